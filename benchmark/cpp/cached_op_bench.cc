@@ -0,0 +1,438 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file cached_op_bench.cc
+ * \brief Inference benchmark of an exported model run by a CachedOp from client threads.
+ *
+ *  The model (a symbol file and a params file) is run by MXInvokeCachedOp on synthetic
+ *  inputs, for every combination of batch size, number of client threads, static_alloc and
+ *  static_shape. Each client thread runs its own requests back to back, a request being
+ *  complete once its outputs are ready. The latency percentiles of the requests, the
+ *  throughput in samples per second and the peak memory of the device are reported.
+ */
+#include <mxnet/c_api.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+/*! \brief exit with the last error of the C API if a call failed */
+void Check(int ret, const char* call) {
+  if (ret != 0) {
+    std::cerr << call << " failed: " << MXGetLastError() << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+}
+
+#define MX_CALL(call) Check(call, #call)
+
+/*! \brief options of the benchmark */
+struct Options {
+  std::string symbol_file;
+  std::string params_file;
+  /*! \brief shapes of the data inputs without their batch dimension, by name */
+  std::vector<std::pair<std::string, std::vector<uint32_t>>> inputs;
+  std::vector<int> batch_sizes{1};
+  std::vector<int> threads{1};
+  std::vector<int> static_alloc{0, 1};
+  std::vector<int> static_shape{0, 1};
+  int dev_type = 1;
+  int dev_id = 0;
+  int warmup = 10;
+  int requests = 100;
+  std::string output;
+};
+
+/*! \brief results of a configuration */
+struct Result {
+  int batch_size;
+  int threads;
+  int static_alloc;
+  int static_shape;
+  double p50, p90, p99, max;
+  double throughput;
+  double peak_mb;
+};
+
+std::vector<int> ParseInts(const std::string& s) {
+  std::vector<int> values;
+  std::stringstream ss(s);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    if (!item.empty()) values.push_back(std::atoi(item.c_str()));
+  }
+  return values;
+}
+
+void Usage(const char* prog) {
+  std::cerr
+      << "Usage: " << prog << " --symbol model-symbol.json --params model-0000.params"
+      << " --input data:3,224,224 [options]\n"
+      << "  --input name:dims      a data input, of shape (batch size, dims), repeatable\n"
+      << "  --batch-sizes 1,8,32   batch sizes\n"
+      << "  --threads 1,4          numbers of client threads, sharing a thread safe CachedOp\n"
+      << "  --static-alloc 0,1     static_alloc flags of the CachedOp\n"
+      << "  --static-shape 0,1     static_shape flags of the CachedOp\n"
+      << "  --gpu id               run on a GPU instead of the CPU\n"
+      << "  --warmup n             requests per thread before measuring (default 10)\n"
+      << "  --requests n           measured requests per thread (default 100)\n"
+      << "  --output file.csv      also write the results as csv\n";
+  std::exit(EXIT_FAILURE);
+}
+
+Options ParseArgs(int argc, char** argv) {
+  Options opts;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (i + 1 >= argc) Usage(argv[0]);
+    const std::string value = argv[++i];
+    if (arg == "--symbol") {
+      opts.symbol_file = value;
+    } else if (arg == "--params") {
+      opts.params_file = value;
+    } else if (arg == "--input") {
+      const size_t colon = value.find(':');
+      if (colon == std::string::npos) Usage(argv[0]);
+      std::vector<uint32_t> dims;
+      for (int d : ParseInts(value.substr(colon + 1))) dims.push_back(d);
+      opts.inputs.emplace_back(value.substr(0, colon), dims);
+    } else if (arg == "--batch-sizes") {
+      opts.batch_sizes = ParseInts(value);
+    } else if (arg == "--threads") {
+      opts.threads = ParseInts(value);
+    } else if (arg == "--static-alloc") {
+      opts.static_alloc = ParseInts(value);
+    } else if (arg == "--static-shape") {
+      opts.static_shape = ParseInts(value);
+    } else if (arg == "--gpu") {
+      opts.dev_type = 2;
+      opts.dev_id = std::atoi(value.c_str());
+    } else if (arg == "--warmup") {
+      opts.warmup = std::atoi(value.c_str());
+    } else if (arg == "--requests") {
+      opts.requests = std::atoi(value.c_str());
+    } else if (arg == "--output") {
+      opts.output = value;
+    } else {
+      Usage(argv[0]);
+    }
+  }
+  if (opts.symbol_file.empty() || opts.inputs.empty() || opts.requests <= 0) Usage(argv[0]);
+  return opts;
+}
+
+/*! \brief bytes of an element of a dtype of mshadow */
+size_t DTypeSize(int dtype) {
+  switch (dtype) {
+    case 0: return 4;   // float32
+    case 1: return 8;   // float64
+    case 2: return 2;   // float16
+    case 3: return 1;   // uint8
+    case 4: return 4;   // int32
+    case 5: return 1;   // int8
+    case 6: return 8;   // int64
+    case 7: return 1;   // bool
+    case 12: return 2;  // bfloat16
+    default:
+      std::cerr << "Unsupported dtype " << dtype << std::endl;
+      std::exit(EXIT_FAILURE);
+  }
+}
+
+/*! \brief an array on the device with the shape and the dtype of a CPU array, copied */
+NDArrayHandle CopyToDevice(NDArrayHandle src, int dev_type, int dev_id) {
+  int ndim = 0;
+  const int* dims = nullptr;
+  int dtype = 0;
+  MX_CALL(MXNDArrayGetShape(src, &ndim, &dims));
+  MX_CALL(MXNDArrayGetDType(src, &dtype));
+  std::vector<uint32_t> shape(dims, dims + ndim);
+  size_t size = 1;
+  for (uint32_t d : shape) size *= d;
+  std::vector<char> buffer(size * DTypeSize(dtype));
+  MX_CALL(MXNDArraySyncCopyToCPU(src, buffer.data(), size));
+  NDArrayHandle dst = nullptr;
+  MX_CALL(MXNDArrayCreate(shape.data(), shape.size(), dev_type, dev_id, 0, dtype, &dst));
+  MX_CALL(MXNDArraySyncCopyFromCPU(dst, buffer.data(), size));
+  return dst;
+}
+
+/*! \brief a float32 array on the device, uniform in [-1, 1] */
+NDArrayHandle RandomArray(const std::vector<uint32_t>& shape, int dev_type, int dev_id,
+                          std::mt19937* gen) {
+  size_t size = 1;
+  for (uint32_t d : shape) size *= d;
+  std::uniform_real_distribution<float> dist(-1.f, 1.f);
+  std::vector<float> buffer(size);
+  for (float& v : buffer) v = dist(*gen);
+  NDArrayHandle arr = nullptr;
+  MX_CALL(MXNDArrayCreate(shape.data(), shape.size(), dev_type, dev_id, 0, 0, &arr));
+  MX_CALL(MXNDArraySyncCopyFromCPU(arr, buffer.data(), size));
+  return arr;
+}
+
+/*! \brief the names of the inputs of a symbol, in the order of the CachedOp */
+std::vector<std::string> InputNames(SymbolHandle sym) {
+  SymbolHandle inputs = nullptr;
+  MX_CALL(MXSymbolGetInputs(sym, &inputs));
+  uint32_t num = 0;
+  const char** names = nullptr;
+  MX_CALL(MXSymbolListOutputs(inputs, &num, &names));
+  std::vector<std::string> ret(names, names + num);
+  MX_CALL(MXSymbolFree(inputs));
+  return ret;
+}
+
+/*! \brief the value of a sorted sample at a percentile, nearest rank */
+double Percentile(const std::vector<double>& sorted, double q) {
+  const size_t rank = static_cast<size_t>(q * (sorted.size() - 1) + 0.5);
+  return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+/*! \brief peak bytes in use of the memory pool of the device, in MB, -1 if not kept */
+double PeakMegabytes(int dev_type, int dev_id) {
+  uint64_t in_use, cached, peak, allocs, hits, largest;
+  int num_sizes;
+  const uint64_t *sizes, *counts;
+  if (MXStorageGetStats(dev_type, dev_id, &in_use, &cached, &peak, &allocs, &hits, &largest,
+                        &num_sizes, &sizes, &counts) != 0) {
+    return -1;
+  }
+  return static_cast<double>(peak) / (1 << 20);
+}
+
+/*! \brief a model with its parameters on the device */
+class Model {
+ public:
+  explicit Model(const Options& opts) : opts_(opts) {
+    MX_CALL(MXSymbolCreateFromFile(opts.symbol_file.c_str(), &sym_));
+    std::map<std::string, NDArrayHandle> params;
+    if (!opts.params_file.empty()) {
+      uint32_t num = 0, num_names = 0;
+      NDArrayHandle* arrs = nullptr;
+      const char** names = nullptr;
+      MX_CALL(MXNDArrayLoad(opts.params_file.c_str(), &num, &arrs, &num_names, &names));
+      for (uint32_t i = 0; i < num_names; ++i) {
+        std::string name = names[i];
+        // the params saved by export are prefixed with arg: or aux:
+        if (name.compare(0, 4, "arg:") == 0 || name.compare(0, 4, "aux:") == 0) {
+          name = name.substr(4);
+        }
+        params[name] = arrs[i];
+      }
+    }
+    const std::vector<std::string> names = InputNames(sym_);
+    for (size_t i = 0; i < names.size(); ++i) {
+      auto it = std::find_if(opts.inputs.begin(), opts.inputs.end(),
+                             [&](const std::pair<std::string, std::vector<uint32_t>>& in) {
+                               return in.first == names[i];
+                             });
+      if (it != opts.inputs.end()) {
+        data_.emplace_back(i, it->second);
+      } else if (params.count(names[i])) {
+        params_.emplace_back(i, CopyToDevice(params[names[i]], opts.dev_type, opts.dev_id));
+      } else {
+        std::cerr << "Input " << names[i] << " is neither a data input nor a parameter"
+                  << std::endl;
+        std::exit(EXIT_FAILURE);
+      }
+    }
+    if (data_.size() != opts.inputs.size()) {
+      std::cerr << "Some data inputs are not inputs of the symbol" << std::endl;
+      std::exit(EXIT_FAILURE);
+    }
+    for (const auto& kv : params) MX_CALL(MXNDArrayFree(kv.second));
+    num_inputs_ = names.size();
+  }
+
+  ~Model() {
+    for (const auto& p : params_) MXNDArrayFree(p.second);
+    MXSymbolFree(sym_);
+  }
+
+  /*! \brief run a configuration */
+  Result Run(int batch_size, int num_threads, int static_alloc, int static_shape) {
+    CachedOpHandle op = CreateCachedOp(static_alloc, static_shape, num_threads > 1);
+    // the inputs of the requests of every thread, the parameters being shared
+    std::mt19937 gen(batch_size);
+    std::vector<std::vector<NDArrayHandle>> inputs(num_threads,
+                                                   std::vector<NDArrayHandle>(num_inputs_));
+    for (auto& in : inputs) {
+      for (const auto& p : params_) in[p.first] = p.second;
+      for (const auto& d : data_) {
+        std::vector<uint32_t> shape{static_cast<uint32_t>(batch_size)};
+        shape.insert(shape.end(), d.second.begin(), d.second.end());
+        in[d.first] = RandomArray(shape, opts_.dev_type, opts_.dev_id, &gen);
+      }
+    }
+    std::vector<std::vector<double>> latencies(num_threads);
+    std::mutex mutex;
+    std::condition_variable cv;
+    int warm = 0;
+    bool go = false;
+    std::chrono::steady_clock::time_point start;
+    auto client = [&](int t) {
+      for (int i = 0; i < opts_.warmup; ++i) Invoke(op, &inputs[t]);
+      {
+        // the threads start measuring together, after the warmup of all of them
+        std::unique_lock<std::mutex> lock(mutex);
+        if (++warm == num_threads) {
+          go = true;
+          start = std::chrono::steady_clock::now();
+          cv.notify_all();
+        }
+        cv.wait(lock, [&]() { return go; });
+      }
+      latencies[t].reserve(opts_.requests);
+      for (int i = 0; i < opts_.requests; ++i) {
+        const auto tic = std::chrono::steady_clock::now();
+        Invoke(op, &inputs[t]);
+        latencies[t].push_back(std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - tic).count());
+      }
+    };
+    std::vector<std::thread> clients;
+    for (int t = 0; t < num_threads; ++t) clients.emplace_back(client, t);
+    for (auto& c : clients) c.join();
+    const double seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+
+    std::vector<double> all;
+    for (const auto& l : latencies) all.insert(all.end(), l.begin(), l.end());
+    std::sort(all.begin(), all.end());
+    Result r;
+    r.batch_size = batch_size;
+    r.threads = num_threads;
+    r.static_alloc = static_alloc;
+    r.static_shape = static_shape;
+    r.p50 = Percentile(all, 0.5);
+    r.p90 = Percentile(all, 0.9);
+    r.p99 = Percentile(all, 0.99);
+    r.max = all.back();
+    r.throughput = static_cast<double>(all.size()) * batch_size / seconds;
+    r.peak_mb = PeakMegabytes(opts_.dev_type, opts_.dev_id);
+
+    for (auto& in : inputs) {
+      for (const auto& d : data_) MX_CALL(MXNDArrayFree(in[d.first]));
+    }
+    MX_CALL(MXFreeCachedOp(op));
+    return r;
+  }
+
+ private:
+  CachedOpHandle CreateCachedOp(int static_alloc, int static_shape, bool thread_safe) {
+    auto indices = [](const std::vector<std::pair<size_t, std::vector<uint32_t>>>& v) {
+      std::string s = "[";
+      for (size_t i = 0; i < v.size(); ++i) s += (i ? "," : "") + std::to_string(v[i].first);
+      return s + "]";
+    };
+    std::string param_indices = "[";
+    for (size_t i = 0; i < params_.size(); ++i) {
+      param_indices += (i ? "," : "") + std::to_string(params_[i].first);
+    }
+    param_indices += "]";
+    const std::string data_indices = indices(data_);
+    const char* keys[] = {"data_indices", "param_indices", "static_alloc", "static_shape"};
+    const char* vals[] = {data_indices.c_str(), param_indices.c_str(),
+                          static_alloc ? "true" : "false", static_shape ? "true" : "false"};
+    CachedOpHandle op = nullptr;
+    MX_CALL(MXCreateCachedOp(sym_, 4, keys, vals, &op, thread_safe));
+    return op;
+  }
+
+  /*! \brief run a request, complete once its outputs are ready */
+  void Invoke(CachedOpHandle op, std::vector<NDArrayHandle>* inputs) {
+    int num_outputs = 0;
+    NDArrayHandle* outputs = nullptr;
+    const int* stypes = nullptr;
+    MX_CALL(MXInvokeCachedOp(op, inputs->size(), inputs->data(), opts_.dev_type, opts_.dev_id,
+                             &num_outputs, &outputs, &stypes));
+    // the returned array of handles belongs to the thread until its next call
+    std::vector<NDArrayHandle> outs(outputs, outputs + num_outputs);
+    for (NDArrayHandle out : outs) MX_CALL(MXNDArrayWaitToRead(out));
+    for (NDArrayHandle out : outs) MX_CALL(MXNDArrayFree(out));
+  }
+
+  const Options& opts_;
+  SymbolHandle sym_ = nullptr;
+  size_t num_inputs_ = 0;
+  /*! \brief positions of the data inputs and their shapes without the batch dimension */
+  std::vector<std::pair<size_t, std::vector<uint32_t>>> data_;
+  /*! \brief positions of the parameters and their arrays on the device */
+  std::vector<std::pair<size_t, NDArrayHandle>> params_;
+};
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const Options opts = ParseArgs(argc, argv);
+  std::vector<Result> results;
+  {
+    Model model(opts);
+    std::printf("%10s %8s %12s %12s %10s %10s %10s %10s %14s %10s\n", "batch", "threads",
+                "static_alloc", "static_shape", "p50 (ms)", "p90 (ms)", "p99 (ms)",
+                "max (ms)", "samples/s", "peak (MB)");
+    for (int batch_size : opts.batch_sizes) {
+      for (int num_threads : opts.threads) {
+        for (int static_alloc : opts.static_alloc) {
+          for (int static_shape : opts.static_shape) {
+            // static_shape needs static_alloc
+            if (static_shape && !static_alloc) continue;
+            const Result r = model.Run(batch_size, num_threads, static_alloc, static_shape);
+            std::printf("%10d %8d %12d %12d %10.3f %10.3f %10.3f %10.3f %14.1f %10.1f\n",
+                        r.batch_size, r.threads, r.static_alloc, r.static_shape, r.p50, r.p90,
+                        r.p99, r.max, r.throughput, r.peak_mb);
+            std::fflush(stdout);
+            results.push_back(r);
+          }
+        }
+      }
+    }
+  }
+  std::printf("peak is the highest memory in use of the device since the start of the process,"
+              " -1 if its memory pool keeps no statistics\n");
+  if (!opts.output.empty()) {
+    std::ofstream f(opts.output);
+    f << "batch_size,threads,static_alloc,static_shape,p50_ms,p90_ms,p99_ms,max_ms,"
+      << "samples_per_sec,peak_mb\n";
+    for (const Result& r : results) {
+      f << r.batch_size << "," << r.threads << "," << r.static_alloc << "," << r.static_shape
+        << "," << r.p50 << "," << r.p90 << "," << r.p99 << "," << r.max << ","
+        << r.throughput << "," << r.peak_mb << "\n";
+    }
+  }
+  MX_CALL(MXNDArrayWaitAll());
+  return 0;
+}
@@ -909,11 +909,18 @@ integrationtest_ubuntu_cpu_dist_kvstore() {
     python3 ../../tools/launch.py -n 7 --launcher local python3 dist_sync_kvstore.py --type=gluon_step_cpu
     python3 ../../tools/launch.py -n 7 --launcher local python3 dist_sync_kvstore.py --type=gluon_sparse_step_cpu
     python3 ../../tools/launch.py -n 7 --launcher local python3 dist_sync_kvstore.py --type=invalid_cpu
+    python3 ../../tools/launch.py -n 7 --launcher local python3 dist_sync_kvstore.py --type=fused_cpu
+    python3 ../../tools/launch.py -n 7 --launcher local python3 dist_sync_kvstore.py --type=local_sgd_cpu
+    MXNET_KVSTORE_ROW_CACHE_SIZE=8 MXNET_KVSTORE_ROW_CACHE_STALENESS=1 python3 ../../tools/launch.py -n 7 --launcher local python3 dist_sync_kvstore.py --type=row_cache_cpu
     python3 ../../tools/launch.py -n 7 --launcher local python3 dist_sync_kvstore.py --type=gluon_type_cpu
+    python3 ../../tools/launch.py -n 7 --launcher local python3 dist_sync_kvstore.py --type=lazy_update_cpu
+    MXNET_KVSTORE_SERVER_NTHREADS=4 python3 ../../tools/launch.py -n 7 --launcher local python3 dist_sync_kvstore.py --type=lazy_update_cpu
     python3 ../../tools/launch.py -n 7 --launcher local python3 dist_sync_kvstore.py
     python3 ../../tools/launch.py -n 7 --launcher local python3 dist_sync_kvstore.py --no-multiprecision
     python3 ../../tools/launch.py -n 7 --launcher local python3 dist_sync_kvstore.py --type=compressed_cpu
     python3 ../../tools/launch.py -n 7 --launcher local python3 dist_sync_kvstore.py --type=compressed_cpu --no-multiprecision
+    MXNET_KVSTORE_SERVER_NTHREADS=4 python3 ../../tools/launch.py -n 7 --launcher local python3 dist_sync_kvstore.py
+    MXNET_KVSTORE_SERVER_NTHREADS=4 python3 ../../tools/launch.py -n 7 --launcher local python3 dist_sync_kvstore.py --type=compressed_cpu
     python3 ../../tools/launch.py -n 3 --launcher local python3 test_server_profiling.py
     popd
 }
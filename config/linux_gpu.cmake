@@ -130,3 +130,5 @@ set(USE_INT64_TENSOR_SIZE OFF CACHE BOOL "Use int64_t to represent the total num
 set(USE_NCCL "Use NVidia NCCL with CUDA" OFF)
 set(NCCL_ROOT "" CACHE BOOL "NCCL install path. Supports autodetection.")
 set(USE_NVTX ON CACHE BOOL "Build with NVTX support")
+set(USE_CUPTI OFF CACHE BOOL "Build with CUPTI kernel timing in the profiler")
+set(USE_NVJPEG OFF CACHE BOOL "Build with nvJPEG support for GPU image decoding")
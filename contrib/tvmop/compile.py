@@ -28,7 +28,7 @@ import logging
 import sys
 import subprocess
 from tvmop.opdef import __OP_DEF__
-from tvmop.space import ConfigSpaces, ConfigSpace
+from tvmop.space import ConfigSpaces, ConfigSpace, OtherOptionEntity
 from tvm.autotvm.measure.measure_methods import set_cuda_target_arch
 
 logging.basicConfig(level=logging.INFO)
@@ -111,6 +111,29 @@ def get_cuda_arch(arch):
     return archs
 
 
+def load_tuning_records(log_path, llvm_target, cuda_arch):
+    """Read the records of a tuning log written by tune.py which were measured on the
+    targets of this build, that is the llvm target of the cpu kernels and one of the archs
+    the gpu kernels are compiled for. The later of two records of a workload wins.
+    """
+    records = {}
+    with open(log_path, "r") as f:
+        for line in f:
+            if len(line.strip()) == 0:
+                continue
+            record = json.loads(line)
+            target = record["target"]
+            if target.startswith("cuda"):
+                arch = target.split("-arch=")[1] if "-arch=" in target else None
+                if arch is not None and cuda_arch is not None and \
+                        not any(arch in flag for flag in cuda_arch):
+                    continue
+            elif target != llvm_target:
+                continue
+            records.setdefault(record["name"], {})[record["key"]] = record["index"]
+    return records
+
+
 if __name__ == "__main__":
     import sys
     sys.path.append(os.path.dirname(sys.path[0]))
@@ -123,6 +146,11 @@ if __name__ == "__main__":
                         help='The cuda arch for compiling kernels for')
     parser.add_argument("--config", action="store", required=True, dest="config_path",
                         help="Path which stores the config file")
+    parser.add_argument("--llvm-target", type=str, default="llvm", dest="llvm_target",
+                        help="The llvm target of cpu kernels, e.g. llvm -mcpu=skylake-avx512")
+    parser.add_argument("--tuning-log", action="store", default=None, dest="tuning_log",
+                        help="Tuning log written by tune.py, whose records of the targets "
+                             "of this build select the schedules of their workloads")
     arguments = parser.parse_args()
 
     func_list_llvm = []
@@ -139,10 +167,10 @@ if __name__ == "__main__":
                                        binds=operator_def.get_binds(args))
                 func_list.append(func_lower)
 
-    lowered_funcs = {get_target("cpu"): func_list_llvm}
+    lowered_funcs = {arguments.llvm_target: func_list_llvm}
+    cuda_arch = get_cuda_arch(arguments.cuda_arch)
     if len(func_list_cuda) > 0:
         lowered_funcs[get_target("cuda")] = func_list_cuda
-        cuda_arch = get_cuda_arch(arguments.cuda_arch)
         if cuda_arch is None:
             logging.info('No cuda arch specified. TVM will try to detect it from the build platform.')
         else:
@@ -159,9 +187,16 @@ if __name__ == "__main__":
                   arguments.target_path + "/libtvmop.o",
                   options=["-L", ld_path, "-ltvm_runtime"])
 
+    tuning_records = {}
+    if arguments.tuning_log is not None:
+        tuning_records = load_tuning_records(arguments.tuning_log, arguments.llvm_target,
+                                             cuda_arch)
     config_spaces = ConfigSpaces()
     for operator_def in __OP_DEF__:
         for config_space, name in operator_def.get_config_spaces():
             config_spaces[name] = ConfigSpace.from_tvm(config_space)
+            # the tuned schedules are entities of the config space, looked up by workload
+            for key, index in tuning_records.get(name, {}).items():
+                config_spaces[name]._entity_map[key] = OtherOptionEntity(index)
     with open(arguments.config_path, "w") as f:
         json.dump(config_spaces.to_json_dict(), f)
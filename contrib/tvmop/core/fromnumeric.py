@@ -17,6 +17,7 @@
 
 
 import tvm
+from tvm import autotvm
 from .. import defop
 from ..utils import reduce_axes, assign_by_req
 
@@ -30,28 +31,34 @@ def _compute_sum(itype, otype, ndim, reduce1st_dim, req):
     return s, a, output_placeholder, final_output, [reduce_output, final_output]
 
 
-@defop(name='sum_cpu', target='cpu', itype=['bool'],
-       otype=['float32', 'float64', 'int32', 'int64'],
-       ndim=[5], req=['kWriteTo', 'kAddTo'], reduce1st_dim=[0, 1],
-       attrs=["reduce1st_dim", "req"])
-def _sum_cpu(itype, otype, ndim, reduce1st_dim, req):
-    s, a, output_placeholder, final_output, tensor_list = _compute_sum(
-        itype, otype, ndim, reduce1st_dim, req)
+# collapsed input shapes the sum kernels are tuned on, see TVMOpReduce
+_sum_workload_ishapes = [(1024, 1024, 1, 1, 1), (64, 4096, 64, 1, 1),
+                         (32, 128, 32, 128, 1), (1, 1048576, 1, 1, 1)]
+
+
+def _sum_attrs_valid(itype, otype, ndim, reduce1st_dim, req):
+    # a boolean input is counted in any of the output types, others are summed in their type
+    return itype == 'bool' or itype == otype
+
+
+def _sum_workloads(itype, otype, ndim, reduce1st_dim, req):
+    workloads = []
+    for ishape in _sum_workload_ishapes:
+        oshape = ishape[reduce1st_dim::2]
+        workloads.append([ishape, oshape, oshape])
+    return workloads
+
+
+def _sum_cpu_schedule(s, tensor_list, tile):
     for t in tensor_list:
         axes = [axis for axis in t.op.axis]
         fused = s[t].fuse(*axes)
+        if tile > 1:
+            fused, _ = s[t].split(fused, factor=tile)
         s[t].parallel(fused)
-    return s, [a, output_placeholder, final_output]
 
 
-@defop(name='sum_gpu', target='gpu', itype=['bool'],
-       otype=['float32', 'float64', 'int32', 'int64'],
-       ndim=[5], req=['kWriteTo', 'kAddTo'], reduce1st_dim=[0, 1],
-       attrs=["reduce1st_dim", "req"])
-def _sum_gpu(itype, otype, ndim, reduce1st_dim, req):
-    s, a, output_placeholder, final_output, tensor_list = _compute_sum(
-        itype, otype, ndim, reduce1st_dim, req)
-    num_threads = 64
+def _sum_gpu_schedule(s, tensor_list, num_threads):
     for t in tensor_list:
         block_x = tvm.thread_axis("blockIdx.x")
         thread_x = tvm.thread_axis("threadIdx.x")
@@ -60,4 +67,32 @@ def _sum_gpu(itype, otype, ndim, reduce1st_dim, req):
         bx, tx = s[t].split(fused, factor=num_threads)
         s[t].bind(bx, block_x)
         s[t].bind(tx, thread_x)
+
+
+@defop(name='sum_cpu', target='cpu', itype=['bool', 'float32', 'float64'],
+       otype=['float32', 'float64', 'int32', 'int64'],
+       ndim=[5], req=['kWriteTo', 'kAddTo'], reduce1st_dim=[0, 1],
+       attrs=["reduce1st_dim", "req"], attrs_valid=_sum_attrs_valid,
+       workloads=_sum_workloads)
+def _sum_cpu(itype, otype, ndim, reduce1st_dim, req, fallback):
+    cfg = autotvm.get_config()
+    # output elements per parallel task
+    cfg.define_knob("tile", [1] if fallback else [1, 8, 64])
+    s, a, output_placeholder, final_output, tensor_list = _compute_sum(
+        itype, otype, ndim, reduce1st_dim, req)
+    _sum_cpu_schedule(s, tensor_list, cfg["tile"].val)
+    return s, [a, output_placeholder, final_output]
+
+
+@defop(name='sum_gpu', target='gpu', itype=['bool', 'float32', 'float64'],
+       otype=['float32', 'float64', 'int32', 'int64'],
+       ndim=[5], req=['kWriteTo', 'kAddTo'], reduce1st_dim=[0, 1],
+       attrs=["reduce1st_dim", "req"], attrs_valid=_sum_attrs_valid,
+       workloads=_sum_workloads)
+def _sum_gpu(itype, otype, ndim, reduce1st_dim, req, fallback):
+    cfg = autotvm.get_config()
+    cfg.define_knob("num_threads", [64] if fallback else [32, 64, 128, 256, 512])
+    s, a, output_placeholder, final_output, tensor_list = _compute_sum(
+        itype, otype, ndim, reduce1st_dim, req)
+    _sum_gpu_schedule(s, tensor_list, cfg["num_threads"].val)
     return s, [a, output_placeholder, final_output]
@@ -32,7 +32,12 @@ def compute_dot(A, B):
     return C
 
 
-@defop(name="dot", target="cpu", dtype=AllTypes)
+def _dot_workloads(dtype):
+    return [[(m, k), (k, n), (m, n)] for m, k, n in
+            [(64, 64, 64), (128, 512, 128), (256, 256, 256), (1024, 1024, 1024)]]
+
+
+@defop(name="dot", target="cpu", dtype=AllTypes, workloads=_dot_workloads)
 def dot(dtype, fallback):
     cfg = autotvm.get_config()
     cfg.define_knob("bn", [64] if fallback else [64, 32])
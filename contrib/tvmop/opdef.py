@@ -48,6 +48,10 @@ class OpDef:
          auto_broadcast=True allows one to implement broadcast computation
          without considering whether dimension size equals to one.
          TVM maps buffer[i][j][k] -> buffer[i][0][k] if dimension i's shape equals 1.
+    workloads : function
+         For dispatchable operators, maps an argument combination to the list of
+         workloads tune.py measures the schedules on. A workload is the list of
+         the shapes of the tensors the function takes.
     """
     def __init__(self, func, name, target, auto_broadcast, **kwargs):
         # construct the value combination of the arguments
@@ -60,6 +64,7 @@ class OpDef:
         # ]
         self.attrs = kwargs.pop('attrs', [])
         self.attrs_valid = kwargs.pop('attrs_valid', lambda **kwargs: True)
+        self.workloads = kwargs.pop('workloads', lambda **kwargs: [])
         args = [k for k in kwargs]
         values = [kwargs[k] if isinstance(kwargs[k], (list, tuple)) else [kwargs[k]]
                   for k in args]
@@ -75,11 +80,14 @@ class OpDef:
     def __call__(self, *args, **kwargs):
         return self.func(*args, **kwargs)
 
+    def get_name(self, each_kwargs):
+        """The function name of an argument combination, before the schedule and dtypes"""
+        return self.name + ''.join(["{}_{}".format(key, each_kwargs[key]) for key in self.attrs])
+
     def invoke_all(self):
         for each_kwargs in self.arg_combination:
             if self.attrs_valid(**each_kwargs):
-                name = self.name \
-                    + ''.join(["{}_{}".format(key, each_kwargs[key]) for key in self.attrs])
+                name = self.get_name(each_kwargs)
                 if self.dispatchable is False:
                     sch, args = self.func(**each_kwargs)
                     yield sch, args, name
@@ -107,8 +115,7 @@ class OpDef:
     def get_config_spaces(self):
         for each_kwargs in self.arg_combination:
             if self.attrs_valid(**each_kwargs) and self.dispatchable is True:
-                name = self.name \
-                    + ''.join(["{}_{}".format(key, each_kwargs[key]) for key in self.attrs])
+                name = self.get_name(each_kwargs)
                 config_space = autotvm.ConfigSpace()
                 with autotvm.task.ApplyConfig(config_space):
                     self.func(fallback=False, **each_kwargs)
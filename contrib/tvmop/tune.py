@@ -0,0 +1,120 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+# coding: utf-8
+"""Ahead-of-time tuning of the dispatchable TVM operators.
+
+Every schedule of the config space of a dispatchable operator is built for the target and
+timed on the workloads of its definition. The fastest schedule of each workload is written
+to the tuning log, one json record per line:
+
+    {"target": "llvm -mcpu=skylake-avx512", "name": "dot", "key": "tuned_float32_...",
+     "index": 3, "cost": 1.2e-05}
+
+compile.py --tuning-log stores the records of the target it builds for in the config file,
+and the kernels of these shapes are then dispatched to the tuned schedule at runtime.
+"""
+import tvm
+from tvm import autotvm
+from tvm.autotvm.measure.measure_methods import set_cuda_target_arch
+
+import os
+import argparse
+import json
+import logging
+import sys
+import numpy as _np
+
+logging.basicConfig(level=logging.INFO)
+
+
+def tuned_key(args, shapes):
+    """The config entity name of a workload, as built by TVMOpConfig::TunedKey"""
+    return "tuned" + "".join("_{}_{}".format(arg.dtype, "x".join(str(d) for d in shape))
+                             for arg, shape in zip(args, shapes))
+
+
+def measure(func, args, shapes, ctx, number):
+    """Mean run time in seconds of func on random tensors of the shapes"""
+    arrays = []
+    for arg, shape in zip(args, shapes):
+        data = _np.random.uniform(0, 2, size=shape).astype(arg.dtype)
+        arrays.append(tvm.nd.array(data, ctx))
+    evaluator = func.time_evaluator(func.entry_name, ctx, number=number)
+    return evaluator(*arrays).mean
+
+
+def tune_op(operator_def, target, target_name, number):
+    """Yield the tuning records of the workloads of a dispatchable operator"""
+    ctx = tvm.context(target.target_name, 0)
+    for each_kwargs in operator_def.arg_combination:
+        if not operator_def.attrs_valid(**each_kwargs):
+            continue
+        workloads = operator_def.workloads(**each_kwargs)
+        if len(workloads) == 0:
+            continue
+        name = operator_def.get_name(each_kwargs)
+        config_space = autotvm.ConfigSpace()
+        with autotvm.task.ApplyConfig(config_space):
+            operator_def.func(fallback=False, **each_kwargs)
+        funcs = []
+        for i in range(len(config_space)):
+            with autotvm.task.ApplyConfig(config_space.get(i)):
+                sch, args = operator_def.func(fallback=False, **each_kwargs)
+            func = tvm.build(sch, args, target=target, binds=operator_def.get_binds(args))
+            funcs.append(func)
+        for shapes in workloads:
+            costs = [measure(func, args, shapes, ctx, number) for func in funcs]
+            best = int(_np.argmin(costs))
+            logging.info("%s %s: schedule %d of %d, %.3g s", name, shapes, best,
+                         len(funcs), costs[best])
+            yield {"target": target_name, "name": name, "key": tuned_key(args, shapes),
+                   "index": best, "cost": costs[best]}
+
+
+if __name__ == "__main__":
+    sys.path.append(os.path.dirname(sys.path[0]))
+    from tvmop.opdef import __OP_DEF__
+    parser = argparse.ArgumentParser(description="Tune the schedules of the tvm operators")
+    parser.add_argument("-o", action="store", required=True, dest="log_path",
+                        help="Path of the tuning log the records are appended to")
+    parser.add_argument("--device", choices=["cpu", "gpu"], default="cpu", dest="device",
+                        help="Tune the operators of this device")
+    parser.add_argument("--llvm-target", type=str, default="llvm", dest="llvm_target",
+                        help="The llvm target of cpu kernels, e.g. llvm -mcpu=skylake-avx512")
+    parser.add_argument("--cuda-arch", type=str, default=None, dest="cuda_arch",
+                        help="The cuda arch of gpu kernels, e.g. sm_70")
+    parser.add_argument("--number", type=int, default=10, dest="number",
+                        help="Runs averaged per measurement")
+    arguments = parser.parse_args()
+
+    if arguments.device == "cpu":
+        tune_target = tvm.target.create(arguments.llvm_target)
+        target_name = arguments.llvm_target
+    else:
+        tune_target = tvm.target.create("cuda")
+        target_name = "cuda"
+        if arguments.cuda_arch is not None:
+            set_cuda_target_arch(arguments.cuda_arch)
+            target_name += " -arch=" + arguments.cuda_arch
+    with open(arguments.log_path, "a") as log:
+        for operator_def in __OP_DEF__:
+            on_device = (operator_def.target == "cpu") == (arguments.device == "cpu")
+            if not operator_def.dispatchable or not on_device:
+                continue
+            for record in tune_op(operator_def, tune_target, target_name, arguments.number):
+                log.write(json.dumps(record) + "\n")
@@ -104,11 +104,17 @@ MXReturnValue backward(const std::unordered_map<std::string, std::string>& attrs
   unsigned n = inputs->at(1).shape[0];
   unsigned k = inputs->at(1).shape[1];
   unsigned m = inputs->at(2).shape[1];
-  // allocate temporary workspace memory through resource manager
-  // for multiple arrays better to request a big memory pool
-  void *workspace = res.alloc_cpu((k*n + m*k) * sizeof(float));
-  float *At = static_cast<float*>(workspace);
-  float *Bt = static_cast<float*>(workspace) + (k*n);
+  float *At, *Bt;
+  if (attrs.count("alloc_cpu") && attrs.at("alloc_cpu") == "true") {
+    // alloc_cpu is rejected for ops declaring their temp space, this path shows the error
+    void *workspace = res.alloc_cpu((k*n + m*k) * sizeof(float));
+    At = static_cast<float*>(workspace);
+    Bt = static_cast<float*>(workspace) + (k*n);
+  } else {
+    // temporary workspaces declared by tempSpace, taken from the temp space pool of MXNet
+    At = static_cast<float*>(res.get_temp_space(0));
+    Bt = static_cast<float*>(res.get_temp_space(1));
+  }
 
   transpose(A, At, k, n);
   transpose(B, Bt, m, k);
@@ -118,6 +124,22 @@ MXReturnValue backward(const std::unordered_map<std::string, std::string>& attrs
   return MX_SUCCESS;
 }
 
+/*
+ * Backward needs the transposes of A and B
+ * in_shapes of the backward are dC, A, B, C
+ */
+MXReturnValue tempSpace(const std::unordered_map<std::string, std::string>& attrs,
+                        const std::vector<std::vector<int64_t>>& in_shapes,
+                        const std::vector<int>& in_types, bool is_forward,
+                        std::vector<size_t>* sizes) {
+  if (!is_forward) {
+    const size_t a_size = in_shapes[1][0] * in_shapes[1][1];
+    const size_t b_size = in_shapes[2][0] * in_shapes[2][1];
+    *sizes = {a_size * sizeof(float), b_size * sizeof(float)};
+  }
+  return MX_SUCCESS;
+}
+
 MXReturnValue parseAttrs(const std::unordered_map<std::string, std::string>& attrs,
                          int* num_in, int* num_out) {
   *num_in = 2;
@@ -175,7 +197,8 @@ REGISTER_OP(my_gemm)
 .setBackward(backward, "cpu")
 .setParseAttrs(parseAttrs)
 .setInferType(inferType)
-.setInferShape(inferShape);
+.setInferShape(inferShape)
+.setTempSpace(tempSpace);
 
 /* ------------------------------------------------------------------------- */
 
@@ -198,6 +221,12 @@ class MyStatefulGemm : public CustomStatefulOp {
     return backward(attrs_, inputs, outputs, op_res);
   }
 
+  MXReturnValue TempSpace(const std::vector<std::vector<int64_t>>& in_shapes,
+                          const std::vector<int>& in_types, bool is_forward,
+                          std::vector<size_t>* sizes) override {
+    return tempSpace(attrs_, in_shapes, in_types, is_forward, sizes);
+  }
+
  private:
   int count;
   const std::unordered_map<std::string, std::string> attrs_;
@@ -49,6 +49,13 @@ MXReturnValue inferShape(const std::unordered_map<std::string, std::string>& att
   return MX_SUCCESS;
 }
 
+MXReturnValue inplaceOption(const std::unordered_map<std::string, std::string>& attrs,
+                            std::vector<std::pair<int, int>>* inplace_pairs) {
+  // the output can be written over the input
+  inplace_pairs->push_back({0, 0});
+  return MX_SUCCESS;
+}
+
 MXReturnValue forwardCPU(const std::unordered_map<std::string, std::string>& attrs,
                          std::vector<MXTensor>* inputs,
                          std::vector<MXTensor>* outputs,
@@ -78,6 +85,7 @@ REGISTER_OP(my_relu)
 .setParseAttrs(parseAttrs)
 .setInferType(inferType)
 .setInferShape(inferShape)
+.setInplaceOption(inplaceOption)
 .setForward(forwardCPU, "cpu")
 .setForward(forwardGPU, "gpu")
 .setBackward(backwardCPU, "cpu")
@@ -132,7 +140,8 @@ REGISTER_OP(my_state_relu)
 .setInferType(inferType)
 .setInferShape(inferShape)
 .setCreateOpState(createOpStateCPU, "cpu")
-.setCreateOpState(createOpStateGPU, "gpu");
+.setCreateOpState(createOpStateGPU, "gpu")
+.setReuseOpState();
 
 MXReturnValue noisyForwardCPU(const std::unordered_map<std::string, std::string>& attrs,
                               std::vector<MXTensor>* inputs,
@@ -26,6 +26,9 @@
 #include <cmath>
 #include <iostream>
 #include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
 #include "mxnet/lib_api.h"
 
 using namespace mxnet::ext;
@@ -43,6 +46,61 @@ MXReturnValue myPass(mxnet::ext::Graph *g,
 REGISTER_PASS(myPass)
 .setBody(myPass);
 
+/* \brief parse a list of ints like [1,2,3] */
+std::vector<int> parseList(const std::string& str) {
+  std::vector<int> ret;
+  std::stringstream ss(str.substr(1, str.size() - 2));
+  std::string value;
+  while (std::getline(ss, value, ','))
+    ret.push_back(std::stoi(value));
+  return ret;
+}
+
+/* \brief print a list of ints like [1,2,3] */
+std::string printList(const std::vector<int>& values) {
+  std::stringstream ss;
+  ss << "[";
+  for (size_t i = 0; i < values.size(); i++)
+    ss << (i > 0 ? "," : "") << values[i];
+  ss << "]";
+  return ss.str();
+}
+
+/* \brief a pass run after memory planning, with MXNET_PLAN_MEMORY_PASSES=noInplace,
+ * that gives a storage of their own to the outputs written inplace over an input */
+MXReturnValue noInplace(mxnet::ext::Graph *g,
+                        const std::unordered_map<std::string, std::string>& options) {
+  std::vector<Node*> nodes = g->topological_sort();
+  int next_id = 0;
+  for (Node* n : nodes) {
+    if (n->attrs.count(MX_STR_STORAGE_ID) == 0)
+      continue;
+    for (int id : parseList(n->attrs[MX_STR_STORAGE_ID]))
+      next_id = std::max(next_id, id + 1);
+  }
+  int count = 0;
+  for (Node* n : nodes) {
+    if (n->attrs.count(MX_STR_STORAGE_ID) == 0)
+      continue;
+    std::vector<int> ids = parseList(n->attrs[MX_STR_STORAGE_ID]);
+    std::vector<int> inplace = parseList(n->attrs[MX_STR_INPLACE_INDEX]);
+    for (size_t i = 0; i < ids.size(); i++) {
+      if (inplace[i] >= 0) {
+        ids[i] = next_id++;
+        inplace[i] = -1;
+        count++;
+      }
+    }
+    n->attrs[MX_STR_STORAGE_ID] = printList(ids);
+    n->attrs[MX_STR_INPLACE_INDEX] = printList(inplace);
+  }
+  std::cout << "noInplace: " << count << " outputs moved to their own storage" << std::endl;
+  return MX_SUCCESS;
+}
+
+REGISTER_PASS(noInplace)
+.setBody(noInplace);
+
 MXReturnValue initialize(int version) {
   if (version >= 10700) {
     std::cout << "MXNet version " << version << " supported" << std::endl;
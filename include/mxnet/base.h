@@ -350,6 +350,11 @@ struct RunContext {
    * \brief indicator of whether this execution is run in bulk mode
    */
   bool is_bulk;
+  /*!
+   * \brief whether the engine tracks the completion of the work queued on the stream
+   *  with a CUDA event, so the function does not need to wait for the stream
+   */
+  bool event_sync{false};
   /*!
    * \brief get mshadow stream from Context
    * \return the mshadow stream
@@ -54,6 +54,9 @@ extern "C" {
 #define MXNET_DLL
 #endif
 
+/*! \brief size of the CUDA IPC handle of GPU memory shared between processes */
+#define MXNET_GPU_IPC_HANDLE_SIZE 64
+
 /*! \brief manually define unsigned int */
 typedef uint32_t mx_uint;
 /*! \brief manually define float */
@@ -71,6 +74,8 @@ typedef const void *FunctionHandle;
 typedef void *AtomicSymbolCreator;
 /*! \brief handle to cached operator */
 typedef void *CachedOpHandle;
+/*! \brief handle to a batching executor over a cached operator */
+typedef void *BatchingExecutorHandle;
 /*! \brief handle to a symbol that can be bind as operator */
 typedef void *SymbolHandle;
 /*! \brief handle to a AtomicSymbol */
@@ -109,6 +114,8 @@ typedef const void *ContextHandle;
 typedef const void *EngineFnPropertyHandle;
 /*! \brief handle to Engine VarHandle */
 typedef void *EngineVarHandle;
+/*! \brief handle to the completion event of an asynchronous copy */
+typedef void *NDArrayCopyEventHandle;
 
 /*! \brief Engine asynchronous operation */
 typedef void (*EngineAsyncFunc)(void*, void*, void*);
@@ -116,6 +123,8 @@ typedef void (*EngineAsyncFunc)(void*, void*, void*);
 typedef void (*EngineSyncFunc)(void*, void*);
 /*! \brief Callback to free the param for EngineAsyncFunc/EngineSyncFunc */
 typedef void (*EngineFuncParamDeleter)(void*);
+/*! \brief Callback of an asynchronous copy, with the status 0 when success, -1 otherwise */
+typedef void (*NDArrayCopyCallback)(int status, void *callback_arg);
 /*! \brief Monitor callback called at operator level for cached op */
 typedef void (*CachedOpMonitorCallback)(const char*,
                                         const char*,
@@ -383,6 +392,19 @@ MXNET_DLL int MXProcessProfilePause(int paused, int profile_process, KVStoreHand
  */
 MXNET_DLL int MXProfilePause(int paused);
 
+/*!
+ * \brief Mark the start of the next iteration, for the profiler sampling iterations
+ * \return 0 when success, -1 when failure happens.
+ */
+MXNET_DLL int MXProfileNextIteration();
+
+/*!
+ * \brief Set the request the operators pushed next by the calling thread are attributed to
+ * \param request name of the request, none if empty
+ * \return 0 when success, -1 when failure happens.
+ */
+MXNET_DLL int MXProfileSetRequest(const char* request);
+
 /*!
  * \brief Create profiling domain
  * \param domain String representing the domain name to create
@@ -494,6 +516,34 @@ MXNET_DLL int MXSetNumOMPThreads(int thread_num);
  */
 MXNET_DLL int MXEngineSetBulkSize(int bulk_size, int* prev_bulk_size);
 
+/*!
+ * \brief set the priority of the operations pushed by the calling thread
+ * \param priority new priority, operations with higher priority run first
+ * \param prev_priority previous priority
+ */
+MXNET_DLL int MXEngineSetPushPriority(int priority, int* prev_priority);
+
+/*!
+ * \brief tag the operations pushed by the calling thread, for MXEngineWaitForTag
+ * \param tag new tag, 0 for none
+ * \param prev_tag previous tag
+ */
+MXNET_DLL int MXEngineSetWaitTag(int tag, int* prev_tag);
+
+/*!
+ * \brief wait until the operations pushed with a tag complete
+ * \param tag the tag, not 0
+ */
+MXNET_DLL int MXEngineWaitForTag(int tag);
+
+/*!
+ * \brief wait until the operations pushed to a context complete, without waiting for the
+ *  other contexts
+ * \param dev_type device type of the context
+ * \param dev_id device id of the context
+ */
+MXNET_DLL int MXEngineWaitForContext(int dev_type, int dev_id);
+
 /*!
  * \brief Get the number of GPUs.
  * \param pointer to int that will hold the number of GPUs available.
@@ -520,6 +570,13 @@ MXNET_DLL int MXGetGPUMemoryInformation(int dev, int *free_mem, int *total_mem);
  */
 MXNET_DLL int MXGetGPUMemoryInformation64(int dev, uint64_t *free_mem, uint64_t *total_mem);
 
+/*!
+ * \brief create a NCCL unique id, e.g. for the 'nccl' backend of SyncBatchNorm
+ * \param out the hex string of the id, valid until the next call on this thread
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXNCCLGetUniqueId(const char **out);
+
 /*!
  * \brief get the MXNet library version as an integer
  * \param pointer to the integer holding the version number
@@ -730,6 +787,74 @@ MXNET_DLL int MXNDArrayLoad(const char* fname,
                             NDArrayHandle** out_arr,
                             uint32_t *out_name_size,
                             const char*** out_names);
+/*!
+ * \brief Save list of dense narray into the file in the mapped format, where the data of
+ *  each narray is aligned to pages, so that MXNDArrayLoad maps the file instead of reading it.
+ * \param fname name of the file.
+ * \param num_args number of arguments to save.
+ * \param args the array of NDArrayHandles to be saved.
+ * \param keys the name of the NDArray, optional, can be NULL
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXNDArraySaveMapped(const char* fname,
+                                  uint32_t num_args,
+                                  NDArrayHandle* args,
+                                  const char** keys);
+/*!
+ * \brief Load the narrays of the given names from the file. Only the named narrays of local
+ *  files in the mapped format are read, when they are first used on CPU.
+ * \param fname name of the file.
+ * \param num_keys number of names, 0 to load all the narrays.
+ * \param keys the names of the NDArrays to load.
+ * \param out_size number of narray loaded.
+ * \param out_arr head of the returning narray handles.
+ * \param out_name_size size of output name arrray.
+ * \param out_names the names of returning NDArrays, can be NULL
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXNDArrayLoadKeys(const char* fname,
+                                uint32_t num_keys,
+                                const char** keys,
+                                uint32_t *out_size,
+                                NDArrayHandle** out_arr,
+                                uint32_t *out_name_size,
+                                const char*** out_names);
+
+/*!
+ * \brief Save named narrays into num_shards files `<prefix>-<shard>-of-<num_shards>.params`
+ *  in the background. The call returns once engine copies of the narrays are pushed, the
+ *  narrays can be updated after them without waiting for the files.
+ * \param prefix the prefix of the file names.
+ * \param num_args number of arguments to save.
+ * \param args the array of NDArrayHandles to be saved.
+ * \param keys the names of the NDArrays.
+ * \param num_shards the number of files written in parallel.
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXNDArraySaveShardedAsync(const char* prefix,
+                                        uint32_t num_args,
+                                        NDArrayHandle* args,
+                                        const char** keys,
+                                        uint32_t num_shards);
+/*!
+ * \brief Wait for the files of the last MXNDArraySaveShardedAsync to be written.
+ * \return 0 when success, -1 when failure happens, including in the writes
+ */
+MXNET_DLL int MXNDArrayWaitForCheckpoint();
+/*!
+ * \brief Load the narrays of the files written by MXNDArraySaveShardedAsync in parallel.
+ * \param prefix the prefix of the file names.
+ * \param num_shards the number of files of the checkpoint.
+ * \param out_size number of narray loaded.
+ * \param out_arr head of the returning narray handles.
+ * \param out_names the names of returning NDArrays.
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXNDArrayLoadSharded(const char* prefix,
+                                   uint32_t num_shards,
+                                   uint32_t *out_size,
+                                   NDArrayHandle** out_arr,
+                                   const char*** out_names);
 
 /*!
  * \brief Load list / dictionary of narrays from file content loaded into memory.
@@ -780,6 +905,60 @@ MXNET_DLL int MXNDArraySyncCopyFromCPU(NDArrayHandle handle,
 MXNET_DLL int MXNDArraySyncCopyToCPU(NDArrayHandle handle,
                                      void *data,
                                      size_t size);
+/*!
+ * \brief Enqueue a copy to a contiguous CPU memory region through the engine, without
+ *  blocking the calling thread.
+ *
+ *  The copy runs after the pending writes of the NDArray, event completes after it and is
+ *  polled with MXNDArrayCopyEventPoll, or waited for with MXNDArrayCopyEventWait. The memory
+ *  region must stay valid until then.
+ *
+ * \param handle the NDArray handle, of default storage type
+ * \param data the data source to copy into.
+ * \param size the memory size we want to copy into.
+ * \param event the completion event of the copy, freed with MXNDArrayCopyEventFree
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXNDArrayCopyToCPUAsync(NDArrayHandle handle,
+                                      void *data,
+                                      size_t size,
+                                      NDArrayCopyEventHandle *event);
+/*!
+ * \brief Enqueue a copy to a contiguous CPU memory region through the engine, and call
+ *  callback after it, from an engine thread. The callback must not wait for the engine.
+ *  The status given to the callback is -1 when the NDArray was written by a failed
+ *  operator, whose error MXNDArrayWaitToRead returns.
+ * \param handle the NDArray handle, of default storage type
+ * \param data the data source to copy into.
+ * \param size the memory size we want to copy into.
+ * \param callback the function called after the copy
+ * \param callback_arg the argument of callback
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXNDArrayCopyToCPUAsyncCallback(NDArrayHandle handle,
+                                              void *data,
+                                              size_t size,
+                                              NDArrayCopyCallback callback,
+                                              void *callback_arg);
+/*!
+ * \brief Check whether an asynchronous copy completed, without blocking.
+ * \param event the completion event
+ * \param done 1 if the copy completed, successfully or not, 0 otherwise
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXNDArrayCopyEventPoll(NDArrayCopyEventHandle event, int *done);
+/*!
+ * \brief Wait for an asynchronous copy to complete.
+ * \param event the completion event
+ * \return 0 when the copy succeeded, -1 when it failed
+ */
+MXNET_DLL int MXNDArrayCopyEventWait(NDArrayCopyEventHandle event);
+/*!
+ * \brief Free the completion event of an asynchronous copy, which may still be running.
+ * \param event the completion event
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXNDArrayCopyEventFree(NDArrayCopyEventHandle event);
 
 /*!
  * \brief Copy src.data() to dst.data() if i = -1, else dst.aux_data(i) if i >= 0
@@ -982,6 +1161,29 @@ MXNET_DLL int MXNDArrayFromDLPack(DLManagedTensorHandle dlpack,
                                   const bool transient_handle,
                                   NDArrayHandle *out_handle);
 
+/*!
+ * \brief Create an NDArray that uses an external CPU or GPU buffer without copying it.
+ *  The buffer must stay valid until the deleter is called, which happens once the NDArray
+ *  is freed and the operations of the engine on it are done.
+ * \param data the pointer to the buffer, on the device of dev_type and dev_id
+ * \param shape the pointer to int64_t shape
+ * \param ndim the dimension of the shape
+ * \param dtype data type of the buffer
+ * \param dev_type device type, 1 for cpu and 2 for gpu
+ * \param dev_id the device id of the specific device
+ * \param var the engine variable guarding the buffer from MXEngineNewVar, so that arrays
+ *  created on the same buffer for successive requests are ordered, or NULL for a new one.
+ *  It is still owned by the caller.
+ * \param deleter called with deleter_param to free the buffer, can be NULL
+ * \param deleter_param the argument of the deleter
+ * \param out the returning handle
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXNDArrayCreateFromBuffer(void *data, const int64_t *shape, int ndim,
+                                        int dtype, int dev_type, int dev_id,
+                                        EngineVarHandle var, EngineFuncParamDeleter deleter,
+                                        void *deleter_param, NDArrayHandle *out);
+
 /*!
  * \brief Delete a dlpack tensor
  * \param dlpack the pointer of the input DLManagedTensor
@@ -989,6 +1191,30 @@ MXNET_DLL int MXNDArrayFromDLPack(DLManagedTensorHandle dlpack,
  */
 MXNET_DLL int MXNDArrayCallDLPackDeleter(DLManagedTensorHandle dlpack);
 
+/*!
+ * \brief Make the work queued from now on a CUDA stream wait for the pending writes of a
+ *  GPU NDArray, and for its pending reads as well when write is nonzero, with a CUDA event
+ *  instead of a host wait. Used to hand the DLPack tensor of the NDArray to a consumer
+ *  working on that stream.
+ * \param handle the handle to the ndarray
+ * \param stream the cudaStream_t of the consumer, 1 for the legacy default stream or 2 for
+ *  the per-thread default stream
+ * \param write whether the consumer writes the ndarray
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXNDArraySyncToStream(NDArrayHandle handle, void *stream, int write);
+
+/*!
+ * \brief Make the later operators on a GPU NDArray wait for the work queued so far on a
+ *  CUDA stream, with a CUDA event instead of a host wait. Used for an NDArray created from
+ *  the DLPack tensor of a producer working on that stream.
+ * \param handle the handle to the ndarray
+ * \param stream the cudaStream_t of the producer, 1 for the legacy default stream or 2 for
+ *  the per-thread default stream
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXNDArraySyncFromStream(NDArrayHandle handle, void *stream);
+
 /*!
  * \brief get the type of the data in NDArray
  * \param handle the handle to the narray
@@ -1342,6 +1568,48 @@ MXNET_DLL int MXInvokeCachedOp(CachedOpHandle handle,
                                NDArrayHandle **outputs,
                                const int** out_stypes);
 
+/*!
+ * \brief create an executor batching concurrent calls to a cached op
+ * \param handle the handle to the cached op, preferably created with thread_safe
+ * \param num_batch_inputs number of inputs concatenated along the first axis
+ * \param batch_inputs positions of the inputs concatenated along the first axis
+ * \param max_batch_size maximum number of rows of a batch
+ * \param max_delay_us maximum time in microseconds a call waits for others to join it
+ * \param dev_type the context type the cached op runs on
+ * \param dev_id the context device id the cached op runs on
+ * \param out the created executor
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXBatchingExecutorCreate(CachedOpHandle handle,
+                                       int num_batch_inputs,
+                                       const uint32_t *batch_inputs,
+                                       uint32_t max_batch_size,
+                                       uint32_t max_delay_us,
+                                       int dev_type,
+                                       int dev_id,
+                                       BatchingExecutorHandle *out);
+
+/*!
+ * \brief run the cached op of a batching executor, blocks until the batch of
+ *  the call has run. Can be called from several threads at once.
+ * \param handle the handle to the batching executor
+ * \param num_inputs number of input NDArrays
+ * \param inputs input NDArrays
+ * \param num_outputs number of output NDArrays
+ * \param outputs output NDArrays, freed by the caller
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXBatchingExecutorInfer(BatchingExecutorHandle handle,
+                                      int num_inputs,
+                                      NDArrayHandle *inputs,
+                                      int *num_outputs,
+                                      NDArrayHandle **outputs);
+
+/*!
+ * \brief free a batching executor, calls still queued fail
+ */
+MXNET_DLL int MXBatchingExecutorFree(BatchingExecutorHandle handle);
+
 /*!
  * \brief cached op set monitor callback
  */
@@ -2916,6 +3184,16 @@ MXNET_DLL int MXRtcFree(RtcHandle handle);
  * \param creator
  */
 MXNET_DLL int MXCustomOpRegister(const char* op_type, CustomOpPropCreator creator);
+/*
+ * \brief register custom operators implemented in native code.
+ *  The forward and backward callbacks run inline on the engine worker executing the
+ *  operator, without the custom operator thread pool, so they must be thread safe and
+ *  must not wait on other engine operations, e.g. by reading the NDArrays synchronously.
+ *  Their time is reported as <op_type>::native in the Custom Operator profiler domain.
+ * \param op_type name of custom op
+ * \param creator
+ */
+MXNET_DLL int MXCustomOpRegisterNative(const char* op_type, CustomOpPropCreator creator);
 /*
  * \brief record custom function for backward later.
  * \param num_inputs number of input NDArrays.
@@ -2988,6 +3266,25 @@ MXNET_DLL int MXRtcCudaKernelCall(CudaKernelHandle handle, int dev_id, void** ar
  */
 MXNET_DLL int MXNDArrayGetSharedMemHandle(NDArrayHandle handle, int* shared_pid,
                                           int* shared_id);
+/*!
+ * \brief Get shared memory handle from NDArray, including the offset of pooled shared memory
+ * \param handle NDArray handle.
+ * \param shared_pid output PID
+ * \param shared_id output shared memory id.
+ * \param shared_offset output offset in the shared memory segment, -1 if not pooled.
+ */
+MXNET_DLL int MXNDArrayGetSharedMemHandleEx(NDArrayHandle handle, int* shared_pid,
+                                            int* shared_id, int64_t* shared_offset);
+/*!
+ * \brief Get the CUDA IPC handle of the GPU memory of an NDArray, that another process of the
+ *  machine opens with MXNDArrayCreateFromGPUSharedMem. The NDArray must outlive the NDArrays
+ *  created from the handle.
+ * \param handle NDArray handle, of default storage on a GPU.
+ * \param ipc_handle output cudaIpcMemHandle_t, of MXNET_GPU_IPC_HANDLE_SIZE bytes.
+ * \param shared_offset output offset of the NDArray in the memory of the handle.
+ */
+MXNET_DLL int MXNDArrayGetGPUSharedMemHandle(NDArrayHandle handle, char* ipc_handle,
+                                             int64_t* shared_offset);
 
 /*!
  * \brief Release all unreferenced memory from the devices storage managers memory pool
@@ -2996,6 +3293,29 @@ MXNET_DLL int MXNDArrayGetSharedMemHandle(NDArrayHandle handle, int* shared_pid,
  */
 MXNET_DLL int MXStorageEmptyCache(int dev_type, int dev_id);
 
+/*!
+ * \brief Get the memory usage of the storage manager of a device
+ * \param dev_type device type, specify device we want to take
+ * \param dev_id the device id of the specific device
+ * \param bytes_in_use bytes of the allocations not freed yet, as rounded by the pool
+ * \param bytes_cached bytes obtained from the device and kept free in the pool
+ * \param peak_bytes_in_use highest value of bytes_in_use
+ * \param num_allocs number of allocations
+ * \param num_pool_hits number of allocations served from the pool
+ * \param largest_free_chunk size of the largest cached free chunk
+ * \param num_free_chunk_sizes number of distinct sizes of the cached free chunks
+ * \param free_chunk_sizes sizes of the cached free chunks, ascending
+ * \param free_chunk_counts number of cached free chunks of each size
+ * \return 0 when success, -1 when failure happens, e.g. if the memory pool type
+ *  of the device keeps no statistics
+ */
+MXNET_DLL int MXStorageGetStats(int dev_type, int dev_id, uint64_t *bytes_in_use,
+                                uint64_t *bytes_cached, uint64_t *peak_bytes_in_use,
+                                uint64_t *num_allocs, uint64_t *num_pool_hits,
+                                uint64_t *largest_free_chunk, int *num_free_chunk_sizes,
+                                const uint64_t **free_chunk_sizes,
+                                const uint64_t **free_chunk_counts);
+
 /*!
  * \brief Reconstruct NDArray from shared memory handle
  * \param shared_pid shared PID
@@ -3007,6 +3327,32 @@ MXNET_DLL int MXStorageEmptyCache(int dev_type, int dev_id);
  */
 MXNET_DLL int MXNDArrayCreateFromSharedMem(int shared_pid, int shared_id, const int *shape,
                                            int ndim, int dtype, NDArrayHandle *out);
+/*!
+ * \brief Reconstruct NDArray from shared memory handle, including pooled shared memory
+ * \param shared_pid shared PID
+ * \param shared_id shared memory id
+ * \param shared_offset offset in the shared memory segment, -1 if not pooled
+ * \param shape pointer to NDArray dimensions
+ * \param ndim number of NDArray dimensions
+ * \param dtype data type of NDArray
+ * \param out constructed NDArray
+ */
+MXNET_DLL int MXNDArrayCreateFromSharedMemEx(int shared_pid, int shared_id,
+                                             int64_t shared_offset, const int *shape,
+                                             int ndim, int dtype, NDArrayHandle *out);
+/*!
+ * \brief Reconstruct NDArray from the CUDA IPC handle of GPU memory of another process
+ * \param ipc_handle cudaIpcMemHandle_t, of MXNET_GPU_IPC_HANDLE_SIZE bytes
+ * \param shared_offset offset of the NDArray in the memory of the handle
+ * \param dev_id the GPU of the memory
+ * \param shape pointer to NDArray dimensions
+ * \param ndim number of NDArray dimensions
+ * \param dtype data type of NDArray
+ * \param out constructed NDArray
+ */
+MXNET_DLL int MXNDArrayCreateFromGPUSharedMem(const char* ipc_handle, int64_t shared_offset,
+                                              int dev_id, const int *shape, int ndim,
+                                              int dtype, NDArrayHandle *out);
 
 /*!
   * \brief Push an asynchronous operation to the engine.
@@ -3114,6 +3460,19 @@ MXNET_DLL int MXEnginePushSyncND(EngineSyncFunc sync_func, void* func_param,
                                  EngineFnPropertyHandle prop_handle DEFAULT(NULL),
                                  int priority DEFAULT(0), const char* opr_name DEFAULT(NULL));
 
+/*!
+  * \brief Create a new variable of the engine, to be passed to MXEnginePushAsync,
+  *  MXEnginePushSync and MXNDArrayCreateFromBuffer.
+  * \param out the returning variable
+  */
+MXNET_DLL int MXEngineNewVar(EngineVarHandle *out);
+
+/*!
+  * \brief Delete a variable of the engine once the operations on it are done.
+  * \param var the variable from MXEngineNewVar
+  */
+MXNET_DLL int MXEngineDeleteVar(EngineVarHandle var);
+
 #ifdef __cplusplus
 }
 #endif  // __cplusplus
@@ -187,6 +187,21 @@ class MXNET_API Engine {
    * \param profiling The variable indicate whether to profile this operator.
    */
   virtual void Push(OprHandle op, Context exec_ctx, int priority = 0, bool profiling = false) = 0;
+  /*!
+   * \brief Push a sequence of operators to the engine at once.
+   *  The result is the same as pushing the operators one after another with Push,
+   *  but engines can amortize the scheduling work over the whole sequence.
+   * \param oprs The operators to push, in execution order.
+   * \param exec_ctx Execution context.
+   * \param priority Priority of the actions, as hint to the engine.
+   * \param profiling The variable indicate whether to profile these operators.
+   */
+  virtual void PushBatch(const std::vector<OprHandle>& oprs, Context exec_ctx,
+                         int priority = 0, bool profiling = false) {
+    for (OprHandle op : oprs) {
+      this->Push(op, exec_ctx, priority, profiling);
+    }
+  }
   /*!
    * \brief Push an asynchronous operation to the engine.
    * \param exec_fun Execution function, this function takes a parameter
@@ -315,6 +330,46 @@ class MXNET_API Engine {
   virtual int set_bulk_size(int) {
     return 0;
   }
+  /*! \brief query the priority added to the operations pushed by the calling thread */
+  virtual int push_priority() const {
+    return 0;
+  }
+  /*!
+   * \brief set the priority added to the operations pushed by the calling thread.
+   *  Engines that schedule by priority run more urgent operations first.
+   * \return the previous priority.
+   */
+  virtual int set_push_priority(int) {
+    return 0;
+  }
+  /*! \brief query the tag of the operations pushed by the calling thread, 0 for none */
+  virtual int wait_tag() const {
+    return 0;
+  }
+  /*!
+   * \brief tag the operations pushed by the calling thread, so that WaitForTag waits for
+   *  them only, e.g. the operations of a tenant of a server.
+   * \return the previous tag.
+   */
+  virtual int set_wait_tag(int) {
+    return 0;
+  }
+  /*!
+   * \brief Wait until the operations pushed to a context complete, without waiting for the
+   *  other contexts. Their errors are thrown by the variables they write.
+   * \param ctx the context the operations were pushed to.
+   */
+  virtual void WaitForContext(Context ctx) {
+    WaitForAll();
+  }
+  /*!
+   * \brief Wait until the operations pushed with a tag complete, see set_wait_tag. Their
+   *  errors are thrown by the variables they write.
+   * \param tag the tag, not 0.
+   */
+  virtual void WaitForTag(int tag) {
+    WaitForAll();
+  }
 };  // class Engine
 #endif  // DMLC_USE_CXX11
 }  // namespace mxnet
@@ -139,6 +139,25 @@ class Dataset {
   *  \param ret the returned ndarray items
   */
   virtual bool GetItem(uint64_t idx, std::vector<NDArray>* ret) = 0;
+  /*!
+  *  \brief Get the ndarray items of several indices in one call, so that a dataset can
+  *   amortize its per-item work over them. The default calls GetItem on each index.
+  *  \param indices the integer indices for required data
+  *  \param rets the returned ndarray items of each index, indices.size() vectors
+  *  \return whether all the items were read
+  */
+  virtual bool GetItems(const std::vector<uint64_t>& indices, std::vector<NDArray>* rets) {
+    for (size_t i = 0; i < indices.size(); ++i) {
+      if (!GetItem(indices[i], rets + i)) return false;
+    }
+    return true;
+  }
+  /*!
+  *  \brief Hint that the items at the given indices will be read soon, so that a dataset
+  *   backed by storage can start reading them asynchronously. The default does nothing.
+  *  \param indices the integer indices of the items
+  */
+  virtual void Prefetch(const std::vector<uint64_t>& indices) {}
   // virtual destructor
   virtual ~Dataset(void) {}
 };  // class Dataset
@@ -178,6 +197,11 @@ class BatchifyFunction {
   /*! \brief The batchify logic */
   virtual bool Batchify(const std::vector<std::vector<NDArray> >& inputs,
                         std::vector<NDArray>* outputs) = 0;
+  /*!
+   * \brief set the context of the output arrays, e.g. cpu_pinned for a fast copy to gpu.
+   * \param ctx a context on cpu memory
+   */
+  virtual void SetOutputContext(const Context& ctx) {}
 };  // class BatchifyFunction
 
 using BatchifyFunctionPtr = std::shared_ptr<BatchifyFunction>;
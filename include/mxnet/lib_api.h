@@ -53,7 +53,7 @@
 #endif
 
 /* Make sure to update the version number everytime you make changes */
-#define MX_LIBRARY_VERSION 9
+#define MX_LIBRARY_VERSION 10
 
 /*!
  * \brief For loading multiple custom op libraries in Linux, exporting same symbol multiple
@@ -420,12 +420,15 @@ class OpResource {
   OpResource(xpu_malloc_t cpu_malloc_fp, void* cpu_alloc_fp,
              xpu_malloc_t gpu_malloc_fp, void* gpu_alloc_fp, void* stream,
              sparse_malloc_t sparse_malloc_fp, void* sparse_alloc_fp,
-             void* rng_cpu_states, void* rng_gpu_states);
+             void* rng_cpu_states, void* rng_gpu_states,
+             void** temp_space, size_t* temp_space_sizes, int num_temp_space);
 
   /*! \brief allocate cpu memory controlled by MXNet */
+  /* Not available to ops declaring their temp space, which share the same MXNet resource */
   void* alloc_cpu(int size) const;
 
   /*! \brief allocate gpu memory controlled by MXNet */
+  /* Not available to ops declaring their temp space, which share the same MXNet resource */
   void* alloc_gpu(int size) const;
 
   /*! \brief return the cuda stream object with correct type */
@@ -447,6 +450,18 @@ class OpResource {
     return static_cast<mx_gpu_rand_t*>(rand_gpu_states);
   }
 
+  /*! \brief get the number of temp space buffers declared by the TempSpace function */
+  inline int num_temp_space() const {
+    return num_temp;
+  }
+
+  /*! \brief get the temp space buffer at index, on the device of the op */
+  /* The buffers do not overlap, and are taken from the temp space pool of MXNet */
+  void* get_temp_space(int index) const;
+
+  /*! \brief get the size in bytes of the temp space buffer at index */
+  size_t get_temp_space_size(int index) const;
+
  private:
   /*! \brief allocation lambda function */
   xpu_malloc_t cpu_malloc, gpu_malloc;
@@ -460,6 +475,10 @@ class OpResource {
   void *sparse_alloc;
   /*! \brief cpu and gpu rng fully inited and seeded states */
   void *rand_cpu_states, *rand_gpu_states;
+  /*! \brief temp space buffers requested by the op and their sizes */
+  void **temp;
+  size_t *temp_sizes;
+  int num_temp;
 };
 
 /*! \brief attribute key to help passing serialized subgraph through subgraph op attribute */
@@ -468,6 +487,12 @@ class OpResource {
 #define MX_STR_DTYPE "__ext_dtype__"
 /*! \brief shape attribute key for ops after shape propagation */
 #define MX_STR_SHAPE "__ext_shape__"
+/*! \brief storage ids attribute key of the node outputs, in passes run after memory planning */
+/* Planned outputs sharing a storage id share their memory, negative ids are not planned */
+#define MX_STR_STORAGE_ID "__ext_storage_id__"
+/*! \brief inplace indices attribute key of the node outputs, set with the storage ids */
+/* The index of the input whose storage an output is written over, or a negative value */
+#define MX_STR_INPLACE_INDEX "__ext_inplace_index__"
 /*! \brief extra input attribute key for ops */
 #define MX_STR_EXTRA_INPUTS "__ext_extra_inputs__"
 
@@ -695,6 +720,12 @@ class CustomStatefulOp {
     MX_ERROR_MSG << "Error! Operator does not support backward" << std::endl;
     return MX_FAIL;
   }
+  /*! \brief sizes in bytes of the temp space buffers Forward or Backward needs */
+  virtual MXReturnValue TempSpace(const std::vector<std::vector<int64_t> >& in_shapes,
+                                  const std::vector<int>& in_types, bool is_forward,
+                                  std::vector<size_t>* sizes) {
+    return MX_SUCCESS;
+  }
 };
 
 /*! \brief StatefulOp wrapper class to pass to backend OpState */
@@ -733,6 +764,14 @@ typedef MXReturnValue (*mutateInputs_t)(const std::unordered_map<std::string,
 typedef MXReturnValue (*createOpState_t)(const std::unordered_map<std::string,
                                          std::string>& attributes,
                                          CustomStatefulOp**);
+typedef MXReturnValue (*inplaceOption_t)(const std::unordered_map<std::string,
+                                         std::string>& attributes,
+                                         std::vector<std::pair<int, int> >* inplace_pairs);
+typedef MXReturnValue (*tempSpace_t)(const std::unordered_map<std::string,
+                                     std::string>& attributes,
+                                     const std::vector<std::vector<int64_t> >& in_shapes,
+                                     const std::vector<int>& in_types, bool is_forward,
+                                     std::vector<size_t>* sizes);
 
 /*!
  * \brief Class to hold custom operator registration
@@ -757,6 +796,16 @@ class CustomOp {
 
   CustomOp& setCreateOpState(createOpState_t func, const char* ctx);
 
+  /*! \brief pairs of (input, output) indices whose memory the forward can share */
+  CustomOp& setInplaceOption(inplaceOption_t func);
+
+  /*! \brief sizes of the temp space buffers of forward and backward, see OpResource */
+  CustomOp& setTempSpace(tempSpace_t func);
+
+  /*! \brief reuse the state created for the same attributes, context, shapes and types */
+  /* Only for states that keep nothing between a Forward and its Backward */
+  CustomOp& setReuseOpState();
+
   CustomOp& setIsSubgraphOp();
 
   void mapToVector();
@@ -770,6 +819,9 @@ class CustomOp {
   inferSType_t infer_storage_type;
   inferShape_t infer_shape;
   mutateInputs_t mutate_inputs;
+  inplaceOption_t inplace_option;
+  tempSpace_t temp_space;
+  bool reuse_state;
   bool isSGop;
 
   /*! \brief vector repr of ctx map to be easily loaded from c_api */
@@ -945,7 +997,9 @@ typedef int (*opRegGet_t)(int idx, const char** name, int *isSGop,
                           const char*** create_op_ctx, mxnet::ext::createOpState_t** create_op_fp,
                           int* create_op_count, mxnet::ext::parseAttrs_t* parse,
                           mxnet::ext::inferType_t* type, mxnet::ext::inferSType_t* stype,
-                          mxnet::ext::inferShape_t* shape, mxnet::ext::mutateInputs_t* mutate);
+                          mxnet::ext::inferShape_t* shape, mxnet::ext::mutateInputs_t* mutate,
+                          mxnet::ext::inplaceOption_t* inplace,
+                          mxnet::ext::tempSpace_t* temp_space, int* reuse_state);
 
 #define MXLIB_OPCALLFREE_STR "_opCallFree"
 typedef int (*opCallFree_t)(void* ptr);
@@ -991,7 +1045,8 @@ typedef int (*opCallFComp_t)(fcomp_t fcomp, const char* const* keys,
                              void** in_indptr, void** out_indptr,
                              int64_t* in_indices_shapes, int64_t* out_indices_shapes,
                              int64_t* in_indptr_shapes, int64_t* out_indptr_shapes,
-                             void* rng_cpu_states, void* rng_gpu_states);
+                             void* rng_cpu_states, void* rng_gpu_states,
+                             void** temp_space, size_t* temp_space_sizes, int num_temp_space);
 
 #define MXLIB_OPCALLMUTATEINPUTS_STR "_opCallMutateInputs"
 typedef int (*opCallMutateInputs_t)(mutateInputs_t mutate, const char* const* keys,
@@ -1021,7 +1076,20 @@ typedef int (*opCallFStatefulComp_t)(int is_forward, void* state_op,
                                      void** in_indptr, void** out_indptr,
                                      int64_t* in_indices_shapes, int64_t* out_indices_shapes,
                                      int64_t* in_indptr_shapes, int64_t* out_indptr_shapes,
-                                     void* rng_cpu_states, void* rng_gpu_states);
+                                     void* rng_cpu_states, void* rng_gpu_states,
+                                     void** temp_space, size_t* temp_space_sizes,
+                                     int num_temp_space);
+
+#define MXLIB_OPCALLINPLACEOPTION_STR "_opCallInplaceOption"
+typedef int (*opCallInplaceOption_t)(inplaceOption_t inplace, const char* const* keys,
+                                     const char* const* vals, int num,
+                                     int** inplace_pairs, int* num_pairs);
+
+#define MXLIB_OPCALLTEMPSPACE_STR "_opCallTempSpace"
+typedef int (*opCallTempSpace_t)(tempSpace_t temp_space, void* state_op,
+                                 const char* const* keys, const char* const* vals, int num,
+                                 const int64_t** inshapes, int* indims, int* intypes, int num_in,
+                                 int is_forward, size_t** sizes, int* num_sizes);
 
 #define MXLIB_PARTREGSIZE_STR "_partRegSize"
 typedef int (*partRegSize_t)(void);
@@ -1138,7 +1206,9 @@ extern "C" {
                         const char*** create_op_ctx, mxnet::ext::createOpState_t** create_op_fp,
                         int* create_op_count, mxnet::ext::parseAttrs_t* parse,
                         mxnet::ext::inferType_t* type, mxnet::ext::inferSType_t* stype,
-                        mxnet::ext::inferShape_t* shape, mxnet::ext::mutateInputs_t* mutate);
+                        mxnet::ext::inferShape_t* shape, mxnet::ext::mutateInputs_t* mutate,
+                        mxnet::ext::inplaceOption_t* inplace,
+                        mxnet::ext::tempSpace_t* temp_space, int* reuse_state);
 
   /*! \brief calls free from the external library for library allocated arrays */
   MX_VOID_RET _opCallFree(void* ptr);
@@ -1181,7 +1251,8 @@ extern "C" {
                              void** in_indptr, void** out_indptr,
                              int64_t* in_indices_shapes, int64_t* out_indices_shapes,
                              int64_t* in_indptr_shapes, int64_t* out_indptr_shapes,
-                             void* rng_cpu_states, void* rng_gpu_states);
+                             void* rng_cpu_states, void* rng_gpu_states,
+                             void** temp_space, size_t* temp_space_sizes, int num_temp_space);
 
   /*! \brief returns status of calling mutateInputs function for operator from library */
   MX_INT_RET _opCallMutateInputs(mxnet::ext::mutateInputs_t mutate, const char* const* keys,
@@ -1209,7 +1280,20 @@ extern "C" {
                                      void** out_indptr, int64_t* in_indices_shapes,
                                      int64_t* out_indices_shapes, int64_t* in_indptr_shapes,
                                      int64_t* out_indptr_shapes,
-                                     void* rng_cpu_states, void* rng_gpu_states);
+                                     void* rng_cpu_states, void* rng_gpu_states,
+                                     void** temp_space, size_t* temp_space_sizes,
+                                     int num_temp_space);
+
+  /*! \brief returns status of calling inplaceOption function for operator from library */
+  MX_INT_RET _opCallInplaceOption(mxnet::ext::inplaceOption_t inplace, const char* const* keys,
+                                  const char* const* vals, int num,
+                                  int** inplace_pairs, int* num_pairs);
+
+  /*! \brief returns status of calling tempSpace function, or TempSpace of a stateful op */
+  MX_INT_RET _opCallTempSpace(mxnet::ext::tempSpace_t temp_space, void* state_op,
+                              const char* const* keys, const char* const* vals, int num,
+                              const int64_t** inshapes, int* indims, int* intypes, int num_in,
+                              int is_forward, size_t** sizes, int* num_sizes);
 
   /*! \brief returns number of partitioners registered in this library */
   MX_INT_RET _partRegSize();
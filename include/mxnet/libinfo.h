@@ -63,6 +63,20 @@
 #define MXNET_USE_NCCL 0
 #endif
 
+/*!
+ *\brief whether the profiler records the GPU kernels with CUPTI
+ */
+#ifndef MXNET_USE_CUPTI
+#define MXNET_USE_CUPTI 0
+#endif
+
+/*!
+ *\brief whether to use nvJPEG for decoding images on the GPU
+ */
+#ifndef MXNET_USE_NVJPEG
+#define MXNET_USE_NVJPEG 0
+#endif
+
 /*!
  *\brief whether to use cusolver library
  */
@@ -139,6 +153,7 @@ enum : unsigned {
   CUDNN,
   NCCL,
   TENSORRT,
+  CUPTI,
 
   // CPU Features / optimizations
   CPU_SSE,
@@ -172,6 +187,7 @@ enum : unsigned {
 
   // Image processing
   OPENCV,
+  NVJPEG,
 
   // Misc
   DIST_KVSTORE,
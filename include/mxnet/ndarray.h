@@ -154,9 +154,38 @@ class NDArray {
         autograd_entry_(nullptr) {
   }
 
+  /*!
+   * \brief constructing an NDArray that uses an external buffer without copying it.
+   *  Unlike the constructor above, the buffer is released only once the NDArray is freed
+   *  and the pending operations on it are done.
+   * \param data the memory content of the external buffer
+   * \param dev_id the device id this tensor sits at
+   * \param var the engine variable guarding the buffer, owned by the caller,
+   *  or nullptr for a new variable
+   * \param release called once the buffer is no longer used, can be empty
+   */
+  NDArray(const TBlob &data, int dev_id, Engine::VarHandle var,
+          const std::function<void()>& release)
+      : ptr_(std::make_shared<Chunk>(data, dev_id, var, release)),
+        shape_(data.shape_),
+        dtype_(data.type_flag_), storage_type_(kDefaultStorage),
+        autograd_entry_(nullptr) {
+  }
+
   /*! \brief create ndarray from shared memory */
-  NDArray(int shared_pid, int shared_id, const mxnet::TShape& shape, int dtype)
-      : ptr_(std::make_shared<Chunk>(shared_pid, shared_id, shape, dtype)),
+  NDArray(int shared_pid, int shared_id, const mxnet::TShape& shape, int dtype,
+          int64_t shared_offset = -1)
+      : ptr_(std::make_shared<Chunk>(shared_pid, shared_id, shape, dtype, shared_offset)),
+        shape_(shape),
+        dtype_(dtype),
+        storage_type_(kDefaultStorage),
+        autograd_entry_(nullptr) {
+  }
+
+  /*! \brief create ndarray from GPU memory of another process, see Storage::GetGPUSharedHandle */
+  NDArray(const std::string& ipc_handle, int64_t shared_offset, int dev_id,
+          const mxnet::TShape& shape, int dtype)
+      : ptr_(std::make_shared<Chunk>(ipc_handle, shared_offset, dev_id, shape, dtype)),
         shape_(shape),
         dtype_(dtype),
         storage_type_(kDefaultStorage),
@@ -381,6 +410,11 @@ class NDArray {
   /*! \brief assign profiler scope and name to the storage handles */
   void AssignStorageInfo(const std::string& profiler_scope,
                          const std::string& name);
+  /*!
+   * \brief prefetch the managed memory of the array to the GPU of the operator about to run
+   *  on rctx, on its stream. Nothing for the memory not managed, see MXNET_GPU_MEM_MANAGED
+   */
+  void PrefetchManaged(const RunContext& rctx) const;
   /*!
    * \brief Block until all the pending write operations with respect
    *    to current NDArray are finished, and read can be performed.
@@ -522,6 +556,20 @@ class NDArray {
    * \param size the memory size we want to copy into, in sizeof(DType) not raw btyes.
    */
   void SyncCopyToCPU(void *data, size_t size) const;
+  /*!
+   * \brief Push a copy to a contiguous CPU memory region to the engine, without waiting.
+   *
+   *  The copy runs once the pending writes of the NDArray are done, and on_complete is
+   *  then called from an engine thread, with false if the copy was skipped because the
+   *  NDArray was written by a failed operator, whose error WaitToRead raises.
+   *  The memory region must stay valid until on_complete is called.
+   *
+   * \param data the data source to copy into.
+   * \param size the memory size we want to copy into, in sizeof(DType) not raw btyes.
+   * \param on_complete the function called after the copy.
+   */
+  void AsyncCopyToCPU(void *data, size_t size,
+                      const std::function<void(bool)>& on_complete) const;
   /*!
   * \brief check whether the NDArray format is valid
   * \param full_check if `True`, rigorous check, O(N) operations
@@ -602,6 +650,25 @@ class NDArray {
     reuse_ = true;
   }
 
+  /*!
+   * \brief Initialize as an array stored offset bytes into the memory of src.
+   *  Used by the memory planner to place several entries in one allocation.
+   */
+  inline void InitAsArrayAt(const NDArray &src, size_t offset,
+                            const mxnet::TShape &shape, int dtype) {
+    CHECK_EQ(src.storage_type(), kDefaultStorage)
+      << "AsArray is intended only for kDefaultStorage.";
+    CHECK_GE(src.ptr_->shandle.size,
+             src.byte_offset_ + offset + shape.Size() * mshadow::mshadow_sizeof(dtype))
+      << "NDArray.AsArray: target memory size is bigger than what was allocated.";
+    CHECK(!src.IsView());
+    *this = src;
+    byte_offset_ += offset;
+    shape_ = shape;
+    dtype_ = dtype;
+    reuse_ = true;
+  }
+
   /*!
    * \brief Create a reference view of NDArray that
    *  represents as DLManagedTensor.
@@ -609,6 +676,25 @@ class NDArray {
    */
   DLManagedTensor* ToDLPack() const;
 
+  /*!
+   * \brief Make the work queued from now on a CUDA stream of the device of the NDArray
+   *  wait for the pending writes of the NDArray, and for its pending reads too when
+   *  write is true, with a CUDA event instead of a host wait on the device.
+   *
+   *  Returns once the event is queued, which is when the engine runs an operator reading
+   *  (or writing) the NDArray; the error of a failed operator writing it is raised.
+   * \param stream the cudaStream_t, or cudaStreamLegacy / cudaStreamPerThread
+   * \param write whether the work queued on the stream writes the NDArray
+   */
+  void SyncToStream(void* stream, bool write) const;
+
+  /*!
+   * \brief Make the operators reading or writing the NDArray from now on wait for the
+   *  work queued so far on a CUDA stream of its device, with a CUDA event and no host wait.
+   * \param stream the cudaStream_t, or cudaStreamLegacy / cudaStreamPerThread
+   */
+  void SyncFromStream(void* stream) const;
+
   /*!
    * \brief Create a NDArray backed by a dlpack tensor.
    *
@@ -842,6 +928,34 @@ class NDArray {
   static void Load(dmlc::Stream* fi,
                    std::vector<NDArray>* data,
                    std::vector<std::string>* keys);
+  /*!
+   * \brief Save list of dense ndarray into the Stream in the mapped format, an index of the
+   *  ndarrays followed by their data, each starting at a multiple of alignment bytes.
+   * \param fo The stream of output.
+   * \param data the NDArrays to be saved.
+   * \param names the name of the NDArray, optional, can be zero length.
+   * \param alignment the alignment of the data in the file, a multiple of the page size.
+   * \param contexts the contexts to load the NDArrays to, their own ones if empty.
+   */
+  static void SaveMapped(dmlc::Stream* fo,
+                         const std::vector<NDArray>& data,
+                         const std::vector<std::string>& names,
+                         size_t alignment = 4096,
+                         const std::vector<Context>& contexts = {});
+  /*!
+   * \brief Load the ndarrays of a local file in the mapped format without reading it.
+   *  The file is mapped in memory, CPU ndarrays view its pages, which are read when they are
+   *  first touched, and GPU ndarrays are copied from them chunk by chunk.
+   * \param fname the path of the file.
+   * \param keys the names of the NDArrays to load, all of them when empty.
+   * \param data the NDArrays loaded.
+   * \param names the names of the NDArrays loaded, if saved in the file.
+   * \return false if fname is not a local file in the mapped format.
+   */
+  static bool LoadMapped(const std::string& fname,
+                         const std::vector<std::string>& keys,
+                         std::vector<NDArray>* data,
+                         std::vector<std::string>* names);
 
  private:
   friend class Imperative;
@@ -875,6 +989,10 @@ class NDArray {
     /*! \brief whether data allocation is delayed. This doesn't indicate whether aux data
                allocation is delayed. */
     bool delay_alloc;
+    /*! \brief whether var is owned by the creator of the chunk, who deletes it */
+    bool external_var = false;
+    /*! \brief called once the operations on the static data are done, can be empty */
+    std::function<void()> release;
     // the type of the storage. The storage_type is never kUndefinedStorage once the chunk
     // is constructed.
     NDArrayStorageType storage_type = kDefaultStorage;
@@ -916,12 +1034,14 @@ class NDArray {
       }
     }
 
-    Chunk(const TBlob &data, int dev_id)
+    Chunk(const TBlob &data, int dev_id, Engine::VarHandle ext_var = nullptr,
+          const std::function<void()>& release_ = nullptr)
         : static_data(true), delay_alloc(false),
+          external_var(ext_var != nullptr), release(release_),
           storage_ref_(Storage::_GetSharedRef()),
           engine_ref_(Engine::_GetSharedRef()) {
       CHECK(storage_type == kDefaultStorage);
-      var = Engine::Get()->NewVariable();
+      var = external_var ? ext_var : Engine::Get()->NewVariable();
       if (data.dev_mask() == cpu::kDevMask) {
         ctx = Context::CPU();
       } else {
@@ -935,7 +1055,8 @@ class NDArray {
       storage_shape = data.shape_;
     }
 
-    Chunk(int shared_pid, int shared_id, const mxnet::TShape& shape, int dtype)
+    Chunk(int shared_pid, int shared_id, const mxnet::TShape& shape, int dtype,
+          int64_t shared_offset)
         : static_data(false), delay_alloc(false),
           storage_ref_(Storage::_GetSharedRef()),
           engine_ref_(Engine::_GetSharedRef()) {
@@ -945,6 +1066,21 @@ class NDArray {
       shandle.ctx = ctx;
       shandle.shared_pid = shared_pid;
       shandle.shared_id = shared_id;
+      shandle.shared_offset = shared_offset;
+      Storage::Get()->Alloc(&shandle);
+      storage_shape = shape;
+    }
+    Chunk(const std::string& ipc_handle, int64_t shared_offset, int dev_id,
+          const mxnet::TShape& shape, int dtype)
+        : static_data(false), delay_alloc(false),
+          storage_ref_(Storage::_GetSharedRef()),
+          engine_ref_(Engine::_GetSharedRef()) {
+      var = Engine::Get()->NewVariable();
+      ctx = Context::GPU(dev_id);
+      shandle.size = shape.Size() * mshadow::mshadow_sizeof(dtype);
+      shandle.ctx = ctx;
+      shandle.ipc_handle = ipc_handle;
+      shandle.shared_offset = shared_offset;
       Storage::Get()->Alloc(&shandle);
       storage_shape = shape;
     }
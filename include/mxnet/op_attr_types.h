@@ -362,6 +362,22 @@ using FNeedCalibrateInput = std::function<std::vector<int> (const NodeAttrs& att
  */
 using FNeedCalibrateOutput = std::function<std::vector<int> (const NodeAttrs& attrs)>;
 
+/*!
+ * \brief Register a function to determine if the operator can be captured into
+ * a CUDA graph, i.e. it only launches work on its stream and its kernel arguments
+ * do not change between runs with the same shapes.
+ */
+using FIsCUDAGraphsCompatible = std::function<bool (const NodeAttrs& attrs, const bool is_train)>;
+
+/*!
+ * \brief Register a function estimating the floating point operations of an operator
+ * from the shapes of its inputs and outputs. The profiler reports them, with the bytes
+ * of the inputs and outputs, as the achieved GFLOP/s and GB/s of the operator.
+ */
+using FComputeCost = std::function<double (const NodeAttrs& attrs,
+                                           const mxnet::ShapeVector& in_shapes,
+                                           const mxnet::ShapeVector& out_shapes)>;
+
 }  // namespace mxnet
 
 #endif  // MXNET_OP_ATTR_TYPES_H_
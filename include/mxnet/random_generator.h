@@ -25,6 +25,8 @@
 #ifndef MXNET_RANDOM_GENERATOR_H_
 #define MXNET_RANDOM_GENERATOR_H_
 
+#include <cmath>
+#include <limits>
 #include <random>
 #include <new>
 #include "./base.h"
@@ -41,6 +43,60 @@ namespace random {
 template<typename Device, typename DType MSHADOW_DEFAULT_DTYPE>
 class RandGenerator;
 
+/*!
+ * \brief Philox4x32-10 counter-based random number engine, the same generator as
+ *  curandStatePhilox4_32_10_t used on GPU. A state is a key and a 128-bit counter: the
+ *  high half of the counter selects the subsequence and the low half the position in it,
+ *  so that the numbers at any position are computed without running the ones before.
+ */
+struct PhiloxState {
+  uint32_t key[2];
+  uint32_t counter[4];
+  uint32_t output[4];
+  uint32_t index;
+
+  MSHADOW_XINLINE void Seed(uint64_t seed, uint64_t subsequence) {
+    key[0] = static_cast<uint32_t>(seed);
+    key[1] = static_cast<uint32_t>(seed >> 32);
+    counter[0] = counter[1] = 0;
+    counter[2] = static_cast<uint32_t>(subsequence);
+    counter[3] = static_cast<uint32_t>(subsequence >> 32);
+    index = 4;
+  }
+
+  /*! \brief next 32 random bits, four of which come out of each ten rounds */
+  MSHADOW_XINLINE uint32_t Next() {
+    if (index == 4) {
+      Block();
+      index = 0;
+    }
+    return output[index++];
+  }
+
+ private:
+  MSHADOW_XINLINE void Block() {
+    const uint32_t kMul0 = 0xD2511F53, kMul1 = 0xCD9E8D57;
+    const uint32_t kWeyl0 = 0x9E3779B9, kWeyl1 = 0xBB67AE85;
+    uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+    uint32_t k0 = key[0], k1 = key[1];
+    for (int round = 0; round < 10; ++round) {
+      const uint64_t p0 = static_cast<uint64_t>(kMul0) * c0;
+      const uint64_t p1 = static_cast<uint64_t>(kMul1) * c2;
+      c0 = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ k0;
+      c1 = static_cast<uint32_t>(p1);
+      c2 = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ k1;
+      c3 = static_cast<uint32_t>(p0);
+      k0 += kWeyl0;
+      k1 += kWeyl1;
+    }
+    output[0] = c0;
+    output[1] = c1;
+    output[2] = c2;
+    output[3] = c3;
+    if (++counter[0] == 0) ++counter[1];
+  }
+};
+
 template<typename DType>
 class RandGenerator<cpu, DType> {
  public:
@@ -55,54 +111,96 @@ class RandGenerator<cpu, DType> {
    public:
     typedef typename std::conditional<std::is_floating_point<DType>::value,
                                       DType, double>::type FType;
+    // Copy state to local memory for efficiency.
     explicit Impl(RandGenerator<cpu, DType> *gen, int state_idx)
-        : engine_(gen->states_ + state_idx) {}
+        : global_state_(gen->states_ + state_idx), state_(*global_state_) {}
+
+    ~Impl() {
+      // store the philox state back into global memory
+      *global_state_ = state_;
+    }
 
     Impl(const Impl &) = delete;
     Impl &operator=(const Impl &) = delete;
 
-    MSHADOW_XINLINE int rand() { return engine_->operator()(); }
+    MSHADOW_XINLINE int rand() { return static_cast<int>(state_.Next()); }
 
     MSHADOW_XINLINE int64_t rand_int64() {
-      return static_cast<int64_t>(engine_->operator()() << 31) + engine_->operator()();
+      return static_cast<int64_t>(static_cast<uint64_t>(state_.Next()) << 31) + state_.Next();
     }
 
+    // uniform numbers include 0 but exclude 1, as with the stl distributions; integral
+    // types draw from [0, max] of the type.
     MSHADOW_XINLINE FType uniform() {
-      typedef typename std::conditional<std::is_integral<DType>::value,
-      std::uniform_int_distribution<DType>,
-      std::uniform_real_distribution<FType>>::type GType;
-      GType dist_uniform;
-      return dist_uniform(*engine_);
+      return Uniform(std::is_integral<DType>());
     }
 
+    // normal numbers come in pairs from the Box-Muller transform.
     MSHADOW_XINLINE FType normal() {
-      std::normal_distribution<FType> dist_normal;
-      return dist_normal(*engine_);
+      if (has_normal_) {
+        has_normal_ = false;
+        return normal_;
+      }
+      const double kTwoPi = 6.283185307179586;
+      const double radius = std::sqrt(-2.0 * std::log(1.0 - Uniform53()));
+      const double angle = kTwoPi * Uniform53();
+      normal_ = static_cast<FType>(radius * std::sin(angle));
+      has_normal_ = true;
+      return static_cast<FType>(radius * std::cos(angle));
     }
 
    private:
-    std::mt19937 *engine_;
+    MSHADOW_XINLINE double Uniform53() {
+      const uint64_t hi = state_.Next() >> 5, lo = state_.Next() >> 6;
+      return static_cast<double>((hi << 26) | lo) * (1.0 / 9007199254740992.0);
+    }
+
+    MSHADOW_XINLINE FType Uniform(std::false_type) {
+      if (sizeof(FType) <= sizeof(float)) {
+        return static_cast<FType>(static_cast<float>(state_.Next() >> 8) *
+                                  (1.0f / 16777216.0f));
+      }
+      return static_cast<FType>(Uniform53());
+    }
+
+    MSHADOW_XINLINE FType Uniform(std::true_type) {
+      const uint64_t bits = (static_cast<uint64_t>(state_.Next()) << 32) | state_.Next();
+      const uint64_t range = static_cast<uint64_t>(std::numeric_limits<DType>::max());
+      return static_cast<FType>(range == UINT64_MAX ? bits : bits % (range + 1));
+    }
+
+    PhiloxState *global_state_;
+    PhiloxState state_;
+    bool has_normal_ = false;
+    FType normal_;
   };  // class RandGenerator<cpu, DType>::Impl
 
   static void AllocState(RandGenerator<cpu, DType> *inst) {
-    inst->states_ = new std::mt19937[kNumRandomStates];
+    inst->states_ = new PhiloxState[kNumRandomStates];
+    inst->engines_ = new std::mt19937[kNumRandomStates];
   }
 
   static void FreeState(RandGenerator<cpu, DType> *inst) {
     delete[] inst->states_;
+    delete[] inst->engines_;
   }
 
   MSHADOW_XINLINE void Seed(mshadow::Stream<cpu> *, uint32_t seed) {
-    for (int i = 0; i < kNumRandomStates; ++i) (states_ + i)->seed(seed + i);
+    for (int i = 0; i < kNumRandomStates; ++i) {
+      (states_ + i)->Seed(seed, i);
+      (engines_ + i)->seed(seed + i);
+    }
   }
 
-  // export global random states, used by c++ custom operator
+  // export global random states, used by c++ custom operator. These are std::mt19937
+  // engines for the library ABI; the operators here sample from the philox states.
   MSHADOW_XINLINE void* GetStates() {
-    return static_cast<void*>(states_);
+    return static_cast<void*>(engines_);
   }
 
  private:
-  std::mt19937 *states_;
+  PhiloxState *states_;
+  std::mt19937 *engines_;
 };  // class RandGenerator<cpu, DType>
 
 template<typename DType>
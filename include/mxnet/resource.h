@@ -104,7 +104,7 @@ struct Resource {
    */
   void *ptr_;
   /*! \brief default constructor */
-  Resource() : id(0) {}
+  Resource() : id(0), ptr_(nullptr) {}
   /*!
    * \brief Get random number generator.
    * \param stream The stream to use in the random number generator.
@@ -249,6 +249,20 @@ class ResourceManager {
    *       still hold by the manager singleton.
    */
   virtual Resource Request(Context ctx, const ResourceRequest &req) = 0;
+  /*!
+   * \brief Create a temporary space owned by the caller instead of the shared round-robin
+   *        copies, e.g. for the operators of a CachedOp with static memory.
+   * \param ctx the context of the space.
+   * \param profiler_scope the scope of the space in the storage profiler.
+   * \return a resource of type kTempSpace, released with ReleaseTempSpaceArena.
+   */
+  virtual Resource NewTempSpaceArena(Context ctx, const std::string &profiler_scope) = 0;
+  /*!
+   * \brief Release a temporary space created by NewTempSpaceArena, once the operations
+   *        using it are done.
+   * \param arena the temporary space.
+   */
+  virtual void ReleaseTempSpaceArena(const Resource &arena) = 0;
   /*!
    * \brief Seed all the allocated random number generators.
    * \param seed the seed to the random number generators on all devices.
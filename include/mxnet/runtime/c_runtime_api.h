@@ -53,6 +53,8 @@ typedef enum {
   kBytes = 9U,
   kPyArg = 10U,
   kNDArrayHandle = 11U,
+  // An argument of MXNetFuncCallBatch referring to the result of an earlier call
+  kBatchResult = 12U,
   // Extension codes for other frameworks to integrate MXNet PackedFunc.
   // To make sure each framework's id do not conflict, use first and
   // last sections to mark ranges.
@@ -127,6 +129,35 @@ MXNET_DLL int MXNetFuncCall(MXNetFunctionHandle func,
                             MXNetValue* ret_val,
                             int* ret_type_code);
 
+/*!
+ * \brief Call a sequence of Packed MXNet Functions in one API call.
+ *
+ * The arguments of all the calls are concatenated in arg_values and type_codes.
+ * An argument of type code kBatchResult refers to the result of an earlier call of
+ * the batch, with v_int64 = (call index << 32) | element, where element 0 is the whole
+ * result and element k > 0 is the element k - 1 of an ADT result.
+ * An output argument returned by a call (kPyArg) is referred to as that argument.
+ *
+ * \param num_calls Number of calls.
+ * \param funcs The functions called, in order.
+ * \param num_args The number of arguments of each call.
+ * \param arg_values The arguments of all the calls.
+ * \param type_codes The type codes of the arguments of all the calls.
+ * \param ret_vals The return value of each call.
+ * \param ret_type_codes The type code of the return value of each call.
+ *
+ * \return 0 when success, -1 when failure happens
+ * \note When a call fails, the results of the earlier calls are released and none
+ *   of them is returned. Returned strings are valid until the next batch on the thread.
+ */
+MXNET_DLL int MXNetFuncCallBatch(int num_calls,
+                                 MXNetFunctionHandle* funcs,
+                                 int* num_args,
+                                 MXNetValue* arg_values,
+                                 int* type_codes,
+                                 MXNetValue* ret_vals,
+                                 int* ret_type_codes);
+
 /*!
  * \brief Get a global function.
  *
@@ -27,12 +27,16 @@
 
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 #include "./base.h"
 
 namespace mxnet {
 
 #define MXNET_STORAGE_DEFAULT_PROFILER_SCOPE_CSTR  "<unk>:"
 #define MXNET_STORAGE_DEFAULT_NAME_CSTR  "unknown"
+/*! \brief size of the CUDA IPC handle of GPU memory shared between processes */
+#define MXNET_GPU_IPC_HANDLE_SIZE 64
 
 /*!
  * \brief Storage manager across multiple devices.
@@ -60,12 +64,53 @@ class Storage {
      */
     int shared_pid{-1};
     int shared_id {-1};
+    /*!
+     * \brief Offset of IPC shared memory in its segment, -1 if it has a segment of its own
+     */
+    int64_t shared_offset{-1};
+    /*!
+     * \brief Whether dptr is CUDA managed memory, and whether the operators prefetch it to
+     *  their GPU before running, see MXNET_GPU_MEM_MANAGED
+     */
+    bool managed{false};
+    bool managed_prefetch{false};
+    /*!
+     * \brief cudaIpcMemHandle_t bytes of the allocation of another process that dptr is in,
+     *  at shared_offset, empty unless the memory is opened by CUDA IPC
+     */
+    std::string ipc_handle;
     /*!
      * \brief Attributes for tracking storage allocations.
      */
     std::string profiler_scope{MXNET_STORAGE_DEFAULT_PROFILER_SCOPE_CSTR};
     std::string name{MXNET_STORAGE_DEFAULT_NAME_CSTR};
   };
+  /*!
+   * \brief Memory usage of the storage manager of a device.
+   */
+  struct Stats {
+    /*! \brief bytes of the allocations not freed yet, as rounded by the pool */
+    size_t bytes_in_use{0};
+    /*! \brief bytes obtained from the device and kept free in the pool */
+    size_t bytes_cached{0};
+    /*! \brief highest value of bytes_in_use */
+    size_t peak_bytes_in_use{0};
+    /*! \brief number of allocations */
+    uint64_t num_allocs{0};
+    /*! \brief number of allocations served from the pool without asking the device */
+    uint64_t num_pool_hits{0};
+    /*! \brief size of the largest cached free chunk */
+    size_t largest_free_chunk{0};
+    /*! \brief number of cached free chunks by chunk size, ascending */
+    std::vector<std::pair<size_t, size_t>> free_chunks;
+    /*!
+     * \brief Part of the cached memory that cannot serve an allocation as large as
+     *  all of it, between 0 (one free chunk) and 1.
+     */
+    double fragmentation() const {
+      return bytes_cached ? 1.0 - static_cast<double>(largest_free_chunk) / bytes_cached : 0.0;
+    }
+  };
   /*!
    * \brief Allocate a new contiguous memory for a given size.
    * \param size Total size of memory in bytes.
@@ -89,6 +134,13 @@ class Storage {
    * \param handle handle to shared memory.
    */
   virtual void SharedIncrementRefCount(Handle handle) = 0;
+  /*!
+   * \brief Get the CUDA IPC handle of GPU memory, that other processes open by allocating a
+   *  handle with the same ipc_handle, shared_offset and ctx.
+   * \param handle a copy of the handle of the GPU memory, whose ipc_handle and shared_offset
+   *  are filled.
+   */
+  virtual void GetGPUSharedHandle(Handle* handle) = 0;
   /*!
    * \brief Free storage.
    * \param handle Handle struct.
@@ -112,6 +164,13 @@ class Storage {
   * For non-pool memory managers this has no effect.
   */
   virtual void ReleaseAll(Context ctx) = 0;
+  /*!
+   * \brief Get the memory usage of the storage manager of a device.
+   * \param ctx Context of the device.
+   * \param stats Filled with the usage, all 0 if nothing was allocated on the device yet.
+   * \return false if the storage manager of the device does not keep statistics.
+   */
+  virtual bool GetStats(Context ctx, Stats* stats) = 0;
   /*!
    * \brief Destructor.
    */
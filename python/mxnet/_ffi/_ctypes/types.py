@@ -37,6 +37,7 @@ class TypeCode(object):
     BYTES = 9
     PYARG = 10
     NDARRAYHANDLE = 11
+    BATCH_RESULT = 12
     EXT_BEGIN = 15
 
 
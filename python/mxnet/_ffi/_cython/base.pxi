@@ -37,6 +37,7 @@ cdef enum MXNetTypeCode:
     kBytes = 9
     kPyArg = 10
     kNDArrayHandle = 11
+    kBatchResult = 12
     kExtBegin = 15
 
 cdef extern from "mxnet/runtime/c_runtime_api.h":
@@ -23,7 +23,7 @@ Acknowledgement: This file originates from incubator-tvm
 import os
 import sys
 import ctypes
-from ..base import _LIB, check_call
+from ..base import _LIB, check_call, get_last_ffi_error
 from .base import py_str, c_str
 
 try:
@@ -114,6 +114,163 @@ def list_global_func_names():
     return fnames
 
 
+class BatchResult(object):
+    """A reference to the result of an earlier call of a batch, as an argument of call_batch.
+
+    Parameters
+    ----------
+    index : int
+        The index of the call in the batch.
+    element : int or None
+        The element of the result, for calls returning several arrays.
+        None refers to the whole result.
+    """
+    __slots__ = ["index", "element"]
+
+    def __init__(self, index, element=None):
+        self.index = index
+        self.element = element
+
+
+class _ByteArray(ctypes.Structure):
+    _fields_ = [("data", ctypes.c_void_p), ("size", ctypes.c_size_t)]
+
+
+def _pack_batch_arg(arg, value, index, temp_args):
+    """Pack one argument of call_batch into value, returning its type code."""
+    # pylint: disable=import-outside-toplevel
+    from numbers import Number, Integral
+    import numpy as onp
+    from ._ctypes.types import TypeCode
+    from .node_generic import convert_to_node
+    from .object import Object
+    from ..ndarray._internal import NDArrayBase
+    if isinstance(arg, BatchResult):
+        if not 0 <= arg.index < index:
+            raise ValueError("call %d refers to call %d, which is not an earlier call"
+                             % (index, arg.index))
+        element = 0 if arg.element is None else arg.element + 1
+        value.v_int64 = (arg.index << 32) | element
+        return TypeCode.BATCH_RESULT
+    if isinstance(arg, NDArrayBase):
+        value.v_handle = arg.handle
+        return TypeCode.NDARRAYHANDLE
+    if isinstance(arg, Object):
+        value.v_handle = arg.handle
+        return TypeCode.OBJECT_HANDLE
+    if arg is None:
+        value.v_handle = None
+        return TypeCode.NULL
+    if isinstance(arg, Integral):
+        value.v_int64 = arg
+        return TypeCode.INT
+    if isinstance(arg, Number):
+        value.v_float64 = arg
+        return TypeCode.FLOAT
+    if isinstance(arg, str):
+        value.v_str = c_str(arg)
+        return TypeCode.STR
+    if isinstance(arg, (list, tuple)):
+        arg = convert_to_node(arg)
+        value.v_handle = arg.handle
+        temp_args.append(arg)
+        return TypeCode.OBJECT_HANDLE
+    if isinstance(arg, ctypes.c_void_p):
+        value.v_handle = arg
+        return TypeCode.HANDLE
+    if isinstance(arg, type):
+        value.v_str = c_str(onp.dtype(arg).name)
+        return TypeCode.STR
+    raise TypeError("Don't know how to handle type %s" % type(arg))
+
+
+def _return_batch_value(value, code, args):
+    """Convert one result of call_batch."""
+    # pylint: disable=import-outside-toplevel
+    from .. import _global_var
+    from ..base import NDArrayHandle
+    from ._ctypes.types import TypeCode
+    from .object import Object, _OBJECT_TYPES
+    if code == TypeCode.NDARRAYHANDLE:
+        return _global_var._np_ndarray_cls(handle=NDArrayHandle(value.v_handle))
+    if code == TypeCode.PYARG:
+        return args[value.v_int64]
+    if code == TypeCode.OBJECT_HANDLE:
+        handle = ctypes.c_void_p(value.v_handle)
+        tindex = ctypes.c_uint()
+        check_call(_LIB.MXNetObjectGetTypeIndex(handle, ctypes.byref(tindex)))
+        cls = _OBJECT_TYPES.get(tindex.value, Object)
+        obj = cls.__new__(cls)
+        obj.handle = handle
+        return obj
+    if code == TypeCode.INT:
+        return value.v_int64
+    if code == TypeCode.FLOAT:
+        return value.v_float64
+    if code == TypeCode.STR:
+        return py_str(value.v_str)
+    if code == TypeCode.BYTES:
+        array = ctypes.cast(value.v_handle, ctypes.POINTER(_ByteArray)).contents
+        return ctypes.string_at(array.data, array.size)
+    if code == TypeCode.NULL:
+        return None
+    raise ValueError("Unhandled type code %d" % code)
+
+
+def call_batch(calls):
+    """Call a sequence of functions in a single call into the library.
+
+    The dispatch cost of the library call is paid once for the whole sequence, which
+    speeds up loops of small operators. An argument can be a BatchResult referring to
+    the result of an earlier call of the sequence, which is passed on without a
+    round trip through Python.
+
+    Parameters
+    ----------
+    calls : list of tuple
+        The (function, args) of each call, where function is a Function, for example
+        one of mxnet.ndarray.numpy._api_internal, and args is a tuple of positional
+        arguments.
+
+    Returns
+    -------
+    results : list
+        The result of each call.
+
+    Examples
+    --------
+    >>> from mxnet.ndarray.numpy import _api_internal
+    >>> from mxnet._ffi.function import call_batch, BatchResult
+    >>> x = mx.np.ones((2, 2))
+    >>> y, z = call_batch([(_api_internal.add, (x, x, None)),
+    ...                    (_api_internal.multiply, (BatchResult(0), x, None))])
+    """
+    # pylint: disable=import-outside-toplevel
+    from ._ctypes.types import MXNetValue
+    num_calls = len(calls)
+    num_args = [len(args) for _, args in calls]
+    total = sum(num_args)
+    funcs = (ctypes.c_void_p * num_calls)()
+    values = (MXNetValue * total)()
+    codes = (ctypes.c_int * total)()
+    temp_args = []
+    offset = 0
+    for i, (func, args) in enumerate(calls):
+        funcs[i] = func.handle
+        for arg in args:
+            codes[offset] = _pack_batch_arg(arg, values[offset], i, temp_args)
+            offset += 1
+    ret_vals = (MXNetValue * num_calls)()
+    ret_codes = (ctypes.c_int * num_calls)()
+    if _LIB.MXNetFuncCallBatch(
+            ctypes.c_int(num_calls), funcs, (ctypes.c_int * num_calls)(*num_args),
+            values, codes, ret_vals, ret_codes) != 0:
+        raise get_last_ffi_error()
+    _ = temp_args
+    return [_return_batch_value(ret_vals[i], ret_codes[i], args)
+            for i, (_, args) in enumerate(calls)]
+
+
 def _get_api(f):
     flocal = f
     flocal.is_global = True
@@ -37,6 +37,9 @@ except ImportError:
     from ._ctypes.object import ObjectBase as _ObjectBase
     from ._ctypes.object import _register_object
 
+# the registered object classes by type index, for the results of call_batch
+_OBJECT_TYPES = {}
+
 class Object(_ObjectBase):
     """Base class for all mxnet's runtime objects."""
 
@@ -72,6 +75,7 @@ def register_object(type_key=None):
                 c_str(object_name), ctypes.byref(tidx)))
             tindex = tidx.value
         _register_object(tindex, cls)
+        _OBJECT_TYPES[tindex] = cls
         return cls
 
     if isinstance(type_key, str):
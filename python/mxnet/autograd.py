@@ -19,6 +19,7 @@
 """Autograd for NDArray."""
 
 from array import array
+from collections import OrderedDict
 from threading import Lock
 import traceback
 import ctypes
@@ -267,6 +268,39 @@ def backward(heads, head_grads=None, retain_graph=False, train_mode=True): #pyli
         ctypes.c_int(train_mode),
         ctypes.c_void_p(0),
         ctypes.c_void_p(0)))
+    _run_backward_hooks()
+
+
+_backward_hooks = OrderedDict()
+
+
+def register_backward_hook(hook):
+    r"""Registers a hook called after each backward pass that writes the gradients of
+    the marked variables, i.e. after :func:`backward` and `NDArray.backward`.
+
+    Backward is asynchronous: the hook is called once the operators of the backward pass
+    are pushed to the engine, while they are still running. Operators the hook pushes
+    that read a gradient start as soon as the gradient is written, so they overlap with
+    the rest of the backward pass.
+
+    Parameters
+    ----------
+    hook : callable
+        The hook, called without arguments.
+
+    Returns
+    -------
+    :class:`mxnet.gluon.utils.HookHandle`
+    """
+    from .gluon.utils import HookHandle
+    handle = HookHandle()
+    handle.attach(_backward_hooks, hook)
+    return handle
+
+
+def _run_backward_hooks():
+    for hook in list(_backward_hooks.values()):
+        hook()
 
 
 def grad(heads, variables, head_grads=None, retain_graph=None, create_graph=False,
@@ -135,6 +135,48 @@ class Context:
         dev_id = ctypes.c_int(self.device_id)
         check_call(_LIB.MXStorageEmptyCache(dev_type, dev_id))
 
+    def memory_stats(self):
+        """Returns the usage statistics of the memory pool of the contexts device.
+
+        Only the Naive, Round and BestFit pool types keep statistics.
+
+        Returns
+        -------
+        dict
+            - bytes_in_use: bytes of the arrays alive, as rounded by the pool.
+            - bytes_cached: bytes kept free in the pool for reuse.
+            - peak_bytes_in_use: highest value of bytes_in_use.
+            - num_allocs: number of allocations.
+            - num_pool_hits: number of allocations served from the pool.
+            - largest_free_chunk: size of the largest cached free chunk.
+            - fragmentation: part of the cached memory that cannot serve an allocation
+              as large as all of it, between 0 and 1.
+            - free_chunks: list of (chunk size, number of cached free chunks).
+
+        Examples
+        -------
+        >>> ctx = mx.gpu(0)
+        >>> arr = mx.nd.ones((200,200), ctx=ctx)
+        >>> del arr
+        >>> ctx.memory_stats()['bytes_cached'] > 0
+        True
+        """
+        stats = [ctypes.c_uint64() for _ in range(6)]
+        num_sizes = ctypes.c_int()
+        sizes = ctypes.POINTER(ctypes.c_uint64)()
+        counts = ctypes.POINTER(ctypes.c_uint64)()
+        check_call(_LIB.MXStorageGetStats(
+            ctypes.c_int(self.device_typeid), ctypes.c_int(self.device_id),
+            *[ctypes.byref(s) for s in stats], ctypes.byref(num_sizes),
+            ctypes.byref(sizes), ctypes.byref(counts)))
+        keys = ['bytes_in_use', 'bytes_cached', 'peak_bytes_in_use', 'num_allocs',
+                'num_pool_hits', 'largest_free_chunk']
+        ret = {k: s.value for k, s in zip(keys, stats)}
+        cached = ret['bytes_cached']
+        ret['fragmentation'] = 1.0 - ret['largest_free_chunk'] / cached if cached else 0.0
+        ret['free_chunks'] = [(sizes[i], counts[i]) for i in range(num_sizes.value)]
+        return ret
+
 
 def cpu(device_id=0):
     """Returns a CPU context.
@@ -21,7 +21,7 @@ __all__ = ['init', 'init_trainer', 'scale_loss', 'unscale', 'convert_model',
            'convert_hybrid_block', 'list_lp16_ops', 'list_fp32_ops',
            'list_lp16_fp32_ops', 'list_conditional_fp32_ops',
            'list_widest_type_cast', 'list_loss_output_functions', 'list_lp16_use_fp32_params',
-           'convert_symbol']
+           'list_fp8_ops', 'convert_symbol']
 
 from array import array
 import ctypes
@@ -372,7 +372,7 @@ def unscale(optimizer_or_trainer):
 def convert_symbol(sym, target_dtype="float16", target_dtype_ops=None,
                    fp32_ops=None, conditional_fp32_ops=None,
                    excluded_sym_names=None, data_names=None,
-                   cast_optional_params=False):
+                   cast_optional_params=False, fp8_ops=None, fp8_options=None):
     """Given a symbol object representing a neural network of data type FP32 and target_dtype,
     add cast layers according to the op lists (target_dtype_ops, fp32_ops,
     conditional_fp32_ops) if provided, otherwise use the default
@@ -405,11 +405,22 @@ def convert_symbol(sym, target_dtype="float16", target_dtype_ops=None,
         Whether to cast the arg_params and aux_params that don't require to be in LP16
         because of a cast layer following it, but will reduce the computation and memory
         overhead of the model if casted.
+    fp8_ops : list of strs, optional
+        Names of the operators run in FP8 with delayed scaling after the cast layers are
+        added, among list_fp8_ops(). Each of them gets an auxiliary state
+        `<name>_amax_history`, to be initialized to zeros. Only with the float16 target_dtype.
+    fp8_options : dict of str to str, optional
+        The fp8_format ('hybrid' or 'e4m3'), amax_history_len, amax_compute_algo ('max' or
+        'most_recent') and margin of the FP8 operators.
     """
     assert isinstance(sym, Symbol), "First argument to convert_symbol should be Symbol"
 
     assert target_dtype in ['float16', 'bfloat16'], \
                "Only target_dtype float16 and bfloat16 are supported currently"
+    if fp8_ops:
+        assert target_dtype == 'float16', "fp8_ops are only supported with float16 target_dtype"
+        unsupported = set(fp8_ops) - set(list_fp8_ops())
+        assert not unsupported, "Operators {} cannot run in FP8".format(unsupported)
 
     if target_dtype == 'bfloat16':
         target_dtype = bfloat16
@@ -527,11 +538,15 @@ def convert_symbol(sym, target_dtype="float16", target_dtype_ops=None,
                                             c_str_array(param_vals),
                                             c_str_array(model_param_names),
                                             keys))
-    return Symbol(out)
+    ret = Symbol(out)
+    if fp8_ops:
+        ret = ret.optimize_for('FP8', skip_infer=True, ops=','.join(fp8_ops),
+                               exclude=','.join(excluded_sym_names), **(fp8_options or {}))
+    return ret
 
 def convert_model(sym, arg_params, aux_params, target_dtype="float16", target_dtype_ops=None,
                   fp32_ops=None, conditional_fp32_ops=None, excluded_sym_names=None,
-                  cast_optional_params=False):
+                  cast_optional_params=False, fp8_ops=None, fp8_options=None):
     """API for converting a model from FP32 model to a mixed precision model.
     MXNet tries to convert the FP32 model to mixed precision model by adding
     cast layers using amp_cast and amp_multicast operators which can be used for inference use cases.
@@ -568,6 +583,11 @@ def convert_model(sym, arg_params, aux_params, target_dtype="float16", target_dt
         Whether to cast the arg_params and aux_params that don't require to be in LP16
         because of a cast layer following it, but will reduce the computation and memory
         overhead of the model if casted.
+    fp8_ops : list of strs
+        Names of the operators run in FP8, see convert_symbol. Their amax histories are
+        added to aux_params.
+    fp8_options : dict of str to str
+        Options of the FP8 operators, see convert_symbol.
     """
     if excluded_sym_names is None:
         excluded_sym_names = []
@@ -589,7 +609,8 @@ def convert_model(sym, arg_params, aux_params, target_dtype="float16", target_dt
     sym = convert_symbol(sym, target_dtype, target_dtype_ops,
                          fp32_ops, conditional_fp32_ops,
                          excluded_sym_names, data_names,
-                         cast_optional_params)
+                         cast_optional_params, fp8_ops, fp8_options)
+    aux_params.update(_fp8_amax_histories(sym, aux_params, fp8_options))
 
     # If dtype is set for params, cast the param to that dtype
     attr_dict = sym.attr_dict()
@@ -617,7 +638,7 @@ def convert_model(sym, arg_params, aux_params, target_dtype="float16", target_dt
 def convert_hybrid_block(block, target_dtype="float16", target_dtype_ops=None,
                          fp32_ops=None, conditional_fp32_ops=None,
                          excluded_sym_names=None, ctx=gpu(0),
-                         cast_optional_params=False):
+                         cast_optional_params=False, fp8_ops=None, fp8_options=None):
     """Given a hybrid block/symbol block representing a FP32 model and a target_dtype,
     return a block with mixed precision support which can be used for inference use cases.
 
@@ -645,6 +666,11 @@ def convert_hybrid_block(block, target_dtype="float16", target_dtype_ops=None,
         Whether to cast the arg_params and aux_params that don't require to be in LP16
         because of a cast layer following it, but will reduce the computation and memory
         overhead of the model if casted.
+    fp8_ops : list of strs
+        Names of the operators run in FP8, see convert_symbol. Their amax histories start
+        as zeros.
+    fp8_options : dict of str to str
+        Options of the FP8 operators, see convert_symbol.
     """
     from ...gluon import HybridBlock, SymbolBlock
     assert isinstance(block, HybridBlock), "block input should be a HybridBlock"
@@ -661,7 +687,8 @@ def convert_hybrid_block(block, target_dtype="float16", target_dtype_ops=None,
     converted_sym = convert_symbol(sym, target_dtype, target_dtype_ops,
                                    fp32_ops, conditional_fp32_ops,
                                    excluded_sym_names, data_names=input_names,
-                                   cast_optional_params=cast_optional_params)
+                                   cast_optional_params=cast_optional_params,
+                                   fp8_ops=fp8_ops, fp8_options=fp8_options)
 
     arg_names = set(converted_sym.list_arguments())
     aux_names = set(converted_sym.list_auxiliary_states())
@@ -704,9 +731,18 @@ def convert_hybrid_block(block, target_dtype="float16", target_dtype_ops=None,
         if aux_param_name in arg_dict and param.dtype != arg_dict[aux_param_name].dtype:
             param.cast(arg_dict[aux_param_name].dtype)
 
+    for name, value in _fp8_amax_histories(converted_sym, {}, fp8_options).items():
+        arg_dict.setdefault('aux:%s' % name, value)
     ret.load_dict(arg_dict, ctx=ctx)
     return ret
 
+def _fp8_amax_histories(sym, aux_params, fp8_options):
+    """Zero amax histories for the FP8 operators of sym missing from aux_params"""
+    history_len = int((fp8_options or {}).get('amax_history_len', 16))
+    return {name: ndarray.zeros((3, history_len))
+            for name in sym.list_auxiliary_states()
+            if name not in aux_params and name.endswith('_amax_history')}
+
 def list_lp16_ops(target_dtype):
     """Get the default list of LP16 ops for AMP
     """
@@ -761,6 +797,11 @@ def list_loss_output_functions(target_dtype):
         assert (target_dtype == bfloat16), "not supported type"
         return lists.symbol_bf16.LOSS_OUTPUT_FUNCTIONS
 
+def list_fp8_ops():
+    """Get the list of ops which can run in FP8
+    """
+    return lists.symbol_fp16.FP8_FUNCS
+
 def list_lp16_use_fp32_params(target_dtype):
     """ Get the params restrict for LP16
 
@@ -22,6 +22,7 @@
 BF16_FUNCS = [
     'Convolution',
     'FullyConnected',
+    'batch_dot',
     ]
 
 # Functions that should not be casted, either because
@@ -543,7 +544,6 @@ WIDEST_TYPE_CASTS = [
     '_sparse_ElementWiseSum',
     'add_n',
     '_sparse_add_n',
-    'batch_dot',
     'broadcast_add',
     'broadcast_plus',
     'broadcast_div',
@@ -616,3 +616,9 @@ WIDEST_TYPE_CASTS = [
 
 LOSS_OUTPUT_FUNCTIONS = [
     ]
+
+# Functions the FP8 pass can run on FP8 Tensor Cores, see convert_symbol(fp8_ops=...)
+FP8_FUNCS = [
+    'FullyConnected',
+    'batch_dot',
+    ]
@@ -86,6 +86,45 @@ def dl_managed_tensor_deleter(dl_managed_tensor_handle):
     pyobj = ctypes.cast(void_p, ctypes.py_object)
     ctypes.pythonapi.Py_DecRef(pyobj)
 
+# the DLPack device types of the MXNet contexts
+_DL_DEVICE_TYPES = {'cpu': 1, 'gpu': 2, 'cpu_pinned': 3, 'cpu_shared': 1}
+_DL_GPU = 2
+# the CUDA stream the producers of GPU tensors exported with __dlpack__ are ordered with,
+# cudaStreamPerThread, which lets an imported array wait for the producer on the device
+_PER_THREAD_STREAM = 2
+
+
+def dlpack_device(data):
+    """Returns the (DLPack device type, device id) of an array, for __dlpack_device__."""
+    return (_DL_DEVICE_TYPES[data.ctx.device_type], data.ctx.device_id)
+
+
+def to_dlpack_for_stream(data, stream=None):
+    """Returns the DLPack tensor of an array for a consumer working on a stream, for
+    __dlpack__.
+
+    For arrays on GPU, the work the consumer queues on the CUDA stream from now on waits for
+    the pending writes of the array with a CUDA event, without waiting on the host for the
+    device. stream is the address of the cudaStream_t, 1 or None for the legacy default
+    stream, 2 for the per-thread default stream, or -1 for no synchronization.
+    Arrays on CPU are waited for on the host.
+    """
+    if data.ctx.device_type == 'gpu':
+        if stream == 0:
+            raise ValueError('stream 0 is ambiguous, use 1 for the legacy default stream or '
+                             '2 for the per-thread default stream')
+        if stream != -1:
+            check_call(_LIB.MXNDArraySyncToStream(
+                data.handle, ctypes.c_void_p(1 if stream is None else stream), ctypes.c_int(0)))
+    else:
+        if stream is not None:
+            raise ValueError('stream must be None for arrays on CPU, got %s' % str(stream))
+        data.wait_to_read()
+    dlpack = DLPackHandle()
+    check_call(_LIB.MXNDArrayToDLPack(data.handle, ctypes.byref(dlpack)))
+    return ctypes.pythonapi.PyCapsule_New(dlpack, _c_str_dltensor, _c_dlpack_deleter)
+
+
 def ndarray_from_dlpack(array_cls):
     """Returns a function that returns specified array_cls from dlpack.
 
@@ -94,6 +133,13 @@ def ndarray_from_dlpack(array_cls):
     fn : dlpack -> array_cls
     """
     def from_dlpack(dlpack):
+        stream = None
+        if hasattr(dlpack, '__dlpack__'):
+            # the producer orders the stream of this thread after its work, and the array
+            # is ordered after the stream with a CUDA event
+            if dlpack.__dlpack_device__()[0] == _DL_GPU:
+                stream = _PER_THREAD_STREAM
+            dlpack = dlpack.__dlpack__(stream=stream)
         handle = NDArrayHandle()
         dlpack = ctypes.py_object(dlpack)
         assert ctypes.pythonapi.PyCapsule_IsValid(dlpack, _c_str_dltensor), ValueError(
@@ -104,6 +150,8 @@ def ndarray_from_dlpack(array_cls):
         ctypes.pythonapi.PyCapsule_SetName(dlpack, _c_str_used_dltensor)
         # delete the deleter of the old dlpack
         ctypes.pythonapi.PyCapsule_SetDestructor(dlpack, None)
+        if stream is not None:
+            check_call(_LIB.MXNDArraySyncFromStream(handle, ctypes.c_void_p(stream)))
         return array_cls(handle=handle)
     return from_dlpack
 
@@ -72,3 +72,133 @@ def bulk(size):
                 x += 1
     """
     return _BulkScope(size)
+
+
+def set_priority(priority):
+    """Set the priority of the operators pushed by the current thread.
+
+    With ``MXNET_ENGINE_PRIORITY_SCHEDULING=1``, engine workers always run
+    the runnable operator with the highest priority first, so that operators
+    pushed with a higher priority (e.g. latency-critical inference) overtake
+    lower-priority work (e.g. background training) in the same process.
+    Operators of equal priority run in push order.
+
+    Parameters
+    ----------
+    priority : int
+        Priority of the operators pushed afterwards. Higher is more urgent.
+
+    Returns
+    -------
+    int
+        Previous priority.
+    """
+    prev = ctypes.c_int()
+    check_call(_LIB.MXEngineSetPushPriority(
+        ctypes.c_int(priority), ctypes.byref(prev)))
+    return prev.value
+
+
+class _PriorityScope(object):
+    """Scope object for operator priority."""
+    def __init__(self, priority):
+        self._priority = priority
+        self._old_priority = None
+
+    def __enter__(self):
+        self._old_priority = set_priority(self._priority)
+        return self
+
+    def __exit__(self, ptype, value, trace):
+        set_priority(self._old_priority)
+
+
+def priority(priority):
+    """Run the operators pushed in the scope with the given priority.
+
+    Returns a scope for managing the priority::
+
+        with mx.engine.priority(10):
+            out = net(data)
+    """
+    return _PriorityScope(priority)
+
+
+def set_wait_tag(tag):
+    """Tag the operators pushed by the current thread, so that `wait_for_tag`
+    waits for them only.
+
+    A server running the models of several tenants in one process tags the
+    operators of each tenant, so that a tenant synchronizing its work does not
+    wait for the work of the others, as `mx.nd.waitall` would.
+
+    Parameters
+    ----------
+    tag : int
+        Tag of the operators pushed afterwards, 0 for none.
+
+    Returns
+    -------
+    int
+        Previous tag.
+    """
+    prev = ctypes.c_int()
+    check_call(_LIB.MXEngineSetWaitTag(
+        ctypes.c_int(tag), ctypes.byref(prev)))
+    return prev.value
+
+
+class _WaitTagScope(object):
+    """Scope object for the tag of operators."""
+    def __init__(self, tag):
+        self._tag = tag
+        self._old_tag = None
+
+    def __enter__(self):
+        self._old_tag = set_wait_tag(self._tag)
+        return self
+
+    def __exit__(self, ptype, value, trace):
+        set_wait_tag(self._old_tag)
+
+
+def wait_tag(tag):
+    """Tag the operators pushed in the scope, see `set_wait_tag`.
+
+    Returns a scope for managing the tag::
+
+        with mx.engine.wait_tag(1):
+            out = net(data)
+        mx.engine.wait_for_tag(1)
+    """
+    return _WaitTagScope(tag)
+
+
+def wait_for_tag(tag):
+    """Wait until the operators pushed with a tag complete.
+
+    Unlike `mx.nd.waitall`, the errors of the operators are not raised here but
+    when reading their outputs.
+
+    Parameters
+    ----------
+    tag : int
+        The tag, not 0.
+    """
+    check_call(_LIB.MXEngineWaitForTag(ctypes.c_int(tag)))
+
+
+def wait_for_context(ctx):
+    """Wait until the operators pushed to a context complete, without waiting
+    for the other contexts.
+
+    Unlike `mx.nd.waitall`, the errors of the operators are not raised here but
+    when reading their outputs.
+
+    Parameters
+    ----------
+    ctx : Context
+        The context, e.g. ``mx.gpu(1)``.
+    """
+    check_call(_LIB.MXEngineWaitForContext(
+        ctypes.c_int(ctx.device_typeid), ctypes.c_int(ctx.device_id)))
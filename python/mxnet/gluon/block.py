@@ -21,6 +21,8 @@
 __all__ = ['Block', 'HybridBlock', 'SymbolBlock']
 
 import copy
+import json
+import os
 import warnings
 import weakref
 from collections import OrderedDict, defaultdict
@@ -46,6 +48,10 @@ from .. util import is_np_array, np_shape, np_array
 
 _naming_counter = contextvars.ContextVar('namecounter')
 _prefix = contextvars.ContextVar('prefix', default='')
+# the number of consecutive identical traces after which an eager HybridBlock is hybridized
+_AUTO_HYBRIDIZE = int(os.environ.get('MXNET_AUTO_HYBRIDIZE', 0))
+# whether an eager HybridBlock call is running, whose children are not traced on their own
+_in_eager_call = contextvars.ContextVar('in_eager_call', default=False)
 
 
 @contextlib.contextmanager
@@ -911,6 +917,10 @@ class HybridBlock(Block):
         self._monitor_all = False
         self._backend = None
         self._backend_opts = {}
+        self._auto_hybridize = True
+        self._auto_signature = None
+        self._auto_graph = None
+        self._auto_count = 0
 
     def __setattr__(self, name, value):
         """Registers parameters."""
@@ -982,6 +992,61 @@ class HybridBlock(Block):
             self._cached_graph = symbol_inputs, symbol_outputs
         return self._cached_graph
 
+    def _trace_key(self, *args):
+        """Trace forward in deferred compute mode, without computing the outputs, and
+        return the graph traced with the names of its operator nodes left out."""
+        flatten_args, in_format = _flatten(args, "input")
+        flatten_args = [ele.detach() if ele is not None else None for ele in flatten_args]
+        real_args = [ele for ele in flatten_args if ele is not None]
+        symbol_inputs = [
+            symbol.var('data{}'.format(i)).as_np_ndarray()
+            if isinstance(arg, _mx_np.ndarray) else symbol.var('data{}'.format(i))
+            for i, arg in enumerate(real_args)
+        ]
+        dc.set_variable(real_args, symbol_inputs)
+        args = _regroup(flatten_args, in_format)
+        with autograd.pause(), dc.context():
+            out = super().__call__(*args)
+        flatten_out, out_format = _flatten(out, "output")
+        graph = json.loads(dc.get_symbol(flatten_out, sym_cls=type(symbol_inputs[0])).tojson())
+        nodes = [(n['op'], n['name'] if n['op'] == 'null' else '', n.get('attrs', {}),
+                  n['inputs']) for n in graph['nodes']]
+        return json.dumps([nodes, graph['heads'], str(out_format)], sort_keys=True)
+
+    def _auto_hybridize_call(self, *args):
+        """Count the calls of an eager block tracing the same graph for the same kind of
+        inputs, and hybridize the block once MXNET_AUTO_HYBRIDIZE calls in a row did.
+
+        Returns whether the block is hybridized. Blocks tracing another graph for the same
+        kind of inputs, which have data dependent control flow, or failing to trace, for
+        example because of in-place operations, stay eager.
+        """
+        if _in_eager_call.get() or dc.is_deferred_compute() or not self._auto_hybridize or \
+                self._forward_hooks or self._forward_pre_hooks:
+            return False
+        flatten_args, _ = _flatten(args, "input")
+        signature = (autograd.is_training(), tuple(
+            None if ele is None else (type(ele), ele.shape, ele.dtype, ele.ctx)
+            for ele in flatten_args))
+        try:
+            key = self._trace_key(*args)
+        except Exception as e:  # pylint: disable=broad-except
+            warnings.warn('"{block}" stays eager, it cannot be traced: {error}'
+                          .format(block=type(self).__name__, error=e))
+            self._auto_hybridize = False
+            return False
+        if signature != self._auto_signature:
+            self._auto_signature, self._auto_graph, self._auto_count = signature, key, 1
+        elif key != self._auto_graph:
+            self._auto_hybridize = False
+            return False
+        else:
+            self._auto_count += 1
+        if self._auto_count < _AUTO_HYBRIDIZE:
+            return False
+        self.hybridize(static_alloc=True, static_shape=True)
+        return True
+
     def _get_graph(self, *args):
         if not self._cached_graph:
             if self.hybrid_forward.__func__ is not HybridBlock.hybrid_forward:  # Gluon 1
@@ -1233,6 +1298,40 @@ class HybridBlock(Block):
             Optimize for invariant input shapes between iterations. Must also
             set static_alloc to True. Change of input shapes is still allowed
             but slower.
+        static_cache_size : int, default 0
+            With static_alloc, number of input shape signatures that keep a static
+            memory plan and executors of their own, the least recently used ones
+            are evicted. 0 shares one static plan between all the input shapes.
+        static_shape_bucket : int, default 0
+            With static_cache_size, round the dimensions of the data inputs up to
+            a multiple of this value when looking up the static plan, so that the
+            shapes of a bucket reuse the memory of one plan.
+        memory_arena : bool, default False
+            Place the intermediate arrays of the graph in a single allocation, at
+            offsets packed by their lifetimes, which lowers the peak memory of
+            the static allocation.
+        alias_concat : bool, default False
+            Compute the inputs of a concatenation in place in its output, and the
+            outputs of a split in place in its input, so that they are not copied.
+            Only applies when all the dimensions before the axis are 1, e.g. along
+            the batch axis, or along the channels of a batch of one.
+        backward_mirror : bool, default False
+            Recompute cheap operators during backward instead of keeping their
+            outputs alive between forward and backward. Defaults to True when
+            MXNET_BACKWARD_DO_MIRROR or MXNET_MEMORY_OPT is set.
+        offload_activations : bool, default False
+            On GPU, move the activations saved for backward to pinned host memory
+            after a recorded forward pass and copy them back during backward, trading
+            PCIe bandwidth for device memory. Ignored with static_alloc.
+        offload_min_size : int, default 1048576
+            Activations smaller than this many bytes stay on the device.
+        offload_prefetch_distance : int, default 2
+            Number of backward operators an offloaded activation is copied back
+            ahead of its first use.
+        prepack_weights : bool, default False
+            With MKLDNN, convert the parameters to the blocked layouts of the
+            operators during the first inference pass on each CPU context, so that
+            the later passes use them without reordering.
         """
 
         self._backend = backend
@@ -1241,6 +1340,8 @@ class HybridBlock(Block):
             "HybridBlock hybridize requires backend_opts to be a dictionary."
             self._backend_opts = backend_opts
 
+        # blocks hybridized, or kept eager, by the user are not hybridized automatically
+        self._auto_hybridize = False
         self._active = active
         self._flags = list(kwargs.items())
         if clear:
@@ -1403,8 +1504,15 @@ class HybridBlock(Block):
                 self._called_infer_shape_already = True
 
             if not self._active:
-                # Normal imperative computation of forward()
-                return super().__call__(x, *args)
+                if not _AUTO_HYBRIDIZE:
+                    # Normal imperative computation of forward()
+                    return super().__call__(x, *args)
+                if not self._auto_hybridize_call(x, *args):
+                    token = _in_eager_call.set(True)
+                    try:
+                        return super().__call__(x, *args)
+                    finally:
+                        _in_eager_call.reset(token)
 
             if dc.is_deferred_compute():
                 # Deferred compute is already enabled. This typically means that the current
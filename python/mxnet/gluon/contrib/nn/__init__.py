@@ -23,4 +23,8 @@ from . import basic_layers
 
 from .basic_layers import *
 
-__all__ = basic_layers.__all__
+from . import tensor_parallel
+
+from .tensor_parallel import *
+
+__all__ = basic_layers.__all__ + tensor_parallel.__all__
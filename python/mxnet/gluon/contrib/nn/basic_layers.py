@@ -23,9 +23,11 @@ __all__ = ['Concurrent', 'HybridConcurrent', 'Identity',
            'SyncBatchNorm', 'PixelShuffle1D', 'PixelShuffle2D',
            'PixelShuffle3D']
 
+import ctypes
 import warnings
 import uuid
 from .... import ndarray as nd, context
+from ....base import _LIB, check_call, py_str
 from ...block import HybridBlock
 from ...nn import Sequential, HybridSequential, BatchNorm
 
@@ -151,6 +153,21 @@ class SyncBatchNorm(BatchNorm):
         Initializer for the running mean.
     running_variance_initializer: str or `Initializer`, default 'ones'
         Initializer for the running variance.
+    backend : str, default 'shared'
+        How the statistics are exchanged between the devices. 'shared' averages them in
+        host memory between the `num_devices` devices of the process, which wait for each
+        other at a barrier. 'nccl' all-reduces them with NCCL on the GPU streams without
+        synchronizing with the host, between the `num_ranks` devices of all the processes
+        sharing `nccl_id`, e.g. on several nodes.
+    nccl_id : str, default None
+        The id of the devices synchronized together by the 'nccl' backend, created by
+        :py:meth:`create_nccl_id` in one process and sent to the others.
+    num_ranks : int, default None
+        Number of devices synchronized together by the 'nccl' backend over all the
+        processes, `num_devices` if None.
+    rank_offset : int, default 0
+        Rank of the first device of this process among the `num_ranks` devices of the
+        'nccl' backend, e.g. the rank of the process times `num_devices`.
 
 
     Inputs:
@@ -167,7 +184,8 @@ class SyncBatchNorm(BatchNorm):
     def __init__(self, in_channels=0, num_devices=None, momentum=0.9, epsilon=1e-5,
                  center=True, scale=True, use_global_stats=False, beta_initializer='zeros',
                  gamma_initializer='ones', running_mean_initializer='zeros',
-                 running_variance_initializer='ones', **kwargs):
+                 running_variance_initializer='ones', backend='shared', nccl_id=None,
+                 num_ranks=None, rank_offset=0, **kwargs):
         super(SyncBatchNorm, self).__init__(
             axis=1, momentum=momentum, epsilon=epsilon,
             center=center, scale=scale,
@@ -181,6 +199,24 @@ class SyncBatchNorm(BatchNorm):
         self._kwargs = {'eps': epsilon, 'momentum': momentum,
                         'fix_gamma': not scale, 'use_global_stats': use_global_stats,
                         'ndev': num_devices, 'key': uuid.uuid4()}
+        if backend == 'nccl':
+            if not nccl_id:
+                raise ValueError("The 'nccl' backend of SyncBatchNorm needs an nccl_id, "
+                                 "see SyncBatchNorm.create_nccl_id")
+            self._kwargs.update({'backend': backend, 'nccl_id': nccl_id,
+                                 'num_ranks': num_ranks if num_ranks else num_devices,
+                                 'rank_offset': rank_offset})
+        elif backend != 'shared':
+            raise ValueError("Unknown SyncBatchNorm backend %s" % backend)
+
+    @staticmethod
+    def create_nccl_id():
+        """Creates the id of the devices synchronized by the 'nccl' backend. The layers
+        whose statistics are exchanged with the same id have to run one after the other
+        on each device, as their all-reduces are issued in turn."""
+        out = ctypes.c_char_p()
+        check_call(_LIB.MXNCCLGetUniqueId(ctypes.byref(out)))
+        return py_str(out.value)
 
     def _get_num_devices(self):
         warnings.warn("Caution using SyncBatchNorm: "
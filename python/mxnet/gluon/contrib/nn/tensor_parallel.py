@@ -0,0 +1,331 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+# coding: utf-8
+# pylint: disable= arguments-differ
+"""Layers whose weights are split across devices, as in tensor parallelism."""
+
+__all__ = ['ColumnParallelDense', 'RowParallelDense', 'ParallelMultiHeadAttention']
+
+import math
+from .... import ndarray as nd, initializer
+from .... import numpy as _mx_np, numpy_extension as _mx_npx
+from ....util import is_np_array
+from ...block import Block
+from ...nn import Dense
+from ...parameter import Parameter
+
+
+def _concat(xs, axis):
+    if is_np_array():
+        return _mx_np.concatenate(xs, axis=axis)
+    return nd.concat(*xs, dim=axis)
+
+
+def _split(x, num, axis):
+    if num == 1:
+        return [x]
+    if is_np_array():
+        return _mx_np.split(x, num, axis=axis)
+    return nd.split(x, num_outputs=num, axis=axis)
+
+
+def _to(x, ctx):
+    return x if x.ctx == ctx else x.copyto(ctx)
+
+
+def _all_gather(xs, ctx, axis):
+    """Concatenates the shards of a tensor on `ctx`."""
+    return _concat([_to(x, ctx) for x in xs], axis)
+
+
+def _all_reduce(xs, ctx):
+    """Sums the partial results of the shards on `ctx`."""
+    out = _to(xs[0], ctx)
+    for x in xs[1:]:
+        out = out + _to(x, ctx)
+    return out
+
+
+class _TensorParallel(Block):
+    """Base of the layers whose i-th shard lives on the i-th of their contexts.
+
+    The collectives between the shards are cross-device copies and sums recorded by
+    autograd, that the engine runs on its copy workers with peer-to-peer access.
+    Their Parameters are placed by :py:meth:`initialize`, which therefore has to be
+    called before the `initialize` of an enclosing Block.
+    """
+    def __init__(self, contexts):
+        super(_TensorParallel, self).__init__()
+        if not contexts:
+            raise ValueError('contexts must not be empty')
+        self._contexts = list(contexts)
+        self._shards = []
+
+    def _add_shard(self, block):
+        self._shards.append(block)
+        self.register_child(block, 'shard%d' % (len(self._shards) - 1))
+
+    @property
+    def contexts(self):
+        return self._contexts
+
+    def _placement(self):
+        """The Parameters and the context of each of them."""
+        placement = []
+        for shard, ctx in zip(self._shards, self._contexts):
+            placement.extend((p, ctx) for p in shard.collect_params().values())
+        return placement
+
+    def initialize(self, init=initializer.Uniform(), ctx=None, verbose=False,
+                   force_reinit=False):
+        """Initializes the Parameters of the i-th shard on the i-th context, and the
+        replicated Parameters on the first context. `ctx` is ignored."""
+        if verbose:
+            init.set_verbosity(verbose=verbose)
+        for param, param_ctx in self._placement():
+            param.initialize(None, param_ctx, init, force_reinit=force_reinit)
+
+    def _scatter(self, x):
+        """The input of each shard: the list of the per-device inputs, or copies of x."""
+        if isinstance(x, (list, tuple)):
+            if len(x) != len(self._contexts):
+                raise ValueError('Expected %d inputs, one per context, but got %d'
+                                 % (len(self._contexts), len(x)))
+            return [_to(xi, ctx) for xi, ctx in zip(x, self._contexts)]
+        return [_to(x, ctx) for ctx in self._contexts]
+
+
+class ColumnParallelDense(_TensorParallel):
+    """Densely-connected layer whose output units are split across devices.
+
+    The i-th device computes `units / len(contexts)` consecutive output units, with the
+    matching rows of the weight and slice of the bias.
+
+    Parameters
+    ----------
+    units : int
+        Dimensionality of the output space, a multiple of the number of contexts.
+    contexts : list of Context
+        The devices of the shards.
+    in_units : int
+        Size of the input data.
+    activation : str
+        Activation function applied by each shard. See :py:class:`nn.Dense`.
+    use_bias : bool, default True
+        Whether the layer uses a bias vector.
+    flatten : bool, default True
+        Whether the input tensor should be flattened. See :py:class:`nn.Dense`.
+    gather_output : bool, default True
+        Whether to gather the output on the first context. If False, the list of the
+        outputs of the shards is returned, e.g. as the input of a
+        :py:class:`RowParallelDense`.
+    dtype : str or np.dtype, default 'float32'
+        Data type of the weights.
+    weight_initializer : str or `Initializer`
+        Initializer for the weights.
+    bias_initializer : str or `Initializer`
+        Initializer for the bias.
+
+    Inputs:
+        - **data**: input tensor, or the list of its copies on each context.
+    Outputs:
+        - **out**: output tensor on the first context, or the list of the outputs of
+          the shards if `gather_output` is False.
+    """
+    def __init__(self, units, contexts, in_units, activation=None, use_bias=True,
+                 flatten=True, gather_output=True, dtype='float32', weight_initializer=None,
+                 bias_initializer='zeros'):
+        super(ColumnParallelDense, self).__init__(contexts)
+        if units % len(self._contexts):
+            raise ValueError('units %d is not a multiple of the %d contexts'
+                             % (units, len(self._contexts)))
+        self._units = units
+        self._gather_output = gather_output
+        for _ in self._contexts:
+            self._add_shard(Dense(units // len(self._contexts), activation=activation,
+                                  use_bias=use_bias, flatten=flatten, dtype=dtype,
+                                  weight_initializer=weight_initializer,
+                                  bias_initializer=bias_initializer, in_units=in_units))
+
+    def forward(self, x):
+        outs = [shard(xi) for shard, xi in zip(self._shards, self._scatter(x))]
+        if not self._gather_output:
+            return outs
+        return _all_gather(outs, self._contexts[0], -1)
+
+    def __repr__(self):
+        return '{name}({units}, contexts={contexts}, gather_output={gather})'.format(
+            name=self.__class__.__name__, units=self._units, contexts=self._contexts,
+            gather=self._gather_output)
+
+
+class RowParallelDense(_TensorParallel):
+    """Densely-connected layer whose input features are split across devices.
+
+    The i-th device multiplies the i-th slice of the last axis of the input with the
+    matching columns of the weight, and the partial results are summed on the first
+    context, where the bias is added.
+
+    Parameters
+    ----------
+    units : int
+        Dimensionality of the output space.
+    contexts : list of Context
+        The devices of the shards.
+    in_units : int
+        Size of the last axis of the input, a multiple of the number of contexts.
+    use_bias : bool, default True
+        Whether the layer uses a bias vector.
+    dtype : str or np.dtype, default 'float32'
+        Data type of the weights.
+    weight_initializer : str or `Initializer`
+        Initializer for the weights.
+    bias_initializer : str or `Initializer`
+        Initializer for the bias.
+
+    Inputs:
+        - **data**: input tensor of shape `(..., in_units)`, or the list of its slices on
+          each context, e.g. the outputs of a :py:class:`ColumnParallelDense` with
+          `gather_output=False`.
+    Outputs:
+        - **out**: output tensor of shape `(..., units)` on the first context.
+    """
+    def __init__(self, units, contexts, in_units, use_bias=True, dtype='float32',
+                 weight_initializer=None, bias_initializer='zeros'):
+        super(RowParallelDense, self).__init__(contexts)
+        if in_units % len(self._contexts):
+            raise ValueError('in_units %d is not a multiple of the %d contexts'
+                             % (in_units, len(self._contexts)))
+        self._units = units
+        for _ in self._contexts:
+            self._add_shard(Dense(units, use_bias=False, flatten=False, dtype=dtype,
+                                  weight_initializer=weight_initializer,
+                                  in_units=in_units // len(self._contexts)))
+        self.bias = Parameter('bias', shape=(units,), init=bias_initializer,
+                              dtype=dtype) if use_bias else None
+
+    def _placement(self):
+        placement = super(RowParallelDense, self)._placement()
+        if self.bias is not None:
+            placement.append((self.bias, self._contexts[0]))
+        return placement
+
+    def forward(self, x):
+        if isinstance(x, (list, tuple)):
+            pieces = self._scatter(x)
+        else:
+            pieces = [_to(xi, ctx) for xi, ctx in
+                      zip(_split(x, len(self._contexts), -1), self._contexts)]
+        out = _all_reduce([shard(xi) for shard, xi in zip(self._shards, pieces)],
+                          self._contexts[0])
+        if self.bias is not None:
+            out = out + self.bias.data(self._contexts[0])
+        return out
+
+    def __repr__(self):
+        return '{name}({units}, contexts={contexts})'.format(
+            name=self.__class__.__name__, units=self._units, contexts=self._contexts)
+
+
+class ParallelMultiHeadAttention(_TensorParallel):
+    """Multi-head self-attention whose heads are split across devices.
+
+    Each device projects the input to the queries, keys and values of
+    `num_heads / len(contexts)` heads, computes their attention locally with `batch_dot`,
+    and the output projection is a :py:class:`RowParallelDense` over the heads. The only
+    collectives are the copies of the input to the devices and the sum of the output
+    projection.
+
+    Parameters
+    ----------
+    units : int
+        Total size of the heads and of the output.
+    num_heads : int
+        Number of heads, a multiple of the number of contexts, dividing `units`.
+    contexts : list of Context
+        The devices of the shards.
+    in_units : int
+        Size of the last axis of the input.
+    use_bias : bool, default True
+        Whether the projections use bias vectors.
+    dtype : str or np.dtype, default 'float32'
+        Data type of the weights.
+    weight_initializer : str or `Initializer`
+        Initializer for the weights.
+    bias_initializer : str or `Initializer`
+        Initializer for the biases.
+
+    Inputs:
+        - **data**: input tensor of shape `(batch_size, length, in_units)`.
+        - **mask**: optional tensor of shape `(batch_size, length, length)`, whose zeros
+          mask the corresponding attention scores.
+    Outputs:
+        - **out**: output tensor of shape `(batch_size, length, units)` on the first
+          context.
+    """
+    def __init__(self, units, num_heads, contexts, in_units, use_bias=True, dtype='float32',
+                 weight_initializer=None, bias_initializer='zeros'):
+        super(ParallelMultiHeadAttention, self).__init__(contexts)
+        if num_heads % len(self._contexts) or units % num_heads:
+            raise ValueError('num_heads %d must be a multiple of the %d contexts and divide '
+                             'units %d' % (num_heads, len(self._contexts), units))
+        self._units = units
+        self._num_heads = num_heads
+        local_units = units // len(self._contexts)
+        for _ in self._contexts:
+            self._add_shard(Dense(3 * local_units, use_bias=use_bias, flatten=False,
+                                  dtype=dtype, weight_initializer=weight_initializer,
+                                  bias_initializer=bias_initializer, in_units=in_units))
+        self.proj = RowParallelDense(units, self._contexts, units, use_bias=use_bias,
+                                     dtype=dtype, weight_initializer=weight_initializer,
+                                     bias_initializer=bias_initializer)
+
+    def _placement(self):
+        return super(ParallelMultiHeadAttention, self)._placement() + self.proj._placement()
+
+    def _attend(self, qkv, mask):
+        batch_size, length, _ = qkv.shape
+        heads = self._num_heads // len(self._contexts)
+        head_units = self._units // self._num_heads
+
+        def to_heads(x):
+            x = x.reshape((batch_size, length, heads, head_units)).transpose((0, 2, 1, 3))
+            return x.reshape((batch_size * heads, length, head_units))
+
+        q, k, v = [to_heads(x) for x in _split(qkv, 3, -1)]
+        batch_dot = _mx_npx.batch_dot if is_np_array() else nd.batch_dot
+        softmax = _mx_npx.softmax if is_np_array() else nd.softmax
+        scores = batch_dot(q, k, transpose_b=True) / math.sqrt(head_units)
+        if mask is not None:
+            scores = scores.reshape((batch_size, heads, length, length))
+            scores = scores + (1 - mask.reshape((batch_size, 1, length, length))) * -1e18
+            scores = scores.reshape((batch_size * heads, length, length))
+        out = batch_dot(softmax(scores, axis=-1), v)
+        out = out.reshape((batch_size, heads, length, head_units)).transpose((0, 2, 1, 3))
+        return out.reshape((batch_size, length, heads * head_units))
+
+    def forward(self, x, mask=None):
+        masks = self._scatter(mask) if mask is not None else [None] * len(self._contexts)
+        outs = [self._attend(shard(xi), m) for shard, xi, m in
+                zip(self._shards, self._scatter(x), masks)]
+        return self.proj(outs)
+
+    def __repr__(self):
+        return '{name}({units}, num_heads={heads}, contexts={contexts})'.format(
+            name=self.__class__.__name__, units=self._units, heads=self._num_heads,
+            contexts=self._contexts)
@@ -0,0 +1,215 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+# coding: utf-8
+"""Micro-batched pipeline parallelism of Gluon blocks across devices."""
+
+from ... import autograd
+from ...context import Context
+from ..nn import HybridSequential
+from ..utils import split_data
+
+__all__ = ['PipelineParallel', 'split_sequential', 'one_f_one_b_schedule']
+
+
+def split_sequential(net, num_stages):
+    """Splits a HybridSequential into contiguous stages of balanced parameter sizes.
+
+    Parameters
+    ----------
+    net : HybridSequential
+        The network to split. Its parameters must be initialized, possibly deferred.
+    num_stages : int
+        Number of stages, at most the number of children of `net`.
+
+    Returns
+    -------
+    list of HybridSequential
+        The stages, sharing the children and parameters of `net`.
+    """
+    children = [net[i] for i in range(len(net))]
+    if not 0 < num_stages <= len(children):
+        raise ValueError('Cannot split %d blocks into %d stages' % (len(children), num_stages))
+
+    def size(block):
+        total = 0
+        for p in block.collect_params().values():
+            if p.shape is not None:
+                n = 1
+                for d in p.shape:
+                    n *= max(d, 1)
+                total += n
+        return max(total, 1)
+
+    sizes = [size(c) for c in children]
+    target = sum(sizes) / float(num_stages)
+    stages, current, acc = [], [], 0
+    for i, (child, n) in enumerate(zip(children, sizes)):
+        current.append(child)
+        acc += n
+        left_blocks = len(children) - i - 1
+        left_stages = num_stages - len(stages) - 1
+        if left_stages > 0 and (acc >= target * (len(stages) + 1) or left_blocks == left_stages):
+            stages.append(current)
+            current = []
+    stages.append(current)
+    result = []
+    for blocks in stages:
+        stage = HybridSequential()
+        stage.add(*blocks)
+        result.append(stage)
+    return result
+
+
+def one_f_one_b_schedule(num_stages, num_micro_batches):
+    """The 1F1B order of the forward and backward passes of the micro-batches.
+
+    The first `num_stages` micro-batches are run forward to fill the pipeline. Then each
+    backward pass is followed by the forward pass of the next micro-batch, so that at most
+    `num_stages` micro-batches keep their activations alive.
+
+    Returns
+    -------
+    list of (str, int)
+        ('F', i) for the forward pass and ('B', i) for the backward pass of micro-batch i.
+    """
+    warmup = min(num_stages, num_micro_batches)
+    schedule = [('F', i) for i in range(warmup)]
+    for i in range(num_micro_batches):
+        schedule.append(('B', i))
+        if i + warmup < num_micro_batches:
+            schedule.append(('F', i + warmup))
+    return schedule
+
+
+class PipelineParallel(object):
+    """Runs a model split into stages on several devices, with micro-batches.
+
+    Each stage lives on its own device and is hybridized with static memory, so that it
+    runs as a CachedOp. A batch is split into micro-batches, which go through the stages
+    in the 1F1B order of :py:func:`one_f_one_b_schedule`. The passes are only pushed to the
+    engine, which runs the stages of different micro-batches concurrently on their devices
+    and copies the activations between devices on its copy workers.
+
+    The gradients of the micro-batches are accumulated, so the parameters of the stages
+    have their `grad_req` set to 'add', and :py:meth:`forward_backward` zeroes them before
+    each batch. A Trainer over :py:meth:`collect_params` then steps with the batch size of
+    the whole batch.
+
+    Parameters
+    ----------
+    stages : list of HybridBlock
+        The stages of the model, applied in turn. See :py:func:`split_sequential`.
+    contexts : list of Context
+        The device of each stage. The parameters of each stage are moved to it.
+    num_micro_batches : int
+        Number of micro-batches each batch is split into.
+    batch_axis : int, default 0
+        The batch axis of the data and labels.
+    hybridize : bool, default True
+        Whether to hybridize the stages with static_alloc and static_shape.
+    """
+    def __init__(self, stages, contexts, num_micro_batches, batch_axis=0, hybridize=True):
+        if len(stages) != len(contexts):
+            raise ValueError('Got %d stages but %d contexts' % (len(stages), len(contexts)))
+        if num_micro_batches < 1:
+            raise ValueError('num_micro_batches must be positive, got %d' % num_micro_batches)
+        for ctx in contexts:
+            if not isinstance(ctx, Context):
+                raise TypeError('contexts must be a list of Context, got %s' % type(ctx))
+        self._stages = list(stages)
+        self._contexts = list(contexts)
+        self._num_micro_batches = num_micro_batches
+        self._batch_axis = batch_axis
+        for stage, ctx in zip(self._stages, self._contexts):
+            stage.reset_ctx(ctx)
+            for p in stage.collect_params().values():
+                if p.grad_req != 'null':
+                    p.grad_req = 'add'
+            if hybridize:
+                stage.hybridize(static_alloc=True, static_shape=True)
+
+    @property
+    def stages(self):
+        return self._stages
+
+    @property
+    def contexts(self):
+        return self._contexts
+
+    def collect_params(self):
+        """Returns the parameters of all the stages, with their names prefixed by the index
+        of their stage."""
+        params = {}
+        for i, stage in enumerate(self._stages):
+            params.update(stage._collect_params_with_prefix(str(i)))
+        return params
+
+    def _forward(self, data):
+        out = data
+        for stage, ctx in zip(self._stages, self._contexts):
+            if out.ctx != ctx:
+                out = out.copyto(ctx)
+            out = stage(out)
+        return out
+
+    def _split(self, data):
+        return split_data(data, self._num_micro_batches, self._batch_axis, even_split=False)
+
+    def forward(self, data):
+        """Runs the stages forward on the micro-batches of `data`, without recording.
+
+        Returns
+        -------
+        list of NDArray
+            The output of each micro-batch, on the device of the last stage.
+        """
+        return [self._forward(x) for x in self._split(data)]
+
+    def forward_backward(self, data, label, loss):
+        """Runs the forward and backward passes of a batch with the 1F1B schedule.
+
+        Parameters
+        ----------
+        data : NDArray
+            The input batch.
+        label : NDArray
+            The labels of the batch.
+        loss : callable
+            Called as `loss(output, label)` on the device of the last stage.
+
+        Returns
+        -------
+        list of NDArray
+            The losses of the micro-batches, on the device of the last stage.
+        """
+        data = self._split(data)
+        label = self._split(label)
+        last = self._contexts[-1]
+        for stage in self._stages:
+            stage.zero_grad()
+        losses = [None] * len(data)
+        schedule = one_f_one_b_schedule(len(self._stages), len(data))
+        for kind, i in schedule:
+            if kind == 'F':
+                with autograd.record():
+                    out = self._forward(data[i])
+                    y = label[i] if label[i].ctx == last else label[i].copyto(last)
+                    losses[i] = loss(out, y)
+            else:
+                losses[i].backward()
+        return losses
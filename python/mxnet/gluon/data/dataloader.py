@@ -53,19 +53,19 @@ if sys.platform == 'darwin' or sys.platform == 'win32':
         """Reduce ndarray to shared memory handle"""
         return rebuild_ndarray, data._to_shared_mem()
 else:
-    def rebuild_ndarray(pid, fd, shape, dtype):
+    def rebuild_ndarray(pid, fd, shape, dtype, offset):
         """Rebuild ndarray from pickled shared memory"""
         # pylint: disable=no-value-for-parameter
         fd = fd.detach()
-        return nd.NDArray(nd.ndarray._new_from_shared_mem(pid, fd, shape, dtype))
+        return nd.NDArray(nd.ndarray._new_from_shared_mem(pid, fd, shape, dtype, offset))
 
     def reduce_ndarray(data):
         """Reduce ndarray to shared memory handle"""
         # keep a local ref before duplicating fd
         data = data.as_in_context(context.Context('cpu_shared', 0))
-        pid, fd, shape, dtype = data._to_shared_mem()
+        pid, fd, shape, dtype, offset = data._to_shared_mem()
         fd = multiprocessing.reduction.DupFd(fd)
-        return rebuild_ndarray, (pid, fd, shape, dtype)
+        return rebuild_ndarray, (pid, fd, shape, dtype, offset)
 
 ForkingPickler.register(nd.NDArray, reduce_ndarray)
 
@@ -79,19 +79,19 @@ if sys.platform == 'darwin' or sys.platform == 'win32':
         """Reduce ndarray to shared memory handle"""
         return rebuild_np_ndarray, data._to_shared_mem()
 else:
-    def rebuild_np_ndarray(pid, fd, shape, dtype):
+    def rebuild_np_ndarray(pid, fd, shape, dtype, offset):
         """Rebuild ndarray from pickled shared memory"""
         # pylint: disable=no-value-for-parameter
         fd = fd.detach()
-        return _mx_np.ndarray(nd.ndarray._new_from_shared_mem(pid, fd, shape, dtype))
+        return _mx_np.ndarray(nd.ndarray._new_from_shared_mem(pid, fd, shape, dtype, offset))
 
     def reduce_np_ndarray(data):
         """Reduce ndarray to shared memory handle"""
         # keep a local ref before duplicating fd
         data = data.as_in_context(context.Context('cpu_shared', 0))
-        pid, fd, shape, dtype = data._to_shared_mem()
+        pid, fd, shape, dtype, offset = data._to_shared_mem()
         fd = multiprocessing.reduction.DupFd(fd)
-        return rebuild_np_ndarray, (pid, fd, shape, dtype)
+        return rebuild_np_ndarray, (pid, fd, shape, dtype, offset)
 
 ForkingPickler.register(_mx_np.ndarray, reduce_np_ndarray)
 
@@ -440,7 +440,7 @@ class _MultiWorkerIter(object):
     """Internal multi-worker iterator for DataLoader."""
     def __init__(self, worker_pool, batchify_fn, batch_sampler, pin_memory=False,
                  pin_device_id=0, worker_fn=_worker_fn, prefetch=0, dataset=None,
-                 data_loader=None, timeout=120):
+                 data_loader=None, timeout=120, copy_to_gpu=False):
         self._worker_pool = worker_pool
         self._batchify_fn = batchify_fn
         self._batch_sampler = batch_sampler
@@ -451,6 +451,7 @@ class _MultiWorkerIter(object):
         self._worker_fn = worker_fn
         self._pin_memory = pin_memory
         self._pin_device_id = pin_device_id
+        self._copy_to_gpu = copy_to_gpu
         self._dataset = dataset
         self._data_loader = data_loader
         self._timeout = timeout
@@ -487,6 +488,8 @@ class _MultiWorkerIter(object):
                 batch = ret.get(self._timeout)
             if self._pin_memory:
                 batch = _as_in_context(batch, context.cpu_pinned(self._pin_device_id))
+                if self._copy_to_gpu:
+                    batch = _as_in_context(batch, context.gpu(self._pin_device_id))
             self._rcvd_idx += 1
             return batch
         except multiprocessing.context.TimeoutError:
@@ -554,6 +557,11 @@ class DataLoader(object):
         but will consume more shared_memory. Using smaller number may forfeit the purpose of using
         multiple worker processes, try reduce `num_workers` in this case.
         By default it defaults to `num_workers * 2`.
+    copy_to_gpu : boolean, default False
+        If ``True`` together with `pin_memory`, the batches are returned on
+        `gpu(pin_device_id)`. The MXNet backend loader (see `try_nopython`) batchifies
+        directly into pinned memory and copies each batch to the gpu while the next one
+        is being assembled.
     thread_pool : bool, default False
         If ``True``, use threading pool instead of multiprocessing pool. Using threadpool
         can avoid shared memory usage. If `DataLoader` is more IO bounded or GIL is not a killing
@@ -576,10 +584,12 @@ class DataLoader(object):
     def __init__(self, dataset, batch_size=None, shuffle=False, sampler=None,
                  last_batch=None, batch_sampler=None, batchify_fn=None,
                  num_workers=0, pin_memory=False, pin_device_id=0,
-                 prefetch=None, thread_pool=False, timeout=120, try_nopython=None):
+                 prefetch=None, thread_pool=False, timeout=120, try_nopython=None,
+                 copy_to_gpu=False):
         self._dataset = dataset
         self._pin_memory = pin_memory
         self._pin_device_id = pin_device_id
+        self._copy_to_gpu = copy_to_gpu and pin_memory
         self._thread_pool = thread_pool
         self._timeout = timeout
         self._mx_iter = None
@@ -633,7 +643,8 @@ class DataLoader(object):
                 num_workers=self._num_workers,
                 pin_memory=self._pin_memory,
                 pin_device_id=self._pin_device_id,
-                prefetch=self._prefetch, **mx_iter_args)
+                prefetch=self._prefetch, copy_to_gpu=self._copy_to_gpu,
+                **mx_iter_args)
         else:
             if self._num_workers > 0:
                 if self._thread_pool:
@@ -659,6 +670,8 @@ class DataLoader(object):
                     ret = self._batchify_fn([self._dataset[idx] for idx in batch])
                     if self._pin_memory:
                         ret = _as_in_context(ret, context.cpu_pinned(self._pin_device_id))
+                        if self._copy_to_gpu:
+                            ret = _as_in_context(ret, context.gpu(self._pin_device_id))
                     yield ret
             return same_process_iter()
 
@@ -668,7 +681,8 @@ class DataLoader(object):
                                 worker_fn=_thread_worker_fn if self._thread_pool else _worker_fn,
                                 prefetch=self._prefetch,
                                 dataset=self._dataset if self._thread_pool else None,
-                                data_loader=self, timeout=self._timeout)
+                                data_loader=self, timeout=self._timeout,
+                                copy_to_gpu=self._copy_to_gpu)
 
     def __len__(self):
         return len(self._batch_sampler)
@@ -723,6 +737,8 @@ def _check_mx_loader_capability(dataset, batch_sampler, batchify_fn):
             return False, error_template.format('pass', 'pass', 'fail')
     elif isinstance(batch_sampler, MXSampler):
         mx_loader_args['batch_sampler'] = batch_sampler
+    elif isinstance(batch_sampler, _sampler.BucketSampler):
+        mx_loader_args['batch_sampler'] = batch_sampler._sampler
     else:
         return False, error_template.format('pass', 'pass', 'fail')
     # all good
@@ -757,11 +773,15 @@ class _MXThreadedDataLoader(object):
         Note that using large prefetching batch will provide smoother bootstrapping performance,
         but will consume more shared_memory. Using smaller number may forfeit the purpose of using
         multiple worker processes, try reduce `num_workers` in this case.
-        By default it defaults to `num_workers * 2`, maximum prefetch size is `16`.
+        By default it defaults to `num_workers * 2`. It also bounds the number of batches
+        loaded by the background thread ahead of the one being consumed.
+    copy_to_gpu : boolean, default False
+        If ``True`` together with `pin_memory`, each batch is copied asynchronously
+        to `gpu(pin_device_id)` while the next batch is being assembled.
     """
     def __init__(self, dataset, batch_sampler, batchify_fn,
                  num_workers=0, pin_memory=False, pin_device_id=0,
-                 prefetch=4):
+                 prefetch=4, copy_to_gpu=False):
         from ._internal import MXDataset, MXSampler, MXBatchifyFunction
         from ...io.io import ThreadedDataLoader
         assert isinstance(dataset, MXDataset)
@@ -778,8 +798,10 @@ class _MXThreadedDataLoader(object):
         ctx = 'cpu_pinned' if pin_memory else 'cpu'
         self._iter = ThreadedDataLoader(num_workers=num_workers, dataset=dataset,
                                         sampler=batch_sampler, batchify_fn=batchify_fn,
-                                        prefetch_buffer=prefetch, ctx=ctx,
-                                        device_id=pin_device_id)
+                                        prefetch_buffer=prefetch, inflight_batches=prefetch,
+                                        ctx=ctx, device_id=pin_device_id,
+                                        pin_device_id=pin_device_id,
+                                        copy_to_gpu=copy_to_gpu and pin_memory)
 
     def __iter__(self):
         while self._iter.iter_next():
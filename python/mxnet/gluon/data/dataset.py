@@ -19,9 +19,12 @@
 # pylint: disable=
 """Dataset container."""
 __all__ = ['Dataset', 'SimpleDataset', 'ArrayDataset',
-           'RecordFileDataset']
+           'RecordFileDataset', 'ColumnarDataset']
 
 import os
+import struct
+
+import numpy as np
 
 from ... import recordio, ndarray
 from ...util import default_array
@@ -396,10 +399,15 @@ class RecordFileDataset(Dataset):
     ----------
     filename : str
         Path to rec file.
+    use_mmap : bool, default False
+        Whether the backend of the ThreadedDataLoader maps the local rec file in memory
+        and returns records pointing into the mapping, instead of reading and copying
+        each of them.
     """
-    def __init__(self, filename):
+    def __init__(self, filename, use_mmap=False):
         self.idx_file = os.path.splitext(filename)[0] + '.idx'
         self.filename = filename
+        self._use_mmap = use_mmap
         self._record = recordio.MXIndexedRecordIO(self.idx_file, self.filename, 'r')
 
     def __getitem__(self, idx):
@@ -410,7 +418,216 @@ class RecordFileDataset(Dataset):
 
     def __mx_handle__(self):
         from ._internal import RecordFileDataset as _RecordFileDataset
-        return _RecordFileDataset(rec_file=self.filename, idx_file=self.idx_file)
+        return _RecordFileDataset(rec_file=self.filename, idx_file=self.idx_file,
+                                  use_mmap=self._use_mmap)
+
+
+class _ColumnarWriter(object):
+    """Writes the row groups of a columnar file, see src/io/columnar_file.h for the layout."""
+    _MAGIC = b'MXCOLUMN'
+    _VERSION = 1
+    _ALIGN = 64
+
+    def __init__(self, filename):
+        self._file = open(filename, 'wb')
+        self._file.write(self._MAGIC)
+        self._columns = None
+        self._groups = []
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()
+
+    def _write(self, arr):
+        """Writes an array at the next aligned offset and returns the offset."""
+        pos = self._file.tell()
+        self._file.write(b'\0' * (-pos % self._ALIGN))
+        offset = self._file.tell()
+        self._file.write(np.ascontiguousarray(arr).tobytes())
+        return offset
+
+    @staticmethod
+    def _as_column(arr):
+        """Returns the numpy values of a dense array, or the values, indices, indptr and
+        number of columns of a sparse array."""
+        from ...ndarray import sparse
+        if isinstance(arr, tuple):
+            return arr
+        if isinstance(arr, sparse.CSRNDArray):
+            return (arr.data.asnumpy(), arr.indices.asnumpy(), arr.indptr.asnumpy(),
+                    arr.shape[1])
+        if hasattr(arr, 'tocsr'):
+            arr = arr.tocsr()
+            return arr.data, arr.indices, arr.indptr, arr.shape[1]
+        return arr.asnumpy() if hasattr(arr, 'asnumpy') else np.asarray(arr)
+
+    def write_row_group(self, columns):
+        """Writes a row group given a list of (name, array) with the same number of rows."""
+        from ...ndarray.ndarray import _DTYPE_NP_TO_MX
+        infos, chunks, num_rows = [], [], None
+        for name, arr in columns:
+            arr = self._as_column(arr)
+            dtype = (arr[0] if isinstance(arr, tuple) else arr).dtype
+            if dtype.type not in _DTYPE_NP_TO_MX:
+                raise TypeError('Column {} has the unsupported dtype {}'.format(name, dtype))
+            if isinstance(arr, tuple):
+                data, indices, indptr, num_col = arr
+                rows = len(indptr) - 1
+                begin, end = indptr[0], indptr[-1]
+                infos.append((name, _DTYPE_NP_TO_MX[data.dtype.type], 1, (num_col,)))
+                chunks.append((self._write(data[begin:end]),
+                               self._write(indices[begin:end].astype(np.int64)),
+                               self._write((indptr - begin).astype(np.int64)), end - begin))
+            else:
+                rows = arr.shape[0]
+                infos.append((name, _DTYPE_NP_TO_MX[arr.dtype.type], 0, arr.shape[1:]))
+                chunks.append((self._write(arr), 0, 0, 0))
+            if num_rows is not None and rows != num_rows:
+                raise ValueError('Column {} has {} rows instead of {}'.format(name, rows, num_rows))
+            num_rows = rows
+        if self._columns is None:
+            self._columns = infos
+        elif infos != self._columns:
+            raise ValueError('The columns of all the row groups must have the same names, '
+                             'dtypes, storage and row shapes')
+        self._groups.append((num_rows, chunks))
+
+    def close(self):
+        """Writes the footer and closes the file."""
+        if self._file is None:
+            return
+        columns = self._columns or []
+        footer = [struct.pack('<IIQQ', self._VERSION, len(columns),
+                              sum(g[0] for g in self._groups), len(self._groups))]
+        for name, dtype, storage, shape in columns:
+            name = name.encode('utf-8')
+            footer.append(struct.pack('<I', len(name)) + name)
+            footer.append(struct.pack('<iii', dtype, storage, len(shape)))
+            footer.append(struct.pack('<%dq' % len(shape), *shape))
+        for num_rows, chunks in self._groups:
+            footer.append(struct.pack('<Q', num_rows))
+            for chunk in chunks:
+                footer.append(struct.pack('<QQQQ', *chunk))
+        offset = self._file.tell()
+        self._file.write(b''.join(footer))
+        self._file.write(struct.pack('<Q', offset) + self._MAGIC)
+        self._file.close()
+        self._file = None
+
+
+class ColumnarDataset(Dataset):
+    """A dataset over the rows of a columnar file.
+
+    A columnar file stores the rows in row groups, with a chunk per column in each row group,
+    so that the backend memory maps the file and reads the selected columns without a parse.
+    Each sample is a tuple with one array per column, or the array of a single column.
+    The arrays of dense columns view the mapping, the arrays of sparse columns are 1 x N
+    CSRNDArrays. The same file is read in batches by :py:class:`mxnet.io.ColumnarIter`.
+
+    Create the file with :py:meth:`write` from arrays, or with :py:meth:`from_parquet`
+    from a Parquet file.
+
+    Parameters
+    ----------
+    filename : str
+        Path to the local columnar file.
+    columns : list of str, default None
+        Names of the columns of each sample. If None, all the columns.
+    """
+    def __init__(self, filename, columns=None):
+        self.filename = filename
+        self._columns = ','.join(columns) if columns else ''
+        self._dataset = None
+
+    def _get_dataset(self):
+        if self._dataset is None:
+            from ._internal import ColumnarDataset as _ColumnarDataset
+            self._dataset = _ColumnarDataset(file=self.filename, columns=self._columns)
+        return self._dataset
+
+    def __getitem__(self, idx):
+        return self._get_dataset()[idx]
+
+    def __len__(self):
+        return len(self._get_dataset())
+
+    def __getstate__(self):
+        # the backend dataset is created again by the worker processes
+        state = self.__dict__.copy()
+        state['_dataset'] = None
+        return state
+
+    def __mx_handle__(self):
+        return self._get_dataset()
+
+    @staticmethod
+    def write(filename, columns, row_group_size=65536):
+        """Writes arrays to a columnar file.
+
+        Parameters
+        ----------
+        filename : str
+            Path of the columnar file.
+        columns : dict or list of (str, array)
+            Name and values of each column: a numpy array or NDArray whose first axis are the
+            rows, or a CSRNDArray or scipy sparse matrix.
+        row_group_size : int, default 65536
+            Number of rows of each row group.
+        """
+        columns = list(columns.items()) if isinstance(columns, dict) else list(columns)
+        columns = [(name, _ColumnarWriter._as_column(arr)) for name, arr in columns]
+        num_rows = [len(arr[2]) - 1 if isinstance(arr, tuple) else arr.shape[0]
+                    for _, arr in columns]
+        if len(set(num_rows)) > 1:
+            raise ValueError('All the columns must have the same number of rows')
+        num_rows = num_rows[0] if num_rows else 0
+
+        def rows(arr, begin, end):
+            if not isinstance(arr, tuple):
+                return arr[begin:end]
+            data, indices, indptr, num_col = arr
+            return data, indices, indptr[begin:end + 1], num_col
+
+        with _ColumnarWriter(filename) as writer:
+            for begin in range(0, max(num_rows, 1), row_group_size):
+                end = min(begin + row_group_size, num_rows)
+                writer.write_row_group([(name, rows(arr, begin, end)) for name, arr in columns])
+
+    @classmethod
+    def from_parquet(cls, parquet_file, filename, columns=None):
+        """Converts a Parquet file to a columnar file, keeping its row groups, and returns
+        the dataset over it. Requires pyarrow.
+
+        Numeric columns are stored as dense columns, and columns of fixed size lists of
+        numbers as dense columns of vectors. Null values are not supported.
+
+        Parameters
+        ----------
+        parquet_file : str
+            Path of the Parquet file.
+        filename : str
+            Path of the columnar file.
+        columns : list of str, default None
+            Names of the columns to convert. If None, all the columns.
+        """
+        try:
+            import pyarrow.parquet as pq
+        except ImportError:
+            raise ImportError('ColumnarDataset.from_parquet requires pyarrow')
+        parquet = pq.ParquetFile(parquet_file)
+        with _ColumnarWriter(filename) as writer:
+            for i in range(parquet.num_row_groups):
+                table = parquet.read_row_group(i, columns=columns)
+                arrays = []
+                for name in table.column_names:
+                    values = table.column(name).to_numpy()
+                    if values.dtype == object:
+                        values = np.stack(values)
+                    arrays.append((name, values))
+                writer.write_row_group(arrays)
+        return cls(filename, columns)
 
 
 class _DownloadedDataset(Dataset):
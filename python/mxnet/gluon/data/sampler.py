@@ -18,7 +18,8 @@
 # coding: utf-8
 # pylint: disable=
 """Dataset sampler."""
-__all__ = ['Sampler', 'SequentialSampler', 'RandomSampler', 'FilterSampler', 'BatchSampler']
+__all__ = ['Sampler', 'SequentialSampler', 'RandomSampler', 'FilterSampler', 'BatchSampler',
+           'BucketSampler']
 
 import numpy as np
 
@@ -159,3 +160,49 @@ class BatchSampler(Sampler):
         raise ValueError(
             "last_batch must be one of 'keep', 'discard', or 'rollover', " \
             "but got %s"%self._last_batch)
+
+
+class BucketSampler(Sampler):
+    """Returns mini-batches of samples of similar lengths, capped by their number of tokens.
+
+    The samples are sorted by length and split into `num_buckets` buckets of equal sizes.
+    Each batch holds samples of a single bucket, as many as fit in `max_tokens` once
+    padded to the longest of them, so the batches have varying sizes and little padding.
+    The batching runs in C++, which the C++ data loader uses without Python.
+
+    Parameters
+    ----------
+    lengths : list of int or array
+        Length of each sample of the dataset.
+    max_tokens : int
+        Maximum number of samples of a batch times the length of its longest sample.
+        A sample longer than it forms a batch on its own.
+    batch_size : int, default 0
+        Maximum number of samples of a batch, 0 for no limit.
+    num_buckets : int, default 10
+        Number of buckets of samples of similar lengths.
+    shuffle : bool, default True
+        Whether to shuffle the samples within the buckets and the batches across the
+        buckets at each epoch.
+
+    Examples
+    --------
+    >>> batch_sampler = gluon.data.BucketSampler([1, 5, 2, 6, 1], max_tokens=6,
+    ...                                          num_buckets=2, shuffle=False)
+    >>> list(batch_sampler)
+    [[0, 4], [2], [1], [3]]
+    """
+    def __init__(self, lengths, max_tokens, batch_size=0, num_buckets=10, shuffle=True):
+        from ._internal import MXSampler
+        from ...ndarray import array
+        self._sampler = MXSampler('BucketSampler',
+                                  lengths=array(np.asarray(lengths), dtype='int64'),
+                                  max_tokens=max_tokens, batch_size=batch_size,
+                                  num_buckets=num_buckets, shuffle=shuffle)
+
+    def __iter__(self):
+        for batch in self._sampler:
+            yield batch if isinstance(batch, list) else [batch]
+
+    def __len__(self):
+        return len(self._sampler)
@@ -253,15 +253,29 @@ class ImageRecordDataset(dataset.RecordFileDataset):
 
             transform=lambda data, label: (data.astype(np.float32)/255, label)
 
+    use_mmap : bool, default False
+        Whether the backend of the ThreadedDataLoader maps the local rec file in memory
+        and decodes the images from the mapping.
+    decoded_cache_size : int, default 0
+        Size in MB of the decoded images the backend of the ThreadedDataLoader keeps in
+        memory, so that the epochs after the first skip decoding them.
+    decoded_cache_file : str, default ''
+        Local file the decoded images spill to once decoded_cache_size is used.
+    decoded_cache_file_size : int, default 0
+        Size in MB of the decoded images kept in decoded_cache_file.
     """
-    def __init__(self, filename, flag=1, transform=None):
-        super(ImageRecordDataset, self).__init__(filename)
+    def __init__(self, filename, flag=1, transform=None, use_mmap=False,
+                 decoded_cache_size=0, decoded_cache_file='', decoded_cache_file_size=0):
+        super(ImageRecordDataset, self).__init__(filename, use_mmap=use_mmap)
         if transform is not None:
             raise DeprecationWarning(
                 'Directly apply transform to dataset is deprecated. '
                 'Please use dataset.transform() or dataset.transform_first() instead...')
         self._flag = flag
         self._transform = transform
+        self._decoded_cache = dict(decoded_cache_size=decoded_cache_size,
+                                   decoded_cache_file=decoded_cache_file,
+                                   decoded_cache_file_size=decoded_cache_file_size)
 
     def __getitem__(self, idx):
         record = super(ImageRecordDataset, self).__getitem__(idx)
@@ -273,7 +287,8 @@ class ImageRecordDataset(dataset.RecordFileDataset):
     def __mx_handle__(self):
         from .._internal import ImageRecordFileDataset as _ImageRecordFileDataset
         return _ImageRecordFileDataset(rec_file=self.filename, idx_file=self.idx_file,
-                                       flag=self._flag)
+                                       flag=self._flag, use_mmap=self._use_mmap,
+                                       **self._decoded_cache)
 
 
 class ImageFolderDataset(dataset.Dataset):
@@ -20,8 +20,12 @@
 """Parameter optimizer."""
 __all__ = ['Trainer']
 
+import pickle
+import weakref
 from collections import OrderedDict
 
+from .. import autograd
+from .. import kvstore as kvs
 from .. import optimizer as opt
 from ..model import _create_kvstore, _create_sparse_kvstore
 from .parameter import Parameter
@@ -68,6 +72,31 @@ class Trainer(object):
         If None and optimizer.aggregate_num > 1, `update_on_kvstore` is set to False.
         If the `update_on_kvstore` argument is provided,
         environment variable `MXNET_UPDATE_ON_KVSTORE` will be ignored.
+    overlap_backward : bool, default False
+        Whether to reduce the gradients as soon as each backward pass is issued instead of
+        in `step` or `allreduce_grads`. The reduction of each gradient then starts once the
+        backward pass writes it, so the communication of the last layers overlaps with the
+        backward pass of the first layers. Only the fresh gradients of the Parameters with
+        ``grad_req='write'`` are reduced early, the others are reduced in `step`. Reduced
+        gradients should not be modified before `step`. Ignored when the parameters
+        are updated on kvstore.
+    local_sgd_period : int, default 1
+        With a distributed kvstore, the number of steps between two averages of the
+        parameters over the workers, as in local SGD. In the steps between, each worker
+        updates its parameters with its gradients summed over its devices only, so the
+        network traffic is divided by `local_sgd_period`, at the cost of the workers
+        diverging for a few steps. 1 reduces the gradients of all the workers every step.
+        The parameters and gradients have to be dense, the kvstore synchronous, and the
+        updates happen on the workers. Ignored without a distributed kvstore.
+    shard_optimizer_states : bool, default False
+        Whether to shard the optimizer states over the devices. Each Parameter is owned by
+        one device, chosen so that the devices own Parameters of similar total sizes. The
+        gradients of a Parameter are only reduced to its owner, only the owner updates it
+        and keeps its optimizer states, and the updated value is then copied to the other
+        devices. This divides the memory of the optimizer states by the number of devices.
+        The parameters and gradients have to be dense, and the updates happen on the
+        workers. After `allreduce_grads`, only the gradients of the owners are reduced.
+        Ignored with a single device.
 
     Properties
     ----------
@@ -76,7 +105,8 @@ class Trainer(object):
         optimizer, its learning rate can be accessed as optimizer.learning_rate.
     """
     def __init__(self, params, optimizer, optimizer_params=None, kvstore='device',
-                 compression_params=None, update_on_kvstore=None):
+                 compression_params=None, update_on_kvstore=None, overlap_backward=False,
+                 local_sgd_period=1, shard_optimizer_states=False):
         param_list = []
         if isinstance(params, (dict, OrderedDict)):
             for key in sorted(list(params.keys())):
@@ -118,12 +148,25 @@ class Trainer(object):
         if update_on_kvstore is None and self._optimizer.aggregate_num > 1:
             update_on_kvstore = False
         self._kvstore_params = {'kvstore': kvstore, 'update_on_kvstore': update_on_kvstore}
+        if not isinstance(local_sgd_period, int) or local_sgd_period < 1:
+            raise ValueError("local_sgd_period must be a positive integer, got %s."
+                             % str(local_sgd_period))
+        self._local_sgd_period = local_sgd_period
+        # kvstore reducing the gradients over the devices of the worker with local SGD
+        self._local_kvstore = None
+        self._local_steps = 0
+        self._shard_optimizer_states = shard_optimizer_states
+        # index of the device owning each Parameter when the optimizer states are sharded
+        self._owners = None
         self._kv_initialized = False
         self._kvstore = None
         self._update_on_kvstore = None
         self._distributed = None
         self._params_to_init = []
         self._reset_kvstore()
+        # uuids of the Parameters whose gradients the backward hook reduced since the last step
+        self._overlapped = set()
+        self._backward_hook = _register_overlap_hook(self) if overlap_backward else None
 
     def _check_contexts(self):
         contexts = None
@@ -172,6 +215,8 @@ class Trainer(object):
                         self._kvstore.init(idx, param_arrays[0])
                     else:
                         self._kvstore.broadcast(idx, param_arrays[0], param_arrays)
+                    if self._local_kvstore:
+                        self._local_kvstore.init(idx, param_arrays[0])
 
         self._params_to_init = params_to_init
 
@@ -261,6 +306,34 @@ class Trainer(object):
                                      "when training with {}".format(type(kvstore)))
                 update_on_kvstore = False
 
+        if self._local_sgd_period > 1 and self._distributed:
+            if self._contains_sparse_weight or self._contains_sparse_grad:
+                raise ValueError("local_sgd_period > 1 is not supported with sparse weights "
+                                 "or sparse gradients.")
+            if 'async' in kvstore.type:
+                raise ValueError("local_sgd_period > 1 is not supported in async mode.")
+            if config['update_on_kvstore']:
+                raise ValueError("Cannot set update_on_kvstore=True when local_sgd_period > 1.")
+            if self._compression_params:
+                raise ValueError("Gradient compression is not supported when "
+                                 "local_sgd_period > 1.")
+            update_on_kvstore = False
+            if len(self._contexts) > 1:
+                # the same reduction over the devices as the distributed kvstore
+                self._local_kvstore = kvs.create('device' if 'device' in kvstore.type
+                                                 else 'local')
+
+        if self._shard_optimizer_states and kvstore:
+            if self._contains_sparse_weight or self._contains_sparse_grad:
+                raise ValueError("shard_optimizer_states is not supported with sparse weights "
+                                 "or sparse gradients.")
+            if self._distributed and 'async' in kvstore.type:
+                raise ValueError("shard_optimizer_states is not supported in async mode.")
+            if config['update_on_kvstore']:
+                raise ValueError("Cannot set update_on_kvstore=True when "
+                                 "shard_optimizer_states is set.")
+            update_on_kvstore = False
+
         # set grad compression and optimizers
         if kvstore:
             if self._compression_params:
@@ -382,31 +455,103 @@ class Trainer(object):
 
         self._allreduce_grads()
 
-    def _allreduce_grads(self):
-        # nothing to reduce
-        if not self._kvstore:
+    def _allreduce_overlapped_grads(self):
+        """Reduces the fresh gradients of a backward pass being issued."""
+        if not self._kv_initialized:
+            self._init_kvstore()
+        if self._params_to_init:
+            self._init_params()
+        if not self._kvstore or self._update_on_kvstore:
             return
+        indices = []
         for i, param in enumerate(self._params):
+            if param.grad_req != 'write' or param._data is None:
+                continue
+            data = param.list_data()
+            if all(arr._fresh_grad for arr in data):
+                # a later backward that does not write the gradient must not reduce it again,
+                # the gradient is fresh again in step
+                for arr in data:
+                    arr._fresh_grad = False
+                indices.append(i)
+                self._overlapped.add(param._uuid)
+        # the ops of the last layers are issued first, as their gradients are written first
+        self._allreduce_grads(indices[::-1])
+
+    def _restore_overlapped(self):
+        """Marks the gradients reduced by the backward hook fresh for the update."""
+        for param in self._params:
+            if param._uuid in self._overlapped:
+                for arr in param.list_data():
+                    arr._fresh_grad = True
+        self._overlapped.clear()
+
+    def _is_local_sgd(self):
+        return self._local_sgd_period > 1 and self._distributed
+
+    def _is_sharded(self):
+        return self._shard_optimizer_states and self._kvstore is not None \
+            and len(self._contexts) > 1
+
+    def _shard_owners(self):
+        """The index of the device owning each Parameter, largest Parameters first to the
+        device owning the least elements, as the device kvstore places its merge buffers."""
+        if self._owners is None:
+            loads = [0] * len(self._contexts)
+            owners = [0] * len(self._params)
+            order = sorted(range(len(self._params)),
+                           key=lambda i: -self._params[i].list_data()[0].size)
+            for i in order:
+                dev = loads.index(min(loads))
+                owners[i] = dev
+                loads[dev] += self._params[i].list_data()[0].size
+            self._owners = owners
+        return self._owners
+
+    def _allreduce_grads(self, indices=None):
+        # with local SGD the gradients are only reduced over the devices of the worker
+        kvstore = self._local_kvstore if self._is_local_sgd() else self._kvstore
+        # nothing to reduce
+        if not kvstore:
+            return
+        if indices is None:
+            indices = [i for i, p in enumerate(self._params) if p._uuid not in self._overlapped]
+            self._restore_overlapped()
+        # the dist kvstores pack the small dense gradients of one pushpull into fused
+        # buckets, see MXNET_KVSTORE_FUSION_BUCKET_SIZE
+        fuse = 'dist' in kvstore.type and not self._update_on_kvstore
+        # with sharded optimizer states the gradients are only reduced to their owner
+        owners = self._shard_owners() if self._is_sharded() else None
+        fused_keys, fused_grads, fused_outs = [], [], []
+        for i in indices:
+            param = self._params[i]
             if param.grad_req != 'null':
                 idx = self._param2idx[param._uuid]
                 grad_list = param.list_grad()
                 # sparse gradients, call push and pull separately
                 if grad_list[0].stype != 'default':
-                    self._kvstore.push(idx, grad_list, priority=-i)
+                    kvstore.push(idx, grad_list, priority=-i)
                     if param._stype == 'default':
                         if self._update_on_kvstore:
                             pull_list = param.list_data()
                         else:
                             pull_list = param.list_grad()
-                        self._kvstore.pull(idx, pull_list, priority=-i,
-                                           ignore_sparse=self._distributed)
+                        kvstore.pull(idx, pull_list, priority=-i,
+                                     ignore_sparse=self._distributed)
                 else:
                     # allreduce dense gradients if not update_on_kvstore,
                     # otherwise push dense gradients, pull dense weights
+                    out_list = grad_list if owners is None else grad_list[owners[i]]
                     if self._update_on_kvstore:
-                        self._kvstore.pushpull(idx, grad_list, out=param.list_data(), priority=-i)
+                        kvstore.pushpull(idx, grad_list, out=param.list_data(), priority=-i)
+                    elif fuse:
+                        fused_keys.append(idx)
+                        fused_grads.append(grad_list)
+                        fused_outs.append(out_list)
                     else:
-                        self._kvstore.pushpull(idx, grad_list, priority=-i)
+                        kvstore.pushpull(idx, grad_list, out=out_list, priority=-i)
+        if fused_keys:
+            kvstore.pushpull(fused_keys, fused_grads, out=fused_outs)
 
     def update(self, batch_size, ignore_stale_grad=False):
         """Makes one step of parameter update.
@@ -442,12 +587,37 @@ class Trainer(object):
         self._update(ignore_stale_grad)
 
     def _update(self, ignore_stale_grad=False):
+        self._restore_overlapped()
+        self._update_params(ignore_stale_grad)
+        if self._is_local_sgd():
+            # counted even when the update is skipped, all the workers average together
+            self._local_steps += 1
+            if self._local_steps % self._local_sgd_period == 0:
+                self._average_params()
+
+    def _average_params(self):
+        """Averages the parameters over the workers, for local SGD."""
+        keys, values, outs = [], [], []
+        for param in self._params:
+            if param.grad_req == 'null':
+                continue
+            data = param.list_data()
+            keys.append(self._param2idx[param._uuid])
+            values.append(data[0] / self._kvstore.num_workers)
+            outs.append(data)
+        if keys:
+            self._kvstore.pushpull(keys, values, out=outs)
+
+    def _update_params(self, ignore_stale_grad=False):
         loss_scaler = getattr(self, '_amp_loss_scaler', None)
         if loss_scaler is not None:
             if loss_scaler.has_overflow(self._params):
                 return  # skip on overflow
 
         updates = [[] for _ in self._updaters]
+        owners = self._shard_owners() if self._is_sharded() else None
+        # the Parameters updated by their owner, copied to the other devices afterwards
+        sharded = []
 
         for i, param in enumerate(self._params):
             if param.grad_req == 'null':
@@ -468,6 +638,15 @@ class Trainer(object):
             if self._kvstore and self._update_on_kvstore:
                 continue
 
+            if owners is not None:
+                data = param.list_data()
+                if not ignore_stale_grad or all(arr._fresh_grad for arr in data):
+                    updates[owners[i]].append((i, param.list_grad()[owners[i]], data[owners[i]]))
+                    sharded.append((data[owners[i]], data))
+                for arr in data:
+                    arr._fresh_grad = False
+                continue
+
             for upd, arr, grad in zip(updates, param.list_data(), param.list_grad()):
                 if not ignore_stale_grad or arr._fresh_grad:
                     upd.append((i, grad, arr))
@@ -478,6 +657,10 @@ class Trainer(object):
                 if upd:
                     i, g, w = zip(*upd)
                     updater(i, g, w)
+            for src, data in sharded:
+                for arr in data:
+                    if arr is not src:
+                        src.copyto(arr)
 
     def save_states(self, fname):
         """Saves trainer states (e.g. optimizer, momentum) to a file.
@@ -504,6 +687,13 @@ class Trainer(object):
             assert not self._params_to_init, "Cannot save trainer states when some " \
                                              "parameters are not yet initialized in kvstore."
             self._kvstore.save_optimizer_states(fname, dump_optimizer=True)
+        elif self._is_sharded():
+            # each updater only holds the states of the Parameters its device owns
+            states = {}
+            for updater in self._updaters:
+                states.update(updater.states)
+            with open(fname, 'wb') as fout:
+                fout.write(pickle.dumps((states, self._updaters[0].optimizer)))
         else:
             with open(fname, 'wb') as fout:
                 fout.write(self._updaters[0].get_states(dump_optimizer=True))
@@ -536,6 +726,27 @@ class Trainer(object):
             for updater in self._updaters:
                 updater.set_states(states)
                 updater.optimizer = self._updaters[0].optimizer
+            if self._is_sharded():
+                owners = self._shard_owners()
+                for dev, updater in enumerate(self._updaters):
+                    updater.states = {i: s for i, s in updater.states.items()
+                                      if owners[i] == dev}
+                    updater.states_synced = dict.fromkeys(updater.states.keys(), False)
             self._optimizer = self._updaters[0].optimizer
         param_dict = {i: param for i, param in enumerate(self._params)}
         self._optimizer.param_dict = param_dict
+
+
+def _register_overlap_hook(trainer):
+    """Reduces the gradients of a trainer after each backward pass, without keeping the
+    trainer alive."""
+    trainer_ref = weakref.ref(trainer)
+    handle = None
+    def hook():
+        target = trainer_ref()
+        if target is None:
+            handle.detach()
+        else:
+            target._allreduce_overlapped_grads()  # pylint: disable=protected-access
+    handle = autograd.register_backward_hook(hook)
+    return handle
@@ -132,6 +132,22 @@ def clip_global_norm(arrays, max_norm, check_isfinite=True):
       False. Otherwise a float is returned.
 
     """
+    ctx = arrays[0].context
+    if all(arr.context == ctx and arr.stype == 'default' for arr in arrays):
+        # one fused pass computes the norm, clips the arrays in place and checks
+        # the norm is finite, without synchronizing with the device
+        total_norm = ndarray.empty((1,), ctx=ctx)
+        finite = ndarray.empty((1,), ctx=ctx)
+        ndarray.multi_clip_global_norm(*arrays, num_arrays=len(arrays), max_norm=max_norm,
+                                       out=list(arrays) + [total_norm, finite])
+        if check_isfinite:
+            if not finite.asscalar():
+                warnings.warn(
+                    UserWarning('nan or inf is detected. '
+                                'Clipping results will be undefined.'), stacklevel=2)
+            return total_norm.asscalar()
+        return total_norm
+
     # group arrays by ctx
     def group_by_ctx(arr_list):
         groups = collections.defaultdict(list)
@@ -141,7 +157,6 @@ def clip_global_norm(arrays, max_norm, check_isfinite=True):
         return groups
     arrays_groups = group_by_ctx(arrays)
     all_ctx_sum = []
-    ctx = arrays[0].context
     for group in arrays_groups:
         sum_sq = ndarray.multi_sum_sq(*arrays_groups[group],
                                       num_arrays=len(arrays_groups[group]))
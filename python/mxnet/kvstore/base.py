@@ -424,6 +424,12 @@ def create(name='local'):
     ``dist_device_sync``: Identical to ``dist_sync`` with the difference similar
     to ``device`` vs ``local``.
 
+    ``dist_allreduce``: Synchronous like ``dist_device_sync``, but sums the dense gradients
+    reduced on the GPUs of each machine with an NCCL allreduce between the machines instead
+    of sending them to the servers, and updates the weights on every worker. The servers
+    are only used to share the initial weights of rank 0 and to reduce the values on CPU.
+    Requires the same number of GPUs on every machine.
+
     ``dist_async``: Performs asynchronous updates.
     The weights are updated whenever gradients are received from any machine.
     No two updates happen on the same weight at the same time. However, the order is not
@@ -435,7 +441,7 @@ def create(name='local'):
 
     Parameters
     ----------
-    name : {'local', 'device', 'nccl', 'dist_sync', 'dist_device_sync', 'dist_async', 'horovod', 'byteps'}
+    name : {'local', 'device', 'nccl', 'dist_sync', 'dist_device_sync', 'dist_allreduce', 'dist_async', 'horovod', 'byteps'}
         The type of KVStore.
 
     Returns
@@ -46,10 +46,39 @@ def _get_kvstore_server_command_type(command):
                      'kStopServer': 2,
                      'kSyncMode': 3,
                      'kSetGradientCompression': 4,
-                     'kSetProfilerParams': 5}
+                     'kSetProfilerParams': 5,
+                     'kSetLazyOptimizer': 6}
     assert (command in command_types), "Unknown command type to send to server"
     return command_types[command]
 
+def _lazy_optimizer_config(optimizer):
+    """The config of the native updates of the row_sparse values on the servers, which apply
+    the same operators as the optimizer. Empty if the optimizer has to update these values."""
+    if optimizer.lr_scheduler is not None or not optimizer.use_fused_step:
+        return ''
+    lr_mults = list(optimizer.lr_mult.values())
+    wd_mults = list(optimizer.wd_mult.values())
+    for param in optimizer.param_dict.values():
+        lr_mults.append(param.lr_mult)
+        wd_mults.append(param.wd_mult)
+    if any(m != 1 for m in lr_mults) or (optimizer.wd and any(m != 1 for m in wd_mults)):
+        return ''
+    kwargs = {'lr': optimizer.lr, 'wd': optimizer.wd, 'rescale_grad': optimizer.rescale_grad,
+              'clip_gradient': optimizer.clip_gradient if optimizer.clip_gradient else -1}
+    if type(optimizer) is opt.Adam and optimizer.lazy_update and \
+            optimizer.state_dtype is None: # pylint: disable=unidiomatic-typecheck
+        name = 'adam'
+        kwargs.update(beta1=optimizer.beta1, beta2=optimizer.beta2, epsilon=optimizer.epsilon)
+    elif type(optimizer) is opt.AdaGrad: # pylint: disable=unidiomatic-typecheck
+        name = 'adagrad'
+        kwargs.update(epsilon=optimizer.epsilon)
+    elif type(optimizer) is opt.Ftrl: # pylint: disable=unidiomatic-typecheck
+        name = 'ftrl'
+        kwargs.update(lamda1=optimizer.lamda1, beta=optimizer.beta)
+    else:
+        return ''
+    return ' '.join([name] + ['%s=%r' % (k, float(v)) for k, v in sorted(kwargs.items())])
+
 
 class KVStore(KVStoreBase):
     """A key-value store for synchronization of values, over multiple devices."""
@@ -513,6 +542,25 @@ class KVStore(KVStoreBase):
         original values is stored at the sender's end as residual and added to the
         gradient in the next iteration.
 
+        1bit Gradient Compression sends the sign of each value: values whose sum
+        with the residual is positive or zero are sent as `threshold`, the others as
+        the negative of `threshold`, and every 32 float values are represented using
+        one float. The difference is kept as residual like for 2bit compression, so this
+        is signSGD with error feedback.
+
+        topk and randk Gradient Compression take an int `block_size`, and send one value
+        out of each block of `block_size` consecutive values: the value of the largest
+        magnitude for topk, a random value for randk. The value and its offset in the block
+        are packed in one float, with the value as float16, so every `block_size` float
+        values are represented using one float. The values not sent accumulate
+        in the residual.
+
+        fp16 and bf16 Gradient Compression send each value as float16 or bfloat16,
+        which halves the communication without a threshold. The rounding error is kept
+        as residual, so no update is lost. bf16 keeps the range of float32, fp16 has more
+        precision but clips the values to the float16 range. With a 'dist' kvstore the
+        servers still accumulate and store the values in float32.
+
         When kvstore is 'local', gradient compression is used to reduce communication
         between multiple devices (gpus). Gradient is quantized on each GPU which
         computed the gradients, then sent to the GPU which merges the gradients. This
@@ -525,15 +573,21 @@ class KVStore(KVStoreBase):
         this data and merges the gradients from each worker. Note that this
         increases CPU memory usage on each worker because of the residual array stored.
         Only worker to server communication is compressed in this setting.
-        If each machine has multiple GPUs, currently this GPU to GPU or GPU to CPU communication
-        is not compressed. Server to worker communication (in the case of pull)
-        is also not compressed.
+        pushpull compresses its push, and pulls the uncompressed sum.
+        If each machine has multiple GPUs, the GPU to GPU communication is only compressed
+        with `intra_node` set to True, like {'type': '2bit', 'intra_node': True}: the merging
+        GPU sums the dequantized gradients of the GPUs, with a residual on each one, and the
+        sum is compressed again for the servers. This helps machines whose GPUs are only
+        linked through PCIe. GPU to CPU communication and server to worker communication
+        (in the case of pull) are not compressed.
 
         To use 2bit compression, we need to specify `type` as `2bit`.
         Only specifying `type` would use default value for the threshold.
         To completely specify the arguments for 2bit compression, we would need to pass
         a dictionary which includes `threshold` like:
         {'type': '2bit', 'threshold': 0.5}
+        and similarly {'type': '1bit', 'threshold': 0.01}, {'type': 'topk', 'block_size': 64}
+        or {'type': 'bf16'}.
 
         Parameters
         ----------
@@ -541,7 +595,7 @@ class KVStore(KVStoreBase):
             A dictionary specifying the type and parameters for gradient compression.
             The key `type` in this dictionary is a
             required string argument and specifies the type of gradient compression.
-            Currently `type` can be only `2bit`
+            Currently `type` can be `2bit`, `1bit`, `topk`, `randk`, `fp16` or `bf16`
             Other keys in this dictionary are optional and specific to the type
             of gradient compression.
         """
@@ -556,8 +610,8 @@ class KVStore(KVStoreBase):
     def set_optimizer(self, optimizer):
         """ Registers an optimizer with the kvstore.
 
-        When using a single machine, this function updates the local optimizer.
-        If using multiple machines and this operation is invoked from a worker node,
+        When using a single machine or ``dist_allreduce``, this function updates the local
+        optimizer. If using multiple machines and this operation is invoked from a worker node,
         it will serialized the optimizer with pickle and send it to all servers.
         The function returns after all servers have been updated.
 
@@ -587,7 +641,8 @@ class KVStore(KVStoreBase):
         check_call(_LIB.MXKVStoreIsWorkerNode(ctypes.byref(is_worker)))
 
         # pylint: disable=invalid-name
-        if 'dist' in self.type and is_worker.value: # pylint: disable=unsupported-membership-test
+        # dist_allreduce updates the weights on the workers
+        if 'dist' in self.type and 'allreduce' not in self.type and is_worker.value: # pylint: disable=unsupported-membership-test
             # send the optimizer to server
             try:
                 # use ASCII protocol 0, might be slower, but not a big ideal
@@ -596,6 +651,9 @@ class KVStore(KVStoreBase):
                 raise
             cmd = _get_kvstore_server_command_type('kController')
             self._send_command_to_servers(cmd, optim_str)
+            # the servers update the row_sparse values natively when the optimizer allows it
+            cmd = _get_kvstore_server_command_type('kSetLazyOptimizer')
+            self._send_command_to_servers(cmd, _lazy_optimizer_config(optimizer))
             if optimizer.multi_precision:
                 cmd = _get_kvstore_server_command_type('kSetMultiPrecision')
                 self._send_command_to_servers(cmd, '')
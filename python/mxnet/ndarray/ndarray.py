@@ -38,6 +38,7 @@ from ..base import c_array, c_array_buf, c_handle_array, mx_real_t
 from ..base import mx_uint, NDArrayHandle, check_call, mx_int, mx_int64
 from ..base import ctypes2buffer
 from ..dlpack import ndarray_to_dlpack_for_read, ndarray_to_dlpack_for_write
+from ..dlpack import to_dlpack_for_stream, dlpack_device
 from ..dlpack import ndarray_from_dlpack, ndarray_from_numpy
 from ..runtime import Features
 from ..context import Context, current_context
@@ -59,6 +60,8 @@ _STORAGE_TYPE_UNDEFINED = -1
 _STORAGE_TYPE_DEFAULT = 0
 _STORAGE_TYPE_ROW_SPARSE = 1
 _STORAGE_TYPE_CSR = 2
+# size of the CUDA IPC handle of an array on gpu, MXNET_GPU_IPC_HANDLE_SIZE
+_GPU_IPC_HANDLE_SIZE = 64
 _SIGNED_INT32_UPPER_LIMIT = (2**31 - 1)
 
 # pylint: disable= no-member
@@ -216,11 +219,25 @@ def _new_alloc_handle(shape, ctx, delay_alloc, dtype=mx_real_t):
     return hdl
 
 
-def _new_from_shared_mem(shared_pid, shared_id, shape, dtype):
+def _new_from_shared_mem(shared_pid, shared_id, shape, dtype, shared_offset=-1):
     hdl = NDArrayHandle()
-    check_call(_LIB.MXNDArrayCreateFromSharedMem(
+    check_call(_LIB.MXNDArrayCreateFromSharedMemEx(
         ctypes.c_int(shared_pid),
         ctypes.c_int(shared_id),
+        ctypes.c_int64(shared_offset),
+        c_array(mx_int, shape),
+        mx_int(len(shape)),
+        ctypes.c_int(int(_DTYPE_NP_TO_MX[np.dtype(dtype).type])),
+        ctypes.byref(hdl)))
+    return hdl
+
+
+def _new_from_gpu_shared_mem(ipc_handle, shared_offset, dev_id, shape, dtype):
+    hdl = NDArrayHandle()
+    check_call(_LIB.MXNDArrayCreateFromGPUSharedMem(
+        ctypes.c_char_p(ipc_handle),
+        ctypes.c_int64(shared_offset),
+        ctypes.c_int(dev_id),
         c_array(mx_int, shape),
         mx_int(len(shape)),
         ctypes.c_int(int(_DTYPE_NP_TO_MX[np.dtype(dtype).type])),
@@ -293,9 +310,22 @@ fixed-size items.
     def _to_shared_mem(self):
         shared_pid = ctypes.c_int()
         shared_id = ctypes.c_int()
-        check_call(_LIB.MXNDArrayGetSharedMemHandle(
-            self.handle, ctypes.byref(shared_pid), ctypes.byref(shared_id)))
-        return shared_pid.value, shared_id.value, self.shape, self.dtype
+        shared_offset = ctypes.c_int64()
+        check_call(_LIB.MXNDArrayGetSharedMemHandleEx(
+            self.handle, ctypes.byref(shared_pid), ctypes.byref(shared_id),
+            ctypes.byref(shared_offset)))
+        return shared_pid.value, shared_id.value, self.shape, self.dtype, shared_offset.value
+
+    def _to_gpu_shared_mem(self):
+        """Returns the CUDA IPC handle of the array on gpu, with which another process of the
+        machine creates an array of the same memory with `_new_from_gpu_shared_mem`. The array
+        must outlive the arrays of the other processes."""
+        ipc_handle = ctypes.create_string_buffer(_GPU_IPC_HANDLE_SIZE)
+        shared_offset = ctypes.c_int64()
+        check_call(_LIB.MXNDArrayGetGPUSharedMemHandle(
+            self.handle, ipc_handle, ctypes.byref(shared_offset)))
+        return (ipc_handle.raw, shared_offset.value, self.ctx.device_id, self.shape,
+                self.dtype)
 
     def __abs__(self):
         """x.__abs__() <=> abs(x) <=> x.abs() <=> mx.nd.abs(x, y)"""
@@ -2900,6 +2930,8 @@ fixed-size items.
             ctypes.c_int(train_mode),
             ctypes.c_void_p(0),
             ctypes.c_void_p(0)))
+        from ..autograd import _run_backward_hooks
+        _run_backward_hooks()
 
     def tostype(self, stype):
         """Return a copy of the array with chosen storage type.
@@ -2966,6 +2998,30 @@ fixed-size items.
         """
         return to_dlpack_for_write(self)
 
+    def __dlpack__(self, stream=None):
+        """Returns the DLPack tensor of the array, a zero-copy view, for the DLPack exchange
+        protocol of `from_dlpack` functions.
+
+        Parameters
+        ----------
+        stream : int or None
+            For arrays on GPU, the CUDA stream of the consumer: the address of the
+            cudaStream_t, 1 or None for the legacy default stream, 2 for the per-thread
+            default stream, or -1 for no synchronization. The work queued on the stream
+            from now on waits for the pending writes of the array with a CUDA event,
+            without a host wait for the device. Must be None for arrays on CPU, which are
+            waited for on the host.
+
+        Returns
+        -------
+        PyCapsule (the pointer of DLManagedTensor)
+        """
+        return to_dlpack_for_stream(self, stream)
+
+    def __dlpack_device__(self):
+        """Returns the (DLPack device type, device id) of the array."""
+        return dlpack_device(self)
+
     def _full(self, value):
         """
         This is added as an NDArray class method in order to support polymorphism in NDArray and numpy.ndarray indexing
@@ -4944,8 +5000,10 @@ from_dlpack_doc = """Returns a NDArray backed by a dlpack tensor.
 
     Parameters
     ----------
-    dlpack: PyCapsule (the pointer of DLManagedTensor)
-        input data
+    dlpack: PyCapsule (the pointer of DLManagedTensor) or an array with __dlpack__
+        input data. The producer of an array on GPU orders the per-thread default CUDA
+        stream after the work writing the array, and the operators reading the returned
+        NDArray wait for that stream with a CUDA event, without a host wait.
 
     Returns
     -------
@@ -17,7 +17,9 @@
 
 # coding: utf-8
 """Utility functions for NDArray and BaseSparseNDArray."""
+import atexit
 import ctypes
+import glob
 
 from ..base import _LIB, check_call, py_str, c_str, string_types, mx_uint, NDArrayHandle
 from ..base import c_array, c_handle_array, c_str_array
@@ -34,7 +36,8 @@ try:
 except ImportError:
     spsp = None
 
-__all__ = ['zeros', 'empty', 'array', 'load', 'load_frombuffer', 'save']
+__all__ = ['zeros', 'empty', 'array', 'load', 'load_frombuffer', 'save', 'save_sharded',
+           'wait_for_checkpoint', 'load_sharded']
 
 
 def zeros(shape, ctx=None, dtype=None, stype=None, **kwargs):
@@ -146,15 +149,20 @@ def array(source_array, ctx=None, dtype=None):
         return _array(source_array, ctx=ctx, dtype=dtype)
 
 
-def load(fname):
+def load(fname, keys=None):
     """Loads an array from file.
 
-    See more details in ``save``.
+    See more details in ``save``. Local files saved with ``mapped=True`` are mapped in memory
+    instead of being read: the arrays saved on CPU view the pages of the file, which are only
+    read when first used, and the arrays saved on GPU are copied from them.
 
     Parameters
     ----------
     fname : str
         The filename.
+    keys : list of str, optional
+        The names of the arrays to load from a dict, all of them by default. Files saved with
+        ``mapped=True`` only read these arrays.
 
     Returns
     -------
@@ -164,15 +172,18 @@ def load(fname):
     """
     if not isinstance(fname, string_types):
         raise TypeError('fname required to be a string')
+    keys = [] if keys is None else list(keys)
     out_size = mx_uint()
     out_name_size = mx_uint()
     handles = ctypes.POINTER(NDArrayHandle)()
     names = ctypes.POINTER(ctypes.c_char_p)()
-    check_call(_LIB.MXNDArrayLoad(c_str(fname),
-                                  ctypes.byref(out_size),
-                                  ctypes.byref(handles),
-                                  ctypes.byref(out_name_size),
-                                  ctypes.byref(names)))
+    check_call(_LIB.MXNDArrayLoadKeys(c_str(fname),
+                                      mx_uint(len(keys)),
+                                      c_str_array(keys),
+                                      ctypes.byref(out_size),
+                                      ctypes.byref(handles),
+                                      ctypes.byref(out_name_size),
+                                      ctypes.byref(names)))
     if out_name_size.value == 0:
         return [_ndarray_cls(NDArrayHandle(handles[i])) for i in range(out_size.value)]
     else:
@@ -219,7 +230,7 @@ def load_frombuffer(buf):
             for i in range(out_size.value))
 
 
-def save(fname, data):
+def save(fname, data, mapped=False):
     """Saves a list of arrays or a dict of str->array to file.
 
     Examples of filenames:
@@ -236,6 +247,10 @@ def save(fname, data):
            or list of NDArray, RowSparseNDArray or CSRNDArray, \
            or dict of str to NDArray, RowSparseNDArray or CSRNDArray
         The data to save.
+    mapped : bool, default False
+        Whether to save dense arrays in the mapped format, which starts with an index of the
+        arrays and aligns their data to pages, so that ``load`` maps the file in memory and
+        reads the arrays lazily.
 
     Examples
     --------
@@ -274,7 +289,95 @@ def save(fname, data):
     else:
         raise ValueError("data needs to either be a NDArray, dict of str, NDArray pairs "
                          "or a list of NDarrays.")
-    check_call(_LIB.MXNDArraySave(c_str(fname),
-                                  mx_uint(len(handles)),
-                                  handles,
-                                  keys))
+    save_fn = _LIB.MXNDArraySaveMapped if mapped else _LIB.MXNDArraySave
+    check_call(save_fn(c_str(fname),
+                       mx_uint(len(handles)),
+                       handles,
+                       keys))
+
+
+_checkpoint_exit_hook = []
+
+def save_sharded(prefix, data, num_shards=4):
+    """Saves a dict of str->array into `num_shards` files in the background.
+
+    The files are named ``<prefix>-<shard>-of-<num_shards>.params``, with 5 digit numbers,
+    and the arrays are split between them by size. The call returns once copies of the
+    arrays are scheduled, so that the arrays can be updated right away; the copies of dense
+    GPU arrays go to pinned host memory. The files are then written in parallel, in the
+    mapped format of ``save`` when they only hold dense arrays.
+
+    A call first waits for the files of the previous one, see ``wait_for_checkpoint``.
+
+    Parameters
+    ----------
+    prefix : str
+        The prefix of the file names.
+    data : dict of str to NDArray, RowSparseNDArray or CSRNDArray
+        The data to save.
+    num_shards : int, default 4
+        The number of files, written by as many threads.
+
+    Examples
+    --------
+    >>> w = mx.nd.ones((1024, 1024), ctx=mx.gpu(0))
+    >>> mx.nd.save_sharded('epoch10', {'w': w, 'b': mx.nd.zeros((1024,))}, num_shards=2)
+    >>> w += 1  # does not change the checkpoint
+    >>> mx.nd.wait_for_checkpoint()
+    >>> mx.nd.load_sharded('epoch10')
+    {'w': <NDArray 1024x1024 @gpu(0)>, 'b': <NDArray 1024 @cpu(0)>}
+    """
+    if not isinstance(data, dict) or \
+       any(not isinstance(k, string_types) for k in data.keys()) or \
+       any(not isinstance(v, NDArray) for v in data.values()):
+        raise TypeError('save_sharded only accept dict str->NDArray')
+    if not _checkpoint_exit_hook:
+        # the files must be complete before the engine shuts down
+        atexit.register(wait_for_checkpoint)
+        _checkpoint_exit_hook.append(True)
+    check_call(_LIB.MXNDArraySaveShardedAsync(c_str(prefix),
+                                              mx_uint(len(data)),
+                                              c_handle_array(data.values()),
+                                              c_str_array(data.keys()),
+                                              mx_uint(num_shards)))
+
+
+def wait_for_checkpoint():
+    """Waits for the files of the last ``save_sharded`` to be written.
+
+    The errors raised while writing them are raised here.
+    """
+    check_call(_LIB.MXNDArrayWaitForCheckpoint())
+
+
+def load_sharded(prefix, num_shards=None):
+    """Loads the dict of str->array saved by ``save_sharded``, a thread per file.
+
+    Parameters
+    ----------
+    prefix : str
+        The prefix of the file names.
+    num_shards : int, optional
+        The number of files, found from the name of the first one by default.
+
+    Returns
+    -------
+    dict of str to NDArray, RowSparseNDArray or CSRNDArray
+        Loaded data.
+    """
+    if num_shards is None:
+        first = glob.glob(glob.escape(prefix) + '-00000-of-*.params')
+        if len(first) != 1:
+            raise ValueError('cannot find the number of shards of %s, found %s'
+                             % (prefix, first))
+        num_shards = int(first[0][len(prefix):].split('-of-')[1].split('.')[0])
+    out_size = mx_uint()
+    handles = ctypes.POINTER(NDArrayHandle)()
+    names = ctypes.POINTER(ctypes.c_char_p)()
+    check_call(_LIB.MXNDArrayLoadSharded(c_str(prefix),
+                                         mx_uint(num_shards),
+                                         ctypes.byref(out_size),
+                                         ctypes.byref(handles),
+                                         ctypes.byref(names)))
+    return dict((py_str(names[i]), _ndarray_cls(NDArrayHandle(handles[i])))
+                for i in range(out_size.value))
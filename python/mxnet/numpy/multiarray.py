@@ -1234,7 +1234,8 @@ class ndarray(NDArray):
     @property
     # pylint: disable= invalid-name, undefined-variable
     def T(self):
-        """Same as self.transpose(). This always returns a copy of self."""
+        """Same as self.transpose(). This returns a view of self if only axes of length 1
+        move, and a copy otherwise."""
         return self.transpose()
     # pylint: enable= invalid-name, undefined-variable
 
@@ -5747,6 +5748,22 @@ def trace(a, offset=0, axis1=0, axis2=1, out=None):
     return _mx_nd_np.trace(a, offset, axis1, axis2, out)
 
 
+def _transposed_view(a, axes):
+    """Returns a view of `a` with its axes permuted by `axes` if the permutation keeps the
+    layout of `a` in memory, that is if it only moves axes of length 1. Returns None if
+    the transpose needs a copy or if `axes` is invalid, which the operator then reports."""
+    if not isinstance(a, ndarray) or dc.is_deferred_compute() or a.size == 0:
+        return None
+    ndim = a.ndim  # pylint: disable=redefined-outer-name
+    axes = [ax + ndim if ax < 0 else ax for ax in axes]
+    if sorted(axes) != list(range(ndim)):
+        return None
+    kept = [ax for ax in axes if a.shape[ax] != 1]
+    if kept != sorted(kept):
+        return None
+    return a.reshape_view(tuple(a.shape[ax] for ax in axes))
+
+
 @set_module('mxnet.numpy')
 def transpose(a, axes=None):
     """
@@ -5772,7 +5789,8 @@ def transpose(a, axes=None):
     the following way(s):
 
     - only ndarray is accepted as valid input, python iterables are not supported
-    - the operator always returns an `ndarray` that does not share the memory with the input
+    - the result shares the memory with the input only if the permutation moves axes of
+      length 1 only, which keeps the layout in memory, otherwise it is a copy
 
     Examples
     --------
@@ -5787,6 +5805,10 @@ def transpose(a, axes=None):
     >>> np.transpose(x, (1, 0, 2)).shape
     (2, 1, 3)
     """
+    if isinstance(a, ndarray):
+        view = _transposed_view(a, range(a.ndim - 1, -1, -1) if axes is None else axes)
+        if view is not None:
+            return view
     return _mx_nd_np.transpose(a, axes)
 
 
@@ -7024,7 +7046,8 @@ def swapaxes(a, axis1, axis2):
     Returns
     -------
     a_swapped : ndarray
-        Swapped array. This is always a copy of the input array.
+        Swapped array. This is a view of the input array if the swap keeps its layout in
+        memory, that is if it moves axes of length 1 only, otherwise it is a copy.
 
     Examples
     --------
@@ -7049,6 +7072,14 @@ def swapaxes(a, axis1, axis2):
            [[1., 5.],
             [3., 7.]]])
     """
+    if isinstance(a, ndarray) and isinstance(axis1, integer_types) \
+            and isinstance(axis2, integer_types) and -a.ndim <= axis1 < a.ndim \
+            and -a.ndim <= axis2 < a.ndim:
+        axes = list(range(a.ndim))
+        axes[axis1], axes[axis2] = axes[axis2], axes[axis1]
+        view = _transposed_view(a, axes)
+        if view is not None:
+            return view
     return _npi.swapaxes(a, dim1=axis1, dim2=axis2)
 
 
@@ -11766,6 +11797,20 @@ def moveaxis(a, source, destination):
     >>> np.moveaxis(x, [0, 1, 2], [-1, -2, -3]).shape
     (5, 4, 3)
     """
+    if isinstance(a, ndarray):
+        source = [source] if isinstance(source, integer_types) else list(source)
+        destination = [destination] if isinstance(destination, integer_types) else list(destination)
+        if len(source) == len(destination) and \
+                all(isinstance(ax, integer_types) and -a.ndim <= ax < a.ndim
+                    for ax in source + destination):
+            source = [ax % a.ndim for ax in source]
+            destination = [ax % a.ndim for ax in destination]
+            axes = [ax for ax in range(a.ndim) if ax not in source]
+            for dst, src in sorted(zip(destination, source)):
+                axes.insert(dst, src)
+            view = _transposed_view(a, axes)
+            if view is not None:
+                return view
     return _mx_nd_np.moveaxis(a, source, destination)
 
 @set_module('mxnet.numpy')
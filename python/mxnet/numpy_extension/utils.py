@@ -127,8 +127,10 @@ from_dlpack_doc = """Returns a np.ndarray backed by a dlpack tensor.
 
     Parameters
     ----------
-    dlpack: PyCapsule (the pointer of DLManagedTensor)
-        input data
+    dlpack: PyCapsule (the pointer of DLManagedTensor) or an array with __dlpack__
+        input data. The producer of an array on GPU orders the per-thread default CUDA
+        stream after the work writing the array, and the operators reading the returned
+        ndarray wait for that stream with a CUDA event, without a host wait.
 
     Returns
     -------
@@ -18,12 +18,17 @@
 """Adam optimizer."""
 from __future__ import absolute_import
 import math
+import numpy
 from ..ndarray import (zeros, clip, sqrt, square)
-from ..ndarray import adam_update
+from ..ndarray import (adam_update, multi_adam_update, multi_mp_adam_update,
+                       multi_adam_8bit_update, multi_mp_adam_8bit_update)
 from .optimizer import Optimizer, register
+from .utils import _flatten_list
 
 __all__ = ['Adam']
 
+_bfloat16 = numpy.dtype([('bfloat16', numpy.uint16)])
+
 
 @register
 class Adam(Optimizer):
@@ -77,19 +82,43 @@ class Adam(Optimizer):
     lazy_update : bool, default False
        Default is False. If True, lazy updates are applied \
        if the storage types of weight and grad are both ``row_sparse``.
+    aggregate_num : int, default 1
+        Number of weights to be aggregated in a list.
+        They are passed to the optimizer for a single optimization step, which updates
+        the dense weights in a single kernel.
+    state_dtype : str, default None
+        Storage of the mean and the variance. None stores them in the type of the weight,
+        or in float32 with ``multi_precision``. 'bfloat16' takes half of the memory of
+        float32 states. 'int8' takes a quarter of it, by storing 8-bit codes with one
+        float32 scale per block of ``state_block_size`` elements, see
+        :class:`~mxnet.ndarray.multi_adam_8bit_update`. The states are converted to the
+        type of the math of the update, float32 for float32 weights or with
+        ``multi_precision``. Both need ``use_fused_step`` without ``lazy_update``.
+    state_block_size : int, default 256
+        Number of consecutive elements of a state sharing a scale when ``state_dtype``
+        is 'int8'.
     use_fused_step : bool, default True
         Whether or not to use fused kernels for optimizer.
         When use_fused_step=False, step is called,
         otherwise, fused_step is called.
     """
     def __init__(self, learning_rate=0.001, beta1=0.9, beta2=0.999, epsilon=1e-8,
-                 lazy_update=False, use_fused_step=True, **kwargs):
+                 lazy_update=False, use_fused_step=True, aggregate_num=1,
+                 state_dtype=None, state_block_size=256, **kwargs):
         super(Adam, self).__init__(use_fused_step=use_fused_step,
                                    learning_rate=learning_rate,
+                                   aggregate_num=aggregate_num,
                                    **kwargs)
         if not self.use_fused_step:
             assert not lazy_update,\
                 'When use_fused_step is set to False, lazy_update has to be turned off.'
+        if state_dtype is not None:
+            assert state_dtype in ('bfloat16', 'int8'), \
+                "state_dtype must be None, 'bfloat16' or 'int8', got %s" % state_dtype
+            assert self.use_fused_step and not lazy_update, \
+                'Optimizer states in %s need use_fused_step and no lazy_update.' % state_dtype
+        self.state_dtype = state_dtype
+        self.state_block_size = state_block_size
         self.lazy_update = lazy_update
         self.beta1 = beta1
         self.beta2 = beta2
@@ -97,6 +126,15 @@ class Adam(Optimizer):
         self.lazy_update = lazy_update
 
     def create_state(self, index, weight):
+        if self.state_dtype == 'bfloat16':
+            return (zeros(weight.shape, weight.context, dtype=_bfloat16),  # mean
+                    zeros(weight.shape, weight.context, dtype=_bfloat16))  # variance
+        if self.state_dtype == 'int8':
+            num_blocks = (weight.size + self.state_block_size - 1) // self.state_block_size
+            return (zeros(weight.shape, weight.context, dtype='int8'),  # mean
+                    zeros(weight.shape, weight.context, dtype='uint8'),  # root of variance
+                    zeros((num_blocks,), weight.context, dtype='float32'),  # scales of mean
+                    zeros((num_blocks,), weight.context, dtype='float32'))  # scales of var
         stype = weight.stype if self.lazy_update else 'default'
         return (zeros(weight.shape, weight.context, dtype=weight.dtype,
                       stype=stype),  # mean
@@ -163,24 +201,61 @@ class Adam(Optimizer):
         states : List of any obj
             List of state returned by `create_state()`.
         """
-        for index, weight, grad, state in zip(indices, weights, grads, states):
-            self._update_count(index)
-            lr = self._get_lr(index)
-            wd = self._get_wd(index)
+        # When either weight or gradient is sparse, aggregate is False.
+        aggregate = self._aggregate(weights, grads)
+        self._update_count(indices)
+        lrs = self._get_lrs(indices)
+        wds = self._get_wds(indices)
+        for i, index in enumerate(indices):
             t = self._index_update_count[index]
-
             coef1 = 1. - self.beta1**t
             coef2 = 1. - self.beta2**t
+            lrs[i] *= math.sqrt(coef2)/coef1
 
-            lr *= math.sqrt(coef2)/coef1
+        kwargs = {'beta1': self.beta1, 'beta2': self.beta2, 'epsilon': self.epsilon,
+                  'rescale_grad': self.rescale_grad}
+        if self.clip_gradient:
+            kwargs['clip_gradient'] = self.clip_gradient
 
-            kwargs = {'beta1': self.beta1, 'beta2': self.beta2, 'epsilon': self.epsilon,
-                      'rescale_grad': self.rescale_grad}
-            if self.clip_gradient:
-                kwargs['clip_gradient'] = self.clip_gradient
+        if aggregate or self.state_dtype is not None:
+            # update `aggregate_num` number of weights in a single kernel, which is the
+            # only one for the states in bfloat16 or int8.
+            multi_precision = self.multi_precision and weights[0].dtype == numpy.float16
+            if multi_precision:
+                inputs = [(weight, grad) + tuple(moments) + (weight32,)
+                          for weight, grad, (weight32, moments) in zip(weights, grads, states)]
+            else:
+                inputs = [(weight, grad) + tuple(state)
+                          for weight, grad, state in zip(weights, grads, states)]
+            if self.state_dtype == 'int8':
+                kwargs['block_size'] = self.state_block_size
+                update = multi_mp_adam_8bit_update if multi_precision else multi_adam_8bit_update
+            else:
+                update = multi_mp_adam_update if multi_precision else multi_adam_update
+            update(*_flatten_list(inputs), out=weights, num_weights=len(weights),
+                   lrs=lrs, wds=wds, **kwargs)
+        else:
+            for weight, grad, state, lr, wd in zip(weights, grads, states, lrs, wds):
+                mean, var = state
 
-            mean, var = state
+                # update weight with fused kernel
+                adam_update(weight, grad, mean, var, out=weight,
+                            lazy_update=self.lazy_update, lr=lr, wd=wd, **kwargs)
 
-            # update weight with fused kernel
-            adam_update(weight, grad, mean, var, out=weight,
-                        lazy_update=self.lazy_update, lr=lr, wd=wd, **kwargs)
+    def _aggregate(self, weights, grads):
+        """Whether the weights are updated by a single multi-tensor kernel."""
+        aggregate = self.aggregate_num > 1
+        for weight, grad in zip(weights, grads):
+            aggregate = (aggregate and
+                         weight.stype == 'default' and
+                         grad.stype == 'default')
+        return aggregate
+
+    def update_multi_precision(self, indices, weights, grads, states):
+        """Override update_multi_precision.
+        """
+        if self.use_fused_step and (self.state_dtype is not None or
+                                    self._aggregate(weights, grads)):
+            self.update(indices, weights, grads, states)
+        else:
+            super(Adam, self).update_multi_precision(indices, weights, grads, states)
@@ -19,8 +19,11 @@
 from __future__ import absolute_import
 import numpy
 from ..ndarray import (zeros, clip)
-from ..ndarray import (sgd_update, mp_sgd_update, nag_mom_update, mp_nag_mom_update)
+from ..ndarray import (sgd_update, mp_sgd_update, nag_mom_update, mp_nag_mom_update,
+                       multi_sgd_update, multi_mp_sgd_update,
+                       multi_nag_mom_update, multi_mp_nag_mom_update)
 from .optimizer import Optimizer, register
+from .utils import _flatten_list
 
 __all__ = ['NAG']
 
@@ -50,16 +53,21 @@ class NAG(Optimizer):
         True: makes internal 32-bit copy of the weights and applies gradients
         in 32-bit precision even if actual weights used in the model have lower precision.
         Turning this on can improve convergence and accuracy when training with float16.
+    aggregate_num : int, default 1
+        Number of weights to be aggregated in a list.
+        They are passed to the optimizer for a single optimization step, which updates
+        the dense weights in a single kernel.
     use_fused_step : bool, default True
         Whether or not to use fused kernels for optimizer.
         When use_fused_step=False, step is called,
         otherwise, fused_step is called.
     """
     def __init__(self, learning_rate=0.1, momentum=0.9, multi_precision=False,
-                 use_fused_step=True, **kwargs):
+                 use_fused_step=True, aggregate_num=1, **kwargs):
         super(NAG, self).__init__(learning_rate=learning_rate,
                                   multi_precision=multi_precision,
                                   use_fused_step=use_fused_step,
+                                  aggregate_num=aggregate_num,
                                   **kwargs)
         self.momentum = momentum
 
@@ -125,33 +133,62 @@ class NAG(Optimizer):
         states : List of any obj
             List of state returned by `create_state()`.
         """
-        for index, weight, grad, state in zip(indices, weights, grads, states):
-            self._update_count(index)
-            lr = self._get_lr(index)
-            wd = self._get_wd(index)
-
-            kwargs = {'rescale_grad': self.rescale_grad}
-            if self.momentum > 0:
-                kwargs['momentum'] = self.momentum
-            if self.clip_gradient:
-                kwargs['clip_gradient'] = self.clip_gradient
-
-            multi_precision = self.multi_precision and weight.dtype == numpy.float16
-
+        # When either weight or gradient is sparse, aggregate is False.
+        aggregate = self.aggregate_num > 1
+        for weight, grad in zip(weights, grads):
+            aggregate = (aggregate and
+                         weight.stype == 'default' and
+                         grad.stype == 'default')
+        self._update_count(indices)
+        lrs = self._get_lrs(indices)
+        wds = self._get_wds(indices)
+
+        kwargs = {'rescale_grad': self.rescale_grad}
+        if self.momentum > 0:
+            kwargs['momentum'] = self.momentum
+        if self.clip_gradient:
+            kwargs['clip_gradient'] = self.clip_gradient
+
+        if aggregate:
+            # update `aggregate_num` number of weights in a single kernel.
+            multi_precision = self.multi_precision and weights[0].dtype == numpy.float16
             if not multi_precision:
-                mom = state
-                if mom is not None:
-                    nag_mom_update(weight, grad, mom, out=weight, lr=lr, wd=wd, **kwargs)
+                if self.momentum > 0:
+                    multi_nag_mom_update(*_flatten_list(zip(weights, grads, states)),
+                                         out=weights, num_weights=len(weights),
+                                         lrs=lrs, wds=wds, **kwargs)
                 else:
-                    sgd_update(weight, grad, out=weight, lr=lr, wd=wd, **kwargs)
+                    multi_sgd_update(*_flatten_list(zip(weights, grads)), out=weights,
+                                     num_weights=len(weights), lrs=lrs, wds=wds, **kwargs)
             else:
-                weight32, mom = state
-                if mom is not None:
-                    mp_nag_mom_update(weight, grad, mom, weight32, out=weight,
-                                      lr=lr, wd=wd, **kwargs)
+                weights32, moms = zip(*states)
+                if self.momentum > 0:
+                    multi_mp_nag_mom_update(*_flatten_list(zip(weights, grads,
+                                                               moms, weights32)),
+                                            out=weights, num_weights=len(weights),
+                                            lrs=lrs, wds=wds, **kwargs)
                 else:
-                    mp_sgd_update(weight, grad, weight32, out=weight,
-                                  lr=lr, wd=wd, **kwargs)
+                    multi_mp_sgd_update(*_flatten_list(zip(weights, grads, weights32)),
+                                        out=weights, num_weights=len(weights),
+                                        lrs=lrs, wds=wds, **kwargs)
+        else:
+            for weight, grad, state, lr, wd in zip(weights, grads, states, lrs, wds):
+                multi_precision = self.multi_precision and weight.dtype == numpy.float16
+
+                if not multi_precision:
+                    mom = state
+                    if mom is not None:
+                        nag_mom_update(weight, grad, mom, out=weight, lr=lr, wd=wd, **kwargs)
+                    else:
+                        sgd_update(weight, grad, out=weight, lr=lr, wd=wd, **kwargs)
+                else:
+                    weight32, mom = state
+                    if mom is not None:
+                        mp_nag_mom_update(weight, grad, mom, weight32, out=weight,
+                                          lr=lr, wd=wd, **kwargs)
+                    else:
+                        mp_sgd_update(weight, grad, weight32, out=weight,
+                                      lr=lr, wd=wd, **kwargs)
 
     def update_multi_precision(self, indices, weights, grads, states):
         """Override update_multi_precision.
@@ -20,7 +20,7 @@
 """Base Optimizer class."""
 import warnings
 import numpy
-from ..ndarray import (NDArray, zeros, cast)
+from ..ndarray import (NDArray, zeros, empty, cast, amp_multicast)
 from ..util import is_np_array
 
 __all__ = ['Optimizer', 'Test', 'create', 'register']
@@ -337,18 +337,38 @@ class Optimizer(object):
         weights_master_copy = []
         original_states = []
         grads32 = []
+        # dense fp16 arrays, cast all together to and from fp32 by amp_multicast
+        dense_grads16, dense_grads32 = [], []
+        dense_weights16, dense_weights32 = [], []
         for weight, grad, state in zip(weights, grads, states):
             if self.multi_precision and weight.dtype == numpy.float16:
                 weights_master_copy.append(state[0])
                 original_states.append(state[1])
-                grads32.append(grad.astype(numpy.float32))
+                if grad.stype == 'default':
+                    grad32 = empty(grad.shape, ctx=grad.context, dtype=numpy.float32)
+                    if is_np_array():
+                        grad32 = grad32.as_np_ndarray()
+                    dense_grads16.append(grad)
+                    dense_grads32.append(grad32)
+                else:
+                    grad32 = grad.astype(numpy.float32)
+                grads32.append(grad32)
+                if weight.stype == 'default':
+                    dense_weights16.append(weight)
+                    dense_weights32.append(state[0])
             else:
                 weights_master_copy.append(weight)
                 original_states.append(state)
                 grads32.append(grad)
+        if dense_grads16:
+            amp_multicast(*dense_grads16, num_outputs=len(dense_grads16), out=dense_grads32)
         self.update(indices, weights_master_copy, grads32, original_states)
+        if dense_weights16:
+            amp_multicast(*dense_weights32, num_outputs=len(dense_weights32), cast_narrow=True,
+                          out=dense_weights16)
         for weight_master_copy, weight in zip(weights_master_copy, weights):
-            if self.multi_precision and weight.dtype == numpy.float16:
+            if self.multi_precision and weight.dtype == numpy.float16 and \
+                    weight.stype != 'default':
                 cast(weight_master_copy, dtype=weight.dtype, out=weight)
 
     def set_learning_rate(self, lr):
@@ -16,9 +16,12 @@
 # under the License.
 """RMSProp optimizer."""
 from __future__ import absolute_import
+import numpy
 from ..ndarray import (zeros, clip, sqrt, square)
-from ..ndarray import (rmsprop_update, rmspropalex_update)
+from ..ndarray import (rmsprop_update, rmspropalex_update,
+                       multi_rmsprop_update, multi_mp_rmsprop_update)
 from .optimizer import Optimizer, register
+from .utils import _flatten_list
 
 __all__ = ['RMSProp']
 
@@ -62,6 +65,10 @@ class RMSProp(Optimizer):
 
     clip_weights : float, optional
         Clips weights into range ``[-clip_weights, clip_weights]``.
+    aggregate_num : int, default 1
+        Number of weights to be aggregated in a list.
+        They are passed to the optimizer for a single optimization step, which updates
+        the dense weights in a single kernel when ``centered`` is False.
     use_fused_step : bool, default True
         Whether or not to use fused kernels for optimizer.
         When use_fused_step=False, step is called,
@@ -69,9 +76,10 @@ class RMSProp(Optimizer):
     """
     def __init__(self, learning_rate=0.001, rho=0.9, momentum=0.9,
                  epsilon=1e-8, centered=False, clip_weights=None,
-                 use_fused_step=True, **kwargs):
+                 use_fused_step=True, aggregate_num=1, **kwargs):
         super(RMSProp, self).__init__(learning_rate=learning_rate,
                                       use_fused_step=use_fused_step,
+                                      aggregate_num=aggregate_num,
                                       **kwargs)
         self.rho = rho
         self.momentum = momentum
@@ -157,25 +165,58 @@ class RMSProp(Optimizer):
         states : List of any obj
             List of state returned by `create_state()`.
         """
-        for index, weight, grad, state in zip(indices, weights, grads, states):
-            self._update_count(index)
-            lr = self._get_lr(index)
-            wd = self._get_wd(index)
-
-            kwargs = {'rho': self.rho, 'epsilon': self.epsilon,
-                      'rescale_grad': self.rescale_grad}
-            if self.centered:
-                kwargs['momentum'] = self.momentum
-            if self.clip_gradient:
-                kwargs['clip_gradient'] = self.clip_gradient
-            if self.clip_weights:
-                kwargs['clip_weights'] = self.clip_weights
-
-            # update weight with fused kernel
-            if not self.centered:
-                var = state
-                rmsprop_update(weight, grad, var, out=weight, lr=lr, wd=wd, **kwargs)
+        # When either weight or gradient is sparse, aggregate is False.
+        aggregate = self._aggregate(weights, grads)
+        self._update_count(indices)
+        lrs = self._get_lrs(indices)
+        wds = self._get_wds(indices)
+
+        kwargs = {'rho': self.rho, 'epsilon': self.epsilon,
+                  'rescale_grad': self.rescale_grad}
+        if self.centered:
+            kwargs['momentum'] = self.momentum
+        if self.clip_gradient:
+            kwargs['clip_gradient'] = self.clip_gradient
+        if self.clip_weights:
+            kwargs['clip_weights'] = self.clip_weights
+
+        if aggregate:
+            # update `aggregate_num` number of weights in a single kernel.
+            multi_precision = self.multi_precision and weights[0].dtype == numpy.float16
+            if not multi_precision:
+                multi_rmsprop_update(*_flatten_list(zip(weights, grads, states)),
+                                     out=weights, num_weights=len(weights),
+                                     lrs=lrs, wds=wds, **kwargs)
             else:
-                mean, var, mom = state
-                rmspropalex_update(weight, grad, mean, var, mom, out=weight,
-                                   lr=lr, wd=wd, **kwargs)
+                weights32, variances = zip(*states)
+                multi_mp_rmsprop_update(*_flatten_list(zip(weights, grads, variances,
+                                                           weights32)),
+                                        out=weights, num_weights=len(weights),
+                                        lrs=lrs, wds=wds, **kwargs)
+        else:
+            for weight, grad, state, lr, wd in zip(weights, grads, states, lrs, wds):
+                # update weight with fused kernel
+                if not self.centered:
+                    var = state
+                    rmsprop_update(weight, grad, var, out=weight, lr=lr, wd=wd, **kwargs)
+                else:
+                    mean, var, mom = state
+                    rmspropalex_update(weight, grad, mean, var, mom, out=weight,
+                                       lr=lr, wd=wd, **kwargs)
+
+    def _aggregate(self, weights, grads):
+        """Whether the weights are updated by a single multi-tensor kernel."""
+        aggregate = self.aggregate_num > 1 and not self.centered
+        for weight, grad in zip(weights, grads):
+            aggregate = (aggregate and
+                         weight.stype == 'default' and
+                         grad.stype == 'default')
+        return aggregate
+
+    def update_multi_precision(self, indices, weights, grads, states):
+        """Override update_multi_precision.
+        """
+        if self.use_fused_step and self._aggregate(weights, grads):
+            self.update(indices, weights, grads, states)
+        else:
+            super(RMSProp, self).update_multi_precision(indices, weights, grads, states)
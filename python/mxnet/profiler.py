@@ -37,7 +37,10 @@ def set_config(**kwargs):
     Parameters
     ----------
     filename : string,
-        output file for profile data
+        output file for profile data, in chrome tracing json format, or in Perfetto
+        protobuf format if it ends with .pftrace or .perfetto-trace. A Perfetto trace
+        is appended to by the continuous dumps and is valid after every dump, which
+        suits long runs.
     gpu_memory_profile_filename_prefix : string
         filename prefix for the GPU memory profile
     profile_all : boolean,
@@ -47,7 +50,10 @@ def set_config(**kwargs):
     profile_imperative : boolean,
         whether to profile imperative operators
     profile_memory : boolean,
-        whether to profile memory usage
+        whether to profile memory usage. Every dump then also writes a memory
+        timeline next to the profile, `profile.json` in `profile_memory.json`, with
+        the live bytes of every device over time, its peak, and the allocations
+        holding memory at the peak with their profiler scope, operator and request.
     profile_api : boolean,
         whether to profile the C API
     continuous_dump : boolean,
@@ -61,6 +67,15 @@ def set_config(**kwargs):
         whether to profile kvstore `server` or `worker`.
         server can only be profiled when kvstore is of type dist.
         if this is not passed, defaults to `worker`
+    ring_size : int
+        if nonzero, only the last `ring_size` records are kept, in a fixed size ring,
+        and every dump writes them as a whole trace. This bounds the memory of a
+        profiler left running, whose traces are taken with `dump(finished=False)`.
+    sample_period : int
+        record one in `sample_period` operators. Defaults to 1
+    sample_iterations : boolean
+        rather record all the operators of one in `sample_period` iterations,
+        the iterations being delimited by `next_iteration()`
     """
     kk = kwargs.keys()
     vv = kwargs.values()
@@ -225,6 +240,33 @@ def resume(profile_process='worker'):
                                           profiler_kvstore_handle))
 
 
+def next_iteration():
+    """Mark the start of the next iteration, for the profiler configured
+    with `sample_iterations`."""
+    check_call(_LIB.MXProfileNextIteration())
+
+
+@contextlib.contextmanager
+def request(request_id):
+    """Attribute the operators pushed in the scope by the calling thread to a request.
+
+    The operators of each request are summed up in the `Requests` table of the
+    aggregate statistics, and are tagged with the request in the trace.
+
+    Parameters
+    ----------
+    request_id : str
+        Name of the request, for example the id of an inference call.
+    """
+    token = _current_request.set(str(request_id))
+    check_call(_LIB.MXProfileSetRequest(c_str(str(request_id))))
+    try:
+        yield request_id
+    finally:
+        _current_request.reset(token)
+        check_call(_LIB.MXProfileSetRequest(c_str(_current_request.get())))
+
+
 class Domain(object):
     """Profiling domain, used to group sub-objects like tasks, counters, etc into categories
     Serves as part of 'categories' for chrome://tracing
@@ -527,3 +569,5 @@ def scope(name='<unk>:', append_mode=False):
 
 # initialize the default profiler scope
 _current_scope = contextvars.ContextVar('profilerscope', default='<unk>:')
+# no request by default
+_current_request = contextvars.ContextVar('profilerrequest', default='')
@@ -209,7 +209,7 @@ def _check_data(inputs, in_type, msg):
         is_NDArray_or_list = isinstance(inputs, in_type)
     assert is_NDArray_or_list, msg
 
-def foreach(body, data, init_states, name="foreach"):
+def foreach(body, data, init_states, name="foreach", static_alloc=None):
     """Run a for loop with user-defined computation over Symbols on dimension 0.
 
     This operator simulates a for loop and body has the computation for an iteration
@@ -254,6 +254,9 @@ def foreach(body, data, init_states, name="foreach"):
         The initial values of the loop states.
     name: string.
         The name of the operator.
+    static_alloc: bool, optional.
+        Plan the memory of the loop body once and reuse it in the iterations that are
+        not recorded for backward. Defaults to MXNET_CONTROL_FLOW_STATIC_ALLOC.
 
     Returns
     -------
@@ -358,9 +361,11 @@ def foreach(body, data, init_states, name="foreach"):
             ordered_ins.append(copy.deepcopy(input_syms[in_name]))
             remain_locs.append(subg_input_names.index(in_name))
 
+    kwargs = {} if static_alloc is None else {'static_alloc': static_alloc}
     ret = symbol._internal._foreach(g, *ordered_ins, num_outputs=num_outputs,
                                     num_out_data=num_out_data, in_state_locs=in_state_locs,
-                                    in_data_locs=in_data_locs, remain_locs=remain_locs)
+                                    in_data_locs=in_data_locs, remain_locs=remain_locs,
+                                    **kwargs)
     outs = []
     for i in range(num_outputs - num_states):
         outs.append(ret[i])
@@ -372,7 +377,7 @@ def foreach(body, data, init_states, name="foreach"):
 
     return (outs, states)
 
-def while_loop(cond, func, loop_vars, max_iterations=None, name="while_loop"):
+def while_loop(cond, func, loop_vars, max_iterations=None, name="while_loop", static_alloc=None):
     """Run a while loop with user-defined computation and loop condition.
 
     This operator simulates a while loop which iterately does customized computation
@@ -428,6 +433,9 @@ def while_loop(cond, func, loop_vars, max_iterations=None, name="while_loop"):
         The initial values of the loop variables.
     max_iterations: a python int.
         Maximum number of iterations.
+    static_alloc: bool, optional.
+        Plan the memory of the loop body once and reuse it in the iterations that are
+        not recorded for backward. Defaults to MXNET_CONTROL_FLOW_STATIC_ALLOC.
 
     Returns
     ------
@@ -587,7 +595,8 @@ def while_loop(cond, func, loop_vars, max_iterations=None, name="while_loop"):
         func_input_locs=func_input_locs,
         func_var_locs=func_var_locs,
         num_out_data=num_out_data,
-        num_outputs=num_outputs
+        num_outputs=num_outputs,
+        **({} if static_alloc is None else {'static_alloc': static_alloc})
     )
     outputs = [result[i] for i in range(num_out_data)]
     outputs, _ = _regroup(outputs, out_fmt)
@@ -1481,7 +1481,38 @@ class Symbol(SymbolBase):
         Parameters
         ----------
         backend : str
-            The name of backend, as registered in `SubgraphBackendRegistry`
+            The name of backend, as registered in `SubgraphBackendRegistry`, or of a
+            registered graph pass. The `FoldConstants` pass replaces the nodes depending only
+            on `args` and `aux` by new args holding their values; inputs listed in the
+            comma-separated `data` option are not treated as constants. The `ConvertLayout`
+            pass rewrites Convolution and Pooling to the channels-last `layout` option
+            (NHWC or NDHWC), transposing only where the graph needs the original layout.
+            The `FuseConvBNReLU` pass replaces Convolution, training mode BatchNorm and ReLU
+            chains by `_contrib_ConvBatchNormWithReLU`, which also computes their gradients.
+            The `FuseFCActivation` pass replaces FullyConnected followed by a ReLU or GELU by
+            `_contrib_FullyConnectedAct`, which applies the bias and the ReLU in the cuBLASLt
+            GEMM epilogue on GPU.
+            The `FuseRequantize` pass folds calibrated `_contrib_requantize` nodes of a
+            quantized symbol into the `_contrib_quantized_elemwise_add` producing them.
+            The `IntgemmDynamicQuantize` pass quantizes the weights of FullyConnected to int8
+            and replaces them by `_contrib_intgemm_fully_connected`, which quantizes the data of
+            each batch at runtime; nodes named in the comma-separated `exclude` option are kept.
+            The `WeightOnlyQuantize` pass quantizes the weights of FullyConnected and the
+            constant rhs of batch_dot to `num_bits` (8 or 4) with a scale per `group_size`
+            values, keeping float activations; it also takes the `exclude` option. The
+            tables of Embedding and EmbeddingBag and the constant rhs of dot are quantized
+            to int8 with a scale per row, read by the `_contrib_rowwise_quantized_*` ops.
+            The `CostModelPartition` pass partitions the graph across the comma-separated
+            `backends` (by default the ones of the device), giving each region to the backend
+            whose estimated latency, including copies to another device, is the lowest. The
+            estimates use the `gflops`, `bandwidth` (GB/s) and `overhead` (us per operator)
+            options for the default executor, the same options prefixed by `<backend>_` for
+            each backend, and `transfer_bandwidth` (GB/s).
+            The `FP8` pass replaces the comma-separated `ops` (FullyConnected and batch_dot by
+            default) by `_contrib_fp8_*` ops computing their GEMMs in FP8 with per-tensor
+            delayed scaling, each with a new zero auxiliary state `<name>_amax_history`; it
+            takes the `exclude`, `fp8_format`, `amax_history_len`, `amax_compute_algo` and
+            `margin` options.
 
         args : dict of str to NDArray, optional
             Input arguments to the symbol, required to infer shapes/types before partitioning
@@ -22,10 +22,13 @@
  * \file c_api.cc
  * \brief C API of mxnet
  */
+#include <algorithm>
 #include <vector>
 #include <sstream>
 #include <string>
 #include <mutex>
+#include <condition_variable>
+#include <map>
 #include <memory>
 #include <functional>
 #include <unordered_map>
@@ -58,7 +61,11 @@
 #include "../operator/subgraph/subgraph_property.h"
 #include "../common/utils.h"
 #include "../profiler/profiler.h"
+#include "../ndarray/checkpoint.h"
 #include "nnvm/pass_functions.h"
+#if MXNET_USE_NCCL
+#include <nccl.h>
+#endif
 
 using namespace mxnet;
 
@@ -124,8 +131,11 @@ void CustomFComputeDispatcher(const std::string op_name,
                               const mxnet::ext::fcomp_t fcomp_fp,
                               const nnvm::NodeAttrs* attrs,
                               const mxnet::ext::opCallFStatefulComp_t callFStatefulComp,
-                              int stateful_forward_flag,
+                              int forward_flag,
                               const OpStatePtr* state_ptr,
+                              const mxnet::ext::opCallTempSpace_t callTempSpace,
+                              const mxnet::ext::tempSpace_t temp_fp,
+                              const mxnet::ext::opCallFree_t callFree,
                               const OpContext& ctx,
                               const std::vector<NDArray>& inputs,
                               const std::vector<OpReqType>& req,
@@ -215,14 +225,78 @@ void CustomFComputeDispatcher(const std::string op_name,
   mshadow::Stream<mxnet::cpu> *cpu_stream = ctx.get_stream<mxnet::cpu>();
   mshadow::Stream<mxnet::gpu> *gpu_stream = ctx.get_stream<mxnet::gpu>();
 
+  CHECK((fcomp_fp != nullptr && state_ptr == nullptr)
+        || (fcomp_fp == nullptr && state_ptr != nullptr))
+    << "Can only register either regular op or stateful op for '" << op_name << "'";
+
+  // convert attributes to vector of char*
+  std::vector<const char*> attr_keys, attr_vals;
+  if (attrs != nullptr) {
+    for (auto &kv : attrs->dict) {
+      attr_keys.push_back(kv.first.c_str());
+      attr_vals.push_back(kv.second.c_str());
+    }
+  }
+
+  // retrieve op state object created from CreateOpState
+  CustomStatefulOp* state_op_inst = nullptr;
+  if (state_ptr != nullptr) {
+    CustomStatefulOpWrapper& op = state_ptr->get_state<CustomStatefulOpWrapper>();
+    state_op_inst = op.get_instance();
+    std::string msgs = getExtensionMsgs(msgSize, msgGet);
+    CHECK(state_op_inst != nullptr)
+      << "Error custom stateful operator is null for operator '" << op_name << "'" << msgs;
+  }
+
+  // the temp space buffers declared by the op share one request of the temp space resource,
+  // so that they are pooled between calls as the workspaces of built-in ops are
+  std::vector<void*> temp_space;
+  std::vector<size_t> temp_space_sizes;
+  if (temp_fp != nullptr || state_op_inst != nullptr) {
+    size_t* sizes = nullptr;
+    int num_sizes = 0;
+    int retval = callTempSpace(temp_fp, state_op_inst, attr_keys.data(), attr_vals.data(),
+                               attr_keys.size(), in_shapes.data(), in_dims.data(),
+                               in_types.data(), in_data.size(), forward_flag,
+                               &sizes, &num_sizes);
+    std::string msgs = getExtensionMsgs(msgSize, msgGet);
+    CHECK(retval) << "Error calling TempSpace for custom operator '" << op_name << "'" << msgs;
+    temp_space_sizes.assign(sizes, sizes + num_sizes);
+    callFree(sizes);
+  }
+  if (!temp_space_sizes.empty()) {
+    // align every buffer as the storage managers align their allocations
+    std::vector<size_t> offsets;
+    size_t total = 0;
+    for (size_t size : temp_space_sizes) {
+      offsets.push_back(total);
+      total += (size + 255) / 256 * 256;
+    }
+    char* base = nullptr;
+    if (total > 0 && ctx.run_ctx.ctx.dev_mask() == Context::kGPU) {
+      base = resource.get_space_typed<mxnet::gpu, 1, char>(mshadow::Shape1(total),
+                                                           gpu_stream).dptr_;
+    } else if (total > 0) {
+      base = resource.get_space_typed<mxnet::cpu, 1, char>(mshadow::Shape1(total),
+                                                           cpu_stream).dptr_;
+    }
+    for (size_t offset : offsets) {
+      temp_space.push_back(base == nullptr ? nullptr : base + offset);
+    }
+  }
+
   // create lambda that captures stream & resource objects
   // this temp workspace holds memory allocated by custom library via OpResource
   auto cpu_alloc = [&](int size) {
+    CHECK(temp_space.empty()) << "Custom operator '" << op_name << "' declares its temp space,"
+      << " which alloc_cpu would overwrite, use OpResource::get_temp_space instead";
     mshadow::Tensor<mxnet::cpu, 1, char> workspace =
       resource.get_space_typed<mxnet::cpu, 1, char>(mshadow::Shape1(size), cpu_stream);
     return workspace.dptr_;
   };
   auto gpu_alloc = [&](int size) {
+    CHECK(temp_space.empty()) << "Custom operator '" << op_name << "' declares its temp space,"
+      << " which alloc_gpu would overwrite, use OpResource::get_temp_space instead";
     mshadow::Tensor<mxnet::gpu, 1, char> workspace =
       resource.get_space_typed<mxnet::gpu, 1, char>(mshadow::Shape1(size), gpu_stream);
     return workspace.dptr_;
@@ -289,18 +363,7 @@ void CustomFComputeDispatcher(const std::string op_name,
   rng_gpu_states = pgen_gpu->GetStates();
 #endif
 
-  CHECK((fcomp_fp != nullptr && state_ptr == nullptr)
-        || (fcomp_fp == nullptr && state_ptr != nullptr))
-    << "Can only register either regular op or stateful op for '" << op_name << "'";
-
   if (fcomp_fp != nullptr) {
-    // convert attributes to vector of char*
-    std::vector<const char*> attr_keys, attr_vals;
-    for (auto &kv : attrs->dict) {
-      attr_keys.push_back(kv.first.c_str());
-      attr_vals.push_back(kv.second.c_str());
-    }
-
     // call fcompute function
     int retval = callFComp(fcomp_fp, attr_keys.data(), attr_vals.data(), attr_keys.size(),
                            in_shapes.data(), in_dims.data(), in_data.data(), in_types.data(),
@@ -314,21 +377,15 @@ void CustomFComputeDispatcher(const std::string op_name,
                            out_indptr.data(),
                            in_indices_shapes.data(), out_indices_shapes.data(),
                            in_indptr_shapes.data(), out_indptr_shapes.data(),
-                           rng_cpu_states, rng_gpu_states);
+                           rng_cpu_states, rng_gpu_states,
+                           temp_space.data(), temp_space_sizes.data(), temp_space.size());
     std::string msgs = getExtensionMsgs(msgSize, msgGet);
     CHECK(retval) << "Error calling FCompute for custom operator '" << op_name << "'" << msgs;
   }
 
   if (state_ptr != nullptr) {
-    // retrieve op state object created from CreateOpState
-    CustomStatefulOpWrapper& op = state_ptr->get_state<CustomStatefulOpWrapper>();
-    CustomStatefulOp* state_op_inst = op.get_instance();
-    std::string msgs = getExtensionMsgs(msgSize, msgGet);
-    CHECK(state_op_inst != nullptr)
-      << "Error custom stateful operator is null for operator '" << op_name << "'" << msgs;
-
     // call fcompute function
-    int retval = callFStatefulComp(stateful_forward_flag, state_op_inst,
+    int retval = callFStatefulComp(forward_flag, state_op_inst,
                                    in_shapes.data(), in_dims.data(), in_data.data(),
                                    in_types.data(),
                                    in_verIDs.data(), in_dev_type.data(), in_dev_id.data(),
@@ -343,8 +400,10 @@ void CustomFComputeDispatcher(const std::string op_name,
                                    in_indptr.data(), out_indptr.data(),
                                    in_indices_shapes.data(), out_indices_shapes.data(),
                                    in_indptr_shapes.data(), out_indptr_shapes.data(),
-                                   rng_cpu_states, rng_gpu_states);
-    msgs = getExtensionMsgs(msgSize, msgGet);
+                                   rng_cpu_states, rng_gpu_states,
+                                   temp_space.data(), temp_space_sizes.data(),
+                                   temp_space.size());
+    std::string msgs = getExtensionMsgs(msgSize, msgGet);
     CHECK(retval) << "Error calling FStatefulCompute for custom operator '" << op_name << "'"
                   << msgs;
   }
@@ -354,7 +413,8 @@ template <typename RescReq, typename AttrParser, typename NumInputs, typename Nu
           typename NumInOuts,
           typename InferType, typename InferShape, typename InferSType, typename MutateInputs,
           typename SubgraphNumInputs, typename SubgraphInferType, typename SubgraphInferShape,
-          typename SubgraphInferSType, typename CreateOpState, typename GradReg>
+          typename SubgraphInferSType, typename CreateOpState, typename GradReg,
+          typename InplaceOption>
 void registerOp(const char* name, const std::string& name_str, bool isSubgraphOp,
                 RescReq resc_req, AttrParser attr_parser, NumInputs num_inputs,
                 NumOutputs num_outputs, NumInOuts num_inouts, InferType infer_type,
@@ -362,12 +422,16 @@ void registerOp(const char* name, const std::string& name_str, bool isSubgraphOp
                 MutateInputs mutate_inputs, SubgraphNumInputs num_subgraph_inputs,
                 SubgraphInferType infer_subgraph_type, SubgraphInferShape infer_subgraph_shape,
                 SubgraphInferSType infer_subgraph_storage_type, CreateOpState create_opstate,
-                GradReg grad_reg, mxnet::ext::mutateInputs_t mutate_fp,
+                GradReg grad_reg, InplaceOption inplace_option,
+                mxnet::ext::mutateInputs_t mutate_fp, mxnet::ext::inplaceOption_t inplace_fp,
+                mxnet::ext::tempSpace_t temp_fp,
                 const std::unordered_map<std::string, mxnet::ext::createOpState_t> &createop_map,
                 const std::unordered_map<std::string, mxnet::ext::fcomp_t> &forward_ctx_map,
                 const std::unordered_map<std::string, mxnet::ext::fcomp_t> &backward_ctx_map,
                 mxnet::ext::opCallFComp_t callFComp,
                 mxnet::ext::opCallFStatefulComp_t callFStatefulComp,
+                mxnet::ext::opCallTempSpace_t callTempSpace,
+                mxnet::ext::opCallFree_t callFree,
                 mxnet::ext::msgSize_t msgSize,
                 mxnet::ext::msgGet_t msgGet) {
   using namespace mxnet::ext;
@@ -395,6 +459,9 @@ void registerOp(const char* name, const std::string& name_str, bool isSubgraphOp
     // optionally add fmutate inputs if user specified a function
     if (mutate_fp != nullptr)
       regOp.set_attr<nnvm::FMutateInputs>("FMutateInputs", mutate_inputs, plevel);
+    // optionally let the memory planner share inputs and outputs
+    if (inplace_fp != nullptr)
+      regOp.set_attr<nnvm::FInplaceOption>("FInplaceOption", inplace_option, plevel);
   } else {
     using namespace mxnet::op;
     regOp.set_num_inputs(num_subgraph_inputs);
@@ -415,8 +482,8 @@ void registerOp(const char* name, const std::string& name_str, bool isSubgraphOp
                               const std::vector<OpReqType>& req,
                               const std::vector<NDArray>& outputs) {
       CustomFComputeDispatcher(name_str, nullptr, nullptr, nullptr,
-                               callFStatefulComp, 1, &state_ptr, ctx, inputs, req, outputs,
-                               msgSize, msgGet);
+                               callFStatefulComp, 1, &state_ptr, callTempSpace, nullptr,
+                               callFree, ctx, inputs, req, outputs, msgSize, msgGet);
     };
     if (createop_map.count("cpu") > 0)
       regOp.set_attr<FStatefulComputeEx>("FStatefulComputeEx<cpu>", fstate_forward, plevel);
@@ -432,12 +499,14 @@ void registerOp(const char* name, const std::string& name_str, bool isSubgraphOp
         CHECK_GT(forward_ctx_map.count("cpu"), 0);
         fcomp_t fcomp = forward_ctx_map.at("cpu");
         CustomFComputeDispatcher(name_str, callFComp, fcomp, &attrs,
-                                 nullptr, 0, nullptr, ctx, inputs, req, outputs, msgSize, msgGet);
+                                 nullptr, 1, nullptr, callTempSpace, temp_fp, callFree,
+                                 ctx, inputs, req, outputs, msgSize, msgGet);
       } else if (ctx.run_ctx.ctx.dev_mask() == Context::kGPU) {
         CHECK_GT(forward_ctx_map.count("gpu"), 0);
         fcomp_t fcomp = forward_ctx_map.at("gpu");
         CustomFComputeDispatcher(name_str, callFComp, fcomp, &attrs,
-                                 nullptr, 0, nullptr, ctx, inputs, req, outputs, msgSize, msgGet);
+                                 nullptr, 1, nullptr, callTempSpace, temp_fp, callFree,
+                                 ctx, inputs, req, outputs, msgSize, msgGet);
       }
     };
     if (forward_ctx_map.count("cpu") > 0)
@@ -481,8 +550,8 @@ void registerOp(const char* name, const std::string& name_str, bool isSubgraphOp
                                  const std::vector<OpReqType>& req,
                                  const std::vector<NDArray>& outputs) {
         CustomFComputeDispatcher(name_str, nullptr, nullptr, nullptr,
-                                 callFStatefulComp, 0, &state_ptr, ctx, inputs, req, outputs,
-                                 msgSize, msgGet);
+                                 callFStatefulComp, 0, &state_ptr, callTempSpace, nullptr,
+                                 callFree, ctx, inputs, req, outputs, msgSize, msgGet);
       };
       gradOp.set_attr<FStatefulComputeEx>("FStatefulComputeEx<cpu>", fstate_backward, plevel);
       gradOp.set_attr<FStatefulComputeEx>("FStatefulComputeEx<gpu>", fstate_backward, plevel);
@@ -496,7 +565,8 @@ void registerOp(const char* name, const std::string& name_str, bool isSubgraphOp
                                        const std::vector<OpReqType>& req,
                                        const std::vector<NDArray>& outputs) {
           CustomFComputeDispatcher(name_str, callFComp, fcomp_back_cpu, &attrs,
-                                   nullptr, 0, nullptr, ctx, inputs, req, outputs, msgSize, msgGet);
+                                   nullptr, 0, nullptr, callTempSpace, temp_fp, callFree,
+                                   ctx, inputs, req, outputs, msgSize, msgGet);
         };
         gradOp.set_attr<FComputeEx>("FComputeEx<cpu>", backward_cpu_lambda, plevel);
       }
@@ -508,7 +578,8 @@ void registerOp(const char* name, const std::string& name_str, bool isSubgraphOp
                                        const std::vector<OpReqType>& req,
                                        const std::vector<NDArray>& outputs) {
           CustomFComputeDispatcher(name_str, callFComp, fcomp_back_gpu, &attrs,
-                                   nullptr, 0, nullptr, ctx, inputs, req, outputs, msgSize, msgGet);
+                                   nullptr, 0, nullptr, callTempSpace, temp_fp, callFree,
+                                   ctx, inputs, req, outputs, msgSize, msgGet);
         };
         gradOp.set_attr<FComputeEx>("FComputeEx<gpu>", backward_gpu_lambda, plevel);
       }
@@ -548,6 +619,12 @@ void registerOperators(void *lib, int verbose, mxnet::ext::msgSize_t msgSize,
   opCallFStatefulComp_t callFStatefulComp =
     get_func<opCallFStatefulComp_t>(lib, const_cast<char*>(MXLIB_OPCALLFSTATEFULCOMP_STR));
 
+  opCallInplaceOption_t callInplaceOption =
+    get_func<opCallInplaceOption_t>(lib, const_cast<char*>(MXLIB_OPCALLINPLACEOPTION_STR));
+
+  opCallTempSpace_t callTempSpace =
+    get_func<opCallTempSpace_t>(lib, const_cast<char*>(MXLIB_OPCALLTEMPSPACE_STR));
+
   // get number of operators registered in the library
   opRegSize_t opRegSize = get_func<opRegSize_t>(lib, const_cast<char*>(MXLIB_OPREGSIZE_STR));
   int numOps = opRegSize();
@@ -567,8 +644,12 @@ void registerOperators(void *lib, int verbose, mxnet::ext::msgSize_t msgSize,
     inferShape_t shape_fp = nullptr;
     // optional attributes
     mutateInputs_t mutate_fp = nullptr;
+    inplaceOption_t inplace_fp = nullptr;
+    tempSpace_t temp_fp = nullptr;
     bool isSubgraphOp = false;
     int _isSubgraphOp = 0;
+    bool reuse_state = false;
+    int _reuse_state = 0;
     // lists of forward and backward function associated with each context
     const char **forward_ctx, **backward_ctx, **createop_ctx;
     fcomp_t *forward_fcomp, *backward_fcomp;
@@ -580,7 +661,8 @@ void registerOperators(void *lib, int verbose, mxnet::ext::msgSize_t msgSize,
              &forward_ctx, &forward_fcomp, &forward_count,
              &backward_ctx, &backward_fcomp, &backward_count,
              &createop_ctx, &createop_fp, &createop_count,
-             &parse_fp, &type_fp, &stype_fp, &shape_fp, &mutate_fp);
+             &parse_fp, &type_fp, &stype_fp, &shape_fp, &mutate_fp,
+             &inplace_fp, &temp_fp, &_reuse_state);
 
     // construct maps of context to forward/backward custom library function
     std::unordered_map<std::string, fcomp_t> forward_ctx_map;
@@ -600,6 +682,7 @@ void registerOperators(void *lib, int verbose, mxnet::ext::msgSize_t msgSize,
     }
     // set bool, dont pass bool across ABI boundary
     isSubgraphOp = _isSubgraphOp;
+    reuse_state = _reuse_state;
 
     // validate custom operator functions from the dynamic library
     if (!isSubgraphOp) {
@@ -965,6 +1048,34 @@ void registerOperators(void *lib, int verbose, mxnet::ext::msgSize_t msgSize,
       return mutate_indices_list;
     };
 
+    // lambda function to convert from external inplace options to internal MXNet types
+    auto inplace_option = [=](const nnvm::NodeAttrs& attrs) {
+      // convert attributes to vector of char*
+      std::vector<const char*> attr_keys, attr_vals;
+      for (auto &kv : attrs.dict) {
+        attr_keys.push_back(kv.first.c_str());
+        attr_vals.push_back(kv.second.c_str());
+      }
+
+      // C type placeholder for flattened (input, output) pairs
+      int* inplace_pairs = nullptr;
+      int num_pairs = 0;
+
+      int retval = callInplaceOption(inplace_fp, attr_keys.data(), attr_vals.data(),
+                                     attr_keys.size(), &inplace_pairs, &num_pairs);
+      std::string msgs = getExtensionMsgs(msgSize, msgGet);
+      CHECK(retval) << "Error calling InplaceOption for custom operator '" << name_str << "'"
+      << msgs;
+
+      std::vector<std::pair<int, int> > pairs(num_pairs);
+      for (int i = 0; i < num_pairs; i++) {
+        pairs[i] = std::make_pair(inplace_pairs[2 * i], inplace_pairs[2 * i + 1]);
+      }
+      callFree(inplace_pairs);
+
+      return pairs;
+    };
+
     // lambda function to set storage types
     auto infer_storage_type = [=](const nnvm::NodeAttrs& attrs,
                                 const int dev_mask,
@@ -1103,6 +1214,23 @@ void registerOperators(void *lib, int verbose, mxnet::ext::msgSize_t msgSize,
         attr_vals.push_back(subgraph_json.c_str());
       }
 
+      // states of ops marked reusable are shared by the calls with the same attributes,
+      // context, shapes and types, as the states of a CachedOp with static_alloc are
+      static thread_local std::unordered_map<std::string, OpStatePtr> reused_states;
+      std::string state_key;
+      if (reuse_state) {
+        std::ostringstream os;
+        os << name_str << ';' << ctx.dev_type << ';' << ctx.dev_id << ';';
+        std::map<std::string, std::string> sorted_attrs(attrs.dict.begin(), attrs.dict.end());
+        for (auto &kv : sorted_attrs) os << kv.first << '=' << kv.second << ';';
+        for (const TShape &shape : in_shapes) os << shape;
+        for (int type : in_types) os << ';' << type;
+        os << ';' << subgraph_json;
+        state_key = os.str();
+        auto it = reused_states.find(state_key);
+        if (it != reused_states.end()) return it->second;
+      }
+
       // create a pointer to hold custom op state object
       // only create one stateful op depending on passing context
       // user can add new supported context and call to custom library
@@ -1130,7 +1258,13 @@ void registerOperators(void *lib, int verbose, mxnet::ext::msgSize_t msgSize,
       << "Error custom library failed to create stateful operator '" << name_str << "'" << msgs;
 
       CustomStatefulOp* state_op = reinterpret_cast<CustomStatefulOp*>(state_op_inst);
-      return OpStatePtr::Create<CustomStatefulOpWrapper>(state_op);
+      OpStatePtr state = OpStatePtr::Create<CustomStatefulOpWrapper>(state_op);
+      if (reuse_state) {
+        // bound the states kept alive for shapes that are not seen anymore
+        if (reused_states.size() >= 64) reused_states.clear();
+        reused_states[state_key] = state;
+      }
+      return state;
     };
 
     /* -------------- BELOW IS THE REGISTRATION FOR CUSTOM OPERATORS --------------- */
@@ -1138,9 +1272,9 @@ void registerOperators(void *lib, int verbose, mxnet::ext::msgSize_t msgSize,
     registerOp(name, name_str, isSubgraphOp, resc_req, attr_parser, num_inputs, num_outputs,
                num_inouts, infer_type, infer_shape, infer_storage_type, mutate_inputs,
                num_subgraph_inputs, infer_subgraph_type, infer_subgraph_shape,
-               infer_subgraph_storage_type, create_opstate, grad_reg, mutate_fp,
-               createop_map, forward_ctx_map, backward_ctx_map, callFComp, callFStatefulComp,
-               msgSize, msgGet);
+               infer_subgraph_storage_type, create_opstate, grad_reg, inplace_option, mutate_fp,
+               inplace_fp, temp_fp, createop_map, forward_ctx_map, backward_ctx_map, callFComp,
+               callFStatefulComp, callTempSpace, callFree, msgSize, msgGet);
   }
 }
 
@@ -1229,6 +1363,126 @@ void registerPartitioners(void *lib, int verbose, mxnet::ext::msgSize_t msgSize,
   }
 }
 
+/*!
+ * \brief Calls a custom graph pass on a graph planned by MXPlanMemory
+ * The storage ids and inplace indices of the outputs of the planned nodes are passed as node
+ * attributes, along with their shapes and dtypes, and are read back from the returned graph
+ */
+nnvm::Graph callPlanMemoryPass(nnvm::Graph&& g, const std::string& pass_name,
+                               mxnet::ext::graphPass_t pass_fp,
+                               mxnet::ext::passCallGraphPass_t callGraphPass,
+                               mxnet::ext::opCallFree_t callFree,
+                               mxnet::ext::msgSize_t msgSize,
+                               mxnet::ext::msgGet_t msgGet) {
+  using namespace mxnet::ext;
+  const nnvm::IndexedGraph& idx = g.indexed_graph();
+  const auto& storage_ids = g.GetAttr<nnvm::StorageVector>("storage_id");
+  const auto& storage_inplace = g.GetAttr<std::vector<int> >("storage_inplace_index");
+  const auto& shapes = g.GetAttr<mxnet::ShapeVector>("shape");
+  const auto& dtypes = g.GetAttr<nnvm::DTypeVector>("dtype");
+  std::pair<uint32_t, uint32_t> node_range(0, idx.num_nodes());
+  if (g.HasAttr("node_range"))
+    node_range = g.GetAttr<std::pair<uint32_t, uint32_t> >("node_range");
+
+  // set the planning attrs for each planned node, as lists over its outputs
+  auto output_list = [&](uint32_t nid, auto value) {
+    std::stringstream ss;
+    ss << "[";
+    for (uint32_t oid = 0; oid < idx[nid].source->num_outputs(); oid++) {
+      if (oid > 0) ss << ",";
+      ss << value(idx.entry_id(nid, oid));
+    }
+    ss << "]";
+    return ss.str();
+  };
+  for (uint32_t nid = node_range.first; nid < node_range.second; nid++) {
+    nnvm::Node* node = const_cast<nnvm::Node*>(idx[nid].source);
+    node->attrs.dict[MX_STR_STORAGE_ID] =
+      output_list(nid, [&](uint32_t eid) { return storage_ids[eid]; });
+    node->attrs.dict[MX_STR_INPLACE_INDEX] =
+      output_list(nid, [&](uint32_t eid) { return storage_inplace[eid]; });
+    node->attrs.dict[MX_STR_SHAPE] = output_list(nid, [&](uint32_t eid) { return shapes[eid]; });
+    node->attrs.dict[MX_STR_DTYPE] = output_list(nid, [&](uint32_t eid) { return dtypes[eid]; });
+  }
+  // the graph attributes are not serialized
+  nnvm::Graph json_graph;
+  json_graph.outputs = g.outputs;
+  std::string in_json = nnvm::pass::SaveJSON(json_graph);
+  for (uint32_t nid = node_range.first; nid < node_range.second; nid++) {
+    auto& dict = const_cast<nnvm::Node*>(idx[nid].source)->attrs.dict;
+    for (const char* key : {MX_STR_STORAGE_ID, MX_STR_INPLACE_INDEX, MX_STR_SHAPE, MX_STR_DTYPE})
+      dict.erase(key);
+  }
+
+  // the planned graph has no args or aux to replace
+  auto ndarray_malloc = [](const void*, const int64_t*, int, const char*, int, int, const char*,
+                           int, void**) {
+    LOG(FATAL) << "Graph passes run after memory planning cannot allocate args or aux";
+  };
+  char* out_json;
+  int retval = callGraphPass(pass_fp, in_json.c_str(), &out_json, nullptr, nullptr, 0,
+                             pass_name.c_str(), nullptr, 0, nullptr, nullptr, nullptr, nullptr,
+                             nullptr, nullptr, nullptr, nullptr, 0, nullptr, nullptr, nullptr,
+                             nullptr, nullptr, nullptr, nullptr, ndarray_malloc, nullptr);
+  std::string msgs = getExtensionMsgs(msgSize, msgGet);
+  CHECK(retval) << "Error calling graph pass for '" << pass_name << "'" << msgs;
+  nnvm::Graph out_graph = nnvm::pass::LoadJSON(std::string(out_json));
+  callFree(out_json);
+
+  // the graph cannot change once planned, its nodes are found back by name
+  std::unordered_map<std::string, const nnvm::Node*> out_nodes;
+  nnvm::DFSVisit(out_graph.outputs, [&](const nnvm::ObjectPtr& n) {
+    CHECK(out_nodes.emplace(n->attrs.name, n.get()).second)
+      << "Graph pass '" << pass_name << "' run after memory planning needs unique node names, "
+      << n->attrs.name << " is repeated";
+  });
+  CHECK_EQ(out_nodes.size(), idx.num_nodes())
+    << "Graph pass '" << pass_name << "' run after memory planning changed the graph";
+  auto parse_list = [](const std::string& str) {
+    std::vector<int> ret;
+    std::istringstream is(str.substr(1, str.size() - 2));
+    std::string value;
+    while (std::getline(is, value, ',')) ret.push_back(std::stoi(value));
+    return ret;
+  };
+  nnvm::StorageVector new_ids = storage_ids;
+  std::vector<int> new_inplace = storage_inplace;
+  for (uint32_t nid = node_range.first; nid < node_range.second; nid++) {
+    const nnvm::Node* node = idx[nid].source;
+    auto it = out_nodes.find(node->attrs.name);
+    CHECK(it != out_nodes.end())
+      << "Graph pass '" << pass_name << "' run after memory planning removed the node "
+      << node->attrs.name;
+    const auto& dict = it->second->attrs.dict;
+    if (!dict.count(MX_STR_STORAGE_ID) || !dict.count(MX_STR_INPLACE_INDEX)) continue;
+    std::vector<int> ids = parse_list(dict.at(MX_STR_STORAGE_ID));
+    std::vector<int> inplace = parse_list(dict.at(MX_STR_INPLACE_INDEX));
+    CHECK(ids.size() == node->num_outputs() && inplace.size() == node->num_outputs())
+      << "Graph pass '" << pass_name << "' returned " << ids.size() << " storage ids and "
+      << inplace.size() << " inplace indices for the " << node->num_outputs()
+      << " outputs of " << node->attrs.name;
+    for (uint32_t oid = 0; oid < node->num_outputs(); oid++) {
+      const uint32_t eid = idx.entry_id(nid, oid);
+      // external and dynamic storages are not planned, and cannot become planned
+      CHECK(ids[oid] == storage_ids[eid] || (ids[oid] >= 0 && storage_ids[eid] >= 0))
+        << "Graph pass '" << pass_name << "' changed the storage id " << storage_ids[eid]
+        << " of output " << oid << " of " << node->attrs.name << " to " << ids[oid];
+      if (inplace[oid] >= 0) {
+        CHECK_LT(static_cast<size_t>(inplace[oid]), idx[nid].inputs.size());
+        const uint32_t in_eid = idx.entry_id(idx[nid].inputs[inplace[oid]]);
+        CHECK_EQ(new_ids[in_eid], ids[oid])
+          << "Graph pass '" << pass_name << "' writes output " << oid << " of "
+          << node->attrs.name << " inplace over an input of another storage";
+      }
+      new_ids[eid] = ids[oid];
+      new_inplace[eid] = inplace[oid];
+    }
+  }
+  g.attrs["storage_id"] = std::make_shared<nnvm::any>(std::move(new_ids));
+  g.attrs["storage_inplace_index"] = std::make_shared<nnvm::any>(std::move(new_inplace));
+  return std::move(g);
+}
+
 void registerPasses(void *lib, int verbose, mxnet::ext::msgSize_t msgSize,
                        mxnet::ext::msgGet_t msgGet) {
   using namespace mxnet::ext;
@@ -1260,7 +1514,13 @@ void registerPasses(void *lib, int verbose, mxnet::ext::msgSize_t msgSize,
 
     if (verbose) LOG(INFO) << "\tGraph Pass [" << i << "] " << name;
 
+    std::string name_str(name);
     auto pass_lambda = [=] (nnvm::Graph&& g) {
+      // passes named by MXNET_PLAN_MEMORY_PASSES are applied to planned graphs
+      if (g.HasAttr("storage_id")) {
+        return callPlanMemoryPass(std::move(g), name_str, pass_fp, callGraphPass, callFree,
+                                  msgSize, msgGet);
+      }
       // get pass name
       const char* pass_name = g.GetAttr<const char*>("pass_name");
       // get options
@@ -1550,6 +1810,31 @@ int MXEngineSetBulkSize(int bulk_size, int* prev_bulk_size) {
   API_END();
 }
 
+int MXEngineSetPushPriority(int priority, int* prev_priority) {
+  API_BEGIN();
+  *prev_priority = Engine::Get()->set_push_priority(priority);
+  API_END();
+}
+
+int MXEngineSetWaitTag(int tag, int* prev_tag) {
+  API_BEGIN();
+  *prev_tag = Engine::Get()->set_wait_tag(tag);
+  API_END();
+}
+
+int MXEngineWaitForTag(int tag) {
+  API_BEGIN();
+  Engine::Get()->WaitForTag(tag);
+  API_END();
+}
+
+int MXEngineWaitForContext(int dev_type, int dev_id) {
+  API_BEGIN();
+  Engine::Get()->WaitForContext(Context::Create(static_cast<Context::DeviceType>(dev_type),
+                                                dev_id));
+  API_END();
+}
+
 int MXGetGPUCount(int* out) {
   API_BEGIN();
   *out = Context::GetGPUCount();
@@ -1573,6 +1858,26 @@ int MXGetGPUMemoryInformation64(int dev, uint64_t *free_mem, uint64_t *total_mem
   API_END();
 }
 
+int MXNCCLGetUniqueId(const char **out) {
+  MXAPIThreadLocalEntry<> *ret = MXAPIThreadLocalStore<>::Get();
+  API_BEGIN();
+#if MXNET_USE_NCCL
+  ncclUniqueId id;
+  CHECK_EQ(ncclGetUniqueId(&id), ncclSuccess) << "Failed to create a NCCL id";
+  static const char digits[] = "0123456789abcdef";
+  ret->ret_str.resize(0);
+  for (size_t i = 0; i < sizeof(id.internal); ++i) {
+    const unsigned char c = static_cast<unsigned char>(id.internal[i]);
+    ret->ret_str.push_back(digits[c >> 4]);
+    ret->ret_str.push_back(digits[c & 15]);
+  }
+  *out = ret->ret_str.c_str();
+#else
+  LOG(FATAL) << "Compile with USE_NCCL=1 to create NCCL ids";
+#endif
+  API_END();
+}
+
 int MXGetVersion(int *out) {
   API_BEGIN();
   *out = static_cast<int>(MXNET_VERSION);
@@ -1788,6 +2093,74 @@ int MXNDArraySyncCopyToCPU(NDArrayHandle handle,
   API_END();
 }
 
+/*! \brief the completion event of an asynchronous copy, shared with its engine operator */
+struct NDArrayCopyEvent {
+  std::mutex mutex;
+  std::condition_variable cond;
+  bool done{false};
+  bool copied{false};
+
+  void Complete(bool success) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      done = true;
+      copied = success;
+    }
+    cond.notify_all();
+  }
+};
+
+int MXNDArrayCopyToCPUAsync(NDArrayHandle handle,
+                            void *data,
+                            size_t size,
+                            NDArrayCopyEventHandle *event) {
+  API_BEGIN();
+  auto ret = std::make_shared<NDArrayCopyEvent>();
+  static_cast<NDArray*>(handle)->AsyncCopyToCPU(data, size, [ret](bool copied) {
+    ret->Complete(copied);
+  });
+  *event = new std::shared_ptr<NDArrayCopyEvent>(ret);
+  API_END();
+}
+
+int MXNDArrayCopyToCPUAsyncCallback(NDArrayHandle handle,
+                                    void *data,
+                                    size_t size,
+                                    NDArrayCopyCallback callback,
+                                    void *callback_arg) {
+  API_BEGIN();
+  CHECK(callback != nullptr) << "the callback of the copy is null";
+  static_cast<NDArray*>(handle)->AsyncCopyToCPU(data, size,
+      [callback, callback_arg](bool copied) {
+    callback(copied ? 0 : -1, callback_arg);
+  });
+  API_END();
+}
+
+int MXNDArrayCopyEventPoll(NDArrayCopyEventHandle event, int *done) {
+  API_BEGIN();
+  NDArrayCopyEvent *ev = static_cast<std::shared_ptr<NDArrayCopyEvent>*>(event)->get();
+  std::lock_guard<std::mutex> lock(ev->mutex);
+  *done = ev->done;
+  API_END();
+}
+
+int MXNDArrayCopyEventWait(NDArrayCopyEventHandle event) {
+  API_BEGIN();
+  NDArrayCopyEvent *ev = static_cast<std::shared_ptr<NDArrayCopyEvent>*>(event)->get();
+  std::unique_lock<std::mutex> lock(ev->mutex);
+  ev->cond.wait(lock, [ev]() { return ev->done; });
+  CHECK(ev->copied) << "the NDArray copied was written by a failed operator, "
+                       "MXNDArrayWaitToRead returns its error";
+  API_END();
+}
+
+int MXNDArrayCopyEventFree(NDArrayCopyEventHandle event) {
+  API_BEGIN();
+  delete static_cast<std::shared_ptr<NDArrayCopyEvent>*>(event);
+  API_END();
+}
+
 /*!
  * \brief Copy src.data() to dst.data() if i = -1, else dst.aux_data(i) if i >= 0
  * This function blocks. Do not use it in performance critical code.
@@ -1853,20 +2226,74 @@ int MXNDArraySave(const char* fname,
   API_END();
 }
 
+int MXNDArraySaveMapped(const char* fname,
+                        uint32_t num_args,
+                        NDArrayHandle* args,
+                        const char** keys) {
+  API_BEGIN();
+  std::vector<NDArray> data(num_args);
+  std::vector<std::string> names;
+  for (uint32_t i = 0; i < num_args; ++i) {
+    data[i] = *static_cast<NDArray*>(args[i]);
+  }
+  if (keys != nullptr) {
+    names.resize(num_args);
+    for (uint32_t i = 0; i < num_args; ++i) {
+      names[i] = keys[i];
+    }
+  }
+  {
+    std::unique_ptr<dmlc::Stream> fo(dmlc::Stream::Create(fname, "w"));
+    mxnet::NDArray::SaveMapped(fo.get(), data, names);
+  }
+  API_END();
+}
+
+/*!
+ * \brief load the ndarrays named keys, or all of them when keys is empty, mapping the local
+ *  files of the mapped format instead of reading them
+ */
+static void LoadNDArrays(const char* fname, const std::vector<std::string>& keys,
+                         std::vector<NDArray>* data, std::vector<std::string>* names) {
+  if (mxnet::NDArray::LoadMapped(fname, keys, data, names)) return;
+  {
+    std::unique_ptr<dmlc::Stream> fi(dmlc::Stream::Create(fname, "r"));
+    mxnet::NDArray::Load(fi.get(), data, names);
+  }
+  if (keys.empty()) return;
+  CHECK(!names->empty()) << "the NDArrays of " << fname << " were saved without names";
+  std::unordered_map<std::string, NDArray> arrays;
+  for (size_t i = 0; i < names->size(); ++i) arrays[(*names)[i]] = (*data)[i];
+  data->clear();
+  for (const std::string& key : keys) {
+    auto it = arrays.find(key);
+    CHECK(it != arrays.end()) << "no NDArray named " << key << " in " << fname;
+    data->push_back(it->second);
+  }
+  *names = keys;
+}
+
 int MXNDArrayLoad(const char* fname,
                   uint32_t *out_size,
                   NDArrayHandle** out_arr,
                   uint32_t *out_name_size,
                   const char*** out_names) {
+  return MXNDArrayLoadKeys(fname, 0, nullptr, out_size, out_arr, out_name_size, out_names);
+}
+
+int MXNDArrayLoadKeys(const char* fname,
+                      uint32_t num_keys,
+                      const char** keys,
+                      uint32_t *out_size,
+                      NDArrayHandle** out_arr,
+                      uint32_t *out_name_size,
+                      const char*** out_names) {
   MXAPIThreadLocalEntry<> *ret = MXAPIThreadLocalStore<>::Get();
   ret->ret_vec_str.clear();
   API_BEGIN();
   std::vector<NDArray> data;
   std::vector<std::string> &names = ret->ret_vec_str;
-  {
-    std::unique_ptr<dmlc::Stream> fi(dmlc::Stream::Create(fname, "r"));
-    mxnet::NDArray::Load(fi.get(), &data, &names);
-  }
+  LoadNDArrays(fname, std::vector<std::string>(keys, keys + num_keys), &data, &names);
   ret->ret_handles.resize(data.size());
   for (size_t i = 0; i < data.size(); ++i) {
     NDArray *ptr = new NDArray();
@@ -1884,6 +2311,54 @@ int MXNDArrayLoad(const char* fname,
   API_END();
 }
 
+int MXNDArraySaveShardedAsync(const char* prefix,
+                              uint32_t num_args,
+                              NDArrayHandle* args,
+                              const char** keys,
+                              uint32_t num_shards) {
+  API_BEGIN();
+  CHECK(keys != nullptr) << "the ndarrays of a sharded checkpoint need names";
+  std::vector<NDArray> data(num_args);
+  std::vector<std::string> names(num_args);
+  for (uint32_t i = 0; i < num_args; ++i) {
+    data[i] = *static_cast<NDArray*>(args[i]);
+    names[i] = keys[i];
+  }
+  mxnet::ndarray::SaveShardedAsync(prefix, data, names, num_shards);
+  API_END();
+}
+
+int MXNDArrayWaitForCheckpoint() {
+  API_BEGIN();
+  mxnet::ndarray::WaitForCheckpoint();
+  API_END();
+}
+
+int MXNDArrayLoadSharded(const char* prefix,
+                         uint32_t num_shards,
+                         uint32_t *out_size,
+                         NDArrayHandle** out_arr,
+                         const char*** out_names) {
+  MXAPIThreadLocalEntry<> *ret = MXAPIThreadLocalStore<>::Get();
+  ret->ret_vec_str.clear();
+  API_BEGIN();
+  std::vector<NDArray> data;
+  std::vector<std::string> &names = ret->ret_vec_str;
+  mxnet::ndarray::LoadSharded(prefix, num_shards, &data, &names);
+  ret->ret_handles.resize(data.size());
+  for (size_t i = 0; i < data.size(); ++i) {
+    ret->ret_handles[i] = new NDArray(data[i]);
+  }
+  ret->ret_vec_charp.resize(names.size());
+  for (size_t i = 0; i < names.size(); ++i) {
+    ret->ret_vec_charp[i] = names[i].c_str();
+  }
+  *out_size = static_cast<uint32_t>(data.size());
+  *out_arr = dmlc::BeginPtr(ret->ret_handles);
+  *out_names = dmlc::BeginPtr(ret->ret_vec_charp);
+  API_END();
+}
+
 int MXNDArrayLoadFromBuffer(const void *ndarray_buffer,
                             size_t size,
                             uint32_t *out_size,
@@ -2127,6 +2602,22 @@ int MXNDArrayFromDLPack(DLManagedTensorHandle dlpack,
   API_END();
 }
 
+int MXNDArrayCreateFromBuffer(void *data, const int64_t *shape, int ndim,
+                              int dtype, int dev_type, int dev_id,
+                              EngineVarHandle var, EngineFuncParamDeleter deleter,
+                              void *deleter_param, NDArrayHandle *out) {
+  API_BEGIN();
+  CHECK(data != nullptr) << "MXNDArrayCreateFromBuffer needs a buffer";
+  const int dev_mask = dev_type == Context::kGPU ? gpu::kDevMask : cpu::kDevMask;
+  TBlob blob(data, mxnet::TShape(shape, shape + ndim), dev_mask, dtype, dev_id);
+  std::function<void()> release;
+  if (deleter != nullptr) {
+    release = [deleter, deleter_param]() { deleter(deleter_param); };
+  }
+  *out = new NDArray(blob, dev_id, static_cast<Engine::VarHandle>(var), release);
+  API_END();
+}
+
 int MXNDArrayCallDLPackDeleter(DLManagedTensorHandle dlpack) {
   API_BEGIN();
   if (dlpack != nullptr) {
@@ -2136,6 +2627,18 @@ int MXNDArrayCallDLPackDeleter(DLManagedTensorHandle dlpack) {
   API_END();
 }
 
+int MXNDArraySyncToStream(NDArrayHandle handle, void *stream, int write) {
+  API_BEGIN();
+  static_cast<NDArray*>(handle)->SyncToStream(stream, write != 0);
+  API_END();
+}
+
+int MXNDArraySyncFromStream(NDArrayHandle handle, void *stream) {
+  API_BEGIN();
+  static_cast<NDArray*>(handle)->SyncFromStream(stream);
+  API_END();
+}
+
 int MXNDArrayGetDType(NDArrayHandle handle,
                      int *out_dtype) {
   API_BEGIN();
@@ -3197,6 +3700,12 @@ int MXCustomOpRegister(const char* op_type, CustomOpPropCreator creator) {
   API_END();
 }
 
+int MXCustomOpRegisterNative(const char* op_type, CustomOpPropCreator creator) {
+  API_BEGIN();
+  mxnet::op::custom::CustomOperator::Get()->Register(op_type, creator, true);
+  API_END();
+}
+
 
 int MXRtcCudaModuleCreate(const char* source, int num_options,
                           const char** options, int num_exports,
@@ -3282,6 +3791,18 @@ int MXRtcCudaKernelCall(CudaKernelHandle handle, int dev_id, void** args,
 }
 
 int MXNDArrayGetSharedMemHandle(NDArrayHandle handle, int* shared_pid, int* shared_id) {
+  int64_t shared_offset = -1;
+  if (MXNDArrayGetSharedMemHandleEx(handle, shared_pid, shared_id, &shared_offset) != 0) {
+    return -1;
+  }
+  API_BEGIN();
+  CHECK_EQ(shared_offset, -1) << "NDArray is in pooled shared memory, "
+                              << "use MXNDArrayGetSharedMemHandleEx to get its offset";
+  API_END();
+}
+
+int MXNDArrayGetSharedMemHandleEx(NDArrayHandle handle, int* shared_pid, int* shared_id,
+                                  int64_t* shared_offset) {
   API_BEGIN();
   NDArray* arr = reinterpret_cast<NDArray*>(handle);
   Storage::Handle shandle;
@@ -3298,13 +3819,47 @@ int MXNDArrayGetSharedMemHandle(NDArrayHandle handle, int* shared_pid, int* shar
   }
   *shared_pid = shandle.shared_pid;
   *shared_id = shandle.shared_id;
+  *shared_offset = shandle.shared_offset;
   API_END();
 }
 
 int MXNDArrayCreateFromSharedMem(int shared_pid, int shared_id, const int *shape,
                                  int ndim, int dtype, NDArrayHandle *out) {
+  return MXNDArrayCreateFromSharedMemEx(shared_pid, shared_id, -1, shape, ndim, dtype, out);
+}
+
+int MXNDArrayCreateFromSharedMemEx(int shared_pid, int shared_id, int64_t shared_offset,
+                                   const int *shape, int ndim, int dtype, NDArrayHandle *out) {
   API_BEGIN();
-  NDArray* nd = new NDArray(shared_pid, shared_id, mxnet::TShape(shape, shape + ndim), dtype);
+  NDArray* nd = new NDArray(shared_pid, shared_id, mxnet::TShape(shape, shape + ndim), dtype,
+                            shared_offset);
+  nd->AssignStorageInfo(profiler::ProfilerScope::Get()->GetCurrentProfilerScope(),
+                        MXNET_STORAGE_DEFAULT_NAME_CSTR);
+  *out = nd;
+  API_END();
+}
+
+int MXNDArrayGetGPUSharedMemHandle(NDArrayHandle handle, char* ipc_handle,
+                                   int64_t* shared_offset) {
+  API_BEGIN();
+  NDArray* arr = reinterpret_cast<NDArray*>(handle);
+  CHECK_EQ(arr->ctx().dev_type, Context::kGPU) << "Only NDArrays on GPU share CUDA IPC handles";
+  CHECK_EQ(arr->storage_type(), kDefaultStorage)
+      << "Only NDArrays of default storage share CUDA IPC handles";
+  arr->WaitToRead();
+  Storage::Handle shandle = arr->storage_handle();
+  Storage::Get()->GetGPUSharedHandle(&shandle);
+  CHECK_EQ(shandle.ipc_handle.size(), MXNET_GPU_IPC_HANDLE_SIZE);
+  std::copy(shandle.ipc_handle.begin(), shandle.ipc_handle.end(), ipc_handle);
+  *shared_offset = shandle.shared_offset + static_cast<int64_t>(arr->byte_offset());
+  API_END();
+}
+
+int MXNDArrayCreateFromGPUSharedMem(const char* ipc_handle, int64_t shared_offset, int dev_id,
+                                    const int *shape, int ndim, int dtype, NDArrayHandle *out) {
+  API_BEGIN();
+  NDArray* nd = new NDArray(std::string(ipc_handle, MXNET_GPU_IPC_HANDLE_SIZE), shared_offset,
+                            dev_id, mxnet::TShape(shape, shape + ndim), dtype);
   nd->AssignStorageInfo(profiler::ProfilerScope::Get()->GetCurrentProfilerScope(),
                         MXNET_STORAGE_DEFAULT_NAME_CSTR);
   *out = nd;
@@ -3439,6 +3994,19 @@ int MXEnginePushSyncND(EngineSyncFunc sync_func, void* func_param,
   API_END();
 }
 
+int MXEngineNewVar(EngineVarHandle *out) {
+  API_BEGIN();
+  *out = Engine::Get()->NewVariable();
+  API_END();
+}
+
+int MXEngineDeleteVar(EngineVarHandle var) {
+  API_BEGIN();
+  Engine::Get()->DeleteVariable([](RunContext s) {}, Context::CPU(),
+                                static_cast<Engine::VarHandle>(var));
+  API_END();
+}
+
 int MXStorageEmptyCache(int dev_type, int dev_id) {
   API_BEGIN();
   Context ctx = Context::Create(static_cast<Context::DeviceType>(dev_type), dev_id);
@@ -3446,6 +4014,37 @@ int MXStorageEmptyCache(int dev_type, int dev_id) {
   API_END();
 }
 
+int MXStorageGetStats(int dev_type, int dev_id, uint64_t *bytes_in_use,
+                      uint64_t *bytes_cached, uint64_t *peak_bytes_in_use,
+                      uint64_t *num_allocs, uint64_t *num_pool_hits,
+                      uint64_t *largest_free_chunk, int *num_free_chunk_sizes,
+                      const uint64_t **free_chunk_sizes,
+                      const uint64_t **free_chunk_counts) {
+  API_BEGIN();
+  Context ctx = Context::Create(static_cast<Context::DeviceType>(dev_type), dev_id);
+  Storage::Stats stats;
+  CHECK(Storage::Get()->GetStats(ctx, &stats))
+      << "The memory pool of " << ctx << " keeps no statistics";
+  *bytes_in_use = stats.bytes_in_use;
+  *bytes_cached = stats.bytes_cached;
+  *peak_bytes_in_use = stats.peak_bytes_in_use;
+  *num_allocs = stats.num_allocs;
+  *num_pool_hits = stats.num_pool_hits;
+  *largest_free_chunk = stats.largest_free_chunk;
+  // sizes first, then counts
+  const size_t n = stats.free_chunks.size();
+  std::vector<uint64_t> &ret = MXAPIThreadLocalStore<>::Get()->ret_vec_uint64;
+  ret.resize(2 * n);
+  for (size_t i = 0; i < n; ++i) {
+    ret[i] = stats.free_chunks[i].first;
+    ret[n + i] = stats.free_chunks[i].second;
+  }
+  *num_free_chunk_sizes = static_cast<int>(n);
+  *free_chunk_sizes = ret.data();
+  *free_chunk_counts = ret.data() + n;
+  API_END();
+}
+
 int MXShallowCopyNDArray(NDArrayHandle src_handle, NDArrayHandle* out) {
   NDArray* ret = nullptr;
   API_BEGIN();
@@ -38,6 +38,7 @@
 #include "../imperative/imperative_utils.h"
 #include "../imperative/cached_op.h"
 #include "../imperative/cached_op_threadsafe.h"
+#include "../imperative/batching_executor.h"
 #include "../profiler/profiler.h"
 
 using namespace mxnet;
@@ -258,6 +259,53 @@ int MXInvokeCachedOp(CachedOpHandle handle,
   API_END();
 }
 
+int MXBatchingExecutorCreate(CachedOpHandle handle,
+                             int num_batch_inputs,
+                             const uint32_t *batch_inputs,
+                             uint32_t max_batch_size,
+                             uint32_t max_delay_us,
+                             int dev_type,
+                             int dev_id,
+                             BatchingExecutorHandle *out) {
+  API_BEGIN();
+  CachedOpPtr op = *static_cast<CachedOpPtr*>(handle);
+  Context ctx = Context::Create(static_cast<Context::DeviceType>(dev_type), dev_id);
+  std::vector<uint32_t> batch(batch_inputs, batch_inputs + num_batch_inputs);
+  *out = new BatchingExecutor(op, ctx, std::move(batch), max_batch_size,
+                              std::chrono::microseconds(max_delay_us));
+  API_END();
+}
+
+int MXBatchingExecutorInfer(BatchingExecutorHandle handle,
+                            int num_inputs,
+                            NDArrayHandle *inputs,
+                            int *num_outputs,
+                            NDArrayHandle **outputs) {
+  MXAPIThreadLocalEntry<> *ret = MXAPIThreadLocalStore<>::Get();
+  API_BEGIN();
+  BatchingExecutor* exec = static_cast<BatchingExecutor*>(handle);
+  std::vector<NDArray> ndinputs;
+  ndinputs.reserve(num_inputs);
+  for (int i = 0; i < num_inputs; ++i) {
+    ndinputs.push_back(*reinterpret_cast<NDArray*>(inputs[i]));
+  }
+  std::vector<NDArray> ndoutputs = exec->Submit(std::move(ndinputs)).get();
+  *num_outputs = ndoutputs.size();
+  ret->ret_handles.clear();
+  ret->ret_handles.reserve(*num_outputs);
+  for (const NDArray& out : ndoutputs) {
+    ret->ret_handles.push_back(new NDArray(out));
+  }
+  *outputs = dmlc::BeginPtr(ret->ret_handles);
+  API_END();
+}
+
+int MXBatchingExecutorFree(BatchingExecutorHandle handle) {
+  API_BEGIN();
+  delete static_cast<BatchingExecutor*>(handle);
+  API_END();
+}
+
 int MXAutogradIsTraining(bool* curr) {
   API_BEGIN();
   *curr = Imperative::Get()->is_training();
@@ -180,6 +180,9 @@ struct ProfileConfigParam : public dmlc::Parameter<ProfileConfigParam> {
   float dump_period;
   bool aggregate_stats;
   int profile_process;
+  int ring_size;
+  int sample_period;
+  bool sample_iterations;
   DMLC_DECLARE_PARAMETER(ProfileConfigParam) {
     DMLC_DECLARE_FIELD(profile_all).set_default(false)
       .describe("Profile all. Default is False.");
@@ -213,6 +216,16 @@ struct ProfileConfigParam : public dmlc::Parameter<ProfileConfigParam> {
       .describe("Specifies which process to profile: "
                 "worker: this is default. for single node training it should always be worker."
                 "server: for distributed training, this profiles server process");
+    DMLC_DECLARE_FIELD(ring_size).set_default(0).set_lower_bound(0)
+      .describe("If nonzero, keep only the last ring_size records in a fixed size ring, "
+                "each dump writing them as a whole trace, so that the profiler can be left "
+                "on. Default is 0, which keeps all the records until dumped.");
+    DMLC_DECLARE_FIELD(sample_period).set_default(1).set_lower_bound(1)
+      .describe("Record 1 in sample_period operators. Default is 1.");
+    DMLC_DECLARE_FIELD(sample_iterations).set_default(false)
+      .describe("Rather record all the operators of 1 in sample_period iterations, "
+                "the iterations being delimited by MXProfileNextIteration. "
+                "Default is False.");
   }
 };
 
@@ -269,6 +282,8 @@ int MXSetProcessProfilerConfig(int num_params, const char* const* keys, const ch
                                            param.continuous_dump,
                                            param.dump_period,
                                            param.aggregate_stats);
+      profiler::Profiler::Get()->SetSampling(param.ring_size, param.sample_period,
+                                             param.sample_iterations);
 #if MXNET_USE_CUDA
       profiler::GpuDeviceStorageProfiler::Get()->SetConfig(
           param.gpu_memory_profile_filename_prefix);
@@ -325,6 +340,7 @@ int MXDumpProcessProfile(int finished, int profile_process, KVStoreHandle kvStor
     CHECK(profiler->IsEnableOutput())
       << "Profiler hasn't been run. Config and start profiler first";
     profiler->DumpProfile(finished != 0);
+    profiler::MemoryTimeline::Get()->DumpProfile(profiler->GetFilename());
 #if MXNET_USE_CUDA
     profiler::GpuDeviceStorageProfiler::Get()->DumpProfile();
 #endif  // MXNET_USE_CUDA
@@ -500,6 +516,20 @@ int MXProfilePause(int paused) {
   return MXProcessProfilePause(paused, static_cast<int>(ProfileProcess::kWorker), nullptr);
 }
 
+int MXProfileNextIteration() {
+  mxnet::IgnoreProfileCallScope ignore;
+  API_BEGIN();
+    profiler::Profiler::Get()->NextIteration();
+  API_END();
+}
+
+int MXProfileSetRequest(const char* request) {
+  mxnet::IgnoreProfileCallScope ignore;
+  API_BEGIN();
+    profiler::Profiler::Get()->SetRequest(request != nullptr ? request : "");
+  API_END();
+}
+
 int MXProcessProfilePause(int paused, int profile_process, KVStoreHandle kvStoreHandle) {
   mxnet::IgnoreProfileCallScope ignore;
   API_BEGIN();
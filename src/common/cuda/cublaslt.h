@@ -0,0 +1,75 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file cublaslt.h
+ * \brief Handles and matrix layouts shared by the cuBLASLt GEMMs of the operators
+ */
+#ifndef MXNET_COMMON_CUDA_CUBLASLT_H_
+#define MXNET_COMMON_CUDA_CUBLASLT_H_
+
+#include "./utils.h"
+
+#if MXNET_USE_CUDA
+#include <cuda.h>
+
+#if CUDA_VERSION >= 11000
+#include <cublasLt.h>
+#include <unordered_map>
+
+namespace mxnet {
+namespace common {
+namespace cuda {
+
+/*! \brief the cuBLASLt workspace, as large as the Hopper algorithms ask for */
+constexpr size_t kCublasLtWorkspace = 32 << 20;
+
+/*! \brief The cuBLASLt handle of the calling thread for the device. */
+inline cublasLtHandle_t CublasLtHandle(int dev_id) {
+  static thread_local std::unordered_map<int, cublasLtHandle_t> handles;
+  auto it = handles.find(dev_id);
+  if (it != handles.end()) return it->second;
+  cublasLtHandle_t handle;
+  CHECK_EQ(cublasLtCreate(&handle), CUBLAS_STATUS_SUCCESS) << "cublasLtCreate failed";
+  handles[dev_id] = handle;
+  return handle;
+}
+
+/*! \brief A column major (rows, cols) layout of batch matrices. */
+inline cublasLtMatrixLayout_t CublasLtLayout(cudaDataType_t type, uint64_t rows,
+                                             uint64_t cols, int32_t batch = 1) {
+  cublasLtMatrixLayout_t layout;
+  CHECK_EQ(cublasLtMatrixLayoutCreate(&layout, type, rows, cols, rows), CUBLAS_STATUS_SUCCESS);
+  if (batch > 1) {
+    const int64_t stride = rows * cols;
+    cublasLtMatrixLayoutSetAttribute(layout, CUBLASLT_MATRIX_LAYOUT_BATCH_COUNT,
+                                     &batch, sizeof(batch));
+    cublasLtMatrixLayoutSetAttribute(layout, CUBLASLT_MATRIX_LAYOUT_STRIDED_BATCH_OFFSET,
+                                     &stride, sizeof(stride));
+  }
+  return layout;
+}
+
+}  // namespace cuda
+}  // namespace common
+}  // namespace mxnet
+
+#endif  // CUDA_VERSION >= 11000
+#endif  // MXNET_USE_CUDA
+#endif  // MXNET_COMMON_CUDA_CUBLASLT_H_
@@ -23,9 +23,19 @@
 
 #include <nvrtc.h>
 
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
 #include <mutex>
+#include <random>
+#include <sstream>
 #include <string>
 #include <fstream>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -77,108 +87,312 @@ std::string GetCompileLog(nvrtcProgram program) {
   return log;
 }
 
-// Obtain compilation result (ptx assembly) from the program.
-std::string GetPtx(nvrtcProgram program) {
-  size_t ptx_size_including_null;
-  NVRTC_CALL(nvrtcGetPTXSize(program, &ptx_size_including_null));
-  std::string ptx(ptx_size_including_null - 1, '\0');
+// Obtain compilation result from the program: a cubin, or ptx assembly if the
+// program was compiled for a virtual architecture.
+std::string GetImage(nvrtcProgram program, bool cubin) {
+  size_t size = 0;
+#if CUDA_VERSION >= 11010
+  if (cubin) {
+    NVRTC_CALL(nvrtcGetCUBINSize(program, &size));
+    std::string image(size, '\0');
+    NVRTC_CALL(nvrtcGetCUBIN(program, &image[0]));
+    return image;
+  }
+#endif
+  NVRTC_CALL(nvrtcGetPTXSize(program, &size));
+  std::string ptx(size - 1, '\0');
   // Room for terminating null character ensured since C++11
   NVRTC_CALL(nvrtcGetPTX(program, &ptx[0]));
   return ptx;
 }
 
-}  // namespace
+// Whether NVRTC can produce a cubin for the architecture, otherwise the ptx is compiled
+// by the driver when the module is loaded.
+bool SupportsCubin(int sm_arch) {
+#if CUDA_VERSION >= 11020
+  static const int max_arch = []() {
+    int num_archs = 0;
+    NVRTC_CALL(nvrtcGetNumSupportedArchs(&num_archs));
+    std::vector<int> archs(num_archs);
+    NVRTC_CALL(nvrtcGetSupportedArchs(archs.data()));
+    return archs.empty() ? 0 : archs.back();
+  }();
+  return sm_arch <= max_arch;
+#else
+  return false;
+#endif
+}
 
-CUfunction get_function(const std::string &parameters,
-                        const std::string &kernel_name,
-                        const std::string &code,
-                        int dev_id) {
-  constexpr int CACHESIZE_WARN_THRESHOLD = 10000;
-  std::lock_guard<std::mutex> l(lock);
-  // Local class for value type of compile cache
-  struct KernelInfo {
-    std::string mangled_name;
-    std::string ptx;
-    std::vector<CUfunction> functions;
+// Directory of the on-disk kernel cache, empty if disabled.
+const std::string& CacheDir() {
+  static const std::string dir = dmlc::GetEnv("MXNET_RTC_CACHE_DIR", std::string());
+  return dir;
+}
+
+#if NDEBUG == 0
+constexpr const char* kBuildFlavor = "debug";
+#else
+constexpr const char* kBuildFlavor = "";
+#endif
+
+// Path of the cache file of a kernel: a hash of everything the compiled image depends on.
+std::string CacheFile(const std::string &source, const std::vector<std::string> &opts,
+                      bool cubin) {
+  uint64_t hash = 14695981039346656037ULL;  // FNV-1a, stable across processes
+  auto update = [&hash](const std::string &str) {
+    for (const char c : str) {
+      hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ULL;
+    }
   };
-  // Maps from the kernel name and parameters to the ptx and jit-compiled CUfunctions.
+  update(source);
+  for (const auto &opt : opts) update(opt);
+  update(std::to_string(MXNET_VERSION) + kBuildFlavor);
+  update(std::to_string(CUDA_VERSION));
+  std::ostringstream os;
+  os << CacheDir() << "/mxnet_rtc_" << std::hex << hash << (cubin ? ".cubin" : ".ptx");
+  return os.str();
+}
+
+// Load the image and mangled name of a kernel compiled by an earlier process.
+// The file starts with the kernel source, checked against source in case of hash collision.
+bool LoadCachedKernel(const std::string &file, const std::string &source,
+                      std::string *mangled_name, std::string *image) {
+  std::ifstream f(file, std::ios::binary);
+  if (!f) return false;
+  size_t source_size = 0;
+  if (!(f >> source_size) || f.get() != '\n' || source_size != source.size()) return false;
+  std::string cached_source(source_size, '\0');
+  if (!f.read(&cached_source[0], source_size) || cached_source != source) return false;
+  if (f.get() != '\n' || !std::getline(f, *mangled_name)) return false;
+  std::ostringstream rest;
+  rest << f.rdbuf();
+  *image = rest.str();
+  return !image->empty();
+}
+
+// Store a compiled kernel. Written to a temporary file and renamed, so that
+// processes sharing the directory never read a partial file.
+void StoreCachedKernel(const std::string &file, const std::string &source,
+                       const std::string &mangled_name, const std::string &image) {
+  // unique across the threads and processes writing the same kernel
+  thread_local std::mt19937_64 rng(std::random_device{}());
+  const std::string tmp = file + ".tmp" +
+                          std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) +
+                          "_" + std::to_string(rng());
+  {
+    std::ofstream f(tmp, std::ios::binary);
+    f << source.size() << "\n" << source << "\n" << mangled_name << "\n" << image;
+    if (!f) {
+      LOG(WARNING) << "Could not write the RTC cache file " << tmp;
+      return;
+    }
+  }
+  if (std::rename(tmp.c_str(), file.c_str()) != 0) {
+    std::remove(tmp.c_str());
+  }
+}
+
+// Value type of the compile cache
+struct KernelInfo {
+  std::string mangled_name;
+  // cubin, or ptx if NVRTC cannot target the architecture
+  std::string image;
+  std::vector<CUfunction> functions;
+  // ready once mangled_name and image are set, holds the compilation error if any
+  std::shared_future<void> compiled;
+};
+
+using CompileTask = std::shared_ptr<std::packaged_task<void()>>;
+
+// Generate the cubin or ptx and the mangled name of a kernel, without holding the lock.
+void Compile(const std::string &parameters, const std::string &kernel_name,
+             const std::string &code, int sm_arch, KernelInfo *kinfo) {
+  static const std::string common_header =
+      std::string(fp16_support_string) + "\n" +
+      type_support_string + "\n" +
+      util_string + "\n" +
+      special_functions_definitions + '\n' +
+      vectorization_support_string + "\n" +
+      function_definitions_util + "\n" +
+      function_definitions_binary + "\n" +
+      function_definitions_unary + "\n" +
+      backward_function_definitions + "\n" +
+      reducer + "\n";
+  std::string code_with_header = common_header + parameters + code;
+  // If verbose mode, output kernel source, though not including the common header
+  if (dmlc::GetEnv("MXNET_RTC_VERBOSE", false)) {
+    LOG(INFO) << "\n" << std::string(80, '-') << "\n" << (parameters + code);
+  }
+  const bool cubin = SupportsCubin(sm_arch);
+  std::vector<std::string> opts = {
+    (cubin ? "--gpu-architecture=sm_" : "--gpu-architecture=compute_") + std::to_string(sm_arch),
+#if NDEBUG == 0
+    "-G",
+#endif
+    "--std=c++14"};
+  // The cache file is keyed by the full source, only the kernel part is stored in it
+  const std::string cache_file = CacheDir().empty() ? std::string() :
+      CacheFile(code_with_header, opts, cubin);
+  if (!cache_file.empty() &&
+      LoadCachedKernel(cache_file, parameters + code, &kinfo->mangled_name, &kinfo->image)) {
+    return;
+  }
+  nvrtcProgram program;
+  NVRTC_CALL(nvrtcCreateProgram(&program,                                  // prog
+                                &code_with_header[0],                      // buffer
+                                (kernel_name + "_kernel.cu").c_str(),      // name
+                                0,                                         // num headers
+                                nullptr,                                   // headers
+                                nullptr));                                 // include names
+
+  std::vector<const char *> opt_ptrs;
+  for (const auto &opt : opts) opt_ptrs.push_back(opt.c_str());
+  const std::string kernel_name_demangled = kernel_name;
+  NVRTC_CALL(nvrtcAddNameExpression(program, (kernel_name_demangled).c_str()));
+
+  nvrtcResult compileResult = nvrtcCompileProgram(program,                          // prog
+                                                  static_cast<int>(opt_ptrs.size()),  // num opts
+                                                  opt_ptrs.data());                 // options
+  if (compileResult != NVRTC_SUCCESS) {
+    static const std::string dump_file = "mxnet_rtc_debug_code.log";
+    {
+      std::lock_guard<std::mutex> l(lock);
+      std::ofstream f(dump_file);
+      f << code_with_header;
+    }
+    const std::string log = GetCompileLog(program);
+    NVRTC_CALL(nvrtcDestroyProgram(&program));
+    LOG(FATAL) << "NVRTC Compilation failed.\n"
+               << "The generated code was stored in " << dump_file << "\n"
+               << log;
+  }
+
+  kinfo->image = GetImage(program, cubin);
+  const char *mangled_name;
+  NVRTC_CALL(nvrtcGetLoweredName(program,
+                                 kernel_name_demangled.c_str(),
+                                 &mangled_name));
+  kinfo->mangled_name = mangled_name;
+  // Destroy the program.
+  NVRTC_CALL(nvrtcDestroyProgram(&program));
+  if (!cache_file.empty()) {
+    StoreCachedKernel(cache_file, parameters + code, kinfo->mangled_name, kinfo->image);
+  }
+}
+
+// Find the cache entry of a kernel. If it is new, *task is set to its compilation, which
+// the caller runs after releasing the lock. Must be called with the lock held.
+KernelInfo *FindKernel(const std::string &parameters, const std::string &kernel_name,
+                       const std::string &code, int dev_id, CompileTask *task) {
+  constexpr int CACHESIZE_WARN_THRESHOLD = 10000;
+  // Maps from the kernel name and parameters to the image and jit-compiled CUfunctions.
   using KernelCache = std::unordered_map<std::string, KernelInfo>;
   // Per-gpu-architecture compiled kernel cache with jit-compiled function for each device context
   static std::unordered_map<int32_t, KernelCache> compiled_kernels;
-  int sm_arch = SMArch(dev_id);
+  const int sm_arch = SMArch(dev_id);
   // make null map as needed
   KernelCache& compiled_kernels_this_arch = compiled_kernels[sm_arch];
-  // make KernelInfo as needed
+  // make KernelInfo as needed, references to it stay valid when the map grows
   KernelInfo& kinfo = compiled_kernels_this_arch[parameters + kernel_name];
-  if (kinfo.ptx.size() == 0) {
-    // It's the first time we've seen this kernel, so we need to generate the ptx and mangled_name.
-    static std::string common_header =
-        std::string(fp16_support_string) + "\n" +
-        type_support_string + "\n" +
-        util_string + "\n" +
-        special_functions_definitions + '\n' +
-        vectorization_support_string + "\n" +
-        function_definitions_util + "\n" +
-        function_definitions_binary + "\n" +
-        function_definitions_unary + "\n" +
-        backward_function_definitions + "\n" +
-        reducer + "\n";
-    std::string code_with_header = common_header + parameters + code;
-    // If verbose mode, output kernel source, though not including the common header
-    if (dmlc::GetEnv("MXNET_RTC_VERBOSE", false)) {
-      LOG(INFO) << "\n" << std::string(80, '-') << "\n" << (parameters + code);
-    }
+  if (!kinfo.compiled.valid()) {
+    // It's the first time we've seen this kernel, so we need to generate the image
     if (compiled_kernels_this_arch.size() == CACHESIZE_WARN_THRESHOLD + 1 &&
         dmlc::GetEnv("MXNET_RTC_SIZE_WARNING", true)) {
       LOG(WARNING) << "The number of different compiled kernels exceeds "
                    << CACHESIZE_WARN_THRESHOLD
                    << ".  Set MXNET_RTC_SIZE_WARNING=0 to quiet this warning.";
     }
-    nvrtcProgram program;
-    NVRTC_CALL(nvrtcCreateProgram(&program,                                  // prog
-                                  &code_with_header[0],                      // buffer
-                                  (kernel_name + "_kernel.cu").c_str(),      // name
-                                  0,                                         // num headers
-                                  nullptr,                                   // headers
-                                  nullptr));                                 // include names
-
-    std::string gpu_arch_arg = "--gpu-architecture=compute_" + std::to_string(sm_arch);
-    const char *opts[] = {gpu_arch_arg.c_str(),
-#if NDEBUG == 0
-                          "-G",
-#endif
-                          "--std=c++14"};
-    const std::string kernel_name_demangled = kernel_name;
-    NVRTC_CALL(nvrtcAddNameExpression(program, (kernel_name_demangled).c_str()));
+    KernelInfo *info = &kinfo;
+    *task = std::make_shared<std::packaged_task<void()>>(
+        [parameters, kernel_name, code, sm_arch, info]() {
+          Compile(parameters, kernel_name, code, sm_arch, info);
+        });
+    kinfo.compiled = (*task)->get_future().share();
+  }
+  return &kinfo;
+}
 
-    nvrtcResult compileResult = nvrtcCompileProgram(program,                         // prog
-                                                    sizeof(opts) / sizeof(opts[0]),  // num options
-                                                    opts);                           // options
-    static const std::string dump_file = "mxnet_rtc_debug_code.log";
-    if (compileResult != NVRTC_SUCCESS) {
-      std::ofstream f(dump_file);
-      f << code_with_header;
-      f.close();
+// Threads compiling the kernels requested by compile_function_async.
+class CompileQueue {
+ public:
+  static CompileQueue *Get() {
+    // never destroyed, the threads are detached and may outlive static destruction
+    static CompileQueue *queue = new CompileQueue();
+    return queue;
+  }
+
+  void Push(CompileTask task) {
+    {
+      std::lock_guard<std::mutex> l(mutex_);
+      tasks_.push_back(std::move(task));
+      if (num_threads_ < max_threads_ && idle_ == 0) {
+        ++num_threads_;
+        std::thread([this]() { Run(); }).detach();
+      }
     }
-    CHECK_EQ(compileResult, NVRTC_SUCCESS)
-        << "NVRTC Compilation failed.\n"
-        << "The generated code was stored in " << dump_file << "\n"
-        << GetCompileLog(program);
-
-    kinfo.ptx = GetPtx(program);
-    const char *mangled_name;
-    NVRTC_CALL(nvrtcGetLoweredName(program,
-                                   kernel_name_demangled.c_str(),
-                                   &mangled_name));
-    kinfo.mangled_name = mangled_name;
-    // Destroy the program.
-    NVRTC_CALL(nvrtcDestroyProgram(&program));
+    cv_.notify_one();
+  }
+
+ private:
+  CompileQueue()
+    : max_threads_(std::max(1, dmlc::GetEnv("MXNET_RTC_COMPILE_THREADS", 4))) {}
+
+  void Run() {
+    std::unique_lock<std::mutex> l(mutex_);
+    while (true) {
+      ++idle_;
+      cv_.wait(l, [this]() { return !tasks_.empty(); });
+      --idle_;
+      CompileTask task = std::move(tasks_.front());
+      tasks_.pop_front();
+      l.unlock();
+      (*task)();
+      l.lock();
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<CompileTask> tasks_;
+  const int max_threads_;
+  int num_threads_ = 0;
+  int idle_ = 0;
+};
+
+}  // namespace
+
+void compile_function_async(const std::string &parameters,
+                            const std::string &kernel_name,
+                            const std::string &code,
+                            int dev_id) {
+  CompileTask task;
+  {
+    std::lock_guard<std::mutex> l(lock);
+    FindKernel(parameters, kernel_name, code, dev_id, &task);
   }
+  if (task) CompileQueue::Get()->Push(std::move(task));
+}
+
+CUfunction get_function(const std::string &parameters,
+                        const std::string &kernel_name,
+                        const std::string &code,
+                        int dev_id) {
+  CompileTask task;
+  KernelInfo *kinfo;
+  {
+    std::lock_guard<std::mutex> l(lock);
+    kinfo = FindKernel(parameters, kernel_name, code, dev_id, &task);
+  }
+  // NVRTC compiles different programs concurrently, so the lock is not held meanwhile
+  if (task) (*task)();
+  // waits for a compilation started by another thread, and rethrows its error
+  kinfo->compiled.get();
+  std::lock_guard<std::mutex> l(lock);
   // Ensure function array is deep enough to index by dev_id
-  while (kinfo.functions.size() <= static_cast<size_t>(dev_id))
-    kinfo.functions.push_back(static_cast<CUfunction>(nullptr));
-  // Jit-compile ptx for the device as needed
-  if (kinfo.functions[dev_id] == static_cast<CUfunction>(nullptr)) {
+  while (kinfo->functions.size() <= static_cast<size_t>(dev_id))
+    kinfo->functions.push_back(static_cast<CUfunction>(nullptr));
+  // Load the cubin, or jit-compile the ptx, for the device as needed
+  if (kinfo->functions[dev_id] == static_cast<CUfunction>(nullptr)) {
     // Make sure driver context is set to the proper device
     CUdevice cu_device;
     CUcontext context;
@@ -199,12 +413,13 @@ CUfunction get_function(const std::string &parameters,
     void* jit_opt_values[] = {reinterpret_cast<void*>(debug_info),
                               reinterpret_cast<void*>(line_info)};
 
-    CUDA_DRIVER_CALL(cuModuleLoadDataEx(&module, kinfo.ptx.c_str(), 2, jit_opts, jit_opt_values));
-    CUDA_DRIVER_CALL(cuModuleGetFunction(&kinfo.functions[dev_id],
+    CUDA_DRIVER_CALL(cuModuleLoadDataEx(&module, kinfo->image.c_str(), 2,
+                                        jit_opts, jit_opt_values));
+    CUDA_DRIVER_CALL(cuModuleGetFunction(&kinfo->functions[dev_id],
                                          module,
-                                         kinfo.mangled_name.c_str()));
+                                         kinfo->mangled_name.c_str()));
   }
-  return kinfo.functions[dev_id];
+  return kinfo->functions[dev_id];
 }
 
 void launch(CUfunction function,
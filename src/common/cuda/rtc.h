@@ -67,6 +67,18 @@ CUfunction get_function(const std::string &parameters,
                         const std::string &code,
                         int dev_id);
 
+/*! \brief Start compiling a GPU kernel in the background, so that a later get_function
+ *         with the same arguments does not wait for the whole compilation.
+ *  \param parameters of the kernel (e.g. values of the template arguments, types used)
+ *  \param kernel_name name of the kernel
+ *  \param code used for compilation of the kernel if not found in cache
+ *  \param dev_id id of the device which the kernel will be launched on
+ */
+void compile_function_async(const std::string &parameters,
+                            const std::string &kernel_name,
+                            const std::string &code,
+                            int dev_id);
+
 /*! \brief Launch a GPU kernel.
  *  \param function to launch
  *  \param grid_dim grid dimensions
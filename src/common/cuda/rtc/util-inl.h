@@ -259,6 +259,17 @@ namespace util {
 
 constexpr int MAX_DIM = 5;
 
+// Quotient of two non-negative indices. With 64-bit index_t, the division
+// is done in 32 bits when both operands fit, since it is much faster.
+__device__ inline index_t index_div(const index_t a, const index_t b) {
+  if (sizeof(index_t) == 8 &&
+      ((static_cast<unsigned long long>(a) |
+        static_cast<unsigned long long>(b)) >> 32) == 0) {
+    return static_cast<unsigned int>(a) / static_cast<unsigned int>(b);
+  }
+  return a / b;
+}
+
 template <int ndim>
 __device__ inline void unravel_dot(const index_t idx, const index_t (&shape)[MAX_DIM],
   const index_t (&stridej)[MAX_DIM], const index_t (&stridek)[MAX_DIM], index_t* j, index_t* k) {
@@ -266,7 +277,7 @@ __device__ inline void unravel_dot(const index_t idx, const index_t (&shape)[MAX
   *k = 0;
   #pragma unroll
   for (index_t i = ndim-1, idx_t = idx; i >=0; --i) {
-    const auto tmp = idx_t / shape[i];
+    const auto tmp = index_div(idx_t, shape[i]);
     const auto coord = idx_t - tmp*shape[i];
     *j += coord*stridej[i];
     *k += coord*stridek[i];
@@ -280,7 +291,7 @@ __device__ inline index_t unravel_dot(const index_t idx, const index_t (&shape)[
   index_t ret = 0;
   #pragma unroll
   for (index_t i = ndim-1, j = idx; i >=0; --i) {
-    auto tmp = j / shape[i];
+    auto tmp = index_div(j, shape[i]);
     ret += (j - tmp*shape[i])*stride[i];
     j = tmp;
   }
@@ -297,7 +308,7 @@ __device__ inline index_t unravel_ravel(const index_t idx, const index_t (&shape
     if (i != ndim - 1) {
       total_shape *= shape2[i + 1];
     }
-    auto tmp = j / shape1[i];
+    auto tmp = index_div(j, shape1[i]);
     const index_t coord = j - tmp*shape1[i];
     ret += total_shape * (shape2[i] > coord) * coord;
     j = tmp;
@@ -321,7 +332,7 @@ __device__ inline void unravel(const index_t idx,
                                index_t (&coord)[ndim]) {
 #pragma unroll
   for (index_t i = ndim-1, j = idx; i >=0; --i) {
-    auto tmp = j / shape[i];
+    auto tmp = index_div(j, shape[i]);
     coord[i] = j - tmp*shape[i];
     j = tmp;
   }
@@ -30,6 +30,7 @@
 #include <dmlc/optional.h>
 #include <mshadow/base.h>
 #include <mxnet/libinfo.h>
+#include <initializer_list>
 
 /*! \brief Macros/inlines to assist CLion to parse Cuda files (*.cu, *.cuh) */
 #ifdef __JETBRAINS_IDE__
@@ -815,6 +816,44 @@ __device__ inline mshadow::half::half_t warp_reduce(mshadow::half::half_t value,
   return mshadow::half::half_t(v);
 }
 
+/*! \brief Reduction inside a warp, after which all the lanes hold the result.
+ * \param value - values to be reduced.
+ * \param redfun - function used to perform reduction.
+ */
+template <typename OP, typename T>
+__device__ inline T warp_allreduce(T value, OP redfun) {
+#pragma unroll
+  for (int i = warp_size / 2; i >= 1; i /= 2) {
+    value = redfun(value, __shfl_xor_sync(0xffffffff, value, i));
+  }
+  return value;
+}
+
+/*! \brief nvec values of DType, loaded or stored with a single instruction
+ *         when nvec * sizeof(DType) is at most 16 bytes.
+ */
+template <typename DType, int nvec>
+struct alignas(sizeof(DType) * nvec) aligned_vector {
+  DType val[nvec];
+};
+
+/*! \brief Largest nvec up to 16 bytes of DType such that the rows of row_size elements
+ *         starting at all the pointers can be accessed as aligned_vector<DType, nvec>.
+ */
+template <typename DType>
+inline int get_vector_length(size_t row_size, std::initializer_list<const void*> ptrs) {
+  int nvec = 16 / sizeof(DType);
+  for (; nvec > 1; nvec /= 2) {
+    const size_t bytes = nvec * sizeof(DType);
+    bool aligned = row_size % nvec == 0;
+    for (const void* ptr : ptrs) {
+      aligned = aligned && (ptr == nullptr || reinterpret_cast<uintptr_t>(ptr) % bytes == 0);
+    }
+    if (aligned) break;
+  }
+  return nvec < 1 ? 1 : nvec;
+}
+
 /*! \brief Reduction inside a block, requires all threads in a block to participate.
  *         It uses a 2 step approach:
  *          - all warps in a block perform intermediate reduction
@@ -189,6 +189,21 @@ inline void CastNonDefaultStorage(const std::vector<NDArray>& src,
   }
 }
 
+/*!
+ * \brief prefetch the managed memory of the arrays of an operator to its GPU
+ */
+inline void PrefetchManaged(const std::vector<NDArray *>& inputs,
+                            const std::vector<NDArray *>& outputs, const RunContext& rctx) {
+  for (const auto i : inputs) i->PrefetchManaged(rctx);
+  for (const auto i : outputs) i->PrefetchManaged(rctx);
+}
+
+inline void PrefetchManaged(const std::vector<NDArray>& inputs,
+                            const std::vector<NDArray>& outputs, const RunContext& rctx) {
+  for (const auto& i : inputs) i.PrefetchManaged(rctx);
+  for (const auto& i : outputs) i.PrefetchManaged(rctx);
+}
+
 /*! \brief The default type inference function, which assigns all undefined
  *         types to the same type of one of the inputs or outputs.
  */
@@ -0,0 +1,182 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file numa.h
+ * \brief NUMA topology detection, thread pinning and memory binding.
+ *
+ *  When MXNET_CPU_NUMA_BIND is set, CPU context `cpu(i)` is mapped to NUMA node
+ *  `i % num_nodes`: the engine pins the CPU workers of that context to the cores
+ *  of the node and the CPU memory pool of the node binds its chunks to node-local
+ *  memory. Running one partition per socket is then a matter of using `cpu(0)`,
+ *  `cpu(1)`, ... for the different models.
+ */
+#ifndef MXNET_COMMON_NUMA_H_
+#define MXNET_COMMON_NUMA_H_
+
+#include <dmlc/logging.h>
+#include <dmlc/parameter.h>
+#include <mxnet/base.h>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+namespace mxnet {
+namespace common {
+
+/*!
+ * \brief NUMA topology of the host, read once from sysfs.
+ */
+class NumaTopology {
+ public:
+  /*! \return the topology singleton */
+  static const NumaTopology* Get() {
+    static NumaTopology inst(ReadNodeCPUs());
+    return &inst;
+  }
+  /*!
+   * \brief Build a topology from the cores of each node.
+   *  Binding is enabled when MXNET_CPU_NUMA_BIND is set and there is more than one node.
+   * \param node_cpus cores of each node, an empty list stands for a single node
+   */
+  explicit NumaTopology(std::vector<std::vector<int>> node_cpus)
+    : node_cpus_(std::move(node_cpus)) {
+#if defined(__linux__)
+    page_size_ = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+    if (node_cpus_.empty()) node_cpus_.emplace_back();
+    enabled_ = dmlc::GetEnv("MXNET_CPU_NUMA_BIND", false) && num_nodes() > 1;
+  }
+  /*! \return whether NUMA binding is requested and there is more than one node */
+  bool enabled() const { return enabled_; }
+  /*! \return number of detected NUMA nodes, at least 1 */
+  int num_nodes() const { return static_cast<int>(node_cpus_.size()); }
+  /*! \return the cores belonging to a node */
+  const std::vector<int>& cpus(int node) const { return node_cpus_.at(node); }
+  /*!
+   * \brief NUMA node serving a context.
+   * \return the node, or -1 if binding is disabled or the context is not a CPU one.
+   */
+  int NodeOf(const Context& ctx) const {
+    if (!enabled_ || ctx.dev_type != Context::kCPU) return -1;
+    return ctx.dev_id % num_nodes();
+  }
+  /*!
+   * \brief Index of the storage manager serving a context.
+   *  CPU contexts get one manager per NUMA node when binding is enabled.
+   */
+  int ManagerIndexOf(const Context& ctx) const {
+    const int node = NodeOf(ctx);
+    return node >= 0 ? node : ctx.real_dev_id();
+  }
+  /*!
+   * \brief Pin the calling thread to the cores of a node.
+   * \return whether the affinity was changed.
+   */
+  bool BindCurrentThread(int node) const {
+#if defined(__linux__)
+    if (node < 0 || node >= num_nodes() || node_cpus_[node].empty()) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : node_cpus_[node]) {
+      if (cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+    }
+    if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+      LOG(WARNING) << "Failed to bind thread to NUMA node " << node;
+      return false;
+    }
+    return true;
+#else
+    return false;
+#endif
+  }
+  /*!
+   * \brief Ask the kernel to place the pages of a region on a node.
+   *  The region must start on a page boundary and must not have been touched yet.
+   * \return whether the policy was applied.
+   */
+  bool BindMemory(void* ptr, size_t size, int node) const {
+#if defined(__linux__) && defined(SYS_mbind)
+    if (node < 0 || node >= num_nodes() || size == 0) return false;
+    // MPOL_PREFERRED from <numaif.h>, spelled out to avoid depending on libnuma.
+    constexpr int kMPolPreferred = 1;
+    unsigned long mask[16] = {0};  // NOLINT(runtime/int)
+    constexpr int kBitsPerWord = 8 * sizeof(mask[0]);
+    if (node >= static_cast<int>(sizeof(mask) * 8)) return false;
+    mask[node / kBitsPerWord] |= 1UL << (node % kBitsPerWord);
+    return syscall(SYS_mbind, ptr, size, kMPolPreferred, mask,
+                   sizeof(mask) * 8, 0) == 0;
+#else
+    return false;
+#endif
+  }
+  /*! \return the system page size */
+  size_t page_size() const { return page_size_; }
+
+  /*! \brief parse a sysfs cpu list such as "0-15,32-47" */
+  static std::vector<int> ParseCPUList(const std::string& list) {
+    std::vector<int> ret;
+    std::stringstream ss(list);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+      if (range.empty()) continue;
+      const size_t dash = range.find('-');
+      const int lo = std::atoi(range.substr(0, dash).c_str());
+      const int hi = dash == std::string::npos ? lo : std::atoi(range.substr(dash + 1).c_str());
+      for (int cpu = lo; cpu <= hi; ++cpu) ret.push_back(cpu);
+    }
+    return ret;
+  }
+
+ private:
+  /*! \brief read the cores of each node from sysfs */
+  static std::vector<std::vector<int>> ReadNodeCPUs() {
+    std::vector<std::vector<int>> node_cpus;
+#if defined(__linux__)
+    for (int node = 0; ; ++node) {
+      std::ifstream in("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+      if (!in.good()) break;
+      std::string line;
+      std::getline(in, line);
+      node_cpus.push_back(ParseCPUList(line));
+    }
+#endif
+    return node_cpus;
+  }
+
+  /*! \brief cores of each node */
+  std::vector<std::vector<int>> node_cpus_;
+  /*! \brief whether binding is enabled */
+  bool enabled_{false};
+  /*! \brief system page size */
+  size_t page_size_{4096};
+};
+
+}  // namespace common
+}  // namespace mxnet
+#endif  // MXNET_COMMON_NUMA_H_
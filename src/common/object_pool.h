@@ -46,6 +46,12 @@ class ObjectPool {
    */
   template <typename... Args>
   T* New(Args&&... args);
+  /*!
+   * \brief Create several default constructed objects, taking the lock once.
+   * \param n Number of objects.
+   * \param out Array receiving the n pointers.
+   */
+  void NewBatch(std::size_t n, T** out);
   /*!
    * \brief Delete an existing object.
    * \param ptr The pointer to delete.
@@ -121,6 +127,12 @@ struct ObjectPoolAllocatable {
    */
   template <typename... Args>
   static T* New(Args&&... args);
+  /*!
+   * \brief Create several default constructed objects.
+   * \param n Number of objects.
+   * \param out Array receiving the n pointers.
+   */
+  static void NewBatch(std::size_t n, T** out);
   /*!
    * \brief Delete an existing object.
    * \param ptr The pointer to delete.
@@ -156,6 +168,23 @@ T* ObjectPool<T>::New(Args&&... args) {
   return new (static_cast<void*>(ret)) T(std::forward<Args>(args)...);
 }
 
+template <typename T>
+void ObjectPool<T>::NewBatch(std::size_t n, T** out) {
+  {
+    std::lock_guard<std::mutex> lock{m_};
+    for (std::size_t i = 0; i < n; ++i) {
+      if (head_->next == nullptr) {
+        AllocateChunk();
+      }
+      out[i] = reinterpret_cast<T*>(head_);
+      head_ = head_->next;
+    }
+  }
+  for (std::size_t i = 0; i < n; ++i) {
+    new (static_cast<void*>(out[i])) T();
+  }
+}
+
 template <typename T>
 void ObjectPool<T>::Delete(T* ptr) {
   ptr->~T();
@@ -213,6 +242,11 @@ T* ObjectPoolAllocatable<T>::New(Args&&... args) {
   return ObjectPool<T>::Get()->New(std::forward<Args>(args)...);
 }
 
+template <typename T>
+void ObjectPoolAllocatable<T>::NewBatch(std::size_t n, T** out) {
+  ObjectPool<T>::Get()->NewBatch(n, out);
+}
+
 template <typename T>
 void ObjectPoolAllocatable<T>::Delete(T* ptr) {
   ObjectPool<T>::Get()->Delete(ptr);
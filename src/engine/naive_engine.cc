@@ -123,7 +123,8 @@ class NaiveEngine final : public Engine {
   void Push(OprHandle op, Context exec_ctx, int priority = 0, bool profiling = false) override {
     profiler::Profiler *profiler = profiler::Profiler::Get();
     NaiveOpr *opr = op->Cast<NaiveOpr>();
-    opr->profiling = profiling && profiler->IsProfiling(profiler::Profiler::kSymbolic);
+    opr->profiling = profiling && profiler->IsProfiling(profiler::Profiler::kSymbolic) &&
+                     profiler->SampleOperator();
     this->PushAsync([&](RunContext ctx, CallbackOnComplete on_complete) {
         if (opr->profiling) {
           std::unique_ptr<profiler::ProfileOperator::Attributes> attrs;
@@ -167,7 +168,8 @@ class NaiveEngine final : public Engine {
       this->DeleteOperator(p);
     };
     std::unique_ptr<NaiveOpr, decltype(opr_deleter)> opr(nullptr, opr_deleter);
-    const bool profiling = opr_name && profiler->IsProfiling(profiler::Profiler::kImperative);
+    const bool profiling = opr_name && profiler->IsProfiling(profiler::Profiler::kImperative) &&
+                           profiler->SampleOperator();
     // GenerateDisplayName() will return a pointer to the correct name of the operator
     const char* display_name = profiling ?
                                profiler::CustomOpProfiler::Get()->GenerateDisplayName(opr_name) :
@@ -19,6 +19,7 @@
 #include <dmlc/omp.h>
 #include <dmlc/base.h>
 #include <dmlc/parameter.h>
+#include <algorithm>
 #include <climits>
 #include "./openmp.h"
 
@@ -88,6 +89,11 @@ void OpenMP::set_reserve_cores(int cores) {
 #endif
 }
 
+void OpenMP::set_leased_cores(int cores) {
+  CHECK_GE(cores, 0);
+  leased_cores_ = cores;
+}
+
 int OpenMP::GetRecommendedOMPThreadCount(bool exclude_reserved) const {
 #ifdef _OPENMP
   if (enabled_) {
@@ -102,6 +108,10 @@ int OpenMP::GetRecommendedOMPThreadCount(bool exclude_reserved) const {
       } else {
         thread_count -= reserve_cores_;
       }
+      // the leased cores cap the count rather than reduce it, as they change over time
+      if (leased_cores_ > 0) {
+        thread_count = std::min(thread_count, std::max(omp_thread_max_ - leased_cores_, 1));
+      }
     }
     // Check that OMP doesn't suggest more than our 'omp_thread_max_' value
     if (!omp_thread_max_ || thread_count < omp_thread_max_) {
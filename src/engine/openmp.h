@@ -67,6 +67,12 @@ class OpenMP {
    */
   int reserve_cores() const { return reserve_cores_; }
 
+  /*!
+   * \brief Exclude the cores leased by the thread budget from OMP regions
+   * \param cores Number of cores leased to the thread pools outside the engine
+   */
+  void set_leased_cores(int cores);
+
   /*!
    * \brief Call at the beginning of a worker thread's life.  This will set the omp_num_threads
    *        for omp regions created by this thread
@@ -101,6 +107,10 @@ class OpenMP {
    * \brief Number of cores to reserve for non-OMP regions
    */
   volatile int reserve_cores_ = 0;
+  /*!
+   * \brief Number of cores leased by the thread budget
+   */
+  volatile int leased_cores_ = 0;
   /*!
    * \brief Whether OMP_NUM_THREADS was set in the environment.  If it is, we fall back to
    *        the OMP's implementation's handling of that environment variable
@@ -0,0 +1,128 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file priority_task_queue.h
+ * \brief Blocking task queue ordered by priority, then by push order.
+ */
+#ifndef MXNET_ENGINE_PRIORITY_TASK_QUEUE_H_
+#define MXNET_ENGINE_PRIORITY_TASK_QUEUE_H_
+
+#include <dmlc/base.h>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <queue>
+#include <vector>
+
+namespace mxnet {
+namespace engine {
+
+/*!
+ * \brief Task queue that always pops the most urgent element.
+ *
+ *  Elements with a higher priority are popped first. Elements of equal priority
+ *  are popped in the order they were pushed, so that the queue degrades to the
+ *  FIFO queue when all priorities are equal. This is unlike the priority mode of
+ *  dmlc::ConcurrentBlockingQueue, which does not keep the push order.
+ *
+ *  The interface mirrors dmlc::ConcurrentBlockingQueue so that it can be used as
+ *  the task queue of an engine worker block.
+ */
+template<typename T>
+class PriorityTaskQueue {
+ public:
+  PriorityTaskQueue() = default;
+  /*!
+   * \brief Push an element.
+   * \param e the element.
+   * \param priority the priority of the element, higher is more urgent.
+   */
+  inline void Push(T e, int priority = 0) {
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      queue_.push(Entry{priority, next_seq_++, e});
+    }
+    cv_.notify_one();
+  }
+  /*!
+   * \brief Push an element ahead of all the elements of the same priority.
+   * \param e the element.
+   * \param priority the priority of the element, higher is more urgent.
+   */
+  inline void PushFront(T e, int priority = 0) {
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      queue_.push(Entry{priority, next_front_seq_--, e});
+    }
+    cv_.notify_one();
+  }
+  /*!
+   * \brief Pop the most urgent element, blocking until one is available.
+   * \param rv the popped element.
+   * \return false if the queue has been signaled for kill.
+   */
+  inline bool Pop(T* rv) {
+    std::unique_lock<std::mutex> lock{mutex_};
+    cv_.wait(lock, [this] { return !queue_.empty() || exit_now_; });
+    if (exit_now_) return false;
+    *rv = queue_.top().value;
+    queue_.pop();
+    return true;
+  }
+  /*! \brief Wake up all the workers and make Pop return false. */
+  inline void SignalForKill() {
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      exit_now_ = true;
+    }
+    cv_.notify_all();
+  }
+  /*! \return number of elements in the queue. */
+  inline size_t Size() {
+    std::lock_guard<std::mutex> lock{mutex_};
+    return queue_.size();
+  }
+
+ private:
+  struct Entry {
+    int priority;
+    int64_t seq;
+    T value;
+    /*! \brief less urgent than */
+    bool operator<(const Entry& other) const {
+      return priority < other.priority ||
+          (priority == other.priority && seq > other.seq);
+    }
+  };
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::priority_queue<Entry> queue_;
+  /*! \brief sequence numbers of Push, increasing */
+  int64_t next_seq_{0};
+  /*! \brief sequence numbers of PushFront, decreasing */
+  int64_t next_front_seq_{-1};
+  bool exit_now_{false};
+  DISALLOW_COPY_AND_ASSIGN(PriorityTaskQueue);
+};
+
+}  // namespace engine
+}  // namespace mxnet
+#endif  // MXNET_ENGINE_PRIORITY_TASK_QUEUE_H_
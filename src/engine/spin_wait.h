@@ -0,0 +1,103 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file spin_wait.h
+ * \brief Spin, then yield, then block wait policy of the engine threads
+ */
+#ifndef MXNET_ENGINE_SPIN_WAIT_H_
+#define MXNET_ENGINE_SPIN_WAIT_H_
+
+#include <dmlc/parameter.h>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+namespace mxnet {
+namespace engine {
+
+/*!
+ * \brief Wait policy of the engine workers and of WaitForVar / WaitForAll.
+ *  A waiting thread first polls its condition for MXNET_ENGINE_SPIN_WAIT_US
+ *  microseconds, then polls it while yielding its core for MXNET_ENGINE_YIELD_WAIT_US
+ *  microseconds, and only then blocks on its condition variable. Both default to 0,
+ *  which blocks right away. Spinning trades CPU time for the wakeup latency of the
+ *  blocked threads, which matters to latency-sensitive inference.
+ *  Each engine reads the policy from the environment when it is created.
+ */
+class SpinWait {
+ public:
+  /*! \brief read the policy from the environment */
+  SpinWait()
+    : spin_(std::max(dmlc::GetEnv("MXNET_ENGINE_SPIN_WAIT_US", 0), 0)),
+      yield_(std::max(dmlc::GetEnv("MXNET_ENGINE_YIELD_WAIT_US", 0), 0)) {}
+  /*! \brief whether the waiting threads poll before blocking */
+  bool enabled() const {
+    return spin_.count() > 0 || yield_.count() > 0;
+  }
+  /*!
+   * \brief Poll ready() until it returns true or the polling budget is spent.
+   * \return whether ready() returned true, otherwise the caller should block.
+   */
+  template<typename Pred>
+  bool Poll(Pred ready) const {
+    if (!enabled()) return false;
+    using clock = std::chrono::steady_clock;
+    const auto spin_end = clock::now() + spin_;
+    const auto yield_end = spin_end + yield_;
+    while (!ready()) {
+      const auto now = clock::now();
+      if (now >= yield_end) return false;
+      if (now >= spin_end) {
+        std::this_thread::yield();
+      } else {
+        Relax();
+      }
+    }
+    return true;
+  }
+
+ private:
+  /*! \brief hint the core that the thread is spinning */
+  static inline void Relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield" ::: "memory");
+#endif
+  }
+
+  const std::chrono::microseconds spin_;
+  const std::chrono::microseconds yield_;
+};
+
+/*!
+ * \brief Pop from a task queue of the engine, polling it by the wait policy before
+ *        blocking in its Pop.
+ */
+template<typename Queue, typename T>
+inline bool SpinPop(const SpinWait& policy, Queue* queue, T* rv) {
+  policy.Poll([queue] { return queue->Size() > 0; });
+  return queue->Pop(rv);
+}
+
+}  // namespace engine
+}  // namespace mxnet
+
+#endif  // MXNET_ENGINE_SPIN_WAIT_H_
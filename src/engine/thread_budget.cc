@@ -0,0 +1,191 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file thread_budget.cc
+ * \brief Process-wide budget of the cores used by the thread pools outside the engine
+ */
+#include <dmlc/logging.h>
+#include <dmlc/parameter.h>
+#include <algorithm>
+#include <fstream>
+#include <thread>
+#include <utility>
+#include "./thread_budget.h"
+#include "./openmp.h"
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+namespace mxnet {
+namespace engine {
+
+namespace {
+
+/*!
+ * \brief Number of cores granted by the CPU quota of the cgroup of the process, or 0 if
+ *        there is no quota
+ */
+int CgroupCores() {
+#if defined(__linux__)
+  double quota = -1, period = 0;
+  std::ifstream v2("/sys/fs/cgroup/cpu.max");
+  if (v2.good()) {
+    std::string max;
+    if (v2 >> max >> period && max != "max") quota = std::stod(max);
+  } else {
+    std::ifstream q("/sys/fs/cgroup/cpu/cpu.cfs_quota_us");
+    std::ifstream p("/sys/fs/cgroup/cpu/cpu.cfs_period_us");
+    if (!(q >> quota && p >> period)) quota = -1;
+  }
+  if (quota > 0 && period > 0) {
+    return std::max(1, static_cast<int>((quota + period - 1) / period));
+  }
+#endif
+  return 0;
+}
+
+bool SetAffinity(const std::vector<int> &cpus) {
+#if defined(__linux__)
+  if (cpus.empty()) return false;
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (int cpu : cpus) {
+    if (cpu >= 0 && cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+  }
+  return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+  return false;
+#endif
+}
+
+}  // namespace
+
+ThreadBudget *ThreadBudget::Get() {
+  static ThreadBudget budget(dmlc::GetEnv("MXNET_THREAD_BUDGET", 0),
+                             dmlc::GetEnv("MXNET_THREAD_AFFINITY", false));
+  return &budget;
+}
+
+ThreadBudget::ThreadBudget(int budget, bool affinity) {
+  // 0 disables the budget, -1 detects the allotted cores, a positive value sets them
+  enabled_ = budget != 0;
+  affinity_ = enabled_ && affinity;
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &set)) cpus_.push_back(cpu);
+    }
+  }
+#endif
+  if (cpus_.empty()) {
+    const int n = std::max(1U, std::thread::hardware_concurrency());
+    for (int cpu = 0; cpu < n; ++cpu) cpus_.push_back(cpu);
+  }
+  const int quota = budget > 0 ? budget : CgroupCores();
+  if (quota > 0 && quota < cores()) cpus_.resize(quota);
+  leased_.resize(cpus_.size(), false);
+  if (enabled_ && OpenMP::Get()->thread_max() > cores()) {
+    OpenMP::Get()->set_thread_max(cores());
+  }
+}
+
+std::unique_ptr<ThreadBudget::Lease> ThreadBudget::Acquire(const std::string &consumer,
+                                                           int wanted) {
+  wanted = std::max(wanted, 1);
+  if (!enabled_) {
+    return std::unique_ptr<Lease>(new Lease(this, consumer, {}, std::vector<int>(wanted, -1)));
+  }
+  std::vector<int> slots, cpus;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // one core is always left to the engine
+    const int granted = std::min(wanted, cores() - 1 - num_leased_);
+    for (int i = cores() - 1; i >= 0 && static_cast<int>(slots.size()) < granted; --i) {
+      if (!leased_[i]) {
+        leased_[i] = true;
+        slots.push_back(i);
+        cpus.push_back(cpus_[i]);
+      }
+    }
+    num_leased_ += static_cast<int>(slots.size());
+    OpenMP::Get()->set_leased_cores(num_leased_);
+  }
+  if (cpus.empty()) {
+    // no core is left, the pool runs unbound on a single thread
+    cpus.push_back(-1);
+  }
+  if (static_cast<int>(cpus.size()) < wanted) {
+    LOG(INFO) << consumer << " gets " << cpus.size() << " of the " << wanted
+              << " threads it asked for, the thread budget has " << cores() << " cores";
+  }
+  return std::unique_ptr<Lease>(new Lease(this, consumer, std::move(slots), std::move(cpus)));
+}
+
+void ThreadBudget::Release(const Lease &lease) {
+  if (lease.slots_.empty()) return;
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (int i : lease.slots_) leased_[i] = false;
+  num_leased_ -= static_cast<int>(lease.slots_.size());
+  OpenMP::Get()->set_leased_cores(num_leased_);
+}
+
+void ThreadBudget::BindWorkerThread() const {
+  if (!affinity_) return;
+  std::vector<int> cpus;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (int i = 0; i < cores(); ++i) {
+      if (!leased_[i]) cpus.push_back(cpus_[i]);
+    }
+  }
+  if (!SetAffinity(cpus)) {
+    LOG(WARNING) << "Failed to bind an engine worker to the cores left by the thread budget";
+  }
+}
+
+ThreadBudget::Lease::Lease(ThreadBudget *budget, std::string consumer, std::vector<int> slots,
+                           std::vector<int> cores)
+  : budget_(budget), consumer_(std::move(consumer)), slots_(std::move(slots)),
+    cores_(std::move(cores)) {}
+
+ThreadBudget::Lease::~Lease() {
+  budget_->Release(*this);
+}
+
+void ThreadBudget::Lease::BindThread(int index) const {
+  if (!budget_->affinity_) return;
+  const int cpu = cores_[index % cores_.size()];
+  if (cpu < 0) return;
+  // pool threads are reused across parallel regions, bind each of them once per lease
+  static thread_local const Lease *bound_lease = nullptr;
+  static thread_local int bound_cpu = -1;
+  if (bound_lease == this && bound_cpu == cpu) return;
+  if (!SetAffinity({cpu})) {
+    LOG(WARNING) << "Failed to bind a thread of " << consumer_ << " to core " << cpu;
+  }
+  bound_lease = this;
+  bound_cpu = cpu;
+}
+
+}  // namespace engine
+}  // namespace mxnet
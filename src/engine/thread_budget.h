@@ -0,0 +1,115 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file thread_budget.h
+ * \brief Process-wide budget of the cores used by the thread pools outside the engine
+ */
+#ifndef MXNET_ENGINE_THREAD_BUDGET_H_
+#define MXNET_ENGINE_THREAD_BUDGET_H_
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace mxnet {
+namespace engine {
+
+/*! \brief Process-wide budget of cores, enabled by MXNET_THREAD_BUDGET
+ *         The thread pools started outside of the engine (data loading, image decoding,
+ *         CPU kvstore reduction) lease their threads from the budget. Each lease gets a
+ *         partition of the cores allotted to the process, taken from the last ones, and the
+ *         leased cores are excluded from the OMP regions of the engine, so that the runnable
+ *         threads do not exceed the allotted cores. With MXNET_THREAD_AFFINITY the leased
+ *         threads are bound to their partition, and the engine workers to the other cores.
+ */
+class ThreadBudget {
+ public:
+  /*! \brief Threads leased from the budget, returned on destruction */
+  class Lease {
+   public:
+    ~Lease();
+    /*! \brief Number of threads granted */
+    int threads() const { return static_cast<int>(cores_.size()); }
+    /*!
+     * \brief Bind the calling thread to a core of the partition, if affinity is enabled
+     * \param index Index of the thread in the pool, e.g. omp_get_thread_num()
+     */
+    void BindThread(int index) const;
+
+   private:
+    friend class ThreadBudget;
+    Lease(ThreadBudget *budget, std::string consumer, std::vector<int> slots,
+          std::vector<int> cores);
+    /*! \brief The budget the threads are leased from */
+    ThreadBudget *const budget_;
+    const std::string consumer_;
+    /*! \brief Indices of the leased cores in the allotted cores */
+    const std::vector<int> slots_;
+    /*! \brief CPU ids of the leased cores */
+    const std::vector<int> cores_;
+  };
+
+  /*!
+   * \brief Create a budget, the process-wide one is created by Get() from the environment
+   * \param budget 0 disables the budget, -1 detects the allotted cores and a positive value
+   *        allots the first cores of the affinity mask, as MXNET_THREAD_BUDGET
+   * \param affinity Whether to bind the threads to their cores, as MXNET_THREAD_AFFINITY
+   */
+  ThreadBudget(int budget, bool affinity);
+
+  /*!
+   * \brief Lease threads from the budget. At least one thread is granted, and all of them
+   *        when the budget is disabled
+   * \param consumer Name of the thread pool, for logging
+   * \param wanted Number of threads wanted
+   */
+  std::unique_ptr<Lease> Acquire(const std::string &consumer, int wanted);
+
+  /*! \brief Whether the budget is enabled */
+  bool enabled() const { return enabled_; }
+  /*! \brief Number of cores allotted to the process */
+  int cores() const { return static_cast<int>(cpus_.size()); }
+  /*! \brief Bind the calling engine worker to the cores which are not leased */
+  void BindWorkerThread() const;
+
+  /*!
+   * \brief Get the ThreadBudget object's singleton pointer
+   * \return Singleton ThreadBudget object pointer
+   */
+  static ThreadBudget *Get();
+
+ private:
+  void Release(const Lease &lease);
+
+  bool enabled_ = false;
+  bool affinity_ = false;
+  /*! \brief CPU ids of the cores allotted to the process */
+  std::vector<int> cpus_;
+  /*! \brief Whether each allotted core is leased */
+  std::vector<bool> leased_;
+  int num_leased_ = 0;
+  mutable std::mutex mutex_;
+};
+
+}  // namespace engine
+}  // namespace mxnet
+
+#endif  // MXNET_ENGINE_THREAD_BUDGET_H_
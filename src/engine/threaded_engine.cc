@@ -30,6 +30,7 @@
 #include <mutex>
 #include <utility>
 #include "./threaded_engine.h"
+#include "./spin_wait.h"
 #include "../common/cuda/utils.h"
 
 namespace mxnet {
@@ -49,24 +50,33 @@ ThreadedVar::ThreadedVar(VersionedVarBlock* head) : head_{head} {
 }
 
 inline void ThreadedVar::AppendReadDependency(OprBlock* opr_block) {
+  // fast path: no pending write, only the read counter changes
+  uint64_t state = state_.load();
+  while (!has_pending_write(state)) {
+    CHECK_GE(pending_reads(state), 0);
+    if (state_.compare_exchange_weak(state, state + 1)) {
+      opr_block->decr_wait();
+      return;
+    }
+  }
+  // slow path: queue the read behind the pending write
+  auto&& new_var_block = VersionedVarBlock::New();
   std::lock_guard<std::mutex> lock{mutex_};
-  if (pending_write_ == nullptr) {
-    // invariant: is_ready_to_read()
-    CHECK_GE(num_pending_reads_, 0);
-    // STATE CHANGE
-    ++num_pending_reads_;
-    // decrease wait counter
+  state = state_.load();
+  if (!has_pending_write(state)) {
+    // the write completed meanwhile, the counter can only be raced by other readers
+    while (!state_.compare_exchange_weak(state, state + 1)) {}
+    VersionedVarBlock::Delete(new_var_block);
     opr_block->decr_wait();
-  } else {
-    auto&& new_var_block = VersionedVarBlock::New();
-    assert(head_->next == nullptr);
-    assert(head_->trigger == nullptr);
-    assert(head_->write == false);
-    // append things to next.
-    head_->next = new_var_block;
-    head_->trigger = opr_block;
-    head_ = new_var_block;
+    return;
   }
+  assert(head_->next == nullptr);
+  assert(head_->trigger == nullptr);
+  assert(head_->write == false);
+  // append things to next.
+  head_->next = new_var_block;
+  head_->trigger = opr_block;
+  head_ = new_var_block;
 }
 
 inline void ThreadedVar::AppendWriteDependency(OprBlock* opr_block) {
@@ -85,36 +95,44 @@ inline void ThreadedVar::AppendWriteDependency(OprBlock* opr_block) {
   if (pending_write_ == nullptr) {
     // invariant: is_ready_to_read()
     pending_write_ = head_;
-    CHECK_GE(num_pending_reads_, 0);
-    if (num_pending_reads_ == 0) {
+    // readers may still complete concurrently until the flag is published
+    uint64_t state = state_.load();
+    bool trigger = false;
+    do {
+      CHECK_GE(pending_reads(state), 0);
+      trigger = pending_reads(state) == 0;
+    } while (!state_.compare_exchange_weak(
+        state, make_state(trigger ? kWriteTriggered : pending_reads(state), true)));
+    if (trigger) {
       // STATE CHANGE
       opr_block->decr_wait();
-      num_pending_reads_ = kWriteTriggered;
     }
   } else {
-    CHECK_NE(num_pending_reads_, 0);
+    CHECK_NE(pending_reads(state_.load()), 0);
   }
   head_ = new_var_block;
 }
 
 template <typename Dispatcher>
 inline void ThreadedVar::CompleteReadDependency(Dispatcher dispatcher) {
-  OprBlock *trigger = nullptr;
-  {
-    // this is lock scope
-    std::lock_guard<std::mutex> lock{mutex_};
-    CHECK_GT(num_pending_reads_, 0);
-
-    if (--num_pending_reads_ == 0) {
-      if (pending_write_ != nullptr) {
-        // STATE CHANGE
-        trigger = pending_write_->trigger;
-        num_pending_reads_ = kWriteTriggered;
-      }
+  uint64_t state = state_.load();
+  uint64_t next;
+  do {
+    const int num_pending_reads = pending_reads(state);
+    CHECK_GT(num_pending_reads, 0);
+    if (num_pending_reads == 1 && has_pending_write(state)) {
+      // STATE CHANGE
+      next = make_state(kWriteTriggered, true);
+    } else {
+      next = state - 1;
+    }
+  } while (!state_.compare_exchange_weak(state, next));
+  if (pending_reads(next) == kWriteTriggered) {
+    // pending_write_ cannot change before the write we just triggered completes
+    OprBlock *trigger = pending_write_->trigger;
+    if (trigger->decr_wait() == 0) {
+      dispatcher(trigger);
     }
-  }
-  if (trigger != nullptr && trigger->decr_wait() == 0) {
-    dispatcher(trigger);
   }
 }
 
@@ -128,7 +146,8 @@ inline bool ThreadedVar::CompleteWriteDependency(Dispatcher dispatcher) {
     // invariants
     assert(head_->next == nullptr);
     assert(pending_write_ != nullptr);
-    CHECK_EQ(num_pending_reads_, kWriteTriggered);
+    // readers cannot touch state_ while a write is triggered
+    CHECK_EQ(pending_reads(state_.load()), kWriteTriggered);
 
     // increment version number
     ++version_;
@@ -146,10 +165,10 @@ inline bool ThreadedVar::CompleteWriteDependency(Dispatcher dispatcher) {
     // search for chains to trigger
     end_of_read_chain = old_pending_write->next;
     // reset to 0 pending reads
-    num_pending_reads_ = 0;
+    int num_pending_reads = 0;
     while (end_of_read_chain != head_ &&
            end_of_read_chain->write == false) {
-      ++num_pending_reads_;
+      ++num_pending_reads;
       end_of_read_chain = end_of_read_chain->next;
     }
     if (end_of_read_chain == head_) {
@@ -158,15 +177,16 @@ inline bool ThreadedVar::CompleteWriteDependency(Dispatcher dispatcher) {
       // check if there is pending reads, if not trigger write
       assert(end_of_read_chain->write == true);
       pending_write_ = end_of_read_chain;
-      if (num_pending_reads_ == 0) {
+      if (num_pending_reads == 0) {
         // mark write as already activated in this var
-        num_pending_reads_ = kWriteTriggered;
+        num_pending_reads = kWriteTriggered;
         trigger_write = end_of_read_chain->trigger;
       }
     }
+    state_.store(make_state(num_pending_reads, pending_write_ != nullptr));
   }
   // This is outside of lock scope
-  // Be very carful, pending_write_ and num_pending_reads_
+  // Be very carful, pending_write_ and state_
   // can change now, do not rely on these two variables.
   // The linked list \in [old_pending_write, end_of_read_chain)
   // is already detached from this Var.
@@ -195,7 +215,6 @@ inline void ThreadedVar::SetToDelete() {
 }
 
 inline bool ThreadedVar::ready_to_read() {
-  std::lock_guard<std::mutex> lock{mutex_};
   return this->is_ready_to_read();
 }
 
@@ -288,6 +307,7 @@ void ThreadedEngine::DeleteOperator(OprHandle op) {
 void ThreadedEngine::Push(OprHandle op, Context exec_ctx, int priority, bool profiling) {
   BulkFlush();
   ThreadedOpr* threaded_opr = ThreadedOpr::CastFromBase(op);
+  profiling = profiling && profiler_->SampleOperator();
   if (profiling) {
     threaded_opr->opr_name =
         profiler::CustomOpProfiler::Get()->GenerateDisplayName(threaded_opr->opr_name.c_str());
@@ -299,9 +319,20 @@ void ThreadedEngine::Push(OprHandle op, Context exec_ctx, int priority, bool pro
       threaded_opr->const_vars.size() +
       threaded_opr->mutable_vars.size() + 1));
   opr_block->ctx = exec_ctx;
-  opr_block->priority = priority;
+  opr_block->priority = priority + push_priority();
   opr_block->profiling = profiling;
+  opr_block->request_id = 0;
+  if (profiling) {
+    opr_block->push_time = profiler::ProfileStat::NowInMicrosec();
+    opr_block->request_id = profiler::CurrentRequestId();
+  }
+  opr_block->wait_tag = wait_tag();
   ++pending_;
+  ++ctx_pending_[ContextIndex(exec_ctx)];
+  if (opr_block->wait_tag != 0) {
+    std::lock_guard<std::mutex> lock{finished_m_};
+    AddTagOperations(opr_block->wait_tag, exec_ctx, 1);
+  }
   // Add read dependencies.
   for (auto&& i : threaded_opr->const_vars) {
     i->AppendReadDependency(opr_block);
@@ -311,7 +342,57 @@ void ThreadedEngine::Push(OprHandle op, Context exec_ctx, int priority, bool pro
     i->AppendWriteDependency(opr_block);
   }
   if (opr_block->decr_wait() == 0) {
-    this->PushToExecute(opr_block, true);
+    this->DispatchReady(opr_block, true);
+  }
+}
+
+void ThreadedEngine::PushBatch(const std::vector<OprHandle>& oprs, Context exec_ctx,
+                               int priority, bool profiling) {
+  if (oprs.empty()) return;
+  BulkFlush();
+  const size_t num_oprs = oprs.size();
+  std::vector<OprBlock*> opr_blocks(num_oprs);
+  OprBlock::NewBatch(num_oprs, opr_blocks.data());
+  pending_ += static_cast<int>(num_oprs);
+  ctx_pending_[ContextIndex(exec_ctx)] += static_cast<int>(num_oprs);
+  const int tag = wait_tag();
+  if (tag != 0) {
+    std::lock_guard<std::mutex> lock{finished_m_};
+    AddTagOperations(tag, exec_ctx, static_cast<int>(num_oprs));
+  }
+  priority += push_priority();
+  const uint64_t push_time = profiling ? profiler::ProfileStat::NowInMicrosec() : 0;
+  const uint32_t request_id = profiling ? profiler::CurrentRequestId() : 0;
+  for (size_t k = 0; k < num_oprs; ++k) {
+    ThreadedOpr* threaded_opr = ThreadedOpr::CastFromBase(oprs[k]);
+    const bool sampled = profiling && profiler_->SampleOperator();
+    if (sampled) {
+      threaded_opr->opr_name =
+          profiler::CustomOpProfiler::Get()->GenerateDisplayName(threaded_opr->opr_name.c_str());
+    }
+    OprBlock* opr_block = opr_blocks[k];
+    opr_block->opr = threaded_opr;
+    // the extra wait is held until the whole batch is registered
+    opr_block->wait.store(static_cast<int>(
+        threaded_opr->const_vars.size() +
+        threaded_opr->mutable_vars.size() + 1));
+    opr_block->ctx = exec_ctx;
+    opr_block->priority = priority;
+    opr_block->profiling = sampled;
+    opr_block->push_time = push_time;
+    opr_block->request_id = sampled ? request_id : 0;
+    opr_block->wait_tag = tag;
+    for (auto&& i : threaded_opr->const_vars) {
+      i->AppendReadDependency(opr_block);
+    }
+    for (auto&& i : threaded_opr->mutable_vars) {
+      i->AppendWriteDependency(opr_block);
+    }
+  }
+  for (OprBlock* opr_block : opr_blocks) {
+    if (opr_block->decr_wait() == 0) {
+      this->DispatchReady(opr_block, true);
+    }
   }
 }
 
@@ -380,6 +461,7 @@ void ThreadedEngine::WaitForVar(VarHandle var) {
   BulkFlush();
   ThreadedVar* threaded_var = ThreadedVar::CastFromBase(var);
   if (threaded_var->ready_to_read()) {
+    WaitGPUWrite(threaded_var);
     ThrowException(threaded_var);
     return;
   }
@@ -403,6 +485,7 @@ void ThreadedEngine::WaitForVar(VarHandle var) {
       on_complete();
     }, Context::CPU(), {var}, {}, FnProperty::kNormal, 0,
     "WaitForVar", true);
+  spin_wait_.Poll([this, &done]() { return done.load() || kill_.load(); });
   {
     std::unique_lock<std::mutex> lock{finished_m_};
     finished_cv_.wait(lock, [this, &done]() {
@@ -415,10 +498,21 @@ void ThreadedEngine::WaitForVar(VarHandle var) {
 
 void ThreadedEngine::WaitForAll() {
   BulkFlush();
+  spin_wait_.Poll([this]() { return pending_.load() == 0 || kill_.load(); });
   std::unique_lock<std::mutex> lock{finished_m_};
   finished_cv_.wait(lock, [this]() {
       return pending_.load() == 0 || kill_.load();
     });
+#if MXNET_USE_CUDA
+  if (gpu_event_sync_) {
+    // all operations completed, but their GPU work may still be running
+    std::lock_guard<std::mutex> devices_lock(event_devices_m_);
+    for (int dev_id : event_devices_) {
+      common::cuda::DeviceStore device_store(dev_id);
+      CUDA_CALL(cudaDeviceSynchronize());
+    }
+  }
+#endif
   std::exception_ptr exception_to_rethrow = nullptr;
   if (!global_exception_refs_.empty()) {
     // iterate through all exception refs
@@ -438,12 +532,70 @@ void ThreadedEngine::WaitForAll() {
   }
 }
 
-inline void ThreadedEngine::OnComplete(ThreadedOpr* threaded_opr) {
+void ThreadedEngine::WaitForContext(Context ctx) {
+  BulkFlush();
+  const std::atomic<int>& pending = ctx_pending_[ContextIndex(ctx)];
+  spin_wait_.Poll([this, &pending]() { return pending.load() == 0 || kill_.load(); });
+  {
+    std::unique_lock<std::mutex> lock{finished_m_};
+    finished_cv_.wait(lock, [this, &pending]() {
+        return pending.load() == 0 || kill_.load();
+      });
+  }
+#if MXNET_USE_CUDA
+  if (gpu_event_sync_ && ctx.dev_mask() == gpu::kDevMask) {
+    // the operations completed, but their GPU work may still be running
+    std::lock_guard<std::mutex> devices_lock(event_devices_m_);
+    if (event_devices_.count(ctx.dev_id)) {
+      common::cuda::DeviceStore device_store(ctx.dev_id);
+      CUDA_CALL(cudaDeviceSynchronize());
+    }
+  }
+#endif
+}
+
+void ThreadedEngine::WaitForTag(int tag) {
+  CHECK_NE(tag, 0) << "The operations without a tag are waited for by WaitForAll";
+  BulkFlush();
+  uint64_t gpus = 0;
+  {
+    std::unique_lock<std::mutex> lock{finished_m_};
+    auto it = tag_pending_.find(tag);
+    if (it == tag_pending_.end()) {
+      // the status of completed operations is erased, their GPUs are not known anymore
+      gpus = ~uint64_t{0};
+    } else {
+      // references to the map elements stay valid while other tags are added
+      TagStatus& status = it->second;
+      ++status.waiters;
+      finished_cv_.wait(lock, [this, &status]() {
+          return status.pending == 0 || kill_.load();
+        });
+      gpus = status.gpus;
+      if (--status.waiters == 0 && status.pending == 0) {
+        tag_pending_.erase(tag);
+      }
+    }
+  }
+#if MXNET_USE_CUDA
+  if (gpu_event_sync_) {
+    std::lock_guard<std::mutex> devices_lock(event_devices_m_);
+    for (int dev_id : event_devices_) {
+      if (!(gpus & (uint64_t{1} << (dev_id % 64)))) continue;
+      common::cuda::DeviceStore device_store(dev_id);
+      CUDA_CALL(cudaDeviceSynchronize());
+    }
+  }
+#endif
+}
+
+inline void ThreadedEngine::OnComplete(ThreadedOpr* threaded_opr, const Context& ctx,
+                                       int wait_tag) {
   bool is_temporary_opr = threaded_opr->temporary;
   // Mark complete for read variables
   for (auto&& i : threaded_opr->const_vars) {
     i->CompleteReadDependency(
-        [this](OprBlock* opr) { this->PushToExecute(opr, false); });
+        [this](OprBlock* opr) { this->DispatchReady(opr, false); });
   }
   // Mark complete for write variables.
   for (auto&& i : threaded_opr->mutable_vars) {
@@ -463,7 +615,7 @@ inline void ThreadedEngine::OnComplete(ThreadedOpr* threaded_opr) {
             LOG(INFO) << "PushToExecute " << opr;
             debug_push_opr_ = opr;
           }
-          this->PushToExecute(opr, false);
+          this->DispatchReady(opr, false);
           if (debug_info) {
             LOG(INFO) << "Fin PushToExecute " << opr;
           }
@@ -477,12 +629,22 @@ inline void ThreadedEngine::OnComplete(ThreadedOpr* threaded_opr) {
   // threaded_opr is not temporary, its value is not reliable
   // anymore start from here.
   int npending = 0;
+  bool ctx_done = false, tag_done = false;
   {
     std::unique_lock<std::mutex> lock{finished_m_};
     npending = --pending_;
+    ctx_done = --ctx_pending_[ContextIndex(ctx)] == 0;
+    if (wait_tag != 0) {
+      // the status is kept for the GPUs of the waiters, which erase it
+      auto it = tag_pending_.find(wait_tag);
+      tag_done = --it->second.pending == 0;
+      if (tag_done && it->second.waiters == 0) {
+        tag_pending_.erase(it);
+      }
+    }
   }
   CHECK_GE(npending, 0);
-  if (npending == 0) {
+  if (npending == 0 || ctx_done || tag_done) {
     // no need to grab lock when notify.
     finished_cv_.notify_all();
   }
@@ -507,6 +669,78 @@ void ThreadedEngine::Throw(VarHandle var) {
   ThrowException(threaded_var);
 }
 
+void ThreadedEngine::WaitGPUEvents(const RunContext& run_ctx, ThreadedOpr* threaded_opr) {
+#if MXNET_USE_CUDA
+  cudaStream_t stream = run_ctx.event_sync ? run_ctx.get_stream<gpu>()->stream_ : nullptr;
+  auto wait = [stream](const GPUEventRef& event) {
+    // work queued on the same stream is already ordered
+    if (event == nullptr || event->stream == stream) return;
+    if (stream != nullptr) {
+      CUDA_CALL(cudaStreamWaitEvent(stream, event->event, 0));
+    } else {
+      CUDA_CALL(cudaEventSynchronize(event->event));
+    }
+  };
+  std::vector<GPUEventRef> events;
+  for (auto* var : threaded_opr->const_vars) {
+    std::lock_guard<std::mutex> lock(var->event_mutex);
+    events.push_back(var->write_event);
+  }
+  // a write also waits for the reads since the previous write
+  for (auto* var : threaded_opr->mutable_vars) {
+    std::lock_guard<std::mutex> lock(var->event_mutex);
+    events.push_back(var->write_event);
+    events.insert(events.end(), var->read_events.begin(), var->read_events.end());
+  }
+  for (const auto& event : events) wait(event);
+#endif
+}
+
+void ThreadedEngine::RecordGPUEvent(OprBlock* opr_block) {
+#if MXNET_USE_CUDA
+  auto* stream = static_cast<mshadow::Stream<gpu>*>(opr_block->event_stream);
+  const int dev_id = opr_block->ctx.dev_id;
+  GPUEventRef event;
+  {
+    common::cuda::DeviceStore device_store(dev_id);
+    event = std::make_shared<GPUEvent>(stream->stream_);
+  }
+  {
+    std::lock_guard<std::mutex> lock(event_devices_m_);
+    event_devices_.insert(dev_id);
+  }
+  ThreadedOpr* threaded_opr = opr_block->opr;
+  for (auto* var : threaded_opr->const_vars) {
+    std::lock_guard<std::mutex> lock(var->event_mutex);
+    // an event supersedes the earlier ones of its stream
+    auto it = std::find_if(var->read_events.begin(), var->read_events.end(),
+                           [&event](const GPUEventRef& e) { return e->stream == event->stream; });
+    if (it != var->read_events.end()) {
+      *it = event;
+    } else {
+      var->read_events.push_back(event);
+    }
+  }
+  for (auto* var : threaded_opr->mutable_vars) {
+    std::lock_guard<std::mutex> lock(var->event_mutex);
+    var->write_event = event;
+    var->read_events.clear();
+  }
+#endif
+}
+
+void ThreadedEngine::WaitGPUWrite(ThreadedVar* threaded_var) {
+#if MXNET_USE_CUDA
+  if (!gpu_event_sync_) return;
+  GPUEventRef event;
+  {
+    std::lock_guard<std::mutex> lock(threaded_var->event_mutex);
+    event = threaded_var->write_event;
+  }
+  if (event != nullptr) CUDA_CALL(cudaEventSynchronize(event->event));
+#endif
+}
+
 void ThreadedEngine::OnCompleteStatic(Engine *engine, void *opr_block_,
                                       const dmlc::Error* error) {
   OprBlock *opr_block = static_cast<OprBlock*>(opr_block_);
@@ -515,11 +749,15 @@ void ThreadedEngine::OnCompleteStatic(Engine *engine, void *opr_block_,
     auto ex_p = std::make_exception_ptr(*error);
     threaded_opr->opr_exception = std::make_shared<std::exception_ptr>(ex_p);
   }
+  if (opr_block->event_stream != nullptr) {
+    static_cast<ThreadedEngine*>(engine)->RecordGPUEvent(opr_block);
+  }
   if (opr_block->profiling && threaded_opr->opr_name.size()) {
     // record operator end timestamp
     opr_block->opr_profile->stop();
   }
-  static_cast<ThreadedEngine*>(engine)->OnComplete(threaded_opr);
+  static_cast<ThreadedEngine*>(engine)->OnComplete(threaded_opr, opr_block->ctx,
+                                                    opr_block->wait_tag);
   OprBlock::Delete(opr_block);
 }
 
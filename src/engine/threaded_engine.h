@@ -31,6 +31,9 @@
 #include <dmlc/logging.h>
 #include <dmlc/omp.h>
 #include <mxnet/storage.h>
+#include <algorithm>
+#include <array>
+#include <cstdint>
 #include <vector>
 #include <functional>
 #include <condition_variable>
@@ -39,11 +42,17 @@
 #include <mutex>
 #include <string>
 #include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include "./engine_impl.h"
 #include "../profiler/profiler.h"
 #include "./openmp.h"
+#include "./spin_wait.h"
 #include "../common/object_pool.h"
 #include "../profiler/custom_op_profiler.h"
+#if MXNET_USE_CUDA
+#include "../common/cuda/utils.h"
+#endif
 
 namespace mxnet {
 namespace engine {
@@ -64,6 +73,29 @@ struct ThreadedOpr;
 /*! shared_ptr to exception_ptr, used for exception handling */
 typedef std::shared_ptr<std::exception_ptr> ExceptionRef;
 
+#if MXNET_USE_CUDA
+/*!
+ * \brief CUDA event marking the end of the work an operation queued on a stream.
+ *  Used when MXNET_ENGINE_GPU_EVENT_SYNC is set, instead of waiting for the stream.
+ */
+struct GPUEvent {
+  cudaEvent_t event;
+  /*! \brief the stream the event was recorded on */
+  cudaStream_t stream;
+  /*! \brief create the event and record it on the stream, on the current device */
+  explicit GPUEvent(cudaStream_t s) : stream(s) {
+    CUDA_CALL(cudaEventCreateWithFlags(&event, cudaEventDisableTiming));
+    CUDA_CALL(cudaEventRecord(event, stream));
+  }
+  ~GPUEvent() {
+    // Ignore the error during driver shutdown
+    cudaEventDestroy(event);
+  }
+  DISALLOW_COPY_AND_ASSIGN(GPUEvent);
+};
+typedef std::shared_ptr<GPUEvent> GPUEventRef;
+#endif
+
 /*!
  * \brief Operation block in the scheduler.
  *  Each OprBlock corresponds to an operation pushed to the engine.
@@ -83,6 +115,18 @@ struct OprBlock : public common::ObjectPoolAllocatable<OprBlock> {
   bool profiling{false};
   /*! \brief operator execution statistics */
   std::unique_ptr<profiler::ProfileOperator> opr_profile;
+  /*! \brief time the operator was pushed, in microseconds, only set when profiling */
+  uint64_t push_time{0};
+  /*! \brief time the operator was handed to a worker queue, only set when profiling */
+  uint64_t enqueue_time{0};
+  /*! \brief request of the pushing thread, only set when profiling */
+  uint32_t request_id{0};
+  /*! \brief tag of the pushing thread, see Engine::set_wait_tag */
+  int wait_tag{0};
+  /*!
+   * \brief the GPU stream the operation ran on, when its completion is tracked with an event
+   */
+  void* event_stream{nullptr};
   // define possible debug information
   DEFINE_ENGINE_DEBUG_INFO(OprBlock);
   /*!
@@ -187,17 +231,29 @@ class ThreadedVar final
    * exception_ptr is undefined behavior. Using shared_ptr to hold
    * exception_ptr and overcome this limitation */
   ExceptionRef var_exception;
+#if MXNET_USE_CUDA
+  /*! \brief guards write_event and read_events */
+  std::mutex event_mutex;
+  /*! \brief event of the last write on a GPU stream */
+  GPUEventRef write_event;
+  /*! \brief latest event per GPU stream of the reads since the last write */
+  std::vector<GPUEventRef> read_events;
+#endif
 
  private:
-  // TODO(hotpxl) change this to spinlock for faster runtime
-  // TODO(hotpxl) consider rename head
-  /*! \brief internal mutex of the ThreadedVar */
+  /*!
+   * \brief internal mutex of the ThreadedVar.
+   *  Only taken on the slow paths, i.e. when the version list has to be modified.
+   *  Reads appended to or completed on a var without pending write only touch state_.
+   */
   std::mutex mutex_;
   /*!
-   * \brief number of pending reads operation in the variable.
-   *  will be marked as -1 when there is a already triggered pending write.
+   * \brief packed dependency state, updated with compare-and-swap.
+   *  The low 32 bits hold the number of pending reads operation in the variable,
+   *  which is kWriteTriggered when there is a already triggered pending write.
+   *  Bit kPendingWriteBit is set iff pending_write_ != nullptr.
    */
-  int num_pending_reads_{0};
+  std::atomic<uint64_t> state_{0};
   /*!
    * \brief Points to the last VersionedVarBlock in the queue.
    *  head_ always points to a empty VersionedVarBlock.
@@ -209,7 +265,7 @@ class ThreadedVar final
   VersionedVarBlock* head_{nullptr};
   /*!
    * \brief The pointer to next write to perform.
-   *  This pointer will only be updated when the write completes.
+   *  This pointer will only be updated under mutex_ when the write completes.
    *  This is actually the head(oldest operation) in the queue.
    */
   VersionedVarBlock* pending_write_{nullptr};
@@ -217,14 +273,29 @@ class ThreadedVar final
    * \brief If true, delete after operation completes.
    */
   bool to_delete_{false};
-  /*! \brief special const on num_pending_reads_ to mark write being triggered */
+  /*! \brief special const on pending reads to mark write being triggered */
   static constexpr int kWriteTriggered = -1;
+  /*! \brief flag in state_ marking a pending write */
+  static constexpr uint64_t kPendingWriteBit = 1ULL << 32;
+  /*! \return number of pending reads stored in a state word */
+  static inline int pending_reads(uint64_t state) {
+    return static_cast<int32_t>(static_cast<uint32_t>(state));
+  }
+  /*! \return whether a state word has a pending write */
+  static inline bool has_pending_write(uint64_t state) {
+    return (state & kPendingWriteBit) != 0;
+  }
+  /*! \return the state word for the given pending reads and write */
+  static inline uint64_t make_state(int num_pending_reads, bool pending_write) {
+    return static_cast<uint64_t>(static_cast<uint32_t>(num_pending_reads)) |
+        (pending_write ? kPendingWriteBit : 0);
+  }
   /*!
    * \brief derived invariant of ready to ready, without lock.
    * \return whether the current variable is ready to read.
    */
   inline bool is_ready_to_read() const {
-    return pending_write_ == nullptr;
+    return !has_pending_write(state_.load());
   }
 };  // struct ThreadedVar
 
@@ -291,6 +362,8 @@ class ThreadedEngine : public Engine {
                            bool wait = false) override;
   void DeleteOperator(OprHandle op) override;
   void Push(OprHandle op, Context exec_ctx, int priority = 0, bool profiling = false) override;
+  void PushBatch(const std::vector<OprHandle>& oprs, Context exec_ctx,
+                 int priority = 0, bool profiling = false) override;
   void PushAsync(AsyncFn exec_fun, Context exec_ctx,
                  std::vector<VarHandle> const& const_vars,
                  std::vector<VarHandle> const& mutable_vars,
@@ -307,6 +380,8 @@ class ThreadedEngine : public Engine {
   void DeleteVariable(SyncFn delete_fn, Context exec_ctx, VarHandle var) override;
   void WaitForVar(VarHandle var) override;
   void WaitForAll() override;
+  void WaitForContext(Context ctx) override;
+  void WaitForTag(int tag) override;
   void Throw(VarHandle var) override;
   void NotifyShutdown() override {
     shutdown_phase_.store(true);
@@ -314,6 +389,9 @@ class ThreadedEngine : public Engine {
 
   ThreadedEngine() {
     engine_info_ = dmlc::GetEnv("MXNET_ENGINE_INFO", false);
+#if MXNET_USE_CUDA
+    gpu_event_sync_ = dmlc::GetEnv("MXNET_ENGINE_GPU_EVENT_SYNC", false);
+#endif
 
     objpool_opr_ref_    = common::ObjectPool<ThreadedOpr>::_GetSharedRef();
     objpool_blk_ref_    = common::ObjectPool<OprBlock>::_GetSharedRef();
@@ -343,6 +421,26 @@ class ThreadedEngine : public Engine {
    * \param pusher_thread whether the caller is the thread that calls push
    */
   virtual void PushToExecute(OprBlock* opr_block, bool pusher_thread) = 0;
+  /*! \return the wait policy of the worker threads */
+  const SpinWait& spin_wait() const {
+    return spin_wait_;
+  }
+  /*! \return whether GPU operations complete without waiting for their stream */
+  bool gpu_event_sync() const {
+    return gpu_event_sync_;
+  }
+  /*!
+   * \brief Hand an opr_block whose dependencies are satisfied to PushToExecute,
+   *  recording the time for the scheduling statistics of the profiler.
+   * \param opr_block The operator block.
+   * \param pusher_thread whether the caller is the thread that calls push
+   */
+  inline void DispatchReady(OprBlock* opr_block, bool pusher_thread) {
+    if (opr_block->profiling) {
+      opr_block->enqueue_time = profiler::ProfileStat::NowInMicrosec();
+    }
+    this->PushToExecute(opr_block, pusher_thread);
+  }
   /*!
    * \brief Call this function to actually execute an opr_block
    *  This function also deletes the opr_block after execution.
@@ -351,6 +449,10 @@ class ThreadedEngine : public Engine {
    */
   void ExecuteOprBlock(RunContext run_ctx, OprBlock* opr_block) {
     ThreadedOpr* threaded_opr = opr_block->opr;
+    // the operator, its allocations and the operators it pushes work for its request,
+    // asynchronous operators may run on the pushing thread which keeps its own
+    const uint32_t thread_request_id = profiler::CurrentRequestId();
+    profiler::CurrentRequestId() = opr_block->request_id;
     if (opr_block->profiling && threaded_opr->opr_name.size()) {
       std::unique_ptr<profiler::ProfileOperator::Attributes> attrs;
       if (profiler_->AggregateEnabled()) {
@@ -359,6 +461,7 @@ class ThreadedEngine : public Engine {
       const Context& ctx = opr_block->ctx;
       opr_block->opr_profile.reset(new profiler::ProfileOperator(threaded_opr->opr_name.c_str(),
                                                                  attrs.release()));
+      opr_block->opr_profile->setSchedulingTimes(opr_block->push_time, opr_block->enqueue_time);
       opr_block->opr_profile->startForDevice(ctx.dev_type, ctx.dev_id);
     }
     CallbackOnComplete callback =
@@ -372,6 +475,14 @@ class ThreadedEngine : public Engine {
     if (!shutdown_phase_ || threaded_opr->prop == FnProperty::kDeleteVar) {
       try {
         OnStart(threaded_opr);
+        if (gpu_event_sync_) {
+          // deleted memory may be reused right away, so its users must be done
+          run_ctx.event_sync = run_ctx.ctx.dev_mask() == Context::kGPU &&
+                               run_ctx.stream != nullptr &&
+                               threaded_opr->prop != FnProperty::kDeleteVar;
+          WaitGPUEvents(run_ctx, threaded_opr);
+          if (run_ctx.event_sync) opr_block->event_stream = run_ctx.stream;
+        }
         if (debug_info) {
           LOG(INFO) << "ExecuteOprFn ";
         }
@@ -409,6 +520,7 @@ class ThreadedEngine : public Engine {
     } else {
       callback();
     }
+    profiler::CurrentRequestId() = thread_request_id;
   }
 
   int bulk_size() const override {
@@ -416,6 +528,26 @@ class ThreadedEngine : public Engine {
     return (prof && prof->AggregateRunning()) ? 0 :  BulkStatusStore::Get()->bulk_size;
   }
 
+  int push_priority() const override {
+    return *PushPriorityStore::Get();
+  }
+
+  int set_push_priority(int priority) override {
+    std::swap(*PushPriorityStore::Get(), priority);
+    return priority;
+  }
+
+  int wait_tag() const override {
+    return WaitTagStore::Get()->tag;
+  }
+
+  int set_wait_tag(int tag) override {
+    // the bulked operations were pushed with the previous tag
+    BulkFlush();
+    std::swap(WaitTagStore::Get()->tag, tag);
+    return tag;
+  }
+
   int set_bulk_size(int bulk_size) override {
     BulkStatus& bulk_status = *BulkStatusStore::Get();
     std::swap(bulk_status.bulk_size, bulk_size);
@@ -445,6 +577,38 @@ class ThreadedEngine : public Engine {
   };
   /*! thread local store for bulk */
   typedef dmlc::ThreadLocalStore<BulkStatus> BulkStatusStore;
+  /*! thread local store for the priority added to pushed operations */
+  typedef dmlc::ThreadLocalStore<int> PushPriorityStore;
+  /*! \brief tag of the operations pushed by a thread */
+  struct WaitTag {
+    int tag{0};
+  };
+  /*! thread local store for the tag of pushed operations */
+  typedef dmlc::ThreadLocalStore<WaitTag> WaitTagStore;
+  /*!
+   * \brief operations of a tag not completed yet, and the GPUs they ran on. The status is
+   *  erased once its operations complete with no thread waiting for the tag.
+   */
+  struct TagStatus {
+    int pending{0};
+    uint64_t gpus{0};
+    /*! \brief threads in WaitForTag, which read gpus once the operations completed */
+    int waiters{0};
+  };
+  /*!
+   * \brief index of a context in ctx_pending_, contexts of large ids may share one, which
+   *  only makes WaitForContext wait longer
+   */
+  static size_t ContextIndex(const Context& ctx) {
+    return static_cast<size_t>(ctx.dev_type) * Context::kMaxDevID +
+        std::min(std::max(ctx.dev_id, 0), Context::kMaxDevID - 1);
+  }
+  /*! \brief count a pushed operation of a tag, the caller holds finished_m_ */
+  void AddTagOperations(int tag, const Context& ctx, int num_oprs) {
+    TagStatus& status = tag_pending_[tag];
+    status.pending += num_oprs;
+    if (ctx.dev_mask() == gpu::kDevMask) status.gpus |= uint64_t{1} << (ctx.dev_id % 64);
+  }
 
   /*!
    * \brief check if thee is duplication in const_vars and mutable_vars.
@@ -458,7 +622,7 @@ class ThreadedEngine : public Engine {
    *
    * On operation completion, this will trigger subsequent operations.
    */
-  inline void OnComplete(ThreadedOpr* threaded_opr);
+  inline void OnComplete(ThreadedOpr* threaded_opr, const Context& ctx, int wait_tag);
   /*!
    * \brief rethrow caught exception in WaitForVar
    * \param threaded_var the var that we are waiting to read
@@ -491,6 +655,18 @@ class ThreadedEngine : public Engine {
 
   static void OnCompleteStatic(Engine *engine, void *threaded_opr,
                                const dmlc::Error* error);
+  /*!
+   * \brief Make the operation wait for the GPU work on its variables tracked by events.
+   *  With run_ctx.event_sync, the stream of run_ctx waits, otherwise the calling thread.
+   */
+  void WaitGPUEvents(const RunContext& run_ctx, ThreadedOpr* threaded_opr);
+  /*!
+   * \brief Record an event on the stream of a completed operation and attach it to its
+   *  variables, before they are released to the following operations.
+   */
+  void RecordGPUEvent(OprBlock* opr_block);
+  /*! \brief Wait for the GPU work tracked by events on a variable ready to read. */
+  void WaitGPUWrite(ThreadedVar* threaded_var);
   /*!
    * \brief find exception in global_exception_refs and add it if missing
    * \param opr_exception the exception to be added to global_exception_refs
@@ -538,7 +714,7 @@ class ThreadedEngine : public Engine {
         }
         ctx.is_bulk = false;
         bool is_gpu = ctx.ctx.dev_mask() == gpu::kDevMask;
-        if (is_gpu) {
+        if (is_gpu && !ctx.event_sync) {
           ctx.get_stream<gpu>()->Wait();
         }
         on_complete();
@@ -554,12 +730,26 @@ class ThreadedEngine : public Engine {
    * \brief Number of pending operations.
    */
   std::atomic<int> pending_{0};
+  /*! \brief Number of pending operations of each context, see ContextIndex */
+  std::array<std::atomic<int>, (Context::kMaxDevType + 1) * Context::kMaxDevID> ctx_pending_{};
+  /*! \brief Pending operations of the tags, guarded by finished_m_ */
+  std::unordered_map<int, TagStatus> tag_pending_;
   /*! \brief whether we want to kill the waiters */
   std::atomic<bool> kill_{false};
+  /*! \brief wait policy of the workers and waiters, read when the engine is created */
+  const SpinWait spin_wait_;
   /*! \brief whether it is during shutdown phase*/
   std::atomic<bool> shutdown_phase_{false};
   /*!\brief show more information from engine actions */
   bool engine_info_{false};
+  /*!
+   * \brief whether GPU operations complete without waiting for their stream,
+   *  the dependent operations waiting for CUDA events instead
+   */
+  bool gpu_event_sync_{false};
+  /*! \brief devices with GPU work tracked by events, synchronized by WaitForAll */
+  std::unordered_set<int> event_devices_;
+  std::mutex event_devices_m_;
   /*! \brief debug information about wait for var. */
   std::atomic<ThreadedVar*> debug_wait_var_{nullptr};
   /*! \brief debug information about wait for var. */
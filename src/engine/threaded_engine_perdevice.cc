@@ -29,12 +29,19 @@
 #include <dmlc/concurrency.h>
 #include <dmlc/thread_group.h>
 
+#include <algorithm>
 #include <memory>
+#include <vector>
 #include "../initialize.h"
 #include "./threaded_engine.h"
 #include "./thread_pool.h"
+#include "./work_stealing_queue.h"
+#include "./priority_task_queue.h"
+#include "./spin_wait.h"
+#include "./thread_budget.h"
 #include "../common/lazy_alloc_array.h"
 #include "../common/utils.h"
+#include "../common/numa.h"
 
 namespace mxnet {
 namespace engine {
@@ -45,6 +52,10 @@ namespace engine {
  *  - Use fixed amount of threads for each device.
  *  - Use special threads for copy operations.
  *  - Each stream is allocated and bound to each of the thread.
+ *  - Optionally, CPU workers of a device share per-worker deques with work stealing
+ *    instead of a single blocking queue.
+ *  - Optionally (MXNET_ENGINE_PRIORITY_SCHEDULING), normal workers always pick the
+ *    runnable operation with the highest priority.
  */
 class ThreadedEnginePerDevice : public ThreadedEngine {
  public:
@@ -54,7 +65,9 @@ class ThreadedEnginePerDevice : public ThreadedEngine {
   static auto constexpr kPriorityQueue = kPriority;
   static auto constexpr kWorkerQueue = kFIFO;
 
-  ThreadedEnginePerDevice() noexcept(false) {
+  explicit ThreadedEnginePerDevice(bool work_stealing = false) noexcept(false)
+      : cpu_work_stealing_(work_stealing),
+        priority_scheduling_(dmlc::GetEnv("MXNET_ENGINE_PRIORITY_SCHEDULING", false)) {
     this->Start();
   }
   ~ThreadedEnginePerDevice() noexcept(false) override {
@@ -64,9 +77,12 @@ class ThreadedEnginePerDevice : public ThreadedEngine {
   void StopNoWait() {
     SignalQueuesForKill();
     gpu_normal_workers_.Clear();
+    gpu_sched_workers_.Clear();
     gpu_priority_workers_.Clear();
     gpu_copy_workers_.Clear();
     cpu_normal_workers_.Clear();
+    cpu_stealing_workers_.Clear();
+    cpu_sched_workers_.Clear();
     cpu_priority_worker_.reset(nullptr);
   }
 
@@ -82,6 +98,9 @@ class ThreadedEnginePerDevice : public ThreadedEngine {
     // MXNET_CPU_WORKER_NTHREADS
     cpu_worker_nthreads_ = LibraryInitializer::Get()->cpu_worker_nthreads_;
     gpu_copy_nthreads_ = dmlc::GetEnv("MXNET_GPU_COPY_NTHREADS", 2);
+    // extra streams are only useful when operations do not wait for their stream
+    gpu_worker_nstreams_ = gpu_event_sync() ?
+        std::max(dmlc::GetEnv("MXNET_ENGINE_GPU_WORKER_STREAMS", 1), 1) : 1;
     // create CPU task
     int cpu_priority_nthreads = dmlc::GetEnv("MXNET_CPU_PRIORITY_NTHREADS", 4);
     cpu_priority_worker_ = std::make_unique<ThreadWorkerBlock<kPriorityQueue>>();
@@ -112,12 +131,36 @@ class ThreadedEnginePerDevice : public ThreadedEngine {
         } else {
           int dev_id = ctx.dev_id;
           int nthread = cpu_worker_nthreads_;
+          if (cpu_work_stealing_) {
+            auto ptr = cpu_stealing_workers_.Get(dev_id, [this, ctx, nthread]() {
+                auto blk = new WorkStealingWorkerBlock(nthread);
+                blk->pool = std::make_unique<ThreadPool>(nthread,
+                    [this, ctx, blk](std::shared_ptr<dmlc::ManualEvent> ready_event) {
+                      this->CPUWorker(ctx, blk, ready_event, true);
+                    }, true);
+              return blk;
+            });
+            if (ptr) PushToWorker(ptr.get(), opr_block);
+            return;
+          }
+          if (priority_scheduling_) {
+            auto ptr = cpu_sched_workers_.Get(dev_id, [this, ctx, nthread]() {
+                auto blk = new PriorityWorkerBlock();
+                blk->pool = std::make_unique<ThreadPool>(nthread,
+                    [this, ctx, blk](std::shared_ptr<dmlc::ManualEvent> ready_event) {
+                      this->CPUWorker(ctx, blk, ready_event, true);
+                    }, true);
+              return blk;
+            });
+            if (ptr) PushToWorker(ptr.get(), opr_block);
+            return;
+          }
           auto ptr =
           cpu_normal_workers_.Get(dev_id, [this, ctx, nthread]() {
               auto blk = new ThreadWorkerBlock<kWorkerQueue>();
               blk->pool = std::make_unique<ThreadPool>(nthread,
                   [this, ctx, blk](std::shared_ptr<dmlc::ManualEvent> ready_event) {
-                    this->CPUWorker(ctx, blk, ready_event);
+                    this->CPUWorker(ctx, blk, ready_event, true);
                   }, true);
             return blk;
           });
@@ -175,6 +218,21 @@ class ThreadedEnginePerDevice : public ThreadedEngine {
             if (ptr) {
               ptr->task_queue.Push(opr_block, opr_block->priority);
             }
+          } else if (priority_scheduling_) {
+            // GPU normal task, scheduled by priority
+            auto ptr = gpu_sched_workers_.Get(ctx.dev_id, [this, ctx, is_copy, nthread]() {
+              // Signify to kernel that GPU is being used, so reserve cores as necessary
+              OpenMP::Get()->set_reserve_cores(GetReserveCoreCount(true));
+                auto blk = new PriorityWorkerBlock();
+                blk->pool = std::make_unique<ThreadPool>(
+                  nthread,
+                  [this, ctx, is_copy, blk]
+                    (std::shared_ptr<dmlc::ManualEvent> ready_event) {
+                      this->GPUWorker(ctx, is_copy, blk, ready_event);
+                    }, true);
+                return blk;
+            });
+            if (ptr) PushToWorker(ptr.get(), opr_block);
           } else {
             // GPU normal task
             auto ptr = gpu_normal_workers_.Get(ctx.dev_id, [this, ctx, is_copy, nthread]() {
@@ -215,21 +273,58 @@ class ThreadedEnginePerDevice : public ThreadedEngine {
     // destructor
     ~ThreadWorkerBlock() = default;
   };
+  // working unit of CPU workers that steal tasks from each other.
+  struct WorkStealingWorkerBlock {
+    // per worker task deques
+    WorkStealingQueue<OprBlock*> task_queue;
+    // thread pool that works on this task
+    std::unique_ptr<ThreadPool> pool;
+    // constructor
+    explicit WorkStealingWorkerBlock(size_t nthread) : task_queue(nthread) {}
+  };
+  // working unit of workers that pick the most urgent task first.
+  struct PriorityWorkerBlock {
+    // task queue ordered by priority, then by push order
+    PriorityTaskQueue<OprBlock*> task_queue;
+    // thread pool that works on this task
+    std::unique_ptr<ThreadPool> pool;
+  };
+  /*! \brief push a task to a worker block, delete var tasks go first */
+  template<typename WorkerBlock>
+  static inline void PushToWorker(WorkerBlock *block, OprBlock *opr_block) {
+    if (opr_block->opr->prop == FnProperty::kDeleteVar) {
+      block->task_queue.PushFront(opr_block, opr_block->priority);
+    } else {
+      block->task_queue.Push(opr_block, opr_block->priority);
+    }
+  }
 
   /*! \brief whether this is a worker thread. */
   static MX_THREAD_LOCAL bool is_worker_;
+  /*! \brief whether cpu normal workers use work stealing queues */
+  const bool cpu_work_stealing_;
+  /*! \brief whether normal workers pop the runnable task of highest priority first */
+  const bool priority_scheduling_;
   /*! \brief number of concurrent thread cpu worker uses */
   size_t cpu_worker_nthreads_;
   /*! \brief number of concurrent thread each gpu worker uses */
   size_t gpu_worker_nthreads_;
   /*! \brief number of concurrent thread each gpu copy worker uses */
   size_t gpu_copy_nthreads_;
+  /*! \brief number of streams each normal gpu worker thread issues operations to */
+  int gpu_worker_nstreams_{1};
   // cpu worker
   common::LazyAllocArray<ThreadWorkerBlock<kWorkerQueue> > cpu_normal_workers_;
+  // cpu worker with work stealing
+  common::LazyAllocArray<WorkStealingWorkerBlock> cpu_stealing_workers_;
+  // cpu worker with priority scheduling
+  common::LazyAllocArray<PriorityWorkerBlock> cpu_sched_workers_;
   // cpu priority worker
   std::unique_ptr<ThreadWorkerBlock<kPriorityQueue> > cpu_priority_worker_;
   // workers doing normal works on GPU
   common::LazyAllocArray<ThreadWorkerBlock<kWorkerQueue> > gpu_normal_workers_;
+  // workers doing normal works on GPU with priority scheduling
+  common::LazyAllocArray<PriorityWorkerBlock> gpu_sched_workers_;
   // workers doing copy works from/to GPU
   common::LazyAllocArray<ThreadWorkerBlock<kCopyQueue> > gpu_copy_workers_;
   // gpu priority workers
@@ -240,56 +335,103 @@ class ThreadedEnginePerDevice : public ThreadedEngine {
    * \param is_copy_worker whether the worker only do copy job
    * \param block The task block of the worker.
    */
-  template<dmlc::ConcurrentQueueType type>
+  template<typename WorkerBlock>
   inline void GPUWorker(Context ctx,
                         bool is_copy_worker,
-                        ThreadWorkerBlock<type> *block,
+                        WorkerBlock *block,
                         const std::shared_ptr<dmlc::ManualEvent>& ready_event) {
     this->is_worker_ = true;
 #if MXNET_USE_CUDA
     CHECK(block != nullptr);
-    mshadow::Stream<gpu> *stream = nullptr;
-    GPUAuxStream *aux_stream = nullptr;
+    const int nstreams = is_copy_worker ? 1 : gpu_worker_nstreams_;
+    std::vector<mshadow::Stream<gpu>*> streams(nstreams, nullptr);
+    std::vector<GPUAuxStream*> aux_streams(nstreams, nullptr);
     do {
       ThreadPool::SetReadyOnDestroy setReady(ready_event);
       // allocate stream
       mshadow::SetDevice<gpu>(ctx.dev_id);
-      if (is_copy_worker) {
-        stream = mshadow::NewStream<gpu>(false, false, ctx.dev_id);
-      } else {
-        stream = mshadow::NewStream<gpu>(true, MXNET_USE_CUDNN != 0, ctx.dev_id);
-        aux_stream = new GPUAuxStream(stream);
+      for (int i = 0; i < nstreams; ++i) {
+        if (is_copy_worker) {
+          streams[i] = mshadow::NewStream<gpu>(false, false, ctx.dev_id);
+        } else {
+          streams[i] = mshadow::NewStream<gpu>(true, MXNET_USE_CUDNN != 0, ctx.dev_id);
+          aux_streams[i] = new GPUAuxStream(streams[i]);
+        }
       }
     } while (false);
     // execute task
     OprBlock* opr_block;
-    RunContext run_ctx{ctx, stream, aux_stream, false};
     auto* task_queue = &(block->task_queue);
+    size_t next_stream = 0;
 
     // Don't eat up omp threads for GPU jobs.  They're probably best used elsewhere,
     // for example for image decoding or the optimizer pass
     OpenMP::Get()->on_start_worker_thread(false);
 
-    while (task_queue->Pop(&opr_block)) {
-      this->ExecuteOprBlock(run_ctx, opr_block);
+    while (SpinPop(spin_wait(), task_queue, &opr_block)) {
+      const size_t i = nstreams > 1 ? PickStream(opr_block, streams, &next_stream) : 0;
+      this->ExecuteOprBlock(RunContext{ctx, streams[i], aux_streams[i], false}, opr_block);
+    }
+    for (int i = 0; i < nstreams; ++i) {
+      // Catch exception for CUDA driver shutdown
+      MSHADOW_CATCH_ERROR(mshadow::DeleteStream<gpu>(streams[i]));
+      if (aux_streams[i] != nullptr)
+        delete aux_streams[i];
     }
-    // Catch exception for CUDA driver shutdown
-    MSHADOW_CATCH_ERROR(mshadow::DeleteStream<gpu>(stream));
-    if (aux_stream != nullptr)
-      delete aux_stream;
 #else
     ready_event->signal();
 #endif
   }
+#if MXNET_USE_CUDA
+  /*!
+   * \brief Choose the stream of a worker to run an operation on.
+   *  An operation reading or writing the output of an operation queued on one of the
+   *  streams continues on that stream, so that it needs no cross-stream wait. The others
+   *  are spread over the streams in turn, so that independent operations overlap.
+   */
+  static size_t PickStream(OprBlock* opr_block,
+                           const std::vector<mshadow::Stream<gpu>*>& streams,
+                           size_t* next_stream) {
+    auto find = [&streams](ThreadedVar* var) -> size_t {
+      std::lock_guard<std::mutex> lock(var->event_mutex);
+      for (size_t i = 0; var->write_event != nullptr && i < streams.size(); ++i) {
+        if (var->write_event->stream == streams[i]->stream_) return i;
+      }
+      return streams.size();
+    };
+    for (auto* var : opr_block->opr->const_vars) {
+      const size_t i = find(var);
+      if (i < streams.size()) return i;
+    }
+    for (auto* var : opr_block->opr->mutable_vars) {
+      const size_t i = find(var);
+      if (i < streams.size()) return i;
+    }
+    const size_t i = *next_stream;
+    *next_stream = (i + 1) % streams.size();
+    return i;
+  }
+#endif
   /*!
    * \brief CPU worker that performs operations on CPU.
    * \param block The task block of the worker.
+   * \param bind_numa Whether to pin the worker to the NUMA node serving ctx.
    */
-  template<dmlc::ConcurrentQueueType type>
+  template<typename WorkerBlock>
   inline void CPUWorker(Context ctx,
-                        ThreadWorkerBlock<type> *block,
-                        const std::shared_ptr<dmlc::ManualEvent>& ready_event) {
+                        WorkerBlock *block,
+                        const std::shared_ptr<dmlc::ManualEvent>& ready_event,
+                        bool bind_numa = false) {
     this->is_worker_ = true;
+    // OMP threads started from this worker inherit its affinity
+    bool bound = false;
+    if (bind_numa) {
+      const common::NumaTopology *numa = common::NumaTopology::Get();
+      bound = numa->BindCurrentThread(numa->NodeOf(ctx));
+    }
+    if (!bound) {
+      ThreadBudget::Get()->BindWorkerThread();
+    }
     auto* task_queue = &(block->task_queue);
     RunContext run_ctx{ctx, nullptr, nullptr, false};
 
@@ -300,7 +442,7 @@ class ThreadedEnginePerDevice : public ThreadedEngine {
     // Set default number of threads for OMP parallel regions initiated by this thread
     OpenMP::Get()->on_start_worker_thread(true);
 
-    while (task_queue->Pop(&opr_block)) {
+    while (SpinPop(spin_wait(), task_queue, &opr_block)) {
       this->ExecuteOprBlock(run_ctx, opr_block);
     }
   }
@@ -338,8 +480,11 @@ class ThreadedEnginePerDevice : public ThreadedEngine {
   void SignalQueuesForKill() {
     SignalQueueForKill(&gpu_priority_workers_);
     SignalQueueForKill(&gpu_normal_workers_);
+    SignalQueueForKill(&gpu_sched_workers_);
     SignalQueueForKill(&gpu_copy_workers_);
     SignalQueueForKill(&cpu_normal_workers_);
+    SignalQueueForKill(&cpu_stealing_workers_);
+    SignalQueueForKill(&cpu_sched_workers_);
     if (cpu_priority_worker_) {
       cpu_priority_worker_->task_queue.SignalForKill();
     }
@@ -350,6 +495,10 @@ Engine *CreateThreadedEnginePerDevice() {
   return new ThreadedEnginePerDevice();
 }
 
+Engine *CreateThreadedEngineWorkStealing() {
+  return new ThreadedEnginePerDevice(true);
+}
+
 MX_THREAD_LOCAL bool ThreadedEnginePerDevice::is_worker_ = false;
 
 }  // namespace engine
@@ -31,6 +31,7 @@
 #include <utility>
 #include "./threaded_engine.h"
 #include "./thread_pool.h"
+#include "./spin_wait.h"
 #include "./stream_manager.h"
 #if MXNET_USE_CUDA
 #include "../common/cuda/utils.h"
@@ -125,7 +126,7 @@ class ThreadedEnginePooled : public ThreadedEngine {
                     const std::shared_ptr<dmlc::ManualEvent>& ready_event) {
     OprBlock* opr_block;
     ready_event->signal();
-    while (task_queue->Pop(&opr_block)) {
+    while (SpinPop(spin_wait(), task_queue.get(), &opr_block)) {
       DoExecute(opr_block);
     }
   }
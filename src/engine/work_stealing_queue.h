@@ -0,0 +1,219 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file work_stealing_queue.h
+ * \brief Blocking task queue made of per-worker deques with work stealing.
+ */
+#ifndef MXNET_ENGINE_WORK_STEALING_QUEUE_H_
+#define MXNET_ENGINE_WORK_STEALING_QUEUE_H_
+
+#include <dmlc/base.h>
+#include <dmlc/logging.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mxnet {
+namespace engine {
+
+/*!
+ * \brief Task queue in which every worker owns a deque.
+ *
+ *  Workers push and pop at the back of their own deque and steal from the front
+ *  of the other deques when their own one is empty. Pushes from threads that are
+ *  not workers of this queue are spread round-robin over the deques. Compared with
+ *  a single dmlc::ConcurrentBlockingQueue this keeps the common path on a lock that
+ *  is only contended by thieves.
+ *
+ *  The interface mirrors dmlc::ConcurrentBlockingQueue so that it can be used as a
+ *  drop-in task queue of an engine worker block. Priorities are ignored, as they
+ *  are for the FIFO queue.
+ */
+template<typename T>
+class WorkStealingQueue {
+ public:
+  /*!
+   * \brief Constructor.
+   * \param num_workers number of workers that pop from this queue.
+   */
+  explicit WorkStealingQueue(size_t num_workers)
+      : lanes_(num_workers) {
+    CHECK_GT(num_workers, 0);
+    for (auto& lane : lanes_) {
+      lane.reset(new Lane());
+    }
+  }
+  /*!
+   * \brief Push an element to the back of a deque.
+   * \param e the element.
+   * \param priority ignored, kept for interface compatibility.
+   */
+  inline void Push(T e, int priority = 0) {
+    Lane* lane = lanes_[PushLane()].get();
+    {
+      std::lock_guard<std::mutex> lock{lane->mutex};
+      lane->tasks.push_back(e);
+    }
+    NotifyPush();
+  }
+  /*!
+   * \brief Push an element so that it is the next one popped by the owner of its deque,
+   *  ahead of the elements already queued. Thieves take it last.
+   * \param e the element.
+   * \param priority ignored, kept for interface compatibility.
+   */
+  inline void PushFront(T e, int priority = 0) {
+    Lane* lane = lanes_[PushLane()].get();
+    {
+      std::lock_guard<std::mutex> lock{lane->mutex};
+      // the owner pops from the back
+      lane->tasks.push_back(e);
+    }
+    NotifyPush();
+  }
+  /*!
+   * \brief Pop an element, blocking until one is available.
+   *  The first call from a thread registers it as a worker of this queue.
+   * \param rv the popped element.
+   * \return false if the queue has been signaled for kill.
+   */
+  inline bool Pop(T* rv) {
+    const size_t self = WorkerLane();
+    while (true) {
+      if (exit_now_.load()) return false;
+      if (TryPop(self, rv)) {
+        pending_.fetch_sub(1);
+        return true;
+      }
+      if (pending_.load() > 0) {
+        // an element is in flight or being popped by someone else
+        std::this_thread::yield();
+        continue;
+      }
+      std::unique_lock<std::mutex> lock{sleep_mutex_};
+      ++num_sleeping_;
+      sleep_cv_.wait(lock, [this] {
+        return pending_.load() > 0 || exit_now_.load();
+      });
+      --num_sleeping_;
+    }
+  }
+  /*! \brief Wake up all the workers and make Pop return false. */
+  inline void SignalForKill() {
+    {
+      std::lock_guard<std::mutex> lock{sleep_mutex_};
+      exit_now_.store(true);
+    }
+    sleep_cv_.notify_all();
+  }
+  /*! \return approximated number of elements in the queue. */
+  inline size_t Size() {
+    const int n = pending_.load();
+    return n > 0 ? static_cast<size_t>(n) : 0;
+  }
+
+ private:
+  /*! \brief deque owned by one worker */
+  struct Lane {
+    std::mutex mutex;
+    std::deque<T> tasks;
+  };
+  /*! \brief per thread registration of the worker */
+  struct WorkerInfo {
+    const WorkStealingQueue* owner;
+    size_t lane;
+  };
+  /*! \return thread local worker registration */
+  static inline WorkerInfo* ThreadWorkerInfo() {
+    static thread_local WorkerInfo info{nullptr, 0};
+    return &info;
+  }
+  /*! \return lane of the calling worker, registering it on first use */
+  inline size_t WorkerLane() {
+    WorkerInfo* info = ThreadWorkerInfo();
+    if (info->owner != this) {
+      info->owner = this;
+      info->lane = next_worker_.fetch_add(1) % lanes_.size();
+    }
+    return info->lane;
+  }
+  /*! \return lane a push from the calling thread should go to */
+  inline size_t PushLane() {
+    const WorkerInfo* info = ThreadWorkerInfo();
+    if (info->owner == this) return info->lane;
+    return next_push_.fetch_add(1) % lanes_.size();
+  }
+  /*! \brief pop from the own lane, then try to steal from the others */
+  inline bool TryPop(size_t self, T* rv) {
+    {
+      Lane* lane = lanes_[self].get();
+      std::lock_guard<std::mutex> lock{lane->mutex};
+      if (!lane->tasks.empty()) {
+        *rv = lane->tasks.back();
+        lane->tasks.pop_back();
+        return true;
+      }
+    }
+    const size_t n = lanes_.size();
+    for (size_t i = 1; i < n; ++i) {
+      Lane* victim = lanes_[(self + i) % n].get();
+      std::unique_lock<std::mutex> lock{victim->mutex, std::try_to_lock};
+      if (lock.owns_lock() && !victim->tasks.empty()) {
+        *rv = victim->tasks.front();
+        victim->tasks.pop_front();
+        return true;
+      }
+    }
+    return false;
+  }
+  /*! \brief account for a new element and wake up a sleeping worker if any */
+  inline void NotifyPush() {
+    pending_.fetch_add(1);
+    if (num_sleeping_.load() > 0) {
+      std::lock_guard<std::mutex> lock{sleep_mutex_};
+      sleep_cv_.notify_one();
+    }
+  }
+
+  /*! \brief per worker deques */
+  std::vector<std::unique_ptr<Lane>> lanes_;
+  /*! \brief number of elements pushed but not popped yet */
+  std::atomic<int> pending_{0};
+  /*! \brief number of workers waiting on sleep_cv_ */
+  std::atomic<int> num_sleeping_{0};
+  /*! \brief counter used to assign lanes to workers */
+  std::atomic<size_t> next_worker_{0};
+  /*! \brief counter used to spread external pushes */
+  std::atomic<size_t> next_push_{0};
+  /*! \brief whether the queue is killed */
+  std::atomic<bool> exit_now_{false};
+  /*! \brief mutex and condition variable for idle workers */
+  std::mutex sleep_mutex_;
+  std::condition_variable sleep_cv_;
+  DISALLOW_COPY_AND_ASSIGN(WorkStealingQueue);
+};
+
+}  // namespace engine
+}  // namespace mxnet
+#endif  // MXNET_ENGINE_WORK_STEALING_QUEUE_H_
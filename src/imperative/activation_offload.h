@@ -0,0 +1,150 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file activation_offload.h
+ * \brief Offloading of the activations saved for backward to pinned host memory.
+ *
+ *  When a CachedOp records its forward pass, the entries read by the backward
+ *  graph stay alive on the device until backward runs. With offloading, the large
+ *  ones are copied to pinned host memory on the device-to-host copy stream and the
+ *  device memory is released. Backward copies each of them back a few operators
+ *  before its first use: the copy is ordered after the backward operator that many
+ *  steps earlier, so that the device never holds much more than the activations
+ *  needed by the next few operators, while the transfer still overlaps compute.
+ */
+#ifndef MXNET_IMPERATIVE_ACTIVATION_OFFLOAD_H_
+#define MXNET_IMPERATIVE_ACTIVATION_OFFLOAD_H_
+
+#include <mxnet/engine.h>
+#include <mxnet/ndarray.h>
+#include <nnvm/graph.h>
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+#include "../ndarray/ndarray_function.h"
+
+namespace mxnet {
+namespace imperative {
+
+/*!
+ * \brief Move the saved activations of a recorded forward pass to pinned host memory.
+ * \param idx the forward graph.
+ * \param fwd_ref_count reference counts of the forward entries within the forward graph.
+ * \param full_ref_count reference counts of the forward entries within the full graph.
+ * \param arrays the entries of the forward graph; only those still pointing into buff,
+ *  i.e. neither inputs nor outputs of the graph, are candidates.
+ * \param min_size entries smaller than this many bytes stay on the device.
+ * \param buff storage of the forward entries, offloaded entries are replaced by their copy.
+ * \return entry ids of the offloaded entries.
+ */
+inline std::vector<uint32_t> OffloadActivations(const nnvm::IndexedGraph& idx,
+                                                const std::vector<uint32_t>& fwd_ref_count,
+                                                const std::vector<uint32_t>& full_ref_count,
+                                                const std::vector<NDArray*>& arrays,
+                                                size_t min_size,
+                                                std::vector<NDArray>* buff) {
+  std::vector<uint32_t> offloaded;
+  for (uint32_t eid = 0; eid < idx.num_node_entries(); ++eid) {
+    NDArray& arr = (*buff)[eid];
+    if (arrays[eid] != &arr || arr.is_none()) continue;
+    // only entries read by backward are still alive
+    if (full_ref_count[eid] == fwd_ref_count[eid]) continue;
+    if (arr.ctx().dev_mask() != gpu::kDevMask || arr.storage_type() != kDefaultStorage ||
+        arr.shape().Size() * mshadow::mshadow_sizeof(arr.dtype()) < min_size) {
+      continue;
+    }
+    NDArray host(arr.shape(), Context::CPUPinned(arr.ctx().dev_id), true, arr.dtype());
+    CopyFromTo(arr, host);
+    // the device memory goes back to the pool once the copy completed
+    arr = host;
+    offloaded.push_back(eid);
+  }
+  return offloaded;
+}
+
+/*!
+ * \brief Decide when the offloaded entries are copied back during backward.
+ * \param idx the full graph.
+ * \param num_forward_nodes number of nodes of the forward graph.
+ * \param offloaded the offloaded entries.
+ * \param distance number of backward operators an entry is copied back ahead of its first use.
+ * \return for each node of the full graph, the entries whose copy is ordered after it.
+ *  The entries listed for the last forward node are copied back before backward starts.
+ */
+inline std::unordered_map<uint32_t, std::vector<uint32_t> > PlanPrefetch(
+    const nnvm::IndexedGraph& idx, size_t num_forward_nodes,
+    const std::vector<uint32_t>& offloaded, size_t distance) {
+  std::unordered_map<uint32_t, uint32_t> first_use;
+  std::vector<uint32_t> ops;
+  for (uint32_t nid = num_forward_nodes; nid < idx.num_nodes(); ++nid) {
+    if (idx[nid].source->is_variable()) continue;
+    for (const auto& e : idx[nid].inputs) {
+      first_use.emplace(idx.entry_id(e), ops.size());
+    }
+    ops.push_back(nid);
+  }
+  std::unordered_map<uint32_t, std::vector<uint32_t> > plan;
+  for (const uint32_t eid : offloaded) {
+    auto it = first_use.find(eid);
+    if (it == first_use.end()) continue;
+    const uint32_t trigger = it->second >= distance + 1 ?
+        ops[it->second - distance - 1] : static_cast<uint32_t>(num_forward_nodes - 1);
+    plan[trigger].push_back(eid);
+  }
+  return plan;
+}
+
+/*!
+ * \brief Copy an offloaded entry back to the device.
+ *  The device memory is only allocated when the copy runs, which is after all the
+ *  writes to after are done.
+ * \param host the offloaded copy.
+ * \param ctx the device to copy to.
+ * \param after entries the copy is ordered after.
+ * \return the device array.
+ */
+inline NDArray PrefetchActivation(const NDArray& host, const Context& ctx,
+                                  const std::vector<NDArray>& after) {
+  NDArray dev(host.shape(), ctx, true, host.dtype());
+#if MXNET_USE_CUDA
+  std::vector<Engine::VarHandle> const_vars(1, host.var());
+  for (const NDArray& arr : after) {
+    if (!arr.is_none()) const_vars.push_back(arr.var());
+  }
+  std::sort(const_vars.begin(), const_vars.end());
+  const_vars.erase(std::unique(const_vars.begin(), const_vars.end()), const_vars.end());
+  Engine::Get()->PushAsync(
+    [host, dev](RunContext rctx, Engine::CallbackOnComplete on_complete) {
+      TBlob tmp = dev.data();
+      ndarray::Copy<cpu, gpu>(host.data(), &tmp, host.ctx(), dev.ctx(), rctx);
+      rctx.get_stream<gpu>()->Wait();
+      on_complete();
+    }, ctx, const_vars, {dev.var()},
+    FnProperty::kCopyToGPU, 0, "PrefetchActivation");
+#else
+  LOG(FATAL) << "Activation offloading requires MXNet built with CUDA";
+#endif  // MXNET_USE_CUDA
+  return dev;
+}
+
+}  // namespace imperative
+}  // namespace mxnet
+
+#endif  // MXNET_IMPERATIVE_ACTIVATION_OFFLOAD_H_
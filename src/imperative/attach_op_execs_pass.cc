@@ -86,6 +86,7 @@ class StorageFallbackOpExecutor : public OpExecutor {
                            &pre_temp_src_, &pre_temp_dst_,
                            &post_temp_src_, &post_temp_dst_,
                            &in_temp_idx_map_, mutate_idx_);
+    if (is_gpu) common::PrefetchManaged(in_array, out_array, op_ctx.run_ctx);
     common::CastNonDefaultStorage(pre_temp_src_, pre_temp_dst_, op_ctx, is_gpu);
   }
 
@@ -159,6 +160,7 @@ class StatefulComputeExExecutor : public OpExecutor {
     INVALIDATE_OUTPUTS(out_array, req);
     std::vector<NDArray> *pInArray = &in_array;
     CREATE_DEFAULT_INPUTS_MKLDNN(in_array, pInArray = &in_array_fallback, attrs_);
+    if (is_gpu) common::PrefetchManaged(*pInArray, out_array, rctx);
     fcompute_(state_, op_ctx, *pInArray, req, out_array);
   }
 
@@ -227,6 +229,7 @@ class FComputeExExecutor : public OpExecutor {
     INVALIDATE_OUTPUTS(out_array, req);
     std::vector<NDArray> *pInArray = &in_array;
     CREATE_DEFAULT_INPUTS_MKLDNN(in_array, pInArray = &in_array_fallback, attrs_);
+    if (is_gpu) common::PrefetchManaged(*pInArray, out_array, rctx);
     fcompute_(attrs_, op_ctx, *pInArray, req, out_array);
   }
 
@@ -34,7 +34,8 @@ void AttachOpResources(
     const Graph& g,
     const OpExecVector& op_execs,
     size_t start_nid,
-    size_t end_nid) {
+    size_t end_nid,
+    const std::map<Context, Resource>& temp_space) {
   static auto& fresource =
       nnvm::Op::GetAttr<FResourceRequest>("FResourceRequest");
   static auto& fresource_ex =
@@ -44,7 +45,7 @@ void AttachOpResources(
   const auto& dev_masks = g.GetAttr<DevMaskVector>("dev_mask");
   const auto& idx = g.indexed_graph();
   // Use global resource pool for each executor for now.
-  std::map<Context, Resource> cached_temp;
+  std::map<Context, Resource> cached_temp(temp_space);
   // Resource allocation
   for (uint32_t nid = start_nid; nid < end_nid; ++nid) {
     const auto& inode = idx[nid];
@@ -0,0 +1,194 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file batching_executor.cc
+ * \brief Dynamic batching of inference requests over a cached op.
+ */
+#include <mxnet/imperative.h>
+#include <algorithm>
+#include <utility>
+#include "./batching_executor.h"
+
+namespace mxnet {
+
+BatchingExecutor::BatchingExecutor(CachedOpPtr op, const Context& ctx,
+                                   std::vector<uint32_t> batch_inputs,
+                                   size_t max_batch_size,
+                                   std::chrono::microseconds max_delay)
+    : op_(std::move(op)), ctx_(ctx), batch_inputs_(std::move(batch_inputs)),
+      max_batch_size_(max_batch_size), max_delay_(max_delay) {
+  CHECK(!batch_inputs_.empty()) << "BatchingExecutor needs at least one batch input";
+  CHECK_GT(max_batch_size_, 0U) << "max_batch_size must be positive";
+  for (const uint32_t i : batch_inputs_) {
+    CHECK_LT(i, op_->num_inputs()) << "Batch input " << i << " out of range";
+  }
+  // the worker runs with the numpy shape semantics of the creating thread
+  const int np_shape = Imperative::Get()->is_np_shape();
+  worker_ = std::thread([this, np_shape]() {
+    Imperative::Get()->set_is_np_shape(np_shape);
+    Run();
+  });
+}
+
+BatchingExecutor::~BatchingExecutor() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  worker_.join();
+  for (auto& req : queue_) {
+    req->result.set_exception(std::make_exception_ptr(
+        dmlc::Error("BatchingExecutor was freed before the request ran")));
+  }
+}
+
+std::future<std::vector<NDArray> > BatchingExecutor::Submit(std::vector<NDArray> inputs) {
+  CHECK_EQ(inputs.size(), op_->num_inputs())
+      << "The cached op expects " << op_->num_inputs() << " inputs, but "
+      << inputs.size() << " were given";
+  for (const uint32_t i : batch_inputs_) {
+    CHECK_GT(inputs[i].shape().ndim(), 0) << "Batch input " << i << " must have a batch axis";
+  }
+  auto req = std::make_unique<Request>();
+  req->inputs = std::move(inputs);
+  req->arrival = std::chrono::steady_clock::now();
+  std::future<std::vector<NDArray> > ret = req->result.get_future();
+  CHECK_LE(static_cast<size_t>(Rows(*req)), max_batch_size_)
+      << "A request cannot have more rows than max_batch_size";
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queue_.push_back(std::move(req));
+  }
+  cv_.notify_one();
+  return ret;
+}
+
+dim_t BatchingExecutor::Rows(const Request& req) const {
+  return req.inputs[batch_inputs_[0]].shape()[0];
+}
+
+bool BatchingExecutor::Compatible(const Request& a, const Request& b) const {
+  for (size_t i = 0; i < a.inputs.size(); ++i) {
+    const NDArray& x = a.inputs[i];
+    const NDArray& y = b.inputs[i];
+    if (std::find(batch_inputs_.begin(), batch_inputs_.end(), i) == batch_inputs_.end()) {
+      if (!x.IsSame(y)) return false;
+      continue;
+    }
+    if (x.dtype() != y.dtype() || x.storage_type() != y.storage_type() ||
+        x.shape().ndim() != y.shape().ndim() || x.shape()[0] != Rows(a) ||
+        y.shape()[0] != Rows(b)) {
+      return false;
+    }
+    for (int d = 1; d < x.shape().ndim(); ++d) {
+      if (x.shape()[d] != y.shape()[d]) return false;
+    }
+  }
+  return true;
+}
+
+size_t BatchingExecutor::ReadyRows() const {
+  size_t rows = 0;
+  for (const auto& req : queue_) {
+    if (Compatible(*queue_.front(), *req)) rows += Rows(*req);
+  }
+  return rows;
+}
+
+void BatchingExecutor::Run() {
+  while (true) {
+    std::vector<std::unique_ptr<Request> > batch;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this]() { return stop_ || !queue_.empty(); });
+      if (stop_) return;
+      const auto deadline = queue_.front()->arrival + max_delay_;
+      cv_.wait_until(lock, deadline, [this]() {
+        return stop_ || ReadyRows() >= max_batch_size_;
+      });
+      if (stop_) return;
+      // the oldest request, followed by the compatible ones in arrival order
+      size_t rows = 0;
+      for (auto it = queue_.begin(); it != queue_.end();) {
+        if (!batch.empty() && !Compatible(*batch.front(), **it)) {
+          ++it;
+          continue;
+        }
+        const size_t n = Rows(**it);
+        if (rows + n > max_batch_size_) break;
+        rows += n;
+        batch.push_back(std::move(*it));
+        it = queue_.erase(it);
+      }
+    }
+    Execute(&batch);
+  }
+}
+
+void BatchingExecutor::Execute(std::vector<std::unique_ptr<Request> >* batch) {
+  try {
+    std::vector<NDArray> inputs = batch->front()->inputs;
+    dim_t rows = 0;
+    for (const auto& req : *batch) rows += Rows(*req);
+    if (batch->size() > 1) {
+      for (const uint32_t i : batch_inputs_) {
+        const NDArray& first = batch->front()->inputs[i];
+        mxnet::TShape shape = first.shape();
+        shape[0] = rows;
+        NDArray batched(shape, ctx_, false, first.dtype());
+        dim_t begin = 0;
+        for (const auto& req : *batch) {
+          const NDArray& input = req->inputs[i];
+          CopyFromTo(input, batched.Slice(begin, begin + input.shape()[0]));
+          begin += input.shape()[0];
+        }
+        inputs[i] = batched;
+      }
+    }
+    std::vector<NDArray> outputs(op_->num_outputs());
+    std::vector<NDArray*> in_ptrs, out_ptrs;
+    for (auto& input : inputs) in_ptrs.push_back(&input);
+    for (auto& output : outputs) out_ptrs.push_back(&output);
+    op_->Forward(op_, in_ptrs, out_ptrs, ctx_);
+
+    dim_t begin = 0;
+    for (auto& req : *batch) {
+      const dim_t n = Rows(*req);
+      std::vector<NDArray> result;
+      result.reserve(outputs.size());
+      for (const NDArray& output : outputs) {
+        if (batch->size() > 1 && output.shape().ndim() > 0 && output.shape()[0] == rows) {
+          result.push_back(output.Slice(begin, begin + n));
+        } else {
+          result.push_back(output);
+        }
+      }
+      begin += n;
+      req->result.set_value(std::move(result));
+    }
+  } catch (...) {
+    for (auto& req : *batch) {
+      req->result.set_exception(std::current_exception());
+    }
+  }
+}
+
+}  // namespace mxnet
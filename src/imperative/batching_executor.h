@@ -0,0 +1,110 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file batching_executor.h
+ * \brief Dynamic batching of inference requests over a cached op.
+ */
+#ifndef MXNET_IMPERATIVE_BATCHING_EXECUTOR_H_
+#define MXNET_IMPERATIVE_BATCHING_EXECUTOR_H_
+
+#include <mxnet/ndarray.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "./cached_op.h"
+
+namespace mxnet {
+
+/*!
+ * \brief Executor coalescing concurrent inference requests into batches.
+ *
+ *  Requests are queued by the calling threads and run by one worker thread.
+ *  The worker takes the oldest request and the queued requests compatible with
+ *  it, until max_batch_size rows are gathered or max_delay has passed since the
+ *  oldest request arrived. Their batch inputs are concatenated along the first
+ *  axis, the cached op runs once, and every output whose first dimension is the
+ *  number of rows is sliced back into the results of the requests. Other outputs
+ *  are shared by all the requests of the batch.
+ *
+ *  Requests are compatible when their batch inputs agree on everything but the
+ *  first dimension and their other inputs, typically the parameters, are the
+ *  same arrays.
+ */
+class BatchingExecutor {
+ public:
+  /*!
+   * \brief Constructor.
+   * \param op the cached op to run.
+   * \param ctx the context the cached op runs on.
+   * \param batch_inputs positions of the inputs concatenated along the first axis.
+   * \param max_batch_size maximum number of rows of a batch.
+   * \param max_delay maximum time a request waits for other requests to join it.
+   */
+  BatchingExecutor(CachedOpPtr op, const Context& ctx, std::vector<uint32_t> batch_inputs,
+                   size_t max_batch_size, std::chrono::microseconds max_delay);
+  /*! \brief Stop the worker, failing the requests still queued. */
+  ~BatchingExecutor();
+  /*!
+   * \brief Queue a request.
+   * \param inputs all the inputs of the cached op.
+   * \return the outputs of the cached op for the request, which may be views of
+   *  the outputs of a whole batch.
+   */
+  std::future<std::vector<NDArray> > Submit(std::vector<NDArray> inputs);
+
+ private:
+  struct Request {
+    std::vector<NDArray> inputs;
+    std::promise<std::vector<NDArray> > result;
+    std::chrono::steady_clock::time_point arrival;
+  };
+
+  /*! \brief worker loop */
+  void Run();
+  /*! \return number of rows of a request */
+  dim_t Rows(const Request& req) const;
+  /*! \return whether two requests can run in the same batch */
+  bool Compatible(const Request& a, const Request& b) const;
+  /*! \return number of queued rows that can join the oldest request, requires mutex_ */
+  size_t ReadyRows() const;
+  /*! \brief concatenate the inputs of a batch, run it and scatter the outputs */
+  void Execute(std::vector<std::unique_ptr<Request> >* batch);
+
+  CachedOpPtr op_;
+  Context ctx_;
+  std::vector<uint32_t> batch_inputs_;
+  size_t max_batch_size_;
+  std::chrono::microseconds max_delay_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::unique_ptr<Request> > queue_;
+  bool stop_{false};
+  std::thread worker_;
+};
+
+}  // namespace mxnet
+
+#endif  // MXNET_IMPERATIVE_BATCHING_EXECUTOR_H_
@@ -16,11 +16,13 @@
  * specific language governing permissions and limitations
  * under the License.
  */
+#include <algorithm>
 #include <memory>
 #include <unordered_set>
 #include <iostream>
 #include "./imperative_utils.h"
 #include "./cached_op.h"
+#include "./activation_offload.h"
 #include "./exec_pass.h"
 #include "../profiler/profiler.h"
 #include "../operator/operator_common.h"
@@ -224,7 +226,8 @@ bool CachedOp::SetForwardGraph(
 
   auto mem_plan = MXPlanMemory(
       &g, std::move(storage), g.GetAttr<std::vector<uint32_t> >(AddPrefix(prefix, REF_COUNT)),
-      AddPrefix(prefix, STORAGE_PLAN));
+      AddPrefix(prefix, STORAGE_PLAN), {0, 0}, {0, 0}, false, config_.memory_arena,
+      config_.alias_concat);
   g.attrs[AddPrefix(prefix, MEM_PLAN)] =
       std::make_shared<dmlc::any>(std::move(mem_plan));
 
@@ -256,6 +259,48 @@ void SetBackwardInputEid(const std::vector<uint32_t>& bwd_in_dep,
   }
 }
 
+void CachedOp::OrderBackwardForMemory(
+    GraphInfo* info,
+    const std::vector<NDArray*>& inputs) {
+  using namespace imperative;
+  nnvm::Graph& g = info->full_graph;
+  const auto& idx = g.indexed_graph();
+  std::vector<uint32_t> input_eid;
+  SetBackwardInputEid(bwd_in_dep_, bwd_out_dep_, bwd_ograd_dep_,
+                      info->ograd_entries, idx, &input_eid);
+  CHECK_EQ(inputs.size(), input_eid.size());
+
+  auto shapes = info->fwd_graph.GetAttr<mxnet::ShapeVector>("shape");
+  shapes.resize(idx.num_node_entries(), mxnet::TShape());
+  auto dtypes = info->fwd_graph.GetAttr<nnvm::DTypeVector>("dtype");
+  dtypes.resize(idx.num_node_entries(), -1);
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    if (input_eid[i] == kEidNotExist) continue;
+    size_t oi = BwdOriginalInput(info->input_map, i);
+    shapes[input_eid[i]] = inputs[oi]->shape();
+    dtypes[input_eid[i]] = inputs[oi]->dtype();
+  }
+
+  // sizes of the backward entries, on a copy sharing the nodes of the graph
+  const uint32_t num_forward_nodes = info->fwd_graph.indexed_graph().num_nodes();
+  const uint32_t num_forward_entries = info->fwd_graph.indexed_graph().num_node_entries();
+  std::pair<uint32_t, uint32_t> node_range = {num_forward_nodes, idx.num_nodes()};
+  std::pair<uint32_t, uint32_t> entry_range = {num_forward_entries, idx.num_node_entries()};
+  nnvm::Graph sized = g;
+  bool contain_unknown = false;
+  CheckAndInferShape(&sized, std::move(shapes), false, node_range, entry_range,
+                     &contain_unknown);
+  CheckAndInferType(&sized, std::move(dtypes), false, node_range, entry_range);
+
+  info->bwd_order_deps = exec::MemoryAwareOrder(sized, num_forward_nodes);
+  if (!info->bwd_order_deps.empty()) {
+    // rebuild the indexed graph with the new control dependencies
+    std::vector<nnvm::NodeEntry> outputs = g.outputs;
+    g = nnvm::Graph();
+    g.outputs = std::move(outputs);
+  }
+}
+
 bool CachedOp::SetBackwardGraph(
     GraphInfo* info,
     const std::vector<OpReqType>& reqs,
@@ -270,12 +315,17 @@ bool CachedOp::SetBackwardGraph(
   if (info->bwd_output_reqs != reqs) {
     info->bwd_output_reqs = reqs;
     info->bwd_input_eid.clear();
+    // the order chosen for the previous outputs may not hold for the new ones
+    for (const auto& n : info->bwd_order_deps) n->control_deps.pop_back();
+    info->bwd_order_deps.clear();
     g = nnvm::Graph();
     g.outputs = info->fwd_graph.outputs;
     for (size_t i = 0; i < info->grad_graph.outputs.size(); ++i) {
       if (info->bwd_output_reqs[i] == kNullOp) continue;
       g.outputs.emplace_back(info->grad_graph.outputs[i]);
     }
+    if (dmlc::GetEnv("MXNET_EXEC_MEMORY_AWARE_ORDER", false))
+      OrderBackwardForMemory(info, inputs);
     g.attrs["context"] = std::make_shared<dmlc::any>(
         std::vector<Context>(g.indexed_graph().num_nodes(), default_ctx));
   }
@@ -357,9 +407,28 @@ bool CachedOp::SetBackwardGraph(
       AddPrefix(BACKWARD, STORAGE_PLAN),
       {num_forward_nodes, idx.num_nodes()},
       {num_forward_entries, idx.num_node_entries()},
-      detect_inplace_addto);
+      detect_inplace_addto, config_.memory_arena, config_.alias_concat);
   g.attrs[AddPrefix(BACKWARD, MEM_PLAN)] = std::make_shared<dmlc::any>(std::move(mem_plan));
 
+  if (dmlc::GetEnv("MXNET_MEM_PLAN_VERBOSE_LOGGING", false)) {
+    const auto& vshape = g.GetAttr<mxnet::ShapeVector>("shape");
+    const auto& vtype = g.GetAttr<nnvm::DTypeVector>("dtype");
+    size_t num_mirrored = 0, mirrored_bytes = 0;
+    for (size_t nid = 0; nid < num_forward_nodes; ++nid) {
+      const auto& dict = idx[nid].source->attrs.dict;
+      auto it = dict.find("__mirror_stage__");
+      if (it == dict.end() || it->second != "1") continue;
+      ++num_mirrored;
+      for (uint32_t j = 0; j < idx[nid].source->num_outputs(); ++j) {
+        const uint32_t eid = idx.entry_id(nid, j);
+        mirrored_bytes += vshape[eid].Size() * mshadow::mshadow_sizeof(vtype[eid]);
+      }
+    }
+    LOG(INFO) << "CachedOp backward recomputes " << num_mirrored << " forward nodes, "
+              << (mirrored_bytes >> 10) << " KB of their outputs are not kept for backward";
+    common::LogMemoryPlan(g);
+  }
+
   return false;
 }
 
@@ -373,12 +442,57 @@ OpStatePtr CachedOp::GetCachedOpState(
     }
   }
   auto state_ptr = OpStatePtr::Create<CachedOpState>(ctx, fwd_graph_, full_graph_,
-                                                     inlining_);
+                                                     inlining_, mirror_shapes_, mirror_dtypes_);
 
   cached_op_states_[ctx].push_back(state_ptr);
   return state_ptr;
 }
 
+OpStatePtr CachedOp::GetStaticState(
+    const Context& ctx,
+    const std::vector<NDArray*>& inputs) {
+  if (config_.static_cache_size == 0) return GetCachedOpState(ctx);
+  mxnet::ShapeVector key;
+  key.reserve(inputs.size());
+  for (const NDArray* input : inputs) key.push_back(input->shape());
+  if (config_.static_shape_bucket != 0) {
+    const dim_t bucket = config_.static_shape_bucket;
+    for (const auto i : config_.data_indices) {
+      mxnet::TShape& shape = key[i];
+      for (int d = 0; d < shape.ndim(); ++d) {
+        shape[d] = (shape[d] + bucket - 1) / bucket * bucket;
+      }
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto& lru = static_states_[ctx];
+  auto it = std::find_if(lru.begin(), lru.end(),
+                         [&key](const std::pair<mxnet::ShapeVector, std::vector<OpStatePtr> >& e) {
+                           return e.first == key;
+                         });
+  if (it != lru.end()) {
+    lru.splice(lru.begin(), lru, it);
+  } else {
+    lru.emplace_front(std::move(key), std::vector<OpStatePtr>());
+    // Evict the least recently used signatures, unless a backward pass still needs them
+    for (auto e = lru.end(); lru.size() > config_.static_cache_size && --e != lru.begin();) {
+      if (std::all_of(e->second.begin(), e->second.end(),
+                      [](const OpStatePtr& state) { return state.unique(); })) {
+        e = lru.erase(e);
+      }
+    }
+  }
+  auto& states = lru.front().second;
+  for (const auto& state : states) {
+    if (state.unique()) return state;
+  }
+  auto state_ptr = OpStatePtr::Create<CachedOpState>(ctx, fwd_graph_, full_graph_,
+                                                     inlining_, mirror_shapes_, mirror_dtypes_);
+  states.push_back(state_ptr);
+  return state_ptr;
+}
+
 void CachedOp::StaticAllocMemory(
     const OpStatePtr& state_ptr,
     bool recording,
@@ -402,10 +516,27 @@ void CachedOp::StaticAllocMemory(
       keep_fwd ? state.info.fwd_graph.indexed_graph().num_node_entries() : 0;
   size_t end_eid = idx.num_node_entries();
 
+  const auto& shapes = g.GetAttr<mxnet::ShapeVector>("shape");
+  const auto& dtypes = g.GetAttr<nnvm::DTypeVector>("dtype");
+  const auto& stypes = g.GetAttr<StorageTypeVector>("storage_type");
+
   if (!keep_fwd) state.fwd_alloc = false;
   state.bwd_alloc = false;
   for (size_t i = start_eid; i < state.buff.size(); ++i) {
-    state.buff[i] = NDArray();
+    NDArray& old = state.buff[i];
+    bool keep = false;
+    if (i < end_eid && mem_plan[i].storage_id == exec::kDynamicStorageID &&
+        !old.is_none() && old.storage_type() != kDefaultStorage) {
+      // sparse entries are planned by capacity, the largest one seen so far is reserved
+      // again, and an unchanged entry keeps its storage
+      old.WaitToWrite();
+      if (old.storage_shape().ndim() > 0) {
+        state.sparse_capacity[i] = std::max(state.sparse_capacity[i], old.storage_shape()[0]);
+      }
+      keep = old.storage_type() == stypes[i] && old.shape() == shapes[i] &&
+             old.dtype() == dtypes[i] && !(addto_entry.size() && addto_entry[i]);
+    }
+    if (!keep) old = NDArray();
     state.arrays[i] = &state.buff[i];
     state.array_reqs[i] = kNullOp;
     state.dynamic_entries[i] = false;
@@ -437,6 +568,11 @@ void CachedOp::StaticAllocMemory(
   reuse_pool = imperative::AllocateMemory(
       g, idx, default_ctx, start_eid, end_eid, mem_plan,
       state.arrays, &state.array_reqs, std::move(reuse_pool));
+  for (size_t i = start_eid; i < end_eid; ++i) {
+    if (state.sparse_capacity[i] > 0 && mem_plan[i].storage_id == exec::kDynamicStorageID) {
+      imperative::ReserveSparseStorage(*state.arrays[i], state.sparse_capacity[i]);
+    }
+  }
 
   state.recording = recording;
   if (keep_fwd) {
@@ -482,7 +618,17 @@ void CachedOp::StaticInitExec(
     for (size_t i = start_nid; i < end_nid; ++i) {
       exec::CreateOpExecs(g, &state.execs, &state.op_states, i);
     }
-    exec::AttachOpResources(g, state.execs, start_nid, end_nid);
+    std::map<Context, Resource> temp_space;
+    if (config_.static_alloc && dmlc::GetEnv("MXNET_CACHEDOP_TEMP_ARENA", false)) {
+      if (state.temp_space.ptr_ == nullptr) {
+        const std::string profiler_scope = common::NodeAttrsGetProfilerScope(
+            state.info.fwd_graph.outputs[0].node->attrs);
+        state.temp_space = ResourceManager::Get()->NewTempSpaceArena(
+            default_ctx, profiler_scope + "temp_space:");
+      }
+      temp_space[default_ctx] = state.temp_space;
+    }
+    exec::AttachOpResources(g, state.execs, start_nid, end_nid, temp_space);
 
     for (size_t i = start_nid; i < end_nid; ++i) {
       bool skip = idx[i].source->is_variable();
@@ -510,8 +656,12 @@ void CachedOp::StaticInitExec(
         bulk_size = 0;
     }
 
+    // CUDA graphs need fixed memory and fixed kernel arguments
+    const bool use_cuda_graphs = CudaGraphsEnabled() && config_.static_shape;
+    const bool split_branches = dmlc::GetEnv("MXNET_EXEC_BULK_EXEC_SPLIT_BRANCHES", false);
     CreateEngineOpSeg(idx, default_ctx, start_nid, end_nid, bulk_size,
-                      state.execs, skip_plus_node, &state.opr_segs);
+                      state.execs, skip_plus_node, &state.opr_segs, use_cuda_graphs,
+                      split_branches);
   }
 
   if (keep_fwd) {
@@ -547,12 +697,18 @@ void CachedOp::StaticRunOps(
     if (op_execs[i]) op_execs[i]->op_ctx.is_train = is_training;
   }
 
+  // consecutive bulked segments are pushed to the engine together
+  std::vector<Engine::OprHandle> opr_batch;
   for (size_t i = start_nid; i < end_nid; i = state.opr_segs[i].next_nid) {
     const auto& opr_seg = state.opr_segs[i];
     if (opr_seg.skip) continue;
     if (opr_seg.opr != nullptr) {
-      Engine::Get()->Push(opr_seg.opr.get(), default_ctx, 0, profiling);
+      opr_batch.push_back(opr_seg.opr.get());
     } else {
+      if (!opr_batch.empty()) {
+        Engine::Get()->PushBatch(opr_batch, default_ctx, 0, profiling);
+        opr_batch.clear();
+      }
       const nnvm::IndexedGraph::Node& node = idx[i];
       if (node.source->is_variable()) continue;
       auto num_outputs = node.source->num_outputs();
@@ -609,6 +765,9 @@ void CachedOp::StaticRunOps(
       }
     }
   }
+  if (!opr_batch.empty()) {
+    Engine::Get()->PushBatch(opr_batch, default_ctx, 0, profiling);
+  }
 }
 
 #define INIT_DETACHED(x, y)   if (!y->is_none()) x->InitDetached(y)
@@ -647,7 +806,7 @@ OpStatePtr CachedOp::StaticForward(
   using namespace imperative;
 
   bool recording = Imperative::Get()->is_recording();
-  auto state_ptr = GetCachedOpState(default_ctx);
+  auto state_ptr = GetStaticState(default_ctx, inputs);
   auto& state = state_ptr.get_state<CachedOpState>();
 
   // Need to lock the mutex on the state, this allows
@@ -756,6 +915,14 @@ OpStatePtr CachedOp::DynamicForward(
     RunGraph(false, idx, arrays, 0, idx.num_nodes(), std::move(array_reqs),
             std::move(ref_count), &states, dispatch_modes,
             recording && inlining_, nullptr, monitor_callback_, monitor_all_);
+    // In the inline mode the recorded operators hold the activations themselves.
+    if (recording && !inlining_ && config_.offload_activations &&
+        default_ctx.dev_mask() == gpu::kDevMask) {
+      runtime.offloaded = OffloadActivations(
+          idx, g.GetAttr<std::vector<uint32_t> >(AddPrefix(FORWARD, REF_COUNT)),
+          g.GetAttr<std::vector<uint32_t> >(AddPrefix(FULL, REF_COUNT)),
+          arrays, config_.offload_min_size, &buff);
+    }
   } else {
     mxnet::ShapeVector shapes = g.GetAttr<mxnet::ShapeVector>("shape");
     NaiveRunGraph(false, default_ctx, idx, arrays, 0, idx.num_nodes(),
@@ -773,6 +940,35 @@ OpStatePtr CachedOp::DynamicForward(
   return op_state;
 }
 
+void CachedOp::SetBackwardMirror(const std::vector<NDArray*>& inputs) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!mirror_shapes_.empty()) return;
+  // The mirrored graph stays valid for other shapes, they only guide which nodes pay off.
+  for (const NDArray* input : inputs) {
+    mirror_shapes_.push_back(input->shape());
+    mirror_dtypes_.push_back(input->dtype());
+  }
+  // The states created so far hold graphs without mirroring
+  cached_op_states_.clear();
+  static_states_.clear();
+}
+
+#if MXNET_USE_MKLDNN == 1
+void CachedOp::PrepackWeights(const Context& ctx,
+                              const std::vector<NDArray*>& inputs,
+                              const std::vector<NDArray*>& outputs) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!prepacked_ctxs_.insert(ctx).second) return;
+  }
+  // The MKLDNN operators push the conversion of their weights to the blocked layouts of
+  // their primitives when they run, so the pass is waited for, then the conversions.
+  // The converted arrays replace the default ones, so only the blocked copy is kept.
+  for (const NDArray* out : outputs) out->WaitToRead();
+  for (const uint32_t i : config_.param_indices) inputs[i]->WaitToRead();
+}
+#endif
+
 OpStatePtr CachedOp::Forward(
     const std::shared_ptr<CachedOp>& op_ptr,
     const std::vector<NDArray*>& inputs,
@@ -781,6 +977,10 @@ OpStatePtr CachedOp::Forward(
   static const auto cached_op = nnvm::Op::Get("_CachedOp");
 
   CHECK_EQ(inputs.size(), num_inputs());
+  // The mirroring is planned from the shapes of the first recorded forward pass
+  if (config_.backward_mirror && !inlining_ && Imperative::Get()->is_recording()) {
+    SetBackwardMirror(inputs);
+  }
   // Assign the storage information for the input arguments. Similar to the
   // implementation in `graph_executor.cc`, we use `mutable_input_nodes()` to
   // distinguish between weight parameters and auxiliary states.
@@ -833,6 +1033,13 @@ OpStatePtr CachedOp::Forward(
 
   Engine::Get()->set_bulk_size(prev_bulk_size);
 
+#if MXNET_USE_MKLDNN == 1
+  if (config_.prepack_weights && !Imperative::Get()->is_training() &&
+      default_ctx.dev_mask() == cpu::kDevMask) {
+    PrepackWeights(default_ctx, inputs, outputs);
+  }
+#endif
+
   if (Imperative::Get()->is_recording() && !inlining_) {
     nnvm::NodeAttrs attrs;
     attrs.op = cached_op;
@@ -918,9 +1125,45 @@ void CachedOp::DynamicBackward(
 
   const auto& dispatch_modes = g.GetAttr<DispatchModeVector>("dispatch_mode");
 
-  RunGraph(retain_graph, idx, arrays, num_forward_nodes, idx.num_nodes(),
-           std::move(array_reqs), std::move(ref_count), &states, dispatch_modes,
-           Imperative::Get()->is_recording(), nullptr, monitor_callback_);
+  if (runtime.offloaded.empty()) {
+    RunGraph(retain_graph, idx, arrays, num_forward_nodes, idx.num_nodes(),
+             std::move(array_reqs), std::move(ref_count), &states, dispatch_modes,
+             Imperative::Get()->is_recording(), nullptr, monitor_callback_);
+  } else {
+    // Run the operators one at a time, to order the copies back of the offloaded
+    // activations after the operator preceding their first use by the prefetch distance.
+    const auto prefetch = PlanPrefetch(idx, num_forward_nodes, runtime.offloaded,
+                                       config_.offload_prefetch_distance);
+    std::vector<NDArray> host_copies;
+    if (retain_graph) {
+      for (const uint32_t eid : runtime.offloaded) host_copies.push_back(buff[eid]);
+    }
+    auto issue = [&](uint32_t nid, const std::vector<NDArray>& after) {
+      auto it = prefetch.find(nid);
+      if (it == prefetch.end()) return;
+      for (const uint32_t eid : it->second) {
+        buff[eid] = PrefetchActivation(buff[eid], default_ctx, after);
+      }
+    };
+    issue(num_forward_nodes - 1, {});
+    // RunGraph updates the reqs and ref counts in place, they carry over between the calls.
+    for (size_t nid = num_forward_nodes; nid < idx.num_nodes(); ++nid) {
+      std::vector<NDArray> written;
+      if (prefetch.count(nid)) {
+        for (uint32_t j = 0; j < idx[nid].source->num_outputs(); ++j) {
+          written.push_back(*arrays[idx.entry_id(nid, j)]);
+        }
+      }
+      RunGraph(retain_graph, idx, arrays, nid, nid + 1,
+               std::move(array_reqs), std::move(ref_count), &states, dispatch_modes,
+               Imperative::Get()->is_recording(), nullptr, monitor_callback_);
+      issue(nid, written);
+    }
+    // keep the activations offloaded for the next backward pass
+    for (size_t i = 0; i < host_copies.size(); ++i) {
+      buff[runtime.offloaded[i]] = host_copies[i];
+    }
+  }
 
   if (retain_graph) {
     buff.resize(num_forward_entries);
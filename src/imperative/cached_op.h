@@ -22,11 +22,13 @@
 
 #include <mxnet/imperative.h>
 #include <vector>
+#include <list>
 #include <numeric>
 #include <atomic>
 #include <utility>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <map>
 #include "../operator/operator_common.h"
 #include "../operator/subgraph/common.h"
@@ -51,6 +53,7 @@ std::string AddPrefix(const std::string& prefix,
 nnvm::NodeEntry AggregateGradient(std::vector<nnvm::NodeEntry>&& v) {
   using nnvm::Op;
   static size_t inplace_sum_cap = dmlc::GetEnv("MXNET_EXEC_INPLACE_GRAD_SUM_CAP", 8);
+  static size_t tree_sum_arity = dmlc::GetEnv("MXNET_EXEC_GRAD_SUM_TREE_ARITY", 0);
   static const Op* ewise_plus_op = Op::Get("_grad_add");
   static const Op* ewise_sum_op = Op::Get("ElementWiseSum");
   static const Op* identity_op = Op::Get("identity");
@@ -85,6 +88,54 @@ nnvm::NodeEntry AggregateGradient(std::vector<nnvm::NodeEntry>&& v) {
       sum_node->attrs.op->attr_parser(&(sum_node->attrs));
       sum_node->inputs = std::move(v);
       return nnvm::NodeEntry(std::move(sum_node), 0, 0);
+    } else if (tree_sum_arity >= 2) {
+      // balanced tree of sums built while the gradients are produced: every `arity`
+      // partial sums of the same level are summed into one of the next level, so at most
+      // (arity - 1) partial sums per level, O(log n) in total, are alive at once.
+      std::vector<std::pair<size_t, nnvm::NodeEntry> > partials;  // (level, partial sum)
+      std::unordered_set<nnvm::Node*> summed;
+      nnvm::ObjectPtr last_sum;
+      size_t num_sums = 0;
+      auto make_sum = [&](std::vector<nnvm::NodeEntry>&& inputs) {
+        nnvm::ObjectPtr sum_node = nnvm::Node::Create();
+        sum_node->attrs.op = ewise_sum_op;
+        sum_node->attrs.name = "sum_grad_tree_" + std::to_string(num_sums++);
+        sum_node->attrs.dict["num_args"] = std::to_string(inputs.size());
+        sum_node->attrs.op->attr_parser(&(sum_node->attrs));
+        sum_node->inputs = std::move(inputs);
+        last_sum = sum_node;
+        return nnvm::NodeEntry(std::move(sum_node), 0, 0);
+      };
+      for (auto& e : v) {
+        // Produce the gradient after the last sum, so that the partial sums are reduced
+        // before more gradients are alive. Safe by the invariant of the stream line below,
+        // unless the producer of e also produced one of the summed gradients.
+        if (last_sum != nullptr && !e.node->is_variable() && !summed.count(e.node.get())) {
+          e.node->control_deps.push_back(last_sum);
+        }
+        summed.insert(e.node.get());
+        partials.emplace_back(0, std::move(e));
+        while (partials.size() >= tree_sum_arity) {
+          const size_t level = partials.back().first;
+          auto first = partials.end() - tree_sum_arity;
+          if (!std::all_of(first, partials.end(),
+                           [level](const std::pair<size_t, nnvm::NodeEntry>& p) {
+                             return p.first == level;
+                           })) {
+            break;
+          }
+          std::vector<nnvm::NodeEntry> inputs;
+          for (auto it = first; it != partials.end(); ++it) inputs.push_back(std::move(it->second));
+          partials.erase(first, partials.end());
+          partials.emplace_back(level + 1, make_sum(std::move(inputs)));
+        }
+      }
+      if (partials.size() == 1) {
+        return std::move(partials[0].second);
+      }
+      std::vector<nnvm::NodeEntry> inputs;
+      for (auto& p : partials) inputs.push_back(std::move(p.second));
+      return make_sum(std::move(inputs));
     } else {
       // use a stream line of plus instead
       nnvm::NodeEntry ret = v[0];
@@ -214,11 +265,49 @@ void CreateForwardGraph(const nnvm::Symbol &sym, nnvm::Graph *fwd_graph) {
   }
 }
 
-/* \brief construct grad_graph from fwd_graph and ograd_entries*/
+/*!
+ * \brief Whether the outputs of a forward node may be recomputed during backward
+ *  instead of being kept alive. Compute-heavy operators are kept, as well as the
+ *  operators whose recomputation would differ or which keep a state for backward.
+ *  The __force_mirroring__ attribute of a node overrides the choice for it.
+ */
+int BackwardMirrorPolicy(const nnvm::Node& node) {
+  using namespace nnvm;
+  static const std::unordered_set<std::string> heavy_ops{
+    "Convolution", "Deconvolution", "FullyConnected", "Concat", "SoftmaxOutput",
+    "dot", "batch_dot", "_npi_matmul", "_npi_dot", "_npi_tensordot", "_npi_einsum"};
+  static auto& fcreate_op_state = Op::GetAttr<FCreateOpState>("FCreateOpState");
+  static auto& fresource = Op::GetAttr<FResourceRequest>("FResourceRequest");
+  static auto& fresource_ex = Op::GetAttr<FResourceRequestEx>("FResourceRequestEx");
+  if (node.is_variable()) return false;
+  const Op* op = node.op();
+  if (fcreate_op_state.count(op) || fresource_ex.count(op)) return false;
+  if (fresource.count(op)) {
+    for (const auto& req : fresource[op](node.attrs)) {
+      if (req.type == ResourceRequest::kRandom || req.type == ResourceRequest::kParallelRandom) {
+        return false;
+      }
+    }
+  }
+  auto it = node.attrs.dict.find("__force_mirroring__");
+  if (it != node.attrs.dict.end()) {
+    return it->second == "True" || it->second == "true" || it->second == "1";
+  }
+  return heavy_ops.count(op->name) == 0;
+}
+
+/*!
+ * \brief construct grad_graph from fwd_graph and ograd_entries
+ *  When the shapes and types of the forward inputs are given, the outputs of the
+ *  nodes accepted by BackwardMirrorPolicy are recomputed in backward wherever that
+ *  reduces the memory kept between forward and backward.
+ */
 void CreateBackwardGraph(nnvm::Graph* fwd_graph,
                          nnvm::Graph* grad_graph,
                          std::vector<nnvm::NodeEntry>* ograd_entries,
-                         std::unordered_map<uint32_t, uint32_t>* fwd_input_to_grad_output) {
+                         std::unordered_map<uint32_t, uint32_t>* fwd_input_to_grad_output,
+                         const mxnet::ShapeVector& mirror_shapes = mxnet::ShapeVector(),
+                         const nnvm::DTypeVector& mirror_dtypes = nnvm::DTypeVector()) {
   using namespace nnvm;
   static const std::vector<const Op*> zero_ops{Op::Get("zeros_like"), Op::Get("_zeros")};
   ograd_entries->reserve(fwd_graph->outputs.size());
@@ -248,6 +337,17 @@ void CreateBackwardGraph(nnvm::Graph* fwd_graph,
 
   // There are inputs in computation graph that require gradients
   if (!xs.empty()) {
+    if (!mirror_shapes.empty()) {
+      try {
+        *grad_graph = pass::MXGradient(
+             *fwd_graph, fwd_graph->outputs, xs, *ograd_entries,
+             mxnet::AggregateGradient, BackwardMirrorPolicy,
+             zero_ops, "_copy", mirror_shapes, mirror_dtypes);
+        return;
+      } catch (const dmlc::Error &e) {
+        LOG(WARNING) << "Backward mirroring is disabled for this graph: " << e.what();
+      }
+    }
     try {
       *grad_graph = pass::MXGradient(
            *fwd_graph, fwd_graph->outputs, xs, *ograd_entries,
@@ -267,7 +367,9 @@ void CreateFullGraph(const nnvm::Symbol& sym,
                      nnvm::Graph* grad_graph,
                      nnvm::Graph* full_graph,
                      std::vector<nnvm::NodeEntry>* ograd_entries,
-                     std::unordered_map<uint32_t, uint32_t>* fwd_input_to_grad_output) {
+                     std::unordered_map<uint32_t, uint32_t>* fwd_input_to_grad_output,
+                     const mxnet::ShapeVector& mirror_shapes = mxnet::ShapeVector(),
+                     const nnvm::DTypeVector& mirror_dtypes = nnvm::DTypeVector()) {
   using namespace nnvm;
   CreateForwardGraph(sym, fwd_graph);
 
@@ -277,7 +379,7 @@ void CreateFullGraph(const nnvm::Symbol& sym,
 
   // construct backward graph
   CreateBackwardGraph(fwd_graph, grad_graph, ograd_entries,
-                      fwd_input_to_grad_output);
+                      fwd_input_to_grad_output, mirror_shapes, mirror_dtypes);
 
   full_graph->outputs = fwd_graph->outputs;
   // add backward graph outputs to full graph
@@ -330,18 +432,27 @@ void OptimizeGraph(nnvm::Graph* full_graph, nnvm::Graph* fwd_graph, nnvm::Graph*
                    size_t num_forward_outputs, const bool inlining) {
   input_map->resize(full_graph->indexed_graph().input_nodes().size());
   std::iota(input_map->begin(), input_map->end(), 0);
-#if MXNET_USE_CUDA && !defined(_WIN32)
-  if (context.dev_mask() == kGPU &&
-      !inlining &&
-      dmlc::GetEnv("MXNET_USE_FUSION", true)) {
+  // fusion is on by default on GPU, and needs to be enabled explicitly on CPU
+  bool use_fusion = !inlining &&
+                    dmlc::GetEnv("MXNET_USE_FUSION", context.dev_mask() == kGPU);
+#if !MXNET_USE_CUDA || defined(_WIN32)
+  if (use_fusion && context.dev_mask() == kGPU) {
+    // Only warn user if MXNET_USE_FUSION env var is explicitly set
+    if (dmlc::GetEnv("MXNET_USE_FUSION", false)) {
+      exec::WarnFusionNotSupported();
+    }
+    use_fusion = false;
+  }
+#endif  // !MXNET_USE_CUDA || defined(_WIN32)
+  if (use_fusion && (context.dev_mask() == kGPU || context.dev_mask() == kCPU)) {
     nnvm::Graph unoptimized_graph;
     common::CopyGraph(&unoptimized_graph, *full_graph, false);
 
     if (common::CheckForInputNameDuplicates(unoptimized_graph.indexed_graph())) {
       full_graph->attrs["num_forward_outputs"] = std::make_shared<nnvm::any>(num_forward_outputs);
-      *full_graph = exec::FusePointwiseForward(std::move(*full_graph));
+      *full_graph = exec::FusePointwiseForward(std::move(*full_graph), context.dev_mask());
       full_graph->attrs["num_forward_outputs"] = std::make_shared<nnvm::any>(num_forward_outputs);
-      *full_graph = exec::FusePointwiseBackward(std::move(*full_graph));
+      *full_graph = exec::FusePointwiseBackward(std::move(*full_graph), context.dev_mask());
       // Fill in input_map - mapping from the new to the original input indices.
       const auto &original_inputs = unoptimized_graph.indexed_graph().input_nodes();
       const auto &new_inputs = full_graph->indexed_graph().input_nodes();
@@ -369,13 +480,6 @@ void OptimizeGraph(nnvm::Graph* full_graph, nnvm::Graph* fwd_graph, nnvm::Graph*
         << "Graph contains duplicate names for some of its inputs - fusion is NOT enabled!";
      }
   }
-#else
-  // Only warn user if MXNET_USE_FUSION env var is explicitly set
-  if (context.dev_mask() == kGPU && !inlining &&
-      dmlc::GetEnv("MXNET_USE_FUSION", false)) {
-    exec::WarnFusionNotSupported();
-  }
-#endif  // MXNET_USE_CUDA && !defined(_WIN32)
 
   *fwd_graph = nnvm::Graph();
   fwd_graph->outputs = std::vector<nnvm::NodeEntry>(full_graph->outputs.begin(),
@@ -419,6 +523,15 @@ struct CachedOpConfig : public dmlc::Parameter<CachedOpConfig> {
   bool static_alloc;
   bool static_shape;
   bool is_dynamic;
+  bool offload_activations;
+  int64_t offload_min_size;
+  uint32_t offload_prefetch_distance;
+  bool backward_mirror;
+  uint32_t static_cache_size;
+  uint32_t static_shape_bucket;
+  bool memory_arena;
+  bool alias_concat;
+  bool prepack_weights;
   mxnet::Tuple<uint32_t> data_indices;
   mxnet::Tuple<uint32_t> param_indices;
   std::string subgraph;
@@ -453,6 +566,49 @@ struct CachedOpConfig : public dmlc::Parameter<CachedOpConfig> {
     DMLC_DECLARE_FIELD(is_dynamic)
     .set_default(false)
     .describe("Whether the graph contains dynamic shape operators.");
+    DMLC_DECLARE_FIELD(static_cache_size)
+    .set_default(0)
+    .describe("With static_alloc, number of input shape signatures per context that "
+              "keep static states of their own, the least recently used ones are "
+              "evicted. 0 shares the static states between all the input shapes.");
+    DMLC_DECLARE_FIELD(static_shape_bucket)
+    .set_default(0)
+    .describe("With static_cache_size, the dimensions of the data inputs are rounded "
+              "up to a multiple of this value to look up the static state, so that "
+              "the shapes of a bucket share the memory of one state. 0 disables "
+              "bucketing.");
+    DMLC_DECLARE_FIELD(memory_arena)
+    .set_default(false)
+    .describe("Place the intermediate entries of each graph in a single allocation, at "
+              "offsets packed by the lifetimes of the entries, instead of allocating "
+              "every reused buffer separately.");
+    DMLC_DECLARE_FIELD(alias_concat)
+    .set_default(false)
+    .describe("Plan the inputs of a concat as slices of its output, and the outputs of a "
+              "split as slices of its input, so that they are not copied. Only applies "
+              "to the axes whose leading dimensions are all 1.");
+    DMLC_DECLARE_FIELD(prepack_weights)
+    .set_default(false)
+    .describe("With MKLDNN, convert the parameters to the blocked layouts of the "
+              "operators during the first inference pass on each CPU context, and wait "
+              "for the conversion, so that the later passes use them without reordering.");
+    DMLC_DECLARE_FIELD(backward_mirror)
+    .set_default(dmlc::GetEnv("MXNET_BACKWARD_DO_MIRROR", false) ||
+                 dmlc::GetEnv("MXNET_MEMORY_OPT", 0))
+    .describe("Recompute cheap forward operators during backward instead of keeping "
+              "their outputs alive, to reduce the memory used by training.");
+    DMLC_DECLARE_FIELD(offload_activations)
+    .set_default(false)
+    .describe("Move the activations saved for backward to pinned host memory after "
+              "a recorded forward pass on GPU, and copy them back during backward. "
+              "Ignored with static_alloc.");
+    DMLC_DECLARE_FIELD(offload_min_size)
+    .set_default(1 << 20)
+    .describe("Activations smaller than this many bytes are not offloaded.");
+    DMLC_DECLARE_FIELD(offload_prefetch_distance)
+    .set_default(2)
+    .describe("Number of backward operators an offloaded activation is copied back "
+              "ahead of its first use.");
   }
 };
 
@@ -539,17 +695,21 @@ class CachedOp {
     std::unordered_map<uint32_t, uint32_t> fwd_input_to_grad_output;
     std::vector<OpReqType> bwd_output_reqs;
     std::vector<uint32_t> bwd_input_eid;
+    // backward nodes given a control dependency by OrderBackwardForMemory
+    std::vector<nnvm::ObjectPtr> bwd_order_deps;
   };
 
   struct CachedOpState {
     CachedOpState(const Context &context_, const nnvm::Graph &fwd_graph_,
-                  const nnvm::Graph &full_graph_, const bool inlining_) {
+                  const nnvm::Graph &full_graph_, const bool inlining_,
+                  const mxnet::ShapeVector &mirror_shapes = mxnet::ShapeVector(),
+                  const nnvm::DTypeVector &mirror_dtypes = nnvm::DTypeVector()) {
       context = context_;
       nnvm::Symbol sym;
       sym.outputs = fwd_graph_.outputs;
       CreateFullGraph(sym.Copy(), &info.fwd_graph, &info.grad_graph,
                       &info.full_graph, &info.ograd_entries,
-                      &info.fwd_input_to_grad_output);
+                      &info.fwd_input_to_grad_output, mirror_shapes, mirror_dtypes);
 
       OptimizeGraph(&info.full_graph, &info.fwd_graph, &info.grad_graph, &info.input_map,
                     context_, fwd_graph_.outputs.size(), inlining_);
@@ -566,10 +726,16 @@ class CachedOp {
       arrays.resize(max_entries);
       array_reqs.resize(max_entries);
       dynamic_entries.resize(max_entries, false);
+      sparse_capacity.resize(max_entries, 0);
       op_states.resize(max_nodes);
       execs.resize(max_nodes);
       opr_segs.resize(max_nodes);
     }
+    ~CachedOpState() {
+      if (temp_space.ptr_ != nullptr) {
+        ResourceManager::Get()->ReleaseTempSpaceArena(temp_space);
+      }
+    }
 
     std::mutex mutex;
     Context context;
@@ -593,9 +759,21 @@ class CachedOp {
     std::vector<bool> dynamic_entries;
     std::multimap<size_t, NDArray> fwd_reuse_pool;
     std::multimap<size_t, NDArray> bwd_reuse_pool;
+    /*!
+     * \brief largest number of stored rows (row_sparse) or non-zeros (csr) seen in each
+     *        sparse entry, reserved when the entry is planned again
+     */
+    std::vector<dim_t> sparse_capacity;
+    /*!
+     * \brief temporary space of the operators with static memory, when
+     *        MXNET_CACHEDOP_TEMP_ARENA is set. It is created with the first static
+     *        executors and sized by the largest request of this graph only.
+     */
+    Resource temp_space;
   };
 
   OpStatePtr GetCachedOpState(const Context& ctx);
+  virtual OpStatePtr GetStaticState(const Context& ctx, const std::vector<NDArray*>& inputs);
   bool SetForwardGraph(
       const Context& default_ctx,
       GraphInfo* info,
@@ -606,6 +784,9 @@ class CachedOp {
       const std::vector<OpReqType>& reqs,
       const std::vector<NDArray*>& inputs,
       bool detect_inplace_addto = false);
+  void OrderBackwardForMemory(
+      GraphInfo* info,
+      const std::vector<NDArray*>& inputs);
   bool CheckDynamicShapeExists(
       const Context& default_ctx,
       const std::vector<NDArray*>& inputs,
@@ -650,6 +831,13 @@ class CachedOp {
       const std::vector<OpReqType>& reqs,
       const std::vector<NDArray*>& outputs);
   size_t BwdOriginalInput(const std::vector<size_t>& input_map, size_t new_i);
+  void SetBackwardMirror(const std::vector<NDArray*>& inputs);
+#if MXNET_USE_MKLDNN == 1
+  /*! \brief wait for the first inference pass on ctx to convert the weights */
+  void PrepackWeights(const Context& ctx,
+                      const std::vector<NDArray*>& inputs,
+                      const std::vector<NDArray*>& outputs);
+#endif
 
   CachedOpConfig config_;
   nnvm::Graph fwd_graph_;
@@ -660,12 +848,20 @@ class CachedOp {
   std::vector<uint32_t> bwd_in_dep_, bwd_out_dep_, bwd_ograd_dep_;
   std::vector<bool> save_inputs_, save_outputs_;
   std::vector<OpReqType> bwd_output_reqs_;
+  /*! \brief shapes and types of the forward inputs the backward mirroring is planned for */
+  mxnet::ShapeVector mirror_shapes_;
+  nnvm::DTypeVector mirror_dtypes_;
 
   std::function<void(const char*, const char*, NDArrayHandle)> monitor_callback_{nullptr};
   bool monitor_all_{false};
 
   std::mutex mutex_;
   std::unordered_map<Context, std::vector<OpStatePtr> > cached_op_states_;
+  /*! \brief contexts whose parameters were converted by prepack_weights */
+  std::unordered_set<Context> prepacked_ctxs_;
+  /*! \brief static states by input shape signature, the most recently used first */
+  std::unordered_map<Context, std::list<std::pair<mxnet::ShapeVector,
+                                                  std::vector<OpStatePtr> > > > static_states_;
 
   friend class ::mxnet::io::LazyTransformDataset;
   nnvm::Symbol sym_;
@@ -676,6 +872,8 @@ struct CachedOp::DynamicRuntime {
   GraphInfo info;
   std::vector<NDArray> buff;
   std::vector<OpStatePtr> op_states;
+  /*! \brief forward entries of buff offloaded to pinned host memory */
+  std::vector<uint32_t> offloaded;
 };
 
 using CachedOpPtr = std::shared_ptr<CachedOp>;
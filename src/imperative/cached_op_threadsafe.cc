@@ -17,8 +17,11 @@
  * under the License.
  */
 
+#include <algorithm>
 #include <unordered_set>
 #include <iostream>
+#include <memory>
+#include <utility>
 #include "./imperative_utils.h"
 #include "./exec_pass.h"
 #include "./cached_op_threadsafe.h"
@@ -39,26 +42,68 @@ struct CachedOpThreadSafe::DynamicRuntime {
   std::vector<OpStatePtr> op_states;
 };
 
-OpStatePtr CachedOpThreadSafe::GetCachedOpState(
-    const Context& ctx) {
+namespace {
 
-  for (const auto& i : cached_op_states_[ctx]) {
-    // only create one state per device when not using static memory
-    if (!config_.static_alloc || i.unique()) {
-      return i;
+/*!
+ * \brief Erases the states of a thread from the cached ops it ran when the thread exits,
+ *  so that the states of short lived threads do not pile up in a long lived op.
+ */
+class ThreadStatesGuard {
+ public:
+  void Register(const std::shared_ptr<CachedOpThreadSafe::ThreadStates>& thread_states) {
+    // drop the ops already freed
+    registered_.erase(std::remove_if(registered_.begin(), registered_.end(),
+                                     [](const auto& weak) { return weak.expired(); }),
+                      registered_.end());
+    for (const auto& weak : registered_) {
+      if (weak.lock() == thread_states) return;
     }
+    registered_.emplace_back(thread_states);
   }
-  nnvm::Graph full_graph;
-  auto state_ptr = OpStatePtr::Create<CachedOpState>(ctx, fwd_graph_, full_graph, false);
 
-  cached_op_states_[ctx].push_back(state_ptr);
+  ~ThreadStatesGuard() {
+    const std::thread::id id = std::this_thread::get_id();
+    std::vector<OpStatePtr> released;
+    for (const auto& weak : registered_) {
+      auto thread_states = weak.lock();
+      if (!thread_states) continue;
+      std::lock_guard<std::mutex> lock(thread_states->mutex);
+      for (auto& ctx_states : thread_states->states) {
+        auto it = ctx_states.second.find(id);
+        if (it == ctx_states.second.end()) continue;
+        released.push_back(std::move(it->second));
+        ctx_states.second.erase(it);
+      }
+    }
+    // the states are freed out of the locks
+  }
+
+ private:
+  std::vector<std::weak_ptr<CachedOpThreadSafe::ThreadStates>> registered_;
+};
+
+}  // namespace
+
+OpStatePtr CachedOpThreadSafe::GetCachedOpState(
+    const Context& ctx) {
+  // Every thread gets a state of its own: with static memory, requests sharing the
+  // buffers of a state would be serialized by the engine on their dependencies.
+  static thread_local ThreadStatesGuard guard;
+  std::lock_guard<std::mutex> lock(thread_states_->mutex);
+  OpStatePtr& state_ptr = thread_states_->states[ctx][std::this_thread::get_id()];
+  if (!state_ptr) {
+    nnvm::Graph full_graph;
+    state_ptr = OpStatePtr::Create<CachedOpState>(ctx, fwd_graph_, full_graph, false);
+    guard.Register(thread_states_);
+  }
   return state_ptr;
 }
 
 
 CachedOpThreadSafe::CachedOpThreadSafe(const nnvm::Symbol& sym,
                                        const std::vector<std::pair<std::string,
-                                       std::string> >& flags) : CachedOp(sym, flags) {
+                                       std::string> >& flags)
+    : CachedOp(sym, flags), thread_states_(std::make_shared<ThreadStates>()) {
   using namespace nnvm;
   using namespace imperative;
   static const std::vector<const Op *> zero_ops{Op::Get("zeros_like"),
@@ -149,17 +194,8 @@ OpStatePtr CachedOpThreadSafe::Forward(const std::shared_ptr<CachedOp>& op_ptr,
                                        const std::vector<NDArray*>& inputs,
                                        const std::vector<NDArray*>& outputs,
                                        const Context& default_ctx) {
-  // Acquiring lock on the mutex in forward
-  // Without this there are issues with static_forward,
-  // specifically with static_shape=True and dynamic_forward.
-  // Adding the lock here for safety,
-  // The perf hit would be acceptable because this involves just pushing
-  // ops to engine and not actual execution
-  // We are putting this lock here because without this there is a hang
-  // in the accept4 call in CUDA lib.
-  // TODO(anirudh2290): Investigate this issue more as it also prevents parallel
-  // push of ops for different contexts
-  std::lock_guard<std::mutex> lock(mutex_);
+  // Threads run on states of their own and push to the engine concurrently, their
+  // operators overlap on the GPU worker streams (see MXNET_GPU_WORKER_NTHREADS).
   CHECK_EQ(inputs.size(), num_inputs());
   const auto& idx = fwd_graph_.indexed_graph();
   for (size_t i = 0; i < inputs.size(); ++i) {
@@ -174,7 +210,13 @@ OpStatePtr CachedOpThreadSafe::Forward(const std::shared_ptr<CachedOp>& op_ptr,
   int prev_bulk_size = Engine::Get()->set_bulk_size(config_.forward_bulk_size);
   OpStatePtr op_state;
   try {
-    if (CheckDynamicShapeExists(default_ctx, inputs, true)) {
+    bool dynamic_shape;
+    {
+      // the check runs once, on a state shared by the threads
+      std::lock_guard<std::mutex> lock(mutex_);
+      dynamic_shape = CheckDynamicShapeExists(default_ctx, inputs, true);
+    }
+    if (dynamic_shape) {
       LOG(FATAL) << "Dynamic shapes aren't supported with thread-safe cached op";
     }
     if (config_.static_alloc) {
@@ -25,8 +25,11 @@
 #include <mxnet/imperative.h>
 #include <vector>
 #include <atomic>
+#include <memory>
+#include <mutex>
 #include <utility>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include "./cached_op.h"
 
@@ -114,10 +117,18 @@ class CachedOpThreadSafe : public CachedOp {
   }
 
   struct GraphInfo;
+  /*! \brief states of the calling threads, so that concurrent requests share no buffer */
+  struct ThreadStates {
+    std::mutex mutex;
+    std::unordered_map<Context, std::unordered_map<std::thread::id, OpStatePtr>> states;
+  };
  private:
   struct DynamicRuntime;
 
   OpStatePtr GetCachedOpState(const Context& ctx);
+  OpStatePtr GetStaticState(const Context& ctx, const std::vector<NDArray*>& inputs) override {
+    return GetCachedOpState(ctx);
+  }
 
   OpStatePtr DynamicForward(const Context& default_ctx,
                             const std::vector<NDArray*>& inputs,
@@ -126,7 +137,8 @@ class CachedOpThreadSafe : public CachedOp {
   CachedOpThreadSafeConfig config_;
   nnvm::Graph fwd_graph_;
   std::mutex mutex_;
-  std::unordered_map<Context, std::vector<OpStatePtr>> cached_op_states_;
+  /*! \brief shared with the exiting threads, which erase their states */
+  std::shared_ptr<ThreadStates> thread_states_;
 };
 
 using CachedOpThreadSafePtr = std::shared_ptr<CachedOpThreadSafe>;
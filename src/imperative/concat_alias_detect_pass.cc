@@ -0,0 +1,190 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file concat_alias_detect_pass.cc
+ * \brief Place the inputs of concat in its output, and the outputs of split in its input.
+ */
+#include <mxnet/base.h>
+#include <mxnet/op_attr_types.h>
+#include <nnvm/graph_attr_types.h>
+
+#include <algorithm>
+#include <unordered_set>
+#include <vector>
+
+#include "./exec_pass.h"
+
+namespace mxnet {
+namespace exec {
+
+namespace {
+
+/*!
+ * \brief Whether the parts laid end to end are the whole array. The parts of a concat or
+ *  a split are contiguous in the whole when all the dimensions before its axis are 1: the
+ *  parts then only differ from the whole up to its first dimension larger than 1.
+ */
+bool Contiguous(const mxnet::TShape& whole, const std::vector<const mxnet::TShape*>& parts) {
+  if (!mxnet::shape_is_known(whole) || whole.Size() == 0) return false;
+  int lead = 0;
+  while (lead < whole.ndim() && whole[lead] == 1) ++lead;
+  size_t size = 0;
+  for (const mxnet::TShape* part : parts) {
+    if (!mxnet::shape_is_known(*part) || part->Size() == 0) return false;
+    // flattened concatenations and squeezed splits of a vector are contiguous too
+    if (whole.ndim() > 1) {
+      if (part->ndim() != whole.ndim()) return false;
+      for (int d = lead + 1; d < whole.ndim(); ++d) {
+        if ((*part)[d] != whole[d]) return false;
+      }
+    }
+    size += part->Size();
+  }
+  return size == whole.Size();
+}
+
+}  // namespace
+
+Graph DetectConcatAlias(Graph g) {
+  nnvm::StorageVector storage_id =
+      g.MoveCopyAttr<nnvm::StorageVector>("storage_id");
+  std::vector<int> storage_inplace_index =
+      g.MoveCopyAttr<std::vector<int> >("storage_inplace_index");
+  const auto& shapes = g.GetAttr<mxnet::ShapeVector>("shape");
+  const auto& dtypes = g.GetAttr<nnvm::DTypeVector>("dtype");
+  static const Op* concat_op = Op::Get("Concat");
+  static const Op* np_concat_op = Op::Get("_npi_concatenate");
+  static const Op* slice_channel_op = Op::Get("SliceChannel");
+  static const Op* split_op = Op::Get("_split_v2");
+  const auto& idx = g.indexed_graph();
+  std::vector<int> alias_entry(idx.num_node_entries(), -1);
+  std::vector<int64_t> alias_offset(idx.num_node_entries(), -1);
+  std::vector<int> alias_node(idx.num_nodes(), 0);
+
+  const auto ref_count = g.MoveCopyAttr<std::vector<uint32_t> >("ref_count");
+  // entries overwritten by an output planned in place of them, and storages of inplace
+  // addto, which their entries keep
+  std::vector<bool> overwritten(idx.num_node_entries(), false);
+  std::unordered_set<int> addto_sids;
+  int next_sid = 0;
+  for (uint32_t nid = 0; nid < idx.num_nodes(); ++nid) {
+    const auto& inode = idx[nid];
+    for (uint32_t i = 0; i < inode.source->num_outputs(); ++i) {
+      const uint32_t eid = idx.entry_id(nid, i);
+      next_sid = std::max(next_sid, storage_id[eid] + 1);
+      if (storage_inplace_index[eid] >= 0) {
+        overwritten[idx.entry_id(inode.inputs[storage_inplace_index[eid]])] = true;
+      }
+    }
+  }
+  if (g.attrs.count("addto_entry")) {
+    const auto& addto_entry = g.GetAttr<std::vector<int> >("addto_entry");
+    for (uint32_t eid = 0; eid < idx.num_node_entries(); ++eid) {
+      if (addto_entry[eid]) addto_sids.insert(storage_id[eid]);
+    }
+  }
+  auto eligible = [&](uint32_t eid) {
+    return storage_id[eid] >= 0 && alias_entry[eid] < 0 && !addto_sids.count(storage_id[eid]) &&
+           mxnet::shape_is_known(shapes[eid]) && dtypes[eid] != -1;
+  };
+
+  for (uint32_t nid = 0; nid < idx.num_nodes(); ++nid) {
+    const auto& inode = idx[nid];
+    // the outputs planned in place of an entry of a group stay in its slice
+    for (uint32_t i = 0; i < inode.source->num_outputs(); ++i) {
+      const uint32_t eid = idx.entry_id(nid, i);
+      if (storage_inplace_index[eid] < 0) continue;
+      const uint32_t src = idx.entry_id(inode.inputs[storage_inplace_index[eid]]);
+      if (alias_entry[src] < 0) continue;
+      storage_id[eid] = storage_id[src];
+      alias_entry[eid] = alias_entry[src];
+      alias_offset[eid] = alias_offset[src];
+    }
+    const Op* op = inode.source->op();
+    uint32_t whole = 0;
+    std::vector<uint32_t> parts;
+    bool ok;
+    if (op == concat_op || op == np_concat_op) {
+      whole = idx.entry_id(nid, 0);
+      // a concat output never read is not worth a storage of its own
+      if (storage_inplace_index[whole] == -2) continue;
+      for (const auto& e : inode.inputs) parts.push_back(idx.entry_id(e));
+      // overwriting an input would overwrite the output
+      ok = eligible(whole) && std::all_of(parts.begin(), parts.end(), [&](uint32_t eid) {
+        return eligible(eid) && !overwritten[eid];
+      });
+    } else if (op == slice_channel_op || op == split_op) {
+      whole = idx.entry_id(inode.inputs[0]);
+      for (uint32_t i = 0; i < inode.source->num_outputs(); ++i) {
+        parts.push_back(idx.entry_id(nid, i));
+      }
+      // overwriting an output would overwrite the input for its other readers, backward
+      // included
+      ok = eligible(whole) && !overwritten[whole] &&
+           std::all_of(parts.begin(), parts.end(), [&](uint32_t eid) {
+             return eligible(eid) && (!overwritten[eid] || ref_count[whole] == 1);
+           });
+    } else {
+      continue;
+    }
+    if (!ok || !std::all_of(parts.begin(), parts.end(), [&](uint32_t eid) {
+          return dtypes[eid] == dtypes[whole];
+        })) {
+      continue;
+    }
+    std::vector<uint32_t> sorted_parts = parts;
+    std::sort(sorted_parts.begin(), sorted_parts.end());
+    if (std::adjacent_find(sorted_parts.begin(), sorted_parts.end()) != sorted_parts.end() ||
+        std::binary_search(sorted_parts.begin(), sorted_parts.end(), whole)) {
+      continue;
+    }
+    std::vector<const mxnet::TShape*> part_shapes;
+    for (const uint32_t eid : parts) part_shapes.push_back(&shapes[eid]);
+    if (!Contiguous(shapes[whole], part_shapes)) continue;
+
+    // the group leaves the storages it shared with entries of other lifetimes
+    const int sid = next_sid++;
+    const size_t dtype_size = mshadow::mshadow_sizeof(dtypes[whole]);
+    int64_t offset = 0;
+    for (const uint32_t eid : parts) {
+      alias_offset[eid] = offset;
+      offset += static_cast<int64_t>(shapes[eid].Size() * dtype_size);
+    }
+    alias_offset[whole] = 0;
+    parts.push_back(whole);
+    for (const uint32_t eid : parts) {
+      storage_id[eid] = sid;
+      alias_entry[eid] = static_cast<int>(whole);
+      if (storage_inplace_index[eid] >= 0) storage_inplace_index[eid] = -1;
+    }
+    alias_node[nid] = 1;
+  }
+
+  g.attrs["storage_id"] = std::make_shared<nnvm::any>(std::move(storage_id));
+  g.attrs["storage_inplace_index"] = std::make_shared<nnvm::any>(
+      std::move(storage_inplace_index));
+  g.attrs["alias_entry"] = std::make_shared<nnvm::any>(std::move(alias_entry));
+  g.attrs["alias_offset"] = std::make_shared<nnvm::any>(std::move(alias_offset));
+  g.attrs["alias_node"] = std::make_shared<nnvm::any>(std::move(alias_node));
+  return g;
+}
+
+}  // namespace exec
+}  // namespace mxnet
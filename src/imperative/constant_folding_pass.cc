@@ -0,0 +1,191 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file constant_folding_pass.cc
+ * \brief Evaluate the parts of the graph depending only on its parameters
+ *
+ *  The pass is applied through optimize_for with the name FoldConstants. The
+ *  inputs given as args or aux are constants, except those listed in the
+ *  comma-separated option `data`. Every node whose inputs are all constants is
+ *  evaluated once, and the outputs still read by the rest of the graph are
+ *  replaced by new args holding their values.
+ */
+
+#include <mxnet/base.h>
+#include <mxnet/imperative.h>
+#include <mxnet/ndarray.h>
+#include <mxnet/op_attr_types.h>
+#include <nnvm/graph.h>
+#include <nnvm/pass.h>
+#include <nnvm/symbolic.h>
+
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace mxnet {
+namespace exec {
+
+namespace {
+
+using nnvm::Graph;
+using nnvm::Node;
+using nnvm::ObjectPtr;
+
+/*!
+ * \brief Whether evaluating the node once gives the value of every later evaluation.
+ */
+bool IsFoldable(const Node& n) {
+  static auto& fmutate = nnvm::Op::GetAttr<nnvm::FMutateInputs>("FMutateInputs");
+  static auto& fstateful = nnvm::Op::GetAttr<FCreateOpState>("FCreateOpState");
+  static auto& fresource = nnvm::Op::GetAttr<FResourceRequest>("FResourceRequest");
+  static auto& fresource_ex = nnvm::Op::GetAttr<FResourceRequestEx>("FResourceRequestEx");
+  if (n.is_variable() || n.inputs.empty() || !n.attrs.subgraphs.empty())
+    return false;
+  const nnvm::Op* op = n.op();
+  if (fmutate.count(op) || fstateful.count(op))
+    return false;
+  std::vector<ResourceRequest> resources;
+  if (fresource_ex.count(op)) {
+    // the dispatch mode does not change whether the op draws random numbers
+    resources = fresource_ex[op](n.attrs, Context::kCPU, DispatchMode::kFCompute);
+  } else if (fresource.count(op)) {
+    resources = fresource[op](n.attrs);
+  }
+  for (const auto& req : resources) {
+    if (req.type == ResourceRequest::kRandom || req.type == ResourceRequest::kParallelRandom)
+      return false;
+  }
+  return true;
+}
+
+std::unordered_set<std::string> SplitNames(const std::string& names) {
+  std::unordered_set<std::string> ret;
+  std::istringstream is(names);
+  std::string name;
+  while (std::getline(is, name, ',')) {
+    if (!name.empty()) ret.insert(name);
+  }
+  return ret;
+}
+
+}  // namespace
+
+Graph FoldConstants(Graph&& g) {
+  using OptionsMap = std::unordered_map<std::string, std::string>;
+  const auto& options = g.GetAttr<OptionsMap>("options_map");
+  const auto data_it = options.find("data");
+  const auto data_names = SplitNames(data_it == options.end() ? "" : data_it->second);
+
+  // values of the constant inputs
+  std::unordered_map<std::string, NDArray*> values;
+  auto add_values = [&](const char* arrays_attr, const char* names_attr) {
+    NDArray** arrays = g.GetAttr<NDArray**>(arrays_attr);
+    const auto& names = g.GetAttr<std::vector<std::string> >(names_attr);
+    for (size_t i = 0; arrays != nullptr && i < names.size(); ++i) {
+      if (arrays[i] != nullptr && !data_names.count(names[i])) {
+        values[names[i]] = arrays[i];
+      }
+    }
+  };
+  add_values("in_args", "in_arg_names");
+  add_values("in_aux", "in_aux_names");
+
+  std::unordered_set<std::string> input_names;
+  DFSVisit(g.outputs, [&input_names](const ObjectPtr& n) {
+    if (n->is_variable()) input_names.insert(n->attrs.name);
+  });
+
+  // evaluate the constant nodes in topological order, with autograd off
+  std::unordered_map<const Node*, std::vector<NDArray> > folded;
+  const bool prev_recording = Imperative::Get()->set_is_recording(false);
+  const bool prev_training = Imperative::Get()->set_is_training(false);
+  DFSVisit(g.outputs, [&values, &folded](const ObjectPtr& n) {
+    if (!IsFoldable(*n))
+      return;
+    std::vector<NDArray*> inputs;
+    for (const auto& e : n->inputs) {
+      if (e.node->is_variable()) {
+        auto it = values.find(e.node->attrs.name);
+        if (it == values.end()) return;
+        inputs.push_back(it->second);
+      } else {
+        auto it = folded.find(e.node.get());
+        if (it == folded.end()) return;
+        inputs.push_back(&it->second[e.index]);
+      }
+    }
+    std::vector<NDArray> outputs(n->num_outputs());
+    std::vector<NDArray*> output_ptrs;
+    for (auto& output : outputs) output_ptrs.push_back(&output);
+    Imperative::Get()->Invoke(inputs[0]->ctx(), n->attrs, inputs, output_ptrs);
+    folded[n.get()] = std::move(outputs);
+  });
+  Imperative::Get()->set_is_training(prev_training);
+  Imperative::Get()->set_is_recording(prev_recording);
+
+  // replace the constant entries read by the rest of the graph by new args
+  std::vector<NDArray*> new_args;
+  std::vector<std::string> new_arg_names;
+  std::unordered_map<const Node*, std::unordered_map<uint32_t, nnvm::NodeEntry> > replaced;
+  auto replace = [&](nnvm::NodeEntry* e) {
+    auto it = folded.find(e->node.get());
+    if (it == folded.end())
+      return;
+    auto& by_index = replaced[e->node.get()];
+    if (!by_index.count(e->index)) {
+      std::string name = e->node->attrs.name + "_folded";
+      if (e->node->num_outputs() > 1) name += std::to_string(e->index);
+      while (input_names.count(name)) name += "_";
+      input_names.insert(name);
+      by_index[e->index] = nnvm::Symbol::CreateVariable(name).outputs[0];
+      new_args.push_back(new NDArray(it->second[e->index]));
+      new_arg_names.push_back(name);
+    }
+    *e = by_index[e->index];
+  };
+  DFSVisit(g.outputs, [&folded, &replace](const ObjectPtr& n) {
+    if (folded.count(n.get()))
+      return;
+    for (auto& e : n->inputs) replace(&e);
+  });
+  for (auto& e : g.outputs) replace(&e);
+
+  Graph ret;
+  ret.outputs = g.outputs;
+  ret.attrs["new_args"] = std::make_shared<nnvm::any>(std::move(new_args));
+  ret.attrs["new_arg_names"] = std::make_shared<nnvm::any>(std::move(new_arg_names));
+  ret.attrs["new_aux"] = std::make_shared<nnvm::any>(std::vector<NDArray*>());
+  ret.attrs["new_aux_names"] = std::make_shared<nnvm::any>(std::vector<std::string>());
+  return ret;
+}
+
+NNVM_REGISTER_PASS(FoldConstants)
+.describe("Replace the nodes depending only on the args and aux by their values.")
+.set_body(FoldConstants)
+.set_change_graph(true)
+.depend_graph_attr("options_map")
+.depend_graph_attr("in_args")
+.depend_graph_attr("in_aux");
+
+}  // namespace exec
+}  // namespace mxnet
@@ -0,0 +1,271 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file convert_layout_pass.cc
+ * \brief Rewrite the convolution part of a graph to a channels-last layout
+ *
+ *  The pass is applied through optimize_for with the name ConvertLayout and the
+ *  option `layout` (NHWC, the default, or NDHWC). Convolution and Pooling are
+ *  switched to the target layout, and the layout is propagated through the ops
+ *  that do not depend on it (elementwise ops, BatchNorm and Concat over the
+ *  channel axis). Transposes are only inserted where a tensor enters or leaves
+ *  the converted region: graph inputs and outputs, convolution weights and the
+ *  ops that need the original layout, e.g. Flatten.
+ */
+
+#include <mxnet/base.h>
+#include <mxnet/ndarray.h>
+#include <nnvm/graph.h>
+#include <nnvm/pass.h>
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "../operator/nn/batch_norm-inl.h"
+#include "../operator/nn/concat-inl.h"
+#include "../operator/nn/convolution-inl.h"
+#include "../operator/nn/dropout-inl.h"
+#include "../operator/nn/pooling-inl.h"
+
+namespace mxnet {
+namespace exec {
+
+namespace {
+
+using nnvm::Node;
+using nnvm::NodeEntry;
+using nnvm::ObjectPtr;
+
+/*!
+ * \brief Ops computing each output element from the elements at the same index of
+ *        their inputs, so they give the same result with all inputs permuted alike.
+ */
+const std::unordered_set<const nnvm::Op*>& LayoutAgnosticOps() {
+  static const std::unordered_set<const nnvm::Op*> ops = []() {
+    std::unordered_set<const nnvm::Op*> ret;
+    for (const char* name : {
+        "Activation", "LeakyReLU", "Dropout", "relu", "sigmoid", "tanh", "softsign",
+        "clip", "Cast", "amp_cast", "amp_multicast", "BlockGrad", "_copy", "identity",
+        "negative", "abs", "square", "sqrt", "exp", "log",
+        "_plus_scalar", "_minus_scalar", "_rminus_scalar", "_mul_scalar", "_div_scalar",
+        "_rdiv_scalar", "_maximum_scalar", "_minimum_scalar",
+        "elemwise_add", "elemwise_sub", "elemwise_mul", "elemwise_div", "add_n",
+        "broadcast_add", "broadcast_sub", "broadcast_mul", "broadcast_div",
+        "broadcast_maximum", "broadcast_minimum",
+        "_npi_add", "_npi_subtract", "_npi_multiply", "_npi_true_divide",
+        "_npi_add_scalar", "_npi_subtract_scalar", "_npi_multiply_scalar",
+        "_npi_true_divide_scalar", "_npi_maximum", "_npi_minimum"}) {
+      const nnvm::Op* op = dmlc::Registry<nnvm::Op>::Find(name);
+      if (op != nullptr) ret.insert(op);
+    }
+    return ret;
+  }();
+  return ops;
+}
+
+/*!
+ * \brief Conversion between a channels-first layout and its channels-last counterpart.
+ */
+class LayoutConverter {
+ public:
+  explicit LayoutConverter(const std::string& target) {
+    if (target == "NHWC") {
+      src_layout_ = mshadow::kNCHW;
+    } else if (target == "NDHWC") {
+      src_layout_ = mshadow::kNCDHW;
+    } else {
+      LOG(FATAL) << "ConvertLayout: unsupported target layout " << target
+                 << ", expected NHWC or NDHWC";
+    }
+    target_ = target;
+    ndim_ = static_cast<int>(target.size());
+  }
+
+  /*! \brief Rewrite the graph, returning its new outputs. */
+  std::vector<NodeEntry> Run(const std::vector<NodeEntry>& outputs) {
+    static const nnvm::Op* conv_op = nnvm::Op::Get("Convolution");
+    static const nnvm::Op* pool_op = nnvm::Op::Get("Pooling");
+    static const nnvm::Op* bn_op = nnvm::Op::Get("BatchNorm");
+    static const nnvm::Op* concat_op = nnvm::Op::Get("Concat");
+    static const nnvm::Op* dropout_op = nnvm::Op::Get("Dropout");
+    const auto& agnostic = LayoutAgnosticOps();
+
+    DFSVisit(outputs, [&](const ObjectPtr& n) {
+      if (n->is_variable())
+        return;
+      const nnvm::Op* node_op = n->op();
+      const bool all_converted = !n->inputs.empty() &&
+          std::all_of(n->inputs.begin(), n->inputs.end(),
+                      [this](const NodeEntry& e) { return IsConverted(e); });
+      if (node_op == conv_op) {
+        const auto& param = nnvm::get<op::ConvolutionParam>(n->attrs.parsed);
+        if (HasSourceLayout(param.layout) &&
+            static_cast<int>(param.kernel.ndim()) == ndim_ - 2) {
+          // the weight is permuted like the data, OIHW becomes OHWI
+          for (uint32_t i = 0; i < 2; ++i) n->inputs[i] = ToTarget(n->inputs[i]);
+          SetAttr(n.get(), "layout", target_);
+          converted_.insert({n.get(), 0});
+          return;
+        }
+      } else if (node_op == pool_op) {
+        const auto& param = nnvm::get<op::PoolingParam>(n->attrs.parsed);
+        if (HasSourceLayout(param.layout) &&
+            (static_cast<int>(param.kernel.ndim()) == ndim_ - 2 || IsConverted(n->inputs[0]))) {
+          n->inputs[0] = ToTarget(n->inputs[0]);
+          SetAttr(n.get(), "layout", target_);
+          converted_.insert({n.get(), 0});
+          return;
+        }
+      } else if (node_op == bn_op) {
+        const auto& param = nnvm::get<op::BatchNormParam>(n->attrs.parsed);
+        if (IsConverted(n->inputs[op::batchnorm::kData]) &&
+            (param.axis == 1 || param.axis == 1 - ndim_)) {
+          SetAttr(n.get(), "axis", std::to_string(ndim_ - 1));
+          converted_.insert({n.get(), op::batchnorm::kOut});
+          return;
+        }
+      } else if (node_op == concat_op) {
+        const auto& param = nnvm::get<op::ConcatParam>(n->attrs.parsed);
+        if (all_converted && (param.dim == 1 || param.dim == 1 - ndim_)) {
+          SetAttr(n.get(), "dim", std::to_string(ndim_ - 1));
+          converted_.insert({n.get(), 0});
+          return;
+        }
+      } else if (agnostic.count(node_op) && all_converted) {
+        if (node_op != dropout_op ||
+            nnvm::get<op::DropoutParam>(n->attrs.parsed).axes.ndim() == 0) {
+          for (uint32_t i = 0; i < n->num_outputs(); ++i) converted_.insert({n.get(), i});
+          return;
+        }
+      }
+      // the op needs the original layout
+      for (auto& e : n->inputs) {
+        if (IsConverted(e)) e = ToSource(e);
+      }
+    });
+
+    std::vector<NodeEntry> ret = outputs;
+    for (auto& e : ret) {
+      if (IsConverted(e)) e = ToSource(e);
+    }
+    return ret;
+  }
+
+ private:
+  using EntryKey = std::pair<const Node*, uint32_t>;
+
+  bool HasSourceLayout(const dmlc::optional<int>& layout) const {
+    return !layout.has_value() || layout.value() == src_layout_;
+  }
+
+  bool IsConverted(const NodeEntry& e) const {
+    return converted_.count({e.node.get(), e.index}) > 0;
+  }
+
+  static void SetAttr(Node* n, const std::string& key, const std::string& value) {
+    n->attrs.dict[key] = value;
+    n->op()->attr_parser(&(n->attrs));
+  }
+
+  /*! \brief Entry holding the (source layout) value of e in the target layout. */
+  NodeEntry ToTarget(const NodeEntry& e) {
+    if (IsConverted(e))
+      return e;
+    std::string axes = "(0,";
+    for (int i = 2; i < ndim_; ++i) axes += std::to_string(i) + ",";
+    axes += "1)";
+    NodeEntry ret = Transpose(e, axes, "_to_" + target_, &to_target_, &to_source_);
+    converted_.insert({ret.node.get(), ret.index});
+    return ret;
+  }
+
+  /*! \brief Entry holding the (target layout) value of e in the source layout. */
+  NodeEntry ToSource(const NodeEntry& e) {
+    std::string axes = "(0," + std::to_string(ndim_ - 1);
+    for (int i = 1; i < ndim_ - 1; ++i) axes += "," + std::to_string(i);
+    axes += ")";
+    return Transpose(e, axes, "_from_" + target_, &to_source_, &to_target_);
+  }
+
+  /*!
+   * \brief Transpose e once, recording the inverse so that a value converted back
+   *        and forth reuses the original entry.
+   */
+  NodeEntry Transpose(const NodeEntry& e, const std::string& axes, const std::string& suffix,
+                      std::map<EntryKey, NodeEntry>* cache,
+                      std::map<EntryKey, NodeEntry>* inverse) {
+    static const nnvm::Op* transpose_op = nnvm::Op::Get("transpose");
+    const EntryKey key{e.node.get(), e.index};
+    auto it = cache->find(key);
+    if (it != cache->end())
+      return it->second;
+    ObjectPtr node = Node::Create();
+    node->attrs.op = transpose_op;
+    node->attrs.name = e.node->attrs.name + suffix;
+    node->attrs.dict["axes"] = axes;
+    transpose_op->attr_parser(&(node->attrs));
+    node->inputs.push_back(e);
+    NodeEntry ret(node, 0, 0);
+    (*cache)[key] = ret;
+    (*inverse)[{node.get(), 0}] = e;
+    return ret;
+  }
+
+  int src_layout_;
+  std::string target_;
+  int ndim_;
+  /*! \brief entries holding values in the target layout */
+  std::set<EntryKey> converted_;
+  std::map<EntryKey, NodeEntry> to_target_;
+  std::map<EntryKey, NodeEntry> to_source_;
+};
+
+}  // namespace
+
+nnvm::Graph ConvertGraphLayout(nnvm::Graph&& g) {
+  using OptionsMap = std::unordered_map<std::string, std::string>;
+  const auto& options = g.GetAttr<OptionsMap>("options_map");
+  const auto layout_it = options.find("layout");
+  LayoutConverter converter(layout_it == options.end() ? "NHWC" : layout_it->second);
+
+  nnvm::Graph ret;
+  ret.outputs = converter.Run(g.outputs);
+  ret.attrs["new_args"] = std::make_shared<nnvm::any>(std::vector<NDArray*>());
+  ret.attrs["new_arg_names"] = std::make_shared<nnvm::any>(std::vector<std::string>());
+  ret.attrs["new_aux"] = std::make_shared<nnvm::any>(std::vector<NDArray*>());
+  ret.attrs["new_aux_names"] = std::make_shared<nnvm::any>(std::vector<std::string>());
+  return ret;
+}
+
+NNVM_REGISTER_PASS(ConvertLayout)
+.describe("Rewrite Convolution and Pooling to a channels-last layout, propagating it "
+          "through the ops that do not depend on it.")
+.set_body(ConvertGraphLayout)
+.set_change_graph(true)
+.depend_graph_attr("options_map");
+
+}  // namespace exec
+}  // namespace mxnet
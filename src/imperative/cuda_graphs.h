@@ -0,0 +1,212 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file cuda_graphs.h
+ * \brief Capture and replay of bulked engine segments with CUDA Graphs.
+ *
+ *  Enabled with MXNET_ENABLE_CUDA_GRAPHS=1 for CachedOps created with
+ *  static_alloc=True and static_shape=True. A segment runs normally the first
+ *  time it sees a given set of input/output pointers (warm-up, so that workspaces
+ *  get allocated and algorithm searches are done), is captured into a CUDA graph
+ *  the second time and replayed from the graph afterwards. Segments that fail to
+ *  capture, e.g. because an operator synchronizes the stream, fall back to
+ *  regular execution for good.
+ *
+ *  Temporary workspaces are assumed not to move once the warm-up run sized them,
+ *  which holds as long as the shapes stay static.
+ */
+#ifndef MXNET_IMPERATIVE_CUDA_GRAPHS_H_
+#define MXNET_IMPERATIVE_CUDA_GRAPHS_H_
+
+#include <dmlc/parameter.h>
+#include <mxnet/base.h>
+#include <mxnet/op_attr_types.h>
+#include <nnvm/graph.h>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+#include "./exec_pass.h"
+
+#if MXNET_USE_CUDA
+#include <cuda_runtime.h>
+#include "../common/cuda/utils.h"
+// cudaStreamCaptureModeThreadLocal appeared in CUDA 10.1
+#define MXNET_CUDA_GRAPHS_SUPPORTED (CUDART_VERSION >= 10010)
+#else
+#define MXNET_CUDA_GRAPHS_SUPPORTED 0
+#endif
+
+namespace mxnet {
+namespace imperative {
+
+/*! \return whether CUDA graphs were requested through MXNET_ENABLE_CUDA_GRAPHS */
+inline bool CudaGraphsEnabled() {
+  static const bool enabled =
+      MXNET_CUDA_GRAPHS_SUPPORTED && dmlc::GetEnv("MXNET_ENABLE_CUDA_GRAPHS", false);
+  return enabled;
+}
+
+/*!
+ * \brief Whether an operator can be part of a captured graph.
+ *  Asynchronous operators and operators drawing random numbers from a shared
+ *  generator are excluded, as well as operators whose FIsCUDAGraphsCompatible
+ *  attribute says so.
+ */
+inline bool IsCudaGraphsCompatible(const nnvm::NodeAttrs& attrs,
+                                   const exec::OpExecutor& exec,
+                                   bool is_train) {
+  static auto& fcompatible =
+      nnvm::Op::GetAttr<FIsCUDAGraphsCompatible>("FIsCUDAGraphsCompatible");
+  if (exec.exec_type() != ExecType::kSync) return false;
+  for (const auto& r : exec.op_ctx.requested) {
+    if (r.req.type == ResourceRequest::kRandom ||
+        r.req.type == ResourceRequest::kParallelRandom) return false;
+  }
+  if (attrs.op != nullptr && fcompatible.count(attrs.op)) {
+    return fcompatible[attrs.op](attrs, is_train);
+  }
+  return true;
+}
+
+/*!
+ * \brief Runs the executors of one engine segment, through CUDA graphs when possible.
+ */
+class CudaGraphsExec {
+ public:
+  explicit CudaGraphsExec(const std::vector<std::shared_ptr<exec::OpExecutor> >& execs,
+                          const std::string& opr_names)
+      : execs_(execs), opr_names_(opr_names),
+        max_graphs_(dmlc::GetEnv("MXNET_CUDA_GRAPHS_MAX_CACHE_SIZE", 8)) {}
+
+  ~CudaGraphsExec() {
+#if MXNET_CUDA_GRAPHS_SUPPORTED
+    for (auto& g : graphs_) g.Destroy();
+#endif
+  }
+  /*! \brief run all the executors of the segment, without synchronizing the stream */
+  void Run(RunContext rctx) {
+#if MXNET_CUDA_GRAPHS_SUPPORTED
+    if (!disabled_) {
+      std::vector<void*> key = PointerKey();
+      for (auto& g : graphs_) {
+        if (g.key == key) {
+          if (g.exec == nullptr && !Capture(rctx, &g)) break;
+          CUDA_CALL(cudaGraphLaunch(
+              g.exec, mshadow::Stream<gpu>::GetStream(rctx.get_stream<gpu>())));
+          return;
+        }
+      }
+      if (!disabled_) {
+        // first time these pointers are seen: warm up, capture on the next run
+        if (graphs_.size() >= static_cast<size_t>(max_graphs_)) {
+          graphs_.front().Destroy();
+          graphs_.pop_front();
+        }
+        graphs_.emplace_back();
+        graphs_.back().key = std::move(key);
+      }
+    }
+#endif
+    RunExecs(rctx);
+  }
+
+ private:
+  void RunExecs(RunContext rctx) {
+    for (const auto& exec : execs_) exec->Run(rctx, true);
+  }
+
+#if MXNET_CUDA_GRAPHS_SUPPORTED
+  /*! \brief a captured graph together with the data pointers captured in it */
+  struct CapturedGraph {
+    std::vector<void*> key;
+    cudaGraph_t graph{nullptr};
+    cudaGraphExec_t exec{nullptr};
+    void Destroy() {
+      // errors are ignored, the driver may be shutting down
+      if (exec != nullptr) cudaGraphExecDestroy(exec);
+      if (graph != nullptr) cudaGraphDestroy(graph);
+      exec = nullptr;
+      graph = nullptr;
+    }
+  };
+
+  /*! \return the data pointers the kernels of the segment are launched with */
+  std::vector<void*> PointerKey() const {
+    std::vector<void*> key;
+    for (const auto& exec : execs_) {
+      for (const auto& nd : exec->in_array) key.push_back(nd.data().dptr_);
+      for (const auto& nd : exec->out_array) key.push_back(nd.data().dptr_);
+    }
+    return key;
+  }
+
+  /*!
+   * \brief Capture the kernels of the segment into g.
+   *  Nothing runs on the device during capture, so on failure the segment can
+   *  simply be executed again the regular way.
+   * \return whether the capture succeeded.
+   */
+  bool Capture(RunContext rctx, CapturedGraph* g) {
+    cudaStream_t stream = mshadow::Stream<gpu>::GetStream(rctx.get_stream<gpu>());
+    CUDA_CALL(cudaStreamBeginCapture(stream, cudaStreamCaptureModeThreadLocal));
+    bool ok = true;
+    try {
+      RunExecs(rctx);
+    } catch (const dmlc::Error& e) {
+      ok = false;
+    }
+    cudaGraph_t graph = nullptr;
+    const cudaError_t end = cudaStreamEndCapture(stream, &graph);
+    ok = ok && end == cudaSuccess && graph != nullptr;
+    if (ok) {
+      ok = cudaGraphInstantiate(&g->exec, graph, nullptr, nullptr, 0) == cudaSuccess;
+      g->graph = graph;
+    } else if (graph != nullptr) {
+      cudaGraphDestroy(graph);
+    }
+    if (!ok) {
+      // clear the sticky capture error and never try again for this segment
+      cudaGetLastError();
+      LOG(INFO) << "Segment " << opr_names_ << " cannot be captured into a CUDA graph, "
+                << "running it without CUDA graphs";
+      disabled_ = true;
+      for (auto& cached : graphs_) cached.Destroy();
+      graphs_.clear();
+    }
+    return ok;
+  }
+
+  /*! \brief captured graphs, oldest first */
+  std::deque<CapturedGraph> graphs_;
+#endif
+  /*! \brief executors of the segment */
+  std::vector<std::shared_ptr<exec::OpExecutor> > execs_;
+  /*! \brief names of the operators, for logging */
+  std::string opr_names_;
+  /*! \brief maximum number of graphs kept for different pointers */
+  int max_graphs_;
+  /*! \brief whether capture failed for this segment */
+  bool disabled_{false};
+};
+
+}  // namespace imperative
+}  // namespace mxnet
+#endif  // MXNET_IMPERATIVE_CUDA_GRAPHS_H_
@@ -31,6 +31,7 @@
 #include <mxnet/graph_attr_types.h>
 #include <nnvm/graph.h>
 #include <nnvm/graph_attr_types.h>
+#include <map>
 #include <vector>
 #include <memory>
 #include <string>
@@ -171,11 +172,14 @@ void AttachOpResources(const Graph& g);
  * \param op_execs OpExecutor vector
  * \param start_nid starting node id
  * \param end_nid end node id
+ * \param temp_space temporary space to use for the nodes of a context, instead of
+ *        the shared copies of the resource manager
  */
 void AttachOpResources(const Graph& g,
                        const OpExecVector& op_execs,
                        size_t start_nid,
-                       size_t end_nid);
+                       size_t end_nid,
+                       const std::map<Context, Resource>& temp_space = {});
 /*!
  * \brief Discover chance of inplace addto operators.
  *  i.e. z = plus(z, source_op), and encourage it to become z += source_op.
@@ -194,6 +198,27 @@ void AttachOpResources(const Graph& g,
  */
 Graph DetectInplaceAddTo(Graph g);
 
+/*!
+ * \brief Place the inputs of the concats in slices of their output, and the outputs of
+ *  the splits in slices of their input, so that the concats and splits copy nothing.
+ *
+ * Only concats and splits on an axis all of whose leading dimensions are 1 have
+ * contiguous slices. The entries of one of them get a storage of their own, which the
+ * outputs planned in place of the concat output or of the split outputs share.
+ *
+ * Require storage placement to be already finished.
+ *
+ * \param g input graph with the storage_id, storage_inplace_index and ref_count attributes
+ *
+ * \return graph three new attributes, changes attributes "storage_id" and
+ *  "storage_inplace_index".
+ *  - "alias_entry", std::vector<int> size=g.num_node_entries()
+ *    - the concat output or split input whose storage holds the entry, -1 if none
+ *  - "alias_offset", std::vector<int64_t> offset in bytes of the entry in that storage
+ *  - "alias_node", std::vector<int> if set to 1, the outputs of the node are in place.
+ */
+Graph DetectConcatAlias(Graph g);
+
 /*!
  * \brief Eliminate common expressions in the graph.
  *
@@ -207,25 +232,38 @@ Graph EliminateCommonExpr(Graph && g);
  * \brief Fuse pointwise operations in the forward pass.
  *
  * \param g input graph (needs to be entire graph, not just forward part)
+ * \param dev_mask device the graph runs on, which decides the fusable operations
  *
  * \return graph with fused pointwise operations in the forward pass
  */
-Graph FusePointwiseForward(Graph&& g);
+Graph FusePointwiseForward(Graph&& g, int dev_mask);
 
 /*!
  * \brief Fuse pointwise operations in the backward pass.
  *
  * \param g input graph (needs to be entire graph, not just forward part)
+ * \param dev_mask device the graph runs on, which decides the fusable operations
  *
  * \return graph with fused pointwise operations in the backward pass
  */
-Graph FusePointwiseBackward(Graph&& g);
+Graph FusePointwiseBackward(Graph&& g, int dev_mask);
 
 /*!
  * \brief Issue a one-time warning that fusion is not possible for this platform or build.
  */
 void WarnFusionNotSupported();
 
+/*!
+ * \brief Order the nodes from node_start on to reduce the peak size of the live entries.
+ *
+ * \param g input graph, with the shape and dtype attributes of all entries
+ * \param node_start first node of the reordered part, e.g. the first backward node
+ *
+ * \return the nodes given an additional (last) control dependency enforcing the order,
+ *         empty when the current order has the lowest peak
+ */
+std::vector<nnvm::ObjectPtr> MemoryAwareOrder(const Graph& g, uint32_t node_start);
+
 /*!
  * \brief Infer shapes in the graph given the information.
  * \param graph The input graph.
@@ -0,0 +1,150 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file fuse_conv_bn_relu_pass.cc
+ * \brief Replace Convolution -> BatchNorm -> ReLU chains by _contrib_ConvBatchNormWithReLU
+ *
+ *  The pass is applied through optimize_for with the name FuseConvBNReLU. A chain is
+ *  fused when the convolution output only feeds the batch norm, the batch norm uses the
+ *  batch statistics (use_global_stats is off), its output only feeds the ReLU and its
+ *  mean and variance outputs are not used. The fused op gives the same forward and
+ *  backward results, including the update of the moving statistics.
+ */
+
+#include <mxnet/base.h>
+#include <mxnet/ndarray.h>
+#include <nnvm/graph.h>
+#include <nnvm/pass.h>
+
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../operator/nn/activation-inl.h"
+#include "../operator/nn/batch_norm-inl.h"
+#include "../operator/nn/convolution-inl.h"
+
+namespace mxnet {
+namespace exec {
+
+namespace {
+
+using nnvm::Node;
+using nnvm::NodeEntry;
+using nnvm::ObjectPtr;
+using EntryKey = std::pair<const Node*, uint32_t>;
+
+bool IsReLU(const Node* n) {
+  static const nnvm::Op* act_op = nnvm::Op::Get("Activation");
+  static const nnvm::Op* relu_op = dmlc::Registry<nnvm::Op>::Find("relu");
+  if (n->op() == relu_op)
+    return true;
+  return n->op() == act_op &&
+         nnvm::get<op::ActivationParam>(n->attrs.parsed).act_type == op::activation::kReLU;
+}
+
+/*! \brief Channel axis of the output of a convolution, -1 for unknown layouts. */
+int ChannelAxis(const op::ConvolutionParam& param) {
+  const int ndim = static_cast<int>(param.kernel.ndim()) + 2;
+  switch (param.layout.value()) {
+    case mshadow::kNCW:
+    case mshadow::kNCHW:
+    case mshadow::kNCDHW:
+      return 1;
+    case mshadow::kNWC:
+    case mshadow::kNHWC:
+    case mshadow::kNDHWC:
+      return ndim - 1;
+    default:
+      return -1;
+  }
+}
+
+/*! \brief Turn relu into the fused op if it ends a chain that can be fused. */
+void TryFuse(Node* relu, const std::map<EntryKey, int>& uses) {
+  static const nnvm::Op* conv_op = nnvm::Op::Get("Convolution");
+  static const nnvm::Op* bn_op = nnvm::Op::Get("BatchNorm");
+  static const nnvm::Op* fused_op = nnvm::Op::Get("_contrib_ConvBatchNormWithReLU");
+  auto use_count = [&uses](const Node* n, uint32_t index) {
+    auto it = uses.find({n, index});
+    return it == uses.end() ? 0 : it->second;
+  };
+
+  const NodeEntry& bn_out = relu->inputs[0];
+  const Node* bn = bn_out.node.get();
+  if (bn->op() != bn_op || bn_out.index != op::batchnorm::kOut ||
+      use_count(bn, op::batchnorm::kOut) != 1 || use_count(bn, op::batchnorm::kMean) ||
+      use_count(bn, op::batchnorm::kVar))
+    return;
+  const auto& bn_param = nnvm::get<op::BatchNormParam>(bn->attrs.parsed);
+  const NodeEntry& conv_out = bn->inputs[op::batchnorm::kData];
+  const Node* conv = conv_out.node.get();
+  if (bn_param.use_global_stats || conv->op() != conv_op || use_count(conv, 0) != 1)
+    return;
+  const auto& conv_param = nnvm::get<op::ConvolutionParam>(conv->attrs.parsed);
+  const int ndim = static_cast<int>(conv_param.kernel.ndim()) + 2;
+  const int bn_axis = bn_param.axis < 0 ? bn_param.axis + ndim : bn_param.axis;
+  if (bn_axis != ChannelAxis(conv_param) || conv_param.cudnn_off != bn_param.cudnn_off)
+    return;
+
+  nnvm::NodeAttrs attrs;
+  attrs.op = fused_op;
+  attrs.name = conv->attrs.name + "_bn_relu";
+  attrs.dict = conv->attrs.dict;
+  attrs.dict.insert(bn->attrs.dict.begin(), bn->attrs.dict.end());
+  fused_op->attr_parser(&attrs);
+  std::vector<NodeEntry> inputs = conv->inputs;
+  inputs.insert(inputs.end(), bn->inputs.begin() + 1, bn->inputs.end());
+  // the relu node becomes the fused node, so that its consumers need no rewiring
+  relu->attrs = std::move(attrs);
+  relu->inputs = std::move(inputs);
+}
+
+}  // namespace
+
+nnvm::Graph FuseConvBNReLU(nnvm::Graph&& g) {
+  std::map<EntryKey, int> uses;
+  std::vector<ObjectPtr> relus;
+  DFSVisit(g.outputs, [&](const ObjectPtr& n) {
+    for (const auto& e : n->inputs) ++uses[{e.node.get(), e.index}];
+    if (!n->is_variable() && IsReLU(n.get())) relus.push_back(n);
+  });
+  for (const auto& e : g.outputs) ++uses[{e.node.get(), e.index}];
+  for (const ObjectPtr& relu : relus) TryFuse(relu.get(), uses);
+
+  nnvm::Graph ret;
+  ret.outputs = g.outputs;
+  ret.attrs["new_args"] = std::make_shared<nnvm::any>(std::vector<NDArray*>());
+  ret.attrs["new_arg_names"] = std::make_shared<nnvm::any>(std::vector<std::string>());
+  ret.attrs["new_aux"] = std::make_shared<nnvm::any>(std::vector<NDArray*>());
+  ret.attrs["new_aux_names"] = std::make_shared<nnvm::any>(std::vector<std::string>());
+  return ret;
+}
+
+NNVM_REGISTER_PASS(FuseConvBNReLU)
+.describe("Replace Convolution, BatchNorm and ReLU chains by _contrib_ConvBatchNormWithReLU.")
+.set_body(FuseConvBNReLU)
+.set_change_graph(true)
+.depend_graph_attr("options_map");
+
+}  // namespace exec
+}  // namespace mxnet
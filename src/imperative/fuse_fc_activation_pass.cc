@@ -0,0 +1,120 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file fuse_fc_activation_pass.cc
+ * \brief Replace FullyConnected -> ReLU / GELU pairs by _contrib_FullyConnectedAct
+ *
+ *  The pass is applied through optimize_for with the name FuseFCActivation. A pair is
+ *  fused when the FullyConnected output only feeds an Activation or relu computing a ReLU,
+ *  or a LeakyReLU computing a GELU. The fused op gives the same forward and backward
+ *  results, and on GPU applies the bias and the ReLU in the epilogue of the GEMM.
+ */
+
+#include <mxnet/base.h>
+#include <mxnet/ndarray.h>
+#include <nnvm/graph.h>
+#include <nnvm/pass.h>
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../operator/leaky_relu-inl.h"
+#include "../operator/nn/activation-inl.h"
+
+namespace mxnet {
+namespace exec {
+
+namespace {
+
+using nnvm::Node;
+using nnvm::NodeEntry;
+using nnvm::ObjectPtr;
+using EntryKey = std::pair<const Node*, uint32_t>;
+
+/*! \brief The act_type of the fused op computing the activation n, nullptr for others. */
+const char* FusedActType(const Node* n) {
+  static const nnvm::Op* act_op = nnvm::Op::Get("Activation");
+  static const nnvm::Op* relu_op = dmlc::Registry<nnvm::Op>::Find("relu");
+  static const nnvm::Op* leaky_op = nnvm::Op::Get("LeakyReLU");
+  if (n->op() == relu_op) return "relu";
+  if (n->op() == act_op &&
+      nnvm::get<op::ActivationParam>(n->attrs.parsed).act_type == op::activation::kReLU)
+    return "relu";
+  if (n->op() == leaky_op &&
+      nnvm::get<op::LeakyReLUParam>(n->attrs.parsed).act_type == op::leakyrelu::kGELU)
+    return "gelu";
+  return nullptr;
+}
+
+/*! \brief Turn act into the fused op if its input is a FullyConnected only it uses. */
+void TryFuse(Node* act, const char* act_type, const std::map<EntryKey, int>& uses) {
+  static const nnvm::Op* fc_op = nnvm::Op::Get("FullyConnected");
+  static const nnvm::Op* fused_op = nnvm::Op::Get("_contrib_FullyConnectedAct");
+  const NodeEntry& fc_out = act->inputs[0];
+  const Node* fc = fc_out.node.get();
+  auto it = uses.find({fc, 0});
+  if (fc->op() != fc_op || it == uses.end() || it->second != 1)
+    return;
+
+  nnvm::NodeAttrs attrs;
+  attrs.op = fused_op;
+  attrs.name = fc->attrs.name + "_" + act_type;
+  attrs.dict = fc->attrs.dict;
+  attrs.dict["act_type"] = act_type;
+  fused_op->attr_parser(&attrs);
+  std::vector<NodeEntry> inputs = fc->inputs;
+  // the activation node becomes the fused node, so that its consumers need no rewiring
+  act->attrs = std::move(attrs);
+  act->inputs = std::move(inputs);
+}
+
+}  // namespace
+
+nnvm::Graph FuseFCActivation(nnvm::Graph&& g) {
+  std::map<EntryKey, int> uses;
+  std::vector<std::pair<ObjectPtr, const char*>> acts;
+  DFSVisit(g.outputs, [&](const ObjectPtr& n) {
+    for (const auto& e : n->inputs) ++uses[{e.node.get(), e.index}];
+    if (n->is_variable()) return;
+    const char* act_type = FusedActType(n.get());
+    if (act_type) acts.emplace_back(n, act_type);
+  });
+  for (const auto& e : g.outputs) ++uses[{e.node.get(), e.index}];
+  for (const auto& act : acts) TryFuse(act.first.get(), act.second, uses);
+
+  nnvm::Graph ret;
+  ret.outputs = g.outputs;
+  ret.attrs["new_args"] = std::make_shared<nnvm::any>(std::vector<NDArray*>());
+  ret.attrs["new_arg_names"] = std::make_shared<nnvm::any>(std::vector<std::string>());
+  ret.attrs["new_aux"] = std::make_shared<nnvm::any>(std::vector<NDArray*>());
+  ret.attrs["new_aux_names"] = std::make_shared<nnvm::any>(std::vector<std::string>());
+  return ret;
+}
+
+NNVM_REGISTER_PASS(FuseFCActivation)
+.describe("Replace FullyConnected and ReLU or GELU pairs by _contrib_FullyConnectedAct.")
+.set_body(FuseFCActivation)
+.set_change_graph(true)
+.depend_graph_attr("options_map");
+
+}  // namespace exec
+}  // namespace mxnet
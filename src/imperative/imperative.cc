@@ -18,11 +18,16 @@
  */
 #include <algorithm>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <type_traits>
 #include <unordered_map>
 #include <unordered_set>
 
 #include "./imperative_utils.h"
 #include "./cached_op.h"
+#include "../common/object_pool.h"
 
 namespace nnvm {
 ObjectPtr CreateVariableNode(const std::string &name);
@@ -46,6 +51,124 @@ Imperative* Imperative::Get() {
   return &inst;
 }
 
+namespace {
+
+/*!
+ * \brief Allocator of the recorded nodes. The nodes and their reference counts are allocated
+ *  together in blocks of an object pool, so that the nodes of an iteration reuse the blocks
+ *  the nodes of the previous iteration released after its backward, instead of the heap.
+ */
+template <typename T>
+struct TapeAllocator {
+  using value_type = T;
+  using Block = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+
+  TapeAllocator() = default;
+  template <typename U>
+  TapeAllocator(const TapeAllocator<U>&) {}  // NOLINT(runtime/explicit)
+
+  T* allocate(size_t n) {
+    CHECK_EQ(n, 1U);
+    return reinterpret_cast<T*>(pool_->New());
+  }
+  void deallocate(T* p, size_t) {
+    pool_->Delete(reinterpret_cast<Block*>(p));
+  }
+  template <typename U>
+  bool operator==(const TapeAllocator<U>&) const { return true; }
+  template <typename U>
+  bool operator!=(const TapeAllocator<U>&) const { return false; }
+
+ private:
+  /*! \brief kept by the nodes, which can be released after the static objects */
+  std::shared_ptr<common::ObjectPool<Block>> pool_{common::ObjectPool<Block>::_GetSharedRef()};
+};
+
+/*! \brief create a node of the autograd graph */
+nnvm::ObjectPtr CreateTapeNode() {
+  return std::allocate_shared<nnvm::Node>(TapeAllocator<nnvm::Node>());
+}
+
+/*!
+ * \brief Gradient graph of a recorded graph, with the attributes inferred for its backward
+ *  nodes. Built on a copy of the recorded nodes without their arrays, so that it can be
+ *  reused by the backward of the recorded graphs of the same structure.
+ */
+struct BackwardGraph {
+  /*! \brief the forward outputs followed by the gradients of xs */
+  nnvm::Graph graph;
+  std::vector<Context> vctx;
+  size_t num_forward_nodes;
+  size_t num_forward_entries;
+  /*! \brief entries of the head gradients, -1 for the ones not used */
+  std::vector<int> ograd_eids;
+};
+
+/*!
+ * \brief Structural key of a backward: the operators, attributes and connections of the
+ *  recorded nodes in topological order, the shapes, dtypes, storage types and contexts of
+ *  their arrays, the head gradients and the arrays of the gradients, empty for gradients of
+ *  variables out of the graph. As for the export of
+ *  the recorded graphs, the operators are identified by their attribute dicts, which the
+ *  operators invoked while recording fill, and the hybridized blocks by their CachedOp.
+ */
+std::string BackwardSignature(const std::vector<nnvm::ObjectPtr>& nodes,
+                              const std::unordered_map<const nnvm::Node*, uint32_t>& node_ids,
+                              const std::vector<nnvm::NodeEntry>& outputs,
+                              const std::vector<nnvm::NodeEntry>& ograds,
+                              const std::vector<nnvm::NodeEntry>& xs,
+                              const std::vector<NDArray*>& x_grads) {
+  static const nnvm::Op* cached_op = nnvm::Op::Get("_CachedOp");
+  std::ostringstream os;
+  auto write_array = [&os](const NDArray& arr) {
+    os << arr.shape() << ',' << arr.dtype() << ',' << arr.storage_type() << ';';
+  };
+  auto write_entry = [&os, &node_ids](const nnvm::NodeEntry& e) {
+    os << node_ids.at(e.node.get()) << ':' << e.index << ':' << e.version << ';';
+  };
+  os << Imperative::Get()->is_np_shape() << Imperative::Get()->is_np_default_dtype() << '|';
+  for (const auto& n : nodes) {
+    const Imperative::AGInfo& info = Imperative::AGInfo::Get(n);
+    if (n->is_variable()) {
+      os << "var " << info.grad_req << ' ';
+    } else if (n->op() == cached_op) {
+      // a hybridized block, which keeps its graph
+      os << n->op()->name << ' ' << nnvm::get<CachedOpPtr>(n->attrs.parsed).get() << ' ';
+    } else {
+      os << n->op()->name << ' ';
+      const std::map<std::string, std::string> dict(n->attrs.dict.begin(),
+                                                    n->attrs.dict.end());
+      for (const auto& kv : dict) os << kv.first << '=' << kv.second << ';';
+      for (const auto& subgraph : n->attrs.subgraphs) os << subgraph.get() << ';';
+    }
+    os << info.ctx.dev_type << ':' << info.ctx.dev_id << '(';
+    for (const auto& e : n->inputs) write_entry(e);
+    os << ')';
+    for (const auto& arr : info.outputs) write_array(arr);
+    os << '|';
+  }
+  for (const auto& e : outputs) write_entry(e);
+  os << '|';
+  for (const auto& e : ograds) write_array(Imperative::AGInfo::Get(e.node).outputs[0]);
+  os << '|';
+  for (const auto& e : xs) {
+    // the variables out of the graph are not worth a key
+    if (!node_ids.count(e.node.get())) return "";
+    write_entry(e);
+  }
+  os << '|';
+  for (const NDArray* arr : x_grads) write_array(*arr);
+  return os.str();
+}
+
+/*! \brief the backward graphs cached by the calling thread, by their signature */
+std::unordered_map<std::string, std::shared_ptr<BackwardGraph>>* BackwardGraphCache() {
+  static thread_local std::unordered_map<std::string, std::shared_ptr<BackwardGraph>> cache;
+  return &cache;
+}
+
+}  // namespace
+
 OpStatePtr Imperative::InvokeOp(
     const Context& ctx,
     const nnvm::NodeAttrs& attrs,
@@ -91,6 +214,7 @@ OpStatePtr Imperative::InvokeOp(
       << "Operator " << op->name << " is not implemented for "
       << (ctx.dev_mask() == gpu::kDevMask ? "GPU." : "CPU.");
   }
+  RecordOpCost(attrs, inputs, outputs);
 
   return state;
 }
@@ -114,7 +238,7 @@ OpStatePtr Imperative::Invoke(
   // TODO(piiswrong): infer ctx
   DispatchMode dispatch_mode = DispatchMode::kUndefined;
   Context ctx = GetContext(attrs, inputs, outputs, default_ctx);
-  SetShapeType(ctx, attrs, inputs, outputs, &dispatch_mode);
+  SetShapeTypeCached(ctx, attrs, inputs, outputs, &dispatch_mode);
   std::vector<OpReqType> req;
   SetWriteInplaceReq(inputs, outputs, &req);
   OpStatePtr ret = InvokeOp(ctx, attrs, inputs, outputs, req, dispatch_mode);
@@ -231,7 +355,7 @@ void Imperative::RecordOp(
   }
   if (!need_grad) return;
 
-  nnvm::ObjectPtr node = nnvm::Node::Create();
+  nnvm::ObjectPtr node = CreateTapeNode();
   node->attrs = std::move(attrs);
   node->attrs.name = "node_" + std::to_string(node_count_++);
   AGInfo& info = AGInfo::Create(node);
@@ -252,8 +376,8 @@ void Imperative::RecordOp(
 
   for (size_t i = 0; i < inputs.size(); ++i) {
     if (AGInfo::IsNone(*(inputs[i]))) {
-      nnvm::NodeEntry entry{nnvm::Symbol::CreateVariable(
-          "null" + std::to_string(variable_count_++)).outputs[0].node, 0, 0};
+      nnvm::NodeEntry entry{CreateTapeNode(), 0, 0};
+      entry.node->attrs.name = "null" + std::to_string(variable_count_++);
       AGInfo& input_info = AGInfo::Create(entry.node);
       input_info.ctx = inputs[i]->ctx();
       if (save_inputs[i]) {
@@ -386,23 +510,23 @@ std::vector<NDArray*> Imperative::Backward(
   static const Op* copy_op = Op::Get("_copy");
 
   // Construct forward graph
-  Graph graph;
-  graph.outputs.reserve(outputs.size());
+  Symbol sym;
+  sym.outputs.reserve(outputs.size());
   for (const auto& i : outputs) {
     CHECK(!AGInfo::IsNone(*i))
       << "Cannot differentiate node because it is not in a computational graph. "
       << "You need to set is_recording to true or use autograd.record() to save "
       << "computational graphs for backward. If you want to differentiate the same "
       << "graph twice, you need to pass retain_graph=True to backward.";
-    graph.outputs.emplace_back(i->autograd_entry_);
+    sym.outputs.emplace_back(i->autograd_entry_);
   }
-  size_t num_forward_outputs = graph.outputs.size();
+  size_t num_forward_outputs = sym.outputs.size();
 
   // Prepare head gradients
   std::vector<NodeEntry> ograd_entries;
   ograd_entries.reserve(ograds.size());
   for (size_t i = 0; i < outputs.size(); ++i) {
-    nnvm::ObjectPtr np = Node::Create();
+    nnvm::ObjectPtr np = CreateTapeNode();
     np->attrs.name = "_head_grad_" + std::to_string(i);
     ograd_entries.emplace_back(NodeEntry{np, 0, 0});
     AGInfo& info = AGInfo::Create(ograd_entries.back().node);
@@ -419,8 +543,6 @@ std::vector<NDArray*> Imperative::Backward(
   }
 
   // Get gradient graph
-  Symbol sym;
-  sym.outputs = graph.outputs;
   std::vector<NodeEntry> xs;
   std::vector<NDArray*> x_grads;
   std::vector<OpReqType> x_reqs;
@@ -454,31 +576,103 @@ std::vector<NDArray*> Imperative::Backward(
         << "There are no inputs in computation graph that require gradients.";
   }
 
-  Graph g_graph = pass::MXGradient(
-      graph, graph.outputs, xs, ograd_entries,
-      mxnet::AggregateGradient, nullptr,
-      zero_ops, "_copy");
-  CHECK_EQ(g_graph.outputs.size(), xs.size());
-  for (const auto& e : g_graph.outputs) {
-    if (e.node->op() == nullptr) {
-      auto node = Node::Create();
-      node->attrs.op = copy_op;
-      node->inputs.push_back(e);
-      graph.outputs.emplace_back(std::move(node));
-    } else {
-      graph.outputs.push_back(e);
+  // The recorded nodes, in the order of their ids in the gradient graph, which starts with
+  // the forward nodes
+  std::vector<ObjectPtr> fwd_nodes;
+  std::unordered_map<const Node*, uint32_t> fwd_ids;
+  nnvm::DFSVisit(sym.outputs, [&](const nnvm::ObjectPtr& n) {
+    fwd_ids.emplace(n.get(), fwd_nodes.size());
+    fwd_nodes.push_back(n);
+  });
+
+  // Reuse the gradient graph of a recorded graph of the same structure
+  static const size_t cache_capacity =
+      dmlc::GetEnv("MXNET_IMPERATIVE_BACKWARD_CACHE_SIZE", static_cast<size_t>(16));
+  auto* cache = BackwardGraphCache();
+  std::string signature;
+  std::shared_ptr<BackwardGraph> bwd;
+  if (cache_capacity > 0 && !create_graph) {
+    signature = BackwardSignature(fwd_nodes, fwd_ids, sym.outputs, ograd_entries, xs, x_grads);
+    auto it = signature.empty() ? cache->end() : cache->find(signature);
+    if (it != cache->end()) bwd = it->second;
+  }
+  const bool cache_hit = bwd != nullptr;
+  if (!cache_hit) {
+    bwd = std::make_shared<BackwardGraph>();
+    // copies of the recorded nodes and of the head gradients, with their contexts only
+    std::vector<ObjectPtr> fwd_copies(fwd_nodes.size());
+    std::unordered_map<const Node*, ObjectPtr> other_copies;
+    auto copy_entry = [&](const NodeEntry& e) {
+      auto it = fwd_ids.find(e.node.get());
+      if (it != fwd_ids.end()) return NodeEntry{fwd_copies[it->second], e.index, e.version};
+      // a variable out of the graph, whose gradient is 0
+      ObjectPtr& copy = other_copies[e.node.get()];
+      if (copy == nullptr) {
+        copy = Node::Create();
+        copy->attrs = e.node->attrs;
+        AGInfo::Create(copy).ctx = AGInfo::Get(e.node).ctx;
+      }
+      return NodeEntry{copy, e.index, e.version};
+    };
+    for (size_t i = 0; i < fwd_nodes.size(); ++i) {
+      fwd_copies[i] = Node::Create();
+      fwd_copies[i]->attrs = fwd_nodes[i]->attrs;
+      for (const auto& e : fwd_nodes[i]->inputs) {
+        fwd_copies[i]->inputs.push_back(copy_entry(e));
+      }
+      AGInfo::Create(fwd_copies[i]).ctx = AGInfo::Get(fwd_nodes[i]).ctx;
+    }
+    std::vector<NodeEntry> ograd_copies;
+    ograd_copies.reserve(ograd_entries.size());
+    for (const auto& e : ograd_entries) {
+      nnvm::ObjectPtr np = Node::Create();
+      np->attrs.name = e.node->attrs.name;
+      AGInfo::Create(np).ctx = AGInfo::Get(e.node).ctx;
+      ograd_copies.emplace_back(NodeEntry{np, 0, 0});
+    }
+    std::vector<NodeEntry> x_copies;
+    x_copies.reserve(xs.size());
+    for (const auto& e : xs) x_copies.push_back(copy_entry(e));
+
+    Graph& graph = bwd->graph;
+    for (const auto& e : sym.outputs) graph.outputs.push_back(copy_entry(e));
+    Graph g_graph = pass::MXGradient(
+        graph, graph.outputs, x_copies, ograd_copies,
+        mxnet::AggregateGradient, nullptr,
+        zero_ops, "_copy");
+    CHECK_EQ(g_graph.outputs.size(), xs.size());
+    for (const auto& e : g_graph.outputs) {
+      if (e.node->op() == nullptr) {
+        auto node = Node::Create();
+        node->attrs.op = copy_op;
+        node->inputs.push_back(e);
+        graph.outputs.emplace_back(std::move(node));
+      } else {
+        graph.outputs.push_back(e);
+      }
+    }
+    const auto& idx = graph.indexed_graph();
+    // get number of nodes used in forward pass
+    bwd->num_forward_nodes = 0;
+    bwd->num_forward_entries = 0;
+    for (size_t i = 0; i < num_forward_outputs; ++i) {
+      bwd->num_forward_nodes = std::max(
+          bwd->num_forward_nodes, static_cast<size_t>(idx.outputs()[i].node_id + 1));
+      bwd->num_forward_entries = std::max(
+          bwd->num_forward_entries, static_cast<size_t>(idx.entry_id(idx.outputs()[i])) + 1);
     }
+    CHECK_EQ(bwd->num_forward_nodes, fwd_nodes.size());
+    for (const auto& e : ograd_copies) {
+      bwd->ograd_eids.push_back(idx.exist(e.node.get()) ? idx.entry_id(e) : -1);
+    }
+    // Assign context
+    bwd->vctx = PlaceDevice(idx);
   }
+  Graph& graph = bwd->graph;
   const auto& idx = graph.indexed_graph();
-  // get number of nodes used in forward pass
-  size_t num_forward_nodes = 0;
-  size_t num_forward_entries = 0;
-  for (size_t i = 0; i < num_forward_outputs; ++i) {
-    num_forward_nodes = std::max(
-        num_forward_nodes, static_cast<size_t>(idx.outputs()[i].node_id + 1));
-    num_forward_entries = std::max(
-        num_forward_entries, static_cast<size_t>(idx.entry_id(idx.outputs()[i])) + 1);
-  }
+  const size_t num_forward_nodes = bwd->num_forward_nodes;
+  const size_t num_forward_entries = bwd->num_forward_entries;
+  const auto& vctx = bwd->vctx;
 
   // Allocate buffer
   std::vector<NDArray> buff(idx.num_node_entries());
@@ -491,29 +685,27 @@ std::vector<NDArray*> Imperative::Backward(
   }
   if (create_graph) {
     states.resize(num_forward_nodes);
-    nnvm::DFSVisit(sym.outputs, [&](const nnvm::ObjectPtr& n) {
+    for (size_t nid = 0; nid < num_forward_nodes; ++nid) {
+      const ObjectPtr& n = fwd_nodes[nid];
       AGInfo& info = AGInfo::Get(n);
-      states[idx.node_id(n.get())] = info.state;
+      states[nid] = info.state;
       for (uint32_t i = 0; i < info.outputs.size(); ++i) {
-        CHECK(idx.exist(n.get()));
-        size_t nid = idx.node_id(n.get());
         size_t eid = idx.entry_id(nid, i);
         buff[eid] = info.outputs[i];
         buff[eid].autograd_entry_ = NodeEntry{n, i, 0};
         ref_count[eid] = 1;
       }
-    });
-    for (auto& ograd_entry : ograd_entries) {
-      AGInfo& info = AGInfo::Get(ograd_entry.node);
-      if (!idx.exist(ograd_entry.node.get())) continue;
-      size_t eid = idx.entry_id(ograd_entry);
-      buff[eid] = info.outputs[0];
-      buff[eid].autograd_entry_ = ograd_entry;
+    }
+    for (size_t i = 0; i < ograd_entries.size(); ++i) {
+      if (bwd->ograd_eids[i] < 0) continue;
+      AGInfo& info = AGInfo::Get(ograd_entries[i].node);
+      buff[bwd->ograd_eids[i]] = info.outputs[0];
+      buff[bwd->ograd_eids[i]].autograd_entry_ = ograd_entries[i];
     }
   } else {
     states.reserve(num_forward_nodes);
     for (size_t i = 0; i < num_forward_nodes; ++i) {
-      const AGInfo& info = dmlc::get<AGInfo>(idx[i].source->info);
+      const AGInfo& info = AGInfo::Get(fwd_nodes[i]);
       states.emplace_back(info.state);
       for (size_t j = 0; j < info.outputs.size(); ++j) {
         size_t eid = idx.entry_id(i, j);
@@ -522,10 +714,10 @@ std::vector<NDArray*> Imperative::Backward(
         if (retain_graph || info.grad_req != kNullOp) ref_count[eid] = 1;
       }
     }
-    for (auto& ograd_entry : ograd_entries) {
-      if (!idx.exist(ograd_entry.node.get())) continue;
-      AGInfo& info = AGInfo::Get(ograd_entry.node);
-      arrays[idx.entry_id(ograd_entry)] = &info.outputs[0];
+    for (size_t i = 0; i < ograd_entries.size(); ++i) {
+      if (bwd->ograd_eids[i] < 0) continue;
+      AGInfo& info = AGInfo::Get(ograd_entries[i].node);
+      arrays[bwd->ograd_eids[i]] = &info.outputs[0];
     }
   }
   for (size_t i = num_forward_outputs; i < graph.outputs.size(); ++i) {
@@ -534,11 +726,8 @@ std::vector<NDArray*> Imperative::Backward(
     ref_count[eid] = 1;
   }
 
-  // Assign context
-  auto vctx = PlaceDevice(idx);
-
   // Infer shape type
-  {
+  if (!cache_hit) {
     std::pair<uint32_t, uint32_t> node_range, entry_range;
     node_range = {num_forward_nodes, idx.num_nodes()};
     entry_range = {num_forward_entries, idx.num_node_entries()};
@@ -564,6 +753,12 @@ std::vector<NDArray*> Imperative::Backward(
     for (const auto& i : vctx) dev_mask.emplace_back(i.dev_mask());
     CheckAndInferStorageType(&graph, std::move(dev_mask), std::move(stypes), false,
                              node_range, entry_range);
+
+    // the graphs whose backward has unknown shapes are inferred again by every backward
+    if (!signature.empty() && !contain_unknown) {
+      if (cache->size() >= cache_capacity) cache->clear();
+      cache->emplace(signature, bwd);
+    }
   }
 
   // Calculate ref count
@@ -598,7 +793,7 @@ std::vector<NDArray*> Imperative::Backward(
     }
   }
 
-  if (dmlc::GetEnv("MXNET_MEM_PLAN_VERBOSE_LOGGING", false)) {
+  if (!cache_hit && dmlc::GetEnv("MXNET_MEM_PLAN_VERBOSE_LOGGING", false)) {
     common::LogMemoryPlan(graph);
   }
 
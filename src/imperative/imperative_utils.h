@@ -22,14 +22,19 @@
 #include <utility>
 #include <algorithm>
 #include <vector>
+#include <limits>
 #include <map>
+#include <sstream>
 #include <string>
+#include <unordered_map>
 #include "./exec_pass.h"
+#include "./cuda_graphs.h"
 #include "../c_api/c_api_common.h"
 #include "../common/utils.h"
 #include "../common/exec_utils.h"
 #include "../operator/nn/mkldnn/mkldnn_base-inl.h"
 #include "../operator/operator_common.h"
+#include "../profiler/profiler.h"
 
 #ifndef MXNET_IMPERATIVE_IMPERATIVE_UTILS_H_
 #define MXNET_IMPERATIVE_IMPERATIVE_UTILS_H_
@@ -108,6 +113,15 @@ struct MemoryPlanInfo {
   uint32_t root;
   size_t size;
   bool inplace;
+  /*! \brief offset in bytes of a root entry in the arena, -1 if it has its own allocation */
+  int64_t offset;
+  /*!
+   * \brief offset in bytes of the entry in the storage of its root, when it is a slice of
+   *  a concat output or split input placed by DetectConcatAlias, -1 otherwise
+   */
+  int64_t view_offset;
+  /*! \brief whether the node writing the entry finds it in place, its req is then kNullOp */
+  bool in_place;
 };
 
 struct EngineOprDeleter {
@@ -160,17 +174,18 @@ inline Context GetContext(const nnvm::NodeAttrs& attrs,
   return ctx;
 }
 
-/*! \brief Set the shape, dtype, storage type and dispatch mode via the
+/*! \brief Infer the shape, dtype, storage type and dispatch mode via the
  * attribute inference functions
  *
  * Inferred information is stored in MXAPIThreadLocalEntry. Existing information
  * is overwritten.
+ * \return whether the output shapes are dynamic, known after the operator runs
  */
-inline void SetShapeType(const Context& ctx,
-                         const nnvm::NodeAttrs& attrs,
-                         const std::vector<NDArray*>& inputs,
-                         const std::vector<NDArray*>& outputs,
-                         DispatchMode* dispatch_mode) {
+inline bool InferShapeType(const Context& ctx,
+                           const nnvm::NodeAttrs& attrs,
+                           const std::vector<NDArray*>& inputs,
+                           const std::vector<NDArray*>& outputs,
+                           DispatchMode* dispatch_mode) {
   static auto& infershape = nnvm::Op::GetAttr<mxnet::FInferShape>("FInferShape");
   static auto& infertype = nnvm::Op::GetAttr<nnvm::FInferType>("FInferType");
   static auto& inferstorage = nnvm::Op::GetAttr<FInferStorageType>("FInferStorageType");
@@ -277,6 +292,20 @@ inline void SetShapeType(const Context& ctx,
 
   CHECK_EQ(out_storage_types.size(), outputs.size());
   CHECK(*dispatch_mode != DispatchMode::kUndefined);
+  return is_dynamic_shape_existing;
+}
+
+/*! \brief Initialize the outputs to the shapes, dtypes and storage types inferred by
+ * InferShapeType, or check the ones they have
+ */
+inline void SetOutputShapeType(const Context& ctx,
+                               const nnvm::NodeAttrs& attrs,
+                               const std::vector<NDArray*>& outputs,
+                               const bool is_dynamic_shape_existing) {
+  MXAPIThreadLocalEntry<> *ret = MXAPIThreadLocalStore<>::Get();
+  const mxnet::ShapeVector& out_shapes = ret->out_shapes;
+  const std::vector<int>& out_types = ret->out_types;
+  const auto& out_storage_types = ret->out_storage_types;
   for (size_t i = 0; i < outputs.size(); ++i) {
     if (outputs[i]->is_none() || (mxnet::op::shape_is_none(outputs[i]->shape()) &&
                                    Imperative::DCInfo::IsNone(*outputs[i]))) {
@@ -311,6 +340,192 @@ inline void SetShapeType(const Context& ctx,
   }
 }
 
+/*! \brief Set the shape, dtype, storage type and dispatch mode via the
+ * attribute inference functions
+ *
+ * Inferred information is stored in MXAPIThreadLocalEntry. Existing information
+ * is overwritten.
+ */
+inline void SetShapeType(const Context& ctx,
+                         const nnvm::NodeAttrs& attrs,
+                         const std::vector<NDArray*>& inputs,
+                         const std::vector<NDArray*>& outputs,
+                         DispatchMode* dispatch_mode) {
+  const bool is_dynamic = InferShapeType(ctx, attrs, inputs, outputs, dispatch_mode);
+  SetOutputShapeType(ctx, attrs, outputs, is_dynamic);
+}
+
+/*!
+ * \brief The results of InferShapeType for one operator call, reused by the calls of the
+ * same operator with the same attributes on arrays of the same shapes, dtypes and storage
+ * types, which are looked up by the hash of all of them.
+ */
+class InferShapeTypeCache {
+ public:
+  /*! \brief the cache of the calling thread */
+  static InferShapeTypeCache* Get() {
+    static thread_local InferShapeTypeCache cache;
+    return &cache;
+  }
+
+  /*! \brief the maximum number of cached calls per thread, 0 disables the cache */
+  static size_t Capacity() {
+    static const size_t capacity = dmlc::GetEnv("MXNET_IMPERATIVE_INFER_CACHE_SIZE",
+                                                static_cast<size_t>(4096));
+    return capacity;
+  }
+
+  /*!
+   * \brief Fill MXAPIThreadLocalEntry and dispatch_mode with the results of InferShapeType
+   * for this call, inferred or cached.
+   * \return whether the output shapes are dynamic
+   */
+  bool Infer(const Context& ctx, const nnvm::NodeAttrs& attrs,
+             const std::vector<NDArray*>& inputs, const std::vector<NDArray*>& outputs,
+             DispatchMode* dispatch_mode) {
+    static auto& infershape = nnvm::Op::GetAttr<mxnet::FInferShape>("FInferShape");
+    // the subgraphs of an operator are not part of its attributes
+    bool cacheable = Capacity() > 0 && infershape.count(attrs.op) && attrs.subgraphs.empty();
+    // the key is the attribute dict, which the numpy FFI only fills when recording, its
+    // calls with a parsed parameter and no dict would all share one entry
+    cacheable = cacheable && !(attrs.dict.empty() && !attrs.parsed.empty());
+    for (const NDArray* input : inputs) {
+      // calls with inputs of unknown shapes and with sparse inputs are not cached, so that
+      // the key needs no input storage types
+      cacheable = cacheable && shape_is_known(input->shape()) &&
+                  input->storage_type() == kDefaultStorage;
+    }
+    if (!cacheable) {
+      return InferShapeType(ctx, attrs, inputs, outputs, dispatch_mode);
+    }
+    const size_t hash = Hash(ctx, attrs, inputs, outputs);
+    auto range = entries_.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+      if (it->second.Matches(ctx, attrs, inputs, outputs)) {
+        it->second.Restore(dispatch_mode);
+        return false;
+      }
+    }
+    Entry entry(ctx, attrs, inputs, outputs);
+    if (InferShapeType(ctx, attrs, inputs, outputs, dispatch_mode)) return true;
+    entry.Store(*dispatch_mode);
+    if (entries_.size() >= Capacity()) entries_.clear();
+    entries_.emplace(hash, std::move(entry));
+    return false;
+  }
+
+ private:
+  struct Entry {
+    const nnvm::Op* op;
+    std::unordered_map<std::string, std::string> dict;
+    int dev_mask;
+    int np_shape;
+    bool np_default_dtype;
+    mxnet::ShapeVector in_shapes, out_shapes;
+    std::vector<int> in_types, out_types, out_stypes;
+    // the inferred attributes
+    mxnet::ShapeVector arg_shapes, res_shapes;
+    std::vector<int> arg_types, res_types, arg_stypes, res_stypes;
+    DispatchMode dispatch_mode;
+
+    Entry(const Context& ctx, const nnvm::NodeAttrs& attrs,
+          const std::vector<NDArray*>& inputs, const std::vector<NDArray*>& outputs)
+        : op(attrs.op), dict(attrs.dict), dev_mask(ctx.dev_mask()),
+          np_shape(Imperative::Get()->is_np_shape()),
+          np_default_dtype(Imperative::Get()->is_np_default_dtype()) {
+      for (const NDArray* input : inputs) {
+        in_shapes.push_back(input->shape());
+        in_types.push_back(input->dtype());
+      }
+      for (const NDArray* output : outputs) {
+        out_shapes.push_back(output->shape());
+        out_types.push_back(output->dtype());
+        out_stypes.push_back(output->storage_type());
+      }
+    }
+
+    bool Matches(const Context& ctx, const nnvm::NodeAttrs& attrs,
+                 const std::vector<NDArray*>& inputs,
+                 const std::vector<NDArray*>& outputs) const {
+      if (op != attrs.op || dev_mask != ctx.dev_mask() ||
+          np_shape != Imperative::Get()->is_np_shape() ||
+          np_default_dtype != Imperative::Get()->is_np_default_dtype() ||
+          in_shapes.size() != inputs.size() || out_shapes.size() != outputs.size()) {
+        return false;
+      }
+      for (size_t i = 0; i < inputs.size(); ++i) {
+        if (in_shapes[i] != inputs[i]->shape() || in_types[i] != inputs[i]->dtype()) {
+          return false;
+        }
+      }
+      for (size_t i = 0; i < outputs.size(); ++i) {
+        if (out_shapes[i] != outputs[i]->shape() || out_types[i] != outputs[i]->dtype() ||
+            out_stypes[i] != outputs[i]->storage_type()) {
+          return false;
+        }
+      }
+      return dict == attrs.dict;
+    }
+
+    void Store(DispatchMode mode) {
+      MXAPIThreadLocalEntry<>* ret = MXAPIThreadLocalStore<>::Get();
+      arg_shapes = ret->arg_shapes;
+      res_shapes = ret->out_shapes;
+      arg_types = ret->arg_types;
+      res_types = ret->out_types;
+      arg_stypes = ret->arg_storage_types;
+      res_stypes = ret->out_storage_types;
+      dispatch_mode = mode;
+    }
+
+    void Restore(DispatchMode* mode) const {
+      MXAPIThreadLocalEntry<>* ret = MXAPIThreadLocalStore<>::Get();
+      ret->arg_shapes = arg_shapes;
+      ret->out_shapes = res_shapes;
+      ret->arg_types = arg_types;
+      ret->out_types = res_types;
+      ret->arg_storage_types = arg_stypes;
+      ret->out_storage_types = res_stypes;
+      *mode = dispatch_mode;
+    }
+  };
+
+  static size_t Hash(const Context& ctx, const nnvm::NodeAttrs& attrs,
+                     const std::vector<NDArray*>& inputs,
+                     const std::vector<NDArray*>& outputs) {
+    size_t ret = std::hash<const void*>()(attrs.op);
+    ret = dmlc::HashCombine(ret, ctx.dev_mask());
+    // independent of the iteration order of the attributes
+    size_t dict_hash = 0;
+    for (const auto& kv : attrs.dict) {
+      dict_hash += dmlc::HashCombine(std::hash<std::string>()(kv.first), kv.second);
+    }
+    ret = dmlc::HashCombine(ret, dict_hash);
+    for (const NDArray* input : inputs) {
+      ret = dmlc::HashCombine(ret, input->dtype());
+      for (const dim_t dim : input->shape()) ret = dmlc::HashCombine(ret, dim);
+    }
+    for (const NDArray* output : outputs) {
+      ret = dmlc::HashCombine(ret, output->dtype());
+      ret = dmlc::HashCombine(ret, output->shape().ndim());
+    }
+    return ret;
+  }
+
+  std::unordered_multimap<size_t, Entry> entries_;
+};
+
+/*! \brief SetShapeType through the InferShapeTypeCache of the calling thread */
+inline void SetShapeTypeCached(const Context& ctx,
+                               const nnvm::NodeAttrs& attrs,
+                               const std::vector<NDArray*>& inputs,
+                               const std::vector<NDArray*>& outputs,
+                               DispatchMode* dispatch_mode) {
+  const bool is_dynamic =
+      InferShapeTypeCache::Get()->Infer(ctx, attrs, inputs, outputs, dispatch_mode);
+  SetOutputShapeType(ctx, attrs, outputs, is_dynamic);
+}
+
 /*! \brief Set read and write vars, resource requests and mutate_idx
  *
  * For inputs and outputs arguments only NDArray::var() is accessed.
@@ -507,7 +722,6 @@ inline void DerefInputOutputRelease(const std::vector<NDArray *>& inputs,
   for (auto i : outputs) delete i;
 }
 
-
 /*
  * \brief setup default-storage tblobs from source NDArrays. If any source NDArray has non-default
  *        storage, it creates a temp NDArray with default storage and uses the temp tblob. The
@@ -633,6 +847,45 @@ inline void SetupDefaultBlobsInOut(const std::vector<NDArray *> &ndinputs,
       DerefInputOutput(in, out, &newIn, &newOut);             \
       DerefInputOutputRelease(in, out)
 
+/*!
+ * \brief Record the FLOPs and bytes of an operator in the aggregate profiler stats,
+ *  if it registers FComputeCost and has dense inputs and outputs, and the elements of its
+ *  outputs when the hardware counters count the operators
+ */
+inline void RecordOpCost(const nnvm::NodeAttrs& attrs,
+                         const std::vector<NDArray*>& inputs,
+                         const std::vector<NDArray*>& outputs) {
+  static auto& fcost = nnvm::Op::GetAttr<FComputeCost>("FComputeCost");
+  // the elements of the outputs give the hardware counters of the operator per element
+  const bool counted = profiler::perf::Running();
+  if (!counted && !fcost.count(attrs.op)) return;
+  profiler::Profiler *profiler = profiler::Profiler::Get();
+  if (!profiler->AggregateRunning() || !profiler->IsProfiling(profiler::Profiler::kImperative)) {
+    return;
+  }
+  std::shared_ptr<profiler::AggregateStats> stats = profiler->GetAggregateStats();
+  if (!stats) return;
+  if (counted) {
+    double elements = 0;
+    for (const NDArray* arr : outputs) elements += static_cast<double>(arr->shape().Size());
+    stats->OnOperatorElements(attrs.op->name, elements);
+    if (!fcost.count(attrs.op)) return;
+  }
+  mxnet::ShapeVector in_shapes, out_shapes;
+  double bytes = 0;
+  for (const NDArray* arr : inputs) {
+    if (arr->storage_type() != kDefaultStorage) return;
+    in_shapes.push_back(arr->shape());
+    bytes += static_cast<double>(arr->shape().Size()) * mshadow::mshadow_sizeof(arr->dtype());
+  }
+  for (const NDArray* arr : outputs) {
+    if (arr->storage_type() != kDefaultStorage) return;
+    out_shapes.push_back(arr->shape());
+    bytes += static_cast<double>(arr->shape().Size()) * mshadow::mshadow_sizeof(arr->dtype());
+  }
+  stats->OnOperatorCost(attrs.op->name, fcost[attrs.op](attrs, in_shapes, out_shapes), bytes);
+}
+
 inline void PushFCompute(const FCompute& fn,
                   const nnvm::Op* op,
                   const nnvm::NodeAttrs& attrs,
@@ -668,12 +921,15 @@ inline void PushFCompute(const FCompute& fn,
     // setup context
     OpContext opctx{need_grad, is_train, rctx, engine::CallbackOnComplete(), requested};
     bool is_gpu = ctx.dev_mask() == gpu::kDevMask;
+    if (is_gpu) common::PrefetchManaged(inputs, outputs, rctx);
     // pre-fcompute fallback, cast to default storage type
     CastNonDefaultStorage(pre_temp_src, pre_temp_dst, opctx, is_gpu);
     fn(attrs, opctx, input_blobs, tmp_req, output_blobs);
     // post-fcompute fallback, cast to original storage type
     CastNonDefaultStorage(post_temp_src, post_temp_dst, opctx, is_gpu);
-    if (is_gpu && !rctx.is_bulk) {
+    // the storage fallback arrays are freed on return, so their users must be done
+    const bool has_temp = !pre_temp_dst.empty() || !post_temp_dst.empty();
+    if (is_gpu && !rctx.is_bulk && (!rctx.event_sync || has_temp)) {
       rctx.get_stream<gpu>()->Wait();
     }
     DerefInputOutputRelease(inputs, outputs);
@@ -711,8 +967,10 @@ inline void PushFComputeEx(const FComputeEx& fn,
       REDEFINE_INPUTS_OUTPUTS(inputs, outputs, inputsA, outputsA);
       INVALIDATE_OUTPUTS_COND(!cross_device_copy, outputsA, req);
       CREATE_DEFAULT_INPUTS(!cross_device_copy, attrs, CreateDefaultInputs(&inputsA));
+      if (ctx.dev_mask() == gpu::kDevMask) common::PrefetchManaged(inputsA, outputsA, rctx);
       fn(attrs, opctx, inputsA, req, outputsA);
-      if (ctx.dev_mask() == gpu::kDevMask && exec_type == ExecType::kSync && !rctx.is_bulk) {
+      if (ctx.dev_mask() == gpu::kDevMask && exec_type == ExecType::kSync && !rctx.is_bulk &&
+          !rctx.event_sync) {
         rctx.get_stream<gpu>()->Wait();
       }
     };
@@ -755,9 +1013,10 @@ inline void PushOperator(const OpStatePtr& state,
       INVALIDATE_OUTPUTS_COND(exec_type != ExecType::kCrossDeviceCopy, outputsA, req);
       CREATE_DEFAULT_INPUTS(exec_type != ExecType::kCrossDeviceCopy, attrs,
                             CreateDefaultInputs(&inputsA));
+      if (ctx.dev_mask() == gpu::kDevMask) common::PrefetchManaged(inputsA, outputsA, rctx);
       fcompute_ex(state, opctx, inputsA, req, outputsA);
       if (ctx.dev_mask() == gpu::kDevMask && exec_type == ExecType::kSync
-          && rctx.get_stream<gpu>() && !rctx.is_bulk) {
+          && rctx.get_stream<gpu>() && !rctx.is_bulk && !rctx.event_sync) {
         rctx.get_stream<gpu>()->Wait();
       }
     };
@@ -801,13 +1060,15 @@ inline void PushOperator(const OpStatePtr& state,
                                &post_temp_src, &post_temp_dst, &in_temp_idx_map, mutate_idx);
         // setup contexts
         const bool is_gpu = rctx.get_ctx().dev_mask() == gpu::kDevMask;
+        if (is_gpu) common::PrefetchManaged(inputs, outputs, rctx);
         // pre-fcompute fallback
         CastNonDefaultStorage(pre_temp_src, pre_temp_dst, opctx, is_gpu);
         fcompute(state, opctx, input_blobs, tmp_req, output_blobs);
         // post-fcompute fallback, cast to original storage type, if necessary
         CastNonDefaultStorage(post_temp_src, post_temp_dst, opctx, is_gpu);
+        const bool has_temp = !pre_temp_dst.empty() || !post_temp_dst.empty();
         if (is_gpu && exec_type == ExecType::kSync
-            && rctx.get_stream<gpu>() && !rctx.is_bulk) {
+            && rctx.get_stream<gpu>() && !rctx.is_bulk && (!rctx.event_sync || has_temp)) {
           rctx.get_stream<gpu>()->Wait();
         }
         DerefInputOutputRelease(inputs, outputs);
@@ -1027,6 +1288,116 @@ inline std::vector<Context> PlaceDevice(const nnvm::IndexedGraph& idx) {
 }
 
 
+/*!
+ * \brief Assign to every storage of a memory plan an offset in a single arena.
+ *
+ *  The storages found by MXPlanMemory are kept, each one lives from the first node
+ *  writing one of its entries to the last node reading one. Storages are placed from
+ *  the largest to the smallest, each at the lowest offset where it does not overlap
+ *  the storages already placed whose lifetime intersects its own. Entries still
+ *  referenced after node_end, e.g. forward entries read by backward, live until the end.
+ * \return size in bytes of the arena.
+ */
+inline size_t PackMemoryPlan(const nnvm::IndexedGraph& idx,
+                             const std::vector<uint32_t>& ref_count,
+                             uint32_t node_start, uint32_t node_end,
+                             uint32_t entry_start, uint32_t entry_end,
+                             MemoryPlanVector* mem_plan) {
+  // offsets are aligned like the allocations of the storage pools
+  constexpr size_t kAlignment = 256;
+  struct Block {
+    uint32_t root;
+    size_t size;
+    uint32_t first;
+    uint32_t last;
+  };
+  std::unordered_map<uint32_t, Block> blocks;
+  std::vector<uint32_t> uses(idx.num_node_entries(), 0);
+  auto touch = [&](uint32_t eid, uint32_t nid) {
+    if (eid < entry_start || eid >= entry_end) return;
+    const MemoryPlanInfo& plan = (*mem_plan)[eid];
+    if (plan.storage_id < 0) return;
+    auto it = blocks.find(plan.root);
+    if (it == blocks.end()) {
+      const size_t size = ((*mem_plan)[plan.root].size + kAlignment - 1) / kAlignment * kAlignment;
+      blocks.emplace(plan.root, Block{plan.root, size, nid, nid});
+    } else {
+      it->second.first = std::min(it->second.first, nid);
+      it->second.last = std::max(it->second.last, nid);
+    }
+  };
+  for (uint32_t nid = node_start; nid < node_end; ++nid) {
+    for (const auto& e : idx[nid].inputs) {
+      const uint32_t eid = idx.entry_id(e);
+      ++uses[eid];
+      touch(eid, nid);
+    }
+    for (uint32_t i = 0; i < idx[nid].source->num_outputs(); ++i) {
+      touch(idx.entry_id(nid, i), nid);
+    }
+  }
+  for (uint32_t eid = entry_start; eid < entry_end; ++eid) {
+    const MemoryPlanInfo& plan = (*mem_plan)[eid];
+    if (plan.storage_id < 0 || ref_count[eid] <= uses[eid]) continue;
+    auto it = blocks.find(plan.root);
+    if (it != blocks.end()) it->second.last = node_end;
+  }
+
+  std::vector<Block> order;
+  order.reserve(blocks.size());
+  for (const auto& kv : blocks) order.push_back(kv.second);
+  std::sort(order.begin(), order.end(), [](const Block& a, const Block& b) {
+    return a.size != b.size ? a.size > b.size : a.root < b.root;
+  });
+  // placed blocks as (offset, block), in placement order
+  std::vector<std::pair<size_t, const Block*> > placed;
+  size_t arena_size = 0;
+  for (const Block& block : order) {
+    std::vector<std::pair<size_t, size_t> > busy;
+    for (const auto& p : placed) {
+      if (p.second->first <= block.last && block.first <= p.second->last) {
+        busy.emplace_back(p.first, p.first + p.second->size);
+      }
+    }
+    std::sort(busy.begin(), busy.end());
+    // best fit: the smallest gap between live blocks that holds this one
+    size_t offset = 0, best = 0, best_gap = std::numeric_limits<size_t>::max();
+    bool found = false;
+    for (const auto& range : busy) {
+      if (range.first >= offset + block.size && range.first - offset < best_gap) {
+        best = offset;
+        best_gap = range.first - offset;
+        found = true;
+      }
+      offset = std::max(offset, range.second);
+    }
+    if (!found) best = offset;
+    placed.emplace_back(best, &block);
+    (*mem_plan)[block.root].offset = static_cast<int64_t>(best);
+    arena_size = std::max(arena_size, best + block.size);
+  }
+  return arena_size;
+}
+
+/*!
+ * \brief The graph passes named by MXNET_PLAN_MEMORY_PASSES, comma separated.
+ *
+ *  They run in order on every graph planned by MXPlanMemory, before the inplace addto
+ *  detection, and may change the storage ids and inplace indices of the planned entries.
+ */
+inline const std::vector<std::string>& PlanMemoryPasses() {
+  static const std::vector<std::string> passes = [] {
+    std::vector<std::string> ret;
+    std::istringstream is(dmlc::GetEnv("MXNET_PLAN_MEMORY_PASSES", std::string()));
+    std::string name;
+    while (std::getline(is, name, ',')) {
+      if (!name.empty()) ret.push_back(name);
+    }
+    return ret;
+  }();
+  return passes;
+}
+
 inline MemoryPlanVector MXPlanMemory(
     nnvm::Graph* p_g,
     nnvm::StorageVector&& storage,
@@ -1034,7 +1405,9 @@ inline MemoryPlanVector MXPlanMemory(
     const std::string& storage_plan,
     const std::pair<uint32_t, uint32_t>& node_range = {0, 0},
     const std::pair<uint32_t, uint32_t>& entry_range = {0, 0},
-    bool detect_inplace_addto = false) {
+    bool detect_inplace_addto = false,
+    bool pack_arena = false,
+    bool alias_concat = false) {
   using namespace nnvm;
   nnvm::Graph& g = *p_g;
   const auto& idx = g.indexed_graph();
@@ -1044,7 +1417,17 @@ inline MemoryPlanVector MXPlanMemory(
   g.attrs["ref_count"] = std::make_shared<dmlc::any>(ref_count);
   g.attrs["storage"] = std::make_shared<dmlc::any>(std::move(storage));
   g = nnvm::ApplyPass(g, "MXPlanMemory");
+  for (const std::string& pass : PlanMemoryPasses()) {
+    CHECK(dmlc::Registry<nnvm::PassFunctionReg>::Find(pass) != nullptr)
+        << "MXNET_PLAN_MEMORY_PASSES names the graph pass " << pass
+        << ", which no loaded library registers";
+    g = nnvm::ApplyPass(g, pass);
+  }
   if (detect_inplace_addto) g = exec::DetectInplaceAddTo(g);
+  if (alias_concat) {
+    g.attrs["ref_count"] = std::make_shared<dmlc::any>(ref_count);
+    g = exec::DetectConcatAlias(g);
+  }
 
   const auto& dtypes = g.GetAttr<DTypeVector>("dtype");
   const auto& shapes = g.GetAttr<mxnet::ShapeVector>("shape");
@@ -1056,28 +1439,75 @@ inline MemoryPlanVector MXPlanMemory(
       entry_range.second > entry_start ? entry_range.second : idx.num_node_entries();
   MemoryPlanVector mem_plan(idx.num_node_entries());
   std::unordered_map<int, uint32_t> sid_to_root;
+  std::vector<int64_t> view_offsets;
+  if (alias_concat) view_offsets = g.GetAttr<std::vector<int64_t> >("alias_offset");
 
   for (uint32_t i = entry_start; i < entry_end; ++i) {
+    const int64_t view_offset = view_offsets.empty() ? -1 : view_offsets[i];
+    // end in bytes of the entry in its storage
+    const size_t end = std::max<int64_t>(view_offset, 0) +
+                       mshadow::mshadow_sizeof(dtypes[i]) * shapes[i].Size();
     if (storage_ids[i] < 0) {
-      mem_plan[i] = {storage_ids[i], i, 0, false};
+      mem_plan[i] = {storage_ids[i], i, 0, false, -1, -1, false};
     } else if (!sid_to_root.count(storage_ids[i])) {
       CHECK_LT(storage_inplace[i], 0);
       sid_to_root[storage_ids[i]] = i;
-      mem_plan[i] = {storage_ids[i], i,
-                     mshadow::mshadow_sizeof(dtypes[i]) * shapes[i].Size(),
-                     false};
+      mem_plan[i] = {storage_ids[i], i, end, false, -1, view_offset, false};
     } else {
       uint32_t root = sid_to_root[storage_ids[i]];
-      mem_plan[i] = {storage_ids[i], root, 0, storage_inplace[i] >= 0};
-      mem_plan[root].size = std::max(mem_plan[root].size,
-          mshadow::mshadow_sizeof(dtypes[i]) * shapes[i].Size());
+      mem_plan[i] = {storage_ids[i], root, 0, storage_inplace[i] >= 0, -1, view_offset, false};
+      mem_plan[root].size = std::max(mem_plan[root].size, end);
+    }
+  }
+  if (alias_concat) {
+    const auto& alias_node = g.GetAttr<std::vector<int> >("alias_node");
+    for (uint32_t nid = 0; nid < idx.num_nodes(); ++nid) {
+      if (!alias_node[nid]) continue;
+      for (uint32_t i = 0; i < idx[nid].source->num_outputs(); ++i) {
+        const uint32_t eid = idx.entry_id(nid, i);
+        if (eid >= entry_start && eid < entry_end) mem_plan[eid].in_place = true;
+      }
     }
   }
 
+  if (pack_arena) {
+    const uint32_t node_start = node_range.second > node_range.first ? node_range.first : 0;
+    const uint32_t node_end =
+        node_range.second > node_range.first ? node_range.second : idx.num_nodes();
+    PackMemoryPlan(idx, ref_count, node_start, node_end, entry_start, entry_end, &mem_plan);
+  }
   return mem_plan;
 }
 
 
+/*!
+ * \brief Reserve the storage of a row_sparse or csr array for `capacity` stored rows or
+ *        non-zeros. The array stays empty, and the operators writing it only reallocate
+ *        its storage when they store more than the reserved capacity.
+ */
+inline void ReserveSparseStorage(const NDArray& arr, dim_t capacity) {
+  const mxnet::TShape& shape = arr.shape();
+  if (capacity <= 0 || !shape_is_known(shape) || shape.ndim() < 1) return;
+  mxnet::TShape storage_shape = shape;
+  if (arr.storage_type() == kRowSparseStorage) {
+    capacity = std::min<dim_t>(capacity, shape[0]);
+    storage_shape[0] = capacity;
+    arr.CheckAndAllocAuxData(rowsparse::kIdx, mxnet::TShape(1, capacity));
+  } else if (arr.storage_type() == kCSRStorage && shape.ndim() == 2) {
+    capacity = std::min<dim_t>(capacity, shape.Size());
+    storage_shape = mxnet::TShape(1, capacity);
+    arr.CheckAndAllocAuxData(csr::kIndPtr, mxnet::TShape(1, shape[0] + 1));
+    arr.CheckAndAllocAuxData(csr::kIdx, mxnet::TShape(1, capacity));
+  } else {
+    return;
+  }
+  arr.CheckAndAllocData(storage_shape);
+  // emptying the aux shapes, and with them the storage shape, keeps the allocated handles
+  for (size_t i = 0; i < num_aux_data(arr.storage_type()); ++i) {
+    arr.set_aux_shape(i, mxnet::TShape(1, 0));
+  }
+}
+
 inline std::multimap<size_t, NDArray> AllocateMemory(
     const nnvm::Graph& g,
     const nnvm::IndexedGraph& idx,
@@ -1108,38 +1538,67 @@ inline std::multimap<size_t, NDArray> AllocateMemory(
     }
   }
 
-  const NDArray *pntr;
+  // storages packed by PackMemoryPlan are carved out of a single arena
+  size_t arena_size = 0;
+  for (uint32_t i = entry_start; i < entry_end; ++i) {
+    const auto &plan = mem_plan[i];
+    if (plan.storage_id >= 0 && plan.root == i && plan.offset >= 0) {
+      arena_size = std::max(arena_size, static_cast<size_t>(plan.offset) + plan.size);
+    }
+  }
+  NDArray arena;
+  if (arena_size > 0) {
+    auto iter = pool.lower_bound(arena_size);
+    if (iter != pool.end()) {
+      arena = new_pool.insert(*iter)->second;
+      pool.erase(iter);
+    } else {
+      arena = NDArray(mxnet::TShape({static_cast<nnvm::dim_t>(arena_size)}),
+                      default_ctx, true, mshadow::kUint8);
+      arena.AssignStorageInfo(data_entry_profiler_scopes[0], "memory_arena");
+      new_pool.insert({arena_size, arena});
+    }
+  }
+
+  // buffers of the roots not packed in the arena
+  std::unordered_map<uint32_t, const NDArray*> buffers;
   for (uint32_t i = entry_start; i < entry_end; ++i) {
     const auto &plan = mem_plan[i];
     if (plan.storage_id == exec::kExternalStorageID) continue;
-    CHECK(arrays[i]->is_none());
     if (plan.storage_id == exec::kDynamicStorageID) {
+      // sparse arrays kept by the caller keep their storage, see ReserveSparseStorage
+      if (!arrays[i]->is_none()) continue;
       *arrays[i] = NDArray(static_cast<NDArrayStorageType>(stypes[i]),
                            shapes[i], default_ctx, true, dtypes[i]);
       arrays[i]->AssignStorageInfo(data_entry_profiler_scopes[i - entry_start],
                                    data_entry_names[i - entry_start]);
       continue;
     }
+    CHECK(arrays[i]->is_none());
     CHECK_EQ(stypes[i], kDefaultStorage);
-    if (plan.root == i) {
+    const auto &root_plan = mem_plan[plan.root];
+    if (plan.root == i && plan.offset < 0) {
       auto iter = pool.lower_bound(plan.size);
       if (iter != pool.end()) {
-        pntr = &new_pool.insert(*iter)->second;
+        buffers[i] = &new_pool.insert(*iter)->second;
         pool.erase(iter);
       } else {
         NDArray buff(mxnet::TShape({static_cast<nnvm::dim_t>(plan.size)}),
                      default_ctx, true, mshadow::kUint8);
         buff.AssignStorageInfo(data_entry_profiler_scopes[i - entry_start],
                                data_entry_names[i - entry_start]);
-        pntr = &new_pool.insert({plan.size, buff})->second;
+        buffers[i] = &new_pool.insert({plan.size, buff})->second;
       }
-    } else {
-      CHECK_GE(mem_plan[plan.root].storage_id, 0);
-      pntr = arrays[plan.root];
+    } else if (plan.root != i) {
+      CHECK_GE(root_plan.storage_id, 0);
       if (plan.inplace && array_reqs->at(i) == kWriteTo)
         array_reqs->at(i) = kWriteInplace;
     }
-    arrays[i]->InitAsArray(*pntr, shapes[i], dtypes[i]);
+    if (plan.in_place) array_reqs->at(i) = kNullOp;
+    const NDArray& buffer = root_plan.offset >= 0 ? arena : *buffers.at(plan.root);
+    const size_t offset = std::max<int64_t>(root_plan.offset, 0) +
+                          std::max<int64_t>(plan.view_offset, 0);
+    arrays[i]->InitAsArrayAt(buffer, offset, shapes[i], dtypes[i]);
   }
 
   return new_pool;
@@ -1172,7 +1631,8 @@ inline void SetupOpExec(
 inline Engine::OprHandle CreateEngineOp(
     const Context& default_ctx,
     const std::vector<std::shared_ptr<exec::OpExecutor> >& execs,
-    const char* opr_names) {
+    const char* opr_names,
+    bool use_cuda_graphs = false) {
   CHECK_GT(execs.size(), 0);
   std::vector<Engine::VarHandle> use_vars, mutate_vars;
 
@@ -1200,15 +1660,24 @@ inline Engine::OprHandle CreateEngineOp(
   bool is_gpu = default_ctx.dev_mask() == gpu::kDevMask;
   bool is_async = execs.size() > 1 ? false : execs[0]->exec_type() == ExecType::kAsync;
 
-  auto exec_fun = [execs, is_async, is_gpu] (
+  std::shared_ptr<CudaGraphsExec> cuda_graphs;
+  if (use_cuda_graphs && is_gpu && !is_async) {
+    cuda_graphs = std::make_shared<CudaGraphsExec>(execs, opr_names);
+  }
+
+  auto exec_fun = [execs, is_async, is_gpu, cuda_graphs] (
       RunContext ctx, Engine::CallbackOnComplete on_complete) {
     if (is_async) {
       execs[0]->op_ctx.async_on_complete = on_complete;
     }
-    for (const auto& exec : execs) exec->Run(ctx, is_gpu);
+    if (cuda_graphs) {
+      cuda_graphs->Run(ctx);
+    } else {
+      for (const auto& exec : execs) exec->Run(ctx, is_gpu);
+    }
     // call on complete only if it is async op
     if (!is_async) {
-      if (is_gpu) {
+      if (is_gpu && !ctx.event_sync) {
       #if MXNET_USE_CUDA
         // Wait GPU kernel to finish.
         ctx.get_stream<gpu>()->Wait();
@@ -1232,10 +1701,15 @@ inline void CreateEngineOpSeg(
     const size_t bulk_size,
     const std::vector<std::shared_ptr<exec::OpExecutor> >& execs,
     const std::vector<int> skip_plus_node,
-    std::vector<EngineOprSeg> *opr_segs) {
+    std::vector<EngineOprSeg> *opr_segs,
+    bool use_cuda_graphs = false,
+    bool split_branches = false) {
   size_t seg_start = start_nid;
   std::vector<std::shared_ptr<exec::OpExecutor> > seg_execs;
   std::string opr_names;
+  // whether all the nodes of the current segment can be captured into a CUDA graph
+  bool seg_capturable = true;
+  const bool is_train = Imperative::Get()->is_training();
   for (size_t nid = start_nid; nid < end_nid; ++nid) {
     const auto& node = idx[nid];
     if (node.source->is_variable()) continue;
@@ -1245,38 +1719,54 @@ inline void CreateEngineOpSeg(
     bool is_async = exec->exec_type() != ExecType::kSync;
     bool valid = exec->out_array.size() > 0;
 
+    // A node reading nothing computed in the current segment starts an independent
+    // branch, which gets its own segment so that the engine can run it concurrently.
+    bool new_branch = split_branches && !seg_execs.empty();
+    for (size_t j = 0; new_branch && j < node.inputs.size(); ++j) {
+      const uint32_t input_nid = node.inputs[j].node_id;
+      new_branch = input_nid < seg_start || idx[input_nid].source->is_variable();
+    }
+
     // Stop at async nodes and invalid node (due to input/output is not allocated)
-    bool stop = is_async || !valid || seg_execs.size() >= bulk_size;
+    bool stop = is_async || !valid || seg_execs.size() >= bulk_size || new_branch;
 
     // Create opr segment for previous nodes.
     if (stop && nid > seg_start) {
       auto& seg = (*opr_segs)[seg_start];
       if (seg_execs.size()) {
         seg = EngineOprSeg{false, nid};
-        seg.opr.reset(CreateEngineOp(default_ctx, seg_execs, opr_names.c_str()));
+        seg.opr.reset(CreateEngineOp(default_ctx, seg_execs, opr_names.c_str(),
+                                     use_cuda_graphs && seg_capturable));
       } else {
         seg = EngineOprSeg{true, nid, nullptr};
       }
       seg_start = nid;
       seg_execs.clear();
       opr_names.clear();
+      seg_capturable = true;
     }
 
     seg_execs.push_back(exec);
     if (opr_names.size()) opr_names += ",";
     opr_names += op_name;
+    if (use_cuda_graphs) {
+      seg_capturable = seg_capturable && IsCudaGraphsCompatible(node.source->attrs, *exec,
+                                                                is_train);
+    }
 
     auto& seg = (*opr_segs)[nid];
     if (!valid) {
       seg = EngineOprSeg{false, nid + 1, nullptr};
       seg_execs.clear();
       opr_names.clear();
+      seg_capturable = true;
       seg_start = nid + 1;
     } else if (is_async) {
       seg = EngineOprSeg{false, nid + 1};
       seg.opr.reset(CreateEngineOp(default_ctx, seg_execs, opr_names.c_str()));
       seg_execs.clear();
       opr_names.clear();
+      seg_capturable = true;
       seg_start = nid + 1;
     }
   }
@@ -1285,7 +1775,8 @@ inline void CreateEngineOpSeg(
     auto& seg = (*opr_segs)[seg_start];
     if (seg_execs.size()) {
       seg = EngineOprSeg{false, end_nid};
-      seg.opr.reset(CreateEngineOp(default_ctx, seg_execs, opr_names.c_str()));
+      seg.opr.reset(CreateEngineOp(default_ctx, seg_execs, opr_names.c_str(),
+                                   use_cuda_graphs && seg_capturable));
     } else {
       seg = EngineOprSeg{true, end_nid, nullptr};
     }
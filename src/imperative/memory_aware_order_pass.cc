@@ -0,0 +1,222 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file memory_aware_order_pass.cc
+ * \brief Reorder the nodes of a graph range to reduce the peak size of live entries
+ */
+
+#include <mxnet/base.h>
+#include <mxnet/tuple.h>
+#include <nnvm/graph.h>
+#include <nnvm/graph_attr_types.h>
+#include <nnvm/op_attr_types.h>
+
+#include <algorithm>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "./exec_pass.h"
+
+namespace mxnet {
+namespace exec {
+
+namespace {
+
+/*!
+ * \brief Liveness of the entries read or written by the nodes of [node_start, num_nodes).
+ *  An entry is live from the node writing it, or from the start for the entries written
+ *  before the range, until its last reader. Graph inputs and outputs are never freed,
+ *  so they do not depend on the order and are left out.
+ */
+class LivenessModel {
+ public:
+  LivenessModel(const nnvm::Graph& g, uint32_t node_start)
+      : idx_(g.indexed_graph()), node_start_(node_start) {
+    const auto& shapes = g.GetAttr<mxnet::ShapeVector>("shape");
+    const auto& dtypes = g.GetAttr<nnvm::DTypeVector>("dtype");
+    bytes_.resize(idx_.num_node_entries(), 0);
+    for (uint32_t eid = 0; eid < idx_.num_node_entries(); ++eid) {
+      if (dtypes[eid] != -1 && mxnet::shape_is_known(shapes[eid])) {
+        bytes_[eid] = shapes[eid].Size() * mshadow::mshadow_sizeof(dtypes[eid]);
+      }
+    }
+    for (const auto& e : idx_.outputs()) bytes_[idx_.entry_id(e)] = 0;
+    for (const uint32_t nid : idx_.input_nodes()) bytes_[idx_.entry_id(nid, 0)] = 0;
+    readers_.resize(idx_.num_node_entries(), 0);
+    for (uint32_t nid = node_start_; nid < idx_.num_nodes(); ++nid) {
+      for (const auto& e : idx_[nid].inputs) ++readers_[idx_.entry_id(e)];
+    }
+  }
+
+  /*! \brief peak bytes of the live entries when running the nodes in the given order */
+  size_t Peak(const std::vector<uint32_t>& order) const {
+    std::vector<uint32_t> readers = readers_;
+    size_t live = 0;
+    for (uint32_t eid = 0; eid < EntryStart(); ++eid) {
+      if (readers[eid] > 0) live += bytes_[eid];
+    }
+    size_t peak = live;
+    for (const uint32_t nid : order) {
+      const auto& node = idx_[nid];
+      for (uint32_t i = 0; i < node.source->num_outputs(); ++i) {
+        live += bytes_[idx_.entry_id(nid, i)];
+      }
+      peak = std::max(peak, live);
+      for (const auto& e : node.inputs) {
+        const uint32_t eid = idx_.entry_id(e);
+        if (--readers[eid] == 0) live -= bytes_[eid];
+      }
+      for (uint32_t i = 0; i < node.source->num_outputs(); ++i) {
+        const uint32_t eid = idx_.entry_id(nid, i);
+        if (readers[eid] == 0) live -= bytes_[eid];
+      }
+    }
+    return peak;
+  }
+
+  /*!
+   * \brief Greedy list scheduling: among the nodes whose dependencies ran, run the one
+   *  freeing the most bytes net of what it allocates, the earliest one on ties.
+   */
+  std::vector<uint32_t> GreedyOrder() const {
+    const uint32_t num_nodes = idx_.num_nodes();
+    std::vector<uint32_t> pending(num_nodes, 0);
+    std::vector<std::vector<uint32_t> > dependents(num_nodes);
+    auto add_dep = [&](uint32_t nid, uint32_t dep) {
+      if (dep < node_start_ || idx_[dep].source->is_variable())
+        return;
+      ++pending[nid];
+      dependents[dep].push_back(nid);
+    };
+    std::set<uint32_t> ready;
+    for (uint32_t nid = node_start_; nid < num_nodes; ++nid) {
+      if (idx_[nid].source->is_variable()) continue;
+      for (const auto& e : idx_[nid].inputs) add_dep(nid, e.node_id);
+      for (const uint32_t dep : idx_[nid].control_deps) add_dep(nid, dep);
+      if (pending[nid] == 0) ready.insert(nid);
+    }
+
+    std::vector<uint32_t> readers = readers_;
+    std::vector<uint32_t> order;
+    std::vector<uint32_t> uses;
+    while (!ready.empty()) {
+      uint32_t best = *ready.begin();
+      int64_t best_score = 0;
+      bool first = true;
+      for (const uint32_t nid : ready) {
+        const auto& node = idx_[nid];
+        int64_t score = 0;
+        for (uint32_t i = 0; i < node.source->num_outputs(); ++i) {
+          score -= bytes_[idx_.entry_id(nid, i)];
+        }
+        uses.clear();
+        for (const auto& e : node.inputs) uses.push_back(idx_.entry_id(e));
+        std::sort(uses.begin(), uses.end());
+        for (size_t i = 0; i < uses.size(); ++i) {
+          size_t j = i;
+          while (j + 1 < uses.size() && uses[j + 1] == uses[i]) ++j;
+          if (readers[uses[i]] == j - i + 1) score += bytes_[uses[i]];
+          i = j;
+        }
+        if (first || score > best_score) {
+          best = nid;
+          best_score = score;
+          first = false;
+        }
+      }
+      ready.erase(best);
+      order.push_back(best);
+      for (const auto& e : idx_[best].inputs) --readers[idx_.entry_id(e)];
+      for (const uint32_t nid : dependents[best]) {
+        if (--pending[nid] == 0) ready.insert(nid);
+      }
+    }
+    return order;
+  }
+
+  /*! \brief the nodes of the range in their current order */
+  std::vector<uint32_t> CurrentOrder() const {
+    std::vector<uint32_t> order;
+    for (uint32_t nid = node_start_; nid < idx_.num_nodes(); ++nid) {
+      if (!idx_[nid].source->is_variable()) order.push_back(nid);
+    }
+    return order;
+  }
+
+ private:
+  uint32_t EntryStart() const {
+    return node_start_ < idx_.num_nodes() ? idx_.entry_id(node_start_, 0)
+                                          : idx_.num_node_entries();
+  }
+
+  const nnvm::IndexedGraph& idx_;
+  const uint32_t node_start_;
+  /*! \brief size of each entry, 0 for the entries not freed by the graph */
+  std::vector<size_t> bytes_;
+  /*! \brief number of reads of each entry by the nodes of the range */
+  std::vector<uint32_t> readers_;
+};
+
+}  // namespace
+
+std::vector<nnvm::ObjectPtr> MemoryAwareOrder(const nnvm::Graph& g, uint32_t node_start) {
+  const auto& idx = g.indexed_graph();
+  LivenessModel model(g, node_start);
+  const std::vector<uint32_t> current = model.CurrentOrder();
+  const std::vector<uint32_t> greedy = model.GreedyOrder();
+  CHECK_EQ(current.size(), greedy.size());
+  const size_t current_peak = model.Peak(current);
+  const size_t greedy_peak = model.Peak(greedy);
+  if (dmlc::GetEnv("MXNET_MEM_PLAN_VERBOSE_LOGGING", false)) {
+    LOG(INFO) << "Memory aware order of " << greedy.size() << " nodes: peak of live entries "
+              << current_peak << " bytes before, " << greedy_peak << " bytes after"
+              << (greedy_peak < current_peak ? "" : ", keeping the original order");
+  }
+  std::vector<nnvm::ObjectPtr> ret;
+  if (greedy_peak >= current_peak)
+    return ret;
+  // chain the nodes, so that the DFS building the indexed graph emits them in this order
+  std::vector<std::pair<nnvm::ObjectPtr, nnvm::ObjectPtr> > deps;
+  for (size_t k = 1; k < greedy.size(); ++k) {
+    nnvm::ObjectPtr prev = idx[greedy[k - 1]].weak_ref.lock();
+    nnvm::ObjectPtr node = idx[greedy[k]].weak_ref.lock();
+    const bool is_input = std::any_of(node->inputs.begin(), node->inputs.end(),
+        [&prev](const nnvm::NodeEntry& e) { return e.node == prev; });
+    if (is_input) continue;
+    // the control dependencies of these nodes point to their forward or fused nodes
+    static auto& is_backward = nnvm::Op::GetAttr<nnvm::TIsBackward>("TIsBackward");
+    static auto& is_fusion = nnvm::Op::GetAttr<TIsFusion>("TIsFusion");
+    static auto& is_fusion_helper = nnvm::Op::GetAttr<TIsFusionHelper>("TIsFusionHelper");
+    if ((is_backward.get(node->op(), false) && node->control_deps.empty()) ||
+        is_fusion.get(node->op(), false) || is_fusion_helper.get(node->op(), false)) {
+      return ret;
+    }
+    deps.emplace_back(node, prev);
+  }
+  for (const auto& dep : deps) {
+    dep.first->control_deps.push_back(dep.second);
+    ret.push_back(dep.first);
+  }
+  return ret;
+}
+
+}  // namespace exec
+}  // namespace mxnet
@@ -31,6 +31,10 @@
 #include <nnvm/pass_functions.h>
 #include <algorithm>
 #include <queue>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 #include "./simple_partition_pass.h"
 #include "../operator/fusion/fused_op-inl.h"
 #include "../operator/fusion/fused_op.h"
@@ -54,8 +58,6 @@ void WarnFusionNotSupported() {
   }
 }
 
-#if MXNET_USE_CUDA
-
 namespace {
   bool IsFusionCompatible(nnvm::Node* n) {
     using namespace mxnet::fusion;
@@ -88,6 +90,86 @@ namespace {
     return false;
   }
 
+  bool IsRowFusionCompatible(nnvm::Node* n) {
+    using namespace mxnet::fusion;
+    if (n->op() == nullptr)
+      return false;
+    const std::string& op_name = n->op()->name;
+    bool keepdims;
+    if (IsLastAxisReduce(n, &keepdims) || broadcast_ops.count(op_name))
+      return true;
+    // reshapes would break the row layout of the entries
+    if (std::find(reshape_ops.begin(), reshape_ops.end(), op_name) != reshape_ops.end())
+      return false;
+    if (ops_desc.count(op_name) || op_name == "add_n")
+      return true;
+    if (op_name == "LeakyReLU")
+      return LeakyReLU_ops.count(n->attrs.dict.at("act_type")) > 0;
+    return false;
+  }
+
+  /*!
+   * \brief Find the subsets fused with reductions over the last axis: the
+   *        connected sets of row compatible nodes containing a reduction,
+   *        whose entries can all be computed row by row.
+   */
+  std::vector<NodeRawPtrSet> GetRowSubsets(const Graph& g) {
+    std::vector<NodeRawPtrSet> ret;
+    for (auto& subset : GetCompatibleSubsets(g, IsRowFusionCompatible)) {
+      std::vector<const nnvm::Node*> nodes(subset.begin(), subset.end());
+      bool has_reduce = false;
+      for (const nnvm::Node* n : nodes) {
+        bool keepdims;
+        has_reduce = has_reduce || fusion::IsLastAxisReduce(n, &keepdims);
+      }
+      fusion::RowKinds kinds;
+      if (has_reduce && fusion::InferRowKinds(nodes, &kinds))
+        ret.push_back(std::move(subset));
+    }
+    return ret;
+  }
+
+  /*!
+   * \brief Whether replacing each subset by a single node makes the graph cyclic.
+   */
+  bool ContractionMakesCycle(const Graph& g, const std::vector<NodeRawPtrSet>& subsets) {
+    std::unordered_map<const nnvm::Node*, const void*> group;
+    for (const auto& subset : subsets) {
+      for (const nnvm::Node* n : subset) {
+        group[n] = &subset;
+      }
+    }
+    auto group_of = [&group](const nnvm::Node* n) {
+      auto it = group.find(n);
+      return it == group.end() ? static_cast<const void*>(n) : it->second;
+    };
+    std::unordered_map<const void*, std::unordered_set<const void*> > edges;
+    std::unordered_map<const void*, size_t> in_degree;
+    DFSVisit(g.outputs, [&group_of, &edges, &in_degree](const nnvm::ObjectPtr& n) {
+      const void* to = group_of(n.get());
+      in_degree.emplace(to, 0);
+      for (const auto& e : n->inputs) {
+        const void* from = group_of(e.node.get());
+        if (from != to && edges[from].insert(to).second)
+          ++in_degree[to];
+      }
+    });
+    std::vector<const void*> ready;
+    for (const auto& it : in_degree) {
+      if (it.second == 0) ready.push_back(it.first);
+    }
+    size_t visited = 0;
+    while (!ready.empty()) {
+      const void* n = ready.back();
+      ready.pop_back();
+      ++visited;
+      for (const void* to : edges[n]) {
+        if (--in_degree[to] == 0) ready.push_back(to);
+      }
+    }
+    return visited != in_degree.size();
+  }
+
   bool IsInputsOnlyCompatible(nnvm::Node* n) {
     using namespace mxnet::fusion;
     if (n->op() == nullptr)
@@ -300,21 +382,43 @@ void AddInputsOnlyCompatible(const Graph &g,
   }
 }
 
-Graph FusePointwiseForward(Graph &&g) {
+Graph FusePointwiseForward(Graph &&g, int dev_mask) {
   Graph ret;
   g.indexed_graph();
   const auto& num_forward_outputs = g.GetAttr<size_t>("num_forward_outputs");
   Graph fg;
   fg.outputs.insert(fg.outputs.begin(), g.outputs.begin(),
                     g.outputs.begin() + num_forward_outputs);
-  auto subsets = GetCompatibleSubsets(fg, IsFusionCompatible);
+  if (dev_mask == cpu::kDevMask) {
+    auto subsets = GetCompatibleSubsets(fg, fusion::IsCPUFusionCompatible);
+    g = ReplaceSubgraphsPointwise(std::move(g), subsets, CreateSubgraphNode);
+    ret.outputs = g.outputs;
+    return ret;
+  }
+  // subsets with reductions take precedence, the remaining nodes are fused
+  // pointwise
+  auto row_subsets = GetRowSubsets(fg);
+  std::unordered_set<nnvm::Node*> row_nodes;
+  for (const auto& subset : row_subsets) {
+    row_nodes.insert(subset.begin(), subset.end());
+  }
+  auto subsets = GetCompatibleSubsets(fg, [&row_nodes](nnvm::Node* n) {
+    if (row_nodes.count(n))
+      return false;
+    return IsFusionCompatible(n);
+  });
   AddInputsOnlyCompatible(fg, &subsets, IsInputsOnlyCompatible);
+  subsets.insert(subsets.end(), row_subsets.begin(), row_subsets.end());
+  if (!row_subsets.empty() && ContractionMakesCycle(fg, subsets)) {
+    subsets = GetCompatibleSubsets(fg, IsFusionCompatible);
+    AddInputsOnlyCompatible(fg, &subsets, IsInputsOnlyCompatible);
+  }
   g = ReplaceSubgraphsPointwise(std::move(g), subsets, CreateSubgraphNode);
   ret.outputs = g.outputs;
   return ret;
 }
 
-Graph FusePointwiseBackward(Graph &&g) {
+Graph FusePointwiseBackward(Graph &&g, int dev_mask) {
   Graph ret;
   g.indexed_graph();
   const auto& num_forward_outputs = g.GetAttr<size_t>("num_forward_outputs");
@@ -325,16 +429,17 @@ Graph FusePointwiseBackward(Graph &&g) {
   DFSVisit(fg.outputs, [&exclusion_set](const nnvm::ObjectPtr& n) {
     exclusion_set.insert(n.get());
   });
-  auto subsets = GetCompatibleSubsets(g, [&exclusion_set](nnvm::Node* n) {
+  auto subsets = GetCompatibleSubsets(g, [&exclusion_set, dev_mask](nnvm::Node* n) {
     if (exclusion_set.count(n))
       return false;
+    if (dev_mask == cpu::kDevMask)
+      return fusion::IsCPUFusionCompatible(n);
     return IsFusionCompatible(n);
   });
   g = ReplaceSubgraphsPointwise(std::move(g), subsets, CreateSubgraphNode);
   ret.outputs = g.outputs;
   return ret;
 }
-#endif  // MXNET_USE_CUDA
 
 }  // namespace exec
 }  // namespace mxnet
@@ -95,6 +95,10 @@ class GroupBatchify : public BatchifyFunction {
     return true;
   }
 
+  void SetOutputContext(const Context& ctx) override {
+    for (auto& f : fs_) f->SetOutputContext(ctx);
+  }
+
  private:
   /*! \brief params */
   GroupBatchifyParam param_;
@@ -152,7 +156,7 @@ class StackBatchify : public BatchifyFunction {
         }
 
         int dtype = inputs[0][i].dtype();
-        if (!(*outputs)[i].is_none() && (*outputs)[i].ctx() == mxnet::Context::CPU(0) &&
+        if (!(*outputs)[i].is_none() && (*outputs)[i].ctx() == ctx_ &&
             (*outputs)[i].dtype() == dtype &&
             (*outputs)[i].storage_type() == kDefaultStorage) {
           if ((*outputs)[i].shape() != sshape) {
@@ -160,7 +164,7 @@ class StackBatchify : public BatchifyFunction {
             (*outputs)[i].ReshapeAndAlloc(sshape);
           }
         } else {
-          (*outputs)[i] = NDArray(sshape, mxnet::Context::CPU(0), false, inputs[0][i].dtype());
+          (*outputs)[i] = NDArray(sshape, ctx_, false, inputs[0][i].dtype());
         }
         int sbs = static_cast<int>(bs);
         MSHADOW_TYPE_SWITCH_WITH_BOOL(dtype, DType, {
@@ -182,9 +186,16 @@ class StackBatchify : public BatchifyFunction {
     }
     return true;
   }
+
+  void SetOutputContext(const Context& ctx) override {
+    CHECK_EQ(ctx.dev_mask(), cpu::kDevMask) << "StackBatchify writes to cpu memory, given " << ctx;
+    ctx_ = ctx;
+  }
  private:
   /*! \brief parameters */
   StackBatchifyParam param_;
+  /*! \brief context of the outputs */
+  Context ctx_ = Context::CPU(0);
   /*! \brief OMPException obj to store and rethrow exceptions from omp blocks*/
   dmlc::OMPException omp_exc_;
 
@@ -272,7 +283,7 @@ class PadBatchify : public BatchifyFunction {
 
         int dtype = param_.dtype > -1 ? param_.dtype : inputs[0][i].dtype();
         if (!(*outputs)[i].is_none() &&
-            (*outputs)[i].ctx() == mxnet::Context::CPU(0) &&
+            (*outputs)[i].ctx() == ctx_ &&
             (*outputs)[i].dtype() == dtype &&
             (*outputs)[i].storage_type() == kDefaultStorage) {
           if ((*outputs)[i].shape() != sshape) {
@@ -280,7 +291,7 @@ class PadBatchify : public BatchifyFunction {
             (*outputs)[i].ReshapeAndAlloc(sshape);
           }
         } else {
-          (*outputs)[i] = NDArray(sshape, mxnet::Context::CPU(0), false, inputs[0][i].dtype());
+          (*outputs)[i] = NDArray(sshape, ctx_, false, inputs[0][i].dtype());
         }
         MSHADOW_TYPE_SWITCH_WITH_BOOL(dtype, DType, {
           // fill pad value first
@@ -357,9 +368,16 @@ class PadBatchify : public BatchifyFunction {
     return true;
   }
 
+  void SetOutputContext(const Context& ctx) override {
+    CHECK_EQ(ctx.dev_mask(), cpu::kDevMask) << "PadBatchify writes to cpu memory, given " << ctx;
+    ctx_ = ctx;
+  }
+
  private:
   /*! \brief parameters */
   PadBatchifyParam param_;
+  /*! \brief context of the outputs */
+  Context ctx_ = Context::CPU(0);
   /*! \brief OMPException obj to store and rethrow exceptions from omp blocks*/
   dmlc::OMPException omp_exc_;
 
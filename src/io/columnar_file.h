@@ -0,0 +1,291 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file columnar_file.h
+ * \brief reader of the columnar binary files of ColumnarDataset and ColumnarIter
+ *
+ *  A columnar file stores the rows in row groups, and each row group stores one chunk per
+ *  column, so that a subset of the columns is read without a parse. The little-endian
+ *  layout, written by mxnet.gluon.data.ColumnarDataset.write, is
+ *
+ *  - the magic "MXCOLUMN"
+ *  - the column chunks, each aligned to 64 bytes. A dense chunk stores the row values,
+ *    a CSR chunk stores its int64 indptr starting at 0, its int64 indices and its values.
+ *  - the footer
+ *    - uint32 version, uint32 number of columns, uint64 number of rows,
+ *      uint64 number of row groups
+ *    - for each column: uint32 name length, name, int32 dtype flag, int32 storage
+ *      (0 dense, 1 CSR), int32 ndim, int64 shape of a row. A CSR row has shape (num_col,).
+ *    - for each row group: uint64 number of rows, then for each column the uint64 offsets
+ *      of the values, of the indices and of the indptr, and the uint64 number of values.
+ *  - uint64 offset of the footer
+ *  - the magic "MXCOLUMN"
+ */
+#ifndef MXNET_IO_COLUMNAR_FILE_H_
+#define MXNET_IO_COLUMNAR_FILE_H_
+
+#include <dmlc/logging.h>
+#include <mxnet/base.h>
+#include <mxnet/tuple.h>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "./mapped_file.h"
+
+namespace mxnet {
+namespace io {
+
+/*! \brief storage of a column */
+enum ColumnStorage {
+  kDenseColumn = 0,
+  kCSRColumn = 1
+};
+
+/*! \brief description of a column */
+struct ColumnInfo {
+  /*! \brief name of the column */
+  std::string name;
+  /*! \brief type flag of the values */
+  int dtype;
+  /*! \brief dense or CSR storage */
+  int storage;
+  /*! \brief shape of one row */
+  mxnet::TShape shape;
+};
+
+/*! \brief chunk of a column in a row group */
+struct ColumnChunk {
+  /*! \brief values of the rows */
+  const char *data;
+  /*! \brief column of each value of a CSR chunk */
+  const int64_t *indices;
+  /*! \brief offset of each row in the values of a CSR chunk */
+  const int64_t *indptr;
+  /*! \brief number of values of a CSR chunk */
+  uint64_t nnz;
+};
+
+/*! \brief row group, the rows [begin, begin + num_rows) of the file */
+struct RowGroup {
+  /*! \brief first row */
+  uint64_t begin;
+  /*! \brief number of rows */
+  uint64_t num_rows;
+  /*! \brief chunk of each column */
+  std::vector<ColumnChunk> chunks;
+};
+
+/*! \brief memory mapped columnar file */
+class ColumnarFile {
+ public:
+  /*!
+   * \brief map and check a columnar file
+   * \param uri path of a local file
+   */
+  explicit ColumnarFile(const std::string &uri) {
+    const std::string path = LocalPath(uri);
+    CHECK(!path.empty()) << "Columnar files are memory mapped and have to be local, got " << uri;
+    mapping_ = std::make_shared<MappedFile>(path);
+    const char *base = mapping_->data();
+    const size_t size = mapping_->size();
+    const size_t kTail = sizeof(uint64_t) + kMagicSize;
+    CHECK(size >= kMagicSize + kTail && std::memcmp(base, kMagic, kMagicSize) == 0 &&
+          std::memcmp(base + size - kMagicSize, kMagic, kMagicSize) == 0)
+        << uri << " is not a columnar file";
+    uint64_t footer = 0;
+    std::memcpy(&footer, base + size - kTail, sizeof(footer));
+    CHECK_LE(footer, size - kTail) << "Invalid columnar file " << uri;
+    pos_ = footer;
+    end_ = size - kTail;
+    const uint32_t version = Read<uint32_t>();
+    CHECK(version == kVersion)
+        << "Unsupported version " << version << " of columnar file " << uri;
+    const uint32_t num_columns = Read<uint32_t>();
+    num_rows_ = Read<uint64_t>();
+    const uint64_t num_groups = Read<uint64_t>();
+    columns_.resize(num_columns);
+    for (auto &column : columns_) {
+      const uint32_t name_size = Read<uint32_t>();
+      CHECK_LE(pos_ + name_size, end_) << "Invalid columnar file " << uri;
+      column.name.assign(base + pos_, name_size);
+      pos_ += name_size;
+      column.dtype = Read<int32_t>();
+      column.storage = Read<int32_t>();
+      const int32_t ndim = Read<int32_t>();
+      CHECK_GE(ndim, 0) << "Invalid columnar file " << uri;
+      column.shape = mxnet::TShape(ndim, -1);
+      for (int32_t i = 0; i < ndim; ++i) column.shape[i] = Read<int64_t>();
+      CHECK(column.storage == kDenseColumn || (column.storage == kCSRColumn && ndim == 1))
+          << "Invalid storage of column " << column.name << " in " << uri;
+    }
+    uint64_t begin = 0;
+    groups_.resize(num_groups);
+    for (auto &group : groups_) {
+      group.begin = begin;
+      group.num_rows = Read<uint64_t>();
+      begin += group.num_rows;
+      group.chunks.resize(num_columns);
+      for (uint32_t c = 0; c < num_columns; ++c) {
+        const uint64_t data = Read<uint64_t>(), indices = Read<uint64_t>();
+        const uint64_t indptr = Read<uint64_t>(), nnz = Read<uint64_t>();
+        ColumnChunk &chunk = group.chunks[c];
+        chunk.nnz = nnz;
+        const size_t elem_size = mshadow::mshadow_sizeof(columns_[c].dtype);
+        if (columns_[c].storage == kDenseColumn) {
+          CheckRange(data, group.num_rows * columns_[c].shape.Size() * elem_size, uri);
+          chunk.data = base + data;
+          chunk.indices = chunk.indptr = nullptr;
+        } else {
+          CheckRange(data, nnz * elem_size, uri);
+          CheckRange(indices, nnz * sizeof(int64_t), uri);
+          CheckRange(indptr, (group.num_rows + 1) * sizeof(int64_t), uri);
+          chunk.data = base + data;
+          chunk.indices = reinterpret_cast<const int64_t *>(base + indices);
+          chunk.indptr = reinterpret_cast<const int64_t *>(base + indptr);
+        }
+      }
+    }
+    CHECK_EQ(begin, num_rows_) << "Invalid columnar file " << uri;
+  }
+
+  /*! \return number of rows */
+  uint64_t NumRows() const {
+    return num_rows_;
+  }
+  /*! \return the columns */
+  const std::vector<ColumnInfo> &Columns() const {
+    return columns_;
+  }
+  /*! \return the row groups */
+  const std::vector<RowGroup> &Groups() const {
+    return groups_;
+  }
+  /*! \return the mapping of the file, to keep it alive while arrays view it */
+  const std::shared_ptr<MappedFile> &Mapping() const {
+    return mapping_;
+  }
+  /*!
+   * \brief select columns by name
+   * \param names comma separated names, all the columns except exclude if empty
+   * \param exclude columns not selected by default
+   * \return indices of the columns
+   */
+  std::vector<size_t> Project(const std::string &names,
+                              const std::vector<size_t> &exclude = {}) const {
+    std::vector<size_t> ret;
+    if (names.empty()) {
+      for (size_t c = 0; c < columns_.size(); ++c) {
+        if (std::find(exclude.begin(), exclude.end(), c) == exclude.end()) ret.push_back(c);
+      }
+      return ret;
+    }
+    std::istringstream is(names);
+    std::string name;
+    while (std::getline(is, name, ',')) {
+      name.erase(0, name.find_first_not_of(' '));
+      name.erase(name.find_last_not_of(' ') + 1);
+      auto it = std::find_if(columns_.begin(), columns_.end(),
+                             [&name](const ColumnInfo &c) { return c.name == name; });
+      CHECK(it != columns_.end()) << "Column " << name << " is not in the columnar file";
+      ret.push_back(it - columns_.begin());
+    }
+    return ret;
+  }
+  /*! \return index of the row group containing a row */
+  size_t GroupOf(uint64_t row) const {
+    CHECK_LT(row, num_rows_) << "Row " << row << " is out of bound: (0, " << num_rows_ << ")";
+    auto it = std::upper_bound(groups_.begin(), groups_.end(), row,
+                               [](uint64_t r, const RowGroup &g) { return r < g.begin; });
+    return it - groups_.begin() - 1;
+  }
+  /*! \return number of bytes of a row of a dense column */
+  size_t RowBytes(size_t column) const {
+    return columns_[column].shape.Size() * mshadow::mshadow_sizeof(columns_[column].dtype);
+  }
+  /*!
+   * \brief let the kernel read the chunks of rows [begin, end) of the columns ahead
+   * \param columns indices of the columns
+   */
+  void WillNeed(const std::vector<size_t> &columns, uint64_t begin, uint64_t end) const {
+    end = std::min(end, num_rows_);
+    const char *base = mapping_->data();
+    while (begin < end) {
+      const RowGroup &group = groups_[GroupOf(begin)];
+      const uint64_t first = begin - group.begin;
+      const uint64_t last = std::min(end, group.begin + group.num_rows) - group.begin;
+      for (size_t c : columns) {
+        const ColumnChunk &chunk = group.chunks[c];
+        if (columns_[c].storage == kDenseColumn) {
+          mapping_->WillNeed(chunk.data - base + first * RowBytes(c),
+                             chunk.data - base + last * RowBytes(c));
+        } else {
+          const size_t elem_size = mshadow::mshadow_sizeof(columns_[c].dtype);
+          const int64_t nz_begin = chunk.indptr[first], nz_end = chunk.indptr[last];
+          mapping_->WillNeed(chunk.data - base + nz_begin * elem_size,
+                             chunk.data - base + nz_end * elem_size);
+          mapping_->WillNeed(reinterpret_cast<const char *>(chunk.indices + nz_begin) - base,
+                             reinterpret_cast<const char *>(chunk.indices + nz_end) - base);
+        }
+      }
+      begin = group.begin + last;
+    }
+  }
+
+  /*! \brief magic at the beginning and the end of the file */
+  static constexpr const char *kMagic = "MXCOLUMN";
+  /*! \brief size of the magic */
+  static constexpr size_t kMagicSize = 8;
+  /*! \brief version of the layout */
+  static constexpr uint32_t kVersion = 1;
+
+ private:
+  /*! \brief read a value of the footer */
+  template<typename T>
+  T Read() {
+    CHECK_LE(pos_ + sizeof(T), end_) << "Invalid columnar file footer";
+    T value;
+    std::memcpy(&value, mapping_->data() + pos_, sizeof(T));
+    pos_ += sizeof(T);
+    return value;
+  }
+  /*! \brief check that [offset, offset + size) is in the file */
+  void CheckRange(uint64_t offset, uint64_t size, const std::string &uri) const {
+    CHECK(offset <= mapping_->size() && size <= mapping_->size() - offset)
+        << "Invalid chunk offset in columnar file " << uri;
+  }
+
+  /*! \brief mapping of the file */
+  std::shared_ptr<MappedFile> mapping_;
+  /*! \brief columns */
+  std::vector<ColumnInfo> columns_;
+  /*! \brief row groups */
+  std::vector<RowGroup> groups_;
+  /*! \brief number of rows */
+  uint64_t num_rows_{0};
+  /*! \brief position and end of the footer while reading it */
+  size_t pos_{0}, end_{0};
+};
+
+}  // namespace io
+}  // namespace mxnet
+#endif  // MXNET_IO_COLUMNAR_FILE_H_
@@ -26,9 +26,16 @@
 #include <dmlc/omp.h>
 #include <mxnet/io.h>
 
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <utility>
+#include <vector>
+
 #include "./inst_vector.h"
 #include "./iter_prefetcher.h"
-#include "../profiler/custom_op_profiler.h"
+#include "../engine/thread_budget.h"
+#include "../profiler/data_profiler.h"
 
 namespace mxnet {
 namespace io {
@@ -43,6 +50,12 @@ struct ThreadedDataLoaderParam : public dmlc::Parameter<ThreadedDataLoaderParam>
   std::intptr_t batchify_fn;
   /*! \brief pin memory to device id.*/
   int pin_device_id;
+  /*! \brief number of batches sampled ahead for the dataset to prefetch.*/
+  int prefetch_batches;
+  /*! \brief copy the batches to the gpu asynchronously.*/
+  bool copy_to_gpu;
+  /*! \brief maximum number of batches loaded in the background.*/
+  int inflight_batches;
   // declare parameters
   DMLC_DECLARE_PARAMETER(ThreadedDataLoaderParam) {
       DMLC_DECLARE_FIELD(num_workers).set_default(0)
@@ -54,7 +67,17 @@ struct ThreadedDataLoaderParam : public dmlc::Parameter<ThreadedDataLoaderParam>
       DMLC_DECLARE_FIELD(batchify_fn)
           .describe("Pointer to Batchify function.");
       DMLC_DECLARE_FIELD(pin_device_id).set_default(-1)
-          .describe("If not negative, will move data to pinned memory.");
+          .describe("If not negative, the batchify function writes data to pinned memory.");
+      DMLC_DECLARE_FIELD(prefetch_batches).set_default(2).set_lower_bound(0)
+          .describe("Number of batches sampled ahead of the current one, whose items "
+                    "the dataset may start reading asynchronously, e.g. a local "
+                    "RecordFileDataset.");
+      DMLC_DECLARE_FIELD(copy_to_gpu).set_default(false)
+          .describe("If true, the batches are copied to gpu(pin_device_id) "
+                    "asynchronously, while the next batch is being assembled.");
+      DMLC_DECLARE_FIELD(inflight_batches).set_default(16).set_lower_bound(1)
+          .describe("Maximum number of batches loaded by the background thread ahead "
+                    "of the one being consumed.");
   }
 };  // struct ThreadedDataLoaderParam
 
@@ -81,15 +104,24 @@ class ThreadedDataLoader : public IIterator<TBlobBatch> {
       threadget = omp_get_num_threads();
     }
     param_.num_workers = std::max(1, threadget);
+    budget_ = engine::ThreadBudget::Get()->Acquire("ThreadedDataLoader", param_.num_workers);
+    param_.num_workers = budget_->threads();
     dataset_ = *static_cast<std::shared_ptr<Dataset>*>(reinterpret_cast<void*>(param_.dataset));
     dataset_len_ = dataset_->GetLen();
     sampler_ = static_cast<IIterator<DataBatch>* >(reinterpret_cast<void*>(param_.sampler));
     batchify_fn_ = *static_cast<BatchifyFunctionPtr*>(reinterpret_cast<void*>(param_.batchify_fn));
+    batchify_fn_->SetOutputContext(param_.pin_device_id >= 0 ?
+                                   Context::CPUPinned(param_.pin_device_id) : Context::CPU(0));
+    CHECK(!param_.copy_to_gpu || param_.pin_device_id >= 0)
+      << "copy_to_gpu requires pinned memory, i.e. a non-negative pin_device_id";
+    // while a batch is copied to the gpu, the next one is assembled in another buffer
+    batched_buffers_.resize(param_.copy_to_gpu ? 2 : 1);
     this->BeforeFirst();
   }
   // before first
   void BeforeFirst() override {
     sampler_->BeforeFirst();
+    pending_.clear();
   }
 
   int64_t GetLenHint() const override {
@@ -97,34 +129,46 @@ class ThreadedDataLoader : public IIterator<TBlobBatch> {
   }
 
   bool Next() override {
-    bool has_next = sampler_->Next();
-    if (!has_next) return false;
-    auto samples = sampler_->Value();
-    auto batch_size = samples.data[0].shape().Size();
+    // sample ahead, so that the dataset reads the next batches while this one is processed
+    while (pending_.size() <= static_cast<size_t>(param_.prefetch_batches) && sampler_->Next()) {
+      auto samples = sampler_->Value();
+      SampledBatch sampled;
+      sampled.batch_size = samples.data[0].shape().Size();
+      sampled.num_batch_padd = samples.num_batch_padd;
+      const int64_t *idx_ptr = static_cast<int64_t*>(samples.data[0].data().dptr_);
+      sampled.indices.assign(idx_ptr, idx_ptr + sampled.batch_size - sampled.num_batch_padd);
+      if (param_.prefetch_batches > 0) {
+        dataset_->Prefetch(std::vector<uint64_t>(sampled.indices.begin(),
+                                                 sampled.indices.end()));
+      }
+      pending_.push_back(std::move(sampled));
+    }
+    if (pending_.empty()) return false;
+    SampledBatch samples = std::move(pending_.front());
+    pending_.pop_front();
+    auto batch_size = samples.batch_size;
     int real_batch_size = batch_size - samples.num_batch_padd;
-    const int64_t *idx_ptr = static_cast<int64_t*>(
-        samples.data[0].data().dptr_);
-    std::vector<int64_t> idx_ptrs;
-    idx_ptrs.assign(idx_ptr, idx_ptr + real_batch_size);
+    const std::vector<int64_t>& idx_ptrs = samples.indices;
 
     // __getitem__
     std::vector<std::vector<NDArray> > inputs(batch_size);
     std::vector<int> is_scalars;
-    bool profiling = profiler::Profiler::Get()->IsProfiling(profiler::Profiler::kImperative);
-    if (profiling) {
-      profiler::CustomOpProfiler::Get()->OnCustomBegin("MXThreadedDataLoaderGetItems");
-    }
+    const bool profiling = profiler::IsProfilingDataPipeline();
+    if (profiling) get_items_stage_.start();
+    // each worker reads a contiguous chunk of the batch in one call
+    const int num_chunks = std::min(param_.num_workers, real_batch_size);
     #pragma omp parallel for num_threads(param_.num_workers)
-    for (int i = 0; i < real_batch_size; ++i) {
+    for (int c = 0; c < num_chunks; ++c) {
+      budget_->BindThread(omp_get_thread_num());
       omp_exc_.Run([&] {
-        auto idx = idx_ptrs[i];
-        CHECK(dataset_->GetItem(idx, &inputs[i]))
-          << "Error getting data # " << idx;
+        const int begin = c * real_batch_size / num_chunks;
+        const int end = (c + 1) * real_batch_size / num_chunks;
+        const std::vector<uint64_t> chunk(idx_ptrs.begin() + begin, idx_ptrs.begin() + end);
+        CHECK(dataset_->GetItems(chunk, &inputs[begin]))
+          << "Error getting data # " << idx_ptrs[begin] << " to " << idx_ptrs[end - 1];
       });
     }
-    if (profiling) {
-      profiler::CustomOpProfiler::Get()->OnCustomEnd();
-    }
+    if (profiling) get_items_stage_.stop(real_batch_size);
     omp_exc_.Rethrow();
 
     // pad to normal batch size
@@ -133,18 +177,20 @@ class ThreadedDataLoader : public IIterator<TBlobBatch> {
     }
 
     // batchify
-    if (profiling) {
-      profiler::CustomOpProfiler::Get()->OnCustomBegin("MXThreadedDataLoaderBatchify");
+    current_ = (current_ + 1) % batched_buffers_.size();
+    std::vector<NDArray>& batched_buffer = batched_buffers_[current_];
+    // wait for the copies still reading the buffer
+    for (auto& arr : batched_buffer) {
+      arr.WaitToWrite();
     }
-    CHECK(batchify_fn_->Batchify(inputs, &batched_buffer_))
+    if (profiling) batchify_stage_.start();
+    CHECK(batchify_fn_->Batchify(inputs, &batched_buffer))
       << "Error call batchify inside dataloader";
-    if (profiling) {
-      profiler::CustomOpProfiler::Get()->OnCustomEnd();
-    }
-    out_.batch_size = batched_buffer_.size();
-    out_.data.resize(batched_buffer_.size());
-    for (size_t i = 0; i < batched_buffer_.size(); ++i) {
-      out_.data[i] = batched_buffer_[i].data();
+    if (profiling) batchify_stage_.stop(real_batch_size);
+    out_.batch_size = batched_buffer.size();
+    out_.data.resize(batched_buffer.size());
+    for (size_t i = 0; i < batched_buffer.size(); ++i) {
+      out_.data[i] = batched_buffer[i].data();
     }
     out_.num_batch_padd = samples.num_batch_padd;
     return true;
@@ -154,32 +200,121 @@ class ThreadedDataLoader : public IIterator<TBlobBatch> {
     return out_;
   }
 
+  /*! \brief the arrays holding the current batch */
+  const std::vector<NDArray> &Arrays() const {
+    return batched_buffers_[current_];
+  }
+
+  /*! \brief the parameters of the loader */
+  const ThreadedDataLoaderParam &Param() const {
+    return param_;
+  }
+
  private:
+  /*! \brief indices of a batch drawn from the sampler */
+  struct SampledBatch {
+    std::vector<int64_t> indices;
+    size_t batch_size;
+    int num_batch_padd;
+  };
   /*! \brief Params */
   ThreadedDataLoaderParam param_;
+  /*! \brief threads of the loader leased from the thread budget */
+  std::unique_ptr<engine::ThreadBudget::Lease> budget_;
   /*! \brief output */
   TBlobBatch out_;
-  /*! \brief batched buffer */
-  std::vector<NDArray> batched_buffer_;
+  /*! \brief batched buffers, used in turn */
+  std::vector<std::vector<NDArray> > batched_buffers_;
+  /*! \brief index of the buffer holding the current batch */
+  size_t current_ = 0;
   /*! \brief pointer to dataset */
   std::shared_ptr<Dataset> dataset_;
   /*! \brief dataset length */
   int64_t dataset_len_;
   /*! \brief pointer to sampler iterator */
   IIterator<DataBatch> *sampler_;
+  /*! \brief batches drawn from the sampler but not yet loaded */
+  std::deque<SampledBatch> pending_;
   /*! \brief pointer to batchify function */
   BatchifyFunctionPtr batchify_fn_;
   /*! \brief OMPException obj to store and rethrow exceptions from omp blocks*/
   dmlc::OMPException omp_exc_;
+  /*! \brief profiled stages */
+  profiler::ProfileDataStage get_items_stage_{"ThreadedDataLoader::GetItems"};
+  profiler::ProfileDataStage batchify_stage_{"ThreadedDataLoader::Batchify"};
 };  // class ThreadedDataLoader
 
+/*!
+ * \brief Prefetcher of the ThreadedDataLoader, which loads up to inflight_batches batches in
+ *  the background. With copy_to_gpu, it issues the copy of each batch from the pinned memory
+ *  of the loader to the gpu on the copy stream of the engine, without waiting for it, so that
+ *  the copy overlaps with loading the next batch.
+ */
+class ThreadedDataLoaderPrefetcherIter : public PrefetcherIter {
+ public:
+  explicit ThreadedDataLoaderPrefetcherIter(ThreadedDataLoader<mxnet::real_t>* base)
+      : PrefetcherIter(base), threaded_loader_(base) {}
+
+  void Init(const std::vector<std::pair<std::string, std::string> >& kwargs) override {
+    ThreadedDataLoaderParam loader_param;
+    loader_param.InitAllowUnknown(kwargs);
+    max_inflight_ = loader_param.inflight_batches;
+    if (!loader_param.copy_to_gpu) {
+      PrefetcherIter::Init(kwargs);
+      return;
+    }
+    PrefetcherIter::InitParams(kwargs);
+    CHECK(!param_.dtype) << "ThreadedDataLoader does not convert the dtype with copy_to_gpu";
+    threaded_loader_->Init(kwargs);
+    length_hint_ = threaded_loader_->GetLenHint();
+    const Context ctx = Context::GPU(loader_param.pin_device_id);
+    iter.Init([this, ctx](DataBatch **dptr) {
+        const bool profiling = profiler::IsProfilingDataPipeline();
+        if (profiling) load_stage_.start();
+        if (!threaded_loader_->Next()) return false;
+        const TBlobBatch& batch = threaded_loader_->Value();
+        const std::vector<NDArray>& arrays = threaded_loader_->Arrays();
+        const size_t num_samples = NumSamples(batch.data, batch.num_batch_padd);
+        if (profiling) load_stage_.stop(num_samples);
+        if (*dptr == nullptr) {
+          *dptr = new DataBatch();
+          (*dptr)->data.resize(arrays.size());
+          (*dptr)->index.resize(batch.batch_size);
+          for (size_t i = 0; i < arrays.size(); ++i) {
+            (*dptr)->data.at(i) = NDArray(arrays[i].shape(), ctx, false, arrays[i].dtype());
+          }
+        }
+        CHECK_EQ(arrays.size(), (*dptr)->data.size());
+        for (size_t i = 0; i < arrays.size(); ++i) {
+          NDArray& dst = (*dptr)->data.at(i);
+          if (dst.shape() != arrays[i].shape()) {
+            dst.ReshapeAndAlloc(arrays[i].shape());
+          }
+          // the loader waits for the copy before reusing the pinned buffer
+          CopyFromTo(arrays[i], &dst);
+        }
+        (*dptr)->num_batch_padd = batch.num_batch_padd;
+        queue_.Push();
+        return true;
+      },
+      [this]() {
+        threaded_loader_->BeforeFirst();
+        length_hint_ = threaded_loader_->GetLenHint();
+      });
+  }
+
+ private:
+  /*! \brief the loader, owned by the base class */
+  ThreadedDataLoader<mxnet::real_t>* threaded_loader_;
+};  // class ThreadedDataLoaderPrefetcherIter
+
 MXNET_REGISTER_IO_ITER(ThreadedDataLoader)
 .describe(R"code(Returns a threaded data loader iterator.
 )code" ADD_FILELINE)
 .add_arguments(ThreadedDataLoaderParam::__FIELDS__())
 .add_arguments(PrefetcherParam::__FIELDS__())
 .set_body([]() {
-    return new PrefetcherIter(
+    return new ThreadedDataLoaderPrefetcherIter(
             new ThreadedDataLoader<mxnet::real_t>());
   });
 }  // namespace io
@@ -29,15 +29,27 @@
 #include <mxnet/ndarray.h>
 #include <mxnet/tensor_blob.h>
 
+#include <cstring>
+#include <fstream>
 #include <memory>
 #include <string>
 #include <vector>
 #include <algorithm>
 #include <thread>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif  // _WIN32
+
 #include "../imperative/cached_op.h"
 #include "../imperative/naive_cached_op.h"
 #include "../ndarray/ndarray_function.h"
+#include "./columnar_file.h"
+#include "./decoded_image_cache.h"
+#include "./mapped_file.h"
 
 #if MXNET_USE_OPENCV
 #include <opencv2/opencv.hpp>
@@ -50,12 +62,16 @@ namespace io {
 struct RecordFileDatasetParam : public dmlc::Parameter<RecordFileDatasetParam> {
   std::string rec_file;
   std::string idx_file;
+  bool use_mmap;
   // declare parameters
   DMLC_DECLARE_PARAMETER(RecordFileDatasetParam) {
       DMLC_DECLARE_FIELD(rec_file)
           .describe("The absolute path of record file.");
       DMLC_DECLARE_FIELD(idx_file)
           .describe("The path of the idx file.");
+      DMLC_DECLARE_FIELD(use_mmap).set_default(false)
+          .describe("Map the local record file in memory and return records pointing into "
+                    "the mapping instead of reading and copying each of them.");
   }
 };  // struct RecordFileDatasetParam
 
@@ -74,6 +90,31 @@ class RecordFileDataset final : public Dataset {
       idx_[key] = idx;
     }
     delete idx_stream;
+    const std::string path = LocalPath(param_.rec_file);
+    if (param_.use_mmap) {
+      CHECK(!path.empty()) << "use_mmap requires a local record file, got " << param_.rec_file;
+      mapping_ = std::make_shared<MappedFile>(path);
+    }
+#ifdef __linux__
+    // the extent of each record, to let the kernel read ahead the records of Prefetch
+    struct stat st;
+    if (!path.empty() && stat(path.c_str(), &st) == 0) {
+      std::vector<size_t> offsets;
+      offsets.reserve(idx_.size());
+      for (const auto& kv : idx_) offsets.push_back(kv.second);
+      std::sort(offsets.begin(), offsets.end());
+      for (size_t i = 0; i < offsets.size(); ++i) {
+        record_end_[offsets[i]] = i + 1 < offsets.size() ? offsets[i + 1] : st.st_size;
+      }
+      if (mapping_ == nullptr) fd_ = open(path.c_str(), O_RDONLY);
+    }
+#endif  // __linux__
+  }
+
+  ~RecordFileDataset() override {
+#ifdef __linux__
+    if (fd_ != -1) close(fd_);
+#endif  // __linux__
   }
 
   uint64_t GetLen() const override {
@@ -83,6 +124,10 @@ class RecordFileDataset final : public Dataset {
   bool GetItem(uint64_t idx, std::vector<NDArray>* ret) override {
     ret->resize(1);
     auto& out = (*ret)[0];
+    if (mapping_ != nullptr) {
+      GetMappedRecord(idx_[static_cast<size_t>(idx)], &out);
+      return true;
+    }
     static thread_local std::unique_ptr<dmlc::Stream> stream;
     static thread_local std::unique_ptr<dmlc::RecordIOReader> reader;
     if (!reader) {
@@ -107,11 +152,72 @@ class RecordFileDataset final : public Dataset {
     return true;
   }
 
+  void Prefetch(const std::vector<uint64_t>& indices) override {
+#ifdef __linux__
+    for (const uint64_t i : indices) {
+      auto idx_it = idx_.find(static_cast<size_t>(i));
+      if (idx_it == idx_.end()) continue;
+      auto end_it = record_end_.find(idx_it->second);
+      if (end_it == record_end_.end()) continue;
+      const size_t begin = idx_it->second;
+      const size_t end = end_it->second;
+      // both only queue the reads and return
+      if (mapping_ != nullptr) {
+        mapping_->WillNeed(begin, end);
+      } else if (fd_ != -1) {
+        posix_fadvise(fd_, begin, end - begin, POSIX_FADV_WILLNEED);
+      }
+    }
+#endif  // __linux__
+  }
+
  private:
+  /*!
+   * \brief The record at offset pos of the mapping. The array views the mapping and keeps
+   *  it alive, unless the record was split around occurrences of the magic number and
+   *  has to be reassembled like RecordIOReader does.
+   */
+  void GetMappedRecord(size_t pos, NDArray* out) const {
+    const uint32_t kMagic = dmlc::RecordIOWriter::kMagic;
+    std::string record;
+    bool split = false;
+    while (true) {
+      uint32_t header[2];
+      CHECK_LE(pos + sizeof(header), mapping_->size()) << "Invalid RecordIO File";
+      std::memcpy(header, mapping_->data() + pos, sizeof(header));
+      CHECK_EQ(header[0], kMagic) << "Invalid RecordIO File";
+      const uint32_t cflag = dmlc::RecordIOWriter::DecodeFlag(header[1]);
+      const uint32_t len = dmlc::RecordIOWriter::DecodeLength(header[1]);
+      char* begin = mapping_->data() + pos + sizeof(header);
+      CHECK_LE(pos + sizeof(header) + len, mapping_->size()) << "Invalid RecordIO File";
+      if (cflag == 0U && !split) {
+        std::shared_ptr<MappedFile> mapping = mapping_;
+        *out = NDArray(TBlob(static_cast<void*>(begin), TShape({static_cast<dim_t>(len)}),
+                             cpu::kDevMask, mshadow::kInt8),
+                       0, [mapping]() {});
+        return;
+      }
+      split = true;
+      record.append(begin, len);
+      if (cflag == 0U || cflag == 3U) break;
+      record.append(reinterpret_cast<const char*>(&kMagic), sizeof(kMagic));
+      pos += sizeof(header) + (((len + 3U) >> 2U) << 2U);
+    }
+    *out = NDArray(TShape({static_cast<dim_t>(record.size())}), Context::CPU(), false,
+                   mshadow::kInt8);
+    std::memcpy(out->data().dptr_, record.data(), record.size());
+  }
+
   /*! \brief parameters */
   RecordFileDatasetParam param_;
   /*! \brief indices */
   std::unordered_map<size_t, size_t> idx_;
+  /*! \brief mapping of the record file, with use_mmap */
+  std::shared_ptr<MappedFile> mapping_;
+  /*! \brief end offset of the record starting at each offset, for local files */
+  std::unordered_map<size_t, size_t> record_end_;
+  /*! \brief descriptor of the local record file to read ahead, without use_mmap */
+  int fd_{-1};
 };
 
 MXNET_REGISTER_IO_DATASET(RecordFileDataset)
@@ -125,6 +231,10 @@ struct ImageRecordFileDatasetParam : public dmlc::Parameter<ImageRecordFileDatas
   std::string rec_file;
   std::string idx_file;
   int flag;
+  bool use_mmap;
+  size_t decoded_cache_size;
+  std::string decoded_cache_file;
+  size_t decoded_cache_file_size;
   // declare parameters
   DMLC_DECLARE_PARAMETER(ImageRecordFileDatasetParam) {
       DMLC_DECLARE_FIELD(rec_file)
@@ -133,47 +243,61 @@ struct ImageRecordFileDatasetParam : public dmlc::Parameter<ImageRecordFileDatas
           .describe("The path of the idx file.");
       DMLC_DECLARE_FIELD(flag).set_default(1)
           .describe("If 1, always convert to colored, if 0 always convert to grayscale.");
+      DMLC_DECLARE_FIELD(use_mmap).set_default(false)
+          .describe("Map the local record file in memory and decode the images from the "
+                    "mapping instead of reading and copying each record.");
+      DMLC_DECLARE_FIELD(decoded_cache_size).set_default(0)
+          .describe("Keep up to this many MB of decoded images in memory, so that reading "
+                    "an image again skips its decode. 0 to disable the cache.");
+      DMLC_DECLARE_FIELD(decoded_cache_file).set_default("")
+          .describe("Local file the decoded images spill to once decoded_cache_size is "
+                    "used. The file is memory mapped and removed at once.");
+      DMLC_DECLARE_FIELD(decoded_cache_file_size).set_default(0)
+          .describe("Keep up to this many MB of decoded images in decoded_cache_file.");
   }
 };  // struct ImageRecordFileDatasetParam
 
 DMLC_REGISTER_PARAMETER(ImageRecordFileDatasetParam);
 
 #if MXNET_USE_OPENCV
-template<int n_channels>
-void SwapImageChannels(const cv::Mat &img, NDArray* arr) {
-  int swap_indices[n_channels]; // NOLINT(*)
-  if (n_channels == 1) {
-    swap_indices[0] = 0;
-  } else if (n_channels == 3) {
-    swap_indices[0] = 2;
-    swap_indices[1] = 1;
-    swap_indices[2] = 0;
-  } else if (n_channels == 4) {
-    swap_indices[0] = 2;
-    swap_indices[1] = 1;
-    swap_indices[2] = 0;
-    swap_indices[3] = 3;
-  }
+/*!
+ * \brief Decode an encoded image into a buffer owned by the calling thread, which is
+ *  reused by its next images of the same size and type instead of being reallocated.
+ *  The returned image is overwritten by the next decode of the thread.
+ */
+const cv::Mat& DecodeImage(void* data, size_t size, int flag) {
+  static thread_local cv::Mat decoded;
+  cv::Mat buf(1, size, CV_8U, data);
+#if (CV_MAJOR_VERSION > 2 || (CV_MAJOR_VERSION == 2 && CV_MINOR_VERSION >= 4))
+  cv::imdecode(buf, flag, &decoded);
+#else
+  decoded = cv::imdecode(buf, flag);
+#endif
+  CHECK(!decoded.empty()) << "Decoding failed. Invalid image file.";
+  return decoded;
+}
 
+/*!
+ * \brief Write a decoded BGR(A) image to arr as an HWC RGB(A) uint8 array. The color
+ *  conversion writes into the memory of arr, which is reused if it has the right shape.
+ */
+void CopyImageToRGB(const cv::Mat &img, NDArray* arr) {
+  CHECK_EQ(img.depth(), CV_8U) << "Only 8-bit images are supported";
+  const int n_channels = img.channels();
   TShape arr_shape = TShape({img.rows, img.cols, n_channels});
   if (arr->is_none() || arr->shape() != arr_shape || arr->ctx() != mxnet::Context::CPU(0) ||
       arr->dtype() != mshadow::kUint8 || arr->storage_type() != kDefaultStorage) {
     *arr = NDArray(arr_shape, mxnet::Context::CPU(0), false, mshadow::kUint8);
   }
-  auto ptr = static_cast<uint8_t*>(arr->data().dptr_);
-
-  // swap channels while copying elements into buffer
-  for (int i = 0; i < img.rows; ++i) {
-    const uint8_t* im_data = img.ptr<uint8_t>(i);
-    uint8_t* buffer_data = ptr + i * img.cols * n_channels;
-    for (int j = 0; j < img.cols; ++j) {
-      for (int k = 0; k < n_channels; ++k) {
-        buffer_data[k] = im_data[swap_indices[k]];
-      }
-      im_data += n_channels;
-      buffer_data += n_channels;
-    }
+  cv::Mat dst(img.rows, img.cols, CV_8UC(n_channels), arr->data().dptr_);
+  if (n_channels == 3) {
+    cv::cvtColor(img, dst, CV_BGR2RGB);
+  } else if (n_channels == 4) {
+    cv::cvtColor(img, dst, CV_BGRA2RGBA);
+  } else {
+    img.copyTo(dst);
   }
+  CHECK_EQ(static_cast<void*>(dst.data), arr->data().dptr_);
 }
 #endif
 
@@ -192,12 +316,21 @@ class ImageRecordFileDataset : public Dataset {
     std::vector<std::pair<std::string, std::string> > kwargs_left;
     param_.InitAllowUnknown(kwargs);
     base_ = std::make_shared<RecordFileDataset>(kwargs);
+    if (param_.decoded_cache_size > 0 || param_.decoded_cache_file_size > 0) {
+      decoded_cache_ = std::make_shared<DecodedImageCache>(
+          param_.decoded_cache_size << 20UL, param_.decoded_cache_file,
+          param_.decoded_cache_file_size << 20UL);
+    }
   }
 
   uint64_t GetLen() const override {
     return base_->GetLen();
   }
 
+  void Prefetch(const std::vector<uint64_t>& indices) override {
+    base_->Prefetch(indices);
+  }
+
   bool GetItem(uint64_t idx, std::vector<NDArray>* ret) override {
     CHECK_LT(idx, GetLen());
     std::vector<NDArray> raw;
@@ -230,16 +363,13 @@ class ImageRecordFileDataset : public Dataset {
     ret->resize(2);
     (*ret)[1] = label;
 #if MXNET_USE_OPENCV
-    cv::Mat buf(1, size, CV_8U, s);
-    cv::Mat res = cv::imdecode(buf, param_.flag);
-    CHECK(!res.empty()) << "Decoding failed. Invalid image file.";
-    const int n_channels = res.channels();
-    if (n_channels == 1) {
-      SwapImageChannels<1>(res, &(ret->at(0)));
-    } else if (n_channels == 3) {
-      SwapImageChannels<3>(res, &(ret->at(0)));
-    } else if (n_channels == 4) {
-      SwapImageChannels<4>(res, &(ret->at(0)));
+    cv::Mat cached;
+    if (decoded_cache_ != nullptr && decoded_cache_->Get(idx, &cached)) {
+      CopyImageToRGB(cached, &(ret->at(0)));
+    } else {
+      const cv::Mat& res = DecodeImage(s, size, param_.flag);
+      if (decoded_cache_ != nullptr) decoded_cache_->Put(idx, res);
+      CopyImageToRGB(res, &(ret->at(0)));
     }
     return true;
 #else
@@ -253,6 +383,8 @@ class ImageRecordFileDataset : public Dataset {
   ImageRecordFileDatasetParam param_;
   /*! \brief base recordIO reader */
   std::shared_ptr<RecordFileDataset> base_;
+  /*! \brief decoded images, copied into the returned arrays */
+  std::shared_ptr<DecodedImageCache> decoded_cache_;
 };
 
 MXNET_REGISTER_IO_DATASET(ImageRecordFileDataset)
@@ -301,17 +433,16 @@ class ImageSequenceDataset final : public Dataset {
 #if MXNET_USE_OPENCV
     CHECK_LT(idx, img_list_.size())
       << "GetItem index: " << idx << " out of bound: " << img_list_.size();
-    cv::Mat res = cv::imread(img_list_[idx], param_.flag);
-    CHECK(!res.empty()) << "Decoding failed. Invalid image file.";
-    const int n_channels = res.channels();
+    // read the file into a buffer of the thread, reused by its next images
+    static thread_local std::vector<char> encoded;
+    std::ifstream file(img_list_[idx], std::ios::binary | std::ios::ate);
+    CHECK(file.good()) << "Cannot open image file " << img_list_[idx];
+    encoded.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    CHECK(file.read(encoded.data(), encoded.size()))
+      << "Cannot read image file " << img_list_[idx];
     ret->resize(1);
-    if (n_channels == 1) {
-      SwapImageChannels<1>(res, &(ret->at(0)));
-    } else if (n_channels == 3) {
-      SwapImageChannels<3>(res, &(ret->at(0)));
-    } else if (n_channels == 4) {
-      SwapImageChannels<4>(res, &(ret->at(0)));
-    }
+    CopyImageToRGB(DecodeImage(encoded.data(), encoded.size(), param_.flag), &(ret->at(0)));
     return true;
 #else
   LOG(FATAL) << "Opencv is needed for image decoding.";
@@ -333,6 +464,94 @@ MXNET_REGISTER_IO_DATASET(ImageSequenceDataset)
      return new ImageSequenceDataset(kwargs);
 });
 
+struct ColumnarDatasetParam : public dmlc::Parameter<ColumnarDatasetParam> {
+  /*! \brief path of the columnar file */
+  std::string file;
+  /*! \brief names of the columns to read */
+  std::string columns;
+  // declare parameters
+  DMLC_DECLARE_PARAMETER(ColumnarDatasetParam) {
+      DMLC_DECLARE_FIELD(file)
+          .describe("The path of the local columnar file.");
+      DMLC_DECLARE_FIELD(columns).set_default("")
+          .describe("The comma separated names of the columns of each item, "
+                    "all the columns if empty.");
+  }
+};  // struct ColumnarDatasetParam
+
+DMLC_REGISTER_PARAMETER(ColumnarDatasetParam);
+
+/*!
+ * \brief Dataset of the rows of a memory mapped columnar file. The items of dense columns
+ *  view the mapping, the items of CSR columns are 1 x num_col CSR arrays.
+ */
+class ColumnarDataset final : public Dataset {
+ public:
+  explicit ColumnarDataset(const std::vector<std::pair<std::string, std::string> >& kwargs) {
+    param_.InitAllowUnknown(kwargs);
+    file_ = std::make_shared<ColumnarFile>(param_.file);
+    columns_ = file_->Project(param_.columns);
+  }
+
+  uint64_t GetLen() const override {
+    return file_->NumRows();
+  }
+
+  bool GetItem(uint64_t idx, std::vector<NDArray>* ret) override {
+    const RowGroup& group = file_->Groups()[file_->GroupOf(idx)];
+    const uint64_t row = idx - group.begin;
+    ret->resize(columns_.size());
+    for (size_t i = 0; i < columns_.size(); ++i) {
+      const ColumnInfo& column = file_->Columns()[columns_[i]];
+      const ColumnChunk& chunk = group.chunks[columns_[i]];
+      auto& out = (*ret)[i];
+      if (column.storage == kDenseColumn) {
+        std::shared_ptr<MappedFile> mapping = file_->Mapping();
+        const size_t row_bytes = file_->RowBytes(columns_[i]);
+        void* dptr = const_cast<char*>(chunk.data) + row * row_bytes;
+        out = NDArray(TBlob(dptr, column.shape, cpu::kDevMask, column.dtype),
+                      0, [mapping]() {});
+      } else {
+        const int64_t begin = chunk.indptr[row], end = chunk.indptr[row + 1];
+        const size_t elem_size = mshadow::mshadow_sizeof(column.dtype);
+        out = NDArray(kCSRStorage, TShape({1, column.shape[0]}), Context::CPU(), false,
+                      column.dtype);
+        out.CheckAndAllocAuxData(csr::kIndPtr, mshadow::Shape1(2));
+        out.CheckAndAllocAuxData(csr::kIdx, mshadow::Shape1(end - begin));
+        out.CheckAndAllocData(mshadow::Shape1(end - begin));
+        int64_t* indptr = out.aux_data(csr::kIndPtr).dptr<int64_t>();
+        indptr[0] = 0;
+        indptr[1] = end - begin;
+        std::memcpy(out.aux_data(csr::kIdx).dptr_, chunk.indices + begin,
+                    (end - begin) * sizeof(int64_t));
+        std::memcpy(out.data().dptr_, chunk.data + begin * elem_size, (end - begin) * elem_size);
+      }
+    }
+    return true;
+  }
+
+  void Prefetch(const std::vector<uint64_t>& indices) override {
+    for (const uint64_t i : indices) {
+      if (i < file_->NumRows()) file_->WillNeed(columns_, i, i + 1);
+    }
+  }
+
+ private:
+  /*! \brief parameters */
+  ColumnarDatasetParam param_;
+  /*! \brief the columnar file */
+  std::shared_ptr<ColumnarFile> file_;
+  /*! \brief indices of the columns of each item */
+  std::vector<size_t> columns_;
+};
+
+MXNET_REGISTER_IO_DATASET(ColumnarDataset)
+  .describe("Columnar File Dataset")
+  .add_arguments(ColumnarDatasetParam::__FIELDS__())
+  .set_body([](const std::vector<std::pair<std::string, std::string> >& kwargs) {
+     return new ColumnarDataset(kwargs);
+});
+
 struct NDArrayDatasetParam : public dmlc::Parameter<NDArrayDatasetParam> {
   /*! \brief the source ndarray */
   std::intptr_t arr;
@@ -447,6 +666,10 @@ class GroupDataset final : public Dataset {
     return true;
   }
 
+  void Prefetch(const std::vector<uint64_t>& indices) override {
+    for (auto child : childs_) child->Prefetch(indices);
+  }
+
  private:
   /*! \brief parameters */
   GroupDatasetParam param_;
@@ -499,6 +722,27 @@ class IndexedDataset final : public Dataset {
     return base_data_->GetItem(new_idx, ret);
   }
 
+  bool GetItems(const std::vector<uint64_t>& indices, std::vector<NDArray>* rets) override {
+    std::vector<uint64_t> base_indices(indices.size());
+    for (size_t i = 0; i < indices.size(); ++i) {
+      CHECK_GT(param_.indices.ndim(), indices[i]) << "IndexError: " << indices[i]
+        << " from total: " << param_.indices.ndim();
+      base_indices[i] = param_.indices[indices[i]];
+      CHECK_GT(base_data_->GetLen(), base_indices[i]) << "IndexError: " << base_indices[i]
+        << " from original dataset with size: " << base_data_->GetLen();
+    }
+    return base_data_->GetItems(base_indices, rets);
+  }
+
+  void Prefetch(const std::vector<uint64_t>& indices) override {
+    std::vector<uint64_t> base_indices;
+    base_indices.reserve(indices.size());
+    for (const uint64_t idx : indices) {
+      if (idx < param_.indices.ndim()) base_indices.push_back(param_.indices[idx]);
+    }
+    base_data_->Prefetch(base_indices);
+  }
+
  private:
   /*! \brief parameters */
   IndexedDatasetParam param_;
@@ -603,6 +847,10 @@ class LazyTransformDataset final : public Dataset {
     return base_data_->GetLen();
   }
 
+  void Prefetch(const std::vector<uint64_t>& indices) override {
+    base_data_->Prefetch(indices);
+  }
+
   bool GetItem(uint64_t idx, std::vector<NDArray>* outputs) override {
     std::vector<NDArray> inputs;
     if (!base_data_->GetItem(idx, &inputs)) return false;
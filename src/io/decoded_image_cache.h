@@ -0,0 +1,183 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file decoded_image_cache.h
+ * \brief cache of the decoded images, so that the epochs after the first skip the decode
+ *
+ *  The images are kept in memory up to a size, then in a local file mapped in memory up
+ *  to a second size. Images are never evicted: once both are full, the next images are
+ *  decoded every epoch.
+ */
+#ifndef MXNET_IO_DECODED_IMAGE_CACHE_H_
+#define MXNET_IO_DECODED_IMAGE_CACHE_H_
+
+#include <dmlc/logging.h>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif  // _WIN32
+
+#if MXNET_USE_OPENCV
+#include <opencv2/opencv.hpp>
+#endif  // MXNET_USE_OPENCV
+
+namespace mxnet {
+namespace io {
+
+/*! \brief thread safe cache of uint8 images in height, width, channel layout */
+class DecodedImageCache {
+ public:
+  /*!
+   * \brief constructor
+   * \param memory_size bytes of the images kept in memory
+   * \param file path of the file the images spill to, none if empty
+   * \param file_size bytes of the images kept in the file
+   */
+  DecodedImageCache(size_t memory_size, const std::string &file, size_t file_size)
+      : memory_size_(memory_size) {
+    if (file.empty() || file_size == 0) return;
+#ifndef _WIN32
+    int fd = open(file.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    CHECK_NE(fd, -1) << "Failed to open " << file << ": " << strerror(errno);
+    CHECK_EQ(ftruncate(fd, file_size), 0)
+        << "Failed to resize " << file << ": " << strerror(errno);
+    void *ptr = mmap(nullptr, file_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    CHECK_NE(ptr, MAP_FAILED) << "Failed to map " << file << ": " << strerror(errno);
+    close(fd);
+    // the mapping keeps the pages, the file does not outlive the process
+    unlink(file.c_str());
+    file_data_ = static_cast<uint8_t *>(ptr);
+    file_size_ = file_size;
+#else
+    LOG(FATAL) << "Spilling decoded images to a file is not supported on Windows";
+#endif  // _WIN32
+  }
+
+  ~DecodedImageCache() {
+#ifndef _WIN32
+    if (file_data_ != nullptr) munmap(file_data_, file_size_);
+#endif  // _WIN32
+  }
+
+  /*!
+   * \brief find an image
+   * \param key key of the image
+   * \param rows, cols, channels shape of the image
+   * \return pixels of the image, valid as long as the cache, nullptr if not cached
+   */
+  const uint8_t *Get(uint64_t key, int *rows, int *cols, int *channels) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(key);
+    if (it == entries_.end()) return nullptr;
+    *rows = it->second.rows;
+    *cols = it->second.cols;
+    *channels = it->second.channels;
+    return it->second.data;
+  }
+
+  /*!
+   * \brief copy an image into the cache, if there is space left
+   * \return whether the image is cached
+   */
+  bool Put(uint64_t key, int rows, int cols, int channels, const uint8_t *data) {
+    const size_t size = static_cast<size_t>(rows) * cols * channels;
+    uint8_t *dst = nullptr;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (entries_.count(key) != 0 || pending_.count(key) != 0) return true;
+      if (memory_used_ + size <= memory_size_) {
+        memory_.emplace_back(new uint8_t[size]);
+        dst = memory_.back().get();
+        memory_used_ += size;
+      } else if (file_used_ + size <= file_size_) {
+        dst = file_data_ + file_used_;
+        file_used_ += size;
+      } else {
+        return false;
+      }
+      // published only once copied, other threads meanwhile decode the image again
+      pending_.emplace(key, Entry{rows, cols, channels, dst});
+    }
+    std::memcpy(dst, data, size);
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = pending_.find(key);
+    entries_.emplace(key, it->second);
+    pending_.erase(it);
+    return true;
+  }
+
+  /*! \return number of bytes cached in memory and in the file */
+  size_t Size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return memory_used_ + file_used_;
+  }
+
+#if MXNET_USE_OPENCV
+  /*!
+   * \brief find a decoded image
+   * \param view read only view of the cached pixels
+   */
+  bool Get(uint64_t key, cv::Mat *view) const {
+    int rows, cols, channels;
+    const uint8_t *data = Get(key, &rows, &cols, &channels);
+    if (data == nullptr) return false;
+    *view = cv::Mat(rows, cols, CV_8UC(channels), const_cast<uint8_t *>(data));
+    return true;
+  }
+
+  /*! \brief copy a decoded uint8 image into the cache, if there is space left */
+  bool Put(uint64_t key, const cv::Mat &img) {
+    if (img.depth() != CV_8U) return false;
+    const cv::Mat dense = img.isContinuous() ? img : img.clone();
+    return Put(key, dense.rows, dense.cols, dense.channels(), dense.ptr<uint8_t>());
+  }
+#endif  // MXNET_USE_OPENCV
+
+ private:
+  /*! \brief cached image */
+  struct Entry {
+    int rows, cols, channels;
+    uint8_t *data;
+  };
+
+  /*! \brief protects the members below */
+  mutable std::mutex mutex_;
+  /*! \brief cached images, and images being copied */
+  std::unordered_map<uint64_t, Entry> entries_, pending_;
+  /*! \brief images kept in memory */
+  std::vector<std::unique_ptr<uint8_t[]>> memory_;
+  size_t memory_size_, memory_used_{0};
+  /*! \brief mapping of the spill file */
+  uint8_t *file_data_{nullptr};
+  size_t file_size_{0}, file_used_{0};
+};
+
+}  // namespace io
+}  // namespace mxnet
+#endif  // MXNET_IO_DECODED_IMAGE_CACHE_H_
@@ -536,6 +536,142 @@ class DefaultImageAugmenter : public ImageAugmenter {
     return res;
   }
 
+  bool MinDecodeSize(int width, int height, int *min_width, int *min_height) override {
+    // every later step works on the image resized to the resize option
+    if (param_.resize == -1) return false;
+    if (height > width) {
+      *min_width = param_.resize;
+      *min_height = 0;
+    } else {
+      *min_width = 0;
+      *min_height = param_.resize;
+    }
+    return true;
+  }
+
+  bool PlanCrop(int width, int height, common::RANDOM_ENGINE *prnd, float crop[4]) override {
+    using mshadow::index_t;
+    float max_aspect_ratio = 1 + param_.max_aspect_ratio;
+    float min_aspect_ratio = 1 - param_.max_aspect_ratio;
+    if (param_.min_aspect_ratio.has_value()) {
+      max_aspect_ratio = param_.max_aspect_ratio;
+      min_aspect_ratio = param_.min_aspect_ratio.value();
+    }
+    // the affine transformation, padding and color augmentations of Process
+    if (param_.max_rotate_angle > 0 || param_.max_shear_ratio > 0.0f
+        || param_.rotate > 0 || rotate_list_.size() > 0
+        || param_.max_random_scale != 1.0f || param_.min_random_scale != 1.0
+        || (!param_.random_resized_crop && (min_aspect_ratio != 1.0f || max_aspect_ratio != 1.0f))
+        || param_.max_img_size != 1e10f || param_.min_img_size != 0.0f
+        || param_.pad > 0
+        || param_.brightness > 0.0f || param_.contrast > 0.0f || param_.saturation > 0.0f
+        || param_.random_h != 0 || param_.random_s != 0 || param_.random_l != 0
+        || param_.pca_noise > 0.0f) {
+      return false;
+    }
+    // mirrors Process, tracking the size of the image and its scale to the source
+    float cols = width, rows = height;
+    if (param_.resize != -1) {
+      if (height > width) {
+        rows = param_.resize * height / width;
+        cols = param_.resize;
+      } else {
+        rows = param_.resize;
+        cols = param_.resize * width / height;
+      }
+      GetInterMethod(param_.inter_method, width, height, cols, rows, prnd);
+    }
+    float scale_x = cols / width, scale_y = rows / height;
+    bool is_cropped = false;
+    if (param_.random_resized_crop) {
+      if (param_.max_random_area != 1.0f || param_.min_random_area != 1.0f
+          || max_aspect_ratio != 1.0f || min_aspect_ratio != 1.0f) {
+        std::uniform_real_distribution<float> rand_uniform_area(param_.min_random_area,
+                                                                param_.max_random_area);
+        std::uniform_real_distribution<float> rand_uniform_ratio(min_aspect_ratio,
+                                                                 max_aspect_ratio);
+        std::uniform_real_distribution<float> rand_uniform(0, 1);
+        const index_t res_rows = rows, res_cols = cols;
+        for (int i = 0; i < 10; ++i) {
+          float target_area = res_rows * res_cols * rand_uniform_area(*prnd);
+          float ratio = rand_uniform_ratio(*prnd);
+          int y_area = std::round(std::sqrt(target_area / ratio));
+          int x_area = std::round(std::sqrt(target_area * ratio));
+          if (rand_uniform(*prnd) > 0.5) std::swap(x_area, y_area);
+          if (y_area <= res_rows && x_area <= res_cols) {
+            crop[1] = std::uniform_int_distribution<index_t>(0, res_rows - y_area)(*prnd);
+            crop[0] = std::uniform_int_distribution<index_t>(0, res_cols - x_area)(*prnd);
+            crop[2] = x_area;
+            crop[3] = y_area;
+            GetInterMethod(param_.inter_method, x_area, y_area, param_.data_shape[2],
+                           param_.data_shape[1], prnd);
+            is_cropped = true;
+            break;
+          }
+        }
+      }
+    } else if (param_.max_crop_size != -1 || param_.min_crop_size != -1) {
+      CHECK(cols >= param_.max_crop_size && rows >= param_.max_crop_size &&
+            param_.max_crop_size >= param_.min_crop_size)
+          << "input image size smaller than max_crop_size";
+      index_t rand_crop_size =
+          std::uniform_int_distribution<index_t>(param_.min_crop_size, param_.max_crop_size)(*prnd);
+      index_t y = static_cast<index_t>(rows) - rand_crop_size;
+      index_t x = static_cast<index_t>(cols) - rand_crop_size;
+      if (param_.rand_crop != 0) {
+        y = std::uniform_int_distribution<index_t>(0, y)(*prnd);
+        x = std::uniform_int_distribution<index_t>(0, x)(*prnd);
+      } else {
+        y /= 2; x /= 2;
+      }
+      crop[0] = x;
+      crop[1] = y;
+      crop[2] = crop[3] = rand_crop_size;
+      GetInterMethod(param_.inter_method, rand_crop_size, rand_crop_size,
+                     param_.data_shape[2], param_.data_shape[1], prnd);
+      is_cropped = true;
+    }
+    if (!is_cropped) {
+      GetInterMethod(param_.inter_method, cols, rows, param_.data_shape[2],
+                     param_.data_shape[1], prnd);
+      // upscale images smaller than the output before the center crop
+      if (rows < param_.data_shape[1]) {
+        const float new_cols = static_cast<index_t>(param_.data_shape[1] / rows * cols);
+        scale_x *= new_cols / cols;
+        scale_y *= param_.data_shape[1] / rows;
+        cols = new_cols;
+        rows = param_.data_shape[1];
+      }
+      if (cols < param_.data_shape[2]) {
+        const float new_rows = static_cast<index_t>(param_.data_shape[2] / cols * rows);
+        scale_x *= param_.data_shape[2] / cols;
+        scale_y *= new_rows / rows;
+        cols = param_.data_shape[2];
+        rows = new_rows;
+      }
+      CHECK(static_cast<index_t>(rows) >= param_.data_shape[1]
+            && static_cast<index_t>(cols) >= param_.data_shape[2])
+          << "input image size smaller than input shape";
+      index_t y = static_cast<index_t>(rows) - param_.data_shape[1];
+      index_t x = static_cast<index_t>(cols) - param_.data_shape[2];
+      if (param_.rand_crop != 0) {
+        y = std::uniform_int_distribution<index_t>(0, y)(*prnd);
+        x = std::uniform_int_distribution<index_t>(0, x)(*prnd);
+      } else {
+        y /= 2; x /= 2;
+      }
+      crop[0] = x;
+      crop[1] = y;
+      crop[2] = param_.data_shape[2];
+      crop[3] = param_.data_shape[1];
+    }
+    // back to the coordinates of the source image
+    crop[0] /= scale_x;
+    crop[1] /= scale_y;
+    crop[2] /= scale_x;
+    crop[3] /= scale_y;
+    return true;
+  }
 
  private:
   // temporal space
@@ -59,6 +59,31 @@ class ImageAugmenter {
    */
   virtual cv::Mat Process(const cv::Mat &src, std::vector<float> *label,
                           common::RANDOM_ENGINE *prnd) = 0;
+  /*!
+   * \brief plan the augmentation of an image without processing its pixels, when it
+   *   amounts to resizing a region of the image to the output shape.
+   * \param width width of the source image
+   * \param height height of the source image
+   * \param prnd pointer to random number generator.
+   * \param crop the region of the source image, as x, y, width and height
+   * \return false if the augmentation does more than cropping, resizing and mirroring.
+   */
+  virtual bool PlanCrop(int width, int height, common::RANDOM_ENGINE *prnd, float crop[4]) {
+    return false;
+  }
+  /*!
+   * \brief the smallest size at which the image can be decoded, keeping its aspect ratio,
+   *   with the augmentation still only shrinking it, so that JPEG images can be decoded
+   *   at a reduced resolution.
+   * \param width width of the source image
+   * \param height height of the source image
+   * \param min_width the smallest width of the decoded image
+   * \param min_height the smallest height of the decoded image
+   * \return false if the output depends on the resolution of the source image.
+   */
+  virtual bool MinDecodeSize(int width, int height, int *min_width, int *min_height) {
+    return false;
+  }
   // virtual destructor
   virtual ~ImageAugmenter() {}
   /*!
@@ -0,0 +1,267 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file image_decode_gpu.cu
+ * \brief Batched JPEG decoding with nvJPEG and GPU crop, resize, mirror and normalization
+ */
+#include "./image_decode_gpu.h"
+
+#if MXNET_USE_CUDA && MXNET_USE_NVJPEG
+
+#include <nvjpeg.h>
+#include <algorithm>
+#include "../common/cuda/utils.h"
+
+/*!
+ * \brief Protected nvJPEG call.
+ * \param func Expression to call.
+ */
+#define NVJPEG_CALL(func)                                       \
+  {                                                             \
+    nvjpegStatus_t e = (func);                                  \
+    CHECK_EQ(e, NVJPEG_STATUS_SUCCESS) << "nvJPEG: error " << e; \
+  }
+
+namespace mxnet {
+namespace io {
+
+namespace {
+
+/*! \brief decoded image and the transform sampling it into the output */
+struct ImageParam {
+  size_t offset;
+  int width;
+  int height;
+  float crop_x;
+  float crop_y;
+  float scale_x;
+  float scale_y;
+  int mirror;
+  float contrast;
+  float illumination;
+};
+
+template<typename DType>
+__device__ __forceinline__ DType Normalize(float v, int c, const GPUNormalizeParam& norm,
+                                           const ImageParam& p) {
+  return static_cast<DType>((v - norm.mean[c]) * p.contrast * norm.inv_std[c] +
+                            p.illumination * norm.inv_std[c]);
+}
+
+template<>
+__device__ __forceinline__ uint8_t Normalize<uint8_t>(float v, int c,
+                                                      const GPUNormalizeParam& norm,
+                                                      const ImageParam& p) {
+  return static_cast<uint8_t>(fminf(fmaxf(roundf(v), 0.0f), 255.0f));
+}
+
+template<>
+__device__ __forceinline__ int8_t Normalize<int8_t>(float v, int c,
+                                                    const GPUNormalizeParam& norm,
+                                                    const ImageParam& p) {
+  return static_cast<int8_t>(fminf(fmaxf(roundf(v) - roundf(norm.mean[c]), -128.0f), 127.0f));
+}
+
+/*!
+ * \brief Bilinear sampling of the crop of each decoded image into the (C, H, W) output.
+ *  blockIdx.y is the image in the batch.
+ */
+template<typename DType, int channels>
+__global__ void CropResizeNormalizeKernel(const uint8_t* pixels, const ImageParam* params,
+                                          const GPUNormalizeParam norm,
+                                          int out_height, int out_width, DType* out) {
+  const ImageParam p = params[blockIdx.y];
+  const int plane = out_height * out_width;
+  const int i = blockIdx.x * blockDim.x + threadIdx.x;
+  if (i >= plane) return;
+  const int oy = i / out_width;
+  int ox = i % out_width;
+  if (p.mirror) ox = out_width - 1 - ox;
+  const float sx = fminf(fmaxf(p.crop_x + (ox + 0.5f) * p.scale_x - 0.5f, 0.0f),
+                         p.width - 1.0f);
+  const float sy = fminf(fmaxf(p.crop_y + (oy + 0.5f) * p.scale_y - 0.5f, 0.0f),
+                         p.height - 1.0f);
+  const int x0 = static_cast<int>(sx);
+  const int y0 = static_cast<int>(sy);
+  const int x1 = min(x0 + 1, p.width - 1);
+  const int y1 = min(y0 + 1, p.height - 1);
+  const float dx = sx - x0;
+  const float dy = sy - y0;
+  const uint8_t* img = pixels + p.offset;
+  const int row = p.width * channels;
+  DType* dst = out + static_cast<size_t>(blockIdx.y) * channels * plane + i;
+  #pragma unroll
+  for (int c = 0; c < channels; ++c) {
+    const float top = img[y0 * row + x0 * channels + c] * (1 - dx) +
+                      img[y0 * row + x1 * channels + c] * dx;
+    const float bottom = img[y1 * row + x0 * channels + c] * (1 - dx) +
+                         img[y1 * row + x1 * channels + c] * dx;
+    dst[c * plane] = Normalize<DType>(top * (1 - dy) + bottom * dy, c, norm, p);
+  }
+}
+
+}  // namespace
+
+struct NvJpegBatchDecoder::Impl {
+  nvjpegHandle_t handle;
+  nvjpegJpegState_t state;
+  cudaStream_t stream;
+};
+
+NvJpegBatchDecoder::NvJpegBatchDecoder(int dev_id, int channels)
+    : dev_id_(dev_id), channels_(channels), impl_(new Impl()) {
+  CHECK(channels == 1 || channels == 3)
+      << "GPU decoding supports 1 or 3 channels, got " << channels;
+  common::cuda::DeviceStore device_store(dev_id_);
+  NVJPEG_CALL(nvjpegCreateSimple(&impl_->handle));
+  NVJPEG_CALL(nvjpegJpegStateCreate(impl_->handle, &impl_->state));
+  CUDA_CALL(cudaStreamCreateWithFlags(&impl_->stream, cudaStreamNonBlocking));
+}
+
+NvJpegBatchDecoder::~NvJpegBatchDecoder() {
+  common::cuda::DeviceStore device_store(dev_id_);
+  if (pixels_.dptr != nullptr) Storage::Get()->Free(pixels_);
+  if (params_.dptr != nullptr) Storage::Get()->Free(params_);
+  CUDA_CALL(cudaStreamDestroy(impl_->stream));
+  NVJPEG_CALL(nvjpegJpegStateDestroy(impl_->state));
+  NVJPEG_CALL(nvjpegDestroy(impl_->handle));
+  delete impl_;
+}
+
+bool NvJpegBatchDecoder::GetImageInfo(const unsigned char* data, size_t size,
+                                      int* width, int* height) {
+  int components;
+  nvjpegChromaSubsampling_t subsampling;
+  int widths[NVJPEG_MAX_COMPONENT];
+  int heights[NVJPEG_MAX_COMPONENT];
+  if (nvjpegGetImageInfo(impl_->handle, data, size, &components, &subsampling,
+                         widths, heights) != NVJPEG_STATUS_SUCCESS ||
+      subsampling == NVJPEG_CSS_UNKNOWN) {
+    return false;
+  }
+  *width = widths[0];
+  *height = heights[0];
+  return true;
+}
+
+void* NvJpegBatchDecoder::Reserve(Storage::Handle* handle, size_t size) {
+  if (handle->dptr == nullptr || handle->size < size) {
+    if (handle->dptr != nullptr) {
+      // the previous batch may still be read by the stream
+      CUDA_CALL(cudaStreamSynchronize(impl_->stream));
+      Storage::Get()->Free(*handle);
+    }
+    *handle = Storage::Get()->Alloc(size, Context::GPU(dev_id_));
+  }
+  return handle->dptr;
+}
+
+void NvJpegBatchDecoder::Run(const std::vector<GPUImageJob>& jobs,
+                             const GPUNormalizeParam& normalize,
+                             int out_height, int out_width, int dtype, void* out,
+                             const std::vector<float>& labels, float* label_out) {
+  common::cuda::DeviceStore device_store(dev_id_);
+  cudaStream_t stream = impl_->stream;
+  std::vector<ImageParam> params(jobs.size());
+  size_t total = 0;
+  for (size_t i = 0; i < jobs.size(); ++i) {
+    const GPUImageJob& job = jobs[i];
+    params[i].offset = total;
+    params[i].width = job.width;
+    params[i].height = job.height;
+    params[i].crop_x = job.crop[0];
+    params[i].crop_y = job.crop[1];
+    params[i].scale_x = job.crop[2] / out_width;
+    params[i].scale_y = job.crop[3] / out_height;
+    params[i].mirror = job.mirror;
+    params[i].contrast = job.contrast;
+    params[i].illumination = job.illumination;
+    // keep every image 16-byte aligned
+    total += (static_cast<size_t>(job.width) * job.height * channels_ + 15) / 16 * 16;
+  }
+  uint8_t* pixels = static_cast<uint8_t*>(Reserve(&pixels_, std::max<size_t>(total, 1)));
+  ImageParam* dev_params = static_cast<ImageParam*>(
+      Reserve(&params_, std::max<size_t>(params.size(), 1) * sizeof(ImageParam)));
+
+  std::vector<const unsigned char*> jpeg_data;
+  std::vector<size_t> jpeg_sizes;
+  std::vector<nvjpegImage_t> jpeg_out;
+  for (size_t i = 0; i < jobs.size(); ++i) {
+    const GPUImageJob& job = jobs[i];
+    const size_t bytes = static_cast<size_t>(job.width) * job.height * channels_;
+    if (!job.host_pixels.empty()) {
+      CHECK_EQ(job.host_pixels.size(), bytes);
+      CUDA_CALL(cudaMemcpyAsync(pixels + params[i].offset, job.host_pixels.data(), bytes,
+                                cudaMemcpyHostToDevice, stream));
+      continue;
+    }
+    nvjpegImage_t image = {};
+    image.channel[0] = pixels + params[i].offset;
+    image.pitch[0] = static_cast<size_t>(job.width) * channels_;
+    jpeg_data.push_back(job.data);
+    jpeg_sizes.push_back(job.size);
+    jpeg_out.push_back(image);
+  }
+  if (!jpeg_data.empty()) {
+    const nvjpegOutputFormat_t format = channels_ == 3 ? NVJPEG_OUTPUT_RGBI : NVJPEG_OUTPUT_Y;
+    NVJPEG_CALL(nvjpegDecodeBatchedInitialize(impl_->handle, impl_->state,
+                                              static_cast<int>(jpeg_data.size()), 1, format));
+    NVJPEG_CALL(nvjpegDecodeBatched(impl_->handle, impl_->state, jpeg_data.data(),
+                                    jpeg_sizes.data(), jpeg_out.data(), stream));
+  }
+  CUDA_CALL(cudaMemcpyAsync(dev_params, params.data(), params.size() * sizeof(ImageParam),
+                            cudaMemcpyHostToDevice, stream));
+
+  const int threads = 256;
+  dim3 blocks((out_height * out_width + threads - 1) / threads, jobs.size());
+  switch (dtype) {
+#define MXNET_LAUNCH_CROP_RESIZE(DType)                                                     \
+    if (channels_ == 3) {                                                                    \
+      CropResizeNormalizeKernel<DType, 3><<<blocks, threads, 0, stream>>>(                  \
+          pixels, dev_params, normalize, out_height, out_width, static_cast<DType*>(out));  \
+    } else {                                                                                 \
+      CropResizeNormalizeKernel<DType, 1><<<blocks, threads, 0, stream>>>(                  \
+          pixels, dev_params, normalize, out_height, out_width, static_cast<DType*>(out));  \
+    }
+   case mshadow::kFloat32:
+    MXNET_LAUNCH_CROP_RESIZE(float);
+    break;
+   case mshadow::kUint8:
+    MXNET_LAUNCH_CROP_RESIZE(uint8_t);
+    break;
+   case mshadow::kInt8:
+    MXNET_LAUNCH_CROP_RESIZE(int8_t);
+    break;
+#undef MXNET_LAUNCH_CROP_RESIZE
+   default:
+    LOG(FATAL) << "GPU decoding does not support output type " << dtype;
+  }
+  MSHADOW_CUDA_POST_KERNEL_CHECK(CropResizeNormalizeKernel);
+  if (!labels.empty()) {
+    CUDA_CALL(cudaMemcpyAsync(label_out, labels.data(), labels.size() * sizeof(float),
+                              cudaMemcpyHostToDevice, stream));
+  }
+  CUDA_CALL(cudaStreamSynchronize(stream));
+}
+
+}  // namespace io
+}  // namespace mxnet
+
+#endif  // MXNET_USE_CUDA && MXNET_USE_NVJPEG
@@ -0,0 +1,103 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file image_decode_gpu.h
+ * \brief Batched JPEG decoding with nvJPEG, followed by crop, resize, mirror and
+ *        normalization kernels writing the batch directly in GPU memory
+ */
+#ifndef MXNET_IO_IMAGE_DECODE_GPU_H_
+#define MXNET_IO_IMAGE_DECODE_GPU_H_
+
+#include <mxnet/base.h>
+#include <mxnet/storage.h>
+#include <cstdint>
+#include <vector>
+
+#if MXNET_USE_CUDA && MXNET_USE_NVJPEG
+
+namespace mxnet {
+namespace io {
+
+/*! \brief one image of a batch decoded on the GPU */
+struct GPUImageJob {
+  /*! \brief encoded image */
+  const unsigned char* data{nullptr};
+  size_t size{0};
+  /*! \brief size of the decoded image */
+  int width{0};
+  int height{0};
+  /*!
+   * \brief image decoded on the CPU, interleaved RGB or gray, when it is not a
+   *  JPEG that nvJPEG can decode, e.g. a PNG; empty otherwise
+   */
+  std::vector<uint8_t> host_pixels;
+  /*! \brief region of the decoded image resized to the output, x, y, width, height */
+  float crop[4]{0, 0, 0, 0};
+  /*! \brief whether to mirror the output horizontally */
+  bool mirror{false};
+  /*! \brief per image scaling of the normalized values, see ImageNormalizeParam */
+  float contrast{1.0f};
+  float illumination{0.0f};
+};
+
+/*! \brief per channel normalization of the output, out = (in - mean) * contrast / std */
+struct GPUNormalizeParam {
+  float mean[3]{0, 0, 0};
+  float inv_std[3]{1, 1, 1};
+};
+
+class NvJpegBatchDecoder {
+ public:
+  /*!
+   * \param dev_id GPU writing the batches
+   * \param channels 3 for RGB output, 1 for gray
+   */
+  NvJpegBatchDecoder(int dev_id, int channels);
+  ~NvJpegBatchDecoder();
+
+  /*! \brief read the size of a JPEG from its header, false if nvJPEG cannot decode it */
+  bool GetImageInfo(const unsigned char* data, size_t size, int* width, int* height);
+
+  /*!
+   * \brief decode the images and write them resized to (channels, out_height, out_width)
+   *  at consecutive positions of out, of type dtype (float32, uint8 or int8), and copy
+   *  the labels to label_out. Returns once the batch is written.
+   */
+  void Run(const std::vector<GPUImageJob>& jobs, const GPUNormalizeParam& normalize,
+           int out_height, int out_width, int dtype, void* out,
+           const std::vector<float>& labels, float* label_out);
+
+ private:
+  /*! \brief device buffer of at least size bytes */
+  void* Reserve(Storage::Handle* handle, size_t size);
+
+  int dev_id_;
+  int channels_;
+  struct Impl;
+  Impl* impl_;
+  Storage::Handle pixels_{};
+  Storage::Handle params_{};
+};
+
+}  // namespace io
+}  // namespace mxnet
+
+#endif  // MXNET_USE_CUDA && MXNET_USE_NVJPEG
+#endif  // MXNET_IO_IMAGE_DECODE_GPU_H_
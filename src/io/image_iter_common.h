@@ -133,8 +133,24 @@ struct ImageRecParserParam : public dmlc::Parameter<ImageRecParserParam> {
   size_t shuffle_chunk_size;
   /*! \brief the seed for chunk shuffling */
   int shuffle_chunk_seed;
+  /*! \brief number of records of the shuffle buffer */
+  size_t shuffle_buffer_size;
+  /*! \brief number of sub-partitions read concurrently to fill the shuffle buffer */
+  int shuffle_buffer_streams;
   /*! \brief random seed for augmentations */
   dmlc::optional<int> seed_aug;
+  /*! \brief whether to decode and augment the images on the GPU */
+  bool gpu_decode;
+  /*! \brief whether to decode JPEG images at a reduced resolution when possible */
+  bool scaled_decode;
+  /*! \brief whether to crop, resize and normalize the images in one pass when possible */
+  bool fused_augment;
+  /*! \brief size of the decoded images kept in memory, in MB */
+  size_t decoded_cache_size;
+  /*! \brief file the decoded images spill to */
+  std::string decoded_cache_file;
+  /*! \brief size of the decoded images kept in decoded_cache_file, in MB */
+  size_t decoded_cache_file_size;
 
   // declare parameters
   DMLC_DECLARE_PARAMETER(ImageRecParserParam) {
@@ -174,8 +190,41 @@ struct ImageRecParserParam : public dmlc::Parameter<ImageRecParserParam> {
         .describe("The data shuffle buffer size in MB. Only valid if shuffle is true.");
     DMLC_DECLARE_FIELD(shuffle_chunk_seed).set_default(0)
         .describe("The random seed for shuffling");
+    DMLC_DECLARE_FIELD(shuffle_buffer_size).set_default(0)
+        .describe("The number of records of the shuffle buffer, 0 to disable it. Only valid "
+                  "if shuffle is true and path_imgidx is not set. The records of each "
+                  "partition are read sequentially by shuffle_buffer_streams streams and "
+                  "every record is drawn uniformly from a buffer of this many raw records. "
+                  "Replaces the chunk shuffle of shuffle_chunk_size.");
+    DMLC_DECLARE_FIELD(shuffle_buffer_streams).set_lower_bound(1).set_default(4)
+        .describe("The number of consecutive sub-partitions of the partition read at the "
+                  "same time to fill the shuffle buffer.");
     DMLC_DECLARE_FIELD(seed_aug).set_default(dmlc::optional<int>())
         .describe("Random seed for augmentations.");
+    DMLC_DECLARE_FIELD(gpu_decode).set_default(false)
+        .describe("Decode the JPEG images with nvJPEG and crop, resize, mirror and normalize "
+                  "them on GPU device_id, returning batches in GPU memory. Only supports "
+                  "the crop and resize augmentations of aug_default. Requires a build with "
+                  "USE_NVJPEG.");
+    DMLC_DECLARE_FIELD(scaled_decode).set_default(true)
+        .describe("Decode JPEG images at 1/2, 1/4 or 1/8 of their resolution when the "
+                  "augmentations resize them below it anyway, e.g. with the resize option. "
+                  "Only used with libjpeg-turbo.");
+    DMLC_DECLARE_FIELD(fused_augment).set_default(false)
+        .describe("Crop, resize, mirror and normalize each image in a single bilinear pass "
+                  "from the decoded image to the output when aug_default only resizes and "
+                  "crops it, instead of running the OpenCV resizes and the normalization "
+                  "separately. The result differs slightly from the separate passes.");
+    DMLC_DECLARE_FIELD(decoded_cache_size).set_default(0)
+        .describe("Keep up to this many MB of decoded images in memory, so that the next "
+                  "epochs only augment them. The images are cached by the index in their "
+                  "record header, which has to be unique. 0 to disable the cache.");
+    DMLC_DECLARE_FIELD(decoded_cache_file).set_default("")
+        .describe("Local file the decoded images spill to once decoded_cache_size is used. "
+                  "The file is memory mapped and removed at once, it does not outlive "
+                  "the iterator.");
+    DMLC_DECLARE_FIELD(decoded_cache_file_size).set_default(0)
+        .describe("Keep up to this many MB of decoded images in decoded_cache_file.");
   }
 };
 
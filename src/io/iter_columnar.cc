@@ -0,0 +1,393 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file iter_columnar.cc
+ * \brief define an iterator over the row groups of a memory mapped columnar file
+ */
+#include <mxnet/io.h>
+#include <dmlc/base.h>
+#include <dmlc/logging.h>
+#include <dmlc/omp.h>
+#include <dmlc/parameter.h>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "./columnar_file.h"
+#include "./inst_vector.h"
+#include "./iter_sparse.h"
+#include "./iter_sparse_prefetcher.h"
+#include "../profiler/data_profiler.h"
+
+namespace mxnet {
+namespace io {
+// Columnar parameters
+struct ColumnarIterParam : public dmlc::Parameter<ColumnarIterParam> {
+  /*! \brief path of the columnar file */
+  std::string file;
+  /*! \brief names of the data columns */
+  std::string data_columns;
+  /*! \brief names of the label columns */
+  std::string label_columns;
+  /*! \brief partition the data into multiple parts */
+  int num_parts;
+  /*! \brief the index of the part will read*/
+  int part_index;
+  /*! \brief number of threads copying the row groups of a batch */
+  int preprocess_threads;
+  // declare parameters
+  DMLC_DECLARE_PARAMETER(ColumnarIterParam) {
+    DMLC_DECLARE_FIELD(file)
+        .describe("The path of the local columnar file.");
+    DMLC_DECLARE_FIELD(data_columns).set_default("")
+        .describe("The comma separated names of the data columns. "
+                  "If empty, all the columns that are not label columns.");
+    DMLC_DECLARE_FIELD(label_columns).set_default("")
+        .describe("The comma separated names of the label columns. "
+                  "If empty, all labels will be returned as 0.");
+    DMLC_DECLARE_FIELD(num_parts).set_default(1)
+        .describe("partition the data into multiple parts");
+    DMLC_DECLARE_FIELD(part_index).set_default(0)
+        .describe("the index of the part will read");
+    DMLC_DECLARE_FIELD(preprocess_threads).set_default(4).set_lower_bound(1)
+        .describe("The number of threads copying the row groups of a batch.");
+  }
+};
+
+/*!
+ * \brief Batch loader of a columnar file. The selected columns are copied from the row groups
+ *  of the mapping into the arrays of the batch, one task per column and row group.
+ *  The dense data columns are concatenated into one array, a CSR column is read alone.
+ */
+class ColumnarBatchLoader : public SparseIIterator<TBlobBatch> {
+ public:
+  ColumnarBatchLoader() = default;
+  ~ColumnarBatchLoader() override = default;
+
+  void Init(const std::vector<std::pair<std::string, std::string> >& kwargs) override {
+    param_.InitAllowUnknown(kwargs);
+    batch_param_.InitAllowUnknown(kwargs);
+    CHECK_GT(param_.num_parts, 0) << "number of parts should be positive";
+    CHECK_GE(param_.part_index, 0) << "part index should be non-negative";
+    CHECK_LT(param_.part_index, param_.num_parts) << "part index should be less than num_parts";
+    nthread_ = std::min(param_.preprocess_threads, std::max(omp_get_num_procs(), 1));
+    file_.reset(new ColumnarFile(param_.file));
+    std::vector<size_t> label_columns;
+    if (!param_.label_columns.empty()) label_columns = file_->Project(param_.label_columns);
+    InitSide(file_->Project(param_.data_columns, label_columns), &data_);
+    CHECK(!data_.columns.empty()) << "ColumnarIter requires at least one data column";
+    InitSide(label_columns, &label_);
+    const uint64_t num_rows = file_->NumRows();
+    part_begin_ = num_rows * param_.part_index / param_.num_parts;
+    part_end_ = num_rows * (param_.part_index + 1) / param_.num_parts;
+    out_.inst_index = new unsigned[batch_param_.batch_size];
+    out_.batch_size = batch_param_.batch_size;
+    out_.data.resize(num_aux_data(GetStorageType(true)) + 1 +
+                     num_aux_data(GetStorageType(false)) + 1);
+    pos_ = part_begin_;
+  }
+
+  void BeforeFirst() override {
+    if (batch_param_.round_batch == 0 || num_overflow_ == 0) {
+      pos_ = part_begin_;
+    } else {
+      // the rows padding the last batch were already read from the beginning
+      num_overflow_ = 0;
+    }
+  }
+
+  bool Next() override {
+    out_.num_batch_padd = 0;
+    // if overflow from previous round, directly return false, until before first is called
+    if (num_overflow_ != 0) return false;
+    if (pos_ >= part_end_) return false;
+    const uint64_t batch_size = batch_param_.batch_size;
+    std::vector<std::pair<uint64_t, uint64_t> > ranges;
+    const uint64_t top = std::min(batch_size, part_end_ - pos_);
+    ranges.emplace_back(pos_, pos_ + top);
+    pos_ += top;
+    if (top < batch_size) {
+      if (batch_param_.round_batch != 0) {
+        CHECK_GE(part_end_ - part_begin_, batch_size)
+            << "number of input must be bigger than batch size";
+        num_overflow_ = batch_size - top;
+        ranges.emplace_back(part_begin_, part_begin_ + num_overflow_);
+        pos_ = part_begin_ + num_overflow_;
+        out_.num_batch_padd = num_overflow_;
+      } else {
+        out_.num_batch_padd = batch_size - top;
+      }
+    }
+    const bool profiling = profiler::IsProfilingDataPipeline();
+    if (profiling) read_stage_.start();
+    const std::vector<Segment> segments = Segments(ranges);
+    Fill(segments, &data_);
+    Fill(segments, &label_);
+    size_t i = 0;
+    for (const auto& range : ranges) {
+      for (uint64_t row = range.first; row < range.second; ++row) out_.inst_index[i++] = row;
+    }
+    SetOutput(true, &out_.data[0]);
+    SetOutput(false, &out_.data[num_aux_data(GetStorageType(true)) + 1]);
+    if (profiling) read_stage_.stop(batch_size);
+    // let the kernel read the rows of the next batch while this one is consumed
+    if (pos_ < part_end_) {
+      file_->WillNeed(data_.columns, pos_, pos_ + batch_size);
+      file_->WillNeed(label_.columns, pos_, pos_ + batch_size);
+    }
+    return true;
+  }
+
+  const TBlobBatch &Value() const override {
+    return out_;
+  }
+
+  const NDArrayStorageType GetStorageType(bool is_data) const override {
+    return (is_data ? data_ : label_).csr ? kCSRStorage : kDefaultStorage;
+  }
+
+  const mxnet::TShape GetShape(bool is_data) const override {
+    const mxnet::TShape& inst_shape = (is_data ? data_ : label_).inst_shape;
+    std::vector<index_t> shape_vec;
+    shape_vec.push_back(batch_param_.batch_size);
+    for (index_t dim = 0; dim < inst_shape.ndim(); ++dim) {
+      shape_vec.push_back(inst_shape[dim]);
+    }
+    return mxnet::TShape(shape_vec.begin(), shape_vec.end());
+  }
+
+ private:
+  /*! \brief columns batched in one array, and the buffers of the batch */
+  struct BatchSide {
+    /*! \brief indices of the columns */
+    std::vector<size_t> columns;
+    /*! \brief offset of each column in a dense row */
+    std::vector<size_t> column_offsets;
+    /*! \brief whether the side is one CSR column */
+    bool csr{false};
+    /*! \brief type flag of the values */
+    int dtype{mshadow::kFloat32};
+    /*! \brief shape of one instance */
+    mxnet::TShape inst_shape;
+    /*! \brief bytes of a dense row */
+    size_t row_bytes{0};
+    /*! \brief values of the batch */
+    std::vector<char> data;
+    /*! \brief indices and indptr of a CSR batch */
+    std::vector<int64_t> indices, indptr;
+  };
+
+  /*! \brief rows [begin, end) of a row group, copied to the rows from out_row of the batch */
+  struct Segment {
+    size_t group;
+    uint64_t begin, end, out_row;
+  };
+
+  /*! \brief check the columns of a side and compute the layout of its rows */
+  void InitSide(const std::vector<size_t>& columns, BatchSide* side) {
+    side->columns = columns;
+    const auto& infos = file_->Columns();
+    if (columns.empty()) {
+      // the labels are all 0
+      side->inst_shape = mxnet::TShape(0, 1);
+      side->row_bytes = sizeof(real_t);
+      return;
+    }
+    side->dtype = infos[columns[0]].dtype;
+    side->csr = infos[columns[0]].storage == kCSRColumn;
+    if (side->csr) {
+      CHECK_EQ(columns.size(), 1U) << "The CSR column " << infos[columns[0]].name
+                                   << " has to be the only data or label column";
+      side->inst_shape = infos[columns[0]].shape;
+      return;
+    }
+    size_t size = 0;
+    for (size_t c : columns) {
+      CHECK_EQ(infos[c].storage, kDenseColumn) << "The CSR column " << infos[c].name
+                                               << " has to be the only data or label column";
+      CHECK_EQ(infos[c].dtype, side->dtype)
+          << "The dense columns concatenated in one array must have the same dtype, "
+          << "column " << infos[c].name << " differs from " << infos[columns[0]].name;
+      side->column_offsets.push_back(side->row_bytes);
+      side->row_bytes += file_->RowBytes(c);
+      size += infos[c].shape.Size();
+    }
+    side->inst_shape = columns.size() == 1 ? infos[columns[0]].shape
+                                           : mxnet::TShape(mshadow::Shape1(size));
+  }
+
+  /*! \brief split the row ranges of a batch at the row group boundaries */
+  std::vector<Segment> Segments(const std::vector<std::pair<uint64_t, uint64_t> >& ranges) const {
+    std::vector<Segment> segments;
+    uint64_t out_row = 0;
+    for (const auto& range : ranges) {
+      for (uint64_t row = range.first; row < range.second;) {
+        const size_t g = file_->GroupOf(row);
+        const RowGroup& group = file_->Groups()[g];
+        const uint64_t end = std::min(range.second, group.begin + group.num_rows);
+        segments.push_back({g, row - group.begin, end - group.begin, out_row});
+        out_row += end - row;
+        row = end;
+      }
+    }
+    return segments;
+  }
+
+  /*! \brief copy the rows of the segments to the buffers of a side */
+  void Fill(const std::vector<Segment>& segments, BatchSide* side) {
+    const size_t batch_size = batch_param_.batch_size;
+    const size_t num_rows = segments.empty() ? 0 : segments.back().out_row +
+                            segments.back().end - segments.back().begin;
+    if (side->columns.empty()) {
+      side->data.assign(batch_size * side->row_bytes, 0);
+      return;
+    }
+    const auto& groups = file_->Groups();
+    if (side->csr) {
+      const size_t column = side->columns[0];
+      const size_t elem_size = mshadow::mshadow_sizeof(side->dtype);
+      // offset of the values of each segment in the batch
+      std::vector<int64_t> nnz_offsets(segments.size() + 1, 0);
+      for (size_t i = 0; i < segments.size(); ++i) {
+        const int64_t *indptr = groups[segments[i].group].chunks[column].indptr;
+        nnz_offsets[i + 1] = nnz_offsets[i] + indptr[segments[i].end] - indptr[segments[i].begin];
+      }
+      const int64_t nnz = nnz_offsets.back();
+      side->data.resize(nnz * elem_size);
+      side->indices.resize(nnz);
+      // the rows padding the batch are empty
+      side->indptr.assign(batch_size + 1, nnz);
+      side->indptr[0] = 0;
+      #pragma omp parallel for num_threads(nthread_) schedule(dynamic)
+      for (int i = 0; i < static_cast<int>(segments.size()); ++i) {
+        const Segment& s = segments[i];
+        const ColumnChunk& chunk = groups[s.group].chunks[column];
+        const int64_t begin = chunk.indptr[s.begin], count = chunk.indptr[s.end] - begin;
+        std::memcpy(side->data.data() + nnz_offsets[i] * elem_size,
+                    chunk.data + begin * elem_size, count * elem_size);
+        std::memcpy(side->indices.data() + nnz_offsets[i], chunk.indices + begin,
+                    count * sizeof(int64_t));
+        for (uint64_t r = s.begin; r < s.end; ++r) {
+          side->indptr[s.out_row + r - s.begin + 1] = nnz_offsets[i] + chunk.indptr[r + 1] - begin;
+        }
+      }
+      return;
+    }
+    const size_t row_bytes = side->row_bytes;
+    side->data.resize(batch_size * row_bytes);
+    // the rows padding the batch are 0
+    std::memset(side->data.data() + num_rows * row_bytes, 0, (batch_size - num_rows) * row_bytes);
+    const int num_tasks = static_cast<int>(segments.size() * side->columns.size());
+    #pragma omp parallel for num_threads(nthread_) schedule(dynamic)
+    for (int t = 0; t < num_tasks; ++t) {
+      const Segment& s = segments[t / side->columns.size()];
+      const size_t c = t % side->columns.size();
+      const size_t column_bytes = file_->RowBytes(side->columns[c]);
+      const char *src = groups[s.group].chunks[side->columns[c]].data + s.begin * column_bytes;
+      char *dst = side->data.data() + s.out_row * row_bytes + side->column_offsets[c];
+      if (column_bytes == row_bytes) {
+        std::memcpy(dst, src, (s.end - s.begin) * row_bytes);
+      } else {
+        for (uint64_t r = s.begin; r < s.end; ++r, src += column_bytes, dst += row_bytes) {
+          std::memcpy(dst, src, column_bytes);
+        }
+      }
+    }
+  }
+
+  /*! \brief point the output arrays to the buffers of the data or the label */
+  void SetOutput(bool is_data, TBlob *out) {
+    BatchSide& side = is_data ? data_ : label_;
+    if (side.csr) {
+      const size_t nnz = side.indices.size();
+      out[0] = TBlob(static_cast<void*>(side.data.data()), mshadow::Shape1(nnz),
+                     cpu::kDevMask, side.dtype);
+      out[1] = TBlob(side.indices.data(), mshadow::Shape1(nnz), cpu::kDevMask);
+      out[2] = TBlob(side.indptr.data(), mshadow::Shape1(side.indptr.size()), cpu::kDevMask);
+    } else {
+      out[0] = TBlob(static_cast<void*>(side.data.data()), GetShape(is_data),
+                     cpu::kDevMask, side.dtype);
+    }
+  }
+
+  ColumnarIterParam param_;
+  BatchParam batch_param_;
+  // output batch
+  TBlobBatch out_;
+  // the columnar file
+  std::unique_ptr<ColumnarFile> file_;
+  // data and label columns
+  BatchSide data_, label_;
+  // rows of the part to read
+  uint64_t part_begin_{0}, part_end_{0};
+  // next row to read
+  uint64_t pos_{0};
+  // number of instances read from the next round to fill the last batch
+  uint64_t num_overflow_{0};
+  // number of copying threads
+  int nthread_{1};
+  // profiler stage of the batch copies
+  profiler::ProfileDataStage read_stage_{"ColumnarIter::Read"};
+};
+
+DMLC_REGISTER_PARAMETER(ColumnarIterParam);
+
+MXNET_REGISTER_IO_ITER(ColumnarIter)
+.describe(R"code(Returns the iterator over a columnar file, as written by
+:py:meth:`mxnet.gluon.data.ColumnarDataset.write` or converted from Parquet by
+:py:meth:`mxnet.gluon.data.ColumnarDataset.from_parquet`.
+
+The file is memory mapped, and the columns of each batch are copied from its row groups,
+without a parse. The row groups of a batch are copied by `preprocess_threads` threads at once,
+and the rows of the next batch are read ahead by the kernel.
+
+The `data_columns` are concatenated into one array of `default` storage, or a single column of
+`csr` storage is returned as is. The same holds for `label_columns`; if it is empty,
+all labels are 0.
+
+The `round_batch` parameter behaves as for the `CSVIter`. With `round_batch` set to False, the
+rows padding the last batch are 0, or empty for a `csr` column.
+
+When `num_parts` and `part_index` are provided, the rows are split into `num_parts` contiguous
+partitions, and the iterator only reads the `part_index`-th partition.
+
+Example::
+
+  >>> mx.gluon.data.ColumnarDataset.write('train.col', {'x': np.random.rand(1000, 8),
+  ...                                                    'y': np.arange(1000)})
+  >>> data_iter = mx.io.ColumnarIter(file='train.col', data_columns='x',
+  ...                                label_columns='y', batch_size=100)
+  >>> batch = data_iter.next()
+  >>> batch.data[0].shape, batch.label[0].shape
+  ((100, 8), (100,))
+
+)code" ADD_FILELINE)
+.add_arguments(ColumnarIterParam::__FIELDS__())
+.add_arguments(BatchParam::__FIELDS__())
+.add_arguments(PrefetcherParam::__FIELDS__())
+.set_body([]() {
+    return new SparsePrefetcherIter(
+        new ColumnarBatchLoader());
+  });
+
+}  // namespace io
+}  // namespace mxnet
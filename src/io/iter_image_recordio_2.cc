@@ -33,16 +33,23 @@
 #include <dmlc/omp.h>
 #include <dmlc/common.h>
 #include <dmlc/timer.h>
+#include <deque>
 #include <memory>
+#include <string>
 #include <type_traits>
 #if MXNET_USE_LIBJPEG_TURBO
 #include <turbojpeg.h>
 #endif
 #include "./image_recordio.h"
 #include "./image_augmenter.h"
+#include "./decoded_image_cache.h"
+#include "./image_decode_gpu.h"
 #include "./image_iter_common.h"
 #include "./inst_vector.h"
+#include "./record_shuffle_split.h"
 #include "../common/utils.h"
+#include "../engine/thread_budget.h"
+#include "../profiler/data_profiler.h"
 #include "../profiler/profiler.h"
 
 namespace mxnet {
@@ -59,6 +66,7 @@ class ImageRecordIOParser2 {
   inline void BeforeFirst() {
     if (batch_param_.round_batch == 0 || !overflow) {
       n_parsed_ = 0;
+      gpu_records_.clear();
       return source_->BeforeFirst();
     } else {
       overflow = false;
@@ -74,13 +82,21 @@ class ImageRecordIOParser2 {
   void ProcessImage(const cv::Mat& res,
     mshadow::Tensor<cpu, 3, DType>* data_ptr, const bool is_mirrored, const float contrast_scaled,
     const float illumination_scaled);
+  template<int n_channels>
+  void CropResizeImage(const cv::Mat& src, const float crop[4],
+    mshadow::Tensor<cpu, 3, DType>* data_ptr, const bool is_mirrored, const float contrast_scaled,
+    const float illumination_scaled);
 #if MXNET_USE_LIBJPEG_TURBO
-  cv::Mat TJimdecode(cv::Mat buf, int color);
+  cv::Mat TJimdecode(cv::Mat buf, int color, ImageAugmenter* aug);
 #endif
 #endif
   inline size_t ParseChunk(DType* data_dptr, real_t* label_dptr, const size_t current_size,
     dmlc::InputSplit::Blob * chunk);
   inline void CreateMeanImg();
+#if MXNET_USE_OPENCV && MXNET_USE_CUDA && MXNET_USE_NVJPEG
+  // decode and augment the next batch on the GPU
+  inline bool ParseNextGPU(DataBatch *out);
+#endif
 
   // magic number to seed prng
   static const int kRandMagic = 111;
@@ -90,6 +106,8 @@ class ImageRecordIOParser2 {
   ImageRecordParam record_param_;
   BatchParam batch_param_;
   ImageNormalizeParam normalize_param_;
+  /*! \brief preprocess threads leased from the thread budget, outside of the engine */
+  std::unique_ptr<engine::ThreadBudget::Lease> budget_;
 
   #if MXNET_USE_OPENCV
   /*! \brief augmenters */
@@ -122,8 +140,22 @@ class ImageRecordIOParser2 {
   bool legacy_shuffle_;
   // whether mean image is ready.
   bool meanfile_ready_;
+  // whether to crop, resize and normalize the images in one pass when possible
+  bool fused_augment_;
   /*! \brief OMPException obj to store and rethrow exceptions from omp blocks*/
   dmlc::OMPException omp_exc_;
+  /*! \brief decoded images, reused by the next epochs */
+  std::unique_ptr<DecodedImageCache> decoded_cache_;
+  /*! \brief records read from the source but not yet put in a batch, with gpu_decode */
+  std::deque<std::string> gpu_records_;
+  /*! \brief profiled stages */
+  profiler::ProfileDataStage read_stage_{"ImageRecordIter::Read"};
+  profiler::ProfileDataStage decode_stage_{"ImageRecordIter::Decode"};
+  profiler::ProfileDataStage augment_stage_{"ImageRecordIter::Augment"};
+#if MXNET_USE_CUDA && MXNET_USE_NVJPEG
+  /*! \brief decoder of the batches, with gpu_decode */
+  std::unique_ptr<NvJpegBatchDecoder> gpu_decoder_;
+#endif
 };
 
 template<typename DType>
@@ -155,10 +187,20 @@ inline void ImageRecordIOParser2<DType>::Init(
     {
       threadget = omp_get_num_threads();
     }
+    // the parser runs outside of the engine, lease its threads from the budget
+    budget_ = engine::ThreadBudget::Get()->Acquire("ImageRecordIOParser2", threadget);
+    threadget = budget_->threads();
   }
   param_.preprocess_threads = threadget;
 
   std::vector<std::string> aug_names = dmlc::Split(param_.aug_seq, ',');
+  // the fused pass resamples bilinearly
+  fused_augment_ = param_.fused_augment && aug_names.size() == 1;
+  for (const auto& kwarg : kwargs) {
+    if (kwarg.first == "inter_method" && std::stoi(kwarg.second) != 1) {
+      fused_augment_ = false;
+    }
+  }
   augmenters_.clear();
   augmenters_.resize(threadget);
   // setup decoders
@@ -175,11 +217,37 @@ inline void ImageRecordIOParser2<DType>::Init(
   }
   CHECK(param_.path_imgrec.length() != 0)
       << "ImageRecordIter2: must specify image_rec";
+  if (param_.gpu_decode) {
+#if MXNET_USE_CUDA && MXNET_USE_NVJPEG
+    CHECK_GE(param_.device_id, 0) << "gpu_decode requires the device_id of a GPU";
+    CHECK(prefetch_param.ctx != PrefetcherParam::CtxType::kCPU)
+        << "gpu_decode is not supported with ctx='cpu'";
+    CHECK(param_.data_shape[0] == 1 || param_.data_shape[0] == 3)
+        << "gpu_decode supports 1 or 3 channels, got data_shape " << param_.data_shape;
+    CHECK_EQ(normalize_param_.mean_img.length(), 0) << "gpu_decode does not support mean_img";
+    // probe the augmentations with an image larger than any crop
+    common::RANDOM_ENGINE probe(kRandMagic);
+    float crop[4];
+    CHECK(aug_names.size() == 1 && augmenters_[0][0]->PlanCrop(4096, 4096, &probe, crop))
+        << "gpu_decode only supports the resize, crop and random_resized_crop "
+           "augmentations of aug_default";
+    gpu_decoder_ = std::make_unique<NvJpegBatchDecoder>(param_.device_id,
+                                                        param_.data_shape[0]);
+#else
+    LOG(FATAL) << "gpu_decode requires MXNet built with USE_NVJPEG=1";
+#endif
+  }
 
   if (param_.verbose) {
     LOG(INFO) << "ImageRecordIOParser2: " << param_.path_imgrec
               << ", use " << threadget << " threads for decoding..";
   }
+  if (param_.decoded_cache_size > 0 || param_.decoded_cache_file_size > 0) {
+    CHECK(!param_.gpu_decode) << "The decoded image cache is not supported with gpu_decode";
+    decoded_cache_.reset(new DecodedImageCache(param_.decoded_cache_size << 20UL,
+                                               param_.decoded_cache_file,
+                                               param_.decoded_cache_file_size << 20UL));
+  }
   legacy_shuffle_ = false;
   if (param_.path_imgidx.length() != 0) {
     source_.reset(dmlc::InputSplit::Create(
@@ -196,7 +264,14 @@ inline void ImageRecordIOParser2<DType>::Init(
         param_.num_parts, "recordio"));
     if (record_param_.shuffle)
       legacy_shuffle_ = true;
-    if (param_.shuffle_chunk_size > 0) {
+    if (record_param_.shuffle && param_.shuffle_buffer_size > 0) {
+      // shuffle the records of the partition across chunks, reading them sequentially
+      source_.reset(new RecordShuffleSplit(param_.path_imgrec, param_.part_index,
+                                           param_.num_parts, param_.shuffle_buffer_streams,
+                                           param_.shuffle_buffer_size,
+                                           kRandMagic + record_param_.seed));
+      legacy_shuffle_ = false;
+    } else if (param_.shuffle_chunk_size > 0) {
       if (param_.shuffle_chunk_size > 4096) {
         LOG(INFO) << "Chunk size: " << param_.shuffle_chunk_size
                    << " MB which is larger than 4096 MB, please set "
@@ -265,6 +340,11 @@ inline void ImageRecordIOParser2<DType>::Init(
 
 template<typename DType>
 inline bool ImageRecordIOParser2<DType>::ParseNext(DataBatch *out) {
+#if MXNET_USE_OPENCV && MXNET_USE_CUDA && MXNET_USE_NVJPEG
+  if (param_.gpu_decode) {
+    return ParseNextGPU(out);
+  }
+#endif
   if (overflow) {
     return false;
   }
@@ -316,7 +396,11 @@ inline bool ImageRecordIOParser2<DType>::ParseNext(DataBatch *out) {
     // int n_to_copy;
     size_t n_to_out = 0;
     if (n_parsed_ == 0) {
-      if (source_->NextBatch(&chunk, batch_param_.batch_size)) {
+      const bool profiling = profiler::IsProfilingDataPipeline();
+      if (profiling) read_stage_.start();
+      const bool has_chunk = source_->NextBatch(&chunk, batch_param_.batch_size);
+      if (profiling) read_stage_.stop();
+      if (has_chunk) {
         inst_order_.clear();
         inst_index_ = 0;
         DType* data_dptr = static_cast<DType*>(out->data[0].data().dptr_);
@@ -377,6 +461,147 @@ inline bool ImageRecordIOParser2<DType>::ParseNext(DataBatch *out) {
   return true;
 }
 
+#if MXNET_USE_OPENCV && MXNET_USE_CUDA && MXNET_USE_NVJPEG
+template<typename DType>
+inline bool ImageRecordIOParser2<DType>::ParseNextGPU(DataBatch *out) {
+  if (overflow) {
+    return false;
+  }
+  CHECK(source_ != nullptr);
+  const size_t batch_size = batch_param_.batch_size;
+  const int channels = param_.data_shape[0];
+  out->index.resize(batch_size);
+  if (out->data.size() == 0) {
+    out->data.resize(2);
+    const Context ctx = Context::GPU(param_.device_id);
+    const std::string profiler_scope =
+        profiler::ProfilerScope::Get()->GetCurrentProfilerScope() + "image_io:";
+    out->data.at(0) = NDArray(mshadow::Shape4(batch_size, channels, param_.data_shape[1],
+                                              param_.data_shape[2]),
+                              ctx, false, mshadow::DataType<DType>::kFlag);
+    out->data.at(0).AssignStorageInfo(profiler_scope, "data");
+    out->data.at(1) = NDArray(mshadow::Shape2(batch_size, param_.label_width),
+                              ctx, false, mshadow::DataType<real_t>::kFlag);
+    out->data.at(1).AssignStorageInfo(profiler_scope, "label");
+  }
+
+  // gather the records of the batch, the decoder reads the images in place
+  size_t num_valid = batch_size;
+  dmlc::InputSplit::Blob chunk;
+  const bool profiling = profiler::IsProfilingDataPipeline();
+  while (gpu_records_.size() < batch_size) {
+    if (profiling) read_stage_.start();
+    const bool has_chunk = source_->NextBatch(&chunk, batch_size);
+    if (profiling) read_stage_.stop();
+    if (has_chunk) {
+      dmlc::RecordIOChunkReader reader(chunk, 0, 1);
+      dmlc::InputSplit::Blob blob;
+      const size_t start = gpu_records_.size();
+      while (reader.NextRecord(&blob)) {
+        gpu_records_.emplace_back(static_cast<char*>(blob.dptr), blob.size);
+      }
+      if (legacy_shuffle_) {
+        std::shuffle(gpu_records_.begin() + start, gpu_records_.end(), rnd_);
+      }
+    } else {
+      if (gpu_records_.empty()) {
+        return false;
+      }
+      CHECK(!overflow) << "number of input images must be bigger than the batch size";
+      num_valid = gpu_records_.size();
+      if (batch_param_.round_batch == 0) {
+        break;
+      }
+      overflow = true;
+      source_->BeforeFirst();
+    }
+  }
+  out->num_batch_padd = batch_size - num_valid;
+
+  const size_t n = std::min(batch_size, gpu_records_.size());
+  std::vector<GPUImageJob> jobs(n);
+  std::vector<float> labels(n * param_.label_width);
+  #pragma omp parallel for num_threads(param_.preprocess_threads)
+  for (int i = 0; i < static_cast<int>(n); ++i) {
+    omp_exc_.Run([&] {
+    const int tid = omp_get_thread_num();
+    ImageRecordIO rec;
+    rec.Load(&gpu_records_[i][0], gpu_records_[i].size());
+    out->index[i] = rec.image_index();
+    if (param_.seed_aug.has_value()) {
+      prnds_[tid]->seed(i + param_.seed_aug.value() + kRandMagic);
+    }
+    GPUImageJob& job = jobs[i];
+    job.data = rec.content;
+    job.size = rec.content_size;
+    if (!gpu_decoder_->GetImageInfo(job.data, job.size, &job.width, &job.height)) {
+      // not a JPEG, decode it here and only resize it on the GPU
+      cv::Mat buf(1, rec.content_size, CV_8U, rec.content);
+      cv::Mat res = cv::imdecode(buf, channels == 3 ? 1 : 0);
+      CHECK(!res.empty()) << "Invalid image with index " << rec.image_index();
+      if (channels == 3) {
+        cv::cvtColor(res, res, cv::COLOR_BGR2RGB);
+      }
+      job.width = res.cols;
+      job.height = res.rows;
+      job.host_pixels.assign(res.datastart, res.dataend);
+    }
+    std::vector<float> label_buf;
+    if (label_map_ != nullptr) {
+      label_buf = label_map_->FindCopy(rec.image_index());
+    } else if (rec.label != nullptr) {
+      CHECK_EQ(param_.label_width, rec.num_label)
+        << "rec file provide " << rec.num_label << "-dimensional label "
+           "but label_width is set to " << param_.label_width;
+      label_buf.assign(rec.label, rec.label + rec.num_label);
+    } else {
+      CHECK_EQ(param_.label_width, 1)
+        << "label_width must be 1 unless an imglist is provided "
+           "or the rec file is packed with multi dimensional label";
+      label_buf.assign(&rec.header.label, &rec.header.label + 1);
+    }
+    CHECK_EQ(label_buf.size(), static_cast<size_t>(param_.label_width));
+    std::copy(label_buf.begin(), label_buf.end(), labels.begin() + i * param_.label_width);
+    CHECK(augmenters_[tid][0]->PlanCrop(job.width, job.height, prnds_[tid].get(), job.crop));
+
+    std::uniform_real_distribution<float> rand_uniform(0, 1);
+    std::bernoulli_distribution coin_flip(0.5);
+    job.mirror = (normalize_param_.rand_mirror && coin_flip(*(prnds_[tid])))
+                 || normalize_param_.mirror;
+    if (!std::is_same<DType, uint8_t>::value) {
+      job.contrast =
+        (rand_uniform(*(prnds_[tid])) * normalize_param_.max_random_contrast * 2
+        - normalize_param_.max_random_contrast + 1)*normalize_param_.scale;
+      job.illumination =
+        (rand_uniform(*(prnds_[tid])) * normalize_param_.max_random_illumination * 2
+        - normalize_param_.max_random_illumination) * normalize_param_.scale;
+    }
+    });
+  }
+  omp_exc_.Rethrow();
+
+  GPUNormalizeParam normalize;
+  if (!std::is_same<DType, uint8_t>::value) {
+    const float mean[3] = {normalize_param_.mean_r, normalize_param_.mean_g,
+                           normalize_param_.mean_b};
+    const float stdev[3] = {normalize_param_.std_r, normalize_param_.std_g,
+                            normalize_param_.std_b};
+    for (int k = 0; k < channels; ++k) {
+      normalize.mean[k] = mean[k];
+      normalize.inv_std[k] = 1.0f / stdev[k];
+    }
+  }
+  // decoding, augmentation and the copy of the batch to the gpu are one stage
+  if (profiling) decode_stage_.start();
+  gpu_decoder_->Run(jobs, normalize, param_.data_shape[1], param_.data_shape[2],
+                    mshadow::DataType<DType>::kFlag, out->data[0].data().dptr_, labels,
+                    static_cast<real_t*>(out->data[1].data().dptr_));
+  if (profiling) decode_stage_.stop(jobs.size());
+  gpu_records_.erase(gpu_records_.begin(), gpu_records_.begin() + n);
+  return true;
+}
+#endif  // MXNET_USE_OPENCV && MXNET_USE_CUDA && MXNET_USE_NVJPEG
+
 #if MXNET_USE_OPENCV
 template<typename DType>
 template<int n_channels>
@@ -468,6 +693,72 @@ void ImageRecordIOParser2<DType>::ProcessImage(const cv::Mat& res,
   }
 }
 
+template<typename DType>
+template<int n_channels>
+void ImageRecordIOParser2<DType>::CropResizeImage(const cv::Mat& src, const float crop[4],
+  mshadow::Tensor<cpu, 3, DType>* data_ptr, const bool is_mirrored, const float contrast_scaled,
+  const float illumination_scaled) {
+  mshadow::Tensor<cpu, 3, DType>& data = (*data_ptr);
+  const int rows = data.size(1);
+  const int cols = data.size(2);
+  const float means[3] = {normalize_param_.mean_r, normalize_param_.mean_g,
+                          normalize_param_.mean_b};
+  const float stds[3] = {normalize_param_.std_r, normalize_param_.std_g,
+                         normalize_param_.std_b};
+  float mult[n_channels], bias[n_channels], mean[n_channels];  // NOLINT(*)
+  int16_t mean_int[n_channels];  // NOLINT(*)
+  // OpenCV stores BGR and we want RGB
+  int src_channel[n_channels];  // NOLINT(*)
+  for (int k = 0; k < n_channels; ++k) {
+    src_channel[k] = n_channels - 1 - k;
+    const bool normalize = !std::is_same<DType, uint8_t>::value;
+    mult[k] = normalize ? contrast_scaled / stds[k] : 1.0f;
+    bias[k] = normalize ? illumination_scaled / stds[k] : 0.0f;
+    mean[k] = normalize ? means[k] : 0.0f;
+    mean_int[k] = std::round(mean[k]);
+  }
+  // horizontal taps of the bilinear sampling, mirrored here to avoid memory copies
+  const float scale_x = crop[2] / cols;
+  const float scale_y = crop[3] / rows;
+  std::vector<int> x0(cols), x1(cols);
+  std::vector<float> wx(cols);
+  for (int j = 0; j < cols; ++j) {
+    const int out_j = is_mirrored ? cols - 1 - j : j;
+    const float sx = std::min(std::max(crop[0] + (out_j + 0.5f) * scale_x - 0.5f, 0.0f),
+                              src.cols - 1.0f);
+    const int x = static_cast<int>(sx);
+    x0[j] = x * n_channels;
+    x1[j] = std::min(x + 1, src.cols - 1) * n_channels;
+    wx[j] = sx - x;
+  }
+  for (int i = 0; i < rows; ++i) {
+    const float sy = std::min(std::max(crop[1] + (i + 0.5f) * scale_y - 0.5f, 0.0f),
+                              src.rows - 1.0f);
+    const int y = static_cast<int>(sy);
+    const float wy = sy - y;
+    const uchar* top = src.ptr<uchar>(y);
+    const uchar* bottom = src.ptr<uchar>(std::min(y + 1, src.rows - 1));
+    for (int k = 0; k < n_channels; ++k) {
+      const uchar* t = top + src_channel[k];
+      const uchar* b = bottom + src_channel[k];
+      DType* out = data[k][i].dptr_;
+      #pragma omp simd
+      for (int j = 0; j < cols; ++j) {
+        const float v_top = t[x0[j]] + (t[x1[j]] - t[x0[j]]) * wx[j];
+        const float v_bottom = b[x0[j]] + (b[x1[j]] - b[x0[j]]) * wx[j];
+        const float v = v_top + (v_bottom - v_top) * wy;
+        if (std::is_same<DType, int8_t>::value) {
+          out[j] = cv::saturate_cast<int8_t>(cvRound(v) - mean_int[k]);
+        } else if (std::is_same<DType, uint8_t>::value) {
+          out[j] = cv::saturate_cast<uint8_t>(v);
+        } else {
+          out[j] = (v - mean[k]) * mult[k] + bias[k];
+        }
+      }
+    }
+  }
+}
+
 #if MXNET_USE_LIBJPEG_TURBO
 
 bool is_jpeg(unsigned char * file) {
@@ -479,7 +770,7 @@ bool is_jpeg(unsigned char * file) {
 }
 
 template<typename DType>
-cv::Mat ImageRecordIOParser2<DType>::TJimdecode(cv::Mat image, int color) {
+cv::Mat ImageRecordIOParser2<DType>::TJimdecode(cv::Mat image, int color, ImageAugmenter* aug) {
   unsigned char* jpeg = image.ptr();
   size_t jpeg_size = image.rows * image.cols;
 
@@ -496,8 +787,27 @@ cv::Mat ImageRecordIOParser2<DType>::TJimdecode(cv::Mat image, int color) {
                                 &w, &h, &subsamp);
   if (err != 0) {
     // If it is a malformed JPEG then fall back to OpenCV
+    tjDestroy(handle);
     return cv::imdecode(image, color);
   }
+  // decode at 1/2, 1/4 or 1/8 of the resolution when the augmentation shrinks it anyway
+  int min_w, min_h;
+  if (param_.scaled_decode && aug != nullptr && aug->MinDecodeSize(w, h, &min_w, &min_h)) {
+    int num_factors;
+    const tjscalingfactor* factors = tjGetScalingFactors(&num_factors);
+    int scaled_w = w, scaled_h = h;
+    for (int i = 0; factors != nullptr && i < num_factors; ++i) {
+      if (factors[i].num != 1) continue;
+      const int sw = TJSCALED(w, factors[i]);
+      const int sh = TJSCALED(h, factors[i]);
+      if (sw >= min_w && sh >= min_h && sw < scaled_w) {
+        scaled_w = sw;
+        scaled_h = sh;
+      }
+    }
+    w = scaled_w;
+    h = scaled_h;
+  }
   cv::Mat ret = cv::Mat(h, w, color ? CV_8UC3 : CV_8UC1);
   err = tjDecompress2(handle,
                       jpeg,
@@ -508,11 +818,11 @@ cv::Mat ImageRecordIOParser2<DType>::TJimdecode(cv::Mat image, int color) {
                       h,
                       color ? TJPF_BGR : TJPF_GRAY,
                       0);
+  tjDestroy(handle);
   if (err != 0) {
     // If it is a malformed JPEG then fall back to OpenCV
     return cv::imdecode(image, color);
   }
-  tjDestroy(handle);
   return ret;
 }
 #endif
@@ -532,12 +842,18 @@ inline size_t ImageRecordIOParser2<DType>::ParseChunk(DType* data_dptr, real_t*
     omp_exc_.Run([&] {
     CHECK(omp_get_num_threads() == param_.preprocess_threads);
     int tid = omp_get_thread_num();
+    if (budget_) budget_->BindThread(tid);
     // dmlc::RecordIOChunkReader reader(*chunk, tid, param_.preprocess_threads);
     ImageRecordIO rec;
     dmlc::InputSplit::Blob blob;
     // image data
     InstVector<DType> &out_tmp = temp_[tid];
     out_tmp.Clear();
+    // busy time of this thread in the decode and augment stages
+    const bool profiling = profiler::IsProfilingDataPipeline();
+    const uint64_t thread_start = profiling ? profiler::ProfileStat::NowInMicrosec() : 0;
+    uint64_t decode_time = 0, augment_time = 0;
+    size_t num_images = 0;
     while (true) {
       bool reader_has_data;
       size_t idx;
@@ -563,30 +879,44 @@ inline size_t ImageRecordIOParser2<DType>::ParseChunk(DType* data_dptr, real_t*
         prnds_[tid]->seed(idx + param_.seed_aug.value() + kRandMagic);
       }
 
-      switch (param_.data_shape[0]) {
-       case 1:
+      uint64_t stage_start = profiling ? profiler::ProfileStat::NowInMicrosec() : 0;
+      // the augmenters may work in place, they get a copy of a cached image
+      const bool cached = decoded_cache_ != nullptr &&
+                          decoded_cache_->Get(rec.image_index(), &res);
+      if (cached) {
+        res = res.clone();
+      } else {
+        switch (param_.data_shape[0]) {
+         case 1:
 #if MXNET_USE_LIBJPEG_TURBO
-        res = TJimdecode(buf, 0);
+          res = TJimdecode(buf, 0, augmenters_[tid].front().get());
 #else
-        res = cv::imdecode(buf, 0);
+          res = cv::imdecode(buf, 0);
 #endif
-        break;
-       case 3:
+          break;
+         case 3:
 #if MXNET_USE_LIBJPEG_TURBO
-        res = TJimdecode(buf, 1);
+          res = TJimdecode(buf, 1, augmenters_[tid].front().get());
 #else
-        res = cv::imdecode(buf, 1);
+          res = cv::imdecode(buf, 1);
 #endif
-        break;
-       case 4:
-        // -1 to keep the number of channel of the encoded image, and not force gray or color.
-        res = cv::imdecode(buf, -1);
-        CHECK_EQ(res.channels(), 4)
-          << "Invalid image with index " << rec.image_index()
-          << ". Expected 4 channels, got " << res.channels();
-        break;
-       default:
-        LOG(FATAL) << "Invalid output shape " << param_.data_shape;
+          break;
+         case 4:
+          // -1 to keep the number of channel of the encoded image, and not force gray or color.
+          res = cv::imdecode(buf, -1);
+          CHECK_EQ(res.channels(), 4)
+            << "Invalid image with index " << rec.image_index()
+            << ". Expected 4 channels, got " << res.channels();
+          break;
+         default:
+          LOG(FATAL) << "Invalid output shape " << param_.data_shape;
+        }
+        if (decoded_cache_ != nullptr) decoded_cache_->Put(rec.image_index(), res);
+      }
+      if (profiling) {
+        const uint64_t now = profiler::ProfileStat::NowInMicrosec();
+        decode_time += now - stage_start;
+        stage_start = now;
       }
       const int n_channels = res.channels();
       // load label before augmentations
@@ -604,16 +934,25 @@ inline size_t ImageRecordIOParser2<DType>::ParseChunk(DType* data_dptr, real_t*
              "or the rec file is packed with multi dimensional label";
         label_buf.assign(&rec.header.label, &rec.header.label + 1);
       }
-      for (auto& aug : augmenters_[tid]) {
-        res = aug->Process(res, &label_buf, prnds_[tid].get());
+      // crop, resize and normalize in one pass when the augmentation is only a crop
+      float crop[4];
+      const bool fused = fused_augment_ && !meanfile_ready_ &&
+          (n_channels == 1 || n_channels == 3) &&
+          augmenters_[tid].front()->PlanCrop(res.cols, res.rows, prnds_[tid].get(), crop);
+      if (!fused) {
+        for (auto& aug : augmenters_[tid]) {
+          res = aug->Process(res, &label_buf, prnds_[tid].get());
+        }
       }
+      const index_t out_rows = fused ? param_.data_shape[1] : res.rows;
+      const index_t out_cols = fused ? param_.data_shape[2] : res.cols;
       mshadow::Tensor<cpu, 3, DType> data;
       if (idx < batch_param_.batch_size) {
         data = mshadow::Tensor<cpu, 3, DType>(data_dptr + idx*unit_size_[0],
-          mshadow::Shape3(n_channels, res.rows, res.cols));
+          mshadow::Shape3(n_channels, out_rows, out_cols));
       } else {
         out_tmp.Push(static_cast<size_t>(rec.image_index()),
-                 mshadow::Shape3(n_channels, res.rows, res.cols),
+                 mshadow::Shape3(n_channels, out_rows, out_cols),
                  mshadow::Shape1(param_.label_width));
         data = out_tmp.data().Back();
       }
@@ -634,13 +973,21 @@ inline size_t ImageRecordIOParser2<DType>::ParseChunk(DType* data_dptr, real_t*
       }
       // For RGB or RGBA data, swap the B and R channel:
       // OpenCV store as BGR (or BGRA) and we want RGB (or RGBA)
-      if (n_channels == 1) {
+      if (fused && n_channels == 1) {
+        CropResizeImage<1>(res, crop, &data, is_mirrored, contrast_scaled, illumination_scaled);
+      } else if (fused) {
+        CropResizeImage<3>(res, crop, &data, is_mirrored, contrast_scaled, illumination_scaled);
+      } else if (n_channels == 1) {
         ProcessImage<1>(res, &data, is_mirrored, contrast_scaled, illumination_scaled);
       } else if (n_channels == 3) {
         ProcessImage<3>(res, &data, is_mirrored, contrast_scaled, illumination_scaled);
       } else if (n_channels == 4) {
         ProcessImage<4>(res, &data, is_mirrored, contrast_scaled, illumination_scaled);
       }
+      if (profiling) {
+        augment_time += profiler::ProfileStat::NowInMicrosec() - stage_start;
+        ++num_images;
+      }
 
       mshadow::Tensor<cpu, 1, real_t> label;
       if (idx < batch_param_.batch_size) {
@@ -654,6 +1001,10 @@ inline size_t ImageRecordIOParser2<DType>::ParseChunk(DType* data_dptr, real_t*
         mshadow::Shape1(label_buf.size())));
       res.release();
     }
+    if (profiling && num_images > 0) {
+      decode_stage_.Record(thread_start, thread_start + decode_time, num_images);
+      augment_stage_.Record(thread_start, thread_start + augment_time, num_images);
+    }
   });
   }
   omp_exc_.Rethrow();
@@ -732,13 +1083,16 @@ class ImageRecordIter2 : public IIterator<DataBatch> {
           if (*dptr == nullptr) {
             *dptr = new DataBatch();
           }
-          return parser_.ParseNext(*dptr);
+          if (!parser_.ParseNext(*dptr)) return false;
+          queue_.Push();
+          return true;
           },
           [this]() { parser_.BeforeFirst(); });
     }
 
     void BeforeFirst() override {
       iter_.BeforeFirst();
+      queue_.Clear();
     }
 
     // From iter_prefetcher.h
@@ -756,7 +1110,12 @@ class ImageRecordIter2 : public IIterator<DataBatch> {
         recycle_queue_.pop();
         iter_.Recycle(&old_batch);
       }
-      return iter_.Next(&out_);
+      const bool profiling = profiler::IsProfilingDataPipeline();
+      if (profiling) wait_stage_.start();
+      if (!iter_.Next(&out_)) return false;
+      if (profiling) wait_stage_.stop(out_->data[0].shape()[0] - out_->num_batch_padd);
+      queue_.Pop();
+      return true;
     }
 
     const DataBatch &Value() const override {
@@ -768,6 +1127,10 @@ class ImageRecordIter2 : public IIterator<DataBatch> {
     dmlc::ThreadedIter<DataBatch> iter_;
     /*! \brief Parameters */
     PrefetcherParam prefetch_param_;
+    /*! \brief time the consumer waits for the batches */
+    profiler::ProfileDataStage wait_stage_{"ImageRecordIter::Wait"};
+    /*! \brief batches loaded but not consumed yet */
+    profiler::ProfileDataQueue queue_{"ImageRecordIter::Queue"};
     /*! \brief output data */
     DataBatch *out_{nullptr};
     /*! \brief queue to be recycled */
@@ -40,6 +40,7 @@
 #include <algorithm>
 #include "./inst_vector.h"
 #include "./image_iter_common.h"
+#include "../profiler/data_profiler.h"
 
 namespace mxnet {
 namespace io {
@@ -64,10 +65,8 @@ class PrefetcherIter : public IIterator<DataBatch> {
     // init image rec param
     kwargs_left = param_.InitAllowUnknown(kwargs);
     CHECK_GT(param_.prefetch_buffer, 0) << "Prefetch_buffer must be positive number";
-    // maximum prefetch threaded iter internal size
-    const int kMaxPrefetchBuffer = 16;
     // init thread iter
-    iter.set_max_capacity(kMaxPrefetchBuffer);
+    iter.set_max_capacity(max_inflight_);
   }
 
   virtual void Init(const std::vector<std::pair<std::string, std::string> >& kwargs) {
@@ -76,8 +75,14 @@ class PrefetcherIter : public IIterator<DataBatch> {
     loader_->Init(kwargs);
     length_hint_ = loader_->GetLenHint();
     iter.Init([this](DataBatch **dptr) {
+        const bool profiling = profiler::IsProfilingDataPipeline();
+        if (profiling) load_stage_.start();
         if (!loader_->Next()) return false;
         const TBlobBatch& batch = loader_->Value();
+        if (profiling) {
+          load_stage_.stop(NumSamples(batch.data, batch.num_batch_padd));
+          copy_stage_.start();
+        }
         if (*dptr == nullptr) {
           // allocate databatch
           *dptr = new DataBatch();
@@ -114,6 +119,8 @@ class PrefetcherIter : public IIterator<DataBatch> {
                     batch.inst_index + batch.batch_size,
                     (*dptr)->index.begin());
         }
+        if (profiling) copy_stage_.stop(NumSamples(batch.data, batch.num_batch_padd));
+        queue_.Push();
        return true;
       },
       [this]() { loader_->BeforeFirst(); length_hint_ = loader_->GetLenHint();});
@@ -121,6 +128,7 @@ class PrefetcherIter : public IIterator<DataBatch> {
 
   virtual void BeforeFirst(void) {
     iter.BeforeFirst();
+    queue_.Clear();
   }
 
   virtual int64_t GetLenHint(void) const {
@@ -141,25 +149,52 @@ class PrefetcherIter : public IIterator<DataBatch> {
       recycle_queue_.pop();
       iter.Recycle(&old_batch);
     }
-    return iter.Next(&out_);
+    const bool profiling = profiler::IsProfilingDataPipeline();
+    if (profiling) wait_stage_.start();
+    if (!iter.Next(&out_)) return false;
+    if (profiling) {
+      std::vector<TBlob> data;
+      for (const NDArray& arr : out_->data) data.push_back(arr.data());
+      wait_stage_.stop(NumSamples(data, out_->num_batch_padd));
+    }
+    queue_.Pop();
+    return true;
   }
   virtual const DataBatch &Value(void) const {
     return *out_;
   }
 
  protected:
+  /*! \return the number of samples in a batch, without the padding */
+  static size_t NumSamples(const std::vector<TBlob>& data, int num_batch_padd) {
+    if (data.empty() || data[0].ndim() == 0) return 0;
+    return static_cast<size_t>(data[0].shape_[0] - num_batch_padd);
+  }
+
   /*! \brief prefetcher parameters */
   PrefetcherParam param_;
   /*! \brief backend thread */
   dmlc::ThreadedIter<DataBatch> iter;
   /*! \brief internal batch loader */
   std::unique_ptr<IIterator<TBlobBatch> > loader_;
+  /*! \brief maximum number of batches loaded ahead of the consumer */
+  size_t max_inflight_ = 16;
+  /*! \brief time taken by the loader, in the background thread */
+  profiler::ProfileDataStage load_stage_{"PrefetcherIter::Load"};
+  /*! \brief time taken to copy the batches of the loader */
+  profiler::ProfileDataStage copy_stage_{"PrefetcherIter::Copy"};
+  /*! \brief time the consumer waits for the batches */
+  profiler::ProfileDataStage wait_stage_{"PrefetcherIter::Wait"};
+  /*! \brief batches loaded but not consumed yet */
+  profiler::ProfileDataQueue queue_{"PrefetcherIter::Queue"};
 
  private:
   /*! \brief output data */
   DataBatch *out_;
   /*! \brief queue to be recycled */
   std::queue<DataBatch*> recycle_queue_;
+
+ protected:
   /*! \brief size hint cache */
   int64_t length_hint_;
 };
@@ -27,8 +27,11 @@
 #include <mxnet/io.h>
 #include <mxnet/base.h>
 #include <mxnet/resource.h>
+#include <algorithm>
 #include <memory>
 #include <numeric>
+#include <utility>
+#include <vector>
 #include "../common/utils.h"
 #include "./iter_batchloader.h"
 #include "./iter_prefetcher.h"
@@ -174,5 +177,155 @@ MXNET_REGISTER_IO_ITER(RandomSampler)
             new RandomSampler());
   });
 
+struct BucketSamplerParam : public dmlc::Parameter<BucketSamplerParam> {
+  /*! \brief Pointer to the NDArray of the sample lengths. */
+  std::intptr_t lengths;
+  /*! \brief Cap on the padded number of tokens of a batch. */
+  size_t max_tokens;
+  /*! \brief Cap on the number of samples of a batch. */
+  size_t batch_size;
+  /*! \brief Number of length buckets. */
+  int num_buckets;
+  /*! \brief Whether to shuffle the samples and the batches. */
+  bool shuffle;
+  // declare parameters
+  DMLC_DECLARE_PARAMETER(BucketSamplerParam) {
+      DMLC_DECLARE_FIELD(lengths)
+          .describe("Pointer to the 1-D NDArray of the lengths of the samples.");
+      DMLC_DECLARE_FIELD(max_tokens)
+          .describe("Maximum number of tokens of a batch, counted as the number of samples "
+                    "times the longest sample of the batch. A sample longer than it forms "
+                    "a batch on its own.");
+      DMLC_DECLARE_FIELD(batch_size).set_default(0)
+          .describe("Maximum number of samples of a batch, 0 for no limit.");
+      DMLC_DECLARE_FIELD(num_buckets).set_default(10)
+          .set_lower_bound(1)
+          .describe("Number of buckets of samples of similar lengths.");
+      DMLC_DECLARE_FIELD(shuffle).set_default(true)
+          .describe("Whether to shuffle the samples within the buckets and the batches "
+                    "across the buckets at each epoch.");
+  }
+};  // struct BucketSamplerParam
+
+DMLC_REGISTER_PARAMETER(BucketSamplerParam);
+
+/*!
+ * \brief Batch sampler of variable-length samples. The samples are sorted by length
+ *  and split into buckets of equal sizes, so that a batch only holds samples of similar
+ *  lengths and wastes little padding. Each batch holds as many samples of its bucket as
+ *  fit in max_tokens padded tokens, so the batches have varying sizes and no padding.
+ */
+class BucketSampler : public IIterator<DataBatch> {
+ public:
+  void Init(const std::vector<std::pair<std::string, std::string> >& kwargs) override {
+    param_.InitAllowUnknown(kwargs);
+    CHECK_GT(param_.max_tokens, 0U) << "max_tokens must be positive";
+    const NDArray& lengths = *(static_cast<NDArray*>(reinterpret_cast<void*>(param_.lengths)));
+    CHECK_EQ(lengths.shape().ndim(), 1) << "lengths must be 1-D, but got " << lengths.shape();
+    const size_t num = lengths.shape()[0];
+    lengths_.resize(num);
+    MSHADOW_TYPE_SWITCH(lengths.dtype(), DType, {
+      std::vector<DType> buf(num);
+      lengths.SyncCopyToCPU(buf.data(), num);
+      std::transform(buf.begin(), buf.end(), lengths_.begin(),
+                     [](DType v) { return static_cast<int64_t>(v); });
+    });
+    for (const int64_t len : lengths_) {
+      CHECK_GE(len, 0) << "lengths must be non-negative, but got " << len;
+    }
+    std::vector<int64_t> order(num);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [this](int64_t a, int64_t b) { return lengths_[a] < lengths_[b]; });
+    const size_t num_buckets = std::min<size_t>(param_.num_buckets, std::max<size_t>(num, 1));
+    buckets_.clear();
+    for (size_t b = 0; b < num_buckets; ++b) {
+      buckets_.emplace_back(order.begin() + b * num / num_buckets,
+                            order.begin() + (b + 1) * num / num_buckets);
+    }
+    if (param_.shuffle) {
+      mshadow::Random<cpu> *ctx_rng = ResourceManager::Get()->Request(
+        Context::CPU(), ResourceRequest::kRandom).get_random<cpu, real_t>(nullptr);
+      rng_ = std::make_unique<common::RANDOM_ENGINE>(ctx_rng->GetSeed());
+    }
+    out_.data.resize(1);
+    out_.num_batch_padd = 0;
+    BeforeFirst();
+  }
+
+  void BeforeFirst() override {
+    indices_.clear();
+    batches_.clear();
+    for (auto& bucket : buckets_) {
+      if (param_.shuffle) std::shuffle(bucket.begin(), bucket.end(), *rng_);
+      size_t begin = indices_.size();
+      int64_t longest = 0;
+      for (const int64_t idx : bucket) {
+        const size_t count = indices_.size() - begin;
+        const int64_t len = std::max(longest, lengths_[idx]);
+        if (count > 0 && ((count + 1) * static_cast<size_t>(len) > param_.max_tokens ||
+                          (param_.batch_size > 0 && count >= param_.batch_size))) {
+          batches_.emplace_back(begin, indices_.size());
+          begin = indices_.size();
+          longest = lengths_[idx];
+        } else {
+          longest = len;
+        }
+        indices_.push_back(idx);
+      }
+      if (indices_.size() > begin) batches_.emplace_back(begin, indices_.size());
+    }
+    if (param_.shuffle) std::shuffle(batches_.begin(), batches_.end(), *rng_);
+    pos_ = 0;
+  }
+
+  int64_t GetLenHint() const override {
+    return static_cast<int64_t>(batches_.size());
+  }
+
+  bool Next() override {
+    if (pos_ < batches_.size()) {
+      const auto& batch = batches_[pos_];
+      out_.data[0] = NDArray(TBlob(indices_.data() + batch.first,
+                                   TShape({static_cast<index_t>(batch.second - batch.first)}),
+                                   cpu::kDevMask, 0), 0);
+      ++pos_;
+      return true;
+    }
+    return false;
+  }
+
+  const DataBatch &Value() const override {
+    return out_;
+  }
+
+ private:
+  /*! \brief length of each sample */
+  std::vector<int64_t> lengths_;
+  /*! \brief sample indices of each bucket, sorted by length */
+  std::vector<std::vector<int64_t> > buckets_;
+  /*! \brief sample indices of the batches of the epoch, one after the other */
+  std::vector<int64_t> indices_;
+  /*! \brief [begin, end) range in indices_ of each batch, in the order of the epoch */
+  std::vector<std::pair<size_t, size_t> > batches_;
+  /*! \brief current batch for iteration */
+  std::size_t pos_;
+  /*! \brief data for next value */
+  DataBatch out_;
+  /*! \brief random generator engine */
+  std::unique_ptr<std::mt19937> rng_;
+  /*! \brief arguments */
+  BucketSamplerParam param_;
+};  // class BucketSampler
+
+MXNET_REGISTER_IO_ITER(BucketSampler)
+.describe(R"code(Returns the length-bucketing batch sampler iterator, whose batches hold
+samples of similar lengths and are capped by their padded number of tokens.
+)code" ADD_FILELINE)
+.add_arguments(BucketSamplerParam::__FIELDS__())
+.set_body([]() {
+    return new BucketSampler();
+  });
+
 }  // namespace io
 }  // namespace mxnet
@@ -114,6 +114,7 @@ class SparsePrefetcherIter : public PrefetcherIter {
                     batch.inst_index + batch.batch_size,
                     (*dptr)->index.begin());
         }
+        queue_.Push();
        return true;
       },
       [this]() { sparse_loader_->BeforeFirst(); });
@@ -0,0 +1,101 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file mapped_file.h
+ * \brief memory mapping of the local files read by the datasets and iterators
+ */
+#ifndef MXNET_IO_MAPPED_FILE_H_
+#define MXNET_IO_MAPPED_FILE_H_
+
+#include <dmlc/logging.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <string>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif  // _WIN32
+
+namespace mxnet {
+namespace io {
+
+/*! \brief path of a local file given as a path or a file:// URI, empty for other URIs */
+inline std::string LocalPath(const std::string& uri) {
+  std::string path = uri;
+  if (path.compare(0, 7, "file://") == 0) path = path.substr(7);
+  return path.find("://") == std::string::npos ? path : std::string();
+}
+
+/*!
+ * \brief Copy-on-write mapping of a local file, so that arrays viewing the file can still
+ *  be written to without changing it.
+ */
+class MappedFile {
+ public:
+  explicit MappedFile(const std::string& path) {
+#ifndef _WIN32
+    int fd = open(path.c_str(), O_RDONLY);
+    CHECK_NE(fd, -1) << "Failed to open " << path << ": " << strerror(errno);
+    struct stat st;
+    CHECK_EQ(fstat(fd, &st), 0) << "Failed to stat " << path << ": " << strerror(errno);
+    size_ = st.st_size;
+    if (size_ > 0) {
+      void* ptr = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+      CHECK_NE(ptr, MAP_FAILED) << "Failed to map " << path << ": " << strerror(errno);
+      data_ = static_cast<char*>(ptr);
+    }
+    close(fd);
+#else
+    LOG(FATAL) << "Memory mapped files are not supported on Windows";
+#endif  // _WIN32
+  }
+
+  ~MappedFile() {
+#ifndef _WIN32
+    if (data_ != nullptr) munmap(data_, size_);
+#endif  // _WIN32
+  }
+
+  char* data() const { return data_; }
+  size_t size() const { return size_; }
+
+  /*! \brief let the kernel read the bytes [begin, end) ahead, returns at once */
+  void WillNeed(size_t begin, size_t end) const {
+#ifdef __linux__
+    static const size_t page = sysconf(_SC_PAGESIZE);
+    end = std::min(end, size_);
+    if (begin >= end) return;
+    const size_t aligned = begin / page * page;
+    madvise(data_ + aligned, end - aligned, MADV_WILLNEED);
+#endif  // __linux__
+  }
+
+ private:
+  char* data_{nullptr};
+  size_t size_{0};
+};
+
+}  // namespace io
+}  // namespace mxnet
+#endif  // MXNET_IO_MAPPED_FILE_H_
@@ -0,0 +1,216 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file record_shuffle_split.h
+ * \brief input split shuffling the records of a RecordIO partition through a shuffle buffer
+ *
+ *  The partition is read as several streams, the consecutive sub-partitions of the
+ *  partition, which each read large sequential chunks. The records of the chunks fill a
+ *  buffer of a fixed number of records, and every record returned is drawn uniformly from
+ *  the buffer, so that records far apart in the partition are mixed while the file is
+ *  still read sequentially.
+ */
+#ifndef MXNET_IO_RECORD_SHUFFLE_SPLIT_H_
+#define MXNET_IO_RECORD_SHUFFLE_SPLIT_H_
+
+#include <dmlc/common.h>
+#include <dmlc/io.h>
+#include <dmlc/logging.h>
+#include <dmlc/memory_io.h>
+#include <dmlc/omp.h>
+#include <dmlc/recordio.h>
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../common/utils.h"
+#include "../profiler/data_profiler.h"
+
+namespace mxnet {
+namespace io {
+
+/*! \brief RecordIO input split returning the records of a partition in shuffled order */
+class RecordShuffleSplit : public dmlc::InputSplit {
+ public:
+  /*!
+   * \brief constructor
+   * \param uri path of the RecordIO file or directory
+   * \param part_index index of the partition to read
+   * \param num_parts number of partitions
+   * \param num_streams number of sub-partitions read at the same time
+   * \param capacity number of records of the shuffle buffer
+   * \param seed random seed, the shuffle of each epoch is seeded with seed + epoch
+   */
+  RecordShuffleSplit(const std::string &uri, unsigned part_index, unsigned num_parts,
+                     unsigned num_streams, size_t capacity, int seed)
+      : capacity_(capacity), seed_(seed) {
+    CHECK_GT(num_streams, 0U);
+    CHECK_GT(capacity, 0U);
+    for (unsigned i = 0; i < num_streams; ++i) {
+      streams_.emplace_back(dmlc::InputSplit::Create(
+          uri.c_str(), part_index * num_streams + i, num_parts * num_streams, "recordio"));
+      streams_.back()->HintChunkSize(kStreamChunkSize);
+    }
+    chunks_.resize(num_streams);
+    buffer_.reserve(capacity);
+    Reset();
+  }
+
+  void HintChunkSize(size_t chunk_size) override {
+    for (auto &stream : streams_) stream->HintChunkSize(chunk_size);
+  }
+
+  size_t GetTotalSize() override {
+    size_t size = 0;
+    for (auto &stream : streams_) size += stream->GetTotalSize();
+    return size;
+  }
+
+  void BeforeFirst() override {
+    for (auto &stream : streams_) stream->BeforeFirst();
+    ++epoch_;
+    Reset();
+  }
+
+  void ResetPartition(unsigned part_index, unsigned num_parts) override {
+    const unsigned num_streams = streams_.size();
+    for (unsigned i = 0; i < num_streams; ++i) {
+      streams_[i]->ResetPartition(part_index * num_streams + i, num_parts * num_streams);
+    }
+    Reset();
+  }
+
+  bool NextRecord(Blob *out_rec) override {
+    if (!Draw(&record_)) return false;
+    out_rec->dptr = dmlc::BeginPtr(record_);
+    out_rec->size = record_.size();
+    return true;
+  }
+
+  bool NextChunk(Blob *out_chunk) override {
+    return NextBatch(out_chunk, kChunkRecords);
+  }
+
+  /*! \brief return a RecordIO chunk of the next n_records shuffled records */
+  bool NextBatch(Blob *out_chunk, size_t n_records) override {
+    chunk_.clear();
+    dmlc::MemoryStringStream stream(&chunk_);
+    dmlc::RecordIOWriter writer(&stream);
+    size_t n = 0;
+    for (; n < n_records && Draw(&record_); ++n) {
+      writer.WriteRecord(record_);
+    }
+    if (n == 0) return false;
+    out_chunk->dptr = dmlc::BeginPtr(chunk_);
+    out_chunk->size = chunk_.size();
+    return true;
+  }
+
+ private:
+  /*! \brief empty the buffer and seed the shuffle of the epoch */
+  void Reset() {
+    buffer_.clear();
+    pending_.clear();
+    next_pending_ = 0;
+    exhausted_ = false;
+    rnd_.seed(seed_ + epoch_);
+  }
+
+  /*! \brief read the next chunk of every stream into pending_, in parallel */
+  bool ReadChunks() {
+    const bool profiling = profiler::IsProfilingDataPipeline();
+    if (profiling) read_stage_.start();
+    const int num_streams = streams_.size();
+    #pragma omp parallel for num_threads(num_streams)
+    for (int i = 0; i < num_streams; ++i) {
+      omp_exc_.Run([&] {
+        chunks_[i].clear();
+        Blob chunk;
+        if (!streams_[i]->NextChunk(&chunk)) return;
+        dmlc::RecordIOChunkReader reader(chunk, 0, 1);
+        Blob rec;
+        while (reader.NextRecord(&rec)) {
+          chunks_[i].emplace_back(static_cast<char *>(rec.dptr), rec.size);
+        }
+      });
+    }
+    omp_exc_.Rethrow();
+    pending_.clear();
+    next_pending_ = 0;
+    for (auto &records : chunks_) {
+      std::move(records.begin(), records.end(), std::back_inserter(pending_));
+    }
+    if (profiling) read_stage_.stop(pending_.size());
+    return !pending_.empty();
+  }
+
+  /*! \brief fill the buffer and draw a record from it */
+  bool Draw(std::string *out) {
+    while (buffer_.size() < capacity_ && !exhausted_) {
+      if (next_pending_ == pending_.size() && !ReadChunks()) {
+        exhausted_ = true;
+        break;
+      }
+      buffer_.push_back(std::move(pending_[next_pending_++]));
+    }
+    if (buffer_.empty()) return false;
+    std::uniform_int_distribution<size_t> pick(0, buffer_.size() - 1);
+    const size_t i = pick(rnd_);
+    out->swap(buffer_[i]);
+    buffer_[i].swap(buffer_.back());
+    buffer_.pop_back();
+    return true;
+  }
+
+  /*! \brief size of the chunks read by each stream */
+  static constexpr size_t kStreamChunkSize = 16UL << 20UL;
+  /*! \brief number of records of a chunk returned by NextChunk */
+  static constexpr size_t kChunkRecords = 256;
+  /*! \brief sub-partitions of the partition */
+  std::vector<std::unique_ptr<dmlc::InputSplit>> streams_;
+  /*! \brief records of the last chunk of each stream */
+  std::vector<std::vector<std::string>> chunks_;
+  /*! \brief records read but not in the buffer yet, and the next of them */
+  std::vector<std::string> pending_;
+  size_t next_pending_{0};
+  /*! \brief shuffle buffer */
+  std::vector<std::string> buffer_;
+  /*! \brief number of records of the shuffle buffer */
+  const size_t capacity_;
+  /*! \brief whether all the streams reached the end of their sub-partition */
+  bool exhausted_{false};
+  /*! \brief random seed and current epoch */
+  const int seed_;
+  int epoch_{0};
+  common::RANDOM_ENGINE rnd_;
+  /*! \brief last record drawn and last chunk returned */
+  std::string record_, chunk_;
+  /*! \brief OMPException obj to store and rethrow exceptions from omp blocks*/
+  dmlc::OMPException omp_exc_;
+  /*! \brief profiled stage */
+  profiler::ProfileDataStage read_stage_{"ImageRecordIter::ShuffleRead"};
+};
+
+}  // namespace io
+}  // namespace mxnet
+#endif  // MXNET_IO_RECORD_SHUFFLE_SPLIT_H_
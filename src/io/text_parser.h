@@ -0,0 +1,360 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file text_parser.h
+ * \brief chunk-parallel parsing of text data files, such as CSV and LibSVM,
+ *  into blocks of rows that are appended to the batch buffers in bulk
+ */
+#ifndef MXNET_IO_TEXT_PARSER_H_
+#define MXNET_IO_TEXT_PARSER_H_
+
+#include <dmlc/io.h>
+#include <dmlc/logging.h>
+#include <dmlc/omp.h>
+#include <mxnet/base.h>
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../profiler/data_profiler.h"
+
+namespace mxnet {
+namespace io {
+
+/*! \return whether c separates the tokens of a line */
+inline bool IsBlank(char c) {
+  return c == ' ' || c == '\t' || c == '\r';
+}
+
+/*! \return whether c is a decimal digit */
+inline bool IsDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+/*! \return the first character of [begin, end) that is not blank */
+inline const char *SkipBlank(const char *begin, const char *end) {
+  while (begin != end && IsBlank(*begin)) ++begin;
+  return begin;
+}
+
+/*!
+ * \brief parse a token with strtod, for the forms the fast path does not handle,
+ *  e.g. more than 19 significant digits, large exponents, inf and nan
+ * \return the pointer past the number, or begin when there is no number
+ */
+inline const char *ParseRealSlow(const char *begin, const char *end, double *out) {
+  char buf[64];
+  size_t len = 0;
+  for (const char *p = begin; p != end && len + 1 < sizeof(buf); ++p, ++len) {
+    const char c = *p;
+    if (!std::isalnum(static_cast<unsigned char>(c)) && c != '+' && c != '-' && c != '.') break;
+    buf[len] = c;
+  }
+  buf[len] = '\0';
+  char *stop = nullptr;
+  *out = std::strtod(buf, &stop);
+  return begin + (stop - buf);
+}
+
+/*!
+ * \brief parse a decimal real number. The mantissa and exponent are accumulated as integers
+ *  and combined with one exactly rounded multiplication or division by a power of ten,
+ *  which covers the numbers written by common tools without calling strtod.
+ * \return the pointer past the number, or begin when there is no number
+ */
+inline const char *ParseReal(const char *begin, const char *end, double *out) {
+  static const double kPow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+  const char *p = begin;
+  bool negative = false;
+  if (p != end && (*p == '-' || *p == '+')) {
+    negative = *p == '-';
+    ++p;
+  }
+  uint64_t mantissa = 0;
+  int digits = 0, exp10 = 0;
+  bool has_digit = false;
+  for (; p != end && IsDigit(*p); ++p) {
+    has_digit = true;
+    if (mantissa != 0 || *p != '0') {
+      if (++digits > 19) return ParseRealSlow(begin, end, out);
+      mantissa = mantissa * 10 + (*p - '0');
+    }
+  }
+  if (p != end && *p == '.') {
+    for (++p; p != end && IsDigit(*p); ++p) {
+      has_digit = true;
+      if (mantissa != 0 || *p != '0') {
+        if (++digits > 19) return ParseRealSlow(begin, end, out);
+        mantissa = mantissa * 10 + (*p - '0');
+      }
+      --exp10;
+    }
+  }
+  if (!has_digit) return ParseRealSlow(begin, end, out);
+  if (p != end && (*p == 'e' || *p == 'E')) {
+    const char *q = p + 1;
+    bool negative_exp = false;
+    if (q != end && (*q == '-' || *q == '+')) {
+      negative_exp = *q == '-';
+      ++q;
+    }
+    if (q == end || !IsDigit(*q)) return ParseRealSlow(begin, end, out);
+    int e = 0;
+    for (; q != end && IsDigit(*q); ++q) {
+      if (e < 10000) e = e * 10 + (*q - '0');
+    }
+    exp10 += negative_exp ? -e : e;
+    p = q;
+  }
+  if (mantissa >= (uint64_t(1) << 53) || exp10 < -22 || exp10 > 22) {
+    return ParseRealSlow(begin, end, out);
+  }
+  double value = static_cast<double>(mantissa);
+  value = exp10 < 0 ? value / kPow10[-exp10] : value * kPow10[exp10];
+  *out = negative ? -value : value;
+  return p;
+}
+
+/*!
+ * \brief parse a number of type DType
+ * \return the pointer past the number, or begin when there is no number
+ */
+template<typename DType>
+inline const char *ParseNumber(const char *begin, const char *end, DType *out) {
+  double value = 0;
+  const char *p = ParseReal(begin, end, &value);
+  *out = static_cast<DType>(value);
+  return p;
+}
+
+/*! \brief integers are parsed exactly, falling back to a real number for forms such as 1.0 */
+template<>
+inline const char *ParseNumber<int64_t>(const char *begin, const char *end, int64_t *out) {
+  const char *p = begin;
+  bool negative = false;
+  if (p != end && (*p == '-' || *p == '+')) {
+    negative = *p == '-';
+    ++p;
+  }
+  const char *digits = p;
+  uint64_t value = 0;
+  for (; p != end && IsDigit(*p) && p - digits < 19; ++p) {
+    value = value * 10 + (*p - '0');
+  }
+  if (p == digits || (p != end && (IsDigit(*p) || *p == '.' || *p == 'e' || *p == 'E'))) {
+    double real = 0;
+    p = ParseReal(begin, end, &real);
+    *out = static_cast<int64_t>(real);
+    return p;
+  }
+  *out = negative ? -static_cast<int64_t>(value) : static_cast<int64_t>(value);
+  return p;
+}
+
+template<>
+inline const char *ParseNumber<int32_t>(const char *begin, const char *end, int32_t *out) {
+  int64_t value = 0;
+  const char *p = ParseNumber<int64_t>(begin, end, &value);
+  *out = static_cast<int32_t>(value);
+  return p;
+}
+
+/*!
+ * \brief split a range of text lines into nparts ranges of about the same size,
+ *  which start at line boundaries. The newlines are searched with memchr, which is
+ *  vectorized by the C library.
+ * \return the nparts + 1 boundaries of the ranges, some ranges may be empty
+ */
+inline std::vector<const char *> SplitLines(const char *begin, const char *end, int nparts) {
+  std::vector<const char *> bounds(nparts + 1, end);
+  bounds[0] = begin;
+  const size_t size = end - begin;
+  for (int i = 1; i < nparts; ++i) {
+    const char *p = std::max(begin + size / nparts * i, bounds[i - 1]);
+    const void *newline = p == end ? nullptr : std::memchr(p, '\n', end - p);
+    bounds[i] = newline == nullptr ? end : static_cast<const char *>(newline) + 1;
+  }
+  return bounds;
+}
+
+/*! \return the end of the line starting at begin, i.e. its newline or the end of the range */
+inline const char *LineEnd(const char *begin, const char *end) {
+  const void *newline = std::memchr(begin, '\n', end - begin);
+  return newline == nullptr ? end : static_cast<const char *>(newline);
+}
+
+/*!
+ * \brief rows parsed from text, laid out like a CSR matrix. The values of row i are
+ *  value[offset[i]:offset[i + 1]], with their column in index for sparse rows.
+ *  The block of a batch is exposed directly as the batch arrays.
+ */
+template<typename DType>
+struct TextRowBlock {
+  /*! \brief label of each row, empty when the rows have no label */
+  std::vector<real_t> label;
+  /*! \brief values of the rows */
+  std::vector<DType> value;
+  /*! \brief column of each value, empty for dense rows */
+  std::vector<int64_t> index;
+  /*! \brief offset of each row in value, i.e. the indptr of a CSR matrix */
+  std::vector<int64_t> offset;
+  /*! \brief error found while parsing, reported once the parallel region ends */
+  std::string error;
+
+  TextRowBlock() {
+    Clear();
+  }
+  /*! \brief remove all rows, keeping the memory */
+  void Clear() {
+    label.clear();
+    value.clear();
+    index.clear();
+    offset.assign(1, 0);
+    error.clear();
+  }
+  /*! \return number of rows */
+  size_t Size() const {
+    return offset.size() - 1;
+  }
+  /*! \brief append the rows [begin, end) of src */
+  void Append(const TextRowBlock &src, size_t begin, size_t end) {
+    const int64_t value_begin = src.offset[begin], value_end = src.offset[end];
+    value.insert(value.end(), src.value.begin() + value_begin, src.value.begin() + value_end);
+    if (!src.index.empty()) {
+      index.insert(index.end(), src.index.begin() + value_begin, src.index.begin() + value_end);
+    }
+    if (!src.label.empty()) {
+      label.insert(label.end(), src.label.begin() + begin, src.label.begin() + end);
+    }
+    const int64_t shift = offset.back() - value_begin;
+    for (size_t i = begin + 1; i <= end; ++i) {
+      offset.push_back(src.offset[i] + shift);
+    }
+  }
+};
+
+/*!
+ * \brief Reads a text file chunk by chunk. The lines of each chunk are split into one range
+ *  per thread, and the ranges are parsed in parallel into blocks of rows.
+ */
+template<typename DType>
+class ParallelTextReader {
+ public:
+  /*! \brief parses the lines in [begin, end) into the rows of a block */
+  typedef std::function<void(const char *begin, const char *end,
+                             TextRowBlock<DType> *out)> ParseFunction;
+  /*!
+   * \brief Constructor
+   * \param uri path of the file or directory
+   * \param part_index index of the part to read
+   * \param num_parts number of parts the data is partitioned into
+   * \param nthread number of parsing threads
+   * \param parse parsing function, called by the threads at once
+   * \param stage_name name of the parsing stage in the profiler
+   */
+  ParallelTextReader(const std::string &uri, int part_index, int num_parts, int nthread,
+                     ParseFunction parse, const char *stage_name)
+    : nthread_(std::max(nthread, 1)), parse_(parse), parse_stage_(stage_name) {
+    source_.reset(dmlc::InputSplit::Create(uri.c_str(), part_index, num_parts, "text"));
+    blocks_.resize(nthread_);
+    block_ = blocks_.size();
+  }
+  /*! \brief restart from the first line */
+  void BeforeFirst() {
+    source_->BeforeFirst();
+    for (auto &block : blocks_) block.Clear();
+    block_ = blocks_.size();
+    row_ = 0;
+  }
+  /*!
+   * \brief append the next rows to a block
+   * \param n maximal number of rows to append
+   * \param out block to append to
+   * \return number of rows appended, less than n only at the end of the data
+   */
+  size_t Take(size_t n, TextRowBlock<DType> *out) {
+    size_t taken = 0;
+    while (taken < n) {
+      if (block_ == blocks_.size()) {
+        if (!ParseNextChunk()) break;
+        continue;
+      }
+      const TextRowBlock<DType> &block = blocks_[block_];
+      const size_t end = std::min(block.Size(), row_ + n - taken);
+      out->Append(block, row_, end);
+      taken += end - row_;
+      row_ = end;
+      if (row_ == block.Size()) {
+        ++block_;
+        row_ = 0;
+      }
+    }
+    return taken;
+  }
+
+ private:
+  /*! \brief read and parse the next chunk, return false at the end of the data */
+  bool ParseNextChunk() {
+    dmlc::InputSplit::Blob chunk;
+    if (!source_->NextChunk(&chunk)) return false;
+    const bool profiling = profiler::IsProfilingDataPipeline();
+    if (profiling) parse_stage_.start();
+    const char *begin = static_cast<const char *>(chunk.dptr);
+    const std::vector<const char *> bounds = SplitLines(begin, begin + chunk.size, nthread_);
+    #pragma omp parallel for num_threads(nthread_)
+    for (int i = 0; i < nthread_; ++i) {
+      blocks_[i].Clear();
+      parse_(bounds[i], bounds[i + 1], &blocks_[i]);
+    }
+    size_t rows = 0;
+    for (const auto &block : blocks_) {
+      CHECK(block.error.empty()) << block.error;
+      rows += block.Size();
+    }
+    if (profiling) parse_stage_.stop(rows);
+    block_ = 0;
+    row_ = 0;
+    return true;
+  }
+
+  /*! \brief number of parsing threads */
+  const int nthread_;
+  /*! \brief parsing function */
+  ParseFunction parse_;
+  /*! \brief input source */
+  std::unique_ptr<dmlc::InputSplit> source_;
+  /*! \brief rows of the current chunk, one block per thread */
+  std::vector<TextRowBlock<DType> > blocks_;
+  /*! \brief position of the next row in blocks_ */
+  size_t block_{0}, row_{0};
+  /*! \brief profiler stage of the parsing */
+  profiler::ProfileDataStage parse_stage_;
+};
+
+}  // namespace io
+}  // namespace mxnet
+#endif  // MXNET_IO_TEXT_PARSER_H_
@@ -23,15 +23,18 @@
 #ifndef MXNET_KVSTORE_COMM_H_
 #define MXNET_KVSTORE_COMM_H_
 #include <dmlc/omp.h>
+#include <map>
 #include <string>
 #include <algorithm>
 #include <utility>
 #include <limits>
+#include <memory>
 #include <vector>
 #include <tuple>
 #include <thread>
 #include "mxnet/ndarray.h"
 #include "gradient_compression.h"
+#include "../engine/thread_budget.h"
 #include "../ndarray/ndarray_function.h"
 #include "../operator/tensor/sparse_retain-inl.h"
 #include "../profiler/profiler.h"
@@ -92,9 +95,35 @@ class Comm {
   }
 
  protected:
+  /**
+   * \brief whether the reduce of src quantizes the values. The compression of the reduce of
+   * a dist kvstore is intra_node, it only compresses what the GPUs send to the merging one.
+   */
+  bool CompressesReduce(const std::vector<NDArray>& src) const {
+    if (gc_ == nullptr || gc_->get_type() == CompressionType::kNone) return false;
+    return src.size() > 1 || !gc_->intra_node();
+  }
+
+  /**
+   * \brief staging array on ctx for the rows retained by a row_sparse_pull of key.
+   * It is reused by the following pulls, so that the retained rows are written into the
+   * same storage instead of being materialized in a new array for every pull.
+   */
+  NDArray RetainBuffer(int key, const Context& ctx, const mxnet::TShape& shape, int dtype,
+                       const std::vector<int>& aux_types) {
+    NDArray& buf = retain_buf_[std::make_pair(key, ctx)];
+    if (buf.is_none() || buf.shape() != shape || buf.dtype() != dtype) {
+      buf = NDArray(kRowSparseStorage, shape, ctx, true, dtype, aux_types);
+    }
+    return buf;
+  }
+
   Context pinned_ctx_;
 
   std::shared_ptr<GradientCompression> gc_;
+
+ private:
+  std::map<std::pair<int, Context>, NDArray> retain_buf_;
 };
 
 /**
@@ -104,7 +133,9 @@ class Comm {
 class CommCPU : public Comm {
  public:
   CommCPU() {
-    nthread_reduction_ = dmlc::GetEnv("MXNET_KVSTORE_REDUCTION_NTHREADS", 4);
+    budget_ = engine::ThreadBudget::Get()->Acquire(
+        "CPU kvstore reduction", dmlc::GetEnv("MXNET_KVSTORE_REDUCTION_NTHREADS", 4));
+    nthread_reduction_ = budget_->threads();
     bigarray_bound_ = dmlc::GetEnv("MXNET_KVSTORE_BIGARRAY_BOUND", 1000 * 1000);
     // TODO(junwu) delete the following data member, now for benchmark only
     is_serial_push_ = dmlc::GetEnv("MXNET_KVSTORE_SERIAL_PUSH", 0);
@@ -243,8 +274,7 @@ class CommCPU : public Comm {
       const bool is_same_ctx = out->ctx() == src.ctx();
       const bool is_diff_var = out->var() != src.var();
       NDArray retained_cpu = (is_same_ctx && is_diff_var) ? *out :
-          NDArray(kRowSparseStorage, src.shape(), src.ctx(), true,
-                  src.dtype(), src.aux_types());
+          RetainBuffer(key, src.ctx(), src.shape(), src.dtype(), src.aux_types());
       if (!is_diff_var) {
         common::LogOnce("The output of row_sparse_pull() on key " + std::to_string(key) +
                         "refers to the same NDArray as the one stored in KVStore."
@@ -438,6 +468,11 @@ class CommCPU : public Comm {
   std::unordered_map<int, BufferEntry> merge_buf_;
   size_t bigarray_bound_;
   int nthread_reduction_;
+  /*!
+   * \brief reduction threads leased from the thread budget. They are not bound to the
+   *        leased cores, as OMP reuses them for the other regions of the engine worker
+   */
+  std::unique_ptr<engine::ThreadBudget::Lease> budget_;
   bool is_serial_push_;
 };
 
@@ -503,9 +538,8 @@ class CommDevice : public Comm {
 
   const NDArray& Reduce(int key, const std::vector<NDArray>& src,
                         int priority) override {
-    // when this reduce is called from kvstore_dist, gc is not set
-    // we don't do compression twice in dist_sync_device
-    if ((gc_ != nullptr) && (gc_->get_type() != CompressionType::kNone)) {
+    // when this reduce is called from kvstore_dist, gc is only set for intra_node compression
+    if (CompressesReduce(src)) {
       return ReduceCompressed(key, src, priority);
     }
 
@@ -600,7 +634,7 @@ class CommDevice : public Comm {
       gc_->Dequantize(buf.compressed_recv_buf[i], &(buf.copy_buf[i]), priority);
       reduce[i] = buf.copy_buf[i];
     }
-    ElementwiseSum(reduce, &buf.merged);
+    ElementwiseSum(reduce, &buf.merged, priority);
     return buf.merged;
   }
 
@@ -642,8 +676,7 @@ class CommDevice : public Comm {
       const bool is_same_ctx = out->ctx() == src.ctx();
       const bool is_diff_var = out->var() != src.var();
       NDArray retained_gpu = (is_same_ctx && is_diff_var) ? *out :
-          NDArray(kRowSparseStorage, out->shape(), src.ctx(), true,
-                  out->dtype(), out->aux_types());
+          RetainBuffer(key, src.ctx(), out->shape(), out->dtype(), out->aux_types());
       if (!is_diff_var) {
         common::LogOnce("The output of row_sparse_pull() on key " + std::to_string(key) +
                         "refers to the same NDArray as the one stored in KVStore."
@@ -667,8 +700,8 @@ class CommDevice : public Comm {
             case gpu::kDevMask: {
               SparseRetainOpForwardRspWrapper<gpu>(rctx.get_stream<gpu>(),
                   src, indices, kWriteTo, &temp);
-              // wait for GPU operations to complete
-              rctx.get_stream<gpu>()->Wait();
+              // wait for GPU operations to complete, unless the engine tracks them
+              if (!rctx.event_sync) rctx.get_stream<gpu>()->Wait();
               break;
             }
 #endif
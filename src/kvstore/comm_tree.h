@@ -25,6 +25,8 @@
 #include <dmlc/omp.h>
 #include <string>
 #include <algorithm>
+#include <fstream>
+#include <sstream>
 #include <utility>
 #include <limits>
 #include <vector>
@@ -46,6 +48,11 @@ namespace kvstore {
  * It is faster if the total device-to-device bandwidths is larger than
  * device-to-cpu, which is often true for 4 or 8 GPUs. But it uses more device
  * memory.
+ *
+ * The arrays from a size on are reduced by one tree per GPU, each reducing a slice.
+ * The size is MXNET_KVSTORE_TREE_ARRAY_BOUND elements, or with
+ * MXNET_KVSTORE_TREE_MEASURE the size in bytes found by a model of the measured links.
+ * The trees can be cached in the file MXNET_KVSTORE_TREE_CACHE across runs.
  */
 class CommDeviceTree : public CommDevice {
  public:
@@ -54,6 +61,8 @@ class CommDeviceTree : public CommDevice {
     gpuarray_bound_ = dmlc::GetEnv("MXNET_KVSTORE_TREE_ARRAY_BOUND", 10000000);
     backtrack_ = dmlc::GetEnv("MXNET_KVSTORE_TREE_BACKTRACK", 0);
     link_usage_penalty_ = dmlc::GetEnv("MXNET_KVSTORE_TREE_LINK_USAGE_PENALTY", 0.7);
+    measure_ = dmlc::GetEnv("MXNET_KVSTORE_TREE_MEASURE", false);
+    cache_file_ = dmlc::GetEnv("MXNET_KVSTORE_TREE_CACHE", std::string());
   }
 
   virtual ~CommDeviceTree() { }
@@ -178,9 +187,8 @@ class CommDeviceTree : public CommDevice {
 
   const NDArray& Reduce(int key, const std::vector<NDArray>& src,
                         int priority) override {
-    // when this reduce is called from kvstore_dist, gc is not set
-    // we don't do compression twice in dist_sync_device
-    if ((gc_ != nullptr) && (gc_->get_type() != CompressionType::kNone)) {
+    // when this reduce is called from kvstore_dist, gc is only set for intra_node compression
+    if (CompressesReduce(src)) {
       return ReduceCompressed(key, src, priority);
     }
 
@@ -195,16 +203,13 @@ class CommDeviceTree : public CommDevice {
     std::vector<std::vector<NDArray*>> broadcast_slice(devs_.size());
     std::vector<int>                   slice_scan(devs_.size()+1);
 
-    int total_size = src[0].shape().Size();
-    unsigned first_size = src[0].shape()[0];
-
     const NDArrayStorageType stype = src[0].storage_type();
     // normal dense reduce
     if (stype == kDefaultStorage) {
-      if (total_size > gpuarray_bound_ && first_size >= 2*devs_.size()) {
+      if (MultiRoot(src[0].shape(), src[0].dtype())) {
         // Find slice bounds
         slice_scan[0] = 0;
-        int slice_size = first_size/devs_.size();
+        int slice_size = src[0].shape()[0]/devs_.size();
         for (unsigned i = 1; i < devs_.size(); ++i) {
           slice_scan[i] = slice_scan[i-1] + slice_size;
         }
@@ -292,12 +297,10 @@ class CommDeviceTree : public CommDevice {
         }
       }
     } else {
-      int total_size = src.shape().Size();
-      unsigned first_size = src.shape()[0];
       const NDArrayStorageType stype = src.storage_type();
       // normal dense reduce
       if (stype == kDefaultStorage) {
-      if (total_size > gpuarray_bound_ && first_size >= 2*devs_.size()) {
+      if (MultiRoot(src.shape(), src.dtype())) {
         std::vector<int> slice_scan(devs_.size()+1);
         slice_scan[0] = 0;
         int slice_size = (dst[0]->shape()[0])/devs_.size();
@@ -325,6 +328,136 @@ class CommDeviceTree : public CommDevice {
   }
 
  private:
+  /**
+   * \brief whether an array is reduced by one tree per GPU rather than by one tree
+   */
+  bool MultiRoot(const mxnet::TShape& shape, int dtype) const {
+    if (static_cast<size_t>(shape[0]) < 2*devs_.size())
+      return false;
+    if (bound_bytes_ >= 0)
+      return static_cast<int64_t>(shape.Size()) * mshadow::mshadow_sizeof(dtype) > bound_bytes_;
+    return static_cast<int64_t>(shape.Size()) > gpuarray_bound_;
+  }
+
+  /**
+   * \brief bytes from which one tree per GPU reduces faster than one tree
+   *
+   * With latency a and seconds per byte b of the links in the trees, one tree of
+   * depth d reduces S bytes in about d*(a + S*b). The trees of the n GPUs each
+   * reduce S/n bytes, so each level makes n copies spread over the L links used,
+   * in about d*(n*a + n*S*b/(2*L)).
+   */
+  int64_t ModelBound(const std::vector<float>& weight, const std::vector<float>& latency,
+                     const std::vector<float>& bandwidth) const {
+    const int n = devs_.size();
+    double a = 0, b = 0;
+    int links = 0;
+    for (int i = 0; i < n*n; ++i) {
+      if (weight[i] > 0 && i / n != i % n) {
+        a += latency[i];
+        b += 1. / bandwidth[i];
+        ++links;
+      }
+    }
+    if (links == 0)
+      return -1;
+    a /= links;
+    b /= links;
+    // both directions of a link were counted
+    const double gain = 1. - n / static_cast<double>(links);
+    if (gain <= 0)
+      return std::numeric_limits<int64_t>::max();
+    return static_cast<int64_t>(a * (n - 1) / (b * gain));
+  }
+
+  /**
+   * \brief key of the cached trees: the devices, the links and the tree options
+   */
+  std::string TreeSignature(const std::vector<float>& link_matrix,
+                            const std::vector<int>& p2p_matrix) const {
+    std::ostringstream os;
+    for (const auto& d : devs_)
+      os << d.dev_id << ',';
+    os << "links:";
+    for (auto v : link_matrix)
+      os << v << ',';
+    for (auto v : p2p_matrix)
+      os << v;
+    os << ";backtrack:" << backtrack_ << ";penalty:" << link_usage_penalty_
+       << ";measure:" << measure_;
+    return os.str();
+  }
+
+  static std::string JoinRows(const std::vector<std::vector<size_t>>& rows) {
+    std::ostringstream os;
+    for (size_t i = 0; i < rows.size(); ++i) {
+      if (i > 0)
+        os << ';';
+      for (size_t j = 0; j < rows[i].size(); ++j)
+        os << (j > 0 ? "," : "") << rows[i][j];
+    }
+    return os.str();
+  }
+
+  static bool SplitRows(const std::string& str, std::vector<std::vector<size_t>>* rows) {
+    rows->clear();
+    std::istringstream rs(str);
+    std::string row, value;
+    while (std::getline(rs, row, ';')) {
+      rows->emplace_back();
+      std::istringstream vs(row);
+      while (std::getline(vs, value, ',')) {
+        std::istringstream is(value);
+        size_t v;
+        if (!(is >> v))
+          return false;
+        rows->back().push_back(v);
+      }
+    }
+    return true;
+  }
+
+  /**
+   * \brief read the trees of the signature from the cache file
+   *
+   * Every line of the file is a signature, the bound in bytes, the trees and their
+   * level starts, separated by tabs.
+   */
+  bool LoadTrees(const std::string& signature) {
+    std::ifstream is(cache_file_);
+    std::string line;
+    while (std::getline(is, line)) {
+      std::istringstream ls(line);
+      std::string sig, bound, topo, scan;
+      if (!std::getline(ls, sig, '\t') || sig != signature)
+        continue;
+      std::getline(ls, bound, '\t');
+      std::getline(ls, topo, '\t');
+      std::getline(ls, scan, '\t');
+      std::istringstream bs(bound);
+      const size_t n = devs_.size();
+      if (!(bs >> bound_bytes_) || !SplitRows(topo, &topology_) || !SplitRows(scan, &scan_) ||
+          topology_.size() != n || scan_.size() != n) {
+        LOG(WARNING) << "Ignoring the malformed trees cached in " << cache_file_;
+        bound_bytes_ = -1;
+        return false;
+      }
+      return true;
+    }
+    return false;
+  }
+
+  void SaveTrees(const std::string& signature) const {
+    std::ostringstream os;
+    os << signature << '\t' << bound_bytes_ << '\t' << JoinRows(topology_) << '\t'
+       << JoinRows(scan_) << '\n';
+    // a single write keeps the line whole when the workers of a server share the file
+    std::ofstream file(cache_file_, std::ios::app);
+    file << os.str() << std::flush;
+    if (!file)
+      LOG(WARNING) << "Failed to cache the trees in " << cache_file_;
+  }
+
   void EnableP2P(std::vector<int>* p2p) {
 #if MXNET_USE_CUDA
     std::vector<int> gpus;
@@ -374,14 +507,28 @@ class CommDeviceTree : public CommDevice {
     std::vector<int> p2p_matrix(devs_.size()*devs_.size());
     EnableP2P(&p2p_matrix);
     GetP2PWeight(devs_, p2p_matrix, &link_matrix);
+    depth_ = ComputeDepth(devs_.size());
+    const std::string signature = TreeSignature(link_matrix, p2p_matrix);
+    if (!cache_file_.empty() && LoadTrees(signature)) {
+      LOG(INFO) << "Using the trees cached in " << cache_file_;
+      return;
+    }
+    if (measure_) {
+      std::vector<float> latency, bandwidth;
+      MeasureP2PLinks(devs_, &latency, &bandwidth);
+      GetMeasuredWeight(bandwidth, devs_.size(), &link_matrix);
+      bound_bytes_ = ModelBound(link_matrix, latency, bandwidth);
+      LOG(INFO) << "Using one tree per GPU for the arrays larger than "
+                << bound_bytes_ << " bytes";
+    }
     if (backtrack_)
       LOG(INFO) << "Using Backtracking to generate trees";
     else
       LOG(INFO) << "Using Kernighan-Lin to generate trees";
     ComputeTrees(link_matrix, devs_.size(), link_usage_penalty_, backtrack_,
         &topology_, &scan_);
-
-    depth_ = ComputeDepth(devs_.size());
+    if (!cache_file_.empty())
+      SaveTrees(signature);
 #endif
   }
 
@@ -448,9 +595,8 @@ class CommDeviceTree : public CommDevice {
         // buf.merged enforces that we only visit each GPU once
         if (buf.merged.empty()) {
           mxnet::TShape shape_copy = shape;
-          int total_size = shape.Size();
           unsigned first_size = shape[0];
-          if (total_size > gpuarray_bound_ && first_size >= 2*devs_.size()) {
+          if (MultiRoot(shape, type)) {
             // Find slice bounds
             int slice_size = first_size/devs_.size();
             int last_slice = first_size-(devs_.size()-1)*slice_size;
@@ -531,6 +677,12 @@ class CommDeviceTree : public CommDevice {
   int gpuarray_bound_;
   bool backtrack_;
   float link_usage_penalty_;
+  /// \brief whether the link weights and bound_bytes_ come from measured copies
+  bool measure_;
+  /// \brief file caching the trees across runs, none if empty
+  std::string cache_file_;
+  /// \brief bytes from which one tree per GPU is used, gpuarray_bound_ if negative
+  int64_t bound_bytes_ = -1;
 
   /// \brief constant for maximum size of recv buffer per GPU
   ///        2: only receive from 1 other GPU
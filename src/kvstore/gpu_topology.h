@@ -25,6 +25,7 @@
 #if MXNET_USE_CUDA
   #include <cuda_runtime_api.h>
   #include <cuda.h>
+  #include "../common/cuda/utils.h"
 #endif
 #include <iostream>
 #include <vector>
@@ -251,6 +252,102 @@ inline void GetP2PWeight(const std::vector<Context>& devs,
 #endif
 }
 
+/**
+ * \brief Measure the copies between every pair of GPUs
+ * \param devs is a vector of GPU contexts
+ * \param latency is the seconds of a small copy from row to col
+ * \param bandwidth is the bytes per second of a large copy from row to col
+ */
+inline void MeasureP2PLinks(const std::vector<Context>& devs,
+                            std::vector<float>* latency,
+                            std::vector<float>* bandwidth) {
+  int num_gpus = devs.size();
+  latency->assign(num_gpus*num_gpus, 0);
+  bandwidth->assign(num_gpus*num_gpus, 0);
+#if MXNET_USE_CUDA
+  const size_t small_bytes = 4 << 10;
+  const size_t large_bytes = 32 << 20;
+  const int repeat = 5;
+  std::vector<void*> bufs(num_gpus);
+  for (int i = 0; i < num_gpus; ++i) {
+    mxnet::common::cuda::DeviceStore device_store(devs[i].dev_id);
+    CUDA_CALL(cudaMalloc(&bufs[i], large_bytes));
+  }
+  for (int row = 0; row < num_gpus; ++row) {
+    mxnet::common::cuda::DeviceStore device_store(devs[row].dev_id);
+    cudaStream_t stream;
+    cudaEvent_t start, stop;
+    CUDA_CALL(cudaStreamCreateWithFlags(&stream, cudaStreamNonBlocking));
+    CUDA_CALL(cudaEventCreate(&start));
+    CUDA_CALL(cudaEventCreate(&stop));
+    for (int col = 0; col < num_gpus; ++col) {
+      if (row == col)
+        continue;
+      auto time = [&](size_t bytes) {
+        // the first copy sets up the link
+        CUDA_CALL(cudaMemcpyPeerAsync(bufs[col], devs[col].dev_id, bufs[row],
+                                      devs[row].dev_id, bytes, stream));
+        CUDA_CALL(cudaEventRecord(start, stream));
+        for (int i = 0; i < repeat; ++i) {
+          CUDA_CALL(cudaMemcpyPeerAsync(bufs[col], devs[col].dev_id, bufs[row],
+                                        devs[row].dev_id, bytes, stream));
+        }
+        CUDA_CALL(cudaEventRecord(stop, stream));
+        CUDA_CALL(cudaEventSynchronize(stop));
+        float ms;
+        CUDA_CALL(cudaEventElapsedTime(&ms, start, stop));
+        return ms * 1e-3f / repeat;
+      };
+      float small_time = time(small_bytes);
+      float large_time = time(large_bytes);
+      (*latency)[row*num_gpus+col] = small_time;
+      (*bandwidth)[row*num_gpus+col] =
+          (large_bytes - small_bytes) / std::max(large_time - small_time, 1e-9f);
+    }
+    CUDA_CALL(cudaEventDestroy(start));
+    CUDA_CALL(cudaEventDestroy(stop));
+    CUDA_CALL(cudaStreamDestroy(stream));
+  }
+  for (int i = 0; i < num_gpus; ++i) {
+    mxnet::common::cuda::DeviceStore device_store(devs[i].dev_id);
+    CUDA_CALL(cudaFree(bufs[i]));
+  }
+  if (kLogTree) {
+    PrintMatrix("Latency", *latency, num_gpus, num_gpus);
+    PrintMatrix("Bandwidth", *bandwidth, num_gpus, num_gpus);
+  }
+#else
+  LOG(WARNING) << "GPU required for link topology";
+#endif
+}
+
+/**
+ * \brief Generate adjacency matrix from the measured bandwidths
+ *
+ * The weight of a link is its bandwidth relative to the fastest link, so that
+ * the NVSwitch, NVLink, PCI-E switch and PCI-E through CPU links of a server stand
+ * apart without being named. As in GetP2PWeight, if the links at least half as fast
+ * as the fastest connect all the GPUs, only they are used.
+ */
+template <typename T>
+inline void GetMeasuredWeight(const std::vector<float>& bandwidth, int num_gpus,
+                              std::vector<T>* matrix) {
+  float max_bandwidth = *std::max_element(bandwidth.begin(), bandwidth.end());
+  std::vector<int> fast(num_gpus*num_gpus, 0);
+  for (int i = 0; i < num_gpus*num_gpus; ++i) {
+    (*matrix)[i] = static_cast<T>(bandwidth[i] / max_bandwidth);
+    fast[i] = (2*bandwidth[i] >= max_bandwidth) ? 2 : 0;
+  }
+  if (IsConnected(fast, num_gpus)) {
+    for (int i = 0; i < num_gpus*num_gpus; ++i) {
+      if (fast[i] == 0)
+        (*matrix)[i] = 0;
+    }
+  }
+  if (kLogTree)
+    PrintMatrix("Weight", *matrix, num_gpus, num_gpus);
+}
+
 /**
  * \brief Dense matrix-vector multiplication
  * Assume: matrix is square
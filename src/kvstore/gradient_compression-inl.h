@@ -26,6 +26,7 @@
 #define MXNET_KVSTORE_GRADIENT_COMPRESSION_INL_H_
 
 #include <vector>
+#include "./gradient_compression.h"
 #include "../operator/mxnet_op.h"
 
 namespace mxnet {
@@ -36,6 +37,18 @@ void Quantize2BitImpl(mshadow::Stream<mshadow::gpu> *s, const std::vector<mxnet:
                       const float threshold);
 void Dequantize2BitImpl(mshadow::Stream<mshadow::gpu> *s, const std::vector<mxnet::TBlob> &inputs,
                         const float threshold);
+void Quantize1BitImpl(mshadow::Stream<mshadow::gpu> *s, const std::vector<mxnet::TBlob> &inputs,
+                      const float threshold);
+void Dequantize1BitImpl(mshadow::Stream<mshadow::gpu> *s, const std::vector<mxnet::TBlob> &inputs,
+                        const float threshold);
+void SparsifyImpl(mshadow::Stream<mshadow::gpu> *s, const std::vector<mxnet::TBlob> &inputs,
+                  const int block_size, const bool random, const uint32_t seed);
+void DesparsifyImpl(mshadow::Stream<mshadow::gpu> *s, const std::vector<mxnet::TBlob> &inputs,
+                    const int block_size);
+void Quantize16BitImpl(mshadow::Stream<mshadow::gpu> *s, const std::vector<mxnet::TBlob> &inputs,
+                       const bool bfloat);
+void Dequantize16BitImpl(mshadow::Stream<mshadow::gpu> *s,
+                         const std::vector<mxnet::TBlob> &inputs, const bool bfloat);
 
 struct quantize_2bit {
   MSHADOW_XINLINE static void Map(int out_block_id,
@@ -138,6 +151,238 @@ void Dequantize2BitKernelLaunch(mshadow::Stream<xpu> *s, const std::vector<mxnet
           threshold);               // positive threshold
 }
 
+struct quantize_1bit {
+  MSHADOW_XINLINE static void Map(int out_block_id,
+                                  int original_size,
+                                  float *out,
+                                  float *grad,
+                                  float *residual,
+                                  const float threshold) {
+    // this block contains the signs of upto 32 values starting from out_block_id*32
+    const int start = out_block_id << 5;
+    const int end = (start + 32 <= original_size) ? start + 32 : original_size;
+    uint32_t bits = 0;
+    for (int i = start; i < end; i++) {
+      // the value sent is +threshold or -threshold, the residual keeps the error
+      residual[i] += grad[i];
+      if (residual[i] >= 0) {
+        bits |= 1U << (i - start);
+        residual[i] -= threshold;
+      } else {
+        residual[i] += threshold;
+      }
+    }
+    *reinterpret_cast<uint32_t *>(out + out_block_id) = bits;
+  }
+};
+
+template<typename xpu>
+void Quantize1BitKernelLaunch(mshadow::Stream<xpu> *s, const std::vector<mxnet::TBlob> &inputs,
+                              const float threshold) {
+  mxnet::op::mxnet_op::Kernel<quantize_1bit, xpu>
+    ::Launch(s,
+            inputs[2].Size(),         // compressed array size
+            inputs[0].Size(),         // original size
+            inputs[2].dptr<float>(),  // compressed array
+            inputs[0].dptr<float>(),  // original array
+            inputs[1].dptr<float>(),  // residual array
+            threshold);
+}
+
+struct dequantize_1bit {
+  MSHADOW_XINLINE static void Map(int i,
+                                  float *out,
+                                  float *in,
+                                  const float threshold) {
+    const uint32_t bits = *reinterpret_cast<uint32_t *>(in + (i >> 5));
+    out[i] = ((bits >> (i & 31)) & 1) ? threshold : -threshold;
+  }
+};
+
+template<typename xpu>
+void Dequantize1BitKernelLaunch(mshadow::Stream<xpu> *s, const std::vector<mxnet::TBlob> &inputs,
+                                const float threshold) {
+  mxnet::op::mxnet_op::Kernel<dequantize_1bit, xpu>
+  ::Launch(s,
+          inputs[1].Size(),         // original size
+          inputs[1].dptr<float>(),  // out array
+          inputs[0].dptr<float>(),  // compressed array
+          threshold);
+}
+
+/*!
+ * \brief keeps one value out of each block of block_size values: the largest in magnitude
+ *  for top-k, a random one for random-k. The compressed value packs the offset of the value
+ *  in the block in its 16 high bits and the value as float16 in its 16 low bits.
+ */
+struct sparsify_block {
+  MSHADOW_XINLINE static uint32_t Hash(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352dU;
+    x ^= x >> 15;
+    x *= 0x846ca68bU;
+    x ^= x >> 16;
+    return x;
+  }
+
+  MSHADOW_XINLINE static void Map(int out_block_id,
+                                  int original_size,
+                                  int block_size,
+                                  float *out,
+                                  float *grad,
+                                  float *residual,
+                                  const bool random,
+                                  const uint32_t seed) {
+    const int start = out_block_id * block_size;
+    const int end = (start + block_size <= original_size) ? start + block_size : original_size;
+    int pick = start;
+    float best = -1;
+    for (int i = start; i < end; i++) {
+      residual[i] += grad[i];
+      const float magnitude = residual[i] < 0 ? -residual[i] : residual[i];
+      if (magnitude > best) {
+        best = magnitude;
+        pick = i;
+      }
+    }
+    if (random) {
+      pick = start + Hash(static_cast<uint32_t>(out_block_id) * 0x9e3779b9U + seed) %
+                     static_cast<uint32_t>(end - start);
+    }
+    // clip to the float16 range, the residual keeps the rest
+    const float kHalfMax = 65504.f;
+    float kept = residual[pick];
+    kept = kept > kHalfMax ? kHalfMax : (kept < -kHalfMax ? -kHalfMax : kept);
+    const mshadow::half::half_t value(kept);
+    residual[pick] -= static_cast<float>(value);
+    *reinterpret_cast<uint32_t *>(out + out_block_id) =
+        (static_cast<uint32_t>(pick - start) << 16) | value.half_;
+  }
+};
+
+template<typename xpu>
+void SparsifyKernelLaunch(mshadow::Stream<xpu> *s, const std::vector<mxnet::TBlob> &inputs,
+                          const int block_size, const bool random, const uint32_t seed) {
+  mxnet::op::mxnet_op::Kernel<sparsify_block, xpu>
+    ::Launch(s,
+            inputs[2].Size(),         // compressed array size
+            inputs[0].Size(),         // original size
+            block_size,
+            inputs[2].dptr<float>(),  // compressed array
+            inputs[0].dptr<float>(),  // original array
+            inputs[1].dptr<float>(),  // residual array
+            random,
+            seed);
+}
+
+struct desparsify_block {
+  MSHADOW_XINLINE static void Map(int out_block_id,
+                                  int original_size,
+                                  int block_size,
+                                  float *out,
+                                  float *in) {
+    const int start = out_block_id * block_size;
+    const int end = (start + block_size <= original_size) ? start + block_size : original_size;
+    for (int i = start; i < end; i++) {
+      out[i] = 0;
+    }
+    const uint32_t code = *reinterpret_cast<uint32_t *>(in + out_block_id);
+    const mshadow::half::half_t value = mshadow::half::half_t::Binary(code & 0xffff);
+    out[start + (code >> 16)] = static_cast<float>(value);
+  }
+};
+
+template<typename xpu>
+void DesparsifyKernelLaunch(mshadow::Stream<xpu> *s, const std::vector<mxnet::TBlob> &inputs,
+                            const int block_size) {
+  mxnet::op::mxnet_op::Kernel<desparsify_block, xpu>
+  ::Launch(s,
+          inputs[0].Size(),         // compressed array size
+          inputs[1].Size(),         // original size
+          block_size,
+          inputs[1].dptr<float>(),  // out array
+          inputs[0].dptr<float>());  // compressed array
+}
+
+/*!
+ * \brief casts values to float16 or bfloat16, two of them per compressed value. The value
+ *  2i is in the 16 low bits of the compressed value i, the value 2i+1 in its 16 high bits.
+ */
+struct quantize_16bit {
+  MSHADOW_XINLINE static uint32_t Encode(const float value, const bool bfloat) {
+    if (bfloat) {
+      const uint32_t bits = *reinterpret_cast<const uint32_t *>(&value);
+      if ((bits & 0x7fffffffU) > 0x7f800000U) return 0x7fc0;  // NaN
+      // round to nearest even
+      return (bits + 0x7fffU + ((bits >> 16) & 1)) >> 16;
+    }
+    // clip to the float16 range, the residual keeps the rest
+    const float kHalfMax = 65504.f;
+    const float kept = value > kHalfMax ? kHalfMax : (value < -kHalfMax ? -kHalfMax : value);
+    return mshadow::half::half_t(kept).half_;
+  }
+
+  MSHADOW_XINLINE static float Decode(const uint32_t code, const bool bfloat) {
+    if (bfloat) {
+      const uint32_t bits = code << 16;
+      return *reinterpret_cast<const float *>(&bits);
+    }
+    return static_cast<float>(mshadow::half::half_t::Binary(static_cast<uint16_t>(code)));
+  }
+
+  MSHADOW_XINLINE static void Map(int out_id,
+                                  int original_size,
+                                  float *out,
+                                  float *grad,
+                                  float *residual,
+                                  const bool bfloat) {
+    const int start = out_id << 1;
+    const int end = (start + 2 <= original_size) ? start + 2 : original_size;
+    uint32_t packed = 0;
+    for (int i = start; i < end; i++) {
+      residual[i] += grad[i];
+      const uint32_t code = Encode(residual[i], bfloat);
+      residual[i] -= Decode(code, bfloat);
+      packed |= code << ((i - start) << 4);
+    }
+    *reinterpret_cast<uint32_t *>(out + out_id) = packed;
+  }
+};
+
+template<typename xpu>
+void Quantize16BitKernelLaunch(mshadow::Stream<xpu> *s, const std::vector<mxnet::TBlob> &inputs,
+                               const bool bfloat) {
+  mxnet::op::mxnet_op::Kernel<quantize_16bit, xpu>
+    ::Launch(s,
+            inputs[2].Size(),         // compressed array size
+            inputs[0].Size(),         // original size
+            inputs[2].dptr<float>(),  // compressed array
+            inputs[0].dptr<float>(),  // original array
+            inputs[1].dptr<float>(),  // residual array
+            bfloat);
+}
+
+struct dequantize_16bit {
+  MSHADOW_XINLINE static void Map(int i,
+                                  float *out,
+                                  float *in,
+                                  const bool bfloat) {
+    const uint32_t packed = *reinterpret_cast<uint32_t *>(in + (i >> 1));
+    out[i] = quantize_16bit::Decode((packed >> ((i & 1) << 4)) & 0xffff, bfloat);
+  }
+};
+
+template<typename xpu>
+void Dequantize16BitKernelLaunch(mshadow::Stream<xpu> *s,
+                                 const std::vector<mxnet::TBlob> &inputs, const bool bfloat) {
+  mxnet::op::mxnet_op::Kernel<dequantize_16bit, xpu>
+  ::Launch(s,
+          inputs[1].Size(),         // original size
+          inputs[1].dptr<float>(),  // out array
+          inputs[0].dptr<float>(),  // compressed array
+          bfloat);
+}
+
 inline void Quantize2BitImpl(mshadow::Stream<mshadow::cpu> *s,
                              const std::vector<mxnet::TBlob> &inputs,
                              const float threshold) {
@@ -149,6 +394,95 @@ inline void Dequantize2BitImpl(mshadow::Stream<mshadow::cpu> *s,
                                const float threshold) {
   Dequantize2BitKernelLaunch(s, inputs, threshold);
 }
+
+inline void Quantize1BitImpl(mshadow::Stream<mshadow::cpu> *s,
+                             const std::vector<mxnet::TBlob> &inputs,
+                             const float threshold) {
+  Quantize1BitKernelLaunch(s, inputs, threshold);
+}
+
+inline void Dequantize1BitImpl(mshadow::Stream<mshadow::cpu> *s,
+                               const std::vector<mxnet::TBlob> &inputs,
+                               const float threshold) {
+  Dequantize1BitKernelLaunch(s, inputs, threshold);
+}
+
+inline void SparsifyImpl(mshadow::Stream<mshadow::cpu> *s,
+                         const std::vector<mxnet::TBlob> &inputs,
+                         const int block_size, const bool random, const uint32_t seed) {
+  SparsifyKernelLaunch(s, inputs, block_size, random, seed);
+}
+
+inline void DesparsifyImpl(mshadow::Stream<mshadow::cpu> *s,
+                           const std::vector<mxnet::TBlob> &inputs,
+                           const int block_size) {
+  DesparsifyKernelLaunch(s, inputs, block_size);
+}
+
+inline void Quantize16BitImpl(mshadow::Stream<mshadow::cpu> *s,
+                              const std::vector<mxnet::TBlob> &inputs,
+                              const bool bfloat) {
+  Quantize16BitKernelLaunch(s, inputs, bfloat);
+}
+
+inline void Dequantize16BitImpl(mshadow::Stream<mshadow::cpu> *s,
+                                const std::vector<mxnet::TBlob> &inputs,
+                                const bool bfloat) {
+  Dequantize16BitKernelLaunch(s, inputs, bfloat);
+}
+
+/*!
+ * \brief compresses inputs[0] into inputs[2], accumulating the error into inputs[1]
+ */
+template<typename xpu>
+void QuantizeImpl(mshadow::Stream<xpu> *s, const std::vector<mxnet::TBlob> &inputs,
+                  const CompressionType type, const float threshold, const int block_size,
+                  const uint32_t seed) {
+  switch (type) {
+    case CompressionType::kTwoBit:
+      Quantize2BitImpl(s, inputs, threshold);
+      break;
+    case CompressionType::kOneBit:
+      Quantize1BitImpl(s, inputs, threshold);
+      break;
+    case CompressionType::kTopK:
+    case CompressionType::kRandomK:
+      SparsifyImpl(s, inputs, block_size, type == CompressionType::kRandomK, seed);
+      break;
+    case CompressionType::kFloat16:
+    case CompressionType::kBfloat16:
+      Quantize16BitImpl(s, inputs, type == CompressionType::kBfloat16);
+      break;
+    default:
+      LOG(FATAL) << "Unsupported quantization of type " << static_cast<int>(type);
+  }
+}
+
+/*!
+ * \brief decompresses inputs[0] into inputs[1]
+ */
+template<typename xpu>
+void DequantizeImpl(mshadow::Stream<xpu> *s, const std::vector<mxnet::TBlob> &inputs,
+                    const CompressionType type, const float threshold, const int block_size) {
+  switch (type) {
+    case CompressionType::kTwoBit:
+      Dequantize2BitImpl(s, inputs, threshold);
+      break;
+    case CompressionType::kOneBit:
+      Dequantize1BitImpl(s, inputs, threshold);
+      break;
+    case CompressionType::kTopK:
+    case CompressionType::kRandomK:
+      DesparsifyImpl(s, inputs, block_size);
+      break;
+    case CompressionType::kFloat16:
+    case CompressionType::kBfloat16:
+      Dequantize16BitImpl(s, inputs, type == CompressionType::kBfloat16);
+      break;
+    default:
+      LOG(FATAL) << "Unsupported dequantization of type " << static_cast<int>(type);
+  }
+}
 }  // namespace kvstore
 }  // namespace mxnet
 
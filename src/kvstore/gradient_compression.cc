@@ -42,8 +42,19 @@ void GradientCompression::SetParams(const std::vector<std::pair<std::string, std
   GradientCompressionParam params;
   params.InitAllowUnknown(kwargs);
   CHECK_GT(params.threshold, 0) << "threshold must be greater than 0";
+  intra_node_ = params.intra_node;
   if (params.type == "2bit") {
     SetTwoBitCompression(params.threshold);
+  } else if (params.type == "1bit") {
+    SetOneBitCompression(params.threshold);
+  } else if (params.type == "topk") {
+    SetSparsification(CompressionType::kTopK, params.block_size);
+  } else if (params.type == "randk") {
+    SetSparsification(CompressionType::kRandomK, params.block_size);
+  } else if (params.type == "fp16") {
+    Set16BitCompression(CompressionType::kFloat16);
+  } else if (params.type == "bf16") {
+    Set16BitCompression(CompressionType::kBfloat16);
   } else {
     LOG(FATAL) << "Unknown type for gradient compression " << params.type;
   }
@@ -62,11 +73,31 @@ void GradientCompression::SetTwoBitCompression(const float threshold) {
   threshold_ = threshold;
 }
 
+void GradientCompression::SetOneBitCompression(const float threshold) {
+  type_ = CompressionType::kOneBit;
+  threshold_ = threshold;
+}
+
+void GradientCompression::SetSparsification(const CompressionType type, const int block_size) {
+  CHECK(type == CompressionType::kTopK || type == CompressionType::kRandomK);
+  CHECK_GE(block_size, 2);
+  CHECK_LE(block_size, 65536) << "the offsets in a block are 16 bits";
+  type_ = type;
+  block_size_ = block_size;
+}
+
+void GradientCompression::Set16BitCompression(const CompressionType type) {
+  CHECK(type == CompressionType::kFloat16 || type == CompressionType::kBfloat16);
+  type_ = type;
+}
+
 std::string GradientCompression::EncodeParams() {
   using namespace std;  // to reduce length of next line
   string rval = get_type_str();
-  if (type_ == CompressionType::kTwoBit) {
+  if (type_ == CompressionType::kTwoBit || type_ == CompressionType::kOneBit) {
     rval += "," + to_string(threshold_);
+  } else if (type_ == CompressionType::kTopK || type_ == CompressionType::kRandomK) {
+    rval += ",," + to_string(block_size_);
   }
   return rval;
 }
@@ -80,11 +111,20 @@ void GradientCompression::DecodeParams(const std::string &s) {
       threshold_ = stof(elems[1]);
     }
   }
+  if (elems.size() > 2) {
+    block_size_ = stoi(elems[2]);
+  }
 }
 
 int GradientCompression::GetCompressionFactor() {
   if (type_ == CompressionType::kTwoBit) {
     return 16;
+  } else if (type_ == CompressionType::kOneBit) {
+    return 32;
+  } else if (type_ == CompressionType::kTopK || type_ == CompressionType::kRandomK) {
+    return block_size_;
+  } else if (type_ == CompressionType::kFloat16 || type_ == CompressionType::kBfloat16) {
+    return 2;
   } else {
     LOG(FATAL) << "Unsupported compression type: " << get_type_str();
     return 0;
@@ -103,35 +143,37 @@ void GradientCompression::Quantize(const mxnet::NDArray &from, mxnet::NDArray *t
   CHECK(shape_is_known(from.shape())) << "source operand has undefined shape";
   CHECK(shape_is_known(to->shape())) << "destination operand has undefined shape";
   CHECK(shape_is_known(residual->shape())) << "residual operand has undefined shape";
+  CHECK(type_ != CompressionType::kNone) << "Unsupported quantization of type " << get_type_str();
   const int a = from.ctx().dev_mask();
   const int b = to->ctx().dev_mask();
+  const CompressionType type = type_;
   const float threshold = threshold_;
-  if (type_ == CompressionType::kTwoBit) {
-    if (a == mshadow::cpu::kDevMask && b == mshadow::cpu::kDevMask) {
-      mxnet::Engine::Get()->PushSync([from, to, residual, threshold](mxnet::RunContext ctx) {
+  const int block_size = block_size_;
+  const uint32_t seed = num_quantized_++;
+  if (a == mshadow::cpu::kDevMask && b == mshadow::cpu::kDevMask) {
+    mxnet::Engine::Get()->PushSync([from, to, residual, type, threshold, block_size, seed]
+                                   (mxnet::RunContext ctx) {
+      std::vector<mxnet::TBlob> inputs = {from.data(), residual->data(), to->data()};
+      QuantizeImpl(ctx.get_stream<mshadow::cpu>(), inputs, type, threshold, block_size, seed);
+    }, from.ctx(), {from.var()}, {to->var(), residual->var()},
+    mxnet::FnProperty::kNormal, priority, "QuantizeCPU");
+  } else {
+#if MXNET_USE_CUDA
+    if (a == mshadow::gpu::kDevMask && b == mshadow::gpu::kDevMask) {
+      mxnet::Engine::Get()->PushSync([from, to, residual, type, threshold, block_size, seed]
+                                     (mxnet::RunContext ctx) {
         std::vector<mxnet::TBlob> inputs = {from.data(), residual->data(), to->data()};
-        Quantize2BitImpl(ctx.get_stream<mshadow::cpu>(), inputs, threshold);
+        QuantizeImpl(ctx.get_stream<mshadow::gpu>(), inputs, type, threshold, block_size, seed);
+        // Wait GPU kernel to complete
+        ctx.get_stream<mshadow::gpu>()->Wait();
       }, from.ctx(), {from.var()}, {to->var(), residual->var()},
-      mxnet::FnProperty::kNormal, priority, "QuantizeCPU");
+      mxnet::FnProperty::kNormal, priority, "QuantizeGPU");
     } else {
-#if MXNET_USE_CUDA
-      if (a == mshadow::gpu::kDevMask && b == mshadow::gpu::kDevMask) {
-        mxnet::Engine::Get()->PushSync([from, to, residual, threshold](mxnet::RunContext ctx) {
-          std::vector<mxnet::TBlob> inputs = {from.data(), residual->data(), to->data()};
-          Quantize2BitImpl(ctx.get_stream<mshadow::gpu>(), inputs, threshold);
-          // Wait GPU kernel to complete
-          ctx.get_stream<mshadow::gpu>()->Wait();
-        }, from.ctx(), {from.var()}, {to->var(), residual->var()},
-        mxnet::FnProperty::kNormal, priority, "QuantizeGPU");
-      } else {
-        LOG(FATAL) << "unknown device mask";
-      }
+      LOG(FATAL) << "unknown device mask";
+    }
 #else
     LOG(FATAL) << MXNET_GPU_NOT_ENABLED_ERROR;
 #endif
-    }
-  } else {
-    LOG(FATAL) << "Unsupported quantization of type " << get_type_str();
   }
 }
 
@@ -139,35 +181,36 @@ void GradientCompression::Dequantize(const mxnet::NDArray &from, mxnet::NDArray
                                      const int priority) {
   CHECK(shape_is_known(from.shape())) << "source operand has undefined shape";
   CHECK(shape_is_known(to->shape())) << "destination operand has undefined shape";
+  CHECK(type_ != CompressionType::kNone)
+      << "Unsupported dequantization of type " << get_type_str();
   const int a = from.ctx().dev_mask();
   const int b = to->ctx().dev_mask();
+  const CompressionType type = type_;
   const float threshold = threshold_;
-  if (type_ == CompressionType::kTwoBit) {
-    if (a == mshadow::cpu::kDevMask && b == mshadow::cpu::kDevMask) {
-      mxnet::Engine::Get()->PushSync([from, to, threshold](mxnet::RunContext ctx) {
+  const int block_size = block_size_;
+  if (a == mshadow::cpu::kDevMask && b == mshadow::cpu::kDevMask) {
+    mxnet::Engine::Get()->PushSync([from, to, type, threshold, block_size](mxnet::RunContext ctx) {
+      std::vector<mxnet::TBlob> inputs = {from.data(), to->data()};
+      DequantizeImpl(ctx.get_stream<mshadow::cpu>(), inputs, type, threshold, block_size);
+    }, from.ctx(), {from.var()}, {to->var()},
+    mxnet::FnProperty::kNormal, priority, "DequantizeCPU");
+  } else {
+#if MXNET_USE_CUDA
+    if (a == mshadow::gpu::kDevMask && b == mshadow::gpu::kDevMask) {
+      mxnet::Engine::Get()->PushSync([from, to, type, threshold, block_size]
+                                     (mxnet::RunContext ctx) {
         std::vector<mxnet::TBlob> inputs = {from.data(), to->data()};
-        Dequantize2BitImpl(ctx.get_stream<mshadow::cpu>(), inputs, threshold);
+        DequantizeImpl(ctx.get_stream<mshadow::gpu>(), inputs, type, threshold, block_size);
+        // Wait GPU kernel to complete
+        ctx.get_stream<mshadow::gpu>()->Wait();
       }, from.ctx(), {from.var()}, {to->var()},
-      mxnet::FnProperty::kNormal, priority, "DequantizeCPU");
+      mxnet::FnProperty::kNormal, priority, "DequantizeGPU");
     } else {
-#if MXNET_USE_CUDA
-      if (a == mshadow::gpu::kDevMask && b == mshadow::gpu::kDevMask) {
-        mxnet::Engine::Get()->PushSync([from, to, threshold](mxnet::RunContext ctx) {
-          std::vector<mxnet::TBlob> inputs = {from.data(), to->data()};
-          Dequantize2BitImpl(ctx.get_stream<mshadow::gpu>(), inputs, threshold);
-          // Wait GPU kernel to complete
-          ctx.get_stream<mshadow::gpu>()->Wait();
-        }, from.ctx(), {from.var()}, {to->var()},
-        mxnet::FnProperty::kNormal, priority, "DequantizeGPU");
-      } else {
-        LOG(FATAL) << "unknown device mask";
-      }
+      LOG(FATAL) << "unknown device mask";
+    }
 #else
-      LOG(FATAL) << MXNET_GPU_NOT_ENABLED_ERROR;
+    LOG(FATAL) << MXNET_GPU_NOT_ENABLED_ERROR;
 #endif
-    }
-  } else {
-    LOG(FATAL) << "Unsupported dequantization of type " << get_type_str();
   }
 }
 
@@ -36,5 +36,35 @@ void Dequantize2BitImpl(mshadow::Stream<gpu>* s, const std::vector<TBlob>& input
                         const float threshold) {
   Dequantize2BitKernelLaunch(s, inputs, threshold);
 }
+
+void Quantize1BitImpl(mshadow::Stream<gpu>* s, const std::vector<TBlob>& inputs,
+                      const float threshold) {
+  Quantize1BitKernelLaunch(s, inputs, threshold);
+}
+
+void Dequantize1BitImpl(mshadow::Stream<gpu>* s, const std::vector<TBlob>& inputs,
+                        const float threshold) {
+  Dequantize1BitKernelLaunch(s, inputs, threshold);
+}
+
+void SparsifyImpl(mshadow::Stream<gpu>* s, const std::vector<TBlob>& inputs,
+                  const int block_size, const bool random, const uint32_t seed) {
+  SparsifyKernelLaunch(s, inputs, block_size, random, seed);
+}
+
+void DesparsifyImpl(mshadow::Stream<gpu>* s, const std::vector<TBlob>& inputs,
+                    const int block_size) {
+  DesparsifyKernelLaunch(s, inputs, block_size);
+}
+
+void Quantize16BitImpl(mshadow::Stream<gpu>* s, const std::vector<TBlob>& inputs,
+                       const bool bfloat) {
+  Quantize16BitKernelLaunch(s, inputs, bfloat);
+}
+
+void Dequantize16BitImpl(mshadow::Stream<gpu>* s, const std::vector<TBlob>& inputs,
+                         const bool bfloat) {
+  Dequantize16BitKernelLaunch(s, inputs, bfloat);
+}
 }  // namespace kvstore
 }  // namespace mxnet
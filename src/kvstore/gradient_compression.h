@@ -35,17 +35,28 @@ namespace mxnet {
 namespace kvstore {
 
 enum class CompressionType {
-  kNone, kTwoBit
+  kNone, kTwoBit, kOneBit, kTopK, kRandomK, kFloat16, kBfloat16
 };
 
 struct GradientCompressionParam : public dmlc::Parameter<GradientCompressionParam> {
   std::string type;
   float threshold;
+  int block_size;
+  bool intra_node;
   DMLC_DECLARE_PARAMETER(GradientCompressionParam) {
     DMLC_DECLARE_FIELD(type)
-      .describe("Type of gradient compression to use, like `2bit` for example");
+      .describe("Type of gradient compression to use: `2bit`, `1bit`, `topk`, `randk`, "
+                "or `fp16` and `bf16` to send the gradients as float16 or bfloat16");
     DMLC_DECLARE_FIELD(threshold).set_default(0.5)
-      .describe("Threshold to use for 2bit gradient compression");
+      .describe("Threshold to use for 2bit gradient compression, "
+                "and magnitude of the values sent by 1bit gradient compression");
+    DMLC_DECLARE_FIELD(block_size).set_default(32).set_range(2, 65536)
+      .describe("Number of values of the blocks of topk and randk gradient compression, "
+                "which send one value out of each block");
+    DMLC_DECLARE_FIELD(intra_node).set_default(false)
+      .describe("Whether a dist kvstore also compresses the gradients that the GPUs of a "
+                "machine send to the GPU merging them before the push to the servers, "
+                "keeping a residual on each GPU. A device kvstore always compresses them");
   }
 };
 
@@ -67,6 +78,13 @@ class GradientCompression {
    */
   CompressionType get_type();
 
+  /*!
+   * \brief returns whether the reduce over the GPUs of a dist kvstore is compressed too
+   */
+  bool intra_node() const {
+    return intra_node_;
+  }
+
   /*!
    * \brief returns as string the enum value of compression type
    */
@@ -78,6 +96,25 @@ class GradientCompression {
    */
   void SetTwoBitCompression(const float threshold);
 
+  /*!
+   * \brief sets one bit gradient compression, which sends the sign of the values
+   * \param threshold magnitude of the values sent
+   */
+  void SetOneBitCompression(const float threshold);
+
+  /*!
+   * \brief sets top-k or random-k gradient compression
+   * \param type kTopK or kRandomK
+   * \param block_size one value out of each block of block_size values is sent
+   */
+  void SetSparsification(const CompressionType type, const int block_size);
+
+  /*!
+   * \brief sets the transport of the gradients as 16 bit floats
+   * \param type kFloat16 or kBfloat16
+   */
+  void Set16BitCompression(const CompressionType type);
+
   /*!
    * \brief encodes parameters of gc into a string
    */
@@ -132,6 +169,22 @@ class GradientCompression {
    * all negative gradients will be thresholded to -1*`threshold_`
    */
   float threshold_ = 0;
+
+  /*!
+   * \brief number of values of which one is sent, for top-k and random-k
+   */
+  int block_size_ = 0;
+
+  /*!
+   * \brief number of quantizations so far, seeds the picks of random-k
+   */
+  uint32_t num_quantized_ = 0;
+
+  /*!
+   * \brief whether a dist kvstore compresses the reduce over the GPUs of the worker too,
+   * which is not sent to the servers
+   */
+  bool intra_node_ = false;
 };
 }  // namespace kvstore
 }  // namespace mxnet
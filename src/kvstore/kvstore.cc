@@ -29,6 +29,7 @@
 #if MXNET_USE_DIST_KVSTORE
 #include "./kvstore_dist.h"
 #include "./p3store_dist.h"
+#include "./kvstore_dist_allreduce.h"
 std::atomic<int> mxnet::kvstore::KVStoreDist::customer_id_{0};
 #endif  // MXNET_USE_DIST_KVSTORE
 #if MXNET_USE_NCCL
@@ -54,10 +55,23 @@ KVStore* KVStore::Create(const char *type_name) {
   if (has("dist")) {
 #if MXNET_USE_DIST_KVSTORE
     auto ps_type = dmlc::GetEnv("DMLC_PS_VAN_TYPE", std::string("none"));
-    if (ps_type == "p3") {
+    if (has("allreduce")) {
+#if MXNET_USE_NCCL
+      CHECK(!has("async")) << "Asynchronous update is not supported in dist_allreduce";
+      kv = new kvstore::KVStoreDistAllreduce();
+#else
+      LOG(FATAL) << "compile with USE_NCCL=1 to use " << tname;
+      return nullptr;
+#endif  // MXNET_USE_NCCL
+    } else if (ps_type == "p3") {
       CHECK(!has("async")) << "Asynchronous update is not supported in P3StoreDist";
       kv = new kvstore::P3StoreDist(use_device_comm);
     } else {
+      // the cached rows only miss the pushes of the worker, which bounds their staleness in
+      // the sync mode only
+      CHECK(!has("_async") || dmlc::GetEnv("MXNET_KVSTORE_ROW_CACHE_SIZE", 0) == 0)
+          << "MXNET_KVSTORE_ROW_CACHE_SIZE is not supported in " << tname
+          << ", use dist_sync or unset it";
       kv = new kvstore::KVStoreDist(use_device_comm);
     }
     if (!has("_async") && kv->IsWorkerNode() && kv->get_rank() == 0) {
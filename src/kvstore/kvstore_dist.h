@@ -24,11 +24,15 @@
  */
 #ifndef MXNET_KVSTORE_KVSTORE_DIST_H_
 #define MXNET_KVSTORE_KVSTORE_DIST_H_
+#include <cstring>
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <map>
+#include <memory>
 #include <utility>
 #include "./kvstore_local.h"
+#include "./kvstore_row_cache.h"
 #include "mxnet/engine.h"
 #include "ps/ps.h"
 #include "./kvstore_dist_server.h"
@@ -56,7 +60,11 @@ class KVStoreDist : public KVStoreLocal {
       }
     }
     bigarray_bound_ = dmlc::GetEnv("MXNET_KVSTORE_BIGARRAY_BOUND", 1000 * 1000);
+    fusion_bucket_size_ = dmlc::GetEnv("MXNET_KVSTORE_FUSION_BUCKET_SIZE", 4 << 20);
     log_verbose_ = dmlc::GetEnv("MXNET_KVSTORE_DIST_ROW_SPARSE_VERBOSE", false);
+    row_cache_size_ = dmlc::GetEnv("MXNET_KVSTORE_ROW_CACHE_SIZE", 0);
+    row_cache_staleness_ = dmlc::GetEnv("MXNET_KVSTORE_ROW_CACHE_STALENESS", 0);
+    CHECK_GE(row_cache_staleness_, 0) << "MXNET_KVSTORE_ROW_CACHE_STALENESS cannot be negative";
   }
 
   virtual ~KVStoreDist() {
@@ -87,6 +95,9 @@ class KVStoreDist : public KVStoreLocal {
   void SetGradientCompression(const std::vector<std::pair<std::string, std::string> >
                               & kwargs) override {
     KVStoreLocal::SetGradientCompression(kwargs);
+    // the reduce over the GPUs of the worker is uncompressed unless it is intra_node
+    comm_->SetGradientCompression(gradient_compression_->intra_node() ?
+                                  gradient_compression_ : nullptr);
     if (get_rank() == 0) {
       SendCommandToServers(static_cast<int>(CommandType::kSetGradientCompression),
                            gradient_compression_->EncodeParams());
@@ -109,6 +120,10 @@ class KVStoreDist : public KVStoreLocal {
   void SendCommandToServers(int cmd_id,
                             const std::string& cmd_body) override {
     CHECK_NOTNULL(ps_worker_);
+    if (cmd_id == static_cast<int>(CommandType::kController)) {
+      // the servers update the values of each key, which rules out fused buckets
+      server_updater_ = true;
+    }
     ps_worker_->Wait(ps_worker_->Request(cmd_id, cmd_body, ps::kServerGroup));
   }
 
@@ -190,6 +205,7 @@ class KVStoreDist : public KVStoreLocal {
     return customer_id_++;
   }
 
+ protected:
   void InitImpl(const std::vector<int>& keys,
                 const std::vector<NDArray>& values) override {
     CheckUnique(keys);
@@ -229,10 +245,19 @@ class KVStoreDist : public KVStoreLocal {
     GroupKVPairsPull(okeys, outputs, &uniq_okeys, &grouped_outs, true);
     CHECK_EQ(uniq_vkeys.size(), uniq_okeys.size())
              << "List of push and pull keys are different";
+    if (gradient_compression_->get_type() != CompressionType::kNone) {
+      // the servers answer the push once every worker pushed, so the pull that follows
+      // returns the sum. Only the push is compressed.
+      Push_(vkeys, values, priority, true);
+      PullImpl(okeys, outputs, priority, true);
+      return;
+    }
 
+    const FusionPlan* plan = GetFusionPlan(uniq_vkeys, grouped_vals, grouped_outs);
     for (size_t i = 0; i < uniq_vkeys.size(); ++i) {
       CHECK_EQ(uniq_vkeys[i], uniq_okeys[i])
              << "Mismatch in push and pull key";
+      if (plan != nullptr && plan->fused[i]) continue;
       int key = uniq_vkeys[i];
       const auto& vals = grouped_vals[i];
       const auto& outs = grouped_outs[i];
@@ -260,11 +285,138 @@ class KVStoreDist : public KVStoreLocal {
         CopyFromTo(merged, &comm_buf);
       }
 
-      CHECK(gradient_compression_->get_type() == CompressionType::kNone)
-               << "Compression not supported with PushPull";
       PushPullDefault(key, comm_buf, priority);
       comm_->Broadcast(key, comm_buf, outs, priority);
     }
+    if (plan == nullptr) return;
+    // the small values are packed into their bucket, which is sent as one value
+    for (const auto& bucket : plan->buckets) {
+      for (size_t j = 0; j < bucket.members.size(); ++j) {
+        const size_t i = bucket.members[j];
+        NDArray merged = comm_->Reduce(uniq_vkeys[i], grouped_vals[i], priority);
+        const size_t size = merged.shape().Size();
+        NDArray part = bucket.buf.Slice(bucket.offsets[j], bucket.offsets[j] + size);
+        CopyFromTo(merged.Reshape(mxnet::TShape(mshadow::Shape1(size))), part, priority);
+      }
+      PushPullDefault(bucket.key, bucket.buf, priority);
+      for (size_t j = 0; j < bucket.members.size(); ++j) {
+        const size_t i = bucket.members[j];
+        const auto& shape = grouped_outs[i][0]->shape();
+        NDArray part = bucket.buf.Slice(bucket.offsets[j], bucket.offsets[j] + shape.Size());
+        comm_->Broadcast(uniq_vkeys[i], part.Reshape(shape), grouped_outs[i], priority);
+      }
+    }
+  }
+
+  /**
+   * \brief values of the keys of a pushpull packed into one contiguous buffer
+   */
+  struct FusedBucket {
+    /** \brief key of the bucket on the servers */
+    int key;
+    /** \brief positions of the packed keys in the keys of the pushpull */
+    std::vector<size_t> members;
+    /** \brief offset of the value of each packed key in the bucket */
+    std::vector<size_t> offsets;
+    /** \brief the bucket */
+    NDArray buf;
+  };
+
+  /**
+   * \brief buckets of the small values of a list of keys
+   */
+  struct FusionPlan {
+    std::vector<FusedBucket> buckets;
+    /** \brief whether each key is packed into a bucket */
+    std::vector<bool> fused;
+  };
+
+  /**
+   * \brief buckets of a pushpull of unique keys, created the first time the keys are
+   *  pushpulled together
+   *
+   * Consecutive dense keys of the same dtype are packed while they fit in
+   * fusion_bucket_size_ bytes. The workers pushpull the same keys in the same order, so
+   * they agree on the keys of the buckets. Rank 0 initializes a new bucket on its server
+   * before any worker pushes it.
+   * \return the plan, nullptr if no bucket is used
+   */
+  const FusionPlan* GetFusionPlan(const std::vector<int>& keys,
+                                  const std::vector<std::vector<NDArray>>& vals,
+                                  const std::vector<std::vector<NDArray*>>& outs) {
+    if (fusion_bucket_size_ == 0 || server_updater_ || keys.size() < 2) return nullptr;
+    auto it = fusion_plans_.find(keys);
+    if (it != fusion_plans_.end()) {
+      return it->second.buckets.empty() ? nullptr : &it->second;
+    }
+    FusionPlan& plan = fusion_plans_[keys];
+    plan.fused.assign(keys.size(), false);
+    // open bucket of each dtype, and its size in bytes
+    std::unordered_map<int, std::pair<std::vector<size_t>, size_t>> open;
+    std::vector<std::vector<size_t>> groups;
+    for (size_t i = 0; i < keys.size(); ++i) {
+      const NDArray& val = vals[i][0];
+      const size_t bytes = val.shape().Size() * mshadow::mshadow_sizeof(val.dtype());
+      if (val.storage_type() != kDefaultStorage || outs[i][0]->storage_type() != kDefaultStorage ||
+          val.dtype() != outs[i][0]->dtype() || val.shape().Size() >= bigarray_bound_ ||
+          bytes > fusion_bucket_size_ / 2) {
+        continue;
+      }
+      auto& bucket = open[val.dtype()];
+      if (bucket.second + bytes > fusion_bucket_size_) {
+        groups.push_back(std::move(bucket.first));
+        bucket = {{}, 0};
+      }
+      bucket.first.push_back(i);
+      bucket.second += bytes;
+    }
+    for (auto& bucket : open) groups.push_back(std::move(bucket.second.first));
+    // the order of the open buckets depends on the hash map, sort by first key
+    std::sort(groups.begin(), groups.end(), [](const std::vector<size_t>& a,
+                                               const std::vector<size_t>& b) {
+      return a[0] < b[0];
+    });
+    auto krs = ps::Postoffice::Get()->GetServerKeyRanges();
+    const int num_servers = krs.size();
+    CHECK_GT(num_servers, 0);
+    const bool init = get_rank() == 0 && ps_worker_->get_customer()->customer_id() == 0;
+    for (auto& members : groups) {
+      if (members.size() < 2) continue;
+      FusedBucket bucket;
+      const int index = num_fused_buckets_++;
+      bucket.key = kFusedKeyBegin + index;
+      bucket.members = std::move(members);
+      const int dtype = vals[bucket.members[0]][0].dtype();
+      size_t size = 0;
+      for (size_t i : bucket.members) {
+        bucket.offsets.push_back(size);
+        size += vals[i][0].shape().Size();
+        plan.fused[i] = true;
+      }
+      bucket.buf = NDArray(mxnet::TShape(mshadow::Shape1(size)), pinned_ctx_, false, dtype);
+      // the buckets go to the servers in turn, EncodeDefaultKey then finds their keys
+      const int num_bytes = size * mshadow::mshadow_sizeof(dtype);
+      mu_.lock();
+      PSKV& pskv = ps_kv_[bucket.key];
+      mu_.unlock();
+      const int server = index % num_servers;
+      CHECK_LT(krs[server].begin() + bucket.key, krs[server].end());
+      pskv.keys.push_back(krs[server].begin() + bucket.key);
+      pskv.lens.push_back(num_bytes);
+      pskv.size = num_bytes;
+      if (init) {
+        std::vector<char> zeros(num_bytes, 0);
+        ps::SArray<char> data(zeros.data(), num_bytes, false);
+        const int cmd = GetCommandType(RequestType::kDefaultPushPull, dtype);
+        ps_worker_->Wait(ps_worker_->ZPush(pskv.keys, data, pskv.lens, cmd));
+      }
+      plan.buckets.push_back(std::move(bucket));
+    }
+    if (plan.buckets.empty()) return nullptr;
+    if (!ps::Postoffice::Get()->is_recovery()) {
+      Barrier();
+    }
+    return &plan;
   }
 
   void PushImpl(const std::vector<int>& keys,
@@ -471,6 +623,7 @@ class KVStoreDist : public KVStoreLocal {
     using namespace rowsparse;
     auto push_to_servers = [this, key, send_buf]
                            (RunContext rctx, Engine::CallbackOnComplete cb) {
+      if (row_cache_size_ > 0) GetRowCache(key)->Pushed();
       char* data = static_cast<char *>(send_buf.data().dptr_);
       const int64_t num_rows = send_buf.aux_shape(kIdx)[0];
       const auto offsets = send_buf.aux_data(kIdx).dptr<int64_t>();
@@ -546,6 +699,16 @@ class KVStoreDist : public KVStoreLocal {
       const auto unit_len = recv_buf.shape().ProdShape(1, recv_buf.shape().ndim());
       const int64_t size = num_rows * unit_len;
       const int num_bytes = mshadow::mshadow_sizeof(dtype);
+      const int cmd = GetCommandType(RequestType::kRowSparsePushPull, recv_buf.dtype());
+      // copy indices to recv_buf. this needs to be done before ZPull
+      // because after pull is done, the callback function returns and locks are released.
+      // at this point, later functions may access the indices variable while copy happens
+      mshadow::Copy(recv_buf.aux_data(kIdx).FlatTo1D<cpu, int64_t>(),
+                    idx_data.FlatTo1D<cpu, int64_t>());
+      if (row_cache_size_ > 0) {
+        PullCachedRows(key, recv_buf, offsets, num_rows, unit_len, num_bytes, cmd, cb);
+        return;
+      }
       // convert to ps keys in row sparse format
       PSKV& pskv = EncodeRowSparseKey(key, size, num_rows, offsets,
                                       unit_len, recv_buf.shape()[0],
@@ -555,12 +718,6 @@ class KVStoreDist : public KVStoreLocal {
                   << pskv.keys << " size: " << size;
       }
       auto vals = new ps::SArray<char>(data, size * num_bytes, false);
-      const int cmd = GetCommandType(RequestType::kRowSparsePushPull, recv_buf.dtype());
-      // copy indices to recv_buf. this needs to be done before ZPull
-      // because after pull is done, the callback function returns and locks are released.
-      // at this point, later functions may access the indices variable while copy happens
-      mshadow::Copy(recv_buf.aux_data(kIdx).FlatTo1D<cpu, int64_t>(),
-                    idx_data.FlatTo1D<cpu, int64_t>());
       CHECK_NOTNULL(ps_worker_)->ZPull(pskv.keys, vals, &pskv.lens,
                                        cmd,
                                        [vals, cb]() { delete vals; cb(); });
@@ -575,6 +732,57 @@ class KVStoreDist : public KVStoreLocal {
       "KVStoreDistRowSparsePull");
   }
 
+  /**
+   * \brief row cache of a key, created on first use
+   */
+  RowCache* GetRowCache(int key) {
+    std::lock_guard<std::mutex> lk(mu_);
+    auto& cache = row_caches_[key];
+    if (!cache) cache.reset(new RowCache(row_cache_size_, row_cache_staleness_));
+    return cache.get();
+  }
+
+  /**
+   * \brief serve the rows offsets of a row sparse pull from the row cache of the key,
+   *  and pull the others from the servers. Runs in the engine operator of the pull
+   */
+  void PullCachedRows(const int key, const NDArray& recv_buf, const int64_t* offsets,
+                      const size_t num_rows, const size_t unit_len, const int num_bytes,
+                      const int cmd, Engine::CallbackOnComplete cb) {
+    RowCache* cache = GetRowCache(key);
+    const size_t row_bytes = unit_len * num_bytes;
+    char* data = static_cast<char *>(recv_buf.data().dptr_);
+    std::vector<size_t> misses;
+    cache->Get(offsets, num_rows, row_bytes, data, &misses);
+    if (this->log_verbose_) {
+      LOG(INFO) << "worker " << get_rank() << " pull of key " << key << ": "
+                << num_rows - misses.size() << " cached rows, " << misses.size()
+                << " pulled rows, hit rate " << cache->HitRate();
+    }
+    if (misses.empty()) {
+      cb();
+      return;
+    }
+    // the missed offsets stay sorted
+    std::vector<int64_t> miss_offsets(misses.size());
+    for (size_t i = 0; i < misses.size(); ++i) miss_offsets[i] = offsets[misses[i]];
+    PSKV& pskv = EncodeRowSparseKey(key, misses.size() * unit_len, misses.size(),
+                                    miss_offsets.data(), unit_len, recv_buf.shape()[0],
+                                    num_bytes);
+    auto vals = new ps::SArray<char>(misses.size() * row_bytes);
+    CHECK_NOTNULL(ps_worker_)->ZPull(
+      pskv.keys, vals, &pskv.lens, cmd,
+      [cache, vals, data, row_bytes, misses, miss_offsets, cb]() {
+        for (size_t i = 0; i < misses.size(); ++i) {
+          const char* row = vals->data() + i * row_bytes;
+          std::memcpy(data + misses[i] * row_bytes, row, row_bytes);
+          cache->Put(miss_offsets[i], row);
+        }
+        delete vals;
+        cb();
+      });
+  }
+
   virtual void PushPullDefault(int key, const NDArray &comm_buf, int priority) {
     auto pushpull = [this, key, comm_buf](
         RunContext rctx, Engine::CallbackOnComplete cb) {
@@ -830,6 +1038,34 @@ class KVStoreDist : public KVStoreLocal {
    * \brief threshold for partition
    */
   size_t bigarray_bound_;
+  /**
+   * \brief size in bytes of the buckets packing the small values of a pushpull,
+   *  0 to send every value alone
+   */
+  size_t fusion_bucket_size_;
+  /**
+   * \brief whether the servers update the values, so they cannot be fused
+   */
+  bool server_updater_ = false;
+  /**
+   * \brief server keys of the buckets are kFusedKeyBegin, kFusedKeyBegin + 1, ...
+   */
+  static constexpr int kFusedKeyBegin = 1 << 30;
+  int num_fused_buckets_ = 0;
+  /**
+   * \brief buckets of each list of unique keys pushpulled together
+   */
+  std::map<std::vector<int>, FusionPlan> fusion_plans_;
+  /**
+   * \brief number of rows of the row cache of each row sparse key, 0 to pull all the rows,
+   *  and number of pushes a cached row may miss
+   */
+  size_t row_cache_size_;
+  int64_t row_cache_staleness_;
+  /**
+   * \brief row caches of the row sparse keys, guarded by mu_
+   */
+  std::unordered_map<int, std::unique_ptr<RowCache>> row_caches_;
   /**
    * \brief buffer for non-compressed data.
    * When gradient compression is active, this is used
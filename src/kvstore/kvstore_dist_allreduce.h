@@ -0,0 +1,307 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file   kvstore_dist_allreduce.h
+ * @brief  distributed kvstore reducing dense gradients with an allreduce between the workers
+ */
+#ifndef MXNET_KVSTORE_KVSTORE_DIST_ALLREDUCE_H_
+#define MXNET_KVSTORE_KVSTORE_DIST_ALLREDUCE_H_
+
+#if MXNET_USE_NCCL
+
+#include <nccl.h>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "./kvstore_dist.h"
+#include "../common/cuda/utils.h"
+
+namespace mxnet {
+namespace kvstore {
+
+/**
+ * \brief distributed kvstore without a server hop for dense values
+ *
+ * A push first reduces the values of the devices of the worker with the device comm, then
+ * sums the merged value of every worker with an NCCL allreduce between the workers, which
+ * runs a ring or a tree over the network (see NCCL_ALGO). Each worker then updates its
+ * copy of the weights with the same summed gradient, so the copies stay identical.
+ *
+ * The servers are only used to broadcast the initial values of rank 0, to exchange the
+ * NCCL ids and to reduce the values merged on CPU.
+ */
+class KVStoreDistAllreduce : public KVStoreDist {
+ public:
+  KVStoreDistAllreduce() : KVStoreDist(true) {
+    if (IsWorkerNode()) {
+      ExchangeNCCLIds();
+    }
+  }
+
+  virtual ~KVStoreDistAllreduce() {
+    Engine::Get()->WaitForAll();
+    Engine::Get()->DeleteVariable([](RunContext ctx) {}, Context::CPU(), order_var_);
+    for (auto& e : nccl_data_) {
+      if (e.comm == nullptr) continue;
+      cudaStreamDestroy(e.stream);
+      ncclCommDestroy(e.comm);
+    }
+  }
+
+  void SetGradientCompression(const std::vector<std::pair<std::string, std::string> >
+                              & kwargs) override {
+    LOG(FATAL) << "Gradient compression is not supported by the dist_allreduce kvstore";
+  }
+
+ private:
+  void InitImpl(const std::vector<int>& keys,
+                const std::vector<NDArray>& values) override {
+    // rank 0 pushes the values to the servers, every worker then keeps a copy of them
+    KVStoreDist::InitImpl(keys, values);
+    for (size_t i = 0; i < keys.size(); ++i) {
+      CHECK_EQ(values[i].storage_type(), kDefaultStorage)
+          << "The dist_allreduce kvstore only supports dense values";
+      NDArray& local = local_[keys[i]];
+      local = NDArray(values[i].shape(), pinned_ctx_, false, values[i].dtype());
+      PullDefault(keys[i], local, 0);
+    }
+  }
+
+  void PushImpl(const std::vector<int>& keys,
+                const std::vector<NDArray>& values,
+                int priority) override {
+    std::vector<int> uniq_keys;
+    std::vector<std::vector<NDArray> > grouped_vals;
+    GroupKVPairsPush(keys, values, &uniq_keys, &grouped_vals, false);
+    for (size_t i = 0; i < uniq_keys.size(); ++i) {
+      const int key = uniq_keys[i];
+      const NDArray reduced = Allreduce(key, comm_->Reduce(key, grouped_vals[i], priority),
+                                        priority);
+      NDArray& local = local_[key];
+      CHECK(!local.is_none()) << "key " << key << " has not been inited";
+      if (updater_ != nullptr) {
+        // if reduced is on gpu, we may need copy weight from cpu to gpu
+        if (reduced.ctx().dev_mask() != cpu::kDevMask &&
+            local.ctx().dev_mask() == cpu::kDevMask) {
+          local = local.Copy(reduced.ctx());
+        }
+        if (key_type_ == kStringKey && str_updater_ != nullptr) {
+          str_updater_(reverse_str_key_dict_[key], reduced, &local);
+        } else {
+          updater_(key, reduced, &local);
+        }
+      } else {
+        local = reduced;
+      }
+    }
+  }
+
+  void PullImpl(const std::vector<int>& keys,
+                const std::vector<NDArray*>& values,
+                int priority, bool ignore_sparse) override {
+    CHECK(ignore_sparse) << "dist_allreduce kvstore pull doesn't support ignore_sparse=False";
+    std::vector<int> uniq_keys;
+    std::vector<std::vector<NDArray*> > grouped_vals;
+    GroupKVPairsPull(keys, values, &uniq_keys, &grouped_vals, true);
+    for (size_t i = 0; i < uniq_keys.size(); ++i) {
+      const NDArray& local = local_[uniq_keys[i]];
+      CHECK(!local.is_none()) << "key " << uniq_keys[i] << " has not been inited";
+      comm_->Broadcast(uniq_keys[i], local, grouped_vals[i], priority);
+    }
+  }
+
+  void PushPullImpl(const std::vector<int>& vkeys,
+                    const std::vector<int>& okeys,
+                    const std::vector<NDArray>& values,
+                    const std::vector<NDArray*>& outputs,
+                    int priority) override {
+    std::vector<int> uniq_vkeys;
+    std::vector<int> uniq_okeys;
+    std::vector<std::vector<NDArray>> grouped_vals;
+    std::vector<std::vector<NDArray*>> grouped_outs;
+    GroupKVPairsPush(vkeys, values, &uniq_vkeys, &grouped_vals, false);
+    GroupKVPairsPull(okeys, outputs, &uniq_okeys, &grouped_outs, true);
+    CHECK_EQ(uniq_vkeys.size(), uniq_okeys.size())
+        << "List of push and pull keys are different";
+    for (size_t i = 0; i < uniq_vkeys.size(); ++i) {
+      CHECK_EQ(uniq_vkeys[i], uniq_okeys[i]) << "Mismatch in push and pull key";
+      const int key = uniq_vkeys[i];
+      const NDArray reduced = Allreduce(key, comm_->Reduce(key, grouped_vals[i], priority),
+                                        priority);
+      comm_->Broadcast(key, reduced, grouped_outs[i], priority);
+    }
+  }
+
+  void PullRowSparseImpl(const std::vector<int>& keys,
+                         const std::vector<std::pair<NDArray*, NDArray>>& val_rowids,
+                         int priority = 0) override {
+    LOG(FATAL) << "The dist_allreduce kvstore does not support sparse storage type";
+  }
+
+  /**
+   * \brief sum a value merged over the devices of this worker with the other workers
+   * \return the sum, which is not merged itself
+   */
+  NDArray Allreduce(int key, const NDArray& merged, int priority) {
+    CHECK_EQ(merged.storage_type(), kDefaultStorage)
+        << "The dist_allreduce kvstore only supports dense values";
+    const bool on_cpu = merged.ctx().dev_mask() == cpu::kDevMask;
+    auto& reduced = reduce_buf_[key];
+    if (reduced.is_none()) {
+      reduced = NDArray(merged.shape(), on_cpu ? pinned_ctx_ : merged.ctx(), false,
+                        merged.dtype());
+    }
+    if (on_cpu) {
+      // no NCCL between cpus, reduce through the servers
+      CopyFromTo(merged, &reduced, priority);
+      PushPullDefault(key, reduced, priority);
+      return reduced;
+    }
+    const int dev_id = merged.ctx().dev_id;
+    auto it = slots_.find(dev_id);
+    if (it == slots_.end()) {
+      // devices are numbered in the order they are used in, the same on every worker
+      it = slots_.emplace(dev_id, slots_.size()).first;
+      CHECK_LT(it->second, nccl_data_.size())
+          << "Values are merged on more devices than the workers have";
+    }
+    const size_t slot = it->second;
+    // every worker has to issue the allreduces in the same order, they all mutate order_var_
+    Engine::Get()->PushSync([this, slot, merged, reduced](RunContext rctx) {
+        NCCLEntry* e;
+        {
+          std::lock_guard<std::mutex> l(Storage::Get()->GetMutex(Context::kGPU));
+          e = GetNCCLEntry(slot, merged.ctx().dev_id);
+          ncclAllReduce(merged.data().dptr_, reduced.data().dptr_, merged.shape().Size(),
+                        GetNCCLType(merged.dtype()), ncclSum, e->comm, e->stream);
+        }
+        mxnet::common::cuda::DeviceStore device_store(e->dev_id);
+        CUDA_CALL(cudaStreamSynchronize(e->stream));
+      },
+      Context::CPU(),
+      {merged.var()},
+      {reduced.var(), order_var_},
+      FnProperty::kCPUPrioritized,
+      priority,
+      "KVStoreDistAllreduce");
+    return reduced;
+  }
+
+  /**
+   * \brief generate the NCCL ids of the communicators on rank 0 and send them to the
+   *  other workers through the servers, one communicator per device slot
+   */
+  void ExchangeNCCLIds() {
+    int num_gpus = 0;
+    CUDA_CALL(cudaGetDeviceCount(&num_gpus));
+    nccl_data_.resize(num_gpus);
+    nccl_ids_.resize(num_gpus);
+    if (num_gpus == 0) return;
+    const int size = num_gpus * sizeof(ncclUniqueId);
+    auto krs = ps::Postoffice::Get()->GetServerKeyRanges();
+    CHECK_GT(krs.size(), 0U);
+    ps::SArray<ps::Key> keys(1, krs[0].begin() + kNCCLIdKey);
+    ps::SArray<int> lens(1, size);
+    ps::SArray<char> vals(size, 0);
+    // the ids travel as float32 values, the only bytes a server stores as is
+    const int cmd = GetCommandType(RequestType::kDefaultPushPull, mshadow::kFloat32);
+    if (get_rank() == 0) {
+      for (int i = 0; i < num_gpus; ++i) {
+        CHECK_EQ(ncclGetUniqueId(&nccl_ids_[i]), ncclSuccess) << "Failed to create a NCCL id";
+        std::memcpy(vals.data() + i * sizeof(ncclUniqueId), &nccl_ids_[i],
+                    sizeof(ncclUniqueId));
+      }
+      ps_worker_->Wait(ps_worker_->ZPush(keys, vals, lens, cmd));
+    }
+    Barrier();
+    if (get_rank() != 0) {
+      ps_worker_->Wait(ps_worker_->ZPull(keys, &vals, &lens, cmd));
+      CHECK_EQ(vals.size(), static_cast<size_t>(size))
+          << "Every worker of the dist_allreduce kvstore needs the same number of GPUs";
+      for (int i = 0; i < num_gpus; ++i) {
+        std::memcpy(&nccl_ids_[i], vals.data() + i * sizeof(ncclUniqueId),
+                    sizeof(ncclUniqueId));
+      }
+    }
+  }
+
+  struct NCCLEntry {
+    /// \brief device ID
+    int dev_id{-1};
+    /// \brief NCCL communicator between the workers
+    ncclComm_t comm{nullptr};
+    /// \brief GPU stream to use with NCCL
+    cudaStream_t stream{nullptr};
+  };
+
+  /// \brief communicator of a device slot, created when first used
+  NCCLEntry* GetNCCLEntry(size_t slot, int dev_id) {
+    NCCLEntry& e = nccl_data_[slot];
+    if (e.comm == nullptr) {
+      mxnet::common::cuda::DeviceStore device_store(dev_id);
+      CHECK_EQ(ncclCommInitRank(&e.comm, get_group_size(), nccl_ids_[slot], get_rank()),
+               ncclSuccess) << "Failed to create the NCCL communicator of device " << dev_id;
+      CUDA_CALL(cudaStreamCreate(&e.stream));
+      e.dev_id = dev_id;
+    }
+    CHECK_EQ(e.dev_id, dev_id);
+    return &e;
+  }
+
+  static ncclDataType_t GetNCCLType(int dtype) {
+    switch (dtype) {
+      case mshadow::kFloat32:
+        return ncclFloat;
+      case mshadow::kFloat16:
+        return ncclHalf;
+      case mshadow::kFloat64:
+        return ncclDouble;
+      case mshadow::kUint8:
+        return ncclChar;
+      case mshadow::kInt32:
+        return ncclInt;
+      case mshadow::kInt64:
+        return ncclInt64;
+      default:
+        LOG(FATAL) << "Unknown type passed to the dist_allreduce kvstore";
+    }
+    return ncclNumTypes;
+  }
+
+  /// \brief key of the NCCL ids on the servers, out of the range of the user keys
+  static constexpr int kNCCLIdKey = std::numeric_limits<int>::max();
+  /// \brief sum of the merged values of the workers
+  std::unordered_map<int, NDArray> reduce_buf_;
+  /// \brief slot of each device the values are merged on
+  std::unordered_map<int, size_t> slots_;
+  /// \brief NCCL id and communicator of each device slot
+  std::vector<ncclUniqueId> nccl_ids_;
+  std::vector<NCCLEntry> nccl_data_;
+  /// \brief orders the allreduces
+  Engine::VarHandle order_var_ = Engine::Get()->NewVariable();
+};
+
+}  // namespace kvstore
+}  // namespace mxnet
+#endif  // MXNET_USE_NCCL
+#endif  // MXNET_KVSTORE_KVSTORE_DIST_ALLREDUCE_H_
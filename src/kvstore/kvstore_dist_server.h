@@ -34,10 +34,13 @@
 #include <memory>
 #include <functional>
 #include <future>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 #include "../profiler/profiler.h"
 #include "../operator/tensor/elemwise_binary_op-inl.h"
 #include "../operator/tensor/init_op.h"
+#include "./kvstore_lazy_optimizer.h"
 
 namespace mxnet {
 namespace kvstore {
@@ -45,7 +48,7 @@ namespace kvstore {
 // maintain same order in frontend.
 enum class CommandType {
   kController, kSetMultiPrecision, kStopServer, kSyncMode,
-  kSetGradientCompression, kSetProfilerParams
+  kSetGradientCompression, kSetProfilerParams, kSetLazyOptimizer
 };
 
 enum class RequestType {
@@ -135,7 +138,17 @@ class Executor {
   }
 
   /**
-   * \brief stop the thread, threadsafe
+   * \brief let the thread called \ref Start to exec a function without waiting for it.
+   *  The functions are executed in the order they are given. threadsafe
+   */
+  void ExecAsync(const Func& func) {
+    std::lock_guard<std::mutex> lk(mu_);
+    queue_.push(Block(func));
+    cond_.notify_one();
+  }
+
+  /**
+   * \brief stop the thread once the functions given before are executed, threadsafe
    */
   void Stop() {
     Exec(Func());
@@ -152,6 +165,27 @@ class Executor {
   std::condition_variable cond_;
 };
 
+/**
+ * \brief map from the keys of a server to their values, whose lookups are threadsafe.
+ *  A value is only accessed by the thread handling its key, and the references to the
+ *  values stay valid when other keys are inserted. The iteration is not threadsafe.
+ */
+template<typename V>
+class KeyMap {
+ public:
+  V& operator[](int key) {
+    std::lock_guard<std::mutex> lk(mu_);
+    return map_[key];
+  }
+
+  typename std::unordered_map<int, V>::iterator begin() { return map_.begin(); }
+  typename std::unordered_map<int, V>::iterator end() { return map_.end(); }
+
+ private:
+  std::unordered_map<int, V> map_;
+  std::mutex mu_;
+};
+
 class KVStoreDistServer {
  public:
   KVStoreDistServer() {
@@ -164,9 +198,20 @@ class KVStoreDistServer {
     sync_mode_ = false;
     gradient_compression_ = std::make_shared<GradientCompression>();
     log_verbose_ = dmlc::GetEnv("MXNET_KVSTORE_DIST_ROW_SPARSE_VERBOSE", false);
+    lazy_update_ = dmlc::GetEnv("MXNET_KVSTORE_SERVER_LAZY_UPDATE", true);
+    // with a single thread the requests are handled by the thread of ps-lite
+    const int num_threads = dmlc::GetEnv("MXNET_KVSTORE_SERVER_NTHREADS", 1);
+    CHECK_GT(num_threads, 0) << "MXNET_KVSTORE_SERVER_NTHREADS has to be positive";
+    if (num_threads > 1) {
+      for (int i = 0; i < num_threads; ++i) {
+        shards_.emplace_back(new Executor());
+        shard_threads_.emplace_back(&Executor::Start, shards_.back().get());
+      }
+    }
   }
 
   ~KVStoreDistServer() {
+    StopShards();
     profiler::Profiler::Get()->SetState(profiler::Profiler::ProfilerState(0));
     delete ps_server_;
   }
@@ -196,10 +241,31 @@ class KVStoreDistServer {
     NDArray temp_array;
   };
 
+  /**
+   * \brief wait for the requests given to the shards to be handled
+   */
+  void WaitShards() {
+    for (auto& shard : shards_) shard->Exec([]() {});
+  }
+
+  /**
+   * \brief stop the shards once the requests given to them are handled
+   */
+  void StopShards() {
+    for (auto& shard : shards_) shard->Stop();
+    for (auto& thread : shard_threads_) thread.join();
+    shards_.clear();
+    shard_threads_.clear();
+  }
+
   void CommandHandle(const ps::SimpleData& recved, ps::SimpleApp* app) {
     CommandType recved_type = static_cast<CommandType>(recved.head);
+    // a command applies after the requests received before it
+    WaitShards();
     switch (recved_type) {
       case CommandType::kStopServer:
+        // the shards may wait for exec_ to run the updater
+        StopShards();
         exec_.Stop();
         break;
       case CommandType::kSyncMode:
@@ -214,6 +280,15 @@ class KVStoreDistServer {
                                                   (recved.body.back() - '0'),
                                       recved.body);
         break;
+      case CommandType::kSetLazyOptimizer:
+        // sent after each optimizer, empty if the python updater has to update all values.
+        // A new optimizer starts with new states, as the python updater does
+        if (lazy_update_ && !recved.body.empty()) {
+          lazy_optimizer_.reset(new LazyOptimizer(recved.body));
+        } else {
+          lazy_optimizer_.reset();
+        }
+        break;
       case CommandType::kSetMultiPrecision:
         // uses value 1 for message id from frontend
         if (!multi_precision_) {
@@ -326,6 +401,22 @@ class KVStoreDistServer {
                     const ps::KVPairs<char>& req_data,
                     ps::KVServer<char>* server) {
     DataHandleType type = DepairDataHandleType(req_meta.cmd);
+    if (shards_.empty()) {
+      DataHandle(type, req_meta, req_data, server);
+      return;
+    }
+    // the requests of a key are handled in order by the same shard. The copies of
+    // req_data share its arrays, which live as long as the copies
+    const bool compressed_push =
+        type.requestType == RequestType::kCompressedPushPull && req_meta.push;
+    const int key = DecodeKey(req_data.keys[compressed_push ? 1 : 0]);
+    shards_[key % shards_.size()]->ExecAsync([this, type, req_meta, req_data, server]() {
+      DataHandle(type, req_meta, req_data, server);
+    });
+  }
+
+  void DataHandle(const DataHandleType type, const ps::KVMeta& req_meta,
+                  const ps::KVPairs<char>& req_data, ps::KVServer<char>* server) {
     switch (type.requestType) {
       case RequestType::kRowSparsePushPull:
         DataHandleRowSparse(type, req_meta, req_data, server);
@@ -350,7 +441,10 @@ class KVStoreDistServer {
       // let the main thread to execute updater_, which is necessary for python
       auto& stored = has_multi_precision_copy(type) ? store_realt_[key] : store_[key];
       auto& update =  sync_mode_ ? update_buf->merged : update_buf->temp_array;
-      if (updater_) {
+      if (lazy_optimizer_ && update.storage_type() == kRowSparseStorage) {
+        // updated by the thread handling the key, without the main thread
+        lazy_optimizer_->Update(key, update, &stored);
+      } else if (updater_) {
         exec_.Exec([this, key, &update, &stored](){
           CHECK(updater_);
           updater_(key, update, &stored);
@@ -647,7 +741,8 @@ class KVStoreDistServer {
       TBlob recv_blob(reinterpret_cast<real_t*>(req_data.vals.data()), dshape, cpu::kDevMask);
       NDArray recved = NDArray(recv_blob, 0);
 
-      NDArray decomp_buf = decomp_buf_[key];
+      // kept across pushes, every compression type decompresses into a dense array
+      NDArray& decomp_buf = decomp_buf_[key];
       dshape = mxnet::TShape{(int64_t) original_size};
 
       if (decomp_buf.is_none()) {
@@ -774,27 +869,39 @@ class KVStoreDistServer {
   bool sync_mode_;
   KVStore::Controller controller_;
   KVStore::Updater updater_;
+  /**
+   * \brief native updater of the row_sparse values, set by kSetLazyOptimizer
+   */
+  std::unique_ptr<LazyOptimizer> lazy_optimizer_;
+  // whether the row_sparse values may be updated by lazy_optimizer_
+  bool lazy_update_;
 
   /**
    * \brief store_ contains the value at kvstore for each key
    */
-  std::unordered_map<int, NDArray> store_;
-  std::unordered_map<int, NDArray> store_realt_;
+  KeyMap<NDArray> store_;
+  KeyMap<NDArray> store_realt_;
 
   /**
    * \brief merge_buf_ is a buffer used if sync_mode is true. It represents
    * values from different workers being merged. The store will be updated
    * to this value when values from all workers are pushed into this buffer.
    */
-  std::unordered_map<int, UpdateBuf> update_buf_;
+  KeyMap<UpdateBuf> update_buf_;
 
   /**
    * \brief decomp_buf_ is a buffer into which compressed values are
    * decompressed before merging to the store. used when compress_!='none'
    */
-  std::unordered_map<int, NDArray> decomp_buf_;
+  KeyMap<NDArray> decomp_buf_;
 
   Executor exec_;
+  /**
+   * \brief executors handling the data requests of the keys key % shards_.size(),
+   *  empty if the thread of ps-lite handles them
+   */
+  std::vector<std::unique_ptr<Executor>> shards_;
+  std::vector<std::thread> shard_threads_;
   ps::KVServer<char>* ps_server_;
 
   // whether to LOG verbose information
@@ -0,0 +1,147 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file   kvstore_lazy_optimizer.h
+ * @brief  server side lazy updates of the row_sparse values
+ *
+ *  The update of a row_sparse value only touches the rows of its merged gradient, with the
+ *  row_sparse kernels of adam_update, _sparse_adagrad_update and ftrl_update. These are the
+ *  operators the python optimizers call for row_sparse gradients, so the weights are the
+ *  same, but the update runs on the thread handling the key instead of the main thread of
+ *  the server, which calls the python updater holding the GIL.
+ */
+#ifndef MXNET_KVSTORE_KVSTORE_LAZY_OPTIMIZER_H_
+#define MXNET_KVSTORE_KVSTORE_LAZY_OPTIMIZER_H_
+#include <mxnet/ndarray.h>
+#include <mxnet/op_attr_types.h>
+#include <cmath>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../operator/optimizer_op-inl.h"
+
+namespace mxnet {
+namespace kvstore {
+
+/**
+ * \brief native optimizer of the row_sparse values of a server, threadsafe for different keys
+ */
+class LazyOptimizer {
+ public:
+  /**
+   * \param config "<name> <param>=<value> ...", the name being adam, adagrad or ftrl and
+   *  the params those of its update operator
+   */
+  explicit LazyOptimizer(const std::string& config) {
+    std::istringstream is(config);
+    is >> name_;
+    std::string kv;
+    while (is >> kv) {
+      const size_t pos = kv.find('=');
+      CHECK_NE(pos, std::string::npos) << "Invalid lazy optimizer param " << kv;
+      attrs_.dict[kv.substr(0, pos)] = kv.substr(pos + 1);
+    }
+    if (name_ == "adam") {
+      attrs_.op = nnvm::Op::Get("adam_update");
+      attrs_.dict["lazy_update"] = "True";
+      num_states_ = 2;
+    } else if (name_ == "adagrad") {
+      attrs_.op = nnvm::Op::Get("_sparse_adagrad_update");
+      num_states_ = 1;
+    } else if (name_ == "ftrl") {
+      attrs_.op = nnvm::Op::Get("ftrl_update");
+      num_states_ = 2;
+    } else {
+      LOG(FATAL) << "Unknown lazy optimizer " << name_;
+    }
+    attrs_.name = name_;
+    attrs_.op->attr_parser(&attrs_);
+    fcompute_ = nnvm::Op::GetAttr<FComputeEx>("FComputeEx<cpu>")[attrs_.op];
+  }
+
+  /**
+   * \brief update the rows of weight present in grad, asynchronously
+   * \param key key of the value
+   * \param grad merged row_sparse gradient
+   * \param weight row_sparse value with all its rows present
+   */
+  void Update(int key, const NDArray& grad, NDArray* weight) {
+    CHECK_EQ(grad.storage_type(), kRowSparseStorage);
+    CHECK_EQ(weight->storage_type(), kRowSparseStorage);
+    State& state = GetState(key);
+    if (state.arrays.empty()) {
+      for (int i = 0; i < num_states_; ++i) {
+        state.arrays.emplace_back(kRowSparseStorage, weight->shape(), weight->ctx(), true,
+                                  weight->dtype());
+      }
+    }
+    ++state.num_update;
+    nnvm::NodeAttrs attrs = attrs_;
+    if (name_ == "adam") {
+      // bias correction of the learning rate, as done by the python Adam
+      op::AdamParam param = nnvm::get<op::AdamParam>(attrs_.parsed);
+      const double t = state.num_update;
+      param.lr *= std::sqrt(1. - std::pow(param.beta2, t)) / (1. - std::pow(param.beta1, t));
+      attrs.parsed = param;
+    }
+
+    std::vector<NDArray> inputs{*weight, grad};
+    std::vector<engine::VarHandle> mutable_vars{weight->var()};
+    for (const auto& arr : state.arrays) {
+      inputs.push_back(arr);
+      mutable_vars.push_back(arr.var());
+    }
+    const NDArray out = *weight;
+    const FComputeEx fcompute = fcompute_;
+    Engine::Get()->PushSync([attrs, inputs, out, fcompute](RunContext ctx) {
+      // the merged gradient of a push without rows is empty
+      if (!inputs[1].storage_initialized()) return;
+      OpContext op_ctx;
+      op_ctx.is_train = true;
+      op_ctx.run_ctx = ctx;
+      fcompute(attrs, op_ctx, inputs, {kWriteInplace}, {out});
+    }, weight->ctx(), {grad.var()}, mutable_vars, FnProperty::kNormal, 0, "KVStoreLazyUpdate");
+  }
+
+ private:
+  struct State {
+    std::vector<NDArray> arrays;
+    int64_t num_update = 0;
+  };
+
+  State& GetState(int key) {
+    std::lock_guard<std::mutex> lk(mu_);
+    return states_[key];
+  }
+
+  std::string name_;
+  nnvm::NodeAttrs attrs_;
+  FComputeEx fcompute_;
+  int num_states_;
+  /*! \brief states of the keys, whose references stay valid when other keys are inserted */
+  std::unordered_map<int, State> states_;
+  std::mutex mu_;
+};
+
+}  // namespace kvstore
+}  // namespace mxnet
+#endif  // MXNET_KVSTORE_KVSTORE_LAZY_OPTIMIZER_H_
@@ -66,12 +66,18 @@ class KVStoreNCCL : public KVStoreLocal {
     comm_ = nullptr;
     pinned_ctx_ = Context::CPUPinned(0);
     inited_ = false;
+    num_channels_ = dmlc::GetEnv("MXNET_KVSTORE_NCCL_CHANNELS", 1);
+    CHECK_GT(num_channels_, 0) << "MXNET_KVSTORE_NCCL_CHANNELS has to be positive";
   }
 
   virtual ~KVStoreNCCL() {
-    for (auto e : nccl_data_) {
-      cudaStreamDestroy(e.second.stream);
-      ncclCommDestroy(e.second.comm);
+    for (auto& channel : channels_) {
+      for (auto e : channel) {
+        cudaEventDestroy(e.second.ready);
+        cudaEventDestroy(e.second.done);
+        cudaStreamDestroy(e.second.stream);
+        ncclCommDestroy(e.second.comm);
+      }
     }
   }
 
@@ -96,16 +102,11 @@ class KVStoreNCCL : public KVStoreLocal {
 
     std::vector<const NDArray*> merged_ptrs;
     std::vector<NDArray*> local_ptrs;
-    bool nccl_called = false;
 
     Reduce(uniq_keys, grouped_vals, priority, &merged_ptrs);
 
     for (size_t i = 0; i < uniq_keys.size(); ++i) {
       int key = uniq_keys[i];
-      if (grouped_vals[i].size() > 1) {
-        // We issued NCCL kernels, need to synchronize
-        nccl_called = true;
-      }
       auto& merged = *(merged_ptrs[i]);
       NDArray& local = local_[key];
       if (updater_ != nullptr) {
@@ -119,11 +120,6 @@ class KVStoreNCCL : public KVStoreLocal {
       local_ptrs.push_back(&local);
     }
 
-    // Sync after all reductions in a group
-    if (nccl_called) {
-      CommSync(merged_ptrs, priority);
-    }
-
     for (size_t i = 0; i < uniq_keys.size(); ++i) {
       int key = uniq_keys[i];
       auto& merged = *(merged_ptrs[i]);
@@ -153,25 +149,15 @@ class KVStoreNCCL : public KVStoreLocal {
     std::vector<std::vector<NDArray*> > grouped_vals;
     GroupKVPairsHelper(keys, values, &uniq_keys, &grouped_vals, true);
     std::vector<NDArray> locals;
-    bool nccl_called = false;
 
     for (size_t i = 0; i < uniq_keys.size(); ++i) {
       int key = uniq_keys[i];
       const NDArray& local = local_[key];
       locals.push_back(local_[key]);
       CHECK(!local.is_none()) << "key " << key << " has not been inited";
-      if (grouped_vals[i].size() > 1) {
-        // We issued NCCL kernels, need to synchronize
-        nccl_called = true;
-      }
     }
 
     Broadcast(uniq_keys, locals, grouped_vals, priority);
-    // Sync after all broadcasts in a group
-    if (nccl_called) {
-      const std::vector<const NDArray*> values_copy(values.begin(), values.end());
-      CommSync(values_copy, priority);
-    }
   }
 
   void PullRowSparseImpl(const std::vector<int>& keys,
@@ -219,6 +205,7 @@ class KVStoreNCCL : public KVStoreLocal {
     merged_ptrs->resize(keys.size());
     std::vector<Engine::VarHandle> const_vars;
     std::vector<Engine::VarHandle> mutate_vars;
+    Context root_ctx;
 
     for (size_t k = 0; k < keys.size(); ++k) {
       auto& key = keys[k];
@@ -254,6 +241,7 @@ class KVStoreNCCL : public KVStoreLocal {
       root_id = FindRootId(src, root);
 
       auto& reduce = buf.merged;
+      root_ctx = reduce.ctx();
       (*merged_ptrs)[k] = &reduce;
       // Need to pass NDArrays by value to the engine
       reduces[k] = reduce;
@@ -263,9 +251,13 @@ class KVStoreNCCL : public KVStoreLocal {
       }
       mutate_vars.push_back(reduce.var());
     }
+    if (mutate_vars.empty()) return;
 
-    Engine::Get()->PushSync([srcs, reduces, root_ids, this](RunContext rctx) {
+    const size_t c = NextChannel();
+    Engine::Get()->PushSync([srcs, reduces, root_ids, c, this](RunContext rctx) {
         std::lock_guard<std::mutex> l(Storage::Get()->GetMutex(Context::kGPU));
+        auto& channel = channels_[c];
+        BeginChannel(rctx, &channel);
 #if (NCCL_MAJOR > 2 || (NCCL_MAJOR == 2 && NCCL_MINOR > 1))
         ncclGroupStart();
 #endif
@@ -276,10 +268,10 @@ class KVStoreNCCL : public KVStoreLocal {
           if (src.size() <= 1) {
             continue;
           }
-          int root = nccl_data_[src[root_id].ctx().dev_id].rank;
+          int root = channel[src[root_id].ctx().dev_id].rank;
           ncclGroupStart();
           for (size_t i = 0; i < src.size(); ++i) {
-            NCCLEntry cur = nccl_data_[src[i].ctx().dev_id];
+            NCCLEntry cur = channel[src[i].ctx().dev_id];
             if (i == root_id) {
             MSHADOW_TYPE_SWITCH(src[i].dtype(), DType,
             ncclReduce(src[i].data().dptr<DType>(),
@@ -307,11 +299,12 @@ class KVStoreNCCL : public KVStoreLocal {
 #if (NCCL_MAJOR > 2 || (NCCL_MAJOR == 2 && NCCL_MINOR > 1))
         ncclGroupEnd();
 #endif
+        EndChannel(rctx, &channel);
       },
-      Context::CPU(),
+      root_ctx,
       const_vars,
       mutate_vars,
-      FnProperty::kCPUPrioritized,
+      FnProperty::kNormal,
       priority,
       "KVStoreReduce");
   }
@@ -323,6 +316,7 @@ class KVStoreNCCL : public KVStoreLocal {
     std::vector<size_t> root_ids(keys.size());
     std::vector<Engine::VarHandle> const_vars;
     std::vector<Engine::VarHandle> mutable_vars;
+    Context root_ctx;
 
     for (size_t k = 0; k < keys.size(); ++k) {
       auto& key = keys[k];
@@ -344,6 +338,7 @@ class KVStoreNCCL : public KVStoreLocal {
         int root = src.ctx().dev_id;
         assert(root == buf.merged.ctx().dev_id);
         root_id = FindRootId(dst, root);
+        root_ctx = src.ctx();
 
         // Check whether we got the same set of devices
         std::vector<int> dev_ids;
@@ -365,7 +360,7 @@ class KVStoreNCCL : public KVStoreLocal {
     }
 
     // If not yet inited, then all work is already scheduled
-    if (!inited_) {
+    if (!inited_ || mutable_vars.empty()) {
       return;
     }
 
@@ -380,8 +375,11 @@ class KVStoreNCCL : public KVStoreLocal {
       }
     }
 
-    Engine::Get()->PushSync([srcs, broadcasts, root_ids, this](RunContext rctx) {
+    const size_t c = NextChannel();
+    Engine::Get()->PushSync([srcs, broadcasts, root_ids, c, this](RunContext rctx) {
         std::lock_guard<std::mutex> l(Storage::Get()->GetMutex(Context::kGPU));
+        auto& channel = channels_[c];
+        BeginChannel(rctx, &channel);
 #if (NCCL_MAJOR > 2 || (NCCL_MAJOR == 2 && NCCL_MINOR > 1))
         ncclGroupStart();
 #endif
@@ -393,11 +391,11 @@ class KVStoreNCCL : public KVStoreLocal {
             continue;
           }
 
-          int root = nccl_data_[src.ctx().dev_id].rank;
+          int root = channel[src.ctx().dev_id].rank;
           ncclGroupStart();
           for (size_t i = 0; i < dst.size(); ++i) {
             auto& bcast = (i == root_id) ? src : dst[i];
-            NCCLEntry cur = nccl_data_[bcast.ctx().dev_id];
+            NCCLEntry cur = channel[bcast.ctx().dev_id];
             MSHADOW_TYPE_SWITCH(bcast.dtype(), DType,
                 ncclBcast(bcast.data().dptr<DType>(),
                   bcast.shape().Size(),
@@ -411,35 +409,52 @@ class KVStoreNCCL : public KVStoreLocal {
 #if (NCCL_MAJOR > 2 || (NCCL_MAJOR == 2 && NCCL_MINOR > 1))
         ncclGroupEnd();
 #endif
+        EndChannel(rctx, &channel);
       },
-      Context::CPU(),
+      root_ctx,
       const_vars,
       mutable_vars,
-      FnProperty::kCPUPrioritized,
+      FnProperty::kNormal,
       priority,
       "KVStoreBCast");
   }
 
-  // Function that waits for NCCL collective to complete
-  template <typename T>
-  void CommSync(const std::vector<T>& dst, int priority) {
-    std::vector<Engine::VarHandle> mutate_vars;
-    for (size_t i = 0; i < dst.size(); ++i) {
-        mutate_vars.push_back(ptr(dst[i])->var());
+  /**
+   * \brief channels are used in turn, so that the collectives of consecutive pushes and
+   *  pulls run concurrently
+   */
+  size_t NextChannel() {
+    return next_channel_++ % channels_.size();
+  }
+
+  /**
+   * \brief make the NCCL streams of a channel wait for the work queued before on the
+   *  stream of the engine operator, which waited for its inputs
+   */
+  void BeginChannel(const RunContext& rctx, std::unordered_map<int, NCCLEntry>* channel) {
+    cudaStream_t stream = rctx.get_stream<gpu>()->stream_;
+    const NCCLEntry& root = channel->at(rctx.ctx.dev_id);
+    CUDA_CALL(cudaEventRecord(root.ready, stream));
+    for (const auto& e : *channel) {
+      CUDA_CALL(cudaStreamWaitEvent(e.second.stream, root.ready, 0));
+    }
+  }
+
+  /**
+   * \brief make the stream of the engine operator wait for the NCCL streams of a channel,
+   *  so that the engine tracks the completion of the collectives without a host wait
+   */
+  void EndChannel(const RunContext& rctx, std::unordered_map<int, NCCLEntry>* channel) {
+    cudaStream_t stream = rctx.get_stream<gpu>()->stream_;
+    mxnet::common::cuda::DeviceStore device_store;
+    for (const auto& e : *channel) {
+      device_store.SetDevice(e.second.dev_id);
+      CUDA_CALL(cudaEventRecord(e.second.done, e.second.stream));
+    }
+    device_store.SetDevice(rctx.ctx.dev_id);
+    for (const auto& e : *channel) {
+      CUDA_CALL(cudaStreamWaitEvent(stream, e.second.done, 0));
     }
-    Engine::Get()->PushSync([this](RunContext rctx) {
-        mxnet::common::cuda::DeviceStore device_store;
-        for (auto cur : nccl_data_) {
-          device_store.SetDevice(cur.second.dev_id);
-          CUDA_CALL(cudaStreamSynchronize(cur.second.stream));
-        }
-      },
-      Context::CPU(),
-      {},
-      mutate_vars,
-      FnProperty::kCPUPrioritized,
-      priority,
-      "KVStoreStreamSync");
   }
 
   // Initialize single key
@@ -478,17 +493,22 @@ class KVStoreNCCL : public KVStoreLocal {
     }
     std::sort(device_ids_.begin(), device_ids_.end());
     std::lock_guard<std::mutex> l(Storage::Get()->GetMutex(Context::kGPU));
-    std::vector<ncclComm_t> comms(devs.size());
-    ncclCommInitAll(&(comms[0]), devs.size(), &(device_ids_[0]));
     mxnet::common::cuda::DeviceStore device_store;
-    for (size_t i = 0; i < devs.size(); ++i) {
-      NCCLEntry e;
-      e.dev_id = device_ids_[i];
-      e.comm = comms[i];
-      e.rank = i;
-      device_store.SetDevice(e.dev_id);
-      cudaStreamCreate(&(e.stream));
-      nccl_data_[device_ids_[i]] = e;
+    channels_.resize(num_channels_);
+    for (auto& channel : channels_) {
+      std::vector<ncclComm_t> comms(devs.size());
+      ncclCommInitAll(&(comms[0]), devs.size(), &(device_ids_[0]));
+      for (size_t i = 0; i < devs.size(); ++i) {
+        NCCLEntry e;
+        e.dev_id = device_ids_[i];
+        e.comm = comms[i];
+        e.rank = i;
+        device_store.SetDevice(e.dev_id);
+        cudaStreamCreateWithFlags(&(e.stream), cudaStreamNonBlocking);
+        CUDA_CALL(cudaEventCreateWithFlags(&(e.ready), cudaEventDisableTiming));
+        CUDA_CALL(cudaEventCreateWithFlags(&(e.done), cudaEventDisableTiming));
+        channel[device_ids_[i]] = e;
+      }
     }
   }
 
@@ -542,9 +562,14 @@ class KVStoreNCCL : public KVStoreLocal {
     int rank;
     /// \brief GPU stream to use with NCCL
     cudaStream_t stream;
+    /// \brief events ordering stream after the engine stream, and the engine stream after it
+    cudaEvent_t ready, done;
   };
   std::unordered_map<int, BufferEntry> merge_buf_;
-  std::unordered_map<int, NCCLEntry> nccl_data_;
+  /// \brief communicator and stream of each device, for each channel
+  std::vector<std::unordered_map<int, NCCLEntry>> channels_;
+  int num_channels_;
+  size_t next_channel_ = 0;
   bool inited_;
   // \brief devices used with this KVStore
   std::vector<int> device_ids_;
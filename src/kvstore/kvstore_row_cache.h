@@ -0,0 +1,183 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @file   kvstore_row_cache.h
+ * @brief  worker side cache of the rows of a row_sparse value
+ *
+ *  The version of a value is the number of pushes of its key by the worker. A row pulled
+ *  at some version is served from the cache while the value has been pushed at most
+ *  `staleness` times since, then it is pulled again. When the cache is full a row is only
+ *  cached in place of a stale row, so that the rows pulled often stay cached.
+ */
+#ifndef MXNET_KVSTORE_KVSTORE_ROW_CACHE_H_
+#define MXNET_KVSTORE_KVSTORE_ROW_CACHE_H_
+#include <dmlc/logging.h>
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace mxnet {
+namespace kvstore {
+
+/**
+ * \brief threadsafe cache of the rows of a row_sparse value
+ */
+class RowCache {
+ public:
+  /**
+   * \param capacity number of rows cached
+   * \param staleness number of pushes a cached row may miss
+   */
+  RowCache(size_t capacity, int64_t staleness)
+      : capacity_(capacity), staleness_(staleness) {
+    CHECK_GT(capacity, 0U);
+    CHECK_GE(staleness, 0);
+  }
+
+  /**
+   * \brief count a push of the value
+   */
+  void Pushed() {
+    std::lock_guard<std::mutex> lk(mu_);
+    ++version_;
+  }
+
+  /**
+   * \brief copy the cached rows, and find the rows to pull
+   * \param row_ids ids of the rows
+   * \param num_rows number of rows
+   * \param row_bytes bytes of a row
+   * \param data rows of the ids, where the cached rows are copied
+   * \param misses positions in row_ids of the rows to pull
+   */
+  void Get(const int64_t* row_ids, size_t num_rows, size_t row_bytes, char* data,
+           std::vector<size_t>* misses) {
+    std::lock_guard<std::mutex> lk(mu_);
+    if (row_bytes_ != row_bytes) {
+      // first pull of the value
+      rows_.clear();
+      order_.clear();
+      row_bytes_ = row_bytes;
+      data_.assign(capacity_ * row_bytes, 0);
+      free_.resize(capacity_);
+      for (size_t i = 0; i < capacity_; ++i) free_[i] = capacity_ - 1 - i;
+    }
+    misses->clear();
+    for (size_t i = 0; i < num_rows; ++i) {
+      auto it = rows_.find(row_ids[i]);
+      if (it != rows_.end() && version_ - it->second.first <= staleness_) {
+        std::memcpy(data + i * row_bytes, data_.data() + it->second.second * row_bytes,
+                    row_bytes);
+      } else {
+        misses->push_back(i);
+      }
+    }
+    hits_ += num_rows - misses->size();
+    lookups_ += num_rows;
+  }
+
+  /**
+   * \brief cache a pulled row, if it is cached already or there is room
+   */
+  void Put(int64_t row_id, const char* row) {
+    std::lock_guard<std::mutex> lk(mu_);
+    auto it = rows_.find(row_id);
+    size_t slot;
+    if (it != rows_.end()) {
+      it->second.first = version_;
+      slot = it->second.second;
+    } else {
+      if (free_.empty()) EvictStale();
+      if (free_.empty()) return;
+      slot = free_.back();
+      free_.pop_back();
+      rows_.emplace(row_id, std::make_pair(version_, slot));
+    }
+    std::memcpy(data_.data() + slot * row_bytes_, row, row_bytes_);
+    order_.emplace_back(row_id, version_);
+    if (order_.size() > 2 * capacity_) Compact();
+  }
+
+  /**
+   * \return ratio of the rows served from the cache
+   */
+  double HitRate() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    return lookups_ == 0 ? 0 : static_cast<double>(hits_) / lookups_;
+  }
+
+ private:
+  /**
+   * \brief free the slot of the oldest cached row, if it is stale
+   */
+  void EvictStale() {
+    while (!order_.empty()) {
+      const auto front = order_.front();
+      auto it = rows_.find(front.first);
+      if (it == rows_.end() || it->second.first != front.second) {
+        // the row was pulled again since
+        order_.pop_front();
+        continue;
+      }
+      if (version_ - front.second <= staleness_) return;
+      free_.push_back(it->second.second);
+      rows_.erase(it);
+      order_.pop_front();
+      return;
+    }
+  }
+
+  /**
+   * \brief drop the entries of order_ of the rows pulled again since
+   */
+  void Compact() {
+    order_.clear();
+    for (const auto& row : rows_) order_.emplace_back(row.first, row.second.first);
+    std::sort(order_.begin(), order_.end(),
+              [](const std::pair<int64_t, int64_t>& a, const std::pair<int64_t, int64_t>& b) {
+                return a.second < b.second;
+              });
+  }
+
+  mutable std::mutex mu_;
+  const size_t capacity_;
+  const int64_t staleness_;
+  /** \brief number of pushes of the value */
+  int64_t version_ = 0;
+  /** \brief bytes of a row */
+  size_t row_bytes_ = 0;
+  /** \brief version when pulled and slot in data_ of the cached rows */
+  std::unordered_map<int64_t, std::pair<int64_t, size_t>> rows_;
+  /** \brief cached rows with their version when pulled, oldest first */
+  std::deque<std::pair<int64_t, int64_t>> order_;
+  /** \brief free slots of data_ */
+  std::vector<size_t> free_;
+  /** \brief rows of the slots */
+  std::vector<char> data_;
+  size_t hits_ = 0, lookups_ = 0;
+};
+
+}  // namespace kvstore
+}  // namespace mxnet
+#endif  // MXNET_KVSTORE_KVSTORE_ROW_CACHE_H_
@@ -42,6 +42,8 @@ class P3StoreDist : public KVStoreDist {
   explicit P3StoreDist(bool use_device_comm)
       : KVStoreDist(use_device_comm) {
     slice_threshold_ = dmlc::GetEnv("MXNET_KVSTORE_SLICE_THRESHOLD", 40 * 1000);
+    // P3 slices the values instead of fusing them
+    fusion_bucket_size_ = 0;
   }
 
   void PullRowSparse(const std::vector<int>& str_keys,
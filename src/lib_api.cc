@@ -222,11 +222,14 @@ mxnet::ext::MXTensor* mxnet::ext::PassResource::alloc_aux(const std::string& nam
 mxnet::ext::OpResource::OpResource(xpu_malloc_t cpu_malloc_fp, void* cpu_alloc_fp,
                                    xpu_malloc_t gpu_malloc_fp, void* gpu_alloc_fp, void* stream,
                                    sparse_malloc_t sparse_malloc_fp, void* sparse_alloc_fp,
-                                   void* rng_cpu_states, void* rng_gpu_states)
+                                   void* rng_cpu_states, void* rng_gpu_states,
+                                   void** temp_space, size_t* temp_space_sizes,
+                                   int num_temp_space)
   : cpu_malloc(cpu_malloc_fp), gpu_malloc(gpu_malloc_fp),
     cpu_alloc(cpu_alloc_fp), gpu_alloc(gpu_alloc_fp), cuda_stream(stream),
     sparse_malloc(sparse_malloc_fp), sparse_alloc(sparse_alloc_fp),
-    rand_cpu_states(rng_cpu_states), rand_gpu_states(rng_gpu_states) {}
+    rand_cpu_states(rng_cpu_states), rand_gpu_states(rng_gpu_states),
+    temp(temp_space), temp_sizes(temp_space_sizes), num_temp(num_temp_space) {}
 
 void* mxnet::ext::OpResource::alloc_cpu(int size) const {
   return cpu_malloc(cpu_alloc, size);
@@ -246,6 +249,20 @@ mxnet::ext::mx_cpu_rand_t* mxnet::ext::OpResource::get_cpu_rand_states() const {
   return static_cast<mx_cpu_rand_t*>(rand_cpu_states);
 }
 
+void* mxnet::ext::OpResource::get_temp_space(int index) const {
+  if (index < 0 || index >= num_temp)
+    throw std::runtime_error("Error! Temp space " + std::to_string(index)
+                             + " was not declared by the TempSpace function");
+  return temp[index];
+}
+
+size_t mxnet::ext::OpResource::get_temp_space_size(int index) const {
+  if (index < 0 || index >= num_temp)
+    throw std::runtime_error("Error! Temp space " + std::to_string(index)
+                             + " was not declared by the TempSpace function");
+  return temp_sizes[index];
+}
+
 std::string mxnet::ext::getShapeAt(const std::string& shape, unsigned index) {
   int idx = 1;  // start at 1 to skip the first square bracket [
   // find the beginning of the output shape for the particular output index
@@ -770,7 +787,8 @@ void mxnet::ext::Graph::_setParams(std::unordered_map<std::string, mxnet::ext::M
 
 mxnet::ext::CustomOp::CustomOp(const char* op_name)
   : name(op_name), parse_attrs(nullptr), infer_type(nullptr), infer_storage_type(nullptr),
-    infer_shape(nullptr), mutate_inputs(nullptr), isSGop(false) {}
+    infer_shape(nullptr), mutate_inputs(nullptr), inplace_option(nullptr), temp_space(nullptr),
+    reuse_state(false), isSGop(false) {}
 
 mxnet::ext::CustomOp& mxnet::ext::CustomOp::setForward(mxnet::ext::fcomp_t fcomp, const char* ctx) {
   if (forward_ctx_map.count(ctx) > 0)
@@ -820,6 +838,21 @@ mxnet::ext::CustomOp& mxnet::ext::CustomOp::setCreateOpState(mxnet::ext::createO
   return *this;
 }
 
+mxnet::ext::CustomOp& mxnet::ext::CustomOp::setInplaceOption(mxnet::ext::inplaceOption_t func) {
+  inplace_option = func;
+  return *this;
+}
+
+mxnet::ext::CustomOp& mxnet::ext::CustomOp::setTempSpace(mxnet::ext::tempSpace_t func) {
+  temp_space = func;
+  return *this;
+}
+
+mxnet::ext::CustomOp& mxnet::ext::CustomOp::setReuseOpState() {
+  reuse_state = true;
+  return *this;
+}
+
 mxnet::ext::CustomOp& mxnet::ext::CustomOp::setIsSubgraphOp() {
   isSGop = true;
   return *this;
@@ -926,7 +959,9 @@ MX_VOID_RET _opRegGet(int idx, const char** name, int *isSGop,
                       const char*** create_op_ctx, mxnet::ext::createOpState_t** create_op_fp,
                       int* create_op_count, mxnet::ext::parseAttrs_t* parse,
                       mxnet::ext::inferType_t* type, mxnet::ext::inferSType_t* stype,
-                      mxnet::ext::inferShape_t* shape, mxnet::ext::mutateInputs_t* mutate) {
+                      mxnet::ext::inferShape_t* shape, mxnet::ext::mutateInputs_t* mutate,
+                      mxnet::ext::inplaceOption_t* inplace,
+                      mxnet::ext::tempSpace_t* temp_space, int* reuse_state) {
   mxnet::ext::CustomOp &op = mxnet::ext::Registry<mxnet::ext::CustomOp>::get()->get(idx);
   *name = op.name;
   *parse = op.parse_attrs;
@@ -934,6 +969,9 @@ MX_VOID_RET _opRegGet(int idx, const char** name, int *isSGop,
   *stype = op.infer_storage_type;
   *shape = op.infer_shape;
   *mutate = op.mutate_inputs;
+  *inplace = op.inplace_option;
+  *temp_space = op.temp_space;
+  *reuse_state = op.reuse_state;
   *isSGop = op.isSGop;
   op.mapToVector();
   *forward_ctx = op.forward_ctx_cstr.data();
@@ -1105,7 +1143,8 @@ MX_INT_RET _opCallFCompute(mxnet::ext::fcomp_t fcomp, const char* const* keys,
                            void** in_indptr, void** out_indptr,
                            int64_t* in_indices_shapes, int64_t* out_indices_shapes,
                            int64_t* in_indptr_shapes, int64_t* out_indptr_shapes,
-                           void* rng_cpu_states, void* rng_gpu_states) {
+                           void* rng_cpu_states, void* rng_gpu_states,
+                           void** temp_space, size_t* temp_space_sizes, int num_temp_space) {
   // create map of attributes from list
   std::unordered_map<std::string, std::string> attrs;
   for (int i = 0; i < num; i++) {
@@ -1171,7 +1210,8 @@ MX_INT_RET _opCallFCompute(mxnet::ext::fcomp_t fcomp, const char* const* keys,
 
   mxnet::ext::OpResource res(cpu_malloc, cpu_alloc, gpu_malloc, gpu_alloc,
                              cuda_stream, sparse_malloc, sparse_alloc,
-                             rng_cpu_states, rng_gpu_states);
+                             rng_cpu_states, rng_gpu_states,
+                             temp_space, temp_space_sizes, num_temp_space);
   return fcomp(attrs, &inputs, &outputs, res);
 }
 
@@ -1235,7 +1275,9 @@ MX_INT_RET _opCallFStatefulCompute(int is_forward, void* state_op, const int64_t
                                    void** out_indptr, int64_t* in_indices_shapes,
                                    int64_t* out_indices_shapes, int64_t* in_indptr_shapes,
                                    int64_t* out_indptr_shapes,
-                                   void* rng_cpu_states, void* rng_gpu_states) {
+                                   void* rng_cpu_states, void* rng_gpu_states,
+                                   void** temp_space, size_t* temp_space_sizes,
+                                   int num_temp_space) {
   // create a vector of tensors for inputs
   std::vector<mxnet::ext::MXTensor> inputs(num_in);
   // create a vector for sparse inputs
@@ -1295,7 +1337,8 @@ MX_INT_RET _opCallFStatefulCompute(int is_forward, void* state_op, const int64_t
   }
 
   mxnet::ext::OpResource res(cpu_malloc, cpu_alloc, gpu_malloc, gpu_alloc,
-                             stream, sparse_malloc, sparse_alloc, rng_cpu_states, rng_gpu_states);
+                             stream, sparse_malloc, sparse_alloc, rng_cpu_states, rng_gpu_states,
+                             temp_space, temp_space_sizes, num_temp_space);
 
   mxnet::ext::CustomStatefulOp* op_ptr =
     reinterpret_cast<mxnet::ext::CustomStatefulOp*>(state_op);
@@ -1305,6 +1348,70 @@ MX_INT_RET _opCallFStatefulCompute(int is_forward, void* state_op, const int64_t
   return op_ptr->Backward(&inputs, &outputs, res);
 }
 
+/*! \brief returns status of calling inplaceOption function for operator from library */
+MX_INT_RET _opCallInplaceOption(mxnet::ext::inplaceOption_t inplace, const char* const* keys,
+                                const char* const* vals, int num,
+                                int** inplace_pairs, int* num_pairs) {
+  // create map of attributes from list
+  std::unordered_map<std::string, std::string> attrs;
+  for (int i = 0; i < num; i++) {
+    attrs[std::string(keys[i])] = std::string(vals[i]);
+  }
+
+  std::vector<std::pair<int, int> > pairs;
+  int retval = inplace(attrs, &pairs);
+  if (!retval)
+    return retval;
+
+  // output the pairs flattened as input, output, input, output...
+  *num_pairs = pairs.size();
+  *inplace_pairs = static_cast<int*>(malloc (2 * *num_pairs * sizeof(int)));
+  for (int i = 0; i < *num_pairs; i++) {
+    (*inplace_pairs)[2 * i] = pairs[i].first;
+    (*inplace_pairs)[2 * i + 1] = pairs[i].second;
+  }
+
+  return retval;
+}
+
+/*! \brief returns status of calling tempSpace function, or TempSpace of a stateful op */
+MX_INT_RET _opCallTempSpace(mxnet::ext::tempSpace_t temp_space, void* state_op,
+                            const char* const* keys, const char* const* vals, int num,
+                            const int64_t** inshapes, int* indims, int* intypes, int num_in,
+                            int is_forward, size_t** sizes, int* num_sizes) {
+  // create a vector of shapes and types for inputs
+  std::vector<std::vector<int64_t> > in_shapes(num_in);
+  std::vector<int> in_types(intypes, intypes + num_in);
+  for (int i = 0; i < num_in; i++) {
+    in_shapes[i].assign(inshapes[i], inshapes[i] + indims[i]);
+  }
+
+  std::vector<size_t> temp_sizes;
+  int retval;
+  if (state_op != nullptr) {
+    mxnet::ext::CustomStatefulOp* op_ptr =
+      reinterpret_cast<mxnet::ext::CustomStatefulOp*>(state_op);
+    retval = op_ptr->TempSpace(in_shapes, in_types, is_forward, &temp_sizes);
+  } else {
+    // create map of attributes from list
+    std::unordered_map<std::string, std::string> attrs;
+    for (int i = 0; i < num; i++) {
+      attrs[std::string(keys[i])] = std::string(vals[i]);
+    }
+    retval = temp_space(attrs, in_shapes, in_types, is_forward, &temp_sizes);
+  }
+  if (!retval)
+    return retval;
+
+  *num_sizes = temp_sizes.size();
+  *sizes = static_cast<size_t*>(malloc (*num_sizes * sizeof(size_t)));
+  for (int i = 0; i < *num_sizes; i++) {
+    (*sizes)[i] = temp_sizes[i];
+  }
+
+  return retval;
+}
+
 /*! \brief returns number of partitioners registered in this library */
 MX_INT_RET _partRegSize() {
   return mxnet::ext::Registry<mxnet::ext::CustomPartitioner>::get()->size();
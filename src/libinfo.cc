@@ -40,6 +40,7 @@ class FeatureSet {
     feature_bits.set(CUDNN, MXNET_USE_CUDNN);
     feature_bits.set(NCCL, MXNET_USE_NCCL);
     feature_bits.set(TENSORRT, MXNET_USE_TENSORRT);
+    feature_bits.set(CUPTI, MXNET_USE_CUPTI);
 
     // Check flags for example with gcc -msse3 -mavx2 -dM -E - < /dev/null | egrep "SSE|AVX"
 #if __SSE__
@@ -81,6 +82,7 @@ class FeatureSet {
 
     // Image
     feature_bits.set(OPENCV, MXNET_USE_OPENCV);
+    feature_bits.set(NVJPEG, MXNET_USE_NVJPEG);
 
     // Misc
     feature_bits.set(DIST_KVSTORE, MXNET_USE_DIST_KVSTORE);
@@ -133,6 +135,7 @@ const std::vector<std::string> EnumNames::names = {
   "CUDNN",
   "NCCL",
   "TENSORRT",
+  "CUPTI",
   "CPU_SSE",
   "CPU_SSE2",
   "CPU_SSE3",
@@ -152,6 +155,7 @@ const std::vector<std::string> EnumNames::names = {
   "LAPACK",
   "MKLDNN",
   "OPENCV",
+  "NVJPEG",
   "DIST_KVSTORE",
   "INT64_TENSOR_SIZE",
   "SIGNAL_HANDLER",
@@ -0,0 +1,184 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file checkpoint.cc
+ * \brief Sharded checkpoints written in the background and loaded in parallel.
+ */
+#include "./checkpoint.h"
+
+#include <dmlc/io.h>
+#include <mxnet/imperative.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <utility>
+#include "../io/mapped_file.h"
+
+namespace mxnet {
+namespace ndarray {
+
+namespace {
+
+/*! \brief the writers of the checkpoint being saved */
+struct PendingCheckpoint {
+  std::mutex mutex;
+  std::vector<std::future<void>> shards;
+};
+
+PendingCheckpoint* Pending() {
+  static PendingCheckpoint pending;
+  return &pending;
+}
+
+/*! \brief the shape semantics of the caller, for the threads saving or loading for it */
+void SetShapeSemantics(int np_shape) {
+  // the global semantics are seen by all threads already
+  if (np_shape == ThreadLocalOn) Imperative::Get()->set_is_np_shape(np_shape);
+}
+
+void WriteShard(const std::string& fname, const std::vector<NDArray>& data,
+                const std::vector<std::string>& names,
+                const std::vector<Context>& contexts, int np_shape) {
+  SetShapeSemantics(np_shape);
+  bool dense = true;
+  for (const NDArray& nd : data) {
+    nd.WaitToRead();
+    dense = dense && nd.storage_type() == kDefaultStorage;
+  }
+  const std::string path = io::LocalPath(fname);
+  const std::string target = path.empty() ? fname : path + ".tmp";
+  {
+    std::unique_ptr<dmlc::Stream> fo(dmlc::Stream::Create(target.c_str(), "w"));
+    if (dense) {
+      NDArray::SaveMapped(fo.get(), data, names, 4096, contexts);
+    } else {
+      NDArray::Save(fo.get(), data, names);
+    }
+  }
+  if (!path.empty()) {
+    CHECK_EQ(std::rename(target.c_str(), path.c_str()), 0)
+        << "Failed to rename " << target << " to " << path << ": " << strerror(errno);
+  }
+}
+
+size_t StorageBytes(const NDArray& nd) {
+  const mxnet::TShape& shape =
+      nd.storage_type() == kDefaultStorage ? nd.shape() : nd.storage_shape();
+  return shape.Size() * mshadow::mshadow_sizeof(nd.dtype());
+}
+
+}  // namespace
+
+std::string CheckpointShardName(const std::string& prefix, int shard, int num_shards) {
+  char suffix[32];
+  snprintf(suffix, sizeof(suffix), "-%05d-of-%05d.params", shard, num_shards);
+  return prefix + suffix;
+}
+
+void SaveShardedAsync(const std::string& prefix, const std::vector<NDArray>& data,
+                      const std::vector<std::string>& names, int num_shards) {
+  CHECK_GT(num_shards, 0) << "a checkpoint needs at least one shard";
+  CHECK_EQ(names.size(), data.size()) << "the ndarrays of a sharded checkpoint need names";
+  WaitForCheckpoint();
+
+  // the largest ndarrays first, each to the shard holding the fewest bytes
+  std::vector<size_t> order(data.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&data](size_t a, size_t b) {
+    return StorageBytes(data[a]) > StorageBytes(data[b]);
+  });
+  std::vector<size_t> shard_bytes(num_shards, 0);
+  std::vector<std::vector<NDArray>> shard_data(num_shards);
+  std::vector<std::vector<std::string>> shard_names(num_shards);
+  std::vector<std::vector<Context>> shard_contexts(num_shards);
+  for (size_t i : order) {
+    const NDArray& nd = data[i];
+    CHECK(!nd.is_none()) << "cannot checkpoint the empty NDArray " << names[i];
+    const int shard = std::min_element(shard_bytes.begin(), shard_bytes.end()) -
+                      shard_bytes.begin();
+    shard_bytes[shard] += StorageBytes(nd);
+    const bool pinned = nd.ctx().dev_mask() == gpu::kDevMask &&
+                        nd.storage_type() == kDefaultStorage;
+    // the copy is pushed to the engine, so it reads nd before any later update
+    shard_data[shard].push_back(
+        nd.Copy(pinned ? Context::CPUPinned(nd.ctx().dev_id) : Context::CPU()));
+    shard_names[shard].push_back(names[i]);
+    shard_contexts[shard].push_back(nd.ctx());
+  }
+
+  const int np_shape = Imperative::Get()->is_np_shape();
+  PendingCheckpoint* pending = Pending();
+  std::lock_guard<std::mutex> lock(pending->mutex);
+  for (int shard = 0; shard < num_shards; ++shard) {
+    pending->shards.push_back(std::async(
+        std::launch::async, WriteShard, CheckpointShardName(prefix, shard, num_shards),
+        std::move(shard_data[shard]), std::move(shard_names[shard]),
+        std::move(shard_contexts[shard]), np_shape));
+  }
+}
+
+void WaitForCheckpoint() {
+  std::vector<std::future<void>> shards;
+  {
+    PendingCheckpoint* pending = Pending();
+    std::lock_guard<std::mutex> lock(pending->mutex);
+    shards.swap(pending->shards);
+  }
+  for (auto& shard : shards) shard.wait();
+  // all the writers are done before the first error is rethrown
+  for (auto& shard : shards) shard.get();
+}
+
+void LoadSharded(const std::string& prefix, int num_shards, std::vector<NDArray>* data,
+                 std::vector<std::string>* names) {
+  CHECK_GT(num_shards, 0) << "a checkpoint has at least one shard";
+  using Shard = std::pair<std::vector<NDArray>, std::vector<std::string>>;
+  const int np_shape = Imperative::Get()->is_np_shape();
+  std::vector<std::future<Shard>> shards;
+  for (int shard = 0; shard < num_shards; ++shard) {
+    shards.push_back(std::async(std::launch::async, [np_shape](const std::string& fname) {
+      SetShapeSemantics(np_shape);
+      Shard ret;
+      if (!NDArray::LoadMapped(fname, {}, &ret.first, &ret.second)) {
+        std::unique_ptr<dmlc::Stream> fi(dmlc::Stream::Create(fname.c_str(), "r"));
+        NDArray::Load(fi.get(), &ret.first, &ret.second);
+      }
+      CHECK_EQ(ret.first.size(), ret.second.size())
+          << "the ndarrays of the checkpoint shard " << fname << " have no names";
+      return ret;
+    }, CheckpointShardName(prefix, shard, num_shards)));
+  }
+  for (auto& shard : shards) shard.wait();
+  data->clear();
+  names->clear();
+  for (auto& shard : shards) {
+    Shard ret = shard.get();
+    data->insert(data->end(), ret.first.begin(), ret.first.end());
+    names->insert(names->end(), ret.second.begin(), ret.second.end());
+  }
+}
+
+}  // namespace ndarray
+}  // namespace mxnet
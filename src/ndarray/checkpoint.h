@@ -0,0 +1,61 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file checkpoint.h
+ * \brief Sharded checkpoints written in the background and loaded in parallel.
+ */
+#ifndef MXNET_NDARRAY_CHECKPOINT_H_
+#define MXNET_NDARRAY_CHECKPOINT_H_
+
+#include <mxnet/ndarray.h>
+#include <string>
+#include <vector>
+
+namespace mxnet {
+namespace ndarray {
+
+/*! \brief the file of shard `shard` of a checkpoint of num_shards files */
+std::string CheckpointShardName(const std::string& prefix, int shard, int num_shards);
+
+/*!
+ * \brief Save named ndarrays into num_shards files, balanced by size, and return before
+ *  the files are written.
+ *
+ *  The ndarrays are snapshotted by engine copies, to pinned host memory for the dense
+ *  ndarrays of GPUs, so that they can be updated as soon as the copies have read them.
+ *  A thread per shard then waits for its snapshots and writes them, in the mapped format
+ *  unless the shard holds sparse ndarrays. Local files are written under a temporary name
+ *  and renamed once complete. The previous checkpoint is waited for first, so that the
+ *  snapshots of at most one checkpoint are kept.
+ */
+void SaveShardedAsync(const std::string& prefix, const std::vector<NDArray>& data,
+                      const std::vector<std::string>& names, int num_shards);
+
+/*! \brief wait for the checkpoint being written, rethrowing the errors of its writers */
+void WaitForCheckpoint();
+
+/*! \brief load the ndarrays of the num_shards files of a checkpoint, a thread per shard */
+void LoadSharded(const std::string& prefix, int num_shards, std::vector<NDArray>* data,
+                 std::vector<std::string>* names);
+
+}  // namespace ndarray
+}  // namespace mxnet
+
+#endif  // MXNET_NDARRAY_CHECKPOINT_H_
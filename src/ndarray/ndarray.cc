@@ -31,12 +31,17 @@
 #include <mxnet/resource.h>
 #include <mxnet/imperative.h>
 #include <mshadow/tensor.h>
+#include <cstdio>
+#include <future>
+#include <unordered_map>
 #include "./ndarray_function.h"
 #include "../common/utils.h"
+#include "../common/cuda/utils.h"
 #include "../operator/tensor/matrix_op-inl.h"
 #include "../operator/tensor/init_op.h"
 #include "../operator/nn/mkldnn/mkldnn_base-inl.h"
 #include "../profiler/storage_profiler.h"
+#include "../io/mapped_file.h"
 
 #if MXNET_USE_OPENCV
 #include <opencv2/opencv.hpp>
@@ -88,18 +93,39 @@ void NDArray::AssignStorageInfo(const std::string& profiler_scope,
   }
   ptr_->shandle.profiler_scope = profiler_scope;
   ptr_->shandle.name = name;
+  profiler::MemoryTimeline::Get()->UpdateStorageInfo(ptr_->shandle);
 #if MXNET_USE_CUDA
   profiler::GpuDeviceStorageProfiler::Get()->UpdateStorageInfo(ptr_->shandle);
 #endif  // MXNET_USE_CUDA
   for (Storage::Handle& aux_handle : ptr_->aux_handles) {
     aux_handle.profiler_scope = profiler_scope;
     aux_handle.name = name + "_aux_data";
+    profiler::MemoryTimeline::Get()->UpdateStorageInfo(aux_handle);
 #if MXNET_USE_CUDA
     profiler::GpuDeviceStorageProfiler::Get()->UpdateStorageInfo(aux_handle);
 #endif  // MXNET_USE_CUDA
   }
 }
 
+void NDArray::PrefetchManaged(const RunContext& rctx) const {
+#if MXNET_USE_CUDA
+  if (is_none()) return;
+  cudaStream_t stream = mshadow::Stream<gpu>::GetStream(rctx.get_stream<gpu>());
+  cudaStreamCaptureStatus capture = cudaStreamCaptureStatusNone;
+  auto prefetch = [&](const Storage::Handle& handle) {
+    if (!handle.managed_prefetch || handle.dptr == nullptr) return;
+    // the prefetches are not recorded in the cuda graphs, whose kernels fault the pages in
+    if (capture == cudaStreamCaptureStatusNone)
+      CUDA_CALL(cudaStreamIsCapturing(stream, &capture));
+    if (capture != cudaStreamCaptureStatusNone) return;
+    CUDA_CALL(cudaMemPrefetchAsync(handle.dptr, handle.size, rctx.get_ctx().real_dev_id(),
+                                   stream));
+  };
+  prefetch(ptr_->shandle);
+  for (const Storage::Handle& aux_handle : ptr_->aux_handles) prefetch(aux_handle);
+#endif  // MXNET_USE_CUDA
+}
+
 void NDArray::SetShapeFromChunk() const {
   if (Imperative::Get()->is_np_shape() ||
       !(ptr_->storage_shape.ndim() == 1 && ptr_->storage_shape[0] == 0)) {
@@ -124,8 +150,17 @@ NDArray::Chunk::~Chunk() {
   // We want to delete mkldnn memory after deleting the variable.
   mem.mem = this->mkl_mem_;
 #endif
-  if (auto engine = engine_ref_.lock()) {
-    engine->DeleteVariable([mem, skip_free](RunContext s) {
+  auto engine = engine_ref_.lock();
+  if (!engine) {
+    if (release) release();
+  } else if (external_var) {
+    // the variable is not ours to delete, only wait for the operations on the buffer
+    if (release) {
+      engine->PushSync([release = this->release](RunContext s) { release(); },
+                       shandle.ctx, {}, {var}, FnProperty::kNormal, 0, "ReleaseBuffer");
+    }
+  } else {
+    engine->DeleteVariable([mem, skip_free, release = this->release](RunContext s) {
       if (skip_free == false) {
 #if MXNET_USE_MKLDNN == 1
         if (mem.mem) {
@@ -138,6 +173,7 @@ NDArray::Chunk::~Chunk() {
           Storage::Get()->Free(aux);
         }
       }
+      if (release) release();
     }, shandle.ctx, var);
   }
 }
@@ -428,6 +464,53 @@ DLManagedTensor* NDArray::ToDLPack() const {
   return &(dlmanager->tensor);
 }
 
+void NDArray::SyncToStream(void* stream, bool write) const {
+  CHECK(!is_none()) << "NDArray is not initialized";
+  CHECK_EQ(ctx().dev_mask(), gpu::kDevMask) << "SyncToStream needs an NDArray on GPU";
+#if MXNET_USE_CUDA
+  cudaStream_t consumer = static_cast<cudaStream_t>(stream);
+  auto queued = std::make_shared<std::promise<void>>();
+  std::future<void> done = queued->get_future();
+  // kNoSkip, so that the wait ends when an operator writing the NDArray failed as well
+  Engine::Get()->PushAsync([consumer, queued](RunContext rctx,
+                                              Engine::CallbackOnComplete on_complete) {
+      cudaEvent_t event;
+      CUDA_CALL(cudaEventCreateWithFlags(&event, cudaEventDisableTiming));
+      CUDA_CALL(cudaEventRecord(event, rctx.get_stream<gpu>()->stream_));
+      CUDA_CALL(cudaStreamWaitEvent(consumer, event, 0));
+      // the queued wait keeps what it needs of the event
+      CUDA_CALL(cudaEventDestroy(event));
+      queued->set_value();
+      on_complete();
+    }, ctx(), write ? std::vector<Engine::VarHandle>{} : std::vector<Engine::VarHandle>{var()},
+    write ? std::vector<Engine::VarHandle>{var()} : std::vector<Engine::VarHandle>{},
+    FnProperty::kNoSkip, 0, "SyncToStream");
+  done.wait();
+  Engine::Get()->Throw(var());
+#else
+  LOG(FATAL) << "GPU is not enabled";
+#endif
+}
+
+void NDArray::SyncFromStream(void* stream) const {
+  CHECK(!is_none()) << "NDArray is not initialized";
+  CHECK_EQ(ctx().dev_mask(), gpu::kDevMask) << "SyncFromStream needs an NDArray on GPU";
+#if MXNET_USE_CUDA
+  cudaEvent_t event;
+  {
+    common::cuda::DeviceStore device_store(ctx().dev_id);
+    CUDA_CALL(cudaEventCreateWithFlags(&event, cudaEventDisableTiming));
+    CUDA_CALL(cudaEventRecord(event, static_cast<cudaStream_t>(stream)));
+  }
+  Engine::Get()->PushSync([event](RunContext rctx) {
+      CUDA_CALL(cudaStreamWaitEvent(rctx.get_stream<gpu>()->stream_, event, 0));
+      CUDA_CALL(cudaEventDestroy(event));
+    }, ctx(), {}, {var()}, FnProperty::kNormal, 0, "SyncFromStream");
+#else
+  LOG(FATAL) << "GPU is not enabled";
+#endif
+}
+
 NDArray NDArray::FromDLPack(const DLManagedTensor* tensor, bool transient_handle) {
   DLManagedTensor *tensor_copy = transient_handle
                                ? new DLManagedTensor(*tensor)
@@ -924,7 +1007,7 @@ void TernaryOp(const NDArray &lhs,
       TBlob tmp = ret.data();
       ndarray::Eval<gpu, OP>(lhs.data(), mhs.data(), rhs.data(), &tmp, ctx);
       // Wait GPU kernel to complete
-      ctx.get_stream<gpu>()->Wait();
+      if (!ctx.event_sync) ctx.get_stream<gpu>()->Wait();
     }, lhs.ctx(), const_vars, { ret.var() },
     FnProperty::kNormal, 0, PROFILER_MESSAGE_FUNCNAME);
     break;
@@ -1002,7 +1085,7 @@ void BinaryOpKernel(const NDArray &lhs,
         mshadow::Stream<gpu>* s = ctx.get_stream<gpu>();
         ndarray::BinaryOpKernelImpl<OP>(s, lhs.data(), rhs.data(), &tmp);
         // Wait GPU kernel to complete
-        ctx.get_stream<gpu>()->Wait();
+        if (!ctx.event_sync) ctx.get_stream<gpu>()->Wait();
       }, lhs.ctx(), const_vars, {ret.var()},
       FnProperty::kNormal, 0, PROFILER_MESSAGE_FUNCNAME);
       break;
@@ -1042,7 +1125,7 @@ void BinaryOp(const NDArray &lhs,
           TBlob tmp = ret.data();
           ndarray::Eval<gpu, OP>(lhs.data(), rhs.data(), &tmp, ctx);
           // Wait GPU kernel to complete
-          ctx.get_stream<gpu>()->Wait();
+          if (!ctx.event_sync) ctx.get_stream<gpu>()->Wait();
         }, lhs.ctx(), const_vars, {ret.var()},
         FnProperty::kNormal, 0, PROFILER_MESSAGE_FUNCNAME);
       break;
@@ -1076,7 +1159,7 @@ void SetValueOp(const real_t &rhs, NDArray *out) {
             ndarray::Eval(ctx.get_stream<gpu>(), rhs, ret);
           }
           // Wait GPU kernel to complete
-          ctx.get_stream<gpu>()->Wait();
+          if (!ctx.event_sync) ctx.get_stream<gpu>()->Wait();
           break;
         }
 #endif
@@ -1125,7 +1208,7 @@ void ScalarOp(const NDArray &lhs,
           TBlob tmp = ret.data();
           ndarray::Eval<gpu, OP, reverse>(lhs.data(), rhs, &tmp, ctx);
           // Wait GPU kernel to complete
-          ctx.get_stream<gpu>()->Wait();
+          if (!ctx.event_sync) ctx.get_stream<gpu>()->Wait();
         }, lhs.ctx(), const_vars, {ret.var()},
         FnProperty::kNormal, 0, PROFILER_MESSAGE_FUNCNAME);
       break;
@@ -1361,7 +1444,7 @@ void CopyFromTo(const NDArray& from, const NDArray& to, int priority, bool is_op
       Engine::Get()->PushAsync(
         [from, to, requested](RunContext ctx, Engine::CallbackOnComplete on_complete) {
           CopyFromToImpl<cpu, gpu>(from, to, ctx, requested);
-          ctx.get_stream<gpu>()->Wait();
+          if (!ctx.event_sync || !requested.empty()) ctx.get_stream<gpu>()->Wait();
           on_complete();
         }, to.ctx(), const_vars, mutable_vars,
         FnProperty::kCopyToGPU, priority, "CopyCPU2GPU");
@@ -1369,7 +1452,7 @@ void CopyFromTo(const NDArray& from, const NDArray& to, int priority, bool is_op
       Engine::Get()->PushAsync(
         [from, to, requested](RunContext ctx, Engine::CallbackOnComplete on_complete) {
           CopyFromToImpl<gpu, cpu>(from, to, ctx, requested);
-          ctx.get_stream<gpu>()->Wait();
+          if (!ctx.event_sync || !requested.empty()) ctx.get_stream<gpu>()->Wait();
           on_complete();
         }, from.ctx(), const_vars, mutable_vars,
         FnProperty::kCopyFromGPU, priority, "CopyGPU2CPU");
@@ -1377,7 +1460,7 @@ void CopyFromTo(const NDArray& from, const NDArray& to, int priority, bool is_op
       Engine::Get()->PushAsync(
         [from, to, requested](RunContext ctx, Engine::CallbackOnComplete on_complete) {
           CopyFromToImpl<gpu, gpu>(from, to, ctx, requested);
-          ctx.get_stream<gpu>()->Wait();
+          if (!ctx.event_sync || !requested.empty()) ctx.get_stream<gpu>()->Wait();
           on_complete();
         }, from.ctx(), const_vars, mutable_vars,
         from.dtype() != to.dtype() ? FnProperty::kNormal : FnProperty::kCopyFromGPU,
@@ -1442,7 +1525,7 @@ void ElementwiseSum(const std::vector<NDArray> &source, NDArray *out, int priori
             TBlob tmp = ret.data();
             ndarray::ElementwiseSum<gpu>(source_tblob, &tmp, ctx);
             // Wait GPU kernel to complete
-            ctx.get_stream<gpu>()->Wait();
+            if (!ctx.event_sync) ctx.get_stream<gpu>()->Wait();
           }, out->ctx(), const_vars, {ret.var()},
           FnProperty::kNormal, priority, "DenseElementwiseSum");
         break;
@@ -1539,7 +1622,7 @@ void SampleOP(const real_t &a,
           TBlob tmp = ret.data();
           ndarray::EvalRandom<gpu, Distribution>(a, b, resource, &tmp, ctx);
           // Wait GPU kernel to complete
-          ctx.get_stream<gpu>()->Wait();
+          if (!ctx.event_sync) ctx.get_stream<gpu>()->Wait();
         }, out->ctx(), {}, {ret.var(), resource.var},
         FnProperty::kNormal, 0, PROFILER_MESSAGE_FUNCNAME);
       break;
@@ -1817,10 +1900,9 @@ bool NDArray::LegacyLoad(dmlc::Stream *strm, const uint32_t magic) {
   }
 }
 
-bool NDArray::Load(dmlc::Stream *strm) {
-  uint32_t magic;
-  if (strm->Read(&magic, sizeof(uint32_t)) != sizeof(uint32_t)) return false;
-  if (magic == NDARRAY_V3_MAGIC) {
+/*! \brief check that ndarrays are loaded in the shape semantics they were saved in */
+static void CheckShapeSemantics(bool saved_np_shape) {
+  if (saved_np_shape) {
     CHECK(Imperative::Get()->is_np_shape())
         << "ndarray was saved in np shape semantics, must be loaded in the same semantics."
            " Please turn on np shape semantics in Python using `with np_shape(True)`"
@@ -1832,6 +1914,12 @@ bool NDArray::Load(dmlc::Stream *strm) {
            " Please turn off np shape semantics in Python using `with np_shape(False)`"
            " to scope the code of loading the ndarray.";
   }
+}
+
+bool NDArray::Load(dmlc::Stream *strm) {
+  uint32_t magic;
+  if (strm->Read(&magic, sizeof(uint32_t)) != sizeof(uint32_t)) return false;
+  CheckShapeSemantics(magic == NDARRAY_V3_MAGIC);
   if (magic != NDARRAY_V2_MAGIC && magic != NDARRAY_V3_MAGIC) {
     return LegacyLoad(strm, magic);
   }
@@ -1929,6 +2017,101 @@ bool NDArray::Load(dmlc::Stream *strm) {
 
 const uint64_t kMXAPINDArrayListMagic = 0x112;
 
+// magic number of the mapped format: the magic, the alignment and the size of the index, the
+// index, then the data of each ndarray at a multiple of the alignment from the data start
+const uint64_t kMXAPINDArrayMappedMagic = 0x113;
+static const uint64_t kMappedHeaderBytes = 3 * sizeof(uint64_t);
+// GPU ndarrays of the mapped format are copied by chunks of this size, so that the copies of
+// the first chunks overlap with the reads of the next ones
+static const size_t kMappedCopyChunkBytes = 64 << 20;
+
+static inline uint64_t MappedAlign(uint64_t bytes, uint64_t alignment) {
+  return (bytes + alignment - 1) / alignment * alignment;
+}
+
+/*! \brief the index of an ndarray in the mapped format */
+struct MappedEntry {
+  int32_t type_flag;
+  mxnet::TShape shape;
+  Context ctx;
+  /*! \brief offset of the data from the data start */
+  uint64_t offset;
+  uint64_t nbytes;
+
+  void Save(dmlc::Stream *strm) const {
+    strm->Write(type_flag);
+    shape.Save(strm);
+    ctx.Save(strm);
+    strm->Write(offset);
+    strm->Write(nbytes);
+  }
+  bool Load(dmlc::Stream *strm) {
+    return strm->Read(&type_flag) && shape.Load(strm) && ctx.Load(strm) &&
+           strm->Read(&offset) && strm->Read(&nbytes);
+  }
+};
+
+/*! \brief the index of a file in the mapped format */
+struct MappedIndex {
+  uint64_t alignment;
+  uint64_t index_bytes;
+  uint64_t data_start;
+  uint32_t np_shape;
+  std::vector<MappedEntry> entries;
+  std::vector<std::string> names;
+
+  /*! \brief load the header and the index, following the magic */
+  bool Load(dmlc::Stream *strm) {
+    if (!strm->Read(&alignment) || !strm->Read(&index_bytes) || alignment == 0) return false;
+    std::string index(index_bytes, '\0');
+    if (strm->Read(&index[0], index_bytes) != index_bytes) return false;
+    dmlc::MemoryStringStream is(&index);
+    uint64_t count;
+    if (!is.Read(&np_shape) || !is.Read(&count)) return false;
+    entries.resize(count);
+    for (MappedEntry &entry : entries) {
+      if (!entry.Load(&is)) return false;
+    }
+    if (!is.Read(&names)) return false;
+    data_start = MappedAlign(kMappedHeaderBytes + index_bytes, alignment);
+    return names.empty() || names.size() == entries.size();
+  }
+};
+
+static int NumGPUs() {
+  int device_count = 0;
+#if MXNET_USE_CUDA
+  if (cudaGetDeviceCount(&device_count) != cudaSuccess) device_count = 0;
+#endif
+  return device_count;
+}
+
+/*! \brief load the ndarrays of a stream in the mapped format, following the magic */
+static void LoadMappedStream(dmlc::Stream *fi, std::vector<NDArray> *data,
+                             std::vector<std::string> *keys) {
+  MappedIndex index;
+  CHECK(index.Load(fi)) << "Invalid NDArray file format";
+  CheckShapeSemantics(index.np_shape);
+  const bool has_gpu = NumGPUs() > 0;
+  uint64_t position = kMappedHeaderBytes + index.index_bytes;
+  std::vector<char> padding;
+  data->clear();
+  for (const MappedEntry &entry : index.entries) {
+    const uint64_t begin = index.data_start + entry.offset;
+    CHECK_LE(position, begin) << "Invalid NDArray file format";
+    padding.resize(begin - position);
+    CHECK_EQ(fi->Read(padding.data(), padding.size()), padding.size())
+        << "Invalid NDArray file format";
+    NDArray temp(entry.shape, Context::CPU(), false, entry.type_flag);
+    CHECK_EQ(fi->Read(temp.data().dptr_, entry.nbytes), entry.nbytes)
+        << "Invalid NDArray file format";
+    position = begin + entry.nbytes;
+    data->push_back(entry.ctx.dev_mask() != cpu::kDevMask && has_gpu ? temp.Copy(entry.ctx) :
+                                                                       temp);
+  }
+  *keys = index.names;
+}
+
 void NDArray::Save(dmlc::Stream* fo,
                    const std::vector<NDArray>& data,
                    const std::vector<std::string>& names) {
@@ -1945,6 +2128,10 @@ void NDArray::Load(dmlc::Stream* fi,
   uint64_t header, reserved;
   CHECK(fi->Read(&header))
       << "Invalid NDArray file format";
+  if (header == kMXAPINDArrayMappedMagic) {
+    LoadMappedStream(fi, data, keys);
+    return;
+  }
   CHECK(fi->Read(&reserved))
       << "Invalid NDArray file format";
   CHECK(header == kMXAPINDArrayListMagic)
@@ -1957,6 +2144,144 @@ void NDArray::Load(dmlc::Stream* fi,
       << "Invalid NDArray file format";
 }
 
+void NDArray::SaveMapped(dmlc::Stream* fo,
+                         const std::vector<NDArray>& data,
+                         const std::vector<std::string>& names,
+                         size_t alignment,
+                         const std::vector<Context>& contexts) {
+  CHECK(names.empty() || names.size() == data.size())
+      << "the NDArrays must all have names or none of them";
+  CHECK(contexts.empty() || contexts.size() == data.size())
+      << "the NDArrays must all have contexts or none of them";
+  CHECK(alignment > 0 && (alignment & (alignment - 1)) == 0)
+      << "the alignment must be a power of 2, got " << alignment;
+  MappedIndex index;
+  index.alignment = alignment;
+  index.np_shape = Imperative::Get()->is_np_shape() ? 1 : 0;
+  index.names = names;
+  uint64_t offset = 0;
+  for (size_t i = 0; i < data.size(); ++i) {
+    const NDArray &nd = data[i];
+    CHECK_EQ(nd.storage_type(), kDefaultStorage)
+        << "only NDArrays of default storage type can be saved in the mapped format";
+    CHECK(!nd.is_none()) << "cannot save an empty NDArray in the mapped format";
+    MappedEntry entry;
+    entry.type_flag = nd.dtype();
+    entry.shape = nd.shape();
+    entry.ctx = contexts.empty() ? nd.ctx() : contexts[i];
+    entry.offset = offset;
+    entry.nbytes = nd.shape().Size() * mshadow::mshadow_sizeof(nd.dtype());
+    offset = MappedAlign(offset + entry.nbytes, alignment);
+    index.entries.push_back(entry);
+  }
+  std::string index_data;
+  {
+    dmlc::MemoryStringStream os(&index_data);
+    const uint64_t count = index.entries.size();
+    os.Write(index.np_shape);
+    os.Write(count);
+    for (const MappedEntry &entry : index.entries) entry.Save(&os);
+    os.Write(index.names);
+  }
+  const uint64_t header[] = {kMXAPINDArrayMappedMagic, alignment, index_data.size()};
+  fo->Write(header, sizeof(header));
+  fo->Write(index_data.data(), index_data.size());
+  const std::vector<char> padding(alignment, 0);
+  const uint64_t index_end = kMappedHeaderBytes + index_data.size();
+  fo->Write(padding.data(), MappedAlign(index_end, alignment) - index_end);
+
+  for (size_t i = 0; i < data.size(); ++i) {
+    // copy one ndarray at a time to cpu, so that at most one copy is alive
+    NDArray nd_cpu = data[i];
+    if (nd_cpu.ctx().dev_mask() != cpu::kDevMask) {
+      nd_cpu = nd_cpu.Copy(Context::CPU());
+    }
+    nd_cpu.WaitToRead();
+#if MXNET_USE_MKLDNN == 1
+    if (nd_cpu.IsMKLDNNData())
+      nd_cpu = nd_cpu.Reorder2Default();
+#endif
+    const TBlob save_data = nd_cpu.data();
+    CHECK(save_data.CheckContiguous());
+    const uint64_t nbytes = index.entries[i].nbytes;
+    fo->Write(save_data.dptr_, nbytes);
+    fo->Write(padding.data(), MappedAlign(nbytes, alignment) - nbytes);
+  }
+}
+
+bool NDArray::LoadMapped(const std::string& fname,
+                         const std::vector<std::string>& keys,
+                         std::vector<NDArray>* data,
+                         std::vector<std::string>* names) {
+#ifdef _WIN32
+  return false;
+#else
+  const std::string path = io::LocalPath(fname);
+  if (path.empty()) return false;
+  {
+    // other formats and unreadable files are left to the stream loader and its errors
+    FILE *fp = fopen(path.c_str(), "rb");
+    if (fp == nullptr) return false;
+    uint64_t magic = 0;
+    const size_t nread = fread(&magic, sizeof(magic), 1, fp);
+    fclose(fp);
+    if (nread != 1 || magic != kMXAPINDArrayMappedMagic) return false;
+  }
+  auto file = std::make_shared<io::MappedFile>(path);
+  dmlc::MemoryFixedSizeStream strm(file->data(), file->size());
+  uint64_t magic;
+  MappedIndex index;
+  CHECK(strm.Read(&magic) && index.Load(&strm)) << "Invalid NDArray file format";
+  CheckShapeSemantics(index.np_shape);
+
+  std::vector<size_t> selected;
+  if (keys.empty()) {
+    for (size_t i = 0; i < index.entries.size(); ++i) selected.push_back(i);
+  } else {
+    CHECK(!index.names.empty()) << "the NDArrays of " << fname << " were saved without names";
+    std::unordered_map<std::string, size_t> positions;
+    for (size_t i = 0; i < index.names.size(); ++i) positions[index.names[i]] = i;
+    for (const std::string &key : keys) {
+      auto it = positions.find(key);
+      CHECK(it != positions.end()) << "no NDArray named " << key << " in " << fname;
+      selected.push_back(it->second);
+    }
+  }
+
+  const bool has_gpu = NumGPUs() > 0;
+  data->clear();
+  names->clear();
+  for (size_t i : selected) {
+    const MappedEntry &entry = index.entries[i];
+    const uint64_t begin = index.data_start + entry.offset;
+    CHECK_LE(begin + entry.nbytes, file->size()) << "Invalid NDArray file format";
+    char *dptr = file->data() + begin;
+    // the views keep the mapping alive
+    auto view = [&file, &entry](char *ptr, const mxnet::TShape &shape) {
+      return NDArray(TBlob(ptr, shape, cpu::kDevMask, entry.type_flag, 0), 0, [file]() {});
+    };
+    if (entry.ctx.dev_mask() == cpu::kDevMask || !has_gpu) {
+      data->push_back(view(dptr, entry.shape));
+    } else {
+      NDArray ret(entry.shape, entry.ctx, false, entry.type_flag);
+      const index_t size = entry.shape.Size();
+      const size_t type_size = mshadow::mshadow_sizeof(entry.type_flag);
+      const index_t chunk = std::max<index_t>(1, kMappedCopyChunkBytes / type_size);
+      const NDArray flat = ret.Reshape(mshadow::Shape1(size));
+      file->WillNeed(begin, begin + entry.nbytes);
+      for (index_t start = 0; start < size; start += chunk) {
+        const index_t end = std::min(start + chunk, size);
+        CopyFromTo(view(dptr + start * type_size, mshadow::Shape1(end - start)),
+                   flat.Slice(start, end));
+      }
+      data->push_back(ret);
+    }
+    if (!index.names.empty()) names->push_back(index.names[i]);
+  }
+  return true;
+#endif  // _WIN32
+}
+
 NDArray NDArray::Copy(Context ctx) const {
   NDArray ret;
   if (kDefaultStorage == storage_type()) {
@@ -2156,6 +2481,63 @@ void NDArray::SyncCopyToCPU(void *data, size_t size) const {
   }
 }
 
+void NDArray::AsyncCopyToCPU(void *data, size_t size,
+                             const std::function<void(bool)>& on_complete) const {
+  mxnet::TShape dshape = this->shape();
+  if (!features::is_enabled(features::INT64_TENSOR_SIZE)) {
+    CHECK_LT(size, (int64_t{1} << 31) - 1) <<
+              "[AsyncCopyToCPU] Size of tensor you are trying to allocate is larger than "
+              "2^31 elements. Please build with flag USE_INT64_TENSOR_SIZE=1";
+  }
+  CHECK_EQ(dshape.Size(), size)
+      << "Memory size do not match";
+  CHECK_EQ(storage_type(), kDefaultStorage)
+      << "AsyncCopyToCPU only copies NDArrays of default storage type";
+  // zero-size array, no need to copy
+  if (size == 0U) {
+    on_complete(true);
+    return;
+  }
+  const TBlob dst(data, dshape, cpu::kDevMask, this->dtype_, 0);
+  const NDArray src = *this;
+  auto copied = std::make_shared<bool>(false);
+  // the copy writes done_var, so that an error of the operators writing src skips both the
+  // copy and the writes of done_var, but not the notification which must always run
+  Engine::VarHandle done_var = Engine::Get()->NewVariable();
+  if (this->ctx().dev_mask() == cpu::kDevMask) {
+    Engine::Get()->PushSync([src, dst, copied](RunContext rctx) {
+        NDArray from = src;
+#if MXNET_USE_MKLDNN == 1
+        if (from.IsMKLDNNData())
+          from = src.Reorder2Default();
+#endif
+        TBlob to = dst;
+        ndarray::Copy<cpu, cpu>(from.data(), &to, Context::CPU(), Context::CPU(), rctx);
+        *copied = true;
+      }, this->ctx(), {this->var()}, {done_var},
+      FnProperty::kNormal, 0, "AsyncCopyCPU2CPU");
+  } else {
+#if MXNET_USE_CUDA
+    Engine::Get()->PushAsync(
+      [src, dst, copied](RunContext rctx, Engine::CallbackOnComplete on_complete) {
+        TBlob to = dst;
+        ndarray::Copy<gpu, cpu>(src.data(), &to, src.ctx(), Context::CPU(), rctx);
+        // Wait GPU kernel to complete
+        rctx.get_stream<gpu>()->Wait();
+        *copied = true;
+        on_complete();
+      }, this->ctx(), {this->var()}, {done_var},
+      FnProperty::kCopyFromGPU, 0, "AsyncCopyGPU2CPU");
+#else
+    LOG(FATAL) << "GPU is not enabled";
+#endif
+  }
+  Engine::Get()->PushSync([copied, on_complete](RunContext rctx) {
+      on_complete(*copied);
+    }, Context::CPU(), {}, {done_var}, FnProperty::kNoSkip, 0, "AsyncCopyToCPUComplete");
+  Engine::Get()->DeleteVariable([](RunContext) {}, Context::CPU(), done_var);
+}
+
 void NDArray::SyncCheckFormat(const bool full_check) const {
   int32_t err = kNormalErr;
   TBlob err_cpu(&err, mshadow::Shape1(1), cpu::kDevMask, 0);
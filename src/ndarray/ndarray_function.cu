@@ -35,6 +35,7 @@
 #include "./ndarray_function.h"
 #include "./ndarray_function-inl.h"
 #include "./ndarray_function-inl.cuh"
+#include "./pinned_staging.h"
 
 namespace mxnet {
 namespace ndarray {
@@ -44,6 +45,13 @@ void Copy<cpu, gpu>(const TBlob &from, TBlob *to,
                     RunContext ctx) {
   CHECK_EQ(to->type_flag_, from.type_flag_)
     << "Source and target must have the same data type when copying across devices.";
+  const size_t size = from.Size() * mshadow::mshadow_sizeof(from.type_flag_);
+  if (from_ctx.dev_type != Context::kCPUPinned && PinnedStagingBuffer::Accepts(size)) {
+    // pageable memory, pipeline the transfer through pinned buffers
+    cudaStream_t stream = mshadow::Stream<gpu>::GetStream(ctx.get_stream<gpu>());
+    PinnedStagingBuffer::Get(stream)->CopyToDevice(to->dptr_, from.dptr_, size, stream);
+    return;
+  }
   MSHADOW_TYPE_SWITCH_WITH_BOOL(to->type_flag_, DType, {
     mshadow::Copy(to->FlatTo1D<gpu, DType>(),
                   from.FlatTo1D<cpu, DType>(),
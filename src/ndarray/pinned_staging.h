@@ -0,0 +1,127 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file pinned_staging.h
+ * \brief Pinned staging buffers for copies from pageable host memory to the GPU.
+ */
+#ifndef MXNET_NDARRAY_PINNED_STAGING_H_
+#define MXNET_NDARRAY_PINNED_STAGING_H_
+
+#if MXNET_USE_CUDA
+#include <cuda_runtime.h>
+#include <dmlc/parameter.h>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+#include "../common/cuda/utils.h"
+
+namespace mxnet {
+namespace ndarray {
+
+/*!
+ * \brief Double-buffered pinned staging area of one copy stream.
+ *
+ *  A copy from pageable memory makes the driver stage the data through its own
+ *  pinned buffers, and the calling thread waits for the whole transfer. Here the
+ *  data is split into chunks that are copied alternately into two pinned buffers,
+ *  so that the memcpy of a chunk into one buffer overlaps the DMA transfer of the
+ *  previous chunk from the other one.
+ *
+ *  The buffers hold MXNET_GPU_COPY_STAGING_SIZE bytes each, 0 disables staging.
+ *  Buffers are owned by the thread running the copies and are keyed by stream,
+ *  since the engine gives every copy worker a stream of its own.
+ */
+class PinnedStagingBuffer {
+ public:
+  /*! \brief copies smaller than this are left to the driver */
+  static constexpr size_t kMinStagedSize = 64 * 1024;
+  /*! \brief number of buffers used in turn */
+  static constexpr int kNumBuffers = 2;
+
+  explicit PinnedStagingBuffer(size_t size) : size_(size) {
+    for (int i = 0; i < kNumBuffers; ++i) {
+      // portable, so that a buffer can feed any device
+      CUDA_CALL(cudaHostAlloc(&buffers_[i], size_, cudaHostAllocPortable));
+      CUDA_CALL(cudaEventCreateWithFlags(&events_[i], cudaEventDisableTiming));
+    }
+  }
+  ~PinnedStagingBuffer() {
+    // errors are ignored, the driver may be shutting down
+    for (int i = 0; i < kNumBuffers; ++i) {
+      cudaEventSynchronize(events_[i]);
+      cudaEventDestroy(events_[i]);
+      cudaFreeHost(buffers_[i]);
+    }
+  }
+  /*! \return size in bytes of each staging buffer, 0 if staging is disabled */
+  static size_t BufferSize() {
+    static const size_t size = dmlc::GetEnv("MXNET_GPU_COPY_STAGING_SIZE",
+                                            static_cast<size_t>(4 * 1024 * 1024));
+    return size;
+  }
+  /*! \return whether a copy of size bytes from pageable memory should be staged */
+  static bool Accepts(size_t size) {
+    return BufferSize() != 0 && size >= kMinStagedSize;
+  }
+  /*! \return the staging buffers of the calling thread for a stream */
+  static PinnedStagingBuffer* Get(cudaStream_t stream) {
+    static thread_local std::unordered_map<cudaStream_t,
+                                           std::unique_ptr<PinnedStagingBuffer>> buffers;
+    auto& ret = buffers[stream];
+    if (ret == nullptr) ret = std::make_unique<PinnedStagingBuffer>(BufferSize());
+    return ret.get();
+  }
+  /*!
+   * \brief Enqueue the copy of size bytes of pageable memory to the device on stream.
+   *  The source can be reused when the call returns, the destination is written once
+   *  the stream reaches the copies.
+   */
+  void CopyToDevice(void* dst, const void* src, size_t size, cudaStream_t stream) {
+    char* to = static_cast<char*>(dst);
+    const char* from = static_cast<const char*>(src);
+    for (size_t offset = 0; offset < size; offset += size_) {
+      const size_t n = std::min(size_, size - offset);
+      const int i = next_;
+      next_ = (next_ + 1) % kNumBuffers;
+      // the previous transfer out of this buffer must be done before it is overwritten
+      CUDA_CALL(cudaEventSynchronize(events_[i]));
+      std::memcpy(buffers_[i], from + offset, n);
+      CUDA_CALL(cudaMemcpyAsync(to + offset, buffers_[i], n, cudaMemcpyHostToDevice, stream));
+      CUDA_CALL(cudaEventRecord(events_[i], stream));
+    }
+  }
+
+ private:
+  /*! \brief size in bytes of each buffer */
+  size_t size_;
+  void* buffers_[kNumBuffers] = {nullptr};
+  /*! \brief recorded after the transfer out of each buffer */
+  cudaEvent_t events_[kNumBuffers] = {nullptr};
+  /*! \brief buffer to fill next */
+  int next_{0};
+  DISALLOW_COPY_AND_ASSIGN(PinnedStagingBuffer);
+};
+
+}  // namespace ndarray
+}  // namespace mxnet
+
+#endif  // MXNET_USE_CUDA
+#endif  // MXNET_NDARRAY_PINNED_STAGING_H_
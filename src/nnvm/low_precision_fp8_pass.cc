@@ -0,0 +1,148 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file low_precision_fp8_pass.cc
+ * \brief Replace FullyConnected and batch_dot by their FP8 versions
+ *
+ *  The pass is applied through optimize_for with the name FP8, by amp.convert_symbol when
+ *  fp8_ops are given. The ops named in the comma-separated option `ops` (FullyConnected and
+ *  batch_dot by default) become _contrib_fp8_fully_connected and _contrib_fp8_batch_dot,
+ *  each with a new auxiliary state <node name>_amax_history, returned filled with zeros.
+ *  The options fp8_format, amax_history_len, amax_compute_algo and margin are passed to the
+ *  new nodes, and the nodes named in the comma-separated option `exclude` are kept.
+ */
+
+#include <mxnet/base.h>
+#include <mxnet/ndarray.h>
+#include <nnvm/graph.h>
+#include <nnvm/pass.h>
+#include <nnvm/symbolic.h>
+
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace mxnet {
+
+namespace {
+
+using nnvm::Graph;
+using nnvm::NodeEntry;
+using nnvm::ObjectPtr;
+
+std::unordered_set<std::string> SplitNames(const std::string &names) {
+  std::unordered_set<std::string> ret;
+  std::istringstream is(names);
+  std::string name;
+  while (std::getline(is, name, ',')) {
+    if (!name.empty()) ret.insert(name);
+  }
+  return ret;
+}
+
+/*! \brief The attributes of the node kept by the FP8 op replacing it. */
+const std::vector<std::string> &KeptKeys(const nnvm::Op *op) {
+  static const nnvm::Op *fc_op = nnvm::Op::Get("FullyConnected");
+  static const std::vector<std::string> fc_keys{"num_hidden", "no_bias", "flatten"};
+  static const std::vector<std::string> batch_dot_keys{"transpose_a", "transpose_b"};
+  return op == fc_op ? fc_keys : batch_dot_keys;
+}
+
+}  // namespace
+
+Graph ReducePrecisionFP8(Graph &&g) {
+  using OptionsMap = std::unordered_map<std::string, std::string>;
+  static const std::unordered_map<std::string, std::string> fp8_ops{
+    {"FullyConnected", "_contrib_fp8_fully_connected"},
+    {"batch_dot", "_contrib_fp8_batch_dot"}};
+  const auto &options = g.GetAttr<OptionsMap>("options_map");
+  auto option = [&options](const char *key, const std::string &value) {
+    auto it = options.find(key);
+    return it == options.end() ? value : it->second;
+  };
+  const auto ops = SplitNames(option("ops", "FullyConnected,batch_dot"));
+  const auto excluded = SplitNames(option("exclude", ""));
+  for (const std::string &name : ops) {
+    CHECK(fp8_ops.count(name)) << "the FP8 pass converts FullyConnected and batch_dot, got "
+                               << name;
+  }
+  const int history_len = std::stoi(option("amax_history_len", "16"));
+  OptionsMap fp8_options;
+  for (const char *key : {"fp8_format", "amax_history_len", "amax_compute_algo", "margin"}) {
+    if (options.count(key)) fp8_options[key] = options.at(key);
+  }
+
+  std::unordered_set<std::string> input_names;
+  std::vector<ObjectPtr> nodes;
+  DFSVisit(g.outputs, [&](const ObjectPtr &n) {
+    if (n->is_variable()) {
+      input_names.insert(n->attrs.name);
+    } else if (ops.count(n->op()->name) && !excluded.count(n->attrs.name) &&
+               !n->attrs.dict.count("forward_stype")) {
+      nodes.push_back(n);
+    }
+  });
+
+  std::vector<NDArray *> new_aux;
+  std::vector<std::string> new_aux_names;
+  for (const ObjectPtr &n : nodes) {
+    nnvm::NodeAttrs attrs;
+    attrs.op = nnvm::Op::Get(fp8_ops.at(n->op()->name));
+    attrs.name = n->attrs.name;
+    for (const std::string &key : KeptKeys(n->op())) {
+      auto it = n->attrs.dict.find(key);
+      if (it != n->attrs.dict.end()) attrs.dict[key] = it->second;
+    }
+    attrs.dict.insert(fp8_options.begin(), fp8_options.end());
+    attrs.op->attr_parser(&attrs);
+
+    std::string history = n->attrs.name + "_amax_history";
+    while (input_names.count(history)) history += "_";
+    input_names.insert(history);
+    NDArray *value = new NDArray(mshadow::Shape2(3, history_len), Context::CPU(), false,
+                                 mshadow::kFloat32);
+    *value = 0.0f;
+    new_aux.push_back(value);
+    new_aux_names.push_back(history);
+    NodeEntry var = nnvm::Symbol::CreateVariable(history).outputs[0];
+    var.node->attrs.dict["__init__"] = "[\"zero\", {}]";
+    // the node is converted in place, so that its consumers need no rewiring
+    n->attrs = std::move(attrs);
+    n->inputs.push_back(std::move(var));
+  }
+
+  Graph ret;
+  ret.outputs = g.outputs;
+  ret.attrs["new_args"] = std::make_shared<nnvm::any>(std::vector<NDArray *>());
+  ret.attrs["new_arg_names"] = std::make_shared<nnvm::any>(std::vector<std::string>());
+  ret.attrs["new_aux"] = std::make_shared<nnvm::any>(std::move(new_aux));
+  ret.attrs["new_aux_names"] = std::make_shared<nnvm::any>(std::move(new_aux_names));
+  return ret;
+}
+
+NNVM_REGISTER_PASS(FP8)
+.describe("Replace FullyConnected and batch_dot by their FP8 versions with delayed scaling.")
+.set_body(ReducePrecisionFP8)
+.set_change_graph(true)
+.depend_graph_attr("options_map");
+
+}  // namespace mxnet
@@ -0,0 +1,192 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file bias_dropout_add-inl.h
+ * \brief fused bias add, dropout and residual add, with a bit-packed dropout mask
+ */
+
+#ifndef MXNET_OPERATOR_CONTRIB_BIAS_DROPOUT_ADD_INL_H_
+#define MXNET_OPERATOR_CONTRIB_BIAS_DROPOUT_ADD_INL_H_
+
+#include <dmlc/parameter.h>
+#include <mxnet/operator.h>
+#include <vector>
+#include "../mshadow_op.h"
+#include "../mxnet_op.h"
+#include "../operator_common.h"
+#include "../nn/dropout-inl.h"
+
+namespace mxnet {
+namespace op {
+
+namespace bias_dropout_add {
+enum BiasDropoutAddInputs {kData, kBias, kResidual};
+enum BiasDropoutAddOutputs {kOut, kMask};
+}  // namespace bias_dropout_add
+
+struct BiasDropoutAddParam : public dmlc::Parameter<BiasDropoutAddParam> {
+  float p;
+  int mode;
+  DMLC_DECLARE_PARAMETER(BiasDropoutAddParam) {
+    DMLC_DECLARE_FIELD(p).set_default(0.5)
+    .set_range(0, 1)
+    .describe("Fraction of the biased input that gets dropped out during training time.");
+    DMLC_DECLARE_FIELD(mode)
+    .add_enum("training", dropout::kTraining)
+    .add_enum("always", dropout::kAlways)
+    .set_default(dropout::kTraining)
+    .describe("Whether to only turn on dropout during training or to also turn on for inference.");
+  }
+};
+
+struct BiasDropoutAddState {
+  explicit BiasDropoutAddState(const BiasDropoutAddParam& param) : param(param) {}
+  BiasDropoutAddParam param;
+  /*! \brief whether the last forward ran without dropout, so that the backward uses no mask */
+  bool passthrough = true;
+};
+
+/*!
+ * \brief out = dropout(data + bias) + residual over the bytes of the mask, each byte
+ *        covering 8 items of the output.
+ */
+template<typename xpu>
+struct BiasDropoutAddKernel {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(index_t id, RandGenerator<xpu, DType> gen,
+                                  const index_t N, const index_t step,
+                                  const index_t size, const index_t channels,
+                                  DType *out, uint8_t *mask, const DType *data,
+                                  const DType *bias, const DType *residual,
+                                  const real_t pkeep) {
+    RNG_KERNEL_LOOP(xpu, DType, id, gen, N, step, {
+      uint8_t bits = 0;
+      for (index_t j = i * 8; j < i * 8 + 8 && j < size; ++j) {
+        const real_t rand_num = static_cast<real_t>(genImpl.uniform());
+        const real_t keep = mshadow_op::threshold_eq::Map<real_t>(rand_num, pkeep);
+        out[j] = (data[j] + bias[j % channels]) * (keep * (1.0f / pkeep)) + residual[j];
+        bits |= static_cast<uint8_t>(keep) << (j & 7);
+      }
+      mask[i] = bits;
+    });
+  }
+};
+
+/*! \brief out = data + bias + residual, the forward without dropout */
+template<int req>
+struct BiasAddResidualKernel {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(index_t i, DType *out, const DType *data,
+                                  const DType *bias, const DType *residual,
+                                  const index_t channels) {
+    KERNEL_ASSIGN(out[i], req, data[i] + bias[i % channels] + residual[i]);
+  }
+};
+
+template<typename xpu>
+void BiasDropoutAddForward(const OpStatePtr& state,
+                           const OpContext& ctx,
+                           const std::vector<TBlob>& inputs,
+                           const std::vector<OpReqType>& req,
+                           const std::vector<TBlob>& outputs) {
+  using namespace mxnet_op;
+  using namespace bias_dropout_add;
+  CHECK_EQ(inputs.size(), 3U);
+  CHECK_EQ(outputs.size(), 2U);
+  if (req[kOut] == kNullOp) return;
+  BiasDropoutAddState& op_state = state.get_state<BiasDropoutAddState>();
+  const BiasDropoutAddParam& param = op_state.param;
+  mshadow::Stream<xpu> *s = ctx.get_stream<xpu>();
+  const TBlob& out = outputs[kOut];
+  const index_t channels = inputs[kBias].Size();
+  const real_t pkeep = 1.0f - param.p;
+  op_state.passthrough = !(pkeep < 1 && (ctx.is_train || param.mode == dropout::kAlways));
+  MSHADOW_REAL_TYPE_SWITCH(out.type_flag_, DType, {
+    if (op_state.passthrough) {
+      MXNET_ASSIGN_REQ_SWITCH(req[kOut], Req, {
+        Kernel<BiasAddResidualKernel<Req>, xpu>::Launch(
+          s, out.Size(), out.dptr<DType>(), inputs[kData].dptr<DType>(),
+          inputs[kBias].dptr<DType>(), inputs[kResidual].dptr<DType>(), channels);
+      });
+    } else {
+      CHECK(req[kOut] != kAddTo);
+      RandGenerator<xpu, DType> *pgen = ctx.requested[0].get_parallel_random<xpu, DType>();
+      CHECK_NOTNULL(pgen);
+      LaunchRNG<BiasDropoutAddKernel<xpu>, xpu>(
+        s, pgen, (out.Size() + 7) / 8, out.Size(), channels, out.dptr<DType>(),
+        outputs[kMask].dptr<uint8_t>(), inputs[kData].dptr<DType>(),
+        inputs[kBias].dptr<DType>(), inputs[kResidual].dptr<DType>(), pkeep);
+    }
+  });
+}
+
+template<typename xpu>
+void BiasDropoutAddBackward(const OpStatePtr& state,
+                            const OpContext& ctx,
+                            const std::vector<TBlob>& inputs,
+                            const std::vector<OpReqType>& req,
+                            const std::vector<TBlob>& outputs) {
+  using namespace mshadow;
+  using namespace mshadow::expr;
+  using namespace mxnet_op;
+  using namespace bias_dropout_add;
+  CHECK_EQ(inputs.size(), 2U);
+  CHECK_EQ(outputs.size(), 3U);
+  const BiasDropoutAddState& op_state = state.get_state<BiasDropoutAddState>();
+  const BiasDropoutAddParam& param = op_state.param;
+  const bool passthrough = op_state.passthrough;
+  Stream<xpu> *s = ctx.get_stream<xpu>();
+  const TBlob& ograd = inputs[0];
+  const TBlob& mask = inputs[1];
+  const index_t size = ograd.Size();
+  const index_t channels = outputs[kBias].Size();
+  const real_t pkeep = 1.0f - param.p;
+  MSHADOW_REAL_TYPE_SWITCH(ograd.type_flag_, DType, {
+    MXNET_ASSIGN_REQ_SWITCH(req[kResidual], Req, {
+      Kernel<op_with_req<mshadow_op::identity, Req>, xpu>::Launch(
+        s, size, outputs[kResidual].dptr<DType>(), ograd.dptr<DType>());
+    });
+    if (req[kData] == kNullOp && req[kBias] == kNullOp) return;
+    // the bias gradient sums the data gradient, which needs its own buffer with kAddTo
+    const bool own_buffer = req[kData] == kWriteTo || req[kData] == kWriteInplace;
+    DType *gdata = own_buffer ? outputs[kData].dptr<DType>() :
+        ctx.requested[0].get_space_typed<xpu, 1, DType>(Shape1(size), s).dptr_;
+    if (passthrough) {
+      Kernel<op_with_req<mshadow_op::identity, kWriteTo>, xpu>::Launch(
+        s, size, gdata, ograd.dptr<DType>());
+    } else {
+      CHECK_EQ(static_cast<size_t>(DropoutMaskBytes(size)), mask.Size());
+      Kernel<DropoutMaskGradKernel<kWriteTo>, xpu>::Launch(
+        s, size, gdata, ograd.dptr<DType>(), mask.dptr<uint8_t>(), pkeep);
+    }
+    if (req[kData] == kAddTo) {
+      Kernel<op_with_req<mshadow_op::identity, kAddTo>, xpu>::Launch(
+        s, size, outputs[kData].dptr<DType>(), gdata);
+    }
+    Tensor<xpu, 2, DType> gdata_2d(gdata, Shape2(size / channels, channels), s);
+    Tensor<xpu, 1, DType> gbias = outputs[kBias].FlatTo1D<xpu, DType>(s);
+    ASSIGN_DISPATCH(gbias, req[kBias], sum_rows(gdata_2d));
+  });
+}
+
+}  // namespace op
+}  // namespace mxnet
+
+#endif  // MXNET_OPERATOR_CONTRIB_BIAS_DROPOUT_ADD_INL_H_
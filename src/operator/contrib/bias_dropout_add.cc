@@ -0,0 +1,133 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file bias_dropout_add.cc
+ * \brief CPU registration of the fused bias add, dropout and residual add
+ */
+#include "./bias_dropout_add-inl.h"
+
+namespace mxnet {
+namespace op {
+
+DMLC_REGISTER_PARAMETER(BiasDropoutAddParam);
+
+static bool BiasDropoutAddShape(const nnvm::NodeAttrs& attrs,
+                                mxnet::ShapeVector* in_shape,
+                                mxnet::ShapeVector* out_shape) {
+  using namespace bias_dropout_add;
+  CHECK_EQ(in_shape->size(), 3U) << "Input:[data, bias, residual]";
+  mxnet::TShape dshape = in_shape->at(kData);
+  if (!mxnet::ndim_is_known(dshape)) dshape = in_shape->at(kResidual);
+  if (!mxnet::ndim_is_known(dshape)) return false;
+  CHECK_GE(dshape.ndim(), 1) << "data should have at least one axis";
+  SHAPE_ASSIGN_CHECK(*in_shape, kData, dshape);
+  SHAPE_ASSIGN_CHECK(*in_shape, kResidual, dshape);
+  SHAPE_ASSIGN_CHECK(*in_shape, kBias, mxnet::TShape(1, dshape[dshape.ndim() - 1]));
+  out_shape->resize(2);
+  SHAPE_ASSIGN_CHECK(*out_shape, kOut, dshape);
+  if (!mxnet::shape_is_known(dshape)) return false;
+  SHAPE_ASSIGN_CHECK(*out_shape, kMask, mxnet::TShape(1, DropoutMaskBytes(dshape.Size())));
+  return true;
+}
+
+static bool BiasDropoutAddType(const nnvm::NodeAttrs& attrs,
+                               std::vector<int>* in_type,
+                               std::vector<int>* out_type) {
+  using namespace bias_dropout_add;
+  CHECK_EQ(in_type->size(), 3U);
+  int dtype = -1;
+  for (int t : *in_type) {
+    if (t != -1) dtype = t;
+  }
+  if (dtype == -1) return false;
+  for (size_t i = 0; i < in_type->size(); ++i) TYPE_ASSIGN_CHECK(*in_type, i, dtype);
+  out_type->resize(2);
+  TYPE_ASSIGN_CHECK(*out_type, kOut, dtype);
+  TYPE_ASSIGN_CHECK(*out_type, kMask, mshadow::kUint8);
+  return true;
+}
+
+static OpStatePtr CreateBiasDropoutAddState(const nnvm::NodeAttrs& attrs,
+                                            const Context ctx,
+                                            const mxnet::ShapeVector& in_shapes,
+                                            const std::vector<int>& in_types) {
+  return OpStatePtr::Create<BiasDropoutAddState>(
+      nnvm::get<BiasDropoutAddParam>(attrs.parsed));
+}
+
+NNVM_REGISTER_OP(_contrib_bias_dropout_add)
+.describe(R"code(Adds the bias along the last axis of data, applies dropout and adds the
+residual, in a single pass over the data::
+
+  out = dropout(data + bias, p) + residual
+
+This is the epilogue of the projections in transformer layers. The dropout mask is kept
+for the backward as one bit per element, and is not an output of the operator.
+)code" ADD_FILELINE)
+.set_num_inputs(3)
+.set_num_outputs(2)
+.set_attr_parser(ParamParser<BiasDropoutAddParam>)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    return std::vector<std::string>{"data", "bias", "residual"};
+  })
+.set_attr<nnvm::FListOutputNames>("FListOutputNames",
+  [](const NodeAttrs& attrs) {
+    return std::vector<std::string>{"output", "mask"};
+  })
+.set_attr<nnvm::FNumVisibleOutputs>("FNumVisibleOutputs",
+  [](const NodeAttrs& attrs) {
+    return 1;
+  })
+.set_attr<mxnet::FInferShape>("FInferShape", BiasDropoutAddShape)
+.set_attr<nnvm::FInferType>("FInferType", BiasDropoutAddType)
+.set_attr<FCreateOpState>("FCreateOpState", CreateBiasDropoutAddState)
+.set_attr<FStatefulCompute>("FStatefulCompute<cpu>", BiasDropoutAddForward<cpu>)
+.set_attr<nnvm::FGradient>("FGradient",
+  [](const nnvm::ObjectPtr& n, const std::vector<nnvm::NodeEntry>& ograds) {
+    std::vector<nnvm::NodeEntry> heads;
+    heads.push_back(ograds[0]);
+    heads.emplace_back(n, bias_dropout_add::kMask, 0);
+    return MakeGradNode("_backward_contrib_bias_dropout_add", n, heads, n->attrs.dict);
+  })
+.set_attr<nnvm::FInplaceOption>("FInplaceOption", [](const NodeAttrs& attrs) {
+  return std::vector<std::pair<int, int> >{{bias_dropout_add::kData, 0}};
+})
+.set_attr<FResourceRequest>("FResourceRequest", [](const NodeAttrs& attrs) {
+  return std::vector<ResourceRequest>{ResourceRequest::kParallelRandom};
+})
+.add_argument("data", "NDArray-or-Symbol", "Input to which the bias is added.")
+.add_argument("bias", "NDArray-or-Symbol", "Bias along the last axis of data.")
+.add_argument("residual", "NDArray-or-Symbol", "Residual added after the dropout.")
+.add_arguments(BiasDropoutAddParam::__FIELDS__());
+
+NNVM_REGISTER_OP(_backward_contrib_bias_dropout_add)
+.set_num_inputs(2)
+.set_num_outputs(3)
+.set_attr<bool>("TIsLayerOpBackward", true)
+.set_attr<nnvm::TIsBackward>("TIsBackward", true)
+.set_attr_parser(ParamParser<BiasDropoutAddParam>)
+.set_attr<FResourceRequest>("FResourceRequest", [](const NodeAttrs& attrs) {
+  return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
+})
+.set_attr<FStatefulCompute>("FStatefulCompute<cpu>", BiasDropoutAddBackward<cpu>);
+
+}  // namespace op
+}  // namespace mxnet
@@ -112,6 +112,123 @@ struct BooleanMaskBackwardKernel {
   }
 };
 
+struct BooleanMaskPaddedParam : public dmlc::Parameter<BooleanMaskPaddedParam> {
+  int axis;
+  double fill_value;
+  DMLC_DECLARE_PARAMETER(BooleanMaskPaddedParam) {
+    DMLC_DECLARE_FIELD(axis).set_default(0)
+    .describe("An integer that represents the axis in NDArray to mask from.");
+    DMLC_DECLARE_FIELD(fill_value).set_default(0)
+    .describe("The value of the rows of the output past the selected rows.");
+  }
+};
+
+/*!
+ * \brief Copy the selected rows of data to the front of out and fill the other rows
+ *        of out, with idx the inclusive prefix sum of the mask of num_rows rows.
+ */
+struct BooleanMaskPaddedForwardKernel {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(index_t i,
+                                  DType* out,
+                                  const DType* data,
+                                  const int32_t* idx,
+                                  const index_t num_rows,
+                                  const index_t col_size,
+                                  const DType fill_value) {
+    const index_t row_id = i / col_size;
+    const index_t col_id = i % col_size;
+    const int32_t prev = (row_id == 0) ? 0 : idx[row_id - 1];
+    if (prev != idx[row_id]) {
+      out[prev * col_size + col_id] = data[i];
+    }
+    if (row_id >= idx[num_rows - 1]) {
+      out[i] = fill_value;
+    }
+  }
+};
+
+/*! \brief Write the number of selected rows, the last of the inclusive prefix sum */
+struct BooleanMaskValidLengthKernel {
+  MSHADOW_XINLINE static void Map(index_t i,
+                                  int32_t* valid_length,
+                                  const int32_t* idx,
+                                  const index_t num_rows) {
+    valid_length[0] = num_rows > 0 ? idx[num_rows - 1] : 0;
+  }
+};
+
+/*!
+ * \brief Inclusive prefix sum of the non-zeros of the 1-d mask, held in the temp
+ *        space of ctx. It stays on the device, the host does not wait for it.
+ */
+template<typename xpu>
+int32_t* BooleanMaskPrefixSum(const OpContext &ctx, const TBlob &mask);
+
+template<typename xpu>
+void BooleanMaskPaddedForward(const nnvm::NodeAttrs& attrs,
+                              const OpContext &ctx,
+                              const std::vector<TBlob> &inputs,
+                              const std::vector<OpReqType> &req,
+                              const std::vector<TBlob> &outputs) {
+  using namespace mxnet_op;
+  CHECK_EQ(inputs.size(), 2U);
+  CHECK_EQ(outputs.size(), 2U);
+  CHECK(req[0] == kWriteTo || req[0] == kNullOp)
+    << "boolean_mask_padded only supports kWriteTo";
+  const BooleanMaskPaddedParam& param = nnvm::get<BooleanMaskPaddedParam>(attrs.parsed);
+  CHECK_EQ(param.axis, 0) << "Not supported yet";
+  const TBlob &data = inputs[0];
+  const TBlob &idx = inputs[1];
+  mshadow::Stream<xpu> *s = ctx.get_stream<xpu>();
+  const index_t num_rows = idx.Size();
+  int32_t* prefix_sum = num_rows > 0 ? BooleanMaskPrefixSum<xpu>(ctx, idx) : nullptr;
+  if (req[0] != kNullOp && data.Size() > 0) {
+    const index_t col_size = data.Size() / num_rows;
+    MSHADOW_TYPE_SWITCH_WITH_BOOL(data.type_flag_, DType, {
+      Kernel<BooleanMaskPaddedForwardKernel, xpu>::Launch(
+        s, data.Size(), outputs[0].dptr<DType>(), data.dptr<DType>(), prefix_sum,
+        num_rows, col_size, static_cast<DType>(param.fill_value));
+    });
+  }
+  if (req[1] != kNullOp) {
+    Kernel<BooleanMaskValidLengthKernel, xpu>::Launch(
+      s, 1, outputs[1].dptr<int32_t>(), prefix_sum, num_rows);
+  }
+}
+
+template<typename xpu>
+void BooleanMaskPaddedBackward(const nnvm::NodeAttrs& attrs,
+                               const OpContext &ctx,
+                               const std::vector<TBlob> &inputs,
+                               const std::vector<OpReqType> &req,
+                               const std::vector<TBlob> &outputs) {
+  using namespace mxnet_op;
+  // inputs: {ograd_out, ograd_valid_length, data, index}
+  // outputs: {igrad_data, igrad_index}
+  CHECK_EQ(inputs.size(), 4U);
+  CHECK_EQ(outputs.size(), 2U);
+  const TBlob &ograd = inputs[0];
+  const TBlob &idx = inputs[3];
+  const TBlob &igrad = outputs[0];
+  mshadow::Stream<xpu> *s = ctx.get_stream<xpu>();
+  const index_t num_rows = idx.Size();
+  if (req[0] != kNullOp && igrad.Size() > 0) {
+    int32_t* prefix_sum = BooleanMaskPrefixSum<xpu>(ctx, idx);
+    const size_t col_size = igrad.Size() / num_rows;
+    MSHADOW_TYPE_SWITCH(igrad.type_flag_, DType, {
+      Kernel<BooleanMaskBackwardKernel, xpu>::Launch(
+        s, igrad.Size(), igrad.dptr<DType>(), req[0], ograd.dptr<DType>(),
+        prefix_sum, col_size);
+    });
+  }
+  if (req[1] == kWriteTo || req[1] == kWriteInplace) {
+    MSHADOW_TYPE_SWITCH_WITH_BOOL(outputs[1].type_flag_, IType, {
+      Kernel<set_zero, xpu>::Launch(s, outputs[1].Size(), outputs[1].dptr<IType>());
+    });
+  }
+}
+
 template<typename xpu>
 inline void BooleanMaskForward(const nnvm::NodeAttrs& attrs,
                                const OpContext &ctx,
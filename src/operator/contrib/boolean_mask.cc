@@ -27,6 +27,7 @@ namespace mxnet {
 namespace op {
 
 DMLC_REGISTER_PARAMETER(BooleanMaskParam);
+DMLC_REGISTER_PARAMETER(BooleanMaskPaddedParam);
 
 bool BooleanMaskType(const nnvm::NodeAttrs& attrs,
                      std::vector<int> *in_attrs,
@@ -222,5 +223,113 @@ NNVM_REGISTER_OP(_backward_contrib_boolean_mask)
 .set_attr<FComputeEx>("FComputeEx<cpu>", BooleanMaskBackward<cpu>)
 .add_arguments(BooleanMaskParam::__FIELDS__());
 
+template<>
+int32_t* BooleanMaskPrefixSum<cpu>(const OpContext &ctx, const TBlob &mask) {
+  const size_t mask_size = mask.Size();
+  mshadow::Stream<cpu> *s = ctx.get_stream<cpu>();
+  int32_t* prefix_sum = ctx.requested[0].get_space_typed<cpu, 1, int32_t>(
+    mshadow::Shape1(mask_size), s).dptr_;
+  MSHADOW_TYPE_SWITCH_WITH_BOOL(mask.type_flag_, IType, {
+    const IType* mask_dptr = mask.dptr<IType>();
+    for (size_t i = 0; i < mask_size; i++) {
+      prefix_sum[i] = (i == 0) ? 0 : prefix_sum[i - 1];
+      prefix_sum[i] += (mask_dptr[i]) ? 1 : 0;
+    }
+  });
+  return prefix_sum;
+}
+
+bool BooleanMaskPaddedShape(const nnvm::NodeAttrs& attrs,
+                            mxnet::ShapeVector *in_attrs,
+                            mxnet::ShapeVector *out_attrs) {
+  CHECK_EQ(in_attrs->size(), 2U);
+  CHECK_EQ(out_attrs->size(), 2U);
+  const BooleanMaskPaddedParam& param = nnvm::get<BooleanMaskPaddedParam>(attrs.parsed);
+  CHECK_EQ(param.axis, 0) << "Not supported yet";
+  SHAPE_ASSIGN_CHECK(*out_attrs, 1, mxnet::TShape(1, 1));
+  const mxnet::TShape& dshape = in_attrs->at(0);
+  if (!ndim_is_known(dshape)) return false;
+  CHECK_GT(dshape.ndim(), 0) << "data of boolean_mask_padded cannot be a scalar";
+  SHAPE_ASSIGN_CHECK(*in_attrs, 1, mxnet::TShape(1, dshape[0]));
+  SHAPE_ASSIGN_CHECK(*out_attrs, 0, dshape);
+  return shape_is_known(dshape);
+}
+
+bool BooleanMaskPaddedType(const nnvm::NodeAttrs& attrs,
+                           std::vector<int> *in_attrs,
+                           std::vector<int> *out_attrs) {
+  CHECK_EQ(in_attrs->size(), 2U);
+  CHECK_EQ(out_attrs->size(), 2U);
+  TYPE_ASSIGN_CHECK(*out_attrs, 0, in_attrs->at(0));
+  TYPE_ASSIGN_CHECK(*in_attrs, 0, out_attrs->at(0));
+  TYPE_ASSIGN_CHECK(*out_attrs, 1, mshadow::kInt32);
+  return in_attrs->at(0) != -1 && in_attrs->at(1) != -1;
+}
+
+NNVM_REGISTER_OP(_contrib_boolean_mask_padded)
+.add_alias("_npx_boolean_mask_padded")
+.describe(R"code(
+The boolean_mask operator with an output of static shape.
+Given an n-d NDArray data, and a 1-d NDArray index, the rows of data where
+the corresponding element in index is non-zero are copied to the front of out,
+which has the shape of data, and the other rows of out are set to fill_value.
+The number of copied rows is written to the int32 output valid_length of shape (1,).
+
+Unlike boolean_mask, the size of the output does not depend on the values of index,
+so the operator does not wait for the count of the selected rows on the host and
+the engine keeps running the following operators asynchronously.
+The following operators read valid_length on the device instead,
+e.g. with fill_value=0 the mean of the selected rows is ``out.sum(axis=0) / valid_length``.
+
+>>> data = mx.nd.array([[1, 2, 3],[4, 5, 6],[7, 8, 9]])
+>>> index = mx.nd.array([0, 1, 1])
+>>> out, valid_length = mx.nd.contrib.boolean_mask_padded(data, index)
+>>> out
+
+[[4. 5. 6.]
+ [7. 8. 9.]
+ [0. 0. 0.]]
+<NDArray 3x3 @cpu(0)>
+>>> valid_length
+
+[2]
+<NDArray 1 @cpu(0)>
+
+)code" ADD_FILELINE)
+.set_attr_parser(ParamParser<BooleanMaskPaddedParam>)
+.set_num_inputs(2)
+.set_num_outputs(2)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    return std::vector<std::string>{"data", "index"};
+  })
+.set_attr<nnvm::FListOutputNames>("FListOutputNames",
+  [](const NodeAttrs& attrs) {
+    return std::vector<std::string>{"output", "valid_length"};
+  })
+.set_attr<mxnet::FInferShape>("FInferShape", BooleanMaskPaddedShape)
+.set_attr<nnvm::FInferType>("FInferType", BooleanMaskPaddedType)
+.set_attr<FResourceRequest>("FResourceRequest",
+  [](const NodeAttrs& attrs) {
+    return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
+  })
+.set_attr<FCompute>("FCompute<cpu>", BooleanMaskPaddedForward<cpu>)
+.set_attr<nnvm::FGradient>("FGradient",
+  ElemwiseGradUseIn{"_backward_contrib_boolean_mask_padded"})
+.add_argument("data", "NDArray-or-Symbol", "Data")
+.add_argument("index", "NDArray-or-Symbol", "Mask")
+.add_arguments(BooleanMaskPaddedParam::__FIELDS__());
+
+NNVM_REGISTER_OP(_backward_contrib_boolean_mask_padded)
+.set_attr_parser(ParamParser<BooleanMaskPaddedParam>)
+.set_num_inputs(4)
+.set_num_outputs(2)
+.set_attr<nnvm::TIsBackward>("TIsBackward", true)
+.set_attr<FResourceRequest>("FResourceRequest",
+  [](const NodeAttrs& attrs) {
+    return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
+  })
+.set_attr<FCompute>("FCompute<cpu>", BooleanMaskPaddedBackward<cpu>);
+
 }  // namespace op
 }  // namespace mxnet
@@ -171,5 +171,45 @@ NNVM_REGISTER_OP(_backward_contrib_boolean_mask)
   })
 .set_attr<FComputeEx>("FComputeEx<gpu>", BooleanMaskBackward<gpu>);
 
+template<>
+int32_t* BooleanMaskPrefixSum<gpu>(const OpContext &ctx, const TBlob &mask) {
+  using namespace mshadow;
+  Stream<gpu>* s = ctx.get_stream<gpu>();
+  cudaStream_t stream = Stream<gpu>::GetStream(s);
+  const size_t mask_size = mask.Size();
+  int32_t* prefix_sum = nullptr;
+  void* d_temp_storage = nullptr;
+  size_t temp_storage_bytes = 0;
+  cub::DeviceScan::InclusiveSum(d_temp_storage,
+                                temp_storage_bytes,
+                                prefix_sum,
+                                prefix_sum,
+                                mask_size,
+                                stream);
+  size_t buffer_size = mask_size * sizeof(int32_t);
+  temp_storage_bytes += buffer_size;
+  Tensor<gpu, 1, char> workspace =
+    ctx.requested[0].get_space_typed<gpu, 1, char>(Shape1(temp_storage_bytes), s);
+  prefix_sum = reinterpret_cast<int32_t*>(workspace.dptr_);
+  d_temp_storage = workspace.dptr_ + buffer_size;
+  MSHADOW_TYPE_SWITCH_WITH_BOOL(mask.type_flag_, IType, {
+    mxnet_op::Kernel<mshadow_op::identity_with_cast, gpu>::Launch(
+      s, mask_size, prefix_sum, mask.dptr<IType>());
+  });
+  cub::DeviceScan::InclusiveSum(d_temp_storage,
+                                temp_storage_bytes,
+                                prefix_sum,
+                                prefix_sum,
+                                mask_size,
+                                stream);
+  return prefix_sum;
+}
+
+NNVM_REGISTER_OP(_contrib_boolean_mask_padded)
+.set_attr<FCompute>("FCompute<gpu>", BooleanMaskPaddedForward<gpu>);
+
+NNVM_REGISTER_OP(_backward_contrib_boolean_mask_padded)
+.set_attr<FCompute>("FCompute<gpu>", BooleanMaskPaddedBackward<gpu>);
+
 }  // namespace op
 }  // namespace mxnet
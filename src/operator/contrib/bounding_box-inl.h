@@ -30,6 +30,9 @@
 #include <utility>
 #include <string>
 #include <algorithm>
+#include <numeric>
+#include <unordered_map>
+#include "../../engine/openmp.h"
 #include "../mshadow_op.h"
 #include "../mxnet_op.h"
 #include "../operator_common.h"
@@ -243,6 +246,35 @@ struct compute_area {
   }
 };
 
+/*!
+ * \brief Greedy nms of the boxes of one batch, or of one class of a batch, in
+ *        descending score order
+ *
+ * \param group the positions in sorted_index of the boxes, in descending score order
+ * \param index sorted index, suppressed boxes are set to -1
+ */
+template<typename DType>
+inline void NMSGroup(const std::vector<int32_t>& group, int32_t *index,
+                     const DType *input, const DType *areas, int stride, int offset_box,
+                     float thresh, int encode) {
+  const int n = static_cast<int>(group.size());
+  for (int r = 0; r < n; ++r) {
+    const int32_t ref = index[group[r]];
+    if (ref < 0) continue;
+    const DType *ref_box = input + ref * stride + offset_box;
+    for (int p = r + 1; p < n; ++p) {
+      const int32_t pos = index[group[p]];
+      if (pos < 0) continue;
+      const DType *pos_box = input + pos * stride + offset_box;
+      DType intersect = Intersect(ref_box, pos_box, encode);
+      if (intersect <= 0) continue;
+      intersect *= Intersect(ref_box + 1, pos_box + 1, encode);
+      const DType iou = intersect / (areas[ref] + areas[pos] - intersect);
+      if (iou > thresh) index[group[p]] = -1;
+    }
+  }
+}
+
 template<typename DType>
 void NMSApply(mshadow::Stream<cpu> *s,
               int num_batch, int topk,
@@ -254,17 +286,36 @@ void NMSApply(mshadow::Stream<cpu> *s,
               int coord_start, int id_index,
               float threshold, bool force_suppress,
               int in_format) {
-  using namespace mxnet_op;
-  // go through each box as reference, suppress if overlap > threshold
-  // sorted_index with -1 is marked as suppressed
-  for (int ref = 0; ref < topk; ++ref) {
-    int num_worker = topk - ref - 1;
-    if (num_worker < 1) continue;
-    Kernel<nms_impl, cpu>::Launch(s, num_batch * num_worker,
-      sorted_index->dptr_, batch_start->dptr_, buffer->dptr_, areas->dptr_,
-      num_worker, ref, num_elem,
-      width_elem, coord_start, id_index,
-      threshold, force_suppress, in_format);
+  // boxes only suppress the boxes of their batch, and of their class unless
+  // force_suppress, so each batch or (batch, class) group runs greedy nms on its own
+  const bool class_aware = !force_suppress && id_index >= 0;
+  const int32_t *start = batch_start->dptr_;
+  int32_t *index = sorted_index->dptr_;
+  const DType *input = buffer->dptr_;
+  std::vector<std::vector<int32_t>> groups;
+  for (int b = 0; b < num_batch; ++b) {
+    const int32_t begin = start[b];
+    const int32_t end = std::min(start[b + 1], begin + topk);
+    if (end - begin < 2) continue;
+    if (!class_aware) {
+      groups.emplace_back(end - begin);
+      std::iota(groups.back().begin(), groups.back().end(), begin);
+      continue;
+    }
+    std::unordered_map<int, size_t> class_group;
+    for (int32_t pos = begin; pos < end; ++pos) {
+      const int id = static_cast<int>(input[index[pos] * width_elem + id_index]);
+      auto it = class_group.emplace(id, groups.size()).first;
+      if (it->second == groups.size()) groups.emplace_back();
+      groups[it->second].push_back(pos);
+    }
+  }
+  const int num_groups = static_cast<int>(groups.size());
+  #pragma omp parallel for schedule(dynamic) \
+    num_threads(engine::OpenMP::Get()->GetRecommendedOMPThreadCount())
+  for (int g = 0; g < num_groups; ++g) {
+    NMSGroup(groups[g], index, input, areas->dptr_, width_elem, coord_start,
+             threshold, in_format);
   }
 }
 
@@ -510,6 +510,218 @@ __global__ void ReduceNMSResultRestKernel(DType* data,
   }
 }
 
+template <int encode, typename DType>
+__global__ void BitmaskNMSMaskKernel(const DType* data, uint32_t* mask,
+                                     const index_t topk,
+                                     const index_t num_words,
+                                     const index_t element_width,
+                                     const index_t num_elements_per_batch,
+                                     const int coord_index,
+                                     const int class_index,
+                                     const int score_index,
+                                     const float threshold);
+
+template <typename DType>
+__global__ void BitmaskNMSReduceKernel(DType* data, const uint32_t* mask,
+                                       const index_t topk,
+                                       const index_t num_words,
+                                       const index_t element_width,
+                                       const index_t num_elements_per_batch,
+                                       const int score_index);
+
+/*!
+ * \brief NMS of the sorted boxes with a bitmask of all their overlaps.
+ *  A first kernel computes, in tiles of kRowsPerBlock boxes against one word of
+ *  32 boxes held in shared memory, the bits of the lower scored boxes each box
+ *  suppresses. A second kernel then reduces the mask of each batch in a single
+ *  block, 32 boxes at a time. Unlike NMS, the number of launches does not grow
+ *  with topk, but the mask takes topk * topk / 8 bytes per batch, so larger
+ *  problems fall back to NMS.
+ */
+template <typename DType>
+struct BitmaskNMS {
+  static constexpr int kBoxesPerWord = sizeof(uint32_t) * 8;
+  static constexpr int kRowsPerBlock = 256;
+  static constexpr int kReduceThreads = 512;
+  static constexpr size_t kMaxMaskBytes = size_t(1) << 28;
+  static constexpr size_t kMaxSharedBytes = 48 * 1024;
+  static constexpr index_t kMaxBatches = 65535;
+
+  static index_t NumWords(const index_t topk) {
+    return ceil_div(topk, kBoxesPerWord);
+  }
+
+  static size_t MaskBytes(const index_t num_batches, const index_t topk) {
+    return sizeof(uint32_t) * num_batches * topk * NumWords(topk);
+  }
+
+  static bool Supported(const index_t num_batches, const index_t topk) {
+    return num_batches <= kMaxBatches &&
+           MaskBytes(num_batches, topk) <= kMaxMaskBytes &&
+           NumWords(topk) * sizeof(uint32_t) <= kMaxSharedBytes;
+  }
+
+  void operator()(Tensor<gpu, 3, DType>* data,
+                  uint32_t* mask,
+                  const index_t topk,
+                  const BoxNMSParam& param,
+                  Stream<gpu>* s) {
+    const index_t num_batches = data->shape_[0];
+    const index_t num_elements_per_batch = data->shape_[1];
+    const index_t element_width = data->shape_[2];
+    const index_t num_words = NumWords(topk);
+    const int class_index = param.force_suppress ? -1 : param.id_index;
+    const dim3 mask_blocks(num_words, ceil_div(topk, kRowsPerBlock), num_batches);
+    auto stream = Stream<gpu>::GetStream(s);
+    if (param.in_format == box_common_enum::kCorner) {
+      BitmaskNMSMaskKernel<box_common_enum::kCorner>
+        <<<mask_blocks, kRowsPerBlock, 0, stream>>>(
+          data->dptr_, mask, topk, num_words, element_width, num_elements_per_batch,
+          param.coord_start, class_index, param.score_index, param.overlap_thresh);
+    } else {
+      BitmaskNMSMaskKernel<box_common_enum::kCenter>
+        <<<mask_blocks, kRowsPerBlock, 0, stream>>>(
+          data->dptr_, mask, topk, num_words, element_width, num_elements_per_batch,
+          param.coord_start, class_index, param.score_index, param.overlap_thresh);
+    }
+    MSHADOW_CUDA_POST_KERNEL_CHECK(BitmaskNMSMaskKernel);
+    BitmaskNMSReduceKernel<<<num_batches, kReduceThreads,
+                             num_words * sizeof(uint32_t), stream>>>(
+        data->dptr_, mask, topk, num_words, element_width, num_elements_per_batch,
+        param.score_index);
+    MSHADOW_CUDA_POST_KERNEL_CHECK(BitmaskNMSReduceKernel);
+  }
+};
+
+template <int encode, typename DType>
+__launch_bounds__(BitmaskNMS<DType>::kRowsPerBlock)
+__global__ void BitmaskNMSMaskKernel(const DType* data, uint32_t* mask,
+                                     const index_t topk,
+                                     const index_t num_words,
+                                     const index_t element_width,
+                                     const index_t num_elements_per_batch,
+                                     const int coord_index,
+                                     const int class_index,
+                                     const int score_index,
+                                     const float threshold) {
+  constexpr int num_other_boxes = BitmaskNMS<DType>::kBoxesPerWord;
+  __shared__ DType other_boxes[num_other_boxes * 4];
+  __shared__ DType other_boxes_areas[num_other_boxes];
+  __shared__ DType other_boxes_classes[num_other_boxes];
+  __shared__ bool other_boxes_valid[num_other_boxes];
+  const index_t my_word = blockIdx.x;
+  const index_t row_start = blockIdx.y * blockDim.x;
+  const index_t my_batch = blockIdx.z;
+  const index_t col_start = my_word * num_other_boxes;
+  // the reduction only reads the words at or after the one of each box
+  if (col_start + num_other_boxes <= row_start) return;
+  const DType* batch_data = data + my_batch * num_elements_per_batch * element_width;
+
+  if (threadIdx.x < num_other_boxes) {
+    const index_t col = col_start + threadIdx.x;
+    bool valid = false;
+    if (col < topk) {
+      const DType* box = batch_data + col * element_width;
+      valid = box[score_index] != -1;
+#pragma unroll
+      for (int i = 0; i < 4; ++i) {
+        other_boxes[threadIdx.x * 4 + i] = box[coord_index + i];
+      }
+      other_boxes_areas[threadIdx.x] = calculate_area<encode>(
+          box[coord_index + 0], box[coord_index + 1],
+          box[coord_index + 2], box[coord_index + 3]);
+      if (class_index != -1) {
+        other_boxes_classes[threadIdx.x] = box[class_index];
+      }
+    }
+    other_boxes_valid[threadIdx.x] = valid;
+  }
+  __syncthreads();
+
+  const index_t my_element = row_start + threadIdx.x;
+  if (my_element >= topk) return;
+  const DType* my_box = batch_data + my_element * element_width;
+  uint32_t ret = 0;
+  if (my_box[score_index] != -1) {
+    const DType b0 = my_box[coord_index + 0];
+    const DType b1 = my_box[coord_index + 1];
+    const DType b2 = my_box[coord_index + 2];
+    const DType b3 = my_box[coord_index + 3];
+    const DType my_class = class_index != -1 ? my_box[class_index] : DType(-1);
+    const DType my_area = calculate_area<encode>(b0, b1, b2, b3);
+#pragma unroll
+    for (int i = 0; i < num_other_boxes; ++i) {
+      if (col_start + i > my_element && other_boxes_valid[i] &&
+          (class_index == -1 || my_class == other_boxes_classes[i])) {
+        const DType intersect = calculate_intersection<encode>(
+            b0, b1, b2, b3,
+            other_boxes[i * 4 + 0], other_boxes[i * 4 + 1],
+            other_boxes[i * 4 + 2], other_boxes[i * 4 + 3]);
+        if (intersect > threshold * (my_area + other_boxes_areas[i] - intersect)) {
+          ret = ret | (1u << i);
+        }
+      }
+    }
+  }
+  mask[(my_batch * topk + my_element) * num_words + my_word] = ret;
+}
+
+template <typename DType>
+__launch_bounds__(BitmaskNMS<DType>::kReduceThreads)
+__global__ void BitmaskNMSReduceKernel(DType* data, const uint32_t* mask,
+                                       const index_t topk,
+                                       const index_t num_words,
+                                       const index_t element_width,
+                                       const index_t num_elements_per_batch,
+                                       const int score_index) {
+  constexpr int warp_size = BitmaskNMS<DType>::kBoxesPerWord;
+  const uint32_t full_mask = 0xFFFFFFFF;
+  // bits of the boxes suppressed by the kept boxes of the previous words
+  extern __shared__ uint32_t removed[];
+  __shared__ uint32_t kept;
+  const index_t my_batch = blockIdx.x;
+  const uint32_t* batch_mask = mask + my_batch * topk * num_words;
+  DType* batch_data = data + my_batch * num_elements_per_batch * element_width;
+  for (index_t v = threadIdx.x; v < num_words; v += blockDim.x) {
+    removed[v] = 0;
+  }
+  __syncthreads();
+
+  for (index_t w = 0; w < num_words; ++w) {
+    if (threadIdx.x < warp_size) {
+      // the first warp resolves the boxes of word w in score order
+      const index_t my_element = w * warp_size + threadIdx.x;
+      const uint32_t my_lane_mask = 1u << threadIdx.x;
+      DType* my_score = batch_data + my_element * element_width + score_index;
+      const bool is_box = my_element < topk && *my_score != -1;
+      bool alive = is_box && (removed[w] & my_lane_mask) == 0;
+      const uint32_t my_mask = alive ? batch_mask[my_element * num_words + w] : 0;
+#pragma unroll
+      for (int j = 0; j < warp_size - 1; ++j) {
+        const uint32_t mask_j = __shfl_sync(full_mask, alive ? my_mask : 0, j);
+        if (mask_j & my_lane_mask) alive = false;
+      }
+      const uint32_t alive_boxes = __ballot_sync(full_mask, alive);
+      if (is_box && !alive) *my_score = -1;
+      if (threadIdx.x == 0) kept = alive_boxes;
+    }
+    __syncthreads();
+    // the kept boxes of word w suppress the boxes of the next words
+    const uint32_t kept_boxes = kept;
+    if (kept_boxes != 0) {
+      for (index_t v = w + 1 + threadIdx.x; v < num_words; v += blockDim.x) {
+        uint32_t r = removed[v];
+        for (uint32_t b = kept_boxes; b != 0; b &= b - 1) {
+          const int j = __ffs(b) - 1;
+          r |= batch_mask[(w * warp_size + j) * num_words + v];
+        }
+        removed[v] = r;
+      }
+    }
+    __syncthreads();
+  }
+}
+
 template <typename DType>
 TempWorkspace<DType> GetWorkspace(const index_t num_batch,
                                   const index_t num_elem,
@@ -528,9 +740,14 @@ TempWorkspace<DType> GetWorkspace(const index_t num_batch,
   workspace.buffer_space = align(num_batch * num_elem * width_elem * sizeof(DType), alignment);
   workspace.nms_scratch_space = align(NMS<DType>::THRESHOLD / (sizeof(uint32_t) * 8) *
                                       num_batch * topk * sizeof(uint32_t), alignment);
+  if (BitmaskNMS<DType>::Supported(num_batch, topk)) {
+    workspace.nms_scratch_space = std::max(workspace.nms_scratch_space,
+      align(BitmaskNMS<DType>::MaskBytes(num_batch, topk), alignment));
+  }
 
   const index_t workspace_size = workspace.scores_temp_space +
                                  workspace.scratch_space +
+                                 workspace.buffer_space +
                                  workspace.nms_scratch_space +
                                  workspace.indices_temp_spaces;
 
@@ -681,8 +898,13 @@ void BoxNMSForwardGPU_notemp(const nnvm::NodeAttrs& attrs,
                            &sorted_indices_batch);
     }
     CompactData<false>(sorted_indices, out, &buffer, topk, -1, s);
-    NMS<DType> nms;
-    nms(&buffer, &nms_scratch, topk, param, s);
+    if (BitmaskNMS<DType>::Supported(num_batch, topk)) {
+      BitmaskNMS<DType> nms;
+      nms(&buffer, workspace.nms_scratch, topk, param, s);
+    } else {
+      NMS<DType> nms;
+      nms(&buffer, &nms_scratch, topk, param, s);
+    }
     CompactNMSResults(buffer, &out, &indices, &scores, &sorted_indices,
                       &sorted_scores, &scratch, param.score_index, topk, s);
 
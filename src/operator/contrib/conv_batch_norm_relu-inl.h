@@ -0,0 +1,146 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file conv_batch_norm_relu-inl.h
+ * \brief Convolution, BatchNorm and ReLU as one training op
+ *
+ *  The forward runs the convolution and the batch norm of the device (cuDNN on GPU)
+ *  and applies the ReLU in place on the normalized output, so the pre-ReLU output is
+ *  never a tensor of the graph. The backward applies the ReLU mask while feeding the
+ *  batch norm backward, whose output goes to _backward_Convolution.
+ */
+#ifndef MXNET_OPERATOR_CONTRIB_CONV_BATCH_NORM_RELU_INL_H_
+#define MXNET_OPERATOR_CONTRIB_CONV_BATCH_NORM_RELU_INL_H_
+
+#include <mxnet/operator_util.h>
+#include <type_traits>
+#include <vector>
+#include "../nn/activation-inl.h"
+#include "../nn/batch_norm-inl.h"
+#include "../nn/convolution-inl.h"
+
+namespace mxnet {
+namespace op {
+
+namespace convbnrelu {
+// inputs are the ones of the convolution followed by gamma, beta, moving_mean, moving_var
+enum ConvBNReLUOpOutputs {kOut, kConvOut, kMean, kVar};
+enum ConvBNReLUOpResource {kTempSpace};
+// inputs of _backward_ConvBatchNormWithReLU, the outputs are the gradients of the
+// convolution output, gamma and beta
+enum ConvBNReLUBwdInputs {kBwdOutGrad, kBwdOut, kBwdConvOut, kBwdMean, kBwdVar,
+  kBwdGamma, kBwdBeta, kBwdMovingMean, kBwdMovingVar};
+}  // namespace convbnrelu
+
+/*!
+ * \brief the attributes of the Convolution and the BatchNorm the op is made of, parsed
+ *        by the parsers of those ops from the keys of their parameters
+ */
+struct ConvBNReLUParam {
+  nnvm::NodeAttrs conv_attrs;
+  nnvm::NodeAttrs bn_attrs;
+  /*! \brief bn_attrs with cudnn_off, for the native kernels normalizing in place */
+  nnvm::NodeAttrs bn_inplace_attrs;
+
+  const ConvolutionParam &conv() const {
+    return nnvm::get<ConvolutionParam>(conv_attrs.parsed);
+  }
+  const BatchNormParam &bn() const {
+    return nnvm::get<BatchNormParam>(bn_attrs.parsed);
+  }
+  /*! \brief data, weight and bias unless no_bias */
+  size_t NumConvInputs() const {
+    return conv().no_bias ? 2U : 3U;
+  }
+};
+
+/*! \brief the FCompute of a registered op for the device of xpu */
+template<typename xpu>
+inline const FCompute &GetFCompute(const char *op_name) {
+  static auto &fcompute = nnvm::Op::GetAttr<FCompute>(
+      std::is_same<xpu, cpu>::value ? "FCompute<cpu>" : "FCompute<gpu>");
+  const nnvm::Op *op = nnvm::Op::Get(op_name);
+  CHECK(fcompute.count(op)) << op_name << " has no FCompute for this device";
+  return fcompute[op];
+}
+
+template<typename xpu>
+void ConvBNReLUCompute(const nnvm::NodeAttrs &attrs,
+                       const OpContext &ctx,
+                       const std::vector<TBlob> &inputs,
+                       const std::vector<OpReqType> &req,
+                       const std::vector<TBlob> &outputs) {
+  using namespace convbnrelu;
+  const ConvBNReLUParam &param = nnvm::get<ConvBNReLUParam>(attrs.parsed);
+  const size_t nconv = param.NumConvInputs();
+  CHECK_EQ(inputs.size(), nconv + 4U);
+  CHECK_EQ(outputs.size(), 4U);
+  CHECK_NE(req[kOut], kAddTo) << "AddTo is not supported for the output";
+  if (req[kOut] == kNullOp) return;
+
+  // without a backward pass the convolution output is not kept, and the batch norm
+  // normalizes it in place in the output
+  const bool keep_conv_out = req[kConvOut] != kNullOp;
+  const TBlob &conv_out = keep_conv_out ? outputs[kConvOut] : outputs[kOut];
+  const std::vector<TBlob> conv_in(inputs.begin(), inputs.begin() + nconv);
+  GetFCompute<xpu>("Convolution")(param.conv_attrs, ctx, conv_in, {kWriteTo}, {conv_out});
+
+  std::vector<TBlob> bn_in{conv_out};
+  bn_in.insert(bn_in.end(), inputs.begin() + nconv, inputs.end());
+  const OpReqType bn_req = keep_conv_out ? req[kOut] : kWriteInplace;
+  GetFCompute<xpu>("BatchNorm")(keep_conv_out ? param.bn_attrs : param.bn_inplace_attrs,
+                                ctx, bn_in, {bn_req, req[kMean], req[kVar]},
+                                {outputs[kOut], outputs[kMean], outputs[kVar]});
+  ActivationForward<xpu, mshadow_op::relu, mshadow_op::relu_grad>(
+      ctx, outputs[kOut], kWriteInplace, outputs[kOut]);
+}
+
+template<typename xpu>
+void ConvBNReLUGradCompute(const nnvm::NodeAttrs &attrs,
+                           const OpContext &ctx,
+                           const std::vector<TBlob> &inputs,
+                           const std::vector<OpReqType> &req,
+                           const std::vector<TBlob> &outputs) {
+  using namespace convbnrelu;
+  const ConvBNReLUParam &param = nnvm::get<ConvBNReLUParam>(attrs.parsed);
+  CHECK_EQ(inputs.size(), 9U);
+  CHECK_EQ(outputs.size(), 3U);
+  mshadow::Stream<xpu> *s = ctx.get_stream<xpu>();
+  const TBlob &out = inputs[kBwdOut];
+  MSHADOW_REAL_TYPE_SWITCH(out.type_flag_, DType, {
+    // the batch norm backward of the GPU only asks for temp space with use_global_stats,
+    // which the op does not support, so it holds the masked gradient meanwhile
+    mshadow::Tensor<xpu, 1, DType> masked =
+        ctx.requested[kTempSpace].get_space_typed<xpu, 1, DType>(
+            mshadow::Shape1(out.Size()), s);
+    const TBlob masked_grad(masked.dptr_, out.shape_, xpu::kDevMask, out.type_flag_);
+    ActivationBackward<xpu, mshadow_op::relu, mshadow_op::relu_grad>(
+        ctx, inputs[kBwdOutGrad], out, kWriteTo, masked_grad);
+    const std::vector<TBlob> bn_in{masked_grad, inputs[kBwdMean], inputs[kBwdVar],
+                                   inputs[kBwdConvOut], inputs[kBwdGamma], inputs[kBwdBeta],
+                                   inputs[kBwdMovingMean], inputs[kBwdMovingVar]};
+    GetFCompute<xpu>("_backward_BatchNorm")(param.bn_attrs, ctx, bn_in, req, outputs);
+  });
+}
+
+}  // namespace op
+}  // namespace mxnet
+
+#endif  // MXNET_OPERATOR_CONTRIB_CONV_BATCH_NORM_RELU_INL_H_
@@ -0,0 +1,267 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file conv_batch_norm_relu.cc
+ * \brief Convolution, BatchNorm and ReLU as one training op
+*/
+
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "./conv_batch_norm_relu-inl.h"
+#include "../elemwise_op_common.h"
+#include "../operator_common.h"
+
+namespace mxnet {
+namespace op {
+
+namespace {
+
+void ParseWith(const char *op_name, const std::string &name, nnvm::NodeAttrs *attrs) {
+  attrs->op = nnvm::Op::Get(op_name);
+  attrs->name = name;
+  attrs->op->attr_parser(attrs);
+}
+
+}  // namespace
+
+/*!
+ * \brief split the keys between the Convolution and the BatchNorm, cudnn_off and the
+ *        hidden keys go to both, unknown keys to the Convolution to be reported by its parser
+ */
+static void ConvBNReLUParamParser(nnvm::NodeAttrs *attrs) {
+  static const std::unordered_set<std::string> bn_fields = [] {
+    std::unordered_set<std::string> ret;
+    for (const auto &f : BatchNormParam::__FIELDS__()) ret.insert(f.name);
+    return ret;
+  }();
+  ConvBNReLUParam param;
+  for (const auto &kv : attrs->dict) {
+    if (kv.first == "cudnn_off" || kv.first.rfind("__", 0) == 0) {
+      param.conv_attrs.dict.insert(kv);
+      param.bn_attrs.dict.insert(kv);
+    } else if (bn_fields.count(kv.first)) {
+      param.bn_attrs.dict.insert(kv);
+    } else {
+      param.conv_attrs.dict.insert(kv);
+    }
+  }
+  ParseWith("Convolution", attrs->name, &param.conv_attrs);
+  ParseWith("BatchNorm", attrs->name, &param.bn_attrs);
+  CHECK(!param.bn().use_global_stats)
+      << "_contrib_ConvBatchNormWithReLU does not support use_global_stats, "
+      << "use Convolution, BatchNorm and Activation instead";
+  param.bn_inplace_attrs = param.bn_attrs;
+  param.bn_inplace_attrs.dict["cudnn_off"] = "True";
+  ParseWith("BatchNorm", attrs->name, &param.bn_inplace_attrs);
+  attrs->parsed = std::move(param);
+}
+
+/*! \brief infer the attribute with the functions of the Convolution, then of the BatchNorm */
+template<typename AttrType, typename FInfer>
+static bool ConvBNReLUInferAttr(const nnvm::NodeAttrs &attrs, const char *attr_name,
+                                std::vector<AttrType> *in_attrs,
+                                std::vector<AttrType> *out_attrs) {
+  using namespace convbnrelu;
+  static auto &finfer = nnvm::Op::GetAttr<FInfer>(attr_name);
+  const ConvBNReLUParam &param = nnvm::get<ConvBNReLUParam>(attrs.parsed);
+  const size_t nconv = param.NumConvInputs();
+  CHECK_EQ(in_attrs->size(), nconv + 4U);
+  CHECK_EQ(out_attrs->size(), 4U);
+
+  std::vector<AttrType> conv_in(in_attrs->begin(), in_attrs->begin() + nconv);
+  std::vector<AttrType> conv_out{(*out_attrs)[kConvOut]};
+  const bool conv_ok = finfer[param.conv_attrs.op](param.conv_attrs, &conv_in, &conv_out);
+  std::copy(conv_in.begin(), conv_in.end(), in_attrs->begin());
+
+  std::vector<AttrType> bn_in{conv_out[0]};
+  bn_in.insert(bn_in.end(), in_attrs->begin() + nconv, in_attrs->end());
+  std::vector<AttrType> bn_out{(*out_attrs)[kOut], (*out_attrs)[kMean], (*out_attrs)[kVar]};
+  if (!finfer[param.bn_attrs.op](param.bn_attrs, &bn_in, &bn_out)) return false;
+  std::copy(bn_in.begin() + 1, bn_in.end(), in_attrs->begin() + nconv);
+  (*out_attrs)[kOut] = bn_out[0];
+  (*out_attrs)[kConvOut] = bn_in[0];
+  (*out_attrs)[kMean] = bn_out[1];
+  (*out_attrs)[kVar] = bn_out[2];
+  return conv_ok;
+}
+
+static bool ConvBNReLUShape(const nnvm::NodeAttrs &attrs,
+                            mxnet::ShapeVector *in_shape,
+                            mxnet::ShapeVector *out_shape) {
+  return ConvBNReLUInferAttr<mxnet::TShape, mxnet::FInferShape>(attrs, "FInferShape",
+                                                                 in_shape, out_shape);
+}
+
+static bool ConvBNReLUType(const nnvm::NodeAttrs &attrs,
+                           std::vector<int> *in_type, std::vector<int> *out_type) {
+  return ConvBNReLUInferAttr<int, nnvm::FInferType>(attrs, "FInferType", in_type, out_type);
+}
+
+static std::vector<nnvm::NodeEntry> ConvBNReLUGrad(const nnvm::ObjectPtr &n,
+                                                   const std::vector<nnvm::NodeEntry> &ograds) {
+  using namespace convbnrelu;
+  const ConvBNReLUParam &param = nnvm::get<ConvBNReLUParam>(n->attrs.parsed);
+  const size_t nconv = param.NumConvInputs();
+  // gradient of the convolution output, gamma and beta
+  std::vector<nnvm::NodeEntry> bn_heads{ograds[kOut], nnvm::NodeEntry{n, kOut, 0},
+                                        nnvm::NodeEntry{n, kConvOut, 0},
+                                        nnvm::NodeEntry{n, kMean, 0},
+                                        nnvm::NodeEntry{n, kVar, 0}};
+  bn_heads.insert(bn_heads.end(), n->inputs.begin() + nconv, n->inputs.end());
+  nnvm::ObjectPtr bn_grad = MakeNode("_backward_ConvBatchNormWithReLU",
+                                     n->attrs.name + "_bn_relu_backward",
+                                     &bn_heads, &n->attrs.dict, &n);
+
+  std::vector<nnvm::NodeEntry> conv_heads{nnvm::NodeEntry{bn_grad, 0, 0}};
+  conv_heads.insert(conv_heads.end(), n->inputs.begin(), n->inputs.begin() + nconv);
+  nnvm::ObjectPtr conv_grad = MakeNode("_backward_Convolution",
+                                       n->attrs.name + "_conv_backward",
+                                       &conv_heads, &param.conv_attrs.dict, &n);
+
+  std::vector<nnvm::NodeEntry> in_grad;
+  for (uint32_t i = 0; i < nconv; ++i) in_grad.emplace_back(conv_grad, i, 0);
+  in_grad.emplace_back(bn_grad, 1, 0);
+  in_grad.emplace_back(bn_grad, 2, 0);
+  // attach no gradient node to forbid gradient on the moving statistics
+  nnvm::ObjectPtr ng = nnvm::Node::Create();
+  ng->attrs.op = Op::Get("_NoGradient");
+  ng->attrs.name = "NoGradient";
+  in_grad.emplace_back(ng);
+  in_grad.emplace_back(ng);
+  return in_grad;
+}
+
+static bool ConvBNReLUGradShape(const nnvm::NodeAttrs &attrs,
+                                mxnet::ShapeVector *in_shape,
+                                mxnet::ShapeVector *out_shape) {
+  using namespace convbnrelu;
+  CHECK_EQ(in_shape->size(), 9U);
+  CHECK_EQ(out_shape->size(), 3U);
+  SHAPE_ASSIGN_CHECK(*in_shape, kBwdOutGrad, (*in_shape)[kBwdOut]);
+  SHAPE_ASSIGN_CHECK(*in_shape, kBwdOut, (*in_shape)[kBwdOutGrad]);
+  SHAPE_ASSIGN_CHECK(*out_shape, 0, (*in_shape)[kBwdConvOut]);
+  SHAPE_ASSIGN_CHECK(*out_shape, 1, (*in_shape)[kBwdGamma]);
+  SHAPE_ASSIGN_CHECK(*out_shape, 2, (*in_shape)[kBwdBeta]);
+  return shape_is_known(*out_shape) && shape_is_known((*in_shape)[kBwdOutGrad]);
+}
+
+static bool ConvBNReLUGradType(const nnvm::NodeAttrs &attrs,
+                               std::vector<int> *in_type, std::vector<int> *out_type) {
+  using namespace convbnrelu;
+  CHECK_EQ(in_type->size(), 9U);
+  CHECK_EQ(out_type->size(), 3U);
+  TYPE_ASSIGN_CHECK(*in_type, kBwdOutGrad, (*in_type)[kBwdOut]);
+  TYPE_ASSIGN_CHECK(*out_type, 0, (*in_type)[kBwdConvOut]);
+  TYPE_ASSIGN_CHECK(*out_type, 1, (*in_type)[kBwdGamma]);
+  TYPE_ASSIGN_CHECK(*out_type, 2, (*in_type)[kBwdBeta]);
+  return (*out_type)[0] != -1 && (*out_type)[1] != -1 && (*out_type)[2] != -1;
+}
+
+static std::vector<dmlc::ParamFieldInfo> ConvBNReLUFields() {
+  std::vector<dmlc::ParamFieldInfo> ret = ConvolutionParam::__FIELDS__();
+  for (const auto &f : BatchNormParam::__FIELDS__()) {
+    if (f.name != "cudnn_off") ret.push_back(f);
+  }
+  return ret;
+}
+
+NNVM_REGISTER_OP(_contrib_ConvBatchNormWithReLU)
+.describe(R"code(Convolution followed by training mode batch normalization and ReLU.
+
+Computes ``relu(BatchNorm(Convolution(data, weight, bias), gamma, beta, moving_mean, moving_var))``
+taking the parameters of both ops. The output of the batch normalization is rectified in place,
+and the backward pass applies the ReLU mask while computing the gradient of the batch
+normalization, so fewer tensors are kept for the backward pass than with the three ops.
+
+The operator is inserted by the ``FuseConvBNReLU`` graph pass, applied through
+``optimize_for`` or ``hybridize(backend='FuseConvBNReLU')``.
+
+)code" ADD_FILELINE)
+.set_num_inputs([](const NodeAttrs &attrs) {
+  return static_cast<uint32_t>(nnvm::get<ConvBNReLUParam>(attrs.parsed).NumConvInputs() + 4);
+})
+.set_num_outputs(4)
+.set_attr_parser(ConvBNReLUParamParser)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+    [](const NodeAttrs &attrs) {
+  const ConvBNReLUParam &param = nnvm::get<ConvBNReLUParam>(attrs.parsed);
+  std::vector<std::string> ret{"data", "weight"};
+  if (!param.conv().no_bias) ret.emplace_back("bias");
+  for (const char *name : {"gamma", "beta", "moving_mean", "moving_var"}) ret.emplace_back(name);
+  return ret;
+})
+.set_attr<nnvm::FListOutputNames>("FListOutputNames",
+    [](const NodeAttrs &attrs) {
+  return std::vector<std::string>{"output", "conv_output", "mean", "var"};
+})
+.set_attr<nnvm::FNumVisibleOutputs>("FNumVisibleOutputs",
+    [](const NodeAttrs &attrs) {
+  return 1;
+})
+.set_attr<nnvm::FMutateInputs>("FMutateInputs", [](const nnvm::NodeAttrs &attrs) {
+  const uint32_t nconv = nnvm::get<ConvBNReLUParam>(attrs.parsed).NumConvInputs();
+  return std::vector<uint32_t>{nconv + 2, nconv + 3};
+})
+.set_attr<mxnet::FInferShape>("FInferShape", ConvBNReLUShape)
+.set_attr<nnvm::FInferType>("FInferType", ConvBNReLUType)
+.set_attr<FResourceRequest>("FResourceRequest", [](const NodeAttrs &n) {
+  return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
+})
+.set_attr<FCompute>("FCompute<cpu>", ConvBNReLUCompute<cpu>)
+.set_attr<nnvm::FGradient>("FGradient", ConvBNReLUGrad)
+.add_argument("data", "NDArray-or-Symbol", "Input data to the convolution")
+.add_argument("weight", "NDArray-or-Symbol", "Weight of the convolution")
+.add_argument("bias", "NDArray-or-Symbol", "Bias of the convolution")
+.add_argument("gamma", "NDArray-or-Symbol", "gamma array")
+.add_argument("beta", "NDArray-or-Symbol", "beta array")
+.add_argument("moving_mean", "NDArray-or-Symbol", "running mean of the convolution output")
+.add_argument("moving_var", "NDArray-or-Symbol", "running variance of the convolution output")
+.add_arguments(ConvBNReLUFields())
+.set_attr<nnvm::FSetInputVarAttrOnCompose>(
+  "FSetInputVarAttrOnCompose",
+  [](const nnvm::NodeAttrs &attrs, nnvm::ObjectPtr var, const int index) {
+    if (var->attrs.dict.find("__init__") != var->attrs.dict.end()) return;
+    const int nconv = nnvm::get<ConvBNReLUParam>(attrs.parsed).NumConvInputs();
+    if (index == nconv + 2) {
+      var->attrs.dict["__init__"] = "[\"zero\", {}]";
+    } else if (index == nconv + 3) {
+      var->attrs.dict["__init__"] = "[\"one\", {}]";
+    }
+  });
+
+// not a TIsBackward op: it has the convolution output gradient as an output, which is no
+// gradient of an input of the forward op
+NNVM_REGISTER_OP(_backward_ConvBatchNormWithReLU)
+.set_num_inputs(9)
+.set_num_outputs(3)
+.set_attr_parser(ConvBNReLUParamParser)
+.set_attr<mxnet::FInferShape>("FInferShape", ConvBNReLUGradShape)
+.set_attr<nnvm::FInferType>("FInferType", ConvBNReLUGradType)
+.set_attr<nnvm::FMutateInputs>("FMutateInputs", [](const nnvm::NodeAttrs &attrs) {
+  return std::vector<uint32_t>{convbnrelu::kBwdMovingMean, convbnrelu::kBwdMovingVar};
+})
+.set_attr<FResourceRequest>("FResourceRequest", [](const NodeAttrs &n) {
+  return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
+})
+.set_attr<FCompute>("FCompute<cpu>", ConvBNReLUGradCompute<cpu>);
+
+}  // namespace op
+}  // namespace mxnet
@@ -66,6 +66,7 @@ struct DeformableConvolutionParam : public dmlc::Parameter<DeformableConvolution
   index_t num_deformable_group;
   uint64_t workspace;
   bool no_bias;
+  uint32_t im2col_step;
   dmlc::optional<int> layout;
   DMLC_DECLARE_PARAMETER(DeformableConvolutionParam) {
     DMLC_DECLARE_FIELD(kernel).describe("Convolution kernel size: (h, w) or (d, h, w)");
@@ -85,6 +86,11 @@ struct DeformableConvolutionParam : public dmlc::Parameter<DeformableConvolution
       .describe("Maximum temperal workspace allowed for convolution (MB).");
     DMLC_DECLARE_FIELD(no_bias).set_default(false)
       .describe("Whether to disable bias parameter.");
+    DMLC_DECLARE_FIELD(im2col_step).set_default(64).set_lower_bound(1)
+      .describe("Maximum number of images per im2col computation; the images of one "
+                "computation share a single GEMM per group, a batch that is not divisible "
+                "by this value ends with a smaller computation; if you face out of memory "
+                "problem, you can try to use a smaller value here.");
     DMLC_DECLARE_FIELD(layout)
       .add_enum("NCW", mshadow::kNCW)
       .add_enum("NCHW", mshadow::kNCHW)
@@ -123,40 +129,46 @@ class DeformableConvolutionOp : public Operator {
                in_data[conv::kOffset].shape_,
                out_data[conv::kOut].shape_);
     Stream<xpu>* s = ctx.get_stream<xpu>();
-    // allocate workspace for col_buffer
+    // allocate workspace for col_buffer and the output of the gemm, reused by every chunk
     Tensor<xpu, 1, DType> workspace = ctx.requested[conv::kTempSpace]
-      .get_space_typed<xpu, 1, DType>(Shape1(col_buffer_size_), s);
-    // calculate the shape of col_buffer
-    mxnet::TShape col_buffer_shape(num_spatial_axes_ + 1, -1);
-    col_buffer_shape[0] = conv_in_channels_ * param_.kernel.Size();
-    for (int i = 1; i < col_buffer_shape.ndim(); ++i) {
-      col_buffer_shape[i] = out_data[0].shape_[i + 1];
-    }
-    // create a column buffer using workspace and col_buffer_shape
-    TBlob col_buffer(workspace.dptr_, col_buffer_shape, xpu::kDevMask, DataType<DType>::kFlag);
+      .get_space_typed<xpu, 1, DType>(Shape1(workspace_size_), s);
 
-    // initialize weight and col_buffer 3D tensors for using gemm
+    // initialize weight 3D tensor for using gemm
     index_t M = conv_out_channels_ / group_;
-    index_t N = conv_out_spatial_dim_;
     index_t K = kernel_dim_;
     Tensor<xpu, 3, DType> weight_3d = in_data[conv::kWeight].get_with_shape<xpu, 3, DType>(
       Shape3(group_, M, K), s);
-    Tensor<xpu, 3, DType> col_buffer_3d = col_buffer.get_with_shape<xpu, 3, DType>(
-      Shape3(group_, K, N), s);
-    Tensor<xpu, 4, DType> output_4d = out_data[conv::kOut].get_with_shape<xpu, 4, DType>(
-      Shape4(num_, group_, M, N), s);
-    for (index_t n = 0; n < num_; ++n) {
-      // transform image to col_buffer in order to use gemm
+    for (index_t n = 0; n < num_; n += im2col_step_) {
+      // the images of the chunk are the columns of one gemm per group
+      const index_t batch = std::min(im2col_step_, num_ - n);
+      const index_t N = batch * conv_out_spatial_dim_;
+      // create a column buffer of the chunk using workspace
+      TBlob col_buffer(workspace.dptr_, ColBufferShape(batch, out_data[conv::kOut].shape_),
+                       xpu::kDevMask, DataType<DType>::kFlag);
+      // transform images to col_buffer in order to use gemm
       deformable_im2col(s, in_data[conv::kData].dptr<DType>() + n * input_dim_,
                         in_data[conv::kOffset].dptr<DType>() + n * input_offset_dim_,
                         in_data[conv::kData].shape_, col_buffer.shape_,
                         param_.kernel, param_.pad, param_.stride, param_.dilate,
                         param_.num_deformable_group, col_buffer.dptr<DType>());
-      Tensor<xpu, 3, DType> output_3d = output_4d[n];
+      Tensor<xpu, 3, DType> col_buffer_3d = col_buffer.get_with_shape<xpu, 3, DType>(
+        Shape3(group_, K, N), s);
+      // the gemm output is (channel, image, pixel): a single image is written in place,
+      // several ones go to the workspace first and are transposed to (image, channel, pixel)
+      DType* out_ptr = out_data[conv::kOut].dptr<DType>() + n * output_dim_;
+      DType* gemm_ptr = batch > 1 ? workspace.dptr_ + col_buffer_size_ : out_ptr;
+      Tensor<xpu, 3, DType> output_3d(gemm_ptr, Shape3(group_, M, N), s);
       for (index_t g = 0; g < group_; ++g) {
         // Legacy approach shown here for comparison:
         //   Assign(output_3d[g], req[conv::kOut], dot(weight_3d[g], col_buffer_3d[g]));
-        linalg_gemm(weight_3d[g], col_buffer_3d[g], output_3d[g], false, false, s, req[conv::kOut]);
+        linalg_gemm(weight_3d[g], col_buffer_3d[g], output_3d[g], false, false, s, kWriteTo);
+      }
+      if (batch > 1) {
+        Tensor<xpu, 3, DType> trans_output_3d(
+          gemm_ptr, Shape3(conv_out_channels_, batch, conv_out_spatial_dim_), s);
+        Tensor<xpu, 3, DType> chunk_output_3d(
+          out_ptr, Shape3(batch, conv_out_channels_, conv_out_spatial_dim_), s);
+        chunk_output_3d = swapaxis<1, 0>(trans_output_3d);
       }
     }
     if (bias_term_) {
@@ -186,29 +198,16 @@ class DeformableConvolutionOp : public Operator {
                in_grad[conv::kOffset].shape_,
                out_grad[conv::kOut].shape_);
     Stream<xpu> *s = ctx.get_stream<xpu>();
-    // allocate workspace for col_buffer
+    // allocate workspace for col_buffer and the transposed output gradient of a chunk
     Tensor<xpu, 1, DType> workspace = ctx.requested[conv::kTempSpace]
-      .get_space_typed<xpu, 1, DType>(Shape1(col_buffer_size_), s);
-    // calculate the shape of col_buffer
-    mxnet::TShape col_buffer_shape(num_spatial_axes_ + 1, -1);
-    col_buffer_shape[0] = conv_in_channels_ * param_.kernel.Size();
-    for (index_t i = 1; i < col_buffer_shape.ndim(); ++i) {
-      col_buffer_shape[i] = out_grad[conv::kData].shape_[i + 1];
-    }
-    // create a column buffer using workspace and col_buffer_shape
-    TBlob col_buffer(workspace.dptr_, col_buffer_shape, xpu::kDevMask, DataType<DType>::kFlag);
+      .get_space_typed<xpu, 1, DType>(Shape1(workspace_size_), s);
 
-    // initialize weight and col_buffer 3D tensors for using gemm
+    // initialize weight 3D tensors for using gemm
     // For computing dLoss/d(in_data[kData])
     index_t M = kernel_dim_;
-    index_t N = conv_out_spatial_dim_;
     index_t K = conv_out_channels_ / group_;
     Tensor<xpu, 3, DType> weight_3d = in_data[conv::kWeight].get_with_shape<xpu, 3, DType>(
       Shape3(group_, K, M), s);
-    Tensor<xpu, 4, DType> out_grad_4d = out_grad[conv::kOut].get_with_shape<xpu, 4, DType>(
-      Shape4(num_, group_, K, N), s);
-    Tensor<xpu, 3, DType> col_buffer_3d = col_buffer.get_with_shape<xpu, 3, DType>(
-      Shape3(group_, M, N), s);
     // For computing dLoss/dWeight
     Tensor<xpu, 3, DType> dweight_3d = in_grad[conv::kWeight].get_with_shape<xpu, 3, DType>(
       Shape3(group_, K, M), s);
@@ -217,8 +216,24 @@ class DeformableConvolutionOp : public Operator {
     data_grad = 0;
 
 
-    for (index_t n = 0; n < num_; ++n) {
-      Tensor<xpu, 3, DType> out_grad_3d = out_grad_4d[n];
+    for (index_t n = 0; n < num_; n += im2col_step_) {
+      const index_t batch = std::min(im2col_step_, num_ - n);
+      const index_t N = batch * conv_out_spatial_dim_;
+      TBlob col_buffer(workspace.dptr_, ColBufferShape(batch, out_grad[conv::kOut].shape_),
+                       xpu::kDevMask, DataType<DType>::kFlag);
+      Tensor<xpu, 3, DType> col_buffer_3d = col_buffer.get_with_shape<xpu, 3, DType>(
+        Shape3(group_, M, N), s);
+      // the output gradient of the chunk as (channel, image, pixel), the layout of the gemm
+      DType* out_grad_ptr = out_grad[conv::kOut].dptr<DType>() + n * output_dim_;
+      DType* gemm_ptr = batch > 1 ? workspace.dptr_ + col_buffer_size_ : out_grad_ptr;
+      if (batch > 1) {
+        Tensor<xpu, 3, DType> trans_out_grad_3d(
+          gemm_ptr, Shape3(conv_out_channels_, batch, conv_out_spatial_dim_), s);
+        Tensor<xpu, 3, DType> chunk_out_grad_3d(
+          out_grad_ptr, Shape3(batch, conv_out_channels_, conv_out_spatial_dim_), s);
+        trans_out_grad_3d = swapaxis<1, 0>(chunk_out_grad_3d);
+      }
+      Tensor<xpu, 3, DType> out_grad_3d(gemm_ptr, Shape3(group_, K, N), s);
       for (index_t g = 0; g < group_; ++g) {
         // Legacy approach shown here for comparison:
         //   col_buffer_3d[g] = dot(weight_3d[g].T(), out_grad_3d[g]);
@@ -267,6 +282,17 @@ class DeformableConvolutionOp : public Operator {
   }
 
  private:
+  /*! \brief shape (#channels, #images, output_im_height, ...) of the column buffer */
+  mxnet::TShape ColBufferShape(index_t batch, const mxnet::TShape& oshape) const {
+    mxnet::TShape col_buffer_shape(num_spatial_axes_ + 2, -1);
+    col_buffer_shape[0] = conv_in_channels_ * param_.kernel.Size();
+    col_buffer_shape[1] = batch;
+    for (int i = 2; i < col_buffer_shape.ndim(); ++i) {
+      col_buffer_shape[i] = oshape[i];
+    }
+    return col_buffer_shape;
+  }
+
   void LayerSetUp(const mxnet::TShape& ishape,
                   const mxnet::TShape& offset_shape,
                   const mxnet::TShape& oshape) {
@@ -293,12 +319,15 @@ class DeformableConvolutionOp : public Operator {
     conv_out_spatial_dim_ = oshape.ProdShape(2, oshape.ndim());
     col_offset_ = kernel_dim_ * conv_out_spatial_dim_;
     output_offset_ = conv_out_channels_ * conv_out_spatial_dim_ / group_;
-    // size of the column buffer used for storing im2col-ed pixels
-    col_buffer_size_ = kernel_dim_ * group_ * conv_out_spatial_dim_;
+    // size of the column buffer used for storing im2col-ed pixels of im2col_step_ images
+    im2col_step_ = std::min(static_cast<index_t>(param_.im2col_step), num_);
+    col_buffer_size_ = kernel_dim_ * group_ * im2col_step_ * conv_out_spatial_dim_;
     // input/output image size (#channels * height * width)
     input_dim_ = ishape.ProdShape(1, ishape.ndim());
     input_offset_dim_ = offset_shape.ProdShape(1, offset_shape.ndim());
     output_dim_ = oshape.ProdShape(1, oshape.ndim());
+    // the (channel, image, pixel) gemm output of a chunk is only buffered for several images
+    workspace_size_ = col_buffer_size_ + (im2col_step_ > 1 ? im2col_step_ * output_dim_ : 0);
     num_kernels_im2col_ = conv_in_channels_ * conv_out_spatial_dim_;
     num_kernels_col2im_ = input_dim_;
   }
@@ -318,6 +347,8 @@ class DeformableConvolutionOp : public Operator {
   index_t col_offset_;
   index_t output_offset_;
   index_t col_buffer_size_;
+  index_t im2col_step_;  // number of images per im2col computation
+  index_t workspace_size_;
   index_t input_dim_;
   index_t input_offset_dim_;
   index_t output_dim_;
@@ -180,7 +180,7 @@ namespace mshadow {
   }
 
   template <typename DType>
-  inline void DeformablePSROIPoolBackwardAccCPU(const index_t count, const DType* top_diff,
+  inline void DeformablePSROIPoolBackwardAccCPU(const index_t /*count*/, const DType* top_diff,
                                                 const DType* top_count, const index_t num_rois,
                                                 const DType spatial_scale, const index_t channels,
                                                 const index_t height, const index_t width,
@@ -199,12 +199,12 @@ namespace mshadow {
                                                 const index_t part_size,
                                                 const index_t num_classes,
                                                 const index_t channels_each_class) {
-    for (index_t index = 0; index < count; index++) {
+    // backward of the bin (n, ctop, ph, pw), accumulated into the feature gradient and/or the
+    // transition gradient
+    auto backward_bin = [&](const index_t n, const index_t ctop, const index_t ph,
+                            const index_t pw, const bool acc_data, const bool acc_trans) {
       // The output is in order (n, ctop, ph, pw)
-      index_t pw = index % pooled_width;
-      index_t ph = (index / pooled_width) % pooled_height;
-      index_t ctop = (index / pooled_width / pooled_height) % output_dim;
-      index_t n = index / pooled_width / pooled_height / output_dim;
+      const index_t index = ((n * output_dim + ctop) * pooled_height + ph) * pooled_width + pw;
 
       // [start, end) interval for spatial sampling
       const DType* offset_bottom_rois = bottom_rois + n * 5;
@@ -243,7 +243,7 @@ namespace mshadow {
       hstart += trans_y * roi_height;
 
       if (top_count[index] <= 0) {
-        continue;
+        return;
       }
       DType diff_val = top_diff[index] / top_count[index];
       const DType* offset_bottom_data = bottom_data + roi_batch_ind * channels * height * width;
@@ -275,12 +275,14 @@ namespace mshadow {
           DType q10 = dist_x * (1 - dist_y);
           DType q11 = dist_x * dist_y;
           index_t bottom_index_base = c * height * width;
-          offset_bottom_data_diff[bottom_index_base + y0 * width + x0] += q00 * diff_val;
-          offset_bottom_data_diff[bottom_index_base + y1 * width + x0] += q01 * diff_val;
-          offset_bottom_data_diff[bottom_index_base + y0 * width + x1] += q10 * diff_val;
-          offset_bottom_data_diff[bottom_index_base + y1 * width + x1] += q11 * diff_val;
+          if (acc_data) {
+            offset_bottom_data_diff[bottom_index_base + y0 * width + x0] += q00 * diff_val;
+            offset_bottom_data_diff[bottom_index_base + y1 * width + x0] += q01 * diff_val;
+            offset_bottom_data_diff[bottom_index_base + y0 * width + x1] += q10 * diff_val;
+            offset_bottom_data_diff[bottom_index_base + y1 * width + x1] += q11 * diff_val;
+          }
 
-          if (no_trans) {
+          if (!acc_trans) {
             continue;
           }
           DType U00 = offset_bottom_data[bottom_index_base + y0 * width + x0];
@@ -298,6 +300,49 @@ namespace mshadow {
           bottom_trans_diff[offset_trans_diff + part_size * part_size] += diff_y;
         }
       }
+    };
+
+    // The bottom channel c = (ctop * group_size + gh) * group_size + gw of the feature gradient
+    // and the transition gradient of a ROI are each accumulated by a single thread, so that
+    // neither atomics nor per thread copies of the gradients are needed.
+    const int omp_threads = mxnet::engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+    std::vector<index_t> group_h(pooled_height), group_w(pooled_width);
+    for (index_t ph = 0; ph < pooled_height; ph++) {
+      index_t gh = floor(static_cast<DType>(ph) * group_size / pooled_height);
+      group_h[ph] = min(max(gh, static_cast<index_t>(0)), group_size - 1);
+    }
+    for (index_t pw = 0; pw < pooled_width; pw++) {
+      index_t gw = floor(static_cast<DType>(pw) * group_size / pooled_width);
+      group_w[pw] = min(max(gw, static_cast<index_t>(0)), group_size - 1);
+    }
+    const index_t bottom_channels = output_dim * group_size * group_size;
+#pragma omp parallel for num_threads(omp_threads)
+    for (index_t c = 0; c < bottom_channels; c++) {
+      const index_t gw = c % group_size;
+      const index_t gh = (c / group_size) % group_size;
+      const index_t ctop = c / group_size / group_size;
+      for (index_t n = 0; n < num_rois; n++) {
+        for (index_t ph = 0; ph < pooled_height; ph++) {
+          if (group_h[ph] != gh) continue;
+          for (index_t pw = 0; pw < pooled_width; pw++) {
+            if (group_w[pw] != gw) continue;
+            backward_bin(n, ctop, ph, pw, true, false);
+          }
+        }
+      }
+    }
+    if (no_trans) {
+      return;
+    }
+#pragma omp parallel for num_threads(omp_threads)
+    for (index_t n = 0; n < num_rois; n++) {
+      for (index_t ctop = 0; ctop < output_dim; ctop++) {
+        for (index_t ph = 0; ph < pooled_height; ph++) {
+          for (index_t pw = 0; pw < pooled_width; pw++) {
+            backward_bin(n, ctop, ph, pw, false, true);
+          }
+        }
+      }
     }
   }
 
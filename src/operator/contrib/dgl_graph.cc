@@ -25,10 +25,10 @@
 #include <dmlc/logging.h>
 #include <dmlc/optional.h>
 #include <algorithm>
-#include <random>
 #include <utility>
 
 #include "../elemwise_op_common.h"
+#include "../../engine/openmp.h"
 #include "../../imperative/imperative_utils.h"
 #include "../subgraph_op_common.h"
 #include "./dgl_graph-inl.h"
@@ -40,14 +40,51 @@ typedef int64_t dgl_id_t;
 
 ////////////////////////////// Graph Sampling ///////////////////////////////
 
+/*
+ * Counter-based random generator. The numbers drawn for a stream only depend on
+ * the seed and on the stream id, so that each vertex samples its neighbors from
+ * its own stream, whatever the thread and the order the vertices are sampled in.
+ */
+class CounterRNG {
+ public:
+  CounterRNG(uint64_t seed, uint64_t stream) : key_(Mix(Mix(seed) ^ stream)), counter_(0) {}
+
+  uint64_t Next() {
+    return Mix(key_ + (++counter_) * 0x9E3779B97F4A7C15ULL);
+  }
+
+  /*
+   * Uniform integer in [0, n)
+   */
+  size_t Uniform(size_t n) {
+    return static_cast<size_t>(Next() % n);
+  }
+
+  /*
+   * Uniform real in [0, 1)
+   */
+  float UniformReal() {
+    return static_cast<float>(Next() >> 40) * (1.0f / 16777216.0f);
+  }
+
+ private:
+  // the finalizer of SplitMix64
+  static uint64_t Mix(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+  }
+
+  uint64_t key_;
+  uint64_t counter_;
+};
+
 /*
  * ArrayHeap is used to sample elements from vector
  */
 class ArrayHeap {
  public:
-  explicit ArrayHeap(const std::vector<float>& prob, unsigned int seed) {
-    generator_ = std::mt19937(seed);
-    distribution_ = std::uniform_real_distribution<float>(0.0, 1.0);
+  ArrayHeap(const std::vector<float>& prob, CounterRNG* rng) : rng_(rng) {
     vec_size_ = prob.size();
     bit_len_ = ceil(log2(vec_size_));
     limit_ = 1 << bit_len_;
@@ -93,7 +130,7 @@ class ArrayHeap {
    * Sample from arrayHeap
    */
   size_t Sample() {
-    float xi = heap_[1] * distribution_(generator_);
+    float xi = heap_[1] * rng_->UniformReal();
     int i = 1;
     while (i < limit_) {
       i = i << 1;
@@ -121,8 +158,7 @@ class ArrayHeap {
   int bit_len_;   // bit size
   int limit_;
   std::vector<float> heap_;
-  std::mt19937 generator_;
-  std::uniform_real_distribution<float> distribution_;
+  CounterRNG* rng_;
 };
 
 struct NeighborSampleParam : public dmlc::Parameter<NeighborSampleParam> {
@@ -410,12 +446,10 @@ static bool CSRNeighborNonUniformSampleType(const nnvm::NodeAttrs& attrs,
 static void RandomSample(size_t set_size,
                          size_t num,
                          std::vector<size_t>* out,
-                         unsigned int seed) {
-  std::mt19937 generator(seed);
+                         CounterRNG* rng) {
   std::unordered_set<size_t> sampled_idxs;
-  std::uniform_int_distribution<size_t> distribution(0, set_size - 1);
   while (sampled_idxs.size() < num) {
-    sampled_idxs.insert(distribution(generator));
+    sampled_idxs.insert(rng->Uniform(set_size));
   }
   out->clear();
   for (size_t sampled_idx : sampled_idxs) {
@@ -443,34 +477,32 @@ static void NegateSet(const std::vector<size_t> &idxs,
 }
 
 /*
- * Uniform sample
+ * Uniform sample, writes min(ver_len, max_num_neighbor) vertices and edges
  */
 static void GetUniformSample(const dgl_id_t* val_list,
                              const dgl_id_t* col_list,
                              const size_t ver_len,
                              const size_t max_num_neighbor,
-                             std::vector<dgl_id_t>* out_ver,
-                             std::vector<dgl_id_t>* out_edge,
-                             unsigned int seed) {
+                             dgl_id_t* out_ver,
+                             dgl_id_t* out_edge,
+                             CounterRNG* rng) {
   // Copy ver_list to output
   if (ver_len <= max_num_neighbor) {
-    for (size_t i = 0; i < ver_len; ++i) {
-      out_ver->push_back(col_list[i]);
-      out_edge->push_back(val_list[i]);
-    }
+    std::copy_n(col_list, ver_len, out_ver);
+    std::copy_n(val_list, ver_len, out_edge);
     return;
   }
   // If we just sample a small number of elements from a large neighbor list.
   std::vector<size_t> sorted_idxs;
   if (ver_len > max_num_neighbor * 2) {
     sorted_idxs.reserve(max_num_neighbor);
-    RandomSample(ver_len, max_num_neighbor, &sorted_idxs, seed);
+    RandomSample(ver_len, max_num_neighbor, &sorted_idxs, rng);
     std::sort(sorted_idxs.begin(), sorted_idxs.end());
   } else {
     std::vector<size_t> negate;
     negate.reserve(ver_len - max_num_neighbor);
     RandomSample(ver_len, ver_len - max_num_neighbor,
-                 &negate, seed);
+                 &negate, rng);
     std::sort(negate.begin(), negate.end());
     NegateSet(negate, ver_len, &sorted_idxs);
   }
@@ -479,29 +511,28 @@ static void GetUniformSample(const dgl_id_t* val_list,
   for (size_t i = 1; i < sorted_idxs.size(); i++) {
     CHECK_GT(sorted_idxs[i], sorted_idxs[i - 1]);
   }
-  for (auto idx : sorted_idxs) {
-    out_ver->push_back(col_list[idx]);
-    out_edge->push_back(val_list[idx]);
+  for (size_t i = 0; i < sorted_idxs.size(); ++i) {
+    out_ver[i] = col_list[sorted_idxs[i]];
+    out_edge[i] = val_list[sorted_idxs[i]];
   }
 }
 
 /*
- * Non-uniform sample via ArrayHeap
+ * Non-uniform sample via ArrayHeap, writes min(ver_len, max_num_neighbor) vertices
+ * and edges
  */
 static void GetNonUniformSample(const float* probability,
                                 const dgl_id_t* val_list,
                                 const dgl_id_t* col_list,
                                 const size_t ver_len,
                                 const size_t max_num_neighbor,
-                                std::vector<dgl_id_t>* out_ver,
-                                std::vector<dgl_id_t>* out_edge,
-                                unsigned int seed) {
+                                dgl_id_t* out_ver,
+                                dgl_id_t* out_edge,
+                                CounterRNG* rng) {
   // Copy ver_list to output
   if (ver_len <= max_num_neighbor) {
-    for (size_t i = 0; i < ver_len; ++i) {
-      out_ver->push_back(col_list[i]);
-      out_edge->push_back(val_list[i]);
-    }
+    std::copy_n(col_list, ver_len, out_ver);
+    std::copy_n(val_list, ver_len, out_edge);
     return;
   }
   // Make sample
@@ -510,17 +541,15 @@ static void GetNonUniformSample(const float* probability,
   for (size_t i = 0; i < ver_len; ++i) {
     sp_prob[i] = probability[col_list[i]];
   }
-  ArrayHeap arrayHeap(sp_prob, seed);
+  ArrayHeap arrayHeap(sp_prob, rng);
   arrayHeap.SampleWithoutReplacement(max_num_neighbor, &sp_index);
-  out_ver->resize(max_num_neighbor);
-  out_edge->resize(max_num_neighbor);
   for (size_t i = 0; i < max_num_neighbor; ++i) {
     size_t idx = sp_index[i];
-    out_ver->at(i) = col_list[idx];
-    out_edge->at(i) = val_list[idx];
+    out_ver[i] = col_list[idx];
+    out_edge[i] = val_list[idx];
   }
-  sort(out_ver->begin(), out_ver->end());
-  sort(out_edge->begin(), out_edge->end());
+  std::sort(out_ver, out_ver + max_num_neighbor);
+  std::sort(out_edge, out_edge + max_num_neighbor);
 }
 
 /*
@@ -547,7 +576,8 @@ static void SampleSubgraph(const NDArray &csr,
                            int num_hops,
                            size_t num_neighbor,
                            size_t max_num_vertices,
-                           unsigned int random_seed) {
+                           uint64_t random_seed,
+                           int num_threads) {
   size_t num_seeds = seed_arr.shape().Size();
   CHECK_GE(max_num_vertices, num_seeds);
 
@@ -571,75 +601,96 @@ static void SampleSubgraph(const NDArray &csr,
       sub_vers.emplace_back(seed[i], 0);
     }
   }
-  std::vector<dgl_id_t> tmp_sampled_src_list;
-  std::vector<dgl_id_t> tmp_sampled_edge_list;
   // ver_id, position
   std::vector<std::pair<dgl_id_t, size_t> > neigh_pos;
   neigh_pos.reserve(num_seeds);
   std::vector<dgl_id_t> neighbor_list;
   size_t num_edges = 0;
 
-  // sub_vers is used both as a node collection and a queue.
-  // In the while loop, we iterate over sub_vers and new nodes are added to the vector.
-  // A vertex in the vector only needs to be accessed once. If there is a vertex behind idx
-  // isn't in the last level, we will sample its neighbors. If not, the while loop terminates.
+  // sub_vers is used both as a node collection and a queue, which holds the vertices
+  // level by level. The neighbors of all the vertices of a level are sampled in
+  // parallel into buffers pre-sized by their degrees, each vertex from its own random
+  // stream. They are then merged in the queue order: new vertices are added to the
+  // queue until the subgraph has max_num_vertices vertices. A vertex in the vector
+  // only needs to be accessed once.
+  std::vector<size_t> sample_pos;
+  std::vector<dgl_id_t> sampled_src_list;
+  std::vector<dgl_id_t> sampled_edge_list;
   size_t idx = 0;
-  while (idx < sub_vers.size() &&
-    sub_ver_mp.size() < max_num_vertices) {
-    dgl_id_t dst_id = sub_vers[idx].first;
-    int cur_node_level = sub_vers[idx].second;
-    idx++;
-    // If the node is in the last level, we don't need to sample neighbors
-    // from this node.
+  bool full = false;
+  while (idx < sub_vers.size() && !full) {
+    const int cur_node_level = sub_vers[idx].second;
+    // If the nodes are in the last level, we don't need to sample their neighbors.
     if (cur_node_level >= num_hops)
-      continue;
-
-    tmp_sampled_src_list.clear();
-    tmp_sampled_edge_list.clear();
-    dgl_id_t ver_len = *(indptr+dst_id+1) - *(indptr+dst_id);
-    if (probability == nullptr) {  // uniform-sample
-      GetUniformSample(val_list + *(indptr + dst_id),
-                       col_list + *(indptr + dst_id),
-                       ver_len,
-                       num_neighbor,
-                       &tmp_sampled_src_list,
-                       &tmp_sampled_edge_list,
-                       random_seed);
-    } else {  // non-uniform-sample
-      GetNonUniformSample(probability,
-                       val_list + *(indptr + dst_id),
-                       col_list + *(indptr + dst_id),
-                       ver_len,
-                       num_neighbor,
-                       &tmp_sampled_src_list,
-                       &tmp_sampled_edge_list,
-                       random_seed);
-    }
-    CHECK_EQ(tmp_sampled_src_list.size(), tmp_sampled_edge_list.size());
-    size_t pos = neighbor_list.size();
-    neigh_pos.emplace_back(dst_id, pos);
-    // First we push the size of neighbor vector
-    neighbor_list.push_back(tmp_sampled_edge_list.size());
-    // Then push the vertices
-    for (dgl_id_t & i : tmp_sampled_src_list) {
-      neighbor_list.push_back(i);
+      break;
+    size_t level_end = idx;
+    while (level_end < sub_vers.size() && sub_vers[level_end].second == cur_node_level)
+      level_end++;
+    const size_t num_level_vers = level_end - idx;
+
+    sample_pos.resize(num_level_vers + 1);
+    sample_pos[0] = 0;
+    for (size_t k = 0; k < num_level_vers; ++k) {
+      const dgl_id_t dst_id = sub_vers[idx + k].first;
+      const size_t ver_len = indptr[dst_id + 1] - indptr[dst_id];
+      sample_pos[k + 1] = sample_pos[k] + std::min(ver_len, num_neighbor);
     }
-    // Finally we push the edge list
-    for (dgl_id_t & i : tmp_sampled_edge_list) {
-      neighbor_list.push_back(i);
+    sampled_src_list.resize(sample_pos[num_level_vers]);
+    sampled_edge_list.resize(sample_pos[num_level_vers]);
+    #pragma omp parallel for schedule(dynamic, 64) num_threads(num_threads)
+    for (int64_t k = 0; k < static_cast<int64_t>(num_level_vers); ++k) {
+      const dgl_id_t dst_id = sub_vers[idx + k].first;
+      const dgl_id_t begin = indptr[dst_id];
+      const size_t ver_len = indptr[dst_id + 1] - begin;
+      CounterRNG rng(random_seed, dst_id);
+      if (probability == nullptr) {  // uniform-sample
+        GetUniformSample(val_list + begin,
+                         col_list + begin,
+                         ver_len,
+                         num_neighbor,
+                         sampled_src_list.data() + sample_pos[k],
+                         sampled_edge_list.data() + sample_pos[k],
+                         &rng);
+      } else {  // non-uniform-sample
+        GetNonUniformSample(probability,
+                            val_list + begin,
+                            col_list + begin,
+                            ver_len,
+                            num_neighbor,
+                            sampled_src_list.data() + sample_pos[k],
+                            sampled_edge_list.data() + sample_pos[k],
+                            &rng);
+      }
     }
-    num_edges += tmp_sampled_src_list.size();
-    for (dgl_id_t & i : tmp_sampled_src_list) {
+
+    for (size_t k = 0; k < num_level_vers; ++k, ++idx) {
       // If we have sampled the max number of vertices, we have to stop.
-      if (sub_ver_mp.size() >= max_num_vertices)
+      if (sub_ver_mp.size() >= max_num_vertices) {
+        full = true;
         break;
-      // We need to add the neighbor in the hashtable here. This ensures that
-      // the vertex in the queue is unique. If we see a vertex before, we don't
-      // need to add it to the queue again.
-      auto ret = sub_ver_mp.insert(i);
-      // If the sampled neighbor is inserted to the map successfully.
-      if (ret.second)
-        sub_vers.emplace_back(i, cur_node_level + 1);
+      }
+      const dgl_id_t dst_id = sub_vers[idx].first;
+      const size_t begin = sample_pos[k];
+      const size_t num_sampled = sample_pos[k + 1] - begin;
+      neigh_pos.emplace_back(dst_id, neighbor_list.size());
+      // First we push the size of neighbor vector, then the vertices and the edges
+      neighbor_list.push_back(num_sampled);
+      neighbor_list.insert(neighbor_list.end(), sampled_src_list.begin() + begin,
+                           sampled_src_list.begin() + begin + num_sampled);
+      neighbor_list.insert(neighbor_list.end(), sampled_edge_list.begin() + begin,
+                           sampled_edge_list.begin() + begin + num_sampled);
+      num_edges += num_sampled;
+      for (size_t j = begin; j < begin + num_sampled; ++j) {
+        if (sub_ver_mp.size() >= max_num_vertices)
+          break;
+        // We need to add the neighbor in the hashtable here. This ensures that
+        // the vertex in the queue is unique. If we see a vertex before, we don't
+        // need to add it to the queue again.
+        auto ret = sub_ver_mp.insert(sampled_src_list[j]);
+        // If the sampled neighbor is inserted to the map successfully.
+        if (ret.second)
+          sub_vers.emplace_back(sampled_src_list[j], cur_node_level + 1);
+      }
     }
   }
   // Let's check if there is a vertex that we haven't sampled its neighbors.
@@ -737,9 +788,14 @@ static void CSRNeighborUniformSampleComputeExCPU(const nnvm::NodeAttrs& attrs,
 
   mshadow::Stream<cpu> *s = ctx.get_stream<cpu>();
   mshadow::Random<cpu, unsigned int> *prnd = ctx.requested[0].get_random<cpu, unsigned int>(s);
-  unsigned int seed = prnd->GetRandInt();
-
-#pragma omp parallel for
+  uint64_t seed = prnd->GetRandInt();
+  // parallelize across the subgraphs when there are enough of them, otherwise
+  // across the vertices of each level of a subgraph
+  const int num_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  const int outer_threads = num_subgraphs >= num_threads ? num_threads : 1;
+  const int inner_threads = num_subgraphs >= num_threads ? 1 : num_threads;
+
+#pragma omp parallel for num_threads(outer_threads)
   for (int i = 0; i < num_subgraphs; i++) {
     SampleSubgraph(inputs[0],                     // graph_csr
                    inputs[i + 1],                 // seed vector
@@ -751,11 +807,8 @@ static void CSRNeighborUniformSampleComputeExCPU(const nnvm::NodeAttrs& attrs,
                    params.num_hops,
                    params.num_neighbor,
                    params.max_num_vertices,
-#if defined(_OPENMP)
-                   seed + omp_get_thread_num());
-#else
-                   seed);
-#endif
+                   (seed << 32) | static_cast<uint64_t>(i),
+                   inner_threads);
   }
 }
 
@@ -841,9 +894,14 @@ static void CSRNeighborNonUniformSampleComputeExCPU(const nnvm::NodeAttrs& attrs
 
   mshadow::Stream<cpu> *s = ctx.get_stream<cpu>();
   mshadow::Random<cpu, unsigned int> *prnd = ctx.requested[0].get_random<cpu, unsigned int>(s);
-  unsigned int seed = prnd->GetRandInt();
-
-#pragma omp parallel for
+  uint64_t seed = prnd->GetRandInt();
+  // parallelize across the subgraphs when there are enough of them, otherwise
+  // across the vertices of each level of a subgraph
+  const int num_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  const int outer_threads = num_subgraphs >= num_threads ? num_threads : 1;
+  const int inner_threads = num_subgraphs >= num_threads ? 1 : num_threads;
+
+#pragma omp parallel for num_threads(outer_threads)
   for (int i = 0; i < num_subgraphs; i++) {
     float* sub_prob = outputs[i+2*num_subgraphs].data().dptr<float>();
     SampleSubgraph(inputs[0],                     // graph_csr
@@ -856,11 +914,8 @@ static void CSRNeighborNonUniformSampleComputeExCPU(const nnvm::NodeAttrs& attrs
                    params.num_hops,
                    params.num_neighbor,
                    params.max_num_vertices,
-#if defined(_OPENMP)
-                   seed + omp_get_thread_num());
-#else
-                   seed);
-#endif
+                   (seed << 32) | static_cast<uint64_t>(i),
+                   inner_threads);
   }
 }
 
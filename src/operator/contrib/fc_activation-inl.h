@@ -0,0 +1,176 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file fc_activation-inl.h
+ * \brief FullyConnected followed by ReLU or GELU as one op
+ *
+ *  On GPU the bias and the ReLU are applied by the epilogue of a cuBLASLt GEMM, so the
+ *  output is written once instead of by the GEMM, the bias and the activation kernels.
+ *  The erf GELU has no cuBLASLt epilogue, its pre-activation is then written with the bias
+ *  by the GEMM and activated by one more kernel. Elsewhere the op runs FullyConnected and
+ *  the activation in place on its output.
+ */
+#ifndef MXNET_OPERATOR_CONTRIB_FC_ACTIVATION_INL_H_
+#define MXNET_OPERATOR_CONTRIB_FC_ACTIVATION_INL_H_
+
+#include <mxnet/operator_util.h>
+#include <type_traits>
+#include <vector>
+#include "./conv_batch_norm_relu-inl.h"
+#include "../mshadow_op.h"
+#include "../mxnet_op.h"
+#include "../nn/activation-inl.h"
+#include "../nn/fully_connected-inl.h"
+
+namespace mxnet {
+namespace op {
+
+namespace fcact {
+// inputs are the ones of the FullyConnected, the pre-activation output is only kept by GELU
+enum FCActOpOutputs {kOut, kPre};
+enum FCActOpResource {kTempSpace};
+enum FCActOpType {kReLU, kGELU};
+}  // namespace fcact
+
+struct FCActTypeParam : public dmlc::Parameter<FCActTypeParam> {
+  int act_type;
+  DMLC_DECLARE_PARAMETER(FCActTypeParam) {
+    DMLC_DECLARE_FIELD(act_type)
+    .add_enum("relu", fcact::kReLU)
+    .add_enum("gelu", fcact::kGELU)
+    .describe("Activation function applied to the output of the fully connected layer.");
+  }
+};
+
+/*!
+ * \brief the attributes of the FullyConnected the op starts with, parsed by its parser,
+ *        and the activation type
+ */
+struct FullyConnectedActParam {
+  nnvm::NodeAttrs fc_attrs;
+  FCActTypeParam act;
+
+  const FullyConnectedParam &fc() const {
+    return nnvm::get<FullyConnectedParam>(fc_attrs.parsed);
+  }
+  bool gelu() const {
+    return act.act_type == fcact::kGELU;
+  }
+  /*! \brief data, weight and bias unless no_bias */
+  uint32_t NumInputs() const {
+    return fc().no_bias ? 2U : 3U;
+  }
+  /*! \brief the output, and for GELU the pre-activation the gradient is computed from */
+  uint32_t NumOutputs() const {
+    return gelu() ? 2U : 1U;
+  }
+};
+
+#if MXNET_USE_CUDA
+/*!
+ * \brief out = data . weight^T + bias, rectified when relu is set, with the bias and the
+ *        ReLU applied by the epilogue of a cuBLASLt GEMM. False when cuBLASLt does not
+ *        support the GEMM, defined in fc_activation.cu
+ */
+bool FullyConnectedCublasLt(const OpContext &ctx, const FullyConnectedParam &param,
+                            const std::vector<TBlob> &inputs, const TBlob &out, bool relu);
+#endif
+
+/*! \brief dpre = ograd * act'(pre), from the output for ReLU and the pre-activation for GELU */
+template<int req>
+struct fc_act_backward {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(index_t i, DType *dpre, const DType *ograd,
+                                  const DType *saved, const int act_type) {
+    const DType grad = act_type == fcact::kReLU ? mshadow_op::relu_grad::Map(saved[i]) :
+                       mshadow_op::gelu_grad::Map(saved[i], saved[i]);
+    KERNEL_ASSIGN(dpre[i], req, ograd[i] * grad);
+  }
+};
+
+template<typename xpu>
+void FullyConnectedActCompute(const nnvm::NodeAttrs &attrs,
+                              const OpContext &ctx,
+                              const std::vector<TBlob> &inputs,
+                              const std::vector<OpReqType> &req,
+                              const std::vector<TBlob> &outputs) {
+  using namespace fcact;
+  using namespace mxnet_op;
+  const FullyConnectedActParam &param = nnvm::get<FullyConnectedActParam>(attrs.parsed);
+  CHECK_EQ(inputs.size(), param.NumInputs());
+  CHECK_EQ(outputs.size(), param.NumOutputs());
+  CHECK_NE(req[kOut], kAddTo) << "AddTo is not supported for the output";
+  if (req[kOut] == kNullOp || outputs[kOut].Size() == 0) return;
+
+  // without a backward pass the pre-activation is not kept, and GELU runs in place
+  const bool keep_pre = param.gelu() && req[kPre] != kNullOp;
+  const TBlob &fc_out = keep_pre ? outputs[kPre] : outputs[kOut];
+  bool fused = false;
+#if MXNET_USE_CUDA
+  fused = std::is_same<xpu, gpu>::value &&
+          FullyConnectedCublasLt(ctx, param.fc(), inputs, fc_out, !param.gelu());
+#endif
+  if (!fused) {
+    GetFCompute<xpu>("FullyConnected")(param.fc_attrs, ctx, inputs, {kWriteTo}, {fc_out});
+  }
+  if (param.gelu()) {
+    mshadow::Stream<xpu> *s = ctx.get_stream<xpu>();
+    const OpReqType act_req = keep_pre ? req[kOut] : kWriteInplace;
+    MSHADOW_REAL_TYPE_SWITCH(outputs[kOut].type_flag_, DType, {
+      MXNET_ASSIGN_REQ_SWITCH(act_req, Req, {
+        Kernel<op_with_req<mshadow_op::gelu, Req>, xpu>::Launch(
+            s, outputs[kOut].Size(), outputs[kOut].dptr<DType>(), fc_out.dptr<DType>());
+      });
+    });
+  } else if (!fused) {
+    ActivationForward<xpu, mshadow_op::relu, mshadow_op::relu_grad>(
+        ctx, outputs[kOut], kWriteInplace, outputs[kOut]);
+  }
+}
+
+/*!
+ * \brief the gradient of the pre-activation, from the output gradient and the output for
+ *        ReLU or the pre-activation for GELU. _backward_FullyConnected takes it from there.
+ */
+template<typename xpu>
+void FullyConnectedActGradCompute(const nnvm::NodeAttrs &attrs,
+                                  const OpContext &ctx,
+                                  const std::vector<TBlob> &inputs,
+                                  const std::vector<OpReqType> &req,
+                                  const std::vector<TBlob> &outputs) {
+  using namespace mxnet_op;
+  const FullyConnectedActParam &param = nnvm::get<FullyConnectedActParam>(attrs.parsed);
+  CHECK_EQ(inputs.size(), 2U);
+  CHECK_EQ(outputs.size(), 1U);
+  if (req[0] == kNullOp || outputs[0].Size() == 0) return;
+  mshadow::Stream<xpu> *s = ctx.get_stream<xpu>();
+  MSHADOW_REAL_TYPE_SWITCH(outputs[0].type_flag_, DType, {
+    MXNET_ASSIGN_REQ_SWITCH(req[0], Req, {
+      Kernel<fc_act_backward<Req>, xpu>::Launch(
+          s, outputs[0].Size(), outputs[0].dptr<DType>(), inputs[0].dptr<DType>(),
+          inputs[1].dptr<DType>(), param.act.act_type);
+    });
+  });
+}
+
+}  // namespace op
+}  // namespace mxnet
+
+#endif  // MXNET_OPERATOR_CONTRIB_FC_ACTIVATION_INL_H_
@@ -0,0 +1,180 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file fc_activation.cc
+ * \brief FullyConnected followed by ReLU or GELU as one op
+*/
+
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "./fc_activation-inl.h"
+#include "../elemwise_op_common.h"
+#include "../operator_common.h"
+
+namespace mxnet {
+namespace op {
+
+DMLC_REGISTER_PARAMETER(FCActTypeParam);
+
+/*! \brief act_type goes to the activation, the other keys to the FullyConnected parser */
+static void FullyConnectedActParamParser(nnvm::NodeAttrs *attrs) {
+  FullyConnectedActParam param;
+  std::vector<std::pair<std::string, std::string>> act_kwargs;
+  for (const auto &kv : attrs->dict) {
+    if (kv.first == "act_type") {
+      act_kwargs.push_back(kv);
+    } else {
+      param.fc_attrs.dict.insert(kv);
+    }
+  }
+  try {
+    param.act.Init(act_kwargs);
+  } catch (const dmlc::ParamError &e) {
+    std::ostringstream os;
+    os << e.what() << ", in operator " << attrs->op->name << "(name=\"" << attrs->name << "\")";
+    throw dmlc::ParamError(os.str());
+  }
+  param.fc_attrs.op = nnvm::Op::Get("FullyConnected");
+  param.fc_attrs.name = attrs->name;
+  param.fc_attrs.op->attr_parser(&param.fc_attrs);
+  attrs->parsed = std::move(param);
+}
+
+/*! \brief infer the attribute with the function of the FullyConnected, shared by the outputs */
+template<typename AttrType, typename FInfer>
+static bool FullyConnectedActInferAttr(const nnvm::NodeAttrs &attrs, const char *attr_name,
+                                       std::vector<AttrType> *in_attrs,
+                                       std::vector<AttrType> *out_attrs) {
+  static auto &finfer = nnvm::Op::GetAttr<FInfer>(attr_name);
+  const FullyConnectedActParam &param = nnvm::get<FullyConnectedActParam>(attrs.parsed);
+  CHECK_EQ(in_attrs->size(), param.NumInputs());
+  CHECK_EQ(out_attrs->size(), param.NumOutputs());
+  std::vector<AttrType> fc_out{(*out_attrs)[fcact::kOut]};
+  if (!finfer[param.fc_attrs.op](param.fc_attrs, in_attrs, &fc_out)) return false;
+  for (auto &attr : *out_attrs) attr = fc_out[0];
+  return true;
+}
+
+static bool FullyConnectedActShape(const nnvm::NodeAttrs &attrs,
+                                   mxnet::ShapeVector *in_shape,
+                                   mxnet::ShapeVector *out_shape) {
+  return FullyConnectedActInferAttr<mxnet::TShape, mxnet::FInferShape>(attrs, "FInferShape",
+                                                                        in_shape, out_shape);
+}
+
+static bool FullyConnectedActType(const nnvm::NodeAttrs &attrs,
+                                  std::vector<int> *in_type, std::vector<int> *out_type) {
+  return FullyConnectedActInferAttr<int, nnvm::FInferType>(attrs, "FInferType",
+                                                           in_type, out_type);
+}
+
+static std::vector<nnvm::NodeEntry> FullyConnectedActGrad(
+    const nnvm::ObjectPtr &n, const std::vector<nnvm::NodeEntry> &ograds) {
+  using namespace fcact;
+  const FullyConnectedActParam &param = nnvm::get<FullyConnectedActParam>(n->attrs.parsed);
+  // gradient of the pre-activation, then of the inputs of the FullyConnected
+  std::vector<nnvm::NodeEntry> act_heads{ograds[kOut],
+                                         nnvm::NodeEntry{n, param.gelu() ? kPre : kOut, 0}};
+  nnvm::ObjectPtr act_grad = MakeNode("_backward_contrib_FullyConnectedAct",
+                                      n->attrs.name + "_act_backward",
+                                      &act_heads, &n->attrs.dict, &n);
+
+  std::vector<nnvm::NodeEntry> fc_heads{nnvm::NodeEntry{act_grad, 0, 0},
+                                        n->inputs[fullc::kData], n->inputs[fullc::kWeight]};
+  nnvm::ObjectPtr fc_grad = MakeNode("_backward_FullyConnected",
+                                     n->attrs.name + "_fc_backward",
+                                     &fc_heads, &param.fc_attrs.dict, &n);
+
+  std::vector<nnvm::NodeEntry> in_grad;
+  for (uint32_t i = 0; i < param.NumInputs(); ++i) in_grad.emplace_back(fc_grad, i, 0);
+  return in_grad;
+}
+
+static std::vector<dmlc::ParamFieldInfo> FullyConnectedActFields() {
+  std::vector<dmlc::ParamFieldInfo> ret = FullyConnectedParam::__FIELDS__();
+  for (const auto &f : FCActTypeParam::__FIELDS__()) ret.push_back(f);
+  return ret;
+}
+
+NNVM_REGISTER_OP(_contrib_FullyConnectedAct)
+.describe(R"code(FullyConnected followed by a ReLU or GELU activation.
+
+Computes ``act(FullyConnected(data, weight, bias))`` taking the parameters of FullyConnected
+and ``act_type``. On GPU the bias and the ReLU are applied by the epilogue of the cuBLASLt
+GEMM, which writes the output once. GELU is the exact erf form: the GEMM epilogue adds the
+bias and one more kernel applies the activation. Set ``MXNET_USE_CUBLASLT_EPILOGUE`` to 0 to
+run FullyConnected and the activation as separate kernels.
+
+The operator is inserted by the ``FuseFCActivation`` graph pass, applied through
+``optimize_for`` or ``hybridize(backend='FuseFCActivation')``.
+
+)code" ADD_FILELINE)
+.set_num_inputs([](const NodeAttrs &attrs) {
+  return nnvm::get<FullyConnectedActParam>(attrs.parsed).NumInputs();
+})
+.set_num_outputs([](const NodeAttrs &attrs) {
+  return nnvm::get<FullyConnectedActParam>(attrs.parsed).NumOutputs();
+})
+.set_attr_parser(FullyConnectedActParamParser)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+    [](const NodeAttrs &attrs) {
+  const FullyConnectedActParam &param = nnvm::get<FullyConnectedActParam>(attrs.parsed);
+  if (param.fc().no_bias) return std::vector<std::string>{"data", "weight"};
+  return std::vector<std::string>{"data", "weight", "bias"};
+})
+.set_attr<nnvm::FListOutputNames>("FListOutputNames",
+    [](const NodeAttrs &attrs) {
+  const FullyConnectedActParam &param = nnvm::get<FullyConnectedActParam>(attrs.parsed);
+  if (param.gelu()) return std::vector<std::string>{"output", "pre_activation"};
+  return std::vector<std::string>{"output"};
+})
+.set_attr<nnvm::FNumVisibleOutputs>("FNumVisibleOutputs",
+    [](const NodeAttrs &attrs) {
+  return 1;
+})
+.set_attr<mxnet::FInferShape>("FInferShape", FullyConnectedActShape)
+.set_attr<nnvm::FInferType>("FInferType", FullyConnectedActType)
+.set_attr<FResourceRequest>("FResourceRequest", [](const NodeAttrs &n) {
+  return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
+})
+.set_attr<FCompute>("FCompute<cpu>", FullyConnectedActCompute<cpu>)
+.set_attr<nnvm::FGradient>("FGradient", FullyConnectedActGrad)
+.add_argument("data", "NDArray-or-Symbol", "Input data.")
+.add_argument("weight", "NDArray-or-Symbol", "Weight matrix.")
+.add_argument("bias", "NDArray-or-Symbol", "Bias parameter.")
+.add_arguments(FullyConnectedActFields());
+
+// not a TIsBackward op: its output is the gradient of the pre-activation, which is no
+// gradient of an input of the forward op
+NNVM_REGISTER_OP(_backward_contrib_FullyConnectedAct)
+.set_num_inputs(2)
+.set_num_outputs(1)
+.set_attr_parser(FullyConnectedActParamParser)
+.set_attr<mxnet::FInferShape>("FInferShape", ElemwiseShape<2, 1>)
+.set_attr<nnvm::FInferType>("FInferType", ElemwiseType<2, 1>)
+.set_attr<nnvm::FInplaceOption>("FInplaceOption", [](const NodeAttrs &attrs) {
+  return std::vector<std::pair<int, int> >{{0, 0}};
+})
+.set_attr<FCompute>("FCompute<cpu>", FullyConnectedActGradCompute<cpu>);
+
+}  // namespace op
+}  // namespace mxnet
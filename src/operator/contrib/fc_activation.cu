@@ -0,0 +1,112 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file fc_activation.cu
+ * \brief FullyConnected followed by ReLU or GELU as one op
+ */
+
+#include "./fc_activation-inl.h"
+#include "../../common/cuda/cublaslt.h"
+
+namespace mxnet {
+namespace op {
+
+#if CUDA_VERSION >= 11000
+
+bool FullyConnectedCublasLt(const OpContext &ctx, const FullyConnectedParam &param,
+                            const std::vector<TBlob> &inputs, const TBlob &out, bool relu) {
+  using namespace mshadow;
+  using common::cuda::kCublasLtWorkspace;
+  static const bool enabled = dmlc::GetEnv("MXNET_USE_CUBLASLT_EPILOGUE", true);
+  if (!enabled || (out.type_flag_ != kFloat32 && out.type_flag_ != kFloat16)) return false;
+  const TBlob &weight = inputs[fullc::kWeight];
+  const uint64_t n = weight.shape_[0], k = weight.shape_[1], m = out.Size() / n;
+  const cudaDataType_t type = out.type_flag_ == kFloat32 ? CUDA_R_32F : CUDA_R_16F;
+
+  Stream<gpu> *s = ctx.get_stream<gpu>();
+  Tensor<gpu, 1, char> workspace = ctx.requested[fcact::kTempSpace]
+      .get_space_typed<gpu, 1, char>(Shape1(kCublasLtWorkspace), s);
+
+  // the column major out^T (n, m) = weight (n, k) . data^T (k, m), the bias is added to
+  // each column and the ReLU applied before the output is written
+  cublasLtMatmulDesc_t desc;
+  CHECK_EQ(cublasLtMatmulDescCreate(&desc, CUBLAS_COMPUTE_32F, CUDA_R_32F),
+           CUBLAS_STATUS_SUCCESS);
+  const cublasOperation_t trans_a = CUBLAS_OP_T, trans_b = CUBLAS_OP_N;
+  cublasLtMatmulDescSetAttribute(desc, CUBLASLT_MATMUL_DESC_TRANSA, &trans_a, sizeof(trans_a));
+  cublasLtMatmulDescSetAttribute(desc, CUBLASLT_MATMUL_DESC_TRANSB, &trans_b, sizeof(trans_b));
+  cublasLtEpilogue_t epilogue;
+  if (param.no_bias) {
+    epilogue = relu ? CUBLASLT_EPILOGUE_RELU : CUBLASLT_EPILOGUE_DEFAULT;
+  } else {
+    epilogue = relu ? CUBLASLT_EPILOGUE_RELU_BIAS : CUBLASLT_EPILOGUE_BIAS;
+    const void *bias = inputs[fullc::kBias].dptr_;
+    cublasLtMatmulDescSetAttribute(desc, CUBLASLT_MATMUL_DESC_BIAS_POINTER,
+                                   &bias, sizeof(bias));
+  }
+  cublasLtMatmulDescSetAttribute(desc, CUBLASLT_MATMUL_DESC_EPILOGUE,
+                                 &epilogue, sizeof(epilogue));
+  cublasLtMatrixLayout_t a_layout = common::cuda::CublasLtLayout(type, k, n);
+  cublasLtMatrixLayout_t b_layout = common::cuda::CublasLtLayout(type, k, m);
+  cublasLtMatrixLayout_t c_layout = common::cuda::CublasLtLayout(type, n, m);
+  cublasLtMatmulPreference_t preference;
+  cublasLtMatmulPreferenceCreate(&preference);
+  const size_t workspace_bytes = kCublasLtWorkspace;
+  cublasLtMatmulPreferenceSetAttribute(preference, CUBLASLT_MATMUL_PREF_MAX_WORKSPACE_BYTES,
+                                       &workspace_bytes, sizeof(workspace_bytes));
+
+  const cublasLtHandle_t handle = common::cuda::CublasLtHandle(ctx.run_ctx.ctx.dev_id);
+  cublasLtMatmulHeuristicResult_t heuristic;
+  int num_results = 0;
+  cublasStatus_t status = cublasLtMatmulAlgoGetHeuristic(
+      handle, desc, a_layout, b_layout, c_layout, c_layout, preference, 1, &heuristic,
+      &num_results);
+  if (status == CUBLAS_STATUS_SUCCESS && num_results > 0) {
+    const float alpha = 1.0f, beta = 0.0f;
+    status = cublasLtMatmul(handle, desc, &alpha, weight.dptr_, a_layout,
+                            inputs[fullc::kData].dptr_, b_layout, &beta, out.dptr_, c_layout,
+                            out.dptr_, c_layout, &heuristic.algo, workspace.dptr_,
+                            workspace_bytes, Stream<gpu>::GetStream(s));
+  }
+  cublasLtMatmulPreferenceDestroy(preference);
+  cublasLtMatrixLayoutDestroy(c_layout);
+  cublasLtMatrixLayoutDestroy(b_layout);
+  cublasLtMatrixLayoutDestroy(a_layout);
+  cublasLtMatmulDescDestroy(desc);
+  return status == CUBLAS_STATUS_SUCCESS && num_results > 0;
+}
+
+#else
+
+bool FullyConnectedCublasLt(const OpContext &ctx, const FullyConnectedParam &param,
+                            const std::vector<TBlob> &inputs, const TBlob &out, bool relu) {
+  return false;
+}
+
+#endif  // CUDA_VERSION >= 11000
+
+NNVM_REGISTER_OP(_contrib_FullyConnectedAct)
+.set_attr<FCompute>("FCompute<gpu>", FullyConnectedActCompute<gpu>);
+
+NNVM_REGISTER_OP(_backward_contrib_FullyConnectedAct)
+.set_attr<FCompute>("FCompute<gpu>", FullyConnectedActGradCompute<gpu>);
+
+}  // namespace op
+}  // namespace mxnet
@@ -0,0 +1,462 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file fp8_gemm-inl.h
+ * \brief FullyConnected and batch_dot computed in FP8 with delayed scaling
+ *
+ *  The operands of the forward GEMM are cast to E4M3 and the output gradient to E5M2, or
+ *  to E4M3 too with the e4m3 format, each multiplied by a per-tensor scale mapping its
+ *  expected absolute maximum (amax) to the largest FP8 value. The scales are computed from
+ *  the amax history, an auxiliary state of (3, amax_history_len) values holding the amax
+ *  of the lhs, the rhs and the output gradient over the last steps, most recent first.
+ *  The op uses the scales of the previous steps, and records the amax of the current
+ *  tensors in the history during training. The scales of the forward pass are a hidden
+ *  output, with which the backward pass casts the operands again instead of keeping them.
+ *
+ *  On GPUs with FP8 Tensor Cores (compute capability 8.9 and above, CUDA 11.8) the GEMM
+ *  runs through cuBLASLt on FP8 values. Elsewhere the FP8 values are held in the type of
+ *  the data and multiplied by the GEMM of the device, which gives the results of FP8
+ *  operands with a wider accumulation.
+ */
+#ifndef MXNET_OPERATOR_CONTRIB_FP8_GEMM_INL_H_
+#define MXNET_OPERATOR_CONTRIB_FP8_GEMM_INL_H_
+
+#include <mxnet/operator_util.h>
+#include <cfloat>
+#include <cmath>
+#include <type_traits>
+#include <vector>
+#include "../linalg.h"
+#include "../mshadow_op.h"
+#include "../mxnet_op.h"
+#include "../operator_common.h"
+#include "../tensor/broadcast_reduce_op.h"
+
+namespace mxnet {
+namespace op {
+
+namespace fp8 {
+enum FP8Type {kE4M3, kE5M2};
+enum FP8Format {kHybrid, kAllE4M3};
+enum FP8AmaxAlgo {kMax, kMostRecent};
+/*! \brief rows of the amax history and of the scales */
+enum FP8Meta {kMetaLhs, kMetaRhs, kMetaGrad};
+const int kNumMeta = 3;
+enum FP8FCInputs {kData, kWeight, kBias};
+enum FP8BatchDotInputs {kLhs, kRhs, kBatchDotHistory};
+enum FP8Outputs {kOut, kScales};
+/*! \brief inputs of the backward ops, followed by the amax history */
+enum FP8BwdInputs {kBwdOutGrad, kBwdLhs, kBwdRhs, kBwdScales, kBwdHistory};
+enum FP8Resource {kTempSpace};
+}  // namespace fp8
+
+#define MXNET_FP8_DECLARE_FIELDS                                                 \
+  DMLC_DECLARE_FIELD(fp8_format)                                                 \
+  .add_enum("hybrid", fp8::kHybrid)                                              \
+  .add_enum("e4m3", fp8::kAllE4M3)                                               \
+  .set_default(fp8::kHybrid)                                                     \
+  .describe("hybrid casts the forward operands to E4M3 and the output gradient "  \
+            "to E5M2, e4m3 casts all of them to E4M3.");                         \
+  DMLC_DECLARE_FIELD(amax_history_len).set_lower_bound(1).set_default(16)        \
+  .describe("Number of steps kept in the amax history.");                        \
+  DMLC_DECLARE_FIELD(amax_compute_algo)                                          \
+  .add_enum("max", fp8::kMax)                                                    \
+  .add_enum("most_recent", fp8::kMostRecent)                                     \
+  .set_default(fp8::kMax)                                                        \
+  .describe("Whether the scales use the largest amax of the history or the most " \
+            "recent one.");                                                      \
+  DMLC_DECLARE_FIELD(margin).set_lower_bound(0).set_default(0)                   \
+  .describe("The scales are divided by 2^margin to leave room for growing values.")
+
+struct FP8FullyConnectedParam : public dmlc::Parameter<FP8FullyConnectedParam> {
+  int num_hidden;
+  bool no_bias;
+  bool flatten;
+  int fp8_format;
+  int amax_history_len;
+  int amax_compute_algo;
+  int margin;
+  DMLC_DECLARE_PARAMETER(FP8FullyConnectedParam) {
+    DMLC_DECLARE_FIELD(num_hidden).set_lower_bound(1)
+    .describe("Number of hidden nodes of the output.");
+    DMLC_DECLARE_FIELD(no_bias).set_default(false)
+    .describe("Whether to disable bias parameter.");
+    DMLC_DECLARE_FIELD(flatten).set_default(true)
+    .describe("Whether to collapse all but the first axis of the input data tensor.");
+    MXNET_FP8_DECLARE_FIELDS;
+  }
+};
+
+struct FP8BatchDotParam : public dmlc::Parameter<FP8BatchDotParam> {
+  bool transpose_a;
+  bool transpose_b;
+  int fp8_format;
+  int amax_history_len;
+  int amax_compute_algo;
+  int margin;
+  DMLC_DECLARE_PARAMETER(FP8BatchDotParam) {
+    DMLC_DECLARE_FIELD(transpose_a).set_default(false)
+    .describe("If true then transpose the first input before dot.");
+    DMLC_DECLARE_FIELD(transpose_b).set_default(false)
+    .describe("If true then transpose the second input before dot.");
+    MXNET_FP8_DECLARE_FIELDS;
+  }
+};
+
+MSHADOW_XINLINE float FP8MaxValue(int type) {
+  return type == fp8::kE4M3 ? 448.0f : 57344.0f;
+}
+
+/*!
+ * \brief x rounded to the nearest FP8 value of the type, ties to even, saturating at the
+ *        largest finite value
+ */
+MSHADOW_XINLINE float FP8Round(float x, int type) {
+  const int mantissa_bits = type == fp8::kE4M3 ? 3 : 2;
+  const int min_exponent = type == fp8::kE4M3 ? -6 : -14;
+  const float max_value = FP8MaxValue(type);
+  const float a = fabsf(x);
+  if (!(a == a) || a == 0.0f) return x;
+  if (a >= max_value) return copysignf(max_value, x);
+  int exponent;
+  frexpf(a, &exponent);
+  // a is in [2^(exponent - 1), 2^exponent), subnormals share the smallest step
+  exponent = exponent - 1 < min_exponent ? min_exponent : exponent - 1;
+  const float step = ldexpf(1.0f, exponent - mantissa_bits);
+  const float rounded = rintf(a / step) * step;
+  return copysignf(rounded < max_value ? rounded : max_value, x);
+}
+
+/*! \brief The FP8 type of a row of the amax history. */
+inline int FP8TypeOf(int fp8_format, int meta) {
+  return meta == fp8::kMetaGrad && fp8_format == fp8::kHybrid ? fp8::kE5M2 : fp8::kE4M3;
+}
+
+/*!
+ * \brief scales[r] = max FP8 value / amax / 2^margin, with the amax of row r of the
+ *        history, 1 while no finite amax was recorded
+ */
+struct fp8_compute_scales {
+  MSHADOW_XINLINE static void Map(int r, float *scales, const float *history, const int len,
+                                  const bool most_recent, const float lhs_max,
+                                  const float rhs_max, const float grad_max,
+                                  const float margin_factor) {
+    float amax = history[r * len];
+    for (int k = 1; !most_recent && k < len; ++k) {
+      amax = history[r * len + k] > amax ? history[r * len + k] : amax;
+    }
+    const float max_value = r == fp8::kMetaLhs ? lhs_max :
+                            r == fp8::kMetaRhs ? rhs_max : grad_max;
+    scales[r] = amax > 0.0f && amax <= FLT_MAX ? max_value / amax / margin_factor : 1.0f;
+  }
+};
+
+/*! \brief Shifts row r of the history by one step, the most recent slot set to 0. */
+struct fp8_roll_history {
+  MSHADOW_XINLINE static void Map(int i, float *history, const int row, const int len) {
+    float *h = history + row * len;
+    for (int k = len - 1; k > 0; --k) h[k] = h[k - 1];
+    h[0] = 0.0f;
+  }
+};
+
+/*!
+ * \brief A GEMM operand of (batch, rows, depth) values, the products being summed along
+ *        the depth, held as (batch, depth, rows) when transposed.
+ */
+struct FP8Operand {
+  TBlob data;
+  index_t rows;
+  bool transposed;
+  /*! \brief the scale of the operand, in the memory of the device */
+  const float *scale;
+  int type;
+
+  index_t Depth(index_t batch) const {
+    return data.Size() / batch / rows;
+  }
+};
+
+/*!
+ * \brief dst[b, r, k], with depth contiguous, is the FP8 value of the operand at (b, r, k)
+ *        times its scale, divided back by the scale
+ */
+struct fp8_cast_operand {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(index_t i, DType *dst, const DType *src, const float *scale,
+                                  const index_t rows, const index_t depth,
+                                  const bool transposed, const int type) {
+    const index_t k = i % depth;
+    const index_t br = i / depth;
+    const index_t r = br % rows;
+    const index_t b = br / rows;
+    const float x = static_cast<float>(transposed ? src[(b * depth + k) * rows + r] : src[i]);
+    const float s = *scale;
+    dst[i] = DType(FP8Round(x * s, type) / s);
+  }
+};
+
+/*! \brief out[i] += bias[i % num_hidden] */
+struct fp8_add_bias {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(index_t i, DType *out, const DType *bias,
+                                  const index_t num_hidden) {
+    out[i] += bias[i % num_hidden];
+  }
+};
+
+#if MXNET_USE_CUDA
+/*!
+ * \brief out[b] = lhs[b] . rhs[b]^T on FP8 Tensor Cores, false when cuBLASLt or the
+ *        device does not support the GEMM, defined in fp8_gemm.cu
+ */
+template<typename DType>
+bool FP8CublasLtGemm(const OpContext &ctx, const FP8Operand &lhs, const FP8Operand &rhs,
+                     const TBlob &out, const OpReqType req);
+#endif
+
+/*! \brief out (batch, M, N) = lhs (batch, M, K) . rhs (batch, N, K)^T on the FP8 values. */
+template<typename xpu, typename DType>
+void FP8Gemm(const OpContext &ctx, const FP8Operand &lhs, const FP8Operand &rhs,
+             const TBlob &out, const OpReqType req) {
+  using namespace mshadow;
+  using namespace mxnet_op;
+  if (req == kNullOp) return;
+#if MXNET_USE_CUDA
+  if (std::is_same<xpu, gpu>::value && FP8CublasLtGemm<DType>(ctx, lhs, rhs, out, req)) return;
+#endif
+  Stream<xpu> *s = ctx.get_stream<xpu>();
+  const index_t batch = out.shape_[0];
+  const index_t depth = lhs.Depth(batch);
+  CHECK_EQ(rhs.Depth(batch), depth);
+  const index_t lhs_size = batch * lhs.rows * depth;
+  const index_t rhs_size = batch * rhs.rows * depth;
+  Tensor<xpu, 1, DType> space = ctx.requested[fp8::kTempSpace].get_space_typed<xpu, 1, DType>(
+      Shape1(lhs_size + rhs_size), s);
+  Kernel<fp8_cast_operand, xpu>::Launch(s, lhs_size, space.dptr_, lhs.data.dptr<DType>(),
+                                        lhs.scale, lhs.rows, depth, lhs.transposed, lhs.type);
+  Kernel<fp8_cast_operand, xpu>::Launch(s, rhs_size, space.dptr_ + lhs_size,
+                                        rhs.data.dptr<DType>(), rhs.scale, rhs.rows, depth,
+                                        rhs.transposed, rhs.type);
+  const Tensor<xpu, 3, DType> l(space.dptr_, Shape3(batch, lhs.rows, depth), s);
+  const Tensor<xpu, 3, DType> r(space.dptr_ + lhs_size, Shape3(batch, rhs.rows, depth), s);
+  linalg_batch_gemm(l, r, out.get<xpu, 3, DType>(s), DType(1),
+                    DType(req == kAddTo ? 1 : 0), false, true, s);
+}
+
+/*! \brief Records the amax of the tensor as the most recent entry of the history row. */
+template<typename xpu>
+void FP8RecordAmax(const OpContext &ctx, const TBlob &history, int row, const TBlob &tensor) {
+  mshadow::Stream<xpu> *s = ctx.get_stream<xpu>();
+  const int len = history.shape_[1];
+  mxnet_op::Kernel<fp8_roll_history, xpu>::Launch(s, 1, history.dptr<float>(), row, len);
+  if (tensor.Size() == 0) return;
+  const mxnet::TShape small(tensor.ndim(), 1);
+  const TBlob amax(history.dptr<float>() + row * len, small, xpu::kDevMask,
+                   ctx.run_ctx.ctx.dev_id);
+  ReduceAxesComputeImpl<xpu, mshadow::red::maximum, true, false, mshadow_op::abs>(
+      ctx, {tensor}, {kWriteTo}, {amax}, small);
+}
+
+/*!
+ * \brief The amounts of a batch_dot like product of lhs and rhs seen as (batch, M, K) and
+ *        (batch, K, N) matrices after their transpositions.
+ */
+struct FP8Product {
+  index_t batch, m, n, k;
+  bool transpose_a, transpose_b;
+
+  FP8Product(const mxnet::TShape &lhs, const mxnet::TShape &rhs, bool ta, bool tb,
+             index_t batch)
+      : batch(batch), transpose_a(ta), transpose_b(tb) {
+    m = ta ? lhs[lhs.ndim() - 1] : lhs[lhs.ndim() - 2];
+    k = ta ? lhs[lhs.ndim() - 2] : lhs[lhs.ndim() - 1];
+    n = tb ? rhs[rhs.ndim() - 2] : rhs[rhs.ndim() - 1];
+  }
+
+  /*! \brief op(lhs) with its M rows, or its transpose with K rows */
+  FP8Operand Lhs(const TBlob &lhs, bool k_rows, const float *scale, int type) const {
+    return {lhs, k_rows ? k : m, k_rows != transpose_a, scale, type};
+  }
+  /*! \brief op(rhs)^T with its N rows, or op(rhs) with its K rows */
+  FP8Operand Rhs(const TBlob &rhs, bool k_rows, const float *scale, int type) const {
+    return {rhs, k_rows ? k : n, k_rows == transpose_b, scale, type};
+  }
+  /*! \brief the output gradient with its M rows, or its transpose with N rows */
+  FP8Operand Grad(const TBlob &grad, bool n_rows, const float *scale, int type) const {
+    return {grad, n_rows ? n : m, n_rows, scale, type};
+  }
+};
+
+template<typename xpu, typename Param>
+void FP8GemmForward(const OpContext &ctx, const Param &param, const FP8Product &p,
+                    const TBlob &lhs, const TBlob &rhs, const TBlob &history,
+                    const TBlob &out, const OpReqType req, const TBlob &scales) {
+  using namespace fp8;
+  mshadow::Stream<xpu> *s = ctx.get_stream<xpu>();
+  CHECK_EQ(history.type_flag_, mshadow::kFloat32) << "the amax history must be float32";
+  // the scales come from the previous steps, before the amax of this one is recorded
+  mxnet_op::Kernel<fp8_compute_scales, xpu>::Launch(
+      s, kNumMeta, scales.dptr<float>(), history.dptr<float>(), param.amax_history_len,
+      param.amax_compute_algo == kMostRecent,
+      FP8MaxValue(FP8TypeOf(param.fp8_format, kMetaLhs)),
+      FP8MaxValue(FP8TypeOf(param.fp8_format, kMetaRhs)),
+      FP8MaxValue(FP8TypeOf(param.fp8_format, kMetaGrad)),
+      std::ldexp(1.0f, param.margin));
+  if (ctx.is_train) {
+    FP8RecordAmax<xpu>(ctx, history, kMetaLhs, lhs);
+    FP8RecordAmax<xpu>(ctx, history, kMetaRhs, rhs);
+  }
+  const float *scale = scales.dptr<float>();
+  const TBlob out3 = out.reshape(mshadow::Shape3(p.batch, p.m, p.n));
+  MSHADOW_REAL_TYPE_SWITCH(out.type_flag_, DType, {
+    FP8Gemm<xpu, DType>(
+        ctx, p.Lhs(lhs, false, scale + kMetaLhs, FP8TypeOf(param.fp8_format, kMetaLhs)),
+        p.Rhs(rhs, false, scale + kMetaRhs, FP8TypeOf(param.fp8_format, kMetaRhs)),
+        out3, req);
+  });
+}
+
+/*! \brief The gradients of lhs and rhs for the output gradient of the element 0 of inputs. */
+template<typename xpu, typename Param>
+void FP8GemmBackward(const OpContext &ctx, const Param &param, const FP8Product &p,
+                     const std::vector<TBlob> &inputs, const std::vector<OpReqType> &req,
+                     const std::vector<TBlob> &outputs) {
+  using namespace fp8;
+  const TBlob &grad = inputs[kBwdOutGrad];
+  const TBlob &lhs = inputs[kBwdLhs];
+  const TBlob &rhs = inputs[kBwdRhs];
+  const float *scale = inputs[kBwdScales].dptr<float>();
+  FP8RecordAmax<xpu>(ctx, inputs[kBwdHistory], kMetaGrad, grad);
+  const int lhs_type = FP8TypeOf(param.fp8_format, kMetaLhs);
+  const int rhs_type = FP8TypeOf(param.fp8_format, kMetaRhs);
+  const int grad_type = FP8TypeOf(param.fp8_format, kMetaGrad);
+  MSHADOW_REAL_TYPE_SWITCH(grad.type_flag_, DType, {
+    // d op(lhs) = grad . op(rhs)^T, the gradient of a transposed lhs is computed transposed
+    const TBlob lhs_grad = p.transpose_a ? outputs[0].reshape(mshadow::Shape3(p.batch, p.k, p.m))
+                                         : outputs[0].reshape(mshadow::Shape3(p.batch, p.m, p.k));
+    const FP8Operand g_m = p.Grad(grad, false, scale + kMetaGrad, grad_type);
+    const FP8Operand b_k = p.Rhs(rhs, true, scale + kMetaRhs, rhs_type);
+    if (p.transpose_a) {
+      FP8Gemm<xpu, DType>(ctx, b_k, g_m, lhs_grad, req[0]);
+    } else {
+      FP8Gemm<xpu, DType>(ctx, g_m, b_k, lhs_grad, req[0]);
+    }
+    // d op(rhs) = op(lhs)^T . grad
+    const TBlob rhs_grad = p.transpose_b ? outputs[1].reshape(mshadow::Shape3(p.batch, p.n, p.k))
+                                         : outputs[1].reshape(mshadow::Shape3(p.batch, p.k, p.n));
+    const FP8Operand g_n = p.Grad(grad, true, scale + kMetaGrad, grad_type);
+    const FP8Operand a_k = p.Lhs(lhs, true, scale + kMetaLhs, lhs_type);
+    if (p.transpose_b) {
+      FP8Gemm<xpu, DType>(ctx, g_n, a_k, rhs_grad, req[1]);
+    } else {
+      FP8Gemm<xpu, DType>(ctx, a_k, g_n, rhs_grad, req[1]);
+    }
+  });
+}
+
+/*! \brief The FullyConnected product data . weight^T as a batch_dot of one matrix. */
+inline FP8Product FP8FCProduct(const FP8FullyConnectedParam &param, const mxnet::TShape &data,
+                               const mxnet::TShape &weight) {
+  const index_t depth = param.flatten ? data.ProdShape(1, data.ndim()) : data[data.ndim() - 1];
+  return FP8Product(mshadow::Shape2(data.Size() / depth, depth), weight, false, true, 1);
+}
+
+inline index_t FP8HistoryInput(const FP8FullyConnectedParam &param) {
+  return param.no_bias ? 2 : 3;
+}
+
+template<typename xpu>
+void FP8FullyConnectedCompute(const nnvm::NodeAttrs &attrs, const OpContext &ctx,
+                              const std::vector<TBlob> &inputs,
+                              const std::vector<OpReqType> &req,
+                              const std::vector<TBlob> &outputs) {
+  using namespace fp8;
+  const FP8FullyConnectedParam &param = nnvm::get<FP8FullyConnectedParam>(attrs.parsed);
+  CHECK_EQ(inputs.size(), FP8HistoryInput(param) + 1U);
+  CHECK_EQ(outputs.size(), 2U);
+  const FP8Product p = FP8FCProduct(param, inputs[kData].shape_, inputs[kWeight].shape_);
+  FP8GemmForward<xpu>(ctx, param, p, inputs[kData], inputs[kWeight],
+                      inputs[FP8HistoryInput(param)], outputs[kOut], req[kOut],
+                      outputs[kScales]);
+  if (!param.no_bias && req[kOut] != kNullOp) {
+    MSHADOW_REAL_TYPE_SWITCH(outputs[kOut].type_flag_, DType, {
+      mxnet_op::Kernel<fp8_add_bias, xpu>::Launch(
+          ctx.get_stream<xpu>(), outputs[kOut].Size(), outputs[kOut].dptr<DType>(),
+          inputs[kBias].dptr<DType>(), static_cast<index_t>(param.num_hidden));
+    });
+  }
+}
+
+template<typename xpu>
+void FP8FullyConnectedGradCompute(const nnvm::NodeAttrs &attrs, const OpContext &ctx,
+                                  const std::vector<TBlob> &inputs,
+                                  const std::vector<OpReqType> &req,
+                                  const std::vector<TBlob> &outputs) {
+  using namespace fp8;
+  const FP8FullyConnectedParam &param = nnvm::get<FP8FullyConnectedParam>(attrs.parsed);
+  CHECK_EQ(inputs.size(), 5U);
+  CHECK_EQ(outputs.size(), param.no_bias ? 2U : 3U);
+  const FP8Product p = FP8FCProduct(param, inputs[kBwdLhs].shape_, inputs[kBwdRhs].shape_);
+  FP8GemmBackward<xpu>(ctx, param, p, inputs, req, outputs);
+  if (!param.no_bias) {
+    ReduceAxesComputeImpl<xpu, mshadow::red::sum, false>(
+        ctx, {inputs[kBwdOutGrad].reshape(mshadow::Shape2(p.m, p.n))}, {req[kBias]},
+        {outputs[kBias].reshape(mshadow::Shape2(1, p.n))}, mshadow::Shape2(1, p.n));
+  }
+}
+
+inline FP8Product FP8BatchDotProduct(const FP8BatchDotParam &param, const mxnet::TShape &lhs,
+                                     const mxnet::TShape &rhs) {
+  return FP8Product(lhs, rhs, param.transpose_a, param.transpose_b,
+                    lhs.ProdShape(0, lhs.ndim() - 2));
+}
+
+template<typename xpu>
+void FP8BatchDotCompute(const nnvm::NodeAttrs &attrs, const OpContext &ctx,
+                        const std::vector<TBlob> &inputs, const std::vector<OpReqType> &req,
+                        const std::vector<TBlob> &outputs) {
+  using namespace fp8;
+  const FP8BatchDotParam &param = nnvm::get<FP8BatchDotParam>(attrs.parsed);
+  CHECK_EQ(inputs.size(), 3U);
+  CHECK_EQ(outputs.size(), 2U);
+  const FP8Product p = FP8BatchDotProduct(param, inputs[kLhs].shape_, inputs[kRhs].shape_);
+  FP8GemmForward<xpu>(ctx, param, p, inputs[kLhs], inputs[kRhs], inputs[kBatchDotHistory],
+                      outputs[kOut], req[kOut], outputs[kScales]);
+}
+
+template<typename xpu>
+void FP8BatchDotGradCompute(const nnvm::NodeAttrs &attrs, const OpContext &ctx,
+                            const std::vector<TBlob> &inputs,
+                            const std::vector<OpReqType> &req,
+                            const std::vector<TBlob> &outputs) {
+  using namespace fp8;
+  const FP8BatchDotParam &param = nnvm::get<FP8BatchDotParam>(attrs.parsed);
+  CHECK_EQ(inputs.size(), 5U);
+  CHECK_EQ(outputs.size(), 2U);
+  const FP8Product p = FP8BatchDotProduct(param, inputs[kBwdLhs].shape_,
+                                          inputs[kBwdRhs].shape_);
+  FP8GemmBackward<xpu>(ctx, param, p, inputs, req, outputs);
+}
+
+}  // namespace op
+}  // namespace mxnet
+
+#endif  // MXNET_OPERATOR_CONTRIB_FP8_GEMM_INL_H_
@@ -0,0 +1,306 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file fp8_gemm.cc
+ * \brief FullyConnected and batch_dot computed in FP8 with delayed scaling
+ */
+
+#include "./fp8_gemm-inl.h"
+#include "../elemwise_op_common.h"
+
+namespace mxnet {
+namespace op {
+
+DMLC_REGISTER_PARAMETER(FP8FullyConnectedParam);
+DMLC_REGISTER_PARAMETER(FP8BatchDotParam);
+
+namespace {
+
+template<typename Param>
+mxnet::TShape FP8HistoryShape(const Param &param) {
+  return mshadow::Shape2(fp8::kNumMeta, param.amax_history_len);
+}
+
+/*! \brief the amax history is float32, the other inputs and the output share their type */
+bool FP8GemmType(size_t history, std::vector<int> *in_type, std::vector<int> *out_type) {
+  using namespace fp8;
+  TYPE_ASSIGN_CHECK(*in_type, history, mshadow::kFloat32);
+  TYPE_ASSIGN_CHECK(*out_type, kScales, mshadow::kFloat32);
+  int dtype = (*out_type)[kOut];
+  for (size_t i = 0; i < history; ++i) {
+    if (dtype == -1) dtype = (*in_type)[i];
+  }
+  if (dtype == -1) return false;
+  for (size_t i = 0; i < history; ++i) TYPE_ASSIGN_CHECK(*in_type, i, dtype);
+  TYPE_ASSIGN_CHECK(*out_type, kOut, dtype);
+  return true;
+}
+
+/*! \brief the inputs of the backward op: output gradient, lhs, rhs, scales and history */
+std::vector<nnvm::NodeEntry> FP8GemmGradHeads(const nnvm::ObjectPtr &n,
+                                              const std::vector<nnvm::NodeEntry> &ograds,
+                                              size_t history) {
+  return {ograds[fp8::kOut], n->inputs[0], n->inputs[1],
+          nnvm::NodeEntry{n, fp8::kScales, 0}, n->inputs[history]};
+}
+
+/*! \brief the gradients of the backward op followed by no gradient for the history */
+std::vector<nnvm::NodeEntry> FP8GemmInputGrads(const nnvm::ObjectPtr &grad, size_t num_grads) {
+  std::vector<nnvm::NodeEntry> in_grad;
+  for (uint32_t i = 0; i < num_grads; ++i) in_grad.emplace_back(grad, i, 0);
+  nnvm::ObjectPtr ng = nnvm::Node::Create();
+  ng->attrs.op = Op::Get("_NoGradient");
+  ng->attrs.name = "NoGradient";
+  in_grad.emplace_back(ng);
+  return in_grad;
+}
+
+}  // namespace
+
+static bool FP8FullyConnectedShape(const nnvm::NodeAttrs &attrs,
+                                   mxnet::ShapeVector *in_shape,
+                                   mxnet::ShapeVector *out_shape) {
+  using namespace fp8;
+  const FP8FullyConnectedParam &param = nnvm::get<FP8FullyConnectedParam>(attrs.parsed);
+  const size_t history = FP8HistoryInput(param);
+  CHECK_EQ(in_shape->size(), history + 1);
+  CHECK_EQ(out_shape->size(), 2U);
+  SHAPE_ASSIGN_CHECK(*in_shape, history, FP8HistoryShape(param));
+  SHAPE_ASSIGN_CHECK(*out_shape, kScales, mshadow::Shape1(kNumMeta));
+  const mxnet::TShape &dshape = (*in_shape)[kData];
+  if (!mxnet::ndim_is_known(dshape)) return false;
+  const index_t depth = param.flatten ? dshape.ProdShape(1, dshape.ndim())
+                                      : dshape[dshape.ndim() - 1];
+  SHAPE_ASSIGN_CHECK(*in_shape, kWeight, mshadow::Shape2(param.num_hidden, depth));
+  if (!param.no_bias) SHAPE_ASSIGN_CHECK(*in_shape, kBias, mshadow::Shape1(param.num_hidden));
+  mxnet::TShape oshape = dshape;
+  if (param.flatten) oshape = mshadow::Shape2(dshape[0], param.num_hidden);
+  oshape[oshape.ndim() - 1] = param.num_hidden;
+  SHAPE_ASSIGN_CHECK(*out_shape, kOut, oshape);
+  return shape_is_known(*in_shape) && shape_is_known(*out_shape);
+}
+
+static bool FP8FullyConnectedType(const nnvm::NodeAttrs &attrs,
+                                  std::vector<int> *in_type, std::vector<int> *out_type) {
+  const FP8FullyConnectedParam &param = nnvm::get<FP8FullyConnectedParam>(attrs.parsed);
+  CHECK_EQ(in_type->size(), FP8HistoryInput(param) + 1);
+  CHECK_EQ(out_type->size(), 2U);
+  return FP8GemmType(FP8HistoryInput(param), in_type, out_type);
+}
+
+static std::vector<nnvm::NodeEntry> FP8FullyConnectedGrad(
+    const nnvm::ObjectPtr &n, const std::vector<nnvm::NodeEntry> &ograds) {
+  const FP8FullyConnectedParam &param = nnvm::get<FP8FullyConnectedParam>(n->attrs.parsed);
+  std::vector<nnvm::NodeEntry> heads = FP8GemmGradHeads(n, ograds, FP8HistoryInput(param));
+  nnvm::ObjectPtr grad = MakeNode("_backward_contrib_fp8_fully_connected",
+                                  n->attrs.name + "_backward", &heads, &n->attrs.dict, &n);
+  return FP8GemmInputGrads(grad, param.no_bias ? 2 : 3);
+}
+
+static bool FP8BatchDotShape(const nnvm::NodeAttrs &attrs,
+                             mxnet::ShapeVector *in_shape,
+                             mxnet::ShapeVector *out_shape) {
+  using namespace fp8;
+  const FP8BatchDotParam &param = nnvm::get<FP8BatchDotParam>(attrs.parsed);
+  CHECK_EQ(in_shape->size(), 3U);
+  CHECK_EQ(out_shape->size(), 2U);
+  SHAPE_ASSIGN_CHECK(*in_shape, kBatchDotHistory, FP8HistoryShape(param));
+  SHAPE_ASSIGN_CHECK(*out_shape, kScales, mshadow::Shape1(kNumMeta));
+  const mxnet::TShape &lshape = (*in_shape)[kLhs];
+  const mxnet::TShape &rshape = (*in_shape)[kRhs];
+  if (!shape_is_known(lshape) || !shape_is_known(rshape)) return false;
+  CHECK(lshape.ndim() >= 3 && lshape.ndim() == rshape.ndim())
+      << "_contrib_fp8_batch_dot takes two arrays of the same rank, at least 3, got "
+      << lshape << " and " << rshape;
+  for (int i = 0; i < lshape.ndim() - 2; ++i) {
+    CHECK_EQ(lshape[i], rshape[i]) << "the batch axes of lhs " << lshape << " and rhs "
+                                   << rshape << " differ";
+  }
+  const FP8Product p = FP8BatchDotProduct(param, lshape, rshape);
+  const index_t rk = param.transpose_b ? rshape[rshape.ndim() - 1] : rshape[rshape.ndim() - 2];
+  CHECK_EQ(p.k, rk) << "the reduced axes of lhs " << lshape << " and rhs " << rshape
+                    << " differ";
+  mxnet::TShape oshape = lshape;
+  oshape[oshape.ndim() - 2] = p.m;
+  oshape[oshape.ndim() - 1] = p.n;
+  SHAPE_ASSIGN_CHECK(*out_shape, kOut, oshape);
+  return true;
+}
+
+static bool FP8BatchDotType(const nnvm::NodeAttrs &attrs,
+                            std::vector<int> *in_type, std::vector<int> *out_type) {
+  CHECK_EQ(in_type->size(), 3U);
+  CHECK_EQ(out_type->size(), 2U);
+  return FP8GemmType(fp8::kBatchDotHistory, in_type, out_type);
+}
+
+static std::vector<nnvm::NodeEntry> FP8BatchDotGrad(const nnvm::ObjectPtr &n,
+                                                    const std::vector<nnvm::NodeEntry> &ograds) {
+  std::vector<nnvm::NodeEntry> heads = FP8GemmGradHeads(n, ograds, fp8::kBatchDotHistory);
+  nnvm::ObjectPtr grad = MakeNode("_backward_contrib_fp8_batch_dot",
+                                  n->attrs.name + "_backward", &heads, &n->attrs.dict, &n);
+  return FP8GemmInputGrads(grad, 2);
+}
+
+static void FP8HistoryInit(const nnvm::ObjectPtr &var, const int index, const int history) {
+  if (index == history && var->attrs.dict.find("__init__") == var->attrs.dict.end()) {
+    var->attrs.dict["__init__"] = "[\"zero\", {}]";
+  }
+}
+
+NNVM_REGISTER_OP(_contrib_fp8_fully_connected)
+.describe(R"code(FullyConnected computed in FP8 with delayed scaling.
+
+The data and the weight are cast to E4M3, and the output gradient to E5M2 with the ``hybrid``
+format, after multiplying each of them by a scale mapping the largest absolute value (amax)
+recorded in ``amax_history`` over the last ``amax_history_len`` steps to the largest FP8 value.
+During training the amax of the current tensors is recorded in the history, which is an
+auxiliary state of shape (3, amax_history_len) initialized to zeros. The bias and the output
+keep the type of the data.
+
+On GPUs with FP8 Tensor Cores the product runs on them through cuBLASLt when the input size
+and ``num_hidden`` are multiples of 16; elsewhere it gives the same results from the FP8
+values held in the type of the data.
+
+The operator is inserted for FullyConnected by the ``FP8`` graph pass, which
+``amp.convert_symbol`` applies to the ops given in ``fp8_ops``.
+
+)code" ADD_FILELINE)
+.set_num_inputs([](const NodeAttrs &attrs) {
+  return static_cast<uint32_t>(
+      FP8HistoryInput(nnvm::get<FP8FullyConnectedParam>(attrs.parsed)) + 1);
+})
+.set_num_outputs(2)
+.set_attr_parser(ParamParser<FP8FullyConnectedParam>)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+    [](const NodeAttrs &attrs) {
+  const FP8FullyConnectedParam &param = nnvm::get<FP8FullyConnectedParam>(attrs.parsed);
+  std::vector<std::string> ret{"data", "weight"};
+  if (!param.no_bias) ret.emplace_back("bias");
+  ret.emplace_back("amax_history");
+  return ret;
+})
+.set_attr<nnvm::FListOutputNames>("FListOutputNames",
+    [](const NodeAttrs &attrs) {
+  return std::vector<std::string>{"output", "scales"};
+})
+.set_attr<nnvm::FNumVisibleOutputs>("FNumVisibleOutputs",
+    [](const NodeAttrs &attrs) {
+  return 1;
+})
+.set_attr<nnvm::FMutateInputs>("FMutateInputs", [](const nnvm::NodeAttrs &attrs) {
+  return std::vector<uint32_t>{static_cast<uint32_t>(
+      FP8HistoryInput(nnvm::get<FP8FullyConnectedParam>(attrs.parsed)))};
+})
+.set_attr<mxnet::FInferShape>("FInferShape", FP8FullyConnectedShape)
+.set_attr<nnvm::FInferType>("FInferType", FP8FullyConnectedType)
+.set_attr<FResourceRequest>("FResourceRequest", [](const NodeAttrs &n) {
+  return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
+})
+.set_attr<FCompute>("FCompute<cpu>", FP8FullyConnectedCompute<cpu>)
+.set_attr<nnvm::FGradient>("FGradient", FP8FullyConnectedGrad)
+.set_attr<nnvm::FSetInputVarAttrOnCompose>(
+  "FSetInputVarAttrOnCompose",
+  [](const nnvm::NodeAttrs &attrs, nnvm::ObjectPtr var, const int index) {
+    FP8HistoryInit(var, index,
+                   FP8HistoryInput(nnvm::get<FP8FullyConnectedParam>(attrs.parsed)));
+  })
+.add_argument("data", "NDArray-or-Symbol", "Input data.")
+.add_argument("weight", "NDArray-or-Symbol", "Weight matrix.")
+.add_argument("bias", "NDArray-or-Symbol", "Bias parameter.")
+.add_argument("amax_history", "NDArray-or-Symbol",
+              "The amax of the data, the weight and the output gradient over the last steps.")
+.add_arguments(FP8FullyConnectedParam::__FIELDS__());
+
+NNVM_REGISTER_OP(_backward_contrib_fp8_fully_connected)
+.set_num_inputs(5)
+.set_num_outputs([](const NodeAttrs &attrs) {
+  return nnvm::get<FP8FullyConnectedParam>(attrs.parsed).no_bias ? 2 : 3;
+})
+.set_attr_parser(ParamParser<FP8FullyConnectedParam>)
+.set_attr<nnvm::TIsBackward>("TIsBackward", true)
+.set_attr<nnvm::FMutateInputs>("FMutateInputs", [](const nnvm::NodeAttrs &attrs) {
+  return std::vector<uint32_t>{fp8::kBwdHistory};
+})
+.set_attr<FResourceRequest>("FResourceRequest", [](const NodeAttrs &n) {
+  return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
+})
+.set_attr<FCompute>("FCompute<cpu>", FP8FullyConnectedGradCompute<cpu>);
+
+NNVM_REGISTER_OP(_contrib_fp8_batch_dot)
+.describe(R"code(batch_dot computed in FP8 with delayed scaling.
+
+Takes the arrays of batch_dot, of the same rank of at least 3, and casts them and the output
+gradient to FP8 as _contrib_fp8_fully_connected does, with the scales of ``amax_history``.
+
+The operator is inserted for batch_dot by the ``FP8`` graph pass.
+
+)code" ADD_FILELINE)
+.set_num_inputs(3)
+.set_num_outputs(2)
+.set_attr_parser(ParamParser<FP8BatchDotParam>)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+    [](const NodeAttrs &attrs) {
+  return std::vector<std::string>{"lhs", "rhs", "amax_history"};
+})
+.set_attr<nnvm::FListOutputNames>("FListOutputNames",
+    [](const NodeAttrs &attrs) {
+  return std::vector<std::string>{"output", "scales"};
+})
+.set_attr<nnvm::FNumVisibleOutputs>("FNumVisibleOutputs",
+    [](const NodeAttrs &attrs) {
+  return 1;
+})
+.set_attr<nnvm::FMutateInputs>("FMutateInputs", [](const nnvm::NodeAttrs &attrs) {
+  return std::vector<uint32_t>{fp8::kBatchDotHistory};
+})
+.set_attr<mxnet::FInferShape>("FInferShape", FP8BatchDotShape)
+.set_attr<nnvm::FInferType>("FInferType", FP8BatchDotType)
+.set_attr<FResourceRequest>("FResourceRequest", [](const NodeAttrs &n) {
+  return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
+})
+.set_attr<FCompute>("FCompute<cpu>", FP8BatchDotCompute<cpu>)
+.set_attr<nnvm::FGradient>("FGradient", FP8BatchDotGrad)
+.set_attr<nnvm::FSetInputVarAttrOnCompose>(
+  "FSetInputVarAttrOnCompose",
+  [](const nnvm::NodeAttrs &attrs, nnvm::ObjectPtr var, const int index) {
+    FP8HistoryInit(var, index, fp8::kBatchDotHistory);
+  })
+.add_argument("lhs", "NDArray-or-Symbol", "The first input")
+.add_argument("rhs", "NDArray-or-Symbol", "The second input")
+.add_argument("amax_history", "NDArray-or-Symbol",
+              "The amax of lhs, rhs and the output gradient over the last steps.")
+.add_arguments(FP8BatchDotParam::__FIELDS__());
+
+NNVM_REGISTER_OP(_backward_contrib_fp8_batch_dot)
+.set_num_inputs(5)
+.set_num_outputs(2)
+.set_attr_parser(ParamParser<FP8BatchDotParam>)
+.set_attr<nnvm::TIsBackward>("TIsBackward", true)
+.set_attr<nnvm::FMutateInputs>("FMutateInputs", [](const nnvm::NodeAttrs &attrs) {
+  return std::vector<uint32_t>{fp8::kBwdHistory};
+})
+.set_attr<FResourceRequest>("FResourceRequest", [](const NodeAttrs &n) {
+  return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
+})
+.set_attr<FCompute>("FCompute<cpu>", FP8BatchDotGradCompute<cpu>);
+
+}  // namespace op
+}  // namespace mxnet
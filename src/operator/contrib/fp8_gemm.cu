@@ -0,0 +1,203 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file fp8_gemm.cu
+ * \brief FullyConnected and batch_dot computed in FP8 with delayed scaling
+ */
+
+#include "./fp8_gemm-inl.h"
+#include "../../common/cuda/cublaslt.h"
+#include "../../common/cuda/utils.h"
+
+#if CUDA_VERSION >= 11080
+#include <cuda_fp8.h>
+#endif
+
+namespace mxnet {
+namespace op {
+
+#if CUDA_VERSION >= 11080
+
+namespace {
+
+using common::cuda::CublasLtHandle;
+using common::cuda::CublasLtLayout;
+using common::cuda::kCublasLtWorkspace;
+
+/*! \brief dst[b, r, k], with depth contiguous, is the FP8 code of the operand at (b, r, k). */
+struct fp8_encode_operand {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(index_t i, __nv_fp8_storage_t *dst, const DType *src,
+                                  const float *scale, const index_t rows, const index_t depth,
+                                  const bool transposed, const int type) {
+    const index_t k = i % depth;
+    const index_t br = i / depth;
+    const index_t r = br % rows;
+    const index_t b = br / rows;
+    const float x = static_cast<float>(transposed ? src[(b * depth + k) * rows + r] : src[i]);
+    // the rounding of FP8Round keeps the results of the emulation
+    dst[i] = __nv_cvt_float_to_fp8(FP8Round(x * *scale, type), __NV_SATFINITE,
+                                   type == fp8::kE4M3 ? __NV_E4M3 : __NV_E5M2);
+  }
+};
+
+/*! \brief The dequantization scales cuBLASLt multiplies the FP8 operands by. */
+struct fp8_inverse_scales {
+  MSHADOW_XINLINE static void Map(int i, float *inverse, const float *a_scale,
+                                  const float *b_scale) {
+    inverse[0] = 1.0f / *a_scale;
+    inverse[1] = 1.0f / *b_scale;
+  }
+};
+
+cudaDataType_t FP8CudaType(int type) {
+  return type == fp8::kE4M3 ? CUDA_R_8F_E4M3 : CUDA_R_8F_E5M2;
+}
+
+/*! \brief the output types of the cuBLASLt FP8 GEMMs */
+template<typename DType> struct FP8OutputType {
+  static const bool kSupported = false;
+  static const cudaDataType_t kType = CUDA_R_32F;
+};
+template<> struct FP8OutputType<float> {
+  static const bool kSupported = true;
+  static const cudaDataType_t kType = CUDA_R_32F;
+};
+template<> struct FP8OutputType<mshadow::half::half_t> {
+  static const bool kSupported = true;
+  static const cudaDataType_t kType = CUDA_R_16F;
+};
+
+size_t FP8Align(size_t bytes) {
+  return (bytes + 255) / 256 * 256;
+}
+
+template<typename DType>
+bool FP8CublasLtGemmImpl(const OpContext &ctx, const FP8Operand &lhs, const FP8Operand &rhs,
+                         const TBlob &out, const OpReqType req) {
+  using namespace mshadow;
+  using namespace mxnet_op;
+  static const bool enabled = dmlc::GetEnv("MXNET_USE_FP8_CUBLASLT", true);
+  const int dev_id = ctx.run_ctx.ctx.dev_id;
+  const index_t batch = out.shape_[0];
+  const index_t m = lhs.rows, n = rhs.rows, k = lhs.Depth(batch);
+  // FP8 GEMMs need 16 byte aligned leading dimensions, and cannot multiply two E5M2 operands
+  if (!enabled || !FP8OutputType<DType>::kSupported || common::cuda::SMArch(dev_id) < 89 ||
+      k % 16 || m % 16 || n % 16 || (lhs.type == fp8::kE5M2 && rhs.type == fp8::kE5M2))
+    return false;
+
+  Stream<gpu> *s = ctx.get_stream<gpu>();
+  const size_t lhs_bytes = FP8Align(batch * m * k), rhs_bytes = FP8Align(batch * n * k);
+  const size_t scale_bytes = FP8Align(2 * sizeof(float));
+  Tensor<gpu, 1, char> space = ctx.requested[fp8::kTempSpace].get_space_typed<gpu, 1, char>(
+      Shape1(lhs_bytes + rhs_bytes + scale_bytes + kCublasLtWorkspace), s);
+  auto *lhs_codes = reinterpret_cast<__nv_fp8_storage_t *>(space.dptr_);
+  auto *rhs_codes = reinterpret_cast<__nv_fp8_storage_t *>(space.dptr_ + lhs_bytes);
+  auto *inverse = reinterpret_cast<float *>(space.dptr_ + lhs_bytes + rhs_bytes);
+  char *workspace = space.dptr_ + lhs_bytes + rhs_bytes + scale_bytes;
+  Kernel<fp8_encode_operand, gpu>::Launch(s, batch * m * k, lhs_codes, lhs.data.dptr<DType>(),
+                                          lhs.scale, m, k, lhs.transposed, lhs.type);
+  Kernel<fp8_encode_operand, gpu>::Launch(s, batch * n * k, rhs_codes, rhs.data.dptr<DType>(),
+                                          rhs.scale, n, k, rhs.transposed, rhs.type);
+  Kernel<fp8_inverse_scales, gpu>::Launch(s, 1, inverse, rhs.scale, lhs.scale);
+
+  // the column major out^T (n, m) = rhs (n, k) . lhs^T (k, m): cuBLASLt takes FP8 operands
+  // with the reduced axis contiguous, as A transposed and B not transposed
+  cublasLtMatmulDesc_t desc;
+  CHECK_EQ(cublasLtMatmulDescCreate(&desc, CUBLAS_COMPUTE_32F, CUDA_R_32F),
+           CUBLAS_STATUS_SUCCESS);
+  const cublasOperation_t trans_a = CUBLAS_OP_T, trans_b = CUBLAS_OP_N;
+  const float *a_scale = inverse, *b_scale = inverse + 1;
+  cublasLtMatmulDescSetAttribute(desc, CUBLASLT_MATMUL_DESC_TRANSA, &trans_a, sizeof(trans_a));
+  cublasLtMatmulDescSetAttribute(desc, CUBLASLT_MATMUL_DESC_TRANSB, &trans_b, sizeof(trans_b));
+  cublasLtMatmulDescSetAttribute(desc, CUBLASLT_MATMUL_DESC_A_SCALE_POINTER,
+                                 &a_scale, sizeof(a_scale));
+  cublasLtMatmulDescSetAttribute(desc, CUBLASLT_MATMUL_DESC_B_SCALE_POINTER,
+                                 &b_scale, sizeof(b_scale));
+  const cudaDataType_t out_type = FP8OutputType<DType>::kType;
+  cublasLtMatrixLayout_t a_layout = CublasLtLayout(FP8CudaType(rhs.type), k, n, batch);
+  cublasLtMatrixLayout_t b_layout = CublasLtLayout(FP8CudaType(lhs.type), k, m, batch);
+  cublasLtMatrixLayout_t c_layout = CublasLtLayout(out_type, n, m, batch);
+  cublasLtMatmulPreference_t preference;
+  cublasLtMatmulPreferenceCreate(&preference);
+  const size_t workspace_bytes = kCublasLtWorkspace;
+  cublasLtMatmulPreferenceSetAttribute(preference, CUBLASLT_MATMUL_PREF_MAX_WORKSPACE_BYTES,
+                                       &workspace_bytes, sizeof(workspace_bytes));
+
+  const cublasLtHandle_t handle = CublasLtHandle(dev_id);
+  cublasLtMatmulHeuristicResult_t heuristic;
+  int num_results = 0;
+  cublasStatus_t status = cublasLtMatmulAlgoGetHeuristic(
+      handle, desc, a_layout, b_layout, c_layout, c_layout, preference, 1, &heuristic,
+      &num_results);
+  if (status == CUBLAS_STATUS_SUCCESS && num_results > 0) {
+    const float alpha = 1.0f, beta = req == kAddTo ? 1.0f : 0.0f;
+    status = cublasLtMatmul(handle, desc, &alpha, rhs_codes, a_layout, lhs_codes, b_layout,
+                            &beta, out.dptr_, c_layout, out.dptr_, c_layout, &heuristic.algo,
+                            workspace, workspace_bytes, Stream<gpu>::GetStream(s));
+  }
+  cublasLtMatmulPreferenceDestroy(preference);
+  cublasLtMatrixLayoutDestroy(c_layout);
+  cublasLtMatrixLayoutDestroy(b_layout);
+  cublasLtMatrixLayoutDestroy(a_layout);
+  cublasLtMatmulDescDestroy(desc);
+  return status == CUBLAS_STATUS_SUCCESS && num_results > 0;
+}
+
+}  // namespace
+
+template<typename DType>
+bool FP8CublasLtGemm(const OpContext &ctx, const FP8Operand &lhs, const FP8Operand &rhs,
+                     const TBlob &out, const OpReqType req) {
+  return FP8CublasLtGemmImpl<DType>(ctx, lhs, rhs, out, req);
+}
+
+#else
+
+template<typename DType>
+bool FP8CublasLtGemm(const OpContext &ctx, const FP8Operand &lhs, const FP8Operand &rhs,
+                     const TBlob &out, const OpReqType req) {
+  return false;
+}
+
+#endif  // CUDA_VERSION >= 11080
+
+template bool FP8CublasLtGemm<float>(const OpContext &, const FP8Operand &,
+                                     const FP8Operand &, const TBlob &, const OpReqType);
+template bool FP8CublasLtGemm<mshadow::half::half_t>(const OpContext &, const FP8Operand &,
+                                                     const FP8Operand &, const TBlob &,
+                                                     const OpReqType);
+template bool FP8CublasLtGemm<double>(const OpContext &, const FP8Operand &,
+                                      const FP8Operand &, const TBlob &, const OpReqType);
+
+NNVM_REGISTER_OP(_contrib_fp8_fully_connected)
+.set_attr<FCompute>("FCompute<gpu>", FP8FullyConnectedCompute<gpu>);
+
+NNVM_REGISTER_OP(_backward_contrib_fp8_fully_connected)
+.set_attr<FCompute>("FCompute<gpu>", FP8FullyConnectedGradCompute<gpu>);
+
+NNVM_REGISTER_OP(_contrib_fp8_batch_dot)
+.set_attr<FCompute>("FCompute<gpu>", FP8BatchDotCompute<gpu>);
+
+NNVM_REGISTER_OP(_backward_contrib_fp8_batch_dot)
+.set_attr<FCompute>("FCompute<gpu>", FP8BatchDotGradCompute<gpu>);
+
+}  // namespace op
+}  // namespace mxnet
@@ -0,0 +1,204 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file dynamic_quantize_pass.cc
+ * \brief Replace FullyConnected by _contrib_intgemm_fully_connected with int8 weights
+ *
+ *  The pass is applied through optimize_for with the name IntgemmDynamicQuantize. The
+ *  weight of a FullyConnected given in args is quantized once by the pass, while its
+ *  float32 data is quantized by the intgemm op at every call with the maximum absolute
+ *  value of the batch, so no calibration dataset is needed. The RNN cells unrolled from
+ *  FullyConnected (i2h and h2h projections) are converted the same way. The nodes listed
+ *  in the comma-separated option `exclude` are kept in float.
+ */
+
+#include <mxnet/base.h>
+#include <mxnet/imperative.h>
+#include <mxnet/ndarray.h>
+#include <nnvm/graph.h>
+#include <nnvm/pass.h>
+#include <nnvm/symbolic.h>
+
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "../../nn/fully_connected-inl.h"
+#include "intgemm/intgemm.h"
+
+namespace mxnet {
+namespace op {
+
+namespace {
+
+using nnvm::Graph;
+using nnvm::NodeEntry;
+using nnvm::ObjectPtr;
+
+std::unordered_set<std::string> SplitNames(const std::string& names) {
+  std::unordered_set<std::string> ret;
+  std::istringstream is(names);
+  std::string name;
+  while (std::getline(is, name, ',')) {
+    if (!name.empty()) ret.insert(name);
+  }
+  return ret;
+}
+
+/*! \brief Run a single output op on the CPU. */
+NDArray InvokeOp(const char* op_name, const std::vector<NDArray*>& inputs) {
+  nnvm::NodeAttrs attrs;
+  attrs.op = nnvm::Op::Get(op_name);
+  if (attrs.op->attr_parser) attrs.op->attr_parser(&attrs);
+  std::vector<NDArray> outputs(1);
+  std::vector<NDArray*> output_ptrs{&outputs[0]};
+  Imperative::Get()->Invoke(Context::CPU(), attrs, inputs, output_ptrs);
+  return outputs[0];
+}
+
+/*! \brief Whether the intgemm op takes the data: float32 and 2D unless not flattened. */
+bool IsSupportedData(const Graph& g, const NodeEntry& data, bool flatten) {
+  if (!g.HasAttr("shape") || !g.HasAttr("dtype"))
+    return false;
+  const uint32_t eid = g.indexed_graph().entry_id(data);
+  const mxnet::TShape& shape = g.GetAttr<mxnet::ShapeVector>("shape")[eid];
+  const int dtype = g.GetAttr<nnvm::DTypeVector>("dtype")[eid];
+  return dtype == mshadow::kFloat32 && mxnet::ndim_is_known(shape) &&
+         (!flatten || shape.ndim() == 2);
+}
+
+/*! \brief Whether the intgemm op takes the weight, given in args as (num_hidden, num_input). */
+bool IsSupportedWeight(const NDArray& weight) {
+  const mxnet::TShape& shape = weight.shape();
+  return weight.dtype() == mshadow::kFloat32 && weight.ctx().dev_mask() == cpu::kDevMask &&
+         weight.storage_type() == kDefaultStorage && shape.ndim() == 2 &&
+         shape[1] % ::intgemm::Int8::tile_info.b_rows == 0 &&
+         shape[0] % ::intgemm::Int8::tile_info.b_cols == 0;
+}
+
+}  // namespace
+
+Graph IntgemmDynamicQuantize(Graph&& g) {
+  using OptionsMap = std::unordered_map<std::string, std::string>;
+  static const nnvm::Op* fc_op = nnvm::Op::Get("FullyConnected");
+  static const nnvm::Op* intgemm_op = nnvm::Op::Get("_contrib_intgemm_fully_connected");
+  const auto& options = g.GetAttr<OptionsMap>("options_map");
+  const auto exclude_it = options.find("exclude");
+  const auto excluded = SplitNames(exclude_it == options.end() ? "" : exclude_it->second);
+
+  std::unordered_map<std::string, NDArray*> args;
+  NDArray** arrays = g.GetAttr<NDArray**>("in_args");
+  const auto& names = g.GetAttr<std::vector<std::string> >("in_arg_names");
+  for (size_t i = 0; arrays != nullptr && i < names.size(); ++i) {
+    if (arrays[i] != nullptr) args[names[i]] = arrays[i];
+  }
+
+  std::unordered_set<std::string> input_names;
+  std::vector<ObjectPtr> fcs;
+  DFSVisit(g.outputs, [&](const ObjectPtr& n) {
+    if (n->is_variable()) {
+      input_names.insert(n->attrs.name);
+    } else if (n->op() == fc_op && !excluded.count(n->attrs.name)) {
+      fcs.push_back(n);
+    }
+  });
+  auto new_variable = [&input_names](std::string name) {
+    while (input_names.count(name)) name += "_";
+    input_names.insert(name);
+    return nnvm::Symbol::CreateVariable(name).outputs[0];
+  };
+
+  // the int8 weight and its scaling, shared by the nodes reading the same weight
+  std::unordered_map<std::string, std::vector<NodeEntry> > prepared;
+  std::vector<NDArray*> new_args;
+  std::vector<std::string> new_arg_names;
+  const bool prev_recording = Imperative::Get()->set_is_recording(false);
+  const bool prev_training = Imperative::Get()->set_is_training(false);
+  for (const ObjectPtr& fc : fcs) {
+    const auto& param = nnvm::get<FullyConnectedParam>(fc->attrs.parsed);
+    const NodeEntry& weight_in = fc->inputs[fullc::kWeight];
+    if (!weight_in.node->is_variable() || !IsSupportedData(g, fc->inputs[fullc::kData],
+                                                            param.flatten))
+      continue;
+    const std::string& weight_name = weight_in.node->attrs.name;
+    if (!prepared.count(weight_name)) {
+      auto it = args.find(weight_name);
+      if (it == args.end() || !IsSupportedWeight(*it->second))
+        continue;
+      NDArray max_abs = InvokeOp("_contrib_intgemm_maxabsolute", {it->second});
+      float max_value = 0.0f;
+      max_abs.SyncCopyToCPU(&max_value, 1);
+      // an all-zero weight has no scale, and is left to the float op
+      if (max_value == 0.0f)
+        continue;
+      NDArray* weight_q = new NDArray(InvokeOp("_contrib_intgemm_prepare_weight",
+                                               {it->second, &max_abs}));
+      NDArray* scaling = new NDArray(mxnet::TShape(1, 1), Context::CPU(), false,
+                                     mshadow::kFloat32);
+      const float scaling_value = max_value / 127.0f;
+      scaling->SyncCopyFromCPU(&scaling_value, 1);
+      std::vector<NodeEntry> entries{new_variable(weight_name + "_intgemm"),
+                                     new_variable(weight_name + "_intgemm_scaling")};
+      new_args.push_back(weight_q);
+      new_arg_names.push_back(entries[0].node->attrs.name);
+      new_args.push_back(scaling);
+      new_arg_names.push_back(entries[1].node->attrs.name);
+      prepared[weight_name] = std::move(entries);
+    }
+
+    nnvm::NodeAttrs attrs;
+    attrs.op = intgemm_op;
+    attrs.name = fc->attrs.name;
+    attrs.dict["num_hidden"] = std::to_string(param.num_hidden);
+    attrs.dict["no_bias"] = param.no_bias ? "True" : "False";
+    attrs.dict["flatten"] = param.flatten ? "True" : "False";
+    attrs.dict["out_type"] = "float32";
+    intgemm_op->attr_parser(&attrs);
+    std::vector<NodeEntry> inputs{fc->inputs[fullc::kData]};
+    inputs.insert(inputs.end(), prepared[weight_name].begin(), prepared[weight_name].end());
+    if (!param.no_bias) inputs.push_back(fc->inputs[fullc::kBias]);
+    // the node is converted in place, so that its consumers need no rewiring
+    fc->attrs = std::move(attrs);
+    fc->inputs = std::move(inputs);
+  }
+  Imperative::Get()->set_is_training(prev_training);
+  Imperative::Get()->set_is_recording(prev_recording);
+
+  Graph ret;
+  ret.outputs = g.outputs;
+  ret.attrs["new_args"] = std::make_shared<nnvm::any>(std::move(new_args));
+  ret.attrs["new_arg_names"] = std::make_shared<nnvm::any>(std::move(new_arg_names));
+  ret.attrs["new_aux"] = std::make_shared<nnvm::any>(std::vector<NDArray*>());
+  ret.attrs["new_aux_names"] = std::make_shared<nnvm::any>(std::vector<std::string>());
+  return ret;
+}
+
+NNVM_REGISTER_PASS(IntgemmDynamicQuantize)
+.describe("Replace FullyConnected by _contrib_intgemm_fully_connected with int8 weights "
+          "and data quantized at runtime.")
+.set_body(IntgemmDynamicQuantize)
+.set_change_graph(true)
+.depend_graph_attr("options_map")
+.depend_graph_attr("in_args");
+
+}  // namespace op
+}  // namespace mxnet
@@ -0,0 +1,197 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file intgemm_fc.cc
+ * \brief FullyConnected computed by intgemm with a weight quantized once
+ *
+ *  The INTGEMM subgraph backend rewrites FullyConnected into _sg_intgemm_fully_connected.
+ *  The op quantizes its weight on the first forward, and again only when the weight
+ *  changes, and runs _contrib_intgemm_fully_connected, which quantizes the float32 data of
+ *  each batch with its maximum absolute value. The inputs intgemm does not take fall back
+ *  to the float FullyConnected.
+ */
+
+#include <string>
+#include <vector>
+#include "intgemm_fc_property.h"
+
+namespace mxnet {
+namespace op {
+
+namespace {
+
+/*! \brief the FCompute<cpu> of a registered op */
+const FCompute &CPUFCompute(const char *op_name) {
+  static auto &fcompute = nnvm::Op::GetAttr<FCompute>("FCompute<cpu>");
+  const nnvm::Op *op = nnvm::Op::Get(op_name);
+  CHECK(fcompute.count(op)) << op_name << " has no FCompute<cpu>";
+  return fcompute[op];
+}
+
+bool IsAligned(const void *ptr) {
+  return reinterpret_cast<intptr_t>(ptr) % 64 == 0;
+}
+
+}  // namespace
+
+class SgIntgemmFCOp {
+ public:
+  explicit SgIntgemmFCOp(const nnvm::NodeAttrs &attrs)
+    : fc_attrs_(attrs.subgraphs[0]->outputs[0].node->attrs) {
+    const FullyConnectedParam &param = nnvm::get<FullyConnectedParam>(attrs.parsed);
+    intgemm_attrs_.op = Op::Get("_contrib_intgemm_fully_connected");
+    intgemm_attrs_.name = attrs.name;
+    intgemm_attrs_.dict["num_hidden"] = std::to_string(param.num_hidden);
+    intgemm_attrs_.dict["no_bias"] = param.no_bias ? "True" : "False";
+    intgemm_attrs_.dict["flatten"] = param.flatten ? "True" : "False";
+    intgemm_attrs_.dict["out_type"] = "float32";
+    intgemm_attrs_.op->attr_parser(&intgemm_attrs_);
+  }
+
+  void Forward(const OpContext &ctx,
+               const std::vector<NDArray> &inputs,
+               const std::vector<OpReqType> &req,
+               const std::vector<NDArray> &outputs);
+
+ private:
+  /*! \brief Whether intgemm takes the inputs and the output of this call. */
+  bool Supported(const std::vector<TBlob> &in_blobs, const std::vector<OpReqType> &req,
+                 const TBlob &out) const;
+  /*! \brief Quantize the weight into cached_weight_ and set scaling_. */
+  void PrepareWeight(const NDArray &weight);
+
+  nnvm::NodeAttrs fc_attrs_;
+  nnvm::NodeAttrs intgemm_attrs_;
+  bool initialized_{false};
+  size_t weight_ver_{0};
+  NDArray cached_weight_;
+  /*! \brief maximum absolute value of the weight divided by 127 */
+  float scaling_{0.0f};
+};
+
+bool SgIntgemmFCOp::Supported(const std::vector<TBlob> &in_blobs,
+                              const std::vector<OpReqType> &req,
+                              const TBlob &out) const {
+  const FullyConnectedParam &param = nnvm::get<FullyConnectedParam>(fc_attrs_.parsed);
+  const TBlob &data = in_blobs[fullc::kData];
+  const TBlob &weight = in_blobs[fullc::kWeight];
+  if (req[fullc::kOut] != kWriteTo || data.type_flag_ != mshadow::kFloat32 ||
+      weight.type_flag_ != mshadow::kFloat32 || (param.flatten && data.ndim() != 2) ||
+      !IntgemmSupportsWeightShape(weight.shape_) || !IsAligned(weight.dptr_) ||
+      !IsAligned(out.dptr_))
+    return false;
+  return param.no_bias || IsAligned(in_blobs[fullc::kBias].dptr_);
+}
+
+void SgIntgemmFCOp::PrepareWeight(const NDArray &weight) {
+  const mxnet::TShape &shape = weight.shape();
+  if (cached_weight_.is_none() || cached_weight_.shape() != shape) {
+    cached_weight_ = NDArray(shape, Context::CPU(), false, mshadow::kInt8);
+  }
+  const float *weight_ptr = weight.data().dptr<float>();
+  const float max_abs = ::intgemm::MaxAbsolute(weight_ptr, weight_ptr + shape.Size());
+  scaling_ = max_abs / 127.0f;
+  // an all-zero weight has no scale, and is left to the float op
+  if (max_abs > 0.0f) {
+    ::intgemm::Int8::PrepareBTransposed(weight_ptr, cached_weight_.data().dptr<int8_t>(),
+                                        127.0f / max_abs, shape[1], shape[0]);
+  }
+  weight_ver_ = weight.version();
+  initialized_ = true;
+}
+
+void SgIntgemmFCOp::Forward(const OpContext &ctx,
+                            const std::vector<NDArray> &inputs,
+                            const std::vector<OpReqType> &req,
+                            const std::vector<NDArray> &outputs) {
+  const FullyConnectedParam &param = nnvm::get<FullyConnectedParam>(fc_attrs_.parsed);
+  CHECK_EQ(inputs.size(), param.no_bias ? 2U : 3U);
+  CHECK_EQ(outputs.size(), 1U);
+  if (req[fullc::kOut] == kNullOp) return;
+  std::vector<TBlob> in_blobs;
+  for (const NDArray &input : inputs) in_blobs.push_back(input.data());
+  const std::vector<TBlob> out_blobs{outputs[fullc::kOut].data()};
+
+  const bool supported = Supported(in_blobs, req, out_blobs[fullc::kOut]);
+  const NDArray &weight = inputs[fullc::kWeight];
+  if (supported && (!initialized_ || weight_ver_ != weight.version())) {
+    PrepareWeight(weight);
+  }
+  if (!supported || scaling_ == 0.0f) {
+    CPUFCompute("FullyConnected")(fc_attrs_, ctx, in_blobs, req, out_blobs);
+    return;
+  }
+  std::vector<TBlob> intgemm_in{in_blobs[fullc::kData], cached_weight_.data(),
+                                TBlob(&scaling_, mshadow::Shape1(1), cpu::kDevMask)};
+  if (!param.no_bias) intgemm_in.push_back(in_blobs[fullc::kBias]);
+  CPUFCompute("_contrib_intgemm_fully_connected")(intgemm_attrs_, ctx, intgemm_in,
+                                                  req, out_blobs);
+}
+
+static void SgIntgemmFCParamParser(nnvm::NodeAttrs *attrs) {
+  CHECK_EQ(attrs->subgraphs.size(), 1U);
+  const nnvm::ObjectPtr &fc = attrs->subgraphs[0]->outputs[0].node;
+  CHECK(!fc->is_variable() && fc->op() == Op::Get("FullyConnected"))
+      << "_sg_intgemm_fully_connected expects a FullyConnected subgraph";
+  attrs->parsed = nnvm::get<FullyConnectedParam>(fc->attrs.parsed);
+}
+
+static OpStatePtr CreateSgIntgemmFCState(const nnvm::NodeAttrs &attrs,
+                                         Context ctx,
+                                         const mxnet::ShapeVector &in_shapes,
+                                         const std::vector<int> &in_types) {
+  return OpStatePtr::Create<SgIntgemmFCOp>(attrs);
+}
+
+static void SgIntgemmFCForward(const OpStatePtr &state_pointer,
+                               const OpContext &ctx,
+                               const std::vector<NDArray> &inputs,
+                               const std::vector<OpReqType> &req,
+                               const std::vector<NDArray> &outputs) {
+  SgIntgemmFCOp &op = state_pointer.get_state<SgIntgemmFCOp>();
+  op.Forward(ctx, inputs, req, outputs);
+}
+
+NNVM_REGISTER_OP(_sg_intgemm_fully_connected)
+.describe(R"code(_sg_intgemm_fully_connected)code" ADD_FILELINE)
+.set_num_inputs([](const NodeAttrs& attrs) {
+  return nnvm::get<FullyConnectedParam>(attrs.parsed).no_bias ? 2 : 3;
+})
+.set_num_outputs(1)
+.set_attr_parser(SgIntgemmFCParamParser)
+.set_attr<nnvm::FListInputNames>("FListInputNames", DefaultSubgraphOpListInputs)
+.set_attr<nnvm::FListOutputNames>("FListOutputNames", DefaultSubgraphOpListOutputs)
+.set_attr<mxnet::FInferShape>("FInferShape", DefaultSubgraphOpShape)
+.set_attr<nnvm::FInferType>("FInferType", DefaultSubgraphOpType)
+.set_attr<FInferStorageType>("FInferStorageType", DefaultSubgraphOpStorageType)
+.set_attr<FCreateOpState>("FCreateOpState", CreateSgIntgemmFCState)
+.set_attr<FStatefulComputeEx>("FStatefulComputeEx<cpu>", SgIntgemmFCForward)
+.set_attr<FResourceRequest>("FResourceRequest", [](const NodeAttrs& n) {
+  return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
+})
+.set_attr<nnvm::FMutateInputs>("FMutateInputs", DefaultSubgraphOpMutableInputs);
+
+MXNET_REGISTER_SUBGRAPH_BACKEND(INTGEMM)
+.set_attr("context", Context::CPU());
+
+MXNET_REGISTER_SUBGRAPH_PROPERTY(INTGEMM, SgIntgemmFCProperty);
+
+}  // namespace op
+}  // namespace mxnet
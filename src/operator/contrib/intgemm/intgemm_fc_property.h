@@ -0,0 +1,115 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file intgemm_fc_property.h
+ * \brief Partition graph property rewriting FullyConnected into _sg_intgemm_fully_connected
+ */
+#ifndef MXNET_OPERATOR_CONTRIB_INTGEMM_INTGEMM_FC_PROPERTY_H_
+#define MXNET_OPERATOR_CONTRIB_INTGEMM_INTGEMM_FC_PROPERTY_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "../../nn/fully_connected-inl.h"
+#include "../../subgraph/common.h"
+#include "intgemm/intgemm.h"
+
+namespace mxnet {
+namespace op {
+
+/*!
+ * \brief Whether the shape of a weight (num_hidden, num_input) fits the intgemm tiles.
+ */
+inline bool IntgemmSupportsWeightShape(const mxnet::TShape& shape) {
+  return shape.ndim() == 2 && shape[1] % ::intgemm::Int8::tile_info.b_rows == 0 &&
+         shape[0] % ::intgemm::Int8::tile_info.b_cols == 0;
+}
+
+/*!
+ * \brief Selects single FullyConnected nodes. Without shapes and types every
+ *        FullyConnected is selected, and the op falls back to the float
+ *        computation for the inputs intgemm does not take.
+ */
+class SgIntgemmFCSelector : public SubgraphSelector {
+ public:
+  bool Select(const nnvm::Node &n, const std::shared_ptr<NodeAttr>& node_attr) override {
+    if (n.op() != Op::Get("FullyConnected"))
+      return false;
+    if (!node_attr)
+      return true;
+    const auto &param = nnvm::get<FullyConnectedParam>(n.attrs.parsed);
+    const mxnet::TShape &dshape = node_attr->ishape[fullc::kData];
+    return node_attr->itype[fullc::kData] == mshadow::kFloat32 &&
+           node_attr->itype[fullc::kWeight] == mshadow::kFloat32 &&
+           (!param.flatten || dshape.ndim() == 2) &&
+           IntgemmSupportsWeightShape(node_attr->ishape[fullc::kWeight]);
+  }
+
+  bool SelectInput(const nnvm::Node &n, const nnvm::Node &new_node) override {
+    return false;
+  }
+
+  bool SelectOutput(const nnvm::Node &n, const nnvm::Node &new_node) override {
+    return false;
+  }
+};
+
+class SgIntgemmFCProperty : public SubgraphProperty {
+ public:
+  static SubgraphPropertyPtr Create() {
+    static const std::string &name = "intgemm FullyConnected optimization pass";
+    auto property = std::make_shared<SgIntgemmFCProperty>();
+    property->SetAttr<std::string>("property_name", name);
+    property->SetAttr<bool>("inference_only", true);
+    return property;
+  }
+
+  nnvm::ObjectPtr CreateSubgraphNode(const nnvm::Symbol &sym,
+                                     const int subgraph_id = 0) const override {
+    nnvm::ObjectPtr n = nnvm::Node::Create();
+    nnvm::Symbol new_sym;
+    new_sym.outputs.emplace_back(sym.outputs[0].node);
+    n->attrs.name = "sg_intgemm_fully_connected_" + std::to_string(subgraph_id);
+    n->attrs.op = Op::Get("_sg_intgemm_fully_connected");
+    CHECK(n->attrs.op);
+    n->attrs.subgraphs.emplace_back(std::make_shared<nnvm::Symbol>(new_sym));
+    n->op()->attr_parser(&(n->attrs));
+    return n;
+  }
+
+  SubgraphSelectorPtr CreateSubgraphSelector() const override {
+    return std::make_shared<SgIntgemmFCSelector>();
+  }
+
+  void ConnectSubgraphOutputs(
+      const nnvm::ObjectPtr n,
+      std::vector<nnvm::NodeEntry *> *output_entries) const override {
+    // Connect all extern output entries to output[0]
+    for (size_t i = 0; i < output_entries->size(); ++i) {
+      auto entry_ptr = output_entries->at(i);
+      *entry_ptr = nnvm::NodeEntry{n, entry_ptr->index, 0};
+    }
+  }
+};
+
+}  // namespace op
+}  // namespace mxnet
+
+#endif  // MXNET_OPERATOR_CONTRIB_INTGEMM_INTGEMM_FC_PROPERTY_H_
@@ -107,6 +107,84 @@ void MultiSumSq(const nnvm::NodeAttrs& attrs,
   MultiSumSqRun<xpu>(inputs, p.num_arrays, out_ptr, ctx, p.scale);
 }
 
+struct MultiClipGlobalNormParam : public dmlc::Parameter<MultiClipGlobalNormParam> {
+  int num_arrays;
+  float max_norm;
+  float scale;
+
+  DMLC_DECLARE_PARAMETER(MultiClipGlobalNormParam) {
+    DMLC_DECLARE_FIELD(num_arrays)
+    .describe("number of input arrays.");
+    DMLC_DECLARE_FIELD(max_norm)
+    .describe("Maximum global L2 norm of the scaled arrays");
+    DMLC_DECLARE_FIELD(scale)
+    .set_default(1.0f)
+    .describe("Scaling factor applied to the arrays before the norm is computed, "
+              "e.g. the inverse of the loss scale");
+  }
+};
+
+inline bool MultiClipGlobalNormShape(const NodeAttrs& attrs,
+                                     std::vector<mxnet::TShape>* in_shape,
+                                     std::vector<mxnet::TShape>* out_shape) {
+  const auto &p = dmlc::get<MultiClipGlobalNormParam>(attrs.parsed);
+  CHECK_EQ(in_shape->size(), p.num_arrays);
+  out_shape->resize(p.num_arrays + 2);
+  bool known = true;
+  for (int i = 0; i < p.num_arrays; ++i) {
+    SHAPE_ASSIGN_CHECK(*out_shape, i, (*in_shape)[i]);
+    SHAPE_ASSIGN_CHECK(*in_shape, i, (*out_shape)[i]);
+    known = known && (*in_shape)[i].ndim() != 0;
+  }
+  SHAPE_ASSIGN_CHECK(*out_shape, p.num_arrays, mxnet::TShape(1, 1));
+  SHAPE_ASSIGN_CHECK(*out_shape, p.num_arrays + 1, mxnet::TShape(1, 1));
+  return known;
+}
+
+inline bool MultiClipGlobalNormType(const NodeAttrs& attrs,
+                                    std::vector<int>* in_type,
+                                    std::vector<int>* out_type) {
+  const auto& p = dmlc::get<MultiClipGlobalNormParam>(attrs.parsed);
+  CHECK_EQ(in_type->size(), p.num_arrays);
+  int dtype = (*in_type)[0];
+  CHECK_NE(dtype, -1) << "First input must have specified type";
+  out_type->resize(p.num_arrays + 2);
+  for (int i = 0; i < p.num_arrays; ++i) {
+    if ((*in_type)[i] == -1) {
+      (*in_type)[i] = dtype;
+    } else {
+      UNIFORM_TYPE_CHECK((*in_type)[i], dtype, "array_" + std::to_string(i));
+    }
+    TYPE_ASSIGN_CHECK(*out_type, i, dtype);
+  }
+  TYPE_ASSIGN_CHECK(*out_type, p.num_arrays, mshadow::kFloat32);
+  TYPE_ASSIGN_CHECK(*out_type, p.num_arrays + 1, mshadow::kFloat32);
+  return true;
+}
+
+/*!
+ * \brief Write the arrays scaled by scale and clipped to the global norm max_norm, the
+ *        global norm, and whether it is finite. The arrays are only copied if it is not.
+ */
+template<typename xpu>
+void MultiClipGlobalNormRun(const std::vector<TBlob> &inputs,
+                            const std::vector<TBlob> &outputs,
+                            const MultiClipGlobalNormParam& p, const OpContext &ctx);
+
+template<typename xpu>
+void MultiClipGlobalNorm(const nnvm::NodeAttrs& attrs,
+                         const OpContext &ctx,
+                         const std::vector<TBlob> &inputs,
+                         const std::vector<OpReqType> &req,
+                         const std::vector<TBlob> &outputs) {
+  const auto& p = dmlc::get<MultiClipGlobalNormParam>(attrs.parsed);
+  for (int i = 0; i < p.num_arrays; ++i) {
+    CHECK(req[i] == kWriteTo || req[i] == kWriteInplace)
+      << "multi_clip_global_norm only supports kWriteTo and kWriteInplace";
+  }
+  MultiClipGlobalNormRun<xpu>(inputs, outputs, p, ctx);
+}
+
 }  // namespace op
 }  // namespace mxnet
 
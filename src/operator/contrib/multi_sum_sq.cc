@@ -24,12 +24,17 @@
  * \author Clement Fuji Tsang, Andrei Ivanov, Moises Hernandez, Shuai Zheng
  */
 
+#include <algorithm>
+#include <cmath>
+#include <utility>
 #include "./multi_sum_sq-inl.h"
+#include "../../engine/openmp.h"
 
 namespace mxnet {
 namespace op {
 
 DMLC_REGISTER_PARAMETER(MultiSumSqParam);
+DMLC_REGISTER_PARAMETER(MultiClipGlobalNormParam);
 
 NNVM_REGISTER_OP(multi_sum_sq)
 .describe(R"code(Compute the sums of squares of multiple arrays
@@ -94,5 +99,80 @@ void MultiSumSqRun<cpu>(const std::vector<TBlob> &inputs, int n_inputs,
   )
 }
 
+template<>
+void MultiClipGlobalNormRun<cpu>(const std::vector<TBlob> &inputs,
+                                 const std::vector<TBlob> &outputs,
+                                 const MultiClipGlobalNormParam& p, const OpContext &ctx) {
+  mshadow::Stream<cpu> *s = ctx.get_stream<cpu>();
+  std::vector<float> sums(p.num_arrays);
+  MultiSumSqRun<cpu>(inputs, p.num_arrays, sums.data(), ctx, p.scale);
+  float total = 0;
+  for (float sum : sums) total += sum;
+  const float norm = std::sqrt(total);
+  const bool finite = std::isfinite(norm);
+  const float clip = finite ? p.scale * std::min(1.0f, p.max_norm / (norm + 1e-8f)) : 1.0f;
+  *outputs[p.num_arrays].dptr<float>() = norm;
+  *outputs[p.num_arrays + 1].dptr<float>() = finite ? 1.0f : 0.0f;
+  MSHADOW_REAL_TYPE_SWITCH(inputs[0].type_flag_, DType, {
+    for (int i = 0; i < p.num_arrays; ++i) {
+      const DType* in = inputs[i].FlatTo2D<cpu, DType>(s).dptr_;
+      DType* out = outputs[i].FlatTo2D<cpu, DType>(s).dptr_;
+      const index_t size = inputs[i].shape_.Size();
+      #pragma omp parallel for num_threads(engine::OpenMP::Get()->GetRecommendedOMPThreadCount())
+      for (index_t j = 0; j < size; ++j) {
+        out[j] = static_cast<DType>(static_cast<float>(in[j]) * clip);
+      }
+    }
+  });
+}
+
+NNVM_REGISTER_OP(multi_clip_global_norm)
+.describe(R"code(Scale multiple arrays and clip them to a maximum global L2 norm, in one pass.
+
+The arrays are multiplied by ``scale``, then by ``min(1, max_norm / (norm + 1e-8))``, where
+``norm`` is the L2 norm of all the scaled arrays together. Besides the arrays, it outputs
+``norm`` and whether it is finite, as in ``multi_all_finite``, both as float32 arrays of
+shape (1,) which stay on the device. If the norm is not finite the arrays are left
+unchanged, so that the step can be skipped without reading the norm back on the host.
+
+The arrays are usually the gradients of the parameters, updated in place by passing them
+as ``out`` too, and ``scale`` the inverse of the loss scale of mixed precision training.
+)code" ADD_FILELINE)
+.set_num_inputs([](const nnvm::NodeAttrs& attrs) {
+    return static_cast<uint32_t>(dmlc::get<MultiClipGlobalNormParam>(attrs.parsed).num_arrays);
+  })
+.set_num_outputs([](const nnvm::NodeAttrs& attrs) {
+    return static_cast<uint32_t>(
+        dmlc::get<MultiClipGlobalNormParam>(attrs.parsed).num_arrays + 2);
+  })
+.set_attr_parser(ParamParser<MultiClipGlobalNormParam>)
+.set_attr<mxnet::FInferShape>("FInferShape", MultiClipGlobalNormShape)
+.set_attr<nnvm::FInferType>("FInferType", MultiClipGlobalNormType)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    const uint32_t num_args = dmlc::get<MultiClipGlobalNormParam>(attrs.parsed).num_arrays;
+    std::vector<std::string> ret;
+    for (uint32_t i = 0; i < num_args; ++i) {
+      ret.push_back(std::string("array_") + std::to_string(i));
+    }
+    return ret;
+  })
+.set_attr<nnvm::FInplaceOption>("FInplaceOption",
+  [](const NodeAttrs& attrs) {
+    const int num_args = dmlc::get<MultiClipGlobalNormParam>(attrs.parsed).num_arrays;
+    std::vector<std::pair<int, int> > ret;
+    for (int i = 0; i < num_args; ++i) {
+      ret.emplace_back(i, i);
+    }
+    return ret;
+  })
+.set_attr<FCompute>("FCompute<cpu>", MultiClipGlobalNorm<cpu>)
+.set_attr<FResourceRequest>("FResourceRequest",
+  [](const NodeAttrs& attrs) {
+    return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
+  })
+.add_argument("data", "NDArray-or-Symbol[]", "Arrays")
+.add_arguments(MultiClipGlobalNormParam::__FIELDS__());
+
 }  // namespace op
 }  // namespace mxnet
@@ -25,6 +25,7 @@
  */
 #include "./multi_sum_sq-inl.h"
 #include <cub/cub.cuh>
+#include <algorithm>
 
 #define ILP 4
 #define BLOCK_LIMIT 320
@@ -148,69 +149,163 @@ size_t GetRequiredStorageMultiSumSq<gpu>(const std::vector<TBlob> &inputs,
   return inputs.size() * max_chunks_per_tensor * sizeof(float);
 }
 
+/*!
+ * \brief Launch the kernels writing the sums of squares of the inputs to out_ptr, with
+ *        block_reductions of GetRequiredStorageMultiSumSq bytes as workspace.
+ */
+template<typename DType>
+void MultiSumSqLaunch(const std::vector<TBlob> &inputs, int n_inputs, float *out_ptr,
+                      float *block_reductions, mshadow::Stream<gpu> *s, float scale) {
+  const int block_size = 512;
+  auto stream = mshadow::Stream<gpu>::GetStream(s);
+  MultiSumSqKernelParam<DType> param;
+  GetRequiredStorageMultiSumSq<gpu>(inputs, &param.max_chunks_per_tensor);
+  CUDA_CALL(cudaMemsetAsync(block_reductions, 0,
+                            n_inputs * param.max_chunks_per_tensor* sizeof(float),
+                            stream));
+
+  int loc_block_info = 0;   // position in param.block_to_tensor and param.block_to_chunck
+  int loc_tensor_info = 0;  // position in param.sizes and param.addresses
+  int start_tensor_id = 0;
+  for (int t = 0; t < n_inputs; t++, loc_tensor_info++) {  // array index in inputs
+    param.sizes[loc_tensor_info] = inputs[t].shape_.Size();
+    param.addresses[loc_tensor_info] = inputs[t].FlatTo2D<gpu, DType>(s).dptr_;
+    const int chunks_this_tensor = (inputs[t].shape_.Size() - 1) / chunk_size;
+    for (int chunk = 0; chunk <= chunks_this_tensor; ++chunk) {  // array chunk index
+      param.block_to_tensor[loc_block_info] = loc_tensor_info;
+      param.block_to_chunk[loc_block_info] = chunk;
+      loc_block_info++;
+
+      const bool last_curr_chunk = chunk == chunks_this_tensor;
+      const bool tensors_full = last_curr_chunk && loc_tensor_info == (ARRAY_LIMIT-1);
+      const bool blocks_full = (loc_block_info == BLOCK_LIMIT);
+      const bool last_chunk = last_curr_chunk && t == n_inputs - 1;
+      if (!(tensors_full || blocks_full || last_chunk))
+        continue;
+      MultiSumSqKernel<<<loc_block_info, block_size, 0, stream>>>
+        (chunk_size, param, block_reductions, start_tensor_id, scale);
+      MSHADOW_CUDA_POST_KERNEL_CHECK(MultiSumSqKernel);
+
+      loc_block_info = 0;
+      if (last_curr_chunk) {  // if you start from a new tensor
+        loc_tensor_info = -1;
+        start_tensor_id = t + 1;
+      } else {  // if you start from the same tensor
+        param.sizes[0] = param.sizes[loc_tensor_info];
+        param.addresses[0] = param.addresses[loc_tensor_info];
+        loc_tensor_info = 0;
+        start_tensor_id = t;
+      }
+    }
+  }
+  // Global reduction
+  GlobalReductionKernel<<<n_inputs, block_size, 0, stream>>>
+    (param, block_reductions, out_ptr);
+}
+
 template<>
 void MultiSumSqRun<gpu>(const std::vector<TBlob> &inputs, int n_inputs,
                         float *out_ptr, const OpContext &ctx, float scale) {
-  const int block_size = 512;
   using namespace mxnet_op;
   auto s = ctx.get_stream<gpu>();
-  auto stream = mshadow::Stream<gpu>::GetStream(s);
+  size_t workspace_size = GetRequiredStorageMultiSumSq<gpu>(inputs);
+  Tensor<gpu, 1, char> workspace =
+    ctx.requested[multi_sum_sq::kTempSpace].get_space_typed<gpu, 1, char>(
+      Shape1(workspace_size), s);
+  MSHADOW_REAL_TYPE_SWITCH(inputs[0].type_flag_, DType, {
+    MultiSumSqLaunch<DType>(inputs, n_inputs, out_ptr,
+                            reinterpret_cast<float*>(workspace.dptr_), s, scale);
+  });
+}
 
+/*!
+ * \brief Reduce the sums of squares of the arrays to their global norm, whether it is
+ *        finite, and the factor the arrays are multiplied by.
+ */
+__global__ void ClipGlobalNormKernel(const float* sums, int n_inputs, float max_norm,
+                                     float scale, float* norm, float* finite, float* clip) {
+  __shared__ float vals[512];
+  float val = 0;
+  for (int i = threadIdx.x; i < n_inputs; i += blockDim.x)
+    val += sums[i];
+  const float total = ReduceBlockIntoLanes(vals, val);
+  if (threadIdx.x == 0) {
+    const float n = sqrtf(total);
+    const bool is_finite = isfinite(n);
+    *norm = n;
+    *finite = is_finite ? 1.0f : 0.0f;
+    *clip = is_finite ? scale * fminf(1.0f, max_norm / (n + 1e-8f)) : 1.0f;
+  }
+}
+
+template <typename DType>
+struct MultiScaleKernelParam {
+  const DType* inputs[ARRAY_LIMIT];
+  DType* outputs[ARRAY_LIMIT];
+  int sizes[ARRAY_LIMIT];
+};
+
+/*! \brief Multiply the arrays by the factor on the device, one array per blockIdx.y */
+template<typename DType>
+__global__ void MultiScaleKernel(MultiScaleKernelParam<DType> param, const float* clip) {
+  const int t = blockIdx.y;
+  const float factor = *clip;
+  const DType* in = param.inputs[t];
+  DType* out = param.outputs[t];
+  for (int i = blockIdx.x * blockDim.x + threadIdx.x; i < param.sizes[t];
+       i += blockDim.x * gridDim.x) {
+    out[i] = static_cast<DType>(static_cast<float>(in[i]) * factor);
+  }
+}
+
+template<>
+void MultiClipGlobalNormRun<gpu>(const std::vector<TBlob> &inputs,
+                                 const std::vector<TBlob> &outputs,
+                                 const MultiClipGlobalNormParam& p, const OpContext &ctx) {
+  using namespace mxnet_op;
+  const int block_size = 256;
+  const int max_blocks = 1024;
+  auto s = ctx.get_stream<gpu>();
+  auto stream = mshadow::Stream<gpu>::GetStream(s);
+  // the sums of squares of the arrays, the clip factor, then the workspace of the sums
+  const size_t sums_size = p.num_arrays + 1;
+  const size_t workspace_size = sums_size * sizeof(float) +
+                                GetRequiredStorageMultiSumSq<gpu>(inputs);
+  Tensor<gpu, 1, char> workspace =
+    ctx.requested[multi_sum_sq::kTempSpace].get_space_typed<gpu, 1, char>(
+      Shape1(workspace_size), s);
+  float* sums = reinterpret_cast<float*>(workspace.dptr_);
+  float* clip = sums + p.num_arrays;
   MSHADOW_REAL_TYPE_SWITCH(inputs[0].type_flag_, DType, {
-    MultiSumSqKernelParam<DType> param;
-    size_t workspace_size = GetRequiredStorageMultiSumSq<gpu>(inputs,
-                                                              &param.max_chunks_per_tensor);
-    Tensor<gpu, 1, char> workspace =
-      ctx.requested[multi_sum_sq::kTempSpace].get_space_typed<gpu, 1, char>(
-        Shape1(workspace_size), s);
-    Tensor<gpu, 1, float> block_reductions(reinterpret_cast<float*>(&workspace[0]),
-      Shape1(n_inputs * param.max_chunks_per_tensor), s);
-    CUDA_CALL(cudaMemsetAsync(block_reductions.dptr_, 0,
-                              n_inputs * param.max_chunks_per_tensor* sizeof(float),
-                              stream));
-
-    int loc_block_info = 0;   // position in param.block_to_tensor and param.block_to_chunck
-    int loc_tensor_info = 0;  // position in param.sizes and param.addresses
-    int start_tensor_id = 0;
-    for (int t = 0; t < n_inputs; t++, loc_tensor_info++) {  // array index in inputs
-      param.sizes[loc_tensor_info] = inputs[t].shape_.Size();
-      param.addresses[loc_tensor_info] = inputs[t].FlatTo2D<gpu, DType>(s).dptr_;
-      const int chunks_this_tensor = (inputs[t].shape_.Size() - 1) / chunk_size;
-      for (int chunk = 0; chunk <= chunks_this_tensor; ++chunk) {  // array chunk index
-        param.block_to_tensor[loc_block_info] = loc_tensor_info;
-        param.block_to_chunk[loc_block_info] = chunk;
-        loc_block_info++;
-
-        const bool last_curr_chunk = chunk == chunks_this_tensor;
-        const bool tensors_full = last_curr_chunk && loc_tensor_info == (ARRAY_LIMIT-1);
-        const bool blocks_full = (loc_block_info == BLOCK_LIMIT);
-        const bool last_chunk = last_curr_chunk && t == n_inputs - 1;
-        if (!(tensors_full || blocks_full || last_chunk))
-          continue;
-        MultiSumSqKernel<<<loc_block_info, block_size, 0, stream>>>
-          (chunk_size, param, block_reductions.dptr_, start_tensor_id, scale);
-        MSHADOW_CUDA_POST_KERNEL_CHECK(MultiSumSqKernel);
-
-        loc_block_info = 0;
-        if (last_curr_chunk) {  // if you start from a new tensor
-          loc_tensor_info = -1;
-          start_tensor_id = t + 1;
-        } else {  // if you start from the same tensor
-          param.sizes[0] = param.sizes[loc_tensor_info];
-          param.addresses[0] = param.addresses[loc_tensor_info];
-          loc_tensor_info = 0;
-          start_tensor_id = t;
-        }
+    MultiSumSqLaunch<DType>(inputs, p.num_arrays, sums, sums + sums_size, s, p.scale);
+    ClipGlobalNormKernel<<<1, 512, 0, stream>>>(sums, p.num_arrays, p.max_norm, p.scale,
+                                                outputs[p.num_arrays].dptr<float>(),
+                                                outputs[p.num_arrays + 1].dptr<float>(),
+                                                clip);
+    MSHADOW_CUDA_POST_KERNEL_CHECK(ClipGlobalNormKernel);
+    for (int start = 0; start < p.num_arrays; start += ARRAY_LIMIT) {
+      const int count = std::min(p.num_arrays - start, ARRAY_LIMIT);
+      MultiScaleKernelParam<DType> param;
+      int max_size = 0;
+      for (int t = 0; t < count; ++t) {
+        param.inputs[t] = inputs[start + t].dptr<DType>();
+        param.outputs[t] = outputs[start + t].dptr<DType>();
+        param.sizes[t] = inputs[start + t].shape_.Size();
+        max_size = std::max(max_size, param.sizes[t]);
       }
+      const int blocks = std::max(1, std::min(max_blocks,
+                                              (max_size + block_size - 1) / block_size));
+      MultiScaleKernel<<<dim3(blocks, count), block_size, 0, stream>>>(param, clip);
+      MSHADOW_CUDA_POST_KERNEL_CHECK(MultiScaleKernel);
     }
-    // Global reduction
-    GlobalReductionKernel<<<n_inputs, block_size, 0, stream>>>
-      (param, block_reductions.dptr_, out_ptr);
   });
 }
 
 NNVM_REGISTER_OP(multi_sum_sq)
 .set_attr<FCompute>("FCompute<gpu>", MultiSumSq<gpu>);
 
+NNVM_REGISTER_OP(multi_clip_global_norm)
+.set_attr<FCompute>("FCompute<gpu>", MultiClipGlobalNorm<gpu>);
+
 }  // namespace op
 }  // namespace mxnet
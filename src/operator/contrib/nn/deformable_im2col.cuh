@@ -226,13 +226,16 @@ __global__ void deformable_im2col_gpu_kernel(const index_t n, const DType* data_
                                              const index_t stride_h, const index_t stride_w,
                                              const index_t dilation_h, const index_t dilation_w,
                                              const index_t channel_per_group,
+                                             const index_t batch_size, const index_t num_channels,
+                                             const index_t deformable_group,
                                              const index_t height_col, const index_t width_col,
                                              DType* data_col) {
   CUDA_KERNEL_LOOP(index, n) {
     // index index of output matrix
     const index_t w_col = index % width_col;
     const index_t h_col = (index / width_col) % height_col;
-    const index_t c_im = (index / width_col) / height_col;
+    const index_t b_col = (index / width_col / height_col) % batch_size;
+    const index_t c_im = (index / width_col / height_col) / batch_size;
     const index_t c_col = c_im * kernel_h * kernel_w;
 
     const index_t group_index = c_im / channel_per_group;
@@ -240,9 +243,13 @@ __global__ void deformable_im2col_gpu_kernel(const index_t n, const DType* data_
 
     const index_t h_in = h_col * stride_h - pad_h;
     const index_t w_in = w_col * stride_w - pad_w;
-    DType* data_col_ptr = data_col + (c_col * height_col + h_col) * width_col + w_col;
-    const DType* data_im_ptr = data_im + (c_im * height + h_in) * width + w_in;
-    const DType* data_offset_ptr = data_offset + group_index * group_offset_step;
+    // the rows of the column buffer hold the images of the batch one after the other
+    DType* data_col_ptr = data_col +
+      ((c_col * batch_size + b_col) * height_col + h_col) * width_col + w_col;
+    const DType* data_im_ptr = data_im + ((b_col * num_channels + c_im) * height + h_in) * width
+      + w_in;
+    const DType* data_offset_ptr = data_offset +
+      (b_col * deformable_group + group_index) * group_offset_step;
 
 
     for (index_t i = 0; i < kernel_h; ++i) {
@@ -263,7 +270,7 @@ __global__ void deformable_im2col_gpu_kernel(const index_t n, const DType* data_
           val = deformable_im2col_bilinear(data_im_ptr, width, cur_height, cur_width, map_h, map_w);
         }
         *data_col_ptr = val;
-        data_col_ptr += height_col * width_col;
+        data_col_ptr += batch_size * height_col * width_col;
       }
     }
   }
@@ -273,10 +280,11 @@ __global__ void deformable_im2col_gpu_kernel(const index_t n, const DType* data_
 /*!\brief
  * cpu function of deformable_im2col algorithm
  * \param s device stream
- * \param data_im pointer of an image (C, H, W, ...) in the image batch
- * \param data_offset pointer of offset (C, H, W, ...) in the offset batch
+ * \param data_im pointer of the first image (C, H, W, ...) of the images in the batch
+ * \param data_offset pointer of the offset (C, H, W, ...) of the first image
  * \param im_shape input image shape in dimensions (N, C, H, W,)
- * \param col_shape column buffer shape (#channels, output_im_height, output_im_width, ...)
+ * \param col_shape column buffer shape (#channels, #images, output_im_height,
+ *        output_im_width, ...), the images follow one another in each row
  * \param kernel_shape kernel filter shape
  * \param pad pad shape
  * \param stride stride shape
@@ -312,7 +320,8 @@ inline void deformable_im2col(mshadow::Stream<gpu>* s,
                                                     pad[0], pad[1], stride[0], stride[1],
                                                     dilation[0], dilation[1],
                                                     channel_per_group,
-                                                    col_shape[1], col_shape[2], data_col);
+                                                    col_shape[1], im_shape[1], deformable_group,
+                                                    col_shape[2], col_shape[3], data_col);
     MSHADOW_CUDA_POST_KERNEL_CHECK(deformable_im2col_gpu_kernel);
     break;
   default:
@@ -335,12 +344,15 @@ __global__ void deformable_col2im_gpu_kernel(const index_t n, const DType* data_
                                              const index_t stride_h, const index_t stride_w,
                                              const index_t dilation_h, const index_t dilation_w,
                                              const index_t channel_per_group,
+                                             const index_t batch_size,
+                                             const index_t deformable_group,
                                              const index_t height_col, const index_t width_col,
                                              DType* grad_im) {
   CUDA_KERNEL_LOOP(index, n) {
-    const index_t j = (index / width_col / height_col) % kernel_w;
-    const index_t i = (index / width_col / height_col / kernel_w) % kernel_h;
-    const index_t c = index / width_col / height_col / kernel_w / kernel_h;
+    const index_t j = (index / width_col / height_col / batch_size) % kernel_w;
+    const index_t i = (index / width_col / height_col / batch_size / kernel_w) % kernel_h;
+    const index_t c = index / width_col / height_col / batch_size / kernel_w / kernel_h;
+    const index_t b = (index / width_col / height_col) % batch_size;
     // compute the start and end of the output
 
     const index_t group_index = c / channel_per_group;
@@ -351,7 +363,8 @@ __global__ void deformable_col2im_gpu_kernel(const index_t n, const DType* data_
     index_t w_in = w_col * stride_w - pad_w;
     index_t h_in = h_col * stride_h - pad_h;
 
-    const DType* data_offset_ptr = data_offset + group_index * group_offset_step;
+    const DType* data_offset_ptr = data_offset +
+      (b * deformable_group + group_index) * group_offset_step;
     const index_t data_offset_h_ptr = ((2 * (i * kernel_w + j)) *
       height_col + h_col) * width_col + w_col;
     const index_t data_offset_w_ptr = data_offset_h_ptr + height_col * width_col;
@@ -370,7 +383,8 @@ __global__ void deformable_col2im_gpu_kernel(const index_t n, const DType* data_
           abs(cur_inv_h_data - (cur_h + dy)) < 1 &&
           abs(cur_inv_w_data - (cur_w + dx)) < 1
           ) {
-          index_t cur_bottom_grad_pos = (c * height + cur_h + dy) * width + cur_w + dx;
+          index_t cur_bottom_grad_pos =
+            ((b * channels + c) * height + cur_h + dy) * width + cur_w + dx;
           DType weight = get_gradient_weight(cur_inv_h_data, cur_inv_w_data,
                                              cur_h + dy, cur_w + dx, height, width);
           atomicAdd(grad_im + cur_bottom_grad_pos, weight * cur_top_grad);
@@ -385,9 +399,9 @@ __global__ void deformable_col2im_gpu_kernel(const index_t n, const DType* data_
  * gpu function of deformable_col2im algorithm
  * \param s device stream
  * \param data_col start pointer of the column buffer to be filled
- * \param data_offset pointer of offset (C, H, W, ...) in the offset batch
+ * \param data_offset pointer of the offset (C, H, W, ...) of the first image
  * \param im_shape input image shape in dimensions (N, C, H, W,)
- * \param col_shape column buffer shape
+ * \param col_shape column buffer shape (#channels, #images, output_im_height, ...)
  * \param kernel_shape kernel filter shape
  * \param pad pad shape
  * \param stride stride shape
@@ -426,8 +440,8 @@ inline void deformable_col2im(mshadow::Stream<gpu>* s,
                                                kernel_shape[0], kernel_shape[1],
                                                pad[0], pad[1], stride[0], stride[1],
                                                dilation[0], dilation[1],
-                                               channel_per_group,
-                                               col_shape[1], col_shape[2], grad_im);
+                                               channel_per_group, col_shape[1], deformable_group,
+                                               col_shape[2], col_shape[3], grad_im);
     MSHADOW_CUDA_POST_KERNEL_CHECK(deformable_col2im_gpu_kernel);
     break;
   default:
@@ -452,35 +466,40 @@ __global__ void deformable_col2im_coord_gpu_kernel(const index_t n, const DType*
                                                    const index_t stride_h, const index_t stride_w,
                                                    const index_t dilation_h, const index_t dilation_w,
                                                    const index_t channel_per_group,
+                                                   const index_t batch_size,
+                                                   const index_t offset_channels,
+                                                   const index_t deformable_group,
                                                    const index_t height_col, const index_t width_col,
                                                    DType* grad_offset) {
   CUDA_KERNEL_LOOP(index, n) {
     DType val = 0;
     index_t w = index % width_col;
     index_t h = (index / width_col) % height_col;
-    index_t c = index / width_col / height_col;
+    index_t c = (index / width_col / height_col) % offset_channels;
+    index_t b = (index / width_col / height_col) / offset_channels;
     // compute the start and end of the output
 
     const index_t group_index = c / (2 * kernel_h * kernel_w);
-    const index_t group_col_step = channel_per_group * width_col * height_col;
+    const index_t group_col_step = channel_per_group * batch_size * width_col * height_col;
     const index_t group_im_step = channel_per_group / kernel_h / kernel_w * height * width;
     const index_t group_offset_step = 2 * kernel_h * kernel_w * height_col * width_col;
     const index_t col_step = kernel_h * kernel_w;
     const DType* data_col_ptr = data_col + group_index * group_col_step;
-    const DType* data_im_ptr = data_im + group_index * group_im_step;
-    const DType* data_offset_ptr = data_offset + group_index * group_offset_step;
+    const DType* data_im_ptr = data_im + (b * deformable_group + group_index) * group_im_step;
+    const DType* data_offset_ptr = data_offset +
+      (b * deformable_group + group_index) * group_offset_step;
 
     index_t cnt = 0;
     const index_t offset_c = c - group_index * 2 * kernel_h * kernel_w;
 
     for (index_t col_c = (offset_c / 2); col_c < channel_per_group; col_c += col_step) {
-      const index_t col_pos = ((col_c * height_col) + h) * width_col + w;
+      const index_t col_pos = ((col_c * batch_size + b) * height_col + h) * width_col + w;
       const index_t bp_dir = offset_c % 2;
 
-      index_t j = (col_pos / width_col / height_col) % kernel_w;
-      index_t i = (col_pos / width_col / height_col / kernel_w) % kernel_h;
-      index_t w_col = col_pos % width_col;
-      index_t h_col = (col_pos / width_col) % height_col;
+      index_t j = col_c % kernel_w;
+      index_t i = (col_c / kernel_w) % kernel_h;
+      index_t w_col = w;
+      index_t h_col = h;
       index_t w_in = w_col * stride_w - pad_w;
       index_t h_in = h_col * stride_h - pad_h;
       const index_t data_offset_h_ptr = ((2 * (i * kernel_w + j)) *
@@ -509,10 +528,10 @@ __global__ void deformable_col2im_coord_gpu_kernel(const index_t n, const DType*
  * gpu function of deformable_col2im_coord algorithm
  * \param s device stream
  * \param data_col start pointer of the column buffer to be filled
- * \param data_im pointer of an image (C, H, W, ...) in the image batch
- * \param data_offset pointer of offset (C, H, W, ...) in the offset batch
+ * \param data_im pointer of the first image (C, H, W, ...) of the images in the batch
+ * \param data_offset pointer of the offset (C, H, W, ...) of the first image
  * \param im_shape input image shape in dimensions (N, C, H, W,)
- * \param col_shape column buffer shape
+ * \param col_shape column buffer shape (#channels, #images, output_im_height, ...)
  * \param kernel_shape kernel filter shape
  * \param pad pad shape
  * \param stride stride shape
@@ -534,8 +553,8 @@ inline void deformable_col2im_coord(mshadow::Stream<gpu>* s,
                                     const index_t deformable_group,
                                     DType* grad_offset) {
   const int num_spatial_axes = kernel_shape.ndim();
-  index_t num_kernels = col_shape[1] * col_shape[2] * 2 *
-    kernel_shape[0] * kernel_shape[1] * deformable_group;
+  index_t offset_channels = 2 * kernel_shape[0] * kernel_shape[1] * deformable_group;
+  index_t num_kernels = col_shape[1] * offset_channels * col_shape[2] * col_shape[3];
   index_t channel_per_group = col_shape[0] / deformable_group;
   // num_axes should be smaller than block size
   CHECK_LT(num_spatial_axes, mshadow::cuda::kBaseThreadNum);
@@ -552,8 +571,9 @@ inline void deformable_col2im_coord(mshadow::Stream<gpu>* s,
                                                kernel_shape[0], kernel_shape[1],
                                                pad[0], pad[1], stride[0], stride[1],
                                                dilation[0], dilation[1],
-                                               channel_per_group,
-                                               col_shape[1], col_shape[2], grad_offset);
+                                               channel_per_group, col_shape[1], offset_channels,
+                                               deformable_group,
+                                               col_shape[2], col_shape[3], grad_offset);
     MSHADOW_CUDA_POST_KERNEL_CHECK(deformable_col2im_coord_gpu_kernel);
     break;
   default:
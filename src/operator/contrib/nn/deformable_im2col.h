@@ -220,35 +220,41 @@ inline void deformable_im2col_cpu(const DType* data_im,
                                   const index_t pad_h, const index_t pad_w,
                                   const index_t stride_h, const index_t stride_w,
                                   const index_t dilation_h, const index_t dilation_w,
-                                  const index_t deformable_group,
+                                  const index_t deformable_group, const index_t batch_size,
                                   const index_t height_col, const index_t width_col,
                                   DType* data_col) {
   const index_t channel_size = height * width;
-  const index_t offset_size = 2 * kernel_h * kernel_w * height_col * width_col;
+  const index_t col_size = height_col * width_col;
+  const index_t offset_size = 2 * kernel_h * kernel_w * col_size;
   const index_t channel_per_group = channels / deformable_group;
-  for (index_t channel = 0; channel < channels; channel++, data_im += channel_size) {
-    if (channel % channel_per_group == 0 && channel != 0) {
-      data_offset += offset_size;
-    }
-    for (index_t i = 0; i < kernel_h; i++) {
-      for (index_t j = 0; j < kernel_w; j++) {
-        index_t input_row = -pad_h + i * dilation_h;
-        for (index_t h_col = 0; h_col < height_col; h_col++) {
-          index_t input_col = -pad_w + j * dilation_w;
-          for (index_t w_col = 0; w_col < width_col; w_col++) {
-            index_t offset_h_ptr = ((2 * (i * kernel_w + j)) *
-              height_col + h_col) * width_col + w_col;
-            index_t offset_w_ptr = offset_h_ptr + height_col * width_col;
-            DType im_row = input_row + data_offset[offset_h_ptr];
-            DType im_col = input_col + data_offset[offset_w_ptr];
-            if (im_row >= 0 && im_col >= 0 && im_row < height && im_col < width) {
-              *(data_col++) = im2col_bilinear_cpu(data_im, height, width, im_row, im_col);
-            } else {
-              *(data_col++) = 0;
+  for (index_t b = 0; b < batch_size; ++b) {
+    for (index_t channel = 0; channel < channels; ++channel) {
+      const DType* im = data_im + (b * channels + channel) * channel_size;
+      const DType* offset = data_offset +
+        (b * deformable_group + channel / channel_per_group) * offset_size;
+      for (index_t i = 0; i < kernel_h; i++) {
+        for (index_t j = 0; j < kernel_w; j++) {
+          // the rows of the column buffer hold the images of the batch one after the other
+          DType* col = data_col +
+            (((channel * kernel_h + i) * kernel_w + j) * batch_size + b) * col_size;
+          index_t input_row = -pad_h + i * dilation_h;
+          for (index_t h_col = 0; h_col < height_col; h_col++) {
+            index_t input_col = -pad_w + j * dilation_w;
+            for (index_t w_col = 0; w_col < width_col; w_col++) {
+              index_t offset_h_ptr = ((2 * (i * kernel_w + j)) *
+                height_col + h_col) * width_col + w_col;
+              index_t offset_w_ptr = offset_h_ptr + col_size;
+              DType im_row = input_row + offset[offset_h_ptr];
+              DType im_col = input_col + offset[offset_w_ptr];
+              if (im_row >= 0 && im_col >= 0 && im_row < height && im_col < width) {
+                *(col++) = im2col_bilinear_cpu(im, height, width, im_row, im_col);
+              } else {
+                *(col++) = 0;
+              }
+              input_col += stride_w;
             }
-            input_col += stride_w;
+            input_row += stride_h;
           }
-          input_row += stride_h;
         }
       }
     }
@@ -259,10 +265,11 @@ inline void deformable_im2col_cpu(const DType* data_im,
 /*!\brief
  * cpu function of deformable_im2col algorithm
  * \param s device stream
- * \param data_im pointer of an image (C, H, W, ...) in the image batch
- * \param data_offset pointer of offset (C, H, W, ...) in the offset batch
+ * \param data_im pointer of the first image (C, H, W, ...) of the images in the batch
+ * \param data_offset pointer of the offset (C, H, W, ...) of the first image
  * \param im_shape input image shape in dimensions (N, C, H, W,)
- * \param col_shape column buffer shape (#channels, output_im_height, output_im_width, ...)
+ * \param col_shape column buffer shape (#channels, #images, output_im_height,
+ *        output_im_width, ...), the images follow one another in each row
  * \param kernel_shape kernel filter shape
  * \param pad pad shape
  * \param stride stride shape
@@ -288,8 +295,8 @@ inline void deformable_im2col(mshadow::Stream<cpu>* s,
                           pad[0], pad[1],
                           stride[0], stride[1],
                           dilation[0], dilation[1],
-                          deformable_group,
-                          col_shape[1], col_shape[2], data_col);
+                          deformable_group, col_shape[1],
+                          col_shape[2], col_shape[3], data_col);
   } else {
     LOG(FATAL) << "not implemented";
   }
@@ -309,15 +316,16 @@ inline void deformable_col2im_cpu(const DType* data_col,
                                   const index_t pad_h, const index_t pad_w,
                                   const index_t stride_h, const index_t stride_w,
                                   const index_t dilation_h, const index_t dilation_w,
-                                  const index_t deformable_group,
+                                  const index_t deformable_group, const index_t batch_size,
                                   const index_t height_col, const index_t width_col,
                                   DType* grad_im) {
   index_t channel_per_group = channels / deformable_group;
-  index_t count = channels * kernel_h * kernel_w * height_col * width_col;
+  index_t count = channels * kernel_h * kernel_w * batch_size * height_col * width_col;
   for (index_t index = 0; index < count; ++index) {
-    const index_t j = (index / width_col / height_col) % kernel_w;
-    const index_t i = (index / width_col / height_col / kernel_w) % kernel_h;
-    const index_t c = index / width_col / height_col / kernel_w / kernel_h;
+    const index_t j = (index / width_col / height_col / batch_size) % kernel_w;
+    const index_t i = (index / width_col / height_col / batch_size / kernel_w) % kernel_h;
+    const index_t c = index / width_col / height_col / batch_size / kernel_w / kernel_h;
+    const index_t b = (index / width_col / height_col) % batch_size;
     // compute the start and end of the output
 
     const index_t group_index = c / channel_per_group;
@@ -328,7 +336,8 @@ inline void deformable_col2im_cpu(const DType* data_col,
     index_t w_in = w_col * stride_w - pad_w;
     index_t h_in = h_col * stride_h - pad_h;
 
-    const DType* data_offset_ptr = data_offset + group_index * group_offset_step;
+    const DType* data_offset_ptr = data_offset +
+      (b * deformable_group + group_index) * group_offset_step;
     const index_t data_offset_h_ptr = ((2 * (i * kernel_w + j)) *
       height_col + h_col) * width_col + w_col;
     const index_t data_offset_w_ptr = data_offset_h_ptr + height_col * width_col;
@@ -347,7 +356,8 @@ inline void deformable_col2im_cpu(const DType* data_col,
           std::abs(cur_inv_h_data - (cur_h + dy)) < 1 &&
           std::abs(cur_inv_w_data - (cur_w + dx)) < 1
           ) {
-          index_t cur_bottom_grad_pos = (c * height + cur_h + dy) * width + cur_w + dx;
+          index_t cur_bottom_grad_pos =
+            ((b * channels + c) * height + cur_h + dy) * width + cur_w + dx;
           DType weight = get_gradient_weight_cpu(cur_inv_h_data, cur_inv_w_data,
                                                  cur_h + dy, cur_w + dx, height, width);
           grad_im[cur_bottom_grad_pos] += weight * cur_top_grad;
@@ -362,9 +372,9 @@ inline void deformable_col2im_cpu(const DType* data_col,
  * cpu function of deformable_col2im algorithm
  * \param s device stream
  * \param data_col start pointer of the column buffer to be filled
- * \param data_offset pointer of offset (C, H, W, ...) in the offset batch
+ * \param data_offset pointer of the offset (C, H, W, ...) of the first image
  * \param im_shape input image shape in dimensions (N, C, H, W,)
- * \param col_shape column buffer shape
+ * \param col_shape column buffer shape (#channels, #images, output_im_height, ...)
  * \param kernel_shape kernel filter shape
  * \param pad pad shape
  * \param stride stride shape
@@ -390,8 +400,8 @@ inline void deformable_col2im(mshadow::Stream<cpu>* s,
                           kernel_shape[0], kernel_shape[1],
                           pad[0], pad[1], stride[0], stride[1],
                           dilation[0], dilation[1],
-                          deformable_group,
-                          col_shape[1], col_shape[2], grad_im);
+                          deformable_group, col_shape[1],
+                          col_shape[2], col_shape[3], grad_im);
   } else {
     LOG(FATAL) << "not implemented";
   }
@@ -414,37 +424,41 @@ inline void deformable_col2im_coord_cpu(const DType* data_col,
                                         const index_t stride_h, const index_t stride_w,
                                         const index_t dilation_h, const index_t dilation_w,
                                         const index_t deformable_group,
+                                        const index_t batch_size,
                                         const index_t height_col, const index_t width_col,
                                         DType* grad_offset) {
   index_t channel_per_group = channels * kernel_h * kernel_w / deformable_group;
-  index_t count = height_col * width_col * 2 * kernel_h * kernel_w * deformable_group;
+  index_t offset_channels = 2 * kernel_h * kernel_w * deformable_group;
+  index_t count = batch_size * offset_channels * height_col * width_col;
   for (index_t index = 0; index < count; ++index) {
     DType val = 0;
     index_t w = index % width_col;
     index_t h = (index / width_col) % height_col;
-    index_t c = index / width_col / height_col;
+    index_t c = (index / width_col / height_col) % offset_channels;
+    index_t b = index / width_col / height_col / offset_channels;
     // compute the start and end of the output
 
     const index_t group_index = c / (2 * kernel_h * kernel_w);
-    const index_t group_col_step = channel_per_group * width_col * height_col;
+    const index_t group_col_step = channel_per_group * batch_size * width_col * height_col;
     const index_t group_im_step = channel_per_group / kernel_h / kernel_w * height * width;
     const index_t group_offset_step = 2 * kernel_h * kernel_w * height_col * width_col;
     const index_t col_step = kernel_h * kernel_w;
     const DType* data_col_ptr = data_col + group_index * group_col_step;
-    const DType* data_im_ptr = data_im + group_index * group_im_step;
-    const DType* data_offset_ptr = data_offset + group_index * group_offset_step;
+    const DType* data_im_ptr = data_im + (b * deformable_group + group_index) * group_im_step;
+    const DType* data_offset_ptr = data_offset +
+      (b * deformable_group + group_index) * group_offset_step;
 
     index_t cnt = 0;
     const index_t offset_c = c - group_index * 2 * kernel_h * kernel_w;
 
     for (index_t col_c = (offset_c / 2); col_c < channel_per_group; col_c += col_step) {
-      const index_t col_pos = ((col_c * height_col) + h) * width_col + w;
+      const index_t col_pos = ((col_c * batch_size + b) * height_col + h) * width_col + w;
       const index_t bp_dir = offset_c % 2;
 
-      index_t j = (col_pos / width_col / height_col) % kernel_w;
-      index_t i = (col_pos / width_col / height_col / kernel_w) % kernel_h;
-      index_t w_col = col_pos % width_col;
-      index_t h_col = (col_pos / width_col) % height_col;
+      index_t j = col_c % kernel_w;
+      index_t i = (col_c / kernel_w) % kernel_h;
+      index_t w_col = w;
+      index_t h_col = h;
       index_t w_in = w_col * stride_w - pad_w;
       index_t h_in = h_col * stride_h - pad_h;
       const index_t data_offset_h_ptr = ((2 * (i * kernel_w + j)) *
@@ -473,10 +487,10 @@ inline void deformable_col2im_coord_cpu(const DType* data_col,
  * cpu function of deformable_col2im_coord algorithm
  * \param s device stream
  * \param data_col start pointer of the column buffer to be filled
- * \param data_im pointer of an image (C, H, W, ...) in the image batch
- * \param data_offset pointer of offset (C, H, W, ...) in the offset batch
+ * \param data_im pointer of the first image (C, H, W, ...) of the images in the batch
+ * \param data_offset pointer of the offset (C, H, W, ...) of the first image
  * \param im_shape input image shape in dimensions (N, C, H, W,)
- * \param col_shape column buffer shape
+ * \param col_shape column buffer shape (#channels, #images, output_im_height, ...)
  * \param kernel_shape kernel filter shape
  * \param pad pad shape
  * \param stride stride shape
@@ -503,8 +517,8 @@ inline void deformable_col2im_coord(mshadow::Stream<cpu>* s,
                                 kernel_shape[0], kernel_shape[1],
                                 pad[0], pad[1], stride[0], stride[1],
                                 dilation[0], dilation[1],
-                                deformable_group,
-                                col_shape[1], col_shape[2], grad_offset);
+                                deformable_group, col_shape[1],
+                                col_shape[2], col_shape[3], grad_offset);
   } else {
     LOG(FATAL) << "not implemented";
   }
@@ -136,7 +136,7 @@ inline void PSROIPoolForward(const Tensor<cpu, 4, DType> &out,
 
 template <typename DType>
  inline void PSROIPoolBackwardAccCPU(
-  const int count,
+  const int /*count*/,
   const DType* top_diff,
   const int num_rois,
   const DType spatial_scale,
@@ -147,56 +147,76 @@ template <typename DType>
   const int output_dim,
   DType* bottom_diff,
   const DType* bottom_rois) {
-  for (int index = 0; index < count; index++) {
-    // The output is in order (n, ctop, ph, pw)
-    int pw = index % pooled_width;
-    int ph = (index / pooled_width) % pooled_height;
-    int ctop = (index / pooled_width / pooled_height) % output_dim;
-    int n = index / pooled_width / pooled_height / output_dim;
+  // group bins of the pooled bins
+  std::vector<int> group_h(pooled_height), group_w(pooled_width);
+  for (int ph = 0; ph < pooled_height; ++ph) {
+    int gh = floor(static_cast<DType>(ph)* group_size / pooled_height);
+    group_h[ph] = min(max(gh, 0), group_size - 1);
+  }
+  for (int pw = 0; pw < pooled_width; ++pw) {
+    int gw = floor(static_cast<DType>(pw)* group_size / pooled_width);
+    group_w[pw] = min(max(gw, 0), group_size - 1);
+  }
+  // Every bottom channel c = (ctop*group_size + gh)*group_size + gw is accumulated by one
+  // thread, over all the ROIs, so that neither atomics nor per thread copies of bottom_diff
+  // are needed.
+  const int omp_threads = mxnet::engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  const int bottom_channels = output_dim * group_size * group_size;
+#pragma omp parallel for num_threads(omp_threads)
+  for (int c = 0; c < bottom_channels; c++) {
+    int gw = c % group_size;
+    int gh = (c / group_size) % group_size;
+    int ctop = c / group_size / group_size;
+    for (int n = 0; n < num_rois; n++) {
+      // [start, end) interval for spatial sampling
+      const DType* offset_bottom_rois = bottom_rois + n * 5;
+      int roi_batch_ind = offset_bottom_rois[0];
+      DType roi_start_w = static_cast<DType>(round(offset_bottom_rois[1])) * spatial_scale;
+      DType roi_start_h = static_cast<DType>(round(offset_bottom_rois[2])) * spatial_scale;
+      DType roi_end_w = static_cast<DType>(round(offset_bottom_rois[3]) + 1.) * spatial_scale;
+      DType roi_end_h = static_cast<DType>(round(offset_bottom_rois[4]) + 1.) * spatial_scale;
 
-    // [start, end) interval for spatial sampling
-    const DType* offset_bottom_rois = bottom_rois + n * 5;
-    int roi_batch_ind = offset_bottom_rois[0];
-    DType roi_start_w = static_cast<DType>(round(offset_bottom_rois[1])) * spatial_scale;
-    DType roi_start_h = static_cast<DType>(round(offset_bottom_rois[2])) * spatial_scale;
-    DType roi_end_w = static_cast<DType>(round(offset_bottom_rois[3]) + 1.) * spatial_scale;
-    DType roi_end_h = static_cast<DType>(round(offset_bottom_rois[4]) + 1.) * spatial_scale;
+      // Force too small ROIs to be 1x1
+      DType roi_width = max(roi_end_w - roi_start_w, static_cast<DType>(0.1));  // avoid 0
+      DType roi_height = max(roi_end_h - roi_start_h, static_cast<DType>(0.1));
 
-    // Force too small ROIs to be 1x1
-    DType roi_width = max(roi_end_w - roi_start_w, static_cast<DType>(0.1));  // avoid 0
-    DType roi_height = max(roi_end_h - roi_start_h, static_cast<DType>(0.1));
+      // Compute w and h at bottom
+      DType bin_size_h = roi_height / static_cast<DType>(pooled_height);
+      DType bin_size_w = roi_width / static_cast<DType>(pooled_width);
 
-    // Compute w and h at bottom
-    DType bin_size_h = roi_height / static_cast<DType>(pooled_height);
-    DType bin_size_w = roi_width / static_cast<DType>(pooled_width);
-
-    int hstart = floor(static_cast<DType>(ph)* bin_size_h
-      + roi_start_h);
-    int wstart = floor(static_cast<DType>(pw)* bin_size_w
-      + roi_start_w);
-    int hend = ceil(static_cast<DType>(ph + 1) * bin_size_h
-      + roi_start_h);
-    int wend = ceil(static_cast<DType>(pw + 1) * bin_size_w
-      + roi_start_w);
-    // Add roi offsets and clip to input boundaries
-    hstart = min(max(hstart, 0), height);
-    hend = min(max(hend, 0), height);
-    wstart = min(max(wstart, 0), width);
-    wend = min(max(wend, 0), width);
-    bool is_empty = (hend <= hstart) || (wend <= wstart);
-    // Compute c at bottom
-    int gw = floor(static_cast<DType>(pw)* group_size / pooled_width);
-    int gh = floor(static_cast<DType>(ph)* group_size / pooled_height);
-    gw = min(max(gw, 0), group_size - 1);
-    gh = min(max(gh, 0), group_size - 1);
-    int c = (ctop*group_size + gh)*group_size + gw;
-    DType* offset_bottom_diff = bottom_diff + (roi_batch_ind * channels + c) * height * width;
-    DType bin_area = (hend - hstart)*(wend - wstart);
-    DType diff_val = is_empty ? (DType)0. : top_diff[index] / bin_area;
-    for (int h = hstart; h < hend; ++h) {
-      for (int w = wstart; w < wend; ++w) {
-        int bottom_index = h*width + w;
-        *(offset_bottom_diff + bottom_index) = *(offset_bottom_diff + bottom_index) + diff_val;
+      DType* offset_bottom_diff = bottom_diff + (roi_batch_ind * channels + c) * height * width;
+      // The output is in order (n, ctop, ph, pw)
+      const DType* offset_top_diff = top_diff + (n * output_dim + ctop) * pooled_height
+        * pooled_width;
+      for (int ph = 0; ph < pooled_height; ++ph) {
+        if (group_h[ph] != gh) continue;
+        for (int pw = 0; pw < pooled_width; ++pw) {
+          if (group_w[pw] != gw) continue;
+          int hstart = floor(static_cast<DType>(ph)* bin_size_h
+            + roi_start_h);
+          int wstart = floor(static_cast<DType>(pw)* bin_size_w
+            + roi_start_w);
+          int hend = ceil(static_cast<DType>(ph + 1) * bin_size_h
+            + roi_start_h);
+          int wend = ceil(static_cast<DType>(pw + 1) * bin_size_w
+            + roi_start_w);
+          // Add roi offsets and clip to input boundaries
+          hstart = min(max(hstart, 0), height);
+          hend = min(max(hend, 0), height);
+          wstart = min(max(wstart, 0), width);
+          wend = min(max(wend, 0), width);
+          bool is_empty = (hend <= hstart) || (wend <= wstart);
+          DType bin_area = (hend - hstart)*(wend - wstart);
+          DType diff_val = is_empty ? (DType)0. :
+            offset_top_diff[ph * pooled_width + pw] / bin_area;
+          for (int h = hstart; h < hend; ++h) {
+            for (int w = wstart; w < wend; ++w) {
+              int bottom_index = h*width + w;
+              *(offset_bottom_diff + bottom_index) = *(offset_bottom_diff + bottom_index)
+                + diff_val;
+            }
+          }
+        }
       }
     }
   }
@@ -24,6 +24,7 @@
  * Adapted from Caffe2
 */
 #include "./roi_align-inl.h"
+#include <algorithm>
 
 
 namespace mxnet {
@@ -55,7 +56,7 @@ void pre_calc_for_bilinear_interpolate(
     T bin_size_w,
     int roi_bin_grid_h,
     int roi_bin_grid_w,
-    std::vector<PreCalc<T>>* pre_calc) {
+    PreCalc<T>* pre_calc) {
   int pre_calc_index = 0;
   for (int ph = 0; ph < pooled_height; ph++) {
     for (int pw = 0; pw < pooled_width; pw++) {
@@ -82,7 +83,7 @@ void pre_calc_for_bilinear_interpolate(
             pc.w2 = 0;
             pc.w3 = 0;
             pc.w4 = 0;
-            pre_calc->at(pre_calc_index) = pc;
+            pre_calc[pre_calc_index] = pc;
             pre_calc_index += 1;
             continue;
           }
@@ -128,7 +129,7 @@ void pre_calc_for_bilinear_interpolate(
           pc.w2 = w2;
           pc.w3 = w3;
           pc.w4 = w4;
-          pre_calc->at(pre_calc_index) = pc;
+          pre_calc[pre_calc_index] = pc;
 
           pre_calc_index += 1;
         }
@@ -169,7 +170,8 @@ num_threads(engine::OpenMP::Get()->GetRecommendedOMPThreadCount())
     if (roi_cols == 5) {
       roi_batch_ind = offset_bottom_rois[0];
       if (roi_batch_ind < 0) {
-        top_data[n] = 0;
+        std::fill(top_data + index_n,
+                  top_data + index_n + channels * pooled_width * pooled_height, T(0));
         continue;
       }
       offset_bottom_rois++;
@@ -222,7 +224,7 @@ num_threads(engine::OpenMP::Get()->GetRecommendedOMPThreadCount())
         bin_size_w,
         roi_bin_grid_h,
         roi_bin_grid_w,
-        &pre_calc);
+        pre_calc.data());
 
     for (int c = 0; c < channels; c++) {
       int index_n_c = index_n + c * pooled_width * pooled_height;
@@ -263,72 +265,31 @@ num_threads(engine::OpenMP::Get()->GetRecommendedOMPThreadCount())
 }
 
 
-template <typename T>
-void bilinear_interpolate_gradient(
-    const int height,
-    const int width,
-    T y,
-    T x,
-    T* w1,
-    T* w2,
-    T* w3,
-    T* w4,
-    int* x_low,
-    int* x_high,
-    int* y_low,
-    int* y_high,
-    const int /*index*/ /* index for debug only*/) {
-  // deal with cases that inverse elements are out of feature map boundary
-  if (y < -1.0 || y > height || x < -1.0 || x > width) {
-    // empty
-    *w1 = *w2 = *w3 = *w4 = 0.;
-    *x_low = *x_high = *y_low = *y_high = -1;
-    return;
-  }
-
-  if (y <= 0) {
-    y = 0;
-  }
-  if (x <= 0) {
-    x = 0;
-  }
-
-  *y_low = static_cast<int>(y);
-  *x_low = static_cast<int>(x);
-
-  if (*y_low >= height - 1) {
-    *y_high = *y_low = height - 1;
-    y = (T)*y_low;
-  } else {
-    *y_high = *y_low + 1;
-  }
-
-  if (*x_low >= width - 1) {
-    *x_high = *x_low = width - 1;
-    x = (T)*x_low;
-  } else {
-    *x_high = *x_low + 1;
-  }
-
-  T ly = y - *y_low;
-  T lx = x - *x_low;
-  T hy = 1. - ly, hx = 1. - lx;
-
-  *w1 = hy * hx, *w2 = hy * lx, *w3 = ly * hx, *w4 = ly * lx;
-
-  return;
-}
-
 template <class T>
 inline void add(const T& val, T* address) {
   *address += val;
 }
 
+/*! \brief sampling grid of a ROI, batch_ind is -1 for the ROIs ignored */
+template <typename T>
+struct ROIGrid {
+  int batch_ind;
+  T start_h;
+  T start_w;
+  T bin_size_h;
+  T bin_size_w;
+  int grid_h;
+  int grid_w;
+};
+
+/*! \brief bilinear weights precalculated at once for the ROIs of a chunk of backward */
+constexpr size_t kROIAlignPreCalcChunk = 1 << 18;
+
 template <typename T>
 void ROIAlignBackward(
-    const int nthreads,
+    const int /*nthreads*/,
     const T* top_diff,
-    const int /*num_rois*/,
+    const int num_rois,
     const T& spatial_scale,
     const bool position_sensitive,
     const bool continuous_coordinate,
@@ -342,21 +303,25 @@ void ROIAlignBackward(
     const T* bottom_rois,
     int rois_cols) {
   DCHECK(rois_cols == 4 || rois_cols == 5);
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  const int pooled_size = pooled_height * pooled_width;
 
-  for (int index = 0; index < nthreads; index++) {
-    // (n, c, ph, pw) is an element in the pooled output
-    int pw = index % pooled_width;
-    int ph = (index / pooled_width) % pooled_height;
-    int c = (index / pooled_width / pooled_height) % channels;
-    int n = index / pooled_width / pooled_height / channels;
-
+  std::vector<ROIGrid<T>> grids(num_rois);
+  // offsets of the bilinear weights of the ROIs
+  std::vector<size_t> offsets(num_rois + 1, 0);
+  for (int n = 0; n < num_rois; n++) {
     const T* offset_bottom_rois = bottom_rois + n * rois_cols;
-    int roi_batch_ind = 0;
+    ROIGrid<T>& grid = grids[n];
+    grid.batch_ind = 0;
     if (rois_cols == 5) {
-      roi_batch_ind = offset_bottom_rois[0];
-      if (roi_batch_ind < 0) continue;
+      grid.batch_ind = offset_bottom_rois[0];
       offset_bottom_rois++;
     }
+    if (grid.batch_ind < 0) {
+      grid.batch_ind = -1;
+      offsets[n + 1] = offsets[n];
+      continue;
+    }
 
     // Do not using rounding; this implementation detail is critical
     T roi_offset = continuous_coordinate ? static_cast<T>(0.5) : static_cast<T>(0);
@@ -372,75 +337,88 @@ void ROIAlignBackward(
       roi_width = std::max(roi_width, (T)1.);
       roi_height = std::max(roi_height, (T)1.);
     }
-    T bin_size_h = static_cast<T>(roi_height) / static_cast<T>(pooled_height);
-    T bin_size_w = static_cast<T>(roi_width) / static_cast<T>(pooled_width);
-
-    int c_unpooled = c;
-    int channels_unpooled = channels;
-    if (position_sensitive) {
-      c_unpooled = c * pooled_height * pooled_width + ph * pooled_width + pw;
-      channels_unpooled = channels * pooled_height * pooled_width;
-    }
-    T* offset_bottom_diff =
-        bottom_diff + (roi_batch_ind * channels_unpooled + c_unpooled)
-        * height * width;
-
-    int top_offset = (n * channels + c) * pooled_height * pooled_width;
-    const T* offset_top_diff = top_diff + top_offset;
-    const T top_diff_this_bin = offset_top_diff[ph * pooled_width + pw];
+    grid.start_h = roi_start_h;
+    grid.start_w = roi_start_w;
+    grid.bin_size_h = static_cast<T>(roi_height) / static_cast<T>(pooled_height);
+    grid.bin_size_w = static_cast<T>(roi_width) / static_cast<T>(pooled_width);
 
     // We use roi_bin_grid to sample the grid and mimic integral
-    int roi_bin_grid_h = (sampling_ratio > 0)
+    grid.grid_h = (sampling_ratio > 0)
         ? sampling_ratio
         : std::ceil(roi_height / pooled_height);  // e.g., = 2
-    int roi_bin_grid_w =
+    grid.grid_w =
         (sampling_ratio > 0) ? sampling_ratio : std::ceil(roi_width / pooled_width);
+    offsets[n + 1] = offsets[n] + grid.grid_h * grid.grid_w * pooled_size;
+  }
 
-    // We do average (integral) pooling inside a bin
-    const T count = roi_bin_grid_h * roi_bin_grid_w;  // e.g. = 4
+  // Every task owns planes of bottom_diff no other task writes to: an output channel when
+  // the channels are shared by the bins, a bin of an output channel when position
+  // sensitive. The ROIs are accumulated without atomics nor per thread copies of bottom_diff.
+  const int num_tasks = position_sensitive ? channels * pooled_size : channels;
+  std::vector<PreCalc<T>> pre_calc;
+  for (int n_begin = 0; n_begin < num_rois;) {
+    int n_end = n_begin + 1;
+    while (n_end < num_rois && offsets[n_end + 1] - offsets[n_begin] <= kROIAlignPreCalcChunk) {
+      n_end++;
+    }
+    pre_calc.resize(offsets[n_end] - offsets[n_begin]);
+#pragma omp parallel for num_threads(omp_threads)
+    for (int n = n_begin; n < n_end; n++) {
+      const ROIGrid<T>& grid = grids[n];
+      if (grid.batch_ind < 0) continue;
+      pre_calc_for_bilinear_interpolate(
+          height,
+          width,
+          pooled_height,
+          pooled_width,
+          grid.grid_h,
+          grid.grid_w,
+          grid.start_h,
+          grid.start_w,
+          grid.bin_size_h,
+          grid.bin_size_w,
+          grid.grid_h,
+          grid.grid_w,
+          pre_calc.data() + offsets[n] - offsets[n_begin]);
+    }
 
-    for (int iy = 0; iy < roi_bin_grid_h; iy++) {
-      const T y = roi_start_h + ph * bin_size_h +
-          static_cast<T>(iy + .5f) * bin_size_h /
-              static_cast<T>(roi_bin_grid_h);  // e.g., 0.5, 1.5
-      for (int ix = 0; ix < roi_bin_grid_w; ix++) {
-        const T x = roi_start_w + pw * bin_size_w +
-            static_cast<T>(ix + .5f) * bin_size_w /
-                static_cast<T>(roi_bin_grid_w);
-
-        T w1, w2, w3, w4;
-        int x_low, x_high, y_low, y_high;
-
-        bilinear_interpolate_gradient(
-            height,
-            width,
-            y,
-            x,
-            &w1,
-            &w2,
-            &w3,
-            &w4,
-            &x_low,
-            &x_high,
-            &y_low,
-            &y_high,
-            index);
-
-        T g1 = top_diff_this_bin * w1 / count;
-        T g2 = top_diff_this_bin * w2 / count;
-        T g3 = top_diff_this_bin * w3 / count;
-        T g4 = top_diff_this_bin * w4 / count;
-
-        if (x_low >= 0 && x_high >= 0 && y_low >= 0 && y_high >= 0) {
-          // atomic add is not needed for now since it is single threaded
-          add(static_cast<T>(g1), offset_bottom_diff + y_low * width + x_low);
-          add(static_cast<T>(g2), offset_bottom_diff + y_low * width + x_high);
-          add(static_cast<T>(g3), offset_bottom_diff + y_high * width + x_low);
-          add(static_cast<T>(g4), offset_bottom_diff + y_high * width + x_high);
-        }  // if
-      }  // ix
-    }  // iy
-  }  // for
+#pragma omp parallel for num_threads(omp_threads)
+    for (int task = 0; task < num_tasks; task++) {
+      const int c = position_sensitive ? task / pooled_size : task;
+      const int bin_begin = position_sensitive ? task % pooled_size : 0;
+      const int bin_end = position_sensitive ? bin_begin + 1 : pooled_size;
+      for (int n = n_begin; n < n_end; n++) {
+        const ROIGrid<T>& grid = grids[n];
+        if (grid.batch_ind < 0) continue;
+        const int grid_size = grid.grid_h * grid.grid_w;
+        // We do average (integral) pooling inside a bin
+        const T count = grid_size;  // e.g. = 4
+        const T* offset_top_diff = top_diff + (n * channels + c) * pooled_size;
+        for (int bin = bin_begin; bin < bin_end; bin++) {
+          int c_unpooled = c;
+          int channels_unpooled = channels;
+          if (position_sensitive) {
+            c_unpooled = c * pooled_size + bin;
+            channels_unpooled = channels * pooled_size;
+          }
+          T* offset_bottom_diff =
+              bottom_diff + (grid.batch_ind * channels_unpooled + c_unpooled)
+              * height * width;
+          const T top_diff_this_bin = offset_top_diff[bin];
+          const PreCalc<T>* pc = pre_calc.data() + offsets[n] - offsets[n_begin] +
+              bin * grid_size;
+          for (int i = 0; i < grid_size; i++, pc++) {
+            // the samples out of the feature map have null weights
+            add(static_cast<T>(top_diff_this_bin * pc->w1 / count), offset_bottom_diff + pc->pos1);
+            add(static_cast<T>(top_diff_this_bin * pc->w2 / count), offset_bottom_diff + pc->pos2);
+            add(static_cast<T>(top_diff_this_bin * pc->w3 / count), offset_bottom_diff + pc->pos3);
+            add(static_cast<T>(top_diff_this_bin * pc->w4 / count), offset_bottom_diff + pc->pos4);
+          }
+        }
+      }
+    }
+    n_begin = n_end;
+  }
 }  // ROIAlignBackward
 
 
@@ -28,14 +28,22 @@
 #include <dmlc/logging.h>
 #include <dmlc/parameter.h>
 #include <mxnet/operator.h>
+#include <mxnet/storage.h>
 #include <condition_variable>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <vector>
 #include <string>
 #include <utility>
 #include "../operator_common.h"
 #include "../mshadow_op.h"
 
+#if MXNET_USE_NCCL
+#include <nccl.h>
+#include "../../common/cuda/utils.h"
+#endif
+
 namespace mxnet {
 namespace op {
 
@@ -44,6 +52,7 @@ enum BatchNormOpInputs {kData, kGamma, kBeta};
 enum BatchNormOpOutputs {kOut, kMean, kVar};
 enum BatchNormOpAuxiliary {kMovingMean, kMovingVar};
 enum BatchNormBackResource {kTempSpace};
+enum SyncBatchNormBackend {kShared, kNCCL};
 }  // namespace syncbatchnorm
 
 struct SyncBatchNormParam : public dmlc::Parameter<SyncBatchNormParam> {
@@ -54,6 +63,10 @@ struct SyncBatchNormParam : public dmlc::Parameter<SyncBatchNormParam> {
   bool output_mean_var;
   int ndev;
   std::string key;
+  int backend;
+  std::string nccl_id;
+  int num_ranks;
+  int rank_offset;
   DMLC_DECLARE_PARAMETER(SyncBatchNormParam) {
     DMLC_DECLARE_FIELD(eps).set_default(1e-3f)
     .describe("Epsilon to prevent div 0");
@@ -71,8 +84,126 @@ struct SyncBatchNormParam : public dmlc::Parameter<SyncBatchNormParam> {
     DMLC_DECLARE_FIELD(key)
       .describe("Hash key for synchronization, please set the same hash key for same layer, "
                 "Block.prefix is typically used as in :class:`gluon.nn.contrib.SyncBatchNorm`.");
+    DMLC_DECLARE_FIELD(backend)
+      .add_enum("shared", syncbatchnorm::kShared)
+      .add_enum("nccl", syncbatchnorm::kNCCL)
+      .set_default(syncbatchnorm::kShared)
+      .describe("How the statistics are exchanged. 'shared' averages them in host memory "
+                "between the ndev devices of the process. 'nccl' all-reduces them on the "
+                "GPU streams between num_ranks devices, possibly of several processes.");
+    DMLC_DECLARE_FIELD(nccl_id).set_default("")
+      .describe("Hex string of the NCCL unique id of the devices synchronized together, "
+                "the same in every process. Only used by the 'nccl' backend.");
+    DMLC_DECLARE_FIELD(num_ranks).set_default(0)
+      .describe("Number of devices synchronized together over all the processes, "
+                "ndev if 0. Only used by the 'nccl' backend.");
+    DMLC_DECLARE_FIELD(rank_offset).set_default(0)
+      .describe("Rank of the first device of this process among the num_ranks devices, "
+                "e.g. the rank of the process times ndev. Only used by the 'nccl' backend.");
+  }
+};
+
+#if MXNET_USE_NCCL
+/*!
+ * \brief NCCL communicators of the 'nccl' backend of SyncBatchNorm, one per NCCL id and
+ *        device. The devices of a process get the ranks from rank_offset on, in the order
+ *        they first use the id.
+ */
+class SyncBatchNormComms {
+ public:
+  static SyncBatchNormComms* Get() {
+    static SyncBatchNormComms comms;
+    return &comms;
+  }
+
+  ncclComm_t Comm(const SyncBatchNormParam& param, int dev_id) {
+    Entry* e;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto& entry = entries_[std::make_pair(param.nccl_id, dev_id)];
+      if (!entry) {
+        entry.reset(new Entry());
+        entry->rank = param.rank_offset + ranks_[param.nccl_id]++;
+      }
+      e = entry.get();
+    }
+    // the creation blocks until all the ranks join, the other devices must not wait for it
+    std::call_once(e->created, [&]() {
+      const int num_ranks = param.num_ranks > 0 ? param.num_ranks : param.ndev;
+      CHECK_LT(e->rank, num_ranks) << "SyncBatchNorm " << param.key << " uses more devices "
+                                   << "than the " << num_ranks << " of its num_ranks";
+      ncclUniqueId id = ParseId(param.nccl_id);
+      mxnet::common::cuda::DeviceStore device_store(dev_id);
+      CHECK_EQ(ncclCommInitRank(&e->comm, num_ranks, id, e->rank), ncclSuccess)
+        << "Failed to create the NCCL communicator of SyncBatchNorm on device " << dev_id;
+    });
+    return e->comm;
+  }
+
+ private:
+  struct Entry {
+    int rank = 0;
+    ncclComm_t comm = nullptr;
+    std::once_flag created;
+  };
+
+  static ncclUniqueId ParseId(const std::string& hex) {
+    ncclUniqueId id;
+    CHECK_EQ(hex.size(), 2 * sizeof(id.internal))
+      << "nccl_id of SyncBatchNorm must be the hex string of a NCCL unique id";
+    for (size_t i = 0; i < sizeof(id.internal); ++i) {
+      id.internal[i] = static_cast<char>(std::stoi(hex.substr(2 * i, 2), nullptr, 16));
+    }
+    return id;
+  }
+
+  ~SyncBatchNormComms() {
+    for (auto& kv : entries_) {
+      if (kv.second->comm != nullptr) ncclCommDestroy(kv.second->comm);
+    }
   }
+
+  std::mutex mutex_;
+  std::map<std::pair<std::string, int>, std::unique_ptr<Entry>> entries_;
+  /*! \brief number of devices of this process using each id */
+  std::map<std::string, int> ranks_;
 };
+#endif  // MXNET_USE_NCCL
+
+/*!
+ * \brief Average a and b over the devices of the 'nccl' backend, in place on the stream
+ *        of the operator, without synchronizing with the host.
+ */
+template<typename xpu>
+inline void NCCLAllreduceMean(const SyncBatchNormParam& param, const OpContext& ctx,
+                              mshadow::Tensor<xpu, 1, real_t> a,
+                              mshadow::Tensor<xpu, 1, real_t> b) {
+  LOG(FATAL) << "The 'nccl' backend of SyncBatchNorm needs a GPU build with NCCL";
+}
+
+#if MXNET_USE_NCCL
+template<>
+inline void NCCLAllreduceMean<gpu>(const SyncBatchNormParam& param, const OpContext& ctx,
+                                   mshadow::Tensor<gpu, 1, real_t> a,
+                                   mshadow::Tensor<gpu, 1, real_t> b) {
+  using namespace mshadow::expr;
+  static_assert(sizeof(real_t) == sizeof(float), "real_t is all-reduced as ncclFloat");
+  mshadow::Stream<gpu>* s = ctx.get_stream<gpu>();
+  ncclComm_t comm = SyncBatchNormComms::Get()->Comm(param, ctx.run_ctx.ctx.dev_id);
+  cudaStream_t stream = mshadow::Stream<gpu>::GetStream(s);
+  {
+    // NCCL kernels must not interleave with the cudaFree of other threads
+    std::lock_guard<std::mutex> lock(Storage::Get()->GetMutex(Context::kGPU));
+    ncclGroupStart();
+    ncclAllReduce(a.dptr_, a.dptr_, a.shape_.Size(), ncclFloat, ncclSum, comm, stream);
+    ncclAllReduce(b.dptr_, b.dptr_, b.shape_.Size(), ncclFloat, ncclSum, comm, stream);
+    ncclGroupEnd();
+  }
+  const real_t scale = 1.0f / (param.num_ranks > 0 ? param.num_ranks : param.ndev);
+  a *= scale;
+  b *= scale;
+}
+#endif  // MXNET_USE_NCCL
 
 // Modified from https://github.com/brucechin/SharedTensor
 template<class T>
@@ -296,9 +427,6 @@ class SyncBatchNorm : public Operator {
 
     // whether use global statistics
     if (ctx.is_train && !param_.use_global_stats) {
-      // get my rank
-      Barrier *global_barrier = global_shared_barrier_forward.Register(param_.key, param_.ndev);
-      int myRank = global_shared_rank_forward.Register(param_.key, param_.ndev);
       // get the mean and var
       Tensor<xpu, 1> mean = out_data[syncbatchnorm::kMean].get<xpu, 1, real_t>(s);
       Tensor<xpu, 1> var = out_data[syncbatchnorm::kVar].get<xpu, 1, real_t>(s);
@@ -307,23 +435,12 @@ class SyncBatchNorm : public Operator {
       // E(x) and E(x^2)
       mean = scale * sumall_except_dim<1>(data);
       var = scale * sumall_except_dim<1>(F<mshadow_op::square>(data));
-      SharedND<mshadow::Tensor<cpu, 1, real_t>> *sharedMean =
-        global_shared_mean.Register(param_.key, param_.ndev);
-      SharedND<mshadow::Tensor<cpu, 1, real_t>> *sharedVar =
-        global_shared_var.Register(param_.key, param_.ndev);
-      // copy to cpu, push and pull
-      Tensor<cpu, 1, real_t>* mean_cpu_ptr = sharedMean->Retrieve(mean.shape_, myRank);
-      Tensor<cpu, 1, real_t>* var_cpu_ptr = sharedVar->Retrieve(mean.shape_, myRank);
-      mshadow::Copy(*mean_cpu_ptr, mean, s);
-      mshadow::Copy(*var_cpu_ptr, var, s);
-      sharedMean->SetReady(myRank);
-      sharedVar->SetReady(myRank);
-      global_barrier->Wait();
-      Tensor<cpu, 1, real_t> mean_cpu = sharedMean->Pop(myRank);
-      Tensor<cpu, 1, real_t> var_cpu = sharedVar->Pop(myRank);
-      // copy back to gpu
-      mshadow::Copy(mean, mean_cpu, s);
-      mshadow::Copy(var, var_cpu, s);
+      if (param_.backend == syncbatchnorm::kNCCL) {
+        NCCLAllreduceMean(param_, ctx, mean, var);
+      } else {
+        AllreduceShared(&global_shared_barrier_forward, &global_shared_rank_forward,
+                        &global_shared_mean, &global_shared_var, mean, var, s);
+      }
 
       var = var-F<mshadow_op::square>(mean);
       Assign(out, req[syncbatchnorm::kOut], broadcast<1>(slope, out.shape_) *
@@ -386,9 +503,6 @@ class SyncBatchNorm : public Operator {
     if (param_.fix_gamma) slope = 1.f;
 
     if (ctx.is_train && !param_.use_global_stats) {
-      // get my rank
-      Barrier *global_barrier = global_shared_barrier_backward.Register(param_.key, param_.ndev);
-      int myRank = global_shared_rank_backward.Register(param_.key, param_.ndev);
       // get requested temp space
       Tensor<xpu, 2> workspace = ctx.requested[syncbatchnorm::kTempSpace].get_space<xpu>(
           mshadow::Shape2(5, mean.shape_[0]), s);
@@ -402,23 +516,12 @@ class SyncBatchNorm : public Operator {
       Tensor<xpu, 1> sumProd = workspace[4];
       sumGrad = sumall_except_dim<1>(grad);
       sumProd = sumall_except_dim<1>(grad * (data - broadcast<1>(mean, data.shape_)));
-      SharedND<mshadow::Tensor<cpu, 1, real_t>> *sharedGrad =
-        global_shared_grad.Register(param_.key, param_.ndev);
-      SharedND<mshadow::Tensor<cpu, 1, real_t>> *sharedProd =
-        global_shared_prod.Register(param_.key, param_.ndev);
-      // copy to cpu, push and pull
-      Tensor<cpu, 1, real_t>* grad_cpu_ptr = sharedGrad->Retrieve(sumGrad.shape_, myRank);
-      Tensor<cpu, 1, real_t>* prod_cpu_ptr = sharedProd->Retrieve(sumGrad.shape_, myRank);
-      mshadow::Copy(*grad_cpu_ptr, sumGrad, s);
-      mshadow::Copy(*prod_cpu_ptr, sumProd, s);
-      sharedGrad->SetReady(myRank);
-      sharedProd->SetReady(myRank);
-      global_barrier->Wait();
-      Tensor<cpu, 1, real_t> grad_cpu = sharedGrad->Pop(myRank);
-      Tensor<cpu, 1, real_t> prod_cpu = sharedProd->Pop(myRank);
-      // copy back to gpu
-      mshadow::Copy(sumGrad, grad_cpu, s);
-      mshadow::Copy(sumProd, prod_cpu, s);
+      if (param_.backend == syncbatchnorm::kNCCL) {
+        NCCLAllreduceMean(param_, ctx, sumGrad, sumProd);
+      } else {
+        AllreduceShared(&global_shared_barrier_backward, &global_shared_rank_backward,
+                        &global_shared_grad, &global_shared_prod, sumGrad, sumProd, s);
+      }
 
       gvar = -1.0f * sumProd * slope *
         F<mshadow_op::power>(var + param_.eps, -1.5f);
@@ -458,6 +561,36 @@ class SyncBatchNorm : public Operator {
   }
 
  private:
+  /*!
+   * \brief Average a and b over the ndev devices of the process through host memory,
+   *        waiting for the other devices at a barrier.
+   */
+  void AllreduceShared(GlobalShared<Barrier>* barriers, GlobalSharedRank<int>* ranks,
+                       GlobalShared<SharedND<mshadow::Tensor<cpu, 1, real_t>>>* shared_a,
+                       GlobalShared<SharedND<mshadow::Tensor<cpu, 1, real_t>>>* shared_b,
+                       mshadow::Tensor<xpu, 1, real_t> a, mshadow::Tensor<xpu, 1, real_t> b,
+                       mshadow::Stream<xpu>* s) {
+    using mshadow::Tensor;
+    // get my rank
+    Barrier *global_barrier = barriers->Register(param_.key, param_.ndev);
+    int myRank = ranks->Register(param_.key, param_.ndev);
+    SharedND<Tensor<cpu, 1, real_t>> *sharedA = shared_a->Register(param_.key, param_.ndev);
+    SharedND<Tensor<cpu, 1, real_t>> *sharedB = shared_b->Register(param_.key, param_.ndev);
+    // copy to cpu, push and pull
+    Tensor<cpu, 1, real_t>* a_cpu_ptr = sharedA->Retrieve(a.shape_, myRank);
+    Tensor<cpu, 1, real_t>* b_cpu_ptr = sharedB->Retrieve(a.shape_, myRank);
+    mshadow::Copy(*a_cpu_ptr, a, s);
+    mshadow::Copy(*b_cpu_ptr, b, s);
+    sharedA->SetReady(myRank);
+    sharedB->SetReady(myRank);
+    global_barrier->Wait();
+    Tensor<cpu, 1, real_t> a_cpu = sharedA->Pop(myRank);
+    Tensor<cpu, 1, real_t> b_cpu = sharedB->Pop(myRank);
+    // copy back to gpu
+    mshadow::Copy(a, a_cpu, s);
+    mshadow::Copy(b, b_cpu, s);
+  }
+
   SyncBatchNormParam param_;
 };  // class SyncBatchNorm
 
@@ -29,6 +29,7 @@
 #include <vector>
 #include "../mxnet_op.h"
 #include "../mshadow_op.h"
+#include "../tensor/init_op.h"
 
 
 namespace mxnet {
@@ -43,6 +44,63 @@ struct InterleavedMatMulParam : public dmlc::Parameter<InterleavedMatMulParam> {
   }
 };
 
+struct InterleavedSelfAttParam : public dmlc::Parameter<InterleavedSelfAttParam> {
+  int heads;
+  bool causal;
+  bool use_length;
+  float dropout;
+  DMLC_DECLARE_PARAMETER(InterleavedSelfAttParam) {
+    DMLC_DECLARE_FIELD(heads)
+    .describe("Set number of heads");
+    DMLC_DECLARE_FIELD(causal).set_default(false)
+    .describe("Whether the queries only attend to the keys at their position or before");
+    DMLC_DECLARE_FIELD(use_length).set_default(false)
+    .describe("Whether to mask the keys beyond the valid length of each sequence");
+    DMLC_DECLARE_FIELD(dropout).set_default(0.0f).set_range(0.0f, 1.0f)
+    .describe("Dropout probability of the attention weights in training");
+  }
+};
+
+namespace selfatt {
+enum InterleavedSelfAttOutputs {kOut, kLogSumExp, kSeed};
+/*! \brief keys of a tile, which also is the warp size of the GPU kernels */
+const int kTileKeys = 32;
+}  // namespace selfatt
+
+/*!
+ * \brief Scale of the attention weight of query `i` and key `j` of attention batch `a` after
+ *        dropout. The mask is a hash of the seed and the position, so that the backward pass
+ *        recomputes it instead of storing (batch, seq_length, seq_length) of them.
+ */
+MSHADOW_XINLINE float SelfAttDropScale(float seed, float dropout, index_t a, index_t i,
+                                       index_t j, index_t seq_len) {
+  if (seed < 0.f) return 1.f;
+  uint64_t x = ((static_cast<uint64_t>(a) * seq_len + i) * seq_len + j) ^
+               (static_cast<uint64_t>(seed * 4294967296.f) << 32);
+  // splitmix64 finalizer
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  const float u = static_cast<float>(x >> 40) * (1.f / 16777216.f);
+  return u < dropout ? 0.f : 1.f / (1.f - dropout);
+}
+
+/*!
+ * \brief Draws the seed of the dropout masks of InterleavedSelfAtt, or -1 if no dropout
+ *        applies.
+ */
+template<typename xpu>
+void SelfAttSampleSeed(const InterleavedSelfAttParam& param, const OpContext& ctx,
+                       const TBlob& seed) {
+  mshadow::Stream<xpu> *s = ctx.get_stream<xpu>();
+  mshadow::Tensor<xpu, 1, float> seed_t = seed.get<xpu, 1, float>(s);
+  if (ctx.is_train && param.dropout > 0.f) {
+    ctx.requested[0].get_random<xpu, float>(s)->SampleUniform(&seed_t, 0, 1);
+  } else {
+    seed_t = -1.f;
+  }
+}
+
 template<typename xpu>
 static void DivSqrtDimForward_(const nnvm::NodeAttrs& attrs,
                   const OpContext& ctx,
@@ -23,13 +23,18 @@
  * \brief CPU implementation of the operators used in Transformer
  */
 #include <mxnet/base.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include "./transformer-inl.h"
 #include "../tensor/elemwise_unary_op.h"
+#include "../../engine/openmp.h"
 
 namespace mxnet {
 namespace op {
 
 DMLC_REGISTER_PARAMETER(InterleavedMatMulParam);
+DMLC_REGISTER_PARAMETER(InterleavedSelfAttParam);
 
 static bool InterleavedMatMulSelfAttQKShape(const NodeAttrs& attrs,
                                             mxnet::ShapeVector* in_shape,
@@ -830,6 +835,315 @@ NNVM_REGISTER_OP(_backward_interleaved_matmul_encdec_valatt)
 .set_attr_parser(ParamParser<InterleavedMatMulParam>)
 .set_attr<FCompute>("FCompute<cpu>", BackwardInterleavedMatMulEncDecValAttCPU);
 
+static bool InterleavedSelfAttShape(const NodeAttrs& attrs,
+                                    mxnet::ShapeVector* in_shape,
+                                    mxnet::ShapeVector* out_shape) {
+  const auto& params = nnvm::get<InterleavedSelfAttParam>(attrs.parsed);
+  CHECK_EQ(in_shape->size(), params.use_length ? 2U : 1U)
+    << "Input:[queries_keys_values" << (params.use_length ? ", valid_length" : "")
+    << "] currently have, " << in_shape->size() << " inputs";
+  auto qkv_shape = in_shape->at(0);
+  if (!mxnet::ndim_is_known(qkv_shape)) return false;
+  CHECK_EQ(qkv_shape.ndim(), 3U)
+    << "Input queries_keys_values should be 3D in seq_length-batch-3*proj_dim, "
+    << "currently is: " << qkv_shape.ndim() << "D";
+  CHECK_EQ(qkv_shape[2] % (3 * params.heads), 0)
+    << "queries_keys_values.shape[2] should be a multiple of 3 * heads, "
+    << "currently is " << qkv_shape[2];
+  if (params.use_length)
+    SHAPE_ASSIGN_CHECK(*in_shape, 1, mxnet::TShape({qkv_shape[1]}));
+  out_shape->resize(3);
+  SHAPE_ASSIGN_CHECK(*out_shape, selfatt::kOut,
+    mxnet::TShape({qkv_shape[0], qkv_shape[1], qkv_shape[2] / 3}));
+  SHAPE_ASSIGN_CHECK(*out_shape, selfatt::kLogSumExp,
+    mxnet::TShape({params.heads * qkv_shape[1], qkv_shape[0]}));
+  SHAPE_ASSIGN_CHECK(*out_shape, selfatt::kSeed, mxnet::TShape({1}));
+  return true;
+}
+
+static bool InterleavedSelfAttType(const NodeAttrs& attrs,
+                                   std::vector<int>* in_type,
+                                   std::vector<int>* out_type) {
+  const int dtype = in_type->at(0);
+  if (dtype == -1) return false;
+  out_type->resize(3);
+  TYPE_ASSIGN_CHECK(*out_type, selfatt::kOut, dtype);
+  TYPE_ASSIGN_CHECK(*out_type, selfatt::kLogSumExp,
+                    dtype == mshadow::kFloat64 ? mshadow::kFloat64 : mshadow::kFloat32);
+  TYPE_ASSIGN_CHECK(*out_type, selfatt::kSeed, mshadow::kFloat32);
+  return in_type->size() == 1 || in_type->at(1) != -1;
+}
+
+/*! \brief end of the keys attended by query `i` */
+inline index_t SelfAttKeyEnd(index_t i, index_t valid_length, bool causal) {
+  return causal ? std::min(valid_length, i + 1) : valid_length;
+}
+
+template<typename IType>
+index_t SelfAttValidLength(const IType* valid_length, index_t seq, index_t seq_len) {
+  if (valid_length == nullptr) return seq_len;
+  return std::max(index_t(0), std::min(seq_len, static_cast<index_t>(valid_length[seq])));
+}
+
+/*!
+ * \brief Self attention of each query row, with the online softmax over the tiles of keys,
+ *        so that the (batch, seq_length, seq_length) attention weights are never stored.
+ */
+template<typename DType, typename AType, typename IType>
+void InterleavedSelfAttForwardCPU(const InterleavedSelfAttParam& params, const DType* qkv,
+                                  const IType* valid_length, float seed, index_t seq_len,
+                                  index_t sequences, index_t head_dim, OpReqType req,
+                                  DType* output, AType* lse) {
+  const index_t attn_batches = params.heads * sequences;
+  const index_t lead_dim = attn_batches * 3 * head_dim;
+  const AType scale = 1.0 / std::sqrt(static_cast<AType>(head_dim));
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  #pragma omp parallel num_threads(omp_threads)
+  {
+    std::vector<AType> acc(head_dim), scores(selfatt::kTileKeys);
+    #pragma omp for
+    for (index_t r = 0; r < attn_batches * seq_len; ++r) {
+      const index_t a = r / seq_len, i = r % seq_len;
+      const index_t end = SelfAttKeyEnd(
+          i, SelfAttValidLength(valid_length, a / params.heads, seq_len), params.causal);
+      const DType* q = qkv + i * lead_dim + a * 3 * head_dim;
+      AType m = -std::numeric_limits<AType>::infinity(), l = 0;
+      std::fill(acc.begin(), acc.end(), AType(0));
+      for (index_t t = 0; t < end; t += selfatt::kTileKeys) {
+        const index_t n = std::min(end - t, index_t(selfatt::kTileKeys));
+        AType tile_max = -std::numeric_limits<AType>::infinity();
+        for (index_t jj = 0; jj < n; ++jj) {
+          const DType* k = qkv + (t + jj) * lead_dim + a * 3 * head_dim + head_dim;
+          AType dot = 0;
+          for (index_t d = 0; d < head_dim; ++d)
+            dot += static_cast<AType>(q[d]) * static_cast<AType>(k[d]);
+          scores[jj] = dot * scale;
+          tile_max = std::max(tile_max, scores[jj]);
+        }
+        const AType m_new = std::max(m, tile_max);
+        const AType corr = std::exp(m - m_new);
+        l *= corr;
+        for (index_t d = 0; d < head_dim; ++d) acc[d] *= corr;
+        for (index_t jj = 0; jj < n; ++jj) {
+          const AType p = std::exp(scores[jj] - m_new);
+          l += p;
+          const AType pd = p * SelfAttDropScale(seed, params.dropout, a, i, t + jj, seq_len);
+          if (pd == 0) continue;
+          const DType* v = qkv + (t + jj) * lead_dim + a * 3 * head_dim + 2 * head_dim;
+          for (index_t d = 0; d < head_dim; ++d) acc[d] += pd * static_cast<AType>(v[d]);
+        }
+        m = m_new;
+      }
+      DType* out = output + i * attn_batches * head_dim + a * head_dim;
+      for (index_t d = 0; d < head_dim; ++d)
+        KERNEL_ASSIGN(out[d], req, l > 0 ? acc[d] / l : AType(0));
+      lse[r] = l > 0 ? m + std::log(l) : -std::numeric_limits<AType>::infinity();
+    }
+  }
+}
+
+/*!
+ * \brief Gradient of the self attention, recomputing the attention weights from the
+ *        log-sum-exp of the rows: the gradient of the queries is reduced over the keys of
+ *        each query row, and those of the keys and values over the queries of each key row.
+ */
+template<typename DType, typename AType, typename IType>
+void InterleavedSelfAttBackwardCPU(const InterleavedSelfAttParam& params, const DType* ograd,
+                                   const DType* qkv, const IType* valid_length,
+                                   const DType* output, const AType* lse, float seed,
+                                   index_t seq_len, index_t sequences, index_t head_dim,
+                                   OpReqType req, AType* row_dots, DType* qkv_grad) {
+  const index_t attn_batches = params.heads * sequences;
+  const index_t lead_dim = attn_batches * 3 * head_dim;
+  const index_t out_lead_dim = attn_batches * head_dim;
+  const AType scale = 1.0 / std::sqrt(static_cast<AType>(head_dim));
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  auto dot = [head_dim](const DType* x, const DType* y) {
+    AType ret = 0;
+    for (index_t d = 0; d < head_dim; ++d)
+      ret += static_cast<AType>(x[d]) * static_cast<AType>(y[d]);
+    return ret;
+  };
+  // row_dots[i] = ograd[i] . output[i], which is sum_j P[i, j] dP[i, j]
+  #pragma omp parallel for num_threads(omp_threads)
+  for (index_t r = 0; r < attn_batches * seq_len; ++r) {
+    const index_t a = r / seq_len, i = r % seq_len;
+    row_dots[r] = dot(ograd + i * out_lead_dim + a * head_dim,
+                      output + i * out_lead_dim + a * head_dim);
+  }
+  #pragma omp parallel num_threads(omp_threads)
+  {
+    std::vector<AType> acc(head_dim), acc2(head_dim);
+    // gradient of the queries
+    #pragma omp for
+    for (index_t r = 0; r < attn_batches * seq_len; ++r) {
+      const index_t a = r / seq_len, i = r % seq_len;
+      const index_t end = SelfAttKeyEnd(
+          i, SelfAttValidLength(valid_length, a / params.heads, seq_len), params.causal);
+      const DType* q = qkv + i * lead_dim + a * 3 * head_dim;
+      const DType* dout = ograd + i * out_lead_dim + a * head_dim;
+      std::fill(acc.begin(), acc.end(), AType(0));
+      for (index_t j = 0; j < end; ++j) {
+        const DType* k = qkv + j * lead_dim + a * 3 * head_dim + head_dim;
+        const AType p = std::exp(dot(q, k) * scale - lse[r]);
+        const AType z = SelfAttDropScale(seed, params.dropout, a, i, j, seq_len);
+        const AType ds = p * (z * dot(dout, k + head_dim) - row_dots[r]);
+        for (index_t d = 0; d < head_dim; ++d) acc[d] += ds * static_cast<AType>(k[d]);
+      }
+      DType* dq = qkv_grad + i * lead_dim + a * 3 * head_dim;
+      for (index_t d = 0; d < head_dim; ++d) KERNEL_ASSIGN(dq[d], req, acc[d] * scale);
+    }
+    // gradients of the keys and values
+    #pragma omp for
+    for (index_t r = 0; r < attn_batches * seq_len; ++r) {
+      const index_t a = r / seq_len, j = r % seq_len;
+      const index_t length = SelfAttValidLength(valid_length, a / params.heads, seq_len);
+      const DType* k = qkv + j * lead_dim + a * 3 * head_dim + head_dim;
+      std::fill(acc.begin(), acc.end(), AType(0));
+      std::fill(acc2.begin(), acc2.end(), AType(0));
+      for (index_t i = params.causal ? j : 0; j < length && i < seq_len; ++i) {
+        const DType* q = qkv + i * lead_dim + a * 3 * head_dim;
+        const DType* dout = ograd + i * out_lead_dim + a * head_dim;
+        const index_t ri = a * seq_len + i;
+        const AType p = std::exp(dot(q, k) * scale - lse[ri]);
+        const AType z = SelfAttDropScale(seed, params.dropout, a, i, j, seq_len);
+        const AType ds = p * (z * dot(dout, k + head_dim) - row_dots[ri]);
+        for (index_t d = 0; d < head_dim; ++d) {
+          acc[d] += ds * static_cast<AType>(q[d]);
+          acc2[d] += p * z * static_cast<AType>(dout[d]);
+        }
+      }
+      DType* dk = qkv_grad + j * lead_dim + a * 3 * head_dim + head_dim;
+      for (index_t d = 0; d < head_dim; ++d) {
+        KERNEL_ASSIGN(dk[d], req, acc[d] * scale);
+        KERNEL_ASSIGN(dk[head_dim + d], req, acc2[d]);
+      }
+    }
+  }
+}
+
+void InterleavedSelfAttCPU(const nnvm::NodeAttrs& attrs,
+                           const OpContext &ctx,
+                           const std::vector<TBlob> &inputs,
+                           const std::vector<OpReqType> &req,
+                           const std::vector<TBlob> &outputs) {
+  const auto& params = nnvm::get<InterleavedSelfAttParam>(attrs.parsed);
+  SelfAttSampleSeed<cpu>(params, ctx, outputs[selfatt::kSeed]);
+  if (req[selfatt::kOut] == kNullOp) return;
+  const float seed = *outputs[selfatt::kSeed].dptr<float>();
+  const TBlob& qkv = inputs[0];
+  MSHADOW_SGL_DBL_TYPE_SWITCH(qkv.type_flag_, DType, {
+    MSHADOW_TYPE_SWITCH(params.use_length ? inputs[1].type_flag_ : mshadow::kInt32, IType, {
+      InterleavedSelfAttForwardCPU(
+          params, qkv.dptr<DType>(), params.use_length ? inputs[1].dptr<IType>() : nullptr,
+          seed, qkv.shape_[0], qkv.shape_[1], qkv.shape_[2] / 3 / params.heads,
+          req[selfatt::kOut], outputs[selfatt::kOut].dptr<DType>(),
+          outputs[selfatt::kLogSumExp].dptr<DType>());
+    });
+  });
+}
+
+void BackwardInterleavedSelfAttCPU(const nnvm::NodeAttrs& attrs,
+                                   const OpContext &ctx,
+                                   const std::vector<TBlob> &inputs,
+                                   const std::vector<OpReqType> &req,
+                                   const std::vector<TBlob> &outputs) {
+  const auto& params = nnvm::get<InterleavedSelfAttParam>(attrs.parsed);
+  mshadow::Stream<cpu>* s = ctx.get_stream<cpu>();
+  // inputs: ograd, queries_keys_values, [valid_length], output, lse, seed
+  const TBlob& qkv = inputs[1];
+  const size_t o = params.use_length ? 3 : 2;
+  if (params.use_length) Fill(s, outputs[1], req[1], 0);
+  if (req[0] == kNullOp) return;
+  const float seed = *inputs[o + 2].dptr<float>();
+  MSHADOW_SGL_DBL_TYPE_SWITCH(qkv.type_flag_, DType, {
+    MSHADOW_TYPE_SWITCH(params.use_length ? inputs[2].type_flag_ : mshadow::kInt32, IType, {
+      mshadow::Tensor<cpu, 1, DType> row_dots = ctx.requested[0].get_space_typed<cpu, 1, DType>(
+          mshadow::Shape1(inputs[o + 1].Size()), s);
+      InterleavedSelfAttBackwardCPU(
+          params, inputs[0].dptr<DType>(), qkv.dptr<DType>(),
+          params.use_length ? inputs[2].dptr<IType>() : nullptr, inputs[o].dptr<DType>(),
+          inputs[o + 1].dptr<DType>(), seed, qkv.shape_[0], qkv.shape_[1],
+          qkv.shape_[2] / 3 / params.heads, req[0], row_dots.dptr_, outputs[0].dptr<DType>());
+    });
+  });
+}
+
+NNVM_REGISTER_OP(_contrib_interleaved_selfatt)
+.describe(R"code(Compute the multihead self attention of the interleaved projections of
+queries, keys and values in a single pass, without storing the attention weights.
+
+the input must be a single tensor of interleaved projections
+of queries, keys and values following the layout:
+(seq_length, batch_size, num_heads * head_dim * 3)
+
+and the output follows the layout:
+(seq_length, batch_size, num_heads * head_dim)
+
+the equivalent code would be::
+
+  att = mx.nd.contrib.interleaved_matmul_selfatt_qk(queries_keys_values, heads=num_heads)
+  att = mx.nd.softmax(att, axis=-1)  # masked with causal and valid_length
+  att = mx.nd.Dropout(att, p=dropout)
+  output = mx.nd.contrib.interleaved_matmul_selfatt_valatt(queries_keys_values, att,
+                                                            heads=num_heads)
+
+With `causal`, query i only attends to the keys j <= i. With `use_length`, the keys at
+valid_length[b] and beyond of sequence b are masked.
+
+)code" ADD_FILELINE)
+.set_num_inputs([](const NodeAttrs& attrs) {
+  const auto& params = nnvm::get<InterleavedSelfAttParam>(attrs.parsed);
+  return params.use_length ? 2 : 1;
+})
+.set_num_outputs(3)
+.set_attr<nnvm::FNumVisibleOutputs>("FNumVisibleOutputs", [](const NodeAttrs& attrs) {
+  return 1;
+})
+.set_attr_parser(ParamParser<InterleavedSelfAttParam>)
+.set_attr<nnvm::FListInputNames>("FListInputNames", [](const NodeAttrs& attrs) {
+  const auto& params = nnvm::get<InterleavedSelfAttParam>(attrs.parsed);
+  if (params.use_length) return std::vector<std::string>{"queries_keys_values", "valid_length"};
+  return std::vector<std::string>{"queries_keys_values"};
+})
+.set_attr<nnvm::FListOutputNames>("FListOutputNames", [](const NodeAttrs& attrs) {
+  return std::vector<std::string>{"output", "lse", "seed"};
+})
+.set_attr<FResourceRequest>("FResourceRequest", [](const NodeAttrs& attrs) {
+  return std::vector<ResourceRequest>{ResourceRequest::kRandom};
+})
+.set_attr<mxnet::FInferShape>("FInferShape", InterleavedSelfAttShape)
+.set_attr<nnvm::FInferType>("FInferType", InterleavedSelfAttType)
+.set_attr<FCompute>("FCompute<cpu>", InterleavedSelfAttCPU)
+.set_attr<nnvm::FGradient>("FGradient",
+  [](const nnvm::ObjectPtr& n, const std::vector<nnvm::NodeEntry>& ograds) {
+    std::vector<nnvm::NodeEntry> heads{ograds[selfatt::kOut]};
+    heads.insert(heads.end(), n->inputs.begin(), n->inputs.end());
+    heads.emplace_back(n, selfatt::kOut, 0);
+    heads.emplace_back(n, selfatt::kLogSumExp, 0);
+    heads.emplace_back(n, selfatt::kSeed, 0);
+    return MakeGradNode("_backward_interleaved_selfatt", n, heads, n->attrs.dict);
+  })
+.add_argument("queries_keys_values", "NDArray-or-Symbol", "Interleaved queries, keys and values")
+.add_argument("valid_length", "NDArray-or-Symbol",
+              "Valid length of each sequence, used if use_length is true")
+.add_arguments(InterleavedSelfAttParam::__FIELDS__());
+
+NNVM_REGISTER_OP(_backward_interleaved_selfatt)
+.set_num_inputs([](const NodeAttrs& attrs) {
+  const auto& params = nnvm::get<InterleavedSelfAttParam>(attrs.parsed);
+  return params.use_length ? 6 : 5;
+})
+.set_num_outputs([](const NodeAttrs& attrs) {
+  const auto& params = nnvm::get<InterleavedSelfAttParam>(attrs.parsed);
+  return params.use_length ? 2 : 1;
+})
+.set_attr<nnvm::TIsBackward>("TIsBackward", true)
+.set_attr_parser(ParamParser<InterleavedSelfAttParam>)
+.set_attr<FResourceRequest>("FResourceRequest", [](const NodeAttrs& attrs) {
+  return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
+})
+.set_attr<FCompute>("FCompute<cpu>", BackwardInterleavedSelfAttCPU);
 
 // relu
 MXNET_OPERATOR_REGISTER_UNARY(_contrib_div_sqrt_dim)
@@ -27,6 +27,7 @@
 #include <cuda_runtime.h>
 #include <cuda_fp16.h>
 #include <cuda_profiler_api.h>
+#include <type_traits>
 
 #include <mxnet/base.h>
 #include "./transformer-inl.h"
@@ -654,6 +655,380 @@ void BackwardInterleavedMatMulEncDecValAttGPU(const nnvm::NodeAttrs& attrs,
   })
 }
 
+/*! \brief query rows, or key rows, of a block of the fused self attention kernels */
+constexpr int kSelfAttWarps = 4;
+/*! \brief largest head_dim of the fused self attention kernels, 4 values per lane */
+constexpr int kSelfAttMaxHeadDim = 128;
+
+template<typename AType>
+__device__ inline AType SelfAttWarpSum(AType v) {
+#pragma unroll
+  for (int o = selfatt::kTileKeys / 2; o > 0; o /= 2) v += __shfl_xor_sync(0xffffffff, v, o);
+  return v;
+}
+
+template<typename AType>
+__device__ inline AType SelfAttWarpMax(AType v) {
+#pragma unroll
+  for (int o = selfatt::kTileKeys / 2; o > 0; o /= 2)
+    v = max(v, __shfl_xor_sync(0xffffffff, v, o));
+  return v;
+}
+
+template<typename IType>
+__device__ inline index_t SelfAttValidLengthGPU(const IType* valid_length, index_t seq,
+                                                index_t seq_len) {
+  if (valid_length == nullptr) return seq_len;
+  const index_t length = static_cast<index_t>(valid_length[seq]);
+  return length < 0 ? 0 : (length < seq_len ? length : seq_len);
+}
+
+/*!
+ * \brief Loads rows [t, t + kTileKeys) of one slot (query, key or value) of the interleaved
+ *        projections into a tile of rows padded to head_dim + 1 against bank conflicts.
+ */
+template<typename DType, typename AType>
+__device__ inline void SelfAttLoadTile(const DType* rows, index_t t, index_t end,
+                                       index_t lead_dim, int head_dim, AType* tile) {
+  for (int e = threadIdx.x; e < selfatt::kTileKeys * head_dim; e += blockDim.x) {
+    const int r = e / head_dim, d = e % head_dim;
+    tile[r * (head_dim + 1) + d] =
+        t + r < end ? static_cast<AType>(rows[(t + r) * lead_dim + d]) : AType(0);
+  }
+}
+
+/*!
+ * \brief Forward of the fused self attention: a warp computes a query row with the online
+ *        softmax over the tiles of keys and values staged in shared memory, lane j scoring
+ *        key j of the tile and lane d accumulating dimensions d, d + 32, ... of the output.
+ */
+template<typename DType, typename AType, typename IType>
+__global__ void InterleavedSelfAttForwardKernel(const DType* qkv, const IType* valid_length,
+                                                const float* seed_ptr, float dropout,
+                                                bool causal, int heads, index_t seq_len,
+                                                index_t attn_batches, int head_dim,
+                                                OpReqType req, DType* output, AType* lse) {
+  extern __shared__ char selfatt_smem[];
+  const int ld = head_dim + 1;
+  AType* k_tile = reinterpret_cast<AType*>(selfatt_smem);
+  AType* v_tile = k_tile + selfatt::kTileKeys * ld;
+  const int warp = threadIdx.x / selfatt::kTileKeys, lane = threadIdx.x % selfatt::kTileKeys;
+  AType* q = v_tile + selfatt::kTileKeys * ld + warp * head_dim;
+  const index_t a = blockIdx.x;
+  const index_t first = static_cast<index_t>(blockIdx.y) * kSelfAttWarps;
+  const index_t i = first + warp;
+  const index_t lead_dim = attn_batches * 3 * head_dim;
+  const DType* base = qkv + a * 3 * head_dim;
+  const float seed = *seed_ptr;
+  const AType scale = AType(1) / sqrt(static_cast<AType>(head_dim));
+  const index_t length = SelfAttValidLengthGPU(valid_length, a / heads, seq_len);
+  const index_t end = i >= seq_len ? 0 : (causal && i + 1 < length ? i + 1 : length);
+  const index_t last = first + kSelfAttWarps < seq_len ? first + kSelfAttWarps : seq_len;
+  const index_t block_end = causal && last < length ? last : length;
+  for (int d = lane; d < head_dim; d += selfatt::kTileKeys)
+    q[d] = i < seq_len ? static_cast<AType>(base[i * lead_dim + d]) : AType(0);
+  AType acc[kSelfAttMaxHeadDim / selfatt::kTileKeys] = {0};
+  AType m = -INFINITY, l = 0;
+  for (index_t t = 0; t < block_end; t += selfatt::kTileKeys) {
+    __syncthreads();
+    SelfAttLoadTile(base + head_dim, t, block_end, lead_dim, head_dim, k_tile);
+    SelfAttLoadTile(base + 2 * head_dim, t, block_end, lead_dim, head_dim, v_tile);
+    __syncthreads();
+    if (t >= end) continue;
+    const index_t j = t + lane;
+    AType s = -INFINITY;
+    if (j < end) {
+      AType dot = 0;
+      for (int d = 0; d < head_dim; ++d) dot += q[d] * k_tile[lane * ld + d];
+      s = dot * scale;
+    }
+    // key t is attended, so that m_new is finite
+    const AType m_new = max(m, SelfAttWarpMax(s));
+    const AType p = j < end ? exp(s - m_new) : AType(0);
+    const AType corr = exp(m - m_new);
+    l = l * corr + SelfAttWarpSum(p);
+    const AType pd = p * SelfAttDropScale(seed, dropout, a, i, j, seq_len);
+#pragma unroll
+    for (int c = 0; c < kSelfAttMaxHeadDim / selfatt::kTileKeys; ++c) acc[c] *= corr;
+    for (int jj = 0; jj < selfatt::kTileKeys; ++jj) {
+      const AType pj = __shfl_sync(0xffffffff, pd, jj);
+#pragma unroll
+      for (int c = 0; c < kSelfAttMaxHeadDim / selfatt::kTileKeys; ++c) {
+        const int d = lane + c * selfatt::kTileKeys;
+        if (d < head_dim) acc[c] += pj * v_tile[jj * ld + d];
+      }
+    }
+    m = m_new;
+  }
+  if (i >= seq_len) return;
+  DType* out = output + (i * attn_batches + a) * head_dim;
+#pragma unroll
+  for (int c = 0; c < kSelfAttMaxHeadDim / selfatt::kTileKeys; ++c) {
+    const int d = lane + c * selfatt::kTileKeys;
+    if (d < head_dim) KERNEL_ASSIGN(out[d], req, l > 0 ? acc[c] / l : AType(0));
+  }
+  if (lane == 0) lse[a * seq_len + i] = l > 0 ? m + log(l) : AType(-INFINITY);
+}
+
+/*!
+ * \brief Gradient of the queries of the fused self attention, a warp per query row as in the
+ *        forward, which also stores ograd . output of the row for the gradients of the keys.
+ */
+template<typename DType, typename AType, typename IType>
+__global__ void InterleavedSelfAttQueryGradKernel(const DType* ograd, const DType* qkv,
+                                                  const IType* valid_length,
+                                                  const DType* output, const AType* lse,
+                                                  const float* seed_ptr, float dropout,
+                                                  bool causal, int heads, index_t seq_len,
+                                                  index_t attn_batches, int head_dim,
+                                                  OpReqType req, AType* row_dots,
+                                                  DType* qkv_grad) {
+  extern __shared__ char selfatt_smem[];
+  const int ld = head_dim + 1;
+  AType* k_tile = reinterpret_cast<AType*>(selfatt_smem);
+  AType* v_tile = k_tile + selfatt::kTileKeys * ld;
+  const int warp = threadIdx.x / selfatt::kTileKeys, lane = threadIdx.x % selfatt::kTileKeys;
+  AType* q = v_tile + selfatt::kTileKeys * ld + warp * 2 * head_dim;
+  AType* dout = q + head_dim;
+  const index_t a = blockIdx.x;
+  const index_t first = static_cast<index_t>(blockIdx.y) * kSelfAttWarps;
+  const index_t i = first + warp;
+  const index_t lead_dim = attn_batches * 3 * head_dim;
+  const DType* base = qkv + a * 3 * head_dim;
+  const float seed = *seed_ptr;
+  const AType scale = AType(1) / sqrt(static_cast<AType>(head_dim));
+  const index_t length = SelfAttValidLengthGPU(valid_length, a / heads, seq_len);
+  const index_t end = i >= seq_len ? 0 : (causal && i + 1 < length ? i + 1 : length);
+  const index_t last = first + kSelfAttWarps < seq_len ? first + kSelfAttWarps : seq_len;
+  const index_t block_end = causal && last < length ? last : length;
+  const index_t out_row = (i * attn_batches + a) * head_dim;
+  AType row_dot = 0;
+  for (int d = lane; d < head_dim; d += selfatt::kTileKeys) {
+    q[d] = i < seq_len ? static_cast<AType>(base[i * lead_dim + d]) : AType(0);
+    dout[d] = i < seq_len ? static_cast<AType>(ograd[out_row + d]) : AType(0);
+    if (i < seq_len) row_dot += dout[d] * static_cast<AType>(output[out_row + d]);
+  }
+  row_dot = SelfAttWarpSum(row_dot);
+  const AType row_lse = i < seq_len ? lse[a * seq_len + i] : AType(0);
+  AType acc[kSelfAttMaxHeadDim / selfatt::kTileKeys] = {0};
+  for (index_t t = 0; t < block_end; t += selfatt::kTileKeys) {
+    __syncthreads();
+    SelfAttLoadTile(base + head_dim, t, block_end, lead_dim, head_dim, k_tile);
+    SelfAttLoadTile(base + 2 * head_dim, t, block_end, lead_dim, head_dim, v_tile);
+    __syncthreads();
+    if (t >= end) continue;
+    const index_t j = t + lane;
+    AType ds = 0;
+    if (j < end) {
+      AType dot = 0, dp = 0;
+      for (int d = 0; d < head_dim; ++d) {
+        dot += q[d] * k_tile[lane * ld + d];
+        dp += dout[d] * v_tile[lane * ld + d];
+      }
+      const AType p = exp(dot * scale - row_lse);
+      ds = p * (SelfAttDropScale(seed, dropout, a, i, j, seq_len) * dp - row_dot);
+    }
+    for (int jj = 0; jj < selfatt::kTileKeys; ++jj) {
+      const AType dsj = __shfl_sync(0xffffffff, ds, jj);
+#pragma unroll
+      for (int c = 0; c < kSelfAttMaxHeadDim / selfatt::kTileKeys; ++c) {
+        const int d = lane + c * selfatt::kTileKeys;
+        if (d < head_dim) acc[c] += dsj * k_tile[jj * ld + d];
+      }
+    }
+  }
+  if (i >= seq_len) return;
+  if (lane == 0) row_dots[a * seq_len + i] = row_dot;
+  DType* dq = qkv_grad + i * lead_dim + a * 3 * head_dim;
+#pragma unroll
+  for (int c = 0; c < kSelfAttMaxHeadDim / selfatt::kTileKeys; ++c) {
+    const int d = lane + c * selfatt::kTileKeys;
+    if (d < head_dim) KERNEL_ASSIGN(dq[d], req, acc[c] * scale);
+  }
+}
+
+/*!
+ * \brief Gradients of the keys and values of the fused self attention: a warp per key row,
+ *        looping over the tiles of the queries attending it, lane i recomputing the weight
+ *        of query i of the tile.
+ */
+template<typename DType, typename AType, typename IType>
+__global__ void InterleavedSelfAttKeyValueGradKernel(const DType* ograd, const DType* qkv,
+                                                     const IType* valid_length,
+                                                     const AType* lse, const AType* row_dots,
+                                                     const float* seed_ptr, float dropout,
+                                                     bool causal, int heads, index_t seq_len,
+                                                     index_t attn_batches, int head_dim,
+                                                     OpReqType req, DType* qkv_grad) {
+  extern __shared__ char selfatt_smem[];
+  const int ld = head_dim + 1;
+  AType* q_tile = reinterpret_cast<AType*>(selfatt_smem);
+  AType* dout_tile = q_tile + selfatt::kTileKeys * ld;
+  AType* lse_tile = dout_tile + selfatt::kTileKeys * ld;
+  AType* dots_tile = lse_tile + selfatt::kTileKeys;
+  const int warp = threadIdx.x / selfatt::kTileKeys, lane = threadIdx.x % selfatt::kTileKeys;
+  AType* k = dots_tile + selfatt::kTileKeys + warp * 2 * head_dim;
+  AType* v = k + head_dim;
+  const index_t a = blockIdx.x;
+  const index_t first = static_cast<index_t>(blockIdx.y) * kSelfAttWarps;
+  const index_t j = first + warp;
+  const index_t lead_dim = attn_batches * 3 * head_dim;
+  const index_t out_lead_dim = attn_batches * head_dim;
+  const DType* base = qkv + a * 3 * head_dim;
+  const float seed = *seed_ptr;
+  const AType scale = AType(1) / sqrt(static_cast<AType>(head_dim));
+  const index_t length = SelfAttValidLengthGPU(valid_length, a / heads, seq_len);
+  const bool attended = j < length;
+  for (int d = lane; d < head_dim; d += selfatt::kTileKeys) {
+    k[d] = attended ? static_cast<AType>(base[j * lead_dim + head_dim + d]) : AType(0);
+    v[d] = attended ? static_cast<AType>(base[j * lead_dim + 2 * head_dim + d]) : AType(0);
+  }
+  AType dk[kSelfAttMaxHeadDim / selfatt::kTileKeys] = {0};
+  AType dv[kSelfAttMaxHeadDim / selfatt::kTileKeys] = {0};
+  // with causal attention, the queries before the first key of the block attend none of them
+  const index_t start = causal ? first / selfatt::kTileKeys * selfatt::kTileKeys : 0;
+  for (index_t t = first < length ? start : seq_len; t < seq_len; t += selfatt::kTileKeys) {
+    __syncthreads();
+    SelfAttLoadTile(base, t, seq_len, lead_dim, head_dim, q_tile);
+    SelfAttLoadTile(ograd + a * head_dim, t, seq_len, out_lead_dim, head_dim, dout_tile);
+    if (threadIdx.x < selfatt::kTileKeys) {
+      const index_t i = t + threadIdx.x;
+      lse_tile[threadIdx.x] = i < seq_len ? lse[a * seq_len + i] : AType(0);
+      dots_tile[threadIdx.x] = i < seq_len ? row_dots[a * seq_len + i] : AType(0);
+    }
+    __syncthreads();
+    if (!attended) continue;
+    const index_t i = t + lane;
+    AType pd = 0, ds = 0;
+    if (i < seq_len && (!causal || i >= j)) {
+      AType dot = 0, dp = 0;
+      for (int d = 0; d < head_dim; ++d) {
+        dot += q_tile[lane * ld + d] * k[d];
+        dp += dout_tile[lane * ld + d] * v[d];
+      }
+      const AType p = exp(dot * scale - lse_tile[lane]);
+      const AType z = SelfAttDropScale(seed, dropout, a, i, j, seq_len);
+      pd = p * z;
+      ds = p * (z * dp - dots_tile[lane]);
+    }
+    for (int ii = 0; ii < selfatt::kTileKeys; ++ii) {
+      const AType pdi = __shfl_sync(0xffffffff, pd, ii);
+      const AType dsi = __shfl_sync(0xffffffff, ds, ii);
+#pragma unroll
+      for (int c = 0; c < kSelfAttMaxHeadDim / selfatt::kTileKeys; ++c) {
+        const int d = lane + c * selfatt::kTileKeys;
+        if (d < head_dim) {
+          dv[c] += pdi * dout_tile[ii * ld + d];
+          dk[c] += dsi * q_tile[ii * ld + d];
+        }
+      }
+    }
+  }
+  if (j >= seq_len) return;
+  DType* dkv = qkv_grad + j * lead_dim + a * 3 * head_dim + head_dim;
+#pragma unroll
+  for (int c = 0; c < kSelfAttMaxHeadDim / selfatt::kTileKeys; ++c) {
+    const int d = lane + c * selfatt::kTileKeys;
+    if (d < head_dim) {
+      KERNEL_ASSIGN(dkv[d], req, dk[c] * scale);
+      KERNEL_ASSIGN(dkv[head_dim + d], req, dv[c]);
+    }
+  }
+}
+
+/*! \brief grid of the fused self attention kernels and their shared memory in bytes */
+inline dim3 SelfAttGrid(index_t seq_len, index_t attn_batches) {
+  const index_t row_blocks = (seq_len + kSelfAttWarps - 1) / kSelfAttWarps;
+  CHECK_LE(row_blocks, 65535) << "seq_length is too large for interleaved_selfatt on GPU";
+  return dim3(attn_batches, row_blocks);
+}
+
+template<typename AType>
+size_t SelfAttSharedBytes(int head_dim, int tiles, int extra) {
+  CHECK_LE(head_dim, kSelfAttMaxHeadDim)
+    << "interleaved_selfatt supports at most " << kSelfAttMaxHeadDim
+    << " dimensions per head on GPU, currently " << head_dim;
+  const size_t bytes = (tiles * selfatt::kTileKeys * (head_dim + 1) + extra) * sizeof(AType);
+  CHECK_LE(bytes, 48 * 1024)
+    << "interleaved_selfatt needs " << bytes << " bytes of shared memory for head_dim "
+    << head_dim << " in this dtype, more than the 48 KB available";
+  return bytes;
+}
+
+void InterleavedSelfAttGPU(const nnvm::NodeAttrs& attrs,
+                           const OpContext &ctx,
+                           const std::vector<TBlob> &inputs,
+                           const std::vector<OpReqType> &req,
+                           const std::vector<TBlob> &outputs) {
+  const auto& params = nnvm::get<InterleavedSelfAttParam>(attrs.parsed);
+  SelfAttSampleSeed<gpu>(params, ctx, outputs[selfatt::kSeed]);
+  if (req[selfatt::kOut] == kNullOp) return;
+  mshadow::Stream<gpu>* s = ctx.get_stream<gpu>();
+  cudaStream_t stream = mshadow::Stream<gpu>::GetStream(s);
+  const TBlob& qkv = inputs[0];
+  const index_t seq_len = qkv.shape_[0];
+  const index_t attn_batches = params.heads * qkv.shape_[1];
+  const int head_dim = qkv.shape_[2] / 3 / params.heads;
+  MSHADOW_REAL_TYPE_SWITCH(qkv.type_flag_, DType, {
+    using AType = typename std::conditional<std::is_same<DType, double>::value,
+                                            double, float>::type;
+    MSHADOW_TYPE_SWITCH(params.use_length ? inputs[1].type_flag_ : mshadow::kInt32, IType, {
+      const size_t smem = SelfAttSharedBytes<AType>(head_dim, 2, kSelfAttWarps * head_dim);
+      InterleavedSelfAttForwardKernel<<<SelfAttGrid(seq_len, attn_batches),
+                                        kSelfAttWarps * selfatt::kTileKeys, smem, stream>>>(
+          qkv.dptr<DType>(), params.use_length ? inputs[1].dptr<IType>() : nullptr,
+          outputs[selfatt::kSeed].dptr<float>(), params.dropout, params.causal, params.heads,
+          seq_len, attn_batches, head_dim, req[selfatt::kOut],
+          outputs[selfatt::kOut].dptr<DType>(), outputs[selfatt::kLogSumExp].dptr<AType>());
+      MSHADOW_CUDA_POST_KERNEL_CHECK(InterleavedSelfAttForwardKernel);
+    });
+  });
+}
+
+void BackwardInterleavedSelfAttGPU(const nnvm::NodeAttrs& attrs,
+                                   const OpContext &ctx,
+                                   const std::vector<TBlob> &inputs,
+                                   const std::vector<OpReqType> &req,
+                                   const std::vector<TBlob> &outputs) {
+  const auto& params = nnvm::get<InterleavedSelfAttParam>(attrs.parsed);
+  mshadow::Stream<gpu>* s = ctx.get_stream<gpu>();
+  cudaStream_t stream = mshadow::Stream<gpu>::GetStream(s);
+  // inputs: ograd, queries_keys_values, [valid_length], output, lse, seed
+  const TBlob& qkv = inputs[1];
+  const size_t o = params.use_length ? 3 : 2;
+  if (params.use_length) Fill(s, outputs[1], req[1], 0);
+  if (req[0] == kNullOp) return;
+  const index_t seq_len = qkv.shape_[0];
+  const index_t attn_batches = params.heads * qkv.shape_[1];
+  const int head_dim = qkv.shape_[2] / 3 / params.heads;
+  const dim3 grid = SelfAttGrid(seq_len, attn_batches);
+  const int threads = kSelfAttWarps * selfatt::kTileKeys;
+  MSHADOW_REAL_TYPE_SWITCH(qkv.type_flag_, DType, {
+    using AType = typename std::conditional<std::is_same<DType, double>::value,
+                                            double, float>::type;
+    MSHADOW_TYPE_SWITCH(params.use_length ? inputs[2].type_flag_ : mshadow::kInt32, IType, {
+      const IType* valid_length = params.use_length ? inputs[2].dptr<IType>() : nullptr;
+      mshadow::Tensor<gpu, 1, AType> row_dots = ctx.requested[0].get_space_typed<gpu, 1, AType>(
+          mshadow::Shape1(inputs[o + 1].Size()), s);
+      size_t smem = SelfAttSharedBytes<AType>(head_dim, 2, 2 * kSelfAttWarps * head_dim);
+      InterleavedSelfAttQueryGradKernel<<<grid, threads, smem, stream>>>(
+          inputs[0].dptr<DType>(), qkv.dptr<DType>(), valid_length, inputs[o].dptr<DType>(),
+          inputs[o + 1].dptr<AType>(), inputs[o + 2].dptr<float>(), params.dropout,
+          params.causal, params.heads, seq_len, attn_batches, head_dim, req[0],
+          row_dots.dptr_, outputs[0].dptr<DType>());
+      MSHADOW_CUDA_POST_KERNEL_CHECK(InterleavedSelfAttQueryGradKernel);
+      smem = SelfAttSharedBytes<AType>(head_dim, 2,
+                                       2 * selfatt::kTileKeys + 2 * kSelfAttWarps * head_dim);
+      InterleavedSelfAttKeyValueGradKernel<<<grid, threads, smem, stream>>>(
+          inputs[0].dptr<DType>(), qkv.dptr<DType>(), valid_length,
+          inputs[o + 1].dptr<AType>(), row_dots.dptr_, inputs[o + 2].dptr<float>(),
+          params.dropout, params.causal, params.heads, seq_len, attn_batches, head_dim, req[0],
+          outputs[0].dptr<DType>());
+      MSHADOW_CUDA_POST_KERNEL_CHECK(InterleavedSelfAttKeyValueGradKernel);
+    });
+  });
+}
+
 NNVM_REGISTER_OP(_contrib_interleaved_matmul_selfatt_qk)
 .set_attr<FCompute>("FCompute<gpu>", InterleavedMatMulSelfAttQKGPU);
 
@@ -678,6 +1053,12 @@ NNVM_REGISTER_OP(_backward_interleaved_matmul_encdec_qk)
 NNVM_REGISTER_OP(_backward_interleaved_matmul_encdec_valatt)
 .set_attr<FCompute>("FCompute<gpu>", BackwardInterleavedMatMulEncDecValAttGPU);
 
+NNVM_REGISTER_OP(_contrib_interleaved_selfatt)
+.set_attr<FCompute>("FCompute<gpu>", InterleavedSelfAttGPU);
+
+NNVM_REGISTER_OP(_backward_interleaved_selfatt)
+.set_attr<FCompute>("FCompute<gpu>", BackwardInterleavedSelfAttGPU);
+
 // relu
 NNVM_REGISTER_OP(_contrib_div_sqrt_dim)
 .set_attr<FCompute>("FCompute<gpu>", DivSqrtDimForward_<gpu>);
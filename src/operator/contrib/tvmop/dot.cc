@@ -59,12 +59,16 @@ int SplitSch(const ::tvm::runtime::TVMOpConfig& config,
 
 std::string DotSch(const std::string name,
                    const nnvm::NodeAttrs& attrs,
-                   const mxnet::ShapeVector& in_attrs,
-                   const mxnet::ShapeVector& out_attrs) {
+                   const std::vector<TBlob>& args) {
   const ::tvm::runtime::TVMOpConfig& config = tvm::runtime::GetOpConfig(name);
-  int m = in_attrs[0][0];
-  int k = in_attrs[0][1];
-  int n = in_attrs[1][1];
+  // the schedule tuned for the shapes, else the first one whose tiles divide them
+  int idx_tuned = config.get_tuned_index(args);
+  if (idx_tuned >= 0) {
+    return "index_" + std::to_string(idx_tuned);
+  }
+  int m = args[0].shape_[0];
+  int k = args[0].shape_[1];
+  int n = args[1].shape_[1];
   int idx_bn = SplitSch(config, "bn", {m, n});
   int idx_factor = SplitSch(config, "factor", {k});
   int idx = idx_bn + idx_factor;
@@ -82,8 +86,7 @@ void TVMDotForward(const nnvm::NodeAttrs& attrs,
   CHECK_EQ(inputs.size(), 2U);
   CHECK_EQ(outputs.size(), 1U);
   std::string funcname = "dot";
-  std::string sch = DotSch(funcname, attrs, {inputs[0].shape_, inputs[1].shape_},
-                           {outputs[0].shape_});
+  std::string sch = DotSch(funcname, attrs, {inputs[0], inputs[1], outputs[0]});
   tvm::runtime::TVMOpModule::Get()->Call(funcname + sch, ctx, {inputs[0], inputs[1], outputs[0]});
 }
 
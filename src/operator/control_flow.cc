@@ -44,6 +44,7 @@ struct ForeachParam : public dmlc::Parameter<ForeachParam> {
   mxnet::Tuple<dim_t> in_data_locs;
   // The location of remaining arrays in the subgraph inputs.
   mxnet::Tuple<dim_t> remain_locs;
+  bool static_alloc;
   DMLC_DECLARE_PARAMETER(ForeachParam) {
     DMLC_DECLARE_FIELD(num_args).set_lower_bound(1)
     .describe("Number of inputs.");
@@ -57,6 +58,12 @@ struct ForeachParam : public dmlc::Parameter<ForeachParam> {
     .describe("The locations of input data among the inputs.");
     DMLC_DECLARE_FIELD(remain_locs)
     .describe("The locations of remaining data among the inputs.");
+    DMLC_DECLARE_FIELD(static_alloc)
+    .set_default(dmlc::GetEnv("MXNET_CONTROL_FLOW_STATIC_ALLOC", false))
+    .describe("Plan the memory of the loop body once and reuse it in all the iterations "
+              "that are not recorded for backward, with the whole body pushed to the "
+              "engine as one bulk segment. The shapes of the loop states must be the "
+              "same in all the iterations.");
   }
 };  // struct ForeachParam
 
@@ -67,7 +74,8 @@ class ForeachState: public LoopState {
   ForeachParam params;
   int num_iterations;
 
-  ForeachState(const nnvm::Symbol &g, const ForeachParam &params) : LoopState(g) {
+  ForeachState(const nnvm::Symbol &g, const ForeachParam &params)
+      : LoopState(g, params.static_alloc) {
     this->params = params;
   }
 };
@@ -492,6 +500,7 @@ struct WhileLoopParam : public dmlc::Parameter<WhileLoopParam> {
   mxnet::Tuple<dim_t> cond_input_locs;
   mxnet::Tuple<dim_t> func_input_locs;
   mxnet::Tuple<dim_t> func_var_locs;
+  bool static_alloc;
   DMLC_DECLARE_PARAMETER(WhileLoopParam) {
     DMLC_DECLARE_FIELD(num_args).set_lower_bound(2)
     .describe("Number of input arguments, including cond and func as two symbol inputs.");
@@ -507,6 +516,12 @@ struct WhileLoopParam : public dmlc::Parameter<WhileLoopParam> {
     .describe("The locations of func's inputs in the given inputs.");
     DMLC_DECLARE_FIELD(func_var_locs)
     .describe("The locations of loop_vars among func's inputs.");
+    DMLC_DECLARE_FIELD(static_alloc)
+    .set_default(dmlc::GetEnv("MXNET_CONTROL_FLOW_STATIC_ALLOC", false))
+    .describe("Plan the memory of the loop body once and reuse it in all the iterations "
+              "that are not recorded for backward, with the whole body pushed to the "
+              "engine as one bulk segment. The shapes of the loop states must be the "
+              "same in all the iterations.");
   }
   template <typename T>
   bool sync_in_out(std::vector<T> *in,
@@ -534,10 +549,10 @@ class WhileLoopState: public LoopState {
   std::vector<int> oi_map;
 
   WhileLoopState(const WhileLoopParam &params, const nnvm::Symbol &cond, const nnvm::Symbol &func) :
-                 LoopState(func),
+                 LoopState(func, params.static_alloc),
                  params(params),
                  n_iterations(0U),
-                 cond_op(LoopState::MakeSharedOp(cond)),
+                 cond_op(LoopState::MakeSharedOp(cond, params.static_alloc)),
                  oi_map(params.func_var_locs.ndim(), -1) {
     const mxnet::Tuple<dim_t> &func_input_locs = params.func_input_locs;
     const mxnet::Tuple<dim_t> &func_var_locs = params.func_var_locs;
@@ -589,6 +604,10 @@ static void WhileLoopComputeExCPU(const OpStatePtr& state_ptr,
   // construct inputs and outputs for func
   std::vector<NDArray> func_inputs, func_outputs(outputs.size());
   extract_by_loc(inputs, params.func_input_locs, &func_inputs);
+  // Without recording, the steps after the first one alternate between two sets of
+  // outputs of the shapes of the first step, so the loop states are not reallocated.
+  const bool ping_pong = state.static_alloc() && !ctx.need_grad;
+  std::vector<NDArray> step_outputs[2];
   for (size_t &step = state.n_iterations = 0; step < (size_t) params.max_iterations; ++step) {
     CHECK(inputs.size() > 0) << "while loop forward requires at least 1 input";
     Context default_ctx = inputs[0].ctx();
@@ -597,10 +616,27 @@ static void WhileLoopComputeExCPU(const OpStatePtr& state_ptr,
       break;
     }
     // we create func_outputs for the current step:
-    for (size_t i = 0; i < outputs.size(); ++i) {
-      func_outputs[i] = NDArray(outputs[i].ctx(), outputs[i].dtype());
+    if (ping_pong && step > 0) {
+      std::vector<NDArray> &bufs = step_outputs[step % 2];
+      if (bufs.empty()) {
+        for (const NDArray &arr : func_outputs) {
+          bufs.emplace_back(arr.shape(), arr.ctx(), true, arr.dtype());
+        }
+      }
+      func_outputs = bufs;
+    } else {
+      for (size_t i = 0; i < outputs.size(); ++i) {
+        func_outputs[i] = NDArray(outputs[i].ctx(), outputs[i].dtype());
+      }
     }
     state.Forward(step, func_inputs, req, func_outputs, ctx.need_grad);
+    if (ping_pong && step == 0) {
+      for (NDArray &arr : func_outputs) {
+        arr.WaitToRead();
+        if (!shape_is_known(arr.shape())) arr.SetShapeFromChunk();
+      }
+      step_outputs[0] = func_outputs;
+    }
     if (step == 0) {
       for (int i = 0; i < params.num_out_data; ++i) {
         func_outputs[i].WaitToRead();
@@ -35,6 +35,7 @@
 #include <map>
 #include <vector>
 #include <string>
+#include <unordered_set>
 #include <utility>
 #include <sstream>
 #include <thread>
@@ -51,12 +52,17 @@ namespace custom {
 
 class CustomOperator {
  public:
-  void Register(const std::string &op_type, CustomOpPropCreator creator) {
+  void Register(const std::string &op_type, CustomOpPropCreator creator, bool native = false) {
     std::lock_guard<std::mutex> lock(mutex_);
     if (registry_.find(op_type) != registry_.end()) {
       LOG(WARNING) << "New registration is overriding existing custom operator " << op_type;
     }
     registry_[op_type] = creator;
+    if (native) {
+      native_.insert(op_type);
+    } else {
+      native_.erase(op_type);
+    }
   }
 
   CustomOpPropCreator Find(const std::string &op_type) {
@@ -66,22 +72,30 @@ class CustomOperator {
     return nullptr;
   }
 
+  /*! \brief whether op_type was registered with native callbacks run inline */
+  bool IsNative(const std::string &op_type) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return native_.count(op_type) > 0;
+  }
+
   // For sparse the memory allocation is done during execution of operator
   // which leads to changing of the pointers stored by ndarray chunk.
   // Thus the changes to the copied ndarries don't propage to final
   // inputs and outputs unlike the dense case. Passing vector of inputs and
   // outputs ndarrays as args and updating the inputs and outputs ndarray
   // chunk pointers to be same as the copied ndarrays.
+  // Native operators run func inline on the calling engine worker instead of
+  // handing it to the worker pool; errors then propagate to the engine directly.
   template <typename Func>
   void Push(const Func& func, const OpContext& ctx, bool recording,
             bool training, const std::vector<NDArray>& arrs,
             const std::vector<int>& tags,
             const std::unordered_set<int>& output_tags,
             const std::vector<NDArray>& outputs,
-            const std::string op_type = "") {
-    if (naive_engine_) {
+            const std::string op_type = "", bool native = false) {
+    if (naive_engine_ || native) {
       if (profiler::Profiler::Get()->IsProfiling(profiler::Profiler::kImperative)) {
-        profiler::CustomOpProfiler::Get()->OnCustomBegin(op_type);
+        profiler::CustomOpProfiler::Get()->OnCustomBegin(op_type, native);
         func();
         profiler::CustomOpProfiler::Get()->OnCustomEnd();
       } else {
@@ -230,6 +244,7 @@ class CustomOperator {
   }
   std::mutex mutex_;
   std::map<std::string, CustomOpPropCreator> registry_;
+  std::unordered_set<std::string> native_;
   // async worker
   std::condition_variable cv_;
   std::vector<std::thread> workers_;
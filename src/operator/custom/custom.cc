@@ -39,6 +39,7 @@ struct CustomParam {
   size_t num_args, num_outs, num_auxs;
   std::vector<int> bwd_idx;
   std::shared_ptr<MXCallbackList> info;
+  bool native = false;
 };
 
 /*! \brief allocate ndarrays from existing ndarrays
@@ -92,6 +93,7 @@ void AttrParser(NodeAttrs* attrs) {
   CustomOpPropCreator creator = CustomOperator::Get()->Find(params.op_type);
   CHECK(CustomOperator::Get()->Find(params.op_type) != nullptr)
       << "Cannot find custom operator " << params.op_type;
+  params.native = CustomOperator::Get()->IsNative(params.op_type);
   params.info.reset(new MXCallbackList, [](MXCallbackList* ptr){
       reinterpret_cast<CustomOpDelFunc>(ptr->callbacks[kCustomOpPropDelete])(
         ptr->contexts[kCustomOpPropDelete]);
@@ -335,7 +337,8 @@ void ForwardEx(const OpStatePtr& state, const OpContext& ctx,
             static_cast<int>(ctx.is_train),
             params.info->contexts[kCustomOpForward]));
       },
-      ctx, false, ctx.is_train, cpys, tags, output_tags, outputs, params.op_type);
+      ctx, false, ctx.is_train, cpys, tags, output_tags, outputs, params.op_type,
+      params.native);
 }
 
 void BackwardEx(const OpStatePtr& state, const OpContext& ctx,
@@ -402,7 +405,8 @@ void BackwardEx(const OpStatePtr& state, const OpContext& ctx,
         ptrs.size(), const_cast<void**>(ptrs.data()), const_cast<int*>(tags.data()),
         reinterpret_cast<const int*>(req.data()), static_cast<int>(ctx.is_train),
         params.info->contexts[kCustomOpBackward]));
-    }, ctx, false, ctx.is_train, cpys, tags, output_tags, outputs, "_backward_" + params.op_type);
+    }, ctx, false, ctx.is_train, cpys, tags, output_tags, outputs, "_backward_" + params.op_type,
+    params.native);
 }
 
 // infer storage backward function for custom op which assigns kDefaultStorage for
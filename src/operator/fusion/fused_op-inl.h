@@ -24,8 +24,6 @@
 #include <map>
 #include <vector>
 
-#if MXNET_USE_CUDA
-
 namespace mxnet {
 
 namespace fusion {
@@ -211,6 +209,40 @@ const std::map<std::string, std::string> slice_ops = {
   {"broadcast_like"   , ""},
 };
 
+// Broadcasting binary ops, fused only when they combine the elements of a row
+// with the result of a reduction over that row
+const std::map<std::string, std::vector<std::vector<std::string>>> broadcast_ops = {
+  {"broadcast_add"                     , {{"op::add(%, %)", "_0", "_1"}}},
+  {"broadcast_plus"                    , {{"op::add(%, %)", "_0", "_1"}}},
+  {"broadcast_sub"                     , {{"op::sub(%, %)", "_0", "_1"}}},
+  {"broadcast_minus"                   , {{"op::sub(%, %)", "_0", "_1"}}},
+  {"broadcast_mul"                     , {{"op::mul(%, %)", "_0", "_1"}}},
+  {"broadcast_div"                     , {{"op::div(%, %)", "_0", "_1"}}},
+  {"broadcast_maximum"                 , {{"op::max(%, %)", "_0", "_1"}}},
+  {"broadcast_minimum"                 , {{"op::min(%, %)", "_0", "_1"}}},
+};
+
+// Reductions over the last axis: the reducer and whether the result is divided
+// by the number of reduced elements
+const std::map<std::string, std::pair<std::string, bool>> reduce_ops = {
+  {"sum"   , {"FusedRedSum", false}},
+  {"mean"  , {"FusedRedSum", true}},
+  {"max"   , {"FusedRedMax", false}},
+  {"min"   , {"FusedRedMin", false}},
+};
+
+// Ops changing the shape of their input, which rules out the row layout
+// of the fused reductions
+const std::vector<std::string> reshape_ops = {
+  "squeeze",
+  "flatten",
+  "Reshape",
+  "reshape",
+  "_backward_reshape",
+  "expand_dims",
+  "amp_multicast",
+};
+
 const std::vector<std::string> variable_io_ops = {
   "add_n",
   "_backward_Activation",
@@ -230,10 +262,66 @@ const char kernel_end[] = R"code(}
 }
 )code";
 
+// Helpers of the kernels with reductions: one block per row of the reduced
+// axis, the threads of a block stride over the row.
+const char row_kernel_support[] = R"code(
+template <typename T>
+__device__ inline T fused_inf();
+template <>
+__device__ inline float fused_inf<float>() { return __int_as_float(0x7f800000); }
+template <>
+__device__ inline double fused_inf<double>() { return __longlong_as_double(0x7ff0000000000000LL); }
+
+struct FusedRedSum {
+  template <typename T>
+  __device__ inline static T init() { return T(0); }
+  template <typename T>
+  __device__ inline static T apply(const T a, const T b) { return a + b; }
+};
+
+struct FusedRedMax {
+  template <typename T>
+  __device__ inline static T init() { return -fused_inf<T>(); }
+  template <typename T>
+  __device__ inline static T apply(const T a, const T b) { return a > b || a != a ? a : b; }
+};
+
+struct FusedRedMin {
+  template <typename T>
+  __device__ inline static T init() { return fused_inf<T>(); }
+  template <typename T>
+  __device__ inline static T apply(const T a, const T b) { return a < b || a != a ? a : b; }
+};
+
+template <typename R, typename T>
+__device__ inline T fused_block_reduce(T val) {
+  __shared__ T shared[32];
+  const int lane = threadIdx.x % 32;
+  const int warp = threadIdx.x / 32;
+  #pragma unroll
+  for (int offset = 16; offset > 0; offset /= 2) {
+    val = R::apply(val, __shfl_down_sync(0xffffffff, val, offset));
+  }
+  if (lane == 0) shared[warp] = val;
+  __syncthreads();
+  if (warp == 0) {
+    val = lane < (blockDim.x + 31) / 32 ? shared[lane] : R::template init<T>();
+    #pragma unroll
+    for (int offset = 16; offset > 0; offset /= 2) {
+      val = R::apply(val, __shfl_down_sync(0xffffffff, val, offset));
+    }
+    if (lane == 0) shared[0] = val;
+  }
+  __syncthreads();
+  val = shared[0];
+  // shared is reused by the next reduction of the same type
+  __syncthreads();
+  return val;
+}
+)code";
+
 }  // namespace fusion
 
 }  // namespace mxnet
 
-#endif  // MXNET_USE_CUDA
-
 #endif  // MXNET_OPERATOR_FUSION_FUSED_OP_INL_H_
@@ -20,15 +20,124 @@
 #include <tuple>
 
 #include "./fused_op.h"
+#include "./fused_op-inl.h"
 #include "../operator_common.h"
 #include "../../imperative/exec_pass.h"
 
-#if MXNET_USE_CUDA
-
 namespace mxnet {
 
 DMLC_REGISTER_PARAMETER(FusedOpConfig);
 
+namespace fusion {
+
+namespace {
+
+bool IsTrue(const std::string& value) {
+  return value == "True" || value == "true" || value == "1";
+}
+
+}  // namespace
+
+bool IsLastAxisReduce(const nnvm::Node* n, bool* keepdims) {
+  if (n->op() == nullptr || !reduce_ops.count(n->op()->name))
+    return false;
+  const auto& dict = n->attrs.dict;
+  auto it = dict.find("axis");
+  if (it == dict.end())
+    return false;
+  std::string axis;
+  for (const char c : it->second) {
+    if (c != '(' && c != ')' && c != '[' && c != ']' && c != ',' && c != ' ')
+      axis += c;
+  }
+  if (axis != "-1")
+    return false;
+  it = dict.find("exclude");
+  if (it != dict.end() && IsTrue(it->second))
+    return false;
+  it = dict.find("keepdims");
+  *keepdims = it != dict.end() && IsTrue(it->second);
+  return true;
+}
+
+bool InferRowKinds(const std::vector<const nnvm::Node*>& nodes, RowKinds* kinds) {
+  bool changed = true;
+  bool consistent = true;
+  auto assign = [kinds, &changed, &consistent](const nnvm::Node* n, uint32_t index, int kind) {
+    auto it = kinds->find({n, index});
+    if (it == kinds->end()) {
+      kinds->insert({{n, index}, kind});
+      changed = true;
+    } else if (it->second != kind) {
+      consistent = false;
+    }
+  };
+  auto kind_of = [kinds](const nnvm::NodeEntry& e) {
+    auto it = kinds->find({e.node.get(), e.index});
+    return it == kinds->end() ? -1 : it->second;
+  };
+  while (changed && consistent) {
+    changed = false;
+    for (const nnvm::Node* n : nodes) {
+      bool keepdims;
+      if (IsLastAxisReduce(n, &keepdims)) {
+        assign(n->inputs[0].node.get(), n->inputs[0].index, kElement);
+        assign(n, 0, keepdims ? kRow : kFlatRow);
+      } else if (broadcast_ops.count(n->op()->name)) {
+        // the elements of a row combined with a value of that row
+        assign(n, 0, kElement);
+        for (int i = 0; i < 2; ++i) {
+          const auto& e = n->inputs[i];
+          const auto& other = n->inputs[1 - i];
+          const int kind = kind_of(e);
+          if (kind == kElement) {
+            assign(other.node.get(), other.index, kRow);
+          } else if (kind == kRow) {
+            assign(other.node.get(), other.index, kElement);
+          } else if (kind == kFlatRow) {
+            consistent = false;
+          }
+        }
+      } else {
+        // everything else is elementwise, with entries of a single kind
+        int kind = -1;
+        for (const auto& e : n->inputs) {
+          if (kind_of(e) != -1) kind = kind_of(e);
+        }
+        for (uint32_t i = 0; i < n->num_outputs(); ++i) {
+          auto it = kinds->find({n, i});
+          if (it != kinds->end()) kind = it->second;
+        }
+        if (kind == -1)
+          continue;
+        for (const auto& e : n->inputs) {
+          assign(e.node.get(), e.index, kind);
+        }
+        for (uint32_t i = 0; i < n->num_outputs(); ++i) {
+          assign(n, i, kind);
+        }
+      }
+    }
+  }
+  if (!consistent)
+    return false;
+  // every entry needs a kind, for instance both operands of a broadcast
+  // coming from outside of the nodes are ambiguous
+  for (const nnvm::Node* n : nodes) {
+    for (const auto& e : n->inputs) {
+      if (kind_of(e) == -1)
+        return false;
+    }
+    for (uint32_t i = 0; i < n->num_outputs(); ++i) {
+      if (!kinds->count({n, i}))
+        return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace fusion
+
 std::mutex FusedOp::mutex_;
 
 void FusedOpParamParser(nnvm::NodeAttrs* attrs) {
@@ -56,6 +165,11 @@ FusedOp::FusedOp(const nnvm::NodeAttrs* attrs, const FusedOpConfig& config) :
   outputs_ = std::vector<FusedOpEntry>(config.num_outputs);
   subgraph_ = nnvm::Graph();
   subgraph_.outputs = attrs->subgraphs[0]->outputs;
+  has_reductions_ = false;
+  DFSVisit(subgraph_.outputs, [this](const nnvm::ObjectPtr& n) {
+    bool keepdims;
+    has_reductions_ = has_reductions_ || fusion::IsLastAxisReduce(n.get(), &keepdims);
+  });
 }
 
 bool FusedOp::InferShape(const nnvm::NodeAttrs &attrs,
@@ -301,5 +415,3 @@ NNVM_REGISTER_OP(_FusedOpOutHelper)
 .set_attr<exec::FAccessSubgraphType>("FAccessSubgraphType", FusedOpOutHelperType);
 
 }  // namespace mxnet
-
-#endif  // MXNET_USE_CUDA
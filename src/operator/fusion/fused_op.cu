@@ -507,6 +507,21 @@ std::string FusedOp::GenerateCode(const std::vector<OpReqType> &req,
     ++counter;
   }
 
+  return GenerateKernelSource(fusion::kernel_begin + std::string("\n") + code + "\n" +
+                              fusion::kernel_end,
+                              "size_t N", in_dtypes, out_dtypes, in_ndims, out_ndims,
+                              node_shapes, nvec, kernel_name);
+}
+
+std::string FusedOp::GenerateKernelSource(const std::string &body,
+                                          const std::string &scalar_params,
+                                          const std::vector<int> &in_dtypes,
+                                          const std::vector<int> &out_dtypes,
+                                          const std::vector<int> &in_ndims,
+                                          const std::vector<int> &out_ndims,
+                                          const mxnet::ShapeVector &node_shapes,
+                                          const int nvec,
+                                          const std::string &kernel_name) {
   // Add boilerplate and type information
   std::string kernel_params = "";
   std::string tensor_params = "";
@@ -560,10 +575,232 @@ std::string FusedOp::GenerateCode(const std::vector<OpReqType> &req,
   return aux_code + "\n" +
          "__launch_bounds__(" + std::to_string(FusedOp::NTHREADS) + ")\n" +
          "__global__ void FusedKernel_" + kernel_name +
-         "(size_t N, " + kernel_params + ") {\n" +
-         fusion::kernel_begin + "\n" +
-         code + "\n" +
-         fusion::kernel_end;
+         "(" + scalar_params + ", " + kernel_params + ") {\n" +
+         body;
+}
+
+std::string FusedOp::GenerateRowCode(const std::vector<OpReqType> &req,
+                                     const std::vector<int> &in_dtypes,
+                                     const std::vector<int> &out_dtypes,
+                                     const std::vector<int> &in_ndims,
+                                     const std::vector<int> &out_ndims,
+                                     const mxnet::ShapeVector &node_shapes,
+                                     const std::string &kernel_name) {
+  const auto& g = subgraph_.indexed_graph();
+  fusion::RowKinds kinds;
+  CHECK(InferRowKinds(&kinds)) << "Fused op " << kernel_name
+                               << " cannot be computed row by row";
+  auto is_row = [&g, &kinds](uint32_t nid, uint32_t index) {
+    auto it = kinds.find({g[nid].source, index});
+    return it != kinds.end() && it->second != fusion::kElement;
+  };
+
+  // An entry computed from reductions over rows whose elements are computed in
+  // the pass k has level k + 1, elements of level k are computed in the pass k.
+  std::vector<int> level(g.num_node_entries(), 0);
+  int num_passes = 1;
+  for (size_t i = 0; i < g.num_nodes(); ++i) {
+    const auto& node = g[i];
+    if (node.source->is_variable())
+      continue;
+    int node_level = 0;
+    for (const auto& e : node.inputs) {
+      node_level = std::max(node_level, level[g.entry_id(e)]);
+    }
+    if (fusion::reduce_ops.count(node.source->op()->name)) {
+      level[g.entry_id(i, 0)] = node_level + 1;
+      num_passes = std::max(num_passes, node_level + 1);
+      continue;
+    }
+    for (uint32_t j = 0; j < node.source->num_outputs(); ++j) {
+      level[g.entry_id(i, j)] = node_level;
+    }
+  }
+
+  bool use_double = false;
+  for (const auto& types : {in_dtypes, out_dtypes}) {
+    for (const int type : types) {
+      use_double = use_double || type == mshadow::kFloat64 ||
+                   type == mshadow::kInt64 || type == mshadow::kInt32;
+    }
+  }
+
+  int temp_name_counter = 0;
+  auto generate_node = [&temp_name_counter](const nnvm::IndexedGraph::Node& node, uint32_t nid,
+                                            std::map<std::pair<int, int>, std::string>* variables,
+                                            std::string* code) {
+    const std::string& op_name = node.source->op()->name;
+    const std::vector<std::vector<std::string>>* op_descs = nullptr;
+    if (fusion::ops_desc.count(op_name)) {
+      op_descs = &fusion::ops_desc.at(op_name);
+    } else if (fusion::broadcast_ops.count(op_name)) {
+      op_descs = &fusion::broadcast_ops.at(op_name);
+    } else if (op_name == "LeakyReLU") {
+      op_descs = &fusion::LeakyReLU_ops.at(node.source->attrs.dict.at("act_type"));
+    } else if (op_name == "add_n") {
+      std::string var_name = "temp" + std::to_string(temp_name_counter++);
+      *code += "auto " + var_name + " = " +
+               variables->at({node.inputs[0].node_id, node.inputs[0].index}) + ";\n";
+      for (size_t inp = 1; inp < node.inputs.size(); ++inp) {
+        *code += var_name + " = op::add(" + var_name + ", " +
+                 variables->at({node.inputs[inp].node_id, node.inputs[inp].index}) + ");\n";
+      }
+      (*variables)[{nid, 0}] = var_name;
+      return;
+    } else {
+      LOG(FATAL) << "Unrecognized op " + op_name;
+    }
+    size_t count = 0;
+    for (const auto& op_desc : *op_descs) {
+      std::string var_name = "temp" + std::to_string(temp_name_counter++);
+      const std::string& fmt = ParseOpDescription(op_desc, *variables, node);
+      *code += "const auto " + var_name + " = " + fmt + ";\n";
+      (*variables)[{nid, count}] = var_name;
+      ++count;
+    }
+  };
+
+  // Values of the rows, computed by every thread of the block
+  std::map<std::pair<int, int>, std::string> row_variables;
+  std::string code = "using AccT = " + std::string(use_double ? "double" : "float") + ";\n";
+  code += "for (size_t row = blockIdx.x; row < N; row += gridDim.x) {\n";
+  auto generate_rows = [&](int row_level) {
+    for (size_t i = 0; i < g.num_nodes(); ++i) {
+      const auto& node = g[i];
+      if (!is_row(i, 0) || level[g.entry_id(i, 0)] != row_level)
+        continue;
+      if (node.source->is_variable()) {
+        const auto& var_name = node.source->attrs.name;
+        const std::string temp = "temp" + std::to_string(temp_name_counter++);
+        code += "const auto " + temp + " = op::load(" + var_name + "[row]);\n";
+        row_variables[{i, 0}] = temp;
+      } else if (!fusion::reduce_ops.count(node.source->op()->name)) {
+        generate_node(node, i, &row_variables, &code);
+      }
+    }
+  };
+  generate_rows(0);
+
+  for (int pass = 0; pass < num_passes; ++pass) {
+    std::vector<uint32_t> reductions;
+    for (size_t i = 0; i < g.num_nodes(); ++i) {
+      const auto& node = g[i];
+      if (!node.source->is_variable() && fusion::reduce_ops.count(node.source->op()->name) &&
+          level[g.entry_id(node.inputs[0])] == pass) {
+        const std::string& reducer = fusion::reduce_ops.at(node.source->op()->name).first;
+        code += "AccT red" + std::to_string(i) + " = " + reducer + "::init<AccT>();\n";
+        reductions.push_back(i);
+      }
+    }
+    code += "for (int col = threadIdx.x; col < row_size; col += blockDim.x) {\n";
+    code += "const size_t idx = row * row_size + col;\n";
+    std::map<std::pair<int, int>, std::string> variables = row_variables;
+    for (size_t i = 0; i < g.num_nodes(); ++i) {
+      const auto& node = g[i];
+      if (is_row(i, 0))
+        continue;
+      if (node.source->is_variable()) {
+        const auto& var_name = node.source->attrs.name;
+        const std::string temp = "temp" + std::to_string(temp_name_counter++);
+        code += "const auto " + temp + " = op::load(" + var_name + "[idx]);\n";
+        variables[{i, 0}] = temp;
+      } else if (level[g.entry_id(i, 0)] <= pass) {
+        generate_node(node, i, &variables, &code);
+      }
+    }
+    for (const uint32_t i : reductions) {
+      const auto& input = g[i].inputs[0];
+      const std::string& reducer = fusion::reduce_ops.at(g[i].source->op()->name).first;
+      code += "red" + std::to_string(i) + " = " + reducer + "::apply(red" + std::to_string(i) +
+              ", static_cast<AccT>(" + variables.at({input.node_id, input.index}) + "));\n";
+    }
+    size_t counter = 0;
+    for (const auto& entry : g.outputs()) {
+      const auto var_name = "output" + std::to_string(counter++);
+      if (is_row(entry.node_id, entry.index) || level[g.entry_id(entry)] != pass)
+        continue;
+      const std::string& var = variables.at({entry.node_id, entry.index});
+      if (req[counter - 1] == kWriteTo || req[counter - 1] == kWriteInplace) {
+        code += var_name + "[idx] = op::store(" + var + ", " + var_name + ");\n";
+      } else if (req[counter - 1] == kAddTo) {
+        code += var_name + "[idx] = op::store(op::add(op::load(" + var_name + "[idx]), " +
+                var + "), " + var_name + ");\n";
+      } else if (req[counter - 1] != kNullOp) {
+        LOG(FATAL) << "Encountered unexpected req.";
+      }
+    }
+    code += "}\n";
+    for (const uint32_t i : reductions) {
+      const auto& reduce_op = fusion::reduce_ops.at(g[i].source->op()->name);
+      const std::string red = "red" + std::to_string(i);
+      const std::string temp = "temp" + std::to_string(temp_name_counter++);
+      code += red + " = fused_block_reduce<" + reduce_op.first + ">(" + red + ");\n";
+      code += "const AccT " + temp + " = " + red +
+              (reduce_op.second ? " / static_cast<AccT>(row_size)" : "") + ";\n";
+      row_variables[{i, 0}] = temp;
+    }
+    generate_rows(pass + 1);
+  }
+
+  code += "if (threadIdx.x == 0) {\n";
+  size_t counter = 0;
+  for (const auto& entry : g.outputs()) {
+    const auto var_name = "output" + std::to_string(counter++);
+    if (!is_row(entry.node_id, entry.index))
+      continue;
+    const std::string& var = row_variables.at({entry.node_id, entry.index});
+    if (req[counter - 1] == kWriteTo || req[counter - 1] == kWriteInplace) {
+      code += var_name + "[row] = op::store(" + var + ", " + var_name + ");\n";
+    } else if (req[counter - 1] == kAddTo) {
+      code += var_name + "[row] = op::store(op::add(op::load(" + var_name + "[row]), " +
+              var + "), " + var_name + ");\n";
+    } else if (req[counter - 1] != kNullOp) {
+      LOG(FATAL) << "Encountered unexpected req.";
+    }
+  }
+  code += "}\n";
+  code += "}\n";
+  code += "}\n";
+
+  return std::string(fusion::row_kernel_support) +
+         GenerateKernelSource(code, "size_t N, int row_size", in_dtypes, out_dtypes,
+                              in_ndims, out_ndims, node_shapes, 1, kernel_name);
+}
+
+bool FusedOp::InferRowKinds(fusion::RowKinds* kinds) const {
+  const auto& g = subgraph_.indexed_graph();
+  std::vector<const nnvm::Node*> nodes;
+  for (size_t i = 0; i < g.num_nodes(); ++i) {
+    if (!g[i].source->is_variable()) {
+      nodes.push_back(g[i].source);
+    }
+  }
+  return fusion::InferRowKinds(nodes, kinds);
+}
+
+void FusedOp::GetRowSize(const mxnet::ShapeVector &node_shapes,
+                         size_t* rows, int* row_size) const {
+  const auto& g = subgraph_.indexed_graph();
+  fusion::RowKinds kinds;
+  CHECK(InferRowKinds(&kinds));
+  *row_size = -1;
+  for (size_t i = 0; i < g.num_nodes(); ++i) {
+    const auto& node = g[i];
+    if (!node.source->is_variable() && fusion::reduce_ops.count(node.source->op()->name)) {
+      const auto& shape = node_shapes[g.entry_id(node.inputs[0])];
+      *row_size = shape[shape.ndim() - 1];
+      *rows = *row_size == 0 ? 0 : shape.Size() / *row_size;
+      break;
+    }
+  }
+  CHECK_GE(*row_size, 0);
+  // broadcasts along other axes than the reduced one are not fused
+  for (const auto& it : kinds) {
+    const auto& shape = node_shapes[g.entry_id(g.node_id(it.first.first), it.first.second)];
+    const size_t expected = it.second == fusion::kElement ? *rows * *row_size : *rows;
+    CHECK_EQ(shape.Size(), expected)
+      << "Inconsistent shapes in a fused reduction, set MXNET_USE_FUSION=0 to run it unfused";
+  }
 }
 
 CUfunction FusedOp::CompileCode(const std::string &code,
@@ -655,14 +892,28 @@ void FusedOp::Forward<gpu>(const nnvm::NodeAttrs& attrs,
   initialized_ = initialized_ && (req == saved_reqs_);
   saved_reqs_ = req;
 
+  if (!initialized_ && has_reductions_) {
+    const auto& code = GenerateRowCode(req, in_dtypes, out_dtypes, in_ndims, out_ndims,
+                                       node_shapes, attrs.name);
+    kernel_functions_[fusion::kGeneral] = CompileCode(code, attrs.name, dev_id);
+    initialized_ = true;
+    kernel_function_dev_id_ = dev_id;
+  }
   if (!initialized_) {
     const auto& code = GenerateCode(req, in_dtypes, out_dtypes, in_ndims, out_ndims,
                        node_shapes, node_dtypes, nvec, attrs.name, &check_shape_args_);
+    std::string optimized_code;
+    if (check_shape_args_.size() > 0) {
+      optimized_code = GenerateCode(req, in_dtypes, out_dtypes, in_ndims, out_ndims,
+                                    node_shapes, node_dtypes, nvec, attrs.name, nullptr);
+      // compiled in the background while the general kernel is compiled here
+      common::cuda::rtc::compile_function_async(optimized_code, "FusedKernel_" + attrs.name,
+                                                "", dev_id);
+    }
     kernel_functions_[fusion::kGeneral] = CompileCode(code, attrs.name, dev_id);
     if (check_shape_args_.size() > 0) {
-      const auto& code = GenerateCode(req, in_dtypes, out_dtypes, in_ndims, out_ndims,
-                           node_shapes, node_dtypes, nvec, attrs.name, nullptr);
-      kernel_functions_[fusion::kShapeOptimized] = CompileCode(code, attrs.name, dev_id);
+      kernel_functions_[fusion::kShapeOptimized] = CompileCode(optimized_code, attrs.name,
+                                                               dev_id);
     }
     initialized_ = true;
     kernel_function_dev_id_ = dev_id;
@@ -674,6 +925,10 @@ void FusedOp::Forward<gpu>(const nnvm::NodeAttrs& attrs,
                <<  ", not expecting switch to device " << dev_id;
 
   Stream<gpu>* s = ctx.get_stream<gpu>();
+  if (has_reductions_) {
+    ForwardRows(ctx, inputs, outputs, node_shapes);
+    return;
+  }
   std::vector<const void*> args;
   size_t N = 0;
   for (const auto& output : outputs) {
@@ -719,6 +974,43 @@ void FusedOp::Forward<gpu>(const nnvm::NodeAttrs& attrs,
                             0, s, &args);
 }
 
+void FusedOp::ForwardRows(const OpContext &ctx,
+                          const std::vector<TBlob> &inputs,
+                          const std::vector<TBlob> &outputs,
+                          const mxnet::ShapeVector &node_shapes) {
+  using namespace mshadow;
+  Stream<gpu>* s = ctx.get_stream<gpu>();
+  size_t rows = 0;
+  int row_size = 0;
+  GetRowSize(node_shapes, &rows, &row_size);
+  if (rows == 0)
+    return;
+  std::vector<const void*> args = {&rows, &row_size};
+
+  std::vector<void*> ptrs;
+  std::vector<std::vector<int>> shapes;
+  for (const auto &data : inputs) {
+    AddPointerAndShape(data, &ptrs, &shapes, s);
+  }
+  for (const auto &data : outputs) {
+    AddPointerAndShape(data, &ptrs, &shapes, s);
+  }
+  for (auto &tensor_shapes : shapes) {
+    args.push_back(tensor_shapes.data());
+  }
+  for (auto &ptr : ptrs) {
+    args.push_back(reinterpret_cast<void *>(&ptr));
+  }
+  // one block per row, with no more full warps than the row needs
+  const unsigned int num_blocks = std::min<size_t>(rows, 65535);
+  const int max_threads = FusedOp::NTHREADS;
+  const unsigned int num_threads = std::min(max_threads, std::max(32, (row_size + 31) / 32 * 32));
+  common::cuda::rtc::launch(kernel_functions_[fusion::kGeneral],
+                            {num_blocks, 1, 1},
+                            {num_threads, 1, 1},
+                            0, s, &args);
+}
+
 void FusedOpForwardGPU(const nnvm::NodeAttrs& attrs,
                     const OpContext &ctx,
                     const std::vector<TBlob> &inputs,
@@ -22,20 +22,49 @@
 
 #include <mxnet/operator.h>
 #include <nnvm/graph.h>
+#include <map>
+#include <memory>
 #include <vector>
 #include <string>
 #include <utility>
 #include <mutex>
 #include <tuple>
 
-#if MXNET_USE_CUDA
-
 namespace mxnet {
 
 namespace fusion {
   enum KernelVariants {kGeneral, kShapeOptimized,
     kNumKernelVariants  // Not a variant- leave this at the end
   };
+
+  /*!
+   * \brief Kinds of the entries of a subgraph fused with reductions over the
+   *        last axis: elements of the rows, or one value per row, kept as
+   *        a trailing axis of size 1 (kRow) or dropped (kFlatRow).
+   */
+  enum RowKind {kElement, kRow, kFlatRow};
+
+  /*! \brief Kind of each (node, output index) entry of a subgraph */
+  using RowKinds = std::map<std::pair<const nnvm::Node*, uint32_t>, int>;
+
+  /*!
+   * \brief Whether a node is a reduction over the last axis supported by FusedOp.
+   * \param keepdims whether the reduced axis is kept.
+   */
+  bool IsLastAxisReduce(const nnvm::Node* n, bool* keepdims);
+
+  /*!
+   * \brief Infer the kinds of the entries read and written by a set of nodes
+   *        containing reductions over the last axis.
+   * \return false when the nodes cannot be computed row by row.
+   */
+  bool InferRowKinds(const std::vector<const nnvm::Node*>& nodes, RowKinds* kinds);
+
+  /*! \brief Whether the CPU implementation of FusedOp can compute a node */
+  bool IsCPUFusionCompatible(const nnvm::Node* n);
+
+  /*! \brief Subgraph of a FusedOp compiled for the CPU interpreter */
+  struct CPUProgram;
 }
 
 struct FusedOpConfig : public dmlc::Parameter<FusedOpConfig> {
@@ -125,6 +154,7 @@ class FusedOp {
   }
 
  private:
+#if MXNET_USE_CUDA
   std::string GenerateCode(const std::vector<OpReqType> &req,
                            const std::vector<int> &in_dtypes,
                            const std::vector<int> &out_dtypes,
@@ -136,6 +166,40 @@ class FusedOp {
                            const std::string& kernel_name,
                            std::vector<uint32_t> *check_shapes);
 
+  /*!
+   * \brief Generate the kernel of a subgraph with reductions over the last axis,
+   *        computing one row per block in as many passes over the row as there
+   *        are dependent reductions.
+   */
+  std::string GenerateRowCode(const std::vector<OpReqType> &req,
+                              const std::vector<int> &in_dtypes,
+                              const std::vector<int> &out_dtypes,
+                              const std::vector<int> &in_ndims,
+                              const std::vector<int> &out_ndims,
+                              const mxnet::ShapeVector &node_shapes,
+                              const std::string& kernel_name);
+
+  /*! \brief Add the parameters and type information to the body of a kernel */
+  std::string GenerateKernelSource(const std::string &body,
+                                   const std::string &scalar_params,
+                                   const std::vector<int> &in_dtypes,
+                                   const std::vector<int> &out_dtypes,
+                                   const std::vector<int> &in_ndims,
+                                   const std::vector<int> &out_ndims,
+                                   const mxnet::ShapeVector &node_shapes,
+                                   const int nvec,
+                                   const std::string& kernel_name);
+
+  bool InferRowKinds(fusion::RowKinds* kinds) const;
+
+  /*! \brief Number and size of the rows reduced by the subgraph */
+  void GetRowSize(const mxnet::ShapeVector &node_shapes, size_t* rows, int* row_size) const;
+
+  void ForwardRows(const OpContext &ctx,
+                   const std::vector<TBlob> &inputs,
+                   const std::vector<TBlob> &outputs,
+                   const mxnet::ShapeVector &node_shapes);
+
   CUfunction CompileCode(const std::string &code,
                          const std::string &kernel_name, int dev_id);
 
@@ -146,6 +210,7 @@ class FusedOp {
                            std::vector<int> *out_dtypes,
                            std::vector<int> *out_ndims,
                            int *nvec);
+#endif  // MXNET_USE_CUDA
 
   std::vector<FusedOpEntry> inputs_;
   std::vector<FusedOpEntry> outputs_;
@@ -177,9 +242,15 @@ class FusedOp {
   std::vector<uint32_t> extra_shape_args_;
   std::vector<uint32_t> check_shape_args_;
 
+#if MXNET_USE_CUDA
   CUfunction kernel_functions_[fusion::kNumKernelVariants];
+#endif  // MXNET_USE_CUDA
+  // program run by the CPU implementation, built on its first call
+  std::shared_ptr<fusion::CPUProgram> cpu_program_;
   bool initialized_;
   int kernel_function_dev_id_;
+  // whether the subgraph contains reductions over the last axis
+  bool has_reductions_;
 
   static std::mutex mutex_;
   std::mutex my_mutex_;
@@ -200,6 +271,4 @@ using FusedOpHelperParamPtr = std::shared_ptr<FusedOpHelperParam>;
 
 }  // namespace mxnet
 
-#endif  // MXNET_USE_CUDA
-
 #endif  // MXNET_OPERATOR_FUSION_FUSED_OP_H_
@@ -0,0 +1,434 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file fused_op_cpu.cc
+ * \brief CPU implementation of FusedOp.
+ *
+ *  The subgraph is translated once into a program of elementwise instructions,
+ *  each one an mshadow_op functor applied to a chunk of elements. The elements of
+ *  a chunk go through the whole program while they stay in cache, so the inputs
+ *  and outputs are streamed through memory once instead of once per operator.
+ */
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "./fused_op.h"
+#include "../mshadow_op.h"
+#include "../operator_common.h"
+#include "../tensor/amp_cast.h"
+#include "../tensor/elemwise_unary_op.h"
+#include "../../engine/openmp.h"
+
+namespace mxnet {
+
+namespace fusion {
+
+namespace {
+
+/*! \brief Number of elements processed at once by an instruction */
+const index_t kCPUChunkSize = 512;
+
+template <typename DType>
+using CPUKernel = void (*)(const DType* a, const DType* b, DType scalar, DType* out, index_t n);
+
+template <typename OP, typename DType>
+void UnaryCPUKernel(const DType* a, const DType*, DType, DType* out, index_t n) {
+  for (index_t i = 0; i < n; ++i) out[i] = OP::Map(a[i]);
+}
+
+template <typename OP, typename DType>
+void BinaryCPUKernel(const DType* a, const DType* b, DType, DType* out, index_t n) {
+  for (index_t i = 0; i < n; ++i) out[i] = OP::Map(a[i], b[i]);
+}
+
+template <typename OP, typename DType>
+void ScalarCPUKernel(const DType* a, const DType*, DType scalar, DType* out, index_t n) {
+  for (index_t i = 0; i < n; ++i) out[i] = OP::Map(a[i], scalar);
+}
+
+/*! \brief Elementwise function available to the interpreter */
+struct CPUFunction {
+  enum Arity {kUnary, kBinary, kScalar};
+  Arity arity;
+  CPUKernel<float> f32;
+  CPUKernel<double> f64;
+};
+
+template <typename OP>
+CPUFunction Unary() {
+  return {CPUFunction::kUnary, UnaryCPUKernel<OP, float>, UnaryCPUKernel<OP, double>};
+}
+
+template <typename OP>
+CPUFunction Binary() {
+  return {CPUFunction::kBinary, BinaryCPUKernel<OP, float>, BinaryCPUKernel<OP, double>};
+}
+
+template <typename OP>
+CPUFunction Scalar() {
+  return {CPUFunction::kScalar, ScalarCPUKernel<OP, float>, ScalarCPUKernel<OP, double>};
+}
+
+/*!
+ * \brief Functions of the supported ops, Activation is looked up as
+ *        Activation/<act_type>.
+ */
+const std::unordered_map<std::string, CPUFunction>& CPUFunctions() {
+  static const std::unordered_map<std::string, CPUFunction> functions = {
+    {"elemwise_add"             , Binary<mshadow_op::plus>()},
+    {"_plus"                    , Binary<mshadow_op::plus>()},
+    {"_Plus"                    , Binary<mshadow_op::plus>()},
+    {"_add"                     , Binary<mshadow_op::plus>()},
+    {"elemwise_sub"             , Binary<mshadow_op::minus>()},
+    {"_minus"                   , Binary<mshadow_op::minus>()},
+    {"_Minus"                   , Binary<mshadow_op::minus>()},
+    {"_sub"                     , Binary<mshadow_op::minus>()},
+    {"elemwise_mul"             , Binary<mshadow_op::mul>()},
+    {"_mul"                     , Binary<mshadow_op::mul>()},
+    {"_Mul"                     , Binary<mshadow_op::mul>()},
+    {"elemwise_div"             , Binary<mshadow_op::div>()},
+    {"_div"                     , Binary<mshadow_op::div>()},
+    {"_Div"                     , Binary<mshadow_op::div>()},
+    {"_Power"                   , Binary<mshadow_op::power>()},
+    {"_power"                   , Binary<mshadow_op::power>()},
+    {"_Maximum"                 , Binary<mshadow_op::maximum>()},
+    {"_maximum"                 , Binary<mshadow_op::maximum>()},
+    {"_Minimum"                 , Binary<mshadow_op::minimum>()},
+    {"_minimum"                 , Binary<mshadow_op::minimum>()},
+    {"relu"                     , Unary<mshadow_op::relu>()},
+    {"sigmoid"                  , Unary<mshadow_op::sigmoid>()},
+    {"softsign"                 , Unary<mshadow_op::softsign>()},
+    {"exp"                      , Unary<mshadow_op::exp>()},
+    {"expm1"                    , Unary<mshadow_op::expm1>()},
+    {"log"                      , Unary<mshadow_op::log>()},
+    {"log10"                    , Unary<mshadow_op::log10>()},
+    {"log2"                     , Unary<mshadow_op::log2>()},
+    {"log1p"                    , Unary<mshadow_op::log1p>()},
+    {"sin"                      , Unary<mshadow_op::sin>()},
+    {"cos"                      , Unary<mshadow_op::cos>()},
+    {"tan"                      , Unary<mshadow_op::tan>()},
+    {"sinh"                     , Unary<mshadow_op::sinh>()},
+    {"cosh"                     , Unary<mshadow_op::cosh>()},
+    {"tanh"                     , Unary<mshadow_op::tanh>()},
+    {"sqrt"                     , Unary<mshadow_op::square_root>()},
+    {"rsqrt"                    , Unary<mshadow_op::reciprocal_square_root>()},
+    {"cbrt"                     , Unary<mshadow_op::cube_root>()},
+    {"square"                   , Unary<mshadow_op::square>()},
+    {"abs"                      , Unary<mshadow_op::abs>()},
+    {"negative"                 , Unary<mshadow_op::negation>()},
+    {"reciprocal"               , Unary<mshadow_op::reciprocal>()},
+    {"erf"                      , Unary<mshadow_op::erf>()},
+    {"floor"                    , Unary<mshadow_op::floor>()},
+    {"ceil"                     , Unary<mshadow_op::ceil>()},
+    {"trunc"                    , Unary<mshadow_op::trunc>()},
+    {"sign"                     , Unary<mshadow_op::sign>()},
+    {"_plus_scalar"             , Scalar<mshadow_op::plus>()},
+    {"_PlusScalar"              , Scalar<mshadow_op::plus>()},
+    {"_minus_scalar"            , Scalar<mshadow_op::minus>()},
+    {"_MinusScalar"             , Scalar<mshadow_op::minus>()},
+    {"_rminus_scalar"           , Scalar<mshadow_op::rminus>()},
+    {"_RMinusScalar"            , Scalar<mshadow_op::rminus>()},
+    {"_mul_scalar"              , Scalar<mshadow_op::mul>()},
+    {"_MulScalar"               , Scalar<mshadow_op::mul>()},
+    {"_div_scalar"              , Scalar<mshadow_op::div>()},
+    {"_DivScalar"               , Scalar<mshadow_op::div>()},
+    {"_rdiv_scalar"             , Scalar<mshadow_op::rdiv>()},
+    {"_RDivScalar"              , Scalar<mshadow_op::rdiv>()},
+    {"_power_scalar"            , Scalar<mshadow_op::power>()},
+    {"_PowerScalar"             , Scalar<mshadow_op::power>()},
+    {"_rpower_scalar"           , Scalar<mshadow_op::rpower>()},
+    {"_RPowerScalar"            , Scalar<mshadow_op::rpower>()},
+    {"_maximum_scalar"          , Scalar<mshadow_op::maximum>()},
+    {"_minimum_scalar"          , Scalar<mshadow_op::minimum>()},
+    {"Activation/relu"          , Unary<mshadow_op::relu>()},
+    {"Activation/sigmoid"       , Unary<mshadow_op::sigmoid>()},
+    {"Activation/tanh"          , Unary<mshadow_op::tanh>()},
+    {"Activation/softrelu"      , Unary<mshadow_op::softrelu>()},
+    {"Activation/softsign"      , Unary<mshadow_op::softsign>()},
+  };
+  return functions;
+}
+
+/*! \brief Ops passing their input through */
+const std::vector<std::string> cpu_identity_ops = {
+  "identity",
+  "_copy",
+  "squeeze",
+  "flatten",
+  "Flatten",
+  "Reshape",
+  "reshape",
+  "expand_dims",
+};
+
+const CPUFunction* GetCPUFunction(const nnvm::Node* n) {
+  const std::string& op_name = n->op()->name;
+  const auto& functions = CPUFunctions();
+  auto it = functions.find(op_name == "Activation" ?
+                           op_name + "/" + n->attrs.dict.at("act_type") : op_name);
+  return it == functions.end() ? nullptr : &it->second;
+}
+
+bool IsCPUIdentity(const nnvm::Node* n) {
+  return std::find(cpu_identity_ops.begin(), cpu_identity_ops.end(), n->op()->name) !=
+         cpu_identity_ops.end();
+}
+
+/*!
+ * \brief Target type of a cast op, or -1 if the node is not a cast.
+ *  The register value is rounded through this type, as the unfused op would do.
+ */
+int GetCPUCastType(const nnvm::Node* n) {
+  const std::string& op_name = n->op()->name;
+  if (op_name == "Cast" || op_name == "cast")
+    return nnvm::get<op::CastParam>(n->attrs.parsed).dtype;
+  if (op_name == "amp_cast")
+    return nnvm::get<op::AMPCastParam>(n->attrs.parsed).dtype;
+  return -1;
+}
+
+}  // namespace
+
+bool IsCPUFusionCompatible(const nnvm::Node* n) {
+  if (n->op() == nullptr)
+    return false;
+  // bfloat16 is not handled by the registers conversions, so such a cast ends the region
+  const int cast_type = GetCPUCastType(n);
+  if (cast_type != -1)
+    return cast_type != mshadow::kBfloat16;
+  return GetCPUFunction(n) != nullptr || IsCPUIdentity(n) || n->op()->name == "add_n";
+}
+
+struct CPUProgram {
+  struct Instruction {
+    // nullptr for a cast, which converts lhs through cast_type
+    const CPUFunction* function;
+    uint32_t lhs;
+    uint32_t rhs;
+    uint32_t out;
+    double scalar;
+    int cast_type;
+  };
+  std::vector<Instruction> instructions;
+  // registers holding the inputs and the outputs of the subgraph
+  std::vector<uint32_t> inputs;
+  std::vector<uint32_t> outputs;
+  uint32_t num_registers = 0;
+
+  explicit CPUProgram(const nnvm::IndexedGraph& g) {
+    std::vector<uint32_t> uses(g.num_node_entries(), 0);
+    for (size_t i = 0; i < g.num_nodes(); ++i) {
+      for (const auto& e : g[i].inputs) ++uses[g.entry_id(e)];
+    }
+    // the outputs are stored at the end of the program
+    for (const auto& e : g.outputs()) ++uses[g.entry_id(e)];
+
+    std::vector<uint32_t> reg(g.num_node_entries(), 0);
+    std::vector<uint32_t> reg_uses;
+    std::vector<uint32_t> free_regs;
+    auto alloc = [this, &reg_uses, &free_regs](uint32_t n_uses) {
+      uint32_t r;
+      if (free_regs.empty()) {
+        r = num_registers++;
+        reg_uses.push_back(0);
+      } else {
+        r = free_regs.back();
+        free_regs.pop_back();
+      }
+      reg_uses[r] = n_uses;
+      if (n_uses == 0) free_regs.push_back(r);
+      return r;
+    };
+    auto release = [&reg_uses, &free_regs](uint32_t r) {
+      if (--reg_uses[r] == 0) free_regs.push_back(r);
+    };
+
+    for (size_t i = 0; i < g.num_nodes(); ++i) {
+      const auto& node = g[i];
+      const uint32_t out = g.entry_id(i, 0);
+      if (node.source->is_variable()) {
+        reg[out] = alloc(uses[out]);
+        inputs.push_back(reg[out]);
+        continue;
+      }
+      CHECK_EQ(node.source->num_outputs(), 1U);
+      if (IsCPUIdentity(node.source)) {
+        // the output shares the register of the input
+        const uint32_t r = reg[g.entry_id(node.inputs[0])];
+        reg_uses[r] += uses[out];
+        reg[out] = r;
+        release(r);
+        continue;
+      }
+      std::vector<uint32_t> in_regs;
+      for (const auto& e : node.inputs) in_regs.push_back(reg[g.entry_id(e)]);
+      if (node.source->op()->name == "add_n") {
+        // the sum is accumulated in the output, which must not overwrite an input
+        reg[out] = alloc(uses[out]);
+        const CPUFunction& plus = CPUFunctions().at("elemwise_add");
+        const CPUFunction& plus_scalar = CPUFunctions().at("_plus_scalar");
+        instructions.push_back({&plus_scalar, in_regs[0], in_regs[0], reg[out], 0, -1});
+        for (size_t k = 1; k < in_regs.size(); ++k) {
+          instructions.push_back({&plus, reg[out], in_regs[k], reg[out], 0, -1});
+        }
+        for (const uint32_t r : in_regs) release(r);
+        continue;
+      }
+      // instructions are elementwise, so the output may reuse an input register
+      for (const uint32_t r : in_regs) release(r);
+      reg[out] = alloc(uses[out]);
+      const int cast_type = GetCPUCastType(node.source);
+      if (cast_type != -1) {
+        instructions.push_back({nullptr, in_regs[0], in_regs[0], reg[out], 0, cast_type});
+        continue;
+      }
+      const CPUFunction* function = GetCPUFunction(node.source);
+      CHECK(function != nullptr) << "Unsupported op " << node.source->op()->name;
+      double scalar = 0;
+      if (function->arity == CPUFunction::kScalar) {
+        scalar = std::stod(node.source->attrs.dict.at("scalar"));
+      }
+      instructions.push_back({function, in_regs[0], in_regs.back(), reg[out], scalar, -1});
+    }
+    for (const auto& e : g.outputs()) outputs.push_back(reg[g.entry_id(e)]);
+  }
+
+  template <typename AccT>
+  void Run(const std::vector<TBlob>& in_data, const std::vector<OpReqType>& req,
+           const std::vector<TBlob>& out_data, index_t size) const {
+    const index_t num_chunks = (size + kCPUChunkSize - 1) / kCPUChunkSize;
+    const int nthreads = num_chunks > 1 ?
+        engine::OpenMP::Get()->GetRecommendedOMPThreadCount() : 1;
+    #pragma omp parallel num_threads(nthreads)
+    {
+      std::vector<AccT> registers(num_registers * kCPUChunkSize);
+      #pragma omp for
+      for (index_t c = 0; c < num_chunks; ++c) {
+        const index_t begin = c * kCPUChunkSize;
+        const index_t n = std::min(kCPUChunkSize, size - begin);
+        // all the inputs are loaded first, so that outputs can be written in place
+        for (size_t k = 0; k < inputs.size(); ++k) {
+          AccT* dst = &registers[inputs[k] * kCPUChunkSize];
+          MSHADOW_TYPE_SWITCH_WITH_BOOL(in_data[k].type_flag_, DType, {
+            const DType* src = in_data[k].dptr<DType>() + begin;
+            for (index_t i = 0; i < n; ++i) dst[i] = static_cast<AccT>(src[i]);
+          });
+        }
+        for (const auto& ins : instructions) {
+          if (ins.function == nullptr) {
+            const AccT* src = &registers[ins.lhs * kCPUChunkSize];
+            AccT* dst = &registers[ins.out * kCPUChunkSize];
+            MSHADOW_TYPE_SWITCH_WITH_BOOL(ins.cast_type, DType, {
+              for (index_t i = 0; i < n; ++i) {
+                dst[i] = static_cast<AccT>(static_cast<DType>(src[i]));
+              }
+            });
+            continue;
+          }
+          const CPUKernel<AccT> kernel = GetKernel<AccT>(*ins.function);
+          kernel(&registers[ins.lhs * kCPUChunkSize], &registers[ins.rhs * kCPUChunkSize],
+                 static_cast<AccT>(ins.scalar), &registers[ins.out * kCPUChunkSize], n);
+        }
+        for (size_t k = 0; k < outputs.size(); ++k) {
+          if (req[k] == kNullOp) continue;
+          const AccT* src = &registers[outputs[k] * kCPUChunkSize];
+          MSHADOW_TYPE_SWITCH_WITH_BOOL(out_data[k].type_flag_, DType, {
+            DType* dst = out_data[k].dptr<DType>() + begin;
+            if (req[k] == kAddTo) {
+              for (index_t i = 0; i < n; ++i) {
+                dst[i] = static_cast<DType>(static_cast<AccT>(dst[i]) + src[i]);
+              }
+            } else {
+              for (index_t i = 0; i < n; ++i) dst[i] = static_cast<DType>(src[i]);
+            }
+          });
+        }
+      }
+    }
+  }
+
+  template <typename AccT>
+  static CPUKernel<AccT> GetKernel(const CPUFunction& function);
+};
+
+template <>
+CPUKernel<float> CPUProgram::GetKernel<float>(const CPUFunction& function) {
+  return function.f32;
+}
+
+template <>
+CPUKernel<double> CPUProgram::GetKernel<double>(const CPUFunction& function) {
+  return function.f64;
+}
+
+}  // namespace fusion
+
+template <>
+void FusedOp::Forward<cpu>(const nnvm::NodeAttrs& attrs,
+                           const OpContext &ctx,
+                           const std::vector<TBlob> &inputs,
+                           const std::vector<OpReqType> &req,
+                           const std::vector<TBlob> &outputs) {
+  std::shared_ptr<fusion::CPUProgram> program;
+  {
+    std::lock_guard<std::mutex> lock(my_mutex_);
+    if (!cpu_program_) {
+      cpu_program_ = std::make_shared<fusion::CPUProgram>(subgraph_.indexed_graph());
+    }
+    program = cpu_program_;
+    // the CPU implementation does not need the attributes of the subgraph
+    intermediate_shapes_.clear();
+    intermediate_dtypes_.clear();
+  }
+  CHECK_EQ(inputs.size(), program->inputs.size());
+  CHECK_EQ(outputs.size(), program->outputs.size());
+  const index_t size = outputs[0].Size();
+  bool use_double = false;
+  for (const auto& blobs : {inputs, outputs}) {
+    for (const TBlob& blob : blobs) {
+      CHECK_EQ(blob.Size(), size) << "Fused op " << attrs.name
+                                  << " expects inputs and outputs of the same size";
+      use_double = use_double || blob.type_flag_ == mshadow::kFloat64 ||
+                   blob.type_flag_ == mshadow::kInt64 || blob.type_flag_ == mshadow::kInt32;
+    }
+  }
+  if (size == 0)
+    return;
+  if (use_double) {
+    program->Run<double>(inputs, req, outputs, size);
+  } else {
+    program->Run<float>(inputs, req, outputs, size);
+  }
+}
+
+void FusedOpForwardCPU(const nnvm::NodeAttrs& attrs,
+                       const OpContext &ctx,
+                       const std::vector<TBlob> &inputs,
+                       const std::vector<OpReqType> &req,
+                       const std::vector<TBlob> &outputs) {
+  const FusedOpPtr& op = nnvm::get<FusedOpPtr>(attrs.parsed);
+  op->Forward<cpu>(attrs, ctx, inputs, req, outputs);
+}
+
+NNVM_REGISTER_OP(_FusedOp)
+.set_attr<FCompute>("FCompute<cpu>", FusedOpForwardCPU);
+
+}  // namespace mxnet
@@ -0,0 +1,212 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*!
+ * \file resize_normalize-inl.h
+ * \brief fused to_tensor, bilinear resize and normalize of a ragged batch of images
+ */
+#ifndef MXNET_OPERATOR_IMAGE_RESIZE_NORMALIZE_INL_H_
+#define MXNET_OPERATOR_IMAGE_RESIZE_NORMALIZE_INL_H_
+
+#include <mxnet/base.h>
+#include <algorithm>
+#include <vector>
+
+#include "../mxnet_op.h"
+#include "../operator_common.h"
+#include "image_utils.h"
+
+namespace mxnet {
+namespace op {
+namespace image {
+
+namespace batch_resize_normalize {
+enum BatchResizeNormalizeInputs {kData, kOffsets, kShapes};
+}  // namespace batch_resize_normalize
+
+struct BatchResizeNormalizeParam : public dmlc::Parameter<BatchResizeNormalizeParam> {
+  mxnet::Tuple<int> size;
+  mxnet::Tuple<float> mean;
+  mxnet::Tuple<float> std;
+  int channels;
+  int dtype;
+  DMLC_DECLARE_PARAMETER(BatchResizeNormalizeParam) {
+    DMLC_DECLARE_FIELD(size)
+    .describe("Size of the output images. Could be (width, height) or (size)");
+    DMLC_DECLARE_FIELD(mean)
+    .set_default(mxnet::Tuple<float> {0.0f, 0.0f, 0.0f})
+    .describe("Sequence of means for each channel, applied after scaling to [0, 1). "
+              "Default value is 0.");
+    DMLC_DECLARE_FIELD(std)
+    .set_default(mxnet::Tuple<float> {1.0f, 1.0f, 1.0f})
+    .describe("Sequence of standard deviations for each channel. "
+              "Default value is 1.");
+    DMLC_DECLARE_FIELD(channels)
+    .set_default(3)
+    .describe("Number of channels of the images, 1 or 3.");
+    DMLC_DECLARE_FIELD(dtype)
+    .add_enum("float32", mshadow::kFloat32)
+    .add_enum("float16", mshadow::kFloat16)
+    .set_default(mshadow::kFloat32)
+    .describe("Data type of the output.");
+  }
+};
+
+inline SizeParam GetBatchOutputSize(const BatchResizeNormalizeParam& param) {
+  CHECK((param.size.ndim() == 1) || (param.size.ndim() == 2))
+      << "Output size dimension must be 1 or 2, but got " << param.size.ndim();
+  for (int i = 0; i < param.size.ndim(); ++i) {
+    CHECK_GT(param.size[i], 0) << "Output size should be greater than 0, but got "
+                               << param.size;
+  }
+  if (param.size.ndim() == 1) return SizeParam(param.size[0], param.size[0]);
+  return SizeParam(param.size[1], param.size[0]);
+}
+
+inline bool BatchResizeNormalizeShape(const nnvm::NodeAttrs& attrs,
+                                      mxnet::ShapeVector *in_attrs,
+                                      mxnet::ShapeVector *out_attrs) {
+  using namespace batch_resize_normalize;
+  const BatchResizeNormalizeParam& param = nnvm::get<BatchResizeNormalizeParam>(attrs.parsed);
+  CHECK_EQ(in_attrs->size(), 3U);
+  CHECK_EQ(out_attrs->size(), 1U);
+  CHECK(param.channels == 1 || param.channels == 3)
+      << "channels must be 1 or 3, but got " << param.channels;
+  CHECK(param.mean.ndim() == 1 || param.mean.ndim() == param.channels)
+      << "mean must have either 1 or " << param.channels << " elements, but got "
+      << param.mean;
+  CHECK(param.std.ndim() == 1 || param.std.ndim() == param.channels)
+      << "std must have either 1 or " << param.channels << " elements, but got "
+      << param.std;
+  const mxnet::TShape& oshape = (*in_attrs)[kOffsets];
+  const mxnet::TShape& sshape = (*in_attrs)[kShapes];
+  if (!ndim_is_known(oshape) && !ndim_is_known(sshape)) return false;
+  const int num_images = ndim_is_known(oshape) ? oshape[0] : sshape[0];
+  SHAPE_ASSIGN_CHECK(*in_attrs, kOffsets, mxnet::TShape({num_images}));
+  SHAPE_ASSIGN_CHECK(*in_attrs, kShapes, mxnet::TShape({num_images, 2}));
+  if (ndim_is_known((*in_attrs)[kData])) {
+    CHECK_EQ((*in_attrs)[kData].ndim(), 1U)
+        << "data must hold the flattened (height, width, channels) images one after "
+        << "the other, but got shape " << (*in_attrs)[kData];
+  }
+  const SizeParam size = GetBatchOutputSize(param);
+  SHAPE_ASSIGN_CHECK(*out_attrs, 0,
+                     mxnet::TShape({num_images, param.channels, size.height, size.width}));
+  return true;
+}
+
+inline bool BatchResizeNormalizeType(const nnvm::NodeAttrs& attrs,
+                                     std::vector<int> *in_attrs,
+                                     std::vector<int> *out_attrs) {
+  using namespace batch_resize_normalize;
+  const BatchResizeNormalizeParam& param = nnvm::get<BatchResizeNormalizeParam>(attrs.parsed);
+  CHECK_EQ(in_attrs->size(), 3U);
+  CHECK_EQ(out_attrs->size(), 1U);
+  TYPE_ASSIGN_CHECK(*in_attrs, kData, mshadow::kUint8);
+  TYPE_ASSIGN_CHECK(*in_attrs, kOffsets, mshadow::kInt64);
+  TYPE_ASSIGN_CHECK(*in_attrs, kShapes, mshadow::kInt64);
+  TYPE_ASSIGN_CHECK(*out_attrs, 0, param.dtype);
+  return true;
+}
+
+/*!
+ * \brief Bilinearly resize, scale to [0, 1) and normalize one output pixel of a batch
+ *  of images of varying sizes, with the half-pixel centers of the resize operator.
+ *  Image n starts at data + offsets[n] and has shape (shapes[2n], shapes[2n+1], C).
+ *  Each thread writes the C channels of its pixel of the (N, C, H, W) output.
+ */
+template<int req>
+struct batch_resize_normalize_forward {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(index_t i, DType* out, const uint8_t* data,
+                                  const int64_t* offsets, const int64_t* shapes,
+                                  const int channels, const int out_h, const int out_w,
+                                  const float mean_d0, const float mean_d1,
+                                  const float mean_d2, const float inv_std_d0,
+                                  const float inv_std_d1, const float inv_std_d2) {
+    const index_t x = i % out_w;
+    const index_t y = (i / out_w) % out_h;
+    const index_t n = i / (out_w * out_h);
+    const int in_h = static_cast<int>(shapes[2 * n]);
+    const int in_w = static_cast<int>(shapes[2 * n + 1]);
+    const uint8_t* image = data + offsets[n];
+
+    float src_y = (y + 0.5f) * in_h / out_h - 0.5f;
+    src_y = src_y > 0 ? src_y : 0;
+    const int y0 = static_cast<int>(src_y);
+    const int y1 = y0 < in_h - 1 ? y0 + 1 : y0;
+    const float ly = src_y - y0;
+    float src_x = (x + 0.5f) * in_w / out_w - 0.5f;
+    src_x = src_x > 0 ? src_x : 0;
+    const int x0 = static_cast<int>(src_x);
+    const int x1 = x0 < in_w - 1 ? x0 + 1 : x0;
+    const float lx = src_x - x0;
+
+    const uint8_t* p00 = image + (y0 * in_w + x0) * channels;
+    const uint8_t* p01 = image + (y0 * in_w + x1) * channels;
+    const uint8_t* p10 = image + (y1 * in_w + x0) * channels;
+    const uint8_t* p11 = image + (y1 * in_w + x1) * channels;
+    const index_t plane = static_cast<index_t>(out_h) * out_w;
+    DType* dst = out + n * channels * plane + y * out_w + x;
+    for (int c = 0; c < channels; ++c) {
+      const float v = (1 - ly) * ((1 - lx) * p00[c] + lx * p01[c]) +
+                      ly * ((1 - lx) * p10[c] + lx * p11[c]);
+      const float mean = c == 0 ? mean_d0 : (c == 1 ? mean_d1 : mean_d2);
+      const float inv_std = c == 0 ? inv_std_d0 : (c == 1 ? inv_std_d1 : inv_std_d2);
+      KERNEL_ASSIGN(dst[c * plane], req, DType((v / 255.0f - mean) * inv_std));
+    }
+  }
+};
+
+template<typename xpu>
+void BatchResizeNormalizeForward(const nnvm::NodeAttrs &attrs,
+                                 const OpContext &ctx,
+                                 const std::vector<TBlob> &inputs,
+                                 const std::vector<OpReqType> &req,
+                                 const std::vector<TBlob> &outputs) {
+  using namespace batch_resize_normalize;
+  using namespace mxnet_op;
+  CHECK_EQ(inputs.size(), 3U);
+  CHECK_EQ(outputs.size(), 1U);
+  CHECK_NE(req[0], kAddTo) << "batch_resize_normalize does not support kAddTo";
+  if (req[0] == kNullOp || outputs[0].Size() == 0) return;
+  const BatchResizeNormalizeParam& param = nnvm::get<BatchResizeNormalizeParam>(attrs.parsed);
+  mshadow::Stream<xpu> *s = ctx.get_stream<xpu>();
+  const SizeParam size = GetBatchOutputSize(param);
+  float mean[3], inv_std[3];
+  for (int c = 0; c < 3; ++c) {
+    mean[c] = param.mean[param.mean.ndim() == 1 ? 0 : std::min(c, param.mean.ndim() - 1)];
+    inv_std[c] = 1.0f / param.std[param.std.ndim() == 1 ? 0 : std::min(c, param.std.ndim() - 1)];
+  }
+  const index_t num_pixels = outputs[0].shape_[0] * size.height * size.width;
+  MSHADOW_TYPE_SWITCH(outputs[0].type_flag_, DType, {
+    MXNET_ASSIGN_REQ_SWITCH(req[0], req_type, {
+      Kernel<batch_resize_normalize_forward<req_type>, xpu>::Launch(
+          s, num_pixels, outputs[0].dptr<DType>(), inputs[kData].dptr<uint8_t>(),
+          inputs[kOffsets].dptr<int64_t>(), inputs[kShapes].dptr<int64_t>(),
+          param.channels, size.height, size.width,
+          mean[0], mean[1], mean[2], inv_std[0], inv_std[1], inv_std[2]);
+    });
+  });
+}
+
+}  // namespace image
+}  // namespace op
+}  // namespace mxnet
+
+#endif  // MXNET_OPERATOR_IMAGE_RESIZE_NORMALIZE_INL_H_
@@ -0,0 +1,79 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*!
+ * \file resize_normalize.cc
+ * \brief fused to_tensor, resize and normalize of a ragged batch of images, cpu
+ */
+#include <mxnet/base.h>
+#include <string>
+#include <vector>
+#include "./resize_normalize-inl.h"
+#include "../operator_common.h"
+#include "../elemwise_op_common.h"
+
+namespace mxnet {
+namespace op {
+namespace image {
+
+DMLC_REGISTER_PARAMETER(BatchResizeNormalizeParam);
+
+NNVM_REGISTER_OP(_image_batch_resize_normalize)
+.add_alias("_npx__image_batch_resize_normalize")
+.describe(R"code(Resize a batch of uint8 images of different sizes to the same size, and
+convert them to a normalized float tensor of shape (N x C x H x W).
+
+This fuses ``to_tensor``, bilinear ``resize`` and ``normalize``: for each pixel
+of each channel ``c``, the output is ``(resized / 255 - mean[c]) / std[c]``.
+
+The images are passed flattened one after the other in ``data``. Image ``n``
+starts at ``data[offsets[n]]`` and has shape ``(shapes[n][0], shapes[n][1], C)``.
+The images do not have to be padded, and are processed in a single pass.
+
+Example:
+    .. code-block:: python
+        a = mx.nd.random.uniform(0, 255, (4, 6, 3)).astype('uint8')
+        b = mx.nd.random.uniform(0, 255, (8, 2, 3)).astype('uint8')
+        data = mx.nd.concat(a.reshape(-1), b.reshape(-1), dim=0)
+        offsets = mx.nd.array([0, a.size], dtype='int64')
+        shapes = mx.nd.array([[4, 6], [8, 2]], dtype='int64')
+        out = mx.nd.image.batch_resize_normalize(data, offsets, shapes, size=(5, 5),
+                                                 mean=(0.485, 0.456, 0.406),
+                                                 std=(0.229, 0.224, 0.225))
+        out.shape
+            (2, 3, 5, 5)
+)code" ADD_FILELINE)
+.set_num_inputs(3)
+.set_num_outputs(1)
+.set_attr_parser(ParamParser<BatchResizeNormalizeParam>)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    return std::vector<std::string>{"data", "offsets", "shapes"};
+  })
+.set_attr<mxnet::FInferShape>("FInferShape", BatchResizeNormalizeShape)
+.set_attr<nnvm::FInferType>("FInferType", BatchResizeNormalizeType)
+.set_attr<FCompute>("FCompute<cpu>", BatchResizeNormalizeForward<cpu>)
+.set_attr<nnvm::FGradient>("FGradient", MakeZeroGradNodes)
+.add_argument("data", "NDArray-or-Symbol", "The flattened uint8 images, one after the other.")
+.add_argument("offsets", "NDArray-or-Symbol", "The start of each image in data.")
+.add_argument("shapes", "NDArray-or-Symbol", "The (height, width) of each image.")
+.add_arguments(BatchResizeNormalizeParam::__FIELDS__());
+
+}  // namespace image
+}  // namespace op
+}  // namespace mxnet
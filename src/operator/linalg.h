@@ -192,6 +192,20 @@ int linalg_syevd_workspace_query(const Tensor<xpu, 2, DType>& A,
                                  const Tensor<xpu, 1, DType>& L,
                                  Stream<xpu> *s = 0);
 
+// Batched version of syevd, the rows of L are the eigenvalues of the matrices of A.
+template<typename xpu, typename DType>
+void linalg_batch_syevd(const Tensor<xpu, 3, DType>& A,
+                        const Tensor<xpu, 2, DType>& L,
+                        const Tensor<xpu, 1, DType>& work,
+                        Stream<xpu> *s = 0);
+
+// This function determines the amount of workspace needed for linalg_batch_syevd
+// which is returned as number of elements of type DType.
+template<typename xpu, typename DType>
+int linalg_batch_syevd_workspace_query(const Tensor<xpu, 3, DType>& A,
+                                       const Tensor<xpu, 2, DType>& L,
+                                       Stream<xpu> *s = 0);
+
 //////////////////////////////// GESVD ////////////////////////////////////////////
 
 // CPU/GPU-versions of LAPACK function "gesvd". Please refer to the
@@ -44,6 +44,22 @@ inline void linalg_check_batch_size(int A, int B, int C) {
   Storage::Handle var = Storage::Get()->Alloc(sizeof(dtype) * size, Context::GPU()); \
   var.profiler_scope = "<ephemeral>:"; \
   var.name = #func"_"#var;
+
+// Batches of matrices up to this size are factorized by one thread per matrix in registers.
+const int kLinalgSmallSize = 4;
+// Batches of matrices up to this size are factorized by the batched routines of
+// cuBLAS/cuSOLVER instead of one call per matrix.
+const int kLinalgBatchedMaxSize = 32;
+
+// "getrfBatched" and "getriBatched" in cuBLAS must have DType *matrices[] as input
+// to store the pointers of each batch matrix. This kernel is used to build the
+// pointer array.
+struct set_matrix {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(int i, DType **p, DType *m, int step) {
+    p[i] = m + i * step;
+  }
+};
 #endif
 
 //////////////////////////////// GEMM ////////////////////////////////////////////
@@ -798,6 +814,133 @@ void linalg_potrf<gpu, DType>(const Tensor<gpu, 2, DType>& A, bool lower, Stream
 LINALG_GPU_POTRF(DnSpotrf, float)
 LINALG_GPU_POTRF(DnDpotrf, double)
 
+// Cholesky factorization of a batch of N x N matrices, one matrix per thread held
+// in registers. Only the triangle of the factor is read and written.
+template<int N, typename DType>
+__global__ void linalgBatchPotrfSmallGPU(DType *a, int nbatch, int stride, int mstride,
+                                         bool lower) {
+  for (int b = blockIdx.x * blockDim.x + threadIdx.x; b < nbatch; b += blockDim.x * gridDim.x) {
+    DType *m = a + b * mstride;
+    DType l[N][N];
+    #pragma unroll
+    for (int i = 0; i < N; ++i) {
+      #pragma unroll
+      for (int j = 0; j <= i; ++j) {
+        l[i][j] = (lower ? m[i * stride + j] : m[j * stride + i]);
+      }
+    }
+    #pragma unroll
+    for (int j = 0; j < N; ++j) {
+      DType d(l[j][j]);
+      #pragma unroll
+      for (int k = 0; k < j; ++k) {
+        d -= l[j][k] * l[j][k];
+      }
+      d = sqrt(d);
+      l[j][j] = d;
+      #pragma unroll
+      for (int i = j + 1; i < N; ++i) {
+        DType v(l[i][j]);
+        #pragma unroll
+        for (int k = 0; k < j; ++k) {
+          v -= l[i][k] * l[j][k];
+        }
+        l[i][j] = v / d;
+      }
+    }
+    #pragma unroll
+    for (int i = 0; i < N; ++i) {
+      #pragma unroll
+      for (int j = 0; j <= i; ++j) {
+        (lower ? m[i * stride + j] : m[j * stride + i]) = l[i][j];
+      }
+    }
+  }
+}
+
+// Mirrors the upper triangles of a batch of matrices into their lower triangles.
+template<typename DType>
+__global__ void linalgCopyUpperToLowerGPU(DType *a, int stride, int lda, int N) {
+  for (int i = blockIdx.x * blockDim.x + threadIdx.x; i < N; i += blockDim.x * gridDim.x) {
+    // index relative to the matrix.
+    const int index(i % stride), row(index / lda), col(index % lda);
+    if (row > col) {
+      a[i] = a[i - index + col * lda + row];
+    }
+  }
+}
+
+// Factorizes batches of small matrices with linalgBatchPotrfSmallGPU, returns false
+// if the size of the matrices is not supported.
+template<typename DType>
+inline bool linalg_batch_potrf_small(const Tensor<gpu, 3, DType>& A, bool lower,
+                                     Stream<gpu> *s) {
+  using namespace mshadow::cuda;
+  const int nbatch(A.size(0)), mstride(A.size(1) * A.stride_);
+  const int ngrid = std::min(kMaxGridNum, (nbatch + kBaseThreadNum - 1) / kBaseThreadNum);
+  cudaStream_t stream = Stream<gpu>::GetStream(s);
+  switch (A.size(1)) {
+#define LINALG_GPU_POTRF_SMALL_CASE(N) \
+  case N: \
+    linalgBatchPotrfSmallGPU<N><<<ngrid, kBaseThreadNum, 0, stream>>> \
+      (A.dptr_, nbatch, A.stride_, mstride, lower); \
+    break;
+  LINALG_GPU_POTRF_SMALL_CASE(1)
+  LINALG_GPU_POTRF_SMALL_CASE(2)
+  LINALG_GPU_POTRF_SMALL_CASE(3)
+  LINALG_GPU_POTRF_SMALL_CASE(4)
+#undef LINALG_GPU_POTRF_SMALL_CASE
+  default:
+    return false;
+  }
+  MSHADOW_CUDA_POST_KERNEL_CHECK(linalgBatchPotrfSmallGPU);
+  return true;
+}
+
+// Batched potrf of cuSOLVER only available with cuda 9.1 or higher.
+#if CUDA_VERSION >= 9010
+
+// The batched routine supports the lower triangle only. The col-major lower triangle
+// is the row-major upper one, so row-major lower factors are obtained by mirroring.
+#define LINALG_GPU_BATCH_POTRF_BATCHED(fname, DType) \
+inline void linalg_batch_potrf_batched(const Tensor<gpu, 3, DType>& A, bool lower, \
+                                       Stream<gpu> *s) { \
+  using namespace mxnet; \
+  using namespace mxnet::op::mxnet_op; \
+  using namespace mshadow::cuda; \
+  EPHEMERAL_GPU_STORAGE_ALLOC(linalg_batch_potrf, info, int, A.size(0)); \
+  EPHEMERAL_GPU_STORAGE_ALLOC(linalg_batch_potrf, A_ptr_buf, DType *, A.size(0)); \
+  DType **A_ptr = static_cast<DType **>(A_ptr_buf.dptr); \
+  Kernel<set_matrix, gpu>::Launch(s, A.size(0), A_ptr, A.dptr_, A.size(1) * A.stride_); \
+  CUSOLVER_CALL(cusolver##fname(Stream<gpu>::GetSolverHandle(s), CUBLAS_FILL_MODE_LOWER, \
+                                A.size(1), A_ptr, A.stride_, static_cast<int *>(info.dptr), \
+                                A.size(0))); \
+  if (lower) { \
+    int ngrid = std::min(kMaxGridNum, \
+                         static_cast<int>((A.MSize() + kBaseThreadNum - 1) / kBaseThreadNum)); \
+    linalgCopyUpperToLowerGPU<<<ngrid, kBaseThreadNum, 0, Stream<gpu>::GetStream(s)>>> \
+      (A.dptr_, A.size(1) * A.stride_, A.stride_, A.MSize()); \
+    MSHADOW_CUDA_POST_KERNEL_CHECK(linalgCopyUpperToLowerGPU); \
+  } \
+  Storage::Get()->Free(info); \
+  Storage::Get()->Free(A_ptr_buf); \
+}
+
+#else
+
+#define LINALG_GPU_BATCH_POTRF_BATCHED(fname, DType) \
+inline void linalg_batch_potrf_batched(const Tensor<gpu, 3, DType>& A, bool lower, \
+                                       Stream<gpu> *s) { \
+  LOG(FATAL) << "batched potrf requires CUDA version >= 9.1!"; \
+}
+
+#endif  // CUDA_VERSION >= 9010
+
+LINALG_GPU_BATCH_POTRF_BATCHED(DnSpotrfBatched, float)
+LINALG_GPU_BATCH_POTRF_BATCHED(DnDpotrfBatched, double)
+
+// Small matrices are factorized in registers, batches of moderately sized matrices
+// by the batched routine, large ones by one call per matrix.
 #define LINALG_GPU_BATCH_POTRF(fname, DType) \
 template<> inline \
 void linalg_batch_potrf<gpu, DType>(const Tensor<gpu, 3, DType>& A, bool lower, Stream<gpu> *s) { \
@@ -806,6 +949,13 @@ void linalg_batch_potrf<gpu, DType>(const Tensor<gpu, 3, DType>& A, bool lower,
   CHECK_NOTNULL(s); \
   CHECK_GT(A.size(0), 0); \
   check_potrf(A[0], lower); \
+  if (A.size(1) <= kLinalgSmallSize && linalg_batch_potrf_small(A, lower, s)) { \
+    return; \
+  } \
+  if (CUDA_VERSION >= 9010 && A.size(0) > 1 && A.size(1) <= kLinalgBatchedMaxSize) { \
+    linalg_batch_potrf_batched(A, lower, s); \
+    return; \
+  } \
   int buffsize(linalg_potrf_buffsize(A[0], lower, s)); \
   EPHEMERAL_GPU_STORAGE_ALLOC(linalg_batch_potrf, buffer, \
       DType, buffsize); \
@@ -1299,6 +1449,109 @@ LINALG_GPU_SYEVD_WORKSPACE_QUERY(DnDsyevd, double)
 
 #endif  // __CUDACC__
 
+// Batched versions of "syevd", by one call per matrix unless a batched routine applies.
+#define LINALG_XPU_BATCH_SYEVD(xpu, DType) \
+template<> inline \
+void linalg_batch_syevd<xpu, DType>(const Tensor<xpu, 3, DType>& A, \
+                                    const Tensor<xpu, 2, DType>& L, \
+                                    const Tensor<xpu, 1, DType>& work, \
+                                    Stream<xpu> *s) { \
+  for (index_t i = 0; i < A.size(0); ++i) { \
+    linalg_syevd(A[i], L[i], work, s); \
+  } \
+}
+
+#define LINALG_XPU_BATCH_SYEVD_WORKSPACE_QUERY(xpu, DType) \
+template<> inline \
+int linalg_batch_syevd_workspace_query<xpu, DType>(const Tensor<xpu, 3, DType>& A, \
+                                                   const Tensor<xpu, 2, DType>& L, \
+                                                   Stream<xpu> *s) { \
+  return linalg_syevd_workspace_query(A[0], L[0], s); \
+}
+
+LINALG_XPU_BATCH_SYEVD(cpu, float)
+LINALG_XPU_BATCH_SYEVD(cpu, double)
+LINALG_XPU_BATCH_SYEVD_WORKSPACE_QUERY(cpu, float)
+LINALG_XPU_BATCH_SYEVD_WORKSPACE_QUERY(cpu, double)
+
+#ifdef __CUDACC__
+
+// SYEVJBATCHED only available with cuda9 or higher.
+#if CUDA_VERSION >= 9000
+
+// Batches of matrices up to 32 x 32 are diagonalized by the Jacobi method of cuSOLVER
+// in a single call. The eigenvalues are sorted in ascending order as by syevd.
+template<typename DType>
+inline bool linalg_use_syevj_batched(const Tensor<gpu, 3, DType>& A) {
+  return A.size(0) > 1 && A.size(1) <= kLinalgBatchedMaxSize;
+}
+
+// Row-major vs. col-major handled by using upper triangular
+// in cusolver-call.
+#define LINALG_GPU_BATCH_SYEVD(fname, DType) \
+template<> inline \
+void linalg_batch_syevd<gpu, DType>(const Tensor<gpu, 3, DType>& A, \
+                                    const Tensor<gpu, 2, DType>& L, \
+                                    const Tensor<gpu, 1, DType>& work, \
+                                    Stream<gpu> *s) { \
+  using namespace mxnet; \
+  using mshadow::gpu; \
+  CHECK_NOTNULL(s); \
+  if (!linalg_use_syevj_batched(A)) { \
+    for (index_t i = 0; i < A.size(0); ++i) { \
+      linalg_syevd(A[i], L[i], work, s); \
+    } \
+    return; \
+  } \
+  check_syevd(A[0], L[0]); \
+  syevjInfo_t params; \
+  CUSOLVER_CALL(cusolverDnCreateSyevjInfo(&params)); \
+  EPHEMERAL_GPU_STORAGE_ALLOC(linalg_batch_syevd, info, int, A.size(0)); \
+  CUSOLVER_CALL(cusolver##fname(Stream<gpu>::GetSolverHandle(s), \
+                CUSOLVER_EIG_MODE_VECTOR, CUBLAS_FILL_MODE_UPPER, \
+                A.size(1), A.dptr_, A.stride_, L.dptr_, work.dptr_, \
+                work.size(0), static_cast<int *>(info.dptr), params, A.size(0))); \
+  Storage::Get()->Free(info); \
+  CUSOLVER_CALL(cusolverDnDestroySyevjInfo(params)); \
+}
+
+#define LINALG_GPU_BATCH_SYEVD_WORKSPACE_QUERY(fname, DType) \
+template<> inline \
+int linalg_batch_syevd_workspace_query<gpu, DType>(const Tensor<gpu, 3, DType>& A, \
+                                                   const Tensor<gpu, 2, DType>& L, \
+                                                   Stream<gpu> *s) { \
+  using namespace mxnet; \
+  using mshadow::gpu; \
+  if (!linalg_use_syevj_batched(A)) { \
+    return linalg_syevd_workspace_query(A[0], L[0], s); \
+  } \
+  syevjInfo_t params; \
+  CUSOLVER_CALL(cusolverDnCreateSyevjInfo(&params)); \
+  int lwork(0); \
+  CUSOLVER_CALL(cusolver##fname##_bufferSize(Stream<gpu>::GetSolverHandle(s), \
+                CUSOLVER_EIG_MODE_VECTOR, CUBLAS_FILL_MODE_UPPER, \
+                A.size(1), A.dptr_, A.stride_, L.dptr_, &lwork, params, A.size(0))); \
+  CUSOLVER_CALL(cusolverDnDestroySyevjInfo(params)); \
+  return lwork; \
+}
+
+LINALG_GPU_BATCH_SYEVD(DnSsyevjBatched, float)
+LINALG_GPU_BATCH_SYEVD(DnDsyevjBatched, double)
+
+LINALG_GPU_BATCH_SYEVD_WORKSPACE_QUERY(DnSsyevjBatched, float)
+LINALG_GPU_BATCH_SYEVD_WORKSPACE_QUERY(DnDsyevjBatched, double)
+
+#else
+
+LINALG_XPU_BATCH_SYEVD(gpu, float)
+LINALG_XPU_BATCH_SYEVD(gpu, double)
+LINALG_XPU_BATCH_SYEVD_WORKSPACE_QUERY(gpu, float)
+LINALG_XPU_BATCH_SYEVD_WORKSPACE_QUERY(gpu, double)
+
+#endif  // CUDA_VERSION >= 9000
+
+#endif  // __CUDACC__
+
 //////////////////////////////// GESVD ////////////////////////////////////////////
 
 // CPU/GPU-versions of LAPACK function "gesvd"
@@ -1460,16 +1713,6 @@ LINALG_CPU_BATCH_GETRF(dgetrf, double)
 
 #ifdef __CUDACC__
 
-// "getrfBatched" and "getriBatched" in cuBLAS must have DType *matrices[] as input
-// to store the pointers of each batch matrix. This kernel is used to build the
-// pointer array.
-struct set_matrix {
-  template<typename DType>
-  MSHADOW_XINLINE static void Map(int i, DType **p, DType *m, int step) {
-    p[i] = m + i * step;
-  }
-};
-
 // GETRF only available with cuda8 or higher.
 #if CUDA_VERSION >= 8000
 
@@ -31,6 +31,7 @@
 #include <mxnet/engine.h>
 #include <mxnet/op_attr_types.h>
 #include <algorithm>
+#include <limits>
 #include "./operator_tune.h"
 #include "../engine/openmp.h"
 
@@ -631,13 +632,26 @@ MSHADOW_XINLINE index_t ravel(const Shape<ndim>& coord, const Shape<ndim>& shape
 }
 
 
+/*!
+ * \brief Quotient of two non-negative indices. With 64-bit index_t, the division is done
+ *        in 32 bits when both operands fit, since 64-bit division is much slower on GPU.
+ */
+MSHADOW_XINLINE index_t index_div(const index_t a, const index_t b) {
+#if MSHADOW_INT64_TENSOR_SIZE == 1
+  if (((static_cast<uint64_t>(a) | static_cast<uint64_t>(b)) >> 32) == 0) {
+    return static_cast<uint32_t>(a) / static_cast<uint32_t>(b);
+  }
+#endif
+  return a / b;
+}
+
 /* Compute coordinates from flattened index given shape */
 template<int ndim>
 MSHADOW_XINLINE Shape<ndim> unravel(const index_t idx, const Shape<ndim>& shape) {
   Shape<ndim> ret;
   #pragma unroll
   for (index_t i = ndim-1, j = idx; i >=0; --i) {
-    auto tmp = j / shape[i];
+    auto tmp = index_div(j, shape[i]);
     ret[i] = j - tmp*shape[i];
     j = tmp;
   }
@@ -664,7 +678,7 @@ MSHADOW_XINLINE index_t unravel_dot(const index_t idx, const Shape<ndim>& shape,
   index_t ret = 0;
   #pragma unroll
   for (index_t i = ndim-1, j = idx; i >=0; --i) {
-    auto tmp = j / shape[i];
+    auto tmp = index_div(j, shape[i]);
     ret += (j - tmp*shape[i])*stride[i];
     j = tmp;
   }
@@ -1021,7 +1035,25 @@ struct Kernel<OP, cpu> {
   static void LaunchTuned(mshadow::Stream<cpu> *, const size_t N, Args... args) {
 #ifdef _OPENMP
     const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
-    if (omp_threads < 2 || !tuned_op<PRIMITIVE_OP, DType>::UseOMP(
+    if (omp_threads >= 2 && N > 0 && OnlineOperatorTune::enabled()) {
+      OnlineOperatorTune::Entry *entry = OnlineTuneEntry<PRIMITIVE_OP, DType>(N, omp_threads);
+      bool measure = false;
+      const int threads = entry->Threads(&measure);
+      const OperatorTuneBase::Timer timer;
+      if (threads < 2) {
+        for (size_t i = 0; i < N; ++i) {
+          OP::Map(i, args...);
+        }
+      } else {
+        #pragma omp parallel for num_threads(threads)
+        for (index_t i = 0; i < static_cast<index_t>(N); ++i) {
+          OP::Map(i, args...);
+        }
+      }
+      if (measure) {
+        entry->Record(threads, static_cast<double>(timer.duration()) / N);
+      }
+    } else if (omp_threads < 2 || !tuned_op<PRIMITIVE_OP, DType>::UseOMP(
       N, static_cast<size_t>(omp_threads))) {
       for (size_t i = 0; i < N; ++i) {
         OP::Map(i, args...);
@@ -1104,42 +1136,63 @@ struct Kernel<OP, cpu> {
 
 
 #ifdef __CUDACC__
-template<typename OP, typename ...Args>
-__global__ void mxnet_generic_kernel(int N, Args... args) {
-  for (int i = blockIdx.x * blockDim.x + threadIdx.x; i < N; i += blockDim.x * gridDim.x) {
+template<typename OP, typename IType, typename ...Args>
+__global__ void mxnet_generic_kernel(IType N, Args... args) {
+  for (IType i = blockIdx.x * blockDim.x + threadIdx.x; i < N;
+       i += static_cast<IType>(blockDim.x) * gridDim.x) {
     OP::Map(i, args...);
   }
 }
 
-template<typename OP, typename ...Args>
-__global__ void mxnet_generic_kernel_ex(int N, Args... args) {
-  for (int i = blockIdx.x * blockDim.x + threadIdx.x; i < N; i += blockDim.x * gridDim.x) {
+template<typename OP, typename IType, typename ...Args>
+__global__ void mxnet_generic_kernel_ex(IType N, Args... args) {
+  for (IType i = blockIdx.x * blockDim.x + threadIdx.x; i < N;
+       i += static_cast<IType>(blockDim.x) * gridDim.x) {
     OP::Map(i, 1, args...);
   }
 }
 
 template<typename OP>
 struct Kernel<OP, gpu> {
-  /*! \brief Launch GPU kernel */
+  /*! \brief Launch GPU kernel
+   *  The loop over the elements uses 32-bit indices whenever N allows it, and 64-bit ones
+   *  only for large tensors, so that builds with large tensor support do not pay for the
+   *  64-bit index math on the common sizes. The last increment of the loop goes up to one
+   *  stride past N, so the 32-bit loop is only used when N + stride fits in int.
+   */
   template<typename ...Args>
-  inline static void Launch(mshadow::Stream<gpu> *s, int N, Args... args) {
+  inline static void Launch(mshadow::Stream<gpu> *s, index_t N, Args... args) {
     if (0 == N) return;
     using namespace mshadow::cuda;
-    int ngrid = std::min(kMaxGridNum, (N + kBaseThreadNum - 1) / kBaseThreadNum);
-    mxnet_generic_kernel<OP, Args...>
-      <<<ngrid, kBaseThreadNum, 0, mshadow::Stream<gpu>::GetStream(s)>>>(
-        N, args...);
+    int ngrid = static_cast<int>(std::min<index_t>(kMaxGridNum,
+                                                   (N + kBaseThreadNum - 1) / kBaseThreadNum));
+    if (N <= std::numeric_limits<int>::max() - static_cast<index_t>(ngrid) * kBaseThreadNum) {
+      mxnet_generic_kernel<OP, int, Args...>
+        <<<ngrid, kBaseThreadNum, 0, mshadow::Stream<gpu>::GetStream(s)>>>(
+          static_cast<int>(N), args...);
+    } else {
+      mxnet_generic_kernel<OP, index_t, Args...>
+        <<<ngrid, kBaseThreadNum, 0, mshadow::Stream<gpu>::GetStream(s)>>>(
+          N, args...);
+    }
     MSHADOW_CUDA_POST_KERNEL_CHECK(mxnet_generic_kernel);
   }
 
   template<typename ...Args>
-  inline static void LaunchEx(mshadow::Stream<gpu> *s, const int N, Args... args) {
+  inline static void LaunchEx(mshadow::Stream<gpu> *s, const index_t N, Args... args) {
     if (0 == N) return;
     using namespace mshadow::cuda;
-    int ngrid = std::min(kMaxGridNum, (N + kBaseThreadNum - 1) / kBaseThreadNum);
-    mxnet_generic_kernel_ex<OP, Args...>
-      <<<ngrid, kBaseThreadNum, 0, mshadow::Stream<gpu>::GetStream(s)>>>(
-        N, args...);
+    int ngrid = static_cast<int>(std::min<index_t>(kMaxGridNum,
+                                                   (N + kBaseThreadNum - 1) / kBaseThreadNum));
+    if (N <= std::numeric_limits<int>::max() - static_cast<index_t>(ngrid) * kBaseThreadNum) {
+      mxnet_generic_kernel_ex<OP, int, Args...>
+        <<<ngrid, kBaseThreadNum, 0, mshadow::Stream<gpu>::GetStream(s)>>>(
+          static_cast<int>(N), args...);
+    } else {
+      mxnet_generic_kernel_ex<OP, index_t, Args...>
+        <<<ngrid, kBaseThreadNum, 0, mshadow::Stream<gpu>::GetStream(s)>>>(
+          N, args...);
+    }
     MSHADOW_CUDA_POST_KERNEL_CHECK(mxnet_generic_kernel_ex);
   }
 };
@@ -25,6 +25,7 @@
 */
 
 #include "./convolution-inl.h"
+#include "./fast_conv_cpu.h"
 #include "../elemwise_op_common.h"
 #include "../operator_common.h"
 #if MXNET_USE_MKLDNN == 1
@@ -48,6 +49,33 @@ static inline std::vector<std::string> ListArguments(const ConvolutionParam& par
   }
 }
 
+static void ConvolutionComputeCPU(const nnvm::NodeAttrs& attrs,
+                                  const OpContext& ctx,
+                                  const std::vector<TBlob>& inputs,
+                                  const std::vector<OpReqType>& req,
+                                  const std::vector<TBlob>& outputs) {
+  const ConvolutionParam& param = nnvm::get<ConvolutionParam>(attrs.parsed);
+  const mxnet::TShape& dshape = inputs[conv::kData].shape_;
+  const mxnet::TShape& oshape = outputs[conv::kOut].shape_;
+  const fast_conv::ConvAlgo algo =
+    fast_conv::SelectAlgo(param, dshape, oshape, inputs[conv::kData].type_flag_);
+  if (algo == fast_conv::kIm2col || req[conv::kOut] != kWriteTo) {
+    ConvolutionCompute<cpu>(attrs, ctx, inputs, req, outputs);
+    return;
+  }
+  mshadow::Stream<cpu> *s = ctx.get_stream<cpu>();
+  const size_t workspace_size = fast_conv::WorkspaceSize(algo, param, dshape, oshape);
+  float *workspace = nullptr;
+  if (workspace_size > 0) {
+    workspace = ctx.requested[conv::kTempSpace]
+      .get_space_typed<cpu, 1, float>(mshadow::Shape1(workspace_size), s).dptr_;
+  }
+  fast_conv::Forward(algo, param, dshape, oshape, inputs[conv::kData].dptr<float>(),
+                     inputs[conv::kWeight].dptr<float>(),
+                     param.no_bias ? nullptr : inputs[conv::kBias].dptr<float>(),
+                     outputs[conv::kOut].dptr<float>(), workspace);
+}
+
 #if MXNET_USE_MKLDNN == 1
 static void ConvolutionComputeExCPU(const nnvm::NodeAttrs& attrs,
                                     const OpContext& ctx,
@@ -61,7 +89,7 @@ static void ConvolutionComputeExCPU(const nnvm::NodeAttrs& attrs,
     MKLDNN_OPCHECK_RUN(ConvolutionCompute<cpu>, attrs, ctx, inputs, req, outputs);
     return;
   }
-  FallBackCompute(ConvolutionCompute<cpu>, attrs, ctx, inputs, req, outputs);
+  FallBackCompute(ConvolutionComputeCPU, attrs, ctx, inputs, req, outputs);
 }
 
 static void ConvolutionGradComputeExCPU(const nnvm::NodeAttrs& attrs,
@@ -490,11 +518,18 @@ There are other options to tune the performance.
     return std::vector<std::string>{"output"};
 })
 .set_attr<mxnet::FInferShape>("FInferShape", ConvolutionShape)
+.set_attr<FComputeCost>("FComputeCost",
+  [](const NodeAttrs& attrs, const mxnet::ShapeVector& in_shapes,
+     const mxnet::ShapeVector& out_shapes) {
+    // a multiply and an add per output element and weight of its filter
+    const mxnet::TShape& weight = in_shapes[conv::kWeight];
+    return 2. * out_shapes[0].Size() * (weight.Size() / weight[0]);
+  })
 .set_attr<nnvm::FInferType>("FInferType", ConvolutionType)
 #if MXNET_USE_MKLDNN == 1
 .set_attr<FInferStorageType>("FInferStorageType", ConvStorageType)
 #endif
-.set_attr<FCompute>("FCompute<cpu>", ConvolutionCompute<cpu>)
+.set_attr<FCompute>("FCompute<cpu>", ConvolutionComputeCPU)
 #if MXNET_USE_MKLDNN == 1
 .set_attr<bool>("TIsMKLDNN", true)
 .set_attr<FComputeEx>("FComputeEx<cpu>", ConvolutionComputeExCPU)
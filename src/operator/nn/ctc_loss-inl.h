@@ -295,6 +295,28 @@ inline std::vector<std::string> CTCLossOpListInputNames(const NodeAttrs& attrs)
   }
 }
 
+/*!
+ * \brief costs and, when training, gradient w.r.t. the activations of a batch, computed by
+ *        the bundled warp-ctc in float. Other data types are cast to float in the workspace.
+ *        Defined in ctc_loss.cc
+ */
+void CTCLossCompute(mshadow::Stream<cpu> *s, const OpContext &ctx, const TBlob &data,
+                    std::vector<int> *packed_labels, std::vector<int> *label_lengths,
+                    std::vector<int> *data_lengths, int blank_label, bool training,
+                    const TBlob &costs, const TBlob &grad);
+
+#if MXNET_USE_CUDA
+/*!
+ * \brief the GPU version, with cuDNN for float data when it supports the batch and
+ *        otherwise a native log-space recursion reading float16, float32 or float64 data.
+ *        Defined in ctc_loss.cu
+ */
+void CTCLossCompute(mshadow::Stream<gpu> *s, const OpContext &ctx, const TBlob &data,
+                    std::vector<int> *packed_labels, std::vector<int> *label_lengths,
+                    std::vector<int> *data_lengths, int blank_label, bool training,
+                    const TBlob &costs, const TBlob &grad);
+#endif
+
 template<typename xpu>
 void CTCLossOpForward(const nnvm::NodeAttrs& attrs,
                       const OpContext& ctx,
@@ -315,27 +337,24 @@ void CTCLossOpForward(const nnvm::NodeAttrs& attrs,
   const TBlob& out_grad = outputs[ctc_loss::kGrad];
 
   Stream<xpu> *s = ctx.get_stream<xpu>();
-  MSHADOW_TYPE_SWITCH(inputs[ctc_loss::kLabel].type_flag_, DType, {
-    Tensor<xpu, 3, real_t> data = in_data.get<xpu, 3, real_t>(s);
-    Tensor<xpu, 2, DType> labels = in_label.get<xpu, 2, DType>(s);
-    Tensor<xpu, 1, real_t> costs = out_data.get<xpu, 1, real_t>(s);
-    Tensor<xpu, 3, real_t> grad = out_grad.get<xpu, 3, real_t>(s);
-
-    int max_seq_len = data.size(0);
-    int batch_size = data.size(1);
-    int alphabet_size = data.size(2);
-
-    // data_lengths
-    std::vector<int> data_lengths(batch_size, max_seq_len);
-    if (param.use_data_lengths) {
-      int kInputLength = 2;
-      IndexTensorToVector(inputs[kInputLength].get<xpu, 1, real_t>(s), &data_lengths);
-    }
-
-    // label_lengths
-    std::vector<int> packed_labels;
-    std::vector<int> label_lengths(batch_size);
+  int max_seq_len = in_data.shape_[0];
+  int batch_size = in_data.shape_[1];
+  int alphabet_size = in_data.shape_[2];
+
+  // data_lengths
+  std::vector<int> data_lengths(batch_size, max_seq_len);
+  if (param.use_data_lengths) {
+    int kInputLength = 2;
+    MSHADOW_TYPE_SWITCH(inputs[kInputLength].type_flag_, IType, {
+      IndexTensorToVector(inputs[kInputLength].get<xpu, 1, IType>(s), &data_lengths);
+    });
+  }
 
+  // label_lengths
+  std::vector<int> packed_labels;
+  std::vector<int> label_lengths(batch_size);
+  MSHADOW_TYPE_SWITCH(in_label.type_flag_, DType, {
+    Tensor<xpu, 2, DType> labels = in_label.get<xpu, 2, DType>(s);
     if (param.use_label_lengths) {
       int kLabelLength = 2 + param.use_data_lengths;
       PackLabelByLength(labels, inputs[kLabelLength].get<xpu, 1, DType>(s),
@@ -344,30 +363,24 @@ void CTCLossOpForward(const nnvm::NodeAttrs& attrs,
       LabelTensorToPackedVector(labels, param.blank_label == 0 ? 0 : -1,
                                 &packed_labels, &label_lengths);
     }
-
-    size_t size_bytes;
-    get_workspace_size<real_t>(&label_lengths, &data_lengths, alphabet_size,
-                               batch_size, data.kDevCPU ? false : true, &size_bytes);
-
-    // round-up so there are enough elems in memory
-    size_t num_tmp_elems = (size_bytes + sizeof(real_t) - 1) / sizeof(real_t);
-    Tensor<xpu, 1, real_t> workspace =
-      ctx.requested[0].get_space_typed<xpu, 1, real_t>(Shape1(num_tmp_elems), s);
-
-    compute_ctc_cost(data, costs.dptr_, grad.dptr_, packed_labels.data(),
-                     label_lengths.data(), data_lengths.data(),
-                     workspace.dptr_, req[ctc_loss::kGrad] != mxnet::kNullOp,
-                     param.blank_label == 0 ? 0 : (alphabet_size - 1));
-
-    if (param.use_data_lengths) {
-      // baidu warp CTC implementation sometimes includes undefined gradients
-      // for data outside of length mask. Setting to 0 to make it consistent
-      // with CPU implementation.
-      int kInputLength = 2;
-      mxnet_op::SequenceMask(grad, inputs[kInputLength].get<xpu, 1, real_t>(s),
-                             static_cast<real_t>(0));
-    }
   });
+
+  CTCLossCompute(s, ctx, in_data, &packed_labels, &label_lengths, &data_lengths,
+                 param.blank_label == 0 ? 0 : (alphabet_size - 1),
+                 req[ctc_loss::kGrad] != mxnet::kNullOp, out_data, out_grad);
+
+  if (param.use_data_lengths) {
+    // cuDNN CTC may include undefined gradients for data outside of length mask.
+    // Setting to 0 to make it consistent with CPU implementation.
+    int kInputLength = 2;
+    MSHADOW_REAL_TYPE_SWITCH(out_grad.type_flag_, DType, {
+      MSHADOW_TYPE_SWITCH(inputs[kInputLength].type_flag_, IType, {
+        mxnet_op::SequenceMask(out_grad.get<xpu, 3, DType>(s),
+                               inputs[kInputLength].get<xpu, 1, IType>(s),
+                               static_cast<DType>(0));
+      });
+    });
+  }
 }
 
 template<typename xpu>
@@ -384,12 +397,15 @@ void CTCLossOpBackward(const nnvm::NodeAttrs& attrs,
   const TBlob& out_grad = inputs[0];
   const TBlob& grad_computed = inputs[3];  // grad computed in the forward step
 
-  Tensor<xpu, 3, real_t> igrad_data = in_grad.get<xpu, 3, real_t>(s);
-  Tensor<xpu, 1, real_t> ograd_data = out_grad.get<xpu, 1, real_t>(s);
-  Tensor<xpu, 3, real_t> computed_grad_data = grad_computed.get<xpu, 3, real_t>(s);
+  MSHADOW_REAL_TYPE_SWITCH(in_grad.type_flag_, DType, {
+    Tensor<xpu, 3, DType> igrad_data = in_grad.get<xpu, 3, DType>(s);
+    Tensor<xpu, 1, DType> ograd_data = out_grad.get<xpu, 1, DType>(s);
+    Tensor<xpu, 3, DType> computed_grad_data = grad_computed.get<xpu, 3, DType>(s);
 
-  Assign(igrad_data, req[0],
-         mshadow::expr::broadcast<1>(ograd_data, computed_grad_data.shape_) * computed_grad_data);
+    Assign(igrad_data, req[0],
+           mshadow::expr::broadcast<1>(ograd_data, computed_grad_data.shape_) *
+           computed_grad_data);
+  });
 }
 
 }  // namespace op
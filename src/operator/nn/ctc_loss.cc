@@ -46,6 +46,51 @@ ctcStatus_t compute_ctc_cost(const Tensor<cpu, 3, DType> activations,
 namespace mxnet {
 namespace op {
 
+void CTCLossCompute(mshadow::Stream<cpu> *s, const OpContext &ctx, const TBlob &data,
+                    std::vector<int> *packed_labels, std::vector<int> *label_lengths,
+                    std::vector<int> *data_lengths, int blank_label, bool training,
+                    const TBlob &costs, const TBlob &grad) {
+  using namespace mshadow;
+  using namespace mshadow::expr;
+  const int batch_size = data.shape_[1];
+  const int alphabet_size = data.shape_[2];
+  size_t size_bytes;
+  get_workspace_size<real_t>(label_lengths, data_lengths, alphabet_size,
+                             batch_size, false, &size_bytes);
+
+  // round-up so there are enough elems in memory
+  size_t num_tmp_elems = (size_bytes + sizeof(real_t) - 1) / sizeof(real_t);
+  if (data.type_flag_ == kFloat32) {
+    Tensor<cpu, 1, real_t> workspace =
+      ctx.requested[0].get_space_typed<cpu, 1, real_t>(Shape1(num_tmp_elems), s);
+    compute_ctc_cost(data.get<cpu, 3, real_t>(s), costs.dptr<real_t>(), grad.dptr<real_t>(),
+                     packed_labels->data(), label_lengths->data(), data_lengths->data(),
+                     workspace.dptr_, training, blank_label);
+    return;
+  }
+
+  // the activations, gradient and costs of other types are cast after the warp-ctc workspace
+  Tensor<cpu, 1, real_t> workspace = ctx.requested[0].get_space_typed<cpu, 1, real_t>(
+    Shape1(num_tmp_elems + 2 * data.Size() + batch_size), s);
+  Tensor<cpu, 3, real_t> float_data(workspace.dptr_ + num_tmp_elems, data.shape_.get<3>(), s);
+  Tensor<cpu, 3, real_t> float_grad(float_data.dptr_ + data.Size(), data.shape_.get<3>(), s);
+  Tensor<cpu, 1, real_t> float_costs(float_grad.dptr_ + data.Size(), Shape1(batch_size), s);
+  MSHADOW_REAL_TYPE_SWITCH(data.type_flag_, DType, {
+    float_data = tcast<real_t>(data.get<cpu, 3, DType>(s));
+    // warp-ctc leaves the gradient of the samples it cannot align untouched
+    if (training) float_grad = 0;
+    compute_ctc_cost(float_data, float_costs.dptr_, float_grad.dptr_,
+                     packed_labels->data(), label_lengths->data(), data_lengths->data(),
+                     workspace.dptr_, training, blank_label);
+    Tensor<cpu, 1, DType> out_costs = costs.get<cpu, 1, DType>(s);
+    out_costs = tcast<DType>(float_costs);
+    if (training) {
+      Tensor<cpu, 3, DType> out_grad = grad.get<cpu, 3, DType>(s);
+      out_grad = tcast<DType>(float_grad);
+    }
+  });
+}
+
 DMLC_REGISTER_PARAMETER(CTCLossOpParam);
 
 NNVM_REGISTER_OP(CTCLoss)
@@ -94,6 +139,12 @@ The resulting `label` tensor should be padded to be::
 
 ``out`` is a list of CTC loss values, one per example in the batch.
 
+``data`` can be float16, float32 or float64, and ``out`` has its type. On GPU the loss of
+float32 data is computed by cuDNN when it supports the batch: the blank label is ``"first"``,
+labels have at most 256 tokens and every sequence is long enough for its labels. Set
+``MXNET_CUDNN_CTC_LOSS`` to 0 to disable it. Otherwise a native implementation reads the
+data in its own type and runs the alpha/beta recursions in float32 log space.
+
 See *Connectionist Temporal Classification: Labelling Unsegmented
 Sequence Data with Recurrent Neural Networks*, A. Graves *et al*. for more
 information on the definition and the algorithm.
@@ -21,34 +21,290 @@
  * Copyright (c) 2018 by Contributors
  * \file ctc_loss.cu
  * \brief GPU Implementation of ctc_loss op
+ *
+ *  The activations are read in their own type by a log-softmax writing float32 log
+ *  probabilities. One block per sample then runs the alpha recursion, and when training
+ *  the beta recursion, over the labels with blanks, the threads of the block handling
+ *  neighbouring positions. The samples are bucketed by label length, so that the blocks of
+ *  short labels are a single warp. The beta recursion adds the posterior of each position
+ *  to its label, from which the gradient w.r.t. the activations is written in their type.
  */
 
+#include <algorithm>
+#include <numeric>
 #include "./ctc_loss-inl.h"
-#include "../../../3rdparty/ctc_include/detail/gpu_ctc.h"
-
-namespace mshadow {
-
-template <typename DType>
-ctcStatus_t compute_ctc_cost(const Tensor<gpu, 3, DType> activations,
-                             DType *costs, DType *grads, int *labels,
-                             int *label_lengths, int *input_lengths,
-                             void *workspace, int train, int blank_label) {
-  int minibatch = static_cast<int>(activations.size(1));
-  int alphabet_size = static_cast<int>(activations.size(2));
-  mxnet_warpctc::GpuCTC<DType> ctc(alphabet_size, minibatch, workspace,
-                    activations.stream_->stream_, blank_label);
-  if (train)
-    return ctc.cost_and_grad(activations.dptr_, grads, costs, labels,
-                             label_lengths, input_lengths);
-  else
-    return ctc.score_forward(activations.dptr_, costs, labels,
-                             label_lengths, input_lengths);
-}
-}  // namespace mshadow
+#include "./softmax-inl.h"
+#include "../../common/cuda/utils.h"
 
 namespace mxnet {
 namespace op {
 
+namespace ctc_loss {
+/*! \brief the threads of the block of a sample with S labels with blanks */
+inline int NumThreads(int S) {
+  return std::min(1024, (S + 31) / 32 * 32);
+}
+}  // namespace ctc_loss
+
+__device__ __forceinline__ float ctc_log_add(float a, float b) {
+  if (a == -INFINITY) return b;
+  if (b == -INFINITY) return a;
+  return fmaxf(a, b) + log1pf(expf(-fabsf(a - b)));
+}
+
+/*! \brief the s-th label of the sequence with blanks at the even positions */
+__device__ __forceinline__ int ctc_label(const int *labels, int s, int blank) {
+  return (s & 1) ? labels[s >> 1] : blank;
+}
+
+/*!
+ * \brief log alpha of the sample of the block for every time step and label with blanks,
+ *        and its cost, 0 for samples that cannot be aligned
+ */
+template<typename DType>
+__global__ void CTCAlphaKernel(const float *log_probs, const int *labels,
+                               const int *label_offsets, const int *label_lengths,
+                               const int *data_lengths, const int *valid, const int *order,
+                               int batch, int alphabet, int max_t, int max_s, int blank,
+                               float *alphas, float *nll, DType *costs) {
+  const int b = order[blockIdx.x];
+  const int S = 2 * label_lengths[b] + 1;
+  const int T = data_lengths[b];
+  const int *lab = labels + label_offsets[b];
+  float *alpha = alphas + static_cast<size_t>(b) * max_t * max_s;
+  if (!valid[b] || T == 0) {
+    if (threadIdx.x == 0) {
+      nll[b] = 0;
+      costs[b] = DType(0);
+    }
+    return;
+  }
+  for (int s = threadIdx.x; s < S; s += blockDim.x) {
+    alpha[s] = s < 2 ? log_probs[b * alphabet + ctc_label(lab, s, blank)] : -INFINITY;
+  }
+  for (int t = 1; t < T; ++t) {
+    __syncthreads();
+    const float *prev = alpha + (t - 1) * max_s;
+    float *cur = alpha + t * max_s;
+    const float *lp = log_probs + (static_cast<size_t>(t) * batch + b) * alphabet;
+    for (int s = threadIdx.x; s < S; s += blockDim.x) {
+      const int l = ctc_label(lab, s, blank);
+      float a = prev[s];
+      if (s > 0) a = ctc_log_add(a, prev[s - 1]);
+      if (s > 1 && l != blank && l != lab[(s >> 1) - 1]) a = ctc_log_add(a, prev[s - 2]);
+      cur[s] = a + lp[l];
+    }
+  }
+  __syncthreads();
+  if (threadIdx.x == 0) {
+    const float *last = alpha + (T - 1) * max_s;
+    const float ll = S > 1 ? ctc_log_add(last[S - 1], last[S - 2]) : last[S - 1];
+    nll[b] = -ll;
+    costs[b] = DType(-ll);
+  }
+}
+
+/*!
+ * \brief log beta of the sample of the block, in two rows alternating with the time step,
+ *        and the posterior of every label at every time step added to post
+ */
+__global__ void CTCBetaKernel(const float *log_probs, const int *labels,
+                              const int *label_offsets, const int *label_lengths,
+                              const int *data_lengths, const int *valid, const int *order,
+                              int batch, int alphabet, int max_t, int max_s, int blank,
+                              const float *alphas, const float *nll, float *betas,
+                              float *post) {
+  const int b = order[blockIdx.x];
+  const int S = 2 * label_lengths[b] + 1;
+  const int T = data_lengths[b];
+  const int *lab = labels + label_offsets[b];
+  if (!valid[b] || T == 0) return;
+  const float *alpha = alphas + static_cast<size_t>(b) * max_t * max_s;
+  float *beta = betas + static_cast<size_t>(b) * 2 * max_s;
+  const float ll = -nll[b];
+  for (int t = T - 1; t >= 0; --t) {
+    const size_t row = static_cast<size_t>(t) * batch + b;
+    const float *lp = log_probs + row * alphabet;
+    const float *next = beta + ((t + 1) & 1) * max_s;
+    float *cur = beta + (t & 1) * max_s;
+    for (int s = threadIdx.x; s < S; s += blockDim.x) {
+      const int l = ctc_label(lab, s, blank);
+      float v;
+      if (t == T - 1) {
+        v = s >= S - 2 ? 0.0f : -INFINITY;
+      } else {
+        v = next[s];
+        if (s + 1 < S) v = ctc_log_add(v, next[s + 1]);
+        if (s + 2 < S && l != blank && l != lab[(s >> 1) + 1]) v = ctc_log_add(v, next[s + 2]);
+      }
+      v += lp[l];
+      cur[s] = v;
+      // alpha and beta both include the emission at t
+      if (v > -INFINITY) {
+        atomicAdd(post + row * alphabet + l, expf(alpha[t * max_s + s] + v - lp[l] - ll));
+      }
+    }
+    __syncthreads();
+  }
+}
+
+/*! \brief grad = softmax - posterior within the sequences that can be aligned, 0 elsewhere */
+struct ctc_grad {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(index_t i, DType *grad, const float *log_probs,
+                                  const float *post, const int *data_lengths, const int *valid,
+                                  int batch, int alphabet) {
+    const index_t row = i / alphabet;
+    const int b = row % batch;
+    const int t = row / batch;
+    grad[i] = (valid[b] && t < data_lengths[b]) ? DType(expf(log_probs[i]) - post[i])
+                                                 : DType(0);
+  }
+};
+
+#if MXNET_USE_CUDNN == 1 && CUDNN_MAJOR >= 7
+/*!
+ * \brief the costs and gradient from cudnnCTCLoss, which only takes float32 data with the
+ *        blank first and labels of at most 256 tokens. False when it does not support them.
+ */
+bool CTCLossCudnn(mshadow::Stream<gpu> *s, const OpContext &ctx, const TBlob &data,
+                  std::vector<int> *packed_labels, std::vector<int> *label_lengths,
+                  std::vector<int> *data_lengths, int blank_label, bool all_valid,
+                  const TBlob &costs, const TBlob &grad) {
+  using namespace mshadow;
+  static const bool enabled = dmlc::GetEnv("MXNET_CUDNN_CTC_LOSS", true);
+  if (!enabled || data.type_flag_ != kFloat32 || blank_label != 0 || !all_valid ||
+      *std::max_element(label_lengths->begin(), label_lengths->end()) > 256) {
+    return false;
+  }
+  CHECK_EQ(s->dnn_handle_ownership_, Stream<gpu>::OwnHandle);
+  const int dims[3] = {static_cast<int>(data.shape_[0]), static_cast<int>(data.shape_[1]),
+                       static_cast<int>(data.shape_[2])};
+  const int strides[3] = {dims[1] * dims[2], dims[2], 1};
+  cudnnTensorDescriptor_t probs_desc, grad_desc;
+  cudnnCTCLossDescriptor_t ctc_desc;
+  CUDNN_CALL(cudnnCreateTensorDescriptor(&probs_desc));
+  CUDNN_CALL(cudnnCreateTensorDescriptor(&grad_desc));
+  CUDNN_CALL(cudnnCreateCTCLossDescriptor(&ctc_desc));
+  CUDNN_CALL(cudnnSetTensorNdDescriptor(probs_desc, CUDNN_DATA_FLOAT, 3, dims, strides));
+  CUDNN_CALL(cudnnSetTensorNdDescriptor(grad_desc, CUDNN_DATA_FLOAT, 3, dims, strides));
+  CUDNN_CALL(cudnnSetCTCLossDescriptor(ctc_desc, CUDNN_DATA_FLOAT));
+  size_t workspace_bytes = 0;
+  CUDNN_CALL(cudnnGetCTCLossWorkspaceSize(s->dnn_handle_, probs_desc, grad_desc,
+                                          packed_labels->data(), label_lengths->data(),
+                                          data_lengths->data(),
+                                          CUDNN_CTC_LOSS_ALGO_DETERMINISTIC, ctc_desc,
+                                          &workspace_bytes));
+  Tensor<gpu, 1, char> workspace = ctx.requested[0].get_space_typed<gpu, 1, char>(
+    Shape1(std::max<size_t>(workspace_bytes, 1)), s);
+  CUDNN_CALL(cudnnCTCLoss(s->dnn_handle_, probs_desc, data.dptr_, packed_labels->data(),
+                          label_lengths->data(), data_lengths->data(), costs.dptr_,
+                          grad_desc, grad.dptr_, CUDNN_CTC_LOSS_ALGO_DETERMINISTIC, ctc_desc,
+                          workspace.dptr_, workspace_bytes));
+  CUDNN_CALL(cudnnDestroyCTCLossDescriptor(ctc_desc));
+  CUDNN_CALL(cudnnDestroyTensorDescriptor(grad_desc));
+  CUDNN_CALL(cudnnDestroyTensorDescriptor(probs_desc));
+  return true;
+}
+#endif  // MXNET_USE_CUDNN == 1 && CUDNN_MAJOR >= 7
+
+void CTCLossCompute(mshadow::Stream<gpu> *s, const OpContext &ctx, const TBlob &data,
+                    std::vector<int> *packed_labels, std::vector<int> *label_lengths,
+                    std::vector<int> *data_lengths, int blank_label, bool training,
+                    const TBlob &costs, const TBlob &grad) {
+  using namespace mshadow;
+  using namespace mxnet_op;
+  const int max_t = data.shape_[0];
+  const int batch = data.shape_[1];
+  const int alphabet = data.shape_[2];
+
+  // a sample can be aligned when its sequence has a step for every label and repeat
+  std::vector<int> label_offsets(batch), valid(batch);
+  int max_s = 1;
+  bool all_valid = true;
+  for (int b = 0, offset = 0; b < batch; offset += (*label_lengths)[b++]) {
+    const int L = (*label_lengths)[b];
+    int repeats = 0;
+    for (int i = 1; i < L; ++i) {
+      repeats += (*packed_labels)[offset + i] == (*packed_labels)[offset + i - 1];
+    }
+    label_offsets[b] = offset;
+    valid[b] = L + repeats <= (*data_lengths)[b];
+    all_valid = all_valid && valid[b];
+    max_s = std::max(max_s, 2 * L + 1);
+  }
+#if MXNET_USE_CUDNN == 1 && CUDNN_MAJOR >= 7
+  if (CTCLossCudnn(s, ctx, data, packed_labels, label_lengths, data_lengths, blank_label,
+                   all_valid, costs, grad)) {
+    return;
+  }
+#endif
+
+  // the samples ordered by the block size of their label length
+  std::vector<int> order(batch);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+    return (*label_lengths)[a] < (*label_lengths)[b];
+  });
+
+  const size_t num_probs = data.Size();
+  const size_t num_floats = (training ? 2 : 1) * num_probs +
+                            static_cast<size_t>(batch) * (max_t + 2) * max_s + batch;
+  std::vector<int> meta;
+  meta.reserve(5 * batch + packed_labels->size());
+  for (const auto *v : {&label_offsets, label_lengths, data_lengths, &valid, &order}) {
+    meta.insert(meta.end(), v->begin(), v->end());
+  }
+  meta.insert(meta.end(), packed_labels->begin(), packed_labels->end());
+  Tensor<gpu, 1, char> workspace = ctx.requested[0].get_space_typed<gpu, 1, char>(
+    Shape1(num_floats * sizeof(float) + meta.size() * sizeof(int)), s);
+  float *log_probs = reinterpret_cast<float *>(workspace.dptr_);
+  float *alphas = log_probs + num_probs;
+  float *betas = alphas + static_cast<size_t>(batch) * max_t * max_s;
+  float *nll = betas + static_cast<size_t>(batch) * 2 * max_s;
+  float *post = nll + batch;
+  int *dev_meta = reinterpret_cast<int *>(log_probs + num_floats);
+  const int *dev_offsets = dev_meta, *dev_label_lengths = dev_meta + batch,
+            *dev_data_lengths = dev_meta + 2 * batch, *dev_valid = dev_meta + 3 * batch,
+            *dev_order = dev_meta + 4 * batch, *dev_labels = dev_meta + 5 * batch;
+  cudaStream_t stream = Stream<gpu>::GetStream(s);
+  CUDA_CALL(cudaMemcpyAsync(dev_meta, meta.data(), meta.size() * sizeof(int),
+                            cudaMemcpyHostToDevice, stream));
+
+  MSHADOW_REAL_TYPE_SWITCH(data.type_flag_, DType, {
+    Softmax<log_softmax_fwd, false, float>(s, data.dptr<DType>(), log_probs,
+                                           static_cast<int *>(nullptr),
+                                           Shape2(max_t * batch, alphabet), 1, 1.0);
+    if (training) {
+      CUDA_CALL(cudaMemsetAsync(post, 0, num_probs * sizeof(float), stream));
+    }
+    // one launch per bucket of samples whose labels take the same number of threads
+    for (int begin = 0; begin < batch;) {
+      const int threads = ctc_loss::NumThreads(2 * (*label_lengths)[order[begin]] + 1);
+      int end = begin + 1;
+      while (end < batch && ctc_loss::NumThreads(2 * (*label_lengths)[order[end]] + 1) == threads)
+        ++end;
+      CTCAlphaKernel<<<end - begin, threads, 0, stream>>>(
+        log_probs, dev_labels, dev_offsets, dev_label_lengths, dev_data_lengths, dev_valid,
+        dev_order + begin, batch, alphabet, max_t, max_s, blank_label, alphas, nll,
+        costs.dptr<DType>());
+      MSHADOW_CUDA_POST_KERNEL_CHECK(CTCAlphaKernel);
+      if (training) {
+        CTCBetaKernel<<<end - begin, threads, 0, stream>>>(
+          log_probs, dev_labels, dev_offsets, dev_label_lengths, dev_data_lengths, dev_valid,
+          dev_order + begin, batch, alphabet, max_t, max_s, blank_label, alphas, nll, betas,
+          post);
+        MSHADOW_CUDA_POST_KERNEL_CHECK(CTCBetaKernel);
+      }
+      begin = end;
+    }
+    if (training) {
+      Kernel<ctc_grad, gpu>::Launch(s, num_probs, grad.dptr<DType>(), log_probs, post,
+                                    dev_data_lengths, dev_valid, batch, alphabet);
+    }
+  });
+}
+
 NNVM_REGISTER_OP(CTCLoss)
 .add_alias("ctc_loss")
 .add_alias("_npx_ctc_loss")
@@ -27,8 +27,11 @@
 #define MXNET_OPERATOR_NN_CUDNN_CUDNN_ALGOREG_INL_H_
 
 #include <algorithm>
+#include <fstream>
 #include <mutex>
+#include <sstream>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <functional>
 #include <utility>
@@ -64,6 +67,13 @@ class CuDNNAlgo {
   bool is_tensor_core_algo_;
 };
 
+/*!
+ * \brief Registry of the algorithms picked for each convolution signature.
+ *
+ * If MXNET_CUDNN_ALGO_CACHE names a file, the algorithms found by autotuning are also
+ * appended to it, keyed by the GPU model, the cuDNN version and the signature, and the
+ * registry is seeded from it, so that later runs skip cudnnFind for the known signatures.
+ */
 template<typename ParamType>
 class CuDNNAlgoReg {
  public:
@@ -71,13 +81,19 @@ class CuDNNAlgoReg {
                             CuDNNAlgo<cudnnConvolutionBwdDataAlgo_t> *,
                             CuDNNAlgo<cudnnConvolutionBwdFilterAlgo_t> *)>;
 
+  explicit CuDNNAlgoReg(const std::string &op_name) : op_name_(op_name) {
+    cache_file_ = dmlc::GetEnv("MXNET_CUDNN_ALGO_CACHE", std::string());
+    if (!cache_file_.empty())
+      LoadCache();
+  }
+
   void FindOrElseRegister(const ParamType &param,
             const mxnet::ShapeVector &in_shape,
             const mxnet::ShapeVector &out_shape,
             cudnnDataType_t cudnn_data_type,
             cudnnDataType_t cudnn_forward_compute_type,
             cudnnDataType_t cudnn_backward_compute_type,
-            int sm_arch,
+            int dev_id,
             bool add_to_weight,
             CuDNNAlgo<cudnnConvolutionFwdAlgo_t> *fwd,
             CuDNNAlgo<cudnnConvolutionBwdDataAlgo_t> *bwd,
@@ -85,35 +101,52 @@ class CuDNNAlgoReg {
             const AlgoSetter_t &algo_setter) {
     CHECK(in_shape.size() == 2 || in_shape.size() == 3);
     ParamKey key{param, in_shape[0], in_shape[1], out_shape[0], cudnn_data_type,
-                 cudnn_forward_compute_type, cudnn_backward_compute_type, sm_arch, add_to_weight};
+                 cudnn_forward_compute_type, cudnn_backward_compute_type, SMArch(dev_id),
+                 add_to_weight};
     std::lock_guard<std::mutex> guard(lock_);
     auto i = reg_.find(key);
     if (i != reg_.end()) {
       *fwd = i->second.fwd;
       *bwd = i->second.bwd;
       *flt = i->second.flt;
-    } else {
-      if (param.cudnn_tune.value() && reg_.size() % 50 == 0) {
-        LOG(INFO) << "Running performance tests to find the best convolution "
-            "algorithm, "
-            "this can take a while... (set the environment variable "
-            "MXNET_CUDNN_AUTOTUNE_DEFAULT to 0 to disable)";
-        if (reg_.size() >= 1000) {
-          // Many people are very concerned about this warning, so change the warning once.
-          if (!is_warning_autotune_) {
-            LOG(INFO)
-                << "If you see this message in the middle of training, you are "
-                    "probably using bucketing. Consider setting env variable "
-                    "MXNET_CUDNN_AUTOTUNE_DEFAULT to 0 to disable cudnn tuning.";
-            is_warning_autotune_ = true;
-          }
+      return;
+    }
+    // Only the results of autotuning are worth keeping across runs, cudnnGet is cheap
+    const bool persist = !cache_file_.empty() && param.cudnn_tune.value();
+    std::string signature;
+    if (persist) {
+      signature = Signature(key, dev_id);
+      auto j = cached_.find(signature);
+      if (j != cached_.end()) {
+        *fwd = j->second.fwd;
+        *bwd = j->second.bwd;
+        *flt = j->second.flt;
+        reg_.insert(std::pair<ParamKey, CudnnAlgorithms>(key, j->second));
+        return;
+      }
+    }
+    if (param.cudnn_tune.value() && reg_.size() % 50 == 0) {
+      LOG(INFO) << "Running performance tests to find the best convolution "
+          "algorithm, "
+          "this can take a while... (set the environment variable "
+          "MXNET_CUDNN_AUTOTUNE_DEFAULT to 0 to disable)";
+      if (reg_.size() >= 1000) {
+        // Many people are very concerned about this warning, so change the warning once.
+        if (!is_warning_autotune_) {
+          LOG(INFO)
+              << "If you see this message in the middle of training, you are "
+                  "probably using bucketing. Consider setting env variable "
+                  "MXNET_CUDNN_AUTOTUNE_DEFAULT to 0 to disable cudnn tuning.";
+          is_warning_autotune_ = true;
         }
       }
-      // Call provided function to determine the algos- likely uses cudnnFind() or cudnnGet()
-      algo_setter(fwd, bwd, flt);
-      // Save result so future lookups hit in this registry
-      reg_.insert(std::pair<ParamKey, CudnnAlgorithms>(key, CudnnAlgorithms{*fwd, *bwd, *flt}));
     }
+    // Call provided function to determine the algos- likely uses cudnnFind() or cudnnGet()
+    algo_setter(fwd, bwd, flt);
+    // Save result so future lookups hit in this registry
+    reg_.insert(std::pair<ParamKey, CudnnAlgorithms>(key, CudnnAlgorithms{*fwd, *bwd, *flt}));
+    if (persist)
+      SaveCache(signature, CudnnAlgorithms{*fwd, *bwd, *flt});
   }
 
   static CuDNNAlgoReg *Get();
@@ -163,9 +196,72 @@ class CuDNNAlgoReg {
     }
   };
 
+  /*! \brief key of the cache file, which is shared by the GPU models and cuDNN versions */
+  std::string Signature(const ParamKey &key, int dev_id) const {
+    cudaDeviceProp props;
+    CUDA_CALL(cudaGetDeviceProperties(&props, dev_id));
+    std::ostringstream os;
+    os << op_name_ << ';' << props.name << ";cudnn=" << cudnnGetVersion();
+    for (const auto &kv : key.param.__DICT__())
+      os << ';' << kv.first << '=' << kv.second;
+    os << ";data=" << key.data_shape << ";weight=" << key.weight_shape
+       << ";out=" << key.out_shape << ";dtype=" << static_cast<int>(key.cudnn_data_type)
+       << ";fwd_compute=" << static_cast<int>(key.cudnn_forward_compute_type)
+       << ";bwd_compute=" << static_cast<int>(key.cudnn_backward_compute_type)
+       << ";add_to_weight=" << key.add_to_weight;
+    return os.str();
+  }
+
+  void LoadCache() {
+    std::ifstream is(cache_file_);
+    std::string line;
+    size_t malformed = 0;
+    while (std::getline(is, line)) {
+      std::istringstream ls(line);
+      std::string signature;
+      if (!std::getline(ls, signature, '\t') || signature.compare(0, op_name_.size() + 1,
+                                                                 op_name_ + ";") != 0)
+        continue;
+      int fwd, bwd, flt;
+      bool fwd_tc, bwd_tc, flt_tc;
+      if (!(ls >> fwd >> fwd_tc >> bwd >> bwd_tc >> flt >> flt_tc)) {
+        ++malformed;
+        continue;
+      }
+      CudnnAlgorithms algos;
+      algos.fwd.Set(static_cast<cudnnConvolutionFwdAlgo_t>(fwd), fwd_tc);
+      algos.bwd.Set(static_cast<cudnnConvolutionBwdDataAlgo_t>(bwd), bwd_tc);
+      algos.flt.Set(static_cast<cudnnConvolutionBwdFilterAlgo_t>(flt), flt_tc);
+      cached_[signature] = algos;
+    }
+    if (malformed > 0)
+      LOG(WARNING) << "Ignoring " << malformed << " malformed lines of " << cache_file_;
+    if (!cached_.empty())
+      LOG(INFO) << "Loaded " << cached_.size() << " " << op_name_
+                << " algorithms from " << cache_file_;
+  }
+
+  void SaveCache(const std::string &signature, const CudnnAlgorithms &algos) {
+    cached_[signature] = algos;
+    std::ostringstream os;
+    os << signature << '\t' << static_cast<int>(algos.fwd.AlgoNumber()) << ' '
+       << algos.fwd.IsTensorCoreAlgo() << ' ' << static_cast<int>(algos.bwd.AlgoNumber()) << ' '
+       << algos.bwd.IsTensorCoreAlgo() << ' ' << static_cast<int>(algos.flt.AlgoNumber()) << ' '
+       << algos.flt.IsTensorCoreAlgo() << '\n';
+    // a single write per line, so that processes can share the file
+    std::ofstream file(cache_file_, std::ios::app);
+    file << os.str() << std::flush;
+    if (!file)
+      LOG(WARNING) << "Failed to cache the " << op_name_ << " algorithms in " << cache_file_;
+  }
+
   std::mutex lock_;
   std::unordered_map<ParamKey, CudnnAlgorithms, ParamHash> reg_;
   bool is_warning_autotune_ = false;
+  std::string op_name_;
+  std::string cache_file_;
+  /*! \brief algorithms of the cache file by signature */
+  std::unordered_map<std::string, CudnnAlgorithms> cached_;
 };
 
 typedef CuDNNAlgoReg<ConvolutionParam> CuDNNConvAlgoReg;
@@ -610,7 +610,7 @@ class CuDNNDeconvolutionOp {
     CuDNNDeconvAlgoReg::Get()->FindOrElseRegister(param_, in_shape, out_shape, dtype_,
                                          cudnn_forward_compute_type,
                                          cudnn_backward_compute_type,
-                                         SMArch(rctx.ctx.dev_id), add_to_weight_,
+                                         rctx.ctx.dev_id, add_to_weight_,
                                          &forward_algo_, &back_algo_, &back_algo_w_, algo_setter);
 
     // If we're allowing Tensor Core variants of the algos to be considered in
@@ -73,6 +73,8 @@ NNVM_REGISTER_OP(Dropout)
 - During testing, this operator does not change the input if mode is 'training'.
   If mode is 'always', the same computaion as during training will be applied.
 
+- Unless axes is given, the mask kept for the backward stores one bit per element.
+
 Example::
 
   random.seed(998)
@@ -118,6 +120,12 @@ Example::
   if (!mxnet::ndim_is_known(dshape)) return false;
   out_shape->clear();
   out_shape->push_back(dshape);
+  if (param.axes.ndim() == 0) {
+    // the mask keeps one bit per element
+    out_shape->push_back(mxnet::TShape(1, mxnet::shape_is_known(dshape) ?
+                                          DropoutMaskBytes(dshape.Size()) : -1));
+    return true;
+  }
   for (int i = 0; i < param.axes.ndim(); ++i) {
     dshape[param.axes[i]] = 1;
   }
@@ -134,9 +142,10 @@ Example::
     return false;
   }
 
-  size_t nout = 2;
+  const DropoutParam& param = nnvm::get<DropoutParam>(attrs.parsed);
   out_type->clear();
-  for (size_t i = 0; i < nout; ++i) out_type->push_back(dtype);
+  out_type->push_back(dtype);
+  out_type->push_back(param.axes.ndim() == 0 ? mshadow::kUint8 : dtype);
   return true;
 })
 .set_attr<FCreateOpState>("FCreateOpState", CreateDropoutState)
@@ -0,0 +1,352 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file fast_conv_cpu.cc
+ * \brief direct depthwise and Winograd forward convolutions of float32 NCHW data on CPU
+ */
+#include <dmlc/parameter.h>
+#include <algorithm>
+#include "./fast_conv_cpu.h"
+#include "../linalg.h"
+#include "../../engine/openmp.h"
+
+namespace mxnet {
+namespace op {
+namespace fast_conv {
+
+namespace {
+
+/*! \brief transforms of Winograd F(m x m, 3 x 3), over tiles of (m + 2) x (m + 2) pixels */
+template<int m>
+struct Winograd;
+
+template<>
+struct Winograd<2> {
+  static constexpr int kTile = 4;
+  static constexpr float BT[4][4] = {
+    {1,  0, -1,  0},
+    {0,  1,  1,  0},
+    {0, -1,  1,  0},
+    {0,  1,  0, -1}
+  };
+  static constexpr float G[4][3] = {
+    {1,     0,    0},
+    {0.5f,  0.5f, 0.5f},
+    {0.5f, -0.5f, 0.5f},
+    {0,     0,    1}
+  };
+  static constexpr float AT[2][4] = {
+    {1, 1,  1,  0},
+    {0, 1, -1, -1}
+  };
+};
+
+template<>
+struct Winograd<4> {
+  static constexpr int kTile = 6;
+  static constexpr float BT[6][6] = {
+    {4,  0, -5,  0, 1, 0},
+    {0, -4, -4,  1, 1, 0},
+    {0,  4, -4, -1, 1, 0},
+    {0, -2, -1,  2, 1, 0},
+    {0,  2, -1, -2, 1, 0},
+    {0,  4,  0, -5, 0, 1}
+  };
+  static constexpr float G[6][3] = {
+    { 1.0f / 4,          0,          0},
+    {-1.0f / 6, -1.0f / 6,  -1.0f / 6},
+    {-1.0f / 6,  1.0f / 6,  -1.0f / 6},
+    { 1.0f / 24, 1.0f / 12,  1.0f / 6},
+    { 1.0f / 24, -1.0f / 12, 1.0f / 6},
+    {        0,          0,          1}
+  };
+  static constexpr float AT[4][6] = {
+    {1, 1,  1, 1,  1, 0},
+    {0, 1, -1, 2, -2, 0},
+    {0, 1,  1, 4,  4, 0},
+    {0, 1, -1, 8, -8, 1}
+  };
+};
+
+constexpr float Winograd<2>::BT[4][4];
+constexpr float Winograd<2>::G[4][3];
+constexpr float Winograd<2>::AT[2][4];
+constexpr float Winograd<4>::BT[6][6];
+constexpr float Winograd<4>::G[6][3];
+constexpr float Winograd<4>::AT[4][6];
+
+/*! \brief numbers of tiles of an output image along its height and width */
+inline void NumTiles(int m, const mxnet::TShape &oshape, index_t *tiles_h, index_t *tiles_w) {
+  *tiles_h = (oshape[2] + m - 1) / m;
+  *tiles_w = (oshape[3] + m - 1) / m;
+}
+
+/*! \brief images transformed at once by Winograd, within the workspace limit of param */
+index_t WinogradImagesPerPass(int m, const ConvolutionParam &param,
+                              const mxnet::TShape &dshape, const mxnet::TShape &oshape) {
+  const index_t a2 = (m + 2) * (m + 2);
+  const index_t channels = dshape[1];
+  const index_t filters = oshape[1];
+  index_t tiles_h, tiles_w;
+  NumTiles(m, oshape, &tiles_h, &tiles_w);
+  const index_t limit = (static_cast<index_t>(param.workspace) << 20) / sizeof(float);
+  const index_t per_image = a2 * (channels + filters) * tiles_h * tiles_w;
+  const index_t available = limit - a2 * filters * channels;
+  return std::min(static_cast<index_t>(dshape[0]), available / per_image);
+}
+
+void DepthwiseForward(const ConvolutionParam &param,
+                      const mxnet::TShape &dshape, const mxnet::TShape &oshape,
+                      const float *data, const float *weight, const float *bias, float *out) {
+  const index_t channels = dshape[1], height = dshape[2], width = dshape[3];
+  const index_t filters = oshape[1], out_h = oshape[2], out_w = oshape[3];
+  const index_t kernel_h = param.kernel[0], kernel_w = param.kernel[1];
+  const index_t stride_h = param.stride[0], stride_w = param.stride[1];
+  const index_t pad_h = param.pad[0], pad_w = param.pad[1];
+  const index_t dilate_h = param.dilate[0], dilate_w = param.dilate[1];
+  const index_t multiplier = filters / channels;
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  #pragma omp parallel for num_threads(omp_threads)
+  for (index_t i = 0; i < static_cast<index_t>(dshape[0]) * filters; ++i) {
+    const index_t f = i % filters;
+    const float *in_plane = data + (i / filters * channels + f / multiplier) * height * width;
+    const float *filter = weight + f * kernel_h * kernel_w;
+    float *out_plane = out + i * out_h * out_w;
+    const float b = bias ? bias[f] : 0.0f;
+    for (index_t oh = 0; oh < out_h; ++oh) {
+      float *out_row = out_plane + oh * out_w;
+      for (index_t ow = 0; ow < out_w; ++ow) out_row[ow] = b;
+      for (index_t kh = 0; kh < kernel_h; ++kh) {
+        const index_t ih = oh * stride_h - pad_h + kh * dilate_h;
+        if (ih < 0 || ih >= height) continue;
+        const float *in_row = in_plane + ih * width;
+        for (index_t kw = 0; kw < kernel_w; ++kw) {
+          // the outputs whose input pixel of the tap kw is inside the row
+          const index_t offset = kw * dilate_w - pad_w;
+          if (offset >= width) break;
+          const index_t begin = offset >= 0 ? 0 : (-offset + stride_w - 1) / stride_w;
+          const index_t end = std::min(out_w, (width - 1 - offset) / stride_w + 1);
+          const float w = filter[kh * kernel_w + kw];
+          if (stride_w == 1) {
+            const float *src = in_row + offset;
+            #pragma omp simd
+            for (index_t ow = begin; ow < end; ++ow) out_row[ow] += w * src[ow];
+          } else {
+            for (index_t ow = begin; ow < end; ++ow) {
+              out_row[ow] += w * in_row[ow * stride_w + offset];
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+/*!
+ * \brief Winograd F(m x m, 3 x 3), see Lavin and Gray, Fast Algorithms for Convolutional
+ *        Neural Networks (https://arxiv.org/abs/1509.09308)
+ *
+ *  The filters and the input tiles are transformed to a x a coefficients, laid out as a
+ *  (a * a, filters, channels) and a (a * a, channels, tiles) tensor, whose batched product
+ *  holds the a x a coefficients of the output tiles.
+ */
+template<int m>
+void WinogradForward(const ConvolutionParam &param,
+                     const mxnet::TShape &dshape, const mxnet::TShape &oshape,
+                     const float *data, const float *weight, const float *bias, float *out,
+                     float *workspace) {
+  using W = Winograd<m>;
+  constexpr int a = W::kTile;
+  const index_t channels = dshape[1], height = dshape[2], width = dshape[3];
+  const index_t filters = oshape[1], out_h = oshape[2], out_w = oshape[3];
+  const index_t pad_h = param.pad[0], pad_w = param.pad[1];
+  index_t tiles_h, tiles_w;
+  NumTiles(m, oshape, &tiles_h, &tiles_w);
+  const index_t images = WinogradImagesPerPass(m, param, dshape, oshape);
+  const index_t max_tiles = images * tiles_h * tiles_w;
+  float *filter_coef = workspace;
+  float *input_coef = filter_coef + a * a * filters * channels;
+  float *output_coef = input_coef + a * a * channels * max_tiles;
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+
+  // U = G g G^T
+  #pragma omp parallel for num_threads(omp_threads)
+  for (index_t fc = 0; fc < filters * channels; ++fc) {
+    const float *g = weight + fc * 9;
+    float tmp[a][3];
+    for (int i = 0; i < a; ++i) {
+      for (int j = 0; j < 3; ++j) {
+        tmp[i][j] = W::G[i][0] * g[j] + W::G[i][1] * g[3 + j] + W::G[i][2] * g[6 + j];
+      }
+    }
+    for (int i = 0; i < a; ++i) {
+      for (int j = 0; j < a; ++j) {
+        filter_coef[(i * a + j) * filters * channels + fc] =
+          tmp[i][0] * W::G[j][0] + tmp[i][1] * W::G[j][1] + tmp[i][2] * W::G[j][2];
+      }
+    }
+  }
+
+  mshadow::Stream<cpu> *s = nullptr;
+  for (index_t first = 0; first < static_cast<index_t>(dshape[0]); first += images) {
+    const index_t count = std::min(images, static_cast<index_t>(dshape[0]) - first);
+    const index_t tiles = count * tiles_h * tiles_w;
+
+    // V = B^T d B, with zeros for the pixels of the padding
+    #pragma omp parallel for num_threads(omp_threads)
+    for (index_t ct = 0; ct < channels * tiles; ++ct) {
+      const index_t c = ct / tiles, t = ct % tiles;
+      const index_t n = first + t / (tiles_h * tiles_w);
+      const index_t th = t / tiles_w % tiles_h, tw = t % tiles_w;
+      const float *plane = data + (n * channels + c) * height * width;
+      float d[a][a];
+      for (int i = 0; i < a; ++i) {
+        const index_t ih = th * m - pad_h + i;
+        for (int j = 0; j < a; ++j) {
+          const index_t iw = tw * m - pad_w + j;
+          d[i][j] = (ih >= 0 && ih < height && iw >= 0 && iw < width) ?
+                    plane[ih * width + iw] : 0.0f;
+        }
+      }
+      float tmp[a][a];
+      for (int i = 0; i < a; ++i) {
+        for (int j = 0; j < a; ++j) {
+          float sum = 0.0f;
+          for (int k = 0; k < a; ++k) sum += W::BT[i][k] * d[k][j];
+          tmp[i][j] = sum;
+        }
+      }
+      for (int i = 0; i < a; ++i) {
+        for (int j = 0; j < a; ++j) {
+          float sum = 0.0f;
+          for (int k = 0; k < a; ++k) sum += tmp[i][k] * W::BT[j][k];
+          input_coef[((i * a + j) * channels + c) * tiles + t] = sum;
+        }
+      }
+    }
+
+    // M = U V for each of the a x a coefficients
+    mshadow::Tensor<cpu, 3, float> u(filter_coef, mshadow::Shape3(a * a, filters, channels));
+    mshadow::Tensor<cpu, 3, float> v(input_coef, mshadow::Shape3(a * a, channels, tiles));
+    mshadow::Tensor<cpu, 3, float> mo(output_coef, mshadow::Shape3(a * a, filters, tiles));
+    for (int p = 0; p < a * a; ++p) {
+      linalg_gemm(u[p], v[p], mo[p], false, false, s, kWriteTo);
+    }
+
+    // Y = A^T M A, cropped to the output image
+    #pragma omp parallel for num_threads(omp_threads)
+    for (index_t ft = 0; ft < filters * tiles; ++ft) {
+      const index_t f = ft / tiles, t = ft % tiles;
+      const index_t n = first + t / (tiles_h * tiles_w);
+      const index_t th = t / tiles_w % tiles_h, tw = t % tiles_w;
+      float coef[a][a];
+      for (int i = 0; i < a; ++i) {
+        for (int j = 0; j < a; ++j) {
+          coef[i][j] = output_coef[((i * a + j) * filters + f) * tiles + t];
+        }
+      }
+      float tmp[m][a];
+      for (int i = 0; i < m; ++i) {
+        for (int j = 0; j < a; ++j) {
+          float sum = 0.0f;
+          for (int k = 0; k < a; ++k) sum += W::AT[i][k] * coef[k][j];
+          tmp[i][j] = sum;
+        }
+      }
+      float *plane = out + (n * filters + f) * out_h * out_w;
+      const float b = bias ? bias[f] : 0.0f;
+      for (int i = 0; i < m; ++i) {
+        const index_t oh = th * m + i;
+        if (oh >= out_h) break;
+        for (int j = 0; j < m; ++j) {
+          const index_t ow = tw * m + j;
+          if (ow >= out_w) break;
+          float sum = b;
+          for (int k = 0; k < a; ++k) sum += tmp[i][k] * W::AT[j][k];
+          plane[oh * out_w + ow] = sum;
+        }
+      }
+    }
+  }
+}
+
+}  // namespace
+
+ConvAlgo SelectAlgo(const ConvolutionParam &param, const mxnet::TShape &dshape,
+                    const mxnet::TShape &oshape, int dtype) {
+  static const bool enabled = dmlc::GetEnv("MXNET_CPU_FAST_CONV", true);
+  if (!enabled || dtype != mshadow::kFloat32 || param.kernel.ndim() != 2 ||
+      param.layout.value() != mshadow::kNCHW || dshape.Size() == 0 || oshape.Size() == 0) {
+    return kIm2col;
+  }
+  const index_t channels = dshape[1];
+  const index_t filters = oshape[1];
+  if (param.num_group > 1) {
+    // one input channel per group, im2col runs a GEMM of a single row for each of them
+    if (param.num_group == channels && filters % channels == 0) return kDepthwise;
+    return kIm2col;
+  }
+  const bool is_3x3 = param.kernel[0] == 3 && param.kernel[1] == 3 &&
+                      param.stride[0] == 1 && param.stride[1] == 1 &&
+                      param.dilate[0] == 1 && param.dilate[1] == 1;
+  // the transforms do not pay off below a few channels on both sides
+  if (!is_3x3 || channels < 8 || filters < 8) return kIm2col;
+  if (oshape[2] >= 8 && oshape[3] >= 8 && WinogradImagesPerPass(4, param, dshape, oshape) > 0) {
+    return kWinograd4x3;
+  }
+  if (oshape[2] >= 2 && oshape[3] >= 2 && WinogradImagesPerPass(2, param, dshape, oshape) > 0) {
+    return kWinograd2x3;
+  }
+  return kIm2col;
+}
+
+size_t WorkspaceSize(ConvAlgo algo, const ConvolutionParam &param,
+                     const mxnet::TShape &dshape, const mxnet::TShape &oshape) {
+  if (algo != kWinograd2x3 && algo != kWinograd4x3) return 0;
+  const int m = algo == kWinograd2x3 ? 2 : 4;
+  const size_t a2 = (m + 2) * (m + 2);
+  index_t tiles_h, tiles_w;
+  NumTiles(m, oshape, &tiles_h, &tiles_w);
+  const size_t tiles = WinogradImagesPerPass(m, param, dshape, oshape) * tiles_h * tiles_w;
+  return a2 * (oshape[1] * dshape[1] + (dshape[1] + oshape[1]) * tiles);
+}
+
+void Forward(ConvAlgo algo, const ConvolutionParam &param,
+             const mxnet::TShape &dshape, const mxnet::TShape &oshape,
+             const float *data, const float *weight, const float *bias, float *out,
+             float *workspace) {
+  switch (algo) {
+    case kDepthwise:
+      DepthwiseForward(param, dshape, oshape, data, weight, bias, out);
+      break;
+    case kWinograd2x3:
+      WinogradForward<2>(param, dshape, oshape, data, weight, bias, out, workspace);
+      break;
+    case kWinograd4x3:
+      WinogradForward<4>(param, dshape, oshape, data, weight, bias, out, workspace);
+      break;
+    default:
+      LOG(FATAL) << "fast_conv::Forward does not implement the algorithm " << algo;
+  }
+}
+
+}  // namespace fast_conv
+}  // namespace op
+}  // namespace mxnet
@@ -0,0 +1,77 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file fast_conv_cpu.h
+ * \brief direct depthwise and Winograd forward convolutions of float32 NCHW data on CPU
+ *
+ *  im2col + GEMM copies every input pixel kernel-size times and runs one tiny GEMM per
+ *  group of a depthwise convolution. The depthwise kernel slides the filters over the
+ *  input rows directly, and the Winograd kernels F(2x2, 3x3) and F(4x4, 3x3) turn a 3x3
+ *  convolution into a batch of GEMMs over transformed tiles, with 2.25x and 4x fewer
+ *  multiplications. The inner loops are over contiguous rows, for the compiler to
+ *  vectorize them with the instruction set of the build, NEON or SSE/AVX.
+ */
+#ifndef MXNET_OPERATOR_NN_FAST_CONV_CPU_H_
+#define MXNET_OPERATOR_NN_FAST_CONV_CPU_H_
+
+#include <mxnet/base.h>
+#include "./convolution-inl.h"
+
+namespace mxnet {
+namespace op {
+namespace fast_conv {
+
+/*! \brief algorithms of the forward convolution on CPU */
+enum ConvAlgo {
+  kIm2col,  // im2col + GEMM of ConvolutionOp
+  kDepthwise,
+  kWinograd2x3,
+  kWinograd4x3
+};
+
+/*!
+ * \brief pick the algorithm for a convolution by its shapes, kIm2col for those the other
+ *        algorithms do not support or would not be faster for
+ * \param param parameters of the convolution
+ * \param dshape shape of the input, NCHW
+ * \param oshape shape of the output, NCHW
+ * \param dtype type of the input
+ */
+ConvAlgo SelectAlgo(const ConvolutionParam &param, const mxnet::TShape &dshape,
+                    const mxnet::TShape &oshape, int dtype);
+
+/*! \brief number of floats of temporary space needed by an algorithm */
+size_t WorkspaceSize(ConvAlgo algo, const ConvolutionParam &param,
+                     const mxnet::TShape &dshape, const mxnet::TShape &oshape);
+
+/*!
+ * \brief compute the convolution with an algorithm other than kIm2col
+ * \param bias bias of the output channels, nullptr without bias
+ * \param workspace temporary space of WorkspaceSize floats
+ */
+void Forward(ConvAlgo algo, const ConvolutionParam &param,
+             const mxnet::TShape &dshape, const mxnet::TShape &oshape,
+             const float *data, const float *weight, const float *bias, float *out,
+             float *workspace);
+
+}  // namespace fast_conv
+}  // namespace op
+}  // namespace mxnet
+#endif  // MXNET_OPERATOR_NN_FAST_CONV_CPU_H_
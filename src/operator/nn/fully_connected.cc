@@ -309,6 +309,12 @@ If ``no_bias`` is set to be true, then the ``bias`` term is ignored.
 #endif
 .set_attr<THasDeterministicOutput>("THasDeterministicOutput", true)
 .set_attr<mxnet::FInferShape>("FInferShape", FullyConnectedShape)
+.set_attr<FComputeCost>("FComputeCost",
+  [](const NodeAttrs& attrs, const mxnet::ShapeVector& in_shapes,
+     const mxnet::ShapeVector& out_shapes) {
+    // a multiply and an add per output element and input feature
+    return 2. * out_shapes[0].Size() * in_shapes[fullc::kWeight][1];
+  })
 .set_attr<nnvm::FInferType>("FInferType", FullyConnectedType)
 .set_attr<FCompute>("FCompute<cpu>", FullyConnectedCompute<cpu>)
 .set_attr<FComputeEx>("FComputeEx<cpu>", FullyConnectedComputeExCPU)
@@ -45,6 +45,9 @@ namespace op {
 namespace layernorm {
 enum LayerNormOpInputs {kData, kGamma, kBeta};  // kGamma: scaling parameters, kBeta: shift biases
 enum LayerNormOpOutputs {kOut, kMean, kStd};  // req, out_data
+// the residual variant also takes the residual and bias, and outputs data + residual + bias
+enum ResidualLayerNormOpInputs {kResidual = 3, kBias};
+enum ResidualLayerNormOpOutputs {kSum = 3};
 }  // namespace layernorm
 
 struct LayerNormParam : public dmlc::Parameter<LayerNormParam> {
@@ -190,6 +193,46 @@ void LayerNormComputeGeneral(const nnvm::NodeAttrs& attrs,
 #endif  // !defined(__CUDACC__)
 }
 
+/*! \brief sum = data + residual + bias, with the bias broadcast over the last axis */
+struct residual_add_bias {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(index_t i, DType* sum, const DType* data,
+                                  const DType* residual, const DType* bias,
+                                  const index_t nchannel) {
+    sum[i] = data[i] + residual[i] + bias[i % nchannel];
+  }
+};
+
+template<typename xpu>
+void ResidualLayerNormCompute(const nnvm::NodeAttrs& attrs,
+                              const OpContext& ctx, const std::vector<TBlob>& inputs,
+                              const std::vector<OpReqType>& req,
+                              const std::vector<TBlob>& outputs);
+
+/*! \brief Adds the residual and bias to the data, then normalizes the sum with LayerNorm */
+template<typename xpu>
+void ResidualLayerNormComputeGeneral(const nnvm::NodeAttrs& attrs,
+                                     const OpContext& ctx, const std::vector<TBlob>& inputs,
+                                     const std::vector<OpReqType>& req,
+                                     const std::vector<TBlob>& outputs) {
+  using namespace mxnet_op;
+  CHECK_EQ(inputs.size(), 5U);
+  CHECK_EQ(outputs.size(), 4U);
+  if (req[layernorm::kOut] == kNullOp) return;
+  const TBlob& sum = outputs[layernorm::kSum];
+  MSHADOW_REAL_TYPE_SWITCH(sum.type_flag_, DType, {
+    Kernel<residual_add_bias, xpu>::Launch(
+      ctx.get_stream<xpu>(), sum.Size(), sum.dptr<DType>(),
+      inputs[layernorm::kData].dptr<DType>(), inputs[layernorm::kResidual].dptr<DType>(),
+      inputs[layernorm::kBias].dptr<DType>(), inputs[layernorm::kBias].Size());
+  });
+  LayerNormCompute<xpu>(attrs, ctx,
+                        {sum, inputs[layernorm::kGamma], inputs[layernorm::kBeta]},
+                        {req[layernorm::kOut], req[layernorm::kMean], req[layernorm::kStd]},
+                        {outputs[layernorm::kOut], outputs[layernorm::kMean],
+                         outputs[layernorm::kStd]});
+}
+
 template<typename xpu>
 void LayerNormGradCompute(const nnvm::NodeAttrs& attrs,
                           const OpContext& ctx, const std::vector<TBlob>& inputs,
@@ -30,6 +30,10 @@
 #if MSHADOW_USE_MKL == 1
 #include "../mkl_functions-inl.h"
 #endif
+#if MXNET_USE_MKLDNN == 1
+#include "./mkldnn/mkldnn_base-inl.h"
+#include "./mkldnn/mkldnn_ops-inl.h"
+#endif
 
 namespace mxnet {
 namespace op {
@@ -68,6 +72,29 @@ static bool LayerNormShape(const nnvm::NodeAttrs& attrs,
   return true;
 }
 
+static bool ResidualLayerNormShape(const nnvm::NodeAttrs& attrs,
+                                   mxnet::ShapeVector *in_shape,
+                                   mxnet::ShapeVector *out_shape) {
+  const LayerNormParam& param = nnvm::get<LayerNormParam>(attrs.parsed);
+  CHECK_EQ(in_shape->size(), 5U) << "Input:[data, gamma, beta, residual, bias]";
+  mxnet::TShape dshape = in_shape->at(layernorm::kData);
+  if (!mxnet::ndim_is_known(dshape)) {
+    dshape = in_shape->at(layernorm::kResidual);
+    if (!mxnet::ndim_is_known(dshape)) return false;
+    SHAPE_ASSIGN_CHECK(*in_shape, layernorm::kData, dshape);
+  }
+  CHECK_EQ(GetRealAxis(param.axis, dshape.ndim()), dshape.ndim() - 1)
+    << "residual_layer_norm only normalizes the last axis, axis=" << param.axis;
+  SHAPE_ASSIGN_CHECK(*in_shape, layernorm::kResidual, dshape);
+  SHAPE_ASSIGN_CHECK(*in_shape, layernorm::kBias,
+                     mxnet::TShape(Shape1(dshape[dshape.ndim() - 1])));
+  mxnet::ShapeVector ln_in_shape(in_shape->begin(), in_shape->begin() + 3);
+  if (!LayerNormShape(attrs, &ln_in_shape, out_shape)) return false;
+  for (int i = 0; i < 3; ++i) SHAPE_ASSIGN_CHECK(*in_shape, i, ln_in_shape[i]);
+  out_shape->push_back(dshape);  // kSum
+  return true;
+}
+
 template<>
 void LayerNormCompute<cpu>(const nnvm::NodeAttrs& attrs,
                            const OpContext& ctx, const std::vector<TBlob>& inputs,
@@ -120,6 +147,45 @@ void LayerNormComputeMKL(const nnvm::NodeAttrs& attrs,
 }
 #endif
 
+#if MXNET_USE_MKLDNN == 1
+static void LayerNormComputeExCPU(const nnvm::NodeAttrs& attrs,
+                                  const OpContext& ctx,
+                                  const std::vector<NDArray>& inputs,
+                                  const std::vector<OpReqType>& req,
+                                  const std::vector<NDArray>& outputs) {
+#if MSHADOW_USE_MKL == 1
+  auto fn = LayerNormComputeMKL;
+#else
+  auto fn = LayerNormCompute<cpu>;
+#endif
+  const LayerNormParam& param = nnvm::get<LayerNormParam>(attrs.parsed);
+  if (SupportMKLDNNLayerNorm(param, inputs)) {
+    MKLDNN_OPCHECK_INIT(false, outputs.size(), inputs, outputs);
+    MKLDNNRun(MKLDNNLayerNormForward, attrs, ctx, inputs, req, outputs);
+    MKLDNN_OPCHECK_RUN(fn, attrs, ctx, inputs, req, outputs);
+    return;
+  }
+  FallBackCompute(fn, attrs, ctx, inputs, req, outputs);
+}
+
+inline static bool LayerNormStorageType(const nnvm::NodeAttrs& attrs,
+                                        const int dev_mask,
+                                        DispatchMode* dispatch_mode,
+                                        std::vector<int> *in_attrs,
+                                        std::vector<int> *out_attrs) {
+  CHECK_EQ(in_attrs->size(), 3U);
+  CHECK_EQ(out_attrs->size(), 3U);
+  return MKLDNNStorageType(attrs, dev_mask, true, dispatch_mode, in_attrs, out_attrs);
+}
+#endif
+
+template<>
+void ResidualLayerNormCompute<cpu>(const nnvm::NodeAttrs& attrs,
+                                   const OpContext& ctx, const std::vector<TBlob>& inputs,
+                                   const std::vector<OpReqType>& req,
+                                   const std::vector<TBlob>& outputs) {
+  return ResidualLayerNormComputeGeneral<cpu>(attrs, ctx, inputs, req, outputs);
+}
 
 template<>
 void LayerNormGradCompute<cpu>(const nnvm::NodeAttrs& attrs,
@@ -180,6 +246,11 @@ axis to be the last item in the input shape.
 #else
 .set_attr<FCompute>("FCompute<cpu>", LayerNormCompute<cpu>)
 #endif
+#if MXNET_USE_MKLDNN == 1
+.set_attr<bool>("TIsMKLDNN", true)
+.set_attr<FComputeEx>("FComputeEx<cpu>", LayerNormComputeExCPU)
+.set_attr<FInferStorageType>("FInferStorageType", LayerNormStorageType)
+#endif
 .set_attr<nnvm::FGradient>("FGradient", [](const nnvm::ObjectPtr& n,
                                            const std::vector<nnvm::NodeEntry>& ograds) {
   std::vector<nnvm::NodeEntry> heads;
@@ -214,5 +285,69 @@ NNVM_REGISTER_OP(_backward_LayerNorm)
   return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
 });
 
+
+NNVM_REGISTER_OP(_contrib_residual_layer_norm)
+.describe(R"code(Layer normalization of the sum of the data, a residual and a bias.
+
+This is the Add & Norm step of the Transformer layers, fused into one operator:
+
+.. math::
+
+  sum = data + residual + bias
+
+  out = \frac{sum - mean(sum, axis)}{\sqrt{var(sum, axis) + \epsilon}} * gamma + beta
+
+``residual`` has the shape of ``data``, and ``bias``, ``gamma`` and ``beta`` have the shape of its
+last axis, the only one normalized. ``output_mean_var`` outputs the mean and std as LayerNorm does.
+
+)code" ADD_FILELINE)
+.set_num_inputs(5)
+.set_num_outputs(4)
+.set_attr_parser(ParamParser<LayerNormParam>)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+    [](const NodeAttrs& attrs) {
+  return std::vector<std::string>{"data", "gamma", "beta", "residual", "bias"};
+})
+.set_attr<nnvm::FListOutputNames>("FListOutputNames",
+    [](const NodeAttrs& attrs) {
+  return std::vector<std::string>{"output", "mean", "std", "sum"};
+})
+.set_attr<nnvm::FNumVisibleOutputs>("FNumVisibleOutputs",
+    [](const NodeAttrs& attrs) {
+  const LayerNormParam& param = nnvm::get<LayerNormParam>(attrs.parsed);
+  return param.output_mean_var ? 3 : 1;
+})
+.set_attr<mxnet::FInferShape>("FInferShape", ResidualLayerNormShape)
+.set_attr<nnvm::FInferType>("FInferType", ElemwiseType<5, 4>)
+.set_attr<FCompute>("FCompute<cpu>", ResidualLayerNormCompute<cpu>)
+.set_attr<nnvm::FGradient>("FGradient", [](const nnvm::ObjectPtr& n,
+                                           const std::vector<nnvm::NodeEntry>& ograds) {
+  // the sum is normalized by LayerNorm, whose gradient is that of the data and the residual
+  std::vector<nnvm::NodeEntry> heads;
+  heads.push_back(ograds[0]);  // ograd
+  heads.emplace_back(n, layernorm::kSum, 0);  // data
+  heads.push_back(n->inputs[layernorm::kGamma]);  // gamma
+  heads.emplace_back(n, layernorm::kMean, 0);  // mean
+  heads.emplace_back(n, layernorm::kStd, 0);  // std
+  auto grad = MakeNode("_backward_LayerNorm", n->attrs.name + "_backward",
+                       &heads, &n->attrs.dict, &n);
+  nnvm::NodeEntry sum_grad{grad, 0, 0};
+  std::unordered_map<std::string, std::string> bias_dict{{"axis", "-1"}, {"exclude", "True"}};
+  auto bias_grad = MakeNode("sum", n->attrs.name + "_bias_backward",
+                            {sum_grad}, &bias_dict, &n);
+  return std::vector<nnvm::NodeEntry>{sum_grad, {grad, 1, 0}, {grad, 2, 0}, sum_grad,
+                                      {bias_grad, 0, 0}};
+})
+.set_attr<FResourceRequest>("FResourceRequest", [](const NodeAttrs& n) {
+  return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
+})
+.set_attr<THasDeterministicOutput>("THasDeterministicOutput", true)
+.add_argument("data", "NDArray-or-Symbol", "Input data to layer normalization")
+.add_argument("gamma", "NDArray-or-Symbol", "gamma array")
+.add_argument("beta", "NDArray-or-Symbol", "beta array")
+.add_argument("residual", "NDArray-or-Symbol", "Residual added to the data")
+.add_argument("bias", "NDArray-or-Symbol", "Bias added to the data, along the last axis")
+.add_arguments(LayerNormParam::__FIELDS__());
+
 }  // namespace op
 }  // namespace mxnet
@@ -267,6 +267,134 @@ __global__ void LayerNormFusedForwardKernelContig(const int nbatch,
   }
 }
 
+/*! \brief rows of a block of LayerNormWarpForwardKernel, one per warp */
+constexpr int kLayerNormWarpRows = 4;
+/*! \brief longest rows normalized with a warp per row */
+constexpr int kLayerNormWarpMaxChannel = 8192;
+
+/* Fused CUDA kernel for the forward pass of layer normalization with a warp per row, for rows
+ * short enough that the reduction across warps of LayerNormFusedForwardKernelContig costs more
+ * than the single warp saves. The rows are accessed in aligned vectors of nvec elements.
+ * With `residual`, it normalizes data + residual + bias, which it also stores to sum_data.
+ *  It's launched with (blockDim.x, blockDim.y) = (WARP_SIZE, kLayerNormWarpRows)
+ */
+template<typename AType, typename DType, int nvec, bool residual>
+__global__ void LayerNormWarpForwardKernel(const int nbatch,
+                                           const int nchannel,
+                                           const AType eps,
+                                           const DType* __restrict__ in_data,
+                                           const DType* __restrict__ residual_data,
+                                           const DType* __restrict__ bias,
+                                           const DType* __restrict__ gamma,
+                                           const DType* __restrict__ beta,
+                                           DType* __restrict__ sum_data,
+                                           DType* __restrict__ out_data,
+                                           DType* __restrict__ mean_data,
+                                           DType* __restrict__ std_data) {
+  using VType = mxnet::common::cuda::aligned_vector<DType, nvec>;
+  const int row = blockIdx.x * blockDim.y + threadIdx.y;
+  if (row >= nbatch) return;
+  const int nvecs = nchannel / nvec;
+  const size_t offset = static_cast<size_t>(row) * nvecs;
+  const VType* col_vals = reinterpret_cast<const VType*>(residual ? sum_data : in_data) + offset;
+  int count = 0;
+  AType mean = 0;
+  AType sigma2 = 0;
+  for (int l = threadIdx.x; l < nvecs; l += blockDim.x) {
+    VType vals = reinterpret_cast<const VType*>(in_data)[offset + l];
+    if (residual) {
+      const VType res = reinterpret_cast<const VType*>(residual_data)[offset + l];
+      const VType b = reinterpret_cast<const VType*>(bias)[l];
+#pragma unroll
+      for (int i = 0; i < nvec; ++i) {
+        vals.val[i] = static_cast<DType>(static_cast<AType>(vals.val[i]) +
+                                         static_cast<AType>(res.val[i]) +
+                                         static_cast<AType>(b.val[i]));
+      }
+      reinterpret_cast<VType*>(sum_data)[offset + l] = vals;
+    }
+#pragma unroll
+    for (int i = 0; i < nvec; ++i) {
+      StepWelfordOnlineSum(static_cast<AType>(vals.val[i]), mean, sigma2, count);
+    }
+  }
+  // Merge the (mean, sigma2, counts) of the warp, after which all the lanes hold the result
+  for (int mask = blockDim.x / 2; mask > 0; mask >>= 1) {
+    AType meanB = warp_shfl_xor(mean, mask);
+    AType sigma2B = warp_shfl_xor(sigma2, mask);
+    int countB = warp_shfl_xor(count, mask);
+    ChanMergePartition(meanB, sigma2B, countB, mean, sigma2, count);
+  }
+  sigma2 /= nchannel;
+  // Calculate the out_data: gamma * (x - mean) / sqrt(var + eps) + beta
+  const AType std_eps = sqrt(sigma2 + eps);
+  const AType invstd_eps = AType(1) / std_eps;
+  VType* out_col_val = reinterpret_cast<VType*>(out_data) + offset;
+  for (int l = threadIdx.x; l < nvecs; l += blockDim.x) {
+    // the row is read again from the cache, instead of being held in the registers
+    const VType vals = col_vals[l];
+    const VType g = reinterpret_cast<const VType*>(gamma)[l];
+    const VType b = reinterpret_cast<const VType*>(beta)[l];
+    VType out;
+#pragma unroll
+    for (int i = 0; i < nvec; ++i) {
+      out.val[i] = static_cast<DType>(static_cast<AType>(g.val[i]) * invstd_eps *
+                                      (static_cast<AType>(vals.val[i]) - mean) +
+                                      static_cast<AType>(b.val[i]));
+    }
+    out_col_val[l] = out;
+  }
+  if (threadIdx.x == 0) {
+    mean_data[row] = static_cast<DType>(mean);
+    std_data[row] = static_cast<DType>(std_eps);
+  }
+}
+
+/*!
+ * \brief Launches LayerNormWarpForwardKernel over the (nbatch, nchannel) rows,
+ *        or returns false if they are too long or not aligned for it.
+ */
+template<bool safe_acc, bool residual>
+bool LayerNormWarpGPU(const LayerNormParam& param, const OpContext& ctx,
+                      const TBlob& in_data, const TBlob& residual_data, const TBlob& bias,
+                      const TBlob& gamma, const TBlob& beta, const TBlob& sum_data,
+                      const TBlob& out_data, const TBlob& mean_data, const TBlob& std_data) {
+  using namespace mshadow;
+  const int nbatch = mean_data.Size();
+  const int nchannel = gamma.Size();
+  if (nchannel > kLayerNormWarpMaxChannel || nbatch == 0) return false;
+  bool launched = false;
+  MXNET_REAL_ACC_TYPE_SWITCH(in_data.type_flag_, DType, AccType, {
+    typedef typename std::conditional<safe_acc, AccType, DType>::type AType;
+    const DType* res = residual ? residual_data.dptr<DType>() : nullptr;
+    const DType* b = residual ? bias.dptr<DType>() : nullptr;
+    DType* sum = residual ? sum_data.dptr<DType>() : nullptr;
+    const int nvec = mxnet::common::cuda::get_vector_length<DType>(
+      nchannel, {in_data.dptr_, res, b, gamma.dptr_, beta.dptr_, sum, out_data.dptr_});
+    // a warp covers the row at most 4 times with unaligned scalar accesses
+    if (nvec == 1 && nchannel > 4 * 32) return false;
+    const dim3 dimBlock(32, kLayerNormWarpRows);
+    const dim3 dimGrid((nbatch + kLayerNormWarpRows - 1) / kLayerNormWarpRows);
+    cudaStream_t stream = Stream<gpu>::GetStream(ctx.get_stream<gpu>());
+    auto launch = [&](auto vec) {
+      LayerNormWarpForwardKernel<AType, DType, decltype(vec)::value, residual>
+        <<<dimGrid, dimBlock, 0, stream>>>
+        (nbatch, nchannel, static_cast<AType>(param.eps), in_data.dptr<DType>(), res, b,
+         gamma.dptr<DType>(), beta.dptr<DType>(), sum, out_data.dptr<DType>(),
+         mean_data.dptr<DType>(), std_data.dptr<DType>());
+    };
+    switch (nvec) {
+      case 8: launch(std::integral_constant<int, 8>()); break;
+      case 4: launch(std::integral_constant<int, 4>()); break;
+      case 2: launch(std::integral_constant<int, 2>()); break;
+      default: launch(std::integral_constant<int, 1>()); break;
+    }
+    MSHADOW_CUDA_POST_KERNEL_CHECK(LayerNormWarpForwardKernel);
+    launched = true;
+  });
+  return launched;
+}
+
 template<bool safe_acc = false>
 void LayerNormGPUContig(const LayerNormParam param,
                         const OpContext& ctx, const std::vector<TBlob>& inputs,
@@ -292,6 +420,10 @@ void LayerNormGPUContig(const LayerNormParam param,
   CHECK_EQ(out_data.CheckContiguous(), true);
   CHECK_EQ(mean_data.CheckContiguous(), true);
   CHECK_EQ(std_data.CheckContiguous(), true);
+  if (LayerNormWarpGPU<safe_acc, false>(param, ctx, in_data, TBlob(), TBlob(), gamma, beta,
+                                        TBlob(), out_data, mean_data, std_data)) {
+    return;
+  }
 
   // Lauch the kernel. The dynamic shared memory size is
   // sizeof(DType) * blockDim.y * blockDim.x + sizeof(DType) * blockDim.y / 2 * blockDim.x
@@ -355,6 +487,26 @@ void LayerNormCompute<gpu>(const nnvm::NodeAttrs& attrs,
 }
 
 
+template<>
+void ResidualLayerNormCompute<gpu>(const nnvm::NodeAttrs& attrs,
+                                   const OpContext& ctx, const std::vector<TBlob>& inputs,
+                                   const std::vector<OpReqType>& req,
+                                   const std::vector<TBlob>& outputs) {
+  const LayerNormParam& param = nnvm::get<LayerNormParam>(attrs.parsed);
+  if (req[0] == kNullOp) return;
+  CHECK_NE(req[0], kAddTo);
+  bool safe_acc = dmlc::GetEnv("MXNET_SAFE_ACCUMULATION", true);
+  auto launch = safe_acc ? LayerNormWarpGPU<true, true> : LayerNormWarpGPU<false, true>;
+  if (launch(param, ctx, inputs[layernorm::kData], inputs[layernorm::kResidual],
+             inputs[layernorm::kBias], inputs[layernorm::kGamma], inputs[layernorm::kBeta],
+             outputs[layernorm::kSum], outputs[layernorm::kOut], outputs[layernorm::kMean],
+             outputs[layernorm::kStd])) {
+    return;
+  }
+  ResidualLayerNormComputeGeneral<gpu>(attrs, ctx, inputs, req, outputs);
+}
+
+
 /* Fused CUDA kernel for calculating the gradient w.r.t gamma/beta in LayerNorm when axis=-1
  * (Contiguous case).
  * The gradient of gamma and beta are:
@@ -750,5 +902,8 @@ NNVM_REGISTER_OP(LayerNorm)
 NNVM_REGISTER_OP(_backward_LayerNorm)
 .set_attr<FCompute>("FCompute<gpu>", LayerNormGradCompute<gpu>);
 
+NNVM_REGISTER_OP(_contrib_residual_layer_norm)
+.set_attr<FCompute>("FCompute<gpu>", ResidualLayerNormCompute<gpu>);
+
 }  // namespace op
 }  // namespace mxnet
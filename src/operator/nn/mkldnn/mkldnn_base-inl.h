@@ -48,7 +48,9 @@
 
 #if MXNET_USE_MKLDNN == 1
 #include <algorithm>
+#include <cstdint>
 #include <iterator>
+#include <list>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -177,16 +179,135 @@ static inline int GetMKLDNNCacheSize() {
   return mkldnn_cache_size;
 }
 
-// TODO(alex): (MXNET-1075) Will remove env variable and calculate cache size during runtime
+static inline int GetMKLDNNCacheTotal() {
+  static int mkldnn_cache_total = dmlc::GetEnv("MXNET_MKLDNN_CACHE_TOTAL", -1);
+  return mkldnn_cache_total;
+}
+
+/*! \brief updates the profiler counters of the primitive caches */
+void MKLDNNCacheCount(bool hit);
+void MKLDNNCacheEvictionCount();
+
+/*!
+ * \brief Type-erased view of a primitive cache, so that the caches of a thread share the
+ *        budget of MXNET_MKLDNN_CACHE_TOTAL primitives.
+ */
+class MKLDNNCacheBase {
+ public:
+  /*! \brief primitive caches of the calling thread and their use clock */
+  struct ThreadCaches {
+    std::vector<MKLDNNCacheBase *> caches;
+    uint64_t clock = 0;
+    size_t size = 0;
+  };
+
+  static ThreadCaches *Get() {
+#if DMLC_CXX11_THREAD_LOCAL
+    static thread_local ThreadCaches caches;
+#else
+    static MX_THREAD_LOCAL ThreadCaches caches;
+#endif
+    return &caches;
+  }
+
+  MKLDNNCacheBase() : thread_(Get()) {
+    thread_->caches.push_back(this);
+  }
+
+  virtual ~MKLDNNCacheBase() {
+    auto &caches = thread_->caches;
+    caches.erase(std::find(caches.begin(), caches.end(), this));
+  }
+
+  /*! \brief last use of the least recently used entry, UINT64_MAX if empty */
+  virtual uint64_t OldestUse() const = 0;
+  virtual void EvictOldest() = 0;
+
+ protected:
+  /*! \brief evicts the least recently used primitives of the thread beyond `limit` */
+  void EvictBeyond(int limit) {
+    while (limit != -1 && thread_->size >= static_cast<size_t>(std::max(limit, 1))) {
+      MKLDNNCacheBase *oldest = nullptr;
+      uint64_t oldest_use = UINT64_MAX;
+      for (auto *cache : thread_->caches) {
+        const uint64_t use = cache->OldestUse();
+        if (use < oldest_use) {
+          oldest = cache;
+          oldest_use = use;
+        }
+      }
+      if (oldest == nullptr) return;
+      oldest->EvictOldest();
+    }
+  }
+
+  ThreadCaches *thread_;
+};
+
+/*!
+ * \brief Per-thread cache of the primitives of an operator by signature, with the lookup
+ *        interface of std::unordered_map. Adding an entry evicts the least recently used
+ *        ones of the cache beyond MXNET_MKLDNN_CACHE_NUM entries, and those of all the
+ *        caches of the thread beyond MXNET_MKLDNN_CACHE_TOTAL entries.
+ */
+template<typename S, typename I, typename H>
+class MKLDNNPrimitiveCache : public MKLDNNCacheBase {
+ public:
+  using value_type = std::pair<S, I>;
+  using iterator = typename std::list<value_type>::iterator;
+
+  /*! \brief finds the entry of `key` and marks it as the most recently used */
+  iterator find(const S &key) {
+    auto it = index_.find(key);
+    MKLDNNCacheCount(it != index_.end());
+    if (it == index_.end()) return entries_.end();
+    entries_.splice(entries_.begin(), entries_, it->second.first);
+    it->second.second = ++thread_->clock;
+    return it->second.first;
+  }
+
+  iterator end() { return entries_.end(); }
+
+  size_t size() const { return entries_.size(); }
+
+  iterator insert(const S &key, const I &item) {
+    int cache_size = GetMKLDNNCacheSize();
+    while (cache_size != -1 && size() >= static_cast<size_t>(std::max(cache_size, 1)))
+      EvictOldest();
+    EvictBeyond(GetMKLDNNCacheTotal());
+    entries_.emplace_front(key, item);
+    auto ins_return = index_.emplace(key, std::make_pair(entries_.begin(), ++thread_->clock));
+    CHECK(ins_return.second);
+    ++thread_->size;
+    return entries_.begin();
+  }
+
+  uint64_t OldestUse() const override {
+    return entries_.empty() ? UINT64_MAX : index_.find(entries_.back().first)->second.second;
+  }
+
+  void EvictOldest() override {
+    index_.erase(entries_.back().first);
+    entries_.pop_back();
+    --thread_->size;
+    MKLDNNCacheEvictionCount();
+  }
+
+  ~MKLDNNPrimitiveCache() {
+    thread_->size -= entries_.size();
+  }
+
+ private:
+  /*! \brief entries from the most to the least recently used */
+  std::list<value_type> entries_;
+  /*! \brief position in entries_ and last use of each key */
+  std::unordered_map<S, std::pair<iterator, uint64_t>, H> index_;
+};
+
 template<typename S, typename I, typename H>
-static typename std::unordered_map<S, I, H>::iterator AddToCache(
-    std::unordered_map<S, I, H>* cache, const S &key, const I &item) {
-  int mkldnn_cache_size = GetMKLDNNCacheSize();
-  if (mkldnn_cache_size != -1 && static_cast<int>(cache->size()) > mkldnn_cache_size)
-    cache->erase(cache->begin());
-  auto ins_return = cache->insert(std::pair<S, I>(key, item));
-  CHECK(ins_return.second);
-  return ins_return.first;
+static typename MKLDNNPrimitiveCache<S, I, H>::iterator AddToCache(
+    MKLDNNPrimitiveCache<S, I, H>* cache, const S &key, const I &item) {
+  return cache->insert(key, item);
 }
 
 /*
@@ -200,6 +321,8 @@ struct LeakyReLUParam;
 struct ConvolutionParam;
 struct DeconvolutionParam;
 struct SoftmaxParam;
+struct LayerNormParam;
+struct GroupNormParam;
 struct TransposeParam;
 struct ReshapeParam;
 bool SupportMKLDNNAct(const ActivationParam& param);
@@ -212,7 +335,10 @@ bool SupportMKLDNNDeconv(const DeconvolutionParam& params, const NDArray &input)
 bool SupportMKLDNNSoftmax(const SoftmaxParam& param, const NDArray &input, const NDArray &output);
 bool SupportMKLDNNLogSoftmax(const SoftmaxParam& param, const NDArray &input,
                              const NDArray &output);
+bool SupportMKLDNNLayerNorm(const LayerNormParam& param, const std::vector<NDArray> &inputs);
+bool SupportMKLDNNGroupNorm(const GroupNormParam& param, const std::vector<NDArray> &inputs);
 bool SupportMKLDNNTranspose(const TransposeParam& param, const NDArray &data);
+bool SupportMKLDNNBatchDot(const std::vector<NDArray> &inputs, const NDArray &output);
 }  // namespace op
 
 static int GetTypeSize(int dtype) {
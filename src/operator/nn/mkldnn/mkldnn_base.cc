@@ -24,6 +24,7 @@
 #include "./mkldnn_ops-inl.h"
 #include "../../../common/exec_utils.h"
 #include "../../operator_common.h"
+#include "../../../profiler/profiler.h"
 
 namespace mxnet {
 
@@ -36,6 +37,24 @@ MKLDNNStream *MKLDNNStream::Get() {
   return &stream;
 }
 
+static profiler::ProfileDomain mkldnn_cache_domain("MKLDNN Primitive Cache");
+static profiler::ProfileCounter mkldnn_cache_hits("MKLDNN Cache Hits", &mkldnn_cache_domain);
+static profiler::ProfileCounter mkldnn_cache_misses("MKLDNN Cache Misses",
+                                                    &mkldnn_cache_domain);
+static profiler::ProfileCounter mkldnn_cache_evictions("MKLDNN Cache Evictions",
+                                                       &mkldnn_cache_domain);
+
+void MKLDNNCacheCount(bool hit) {
+  if (hit)
+    ++mkldnn_cache_hits;
+  else
+    ++mkldnn_cache_misses;
+}
+
+void MKLDNNCacheEvictionCount() {
+  ++mkldnn_cache_evictions;
+}
+
 void *AlignMem(void *mem, size_t size, size_t alignment, size_t *space) {
   if (size > *space)
     return nullptr;
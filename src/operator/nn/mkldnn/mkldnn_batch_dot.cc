@@ -0,0 +1,133 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file mkldnn_batch_dot.cc
+ * \brief Implement batch_dot operator via MKL-DNN matmul primitive, for float32 and bfloat16
+*/
+
+#if MXNET_USE_MKLDNN == 1
+
+#include <mkldnn.hpp>
+#include "../../tensor/dot-inl.h"
+#include "./mkldnn_base-inl.h"
+#include "./mkldnn_ops-inl.h"
+
+namespace mxnet {
+namespace op {
+
+bool SupportMKLDNNBatchDot(const std::vector<NDArray> &inputs, const NDArray &output) {
+  for (const auto& arr : {inputs[0], inputs[1], output}) {
+    if (arr.shape().ndim() < 3 || arr.shape().Size() == 0 ||
+        arr.storage_type() != kDefaultStorage ||
+        !(arr.dtype() == mshadow::kFloat32 || arr.dtype() == mshadow::kBfloat16))
+      return false;
+  }
+  return inputs[0].dtype() == output.dtype() && inputs[1].dtype() == output.dtype();
+}
+
+typedef ParamOpSign<DotParam> MKLDNNBatchDotSignature;
+
+class MKLDNNBatchDotFwd {
+ public:
+  std::shared_ptr<mkldnn::matmul::primitive_desc> pd;
+
+  MKLDNNBatchDotFwd(const DotParam &param,
+                    const std::vector<NDArray> &inputs,
+                    const NDArray &output) {
+    const int ndim = output.shape().ndim();
+    const dim_t batch = output.shape().ProdShape(0, ndim - 2);
+    const auto dtype = get_mkldnn_type(output.dtype());
+    // the batches of (B, M, K) x (B, K, N), a transposed operand is read through its strides
+    auto operand_md = [&](const NDArray& arr, bool transposed) {
+      const dim_t rows = arr.shape()[ndim - 2];
+      const dim_t cols = arr.shape()[ndim - 1];
+      if (transposed) {
+        return mkldnn::memory::desc({batch, cols, rows}, dtype, {rows * cols, 1, cols});
+      }
+      return mkldnn::memory::desc({batch, rows, cols}, dtype, {rows * cols, cols, 1});
+    };
+    auto src_md = operand_md(inputs[0], param.transpose_a);
+    auto weights_md = operand_md(inputs[1], param.transpose_b);
+    const dim_t m = output.shape()[ndim - 2];
+    const dim_t n = output.shape()[ndim - 1];
+    auto dst_md = mkldnn::memory::desc({batch, m, n}, dtype, {m * n, n, 1});
+    mkldnn::matmul::desc desc(src_md, weights_md, dst_md);
+    pd = std::make_shared<mkldnn::matmul::primitive_desc>(desc, CpuEngine::Get()->get_engine());
+    fwd_ = std::make_shared<mkldnn::matmul>(*pd);
+  }
+
+  const mkldnn::matmul &GetFwd() const {
+    return *fwd_;
+  }
+
+ private:
+  std::shared_ptr<mkldnn::matmul> fwd_;
+};
+
+static MKLDNNBatchDotFwd &GetBatchDotFwd(const DotParam &param,
+                                         const std::vector<NDArray> &inputs,
+                                         const NDArray &output) {
+#if DMLC_CXX11_THREAD_LOCAL
+  static thread_local MKLDNNPrimitiveCache<MKLDNNBatchDotSignature,
+                                           MKLDNNBatchDotFwd, OpHash> fwds;
+#else
+  static MX_THREAD_LOCAL MKLDNNPrimitiveCache<MKLDNNBatchDotSignature,
+                                              MKLDNNBatchDotFwd, OpHash> fwds;
+#endif
+  MKLDNNBatchDotSignature key(param);
+  key.AddSign(inputs);
+  key.AddSign(output);
+
+  auto it = fwds.find(key);
+  if (it == fwds.end()) {
+    MKLDNNBatchDotFwd fwd(param, inputs, output);
+    it = AddToCache(&fwds, key, fwd);
+  }
+  return it->second;
+}
+
+void MKLDNNBatchDotForward(const nnvm::NodeAttrs& attrs,
+                           const OpContext &ctx,
+                           const std::vector<NDArray> &inputs,
+                           const std::vector<OpReqType> &req,
+                           const std::vector<NDArray> &outputs) {
+  if (req[0] == kNullOp) return;
+  const DotParam& param = nnvm::get<DotParam>(attrs.parsed);
+  auto &fwd = GetBatchDotFwd(param, inputs, outputs[0]);
+
+  // the strides of the operands describe the default layout
+  const NDArray lhs = inputs[0].IsMKLDNNData() ? inputs[0].Reorder2Default() : inputs[0];
+  const NDArray rhs = inputs[1].IsMKLDNNData() ? inputs[1].Reorder2Default() : inputs[1];
+  auto engine = CpuEngine::Get()->get_engine();
+  mkldnn::memory src_mem(fwd.pd->src_desc(), engine, lhs.data().dptr_);
+  mkldnn::memory weights_mem(fwd.pd->weights_desc(), engine, rhs.data().dptr_);
+  auto dst_mem = CreateMKLDNNMem(outputs[0], fwd.pd->dst_desc(), req[0]);
+
+  MKLDNNStream *stream = MKLDNNStream::Get();
+  stream->RegisterPrimArgs(fwd.GetFwd(), {{MKLDNN_ARG_SRC, src_mem},
+                                          {MKLDNN_ARG_WEIGHTS, weights_mem},
+                                          {MKLDNN_ARG_DST, *dst_mem.second}});
+  CommitOutput(outputs[0], dst_mem);
+  stream->Submit();
+}
+
+}  // namespace op
+}  // namespace mxnet
+#endif
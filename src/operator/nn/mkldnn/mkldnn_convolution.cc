@@ -364,7 +364,7 @@ MKLDNNConvForward::MKLDNNConvForward(const MKLDNNConvFullParam &param, const boo
 MKLDNNConvForward &GetConvFwd(const MKLDNNConvFullParam &param, const bool is_train,
                               const NDArray &data, const NDArray &weight, const NDArray *bias,
                               const NDArray &output) {
-  using conv_fwd_map = std::unordered_map<MKLDNNConvSignature, MKLDNNConvForward, OpHash>;
+  using conv_fwd_map = MKLDNNPrimitiveCache<MKLDNNConvSignature, MKLDNNConvForward, OpHash>;
 #if DMLC_CXX11_THREAD_LOCAL
   static thread_local conv_fwd_map fwds;
 #else
@@ -470,7 +470,7 @@ MKLDNNConvBackward::MKLDNNConvBackward(const MKLDNNConvFullParam &param, const N
 static inline MKLDNNConvBackward &GetConvBwd(const MKLDNNConvFullParam &param, const NDArray &data,
                                              const NDArray &weight, const NDArray *bias,
                                              const NDArray &output) {
-  using mkldnn_conv_bwd_map = std::unordered_map<MKLDNNConvSignature, MKLDNNConvBackward, OpHash>;
+  using mkldnn_conv_bwd_map = MKLDNNPrimitiveCache<MKLDNNConvSignature, MKLDNNConvBackward, OpHash>;
 #if DMLC_CXX11_THREAD_LOCAL
   static thread_local mkldnn_conv_bwd_map bwds;
 #else
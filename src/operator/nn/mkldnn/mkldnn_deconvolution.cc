@@ -258,12 +258,12 @@ MKLDNNDeconvForward &GetDeconvFwd(const nnvm::NodeAttrs &attrs,
                                   const NDArray &data, const NDArray &weights,
                                   const NDArray *bias, const NDArray &output) {
 #if DMLC_CXX11_THREAD_LOCAL
-  static thread_local std::unordered_map<DeconvSignature, MKLDNNDeconvForward,
-                                         OpHash>
+  static thread_local MKLDNNPrimitiveCache<DeconvSignature, MKLDNNDeconvForward,
+                                           OpHash>
       fwds;
 #else
   static MX_THREAD_LOCAL
-      std::unordered_map<DeconvSignature, MKLDNNDeconvForward, OpHash>
+      MKLDNNPrimitiveCache<DeconvSignature, MKLDNNDeconvForward, OpHash>
           fwds;
 #endif
   const DeconvolutionParam &param = nnvm::get<DeconvolutionParam>(attrs.parsed);
@@ -369,12 +369,12 @@ static inline MKLDNNDeconvBackwardData &GetDeconvBwdData(
     const DeconvolutionParam &param, const NDArray &data,
     const NDArray &weights, const NDArray &output) {
 #if DMLC_CXX11_THREAD_LOCAL
-  static thread_local std::unordered_map<MKLDNNDeconvSignature,
-                                         MKLDNNDeconvBackwardData, OpHash>
+  static thread_local MKLDNNPrimitiveCache<MKLDNNDeconvSignature,
+                                           MKLDNNDeconvBackwardData, OpHash>
       bwds;
 #else
-  static MX_THREAD_LOCAL std::unordered_map<MKLDNNDeconvSignature,
-                                            MKLDNNDeconvBackwardData, OpHash>
+  static MX_THREAD_LOCAL MKLDNNPrimitiveCache<MKLDNNDeconvSignature,
+                                              MKLDNNDeconvBackwardData, OpHash>
       bwds;
 #endif
   MKLDNNDeconvSignature key(param);
@@ -424,12 +424,12 @@ static inline MKLDNNDeconvBackwardWeights &GetDeconvBwdWeights(
     const NDArray &weights, const NDArray &output,
     const mkldnn::convolution_forward::primitive_desc &bwd_data_pd) {
 #if DMLC_CXX11_THREAD_LOCAL
-  static thread_local std::unordered_map<MKLDNNDeconvSignature,
-                                         MKLDNNDeconvBackwardWeights, OpHash>
+  static thread_local MKLDNNPrimitiveCache<MKLDNNDeconvSignature,
+                                           MKLDNNDeconvBackwardWeights, OpHash>
       bwds;
 #else
-  static MX_THREAD_LOCAL std::unordered_map<MKLDNNDeconvSignature,
-                                            MKLDNNDeconvBackwardWeights, OpHash>
+  static MX_THREAD_LOCAL MKLDNNPrimitiveCache<MKLDNNDeconvSignature,
+                                              MKLDNNDeconvBackwardWeights, OpHash>
       bwds;
 #endif
   MKLDNNDeconvSignature key(param);
@@ -444,11 +444,7 @@ static inline MKLDNNDeconvBackwardWeights &GetDeconvBwdWeights(
   if (it == bwds.end()) {
     auto bwd =
         MKLDNNDeconvBackwardWeights(param, data, weights, output, bwd_data_pd);
-    auto ins_ret = bwds.insert(
-        std::pair<MKLDNNDeconvSignature, MKLDNNDeconvBackwardWeights>(key,
-                                                                      bwd));
-    CHECK(ins_ret.second);
-    it = ins_ret.first;
+    it = AddToCache(&bwds, key, bwd);
   }
   return it->second;
 }
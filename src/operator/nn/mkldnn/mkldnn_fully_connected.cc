@@ -51,6 +51,10 @@ mkldnn::inner_product_forward::primitive_desc GetFCFwdImpl(
                        full_param.eltwise_param.alpha,
                        full_param.eltwise_param.beta);
   }
+  // the sum post-op adds the content of dst, which holds the residual operand
+  if (full_param.mkldnn_param.with_sum) {
+    ops.append_sum(1.0f);
+  }
   attr.set_post_ops(ops);
 
   if (full_param.mkldnn_param.quantized && full_param.output_scales.size()) {
@@ -125,11 +129,11 @@ MKLDNNFullyConnectedForward &GetFCFwd(
     const NDArray &data, const NDArray &weight,
     const NDArray *bias, const mkldnn::memory::desc &out_md) {
 #if DMLC_CXX11_THREAD_LOCAL
-  static thread_local std::unordered_map<MKLDNNFullyconSignature,
-              MKLDNNFullyConnectedForward, OpHash> fcFwds;
+  static thread_local MKLDNNPrimitiveCache<MKLDNNFullyconSignature,
+                MKLDNNFullyConnectedForward, OpHash> fcFwds;
 #else
-  static MX_THREAD_LOCAL std::unordered_map<MKLDNNFullyconSignature,
-              MKLDNNFullyConnectedForward, OpHash> fcFwds;
+  static MX_THREAD_LOCAL MKLDNNPrimitiveCache<MKLDNNFullyconSignature,
+                MKLDNNFullyConnectedForward, OpHash> fcFwds;
 #endif
   MKLDNNFullyconSignature key(param);
   key.AddSign(is_train);
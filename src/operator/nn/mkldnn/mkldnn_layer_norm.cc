@@ -0,0 +1,222 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file mkldnn_layer_norm.cc
+ * \brief Implement LayerNorm and GroupNorm forward via MKL-DNN layer_normalization primitive
+*/
+
+#if MXNET_USE_MKLDNN == 1
+
+#include <mkldnn.hpp>
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include "../layer_norm-inl.h"
+#include "../group_norm-inl.h"
+#include "./mkldnn_base-inl.h"
+#include "./mkldnn_ops-inl.h"
+
+namespace mxnet {
+namespace op {
+
+bool SupportMKLDNNLayerNorm(const LayerNormParam &param, const std::vector<NDArray> &inputs) {
+  const mxnet::TShape &shape = inputs[layernorm::kData].shape();
+  // the primitive only normalizes the innermost dimension
+  if (shape.ndim() < 2 || shape.Size() == 0 ||
+      GetRealAxis(param.axis, shape.ndim()) != shape.ndim() - 1) {
+    return false;
+  }
+  for (const auto &arr : inputs) {
+    if (arr.dtype() != mshadow::kFloat32 || arr.storage_type() != kDefaultStorage)
+      return false;
+  }
+  return true;
+}
+
+bool SupportMKLDNNGroupNorm(const GroupNormParam &param, const std::vector<NDArray> &inputs) {
+  const mxnet::TShape &shape = inputs[groupnorm::kData].shape();
+  if (shape.ndim() < 3 || shape.Size() == 0 || shape[1] % param.num_groups != 0) {
+    return false;
+  }
+  for (const auto &arr : inputs) {
+    if (arr.dtype() != mshadow::kFloat32 || arr.storage_type() != kDefaultStorage)
+      return false;
+  }
+  return true;
+}
+
+class MKLDNNLayerNormFwd {
+ public:
+  mkldnn::layer_normalization_forward::primitive_desc pd;
+
+  MKLDNNLayerNormFwd(const dim_t rows, const dim_t cols, const float eps,
+                     const bool scale_shift) : pd(GetPd(rows, cols, eps, scale_shift)) {
+    fwd_ = std::make_shared<mkldnn::layer_normalization_forward>(pd);
+    if (scale_shift) {
+      weight_ = std::make_shared<mkldnn::memory>(pd.weights_desc(),
+                                                 CpuEngine::Get()->get_engine());
+    }
+  }
+
+  const mkldnn::layer_normalization_forward &GetFwd() const {
+    return *fwd_;
+  }
+
+  /*! \brief gamma in the first row and beta in the second, nullptr without scale_shift */
+  const mkldnn::memory *GetWeight() const {
+    return weight_.get();
+  }
+
+ private:
+  static mkldnn::layer_normalization_forward::primitive_desc GetPd(
+      const dim_t rows, const dim_t cols, const float eps, const bool scale_shift) {
+    mkldnn::memory::desc data_md({rows, cols}, mkldnn::memory::data_type::f32,
+                                 mkldnn::memory::format_tag::ab);
+    mkldnn::memory::desc stat_md({rows}, mkldnn::memory::data_type::f32,
+                                 mkldnn::memory::format_tag::a);
+    // forward_training also writes the mean and variance, which are outputs of the operators
+    auto flags = scale_shift ? mkldnn::normalization_flags::use_scale_shift
+                             : static_cast<mkldnn::normalization_flags>(0U);
+    mkldnn::layer_normalization_forward::desc desc(mkldnn::prop_kind::forward_training,
+                                                   data_md, stat_md, eps, flags);
+    return mkldnn::layer_normalization_forward::primitive_desc(desc,
+                                                               CpuEngine::Get()->get_engine());
+  }
+
+  std::shared_ptr<mkldnn::layer_normalization_forward> fwd_;
+  std::shared_ptr<mkldnn::memory> weight_;
+};
+
+static MKLDNNLayerNormFwd &GetLayerNormFwd(const dim_t rows, const dim_t cols,
+                                           const float eps, const bool scale_shift) {
+#if DMLC_CXX11_THREAD_LOCAL
+  static thread_local MKLDNNPrimitiveCache<OpSignature, MKLDNNLayerNormFwd, OpHash> fwds;
+#else
+  static MX_THREAD_LOCAL MKLDNNPrimitiveCache<OpSignature, MKLDNNLayerNormFwd, OpHash> fwds;
+#endif
+  OpSignature key;
+  key.AddSign(static_cast<int>(rows));
+  key.AddSign(static_cast<int>(cols));
+  key.AddSign(eps);
+  key.AddSign(static_cast<int>(scale_shift));
+
+  auto it = fwds.find(key);
+  if (it == fwds.end()) {
+    MKLDNNLayerNormFwd fwd(rows, cols, eps, scale_shift);
+    it = AddToCache(&fwds, key, fwd);
+  }
+  return it->second;
+}
+
+/*!
+ * \brief normalize the rows of data, the variance is written to std and turned into
+ *        sqrt(var + eps) to match the outputs of the FCompute implementations.
+ */
+static void LayerNormRows(const dim_t rows, const dim_t cols, const float eps,
+                          const NDArray &data, const NDArray *gamma, const NDArray *beta,
+                          const NDArray &out, const OpReqType req,
+                          const NDArray &mean, const NDArray &std) {
+  auto &fwd = GetLayerNormFwd(rows, cols, eps, gamma != nullptr);
+  const NDArray in = data.IsMKLDNNData() ? data.Reorder2Default() : data;
+  auto cpu_engine = CpuEngine::Get()->get_engine();
+  mkldnn::memory src_mem(fwd.pd.src_desc(), cpu_engine, in.data().dptr_);
+
+  mkldnn_args_map_t args;
+  args[MKLDNN_ARG_SRC] = src_mem;
+  if (gamma != nullptr) {
+    float *weight_buf = static_cast<float *>(fwd.GetWeight()->get_data_handle());
+    const size_t copy_size = sizeof(float) * cols;
+    memcpy(weight_buf, gamma->data().dptr<float>(), copy_size);
+    memcpy(weight_buf + cols, beta->data().dptr<float>(), copy_size);
+    args[MKLDNN_ARG_SCALE_SHIFT] = *fwd.GetWeight();
+  }
+  auto dst_mem = CreateMKLDNNMem(out, fwd.pd.dst_desc(), req);
+  args[MKLDNN_ARG_DST] = *dst_mem.second;
+  float *mean_ptr = mean.data().dptr<float>();
+  float *std_ptr = std.data().dptr<float>();
+  args[MKLDNN_ARG_MEAN] = mkldnn::memory(fwd.pd.mean_desc(), cpu_engine, mean_ptr);
+  args[MKLDNN_ARG_VARIANCE] = mkldnn::memory(fwd.pd.variance_desc(), cpu_engine, std_ptr);
+
+  MKLDNNStream *stream = MKLDNNStream::Get();
+  stream->RegisterPrimArgs(fwd.GetFwd(), args);
+  CommitOutput(out, dst_mem);
+  stream->Submit();
+
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  #pragma omp parallel for num_threads(omp_threads)
+  for (index_t i = 0; i < static_cast<index_t>(rows); ++i) {
+    std_ptr[i] = std::sqrt(std_ptr[i] + eps);
+  }
+}
+
+void MKLDNNLayerNormForward(const nnvm::NodeAttrs &attrs,
+                            const OpContext &ctx,
+                            const std::vector<NDArray> &inputs,
+                            const std::vector<OpReqType> &req,
+                            const std::vector<NDArray> &outputs) {
+  if (req[layernorm::kOut] == kNullOp) return;
+  CHECK_NE(req[layernorm::kOut], kAddTo);
+  const LayerNormParam &param = nnvm::get<LayerNormParam>(attrs.parsed);
+  const mxnet::TShape &shape = inputs[layernorm::kData].shape();
+  const dim_t cols = shape[shape.ndim() - 1];
+  const dim_t rows = shape.Size() / cols;
+  LayerNormRows(rows, cols, param.eps, inputs[layernorm::kData],
+                &inputs[layernorm::kGamma], &inputs[layernorm::kBeta],
+                outputs[layernorm::kOut], req[layernorm::kOut],
+                outputs[layernorm::kMean], outputs[layernorm::kStd]);
+}
+
+void MKLDNNGroupNormForward(const nnvm::NodeAttrs &attrs,
+                            const OpContext &ctx,
+                            const std::vector<NDArray> &inputs,
+                            const std::vector<OpReqType> &req,
+                            const std::vector<NDArray> &outputs) {
+  if (req[groupnorm::kOut] == kNullOp) return;
+  CHECK_NE(req[groupnorm::kOut], kAddTo);
+  const GroupNormParam &param = nnvm::get<GroupNormParam>(attrs.parsed);
+  const mxnet::TShape &shape = inputs[groupnorm::kData].shape();
+  const dim_t batch = shape[0];
+  const dim_t channels = shape[1];
+  const dim_t spatial = shape.Size() / (batch * channels);
+  // each (batch, group) pair is a row of (channels / num_groups) * spatial elements,
+  // the per-channel gamma and beta do not fit the per-row scale_shift of the primitive
+  const dim_t rows = batch * param.num_groups;
+  const dim_t cols = shape.Size() / rows;
+  const NDArray &out = outputs[groupnorm::kOut];
+  LayerNormRows(rows, cols, param.eps, inputs[groupnorm::kData], nullptr, nullptr,
+                out, req[groupnorm::kOut], outputs[groupnorm::kMean], outputs[groupnorm::kStd]);
+
+  float *out_ptr = out.data().dptr<float>();
+  const float *gamma = inputs[groupnorm::kGamma].data().dptr<float>();
+  const float *beta = inputs[groupnorm::kBeta].data().dptr<float>();
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  #pragma omp parallel for num_threads(omp_threads)
+  for (index_t i = 0; i < static_cast<index_t>(batch * channels); ++i) {
+    const dim_t c = i % channels;
+    float *plane = out_ptr + i * spatial;
+    for (dim_t j = 0; j < spatial; ++j) {
+      plane[j] = plane[j] * gamma[c] + beta[c];
+    }
+  }
+}
+
+}  // namespace op
+}  // namespace mxnet
+#endif
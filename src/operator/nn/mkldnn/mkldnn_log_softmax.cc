@@ -102,13 +102,13 @@ static MKLDNNLogSoftmaxFwd &GetLogSoftmaxFwd(const SoftmaxParam &param,
                                              const NDArray &data,
                                              const NDArray &output) {
 #if DMLC_CXX11_THREAD_LOCAL
-  static thread_local std::unordered_map<MKLDNNSoftmaxSignature,
-                                         MKLDNNLogSoftmaxFwd,
-                                         OpHash> fwds;
+  static thread_local MKLDNNPrimitiveCache<MKLDNNSoftmaxSignature,
+                                           MKLDNNLogSoftmaxFwd,
+                                           OpHash> fwds;
 #else
-  static MX_THREAD_LOCAL std::unordered_map<MKLDNNSoftmaxSignature,
-                                            MKLDNNLogSoftmaxFwd,
-                                            OpHash> fwds;
+  static MX_THREAD_LOCAL MKLDNNPrimitiveCache<MKLDNNSoftmaxSignature,
+                                              MKLDNNLogSoftmaxFwd,
+                                              OpHash> fwds;
 #endif
 
   MKLDNNSoftmaxSignature key(param);
@@ -170,13 +170,13 @@ static MKLDNNLogSoftmaxBwd &GetLogSoftmaxBwd(const SoftmaxParam &param,
                                              const std::vector<NDArray> &data,
                                              const std::vector<NDArray> &output) {
 #if DMLC_CXX11_THREAD_LOCAL
-  static thread_local std::unordered_map<MKLDNNSoftmaxSignature,
-                                         MKLDNNLogSoftmaxBwd,
-                                         OpHash> bwds;
+  static thread_local MKLDNNPrimitiveCache<MKLDNNSoftmaxSignature,
+                                           MKLDNNLogSoftmaxBwd,
+                                           OpHash> bwds;
 #else
-  static MX_THREAD_LOCAL std::unordered_map<MKLDNNSoftmaxSignature,
-                                            MKLDNNLogSoftmaxBwd,
-                                            OpHash> bwds;
+  static MX_THREAD_LOCAL MKLDNNPrimitiveCache<MKLDNNSoftmaxSignature,
+                                              MKLDNNLogSoftmaxBwd,
+                                              OpHash> bwds;
 #endif
 
   MKLDNNSoftmaxSignature key(param);
@@ -148,13 +148,13 @@ static MKLDNNLRNFwd &GetLRNFwd(const LRNParam& param,
                                const OpContext &ctx,
                                const NDArray &in_data) {
 #if DMLC_CXX11_THREAD_LOCAL
-  static thread_local std::unordered_map<MKLDNNLRNSignature,
-                                         MKLDNNLRNFwd,
-                                         OpHash> lrn_fwds;
+  static thread_local MKLDNNPrimitiveCache<MKLDNNLRNSignature,
+                                           MKLDNNLRNFwd,
+                                           OpHash> lrn_fwds;
 #else
-  static MX_THREAD_LOCAL std::unordered_map<MKLDNNLRNSignature,
-                                            MKLDNNLRNFwd,
-                                            OpHash> lrn_fwds;
+  static MX_THREAD_LOCAL MKLDNNPrimitiveCache<MKLDNNLRNSignature,
+                                              MKLDNNLRNFwd,
+                                              OpHash> lrn_fwds;
 #endif
   auto kind_ =
       ctx.is_train ? mkldnn::prop_kind::forward_training
@@ -224,10 +224,10 @@ static MKLDNNLRNBwd &GetLRNBwd(const LRNParam &param, const NDArray &in_data,
                                const NDArray &in_grad, const NDArray &out_grad) {
 #if DMLC_CXX11_THREAD_LOCAL
   static thread_local
-      std::unordered_map<MKLDNNLRNSignature, MKLDNNLRNBwd, OpHash> lrn_bwds;
+      MKLDNNPrimitiveCache<MKLDNNLRNSignature, MKLDNNLRNBwd, OpHash> lrn_bwds;
 #else
   static MX_THREAD_LOCAL
-      std::unordered_map<MKLDNNLRNSignature, MKLDNNLRNBwd, OpHash> lrn_bwds;
+      MKLDNNPrimitiveCache<MKLDNNLRNSignature, MKLDNNLRNBwd, OpHash> lrn_bwds;
 #endif
   MKLDNNLRNSignature key(param);
   key.AddSign(in_data);
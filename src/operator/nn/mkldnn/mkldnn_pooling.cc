@@ -260,13 +260,13 @@ MKLDNNPoolingFwd &GetPoolingFwd(const PoolingParam &param,
                                 const NDArray &data,
                                 const NDArray &output) {
 #if DMLC_CXX11_THREAD_LOCAL
-  static thread_local std::unordered_map<MKLDNNPoolingSignature,
-                                         MKLDNNPoolingFwd,
-                                         OpHash> pooling_fwds;
+  static thread_local MKLDNNPrimitiveCache<MKLDNNPoolingSignature,
+                                           MKLDNNPoolingFwd,
+                                           OpHash> pooling_fwds;
 #else
-  static MX_THREAD_LOCAL std::unordered_map<MKLDNNPoolingSignature,
-                                            MKLDNNPoolingFwd,
-                                            OpHash> pooling_fwds;
+  static MX_THREAD_LOCAL MKLDNNPrimitiveCache<MKLDNNPoolingSignature,
+                                              MKLDNNPoolingFwd,
+                                              OpHash> pooling_fwds;
 #endif
 
   bool with_workspace = is_train && MKLDNNRequireWorkspace(param);
@@ -320,12 +320,12 @@ MKLDNNPoolingBwd &GetPoolingBwd(const PoolingParam &param,
                                 const NDArray &out_grad) {
 #if DMLC_CXX11_THREAD_LOCAL
   static thread_local
-      std::unordered_map<MKLDNNPoolingSignature,
-                         MKLDNNPoolingBwd, OpHash> pooling_bwds;
+      MKLDNNPrimitiveCache<MKLDNNPoolingSignature,
+                           MKLDNNPoolingBwd, OpHash> pooling_bwds;
 #else
   static MX_THREAD_LOCAL
-      std::unordered_map<MKLDNNPoolingSignature,
-                         MKLDNNPoolingBwd, OpHash> pooling_bwds;
+      MKLDNNPrimitiveCache<MKLDNNPoolingSignature,
+                           MKLDNNPoolingBwd, OpHash> pooling_bwds;
 #endif
 
   bool with_workspace = MKLDNNRequireWorkspace(param);
@@ -102,11 +102,11 @@ MKLDNNReshapeFwd &GetReshapeForward(const OpReqType &req,
                                     const NDArray &input,
                                     const NDArray &output) {
 #if DMLC_CXX11_THREAD_LOCAL
-  static thread_local std::unordered_map<MKLDNNReshapeSignature,
-                                         MKLDNNReshapeFwd, OpHash> fwds;
+  static thread_local MKLDNNPrimitiveCache<MKLDNNReshapeSignature,
+                                           MKLDNNReshapeFwd, OpHash> fwds;
 #else
-  static MX_THREAD_LOCAL std::unordered_map<MKLDNNReshapeSignature,
-                                            MKLDNNReshapeFwd, OpHash> fwds;
+  static MX_THREAD_LOCAL MKLDNNPrimitiveCache<MKLDNNReshapeSignature,
+                                              MKLDNNReshapeFwd, OpHash> fwds;
 #endif
   MKLDNNReshapeSignature key;
   key.AddSign(req);
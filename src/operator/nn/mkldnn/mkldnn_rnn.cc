@@ -384,11 +384,11 @@ void MKLDNNRnnForward::SetNewDataMem(void* x, void* hx, void* cx,
 inline void MKLDNNMemoryReorder(const mkldnn::memory& src,
                                 const mkldnn::memory& dst) {
 #if DMLC_CXX11_THREAD_LOCAL
-  static thread_local std::unordered_map<OpSignature,
-      mkldnn::reorder, OpHash> reorderPrimitives;
+  static thread_local MKLDNNPrimitiveCache<OpSignature,
+        mkldnn::reorder, OpHash> reorderPrimitives;
 #else
-  static MX_THREAD_LOCAL std::unordered_map<OpSignature,
-      mkldnn::reorder, OpHash> reorderPrimitives;
+  static MX_THREAD_LOCAL MKLDNNPrimitiveCache<OpSignature,
+        mkldnn::reorder, OpHash> reorderPrimitives;
 #endif
   OpSignature key{};
   key.AddSign(src);
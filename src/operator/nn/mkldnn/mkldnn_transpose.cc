@@ -120,11 +120,11 @@ class MKLDNNTransposeForward {
 static MKLDNNTransposeForward &GetTransposeForward(const TransposeParam& param,
                                                    const NDArray &data) {
 #if DMLC_CXX11_THREAD_LOCAL
-  static thread_local std::unordered_map<MKLDNNTransposeSignature,
-                                         MKLDNNTransposeForward, OpHash> fwds;
+  static thread_local MKLDNNPrimitiveCache<MKLDNNTransposeSignature,
+                                           MKLDNNTransposeForward, OpHash> fwds;
 #else
-  static MX_THREAD_LOCAL std::unordered_map<MKLDNNTransposeSignature,
-                                            MKLDNNTransposeForward, OpHash> fwds;
+  static MX_THREAD_LOCAL MKLDNNPrimitiveCache<MKLDNNTransposeSignature,
+                                              MKLDNNTransposeForward, OpHash> fwds;
 #endif
   MKLDNNTransposeSignature key(param);
   key.AddSign(data);
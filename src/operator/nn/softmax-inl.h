@@ -26,6 +26,7 @@
 #define MXNET_OPERATOR_NN_SOFTMAX_INL_H_
 
 #include <algorithm>
+#include <limits>
 #include <string>
 #include <utility>
 #include <vector>
@@ -259,6 +260,43 @@ inline void SoftmaxGrad(Stream<cpu> *s, OType *out, OType *ograd,
 }
 
 
+/*!
+ * \brief Softmax over the elements of each row of `in` where the mask is true, after scaling
+ *        them by 1 / temperature. The other elements, and the rows with none, output 0.
+ */
+template<typename AType, typename DType, typename OType, int ndim>
+inline void MaskedSoftmax(Stream<cpu> *s, const DType *in, OType *out, const bool *mask,
+                          Shape<ndim> shape, int axis, const double temperature) {
+  index_t M = shape[axis];
+  if (M == 0) return;
+  index_t N = shape.Size()/M;
+  Shape<ndim> stride = calc_stride(shape);
+  Shape<ndim> sshape = shape;
+  sshape[axis] = 1;
+  index_t sa = stride[axis];
+  const AType scale = AType(1) / static_cast<AType>(temperature);
+
+  #pragma omp parallel for
+  for (index_t i = 0; i < N; ++i) {
+    index_t base = unravel_dot(i, sshape, stride);
+
+    AType mmax = -std::numeric_limits<AType>::infinity();
+    for (index_t j = 0; j < M; ++j) {
+      if (mask[base + j*sa]) mmax = std::max(mmax, static_cast<AType>(in[base + j*sa]) * scale);
+    }
+
+    AType sum = AType(0);
+    for (index_t j = 0; j < M; ++j) {
+      if (mask[base + j*sa]) sum += std::exp(static_cast<AType>(in[base + j*sa]) * scale - mmax);
+    }
+
+    for (index_t j = 0; j < M; ++j) {
+      out[base + j*sa] = mask[base + j*sa] ?
+        OType(std::exp(static_cast<AType>(in[base + j*sa]) * scale - mmax) / sum) : OType(0.0f);
+    }
+  }
+}
+
 #ifdef __CUDACC__
 template<int x_bits, typename OP, bool negate, typename AType, int ndim,
          typename DType, typename OType, typename IType>
@@ -591,6 +629,158 @@ inline void SoftmaxGrad(Stream<gpu> *s, OType *out, OType *ograd,
     MSHADOW_CUDA_POST_KERNEL_CHECK(softmax_grad_kernel);
   }
 }
+
+/*! \brief rows of a block of masked_softmax_warp_kernel, one per warp */
+const int masked_softmax_warp_rows = 4;
+/*! \brief largest number of aligned vectors of a row held by a lane of
+ *         masked_softmax_warp_kernel */
+const int masked_softmax_max_vecs = 8;
+
+/*!
+ * \brief Masked softmax with a warp per contiguous row, which it loads once into the registers
+ *        in aligned vectors of nvec elements, lane l holding vectors l, l + 32, ...
+ */
+template<typename AType, int nvec, int nvecs_per_lane, typename DType>
+__global__ void masked_softmax_warp_kernel(const DType *in, DType *out, const bool *mask,
+                                           const index_t M, const index_t N,
+                                           const double temperature) {
+  using VType = common::cuda::aligned_vector<DType, nvec>;
+  using MType = common::cuda::aligned_vector<bool, nvec>;
+  const index_t row = static_cast<index_t>(blockIdx.x) * blockDim.y + threadIdx.y;
+  if (row >= N) return;
+  const index_t nvecs = M / nvec;
+  const index_t base = row * nvecs;
+  const AType scale = AType(1) / static_cast<AType>(temperature);
+  AType vals[nvecs_per_lane][nvec];
+  bool keep[nvecs_per_lane][nvec];
+  AType smax = -INFINITY;
+#pragma unroll
+  for (int k = 0; k < nvecs_per_lane; ++k) {
+    const index_t l = threadIdx.x + k * common::cuda::warp_size;
+    VType x;
+    MType m;
+    if (l < nvecs) {
+      x = reinterpret_cast<const VType*>(in)[base + l];
+      m = reinterpret_cast<const MType*>(mask)[base + l];
+    }
+#pragma unroll
+    for (int i = 0; i < nvec; ++i) {
+      keep[k][i] = l < nvecs && m.val[i];
+      vals[k][i] = keep[k][i] ? static_cast<AType>(x.val[i]) * scale : AType(-INFINITY);
+      smax = ::max(smax, vals[k][i]);
+    }
+  }
+  smax = common::cuda::warp_allreduce(smax, [](AType x, AType y) { return ::max(x, y); });
+  AType ssum = 0;
+#pragma unroll
+  for (int k = 0; k < nvecs_per_lane; ++k) {
+#pragma unroll
+    for (int i = 0; i < nvec; ++i) {
+      vals[k][i] = keep[k][i] ? exp(vals[k][i] - smax) : AType(0);
+      ssum += vals[k][i];
+    }
+  }
+  ssum = common::cuda::warp_allreduce(ssum, [](AType x, AType y) { return x + y; });
+  const AType inv_sum = ssum > AType(0) ? AType(1) / ssum : AType(0);
+#pragma unroll
+  for (int k = 0; k < nvecs_per_lane; ++k) {
+    const index_t l = threadIdx.x + k * common::cuda::warp_size;
+    if (l >= nvecs) break;
+    VType y;
+#pragma unroll
+    for (int i = 0; i < nvec; ++i) y.val[i] = DType(vals[k][i] * inv_sum);
+    reinterpret_cast<VType*>(out)[base + l] = y;
+  }
+}
+
+template<int x_bits, typename AType, int ndim, typename DType, typename OType>
+__global__ void masked_softmax_compute_kernel(const DType *in, OType *out, const bool *mask,
+                                              index_t M, int axis, Shape<ndim> sshape,
+                                              Shape<ndim> stride, const double temperature) {
+  const unsigned x_size = 1 << x_bits;
+  __shared__ AType smem[x_size];
+  index_t sa = stride[axis];
+  index_t base = unravel_dot(blockIdx.x, sshape, stride);
+  index_t x = threadIdx.x;
+  const AType scale = AType(1) / static_cast<AType>(temperature);
+
+  smem[x] = -INFINITY;
+  for (index_t i = x; i < M; i += x_size) {
+    if (mask[base + i*sa]) smem[x] = ::max(smem[x], static_cast<AType>(in[base + i*sa]) * scale);
+  }
+  __syncthreads();
+  cuda::Reduce1D<red::maximum, x_bits>(smem);
+  __syncthreads();
+  AType smax = smem[0];
+  __syncthreads();
+
+  red::sum::SetInitValue(smem[x]);
+  for (index_t i = x; i < M; i += x_size) {
+    if (mask[base + i*sa]) smem[x] += exp(static_cast<AType>(in[base + i*sa]) * scale - smax);
+  }
+  __syncthreads();
+  cuda::Reduce1D<red::sum, x_bits>(smem);
+  __syncthreads();
+  AType ssum = smem[0];
+  __syncthreads();
+
+  for (index_t i = x; i < M; i += x_size) {
+    out[base + i*sa] = mask[base + i*sa] ?
+      OType(exp(static_cast<AType>(in[base + i*sa]) * scale - smax) / ssum) : OType(0.0f);
+  }
+}
+
+template<typename AType, typename DType, typename OType, int ndim>
+inline void MaskedSoftmax(Stream<gpu> *s, const DType *in, OType *out, const bool *mask,
+                          Shape<ndim> shape, int axis, const double temperature) {
+  const int x_bits = 7;
+  const int x_size = 1 << x_bits;
+  index_t M = shape[axis];
+  if (M == 0 || shape.Size() == 0) return;
+  index_t N = shape.Size()/M;
+  Shape<ndim> stride = calc_stride(shape);
+  Shape<ndim> sshape = shape;
+  sshape[axis] = 1;
+  cudaStream_t stream = mshadow::Stream<gpu>::GetStream(s);
+
+  if (stride[axis] == 1 && std::is_same<DType, OType>::value) {
+    int nvec = common::cuda::get_vector_length<DType>(M, {in, out});
+    while (nvec > 1 && reinterpret_cast<uintptr_t>(mask) % nvec != 0) nvec /= 2;
+    const index_t nvecs_per_lane = (M / nvec + common::cuda::warp_size - 1) /
+                                   common::cuda::warp_size;
+    if (nvecs_per_lane <= masked_softmax_max_vecs) {
+      const dim3 block(common::cuda::warp_size, masked_softmax_warp_rows);
+      const dim3 grid((N + masked_softmax_warp_rows - 1) / masked_softmax_warp_rows);
+      auto launch = [&](auto vec, auto vecs) {
+        masked_softmax_warp_kernel<AType, decltype(vec)::value, decltype(vecs)::value>
+          <<<grid, block, 0, stream>>>(in, reinterpret_cast<DType*>(out), mask, M, N,
+                                       temperature);
+      };
+      auto launch_vec = [&](auto vec) {
+        if (nvecs_per_lane <= 1) {
+          launch(vec, std::integral_constant<int, 1>());
+        } else if (nvecs_per_lane <= 2) {
+          launch(vec, std::integral_constant<int, 2>());
+        } else if (nvecs_per_lane <= 4) {
+          launch(vec, std::integral_constant<int, 4>());
+        } else {
+          launch(vec, std::integral_constant<int, masked_softmax_max_vecs>());
+        }
+      };
+      switch (nvec) {
+        case 8: launch_vec(std::integral_constant<int, 8>()); break;
+        case 4: launch_vec(std::integral_constant<int, 4>()); break;
+        case 2: launch_vec(std::integral_constant<int, 2>()); break;
+        default: launch_vec(std::integral_constant<int, 1>()); break;
+      }
+      MSHADOW_CUDA_POST_KERNEL_CHECK(masked_softmax_warp_kernel);
+      return;
+    }
+  }
+  masked_softmax_compute_kernel<x_bits, AType, ndim>
+    <<<N, x_size, 0, stream>>>(in, out, mask, M, axis, sshape, stride, temperature);
+  MSHADOW_CUDA_POST_KERNEL_CHECK(masked_softmax_compute_kernel);
+}
 #endif
 
 }  // namespace mxnet_op
@@ -907,6 +1097,123 @@ void SoftmaxGradCompute(const nnvm::NodeAttrs& attrs,
   });
 }
 
+struct MaskedSoftmaxParam : public dmlc::Parameter<MaskedSoftmaxParam> {
+  int axis;
+  dmlc::optional<double> temperature;
+  DMLC_DECLARE_PARAMETER(MaskedSoftmaxParam) {
+    DMLC_DECLARE_FIELD(axis).set_default(-1)
+    .describe("The axis along which to compute softmax.");
+    DMLC_DECLARE_FIELD(temperature).set_default(dmlc::optional<double>())
+    .describe("Temperature parameter in softmax, by which the data is divided");
+  }
+};
+
+static inline bool MaskedSoftmaxOpShape(const nnvm::NodeAttrs& attrs,
+                                        mxnet::ShapeVector *in_attrs,
+                                        mxnet::ShapeVector *out_attrs) {
+  CHECK_EQ(in_attrs->size(), 2U) << "Input:[data, mask]";
+  CHECK_EQ(out_attrs->size(), 1U);
+  return ElemwiseShape<2, 1>(attrs, in_attrs, out_attrs);
+}
+
+static inline bool MaskedSoftmaxOpType(const nnvm::NodeAttrs& attrs,
+                                       std::vector<int>* in_attrs,
+                                       std::vector<int>* out_attrs) {
+  CHECK_EQ(in_attrs->size(), 2U);
+  CHECK_EQ(out_attrs->size(), 1U);
+  TYPE_ASSIGN_CHECK(*in_attrs, 1, mshadow::kBool);
+  std::vector<int> tmp = {in_attrs->at(0)};
+  bool ret = ElemwiseType<1, 1>(attrs, &tmp, out_attrs);
+  TYPE_ASSIGN_CHECK(*in_attrs, 0, tmp[0]);
+  return ret;
+}
+
+template<typename xpu>
+void MaskedSoftmaxCompute(const nnvm::NodeAttrs& attrs,
+                          const OpContext& ctx,
+                          const std::vector<TBlob>& inputs,
+                          const std::vector<OpReqType>& req,
+                          const std::vector<TBlob>& outputs) {
+  using namespace mxnet_op;
+  if (req[0] == kNullOp || inputs[0].Size() == 0U) return;
+  CHECK_NE(req[0], kAddTo);
+  const MaskedSoftmaxParam& param = nnvm::get<MaskedSoftmaxParam>(attrs.parsed);
+  int axis = CheckAxis(param.axis, inputs[0].ndim());
+  const double temperature = param.temperature.has_value() ?
+    param.temperature.value() : 1.0;
+  mxnet::TShape shape = AxisShapeCompact(inputs[0].shape_, &axis, true);
+
+  MSHADOW_REAL_TYPE_SWITCH(inputs[0].type_flag_, DType, {
+    // float16 accumulates in float, whether or not MXNET_SAFE_ACCUMULATION is set
+    typedef typename std::conditional<std::is_same<DType, double>::value,
+                                      double, float>::type AType;
+    const bool* mask = inputs[1].dptr<bool>();
+    if (shape.ndim() == 2) {
+      MaskedSoftmax<AType>(ctx.get_stream<xpu>(), inputs[0].dptr<DType>(),
+                           outputs[0].dptr<DType>(), mask, shape.get<2>(), axis, temperature);
+    } else {
+      MaskedSoftmax<AType>(ctx.get_stream<xpu>(), inputs[0].dptr<DType>(),
+                           outputs[0].dptr<DType>(), mask, shape.get<3>(), axis, temperature);
+    }
+  });
+}
+
+/*!
+ * \brief Gradient of masked_softmax. The output is 0 where the mask is false, so that the
+ *        gradient of softmax already vanishes there.
+ */
+template<typename xpu>
+void MaskedSoftmaxGradCompute(const nnvm::NodeAttrs& attrs,
+                              const OpContext& ctx,
+                              const std::vector<TBlob>& inputs,
+                              const std::vector<OpReqType>& req,
+                              const std::vector<TBlob>& outputs) {
+  using namespace mxnet_op;
+  // inputs: ograd, output; outputs: data grad, mask grad
+  if (req[1] != kNullOp) {
+    Kernel<set_zero, xpu>::Launch(ctx.get_stream<xpu>(), outputs[1].Size(),
+                                  outputs[1].dptr<bool>());
+  }
+  if (req[0] == kNullOp || inputs[0].Size() == 0U) return;
+  const MaskedSoftmaxParam& param = nnvm::get<MaskedSoftmaxParam>(attrs.parsed);
+  int axis = CheckAxis(param.axis, inputs[0].ndim());
+  const double temperature = param.temperature.has_value() ?
+    param.temperature.value() : 1.0;
+  mxnet::TShape shape = AxisShapeCompact(inputs[0].shape_, &axis, true);
+  bool safe_acc = dmlc::GetEnv("MXNET_SAFE_ACCUMULATION", true);
+  int* length = nullptr;
+
+  MXNET_REAL_ACC_TYPE_SWITCH(inputs[0].type_flag_, DType, AType, {
+    MXNET_ASSIGN_REQ_SWITCH(req[0], Req, {
+      if (safe_acc) {
+        if (shape.ndim() == 2) {
+          SoftmaxGrad<mshadow_op::mul, softmax_bwd, Req, false, AType>(
+              ctx.get_stream<xpu>(), inputs[1].dptr<DType>(), inputs[0].dptr<DType>(),
+              outputs[0].dptr<DType>(), length, shape.get<2>(), axis,
+              static_cast<DType>(temperature));
+        } else {
+          SoftmaxGrad<mshadow_op::mul, softmax_bwd, Req, false, AType>(
+              ctx.get_stream<xpu>(), inputs[1].dptr<DType>(), inputs[0].dptr<DType>(),
+              outputs[0].dptr<DType>(), length, shape.get<3>(), axis,
+              static_cast<DType>(temperature));
+        }
+      } else {
+        if (shape.ndim() == 2) {
+          SoftmaxGrad<mshadow_op::mul, softmax_bwd, Req, false, DType>(
+              ctx.get_stream<xpu>(), inputs[1].dptr<DType>(), inputs[0].dptr<DType>(),
+              outputs[0].dptr<DType>(), length, shape.get<2>(), axis,
+              static_cast<DType>(temperature));
+        } else {
+          SoftmaxGrad<mshadow_op::mul, softmax_bwd, Req, false, DType>(
+              ctx.get_stream<xpu>(), inputs[1].dptr<DType>(), inputs[0].dptr<DType>(),
+              outputs[0].dptr<DType>(), length, shape.get<3>(), axis,
+              static_cast<DType>(temperature));
+        }
+      }
+    });
+  });
+}
+
 }  // namespace op
 }  // namespace mxnet
 
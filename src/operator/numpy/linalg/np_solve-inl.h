@@ -236,8 +236,191 @@ LINALG_XPU_BATCH_SOLVE(cpu, double)
 
 #ifdef __CUDACC__
 
-LINALG_XPU_BATCH_SOLVE(gpu, float)
-LINALG_XPU_BATCH_SOLVE(gpu, double)
+// Solves a batch of N x N col-major systems, one system with all of its right-hand
+// sides per thread. The LU factorization with partial pivoting is held in registers.
+template<int N, typename DType>
+__global__ void SolveSmallGPU(const DType *a, DType *x, int nbatch, int nrhs) {
+  for (int b = blockIdx.x * blockDim.x + threadIdx.x; b < nbatch; b += blockDim.x * gridDim.x) {
+    const DType *m = a + b * N * N;
+    DType *y = x + b * N * nrhs;
+    DType lu[N][N];
+    int perm[N];
+    #pragma unroll
+    for (int i = 0; i < N; ++i) {
+      #pragma unroll
+      for (int j = 0; j < N; ++j) {
+        lu[i][j] = m[j * N + i];
+      }
+    }
+    #pragma unroll
+    for (int k = 0; k < N; ++k) {
+      int p = k;
+      DType pmax = fabs(lu[k][k]);
+      #pragma unroll
+      for (int i = k + 1; i < N; ++i) {
+        if (fabs(lu[i][k]) > pmax) {
+          p = i;
+          pmax = fabs(lu[i][k]);
+        }
+      }
+      perm[k] = p;
+      // rows are swapped by static indices, so that lu stays in registers
+      #pragma unroll
+      for (int i = k + 1; i < N; ++i) {
+        if (i == p) {
+          #pragma unroll
+          for (int j = 0; j < N; ++j) {
+            const DType tmp = lu[i][j];
+            lu[i][j] = lu[k][j];
+            lu[k][j] = tmp;
+          }
+        }
+      }
+      #pragma unroll
+      for (int i = k + 1; i < N; ++i) {
+        lu[i][k] /= lu[k][k];
+        #pragma unroll
+        for (int j = k + 1; j < N; ++j) {
+          lu[i][j] -= lu[i][k] * lu[k][j];
+        }
+      }
+    }
+    for (int r = 0; r < nrhs; ++r) {
+      DType v[N];
+      #pragma unroll
+      for (int i = 0; i < N; ++i) {
+        v[i] = y[r * N + i];
+      }
+      #pragma unroll
+      for (int k = 0; k < N; ++k) {
+        #pragma unroll
+        for (int i = k + 1; i < N; ++i) {
+          if (i == perm[k]) {
+            const DType tmp = v[i];
+            v[i] = v[k];
+            v[k] = tmp;
+          }
+        }
+      }
+      #pragma unroll
+      for (int i = 1; i < N; ++i) {
+        #pragma unroll
+        for (int k = 0; k < i; ++k) {
+          v[i] -= lu[i][k] * v[k];
+        }
+      }
+      #pragma unroll
+      for (int i = N - 1; i >= 0; --i) {
+        #pragma unroll
+        for (int k = i + 1; k < N; ++k) {
+          v[i] -= lu[i][k] * v[k];
+        }
+        v[i] /= lu[i][i];
+      }
+      #pragma unroll
+      for (int i = 0; i < N; ++i) {
+        y[r * N + i] = v[i];
+      }
+    }
+  }
+}
+
+// Solves batches of small systems with SolveSmallGPU, returns false if the size of
+// the matrices is not supported.
+template<typename DType>
+inline bool linalg_batch_solve_small(const Tensor<gpu, 3, DType>& A,
+                                     const Tensor<gpu, 3, DType>& X,
+                                     Stream<gpu> *s) {
+  using namespace mshadow::cuda;
+  const int nbatch(A.size(0)), nrhs(X.size(1));
+  const int ngrid = std::min(kMaxGridNum, (nbatch + kBaseThreadNum - 1) / kBaseThreadNum);
+  cudaStream_t stream = Stream<gpu>::GetStream(s);
+  switch (A.size(1)) {
+#define LINALG_GPU_SOLVE_SMALL_CASE(N) \
+  case N: \
+    SolveSmallGPU<N><<<ngrid, kBaseThreadNum, 0, stream>>>(A.dptr_, X.dptr_, nbatch, nrhs); \
+    break;
+  LINALG_GPU_SOLVE_SMALL_CASE(1)
+  LINALG_GPU_SOLVE_SMALL_CASE(2)
+  LINALG_GPU_SOLVE_SMALL_CASE(3)
+  LINALG_GPU_SOLVE_SMALL_CASE(4)
+#undef LINALG_GPU_SOLVE_SMALL_CASE
+  default:
+    return false;
+  }
+  MSHADOW_CUDA_POST_KERNEL_CHECK(SolveSmallGPU);
+  return true;
+}
+
+#if CUDA_VERSION >= 8000
+
+// Batches of moderately sized systems are solved by getrfBatched and getrsBatched
+// of cuBLAS in two calls.
+#define LINALG_GPU_BATCH_SOLVE_BATCHED(getrf, getrs, DType) \
+inline void linalg_batch_solve_batched(const Tensor<gpu, 3, DType>& A, \
+                                       const Tensor<gpu, 3, DType>& X, \
+                                       const Tensor<gpu, 2, int>& ipiv, \
+                                       Stream<gpu> *s) { \
+  using namespace mxnet; \
+  using namespace mxnet::op::mxnet_op; \
+  const int nbatch = A.size(0), N = A.size(1), nrhs = X.size(1); \
+  EPHEMERAL_GPU_STORAGE_ALLOC(linalg_batch_solve, info, int, nbatch); \
+  EPHEMERAL_GPU_STORAGE_ALLOC(linalg_batch_solve, A_ptr_buf, DType *, nbatch); \
+  EPHEMERAL_GPU_STORAGE_ALLOC(linalg_batch_solve, X_ptr_buf, DType *, nbatch); \
+  DType **A_ptr = static_cast<DType **>(A_ptr_buf.dptr); \
+  DType **X_ptr = static_cast<DType **>(X_ptr_buf.dptr); \
+  Kernel<set_matrix, gpu>::Launch(s, nbatch, A_ptr, A.dptr_, N * N); \
+  Kernel<set_matrix, gpu>::Launch(s, nbatch, X_ptr, X.dptr_, N * nrhs); \
+  CUBLAS_CALL(cublas##getrf(Stream<gpu>::GetBlasHandle(s), N, A_ptr, N, ipiv.dptr_, \
+                            static_cast<int *>(info.dptr), nbatch)); \
+  int getrs_info(0); \
+  CUBLAS_CALL(cublas##getrs(Stream<gpu>::GetBlasHandle(s), CUBLAS_OP_N, N, nrhs, \
+                            const_cast<const DType **>(A_ptr), N, ipiv.dptr_, X_ptr, N, \
+                            &getrs_info, nbatch)); \
+  CHECK_EQ(getrs_info, 0) << #getrs << ": the " << -getrs_info \
+    << "-th argument had an illegal value"; \
+  Storage::Get()->Free(info); \
+  Storage::Get()->Free(A_ptr_buf); \
+  Storage::Get()->Free(X_ptr_buf); \
+}
+
+#else  // CUDA_VERSION >= 8000
+
+#define LINALG_GPU_BATCH_SOLVE_BATCHED(getrf, getrs, DType) \
+inline void linalg_batch_solve_batched(const Tensor<gpu, 3, DType>& A, \
+                                       const Tensor<gpu, 3, DType>& X, \
+                                       const Tensor<gpu, 2, int>& ipiv, \
+                                       Stream<gpu> *s) { \
+  LOG(FATAL) << "gpu solve requires CUDA version >= 8.0!"; \
+}
+
+#endif  // CUDA_VERSION >= 8000
+
+LINALG_GPU_BATCH_SOLVE_BATCHED(SgetrfBatched, SgetrsBatched, float)
+LINALG_GPU_BATCH_SOLVE_BATCHED(DgetrfBatched, DgetrsBatched, double)
+
+// Small systems are solved in registers, batches of moderately sized systems by
+// the batched routines, large ones by one call per system.
+#define LINALG_GPU_BATCH_SOLVE(DType) \
+template<> inline \
+void linalg_batch_solve<gpu, DType>(const Tensor<gpu, 3, DType>& A, \
+                                    const Tensor<gpu, 3, DType>& X, \
+                                    const Tensor<gpu, 2, int>& ipiv, \
+                                    const mxnet::OpContext& ctx) { \
+  Stream<gpu> *s = ctx.get_stream<gpu>(); \
+  if (A.size(1) <= kLinalgSmallSize && linalg_batch_solve_small(A, X, s)) { \
+    return; \
+  } \
+  if (A.size(0) > 1 && A.size(1) <= kLinalgBatchedMaxSize) { \
+    linalg_batch_solve_batched(A, X, ipiv, s); \
+    return; \
+  } \
+  for (index_t i = 0; i < A.size(0); ++i) { \
+    linalg_solve(A[i], X[i], ipiv[i], s); \
+  } \
+}
+LINALG_GPU_BATCH_SOLVE(float)
+LINALG_GPU_BATCH_SOLVE(double)
 
 #endif  // __CUDACC__
 
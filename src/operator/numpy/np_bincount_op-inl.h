@@ -34,6 +34,7 @@
 #include "../operator_common.h"
 #include "../elemwise_op_common.h"
 #include "np_broadcast_reduce_op.h"
+#include "../tensor/histogram-inl.h"
 
 namespace mxnet {
 namespace op {
@@ -60,6 +61,19 @@ struct NumpyBincountParam : public dmlc::Parameter<NumpyBincountParam> {
   }
 };
 
+/*! \brief bins of bincount, the values of data, weighted by weights or by 1 without them */
+template<typename DType, typename OType>
+struct BincountBin {
+  const DType* data;
+  const OType* weights;
+  MSHADOW_XINLINE int Bin(index_t i) const {
+    return static_cast<int>(data[i]);
+  }
+  MSHADOW_XINLINE OType Weight(index_t i) const {
+    return weights != nullptr ? weights[i] : OType(1);
+  }
+};
+
 inline bool NumpyBincountType(const nnvm::NodeAttrs& attrs,
                               std::vector<int> *in_attrs,
                               std::vector<int> *out_attrs) {
@@ -44,23 +44,6 @@ void BinNumberCount(const NDArray& data, const int& minlength,
   const_cast<NDArray &>(out).Init(s);  // set the output shape forcefully
 }
 
-template<typename DType, typename OType>
-void BincountCpuWeights(const DType* data, const OType* weights,
-                        OType* out, const size_t& data_n) {
-  for (size_t i = 0; i < data_n; i++) {
-    int target = data[i];
-    out[target] += weights[i];
-  }
-}
-
-template<typename DType, typename OType>
-void BincountCpu(const DType* data, OType* out, const size_t& data_n) {
-  for (size_t i = 0; i < data_n; i++) {
-    int target = data[i];
-    out[target] += 1;
-  }
-}
-
 template<>
 void NumpyBincountForwardImpl<cpu>(const OpContext &ctx,
                                    const NDArray &data,
@@ -75,8 +58,9 @@ void NumpyBincountForwardImpl<cpu>(const OpContext &ctx,
       MSHADOW_TYPE_SWITCH(weights.dtype(), OType, {
         size_t out_size = out.shape()[0];
         Kernel<set_zero, cpu>::Launch(s, out_size, out.data().dptr<OType>());
-        BincountCpuWeights(data.data().dptr<DType>(), weights.data().dptr<OType>(),
-                          out.data().dptr<OType>(), data_n);
+        ParallelHistogramCPU(out.data().dptr<OType>(), data_n, static_cast<int>(out_size),
+                             BincountBin<DType, OType>{data.data().dptr<DType>(),
+                                                       weights.data().dptr<OType>()});
       });
     });
 }
@@ -94,7 +78,8 @@ void NumpyBincountForwardImpl<cpu>(const OpContext &ctx,
       MSHADOW_TYPE_SWITCH(out.dtype(), OType, {
         size_t out_size = out.shape()[0];
         Kernel<set_zero, cpu>::Launch(s, out_size, out.data().dptr<OType>());
-        BincountCpu(data.data().dptr<DType>(), out.data().dptr<OType>(), data_n);
+        ParallelHistogramCPU(out.data().dptr<OType>(), data_n, static_cast<int>(out_size),
+                             BincountBin<DType, OType>{data.data().dptr<DType>(), nullptr});
       });
     });
 }
@@ -28,22 +28,15 @@
 #include <thrust/extrema.h>
 #include "../tensor/util/tensor_util-inl.cuh"
 #include "../tensor/util/tensor_util-inl.h"
+#include "../tensor/histogram-inl.cuh"
 
 namespace mxnet {
 namespace op {
 
 struct BincountFusedKernel {
-  template<typename DType, typename OType>
-  static MSHADOW_XINLINE void Map(int i, const DType* data, OType* out) {
-    int idx = data[i];
-    atomicAdd(&out[idx], 1);
-  }
-
-  template<typename DType, typename OType>
-  static MSHADOW_XINLINE void Map(int i, const DType* data, const OType* weights,
-                                  OType* out) {
-    int idx = data[i];
-    atomicAdd(&out[idx], weights[i]);
+  template<typename OType, typename BinOp>
+  static MSHADOW_XINLINE void Map(int i, OType* out, const BinOp op) {
+    atomicAdd(&out[op.Bin(i)], op.Weight(i));
   }
 };
 
@@ -104,9 +97,12 @@ void NumpyBincountForwardImpl<gpu>(const OpContext &ctx,
       MSHADOW_TYPE_SWITCH(weights.dtype(), OType, {
         size_t out_size = out.shape().Size();
         Kernel<set_zero, gpu>::Launch(s, out_size, out.data().dptr<OType>());
-        Kernel<BincountFusedKernel, gpu>::Launch(
-          s, data_n, data.data().dptr<DType>(), weights.data().dptr<OType>(),
-          out.data().dptr<OType>());
+        const BincountBin<DType, OType> op{data.data().dptr<DType>(),
+                                           weights.data().dptr<OType>()};
+        if (!PrivatizedHistogram(s, ctx.run_ctx.ctx.dev_id, out.data().dptr<OType>(),
+                                 data_n, static_cast<int>(out_size), op)) {
+          Kernel<BincountFusedKernel, gpu>::Launch(s, data_n, out.data().dptr<OType>(), op);
+        }
       });
     });
 }
@@ -147,8 +143,11 @@ void NumpyBincountForwardImpl<gpu>(const OpContext &ctx,
     MSHADOW_TYPE_SWITCH(out.dtype(), OType, {
       size_t out_size = out.shape().Size();
       Kernel<set_zero, gpu>::Launch(s, out_size, out.data().dptr<OType>());
-      Kernel<BincountFusedKernel, gpu>::Launch(
-        s, data_n, data.data().dptr<DType>(), out.data().dptr<OType>());
+      const BincountBin<DType, OType> op{data.data().dptr<DType>(), nullptr};
+      if (!PrivatizedHistogram(s, ctx.run_ctx.ctx.dev_id, out.data().dptr<OType>(),
+                               data_n, static_cast<int>(out_size), op)) {
+        Kernel<BincountFusedKernel, gpu>::Launch(s, data_n, out.data().dptr<OType>(), op);
+      }
     });
   });
 }
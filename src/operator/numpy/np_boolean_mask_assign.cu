@@ -109,6 +109,37 @@ struct BooleanAssignGPUKernel {
   }
 };
 
+/*!
+ * \brief Assign to the elements of data where the mask is true, the mask covering the
+ *        middle axes of data. It reads the mask directly, without its prefix sum.
+ */
+struct BooleanAssignMaskedGPUKernel {
+  template<typename DType, typename MType>
+  static void __device__ Map(int i,
+                             DType* data,
+                             const MType* mask,
+                             const size_t middle,
+                             const size_t trailing,
+                             const DType val) {
+    if (mask[i / trailing % middle]) {
+      data[i] = val;
+    }
+  }
+
+  template<typename DType, typename MType>
+  static void __device__ Map(int i,
+                             DType* data,
+                             const MType* mask,
+                             const size_t middle,
+                             const size_t trailing,
+                             const DType* tensor,
+                             const bool scalar) {
+    if (mask[i / trailing % middle]) {
+      data[i] = scalar ? tensor[0] : tensor[i / trailing / middle * trailing + i % trailing];
+    }
+  }
+};
+
 struct NonZeroWithCast {
   template<typename OType, typename IType>
   static void __device__ Map(int i, OType* out, const IType* in) {
@@ -184,41 +215,8 @@ void NumpyBooleanAssignForwardGPU(const nnvm::NodeAttrs& attrs,
   const TShape& mshape = mask.shape_;
   const int start_axis = std::stoi(common::attr_value_string(attrs, "start_axis", "0"));
 
-  // Get valid_num
   size_t mask_size = mask.shape_.Size();
-  size_t valid_num = 0;
-  size_t* prefix_sum = nullptr;
-  if (mask_size != 0) {
-    MSHADOW_TYPE_SWITCH_WITH_BOOL(mask.type_flag_, MType, {
-      prefix_sum = GetValidNumGPU<MType>(ctx, mask.dptr<MType>(), mask_size);
-    });
-    cudaStream_t stream = mshadow::Stream<gpu>::GetStream(s);
-    CUDA_CALL(cudaMemcpyAsync(&valid_num, &prefix_sum[mask_size], sizeof(size_t),
-                              cudaMemcpyDeviceToHost, stream));
-    CUDA_CALL(cudaStreamSynchronize(stream));
-  }
-
-  // If there's no True in mask, return directly
-  if (valid_num == 0) return;
-
-  const TShape& vshape = inputs[2].shape_;
-
-  if (inputs.size() == 3U) {
-    // tensor case
-    if (inputs[2].shape_.Size() != 1) {
-      auto vndim = vshape.ndim();
-      auto dndim = dshape.ndim();
-      auto mndim = mshape.ndim();
-      CHECK(vndim <= (dndim - mndim + 1));
-      if ((vndim == (dndim - mndim + 1)) && (vshape[start_axis] != 1)) {
-        // tensor case, check tensor size equal to or broadcastable with valid_num
-        CHECK_EQ(static_cast<size_t>(valid_num), vshape[start_axis])
-          << "boolean array indexing assignment cannot assign " << vshape
-          << " input values to the " << valid_num << " output values where the mask is true"
-          << std::endl;
-      }
-    }
-  }
+  if (mask_size == 0) return;
 
   size_t leading = 1U;
   size_t middle = mask_size;
@@ -233,32 +231,67 @@ void NumpyBooleanAssignForwardGPU(const nnvm::NodeAttrs& attrs,
     }
   }
 
-  if (inputs.size() == 3U) {
-    if (inputs[2].shape_.Size() == 1) {
+  // a scalar value, or a value broadcast along the masked axis, does not depend on the
+  // number of true elements of the mask, so it is assigned without counting them
+  bool to_scalar = inputs.size() == 2U || inputs[2].shape_.Size() == 1;
+  bool need_broadcast = true;
+  if (!to_scalar) {
+    const TShape& vshape = inputs[2].shape_;
+    CHECK(vshape.ndim() <= (dshape.ndim() - mshape.ndim() + 1));
+    need_broadcast = (vshape.ndim() == (dshape.ndim() - mshape.ndim() + 1)) ?
+                     (vshape[start_axis] == 1) :
+                     true;
+  }
+
+  if (to_scalar || need_broadcast) {
+    if (inputs.size() == 3U) {
       MSHADOW_TYPE_SWITCH_WITH_BOOL(data.type_flag_, DType, {
-        Kernel<BooleanAssignGPUKernel<true>, gpu>::Launch(
-          s, leading * valid_num * trailing, data.dptr<DType>(), prefix_sum, mask_size + 1,
-          leading, middle, valid_num, trailing, inputs[2].dptr<DType>());
+        MSHADOW_TYPE_SWITCH_WITH_BOOL(mask.type_flag_, MType, {
+          Kernel<BooleanAssignMaskedGPUKernel, gpu>::Launch(
+            s, leading * middle * trailing, data.dptr<DType>(), mask.dptr<MType>(),
+            middle, trailing, inputs[2].dptr<DType>(), to_scalar);
+        });
       });
     } else {
-      bool need_broadcast = (vshape.ndim() == (dshape.ndim() - mshape.ndim() + 1)) ?
-                            (vshape[start_axis] == 1) :
-                            true;
+      CHECK(attrs.dict.find("value") != attrs.dict.end()) << "value is not provided";
+      double value = std::stod(attrs.dict.at("value"));
       MSHADOW_TYPE_SWITCH_WITH_BOOL(data.type_flag_, DType, {
-        Kernel<BooleanAssignGPUKernel<false>, gpu>::Launch(
-          s, leading * valid_num * trailing, data.dptr<DType>(), prefix_sum, mask_size + 1,
-          leading, middle, valid_num, trailing, inputs[2].dptr<DType>(), need_broadcast);
+        MSHADOW_TYPE_SWITCH_WITH_BOOL(mask.type_flag_, MType, {
+          Kernel<BooleanAssignMaskedGPUKernel, gpu>::Launch(
+            s, leading * middle * trailing, data.dptr<DType>(), mask.dptr<MType>(),
+            middle, trailing, static_cast<DType>(value));
+        });
       });
     }
-  } else {
-    CHECK(attrs.dict.find("value") != attrs.dict.end()) << "value is not provided";
-    double value = std::stod(attrs.dict.at("value"));
-    MSHADOW_TYPE_SWITCH_WITH_BOOL(data.type_flag_, DType, {
-      Kernel<BooleanAssignGPUKernel<true>, gpu>::Launch(
-        s, leading * valid_num * trailing, data.dptr<DType>(), prefix_sum, mask_size + 1,
-        leading, middle, valid_num, trailing, static_cast<DType>(value));
-    });
+    return;
   }
+
+  // Get valid_num, the values of a tensor are checked against it
+  size_t valid_num = 0;
+  size_t* prefix_sum = nullptr;
+  MSHADOW_TYPE_SWITCH_WITH_BOOL(mask.type_flag_, MType, {
+    prefix_sum = GetValidNumGPU<MType>(ctx, mask.dptr<MType>(), mask_size);
+  });
+  cudaStream_t stream = mshadow::Stream<gpu>::GetStream(s);
+  CUDA_CALL(cudaMemcpyAsync(&valid_num, &prefix_sum[mask_size], sizeof(size_t),
+                            cudaMemcpyDeviceToHost, stream));
+  CUDA_CALL(cudaStreamSynchronize(stream));
+
+  // If there's no True in mask, return directly
+  if (valid_num == 0) return;
+
+  const TShape& vshape = inputs[2].shape_;
+  // tensor case, check tensor size equal to valid_num
+  CHECK_EQ(static_cast<size_t>(valid_num), vshape[start_axis])
+    << "boolean array indexing assignment cannot assign " << vshape
+    << " input values to the " << valid_num << " output values where the mask is true"
+    << std::endl;
+
+  MSHADOW_TYPE_SWITCH_WITH_BOOL(data.type_flag_, DType, {
+    Kernel<BooleanAssignGPUKernel<false>, gpu>::Launch(
+      s, leading * valid_num * trailing, data.dptr<DType>(), prefix_sum, mask_size + 1,
+      leading, middle, valid_num, trailing, inputs[2].dptr<DType>(), need_broadcast);
+  });
 }
 
 NNVM_REGISTER_OP(_npi_boolean_mask_assign_scalar)
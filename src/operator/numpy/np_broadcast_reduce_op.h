@@ -336,8 +336,13 @@ void NumpyReduceAxesCompute(const nnvm::NodeAttrs& attrs,
   }
   CHECK_NE(req[0], kWriteInplace) << "Reduce does not support write in-place";
 #if MXNET_USE_TVM_OP
-  // If boolean ndarray, use the kernel generated by TVM
-  if (inputs[0].type_flag_ == mshadow::kBool) {
+  // If boolean ndarray, or float ndarray summed in its type, use the kernel generated by TVM
+  const int itype = inputs[0].type_flag_;
+  const bool tvm_float_sum = std::is_same<reducer, mshadow_op::sum>::value &&
+                             std::is_same<OP, mshadow_op::identity>::value &&
+                             (itype == mshadow::kFloat32 || itype == mshadow::kFloat64) &&
+                             itype == outputs[0].type_flag_ && inputs[0].ndim() <= 5;
+  if (itype == mshadow::kBool || tvm_float_sum) {
     std::string reducer_name;
     if (std::is_same<reducer, mshadow_op::sum>::value) {
       reducer_name = "sum";
@@ -120,7 +120,9 @@ void TVMOpReduce(const OpContext& ctx,
             << (ctx.run_ctx.ctx.dev_type == mxnet::Context::DeviceType::kCPU ? "cpu" : "gpu")
             << "reduce1st_dim_" << reduce1st_dim
             << "req_" << (req == kWriteTo ? "kWriteTo" : "kAddTo");
-  tvm::runtime::TVMOpModule::Get()->Call(func_name.str(), ctx, {input_tvm, output_tvm, output_tvm});
+  const std::vector<TBlob> args{input_tvm, output_tvm, output_tvm};
+  func_name << tvm::runtime::TunedSchedule(func_name.str(), args);
+  tvm::runtime::TVMOpModule::Get()->Call(func_name.str(), ctx, args);
 #else
   LOG(FATAL) << "Please add USE_TVM_OP=1 as a compile flag to enable TVM-generated kernels.";
 #endif  // MXNET_USE_TVM_OP
@@ -133,6 +135,7 @@ NNVM_REGISTER_OP(_npi_sum)
 .set_attr_parser(ParamParser<NumpyReduceAxesParam>)
 .set_attr<mxnet::FInferShape>("FInferShape", NumpyReduceAxesShape)
 .set_attr<nnvm::FInferType>("FInferType", NumpySumType)
+.set_attr<FComputeCost>("FComputeCost", ReduceCost)
 .set_attr<nnvm::FListInputNames>("FListInputNames",
   [](const NodeAttrs& attrs) {
     return std::vector<std::string>{"a"};
@@ -120,6 +120,12 @@ void CumsumForwardImpl(const OpContext& ctx,
   });
 }
 
+template<>
+void CumsumForwardImpl<cpu>(const OpContext& ctx,
+                            const TBlob& in,
+                            const TBlob& out,
+                            const dmlc::optional<int>& axis);
+
 template<typename xpu>
 void CumsumForward(const nnvm::NodeAttrs& attrs,
                    const OpContext& ctx,
@@ -179,6 +185,12 @@ void CumsumBackwardImpl(const OpContext& ctx,
   });
 }
 
+template<>
+void CumsumBackwardImpl<cpu>(const OpContext& ctx,
+                             const TBlob& ograd,
+                             const TBlob& igrad,
+                             const dmlc::optional<int>& axis);
+
 template<typename xpu>
 void CumsumBackward(const nnvm::NodeAttrs& attrs,
                     const OpContext& ctx,
@@ -22,11 +22,166 @@
  * \brief CPU implementation of numpy-compatible cumsum operator
  */
 
+#include <algorithm>
+#include <memory>
 #include "./np_cumsum-inl.h"
+#include "../../engine/openmp.h"
 
 namespace mxnet {
 namespace op {
 
+/*! \brief minimum number of rows of a block of the parallel scan */
+constexpr index_t kCumsumMinBlockRows = 4096;
+
+/*!
+ * \brief Blocked two-pass scan of a (middle, trailing) slab along its middle axis.
+ *  Each of the num_blocks threads scans a block of rows, the totals of the blocks are
+ *  scanned, and each thread then adds the total of the preceding blocks to its block.
+ *  The inner loops run over the contiguous trailing axis. The reverse scan starts from
+ *  the last row, for the backward of cumsum. carry holds num_blocks * trailing elements.
+ */
+template<bool reverse, typename IType, typename OType>
+void CumsumSlabCPU(OType* out, const IType* in, const index_t middle,
+                   const index_t trailing, const int num_blocks, OType* carry) {
+  const index_t block = (middle + num_blocks - 1) / num_blocks;
+  // offset of the r-th row in the order of the scan
+  auto row = [=](index_t r) { return (reverse ? middle - 1 - r : r) * trailing; };
+  #pragma omp parallel for num_threads(num_blocks)
+  for (int b = 0; b < num_blocks; ++b) {
+    const index_t begin = b * block, end = std::min(middle, begin + block);
+    if (begin >= end) continue;
+    const OType* prev = out + row(begin);
+    OType* dst = out + row(begin);
+    const IType* src = in + row(begin);
+    for (index_t t = 0; t < trailing; ++t) {
+      dst[t] = OType(src[t]);
+    }
+    for (index_t r = begin + 1; r < end; ++r) {
+      dst = out + row(r);
+      src = in + row(r);
+      #pragma omp simd
+      for (index_t t = 0; t < trailing; ++t) {
+        dst[t] = prev[t] + OType(src[t]);
+      }
+      prev = dst;
+    }
+  }
+  // carry of block b is the sum of the blocks before it
+  for (index_t t = 0; t < trailing; ++t) {
+    carry[t] = OType(0);
+  }
+  for (int b = 1; b < num_blocks; ++b) {
+    const OType* total = out + row(std::min(middle, b * block) - 1);
+    OType* c = carry + b * trailing;
+    const OType* pc = c - trailing;
+    for (index_t t = 0; t < trailing; ++t) {
+      c[t] = pc[t] + total[t];
+    }
+  }
+  #pragma omp parallel for num_threads(num_blocks)
+  for (int b = 1; b < num_blocks; ++b) {
+    const index_t begin = b * block, end = std::min(middle, begin + block);
+    const OType* c = carry + b * trailing;
+    for (index_t r = begin; r < end; ++r) {
+      OType* dst = out + row(r);
+      #pragma omp simd
+      for (index_t t = 0; t < trailing; ++t) {
+        dst[t] += c[t];
+      }
+    }
+  }
+}
+
+/*!
+ * \brief Number of blocks of the parallel scan of each slab, or 0 when there are
+ *  enough slabs for the threads or the axis is too short, and the kernel of cumsum
+ *  scans each lane in a thread instead.
+ */
+inline int CumsumNumBlocks(const index_t outer, const index_t middle) {
+  const int num_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  const index_t num_blocks = std::min<index_t>(num_threads, middle / kCumsumMinBlockRows);
+  return (outer >= num_threads || num_blocks < 2) ? 0 : static_cast<int>(num_blocks);
+}
+
+template<>
+void CumsumForwardImpl<cpu>(const OpContext& ctx,
+                            const TBlob& in,
+                            const TBlob& out,
+                            const dmlc::optional<int>& axis) {
+  using namespace mshadow;
+  using namespace mxnet_op;
+
+  CHECK(!axis.has_value() ||
+        ((axis.value() >= -out.shape_.ndim()) && axis.value() < out.shape_.ndim()))
+    << "axis value " << axis.value() << " out of range";
+
+  const index_t middle = axis.has_value() ? out.shape_[axis.value()] : out.Size();
+  if (middle == 0 || out.Size() == 0) return;
+  index_t trailing = 1;
+  if (axis.has_value()) {
+    for (int i = axis.value() + 1; i < out.shape_.ndim(); ++i) {
+      trailing *= out.shape_[i];
+    }
+  }
+  const index_t outer = out.Size() / middle / trailing;
+  const int num_blocks = CumsumNumBlocks(outer, middle);
+
+  Stream<cpu> *s = ctx.get_stream<cpu>();
+  MSHADOW_TYPE_SWITCH_WITH_BOOL(in.type_flag_, IType, {
+    MSHADOW_TYPE_SWITCH(out.type_flag_, OType, {
+      if (num_blocks == 0) {
+        Kernel<cumsum_forward, cpu>::Launch(
+          s, out.Size() / middle, out.dptr<OType>(),
+          in.dptr<IType>(), middle, trailing);
+      } else {
+        std::unique_ptr<OType[]> carry(new OType[num_blocks * trailing]);
+        for (index_t i = 0; i < outer; ++i) {
+          CumsumSlabCPU<false>(out.dptr<OType>() + i * middle * trailing,
+                               in.dptr<IType>() + i * middle * trailing,
+                               middle, trailing, num_blocks, carry.get());
+        }
+      }
+    });
+  });
+}
+
+template<>
+void CumsumBackwardImpl<cpu>(const OpContext& ctx,
+                             const TBlob& ograd,
+                             const TBlob& igrad,
+                             const dmlc::optional<int>& axis) {
+  using namespace mshadow;
+  using namespace mxnet_op;
+  const index_t middle = axis.has_value() ? igrad.shape_[axis.value()] : igrad.Size();
+  if (middle == 0 || igrad.Size() == 0) return;
+  index_t trailing = 1;
+  if (axis.has_value()) {
+    for (int i = axis.value() + 1; i < igrad.shape_.ndim(); ++i) {
+      trailing *= igrad.shape_[i];
+    }
+  }
+  const index_t outer = igrad.Size() / middle / trailing;
+  const int num_blocks = CumsumNumBlocks(outer, middle);
+
+  Stream<cpu> *s = ctx.get_stream<cpu>();
+  MSHADOW_TYPE_SWITCH_WITH_BOOL(igrad.type_flag_, IType, {
+    MSHADOW_TYPE_SWITCH(ograd.type_flag_, OType, {
+      if (num_blocks == 0) {
+        Kernel<cumsum_backward, cpu>::Launch(
+          s, igrad.Size() / middle, igrad.dptr<IType>(),
+          ograd.dptr<OType>(), middle, trailing);
+      } else {
+        std::unique_ptr<IType[]> carry(new IType[num_blocks * trailing]);
+        for (index_t i = 0; i < outer; ++i) {
+          CumsumSlabCPU<true>(igrad.dptr<IType>() + i * middle * trailing,
+                              ograd.dptr<OType>() + i * middle * trailing,
+                              middle, trailing, num_blocks, carry.get());
+        }
+      }
+    });
+  });
+}
+
 inline bool CumsumShape(const nnvm::NodeAttrs& attrs,
                         mxnet::ShapeVector *in_attrs,
                         mxnet::ShapeVector *out_attrs) {
@@ -64,6 +64,7 @@
 
 #include <mxnet/operator_util.h>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <algorithm>
 #include "./np_tensordot_op-inl.h"
@@ -73,6 +74,7 @@
 #include "../operator_common.h"
 #include "../mshadow_op.h"
 #include "../elemwise_op_common.h"
+#include "../linalg.h"
 
 namespace mxnet {
 namespace op {
@@ -421,13 +423,22 @@ class EinsumOp {
   std::string subscripts;
   std::shared_ptr<NDArray> tempspace;
   std::vector<Step> paths;
+  // contraction paths by the shapes and the type of the operands
+  std::unordered_map<std::string, std::vector<Step> > path_cache;
   explicit EinsumOp(int num_args, int optimize, std::string subscripts) {
     this->num_args = num_args;
     this->optimize = optimize;
     this->subscripts = subscripts;
   }
+  /*! \brief whether the operands are contracted pairwise along a path */
+  bool use_path() const {
+    return optimize != 0 || num_args > 1;
+  }
 };  // class EinsumOp
 
+/*! \brief maximum number of contraction paths cached by an einsum operator */
+constexpr size_t kEinsumPathCacheSize = 64;
+
 template<int dimension, int req, bool back, typename AType>
 struct numpy_einsum{
   template<typename DType>
@@ -784,6 +795,198 @@ inline void NumpyEinsumProcess(const std::vector<TBlob>& inputs,
   }
 }
 
+/*! \brief shape of tensor transposed by axes */
+inline TShape EinsumTransposedShape(const TShape& shape, const TShape& axes) {
+  TShape ret(axes.ndim(), -1);
+  for (int i = 0; i < axes.ndim(); ++i) {
+    ret[i] = shape[axes[i]];
+  }
+  return ret;
+}
+
+/*! \brief the axes undoing the transpose by axes */
+inline TShape EinsumInverseAxes(const TShape& axes) {
+  TShape ret(axes.ndim(), -1);
+  for (int i = 0; i < axes.ndim(); ++i) {
+    ret[axes[i]] = i;
+  }
+  return ret;
+}
+
+/*!
+ * \brief C = X * Y on batches of matrices, any of them may be stored transposed
+ * \param beta the scale of C before adding the product
+ */
+template<typename xpu, typename DType>
+inline void EinsumBatchGemm(const mshadow::Tensor<xpu, 3, DType>& x, bool x_trans,
+                            const mshadow::Tensor<xpu, 3, DType>& y, bool y_trans,
+                            const mshadow::Tensor<xpu, 3, DType>& c, bool c_trans,
+                            DType beta, mshadow::Stream<xpu>* s) {
+  if (c_trans) {
+    // C^T = Y^T * X^T
+    linalg_batch_gemm(y, x, c, DType(1), beta, !y_trans, !x_trans, s);
+  } else {
+    linalg_batch_gemm(x, y, c, DType(1), beta, x_trans, y_trans, s);
+  }
+}
+
+/*! \brief a batch of rows x cols matrices, stored transposed if trans */
+template<typename xpu, typename DType>
+inline mshadow::Tensor<xpu, 3, DType> EinsumMatrices(DType* dptr, dim_t batch, dim_t rows,
+                                                     dim_t cols, bool trans,
+                                                     mshadow::Stream<xpu>* s) {
+  return mshadow::Tensor<xpu, 3, DType>(dptr, trans ? mshadow::Shape3(batch, cols, rows) :
+                                                      mshadow::Shape3(batch, rows, cols), s);
+}
+
+/*! \brief copy src transposed by axes to dptr, laid out for the gemm */
+template<typename xpu>
+inline TBlob EinsumTransposeTo(const OpContext& ctx, const TBlob& src, const TShape& axes,
+                               void* dptr) {
+  TBlob ret(dptr, EinsumTransposedShape(src.shape_, axes), xpu::kDevMask, src.type_flag_);
+  TransposeImpl<xpu>(ctx.run_ctx, src, ret, axes);
+  return ret;
+}
+
+/*! \brief transpose src, laid out for the gemm, by axes into dst according to req */
+template<typename xpu>
+inline void EinsumTransposeFrom(const OpContext& ctx, const TBlob& src, const TBlob& dst,
+                                const TShape& axes, OpReqType req) {
+  if (req == kAddTo) {
+    TransposeImpl<xpu, true>(ctx.run_ctx, src, dst, axes);
+  } else {
+    TransposeImpl<xpu>(ctx.run_ctx, src, dst, axes);
+  }
+}
+
+/*! \brief workspace in elements of the batched gemm contraction step */
+inline size_t EinsumBatchGemmWorkspaceSize(const Step& step, const TBlob& left,
+                                           const TBlob& right, const TBlob& out) {
+  return (step.left_axes.ndim() > 0 ? left.Size() : 0) +
+         (step.right_axes.ndim() > 0 ? right.Size() : 0) +
+         (step.out_axes.ndim() > 0 ? out.Size() : 0);
+}
+
+/*! \brief workspace in bytes of the backward of the batched gemm contraction step */
+inline size_t EinsumBatchGemmBackwardWorkspaceSize(const Step& step, const TBlob& out_grad,
+                                                   const TBlob& left, const TBlob& right) {
+  const size_t left_size = step.left_axes.ndim() > 0 ? left.Size() : 0;
+  const size_t right_size = step.right_axes.ndim() > 0 ? right.Size() : 0;
+  const size_t grad_size = step.out_axes.ndim() > 0 ? out_grad.Size() : 0;
+  return (grad_size + left_size + right_size + std::max(left_size, right_size)) *
+         mshadow::mshadow_sizeof(out_grad.type_flag_);
+}
+
+/*!
+ * \brief contract left and right into out by a batched gemm, transposing from and to
+ *  the gemm layouts in the workspace if needed
+ */
+template<typename xpu>
+inline void EinsumBatchGemmForward(const Step& step, const OpContext& ctx,
+                                   const TBlob& left, const TBlob& right,
+                                   const TBlob& out, OpReqType req) {
+  using namespace mshadow;
+  if (req == kNullOp) return;
+  Stream<xpu> *s = ctx.get_stream<xpu>();
+  const dim_t batch = step.bgemm_shape[0], m = step.bgemm_shape[1];
+  const dim_t k = step.bgemm_shape[2], n = step.bgemm_shape[3];
+  MSHADOW_SGL_DBL_TYPE_SWITCH(out.type_flag_, DType, {
+    const size_t workspace_size = EinsumBatchGemmWorkspaceSize(step, left, right, out);
+    Tensor<xpu, 1, DType> workspace = ctx.requested[0].get_space_typed<xpu, 1, DType>(
+      Shape1(std::max<size_t>(workspace_size, 1)), s);
+    DType* dptr = workspace.dptr_;
+    DType* a = left.dptr<DType>();
+    DType* b = right.dptr<DType>();
+    DType* c = out.dptr<DType>();
+    if (step.left_axes.ndim() > 0) {
+      a = EinsumTransposeTo<xpu>(ctx, left, step.left_axes, dptr).dptr<DType>();
+      dptr += left.Size();
+    }
+    if (step.right_axes.ndim() > 0) {
+      b = EinsumTransposeTo<xpu>(ctx, right, step.right_axes, dptr).dptr<DType>();
+      dptr += right.Size();
+    }
+    if (step.out_axes.ndim() > 0) {
+      c = dptr;
+    }
+    EinsumBatchGemm(EinsumMatrices(a, batch, m, k, step.left_trans, s), step.left_trans,
+                    EinsumMatrices(b, batch, k, n, step.right_trans, s), step.right_trans,
+                    EinsumMatrices(c, batch, m, n, step.out_trans, s), step.out_trans,
+                    DType(step.out_axes.ndim() == 0 && req == kAddTo ? 1 : 0), s);
+    if (step.out_axes.ndim() > 0) {
+      const TShape gemm_shape = EinsumTransposedShape(out.shape_,
+                                                      EinsumInverseAxes(step.out_axes));
+      EinsumTransposeFrom<xpu>(ctx, TBlob(c, gemm_shape, xpu::kDevMask), out,
+                               step.out_axes, req);
+    }
+  });
+}
+
+/*!
+ * \brief gradients of the batched gemm contraction step, dA = G * B^T and dB = A^T * G
+ *  in the gemm layouts
+ */
+template<typename xpu>
+inline void EinsumBatchGemmBackward(const Step& step, const OpContext& ctx,
+                                    const TBlob& out_grad, const TBlob& left,
+                                    const TBlob& right, const TBlob& left_grad,
+                                    const TBlob& right_grad,
+                                    const std::vector<OpReqType>& req,
+                                    const mshadow::Tensor<xpu, 1, char>& workspace) {
+  using namespace mshadow;
+  Stream<xpu> *s = ctx.get_stream<xpu>();
+  const dim_t batch = step.bgemm_shape[0], m = step.bgemm_shape[1];
+  const dim_t k = step.bgemm_shape[2], n = step.bgemm_shape[3];
+  MSHADOW_SGL_DBL_TYPE_SWITCH(out_grad.type_flag_, DType, {
+    DType* dptr = reinterpret_cast<DType*>(workspace.dptr_);
+    DType* g = out_grad.dptr<DType>();
+    DType* a = left.dptr<DType>();
+    DType* b = right.dptr<DType>();
+    if (step.out_axes.ndim() > 0) {
+      g = EinsumTransposeTo<xpu>(ctx, out_grad, EinsumInverseAxes(step.out_axes),
+                                 dptr).dptr<DType>();
+      dptr += out_grad.Size();
+    }
+    if (step.left_axes.ndim() > 0) {
+      a = EinsumTransposeTo<xpu>(ctx, left, step.left_axes, dptr).dptr<DType>();
+      dptr += left.Size();
+    }
+    if (step.right_axes.ndim() > 0) {
+      b = EinsumTransposeTo<xpu>(ctx, right, step.right_axes, dptr).dptr<DType>();
+      dptr += right.Size();
+    }
+    const Tensor<xpu, 3, DType> g_mat = EinsumMatrices(g, batch, m, n, step.out_trans, s);
+    if (req[0] != kNullOp) {
+      const bool copy = step.left_axes.ndim() > 0;
+      DType* da = copy ? dptr : left_grad.dptr<DType>();
+      EinsumBatchGemm(g_mat, step.out_trans,
+                      EinsumMatrices(b, batch, n, k, !step.right_trans, s), !step.right_trans,
+                      EinsumMatrices(da, batch, m, k, step.left_trans, s), step.left_trans,
+                      DType(!copy && req[0] == kAddTo ? 1 : 0), s);
+      if (copy) {
+        EinsumTransposeFrom<xpu>(ctx,
+                                 TBlob(da, EinsumTransposedShape(left.shape_, step.left_axes),
+                                       xpu::kDevMask),
+                                 left_grad, EinsumInverseAxes(step.left_axes), req[0]);
+      }
+    }
+    if (req[1] != kNullOp) {
+      const bool copy = step.right_axes.ndim() > 0;
+      DType* db = copy ? dptr : right_grad.dptr<DType>();
+      EinsumBatchGemm(EinsumMatrices(a, batch, k, m, !step.left_trans, s), !step.left_trans,
+                      g_mat, step.out_trans,
+                      EinsumMatrices(db, batch, k, n, step.right_trans, s), step.right_trans,
+                      DType(!copy && req[1] == kAddTo ? 1 : 0), s);
+      if (copy) {
+        EinsumTransposeFrom<xpu>(ctx,
+                                 TBlob(db, EinsumTransposedShape(right.shape_, step.right_axes),
+                                       xpu::kDevMask),
+                                 right_grad, EinsumInverseAxes(step.right_axes), req[1]);
+      }
+    }
+  });
+}
+
 template<typename xpu>
 inline void NumpyEinsumForward(const OpStatePtr& state_ptr,
                                const OpContext& ctx,
@@ -794,19 +997,30 @@ inline void NumpyEinsumForward(const OpStatePtr& state_ptr,
   using namespace mxnet_op;
   EinsumOp& state = state_ptr.get_state<EinsumOp>();
   int num_args = state.num_args;
-  int optimize = state.optimize;
   const char* subscripts = state.subscripts.c_str();
   Stream<xpu> *s = ctx.get_stream<xpu>();
   CHECK_EQ(inputs.size(), num_args);
   CHECK_EQ(outputs.size(), 1U);
-  if (optimize == 0) {
+  if (!state.use_path()) {
     NumpyEinsumProcess<xpu, 0>(inputs, req, outputs, subscripts, num_args, ctx);
     return;
   }
+  // the path depends on the shapes and the type of the operands only
+  std::ostringstream key;
+  key << outputs[0].type_flag_;
+  for (const TBlob& input : inputs) {
+    key << input.shape_;
+  }
+  auto it = state.path_cache.find(key.str());
+  if (it == state.path_cache.end()) {
+    if (state.path_cache.size() >= kEinsumPathCacheSize) {
+      state.path_cache.clear();
+    }
+    it = state.path_cache.emplace(key.str(), einsum_path(state.subscripts, inputs, true,
+                                                         ctx.run_ctx, nullptr, nullptr)).first;
+  }
   std::vector<Step>& paths = state.paths;
-  std::vector<std::vector<int> > pos;
-  std::string string_repr;
-  paths = einsum_path(state.subscripts, inputs, true, ctx.run_ctx, &pos, &string_repr);
+  paths = it->second;
   int paths_len = paths.size();
   size_t temp_space_size = 0, max_temp_space_size = 0;
   std::vector<TBlob> operands(inputs), tmp_operands, temp_space_vec(paths_len - 1);
@@ -818,10 +1032,13 @@ inline void NumpyEinsumForward(const OpStatePtr& state_ptr,
   }
   temp_space_size += max_temp_space_size;
   MSHADOW_TYPE_SWITCH(outputs[0].type_flag_, DType, {
-    state.tempspace.reset<NDArray>(new NDArray(TShape(Shape1(temp_space_size)),
-                                               ctx.run_ctx.ctx,
-                                               false,
-                                               outputs[0].type_flag_));
+    if (!state.tempspace || state.tempspace->shape()[0] != static_cast<dim_t>(temp_space_size) ||
+        state.tempspace->dtype() != outputs[0].type_flag_) {
+      state.tempspace.reset<NDArray>(new NDArray(TShape(Shape1(temp_space_size)),
+                                                 ctx.run_ctx.ctx,
+                                                 false,
+                                                 outputs[0].type_flag_));
+    }
     Tensor<xpu, 1, DType> temp_space = state.tempspace->data().FlatTo1D<xpu, DType>();
     size_t begin = max_temp_space_size;
     for (int i = 0; i < paths_len - 1; ++i) {
@@ -838,8 +1055,12 @@ inline void NumpyEinsumForward(const OpStatePtr& state_ptr,
         operands.erase(operands.begin() + p);
       }
       bool handle_out = (i == paths_len - 1);
-      // Call tensordot if still possible
-      if (paths[i].do_blas) {
+      if (paths[i].do_bgemm) {
+        EinsumBatchGemmForward<xpu>(paths[i], ctx, tmp_operands[0], tmp_operands[1],
+                                    handle_out ? outputs[0] : temp_space_vec[i],
+                                    handle_out ? req[0] : OpReqType::kWriteTo);
+      } else if (paths[i].do_blas) {
+        // Call tensordot if still possible
         // Contract!
         if (paths[i].do_einsum || handle_out) {
           TBlob max_temp_space = TBlob(temp_space.Slice(0, paths[i].tshape.Size()));
@@ -909,12 +1130,11 @@ inline void NumpyEinsumBackward(const OpStatePtr& state_ptr,
   using namespace mshadow_op;
   const EinsumOp& state = state_ptr.get_state<EinsumOp>();
   int num_args = state.num_args;
-  int optimize = state.optimize;
   const char* subscripts = state.subscripts.c_str();
   Stream<xpu> *s = ctx.get_stream<xpu>();
   CHECK_EQ(inputs.size(), 1 + num_args);
   CHECK_EQ(outputs.size(), num_args);
-  if (optimize == 0) {
+  if (!state.use_path()) {
     NumpyEinsumProcess<xpu, 1>(inputs, req, outputs, subscripts, num_args, ctx);
     return;
   }
@@ -983,7 +1203,11 @@ inline void NumpyEinsumBackward(const OpStatePtr& state_ptr,
         }
       }
       size_t cur_tensordot_tempspace_size = 0;
-      if (paths[i].do_blas) {
+      if (paths[i].do_bgemm) {
+        cur_tensordot_tempspace_size =
+          EinsumBatchGemmBackwardWorkspaceSize(paths[i], temp_inputs[0], temp_inputs[1],
+                                               temp_inputs[2]);
+      } else if (paths[i].do_blas) {
         if (paths[i].do_einsum) {
           cur_tensordot_tempspace_size =
             TensordotBackwardWorkspaceSize<xpu>(paths[i].left_pos,
@@ -1061,7 +1285,18 @@ inline void NumpyEinsumBackward(const OpStatePtr& state_ptr,
           temp_req.push_back(OpReqType::kWriteTo);
         }
       }
-      if (paths[i].do_blas) {
+      if (paths[i].do_bgemm) {
+        CHECK_EQ(temp_inputs.size(), 3U);
+        CHECK_EQ(temp_outputs.size(), 2U);
+        Tensor<xpu, 1, DType> bgemm_tempspace = temp_space.Slice(begin_tensordot_tempspace,
+                                                                 temp_space_size);
+        EinsumBatchGemmBackward<xpu>(paths[i], ctx, temp_inputs[0], temp_inputs[1],
+                                     temp_inputs[2], temp_outputs[0], temp_outputs[1], temp_req,
+                                     Tensor<xpu, 1, char>(
+                                       reinterpret_cast<char*>(bgemm_tempspace.dptr_),
+                                       Shape1(tensordot_tempspace_size[i]),
+                                       bgemm_tempspace.stream_));
+      } else if (paths[i].do_blas) {
         CHECK_EQ(temp_inputs.size(), 3U);
         CHECK_EQ(temp_outputs.size(), 2U);
         CHECK_EQ(temp_req.size(), 2U);
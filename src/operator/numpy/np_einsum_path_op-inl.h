@@ -93,6 +93,14 @@ struct Step {
   bool do_blas, do_einsum;
   TShape oshape, tshape;
   Tuple<int> left_pos, right_pos;
+  // batched gemm (batch, M, K) x (batch, K, N) -> (batch, M, N) of a pairwise contraction
+  bool do_bgemm;
+  // the operands and the result are stored as their matrices transposed
+  bool left_trans, right_trans, out_trans;
+  // transposes of the operands to, and of the result from, the gemm layout, if needed
+  TShape left_axes, right_axes, out_axes;
+  // batch, M, K, N
+  TShape bgemm_shape;
 };
 
 inline size_t _compute_size_by_dict(const std::string& indices,
@@ -468,6 +476,102 @@ inline bool _can_dot(const std::vector<std::string>& inputs,
 }
 
 
+/*!
+ * \brief positions in str of the labels of target, the axes transposing str to target
+ */
+inline TShape _transpose_axes(const std::string& str, const std::string& target) {
+  TShape axes(target.length(), -1);
+  for (size_t i = 0; i < target.length(); ++i) {
+    axes[i] = static_cast<dim_t>(str.find(target[i]));
+  }
+  return axes;
+}
+
+/*!
+ * \brief plan the pairwise contraction of inputs into result as a batched gemm. The labels
+ *  of both inputs and the result are the batch, the other labels of both inputs are contracted,
+ *  the labels of one input only are the rows or the columns. Labels summed within one input,
+ *  repeated labels and broadcasting are left to einsum.
+ * \param result the labels of the result, empty if the layout of the result is free
+ * \return false if the contraction does not map onto batched gemm
+ */
+inline bool _plan_batch_dot(const std::vector<std::string>& inputs,
+                             const std::bitset<MAXAXIS>& result_set,
+                             const std::bitset<MAXAXIS>& bcast,
+                             const dim_t idx_dict[],
+                             std::string* result,
+                             Step* step) {
+  if (inputs.size() != 2) {
+    return false;
+  }
+  const std::string& left = inputs[0];
+  const std::string& right = inputs[1];
+  std::string batch, contract, lfree, rfree;
+  for (int i = 0; i < 2; ++i) {
+    const std::string& term = inputs[i];
+    const std::string& other = inputs[1 - i];
+    for (const char& c : term) {
+      if (std::count(term.begin(), term.end(), c) > 1) {
+        return false;
+      }
+      const bool in_other = other.find(c) != std::string::npos;
+      const bool in_result = result_set.test(static_cast<int>(c));
+      if (!in_other && !in_result) {
+        return false;
+      }
+      if (bcast.test(static_cast<int>(c)) && idx_dict[static_cast<int>(c)] != 1) {
+        return false;
+      }
+      if (idx_dict[static_cast<int>(c)] == 0) {
+        return false;
+      }
+      if (i == 0) {
+        if (!in_other) {
+          lfree += c;
+        } else if (in_result) {
+          batch += c;
+        } else {
+          contract += c;
+        }
+      } else if (!in_other) {
+        rfree += c;
+      }
+    }
+  }
+  // keep the operands and the result in place if their layouts are gemm ones
+  const std::string left_gemm = batch + lfree + contract;
+  const std::string right_gemm = batch + contract + rfree;
+  const std::string out_gemm = batch + lfree + rfree;
+  const std::string out = result->empty() ? out_gemm : *result;
+  step->left_trans = left != left_gemm && left == batch + contract + lfree;
+  step->right_trans = right != right_gemm && right == batch + rfree + contract;
+  step->out_trans = out != out_gemm && out == batch + rfree + lfree;
+  step->left_axes = TShape();
+  step->right_axes = TShape();
+  step->out_axes = TShape();
+  if (left != left_gemm && !step->left_trans) {
+    step->left_axes = _transpose_axes(left, left_gemm);
+  }
+  if (right != right_gemm && !step->right_trans) {
+    step->right_axes = _transpose_axes(right, right_gemm);
+  }
+  if (out != out_gemm && !step->out_trans) {
+    step->out_axes = _transpose_axes(out_gemm, out);
+  }
+  // the transposes support up to 6 dimensions
+  if (step->left_axes.ndim() > 6 || step->right_axes.ndim() > 6 ||
+      step->out_axes.ndim() > 6) {
+    return false;
+  }
+  step->bgemm_shape = TShape(4, -1);
+  step->bgemm_shape[0] = _compute_size_by_dict(batch, idx_dict);
+  step->bgemm_shape[1] = _compute_size_by_dict(lfree, idx_dict);
+  step->bgemm_shape[2] = _compute_size_by_dict(contract, idx_dict);
+  step->bgemm_shape[3] = _compute_size_by_dict(rfree, idx_dict);
+  *result = out;
+  return true;
+}
+
 inline int _count_substring(const std::string& str,
                             const std::string& sub) {
   int count = 0;
@@ -823,20 +927,29 @@ inline std::vector<Step> einsum_path(const std::string& subscripts,
 
     std::bitset<MAXAXIS> new_bcast_inds = bcast & ~contract.idx_removed;
 
+    // Last contraction
+    std::string idx_result;
+    if (i + 1 == size_path) {
+      idx_result = parsed_subscripts[1];
+    }
+
+    // Pairwise contractions are batched gemms if possible, intermediate results are then
+    // laid out for the gemm
+    const int type_flag = operands[0].type_flag_;
+    ret[i].do_bgemm = (type_flag == kFloat32 || type_flag == kFloat64) &&
+                      _plan_batch_dot(tmp_inputs, contract.new_result, bcast, dimension_dict,
+                                      &idx_result, &ret[i]);
+
     // If we're broadcasting, nix blas
     bool do_blas;
-    if ((contract.idx_removed & bcast).any() ||
+    if (ret[i].do_bgemm || (contract.idx_removed & bcast).any() ||
         !_tensordot_type_check(operands[0].type_flag_, run_ctx)) {
       do_blas = false;
     } else {
       do_blas = _can_dot(tmp_inputs, contract.new_result, contract.idx_removed);
     }
 
-    // Last contraction
-    std::string idx_result;
-    if (i + 1 == size_path) {
-      idx_result = parsed_subscripts[1];
-    } else {
+    if (idx_result.empty() && i + 1 < size_path) {
       idx_result = set2str(contract.new_result);
       std::sort(idx_result.begin(), idx_result.end(),
                 [&dimension_dict](const char& a, const char& b) -> bool {
@@ -37,6 +37,7 @@ DMLC_REGISTER_PARAMETER(NumpyBinaryScalarParam);
   .set_attr_parser(ParamParser<NumpyBinaryScalarParam>)                   \
   .set_attr<mxnet::FInferShape>("FInferShape", ElemwiseShape<1, 1>)       \
   .set_attr<nnvm::FInferType>("FInferType", NumpyBinaryScalarType)        \
+  .set_attr<FComputeCost>("FComputeCost", ElemwiseCost)                   \
   .set_attr<FResourceRequest>("FResourceRequest",                         \
     [](const NodeAttrs& attrs) {                                          \
       return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};   \
@@ -70,6 +71,7 @@ bool NumpyBinaryMixedPrecisionType(const nnvm::NodeAttrs& attrs,
     })                                                                         \
   .set_attr<mxnet::FInferShape>("FInferShape", BinaryBroadcastShape)           \
   .set_attr<nnvm::FInferType>("FInferType", NumpyBinaryMixedPrecisionType)     \
+  .set_attr<FComputeCost>("FComputeCost", ElemwiseCost)                        \
   .set_attr<nnvm::FInplaceOption>("FInplaceOption",                            \
     [](const NodeAttrs& attrs){                                                \
       return std::vector<std::pair<int, int> >{{0, 0}, {1, 0}};                \
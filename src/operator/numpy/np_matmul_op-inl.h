@@ -75,159 +75,150 @@ mshadow::Shape<ndim> GetKernelShape(const mxnet::TShape& shape, size_t N) {
   return k_shape;
 }
 
-/*!
- * \brief Broadcast in_shape to broadcast_shape in [dimstart, dimend].
-          Make sure that before use this function:
-          If in_shape[i] != broadcast_shape[i], in_shape[i] == 1.
- * \param N - ndim of both in_shape and broadcast_shape.
- * \param dimstart start dimension
- * \param dimend end dimension
- */
-template<int ndim>
-mshadow::Shape<ndim> GetBroadcastKernelShape(mshadow::Shape<ndim> in_shape,
-                                             mshadow::Shape<ndim> broadcast_shape,
-                                             int dimstart, int dimend) {
-  CHECK_GE(dimstart, 0) << "dimstart must be >= 0, while received " << dimstart;
-  CHECK_LT(dimend, ndim) << "dimend must be < " << ndim
-                         << ", while received " << dimend;
-  mshadow::Shape<ndim>out_shape(in_shape);
-  for (int i = dimstart; i < dimend; ++i) {
-    out_shape[i] = std::max(in_shape[i], broadcast_shape[i]);
-  }
-  return out_shape;
-}
-
-struct SumByShape {
+struct MatmulGradSum {
   /*!
-   * \brief squash input into output by addition
-   * \example input.flatten.shape = (10, ),
-              output.flatten.shape = (2, ),
-              in_size = 10, out_size = 2, then,
-              output[0] = sum(input[0, 2, 4, 6, 8])
-              output[1] = sum(input[1, 3, 5, 7, 9])
-   * \note in_size >= out_size
+   * \brief sum the gradient of the broadcast operand of shape grad_shape over the
+   *        dimensions it was broadcast along, from the batch of gradients of shape out_shape
+   * \example grad_shape = (2, 1, 3, 4), out_shape = (2, 5, 3, 4), then
+              grad[i0, 0] = sum(input[i0, 0:5])
+   * \note both shapes have ndim dimensions, the matrices of size matrix_size are not reduced
    */
   template<typename DType>
-  MSHADOW_XINLINE static void Map(int i, DType* output, DType* input,
-                                  size_t in_size, size_t out_size,
-                                  const int req){
-    // i is the global position in flattened output
-    size_t pos = static_cast<size_t>(i);
+  MSHADOW_XINLINE static void Map(index_t i, DType* grad, const DType* input,
+                                  const mshadow::Shape<MXNET_SPECIAL_MAX_NDIM> grad_shape,
+                                  const mshadow::Shape<MXNET_SPECIAL_MAX_NDIM> out_shape,
+                                  const int ndim, const index_t matrix_size,
+                                  const index_t replicas, const int req) {
+    const index_t pos = i % matrix_size;
     DType temp = 0;
-    while (pos < in_size) {
-      temp += input[pos];
-      pos += out_size;
+    for (index_t r = 0; r < replicas; ++r) {
+      // r enumerates the broadcast coordinates, the others are the ones of the grad batch
+      index_t grad_idx = i / matrix_size, rep_idx = r, in_batch = 0, in_stride = 1;
+      for (int d = ndim - 3; d >= 0; --d) {
+        index_t coord;
+        if (grad_shape[d] == out_shape[d]) {
+          coord = grad_idx % grad_shape[d];
+          grad_idx /= grad_shape[d];
+        } else {
+          coord = rep_idx % out_shape[d];
+          rep_idx /= out_shape[d];
+        }
+        in_batch += coord * in_stride;
+        in_stride *= out_shape[d];
+      }
+      temp += input[in_batch * matrix_size + pos];
+    }
+    KERNEL_ASSIGN(grad[i], req, temp);
+  }
+};
+
+/*!
+ * \brief the pointers to the i-th matrices of a, b and out of a broadcast batch, at
+ *        ptrs[i], ptrs[batch_size + i] and ptrs[2 * batch_size + i]. A dimension of size 1
+ *        of an operand has stride 0, so its matrix is repeated instead of copied.
+ */
+struct matmul_batch_ptrs {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(index_t i, DType** ptrs, DType* a, DType* b, DType* out,
+                                  const mshadow::Shape<MXNET_SPECIAL_MAX_NDIM> a_shape,
+                                  const mshadow::Shape<MXNET_SPECIAL_MAX_NDIM> b_shape,
+                                  const mshadow::Shape<MXNET_SPECIAL_MAX_NDIM> out_shape,
+                                  const int ndim, const index_t batch_size) {
+    index_t a_stride = a_shape[ndim - 2] * a_shape[ndim - 1];
+    index_t b_stride = b_shape[ndim - 2] * b_shape[ndim - 1];
+    index_t a_offset = 0, b_offset = 0, idx = i;
+    for (int d = ndim - 3; d >= 0; --d) {
+      const index_t coord = idx % out_shape[d];
+      idx /= out_shape[d];
+      if (a_shape[d] != 1) a_offset += coord * a_stride;
+      if (b_shape[d] != 1) b_offset += coord * b_stride;
+      a_stride *= a_shape[d];
+      b_stride *= b_shape[d];
     }
-    KERNEL_ASSIGN(output[i], req, temp);
+    ptrs[i] = a + a_offset;
+    ptrs[batch_size + i] = b + b_offset;
+    ptrs[2 * batch_size + i] = out + i * out_shape[ndim - 2] * out_shape[ndim - 1];
   }
 };
 
+/*!
+ * \brief out[i] = op(a[i]) . op(b[i]) + beta * out[i] for the row major matrices of the
+ *        pointer arrays built by matmul_batch_ptrs, op(a[i]) being (m, k)
+ */
+template<typename DType>
+inline void MatmulBatchedGemm(mshadow::Stream<cpu> *s, bool TA, bool TB,
+                              int m, int n, int k, DType** ptrs, int batch_size, DType beta) {
+  // the column major out^T = op(b)^T . op(a)^T
+  for (int i = 0; i < batch_size; ++i) {
+    mshadow::BLASEngine<cpu, DType>::gemm(s, TB, TA, n, m, k, DType(1.0f),
+                                          ptrs[batch_size + i], TB ? k : n,
+                                          ptrs[i], TA ? m : k,
+                                          beta, ptrs[2 * batch_size + i], n);
+  }
+}
+
+#ifdef __CUDACC__
+/*! \brief the GPU version, one pointer array batched cuBLAS call. Defined in np_matmul_op.cu */
+template<typename DType>
+void MatmulBatchedGemm(mshadow::Stream<gpu> *s, bool TA, bool TB,
+                       int m, int n, int k, DType** ptrs, int batch_size, DType beta);
+#endif
+
 template<typename xpu, typename DType>
 inline void MatmulImpl(const OpContext& ctx,
                        const TBlob& input_a, const TBlob& input_b,
                        const OpReqType& req, const TBlob& output,
                        Tensor<xpu, 1, char> temp_mem,
                        const size_t ndim, const size_t batch_size,
-                       const size_t bc_size_a, const size_t bc_size_b,
                        const mxnet::TShape& a_shape,
                        const mxnet::TShape& b_shape,
                        const mxnet::TShape& out_shape,
                        const bool TA, const bool TB) {
   using namespace mshadow;
   using namespace mxnet_op;
-  mshadow::Tensor<xpu, 1, DType*> workspace;
-  mshadow::Tensor<xpu, 3, DType> ans, mlhs, mrhs;
   mshadow::Stream<xpu> *s = ctx.get_stream<xpu>();
-  bool isCPU = std::is_same<xpu, cpu>::value;
+  mshadow::Tensor<xpu, 1, DType*> workspace(reinterpret_cast<DType**>(temp_mem.dptr_),
+                                            Shape1(3 * batch_size), s);
+  mshadow::Tensor<xpu, 3, DType> ans, mlhs, mrhs;
+  const DType beta = (kAddTo == req) ? (DType)1.0f : (DType)0.0f;
   // Is true if either a or b requires broadcast or not
   if (MatmulNeedBroadcast(a_shape, b_shape)) {
     // e.g. a.shape = (2, 3, 1, 4, 2)
     //      b.shape =       (5, 2, 4)
     //      c = matmul(a, b), need to broadcast a and b
     //      c.shape = (2, 3, 5, 4, 4)
+    // the operands are not broadcast in memory, the batched GEMM gets the pointers to
+    // their matrices with zero strides along the broadcast dimensions
     mshadow::Shape<MXNET_SPECIAL_MAX_NDIM> k_a_shape =
       GetKernelShape<MXNET_SPECIAL_MAX_NDIM>(a_shape, ndim);
     mshadow::Shape<MXNET_SPECIAL_MAX_NDIM> k_b_shape =
       GetKernelShape<MXNET_SPECIAL_MAX_NDIM>(b_shape, ndim);
     mshadow::Shape<MXNET_SPECIAL_MAX_NDIM> k_out_shape =
       GetKernelShape<MXNET_SPECIAL_MAX_NDIM>(out_shape, ndim);
-    const mshadow::Shape<MXNET_SPECIAL_MAX_NDIM> k_a_shape_bc =
-      GetBroadcastKernelShape<MXNET_SPECIAL_MAX_NDIM>(k_a_shape, k_out_shape, 0, ndim - 2);
-    const mshadow::Shape<MXNET_SPECIAL_MAX_NDIM> k_b_shape_bc =
-      GetBroadcastKernelShape<MXNET_SPECIAL_MAX_NDIM>(k_b_shape, k_out_shape, 0, ndim - 2);
-    DType* bc_a_ptr = reinterpret_cast<DType*>(temp_mem.dptr_);
-    DType* bc_b_ptr = bc_a_ptr + bc_size_a;
-    MSHADOW_TYPE_SWITCH_WITH_BOOL(input_a.type_flag_, IType, {
-      MSHADOW_TYPE_SWITCH_WITH_BOOL(input_b.type_flag_, OType, {
-        struct ShapeAndStride aux_data_a, aux_data_b;
-        PrepareAUXData(&aux_data_a, k_a_shape, k_a_shape_bc, ndim);
-        PrepareAUXData(&aux_data_b, k_b_shape, k_b_shape_bc, ndim);
-        if (isCPU) {
-          if (!aux_data_a.shape_changed) {
-            Kernel<direct_copy<mshadow_op::identity>, xpu>::Launch(
-              s, bc_size_a, input_a.dptr<IType>(), bc_a_ptr, OpReqType::kWriteTo);
-            Kernel<broadcast_kernel_cpu<mshadow_op::identity>, xpu>::Launch(
-              s, input_b.Size(), input_b.dptr<IType>(), bc_b_ptr,
-              aux_data_b, OpReqType::kWriteTo, ndim);
-          } else if (!aux_data_b.shape_changed) {
-            Kernel<direct_copy<mshadow_op::identity>, xpu>::Launch(
-              s, bc_size_b, input_b.dptr<IType>(), bc_b_ptr, OpReqType::kWriteTo);
-            Kernel<broadcast_kernel_cpu<mshadow_op::identity>, xpu>::Launch(
-              s, input_a.Size(), input_a.dptr<IType>(), bc_a_ptr,
-              aux_data_a, OpReqType::kWriteTo, ndim);
-          } else {
-            Kernel<broadcast_kernel_cpu<mshadow_op::identity>, xpu>::Launch(
-              s, input_a.Size(), input_a.dptr<IType>(), bc_a_ptr,
-              aux_data_a, OpReqType::kWriteTo, ndim);
-            Kernel<broadcast_kernel_cpu<mshadow_op::identity>, xpu>::Launch(
-              s, input_b.Size(), input_b.dptr<IType>(), bc_b_ptr,
-              aux_data_b, OpReqType::kWriteTo, ndim);
-          }
-        } else {
-          Kernel<broadcast_kernel_gpu<mshadow_op::identity>, xpu>::Launch(
-            s, bc_size_a, input_a.dptr<IType>(), bc_a_ptr,
-            aux_data_a, OpReqType::kWriteTo, ndim);
-          Kernel<broadcast_kernel_gpu<mshadow_op::identity>, xpu>::Launch(
-            s, bc_size_b, input_b.dptr<IType>(), bc_b_ptr,
-            aux_data_b, OpReqType::kWriteTo, ndim);
-        }
-      });
-    });
-    ans = mshadow::Tensor<xpu, 3, DType>(output.dptr<DType>(),
-      Shape3(batch_size, k_out_shape[ndim - 2], k_out_shape[ndim - 1]), s);
-    mlhs = mshadow::Tensor<xpu, 3, DType>(bc_a_ptr,
-      Shape3(batch_size, k_a_shape_bc[ndim - 2], k_a_shape_bc[ndim - 1]), s);
-    mrhs = mshadow::Tensor<xpu, 3, DType>(bc_b_ptr,
-      Shape3(batch_size, k_b_shape_bc[ndim - 2], k_b_shape_bc[ndim - 1]), s);
-    DType** workspace_ptr = reinterpret_cast<DType**>(bc_b_ptr + bc_size_b);
-    workspace = mshadow::Tensor<xpu, 1, DType*>(workspace_ptr, Shape1(3 * ans.size(0)), s);
-  } else {
-    ans = output.get_with_shape<xpu, 3, DType>(
-      Shape3(batch_size, out_shape[ndim - 2], out_shape[ndim - 1]), s);
-    mlhs = input_a.get_with_shape<xpu, 3, DType>(
-      Shape3(batch_size, (a_shape.ndim() == 1) ? 1 : a_shape[a_shape.ndim() - 2],
-             a_shape[a_shape.ndim() - 1]), s);
-    mrhs = input_b.get_with_shape<xpu, 3, DType>(
-      Shape3(batch_size, b_shape[b_shape.ndim() - 2], b_shape[b_shape.ndim() - 1]), s);
-    workspace = ctx.requested[0].get_space_typed<xpu, 1, DType*>
-      (mshadow::Shape1(3 * ans.size(0)), s);
+    Kernel<matmul_batch_ptrs, xpu>::Launch(
+      s, batch_size, workspace.dptr_, input_a.dptr<DType>(), input_b.dptr<DType>(),
+      output.dptr<DType>(), k_a_shape, k_b_shape, k_out_shape, static_cast<int>(ndim),
+      static_cast<index_t>(batch_size));
+    const int m = k_out_shape[ndim - 2], n = k_out_shape[ndim - 1];
+    const int k = TA ? k_a_shape[ndim - 2] : k_a_shape[ndim - 1];
+    MatmulBatchedGemm(s, TA, TB, m, n, k, workspace.dptr_, static_cast<int>(batch_size), beta);
+    return;
   }
+  ans = output.get_with_shape<xpu, 3, DType>(
+    Shape3(batch_size, out_shape[ndim - 2], out_shape[ndim - 1]), s);
+  mlhs = input_a.get_with_shape<xpu, 3, DType>(
+    Shape3(batch_size, (a_shape.ndim() == 1) ? 1 : a_shape[a_shape.ndim() - 2],
+           a_shape[a_shape.ndim() - 1]), s);
+  mrhs = input_b.get_with_shape<xpu, 3, DType>(
+    Shape3(batch_size, b_shape[b_shape.ndim() - 2], b_shape[b_shape.ndim() - 1]), s);
   if (TA && TB) {
-    mshadow::BatchGEMM<true, true>(ans, mlhs, mrhs, (DType)1.0f,
-                                   (kAddTo == req) ? (DType)1.0f : (DType)0.0f,
-                                   workspace);
+    mshadow::BatchGEMM<true, true>(ans, mlhs, mrhs, (DType)1.0f, beta, workspace);
   } else if (TA && !TB) {
-    mshadow::BatchGEMM<true, false>(ans, mlhs, mrhs, (DType)1.0f,
-                                    (kAddTo == req) ? (DType)1.0f : (DType)0.0f,
-                                    workspace);
+    mshadow::BatchGEMM<true, false>(ans, mlhs, mrhs, (DType)1.0f, beta, workspace);
   } else if (!TA && TB) {
-    mshadow::BatchGEMM<false, true>(ans, mlhs, mrhs, (DType)1.0f,
-                                    (kAddTo == req) ? (DType)1.0f : (DType)0.0f,
-                                    workspace);
+    mshadow::BatchGEMM<false, true>(ans, mlhs, mrhs, (DType)1.0f, beta, workspace);
   } else {
-    mshadow::BatchGEMM<false, false>(ans, mlhs, mrhs, (DType)1.0f,
-                                     (kAddTo == req) ? (DType)1.0f : (DType)0.0f,
-                                     workspace);
+    mshadow::BatchGEMM<false, false>(ans, mlhs, mrhs, (DType)1.0f, beta, workspace);
   }
 }
 
@@ -296,15 +287,11 @@ void NumpyMatmulForward(const nnvm::NodeAttrs& attrs,
   }
   MSHADOW_REAL_TYPE_SWITCH(outputs[0].type_flag_, DType, {
     size_t batch_size = out_shape.ProdShape(0, ndim - 2);
-    size_t bc_size_a = batch_size * a_shape[a_shape.ndim() - 2] * a_shape[a_shape.ndim() - 1];
-    size_t bc_size_b = batch_size * b_shape[b_shape.ndim() - 2] * b_shape[b_shape.ndim() - 1];
-    size_t temp_mem_size = (bc_size_a + bc_size_b) * sizeof(DType) +
-                           3 * batch_size * sizeof(DType*);
+    size_t temp_mem_size = 3 * batch_size * sizeof(DType*);
     Tensor<xpu, 1, char> temp_mem =
       ctx.requested[0].get_space_typed<xpu, 1, char>(Shape1(temp_mem_size), s);
     MatmulImpl<xpu, DType>(ctx, inputs[0], inputs[1], req[0], outputs[0], temp_mem,
-                           ndim, batch_size, bc_size_a, bc_size_b,
-                           a_shape, b_shape, out_shape, false, false);
+                           ndim, batch_size, a_shape, b_shape, out_shape, false, false);
   });
 }
 
@@ -410,13 +397,9 @@ void NumpyMatmulBackward(const nnvm::NodeAttrs& attrs,
       batch_size * a_shape[a_shape.ndim() - 2] * a_shape[a_shape.ndim() - 1];
     size_t bc_size_b =
       batch_size * b_shape[b_shape.ndim() - 2] * b_shape[b_shape.ndim() - 1];
-    size_t bc_size_out =
-      batch_size * out_shape[out_shape.ndim() - 2] * out_shape[out_shape.ndim() - 1];
 
-    size_t temp_mem_size_grada = (bc_size_out + bc_size_b) * sizeof(DType) +
-                                 3 * batch_size * sizeof(DType*);
-    size_t temp_mem_size_gradb = (bc_size_a + bc_size_out) * sizeof(DType) +
-                                 3 * batch_size * sizeof(DType*);
+    size_t temp_mem_size_grada = 3 * batch_size * sizeof(DType*);
+    size_t temp_mem_size_gradb = 3 * batch_size * sizeof(DType*);
     size_t temp_size_grada = bc_size_a * sizeof(DType);
     size_t temp_size_gradb = bc_size_b * sizeof(DType);
     size_t temp_mem_size = temp_mem_size_grada + temp_mem_size_gradb +
@@ -433,17 +416,22 @@ void NumpyMatmulBackward(const nnvm::NodeAttrs& attrs,
       reinterpret_cast<DType*>(temp_grada.dptr_ + bc_size_a),
       Shape1(bc_size_b), s);
     MatmulImpl<xpu, DType>(ctx, ograd, b, kWriteTo, temp_grada, workspace_grada,
-                           ndim, batch_size, bc_size_out, bc_size_b,
-                           out_shape, b_shape, grad_a_shape, false, true);
+                           ndim, batch_size, out_shape, b_shape, grad_a_shape, false, true);
     MatmulImpl<xpu, DType>(ctx, a, ograd, kWriteTo, temp_gradb, workspace_gradb,
-                           ndim, batch_size, bc_size_a, bc_size_out,
-                           a_shape, out_shape, grad_b_shape, true, false);
-    Kernel<SumByShape, xpu>::Launch(
+                           ndim, batch_size, a_shape, out_shape, grad_b_shape, true, false);
+    const int kndim = static_cast<int>(ndim);
+    Kernel<MatmulGradSum, xpu>::Launch(
       s, a_shape.Size(), grad_a.dptr<DType>(), temp_grada.dptr_,
-      bc_size_a, a_shape.Size(), req[0]);
-    Kernel<SumByShape, xpu>::Launch(
+      GetKernelShape<MXNET_SPECIAL_MAX_NDIM>(a_shape, ndim),
+      GetKernelShape<MXNET_SPECIAL_MAX_NDIM>(grad_a_shape, ndim), kndim,
+      static_cast<index_t>(a_shape[a_shape.ndim() - 2] * a_shape[a_shape.ndim() - 1]),
+      static_cast<index_t>(bc_size_a / a_shape.Size()), req[0]);
+    Kernel<MatmulGradSum, xpu>::Launch(
       s, b_shape.Size(), grad_b.dptr<DType>(), temp_gradb.dptr_,
-      bc_size_b, b_shape.Size(), req[1]);
+      GetKernelShape<MXNET_SPECIAL_MAX_NDIM>(b_shape, ndim),
+      GetKernelShape<MXNET_SPECIAL_MAX_NDIM>(grad_b_shape, ndim), kndim,
+      static_cast<index_t>(b_shape[b_shape.ndim() - 2] * b_shape[b_shape.ndim() - 1]),
+      static_cast<index_t>(bc_size_b / b_shape.Size()), req[1]);
   });
 }
 
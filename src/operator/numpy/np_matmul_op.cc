@@ -150,6 +150,13 @@ NNVM_REGISTER_OP(_npi_matmul)
 })
 .set_attr<mxnet::FInferShape>("FInferShape", NumpyMatmulShape)
 .set_attr<nnvm::FInferType>("FInferType", ElemwiseType<2, 1>)
+.set_attr<FComputeCost>("FComputeCost",
+  [](const NodeAttrs& attrs, const mxnet::ShapeVector& in_shapes,
+     const mxnet::ShapeVector& out_shapes) {
+    // a multiply and an add per output element and element of the contracted axis
+    const mxnet::TShape& a = in_shapes[0];
+    return 2. * out_shapes[0].Size() * a[a.ndim() - 1];
+  })
 .set_attr<THasDeterministicOutput>("THasDeterministicOutput", true)
 .set_attr<FCompute>("FCompute<cpu>", NumpyMatmulForward<cpu>)
 .set_attr<nnvm::FGradient>("FGradient", ElemwiseGradUseIn{"_backward_np_matmul"})
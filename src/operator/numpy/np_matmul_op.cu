@@ -23,9 +23,62 @@
  */
 
 #include "np_matmul_op-inl.h"
+#include "../../common/cuda/utils.h"
+
 namespace mxnet {
 namespace op {
 
+namespace {
+
+void CublasGemmBatched(cublasHandle_t handle, cublasOperation_t ta, cublasOperation_t tb,
+                       int m, int n, int k, const float *alpha, float **a, int lda,
+                       float **b, int ldb, const float *beta, float **c, int ldc, int batch) {
+  CUBLAS_CALL(cublasSgemmBatched(handle, ta, tb, m, n, k, alpha, const_cast<const float**>(a),
+                                 lda, const_cast<const float**>(b), ldb, beta, c, ldc, batch));
+}
+
+void CublasGemmBatched(cublasHandle_t handle, cublasOperation_t ta, cublasOperation_t tb,
+                       int m, int n, int k, const double *alpha, double **a, int lda,
+                       double **b, int ldb, const double *beta, double **c, int ldc,
+                       int batch) {
+  CUBLAS_CALL(cublasDgemmBatched(handle, ta, tb, m, n, k, alpha,
+                                 const_cast<const double**>(a), lda,
+                                 const_cast<const double**>(b), ldb, beta, c, ldc, batch));
+}
+
+void CublasGemmBatched(cublasHandle_t handle, cublasOperation_t ta, cublasOperation_t tb,
+                       int m, int n, int k, const mshadow::half::half_t *alpha,
+                       mshadow::half::half_t **a, int lda, mshadow::half::half_t **b, int ldb,
+                       const mshadow::half::half_t *beta, mshadow::half::half_t **c, int ldc,
+                       int batch) {
+#if CUDA_VERSION >= 9000
+  CUBLAS_CALL(cublasHgemmBatched(handle, ta, tb, m, n, k,
+                                 reinterpret_cast<const __half*>(alpha),
+                                 reinterpret_cast<const __half**>(a), lda,
+                                 reinterpret_cast<const __half**>(b), ldb,
+                                 reinterpret_cast<const __half*>(beta),
+                                 reinterpret_cast<__half**>(c), ldc, batch));
+#else
+  LOG(FATAL) << "Broadcast float16 matmul requires CUDA >= 9.0";
+#endif
+}
+
+}  // namespace
+
+template<typename DType>
+void MatmulBatchedGemm(mshadow::Stream<gpu> *s, bool TA, bool TB,
+                       int m, int n, int k, DType** ptrs, int batch_size, DType beta) {
+  using mxnet::common::cuda::CublasTransposeOp;
+  CHECK_EQ(s->blas_handle_ownership_, mshadow::Stream<gpu>::OwnHandle)
+      << "Must init CuBLAS handle in stream";
+  mshadow::BLASEngine<gpu, DType>::SetStream(s);
+  const DType alpha = 1.0f;
+  // the column major out^T = op(b)^T . op(a)^T, as in the CPU version
+  CublasGemmBatched(mshadow::Stream<gpu>::GetBlasHandle(s), CublasTransposeOp(TB),
+                    CublasTransposeOp(TA), n, m, k, &alpha, ptrs + batch_size, TB ? k : n,
+                    ptrs, TA ? m : k, &beta, ptrs + 2 * batch_size, n, batch_size);
+}
+
 NNVM_REGISTER_OP(_npi_matmul)
 .set_attr<FCompute>("FCompute<gpu>", NumpyMatmulForward<gpu>);
 
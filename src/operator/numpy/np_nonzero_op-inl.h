@@ -38,6 +38,7 @@
 #include "../tensor/init_op.h"
 #include "../mshadow_op.h"
 #include "../elemwise_op_common.h"
+#include "../contrib/boolean_mask-inl.h"
 
 namespace mxnet {
 namespace op {
@@ -78,6 +79,61 @@ struct NonzeroForwardKernelGPU {
   }
 };
 
+/*!
+ * \brief Write the coordinates of the non-zeros to the front of out and -1 to its
+ *        other rows, with idx the inclusive prefix sum of the non-zeros of size elements.
+ */
+struct NonzeroPaddedForwardKernel {
+  template<int ndim>
+  MSHADOW_XINLINE static void Map(index_t i,
+                                  int64_t* out,
+                                  const int32_t* idx,
+                                  const index_t size,
+                                  const mshadow::Shape<ndim> shape) {
+    const int32_t prev = (i == 0) ? 0 : idx[i - 1];
+    if (prev != idx[i]) {
+      mshadow::Shape<ndim> coord = mxnet_op::unravel<ndim>(i, shape);
+      for (int j = 0; j < ndim; j++) {
+        out[prev * ndim + j] = coord[j];
+      }
+    }
+    if (i >= idx[size - 1]) {
+      for (int j = 0; j < ndim; j++) {
+        out[i * ndim + j] = -1;
+      }
+    }
+  }
+};
+
+template<typename xpu>
+void NonzeroPaddedForward(const nnvm::NodeAttrs& attrs,
+                          const OpContext &ctx,
+                          const std::vector<TBlob> &inputs,
+                          const std::vector<OpReqType> &req,
+                          const std::vector<TBlob> &outputs) {
+  using namespace mxnet_op;
+  CHECK_EQ(inputs.size(), 1U);
+  CHECK_EQ(outputs.size(), 2U);
+  CHECK(req[0] == kWriteTo || req[0] == kNullOp)
+    << "nonzero_padded only supports kWriteTo";
+  const TBlob &in = inputs[0];
+  mshadow::Stream<xpu> *s = ctx.get_stream<xpu>();
+  const index_t in_size = in.Size();
+  int32_t* prefix_sum = in_size > 0 ? BooleanMaskPrefixSum<xpu>(ctx, in) : nullptr;
+  if (req[0] != kNullOp && in_size > 0) {
+    // a 0-dim input has the coordinates of an input of shape (1,)
+    const mxnet::TShape ishape = in.ndim() == 0 ? mxnet::TShape(1, 1) : in.shape_;
+    MXNET_NDIM_SWITCH(ishape.ndim(), ndim, {
+      Kernel<NonzeroPaddedForwardKernel, xpu>::Launch(
+        s, in_size, outputs[0].dptr<int64_t>(), prefix_sum, in_size, ishape.get<ndim>());
+    });
+  }
+  if (req[1] != kNullOp) {
+    Kernel<BooleanMaskValidLengthKernel, xpu>::Launch(
+      s, 1, outputs[1].dptr<int32_t>(), prefix_sum, in_size);
+  }
+}
+
 }  // namespace op
 }  // namespace mxnet
 
@@ -125,5 +125,59 @@ NNVM_REGISTER_OP(_npx_nonzero)
 .set_attr<nnvm::FGradient>("FGradient", MakeZeroGradNodes)
 .add_argument("x", "NDArray-or-Symbol", "The input array.");
 
+bool NonzeroPaddedShape(const nnvm::NodeAttrs& attrs,
+                        mxnet::ShapeVector *in_attrs,
+                        mxnet::ShapeVector *out_attrs) {
+  CHECK_EQ(in_attrs->size(), 1U);
+  CHECK_EQ(out_attrs->size(), 2U);
+  SHAPE_ASSIGN_CHECK(*out_attrs, 1, mxnet::TShape(1, 1));
+  const mxnet::TShape& ishape = in_attrs->at(0);
+  if (!shape_is_known(ishape)) return false;
+  CHECK_LE(ishape.ndim(), MAXDIM) << "ndim of input cannot larger than " << MAXDIM;
+  mxnet::TShape oshape(2, std::max(ishape.ndim(), 1));
+  oshape[0] = ishape.Size();
+  SHAPE_ASSIGN_CHECK(*out_attrs, 0, oshape);
+  return true;
+}
+
+bool NonzeroPaddedType(const nnvm::NodeAttrs& attrs,
+                       std::vector<int> *in_attrs,
+                       std::vector<int> *out_attrs) {
+  CHECK_EQ(in_attrs->size(), 1U);
+  CHECK_EQ(out_attrs->size(), 2U);
+  TYPE_ASSIGN_CHECK(*out_attrs, 0, mshadow::kInt64);
+  TYPE_ASSIGN_CHECK(*out_attrs, 1, mshadow::kInt32);
+  return in_attrs->at(0) != -1;
+}
+
+NNVM_REGISTER_OP(_npx_nonzero_padded)
+.describe(R"code(
+The nonzero operator with an output of static shape.
+Returns the coordinates of the non-zero elements of x in an int64 array of shape
+(x.size, max(x.ndim, 1)), where the rows past the number of non-zero elements are -1,
+and that number in the int32 output valid_length of shape (1,).
+Unlike nonzero, the host does not wait for the count of the non-zero elements,
+the following operators read valid_length on the device instead.
+)code" ADD_FILELINE)
+.set_num_inputs(1)
+.set_num_outputs(2)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    return std::vector<std::string>{"x"};
+  })
+.set_attr<nnvm::FListOutputNames>("FListOutputNames",
+  [](const NodeAttrs& attrs) {
+    return std::vector<std::string>{"output", "valid_length"};
+  })
+.set_attr<mxnet::FInferShape>("FInferShape", NonzeroPaddedShape)
+.set_attr<nnvm::FInferType>("FInferType", NonzeroPaddedType)
+.set_attr<FResourceRequest>("FResourceRequest",
+  [](const NodeAttrs& attrs) {
+    return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
+  })
+.set_attr<FCompute>("FCompute<cpu>", NonzeroPaddedForward<cpu>)
+.set_attr<nnvm::FGradient>("FGradient", MakeZeroGradNodes)
+.add_argument("x", "NDArray-or-Symbol", "The input array.");
+
 }  // namespace op
 }  // namespace mxnet
@@ -128,5 +128,8 @@ NNVM_REGISTER_OP(_npx_nonzero)
   })
 .set_attr<FComputeEx>("FComputeEx<gpu>", NonzeroForwardGPU);
 
+NNVM_REGISTER_OP(_npx_nonzero_padded)
+.set_attr<FCompute>("FCompute<gpu>", NonzeroPaddedForward<gpu>);
+
 }  // namespace op
 }  // namespace mxnet
@@ -24,6 +24,7 @@
 #ifndef MXNET_OPERATOR_NUMPY_NP_PERCENTILE_OP_INL_H_
 #define MXNET_OPERATOR_NUMPY_NP_PERCENTILE_OP_INL_H_
 
+#include <algorithm>
 #include <vector>
 #include <string>
 #include "../tensor/ordering_op-inl.h"
@@ -34,6 +35,7 @@
 #include "../elemwise_op_common.h"
 #include "np_broadcast_reduce_op.h"
 #include "../../api/operator/op_utils.h"
+#include "../../engine/openmp.h"
 
 namespace mxnet {
 namespace op {
@@ -133,6 +135,54 @@ struct percentile_take {
   }
 };
 
+/*!
+ * \brief Partially order each of the num_lanes contiguous lanes of red_size elements of a
+ *  with std::nth_element, so that the elements at the ranks read by percentile_take for
+ *  the percentiles q are those of the sorted lane. The ranks are selected in ascending
+ *  order, each selection only searching the elements above the previous rank.
+ */
+template<typename DType, typename QType>
+void PercentileSelect(mshadow::Stream<cpu> *s,
+                      DType* a,
+                      const index_t num_lanes,
+                      const index_t red_size,
+                      const QType* q,
+                      const index_t num_q) {
+  if (red_size == 0) return;
+  std::vector<index_t> ranks;
+  for (index_t i = 0; i < num_q; ++i) {
+    // the same computation as percentile_take, for all the interpolations
+    float idx = q[i] * (red_size - 1) / 100.0;
+    const index_t below = static_cast<index_t>(floor(idx));
+    ranks.push_back(below);
+    ranks.push_back(std::min(below + 1, red_size - 1));
+    ranks.push_back(static_cast<index_t>(ceil(idx)));
+    ranks.push_back(static_cast<index_t>(round(idx)));
+  }
+  std::sort(ranks.begin(), ranks.end());
+  ranks.erase(std::unique(ranks.begin(), ranks.end()), ranks.end());
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  #pragma omp parallel for num_threads(omp_threads) if (num_lanes > 1)
+  for (index_t i = 0; i < num_lanes; ++i) {
+    DType* lane = a + i * red_size;
+    DType* first = lane;
+    for (const index_t rank : ranks) {
+      std::nth_element(first, lane + rank, lane + red_size);
+      first = lane + rank + 1;
+    }
+  }
+}
+
+template<typename DType, typename QType>
+void PercentileSelect(mshadow::Stream<gpu> *s,
+                      DType* a,
+                      const index_t num_lanes,
+                      const index_t red_size,
+                      const QType* q,
+                      const index_t num_q) {
+  LOG(FATAL) << "Selection of the percentiles is only implemented on CPU";
+}
+
 template<typename QType, typename xpu>
 bool CheckInvalidInput(mshadow::Stream<xpu> *s,
                        const QType *data,
@@ -224,13 +274,18 @@ void NumpyPercentileForward(const nnvm::NodeAttrs& attrs,
   topk_param.k = 0;
   topk_param.ret_typ = topk_enum::kReturnValue;
 
+  // on CPU the ranks of the percentiles are selected in the transposed copy of data,
+  // on GPU the lanes are sorted
+  const bool by_selection = xpu::kDevCPU;
+
   MSHADOW_TYPE_SWITCH(data.type_flag_, DType, {
-    size_t temp_size;  // Used by Sort
-    size_t topk_workspace_size = TopKWorkspaceSize<xpu, DType>(data, topk_param, &temp_size);
+    size_t temp_size = 0;  // Used by Sort
+    size_t topk_workspace_size = by_selection ? 0 :
+      TopKWorkspaceSize<xpu, DType>(data, topk_param, &temp_size);
 
     size_t temp_data_size = data.Size() * sizeof(DType);
-    size_t idx_size = data.Size() * sizeof(index_t);
-    size_t temp_mem_size = 2 * temp_data_size + idx_size;
+    size_t idx_size = by_selection ? 0 : data.Size() * sizeof(index_t);
+    size_t temp_mem_size = (by_selection ? 1 : 2) * temp_data_size + idx_size;
     size_t workspace_size = topk_workspace_size * 2 + temp_mem_size + 16;
 
     Tensor<xpu, 1, char> temp_mem =
@@ -271,18 +326,31 @@ void NumpyPercentileForward(const nnvm::NodeAttrs& attrs,
       trans_ptr = reinterpret_cast<DType*>(workspace_curr_ptr + idx_size);
       sort_ptr = reinterpret_cast<DType*>(workspace_curr_ptr + temp_data_size + idx_size);
     }
-    workspace_curr_ptr += 2 * temp_data_size + idx_size;
+    if (by_selection) {
+      trans_ptr = reinterpret_cast<DType*>(workspace_curr_ptr);
+    }
+    workspace_curr_ptr += temp_mem_size;
 
     TBlob a_trans = TBlob(trans_ptr, t_shape_ex, xpu::kDevMask);
     TransposeImpl<xpu>(ctx.run_ctx, data, a_trans, t_axes);
-    TBlob a_sort = TBlob(sort_ptr, t_shape, xpu::kDevMask);
-    TBlob a_idx = TBlob(idx_ptr, t_shape, xpu::kDevMask);
-    std::vector<OpReqType> req_TopK = {kWriteTo, kNullOp};
-    TBlob src = a_trans.reshape(t_shape);
-    std::vector<TBlob> ret = {a_sort, a_idx};
+    TBlob a_sort;
+    if (by_selection) {
+      a_sort = a_trans.reshape(t_shape);
+      MSHADOW_TYPE_SWITCH(percentile.type_flag_, QType, {
+        PercentileSelect(s, a_sort.dptr<DType>(), red_size == 0 ? 0 : a_sort.Size() / red_size,
+                         static_cast<index_t>(red_size),
+                         percentile.dptr<QType>(), percentile.Size());
+      })
+    } else {
+      a_sort = TBlob(sort_ptr, t_shape, xpu::kDevMask);
+      TBlob a_idx = TBlob(idx_ptr, t_shape, xpu::kDevMask);
+      std::vector<OpReqType> req_TopK = {kWriteTo, kNullOp};
+      TBlob src = a_trans.reshape(t_shape);
+      std::vector<TBlob> ret = {a_sort, a_idx};
 
-    TopKImplwithWorkspace<xpu, DType, index_t>(ctx.run_ctx, req_TopK, src, ret, topk_param,
-                                               workspace_curr_ptr, temp_size, s);
+      TopKImplwithWorkspace<xpu, DType, index_t>(ctx.run_ctx, req_TopK, src, ret, topk_param,
+                                                 workspace_curr_ptr, temp_size, s);
+    }
     MSHADOW_TYPE_SWITCH(percentile.type_flag_, QType, {
       MSHADOW_SGL_DBL_TYPE_SWITCH(out.type_flag_, OType, {
         MXNET_NDIM_SWITCH(small.ndim()+1, NDim, {
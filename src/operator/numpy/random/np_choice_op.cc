@@ -30,11 +30,13 @@ namespace mxnet {
 namespace op {
 
 template <>
-void _sort<cpu>(float* key, int64_t* data, index_t length) {
-  std::sort(data, data + length,
-            [key](int64_t const& i, int64_t const& j) -> bool {
-              return key[i] > key[j];
-            });
+void _topk<cpu>(mshadow::Tensor<cpu, 1, float> keys, mshadow::Tensor<cpu, 1, int64_t> indices,
+                index_t k, mshadow::Tensor<cpu, 1, char> *workspace) {
+  const float *key = keys.dptr_;
+  std::partial_sort(indices.dptr_, indices.dptr_ + k, indices.dptr_ + indices.size(0),
+                    [key](int64_t const& i, int64_t const& j) -> bool {
+                      return key[i] > key[j];
+                    });
 }
 
 DMLC_REGISTER_PARAMETER(NumpyChoiceParam);
@@ -23,20 +23,16 @@
  * \brief Operator for random subset sampling
  */
 
-#include <thrust/execution_policy.h>
-#include <thrust/sort.h>
-#include <thrust/swap.h>
 #include "./np_choice_op.h"
 
 namespace mxnet {
 namespace op {
 
 template <>
-void _sort<gpu>(float* key, int64_t* data, index_t length) {
-  thrust::device_ptr<float> dev_key(key);
-  thrust::device_ptr<int64_t> dev_data(data);
-  thrust::sort_by_key(dev_key, dev_key + length, dev_data,
-                      thrust::greater<float>());
+void _topk<gpu>(mshadow::Tensor<gpu, 1, float> keys, mshadow::Tensor<gpu, 1, int64_t> indices,
+                index_t k, mshadow::Tensor<gpu, 1, char> *workspace) {
+  // a radix sort of all the keys, on the stream of the operator
+  SortByKey(keys, indices, false, workspace);
 }
 
 NNVM_REGISTER_OP(_npi_choice)
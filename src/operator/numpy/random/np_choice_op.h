@@ -36,6 +36,8 @@
 #include "../../mxnet_op.h"
 #include "../../operator_common.h"
 #include "../../tensor/elemwise_binary_broadcast_op.h"
+#include "../../tensor/sort_op.h"
+#include "../../random/sample_multinomial_op.h"
 
 namespace mxnet {
 namespace op {
@@ -91,8 +93,13 @@ inline bool NumpyChoiceOpShape(const nnvm::NodeAttrs &attrs,
   return true;
 }
 
+/*!
+ * \brief Move the indices of the k largest keys to the front of indices, by decreasing keys.
+ * \param workspace temp space of SortByKeyWorkspaceSize<float, int64_t, xpu> bytes
+ */
 template <typename xpu>
-void _sort(float *key, int64_t *data, index_t length);
+void _topk(mshadow::Tensor<xpu, 1, float> keys, mshadow::Tensor<xpu, 1, int64_t> indices,
+           index_t k, mshadow::Tensor<xpu, 1, char> *workspace);
 
 namespace mxnet_op {
 
@@ -136,23 +143,6 @@ struct generate_keys {
   }
 };
 
-// Weighted sample with replacement.
-template <typename IType>
-struct categorical_sampling {
-  MSHADOW_XINLINE static void Map(index_t i, IType *weights, size_t length,
-                                  float *uniforms, int64_t *outs) {
-    outs[i] = 0;
-    float acc = 0.0;
-    float threshold = uniforms[i];
-    for (size_t k = 0; k < length; k++) {
-      acc += weights[k];
-      if (acc < threshold) {
-        outs[i] += 1;
-      }
-    }
-  }
-};
-
 }  // namespace mxnet_op
 
 template <typename xpu>
@@ -177,35 +167,49 @@ void NumpyChoiceForward(const nnvm::NodeAttrs &attrs, const OpContext &ctx,
   int64_t output_size = outputs[0].Size();
   if (weighted) {
     Random<xpu, float> *prnd = ctx.requested[0].get_random<xpu, float>(s);
-    int64_t random_tensor_size = replace ? output_size : input_size;
-    int64_t indices_size = replace ? 0 : input_size;
-    Tensor<xpu, 1, char> workspace =
-        ctx.requested[1].get_space_typed<xpu, 1, char>(
-            Shape1(indices_size * sizeof(int64_t) +
-                   (random_tensor_size * sizeof(float) / 7 + 1) * 8),
-            s);
-    // slice workspace
-    char *workspace_ptr = workspace.dptr_;
-    Tensor<xpu, 1, float> random_numbers =
-        Tensor<xpu, 1, float>(reinterpret_cast<float *>(workspace_ptr),
-                              Shape1(random_tensor_size), s);
-    prnd->SampleUniform(&random_numbers, 0, 1);
-    workspace_ptr += ((random_tensor_size * sizeof(float) / 7 + 1) * 8);
     if (replace) {
+      // Draws from the alias table of the weights.
+      // [aliases, worklist of the alias table, uniforms, probability table]
+      Tensor<xpu, 1, char> workspace =
+          ctx.requested[1].get_space_typed<xpu, 1, char>(
+              Shape1(2 * sizeof(index_t) * input_size +
+                     sizeof(float) * (2 * output_size + input_size)), s);
+      index_t *alias = reinterpret_cast<index_t *>(workspace.dptr_);
+      Tensor<xpu, 1, float> uniforms(reinterpret_cast<float *>(alias + 2 * input_size),
+                                     Shape1(2 * output_size), s);
+      float *prob_table = uniforms.dptr_ + 2 * output_size;
+      prnd->SampleUniform(&uniforms, 0, 1);
       MSHADOW_REAL_TYPE_SWITCH(inputs[weight_index].type_flag_, IType, {
-        Kernel<categorical_sampling<IType>, xpu>::Launch(
-            s, output_size, inputs[weight_index].dptr<IType>(), input_size,
-            random_numbers.dptr_, outputs[0].dptr<int64_t>());
+        Kernel<BuildAliasTableKernel, xpu>::Launch(
+            s, 1, input_size, inputs[weight_index].dptr<IType>(), prob_table, alias,
+            alias + input_size);
+        Kernel<SampleAliasTableKernel, xpu>::Launch(
+            s, output_size, input_size, output_size, inputs[weight_index].dptr<IType>(),
+            uniforms.dptr_, prob_table, alias, outputs[0].dptr<int64_t>(),
+            static_cast<IType *>(nullptr));
       });
     } else {
-      Tensor<xpu, 1, int64_t> indices = Tensor<xpu, 1, int64_t>(
-          reinterpret_cast<int64_t *>(workspace_ptr), Shape1(indices_size), s);
+      // The indices of the largest perturbed Gumbel keys.
+      // [indices, keys, temp space of the top-k]
+      const size_t indices_bytes = sizeof(int64_t) * input_size;
+      const size_t keys_bytes = PadBytes(sizeof(float) * input_size, sizeof(int64_t));
+      const size_t topk_bytes = SortByKeyWorkspaceSize<float, int64_t, xpu>(input_size);
+      Tensor<xpu, 1, char> workspace =
+          ctx.requested[1].get_space_typed<xpu, 1, char>(
+              Shape1(indices_bytes + keys_bytes + topk_bytes), s);
+      Tensor<xpu, 1, int64_t> indices(reinterpret_cast<int64_t *>(workspace.dptr_),
+                                      Shape1(input_size), s);
+      Tensor<xpu, 1, float> keys(reinterpret_cast<float *>(workspace.dptr_ + indices_bytes),
+                                 Shape1(input_size), s);
+      Tensor<xpu, 1, char> topk_workspace(workspace.dptr_ + indices_bytes + keys_bytes,
+                                          Shape1(topk_bytes), s);
+      prnd->SampleUniform(&keys, 0, 1);
       indices = expr::range((int64_t)0, input_size);
       MSHADOW_REAL_TYPE_SWITCH(inputs[weight_index].type_flag_, IType, {
-        Kernel<generate_keys<IType>, xpu>::Launch(s, input_size, random_numbers.dptr_,
+        Kernel<generate_keys<IType>, xpu>::Launch(s, input_size, keys.dptr_,
                                            inputs[weight_index].dptr<IType>());
       });
-      _sort<xpu>(random_numbers.dptr_, indices.dptr_, input_size);
+      _topk<xpu>(keys, indices, output_size, &topk_workspace);
       Copy(outputs[0].FlatTo1D<xpu, int64_t>(s), indices.Slice(0, output_size), s);
     }
   } else {
@@ -512,6 +512,20 @@ inline void CheckAllRowsPresent(const NDArray& arr, const std::string& func,
   }
 }
 
+/*! \brief FComputeCost of the elementwise operators, one operation per output element */
+inline double ElemwiseCost(const nnvm::NodeAttrs& attrs,
+                           const mxnet::ShapeVector& in_shapes,
+                           const mxnet::ShapeVector& out_shapes) {
+  return static_cast<double>(out_shapes[0].Size());
+}
+
+/*! \brief FComputeCost of the reductions, one operation per input element */
+inline double ReduceCost(const nnvm::NodeAttrs& attrs,
+                         const mxnet::ShapeVector& in_shapes,
+                         const mxnet::ShapeVector& out_shapes) {
+  return static_cast<double>(in_shapes[0].Size());
+}
+
 inline void LogUnimplementedOp(const nnvm::NodeAttrs& attrs,
                                const OpContext &ctx,
                                const std::vector<NDArray> &inputs,
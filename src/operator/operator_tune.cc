@@ -18,6 +18,9 @@
  */
 #include <cfloat>
 #include <atomic>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
 #include "./mxnet_op.h"
 #include "./mshadow_op.h"
 #include "./tensor/init_op.h"
@@ -34,6 +37,113 @@ std::atomic<bool> OperatorTuneBase::calculated_(false);
 bool OperatorTuneBase::verbose_tuning_info_ = false;
 double OperatorTuneBase::tuning_weight_scale_ = 0.0;
 
+OnlineOperatorTune::Entry::Entry(int max_threads, int samples)
+  : max_threads(max_threads), samples_(samples) {
+  for (int threads = 1; threads < max_threads; threads *= 2) {
+    candidates_.push_back(threads);
+  }
+  candidates_.push_back(max_threads);
+  best_.resize(candidates_.size(), DBL_MAX);
+}
+
+int OnlineOperatorTune::Entry::Threads(bool *measure) {
+  *measure = false;
+  const int chosen = this->chosen();
+  if (chosen > 0) {
+    return chosen;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (issued_ < samples_ * static_cast<int>(candidates_.size())) {
+    *measure = true;
+    // candidates are interleaved so that warm-up effects are spread over all of them
+    return candidates_[issued_++ % candidates_.size()];
+  }
+  // all measurements are issued, but not all of them are recorded yet
+  return max_threads;
+}
+
+void OnlineOperatorTune::Entry::Record(int threads, double ns_per_item) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const size_t i = std::find(candidates_.begin(), candidates_.end(), threads)
+                     - candidates_.begin();
+    CHECK_LT(i, candidates_.size());
+    // the minimum is the least noisy estimate of a kernel time
+    best_[i] = std::min(best_[i], ns_per_item);
+    if (++recorded_ < samples_ * static_cast<int>(candidates_.size())) {
+      return;
+    }
+    const size_t best = std::min_element(best_.begin(), best_.end()) - best_.begin();
+    chosen_.store(candidates_[best], std::memory_order_release);
+  }
+  OnlineOperatorTune::Get()->Decided(*this);
+}
+
+OnlineOperatorTune *OnlineOperatorTune::Get() {
+  static OnlineOperatorTune tune;
+  return &tune;
+}
+
+OnlineOperatorTune::OnlineOperatorTune()
+  : cache_file_(dmlc::GetEnv("MXNET_ONLINE_TUNING_CACHE", std::string())),
+    samples_(std::max(1, dmlc::GetEnv("MXNET_ONLINE_TUNING_SAMPLES", 3))) {
+  if (cache_file_.empty()) {
+    return;
+  }
+  std::ifstream is(cache_file_);
+  std::string line;
+  while (std::getline(is, line)) {
+    std::istringstream fields(line);
+    std::string key;
+    int threads = 0;
+    if (fields >> key >> threads && threads > 0) {
+      cache_[key] = threads;
+    }
+  }
+}
+
+OnlineOperatorTune::~OnlineOperatorTune() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!dirty_ || cache_file_.empty()) {
+    return;
+  }
+  std::ofstream os(cache_file_);
+  if (!os) {
+    LOG(WARNING) << "Unable to write the online tuning cache " << cache_file_;
+    return;
+  }
+  for (const auto &kv : cache_) {
+    os << kv.first << " " << kv.second << "\n";
+  }
+}
+
+OnlineOperatorTune::Entry *OnlineOperatorTune::Find(const char *op, const char *dtype,
+                                                    int bucket, int max_threads) {
+  std::ostringstream key;
+  key << op << ":" << dtype << ":" << bucket << ":" << max_threads;
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::unique_ptr<Entry> &entry = entries_[key.str()];
+  if (!entry) {
+    entry.reset(new Entry(max_threads, samples_));
+    entry->key_ = key.str();
+    auto it = cache_.find(entry->key_);
+    if (it != cache_.end() && it->second <= max_threads) {
+      entry->chosen_.store(it->second, std::memory_order_release);
+    }
+  }
+  return entry.get();
+}
+
+void OnlineOperatorTune::Decided(const Entry &entry) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  cache_[entry.key_] = entry.chosen();
+  dirty_ = true;
+  static const bool verbose = dmlc::GetEnv("MXNET_VERBOSE_TUNING_INFO", false);
+  if (verbose) {
+    LOG(INFO) << "Online tuning of " << entry.key_ << ": " << entry.chosen() << " threads";
+  }
+}
+
 /*!
  * \brief Instantiate static variables for OperatorTune<DType>, where 'DType' is specified
  */
@@ -19,12 +19,17 @@
 #ifndef MXNET_OPERATOR_OPERATOR_TUNE_H_
 #define MXNET_OPERATOR_OPERATOR_TUNE_H_
 
+#include <dmlc/parameter.h>
 #include <mshadow/base.h>
 #include <mshadow/tensor.h>
 #include <vector>
 #include <set>
 #include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <typeinfo>
 
 // #define MXNET_DEBUG_TUNING_LAUNCH
 
@@ -219,6 +224,93 @@ class OperatorTuneByType : public OperatorTuneBase {
 // template <typename DType>
 // volatile tune::TuningMode OperatorTuneByType<DType>::tuning_mode_;
 
+/*!
+ * \brief Online tuning of the OMP thread count of the tuned kernels, enabled by
+ *        MXNET_ONLINE_OPERATOR_TUNING. The first launches of each (op, dtype, size bucket,
+ *        thread count) time the candidate thread counts, and the fastest one is used
+ *        afterwards. Decisions are read from and written to MXNET_ONLINE_TUNING_CACHE.
+ */
+class OnlineOperatorTune {
+ public:
+  /*! \brief Thread count decision for one key */
+  class Entry {
+   public:
+    Entry(int max_threads, int samples);
+    /*!
+     * \brief Thread count to run the next launch with
+     * \param measure Set to whether the launch should be timed and recorded
+     */
+    int Threads(bool *measure);
+    /*! \brief Record the time per item of a timed launch */
+    void Record(int threads, double ns_per_item);
+    /*! \brief The chosen thread count, 0 while measuring */
+    int chosen() const {
+      return chosen_.load(std::memory_order_acquire);
+    }
+    const int max_threads;
+
+   private:
+    friend class OnlineOperatorTune;
+    std::atomic<int> chosen_{0};
+    std::mutex mutex_;
+    std::vector<int> candidates_;
+    std::vector<double> best_;
+    int issued_ = 0;
+    int recorded_ = 0;
+    int samples_;
+    std::string key_;
+  };
+
+  static OnlineOperatorTune *Get();
+  ~OnlineOperatorTune();
+
+  /*! \brief Whether online tuning is enabled */
+  static bool enabled() {
+    static const bool enabled = dmlc::GetEnv("MXNET_ONLINE_OPERATOR_TUNING", false);
+    return enabled;
+  }
+
+  /*! \brief Size bucket of a launch of n items */
+  static MSHADOW_CINLINE int Bucket(size_t n) {
+    int bucket = 0;
+    while (n >>= 1) ++bucket;
+    return bucket;
+  }
+
+  /*! \brief The entry of an op and dtype, created and looked up in the cache on first use */
+  Entry *Find(const char *op, const char *dtype, int bucket, int max_threads);
+
+ private:
+  OnlineOperatorTune();
+  void Decided(const Entry &entry);
+
+  std::mutex mutex_;
+  std::map<std::string, std::unique_ptr<Entry>> entries_;
+  /*! \brief cached decisions, from the cache file and from this run */
+  std::map<std::string, int> cache_;
+  std::string cache_file_;
+  bool dirty_ = false;
+  int samples_;
+};
+
+/*!
+ * \brief The online tuning entry of a tuned kernel launch of n items
+ * \tparam PRIMITIVE_OP The primitive operation of the launch
+ * \tparam DType Data type
+ */
+template<typename PRIMITIVE_OP, typename DType>
+inline OnlineOperatorTune::Entry *OnlineTuneEntry(size_t n, int max_threads) {
+  static std::atomic<OnlineOperatorTune::Entry *> table[sizeof(size_t) * 8];
+  const int bucket = OnlineOperatorTune::Bucket(n);
+  OnlineOperatorTune::Entry *entry = table[bucket].load(std::memory_order_acquire);
+  if (entry == nullptr || entry->max_threads != max_threads) {
+    entry = OnlineOperatorTune::Get()->Find(typeid(PRIMITIVE_OP).name(), typeid(DType).name(),
+                                            bucket, max_threads);
+    table[bucket].store(entry, std::memory_order_release);
+  }
+  return entry;
+}
+
 namespace mxnet_op {
 /*!
  * \brief Kernel operator wrapper used for tuning data
@@ -32,6 +32,7 @@
 #include <mshadow/base.h>
 #include <nnvm/op.h>
 #include <nnvm/op_attr_types.h>
+#include <algorithm>
 #include <vector>
 #include "./operator_common.h"
 #include "./mshadow_op.h"
@@ -2052,6 +2053,857 @@ inline void RMSPropUpdate(const nnvm::NodeAttrs &attrs, const OpContext &ctx,
   });
 }
 
+struct MultiAdamParam : public dmlc::Parameter<MultiAdamParam> {
+  mxnet::Tuple<float> lrs;
+  mxnet::Tuple<float> wds;
+  float beta1;
+  float beta2;
+  float epsilon;
+  float rescale_grad;
+  float clip_gradient;
+  int num_weights;
+  DMLC_DECLARE_PARAMETER(MultiAdamParam) {
+    DMLC_DECLARE_FIELD(lrs)
+    .describe("Learning rates, including the bias correction of each weight.");
+    DMLC_DECLARE_FIELD(wds)
+    .describe("Weight decay augments the objective function with a "
+              "regularization term that penalizes large weights. "
+              "The penalty scales with the square of the magnitude of each weight.");
+    DMLC_DECLARE_FIELD(beta1)
+    .set_default(0.9f)
+    .describe("The decay rate for the 1st moment estimates.");
+    DMLC_DECLARE_FIELD(beta2)
+    .set_default(0.999f)
+    .describe("The decay rate for the 2nd moment estimates.");
+    DMLC_DECLARE_FIELD(epsilon)
+    .set_default(1e-8f)
+    .describe("A small constant for numerical stability.");
+    DMLC_DECLARE_FIELD(rescale_grad)
+    .set_default(1.0f)
+    .describe("Rescale gradient to grad = rescale_grad*grad.");
+    DMLC_DECLARE_FIELD(clip_gradient)
+    .set_default(-1.0f)
+    .describe("Clip gradient to the range of [-clip_gradient, clip_gradient] "
+              "If clip_gradient <= 0, gradient clipping is turned off. "
+              "grad = max(min(grad, clip_gradient), -clip_gradient).");
+    DMLC_DECLARE_FIELD(num_weights)
+    .set_default(1)
+    .describe("Number of updated weights.");
+  }
+};
+
+struct MultiRMSPropParam : public dmlc::Parameter<MultiRMSPropParam> {
+  mxnet::Tuple<float> lrs;
+  mxnet::Tuple<float> wds;
+  float rho;
+  float epsilon;
+  float rescale_grad;
+  float clip_gradient;
+  float clip_weights;
+  int num_weights;
+  DMLC_DECLARE_PARAMETER(MultiRMSPropParam) {
+    DMLC_DECLARE_FIELD(lrs)
+    .describe("Learning rates.");
+    DMLC_DECLARE_FIELD(wds)
+    .describe("Weight decay augments the objective function with a "
+              "regularization term that penalizes large weights. "
+              "The penalty scales with the square of the magnitude of each weight.");
+    DMLC_DECLARE_FIELD(rho).set_default(0.95f)
+    .describe("The decay rate of momentum estimates.");
+    DMLC_DECLARE_FIELD(epsilon).set_default(1e-8f)
+    .describe("A small constant for numerical stability.");
+    DMLC_DECLARE_FIELD(rescale_grad)
+    .set_default(1.0f)
+    .describe("Rescale gradient to grad = rescale_grad*grad.");
+    DMLC_DECLARE_FIELD(clip_gradient)
+    .set_default(-1.0f)
+    .describe("Clip gradient to the range of [-clip_gradient, clip_gradient] "
+              "If clip_gradient <= 0, gradient clipping is turned off. "
+              "grad = max(min(grad, clip_gradient), -clip_gradient).");
+    DMLC_DECLARE_FIELD(clip_weights)
+    .set_default(-1.0f)
+    .describe("Clip weights to the range of [-clip_weights, clip_weights] "
+              "If clip_weights <= 0, weight clipping is turned off. "
+              "weights = max(min(weights, clip_weights), -clip_weights).");
+    DMLC_DECLARE_FIELD(num_weights)
+    .set_default(1)
+    .describe("Number of updated weights.");
+  }
+};
+
+struct MultiNAGMomParam : public dmlc::Parameter<MultiNAGMomParam> {
+  mxnet::Tuple<float> lrs;
+  mxnet::Tuple<float> wds;
+  float momentum;
+  float rescale_grad;
+  float clip_gradient;
+  int num_weights;
+  DMLC_DECLARE_PARAMETER(MultiNAGMomParam) {
+    DMLC_DECLARE_FIELD(lrs)
+    .describe("Learning rates.");
+    DMLC_DECLARE_FIELD(wds)
+    .describe("Weight decay augments the objective function with a "
+              "regularization term that penalizes large weights. "
+              "The penalty scales with the square of the magnitude of each weight.");
+    DMLC_DECLARE_FIELD(momentum)
+    .set_default(0.0f)
+    .describe("The decay rate of momentum estimates at each epoch.");
+    DMLC_DECLARE_FIELD(rescale_grad)
+    .set_default(1.0f)
+    .describe("Rescale gradient to grad = rescale_grad*grad.");
+    DMLC_DECLARE_FIELD(clip_gradient)
+    .set_default(-1.0f)
+    .describe("Clip gradient to the range of [-clip_gradient, clip_gradient] "
+              "If clip_gradient <= 0, gradient clipping is turned off. "
+              "grad = max(min(grad, clip_gradient), -clip_gradient).");
+    DMLC_DECLARE_FIELD(num_weights)
+    .set_default(1)
+    .describe("Number of updated weights.");
+  }
+};
+
+/*!
+ * \brief Adam with the learning rates, weight decays and gradient scale in device arrays,
+ *        which a schedule or a loss scaler changes without changing the attributes.
+ */
+struct PreloadedMultiAdamParam : public dmlc::Parameter<PreloadedMultiAdamParam> {
+  float beta1;
+  float beta2;
+  float epsilon;
+  float clip_gradient;
+  int num_weights;
+  DMLC_DECLARE_PARAMETER(PreloadedMultiAdamParam) {
+    DMLC_DECLARE_FIELD(beta1)
+    .set_default(0.9f)
+    .describe("The decay rate for the 1st moment estimates.");
+    DMLC_DECLARE_FIELD(beta2)
+    .set_default(0.999f)
+    .describe("The decay rate for the 2nd moment estimates.");
+    DMLC_DECLARE_FIELD(epsilon)
+    .set_default(1e-8f)
+    .describe("A small constant for numerical stability.");
+    DMLC_DECLARE_FIELD(clip_gradient)
+    .set_default(-1.0f)
+    .describe("Clip gradient to the range of [-clip_gradient, clip_gradient] "
+              "If clip_gradient <= 0, gradient clipping is turned off. "
+              "grad = max(min(grad, clip_gradient), -clip_gradient).");
+    DMLC_DECLARE_FIELD(num_weights)
+    .set_default(1)
+    .describe("Number of updated weights.");
+  }
+};
+
+/*! \brief update of a weight element by Adam, from the gradient with weight decay */
+template<typename MPDType>
+struct MultiAdamRule {
+  static const int num_states = 2;  // mean, var
+  MPDType beta1;
+  MPDType beta2;
+  MPDType epsilon;
+
+  template<typename ParamType>
+  void Init(const ParamType &p) {
+    beta1 = p.beta1;
+    beta2 = p.beta2;
+    epsilon = p.epsilon;
+  }
+
+  MSHADOW_XINLINE MPDType Update(MPDType w, MPDType grad, MPDType lr,
+                                 MPDType *mean, MPDType *var) const {
+    *mean = beta1 * *mean + (1.f - beta1) * grad;
+    *var = beta2 * *var + (1.f - beta2) * grad * grad;
+    return w - lr * *mean / (mshadow_op::square_root::Map(*var) + epsilon);
+  }
+};
+
+/*! \brief update of a weight element by RMSProp (Tieleman & Hinton) */
+template<typename MPDType>
+struct MultiRMSPropRule {
+  static const int num_states = 1;  // n
+  MPDType rho;
+  MPDType epsilon;
+  MPDType clip_weights;
+
+  void Init(const MultiRMSPropParam &p) {
+    rho = p.rho;
+    epsilon = p.epsilon;
+    clip_weights = p.clip_weights;
+  }
+
+  MSHADOW_XINLINE MPDType Update(MPDType w, MPDType grad, MPDType lr,
+                                 MPDType *state_n, MPDType *) const {
+    *state_n = (1.f - rho) * mshadow_op::square::Map(grad) + rho * *state_n;
+    w -= lr * grad / (mshadow_op::square_root::Map(*state_n) + epsilon);
+    if (clip_weights >= 0.0f) {
+      w = mshadow_op::clip::Map(w, clip_weights);
+    }
+    return w;
+  }
+};
+
+/*! \brief update of a weight element by Nesterov momentum */
+template<typename MPDType>
+struct MultiNAGMomRule {
+  static const int num_states = 1;  // mom
+  MPDType momentum;
+
+  void Init(const MultiNAGMomParam &p) {
+    momentum = p.momentum;
+  }
+
+  MSHADOW_XINLINE MPDType Update(MPDType w, MPDType grad, MPDType lr,
+                                 MPDType *mom, MPDType *) const {
+    *mom = momentum * *mom - lr * grad;
+    return w + momentum * *mom - lr * grad;
+  }
+};
+
+/*!
+ * \brief Conversion of the state elements between the type they are stored in and the
+ *        type of the math of the update
+ */
+template<typename SType>
+struct MultiTensorState {
+  template<typename MPDType>
+  MSHADOW_XINLINE static MPDType Load(SType v) {
+    return static_cast<MPDType>(v);
+  }
+  template<typename MPDType>
+  MSHADOW_XINLINE static SType Store(MPDType v) {
+    return static_cast<SType>(v);
+  }
+};
+
+/*!
+ * \brief bfloat16 states keep the float32 math. The conversion of bf16_t truncates, which
+ *        would bias the moments towards zero at each step, so they are rounded to nearest
+ *        even instead.
+ */
+template<>
+struct MultiTensorState<mshadow::bfloat::bf16_t> {
+  template<typename MPDType>
+  MSHADOW_XINLINE static MPDType Load(mshadow::bfloat::bf16_t v) {
+    return MPDType(static_cast<float>(v));
+  }
+  template<typename MPDType>
+  MSHADOW_XINLINE static mshadow::bfloat::bf16_t Store(MPDType v) {
+    union {
+      float f;
+      uint32_t u;
+    } bits;
+    bits.f = static_cast<float>(v);
+    if ((bits.u & 0x7fffffffU) > 0x7f800000U) {
+      // NaN stays NaN, rounding could carry it into infinity
+      return mshadow::bfloat::bf16_t::Binary(static_cast<uint16_t>((bits.u >> 16) | 0x40U));
+    }
+    bits.u += 0x7fffU + ((bits.u >> 16) & 1U);
+    return mshadow::bfloat::bf16_t::Binary(static_cast<uint16_t>(bits.u >> 16));
+  }
+};
+
+/*!
+ * \brief Pointer lists of a multi-tensor update. The tensors of a launch are laid end to
+ *        end in one index space, and each thread finds its tensor from the offsets, so a
+ *        launch has one thread per element whatever the sizes of the tensors. Lists of
+ *        more than N tensors are updated by one launch per chunk of N tensors.
+ */
+template<typename DType, typename MPDType, typename SType, typename Rule>
+struct MultiTensorKernelParam {
+  // keeps the struct under the 4KB limit of the arguments of a CUDA kernel
+  static const int N = 48;
+  int count;
+  index_t offsets[N + 1];
+  DType *weights[N];
+  DType *grads[N];
+  SType *states[2][N];
+  MPDType *weights32[N];
+  DType *out_data[N];
+  MPDType lrs[N];
+  MPDType wds[N];
+  MPDType rescale_grad;
+  MPDType clip_gradient;
+  Rule rule;
+  // with preloaded hyperparameters, the float32 lists of all the tensors of the update on
+  // the device, of which the launch takes the tensors from begin on
+  const float *preloaded_lrs;
+  const float *preloaded_wds;
+  const float *preloaded_rescale_grad;
+  int begin;
+};
+
+/*! \brief index of the last of the count tensors starting at or before i */
+MSHADOW_XINLINE int MultiTensorIndex(index_t i, const index_t *offsets, int count) {
+  // the search skips the empty tensors, which start where the next one does
+  int t = 0;
+  int last = count - 1;
+  while (t < last) {
+    const int mid = (t + last + 1) / 2;
+    if (offsets[mid] <= i) {
+      t = mid;
+    } else {
+      last = mid - 1;
+    }
+  }
+  return t;
+}
+
+template<bool has_mixed_precision, bool preloaded = false>
+struct MultiTensorUpdateKernel {
+  template<typename DType, typename MPDType, typename SType, typename Rule>
+  MSHADOW_XINLINE static void Map(index_t i,
+                                  const MultiTensorKernelParam<DType, MPDType, SType, Rule> &param,
+                                  const OpReqType req) {
+    const int t = MultiTensorIndex(i, param.offsets, param.count);
+    const index_t j = i - param.offsets[t];
+    MPDType w = has_mixed_precision ? param.weights32[t][j] :
+                                      static_cast<MPDType>(param.weights[t][j]);
+    MPDType rescale_grad, lr, wd;
+    if (preloaded) {
+      const float scale = *param.preloaded_rescale_grad;
+      // a loss scaler skips the step of overflowing gradients with a scale of 0 or inf
+      if (!mshadow_op::isfinite::Map(scale) || scale == 0.0f) {
+        KERNEL_ASSIGN(param.out_data[t][j], req, w);
+        return;
+      }
+      rescale_grad = scale;
+      lr = param.preloaded_lrs[param.begin + t];
+      wd = param.preloaded_wds[param.begin + t];
+    } else {
+      rescale_grad = param.rescale_grad;
+      lr = param.lrs[t];
+      wd = param.wds[t];
+    }
+    MPDType grad = rescale_grad * static_cast<MPDType>(param.grads[t][j]);
+    if (param.clip_gradient >= 0.0f) {
+      grad = mshadow_op::clip::Map(grad, param.clip_gradient);
+    }
+    grad += wd * w;
+    MPDType state[2];
+    for (int n = 0; n < Rule::num_states; ++n) {
+      state[n] = MultiTensorState<SType>::template Load<MPDType>(param.states[n][t][j]);
+    }
+    w = param.rule.Update(w, grad, lr, &state[0], &state[1]);
+    for (int n = 0; n < Rule::num_states; ++n) {
+      param.states[n][t][j] = MultiTensorState<SType>::Store(state[n]);
+    }
+    if (has_mixed_precision) {
+      param.weights32[t][j] = w;
+    }
+    KERNEL_ASSIGN(param.out_data[t][j], req, w);
+  }
+};
+
+/*!
+ * \brief Fill the pointers of the count tensors from begin of a launch, and return their
+ *        number of elements.
+ */
+template<typename DType, typename MPDType, typename SType, typename Rule>
+inline index_t MultiTensorPointers(int begin,
+                                   const std::vector<TBlob> &inputs,
+                                   const std::vector<TBlob> &outputs,
+                                   MultiTensorKernelParam<DType, MPDType, SType, Rule> *param) {
+  constexpr bool has_mixed_precision = !std::is_same<DType, MPDType>::value;
+  constexpr int input_stride = 2 + Rule::num_states + (has_mixed_precision ? 1 : 0);
+  index_t total = 0;
+  for (int k = 0; k < param->count; ++k) {
+    const int i = begin + k;
+    const TBlob *in = &inputs[i * input_stride];
+    param->offsets[k] = total;
+    total += in[0].Size();
+    param->weights[k] = in[0].dptr<DType>();
+    param->grads[k] = in[1].dptr<DType>();
+    for (int n = 0; n < 2; ++n) {
+      param->states[n][k] = n < Rule::num_states ? in[2 + n].dptr<SType>() : nullptr;
+    }
+    param->weights32[k] = has_mixed_precision ? in[input_stride - 1].dptr<MPDType>() : nullptr;
+    param->out_data[k] = outputs[i].dptr<DType>();
+  }
+  param->offsets[param->count] = total;
+  return total;
+}
+
+/*! \brief launches of a multi-tensor update with the hyperparameters in its attributes */
+template<typename xpu, typename DType, typename MPDType, typename SType,
+         typename ParamType, typename Rule>
+inline void MultiTensorLaunch(std::false_type,
+                              const ParamType &p,
+                              mshadow::Stream<xpu> *s,
+                              const std::vector<TBlob> &inputs,
+                              const std::vector<OpReqType> &req,
+                              const std::vector<TBlob> &outputs) {
+  using namespace mxnet_op;
+  using KernelParam = MultiTensorKernelParam<DType, MPDType, SType, Rule>;
+  constexpr bool has_mixed_precision = !std::is_same<DType, MPDType>::value;
+  KernelParam param;
+  param.rescale_grad = p.rescale_grad;
+  param.clip_gradient = p.clip_gradient;
+  param.rule.Init(p);
+  param.preloaded_lrs = nullptr;
+  param.preloaded_wds = nullptr;
+  param.preloaded_rescale_grad = nullptr;
+  param.begin = 0;
+  for (int begin = 0; begin < p.num_weights; begin += KernelParam::N) {
+    param.count = std::min(p.num_weights - begin, KernelParam::N);
+    const index_t total = MultiTensorPointers(begin, inputs, outputs, &param);
+    for (int k = 0; k < param.count; ++k) {
+      param.lrs[k] = p.lrs[begin + k];
+      param.wds[k] = p.wds[begin + k];
+    }
+    if (total > 0) {
+      Kernel<MultiTensorUpdateKernel<has_mixed_precision>, xpu>::Launch(s, total, param, req[0]);
+    }
+  }
+}
+
+/*!
+ * \brief launches of a multi-tensor update with preloaded hyperparameters, the inputs after
+ *        those of the weights are the learning rates, the weight decays and the gradient scale
+ */
+template<typename xpu, typename DType, typename MPDType, typename SType,
+         typename ParamType, typename Rule>
+inline void MultiTensorLaunch(std::true_type,
+                              const ParamType &p,
+                              mshadow::Stream<xpu> *s,
+                              const std::vector<TBlob> &inputs,
+                              const std::vector<OpReqType> &req,
+                              const std::vector<TBlob> &outputs) {
+  using namespace mxnet_op;
+  using KernelParam = MultiTensorKernelParam<DType, MPDType, SType, Rule>;
+  constexpr bool has_mixed_precision = !std::is_same<DType, MPDType>::value;
+  constexpr int input_stride = 2 + Rule::num_states + (has_mixed_precision ? 1 : 0);
+  KernelParam param;
+  param.rescale_grad = 1.0f;
+  param.clip_gradient = p.clip_gradient;
+  param.rule.Init(p);
+  const TBlob *hyper = &inputs[input_stride * p.num_weights];
+  param.preloaded_lrs = hyper[0].dptr<float>();
+  param.preloaded_wds = hyper[1].dptr<float>();
+  param.preloaded_rescale_grad = hyper[2].dptr<float>();
+  for (int begin = 0; begin < p.num_weights; begin += KernelParam::N) {
+    param.count = std::min(p.num_weights - begin, KernelParam::N);
+    param.begin = begin;
+    const index_t total = MultiTensorPointers(begin, inputs, outputs, &param);
+    if (total > 0) {
+      Kernel<MultiTensorUpdateKernel<has_mixed_precision, true>, xpu>::Launch(s, total, param,
+                                                                              req[0]);
+    }
+  }
+}
+
+/*!
+ * \brief Update num_weights weights, the inputs of each one are the weight, the gradient,
+ *        the states of the rule and, with mixed precision, the float32 master weight.
+ *        The states are either of the type of the math of the update or all bfloat16.
+ *        A preloaded update reads its hyperparameters from 3 more inputs, see
+ *        PreloadedMultiTensorShape.
+ */
+template<typename xpu, template<typename> class MPTypeChooser,
+         typename ParamType, template<typename> class Rule, bool preloaded = false>
+inline void MultiTensorUpdate(const nnvm::NodeAttrs& attrs,
+                              const OpContext &ctx,
+                              const std::vector<TBlob> &inputs,
+                              const std::vector<OpReqType> &req,
+                              const std::vector<TBlob> &outputs) {
+  const ParamType& p = nnvm::get<ParamType>(attrs.parsed);
+  Stream<xpu>* s = ctx.get_stream<xpu>();
+  MSHADOW_REAL_TYPE_SWITCH(outputs[0].type_flag_, DType, {
+    using MPDType = typename MPTypeChooser<DType>::type;
+    constexpr bool has_mixed_precision = !std::is_same<DType, MPDType>::value;
+    constexpr int input_stride = 2 + Rule<MPDType>::num_states + (has_mixed_precision ? 1 : 0);
+    CHECK_EQ(inputs.size(), static_cast<size_t>(input_stride * p.num_weights +
+                                                (preloaded ? 3 : 0)));
+    const std::integral_constant<bool, preloaded> tag{};
+    if (inputs[2].type_flag_ == mshadow::kBfloat16) {
+      MultiTensorLaunch<xpu, DType, MPDType, mshadow::bfloat::bf16_t, ParamType,
+                        Rule<MPDType>>(tag, p, s, inputs, req, outputs);
+    } else {
+      CHECK_EQ(inputs[2].type_flag_, mshadow::DataType<MPDType>::kFlag)
+        << "The states must be bfloat16 or of the type of the update";
+      MultiTensorLaunch<xpu, DType, MPDType, MPDType, ParamType,
+                        Rule<MPDType>>(tag, p, s, inputs, req, outputs);
+    }
+  });
+}
+
+/*!
+ * \brief Types of the inputs of MultiTensorUpdate. The weight, the gradient and the output
+ *        share a type, the states have the type of the math of the update unless they are
+ *        all bfloat16, and the master weights and preloaded hyperparameters are float32.
+ */
+template<typename ParamType, int num_states, bool has_mixed_precision, bool preloaded = false>
+inline bool MultiTensorInferType(const nnvm::NodeAttrs& attrs,
+                                 std::vector<int> *in_attrs,
+                                 std::vector<int> *out_attrs) {
+  const ParamType& param = dmlc::get<ParamType>(attrs.parsed);
+  constexpr int input_stride = 2 + num_states + (has_mixed_precision ? 1 : 0);
+  CHECK_EQ(in_attrs->size(), input_stride * param.num_weights + (preloaded ? 3 : 0));
+  CHECK_EQ(out_attrs->size(), param.num_weights);
+  auto& input_types = *in_attrs;
+  auto& output_types = *out_attrs;
+  if (preloaded) {
+    for (int n = 0; n < 3; ++n) {
+      TYPE_ASSIGN_CHECK(input_types, input_stride * param.num_weights + n, mshadow::kFloat32);
+    }
+  }
+  bool bf16_states = false;
+  for (int i = 0; i < param.num_weights; ++i) {
+    for (int n = 0; n < num_states; ++n) {
+      bf16_states = bf16_states ||
+                    input_types[i * input_stride + 2 + n] == mshadow::kBfloat16;
+    }
+  }
+  bool all_inferred = true;
+  for (int i = 0; i < param.num_weights; ++i) {
+    const int w = i * input_stride;
+    int dtype = output_types[i];
+    for (int j = 0; j < 2; ++j) {
+      if (input_types[w + j] != -1) dtype = input_types[w + j];
+    }
+    if (has_mixed_precision) {
+      TYPE_ASSIGN_CHECK(input_types, w + input_stride - 1, mshadow::kFloat32);
+    }
+    if (dtype == -1) {
+      all_inferred = false;
+      continue;
+    }
+    TYPE_ASSIGN_CHECK(input_types, w, dtype);
+    TYPE_ASSIGN_CHECK(input_types, w + 1, dtype);
+    TYPE_ASSIGN_CHECK(output_types, i, dtype);
+    const int state_type = bf16_states ? mshadow::kBfloat16 :
+                           has_mixed_precision ? mshadow::kFloat32 : dtype;
+    for (int n = 0; n < num_states; ++n) {
+      TYPE_ASSIGN_CHECK(input_types, w + 2 + n, state_type);
+    }
+  }
+  return all_inferred;
+}
+
+/*!
+ * \brief Shapes of the inputs of a preloaded MultiTensorUpdate: the inputs of each weight,
+ *        then the num_weights learning rates, the num_weights weight decays and the scale
+ *        of the gradients.
+ */
+template<typename ParamType, int input_stride>
+inline bool PreloadedMultiTensorShape(const nnvm::NodeAttrs& attrs,
+                                      mxnet::ShapeVector *in_attrs,
+                                      mxnet::ShapeVector *out_attrs) {
+  const ParamType& param = dmlc::get<ParamType>(attrs.parsed);
+  CHECK_EQ(in_attrs->size(), input_stride * param.num_weights + 3);
+  CHECK_EQ(out_attrs->size(), param.num_weights);
+  const int hyper = input_stride * param.num_weights;
+  SHAPE_ASSIGN_CHECK(*in_attrs, hyper, mxnet::TShape(mshadow::Shape1(param.num_weights)));
+  SHAPE_ASSIGN_CHECK(*in_attrs, hyper + 1, mxnet::TShape(mshadow::Shape1(param.num_weights)));
+  SHAPE_ASSIGN_CHECK(*in_attrs, hyper + 2, mxnet::TShape(mshadow::Shape1(1)));
+  bool all_inferred = true;
+  auto& input_shapes = *in_attrs;
+  auto& output_shapes = *out_attrs;
+  for (int i = 0; i < param.num_weights; ++i) {
+    mxnet::ShapeVector input_vec;
+    mxnet::ShapeVector output_vec({output_shapes[i]});
+    for (int j = 0; j < input_stride; ++j) {
+      input_vec.push_back(input_shapes[i * input_stride + j]);
+    }
+    all_inferred = all_inferred && ElemwiseShape<input_stride, 1>(attrs, &input_vec, &output_vec);
+    for (int j = 0; j < input_stride; ++j) {
+      SHAPE_ASSIGN_CHECK(input_shapes, i * input_stride + j, input_vec[j]);
+    }
+    SHAPE_ASSIGN_CHECK(output_shapes, i, output_vec[0]);
+  }
+  return all_inferred;
+}
+
+struct MultiAdam8bitParam : public dmlc::Parameter<MultiAdam8bitParam> {
+  mxnet::Tuple<float> lrs;
+  mxnet::Tuple<float> wds;
+  float beta1;
+  float beta2;
+  float epsilon;
+  float rescale_grad;
+  float clip_gradient;
+  int block_size;
+  int num_weights;
+  DMLC_DECLARE_PARAMETER(MultiAdam8bitParam) {
+    DMLC_DECLARE_FIELD(lrs)
+    .describe("Learning rates, including the bias correction of each weight.");
+    DMLC_DECLARE_FIELD(wds)
+    .describe("Weight decay augments the objective function with a "
+              "regularization term that penalizes large weights. "
+              "The penalty scales with the square of the magnitude of each weight.");
+    DMLC_DECLARE_FIELD(beta1)
+    .set_default(0.9f)
+    .describe("The decay rate for the 1st moment estimates.");
+    DMLC_DECLARE_FIELD(beta2)
+    .set_default(0.999f)
+    .describe("The decay rate for the 2nd moment estimates.");
+    DMLC_DECLARE_FIELD(epsilon)
+    .set_default(1e-8f)
+    .describe("A small constant for numerical stability.");
+    DMLC_DECLARE_FIELD(rescale_grad)
+    .set_default(1.0f)
+    .describe("Rescale gradient to grad = rescale_grad*grad.");
+    DMLC_DECLARE_FIELD(clip_gradient)
+    .set_default(-1.0f)
+    .describe("Clip gradient to the range of [-clip_gradient, clip_gradient] "
+              "If clip_gradient <= 0, gradient clipping is turned off. "
+              "grad = max(min(grad, clip_gradient), -clip_gradient).");
+    DMLC_DECLARE_FIELD(block_size)
+    .set_default(256)
+    .set_lower_bound(1)
+    .describe("Number of consecutive elements of a state sharing one scale.");
+    DMLC_DECLARE_FIELD(num_weights)
+    .set_default(1)
+    .describe("Number of updated weights.");
+  }
+};
+
+namespace adam8bit {
+// inputs of each weight, followed by weight32 with mixed precision
+enum MultiAdam8bitInputs {kWeight, kGrad, kMean, kVar, kMeanAbsMax, kVarAbsMax, kNumInputs};
+}  // namespace adam8bit
+
+/*!
+ * \brief 8-bit codes of the block-wise quantized Adam states, relative to the largest
+ *        magnitude of their block. The codes are linear in the fourth root of the relative
+ *        magnitude, which keeps a few percents of precision on values down to 1e-6 of the
+ *        largest one, as the moments of the elements of a block spread over decades.
+ */
+struct BlockQuantize {
+  MSHADOW_XINLINE static float Root4(float x) {
+    return mshadow_op::square_root::Map(mshadow_op::square_root::Map(x));
+  }
+  MSHADOW_XINLINE static float Pow4(float x) {
+    return (x * x) * (x * x);
+  }
+  MSHADOW_XINLINE static int8_t EncodeSigned(float x, float absmax) {
+    if (absmax <= 0.f) return 0;
+    const int q = static_cast<int>(Root4(fminf(fabsf(x) / absmax, 1.f)) * 127.f + 0.5f);
+    return static_cast<int8_t>(x < 0.f ? -q : q);
+  }
+  MSHADOW_XINLINE static float DecodeSigned(int8_t q, float absmax) {
+    const float r = Pow4(q / 127.f) * absmax;
+    return q < 0 ? -r : r;
+  }
+  MSHADOW_XINLINE static uint8_t EncodeUnsigned(float x, float max) {
+    if (max <= 0.f) return 0;
+    return static_cast<uint8_t>(Root4(fminf(x / max, 1.f)) * 255.f + 0.5f);
+  }
+  MSHADOW_XINLINE static float DecodeUnsigned(uint8_t q, float max) {
+    return Pow4(q / 255.f) * max;
+  }
+};
+
+/*!
+ * \brief Pointer lists of a multi-tensor 8-bit Adam update. A thread updates a block of
+ *        block_size elements of a tensor, the blocks of the tensors of a launch are laid
+ *        end to end in one index space.
+ */
+template<typename DType>
+struct MultiAdam8bitKernelParam {
+  // keeps the struct under the 4KB limit of the arguments of a CUDA kernel
+  static const int N = 40;
+  int count;
+  index_t block_size;
+  index_t block_offsets[N + 1];
+  index_t sizes[N];
+  DType *weights[N];
+  DType *grads[N];
+  int8_t *means[N];
+  uint8_t *vars[N];
+  float *mean_absmax[N];
+  float *var_absmax[N];
+  float *weights32[N];
+  DType *out_data[N];
+  float lrs[N];
+  float wds[N];
+  float beta1;
+  float beta2;
+  float epsilon;
+  float rescale_grad;
+  float clip_gradient;
+};
+
+template<bool has_mixed_precision>
+struct MultiAdam8bitUpdateKernel {
+  /*! \brief weight and new moments of element j of tensor t, in float32 */
+  template<typename DType>
+  MSHADOW_XINLINE static void Moments(const MultiAdam8bitKernelParam<DType> &param,
+                                      int t, index_t j, float mean_absmax, float var_absmax,
+                                      float *w, float *mean, float *var) {
+    *w = has_mixed_precision ? param.weights32[t][j] : static_cast<float>(param.weights[t][j]);
+    float grad = param.rescale_grad * static_cast<float>(param.grads[t][j]);
+    if (param.clip_gradient >= 0.0f) {
+      grad = mshadow_op::clip::Map(grad, param.clip_gradient);
+    }
+    grad += param.wds[t] * *w;
+    const float old_mean = BlockQuantize::DecodeSigned(param.means[t][j], mean_absmax);
+    const float old_root = BlockQuantize::DecodeUnsigned(param.vars[t][j], var_absmax);
+    *mean = param.beta1 * old_mean + (1.f - param.beta1) * grad;
+    *var = param.beta2 * old_root * old_root + (1.f - param.beta2) * grad * grad;
+  }
+
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(index_t i, const MultiAdam8bitKernelParam<DType> &param,
+                                  const OpReqType req) {
+    const int t = MultiTensorIndex(i, param.block_offsets, param.count);
+    const index_t block = i - param.block_offsets[t];
+    const index_t begin = block * param.block_size;
+    const index_t end = begin + param.block_size < param.sizes[t] ?
+                        begin + param.block_size : param.sizes[t];
+    const float mean_absmax = param.mean_absmax[t][block];
+    const float var_absmax = param.var_absmax[t][block];
+    float w, mean, var;
+    // the codes need the scales of the new moments, so the moments are computed once for
+    // the scales and once for the update
+    float new_mean_absmax = 0.f;
+    float new_var_absmax = 0.f;
+    for (index_t j = begin; j < end; ++j) {
+      Moments(param, t, j, mean_absmax, var_absmax, &w, &mean, &var);
+      new_mean_absmax = fmaxf(new_mean_absmax, fabsf(mean));
+      new_var_absmax = fmaxf(new_var_absmax, mshadow_op::square_root::Map(var));
+    }
+    for (index_t j = begin; j < end; ++j) {
+      Moments(param, t, j, mean_absmax, var_absmax, &w, &mean, &var);
+      const float root = mshadow_op::square_root::Map(var);
+      w -= param.lrs[t] * mean / (root + param.epsilon);
+      param.means[t][j] = BlockQuantize::EncodeSigned(mean, new_mean_absmax);
+      param.vars[t][j] = BlockQuantize::EncodeUnsigned(root, new_var_absmax);
+      if (has_mixed_precision) {
+        param.weights32[t][j] = w;
+      }
+      KERNEL_ASSIGN(param.out_data[t][j], req, w);
+    }
+    param.mean_absmax[t][block] = new_mean_absmax;
+    param.var_absmax[t][block] = new_var_absmax;
+  }
+};
+
+/*!
+ * \brief Adam update of num_weights weights whose moments are stored in 8 bits, with one
+ *        float32 scale per block of block_size elements. The math is in float32.
+ */
+template<typename xpu, bool has_mixed_precision>
+inline void MultiAdam8bitUpdate(const nnvm::NodeAttrs& attrs,
+                                const OpContext &ctx,
+                                const std::vector<TBlob> &inputs,
+                                const std::vector<OpReqType> &req,
+                                const std::vector<TBlob> &outputs) {
+  using namespace mxnet_op;
+  using namespace adam8bit;
+  const MultiAdam8bitParam& p = nnvm::get<MultiAdam8bitParam>(attrs.parsed);
+  Stream<xpu>* s = ctx.get_stream<xpu>();
+  constexpr int input_stride = kNumInputs + (has_mixed_precision ? 1 : 0);
+  CHECK_EQ(inputs.size(), static_cast<size_t>(input_stride * p.num_weights));
+  MSHADOW_REAL_TYPE_SWITCH(outputs[0].type_flag_, DType, {
+    using KernelParam = MultiAdam8bitKernelParam<DType>;
+    KernelParam param;
+    param.block_size = p.block_size;
+    param.beta1 = p.beta1;
+    param.beta2 = p.beta2;
+    param.epsilon = p.epsilon;
+    param.rescale_grad = p.rescale_grad;
+    param.clip_gradient = p.clip_gradient;
+    for (int begin = 0; begin < p.num_weights; begin += KernelParam::N) {
+      param.count = std::min(p.num_weights - begin, KernelParam::N);
+      index_t total = 0;
+      for (int k = 0; k < param.count; ++k) {
+        const int i = begin + k;
+        const TBlob *in = &inputs[i * input_stride];
+        param.block_offsets[k] = total;
+        param.sizes[k] = in[kWeight].Size();
+        total += (param.sizes[k] + param.block_size - 1) / param.block_size;
+        param.weights[k] = in[kWeight].dptr<DType>();
+        param.grads[k] = in[kGrad].dptr<DType>();
+        param.means[k] = in[kMean].dptr<int8_t>();
+        param.vars[k] = in[kVar].dptr<uint8_t>();
+        param.mean_absmax[k] = in[kMeanAbsMax].dptr<float>();
+        param.var_absmax[k] = in[kVarAbsMax].dptr<float>();
+        param.weights32[k] = has_mixed_precision ? in[kNumInputs].dptr<float>() : nullptr;
+        param.out_data[k] = outputs[i].dptr<DType>();
+        param.lrs[k] = p.lrs[i];
+        param.wds[k] = p.wds[i];
+      }
+      param.block_offsets[param.count] = total;
+      if (total > 0) {
+        Kernel<MultiAdam8bitUpdateKernel<has_mixed_precision>, xpu>::Launch(s, total, param,
+                                                                            req[0]);
+      }
+    }
+  });
+}
+
+template<bool has_mixed_precision>
+inline bool MultiAdam8bitShape(const nnvm::NodeAttrs& attrs,
+                               mxnet::ShapeVector *in_attrs,
+                               mxnet::ShapeVector *out_attrs) {
+  using namespace adam8bit;
+  const MultiAdam8bitParam& param = dmlc::get<MultiAdam8bitParam>(attrs.parsed);
+  constexpr int input_stride = kNumInputs + (has_mixed_precision ? 1 : 0);
+  CHECK_EQ(in_attrs->size(), input_stride * param.num_weights);
+  CHECK_EQ(out_attrs->size(), param.num_weights);
+  CHECK_EQ(param.lrs.ndim(), param.num_weights)
+    << "Number of learning rates is inconsistent with num_weights";
+  CHECK_EQ(param.wds.ndim(), param.num_weights)
+    << "Number of weight decays is inconsistent with num_weights";
+  // the inputs with the shape of the weight
+  std::vector<int> elemwise_inputs{kWeight, kGrad, kMean, kVar};
+  if (has_mixed_precision) elemwise_inputs.push_back(kNumInputs);
+  bool all_inferred = true;
+  for (int i = 0; i < param.num_weights; ++i) {
+    mxnet::TShape shape = (*out_attrs)[i];
+    for (int j : elemwise_inputs) {
+      shape_assign(&shape, (*in_attrs)[i * input_stride + j]);
+    }
+    if (!mxnet::shape_is_known(shape)) {
+      all_inferred = false;
+      continue;
+    }
+    for (int j : elemwise_inputs) {
+      SHAPE_ASSIGN_CHECK(*in_attrs, i * input_stride + j, shape);
+    }
+    SHAPE_ASSIGN_CHECK(*out_attrs, i, shape);
+    const index_t num_blocks = (shape.Size() + param.block_size - 1) / param.block_size;
+    SHAPE_ASSIGN_CHECK(*in_attrs, i * input_stride + kMeanAbsMax, mshadow::Shape1(num_blocks));
+    SHAPE_ASSIGN_CHECK(*in_attrs, i * input_stride + kVarAbsMax, mshadow::Shape1(num_blocks));
+  }
+  return all_inferred;
+}
+
+template<bool has_mixed_precision>
+inline bool MultiAdam8bitInferType(const nnvm::NodeAttrs& attrs,
+                                   std::vector<int> *in_attrs,
+                                   std::vector<int> *out_attrs) {
+  using namespace adam8bit;
+  const MultiAdam8bitParam& param = dmlc::get<MultiAdam8bitParam>(attrs.parsed);
+  constexpr int input_stride = kNumInputs + (has_mixed_precision ? 1 : 0);
+  CHECK_EQ(in_attrs->size(), input_stride * param.num_weights);
+  CHECK_EQ(out_attrs->size(), param.num_weights);
+  auto& input_types = *in_attrs;
+  auto& output_types = *out_attrs;
+  bool all_inferred = true;
+  for (int i = 0; i < param.num_weights; ++i) {
+    const int w = i * input_stride;
+    TYPE_ASSIGN_CHECK(input_types, w + kMean, mshadow::kInt8);
+    TYPE_ASSIGN_CHECK(input_types, w + kVar, mshadow::kUint8);
+    TYPE_ASSIGN_CHECK(input_types, w + kMeanAbsMax, mshadow::kFloat32);
+    TYPE_ASSIGN_CHECK(input_types, w + kVarAbsMax, mshadow::kFloat32);
+    if (has_mixed_precision) {
+      TYPE_ASSIGN_CHECK(input_types, w + kNumInputs, mshadow::kFloat32);
+    }
+    int dtype = output_types[i];
+    for (int j : {kWeight, kGrad}) {
+      if (input_types[w + j] != -1) dtype = input_types[w + j];
+    }
+    if (dtype == -1) {
+      all_inferred = false;
+      continue;
+    }
+    TYPE_ASSIGN_CHECK(input_types, w + kWeight, dtype);
+    TYPE_ASSIGN_CHECK(input_types, w + kGrad, dtype);
+    TYPE_ASSIGN_CHECK(output_types, i, dtype);
+  }
+  return all_inferred;
+}
+
 struct FtrlParam : public dmlc::Parameter<FtrlParam> {
   float lr;
   float lamda1;
@@ -39,6 +39,11 @@ DMLC_REGISTER_PARAMETER(NAGParam);
 DMLC_REGISTER_PARAMETER(NAGMomParam);
 DMLC_REGISTER_PARAMETER(RMSPropParam);
 DMLC_REGISTER_PARAMETER(RMSPropAlexParam);
+DMLC_REGISTER_PARAMETER(MultiAdamParam);
+DMLC_REGISTER_PARAMETER(MultiRMSPropParam);
+DMLC_REGISTER_PARAMETER(MultiNAGMomParam);
+DMLC_REGISTER_PARAMETER(PreloadedMultiAdamParam);
+DMLC_REGISTER_PARAMETER(MultiAdam8bitParam);
 DMLC_REGISTER_PARAMETER(FtrlParam);
 DMLC_REGISTER_PARAMETER(SignSGDParam);
 DMLC_REGISTER_PARAMETER(SignumParam);
@@ -842,6 +847,354 @@ to be 0.9 and the learning rate :math:`\eta` to be 0.0001.
 .add_argument("delta", "NDArray-or-Symbol", "delta")
 .add_arguments(RMSPropAlexParam::__FIELDS__());
 
+/*!
+ * \brief Input names of a multi-tensor update, the names of the inputs of one weight
+ *        suffixed by the index of the weight.
+ */
+template<typename ParamType>
+static std::vector<std::string> MultiTensorInputNames(const NodeAttrs& attrs,
+                                                      const std::vector<std::string>& names) {
+  const int num_weights = dmlc::get<ParamType>(attrs.parsed).num_weights;
+  std::vector<std::string> ret;
+  for (int i = 0; i < num_weights; ++i) {
+    for (const auto& name : names) {
+      ret.push_back(name + "_" + std::to_string(i));
+    }
+  }
+  return ret;
+}
+
+/*!
+ * \brief The states and master weights of a multi-tensor update, all the inputs of each
+ *        weight but the weight and the gradient.
+ */
+template<typename ParamType, int input_stride>
+static std::vector<uint32_t> MultiTensorMutateInputs(const NodeAttrs& attrs) {
+  const int num_weights = dmlc::get<ParamType>(attrs.parsed).num_weights;
+  std::vector<uint32_t> ret;
+  for (int i = 0; i < num_weights; ++i) {
+    for (int j = 2; j < input_stride; ++j) {
+      ret.push_back(i * input_stride + j);
+    }
+  }
+  return ret;
+}
+
+template<typename ParamType, int input_stride>
+static uint32_t MultiTensorNumInputs(const NodeAttrs& attrs) {
+  return static_cast<uint32_t>(dmlc::get<ParamType>(attrs.parsed).num_weights * input_stride);
+}
+
+template<typename ParamType>
+static uint32_t MultiTensorNumOutputs(const NodeAttrs& attrs) {
+  return static_cast<uint32_t>(dmlc::get<ParamType>(attrs.parsed).num_weights);
+}
+
+NNVM_REGISTER_OP(multi_adam_update)
+.describe(R"code(Update function for Adam optimizer, applied to num_weights weights in
+a single kernel.
+
+It updates each weight using::
+
+  rescaled_grad = clip(grad * rescale_grad, clip_gradient) + wd * weight
+  m = beta1 * m + (1 - beta1) * rescaled_grad
+  v = beta2 * v + (1 - beta2) * (rescaled_grad**2)
+  w = w - learning_rate * m / (sqrt(v) + epsilon)
+
+with the learning rate and weight decay of the weight in ``lrs`` and ``wds``. The bias
+correction of Adam is part of the learning rates.
+
+The states can be stored in bfloat16, for half of the memory of float32 states. The math
+of the update stays in the type of the weight, and the new states are rounded to nearest.
+
+)code" ADD_FILELINE)
+.set_num_inputs(MultiTensorNumInputs<MultiAdamParam, 4>)
+.set_num_outputs(MultiTensorNumOutputs<MultiAdamParam>)
+.set_attr_parser(ParamParser<MultiAdamParam>)
+.set_attr<mxnet::FInferShape>("FInferShape", MultiSGDShape<MultiAdamParam, 4>)
+.set_attr<nnvm::FInferType>("FInferType", MultiTensorInferType<MultiAdamParam, 2, false>)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    return MultiTensorInputNames<MultiAdamParam>(attrs, {"weight", "grad", "mean", "var"});
+  })
+.set_attr<nnvm::FMutateInputs>("FMutateInputs", MultiTensorMutateInputs<MultiAdamParam, 4>)
+.set_attr<FCompute>("FCompute<cpu>",
+                    MultiTensorUpdate<cpu, type_identity, MultiAdamParam, MultiAdamRule>)
+.add_argument("data", "NDArray-or-Symbol[]", "Weights, gradients, means and variances")
+.add_arguments(MultiAdamParam::__FIELDS__());
+
+NNVM_REGISTER_OP(multi_mp_adam_update)
+.describe(R"code(Update function for multi-precision Adam optimizer, applied to num_weights
+weights in a single kernel.
+
+It updates the float32 master copy of each weight like ``multi_adam_update`` and writes it
+to the weight.
+
+)code" ADD_FILELINE)
+.set_num_inputs(MultiTensorNumInputs<MultiAdamParam, 5>)
+.set_num_outputs(MultiTensorNumOutputs<MultiAdamParam>)
+.set_attr_parser(ParamParser<MultiAdamParam>)
+.set_attr<mxnet::FInferShape>("FInferShape", MultiSGDShape<MultiAdamParam, 5>)
+.set_attr<nnvm::FInferType>("FInferType", MultiTensorInferType<MultiAdamParam, 2, true>)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    return MultiTensorInputNames<MultiAdamParam>(attrs,
+                                                 {"weight", "grad", "mean", "var", "weight32"});
+  })
+.set_attr<nnvm::FMutateInputs>("FMutateInputs", MultiTensorMutateInputs<MultiAdamParam, 5>)
+.set_attr<FCompute>("FCompute<cpu>",
+                    MultiTensorUpdate<cpu, single_precision, MultiAdamParam, MultiAdamRule>)
+.add_argument("data", "NDArray-or-Symbol[]",
+              "Weights, gradients, means, variances and float32 weights")
+.add_arguments(MultiAdamParam::__FIELDS__());
+
+/*!
+ * \brief Input names of a preloaded multi-tensor update, followed by its hyperparameters.
+ */
+template<typename ParamType>
+static std::vector<std::string> PreloadedMultiTensorInputNames(
+    const NodeAttrs& attrs, const std::vector<std::string>& names) {
+  std::vector<std::string> ret = MultiTensorInputNames<ParamType>(attrs, names);
+  ret.emplace_back("lrs");
+  ret.emplace_back("wds");
+  ret.emplace_back("rescale_grad");
+  return ret;
+}
+
+template<typename ParamType, int input_stride>
+static uint32_t PreloadedMultiTensorNumInputs(const NodeAttrs& attrs) {
+  return MultiTensorNumInputs<ParamType, input_stride>(attrs) + 3;
+}
+
+NNVM_REGISTER_OP(preloaded_multi_adam_update)
+.describe(R"code(Update function for Adam optimizer like ``multi_adam_update``, with the
+learning rates, the weight decays and the gradient scale in float32 arrays.
+
+The last three inputs are the ``num_weights`` learning rates, including the bias correction
+of Adam, the ``num_weights`` weight decays, and ``rescale_grad`` of shape (1,). The kernel
+reads them on the device, so that a learning rate schedule or a loss scaler changes them
+in place without changing the attributes of the operator, and a cached graph of the whole
+training step stays valid. A ``rescale_grad`` of 0, inf or nan skips the update, leaving
+the weights and the states as they are, which skips the step of overflowing gradients
+without waiting for the device.
+
+)code" ADD_FILELINE)
+.set_num_inputs(PreloadedMultiTensorNumInputs<PreloadedMultiAdamParam, 4>)
+.set_num_outputs(MultiTensorNumOutputs<PreloadedMultiAdamParam>)
+.set_attr_parser(ParamParser<PreloadedMultiAdamParam>)
+.set_attr<mxnet::FInferShape>("FInferShape",
+                              PreloadedMultiTensorShape<PreloadedMultiAdamParam, 4>)
+.set_attr<nnvm::FInferType>("FInferType",
+                            MultiTensorInferType<PreloadedMultiAdamParam, 2, false, true>)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    return PreloadedMultiTensorInputNames<PreloadedMultiAdamParam>(
+        attrs, {"weight", "grad", "mean", "var"});
+  })
+.set_attr<nnvm::FMutateInputs>("FMutateInputs",
+                               MultiTensorMutateInputs<PreloadedMultiAdamParam, 4>)
+.set_attr<FCompute>("FCompute<cpu>",
+                    MultiTensorUpdate<cpu, type_identity, PreloadedMultiAdamParam,
+                                      MultiAdamRule, true>)
+.add_argument("data", "NDArray-or-Symbol[]",
+              "Weights, gradients, means and variances, learning rates, weight decays and "
+              "gradient scale")
+.add_arguments(PreloadedMultiAdamParam::__FIELDS__());
+
+NNVM_REGISTER_OP(preloaded_multi_mp_adam_update)
+.describe(R"code(Update function for multi-precision Adam optimizer like
+``multi_mp_adam_update``, with the learning rates, the weight decays and the gradient scale
+in float32 arrays, see ``preloaded_multi_adam_update``.
+
+)code" ADD_FILELINE)
+.set_num_inputs(PreloadedMultiTensorNumInputs<PreloadedMultiAdamParam, 5>)
+.set_num_outputs(MultiTensorNumOutputs<PreloadedMultiAdamParam>)
+.set_attr_parser(ParamParser<PreloadedMultiAdamParam>)
+.set_attr<mxnet::FInferShape>("FInferShape",
+                              PreloadedMultiTensorShape<PreloadedMultiAdamParam, 5>)
+.set_attr<nnvm::FInferType>("FInferType",
+                            MultiTensorInferType<PreloadedMultiAdamParam, 2, true, true>)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    return PreloadedMultiTensorInputNames<PreloadedMultiAdamParam>(
+        attrs, {"weight", "grad", "mean", "var", "weight32"});
+  })
+.set_attr<nnvm::FMutateInputs>("FMutateInputs",
+                               MultiTensorMutateInputs<PreloadedMultiAdamParam, 5>)
+.set_attr<FCompute>("FCompute<cpu>",
+                    MultiTensorUpdate<cpu, single_precision, PreloadedMultiAdamParam,
+                                      MultiAdamRule, true>)
+.add_argument("data", "NDArray-or-Symbol[]",
+              "Weights, gradients, means, variances and float32 weights, learning rates, "
+              "weight decays and gradient scale")
+.add_arguments(PreloadedMultiAdamParam::__FIELDS__());
+
+NNVM_REGISTER_OP(multi_rmsprop_update)
+.describe(R"code(Update function for RMSProp optimizer, applied to num_weights weights in
+a single kernel.
+
+It updates each weight using::
+
+  rescaled_grad = clip(grad * rescale_grad, clip_gradient) + wd * weight
+  n = rho * n + (1 - rho) * (rescaled_grad**2)
+  w = clip(w - learning_rate * rescaled_grad / (sqrt(n) + epsilon), clip_weights)
+
+with the learning rate and weight decay of the weight in ``lrs`` and ``wds``. The states
+can be stored in bfloat16, as with ``multi_adam_update``.
+
+)code" ADD_FILELINE)
+.set_num_inputs(MultiTensorNumInputs<MultiRMSPropParam, 3>)
+.set_num_outputs(MultiTensorNumOutputs<MultiRMSPropParam>)
+.set_attr_parser(ParamParser<MultiRMSPropParam>)
+.set_attr<mxnet::FInferShape>("FInferShape", MultiSGDShape<MultiRMSPropParam, 3>)
+.set_attr<nnvm::FInferType>("FInferType",
+                            MultiTensorInferType<MultiRMSPropParam, 1, false>)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    return MultiTensorInputNames<MultiRMSPropParam>(attrs, {"weight", "grad", "n"});
+  })
+.set_attr<nnvm::FMutateInputs>("FMutateInputs", MultiTensorMutateInputs<MultiRMSPropParam, 3>)
+.set_attr<FCompute>("FCompute<cpu>",
+                    MultiTensorUpdate<cpu, type_identity, MultiRMSPropParam, MultiRMSPropRule>)
+.add_argument("data", "NDArray-or-Symbol[]", "Weights, gradients and n")
+.add_arguments(MultiRMSPropParam::__FIELDS__());
+
+NNVM_REGISTER_OP(multi_mp_rmsprop_update)
+.describe(R"code(Update function for multi-precision RMSProp optimizer, applied to
+num_weights weights in a single kernel.
+
+It updates the float32 master copy of each weight like ``multi_rmsprop_update`` and writes
+it to the weight.
+
+)code" ADD_FILELINE)
+.set_num_inputs(MultiTensorNumInputs<MultiRMSPropParam, 4>)
+.set_num_outputs(MultiTensorNumOutputs<MultiRMSPropParam>)
+.set_attr_parser(ParamParser<MultiRMSPropParam>)
+.set_attr<mxnet::FInferShape>("FInferShape", MultiSGDShape<MultiRMSPropParam, 4>)
+.set_attr<nnvm::FInferType>("FInferType",
+                            MultiTensorInferType<MultiRMSPropParam, 1, true>)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    return MultiTensorInputNames<MultiRMSPropParam>(attrs, {"weight", "grad", "n", "weight32"});
+  })
+.set_attr<nnvm::FMutateInputs>("FMutateInputs", MultiTensorMutateInputs<MultiRMSPropParam, 4>)
+.set_attr<FCompute>("FCompute<cpu>",
+                    MultiTensorUpdate<cpu, single_precision, MultiRMSPropParam, MultiRMSPropRule>)
+.add_argument("data", "NDArray-or-Symbol[]", "Weights, gradients, n and float32 weights")
+.add_arguments(MultiRMSPropParam::__FIELDS__());
+
+NNVM_REGISTER_OP(multi_nag_mom_update)
+.describe(R"code(Update function for Nesterov Accelerated Gradient (NAG) optimizer, applied
+to num_weights weights in a single kernel.
+
+It updates each weight using::
+
+  rescaled_grad = clip(grad * rescale_grad, clip_gradient) + wd * weight
+  mom = momentum * mom - learning_rate * rescaled_grad
+  w = w + momentum * mom - learning_rate * rescaled_grad
+
+with the learning rate and weight decay of the weight in ``lrs`` and ``wds``. The states
+can be stored in bfloat16, as with ``multi_adam_update``.
+
+)code" ADD_FILELINE)
+.set_num_inputs(MultiTensorNumInputs<MultiNAGMomParam, 3>)
+.set_num_outputs(MultiTensorNumOutputs<MultiNAGMomParam>)
+.set_attr_parser(ParamParser<MultiNAGMomParam>)
+.set_attr<mxnet::FInferShape>("FInferShape", MultiSGDShape<MultiNAGMomParam, 3>)
+.set_attr<nnvm::FInferType>("FInferType",
+                            MultiTensorInferType<MultiNAGMomParam, 1, false>)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    return MultiTensorInputNames<MultiNAGMomParam>(attrs, {"weight", "grad", "mom"});
+  })
+.set_attr<nnvm::FMutateInputs>("FMutateInputs", MultiTensorMutateInputs<MultiNAGMomParam, 3>)
+.set_attr<FCompute>("FCompute<cpu>",
+                    MultiTensorUpdate<cpu, type_identity, MultiNAGMomParam, MultiNAGMomRule>)
+.add_argument("data", "NDArray-or-Symbol[]", "Weights, gradients and momentum")
+.add_arguments(MultiNAGMomParam::__FIELDS__());
+
+NNVM_REGISTER_OP(multi_mp_nag_mom_update)
+.describe(R"code(Update function for multi-precision Nesterov Accelerated Gradient (NAG)
+optimizer, applied to num_weights weights in a single kernel.
+
+It updates the float32 master copy of each weight like ``multi_nag_mom_update`` and writes
+it to the weight.
+
+)code" ADD_FILELINE)
+.set_num_inputs(MultiTensorNumInputs<MultiNAGMomParam, 4>)
+.set_num_outputs(MultiTensorNumOutputs<MultiNAGMomParam>)
+.set_attr_parser(ParamParser<MultiNAGMomParam>)
+.set_attr<mxnet::FInferShape>("FInferShape", MultiSGDShape<MultiNAGMomParam, 4>)
+.set_attr<nnvm::FInferType>("FInferType",
+                            MultiTensorInferType<MultiNAGMomParam, 1, true>)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    return MultiTensorInputNames<MultiNAGMomParam>(attrs, {"weight", "grad", "mom", "weight32"});
+  })
+.set_attr<nnvm::FMutateInputs>("FMutateInputs", MultiTensorMutateInputs<MultiNAGMomParam, 4>)
+.set_attr<FCompute>("FCompute<cpu>",
+                    MultiTensorUpdate<cpu, single_precision, MultiNAGMomParam, MultiNAGMomRule>)
+.add_argument("data", "NDArray-or-Symbol[]", "Weights, gradients, momentum and float32 weights")
+.add_arguments(MultiNAGMomParam::__FIELDS__());
+
+NNVM_REGISTER_OP(multi_adam_8bit_update)
+.describe(R"code(Update function for Adam optimizer with 8-bit states, applied to num_weights
+weights in a single kernel.
+
+It updates each weight like ``multi_adam_update``, with the math in float32. The mean is
+stored as int8 and the square root of the variance as uint8, each with one float32 scale,
+the largest magnitude, per block of ``block_size`` consecutive elements. The codes are
+linear in the fourth root of the magnitude relative to the scale of the block, so that the
+values much smaller than the scale keep their precision. The states take a quarter of the
+memory of float32 states.
+
+The scales of a state of n elements have ceil(n / block_size) elements and start at zero
+along with the codes.
+
+)code" ADD_FILELINE)
+.set_num_inputs(MultiTensorNumInputs<MultiAdam8bitParam, adam8bit::kNumInputs>)
+.set_num_outputs(MultiTensorNumOutputs<MultiAdam8bitParam>)
+.set_attr_parser(ParamParser<MultiAdam8bitParam>)
+.set_attr<mxnet::FInferShape>("FInferShape", MultiAdam8bitShape<false>)
+.set_attr<nnvm::FInferType>("FInferType", MultiAdam8bitInferType<false>)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    return MultiTensorInputNames<MultiAdam8bitParam>(attrs,
+        {"weight", "grad", "mean", "var", "mean_absmax", "var_absmax"});
+  })
+.set_attr<nnvm::FMutateInputs>("FMutateInputs",
+                               MultiTensorMutateInputs<MultiAdam8bitParam, adam8bit::kNumInputs>)
+.set_attr<FCompute>("FCompute<cpu>", MultiAdam8bitUpdate<cpu, false>)
+.add_argument("data", "NDArray-or-Symbol[]",
+              "Weights, gradients, quantized means and variances and their scales")
+.add_arguments(MultiAdam8bitParam::__FIELDS__());
+
+NNVM_REGISTER_OP(multi_mp_adam_8bit_update)
+.describe(R"code(Update function for multi-precision Adam optimizer with 8-bit states, applied
+to num_weights weights in a single kernel.
+
+It updates the float32 master copy of each weight like ``multi_adam_8bit_update`` and writes
+it to the weight.
+
+)code" ADD_FILELINE)
+.set_num_inputs(MultiTensorNumInputs<MultiAdam8bitParam, adam8bit::kNumInputs + 1>)
+.set_num_outputs(MultiTensorNumOutputs<MultiAdam8bitParam>)
+.set_attr_parser(ParamParser<MultiAdam8bitParam>)
+.set_attr<mxnet::FInferShape>("FInferShape", MultiAdam8bitShape<true>)
+.set_attr<nnvm::FInferType>("FInferType", MultiAdam8bitInferType<true>)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    return MultiTensorInputNames<MultiAdam8bitParam>(attrs,
+        {"weight", "grad", "mean", "var", "mean_absmax", "var_absmax", "weight32"});
+  })
+.set_attr<nnvm::FMutateInputs>("FMutateInputs",
+    MultiTensorMutateInputs<MultiAdam8bitParam, adam8bit::kNumInputs + 1>)
+.set_attr<FCompute>("FCompute<cpu>", MultiAdam8bitUpdate<cpu, true>)
+.add_argument("data", "NDArray-or-Symbol[]",
+              "Weights, gradients, quantized means and variances, their scales "
+              "and float32 weights")
+.add_arguments(MultiAdam8bitParam::__FIELDS__());
+
 NNVM_REGISTER_OP(ftrl_update)
 MXNET_ADD_SPARSE_OP_ALIAS(ftrl_update)
 .describe(R"code(Update function for Ftrl optimizer.
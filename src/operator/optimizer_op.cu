@@ -249,6 +249,37 @@ NNVM_REGISTER_OP(multi_mp_sgd_update)
 NNVM_REGISTER_OP(multi_mp_sgd_mom_update)
 .set_attr<FCompute>("FCompute<gpu>", MultiSGDMomUpdate<gpu, single_precision, 4>);
 
+NNVM_REGISTER_OP(multi_adam_update)
+.set_attr<FCompute>("FCompute<gpu>",
+                    MultiTensorUpdate<gpu, type_identity, MultiAdamParam, MultiAdamRule>);
+NNVM_REGISTER_OP(multi_mp_adam_update)
+.set_attr<FCompute>("FCompute<gpu>",
+                    MultiTensorUpdate<gpu, single_precision, MultiAdamParam, MultiAdamRule>);
+NNVM_REGISTER_OP(preloaded_multi_adam_update)
+.set_attr<FCompute>("FCompute<gpu>",
+                    MultiTensorUpdate<gpu, type_identity, PreloadedMultiAdamParam,
+                                      MultiAdamRule, true>);
+NNVM_REGISTER_OP(preloaded_multi_mp_adam_update)
+.set_attr<FCompute>("FCompute<gpu>",
+                    MultiTensorUpdate<gpu, single_precision, PreloadedMultiAdamParam,
+                                      MultiAdamRule, true>);
+NNVM_REGISTER_OP(multi_rmsprop_update)
+.set_attr<FCompute>("FCompute<gpu>",
+                    MultiTensorUpdate<gpu, type_identity, MultiRMSPropParam, MultiRMSPropRule>);
+NNVM_REGISTER_OP(multi_mp_rmsprop_update)
+.set_attr<FCompute>("FCompute<gpu>",
+                    MultiTensorUpdate<gpu, single_precision, MultiRMSPropParam, MultiRMSPropRule>);
+NNVM_REGISTER_OP(multi_nag_mom_update)
+.set_attr<FCompute>("FCompute<gpu>",
+                    MultiTensorUpdate<gpu, type_identity, MultiNAGMomParam, MultiNAGMomRule>);
+NNVM_REGISTER_OP(multi_mp_nag_mom_update)
+.set_attr<FCompute>("FCompute<gpu>",
+                    MultiTensorUpdate<gpu, single_precision, MultiNAGMomParam, MultiNAGMomRule>);
+NNVM_REGISTER_OP(multi_adam_8bit_update)
+.set_attr<FCompute>("FCompute<gpu>", MultiAdam8bitUpdate<gpu, false>);
+NNVM_REGISTER_OP(multi_mp_adam_8bit_update)
+.set_attr<FCompute>("FCompute<gpu>", MultiAdam8bitUpdate<gpu, true>);
+
 NNVM_REGISTER_OP(nag_mom_update)
 .set_attr<FCompute>("FCompute<gpu>", NAGMomUpdate<gpu>);
 
@@ -43,6 +43,28 @@ struct CalibrateEntropyParam : public dmlc::Parameter<CalibrateEntropyParam> {
   }
 };
 
+struct CalibratePercentileParam : public dmlc::Parameter<CalibratePercentileParam> {
+  float percentile;
+  DMLC_DECLARE_PARAMETER(CalibratePercentileParam) {
+    DMLC_DECLARE_FIELD(percentile)
+      .set_default(99.99f)
+      .set_range(0.0f, 100.0f)
+      .describe(
+          "The percentage of the histogram mass the threshold keeps within [-threshold, "
+          "threshold].");
+  }
+};
+
+struct CalibrateMSEParam : public dmlc::Parameter<CalibrateMSEParam> {
+  int num_quantized_bins;
+  DMLC_DECLARE_PARAMETER(CalibrateMSEParam) {
+    DMLC_DECLARE_FIELD(num_quantized_bins)
+      .set_default(255)
+      .describe(
+          "The number of quantized bins.");
+  }
+};
+
 }  // namespace op
 }  // namespace mxnet
 #endif  // MXNET_OPERATOR_QUANTIZATION_CALIBRATE_INL_H_
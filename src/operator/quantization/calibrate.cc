@@ -23,6 +23,9 @@
  * \brief
  */
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <numeric>
 #include "./calibrate-inl.h"
 
@@ -30,6 +33,8 @@ namespace mxnet {
 namespace op {
 
 DMLC_REGISTER_PARAMETER(CalibrateEntropyParam);
+DMLC_REGISTER_PARAMETER(CalibratePercentileParam);
+DMLC_REGISTER_PARAMETER(CalibrateMSEParam);
 
 // Given a discrete distribution (may have not been normalized to 1),
 // smooth it by replacing zeros with eps multiplied by a scaling factor and taking the
@@ -170,23 +175,89 @@ void CalibrateComputeCPU(const nnvm::NodeAttrs& attrs, const OpContext& ctx,
   *out_threshold = thresholds[min_divergence_idx];
 }
 
+// The histograms are symmetric around the bin zero_bin_idx = num_bins / 2, and the
+// candidate thresholds are the edges hist_edges[zero_bin_idx + i + 1] keeping the 2 * i + 1
+// bins around it, as for the entropy calibration.
+void CalibratePercentileComputeCPU(const nnvm::NodeAttrs& attrs, const OpContext& ctx,
+                                   const std::vector<TBlob>& inputs,
+                                   const std::vector<OpReqType>& req,
+                                   const std::vector<TBlob>& outputs) {
+  const auto& param = nnvm::get<CalibratePercentileParam>(attrs.parsed);
+  const float* const hist_ptr = inputs[0].dptr<float>();
+  const float* const hist_edges_ptr = inputs[1].dptr<float>();
+  const auto num_bins = inputs[0].Size();
+  CHECK_EQ(num_bins + 1, inputs[1].Size());
+  const int zero_bin_idx = num_bins / 2;
+  const double total = std::accumulate(hist_ptr, hist_ptr + num_bins, 0.0);
+  const double wanted = total * param.percentile / 100.0;
+
+  double kept = hist_ptr[zero_bin_idx];
+  int i = 0;
+  while (kept < wanted && i < zero_bin_idx) {
+    ++i;
+    kept += hist_ptr[zero_bin_idx - i];
+    if (zero_bin_idx + i < static_cast<int>(num_bins)) kept += hist_ptr[zero_bin_idx + i];
+  }
+  *outputs[0].dptr<float>() = hist_edges_ptr[std::min<size_t>(zero_bin_idx + i + 1, num_bins)];
+}
+
+void CalibrateMSEComputeCPU(const nnvm::NodeAttrs& attrs, const OpContext& ctx,
+                            const std::vector<TBlob>& inputs, const std::vector<OpReqType>& req,
+                            const std::vector<TBlob>& outputs) {
+  const auto& param = nnvm::get<CalibrateMSEParam>(attrs.parsed);
+  const float* const hist_ptr = inputs[0].dptr<float>();
+  const float* const hist_edges_ptr = inputs[1].dptr<float>();
+  const auto num_bins = inputs[0].Size();
+  CHECK_EQ(num_bins + 1, inputs[1].Size());
+  const int zero_bin_idx = num_bins / 2;
+  const int num_half_quantized_bins = param.num_quantized_bins / 2;
+  CHECK_GT(num_half_quantized_bins, 0);
+  std::vector<float> thresholds(std::max(zero_bin_idx + 1 - num_half_quantized_bins, 1), 0.f);
+  std::vector<double> errors(thresholds.size(), std::numeric_limits<double>::infinity());
+  #pragma omp parallel for num_threads(engine::OpenMP::Get()->GetRecommendedOMPThreadCount())
+  for (index_t i = 0; i < static_cast<index_t>(thresholds.size()); i++) {
+    const int edge_idx = std::min<int>(zero_bin_idx + num_half_quantized_bins + i + 1, num_bins);
+    const float threshold = hist_edges_ptr[edge_idx];
+    thresholds[i] = threshold;
+    if (!(threshold > 0.f)) continue;
+    // the error of quantizing the bin centers to int with the scale of the threshold,
+    // saturating at the threshold as FloatToQuantized does
+    const float scale = num_half_quantized_bins / threshold;
+    double error = 0;
+    for (size_t j = 0; j < num_bins; j++) {
+      if (!hist_ptr[j]) continue;
+      const float x = 0.5f * (hist_edges_ptr[j] + hist_edges_ptr[j + 1]);
+      const float level = std::min(std::floor(std::abs(x) * scale + 0.5f),
+                                   static_cast<float>(num_half_quantized_bins));
+      const double diff = std::abs(x) - level / scale;
+      error += hist_ptr[j] * diff * diff;
+    }
+    errors[i] = error;
+  }
+
+  const auto min_it = std::min_element(errors.begin(), errors.end());
+  const double total = std::accumulate(hist_ptr, hist_ptr + num_bins, 0.0);
+  *outputs[0].dptr<float>() = thresholds[min_it - errors.begin()];
+  *outputs[1].dptr<float>() = total > 0 ? *min_it / total : 0.f;
+}
+
 static inline bool CalibrateShape(const nnvm::NodeAttrs& attrs, std::vector<TShape>* in_attrs,
                                   std::vector<TShape>* out_attrs) {
   CHECK_EQ(in_attrs->size(), 2U);
-  CHECK_EQ(out_attrs->size(), 2U);
-  SHAPE_ASSIGN_CHECK(*out_attrs, 0, TShape(1, 1));
-  SHAPE_ASSIGN_CHECK(*out_attrs, 1, TShape(1, 1));
+  for (size_t i = 0; i < out_attrs->size(); ++i) {
+    SHAPE_ASSIGN_CHECK(*out_attrs, i, TShape(1, 1));
+  }
   return (!shape_is_none(in_attrs->at(0))) && (!shape_is_none(in_attrs->at(1)));
 }
 
 static inline bool CalibrateType(const nnvm::NodeAttrs& attrs, std::vector<int>* in_attrs,
                                  std::vector<int>* out_attrs) {
   CHECK_EQ(in_attrs->size(), 2U);
-  CHECK_EQ(out_attrs->size(), 2U);
   CHECK(in_attrs->at(0) == mshadow::kFloat32);
   TYPE_ASSIGN_CHECK(*in_attrs, 1, mshadow::kFloat32);
-  TYPE_ASSIGN_CHECK(*out_attrs, 0, mshadow::kFloat32);
-  TYPE_ASSIGN_CHECK(*out_attrs, 1, mshadow::kFloat32);
+  for (size_t i = 0; i < out_attrs->size(); ++i) {
+    TYPE_ASSIGN_CHECK(*out_attrs, i, mshadow::kFloat32);
+  }
   return true;
 }
 
@@ -211,5 +282,51 @@ NNVM_REGISTER_OP(_contrib_calibrate_entropy)
 .add_argument("hist_edges", "NDArray-or-Symbol", "A ndarray/symbol of type `float32`")
 .add_arguments(CalibrateEntropyParam::__FIELDS__());
 
+NNVM_REGISTER_OP(_contrib_calibrate_percentile)
+.describe(R"code(Provide the calibrated threshold of an input histogram as the smallest
+symmetric range around zero holding `percentile` percent of the histogram mass, which makes
+the quantization range ignore rare outliers.
+
+.. Note::
+    This operator only supports forward propagation. DO NOT use it in training.)code" ADD_FILELINE)
+.set_attr_parser(ParamParser<CalibratePercentileParam>)
+.set_num_inputs(2)
+.set_num_outputs(1)
+.set_attr<nnvm::FListInputNames>("FListInputNames", [](const NodeAttrs& attrs) {
+  return std::vector<std::string>{"hist", "hist_edges"};
+})
+.set_attr<nnvm::FListOutputNames>("FListOutputNames", [](const NodeAttrs& attrs) {
+  return std::vector<std::string>{"threshold"};
+})
+.set_attr<mxnet::FInferShape>("FInferShape", CalibrateShape)
+.set_attr<nnvm::FInferType>("FInferType", CalibrateType)
+.set_attr<FCompute>("FCompute<cpu>", CalibratePercentileComputeCPU)
+.add_argument("hist", "NDArray-or-Symbol", "A ndarray/symbol of type `float32`")
+.add_argument("hist_edges", "NDArray-or-Symbol", "A ndarray/symbol of type `float32`")
+.add_arguments(CalibratePercentileParam::__FIELDS__());
+
+NNVM_REGISTER_OP(_contrib_calibrate_mse)
+.describe(R"code(Provide the calibrated threshold of an input histogram minimizing the mean
+squared error between the values and their int8 quantization, clipping included, and that
+error per value.
+
+.. Note::
+    This operator only supports forward propagation. DO NOT use it in training.)code" ADD_FILELINE)
+.set_attr_parser(ParamParser<CalibrateMSEParam>)
+.set_num_inputs(2)
+.set_num_outputs(2)
+.set_attr<nnvm::FListInputNames>("FListInputNames", [](const NodeAttrs& attrs) {
+  return std::vector<std::string>{"hist", "hist_edges"};
+})
+.set_attr<nnvm::FListOutputNames>("FListOutputNames", [](const NodeAttrs& attrs) {
+  return std::vector<std::string>{"threshold", "mse"};
+})
+.set_attr<mxnet::FInferShape>("FInferShape", CalibrateShape)
+.set_attr<nnvm::FInferType>("FInferType", CalibrateType)
+.set_attr<FCompute>("FCompute<cpu>", CalibrateMSEComputeCPU)
+.add_argument("hist", "NDArray-or-Symbol", "A ndarray/symbol of type `float32`")
+.add_argument("hist_edges", "NDArray-or-Symbol", "A ndarray/symbol of type `float32`")
+.add_arguments(CalibrateMSEParam::__FIELDS__());
+
 }  // namespace op
 }  // namespace mxnet
@@ -0,0 +1,118 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file fuse_requantize_pass.cc
+ * \brief Fold calibrated _contrib_requantize nodes into the quantized op producing their input
+ *
+ *  The pass is applied through optimize_for with the name FuseRequantize, after the
+ *  calibration table is set. A requantize is folded when its producer takes the calibrated
+ *  range of its output, the producer outputs only feed the requantize and it requantizes to
+ *  int8. The producer then writes int8 into the calibrated range directly, which saves the
+ *  int32 output and a pass over it; this is the device independent counterpart of the
+ *  requantize fusion of the MKLDNN post quantization subgraph property.
+ */
+
+#include <mxnet/base.h>
+#include <mxnet/ndarray.h>
+#include <nnvm/graph.h>
+#include <nnvm/pass.h>
+
+#include <map>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "./requantize-inl.h"
+
+namespace mxnet {
+namespace op {
+
+namespace {
+
+using nnvm::Node;
+using nnvm::NodeEntry;
+using nnvm::ObjectPtr;
+using EntryKey = std::pair<const Node*, uint32_t>;
+
+/*! \brief quantized ops writing int8 into min_calib_range and max_calib_range when set */
+bool TakesOutputCalibRange(const Node* n) {
+  static const std::unordered_set<const nnvm::Op*> ops{
+    nnvm::Op::Get("_contrib_quantized_elemwise_add"),
+  };
+  return !n->is_variable() && ops.count(n->op());
+}
+
+/*! \brief Turn requantize into its producer if the producer can take the calibrated range. */
+void TryFuse(Node* requantize, const std::map<EntryKey, int>& uses) {
+  const auto& param = nnvm::get<RequantizeParam>(requantize->attrs.parsed);
+  if (!param.min_calib_range.has_value() || !param.max_calib_range.has_value() ||
+      GetQuantizeOutputType(param) != mshadow::kInt8)
+    return;
+  const Node* producer = requantize->inputs[0].node.get();
+  if (!TakesOutputCalibRange(producer) || producer->num_outputs() != 3U)
+    return;
+  for (uint32_t i = 0; i < 3U; ++i) {
+    const NodeEntry& e = requantize->inputs[i];
+    auto it = uses.find({producer, i});
+    if (e.node.get() != producer || e.index != i || it == uses.end() || it->second != 1)
+      return;
+  }
+
+  nnvm::NodeAttrs attrs = producer->attrs;
+  attrs.dict["min_calib_range"] = requantize->attrs.dict.at("min_calib_range");
+  attrs.dict["max_calib_range"] = requantize->attrs.dict.at("max_calib_range");
+  attrs.op->attr_parser(&attrs);
+  std::vector<NodeEntry> inputs = producer->inputs;
+  // the requantize node becomes the producer, so that its consumers need no rewiring
+  requantize->attrs = std::move(attrs);
+  requantize->inputs = std::move(inputs);
+}
+
+}  // namespace
+
+nnvm::Graph FuseRequantize(nnvm::Graph&& g) {
+  static const nnvm::Op* requantize_op = nnvm::Op::Get("_contrib_requantize");
+  std::map<EntryKey, int> uses;
+  std::vector<ObjectPtr> requantizes;
+  DFSVisit(g.outputs, [&](const ObjectPtr& n) {
+    for (const auto& e : n->inputs) ++uses[{e.node.get(), e.index}];
+    if (n->op() == requantize_op) requantizes.push_back(n);
+  });
+  for (const auto& e : g.outputs) ++uses[{e.node.get(), e.index}];
+  for (const ObjectPtr& requantize : requantizes) TryFuse(requantize.get(), uses);
+
+  nnvm::Graph ret;
+  ret.outputs = g.outputs;
+  ret.attrs["new_args"] = std::make_shared<nnvm::any>(std::vector<NDArray*>());
+  ret.attrs["new_arg_names"] = std::make_shared<nnvm::any>(std::vector<std::string>());
+  ret.attrs["new_aux"] = std::make_shared<nnvm::any>(std::vector<NDArray*>());
+  ret.attrs["new_aux_names"] = std::make_shared<nnvm::any>(std::vector<std::string>());
+  return ret;
+}
+
+NNVM_REGISTER_PASS(FuseRequantize)
+.describe("Fold calibrated _contrib_requantize nodes into the quantized ops producing them.")
+.set_body(FuseRequantize)
+.set_change_graph(true)
+.depend_graph_attr("options_map");
+
+}  // namespace op
+}  // namespace mxnet
@@ -32,8 +32,6 @@
 namespace mxnet {
 namespace op {
 
-DMLC_REGISTER_PARAMETER(QuantizeElemwiseAddParam);
-
 static inline float GetScale(const NDArray& data, float min, float max) {
   auto data_range = (data.dtype() == mshadow::kInt8) ? kInt8Range : kUint8Range;
   return data_range / MaxAbs(min, max);
@@ -65,11 +63,11 @@ static MKLDNNQuantizedElemwiseAddFwd &GetQuantizedElemwiseAddForward(
     const std::vector<NDArray> &in_data, const std::vector<NDArray> &out_data,
     const std::vector<mkldnn::memory::desc> &data_md) {
 #if DMLC_CXX11_THREAD_LOCAL
-  static thread_local std::unordered_map<OpSignature,
-              MKLDNNQuantizedElemwiseAddFwd, OpHash> fwds;
+  static thread_local MKLDNNPrimitiveCache<OpSignature,
+                MKLDNNQuantizedElemwiseAddFwd, OpHash> fwds;
 #else
-  static MX_THREAD_LOCAL std::unordered_map<OpSignature,
-              MKLDNNQuantizedElemwiseAddFwd, OpHash> fwds;
+  static MX_THREAD_LOCAL MKLDNNPrimitiveCache<OpSignature,
+                MKLDNNQuantizedElemwiseAddFwd, OpHash> fwds;
 #endif
   OpSignature key;
   key.AddSign(in_data);
@@ -249,9 +247,7 @@ inline static bool ElemwiseAddStorageType(const nnvm::NodeAttrs& attrs, const in
 NNVM_REGISTER_OP(_contrib_quantized_elemwise_add)
 .set_attr<FInferStorageType>("FInferStorageType", ElemwiseAddStorageType)
 .set_attr<FComputeEx>("FComputeEx<cpu>", MKLDNNQuantizedElemwiseAddForward)
-.set_attr<bool>("TIsMKLDNN", true)
-.set_attr_parser(ParamParser<QuantizeElemwiseAddParam>)
-.add_arguments(QuantizeElemwiseAddParam::__FIELDS__());
+.set_attr<bool>("TIsMKLDNN", true);
 }  // namespace op
 }  // namespace mxnet
 
@@ -173,6 +173,53 @@ struct QuantizationRangeForS8U8MultiplicationStruct {
   }
 };
 
+/*!
+ * \brief Range of the int32 product of int8 data and int8 weights quantized per output
+ *        channel, given by the largest weight range so that no channel overflows.
+ */
+struct QuantizationRangeForS8S8ChannelWiseMultiplicationStruct {
+  MSHADOW_XINLINE static void Map(int i,
+                                  float *min_c,
+                                  float *max_c,
+                                  const float *min_a,
+                                  const float *max_a,
+                                  const float *min_b,
+                                  const float *max_b,
+                                  const index_t num_channels) {
+    float max_abs_b = 0.f;
+    for (index_t c = 0; c < num_channels; ++c) {
+      max_abs_b = Max(max_abs_b, MaxAbs(min_b[c], max_b[c]));
+    }
+    QuantizationRangeForMultiplication<int8_t, int8_t, int32_t>(
+      *min_a, *max_a, -max_abs_b, max_abs_b, min_c, max_c, true);
+  }
+};
+
+/*!
+ * \brief Rescale the int32 product of int8 data and int8 weights quantized per output
+ *        channel into the common output range [min_c, max_c]. The channel of element i is
+ *        (i / inner) % num_channels.
+ */
+struct QuantizedChannelWiseRescaleStruct {
+  MSHADOW_XINLINE static void Map(int i,
+                                  int32_t *out,
+                                  const float *min_a,
+                                  const float *max_a,
+                                  const float *min_b,
+                                  const float *max_b,
+                                  const float *min_c,
+                                  const float *max_c,
+                                  const index_t inner,
+                                  const index_t num_channels) {
+    const index_t c = (i / inner) % num_channels;
+    const float scale = FloatForOneQuantizedLevel<int8_t>(*min_a, *max_a, true) *
+                        FloatForOneQuantizedLevel<int8_t>(min_b[c], max_b[c], true) /
+                        FloatForOneQuantizedLevel<int32_t>(*min_c, *max_c, true);
+    const float value = out[i] * scale;
+    out[i] = static_cast<int32_t>(value + (value < 0.f ? -0.5f : 0.5f));
+  }
+};
+
 template<typename xpu, typename DType>
 inline size_t ConfigReduce(mshadow::Stream<xpu>* s,
                            const mxnet::TShape& data_shape,
@@ -274,10 +274,12 @@ Graph QuantizeGraph(Graph &&src) {
   const auto quantize_granularity = src.GetAttr<std::string>("quantize_granularity");
   const auto dev_type = src.GetAttr<int>("target_ctx");
 
-  if (dev_type == Context::kGPU && quantize_granularity == "channel-wise") {
-    LOG(FATAL) << "`channel-wise` quantization option is not supported yet by GPU,"
-               << " please set quantize_granularity to `tensor-wise` when quantizing model.";
-  }
+  // on GPU, channel-wise quantization gives one range per output channel to the weights of
+  // the quantized convolution and fully connected ops, which MKLDNN handles in its subgraphs
+  static const std::unordered_set<const nnvm::Op*> channel_wise_ops{
+    Op::Get("_contrib_quantized_conv"), Op::Get("_contrib_quantized_fully_connected")};
+  const bool channel_wise_weights =
+      dev_type == Context::kGPU && quantize_granularity == "channel-wise";
 
   std::unordered_map<ObjectPtr, ObjectPtr> quantized_node_map;
   MarkQuantizedNodes(src, &quantized_node_map);
@@ -335,6 +337,9 @@ Graph QuantizeGraph(Graph &&src) {
             ObjectPtr quantize_node = InsertNode("_contrib_quantize_v2",
               e.node->attrs.name + suffix + "_quantize", new_node, mirror_entry);
             quantize_node->attrs.dict["out_type"] = quantized_dtype;
+            if (channel_wise_weights && i == 1 && channel_wise_ops.count(new_node->op())) {
+              quantize_node->attrs.dict["channel_wise_quantize"] = "True";
+            }
             quantize_node->op()->attr_parser(&(quantize_node->attrs));
             mirror_entry_map[e] = NodeEntry{quantize_node, 0, e.version};
           }
@@ -41,6 +41,7 @@ struct QuantizeV2Param : public dmlc::Parameter<QuantizeV2Param> {
   int out_type;
   dmlc::optional<float> min_calib_range;
   dmlc::optional<float> max_calib_range;
+  bool channel_wise_quantize;
   DMLC_DECLARE_PARAMETER(QuantizeV2Param) {
     DMLC_DECLARE_FIELD(out_type)
       .add_enum("auto", QuantizeOutType::kAuto)
@@ -57,6 +58,12 @@ struct QuantizeV2Param : public dmlc::Parameter<QuantizeV2Param> {
       .set_default(dmlc::optional<float>())
       .describe("The maximum scalar value in the form of float32. If present, it will be used to "
                 "quantize the fp32 data into int8 or uint8.");
+    DMLC_DECLARE_FIELD(channel_wise_quantize)
+      .set_default(false)
+      .describe("Whether to quantize each slice along the first axis, such as the output "
+                "channels of weights, into int8 with the range of the slice collected at "
+                "runtime. The min and max outputs then hold one value per slice and the "
+                "calibrated ranges are ignored.");
   }
 };
 
@@ -104,15 +111,42 @@ struct quantize_v2_zero_centered {
   }
 };
 
+// keep zero-center, with one range per slice of inner elements along the first axis
+struct quantize_v2_channel_wise {
+  template <typename DstDType, typename SrcDType>
+  MSHADOW_XINLINE static void Map(int i, DstDType *out, float *omin_range, float *omax_range,
+                                  const SrcDType *in, const float *imin_range,
+                                  const float *imax_range, const index_t inner,
+                                  const float quantized_range) {
+    const index_t c = i / inner;
+    const float real_range = MaxAbs(imin_range[c], imax_range[c]);
+    // a slice of zeros, e.g. a pruned filter, stays zero
+    const float scale = real_range > 0.f ? quantized_range / real_range : 0.f;
+    SrcDType x = in[i];
+    out[i] = static_cast<DstDType>(Sign(x) * Min(Abs(x) * scale + 0.5f, quantized_range));
+    if (i % inner == 0) {
+      omin_range[c] = -real_range;
+      omax_range[c] = real_range;
+    }
+  }
+};
+
 static inline bool QuantizeV2Shape(const nnvm::NodeAttrs &attrs, std::vector<TShape> *in_attrs,
                                    std::vector<TShape> *out_attrs) {
   CHECK_EQ(in_attrs->size(), 1U);
   CHECK_EQ(out_attrs->size(), 3U);
 
+  const QuantizeV2Param &param = nnvm::get<QuantizeV2Param>(attrs.parsed);
   mxnet::TShape dshape = (*in_attrs)[0];
   SHAPE_ASSIGN_CHECK(*out_attrs, 0, in_attrs->at(0));
-  SHAPE_ASSIGN_CHECK(*out_attrs, 1, TShape(1, 1));
-  SHAPE_ASSIGN_CHECK(*out_attrs, 2, TShape(1, 1));
+  if (!param.channel_wise_quantize) {
+    SHAPE_ASSIGN_CHECK(*out_attrs, 1, TShape(1, 1));
+    SHAPE_ASSIGN_CHECK(*out_attrs, 2, TShape(1, 1));
+  } else if (mxnet::ndim_is_known(dshape) && dshape.ndim() > 0 &&
+             mxnet::dim_size_is_known(dshape, 0)) {
+    SHAPE_ASSIGN_CHECK(*out_attrs, 1, TShape(1, dshape[0]));
+    SHAPE_ASSIGN_CHECK(*out_attrs, 2, TShape(1, dshape[0]));
+  }
 
   if ((*out_attrs)[0].ndim() > 0) {
     dshape[0] = ((*out_attrs)[0])[0];
@@ -176,6 +210,8 @@ class QuantizeV2Operator {
         }
       }
       UnaryOp::IdentityCompute<xpu>(attrs_, ctx, {inputs[0]}, req, outputs);
+    } else if (param.channel_wise_quantize) {
+      ChannelWiseForward(ctx, inputs, outputs);
     } else {
       if (param.min_calib_range.has_value() && param.max_calib_range.has_value()) {
         if (out_type == mshadow::kUint8) {
@@ -227,6 +263,44 @@ class QuantizeV2Operator {
   }
 
  private:
+  void ChannelWiseForward(const OpContext &ctx, const std::vector<TBlob> &inputs,
+                          const std::vector<TBlob> &outputs) {
+    using namespace mshadow;
+    using namespace mxnet_op;
+    typedef float SrcDType;
+    using mshadow::red::limits::MaxValue;
+    using mshadow::red::limits::MinValue;
+    Stream<xpu> *s = ctx.get_stream<xpu>();
+    const QuantizeV2Param &param = nnvm::get<QuantizeV2Param>(attrs_.parsed);
+    CHECK_EQ(GetQuantizeOutputType(param), mshadow::kInt8)
+        << "channel-wise quantization only supports int8 as output type";
+    const TBlob &data = inputs[0];
+    if (data.Size() == 0) return;
+    const index_t channels = data.shape_[0];
+    const index_t inner = data.Size() / channels;
+    // reduce each channel of the data seen as (channels, inner)
+    mxnet::TShape src_shape, dst_shape;
+    const size_t temp_reduce_size = ConfigReduce<xpu, SrcDType>(
+        s, Shape2(channels, inner), Shape2(channels, 1), &src_shape, &dst_shape);
+    Tensor<xpu, 1, char> temp_space = ctx.requested[0].get_space_typed<xpu, 1, char>(
+        Shape1(2 * channels * sizeof(float) + temp_reduce_size), s);
+    const int dev_id = ctx.run_ctx.ctx.dev_id;
+    TBlob in_min_t(reinterpret_cast<SrcDType *>(temp_space.dptr_), Shape1(channels),
+                   xpu::kDevMask, dev_id);
+    TBlob in_max_t(reinterpret_cast<SrcDType *>(temp_space.dptr_) + channels, Shape1(channels),
+                   xpu::kDevMask, dev_id);
+    Tensor<xpu, 1, char> workspace(temp_space.dptr_ + 2 * channels * sizeof(float),
+                                   Shape1(temp_reduce_size), s);
+    broadcast::Reduce<red::minimum, 2, SrcDType, mshadow::op::identity>(
+        s, in_min_t.reshape(dst_shape), kWriteTo, workspace, data.reshape(src_shape));
+    broadcast::Reduce<red::maximum, 2, SrcDType, mshadow::op::identity>(
+        s, in_max_t.reshape(dst_shape), kWriteTo, workspace, data.reshape(src_shape));
+    Kernel<quantize_v2_channel_wise, xpu>::Launch(
+        s, outputs[0].Size(), outputs[0].dptr<int8_t>(), outputs[1].dptr<float>(),
+        outputs[2].dptr<float>(), data.dptr<SrcDType>(), in_min_t.dptr<float>(),
+        in_max_t.dptr<float>(), inner, MinAbs(MaxValue<int8_t>(), MinValue<int8_t>()));
+  }
+
   nnvm::NodeAttrs attrs_;
 };
 
@@ -37,7 +37,8 @@ static bool QuantizeV2StorageType(const nnvm::NodeAttrs& attrs, const int dev_ma
                                   std::vector<int>* out_attrs) {
   *dispatch_mode = DispatchMode::kFCompute;
 #if MXNET_USE_MKLDNN == 1
-  if (dev_mask == mshadow::cpu::kDevMask) {
+  const QuantizeV2Param &param = nnvm::get<QuantizeV2Param>(attrs.parsed);
+  if (dev_mask == mshadow::cpu::kDevMask && !param.channel_wise_quantize) {
     *dispatch_mode = DispatchMode::kFComputeEx;
   }
 #endif
@@ -55,7 +56,11 @@ static OpStatePtr CreateQuantizeV2State(const nnvm::NodeAttrs& attrs, Context ct
     state = OpStatePtr::Create<QuantizeV2Operator<gpu>>(attrs);
   } else {
 #if MXNET_USE_MKLDNN == 1
-    state = OpStatePtr::Create<SgMKLDNNQuantizeOperator>(attrs);
+    if (nnvm::get<QuantizeV2Param>(attrs.parsed).channel_wise_quantize) {
+      state = OpStatePtr::Create<QuantizeV2Operator<cpu>>(attrs);
+    } else {
+      state = OpStatePtr::Create<SgMKLDNNQuantizeOperator>(attrs);
+    }
 #else
     state = OpStatePtr::Create<QuantizeV2Operator<cpu>>(attrs);
 #endif
@@ -68,6 +73,7 @@ NNVM_REGISTER_OP(_contrib_quantize_v2)
 with user-specified `min_calib_range` and `max_calib_range` or the input range collected at runtime.
 
 Output `min_range` and `max_range` are scalar floats that specify the range for the input data.
+With `channel_wise_quantize`, they hold the int8 range of each slice along the first axis instead.
 
 When out_type is `uint8`, the output is calculated using the following equation:
 
@@ -119,7 +125,8 @@ If min_calib_range isn't presented, the output type will be int8.
 })
 .set_attr<FResourceRequest>("FResourceRequest", [](const NodeAttrs& attrs) {
   const QuantizeV2Param &param = nnvm::get<QuantizeV2Param>(attrs.parsed);
-  if (param.min_calib_range.has_value() && param.max_calib_range.has_value()) {
+  if (param.min_calib_range.has_value() && param.max_calib_range.has_value() &&
+      !param.channel_wise_quantize) {
     return std::vector<ResourceRequest>();
   } else {
     return std::vector<ResourceRequest>(1, ResourceRequest::kTempSpace);
@@ -0,0 +1,67 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file quantized_activation.cu
+ * \brief GPU implementation of quantized relu for int8 data
+ */
+#include <mxnet/op_attr_types.h>
+#include <vector>
+#include "../nn/activation-inl.h"
+#include "../mxnet_op.h"
+
+namespace mxnet {
+namespace op {
+
+// relu keeps zero, so the output keeps the scale and the range of the input
+struct quantized_relu {
+  MSHADOW_XINLINE static void Map(int i, int8_t *out, float *omin_range, float *omax_range,
+                                  const int8_t *in, const float *imin_range,
+                                  const float *imax_range) {
+    out[i] = in[i] > 0 ? in[i] : 0;
+    if (i == 0) {
+      *omin_range = *imin_range;
+      *omax_range = *imax_range;
+    }
+  }
+};
+
+void QuantizedActivationForwardGPU(const nnvm::NodeAttrs& attrs,
+                                   const OpContext& ctx,
+                                   const std::vector<TBlob>& inputs,
+                                   const std::vector<OpReqType>& req,
+                                   const std::vector<TBlob>& outputs) {
+  CHECK_EQ(inputs.size(), 3U);
+  CHECK_EQ(outputs.size(), 3U);
+  CHECK_EQ(req[0], kWriteTo) << "_contrib_quantized_act only supports kWriteTo";
+  CHECK_EQ(nnvm::get<ActivationParam>(attrs.parsed).act_type, activation::kReLU)
+      << "_contrib_quantized_act only supports act_type=relu for now";
+  CHECK_EQ(inputs[0].type_flag_, mshadow::kInt8)
+      << "_contrib_quantized_act only supports int8 input on GPU";
+  mshadow::Stream<gpu> *s = ctx.get_stream<gpu>();
+  mxnet_op::Kernel<quantized_relu, gpu>::Launch(s, outputs[0].Size(),
+    outputs[0].dptr<int8_t>(), outputs[1].dptr<float>(), outputs[2].dptr<float>(),
+    inputs[0].dptr<int8_t>(), inputs[1].dptr<float>(), inputs[2].dptr<float>());
+}
+
+NNVM_REGISTER_OP(_contrib_quantized_act)
+.set_attr<FCompute>("FCompute<gpu>", QuantizedActivationForwardGPU);
+
+}  // namespace op
+}  // namespace mxnet
@@ -0,0 +1,89 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file quantized_batch_norm.cu
+ * \brief GPU implementation of quantized batch norm for int8 data
+ *
+ *  As with MKLDNN, the moving statistics are folded into a scale and a shift per channel
+ *  and the output is quantized into the calibrated output range.
+ */
+#include <vector>
+#include "../nn/batch_norm-inl.h"
+#include "./quantization_utils.h"
+
+namespace mxnet {
+namespace op {
+
+// inner is the size of the axes after the channel axis
+struct quantized_batch_norm {
+  MSHADOW_XINLINE static void Map(int i, int8_t *out, float *omin_range, float *omax_range,
+                                  const int8_t *in, const float *gamma, const float *beta,
+                                  const float *mean, const float *var,
+                                  const float *imin_range, const float *imax_range,
+                                  const index_t inner, const index_t channels, const float eps,
+                                  const bool fix_gamma, const float calib_min,
+                                  const float calib_max) {
+    const index_t c = (i / inner) % channels;
+    const float scale = (fix_gamma ? 1.0f : gamma[c]) * rsqrtf(var[c] + eps);
+    const float x = QuantizedToFloat<int8_t>(in[i], *imin_range, *imax_range);
+    out[i] = FloatToQuantized<int8_t>((x - mean[c]) * scale + beta[c], calib_min, calib_max);
+    if (i == 0) {
+      *omin_range = calib_min;
+      *omax_range = calib_max;
+    }
+  }
+};
+
+void QuantizedBatchNormForwardGPU(const nnvm::NodeAttrs& attrs,
+                                  const OpContext& ctx,
+                                  const std::vector<TBlob>& inputs,
+                                  const std::vector<OpReqType>& req,
+                                  const std::vector<TBlob>& outputs) {
+  using namespace quantized_batchnorm;
+  CHECK_EQ(inputs.size(), 7U);
+  CHECK_EQ(outputs.size(), 3U);
+  CHECK_EQ(req[kOut], kWriteTo) << "_contrib_quantized_batch_norm only supports kWriteTo";
+  const BatchNormParam& param = nnvm::get<BatchNormParam>(attrs.parsed);
+  if (!param.min_calib_range.has_value() || !param.max_calib_range.has_value()) {
+    LOG(FATAL) << "min_calib_range or max_calib_range is not available. Quantized BN currently "
+                  "don't support calib_mode=None";
+  }
+  const TBlob& data = inputs[kData];
+  CHECK_EQ(data.type_flag_, mshadow::kInt8)
+      << "_contrib_quantized_batch_norm only supports int8 input on GPU";
+  const int axis = param.axis < 0 ? data.ndim() + param.axis : param.axis;
+  index_t inner = 1;
+  for (int i = axis + 1; i < data.ndim(); ++i) inner *= data.shape_[i];
+  mshadow::Stream<gpu> *s = ctx.get_stream<gpu>();
+  mxnet_op::Kernel<quantized_batch_norm, gpu>::Launch(s, data.Size(),
+    outputs[kOut].dptr<int8_t>(), outputs[kOutMin].dptr<float>(),
+    outputs[kOutMax].dptr<float>(), data.dptr<int8_t>(), inputs[kGamma].dptr<float>(),
+    inputs[kBeta].dptr<float>(), inputs[kInMovingMean].dptr<float>(),
+    inputs[kInMovingVar].dptr<float>(), inputs[kDataMin].dptr<float>(),
+    inputs[kDataMax].dptr<float>(), inner, static_cast<index_t>(data.shape_[axis]),
+    static_cast<float>(param.eps), param.fix_gamma, param.min_calib_range.value(),
+    param.max_calib_range.value());
+}
+
+NNVM_REGISTER_OP(_contrib_quantized_batch_norm)
+.set_attr<FCompute>("FCompute<gpu>", QuantizedBatchNormForwardGPU);
+
+}  // namespace op
+}  // namespace mxnet
@@ -0,0 +1,102 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file quantized_concat.cu
+ * \brief GPU implementation of quantized concat for int8 inputs
+ *
+ *  As with MKLDNN, the output range covers all the input ranges and each input is
+ *  requantized into it while it is copied to its slice of the output.
+ */
+#include <vector>
+#include "../nn/concat-inl.h"
+#include "./quantization_utils.h"
+
+namespace mxnet {
+namespace op {
+
+// run one thread per input in order, the first one initializes the output range
+struct quantized_concat_range {
+  MSHADOW_XINLINE static void Map(int i, float *omin_range, float *omax_range,
+                                  const float *imin_range, const float *imax_range,
+                                  const bool first) {
+    *omin_range = first ? *imin_range : Min(*omin_range, *imin_range);
+    *omax_range = first ? *imax_range : Max(*omax_range, *imax_range);
+  }
+};
+
+// in_block and out_block are the sizes of the concat axis and the trailing axes of the
+// input and the output, offset the start of the input along them
+struct quantized_concat_copy {
+  MSHADOW_XINLINE static void Map(int i, int8_t *out, const int8_t *in,
+                                  const float *imin_range, const float *imax_range,
+                                  const float *omin_range, const float *omax_range,
+                                  const index_t in_block, const index_t out_block,
+                                  const index_t offset) {
+    const index_t lead = i / in_block;
+    out[lead * out_block + offset + i % in_block] = RequantizeInNewRange<int8_t, int8_t>(
+        in[i], *imin_range, *imax_range, *omin_range, *omax_range);
+  }
+};
+
+void QuantizedConcatForwardGPU(const nnvm::NodeAttrs& attrs,
+                               const OpContext& ctx,
+                               const std::vector<TBlob>& inputs,
+                               const std::vector<OpReqType>& req,
+                               const std::vector<TBlob>& outputs) {
+  using namespace mxnet_op;
+  const ConcatParam& param = nnvm::get<ConcatParam>(attrs.parsed);
+  const int num_args = param.num_args;
+  CHECK_EQ(inputs.size(), static_cast<size_t>(num_args * 3));
+  CHECK_EQ(outputs.size(), 3U);
+  CHECK_EQ(req[0], kWriteTo) << "_contrib_quantized_concat only supports kWriteTo";
+  const TBlob& out = outputs[0];
+  const int axis = CheckAxis(param.dim, out.ndim());
+  index_t trailing = 1;
+  for (int i = axis + 1; i < out.ndim(); ++i) trailing *= out.shape_[i];
+  const index_t out_block = out.shape_[axis] * trailing;
+  mshadow::Stream<gpu> *s = ctx.get_stream<gpu>();
+  float *omin_range = outputs[1].dptr<float>();
+  float *omax_range = outputs[2].dptr<float>();
+  for (int i = 0; i < num_args; ++i) {
+    CHECK_EQ(inputs[i].type_flag_, mshadow::kInt8)
+        << "_contrib_quantized_concat only supports int8 inputs on GPU";
+    Kernel<quantized_concat_range, gpu>::Launch(s, 1, omin_range, omax_range,
+      inputs[num_args + 2 * i].dptr<float>(), inputs[num_args + 2 * i + 1].dptr<float>(),
+      i == 0);
+  }
+  index_t offset = 0;
+  for (int i = 0; i < num_args; ++i) {
+    const TBlob& in = inputs[i];
+    const index_t in_block = in.shape_[axis] * trailing;
+    if (in.Size() != 0) {
+      Kernel<quantized_concat_copy, gpu>::Launch(s, in.Size(), out.dptr<int8_t>(),
+        in.dptr<int8_t>(), inputs[num_args + 2 * i].dptr<float>(),
+        inputs[num_args + 2 * i + 1].dptr<float>(), omin_range, omax_range,
+        in_block, out_block, offset);
+    }
+    offset += in_block;
+  }
+}
+
+NNVM_REGISTER_OP(_contrib_quantized_concat)
+.set_attr<FCompute>("FCompute<gpu>", QuantizedConcatForwardGPU);
+
+}  // namespace op
+}  // namespace mxnet
@@ -125,6 +125,9 @@ if (data_ndims == 4) {
   const int start = param.no_bias? 2 : 3;
   const int end = param.no_bias? 6 : 9;
   for (int i = start; i < end; ++i) {
+    // weights quantized per output channel come with one range per channel
+    const bool weight_range = i == start + 2 || i == start + 3;
+    if (weight_range && (*in_shape)[i] == mxnet::TShape(Shape1(param.num_filter))) continue;
     SHAPE_ASSIGN_CHECK(*in_shape, i, mxnet::TShape{1});
   }
   if (!param.no_bias) {
@@ -175,10 +175,28 @@ class QuantizedCuDNNConvOp {
     // of in_data[0] and in_data[1]. Need to rescale the min/max range of out_data
     // based on the min/max ranges of in_data[0] and in_data[1].
     const size_t num_inputs = param_.no_bias ? 2 : 3;
-    mxnet_op::Kernel<QuantizationRangeForS8S8MultiplicationStruct, gpu>::Launch(s, 1,
-      out_data[1].dptr<float>(), out_data[2].dptr<float>(),
-       in_data[num_inputs].dptr<float>(),  in_data[num_inputs+1].dptr<float>(),
-       in_data[num_inputs+2].dptr<float>(),  in_data[num_inputs+3].dptr<float>());
+    const TBlob& min_weight = in_data[num_inputs + 2];
+    if (min_weight.Size() == 1) {
+      mxnet_op::Kernel<QuantizationRangeForS8S8MultiplicationStruct, gpu>::Launch(s, 1,
+        out_data[1].dptr<float>(), out_data[2].dptr<float>(),
+         in_data[num_inputs].dptr<float>(),  in_data[num_inputs+1].dptr<float>(),
+         in_data[num_inputs+2].dptr<float>(),  in_data[num_inputs+3].dptr<float>());
+    } else {
+      // the weights are quantized per output channel, bring all the channels to the
+      // scale of the output range
+      CHECK_EQ(min_weight.Size(), oshape[1]);
+      mxnet_op::Kernel<QuantizationRangeForS8S8ChannelWiseMultiplicationStruct, gpu>::Launch(
+        s, 1, out_data[1].dptr<float>(), out_data[2].dptr<float>(),
+        in_data[num_inputs].dptr<float>(), in_data[num_inputs+1].dptr<float>(),
+        in_data[num_inputs+2].dptr<float>(), in_data[num_inputs+3].dptr<float>(),
+        static_cast<index_t>(oshape[1]));
+      mxnet_op::Kernel<QuantizedChannelWiseRescaleStruct, gpu>::Launch(s, out.Size(),
+        out.dptr<int32_t>(), in_data[num_inputs].dptr<float>(),
+        in_data[num_inputs+1].dptr<float>(), in_data[num_inputs+2].dptr<float>(),
+        in_data[num_inputs+3].dptr<float>(), out_data[1].dptr<float>(),
+        out_data[2].dptr<float>(), static_cast<index_t>(oshape[2] * oshape[3]),
+        static_cast<index_t>(oshape[1]));
+    }
 
     if (!param_.no_bias) {
       if (param_.layout.has_value()) {
@@ -25,7 +25,9 @@
 #ifndef MXNET_OPERATOR_QUANTIZATION_QUANTIZED_ELEMWISE_ADD_INL_H_
 #define MXNET_OPERATOR_QUANTIZATION_QUANTIZED_ELEMWISE_ADD_INL_H_
 
+#include <vector>
 #include "../tensor/elemwise_unary_op.h"
+#include "./quantization_utils.h"
 
 namespace mxnet {
 namespace op {
@@ -52,6 +54,73 @@ enum QuantizedElemwiseAddOutputs { kOut, kMin, kMax };
 enum QuantizedElemwiseAddInputs { kDataA, kDataB, kAMin, kAMax, kBMin, kBMax};
 }
 
+/*!
+ * \brief Adds the dequantized inputs and quantizes the sum into [-range, range], which is
+ *        the calibrated output range when calibrated, and the sum of the input ranges
+ *        otherwise, so that the int32 output can not overflow.
+ */
+struct quantized_elemwise_add {
+  template<typename OType>
+  MSHADOW_XINLINE static void Map(int i, OType *out, float *omin_range, float *omax_range,
+                                  const int8_t *a, const int8_t *b,
+                                  const float *amin_range, const float *amax_range,
+                                  const float *bmin_range, const float *bmax_range,
+                                  const bool calibrated, const float calib_min,
+                                  const float calib_max) {
+    const float a_float = QuantizedToFloat<int8_t>(a[i], *amin_range, *amax_range);
+    const float b_float = QuantizedToFloat<int8_t>(b[i], *bmin_range, *bmax_range);
+    const float range = calibrated ? MaxAbs(calib_min, calib_max) :
+        MaxAbs(*amin_range, *amax_range) + MaxAbs(*bmin_range, *bmax_range);
+    out[i] = FloatToQuantized<OType>(a_float + b_float, -range, range);
+    if (i == 0) {
+      *omin_range = calibrated ? calib_min : -range;
+      *omax_range = calibrated ? calib_max : range;
+    }
+  }
+};
+
+template<typename xpu, typename OType>
+inline void QuantizedElemwiseAddLaunch(mshadow::Stream<xpu> *s,
+                                       const std::vector<TBlob> &in_data,
+                                       const std::vector<TBlob> &out_data,
+                                       const QuantizeElemwiseAddParam &params) {
+  using namespace quantized_elemwise_add_enum;
+  const bool calibrated = params.min_calib_range.has_value() &&
+                          params.max_calib_range.has_value();
+  mxnet_op::Kernel<quantized_elemwise_add, xpu>::Launch(s, out_data[kOut].Size(),
+    out_data[kOut].dptr<OType>(), out_data[kMin].dptr<float>(), out_data[kMax].dptr<float>(),
+    in_data[kDataA].dptr<int8_t>(), in_data[kDataB].dptr<int8_t>(),
+    in_data[kAMin].dptr<float>(), in_data[kAMax].dptr<float>(),
+    in_data[kBMin].dptr<float>(), in_data[kBMax].dptr<float>(), calibrated,
+    calibrated ? params.min_calib_range.value() : 0.f,
+    calibrated ? params.max_calib_range.value() : 0.f);
+}
+
+template<typename xpu>
+void QuantizedElemwiseAddForward(const nnvm::NodeAttrs& attrs,
+                                 const OpContext &ctx,
+                                 const std::vector<TBlob> &in_data,
+                                 const std::vector<OpReqType> &req,
+                                 const std::vector<TBlob> &out_data) {
+  using namespace quantized_elemwise_add_enum;
+  CHECK_EQ(in_data.size(), 6U) << "should be A, B, A_min, A_max, B_min, B_max";
+  CHECK_EQ(out_data.size(), 3U) << "should be C, C_min, C_max";
+  CHECK_EQ(req[kOut], kWriteTo) << "_contrib_quantized_elemwise_add only supports kWriteTo";
+  const QuantizeElemwiseAddParam& params = nnvm::get<QuantizeElemwiseAddParam>(attrs.parsed);
+  CHECK(in_data[kDataA].type_flag_ == mshadow::kInt8 &&
+        in_data[kDataB].type_flag_ == mshadow::kInt8)
+      << "_contrib_quantized_elemwise_add without MKLDNN only supports int8 inputs";
+  mshadow::Stream<xpu> *s = ctx.get_stream<xpu>();
+  const TBlob &out = out_data[kOut];
+  if (out.type_flag_ == mshadow::kInt32) {
+    QuantizedElemwiseAddLaunch<xpu, int32_t>(s, in_data, out_data, params);
+  } else {
+    CHECK_EQ(out.type_flag_, mshadow::kInt8)
+        << "_contrib_quantized_elemwise_add only supports int32 and int8 outputs";
+    QuantizedElemwiseAddLaunch<xpu, int8_t>(s, in_data, out_data, params);
+  }
+}
+
 }  // namespace op
 }  // namespace mxnet
 
@@ -28,6 +28,8 @@
 namespace mxnet {
 namespace op {
 
+DMLC_REGISTER_PARAMETER(QuantizeElemwiseAddParam);
+
 static bool ElemwiseAddShape(const nnvm::NodeAttrs& attrs,
                              mxnet::ShapeVector* in_shape,
                              mxnet::ShapeVector* out_shape) {
@@ -81,15 +83,6 @@ static bool ElemwiseAddType(const nnvm::NodeAttrs& attrs,
   return true;
 }
 
-void QuantizedElemwiseAddForward(const nnvm::NodeAttrs& attrs,
-                                 const OpContext &ctx,
-                                 const std::vector<TBlob> &in_data,
-                                 const std::vector<OpReqType> &req,
-                                 const std::vector<TBlob> &out_data) {
-  LOG(FATAL) << "Not supported for MXNet built without MKLDNN. "
-                "Please install MKLDNN enabled MXNet.";
-}
-
 NNVM_REGISTER_OP(_contrib_quantized_elemwise_add)
 .describe(R"code(elemwise_add operator for input dataA and input dataB data type of int8,
 and accumulates in type int32 for the output. For each argument, two more arguments of type
@@ -107,6 +100,7 @@ and max thresholds representing the threholds for quantizing the float32 output
 })
 // C, C_min, C_max
 .set_num_outputs(3)
+.set_attr_parser(ParamParser<QuantizeElemwiseAddParam>)
 .set_attr<nnvm::FListInputNames>("FListInputNames", [](const NodeAttrs& attrs) {
   return std::vector<std::string>{"lhs", "rhs", "lhs_min", "lhs_max", "rhs_min", "rhs_max"}; \
 })
@@ -115,14 +109,15 @@ and max thresholds representing the threholds for quantizing the float32 output
 })
 .set_attr<nnvm::FInferType>("FInferType", ElemwiseAddType)
 .set_attr<mxnet::FInferShape>("FInferShape", ElemwiseAddShape)
-.set_attr<FCompute>("FCompute<cpu>", QuantizedElemwiseAddForward)
+.set_attr<FCompute>("FCompute<cpu>", QuantizedElemwiseAddForward<cpu>)
 .set_attr<FNeedRequantize>("FNeedRequantize", [](const NodeAttrs& attrs) { return true; })
 .add_argument("lhs", "NDArray-or-Symbol", "first input")
 .add_argument("rhs", "NDArray-or-Symbol", "second input")
 .add_argument("lhs_min", "NDArray-or-Symbol", "3rd input")
 .add_argument("lhs_max", "NDArray-or-Symbol", "4th input")
 .add_argument("rhs_min", "NDArray-or-Symbol", "5th input")
-.add_argument("rhs_max", "NDArray-or-Symbol", "6th input");
+.add_argument("rhs_max", "NDArray-or-Symbol", "6th input")
+.add_arguments(QuantizeElemwiseAddParam::__FIELDS__());
 
 
 NNVM_REGISTER_OP(elemwise_add)
@@ -66,6 +66,9 @@ bool QuantizedFullyConnectedShape(const nnvm::NodeAttrs& attrs,
   }
 
   for (size_t i = num_inputs; i < 3 * num_inputs; ++i) {
+    // weights quantized per output channel come with one range per channel
+    const bool weight_range = i == num_inputs + 2 || i == num_inputs + 3;
+    if (weight_range && (*in_shape)[i] == mxnet::TShape(Shape1(param.num_hidden))) continue;
     SHAPE_ASSIGN_CHECK(*in_shape, i, mxnet::TShape(1, 1));
   }
 
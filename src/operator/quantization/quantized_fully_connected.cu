@@ -109,10 +109,27 @@ void QuantizedFullyConnectedForwardGPU(const nnvm::NodeAttrs& attrs,
                            cmp_type,
                            CUBLAS_GEMM_DFALT));
 
-  Kernel<QuantizationRangeForS8S8MultiplicationStruct, gpu>::Launch(s, 1,
-    outputs[1].dptr<float>(), outputs[2].dptr<float>(),
-     inputs[num_inputs].dptr<float>(),   inputs[num_inputs+1].dptr<float>(),
-     inputs[num_inputs+2].dptr<float>(), inputs[num_inputs+3].dptr<float>());
+  const TBlob& min_weight = inputs[num_inputs + 2];
+  if (min_weight.Size() == 1) {
+    Kernel<QuantizationRangeForS8S8MultiplicationStruct, gpu>::Launch(s, 1,
+      outputs[1].dptr<float>(), outputs[2].dptr<float>(),
+       inputs[num_inputs].dptr<float>(),   inputs[num_inputs+1].dptr<float>(),
+       inputs[num_inputs+2].dptr<float>(), inputs[num_inputs+3].dptr<float>());
+  } else {
+    // the weights are quantized per output channel, bring all the channels to the
+    // scale of the output range
+    CHECK_EQ(min_weight.Size(), static_cast<size_t>(k));
+    Kernel<QuantizationRangeForS8S8ChannelWiseMultiplicationStruct, gpu>::Launch(s, 1,
+      outputs[1].dptr<float>(), outputs[2].dptr<float>(),
+      inputs[num_inputs].dptr<float>(), inputs[num_inputs+1].dptr<float>(),
+      inputs[num_inputs+2].dptr<float>(), inputs[num_inputs+3].dptr<float>(),
+      static_cast<index_t>(k));
+    Kernel<QuantizedChannelWiseRescaleStruct, gpu>::Launch(s, out.Size(),
+      out.dptr<int32_t>(), inputs[num_inputs].dptr<float>(),
+      inputs[num_inputs+1].dptr<float>(), inputs[num_inputs+2].dptr<float>(),
+      inputs[num_inputs+3].dptr<float>(), outputs[1].dptr<float>(),
+      outputs[2].dptr<float>(), static_cast<index_t>(1), static_cast<index_t>(k));
+  }
 
   if (!param.no_bias) {
     const TBlob& bias = inputs[2];
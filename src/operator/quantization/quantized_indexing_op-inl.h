@@ -0,0 +1,72 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file quantized_indexing_op-inl.h
+ * \brief forward of quantized embedding on CPU and GPU
+ */
+#ifndef MXNET_OPERATOR_QUANTIZATION_QUANTIZED_INDEXING_OP_INL_H_
+#define MXNET_OPERATOR_QUANTIZATION_QUANTIZED_INDEXING_OP_INL_H_
+
+#include <mxnet/op_attr_types.h>
+#include <vector>
+#include "../mxnet_op.h"
+#include "../tensor/indexing_op.h"
+
+namespace mxnet {
+namespace op {
+
+// the rows are looked up without requantization, so the output keeps the weight range
+struct quantized_embedding_range {
+  MSHADOW_XINLINE static void Map(int i, float *omin_range, float *omax_range,
+                                  const float *imin_range, const float *imax_range) {
+    *omin_range = *imin_range;
+    *omax_range = *imax_range;
+  }
+};
+
+template<typename xpu>
+void QuantizedEmbeddingOpForward(const nnvm::NodeAttrs& attrs,
+                                 const OpContext& ctx,
+                                 const std::vector<TBlob>& inputs,
+                                 const std::vector<OpReqType>& req,
+                                 const std::vector<TBlob>& outputs) {
+  CHECK_EQ(req[quantized_embedding::kOut], kWriteTo);
+  CHECK_EQ(inputs.size(), 4U);
+  CHECK_EQ(outputs.size(), 3U);
+  CHECK_EQ(inputs[quantized_embedding::kWeight].ndim(), 2U)
+          << "Embedding layer expects its weight to be two-dimensional. "
+          << inputs[quantized_embedding::kWeight].ndim()
+          << " dimensional input is given instead";
+  mshadow::Stream<xpu> *s = ctx.get_stream<xpu>();
+  EmbeddingOpForwardDnsImpl<xpu>(s, inputs[quantized_embedding::kData],
+                                 inputs[quantized_embedding::kWeight],
+                                 req[quantized_embedding::kOut],
+                                 outputs[quantized_embedding::kOut]);
+  mxnet_op::Kernel<quantized_embedding_range, xpu>::Launch(s, 1,
+    outputs[quantized_embedding::kOutMin].dptr<float>(),
+    outputs[quantized_embedding::kOutMax].dptr<float>(),
+    inputs[quantized_embedding::kWeightMin].dptr<float>(),
+    inputs[quantized_embedding::kWeightMax].dptr<float>());
+}
+
+}  // namespace op
+}  // namespace mxnet
+
+#endif  // MXNET_OPERATOR_QUANTIZATION_QUANTIZED_INDEXING_OP_INL_H_
@@ -22,7 +22,7 @@
  * \file quantized_indexing_op.cc
 */
 #include <mxnet/op_attr_types.h>
-#include "../tensor/indexing_op.h"
+#include "./quantized_indexing_op-inl.h"
 
 namespace mxnet {
 namespace op {
@@ -106,29 +106,6 @@ inline bool QuantizedEmbeddingOpForwardStorageType(const nnvm::NodeAttrs& attrs,
   return dispatched;
 }
 
-void QuantizedEmbeddingOpForward(const nnvm::NodeAttrs& attrs,
-                                 const OpContext& ctx,
-                                 const std::vector<TBlob>& inputs,
-                                 const std::vector<OpReqType>& req,
-                                 const std::vector<TBlob>& outputs) {
-  CHECK_EQ(req[quantized_embedding::kOut], kWriteTo);
-  CHECK_EQ(inputs.size(), 4U);
-  CHECK_EQ(outputs.size(), 3U);
-  CHECK_EQ(inputs[quantized_embedding::kWeight].ndim(), 2U)
-          << "Embedding layer expects its weight to be two-dimensional. "
-          << inputs[quantized_embedding::kWeight].ndim()
-          << " dimensional input is given instead";
-  mshadow::Stream<cpu> *s = ctx.get_stream<cpu>();
-  EmbeddingOpForwardDnsImpl<cpu>(s, inputs[quantized_embedding::kData],
-                                 inputs[quantized_embedding::kWeight],
-                                 req[quantized_embedding::kOut],
-                                 outputs[quantized_embedding::kOut]);
-  float min_weight = inputs[quantized_embedding::kWeightMin].dptr<float>()[0];
-  float max_weight = inputs[quantized_embedding::kWeightMax].dptr<float>()[0];
-  outputs[quantized_embedding::kOutMin].dptr<float>()[0] = min_weight;
-  outputs[quantized_embedding::kOutMax].dptr<float>()[0] = max_weight;
-}
-
 NNVM_REGISTER_OP(_contrib_quantized_embedding)
 .describe(R"code(Maps integer indices to int8 vector representations (embeddings).
 )code" ADD_FILELINE)
@@ -150,7 +127,7 @@ NNVM_REGISTER_OP(_contrib_quantized_embedding)
   [](const NodeAttrs& attrs) {
     return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
   })
-.set_attr<FCompute>("FCompute<cpu>", QuantizedEmbeddingOpForward)
+.set_attr<FCompute>("FCompute<cpu>", QuantizedEmbeddingOpForward<cpu>)
 // TODO(Xinyu): a temp solution to enable GluonCV INT8 flow,
 // will be reverted after the improvement of CachedOP is done.
 .set_attr<nnvm::FGradient>("FGradient", MakeZeroGradNodes)
@@ -0,0 +1,341 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file rowwise_quantized_ops-inl.h
+ * \brief Embedding, EmbeddingBag and dot(csr, dns) with int8 tables scaled row by row
+ *
+ *  A table of (rows, row_length) int8 values comes with one float32 scale per row, and
+ *  its rows are dequantized when they are read, so the output is float32 and needs no
+ *  requantization. The table of the embeddings may be row_sparse, the rows it does not
+ *  hold are zeros.
+ */
+#ifndef MXNET_OPERATOR_QUANTIZATION_ROWWISE_QUANTIZED_OPS_INL_H_
+#define MXNET_OPERATOR_QUANTIZATION_ROWWISE_QUANTIZED_OPS_INL_H_
+
+#include <mxnet/operator_util.h>
+#include <algorithm>
+#include <vector>
+#include "../linalg.h"
+#include "../mxnet_op.h"
+#include "../operator_common.h"
+#include "../tensor/indexing_op.h"
+
+namespace mxnet {
+namespace op {
+
+namespace rowwise_quantized {
+enum EmbeddingInputs {kData, kWeight, kScale};
+enum EmbeddingBagInputs {kBagData, kBagOffsets, kBagWeight, kBagScale};
+enum DotInputs {kLhs, kRhs, kRhsScale};
+enum Resource {kTempSpace};
+/*! \brief number of columns of a bag pooled at once */
+const nnvm::dim_t kBagBlock = 64;
+}  // namespace rowwise_quantized
+
+struct RowwiseQuantizedEmbeddingParam
+    : public dmlc::Parameter<RowwiseQuantizedEmbeddingParam> {
+  index_t input_dim;
+  index_t output_dim;
+  DMLC_DECLARE_PARAMETER(RowwiseQuantizedEmbeddingParam) {
+    DMLC_DECLARE_FIELD(input_dim).set_lower_bound(1)
+    .describe("Vocabulary size of the input indices.");
+    DMLC_DECLARE_FIELD(output_dim).set_lower_bound(1)
+    .describe("Dimension of the embedding vectors.");
+  }
+};
+
+struct RowwiseQuantizedEmbeddingBagParam
+    : public dmlc::Parameter<RowwiseQuantizedEmbeddingBagParam> {
+  index_t input_dim;
+  index_t output_dim;
+  int mode;
+  DMLC_DECLARE_PARAMETER(RowwiseQuantizedEmbeddingBagParam) {
+    DMLC_DECLARE_FIELD(input_dim).set_lower_bound(1)
+    .describe("Vocabulary size of the input indices.");
+    DMLC_DECLARE_FIELD(output_dim).set_lower_bound(1)
+    .describe("Dimension of the embedding vectors.");
+    DMLC_DECLARE_FIELD(mode)
+    .add_enum("sum", embedding_bag::kSum)
+    .add_enum("mean", embedding_bag::kMean)
+    .set_default(embedding_bag::kSum)
+    .describe("How the embeddings of a bag are pooled.");
+  }
+};
+
+/*!
+ * \brief the position of a row in the sorted row indices of a row_sparse table, -1 if the
+ *        table does not hold it
+ */
+template<typename RType>
+MSHADOW_XINLINE nnvm::dim_t RowwiseFindRow(const RType* row_idx, const nnvm::dim_t nnr,
+                                           const nnvm::dim_t row) {
+  nnvm::dim_t lo = 0, hi = nnr;
+  while (lo < hi) {
+    const nnvm::dim_t mid = lo + (hi - lo) / 2;
+    if (static_cast<nnvm::dim_t>(row_idx[mid]) < row) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return (lo < nnr && static_cast<nnvm::dim_t>(row_idx[lo]) == row) ? lo : -1;
+}
+
+/*!
+ * \brief the position in the stored rows of the table of the clipped index, -1 for a row
+ *        the table does not hold
+ */
+template<typename IType, typename RType>
+MSHADOW_XINLINE nnvm::dim_t RowwiseTableRow(const IType index, const RType* row_idx,
+                                            const nnvm::dim_t nnr, const nnvm::dim_t num_rows,
+                                            nnvm::dim_t* row) {
+  nnvm::dim_t r = static_cast<nnvm::dim_t>(index);
+  r = r < 0 ? 0 : (r >= num_rows ? num_rows - 1 : r);
+  *row = r;
+  return row_idx == nullptr ? r : RowwiseFindRow(row_idx, nnr, r);
+}
+
+template<int req>
+struct rowwise_quantized_embedding {
+  /*!
+   * \brief dequantizes the row of index i into the output
+   * \param row_idx  sorted row indices of a row_sparse table of nnr rows, nullptr if dense
+   */
+  template<typename IType, typename RType>
+  MSHADOW_XINLINE static void Map(index_t i, float* out, const int8_t* weight,
+                                  const float* scale, const IType* data, const RType* row_idx,
+                                  const nnvm::dim_t nnr, const nnvm::dim_t row_length,
+                                  const nnvm::dim_t num_rows) {
+    nnvm::dim_t row;
+    const nnvm::dim_t pos = RowwiseTableRow(data[i], row_idx, nnr, num_rows, &row);
+    float* o = out + i * row_length;
+    if (pos < 0) {
+      for (nnvm::dim_t j = 0; j < row_length; ++j) KERNEL_ASSIGN(o[j], req, 0.0f);
+      return;
+    }
+    const int8_t* w = weight + pos * row_length;
+    const float s = scale[row];
+    for (nnvm::dim_t j = 0; j < row_length; ++j) {
+      KERNEL_ASSIGN(o[j], req, s * static_cast<float>(w[j]));
+    }
+  }
+};
+
+template<int req>
+struct rowwise_quantized_embedding_bag {
+  /*!
+   * \brief pools the dequantized rows of bag b, a block of columns at a time so that the
+   *        sums stay in registers
+   * \param offsets  start offsets of the bags, followed by the end offset of the last one
+   */
+  template<typename IType, typename OType, typename RType>
+  MSHADOW_XINLINE static void Map(index_t b, float* out, const int8_t* weight,
+                                  const float* scale, const IType* data, const OType* offsets,
+                                  const RType* row_idx, const nnvm::dim_t nnr,
+                                  const nnvm::dim_t data_size, const nnvm::dim_t row_length,
+                                  const nnvm::dim_t num_rows, const bool mean) {
+    using nnvm::dim_t;
+    using rowwise_quantized::kBagBlock;
+    dim_t begin, end;
+    EmbeddingBagRange(offsets, b, data_size, &begin, &end);
+    const float norm = (mean && end > begin) ? 1.0f / static_cast<float>(end - begin) : 1.0f;
+    for (dim_t col = 0; col < row_length; col += kBagBlock) {
+      const dim_t len = row_length - col < kBagBlock ? row_length - col : kBagBlock;
+      float acc[kBagBlock];
+      for (dim_t j = 0; j < len; ++j) acc[j] = 0.0f;
+      for (dim_t k = begin; k < end; ++k) {
+        dim_t row;
+        const dim_t pos = RowwiseTableRow(data[k], row_idx, nnr, num_rows, &row);
+        if (pos < 0) continue;
+        const int8_t* w = weight + pos * row_length + col;
+        const float s = scale[row];
+        for (dim_t j = 0; j < len; ++j) acc[j] += s * static_cast<float>(w[j]);
+      }
+      float* o = out + b * row_length + col;
+      for (dim_t j = 0; j < len; ++j) KERNEL_ASSIGN(o[j], req, acc[j] * norm);
+    }
+  }
+};
+
+struct rowwise_quantized_dot_csr {
+  /*!
+   * \brief row i of dot(csr, rhs), accumulating the dequantized rows of rhs of its columns
+   */
+  template<typename IType, typename CType>
+  MSHADOW_XINLINE static void Map(index_t i, float* out, const float* data_l,
+                                  const IType* indptr_l, const CType* col_idx_l,
+                                  const int8_t* rhs, const float* scale,
+                                  const nnvm::dim_t num_cols, const bool add_to) {
+    float* o = out + i * num_cols;
+    if (!add_to) {
+      for (nnvm::dim_t l = 0; l < num_cols; ++l) o[l] = 0.0f;
+    }
+    for (IType k = indptr_l[i]; k < indptr_l[i + 1]; ++k) {
+      const nnvm::dim_t col = static_cast<nnvm::dim_t>(col_idx_l[k]);
+      const float v = data_l[k] * scale[col];
+      const int8_t* w = rhs + col * num_cols;
+      for (nnvm::dim_t l = 0; l < num_cols; ++l) o[l] += v * static_cast<float>(w[l]);
+    }
+  }
+};
+
+/*! \brief element i of the dequantized rhs of rows of row_length values */
+struct rowwise_dequantize {
+  MSHADOW_XINLINE static void Map(index_t i, float* out, const int8_t* data,
+                                  const float* scale, const nnvm::dim_t row_length) {
+    out[i] = scale[i / row_length] * static_cast<float>(data[i]);
+  }
+};
+
+/*! \brief the row indices of a row_sparse table and their number, nullptr if dense */
+template<typename RType>
+inline const RType* RowwiseTableIndices(const NDArray& weight, nnvm::dim_t* nnr) {
+  if (weight.storage_type() != kRowSparseStorage) {
+    *nnr = weight.shape()[0];
+    return nullptr;
+  }
+  *nnr = weight.aux_shape(rowsparse::kIdx)[0];
+  return weight.aux_data(rowsparse::kIdx).dptr<RType>();
+}
+
+template<typename xpu>
+void RowwiseQuantizedEmbeddingForwardEx(const nnvm::NodeAttrs& attrs,
+                                        const OpContext& ctx,
+                                        const std::vector<NDArray>& inputs,
+                                        const std::vector<OpReqType>& req,
+                                        const std::vector<NDArray>& outputs) {
+  using namespace rowwise_quantized;
+  CHECK_EQ(inputs.size(), 3U);
+  CHECK_EQ(outputs.size(), 1U);
+  if (req[0] == kNullOp) return;
+  mshadow::Stream<xpu> *s = ctx.get_stream<xpu>();
+  const NDArray& weight = inputs[kWeight];
+  const TBlob& data = inputs[kData].data();
+  const TBlob& out = outputs[0].data();
+  const nnvm::dim_t row_length = weight.shape()[1];
+  if (weight.storage_type() == kRowSparseStorage && !weight.storage_initialized()) {
+    Fill<false>(s, out, req[0], 0.0f);
+    return;
+  }
+  MSHADOW_TYPE_SWITCH(data.type_flag_, IType, {
+    MSHADOW_IDX_TYPE_SWITCH(weight.storage_type() == kRowSparseStorage ?
+                            weight.aux_type(rowsparse::kIdx) : mshadow::kInt64, RType, {
+      MXNET_ASSIGN_REQ_SWITCH(req[0], req_type, {
+        nnvm::dim_t nnr = 0;
+        const RType* row_idx = RowwiseTableIndices<RType>(weight, &nnr);
+        mxnet_op::Kernel<rowwise_quantized_embedding<req_type>, xpu>::Launch(
+            s, data.Size(), out.dptr<float>(), weight.data().dptr<int8_t>(),
+            inputs[kScale].data().dptr<float>(), data.dptr<IType>(), row_idx, nnr,
+            row_length, weight.shape()[0]);
+      });
+    });
+  });
+}
+
+template<typename xpu>
+void RowwiseQuantizedEmbeddingBagForwardEx(const nnvm::NodeAttrs& attrs,
+                                           const OpContext& ctx,
+                                           const std::vector<NDArray>& inputs,
+                                           const std::vector<OpReqType>& req,
+                                           const std::vector<NDArray>& outputs) {
+  using namespace rowwise_quantized;
+  CHECK_EQ(inputs.size(), 4U);
+  CHECK_EQ(outputs.size(), 1U);
+  if (req[0] == kNullOp) return;
+  const auto& param = nnvm::get<RowwiseQuantizedEmbeddingBagParam>(attrs.parsed);
+  mshadow::Stream<xpu> *s = ctx.get_stream<xpu>();
+  const NDArray& weight = inputs[kBagWeight];
+  const TBlob& data = inputs[kBagData].data();
+  const TBlob& offsets = inputs[kBagOffsets].data();
+  const TBlob& out = outputs[0].data();
+  if (weight.storage_type() == kRowSparseStorage && !weight.storage_initialized()) {
+    Fill<false>(s, out, req[0], 0.0f);
+    return;
+  }
+  MSHADOW_TYPE_SWITCH(data.type_flag_, IType, {
+    MSHADOW_IDX_TYPE_SWITCH(offsets.type_flag_, OType, {
+      MSHADOW_IDX_TYPE_SWITCH(weight.storage_type() == kRowSparseStorage ?
+                              weight.aux_type(rowsparse::kIdx) : mshadow::kInt64, RType, {
+        MXNET_ASSIGN_REQ_SWITCH(req[0], req_type, {
+          nnvm::dim_t nnr = 0;
+          const RType* row_idx = RowwiseTableIndices<RType>(weight, &nnr);
+          mxnet_op::Kernel<rowwise_quantized_embedding_bag<req_type>, xpu>::Launch(
+              s, out.shape_[0], out.dptr<float>(), weight.data().dptr<int8_t>(),
+              inputs[kBagScale].data().dptr<float>(), data.dptr<IType>(),
+              offsets.dptr<OType>(), row_idx, nnr, static_cast<nnvm::dim_t>(data.Size()),
+              weight.shape()[1], weight.shape()[0], param.mode == embedding_bag::kMean);
+        });
+      });
+    });
+  });
+}
+
+template<typename xpu>
+void RowwiseQuantizedDotForwardEx(const nnvm::NodeAttrs& attrs,
+                                  const OpContext& ctx,
+                                  const std::vector<NDArray>& inputs,
+                                  const std::vector<OpReqType>& req,
+                                  const std::vector<NDArray>& outputs) {
+  using namespace rowwise_quantized;
+  using namespace mshadow;
+  CHECK_EQ(inputs.size(), 3U);
+  CHECK_EQ(outputs.size(), 1U);
+  if (req[0] == kNullOp) return;
+  CHECK_NE(req[0], kWriteInplace) << "_contrib_rowwise_quantized_dot does not write in place";
+  Stream<xpu> *s = ctx.get_stream<xpu>();
+  const NDArray& lhs = inputs[kLhs];
+  const TBlob& rhs = inputs[kRhs].data();
+  const TBlob& scale = inputs[kRhsScale].data();
+  const TBlob& out = outputs[0].data();
+  const nnvm::dim_t num_cols = rhs.shape_[1];
+  CHECK_EQ(lhs.dtype(), mshadow::kFloat32)
+      << "_contrib_rowwise_quantized_dot only supports a float32 lhs";
+  if (lhs.storage_type() == kCSRStorage) {
+    if (!lhs.storage_initialized()) {
+      if (req[0] == kWriteTo) Fill<false>(s, out, kWriteTo, 0);
+      return;
+    }
+    const TBlob& indptr = lhs.aux_data(csr::kIndPtr);
+    const TBlob& col_idx = lhs.aux_data(csr::kIdx);
+    MSHADOW_IDX_TYPE_SWITCH(indptr.type_flag_, IType, {
+      MSHADOW_IDX_TYPE_SWITCH(col_idx.type_flag_, CType, {
+        mxnet_op::Kernel<rowwise_quantized_dot_csr, xpu>::Launch(
+            s, out.shape_[0], out.dptr<float>(), lhs.data().dptr<float>(),
+            indptr.dptr<IType>(), col_idx.dptr<CType>(), rhs.dptr<int8_t>(),
+            scale.dptr<float>(), num_cols, req[0] == kAddTo);
+      });
+    });
+    return;
+  }
+  // a dense lhs multiplies the dequantized rhs
+  Tensor<xpu, 2, float> dequantized = ctx.requested[kTempSpace]
+      .get_space_typed<xpu, 2, float>(Shape2(rhs.shape_[0], num_cols), s);
+  mxnet_op::Kernel<rowwise_dequantize, xpu>::Launch(
+      s, dequantized.shape_.Size(), dequantized.dptr_, rhs.dptr<int8_t>(),
+      scale.dptr<float>(), num_cols);
+  const TBlob& dense_lhs = lhs.data();
+  linalg_gemm(dense_lhs.FlatTo2D<xpu, float>(s), dequantized, out.FlatTo2D<xpu, float>(s),
+              1.0f, req[0] == kAddTo ? 1.0f : 0.0f, false, false, s);
+}
+
+}  // namespace op
+}  // namespace mxnet
+
+#endif  // MXNET_OPERATOR_QUANTIZATION_ROWWISE_QUANTIZED_OPS_INL_H_
@@ -0,0 +1,274 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file rowwise_quantized_ops.cc
+ * \brief Embedding, EmbeddingBag and dot(csr, dns) with int8 tables scaled row by row
+ */
+#include "./rowwise_quantized_ops-inl.h"
+
+namespace mxnet {
+namespace op {
+
+DMLC_REGISTER_PARAMETER(RowwiseQuantizedEmbeddingParam);
+DMLC_REGISTER_PARAMETER(RowwiseQuantizedEmbeddingBagParam);
+
+/*! \brief Assign the shapes of a table of input_dim rows of output_dim int8 values. */
+static void RowwiseTableShape(mxnet::ShapeVector *in_shape, size_t weight, size_t scale,
+                              index_t input_dim, index_t output_dim) {
+  SHAPE_ASSIGN_CHECK(*in_shape, weight, mshadow::Shape2(input_dim, output_dim));
+  SHAPE_ASSIGN_CHECK(*in_shape, scale, mshadow::Shape1(input_dim));
+}
+
+/*! \brief dense or row_sparse table, dense indices and scales, dense output */
+static bool RowwiseTableStorageType(std::vector<int> *in_attrs, std::vector<int> *out_attrs,
+                                    size_t weight, DispatchMode *dispatch_mode) {
+  for (size_t i = 0; i < in_attrs->size(); ++i) {
+    if (i == weight) continue;
+    if (!type_assign(&in_attrs->at(i), kDefaultStorage)) return false;
+  }
+  const int weight_stype = in_attrs->at(weight);
+  if (weight_stype != kDefaultStorage && weight_stype != kRowSparseStorage) return false;
+  return storage_type_assign(&out_attrs->at(0), kDefaultStorage,
+                             dispatch_mode, DispatchMode::kFComputeEx);
+}
+
+static bool RowwiseQuantizedEmbeddingShape(const nnvm::NodeAttrs& attrs,
+                                           mxnet::ShapeVector *in_shape,
+                                           mxnet::ShapeVector *out_shape) {
+  using namespace rowwise_quantized;
+  const auto& param = nnvm::get<RowwiseQuantizedEmbeddingParam>(attrs.parsed);
+  CHECK_EQ(in_shape->size(), 3U);
+  CHECK_EQ(out_shape->size(), 1U);
+  RowwiseTableShape(in_shape, kWeight, kScale, param.input_dim, param.output_dim);
+  const mxnet::TShape &dshape = (*in_shape)[kData];
+  if (!ndim_is_known(dshape)) return false;
+  mxnet::TShape oshape(dshape.ndim() + 1, -1);
+  for (int i = 0; i < dshape.ndim(); ++i) oshape[i] = dshape[i];
+  oshape[dshape.ndim()] = param.output_dim;
+  SHAPE_ASSIGN_CHECK(*out_shape, 0, oshape);
+  return shape_is_known(oshape);
+}
+
+static bool RowwiseQuantizedEmbeddingType(const nnvm::NodeAttrs& attrs,
+                                          std::vector<int> *in_type,
+                                          std::vector<int> *out_type) {
+  using namespace rowwise_quantized;
+  CHECK_EQ(in_type->size(), 3U);
+  CHECK_EQ(out_type->size(), 1U);
+  CHECK_NE((*in_type)[kData], -1) << "First input must have specified type";
+  TYPE_ASSIGN_CHECK(*in_type, kWeight, mshadow::kInt8);
+  TYPE_ASSIGN_CHECK(*in_type, kScale, mshadow::kFloat32);
+  TYPE_ASSIGN_CHECK(*out_type, 0, mshadow::kFloat32);
+  return true;
+}
+
+static bool RowwiseQuantizedEmbeddingStorageType(const nnvm::NodeAttrs& attrs,
+                                                 const int dev_mask,
+                                                 DispatchMode* dispatch_mode,
+                                                 std::vector<int>* in_attrs,
+                                                 std::vector<int>* out_attrs) {
+  CHECK_EQ(in_attrs->size(), 3U);
+  CHECK_EQ(out_attrs->size(), 1U);
+  return RowwiseTableStorageType(in_attrs, out_attrs, rowwise_quantized::kWeight,
+                                 dispatch_mode);
+}
+
+static bool RowwiseQuantizedEmbeddingBagShape(const nnvm::NodeAttrs& attrs,
+                                              mxnet::ShapeVector *in_shape,
+                                              mxnet::ShapeVector *out_shape) {
+  using namespace rowwise_quantized;
+  const auto& param = nnvm::get<RowwiseQuantizedEmbeddingBagParam>(attrs.parsed);
+  CHECK_EQ(in_shape->size(), 4U);
+  CHECK_EQ(out_shape->size(), 1U);
+  RowwiseTableShape(in_shape, kBagWeight, kBagScale, param.input_dim, param.output_dim);
+  const mxnet::TShape &dshape = (*in_shape)[kBagData];
+  const mxnet::TShape &oshape = (*in_shape)[kBagOffsets];
+  if (ndim_is_known(dshape)) {
+    CHECK_EQ(dshape.ndim(), 1) << "EmbeddingBag expects one-dimensional indices";
+  }
+  if (!ndim_is_known(oshape)) return false;
+  CHECK_EQ(oshape.ndim(), 1) << "EmbeddingBag expects one-dimensional offsets";
+  if (!dim_size_is_known(oshape, 0)) return false;
+  CHECK_GE(oshape[0], 1) << "EmbeddingBag expects the offsets of the bags and of the end";
+  SHAPE_ASSIGN_CHECK(*out_shape, 0, mshadow::Shape2(oshape[0] - 1, param.output_dim));
+  return shape_is_known(dshape);
+}
+
+static bool RowwiseQuantizedEmbeddingBagType(const nnvm::NodeAttrs& attrs,
+                                             std::vector<int> *in_type,
+                                             std::vector<int> *out_type) {
+  using namespace rowwise_quantized;
+  CHECK_EQ(in_type->size(), 4U);
+  CHECK_EQ(out_type->size(), 1U);
+  CHECK_NE((*in_type)[kBagData], -1) << "First input must have specified type";
+  TYPE_ASSIGN_CHECK(*in_type, kBagOffsets, mshadow::kInt64);
+  TYPE_ASSIGN_CHECK(*in_type, kBagWeight, mshadow::kInt8);
+  TYPE_ASSIGN_CHECK(*in_type, kBagScale, mshadow::kFloat32);
+  TYPE_ASSIGN_CHECK(*out_type, 0, mshadow::kFloat32);
+  return true;
+}
+
+static bool RowwiseQuantizedEmbeddingBagStorageType(const nnvm::NodeAttrs& attrs,
+                                                    const int dev_mask,
+                                                    DispatchMode* dispatch_mode,
+                                                    std::vector<int>* in_attrs,
+                                                    std::vector<int>* out_attrs) {
+  CHECK_EQ(in_attrs->size(), 4U);
+  CHECK_EQ(out_attrs->size(), 1U);
+  return RowwiseTableStorageType(in_attrs, out_attrs, rowwise_quantized::kBagWeight,
+                                 dispatch_mode);
+}
+
+static bool RowwiseQuantizedDotShape(const nnvm::NodeAttrs& attrs,
+                                     mxnet::ShapeVector *in_shape,
+                                     mxnet::ShapeVector *out_shape) {
+  using namespace rowwise_quantized;
+  CHECK_EQ(in_shape->size(), 3U);
+  CHECK_EQ(out_shape->size(), 1U);
+  const mxnet::TShape &lshape = (*in_shape)[kLhs];
+  const mxnet::TShape &rshape = (*in_shape)[kRhs];
+  if (!shape_is_known(lshape) || !shape_is_known(rshape)) return false;
+  CHECK_GE(lshape.ndim(), 2) << "lhs must be (..., depth)";
+  CHECK_EQ(rshape.ndim(), 2) << "rhs must be (depth, cols)";
+  CHECK_EQ(lshape[lshape.ndim() - 1], rshape[0])
+      << "dot shape error: " << lshape << " X " << rshape;
+  SHAPE_ASSIGN_CHECK(*in_shape, kRhsScale, mshadow::Shape1(rshape[0]));
+  mxnet::TShape oshape(lshape);
+  oshape[lshape.ndim() - 1] = rshape[1];
+  SHAPE_ASSIGN_CHECK(*out_shape, 0, oshape);
+  return true;
+}
+
+static bool RowwiseQuantizedDotType(const nnvm::NodeAttrs& attrs,
+                                    std::vector<int> *in_type,
+                                    std::vector<int> *out_type) {
+  using namespace rowwise_quantized;
+  CHECK_EQ(in_type->size(), 3U);
+  CHECK_EQ(out_type->size(), 1U);
+  TYPE_ASSIGN_CHECK(*in_type, kLhs, mshadow::kFloat32);
+  TYPE_ASSIGN_CHECK(*in_type, kRhs, mshadow::kInt8);
+  TYPE_ASSIGN_CHECK(*in_type, kRhsScale, mshadow::kFloat32);
+  TYPE_ASSIGN_CHECK(*out_type, 0, mshadow::kFloat32);
+  return true;
+}
+
+static bool RowwiseQuantizedDotStorageType(const nnvm::NodeAttrs& attrs,
+                                           const int dev_mask,
+                                           DispatchMode* dispatch_mode,
+                                           std::vector<int>* in_attrs,
+                                           std::vector<int>* out_attrs) {
+  using namespace rowwise_quantized;
+  CHECK_EQ(in_attrs->size(), 3U);
+  CHECK_EQ(out_attrs->size(), 1U);
+  const int lhs_stype = in_attrs->at(kLhs);
+  if (lhs_stype != kDefaultStorage && lhs_stype != kCSRStorage) return false;
+  if (!type_assign(&in_attrs->at(kRhs), kDefaultStorage) ||
+      !type_assign(&in_attrs->at(kRhsScale), kDefaultStorage))
+    return false;
+  return storage_type_assign(&out_attrs->at(0), kDefaultStorage,
+                             dispatch_mode, DispatchMode::kFComputeEx);
+}
+
+NNVM_REGISTER_OP(_contrib_rowwise_quantized_embedding)
+.describe(R"code(Maps integer indices to the rows of an int8 table, dequantized by the
+float32 scale of their row.
+
+The output is ``weight[data] * scale[data][..., None]`` in float32, of shape
+data.shape + (output_dim,), so a table takes a quarter of the memory of its float32
+version and its lookups need no separate dequantize. Indices out of range are clipped.
+
+The weight may be row_sparse, the rows it does not hold then give zeros. The tables are
+made by the WeightOnlyQuantize pass of ``optimize_for`` from the weight of ``Embedding``.
+)code" ADD_FILELINE)
+.set_num_inputs(3)
+.set_num_outputs(1)
+.set_attr_parser(ParamParser<RowwiseQuantizedEmbeddingParam>)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    return std::vector<std::string>{"data", "weight", "scale"};
+  })
+.set_attr<mxnet::FInferShape>("FInferShape", RowwiseQuantizedEmbeddingShape)
+.set_attr<nnvm::FInferType>("FInferType", RowwiseQuantizedEmbeddingType)
+.set_attr<FInferStorageType>("FInferStorageType", RowwiseQuantizedEmbeddingStorageType)
+.set_attr<FComputeEx>("FComputeEx<cpu>", RowwiseQuantizedEmbeddingForwardEx<cpu>)
+.set_attr<nnvm::FGradient>("FGradient", MakeZeroGradNodes)
+.add_argument("data", "NDArray-or-Symbol", "The input array to the embedding operator.")
+.add_argument("weight", "NDArray-or-Symbol", "The int8 embedding table.")
+.add_argument("scale", "NDArray-or-Symbol", "The float32 scale of each row of the table.")
+.add_arguments(RowwiseQuantizedEmbeddingParam::__FIELDS__());
+
+NNVM_REGISTER_OP(_contrib_rowwise_quantized_embedding_bag)
+.describe(R"code(Maps bags of integer indices to the sum or the mean of the rows of an
+int8 table, dequantized by the float32 scale of their row.
+
+The bags are given like the ones of ``EmbeddingBag``: ``offsets`` holds the position in
+``data`` of the first index of each bag, followed by the number of indices. The rows are
+dequantized while they are pooled, into a float32 output of shape (B, output_dim).
+
+The weight may be row_sparse, the rows it does not hold then count as zeros.
+)code" ADD_FILELINE)
+.set_num_inputs(4)
+.set_num_outputs(1)
+.set_attr_parser(ParamParser<RowwiseQuantizedEmbeddingBagParam>)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    return std::vector<std::string>{"data", "offsets", "weight", "scale"};
+  })
+.set_attr<mxnet::FInferShape>("FInferShape", RowwiseQuantizedEmbeddingBagShape)
+.set_attr<nnvm::FInferType>("FInferType", RowwiseQuantizedEmbeddingBagType)
+.set_attr<FInferStorageType>("FInferStorageType", RowwiseQuantizedEmbeddingBagStorageType)
+.set_attr<FComputeEx>("FComputeEx<cpu>", RowwiseQuantizedEmbeddingBagForwardEx<cpu>)
+.set_attr<nnvm::FGradient>("FGradient", MakeZeroGradNodes)
+.add_argument("data", "NDArray-or-Symbol", "The indices of the rows of the bags.")
+.add_argument("offsets", "NDArray-or-Symbol", "The start offsets of the bags, followed by "
+              "the end offset of the last one.")
+.add_argument("weight", "NDArray-or-Symbol", "The int8 embedding table.")
+.add_argument("scale", "NDArray-or-Symbol", "The float32 scale of each row of the table.")
+.add_arguments(RowwiseQuantizedEmbeddingBagParam::__FIELDS__());
+
+NNVM_REGISTER_OP(_contrib_rowwise_quantized_dot)
+.describe(R"code(Dot product of a float32 lhs, csr or dense, and an int8 rhs dequantized
+by the float32 scale of its rows.
+
+``out = dot(lhs, rhs * scale[:, None])`` of shape lhs.shape[:-1] + (rhs.shape[1],). With a
+csr lhs, every stored value reads and dequantizes one row of rhs while accumulating it, the
+same as ``dot(csr, dns)``. A dense lhs multiplies the dequantized rhs.
+)code" ADD_FILELINE)
+.set_num_inputs(3)
+.set_num_outputs(1)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    return std::vector<std::string>{"lhs", "rhs", "rhs_scale"};
+  })
+.set_attr<mxnet::FInferShape>("FInferShape", RowwiseQuantizedDotShape)
+.set_attr<nnvm::FInferType>("FInferType", RowwiseQuantizedDotType)
+.set_attr<FInferStorageType>("FInferStorageType", RowwiseQuantizedDotStorageType)
+.set_attr<FResourceRequest>("FResourceRequest",
+  [](const NodeAttrs& attrs) {
+    return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
+  })
+.set_attr<FComputeEx>("FComputeEx<cpu>", RowwiseQuantizedDotForwardEx<cpu>)
+.set_attr<nnvm::FGradient>("FGradient", MakeZeroGradNodes)
+.add_argument("lhs", "NDArray-or-Symbol", "The float32 lhs, csr or dense.")
+.add_argument("rhs", "NDArray-or-Symbol", "The int8 rhs.")
+.add_argument("rhs_scale", "NDArray-or-Symbol", "The float32 scale of each row of rhs.");
+
+}  // namespace op
+}  // namespace mxnet
@@ -0,0 +1,39 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file rowwise_quantized_ops.cu
+ * \brief Embedding, EmbeddingBag and dot(csr, dns) with int8 tables scaled row by row
+ */
+#include "./rowwise_quantized_ops-inl.h"
+
+namespace mxnet {
+namespace op {
+
+NNVM_REGISTER_OP(_contrib_rowwise_quantized_embedding)
+.set_attr<FComputeEx>("FComputeEx<gpu>", RowwiseQuantizedEmbeddingForwardEx<gpu>);
+
+NNVM_REGISTER_OP(_contrib_rowwise_quantized_embedding_bag)
+.set_attr<FComputeEx>("FComputeEx<gpu>", RowwiseQuantizedEmbeddingBagForwardEx<gpu>);
+
+NNVM_REGISTER_OP(_contrib_rowwise_quantized_dot)
+.set_attr<FComputeEx>("FComputeEx<gpu>", RowwiseQuantizedDotForwardEx<gpu>);
+
+}  // namespace op
+}  // namespace mxnet
@@ -0,0 +1,353 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file weight_only_quantize_pass.cc
+ * \brief Quantize the weights of FullyConnected and batch_dot of a float model
+ *
+ *  The pass is applied through optimize_for with the name WeightOnlyQuantize. The weight
+ *  of a FullyConnected, and the 3D rhs of a batch_dot without transpose_a, given in args
+ *  are quantized to `num_bits` (8, the default, or 4) with one scale per row and group of
+ *  `group_size` (default 128) values along the reduced axis. The nodes become
+ *  _contrib_weight_only_fully_connected and _contrib_weight_only_batch_dot reading the new
+ *  args. The nodes named in the comma-separated option `exclude` are kept in float.
+ *
+ *  The tables of Embedding and EmbeddingBag, and the 2D rhs of a dot without transposes,
+ *  are quantized to int8 with one scale per row whatever `num_bits`, and the nodes become
+ *  _contrib_rowwise_quantized_embedding, _contrib_rowwise_quantized_embedding_bag and
+ *  _contrib_rowwise_quantized_dot, which dequantize the rows they read.
+ */
+
+#include <mxnet/base.h>
+#include <mxnet/ndarray.h>
+#include <nnvm/graph.h>
+#include <nnvm/pass.h>
+#include <nnvm/symbolic.h>
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "../nn/fully_connected-inl.h"
+#include "../tensor/dot-inl.h"
+#include "../tensor/indexing_op.h"
+#include "./rowwise_quantized_ops-inl.h"
+#include "./weight_only_quantized_ops-inl.h"
+
+namespace mxnet {
+namespace op {
+
+namespace {
+
+using nnvm::Graph;
+using nnvm::NodeEntry;
+using nnvm::ObjectPtr;
+
+std::unordered_set<std::string> SplitNames(const std::string& names) {
+  std::unordered_set<std::string> ret;
+  std::istringstream is(names);
+  std::string name;
+  while (std::getline(is, name, ',')) {
+    if (!name.empty()) ret.insert(name);
+  }
+  return ret;
+}
+
+/*! \brief The values of a float array, read on the CPU. */
+std::vector<float> ReadValues(const NDArray& array) {
+  std::vector<float> values(array.shape().Size());
+  MSHADOW_REAL_TYPE_SWITCH(array.dtype(), DType, {
+    std::vector<DType> raw(values.size());
+    array.SyncCopyToCPU(raw.data(), raw.size());
+    std::transform(raw.begin(), raw.end(), values.begin(),
+                   [](DType v) { return static_cast<float>(v); });
+  });
+  return values;
+}
+
+/*!
+ * \brief A weight of rows x depth values quantized row by row, in the layout of the
+ *        weight only ops.
+ */
+struct QuantizedWeight {
+  std::vector<int8_t> data;
+  std::vector<float> scale;
+
+  QuantizedWeight(const std::vector<float>& values, index_t rows, index_t depth,
+                  int num_bits, index_t group_size) {
+    const index_t row_bytes = WeightOnlyRowBytes(depth, num_bits);
+    const index_t num_groups = WeightOnlyNumGroups(depth, group_size);
+    const float qmax = num_bits == 4 ? 7.0f : 127.0f;
+    data.assign(rows * row_bytes, 0);
+    scale.assign(rows * num_groups, 0.0f);
+    for (index_t r = 0; r < rows; ++r) {
+      const float* row = values.data() + r * depth;
+      for (index_t g = 0; g < num_groups; ++g) {
+        const index_t begin = g * group_size;
+        const index_t end = std::min(depth, begin + group_size);
+        float max_abs = 0.0f;
+        for (index_t k = begin; k < end; ++k) max_abs = std::max(max_abs, std::fabs(row[k]));
+        scale[r * num_groups + g] = max_abs / qmax;
+        // an all-zero group keeps zero codes and a zero scale
+        const float inv_scale = max_abs > 0.0f ? qmax / max_abs : 0.0f;
+        for (index_t k = begin; k < end; ++k) {
+          const float q = std::max(-qmax, std::min(qmax, std::round(row[k] * inv_scale)));
+          const int code = static_cast<int>(q);
+          if (num_bits == 4) {
+            uint8_t& byte = reinterpret_cast<uint8_t&>(data[r * row_bytes + k / 2]);
+            byte |= (k % 2) ? static_cast<uint8_t>((code & 0xF) << 4)
+                            : static_cast<uint8_t>(code & 0xF);
+          } else {
+            data[r * row_bytes + k] = static_cast<int8_t>(code);
+          }
+        }
+      }
+    }
+  }
+};
+
+}  // namespace
+
+Graph WeightOnlyQuantize(Graph&& g) {
+  using OptionsMap = std::unordered_map<std::string, std::string>;
+  static const nnvm::Op* fc_op = nnvm::Op::Get("FullyConnected");
+  static const nnvm::Op* batch_dot_op = nnvm::Op::Get("batch_dot");
+  static const nnvm::Op* wo_fc_op = nnvm::Op::Get("_contrib_weight_only_fully_connected");
+  static const nnvm::Op* wo_batch_dot_op = nnvm::Op::Get("_contrib_weight_only_batch_dot");
+  static const nnvm::Op* embedding_op = nnvm::Op::Get("Embedding");
+  static const nnvm::Op* embedding_bag_op = nnvm::Op::Get("EmbeddingBag");
+  static const nnvm::Op* dot_op = nnvm::Op::Get("dot");
+  static const nnvm::Op* rw_embedding_op = nnvm::Op::Get("_contrib_rowwise_quantized_embedding");
+  static const nnvm::Op* rw_embedding_bag_op =
+      nnvm::Op::Get("_contrib_rowwise_quantized_embedding_bag");
+  static const nnvm::Op* rw_dot_op = nnvm::Op::Get("_contrib_rowwise_quantized_dot");
+  static const std::unordered_set<const nnvm::Op*> quantized_ops{
+    fc_op, batch_dot_op, embedding_op, embedding_bag_op, dot_op};
+  const auto& options = g.GetAttr<OptionsMap>("options_map");
+  auto option = [&options](const char* key, const std::string& value) {
+    auto it = options.find(key);
+    return it == options.end() ? value : it->second;
+  };
+  const auto excluded = SplitNames(option("exclude", ""));
+  const int num_bits = std::stoi(option("num_bits", "8"));
+  const index_t group_size = std::stol(option("group_size", "128"));
+  CHECK(num_bits == 8 || num_bits == 4) << "num_bits must be 8 or 4, got " << num_bits;
+  CHECK_GT(group_size, 0) << "group_size must be positive";
+
+  std::unordered_map<std::string, NDArray*> args;
+  NDArray** arrays = g.GetAttr<NDArray**>("in_args");
+  const auto& names = g.GetAttr<std::vector<std::string> >("in_arg_names");
+  for (size_t i = 0; arrays != nullptr && i < names.size(); ++i) {
+    if (arrays[i] != nullptr) args[names[i]] = arrays[i];
+  }
+
+  std::unordered_set<std::string> input_names;
+  std::vector<ObjectPtr> nodes;
+  DFSVisit(g.outputs, [&](const ObjectPtr& n) {
+    if (n->is_variable()) {
+      input_names.insert(n->attrs.name);
+    } else if (quantized_ops.count(n->op()) && !excluded.count(n->attrs.name)) {
+      nodes.push_back(n);
+    }
+  });
+
+  std::vector<NDArray*> new_args;
+  std::vector<std::string> new_arg_names;
+  std::unordered_map<std::string, std::vector<NodeEntry> > quantized;
+  // quantize the weight of the variable once, (batch, cols, depth) after the transposition
+  auto quantize = [&](const std::string& name, const NDArray& weight, bool transposed) {
+    if (quantized.count(name)) return;
+    const mxnet::TShape& shape = weight.shape();
+    const index_t batch = shape.ndim() == 3 ? shape[0] : 1;
+    const index_t cols = transposed ? shape[shape.ndim() - 2] : shape[shape.ndim() - 1];
+    const index_t depth = transposed ? shape[shape.ndim() - 1] : shape[shape.ndim() - 2];
+    std::vector<float> values = ReadValues(weight);
+    if (!transposed) {
+      std::vector<float> rows(values.size());
+      for (index_t b = 0; b < batch; ++b) {
+        for (index_t k = 0; k < depth; ++k) {
+          for (index_t n = 0; n < cols; ++n) {
+            rows[(b * cols + n) * depth + k] = values[(b * depth + k) * cols + n];
+          }
+        }
+      }
+      values.swap(rows);
+    }
+    const QuantizedWeight q(values, batch * cols, depth, num_bits, group_size);
+    mxnet::TShape qshape(shape.ndim(), -1);
+    mxnet::TShape sshape(shape.ndim(), -1);
+    if (shape.ndim() == 3) qshape[0] = sshape[0] = batch;
+    qshape[shape.ndim() - 2] = sshape[shape.ndim() - 2] = cols;
+    qshape[shape.ndim() - 1] = WeightOnlyRowBytes(depth, num_bits);
+    sshape[shape.ndim() - 1] = WeightOnlyNumGroups(depth, group_size);
+    NDArray* qweight = new NDArray(qshape, weight.ctx(), false, mshadow::kInt8);
+    qweight->SyncCopyFromCPU(q.data.data(), q.data.size());
+    NDArray* scale = new NDArray(sshape, weight.ctx(), false, mshadow::kFloat32);
+    scale->SyncCopyFromCPU(q.scale.data(), q.scale.size());
+    std::vector<NodeEntry> entries;
+    for (const std::string& suffix : {"_quantized", "_scale"}) {
+      std::string new_name = name + suffix;
+      while (input_names.count(new_name)) new_name += "_";
+      input_names.insert(new_name);
+      entries.push_back(nnvm::Symbol::CreateVariable(new_name).outputs[0]);
+      new_arg_names.push_back(new_name);
+    }
+    new_args.push_back(qweight);
+    new_args.push_back(scale);
+    quantized[name] = std::move(entries);
+  };
+  // quantize the (rows, row_length) table of the variable once, with a scale per row
+  std::unordered_map<std::string, std::vector<NodeEntry> > rowwise;
+  auto quantize_rows = [&](const std::string& name, const NDArray& weight) {
+    if (rowwise.count(name)) return;
+    const mxnet::TShape& shape = weight.shape();
+    const QuantizedWeight q(ReadValues(weight), shape[0], shape[1], 8, shape[1]);
+    NDArray* qweight = new NDArray(shape, weight.ctx(), false, mshadow::kInt8);
+    qweight->SyncCopyFromCPU(q.data.data(), q.data.size());
+    NDArray* scale = new NDArray(mshadow::Shape1(shape[0]), weight.ctx(), false,
+                                 mshadow::kFloat32);
+    scale->SyncCopyFromCPU(q.scale.data(), q.scale.size());
+    std::vector<NodeEntry> entries;
+    for (const std::string& suffix : {"_quantized", "_scale"}) {
+      std::string new_name = name + suffix;
+      while (input_names.count(new_name)) new_name += "_";
+      input_names.insert(new_name);
+      entries.push_back(nnvm::Symbol::CreateVariable(new_name).outputs[0]);
+      new_arg_names.push_back(new_name);
+    }
+    new_args.push_back(qweight);
+    new_args.push_back(scale);
+    rowwise[name] = std::move(entries);
+  };
+  auto supported = [&](const NodeEntry& e, int ndim, bool transposed) -> const NDArray* {
+    if (!e.node->is_variable()) return nullptr;
+    auto it = args.find(e.node->attrs.name);
+    if (it == args.end()) return nullptr;
+    const NDArray& w = *it->second;
+    const mxnet::TShape& shape = w.shape();
+    if (w.storage_type() != kDefaultStorage || shape.ndim() != ndim ||
+        (w.dtype() != mshadow::kFloat32 && w.dtype() != mshadow::kFloat16))
+      return nullptr;
+    const index_t depth = transposed ? shape[ndim - 1] : shape[ndim - 2];
+    return num_bits == 4 && depth % 2 ? nullptr : it->second;
+  };
+  // the row-wise ops take dense float32 tables
+  auto table = [&](const NodeEntry& e) -> const NDArray* {
+    if (!e.node->is_variable()) return nullptr;
+    auto it = args.find(e.node->attrs.name);
+    if (it == args.end()) return nullptr;
+    const NDArray& w = *it->second;
+    return w.storage_type() == kDefaultStorage && w.shape().ndim() == 2 &&
+           w.dtype() == mshadow::kFloat32 ? it->second : nullptr;
+  };
+
+  for (const ObjectPtr& n : nodes) {
+    nnvm::NodeAttrs attrs;
+    attrs.name = n->attrs.name;
+    attrs.dict["num_bits"] = std::to_string(num_bits);
+    attrs.dict["group_size"] = std::to_string(group_size);
+    std::vector<NodeEntry> inputs;
+    if (n->op() == fc_op) {
+      const auto& param = nnvm::get<FullyConnectedParam>(n->attrs.parsed);
+      const NodeEntry& weight = n->inputs[fullc::kWeight];
+      const NDArray* value = supported(weight, 2, true);
+      if (value == nullptr) continue;
+      quantize(weight.node->attrs.name, *value, true);
+      attrs.op = wo_fc_op;
+      attrs.dict["num_hidden"] = std::to_string(param.num_hidden);
+      attrs.dict["no_bias"] = param.no_bias ? "True" : "False";
+      attrs.dict["flatten"] = param.flatten ? "True" : "False";
+      inputs.push_back(n->inputs[fullc::kData]);
+      const auto& entries = quantized[weight.node->attrs.name];
+      inputs.insert(inputs.end(), entries.begin(), entries.end());
+      if (!param.no_bias) inputs.push_back(n->inputs[fullc::kBias]);
+    } else if (n->op() == embedding_op || n->op() == embedding_bag_op) {
+      const bool bag = n->op() == embedding_bag_op;
+      const NodeEntry& weight = n->inputs[bag ? embedding_bag::kWeight : embedding::kWeight];
+      const NDArray* value = table(weight);
+      if (value == nullptr) continue;
+      quantize_rows(weight.node->attrs.name, *value);
+      attrs.dict.clear();
+      attrs.dict["input_dim"] = std::to_string(value->shape()[0]);
+      attrs.dict["output_dim"] = std::to_string(value->shape()[1]);
+      if (bag) {
+        const auto& param = nnvm::get<EmbeddingBagParam>(n->attrs.parsed);
+        attrs.op = rw_embedding_bag_op;
+        attrs.dict["mode"] = param.mode == embedding_bag::kMean ? "mean" : "sum";
+        inputs.push_back(n->inputs[embedding_bag::kData]);
+        inputs.push_back(n->inputs[embedding_bag::kOffsets]);
+      } else {
+        attrs.op = rw_embedding_op;
+        inputs.push_back(n->inputs[embedding::kData]);
+      }
+      const auto& entries = rowwise[weight.node->attrs.name];
+      inputs.insert(inputs.end(), entries.begin(), entries.end());
+    } else if (n->op() == dot_op) {
+      const auto& param = nnvm::get<DotParam>(n->attrs.parsed);
+      const NodeEntry& rhs = n->inputs[1];
+      const NDArray* value = param.transpose_a || param.transpose_b ||
+                             param.forward_stype.has_value() ? nullptr : table(rhs);
+      if (value == nullptr) continue;
+      quantize_rows(rhs.node->attrs.name, *value);
+      attrs.dict.clear();
+      attrs.op = rw_dot_op;
+      inputs.push_back(n->inputs[0]);
+      const auto& entries = rowwise[rhs.node->attrs.name];
+      inputs.insert(inputs.end(), entries.begin(), entries.end());
+    } else {
+      const auto& param = nnvm::get<DotParam>(n->attrs.parsed);
+      const NodeEntry& rhs = n->inputs[1];
+      const NDArray* value = param.transpose_a ? nullptr : supported(rhs, 3, param.transpose_b);
+      if (value == nullptr) continue;
+      quantize(rhs.node->attrs.name, *value, param.transpose_b);
+      attrs.op = wo_batch_dot_op;
+      inputs.push_back(n->inputs[0]);
+      const auto& entries = quantized[rhs.node->attrs.name];
+      inputs.insert(inputs.end(), entries.begin(), entries.end());
+    }
+    attrs.op->attr_parser(&attrs);
+    // the node is converted in place, so that its consumers need no rewiring
+    n->attrs = std::move(attrs);
+    n->inputs = std::move(inputs);
+  }
+
+  Graph ret;
+  ret.outputs = g.outputs;
+  ret.attrs["new_args"] = std::make_shared<nnvm::any>(std::move(new_args));
+  ret.attrs["new_arg_names"] = std::make_shared<nnvm::any>(std::move(new_arg_names));
+  ret.attrs["new_aux"] = std::make_shared<nnvm::any>(std::vector<NDArray*>());
+  ret.attrs["new_aux_names"] = std::make_shared<nnvm::any>(std::vector<std::string>());
+  return ret;
+}
+
+NNVM_REGISTER_PASS(WeightOnlyQuantize)
+.describe("Quantize the weights of FullyConnected and batch_dot given in args to int8 or "
+          "int4 with group-wise scales, and the tables of Embedding, EmbeddingBag and dot "
+          "to int8 with row-wise scales.")
+.set_body(WeightOnlyQuantize)
+.set_change_graph(true)
+.depend_graph_attr("options_map")
+.depend_graph_attr("in_args");
+
+}  // namespace op
+}  // namespace mxnet
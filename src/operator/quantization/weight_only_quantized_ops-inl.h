@@ -0,0 +1,324 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file weight_only_quantized_ops-inl.h
+ * \brief FullyConnected and batch_dot with int8 or int4 weights and float activations
+ *
+ *  The weight is stored as (batch, rows, depth) int8 values, or as two int4 values per
+ *  byte, the even depth index in the low nibble, with one float32 scale per row and
+ *  group of group_size along the depth. The activations, the bias and the output are
+ *  float32 or float16 and the products are accumulated in float32. Small batches, which
+ *  are bound by the weight loads, read the quantized weight directly; larger float32
+ *  batches dequantize the weight into temporary space and use a GEMM.
+ */
+#ifndef MXNET_OPERATOR_QUANTIZATION_WEIGHT_ONLY_QUANTIZED_OPS_INL_H_
+#define MXNET_OPERATOR_QUANTIZATION_WEIGHT_ONLY_QUANTIZED_OPS_INL_H_
+
+#include <mxnet/operator_util.h>
+#include <type_traits>
+#include <vector>
+#include "../linalg.h"
+#include "../mxnet_op.h"
+#include "../operator_common.h"
+
+namespace mxnet {
+namespace op {
+
+namespace weight_only {
+enum WeightOnlyFCInputs {kData, kWeight, kScale, kBias};
+enum WeightOnlyBatchDotInputs {kLhs, kRhs, kRhsScale};
+enum WeightOnlyResource {kTempSpace};
+/*! \brief up to this number of rows the quantized weight is read directly */
+const index_t kFusedMaxRows = 16;
+}  // namespace weight_only
+
+struct WeightOnlyFCParam : public dmlc::Parameter<WeightOnlyFCParam> {
+  int num_hidden;
+  bool no_bias;
+  bool flatten;
+  int num_bits;
+  int group_size;
+  DMLC_DECLARE_PARAMETER(WeightOnlyFCParam) {
+    DMLC_DECLARE_FIELD(num_hidden).set_lower_bound(1)
+    .describe("Number of hidden nodes of the output.");
+    DMLC_DECLARE_FIELD(no_bias).set_default(false)
+    .describe("Whether to disable bias parameter.");
+    DMLC_DECLARE_FIELD(flatten).set_default(true)
+    .describe("Whether to collapse all but the first axis of the input data tensor.");
+    DMLC_DECLARE_FIELD(num_bits).set_default(8)
+    .describe("Bits of the quantized weight, 8 or 4.");
+    DMLC_DECLARE_FIELD(group_size).set_lower_bound(1).set_default(128)
+    .describe("Number of consecutive inputs of a weight row sharing a scale.");
+  }
+};
+
+struct WeightOnlyBatchDotParam : public dmlc::Parameter<WeightOnlyBatchDotParam> {
+  int num_bits;
+  int group_size;
+  DMLC_DECLARE_PARAMETER(WeightOnlyBatchDotParam) {
+    DMLC_DECLARE_FIELD(num_bits).set_default(8)
+    .describe("Bits of the quantized rhs, 8 or 4.");
+    DMLC_DECLARE_FIELD(group_size).set_lower_bound(1).set_default(128)
+    .describe("Number of consecutive elements along the reduced axis of rhs sharing a scale.");
+  }
+};
+
+/*! \brief Number of bytes of a weight row of depth values. */
+inline index_t WeightOnlyRowBytes(index_t depth, int num_bits) {
+  return num_bits == 4 ? depth / 2 : depth;
+}
+
+inline index_t WeightOnlyNumGroups(index_t depth, int group_size) {
+  return (depth + group_size - 1) / group_size;
+}
+
+/*! \brief The quantized value at index k of a weight row. */
+template<int num_bits>
+MSHADOW_XINLINE int WeightOnlyValue(const int8_t *row, index_t k) {
+  if (num_bits == 4) {
+    const int8_t byte = row[k / 2];
+    // sign extend the nibble
+    return (k % 2) ? (byte >> 4)
+                   : (static_cast<int8_t>(static_cast<uint8_t>(byte) << 4) >> 4);
+  }
+  return row[k];
+}
+
+/*!
+ * \brief out[b, m, n] = sum_k data[b, m, k] * weight[b, n, k] * scale[b, n, k / group],
+ *        plus bias[n] when given, one output element per index.
+ */
+template<int num_bits>
+struct weight_only_dot {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(index_t i, DType *out, const DType *data,
+                                  const int8_t *weight, const float *scale, const DType *bias,
+                                  const index_t rows, const index_t cols, const index_t depth,
+                                  const index_t group_size, const OpReqType req) {
+    const index_t n = i % cols;
+    const index_t bm = i / cols;
+    const index_t b = bm / rows;
+    const index_t num_groups = (depth + group_size - 1) / group_size;
+    const DType *x = data + bm * depth;
+    const int8_t *w = weight + (b * cols + n) * (num_bits == 4 ? depth / 2 : depth);
+    const float *s = scale + (b * cols + n) * num_groups;
+    float sum = 0.0f;
+    for (index_t g = 0; g < num_groups; ++g) {
+      const index_t end = (g + 1) * group_size < depth ? (g + 1) * group_size : depth;
+      float group_sum = 0.0f;
+      for (index_t k = g * group_size; k < end; ++k) {
+        group_sum += static_cast<float>(x[k]) * WeightOnlyValue<num_bits>(w, k);
+      }
+      sum += group_sum * s[g];
+    }
+    if (bias != nullptr) sum += static_cast<float>(bias[n]);
+    KERNEL_ASSIGN(out[i], req, DType(sum));
+  }
+};
+
+/*! \brief Dequantizes the weight of (batch * cols, depth) values. */
+template<int num_bits>
+struct weight_only_dequantize {
+  MSHADOW_XINLINE static void Map(index_t i, float *out, const int8_t *weight,
+                                  const float *scale, const index_t depth,
+                                  const index_t group_size) {
+    const index_t row = i / depth;
+    const index_t k = i % depth;
+    const index_t num_groups = (depth + group_size - 1) / group_size;
+    const int8_t *w = weight + row * (num_bits == 4 ? depth / 2 : depth);
+    out[i] = WeightOnlyValue<num_bits>(w, k) * scale[row * num_groups + k / group_size];
+  }
+};
+
+struct weight_only_add_bias {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(index_t i, DType *out, const DType *bias, const index_t cols) {
+    out[i] += bias[i % cols];
+  }
+};
+
+template<int num_bits, typename DType>
+void WeightOnlyFusedDot(mshadow::Stream<cpu> *s, DType *out, const DType *data,
+                        const int8_t *weight, const float *scale, const DType *bias,
+                        index_t batch, index_t rows, index_t cols, index_t depth,
+                        index_t group_size, OpReqType req) {
+  mxnet_op::Kernel<weight_only_dot<num_bits>, cpu>::Launch(
+      s, batch * rows * cols, out, data, weight, scale, bias, rows, cols, depth, group_size,
+      req);
+}
+
+#ifdef __CUDACC__
+/*!
+ * \brief One warp per output element, whose lanes read consecutive weights so that
+ *        the loads of the quantized weight are coalesced.
+ */
+template<int num_bits, typename DType>
+__global__ void WeightOnlyDotWarpKernel(DType *out, const DType *data, const int8_t *weight,
+                                        const float *scale, const DType *bias,
+                                        const index_t size, const index_t rows,
+                                        const index_t cols, const index_t depth,
+                                        const index_t group_size, const OpReqType req) {
+  const index_t i = (static_cast<index_t>(blockIdx.x) * blockDim.x + threadIdx.x) / warpSize;
+  const int lane = threadIdx.x % warpSize;
+  if (i >= size) return;
+  const index_t n = i % cols;
+  const index_t bm = i / cols;
+  const index_t b = bm / rows;
+  const index_t num_groups = (depth + group_size - 1) / group_size;
+  const DType *x = data + bm * depth;
+  const int8_t *w = weight + (b * cols + n) * (num_bits == 4 ? depth / 2 : depth);
+  const float *s = scale + (b * cols + n) * num_groups;
+  float sum = 0.0f;
+  for (index_t k = lane; k < depth; k += warpSize) {
+    sum += static_cast<float>(x[k]) * WeightOnlyValue<num_bits>(w, k) * s[k / group_size];
+  }
+  for (int offset = warpSize / 2; offset > 0; offset /= 2) {
+    sum += __shfl_down_sync(0xffffffff, sum, offset);
+  }
+  if (lane == 0) {
+    if (bias != nullptr) sum += static_cast<float>(bias[n]);
+    KERNEL_ASSIGN(out[i], req, DType(sum));
+  }
+}
+
+template<int num_bits, typename DType>
+void WeightOnlyFusedDot(mshadow::Stream<gpu> *s, DType *out, const DType *data,
+                        const int8_t *weight, const float *scale, const DType *bias,
+                        index_t batch, index_t rows, index_t cols, index_t depth,
+                        index_t group_size, OpReqType req) {
+  const index_t size = batch * rows * cols;
+  const int threads = mshadow::cuda::kBaseThreadNum;
+  const index_t warps_per_block = threads / 32;
+  const index_t blocks = (size + warps_per_block - 1) / warps_per_block;
+  WeightOnlyDotWarpKernel<num_bits, DType>
+      <<<static_cast<int>(blocks), threads, 0, mshadow::Stream<gpu>::GetStream(s)>>>(
+      out, data, weight, scale, bias, size, rows, cols, depth, group_size, req);
+  MSHADOW_CUDA_POST_KERNEL_CHECK(WeightOnlyDotWarpKernel);
+}
+#endif  // __CUDACC__
+
+/*!
+ * \brief out (batch, rows, cols) = data (batch, rows, depth) times the transposed
+ *        dequantized weight (batch, cols, depth), plus bias (cols,) when given.
+ */
+template<typename xpu, int num_bits, typename DType>
+void WeightOnlyDot(const OpContext &ctx, const TBlob &data, const TBlob &weight,
+                   const TBlob &scale, const TBlob *bias, const TBlob &out, OpReqType req,
+                   index_t batch, index_t rows, index_t cols, index_t depth,
+                   index_t group_size) {
+  using namespace mshadow;
+  Stream<xpu> *s = ctx.get_stream<xpu>();
+  const DType *bias_ptr = bias != nullptr ? bias->dptr<DType>() : nullptr;
+  if (!std::is_same<DType, float>::value || rows <= weight_only::kFusedMaxRows) {
+    WeightOnlyFusedDot<num_bits, DType>(s, out.dptr<DType>(), data.dptr<DType>(),
+                                        weight.dptr<int8_t>(), scale.dptr<float>(), bias_ptr,
+                                        batch, rows, cols, depth, group_size, req);
+    return;
+  }
+  Tensor<xpu, 3, float> dequantized = ctx.requested[weight_only::kTempSpace]
+      .get_space_typed<xpu, 3, float>(Shape3(batch, cols, depth), s);
+  mxnet_op::Kernel<weight_only_dequantize<num_bits>, xpu>::Launch(
+      s, dequantized.shape_.Size(), dequantized.dptr_, weight.dptr<int8_t>(),
+      scale.dptr<float>(), depth, group_size);
+  // DType is float on this path
+  Tensor<xpu, 3, float> lhs(reinterpret_cast<float *>(data.dptr_), Shape3(batch, rows, depth), s);
+  Tensor<xpu, 3, float> dst(reinterpret_cast<float *>(out.dptr_), Shape3(batch, rows, cols), s);
+  linalg_batch_gemm(lhs, dequantized, dst, 1.0f, req == kAddTo ? 1.0f : 0.0f, false, true, s);
+  if (bias != nullptr) {
+    mxnet_op::Kernel<weight_only_add_bias, xpu>::Launch(
+        s, dst.shape_.Size(), dst.dptr_, reinterpret_cast<const float *>(bias_ptr), cols);
+  }
+}
+
+template<typename xpu, typename DType>
+void WeightOnlyDotBits(int num_bits, const OpContext &ctx, const TBlob &data,
+                       const TBlob &weight, const TBlob &scale, const TBlob *bias,
+                       const TBlob &out, OpReqType req, index_t batch, index_t rows,
+                       index_t cols, index_t depth, index_t group_size) {
+  if (num_bits == 4) {
+    WeightOnlyDot<xpu, 4, DType>(ctx, data, weight, scale, bias, out, req,
+                                 batch, rows, cols, depth, group_size);
+  } else {
+    WeightOnlyDot<xpu, 8, DType>(ctx, data, weight, scale, bias, out, req,
+                                 batch, rows, cols, depth, group_size);
+  }
+}
+
+template<typename xpu>
+void WeightOnlyFCForward(const nnvm::NodeAttrs &attrs,
+                         const OpContext &ctx,
+                         const std::vector<TBlob> &inputs,
+                         const std::vector<OpReqType> &req,
+                         const std::vector<TBlob> &outputs) {
+  using namespace weight_only;
+  const WeightOnlyFCParam &param = nnvm::get<WeightOnlyFCParam>(attrs.parsed);
+  CHECK_EQ(inputs.size(), param.no_bias ? 3U : 4U);
+  CHECK_EQ(outputs.size(), 1U);
+  if (req[0] == kNullOp) return;
+  CHECK_NE(req[0], kWriteInplace);
+  const TBlob &data = inputs[kData];
+  const index_t depth = param.flatten ? data.shape_.ProdShape(1, data.ndim())
+                                      : data.shape_[data.ndim() - 1];
+  const index_t rows = data.Size() / depth;
+  const TBlob *bias = param.no_bias ? nullptr : &inputs[kBias];
+  if (data.type_flag_ == mshadow::kFloat16) {
+    WeightOnlyDotBits<xpu, mshadow::half::half_t>(
+        param.num_bits, ctx, data, inputs[kWeight], inputs[kScale], bias, outputs[0], req[0],
+        1, rows, param.num_hidden, depth, param.group_size);
+  } else {
+    CHECK_EQ(data.type_flag_, mshadow::kFloat32)
+        << "_contrib_weight_only_fully_connected only supports float32 and float16 data";
+    WeightOnlyDotBits<xpu, float>(param.num_bits, ctx, data, inputs[kWeight], inputs[kScale],
+                                  bias, outputs[0], req[0], 1, rows, param.num_hidden, depth,
+                                  param.group_size);
+  }
+}
+
+template<typename xpu>
+void WeightOnlyBatchDotForward(const nnvm::NodeAttrs &attrs,
+                               const OpContext &ctx,
+                               const std::vector<TBlob> &inputs,
+                               const std::vector<OpReqType> &req,
+                               const std::vector<TBlob> &outputs) {
+  using namespace weight_only;
+  const WeightOnlyBatchDotParam &param = nnvm::get<WeightOnlyBatchDotParam>(attrs.parsed);
+  CHECK_EQ(inputs.size(), 3U);
+  CHECK_EQ(outputs.size(), 1U);
+  if (req[0] == kNullOp) return;
+  CHECK_NE(req[0], kWriteInplace);
+  const TBlob &lhs = inputs[kLhs];
+  const TBlob &rhs = inputs[kRhs];
+  if (lhs.type_flag_ == mshadow::kFloat16) {
+    WeightOnlyDotBits<xpu, mshadow::half::half_t>(
+        param.num_bits, ctx, lhs, rhs, inputs[kRhsScale], nullptr, outputs[0], req[0],
+        lhs.shape_[0], lhs.shape_[1], rhs.shape_[1], lhs.shape_[2], param.group_size);
+  } else {
+    CHECK_EQ(lhs.type_flag_, mshadow::kFloat32)
+        << "_contrib_weight_only_batch_dot only supports float32 and float16 lhs";
+    WeightOnlyDotBits<xpu, float>(param.num_bits, ctx, lhs, rhs, inputs[kRhsScale], nullptr,
+                                  outputs[0], req[0], lhs.shape_[0], lhs.shape_[1],
+                                  rhs.shape_[1], lhs.shape_[2], param.group_size);
+  }
+}
+
+}  // namespace op
+}  // namespace mxnet
+
+#endif  // MXNET_OPERATOR_QUANTIZATION_WEIGHT_ONLY_QUANTIZED_OPS_INL_H_
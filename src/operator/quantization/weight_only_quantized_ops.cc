@@ -0,0 +1,193 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file weight_only_quantized_ops.cc
+ * \brief FullyConnected and batch_dot with int8 or int4 weights and float activations
+ */
+#include "./weight_only_quantized_ops-inl.h"
+
+namespace mxnet {
+namespace op {
+
+DMLC_REGISTER_PARAMETER(WeightOnlyFCParam);
+DMLC_REGISTER_PARAMETER(WeightOnlyBatchDotParam);
+
+/*! \brief Assign the shapes of a quantized weight of (batch, cols, depth) values. */
+static void WeightOnlyWeightShape(mxnet::ShapeVector *in_shape, size_t weight, size_t scale,
+                                  int num_bits, int group_size, const mxnet::TShape &prefix,
+                                  index_t depth) {
+  CHECK(num_bits == 8 || num_bits == 4) << "num_bits must be 8 or 4, got " << num_bits;
+  if (num_bits == 4) {
+    CHECK_EQ(depth % 2, 0) << "int4 weights pack two values per byte, so the depth " << depth
+                           << " must be even";
+  }
+  mxnet::TShape wshape(prefix.ndim() + 1, -1);
+  mxnet::TShape sshape(prefix.ndim() + 1, -1);
+  for (int i = 0; i < prefix.ndim(); ++i) wshape[i] = sshape[i] = prefix[i];
+  wshape[prefix.ndim()] = WeightOnlyRowBytes(depth, num_bits);
+  sshape[prefix.ndim()] = WeightOnlyNumGroups(depth, group_size);
+  SHAPE_ASSIGN_CHECK(*in_shape, weight, wshape);
+  SHAPE_ASSIGN_CHECK(*in_shape, scale, sshape);
+}
+
+static bool WeightOnlyFCShape(const nnvm::NodeAttrs &attrs,
+                              mxnet::ShapeVector *in_shape,
+                              mxnet::ShapeVector *out_shape) {
+  using namespace weight_only;
+  const WeightOnlyFCParam &param = nnvm::get<WeightOnlyFCParam>(attrs.parsed);
+  CHECK_EQ(in_shape->size(), param.no_bias ? 3U : 4U);
+  CHECK_EQ(out_shape->size(), 1U);
+  const mxnet::TShape &dshape = (*in_shape)[kData];
+  if (!mxnet::shape_is_known(dshape)) return false;
+
+  const index_t depth = param.flatten ? dshape.ProdShape(1, dshape.ndim())
+                                      : dshape[dshape.ndim() - 1];
+  WeightOnlyWeightShape(in_shape, kWeight, kScale, param.num_bits, param.group_size,
+                        mshadow::Shape1(param.num_hidden), depth);
+  if (!param.no_bias) {
+    SHAPE_ASSIGN_CHECK(*in_shape, kBias, mshadow::Shape1(param.num_hidden));
+  }
+  if (param.flatten) {
+    SHAPE_ASSIGN_CHECK(*out_shape, 0, mshadow::Shape2(dshape[0], param.num_hidden));
+  } else {
+    mxnet::TShape oshape(dshape);
+    oshape[dshape.ndim() - 1] = param.num_hidden;
+    SHAPE_ASSIGN_CHECK(*out_shape, 0, oshape);
+  }
+  return true;
+}
+
+static bool WeightOnlyFCType(const nnvm::NodeAttrs &attrs,
+                             std::vector<int> *in_type,
+                             std::vector<int> *out_type) {
+  using namespace weight_only;
+  const WeightOnlyFCParam &param = nnvm::get<WeightOnlyFCParam>(attrs.parsed);
+  CHECK_EQ(in_type->size(), param.no_bias ? 3U : 4U);
+  CHECK_EQ(out_type->size(), 1U);
+  TYPE_ASSIGN_CHECK(*in_type, kWeight, mshadow::kInt8);
+  TYPE_ASSIGN_CHECK(*in_type, kScale, mshadow::kFloat32);
+  const int dtype = (*in_type)[kData];
+  if (dtype == -1) return false;
+  CHECK(dtype == mshadow::kFloat32 || dtype == mshadow::kFloat16)
+      << "_contrib_weight_only_fully_connected only supports float32 and float16 data";
+  if (!param.no_bias) TYPE_ASSIGN_CHECK(*in_type, kBias, dtype);
+  TYPE_ASSIGN_CHECK(*out_type, 0, dtype);
+  return true;
+}
+
+static bool WeightOnlyBatchDotShape(const nnvm::NodeAttrs &attrs,
+                                    mxnet::ShapeVector *in_shape,
+                                    mxnet::ShapeVector *out_shape) {
+  using namespace weight_only;
+  const WeightOnlyBatchDotParam &param = nnvm::get<WeightOnlyBatchDotParam>(attrs.parsed);
+  CHECK_EQ(in_shape->size(), 3U);
+  CHECK_EQ(out_shape->size(), 1U);
+  const mxnet::TShape &lshape = (*in_shape)[kLhs];
+  const mxnet::TShape &rshape = (*in_shape)[kRhs];
+  if (!mxnet::shape_is_known(lshape) || !mxnet::ndim_is_known(rshape) ||
+      !mxnet::dim_size_is_known(rshape, 1))
+    return false;
+  CHECK_EQ(lshape.ndim(), 3) << "lhs must be (batch, rows, depth)";
+  CHECK_EQ(rshape.ndim(), 3) << "rhs must be (batch, cols, depth bytes)";
+  WeightOnlyWeightShape(in_shape, kRhs, kRhsScale, param.num_bits, param.group_size,
+                        mshadow::Shape2(lshape[0], rshape[1]), lshape[2]);
+  SHAPE_ASSIGN_CHECK(*out_shape, 0, mshadow::Shape3(lshape[0], lshape[1], rshape[1]));
+  return true;
+}
+
+static bool WeightOnlyBatchDotType(const nnvm::NodeAttrs &attrs,
+                                   std::vector<int> *in_type,
+                                   std::vector<int> *out_type) {
+  using namespace weight_only;
+  CHECK_EQ(in_type->size(), 3U);
+  CHECK_EQ(out_type->size(), 1U);
+  TYPE_ASSIGN_CHECK(*in_type, kRhs, mshadow::kInt8);
+  TYPE_ASSIGN_CHECK(*in_type, kRhsScale, mshadow::kFloat32);
+  const int dtype = (*in_type)[kLhs];
+  if (dtype == -1) return false;
+  CHECK(dtype == mshadow::kFloat32 || dtype == mshadow::kFloat16)
+      << "_contrib_weight_only_batch_dot only supports float32 and float16 lhs";
+  TYPE_ASSIGN_CHECK(*out_type, 0, dtype);
+  return true;
+}
+
+NNVM_REGISTER_OP(_contrib_weight_only_fully_connected)
+.describe(R"code(FullyConnected with a weight quantized to int8 or int4 and float activations.
+
+The weight of shape (num_hidden, depth) is given as int8 values, or for ``num_bits=4`` as
+(num_hidden, depth / 2) bytes holding two values each, the even index in the low nibble.
+``scale`` of shape (num_hidden, ceil(depth / group_size)) holds the float32 scale of each
+group of ``group_size`` consecutive inputs of a row, so that the float weight is
+``weight[n, k] * scale[n, k / group_size]``. The data, the bias and the output are float32 or
+float16, and the products are accumulated in float32.
+
+The WeightOnlyQuantize graph pass converts the FullyConnected of a float model.
+)code" ADD_FILELINE)
+.set_attr_parser(ParamParser<WeightOnlyFCParam>)
+.set_num_inputs([](const NodeAttrs &attrs) {
+  return nnvm::get<WeightOnlyFCParam>(attrs.parsed).no_bias ? 3 : 4;
+})
+.set_num_outputs(1)
+.set_attr<nnvm::FListInputNames>("FListInputNames", [](const NodeAttrs &attrs) {
+  if (nnvm::get<WeightOnlyFCParam>(attrs.parsed).no_bias) {
+    return std::vector<std::string>{"data", "weight", "scale"};
+  }
+  return std::vector<std::string>{"data", "weight", "scale", "bias"};
+})
+.set_attr<mxnet::FInferShape>("FInferShape", WeightOnlyFCShape)
+.set_attr<nnvm::FInferType>("FInferType", WeightOnlyFCType)
+.set_attr<FResourceRequest>("FResourceRequest", [](const NodeAttrs &attrs) {
+  return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
+})
+.set_attr<FCompute>("FCompute<cpu>", WeightOnlyFCForward<cpu>)
+.add_argument("data", "NDArray-or-Symbol", "Input data.")
+.add_argument("weight", "NDArray-or-Symbol", "Quantized weight.")
+.add_argument("scale", "NDArray-or-Symbol", "Scales of the groups of the weight rows.")
+.add_argument("bias", "NDArray-or-Symbol", "Bias parameter.")
+.add_arguments(WeightOnlyFCParam::__FIELDS__());
+
+NNVM_REGISTER_OP(_contrib_weight_only_batch_dot)
+.describe(R"code(batch_dot of float lhs with a transposed rhs quantized to int8 or int4.
+
+Computes out[b, m, n] = sum_k lhs[b, m, k] * rhs[b, n, k] * rhs_scale[b, n, k / group_size],
+which is ``batch_dot(lhs, rhs, transpose_b=True)`` of the dequantized rhs. lhs is
+(batch, rows, depth) float32 or float16. rhs is (batch, cols, depth) int8 values, or for
+``num_bits=4`` (batch, cols, depth / 2) bytes holding two values each, the even index in the
+low nibble. rhs_scale is (batch, cols, ceil(depth / group_size)) float32.
+)code" ADD_FILELINE)
+.set_attr_parser(ParamParser<WeightOnlyBatchDotParam>)
+.set_num_inputs(3)
+.set_num_outputs(1)
+.set_attr<nnvm::FListInputNames>("FListInputNames", [](const NodeAttrs &attrs) {
+  return std::vector<std::string>{"lhs", "rhs", "rhs_scale"};
+})
+.set_attr<mxnet::FInferShape>("FInferShape", WeightOnlyBatchDotShape)
+.set_attr<nnvm::FInferType>("FInferType", WeightOnlyBatchDotType)
+.set_attr<FResourceRequest>("FResourceRequest", [](const NodeAttrs &attrs) {
+  return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
+})
+.set_attr<FCompute>("FCompute<cpu>", WeightOnlyBatchDotForward<cpu>)
+.add_argument("lhs", "NDArray-or-Symbol", "The first input.")
+.add_argument("rhs", "NDArray-or-Symbol", "The quantized and transposed second input.")
+.add_argument("rhs_scale", "NDArray-or-Symbol", "Scales of the groups of the rhs rows.")
+.add_arguments(WeightOnlyBatchDotParam::__FIELDS__());
+
+}  // namespace op
+}  // namespace mxnet
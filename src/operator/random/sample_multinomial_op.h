@@ -145,6 +145,64 @@ struct SampleMultinomialKernel {
 };
 
 
+/*!
+ * \brief Build the alias tables of distributions of K categories, one distribution per
+ *  index (Vose's method). A draw picks a column c uniformly, then c with probability
+ *  prob_table[c] and alias[c] otherwise, in constant time however large K is.
+ */
+struct BuildAliasTableKernel {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(index_t i, index_t K, const DType* dist,
+                                  float* prob_table, index_t* alias, index_t* work) {
+    dist += i * K;
+    prob_table += i * K;
+    alias += i * K;
+    work += i * K;
+    double total = 0.0;
+    for (index_t c = 0; c < K; ++c) total += static_cast<double>(dist[c]);
+    // columns of probability below 1 pushed at the front of work, the others at its back
+    index_t num_small = 0, num_large = 0;
+    for (index_t c = 0; c < K; ++c) {
+      prob_table[c] = static_cast<float>(static_cast<double>(dist[c]) * K / total);
+      alias[c] = c;
+      if (prob_table[c] < 1.0f) {
+        work[num_small++] = c;
+      } else {
+        work[K - 1 - num_large++] = c;
+      }
+    }
+    while (num_small > 0 && num_large > 0) {
+      const index_t under = work[--num_small];
+      const index_t over = work[K - num_large];
+      // the rest of the column of under goes to over
+      alias[under] = over;
+      prob_table[over] = (prob_table[over] + prob_table[under]) - 1.0f;
+      if (prob_table[over] < 1.0f) {
+        --num_large;
+        work[num_small++] = over;
+      }
+    }
+    // the columns left are full, up to the rounding errors
+    while (num_large > 0) prob_table[work[K - num_large--]] = 1.0f;
+    while (num_small > 0) prob_table[work[--num_small]] = 1.0f;
+  }
+};
+
+/*! \brief Draw from the alias tables, one draw per index, two uniforms per draw. */
+struct SampleAliasTableKernel {
+  template<typename DType, typename IType>
+  MSHADOW_XINLINE static void Map(index_t i, index_t K, index_t M, const DType* dist,
+                                  const float* uniform, const float* prob_table,
+                                  const index_t* alias, IType* out, DType* prob) {
+    const index_t offset = (i / M) * K;
+    index_t c = static_cast<index_t>(uniform[2 * i] * K);
+    if (c >= K) c = K - 1;
+    const index_t k = uniform[2 * i + 1] < prob_table[offset + c] ? c : alias[offset + c];
+    out[i] = static_cast<IType>(k);
+    if (prob != nullptr) prob[i] = logf(dist[offset + k]);
+  }
+};
+
 template<typename xpu>
 void SampleMultinomialForward(const nnvm::NodeAttrs& attrs,
                               const OpContext& ctx,
@@ -160,6 +218,28 @@ void SampleMultinomialForward(const nnvm::NodeAttrs& attrs,
   index_t M = outputs[0].Size()/N;
 
   Stream<xpu> *s = ctx.get_stream<xpu>();
+  if (M > 1) {
+    // repeated draws from the same distributions, from their alias tables
+    MSHADOW_REAL_TYPE_SWITCH(inputs[0].type_flag_, DType, {
+      Random<xpu, float> *prnd = ctx.requested[0].get_random<xpu, float>(s);
+      // [aliases, worklists of the alias tables, uniforms, probability tables]
+      Tensor<xpu, 1, char> workspace = ctx.requested[1].get_space_typed<xpu, 1, char>(
+          Shape1(2 * sizeof(index_t) * N * K + sizeof(float) * (2 * N * M + N * K)), s);
+      index_t* alias = reinterpret_cast<index_t*>(workspace.dptr_);
+      Tensor<xpu, 1, float> uniform(reinterpret_cast<float*>(alias + 2 * N * K),
+                                    Shape1(2 * N * M), s);
+      float* prob_table = uniform.dptr_ + 2 * N * M;
+      prnd->SampleUniform(&uniform, 0, 1);
+      Kernel<BuildAliasTableKernel, xpu>::Launch(s, N, K, inputs[0].dptr<DType>(), prob_table,
+                                                 alias, alias + N * K);
+      MSHADOW_TYPE_SWITCH(outputs[0].type_flag_, IType, {
+        Kernel<SampleAliasTableKernel, xpu>::Launch(
+          s, N * M, K, M, inputs[0].dptr<DType>(), uniform.dptr_, prob_table, alias,
+          outputs[0].dptr<IType>(), param.get_prob ? outputs[1].dptr<DType>() : nullptr);
+      });
+    });
+    return;
+  }
   MSHADOW_REAL_TYPE_SWITCH(inputs[0].type_flag_, DType, {
     Random<xpu, float> *prnd = ctx.requested[0].get_random<xpu, float>(s);
     Tensor<xpu, 1, float> workspace =
@@ -543,16 +543,7 @@ class RNNOp {
     if (dgrad_sync_event_created_)
       CUDA_CALL(cudaEventDestroy(dgrad_sync_event_));
 
-    if (init_cudnn_) {
-      for (size_t i = 0; i < x_desc_vec_.size(); ++i) {
-        CUDNN_CALL(cudnnDestroyTensorDescriptor(x_desc_vec_[i]));
-        CUDNN_CALL(cudnnDestroyTensorDescriptor(y_desc_vec_[i]));
-        CUDNN_CALL(cudnnDestroyTensorDescriptor(dx_desc_vec_[i]));
-        CUDNN_CALL(cudnnDestroyTensorDescriptor(dy_desc_vec_[i]));
-      }
-      init_cudnn_ = false;
-      Storage::Get()->Free(reserve_space_);
-    }
+    ReleaseCudnnPlan();
 #if MXNET_USE_CUDNN_GE_7200
     CUDNN_CALL(cudnnDestroyRNNDataDescriptor(x_data_desc_));
     CUDNN_CALL(cudnnDestroyRNNDataDescriptor(y_data_desc_));
@@ -626,19 +617,11 @@ class RNNOp {
 #endif
 
 
-    if (param_.use_sequence_length) {
+    // on CPU the lengths are read in place by VarLengthForwardCPU
+    if (param_.use_sequence_length && ctx_.dev_type == kGPU) {
 #if MXNET_USE_CUDNN_GE_7200
-      if (ctx_.dev_type == kCPU) {
-        LOG(FATAL) << "RNN use_sequence_length option is only available for cuDNN at the moment."
-                   << " Not supported on CPU";
-      }
-
-      // We can assume we are on GPU for now
-      size_t seq_len_input_idx = rnn_enum::kSequenceLength;
-      if  (param_.mode != rnn_enum::kLstm) {
-        seq_len_input_idx -= 1;
-      }
-      IType *sequence_length_ptr_gpu = (in_data[seq_len_input_idx].get<xpu, 1, IType>(s)).dptr_;
+      IType *sequence_length_ptr_gpu =
+          (in_data[SeqLengthInputIdx()].get<xpu, 1, IType>(s)).dptr_;
 
       // Need to copy from GPU -> CPU, becuase cuDNN API requires this array on CPU memory.
       // TODO(stephenrawls): In future, allow users to pass this array on the CPU so we don't have
@@ -664,6 +647,12 @@ class RNNOp {
     CHECK_EQ(y.CheckContiguous(), true);
 
 #if MXNET_USE_CUDNN == 1 && defined(__CUDACC__)
+    // the descriptors, the reserve space and the persistent plan only depend on the max
+    // sequence length and the batch size, they are reused for as long as those stay the same
+    if (init_cudnn_ && (plan_seq_length_ != param_.seq_length_ ||
+                        plan_batch_size_ != param_.batch_size_)) {
+      ReleaseCudnnPlan();
+    }
     if (!init_cudnn_) {
       Init(ctx, s, in_data, out_data);
     }
@@ -862,6 +851,12 @@ class RNNOp {
       }
       DType* work_cpu_space = static_cast<DType*>(temp_cpu_space_.data().dptr_);
 
+      if (param_.use_sequence_length) {
+        VarLengthForwardCPU(ctx, s, in_data, work_cpu_space, projection_size,
+                            x.dptr_, hx.dptr_, cx_ptr, w.dptr_, b_ptr, y.dptr_, hy_ptr, cy_ptr);
+        return;
+      }
+
       if (ctx.is_train || ctx.need_grad) {
         mshadow::Random<cpu, unsigned> *prnd = ctx.requested[0].get_random<xpu, unsigned int>(s);
         std::mt19937 &rnd_engine = prnd->GetRndEngine();
@@ -1128,6 +1123,12 @@ class RNNOp {
         LOG(FATAL) << "Check temp init error";
       }
       DType* work_cpu_space = static_cast<DType*>(temp_cpu_space_.data().dptr_);
+      if (param_.use_sequence_length) {
+        VarLengthBackwardCPU(in_data, req, work_cpu_space, x.dptr_, hx.dptr_, cx_ptr,
+                             w.dptr_, y.dptr_, dy.dptr_, dhy_ptr, dcy_ptr, dx.dptr_, dhx.dptr_,
+                             dcx_ptr, dw.dptr_, db_ptr);
+        return;
+      }
       size_t r_size = GetRNNReserveSpaceSize(param_.num_layers, direction,
                                              param_.seq_length_, param_.batch_size_,
                                              param_.state_size, param_.mode);
@@ -1169,6 +1170,191 @@ class RNNOp {
   }
 
  private:
+  /*! \brief index of the sequence_length input, which follows state_cell for LSTM */
+  inline size_t SeqLengthInputIdx() const {
+    return param_.mode == rnn_enum::kLstm ? rnn_enum::kSequenceLength
+                                          : rnn_enum::kSequenceLength - 1;
+  }
+
+  /*!
+   * \brief batch indices bucketed by their sequence length, the CPU kernels run each
+   *        bucket as a dense batch of exactly that many time steps
+   */
+  inline std::map<int, std::vector<int>> GroupByLength(const TBlob &sequence_length) const {
+    const IType *lengths = sequence_length.dptr<IType>();
+    std::map<int, std::vector<int>> groups;
+    for (int b = 0; b < param_.batch_size_; ++b) {
+      const int len = static_cast<int>(lengths[b]);
+      CHECK(len > 0 && len <= param_.seq_length_)
+        << "sequence_length[" << b << "] = " << len << " is out of range (0, "
+        << param_.seq_length_ << "]";
+      groups[len].push_back(b);
+    }
+    return groups;
+  }
+
+  /*! \brief copy the rows of the batch elements in idx out of a (steps, batch, row) tensor */
+  static void GatherBatch(const DType *src, const int steps, const int batch, const int row,
+                          const std::vector<int> &idx, DType *dst) {
+    const int nb = idx.size();
+    for (int t = 0; t < steps; ++t) {
+      for (int j = 0; j < nb; ++j) {
+        std::copy(src + (t * batch + idx[j]) * row, src + (t * batch + idx[j] + 1) * row,
+                  dst + (t * nb + j) * row);
+      }
+    }
+  }
+
+  /*! \brief inverse of GatherBatch */
+  static void ScatterBatch(const DType *src, const int steps, const int batch, const int row,
+                           const std::vector<int> &idx, DType *dst) {
+    const int nb = idx.size();
+    for (int t = 0; t < steps; ++t) {
+      for (int j = 0; j < nb; ++j) {
+        std::copy(src + (t * nb + j) * row, src + (t * nb + j + 1) * row,
+                  dst + (t * batch + idx[j]) * row);
+      }
+    }
+  }
+
+  /*!
+   * \brief forward of padded sequences of different lengths on CPU. The batch is split into
+   *        groups of equal length, so that no time is spent on the padding and the reverse
+   *        direction starts at the last valid step of each sequence, as for cuDNN. The output
+   *        past the length of a sequence is zero, and the reserve space holds the groups one
+   *        after another for the backward pass.
+   */
+  void VarLengthForwardCPU(const OpContext &ctx, mshadow::Stream<xpu> *s,
+                           const std::vector<TBlob> &in_data, DType *work_cpu_space,
+                           const int projection_size, DType *x, DType *hx, DType *cx,
+                           DType *w, DType *b, DType *y, DType *hy, DType *cy) {
+    const int T = param_.seq_length_;
+    const int N = param_.batch_size_;
+    const int I = param_.input_size_;
+    const int H = param_.state_size;
+    const int D = param_.bidirectional ? 2 : 1;
+    const int P = projection_size > 0 ? projection_size : H;
+    const int S = param_.num_layers * D;
+    const bool lstm = param_.mode == rnn_enum::kLstm;
+    const bool training = ctx.is_train || ctx.need_grad;
+    const auto groups = GroupByLength(in_data[SeqLengthInputIdx()]);
+
+    DType *reserve_space_ptr = nullptr;
+    if (training) {
+      if (param_.projection_size.has_value()) {
+        LOG(FATAL) << "No training support for LSTM with projection on CPU currently.";
+      }
+      size_t r_size = 0;
+      for (const auto &g : groups) {
+        r_size += GetRNNReserveSpaceSize(param_.num_layers, D, g.first, g.second.size(),
+                                         H, param_.mode);
+      }
+      if (!init_space_ || reserve_cpu_space_size_ < r_size) {
+        reserve_cpu_space_size_ = r_size;
+        reserve_cpu_space_ = NDArray(TShape({static_cast<dim_t>(reserve_cpu_space_size_)}), ctx_,
+            false, in_data[rnn_enum::kData].type_flag_);
+        init_space_ = true;
+      }
+      reserve_space_ptr = static_cast<DType*>(reserve_cpu_space_.data().dptr_);
+    }
+
+    std::fill(y, y + T * N * D * P, DType(0));
+    for (const auto &g : groups) {
+      const int L = g.first;
+      const std::vector<int> &idx = g.second;
+      const int nb = idx.size();
+      std::vector<DType> xg(L * nb * I), yg(L * nb * D * P);
+      std::vector<DType> hxg(S * nb * P), hyg(hy ? S * nb * P : 0);
+      std::vector<DType> cxg(lstm ? S * nb * H : 0), cyg(cy ? S * nb * H : 0);
+      GatherBatch(x, L, N, I, idx, xg.data());
+      GatherBatch(hx, S, N, P, idx, hxg.data());
+      if (lstm) GatherBatch(cx, S, N, H, idx, cxg.data());
+      DType *hy_g = hy ? hyg.data() : nullptr;
+      DType *cy_g = cy ? cyg.data() : nullptr;
+      if (training) {
+        mshadow::Random<cpu, unsigned> *prnd = ctx.requested[0].get_random<xpu, unsigned int>(s);
+        RNNForwardTraining<DType>(work_cpu_space, reserve_space_ptr, param_.state_outputs,
+                                  param_.num_layers, D, L, nb, I, H, xg.data(), hxg.data(),
+                                  lstm ? cxg.data() : nullptr, w, b, yg.data(), hy_g, cy_g,
+                                  param_.p, param_.mode, prnd->GetRndEngine());
+        reserve_space_ptr += GetRNNReserveSpaceSize(param_.num_layers, D, L, nb, H, param_.mode);
+      } else {
+        RNNForwardInference<DType>(work_cpu_space, param_.state_outputs, param_.num_layers, D,
+                                   L, nb, I, H, projection_size, xg.data(), hxg.data(),
+                                   lstm ? cxg.data() : nullptr, w, b, yg.data(), hy_g, cy_g,
+                                   param_.mode);
+      }
+      ScatterBatch(yg.data(), L, N, D * P, idx, y);
+      if (hy) ScatterBatch(hyg.data(), S, N, P, idx, hy);
+      if (cy) ScatterBatch(cyg.data(), S, N, H, idx, cy);
+    }
+  }
+
+  /*!
+   * \brief backward of VarLengthForwardCPU, group by group; the gradient of the parameters
+   *        is accumulated over the groups and the gradient of the padding of x is zero
+   */
+  void VarLengthBackwardCPU(const std::vector<TBlob> &in_data,
+                            const std::vector<OpReqType> &req, DType *work_cpu_space,
+                            DType *x, DType *hx, DType *cx, DType *w, DType *y, DType *dy,
+                            DType *dhy, DType *dcy, DType *dx, DType *dhx, DType *dcx,
+                            DType *dw, DType *db) {
+    const int T = param_.seq_length_;
+    const int N = param_.batch_size_;
+    const int I = param_.input_size_;
+    const int H = param_.state_size;
+    const int D = param_.bidirectional ? 2 : 1;
+    const int S = param_.num_layers * D;
+    const bool lstm = param_.mode == rnn_enum::kLstm;
+    const OpReqType req_cell = lstm ? req[rnn_enum::kStateCell] : kNullOp;
+    const auto groups = GroupByLength(in_data[SeqLengthInputIdx()]);
+
+    size_t r_size = 0;
+    for (const auto &g : groups) {
+      r_size += GetRNNReserveSpaceSize(param_.num_layers, D, g.first, g.second.size(),
+                                       H, param_.mode);
+    }
+    if (!init_space_ || reserve_cpu_space_size_ < r_size) {
+      LOG(FATAL) << "Check forward init error";
+    }
+    DType *reserve_space_ptr = static_cast<DType*>(reserve_cpu_space_.data().dptr_);
+
+    if (req[rnn_enum::kData] != kNullOp) {
+      std::fill(dx, dx + T * N * I, DType(0));
+    }
+    for (const auto &g : groups) {
+      const int L = g.first;
+      const std::vector<int> &idx = g.second;
+      const int nb = idx.size();
+      std::vector<DType> xg(L * nb * I), dxg(L * nb * I);
+      std::vector<DType> yg(L * nb * D * H), dyg(L * nb * D * H);
+      std::vector<DType> hxg(S * nb * H), dhxg(S * nb * H), dhyg(dhy ? S * nb * H : 0);
+      std::vector<DType> cxg(lstm ? S * nb * H : 0), dcxg(lstm ? S * nb * H : 0);
+      std::vector<DType> dcyg(dcy ? S * nb * H : 0);
+      GatherBatch(x, L, N, I, idx, xg.data());
+      GatherBatch(y, L, N, D * H, idx, yg.data());
+      GatherBatch(dy, L, N, D * H, idx, dyg.data());
+      GatherBatch(hx, S, N, H, idx, hxg.data());
+      if (dhy) GatherBatch(dhy, S, N, H, idx, dhyg.data());
+      if (lstm) GatherBatch(cx, S, N, H, idx, cxg.data());
+      if (dcy) GatherBatch(dcy, S, N, H, idx, dcyg.data());
+      // dw was zeroed by Backward unless it is added to, the groups all add to it
+      RNNBackward<DType>(work_cpu_space, reserve_space_ptr, param_.num_layers, D, L, nb, I, H,
+                         xg.data(), hxg.data(), lstm ? cxg.data() : nullptr, w, yg.data(),
+                         dyg.data(), dhy ? dhyg.data() : nullptr, dcy ? dcyg.data() : nullptr,
+                         dxg.data(), dhxg.data(), lstm ? dcxg.data() : nullptr, dw, db,
+                         req[rnn_enum::kData] != kNullOp ? kWriteTo : kNullOp,
+                         req[rnn_enum::kParams] != kNullOp ? kAddTo : kNullOp,
+                         req[rnn_enum::kState] != kNullOp ? kWriteTo : kNullOp,
+                         req_cell != kNullOp ? kWriteTo : kNullOp,
+                         param_.p, param_.mode);
+      reserve_space_ptr += GetRNNReserveSpaceSize(param_.num_layers, D, L, nb, H, param_.mode);
+      if (req[rnn_enum::kData] != kNullOp) ScatterBatch(dxg.data(), L, N, I, idx, dx);
+      if (req[rnn_enum::kState] != kNullOp) ScatterBatch(dhxg.data(), S, N, H, idx, dhx);
+      if (req_cell != kNullOp) ScatterBatch(dcxg.data(), S, N, H, idx, dcx);
+    }
+  }
+
   inline void Init(const OpContext &ctx,
                    mshadow::Stream<xpu> *s,
                    const std::vector<TBlob> &in_data,
@@ -1197,6 +1383,8 @@ class RNNOp {
       param_.seq_length_ = x.shape_[0];
       param_.batch_size_ = x.shape_[1];
       param_.input_size_ = x.shape_[2];
+      plan_seq_length_ = param_.seq_length_;
+      plan_batch_size_ = param_.batch_size_;
 
       // Tensor Descriptors
       std::vector<cudnnTensorDescriptor_t> x_vec(param_.seq_length_);
@@ -1351,8 +1539,8 @@ class RNNOp {
       cudnnDataType_t dtype_with_fallback_ =
         (cudnnGetVersion() >= 7500 && dtype_ == CUDNN_DATA_HALF) ? CUDNN_DATA_FLOAT
                                                              : dtype_;
-      cudnnRNNAlgo_t rnn_algo = CUDNN_RNN_ALGO_STANDARD;
-      dgrad_sync_needed_ = (rnn_algo == CUDNN_RNN_ALGO_STANDARD) && param_.bidirectional;
+      cudnnRNNAlgo_t rnn_algo = UsePersistentAlgo() ? CUDNN_RNN_ALGO_PERSIST_STATIC
+                                                    : CUDNN_RNN_ALGO_STANDARD;
       CUDNN_CALL(cudnnSetRNNDescriptor_v6(s->dnn_handle_,
                                           rnn_desc_,
                                           param_.state_size,
@@ -1363,6 +1551,37 @@ class RNNOp {
                                           mode_,
                                           rnn_algo,
                                           dtype_with_fallback_));
+      if (rnn_algo == CUDNN_RNN_ALGO_PERSIST_STATIC) {
+        // the persistent kernels keep the recurrent weights in the registers and shared memory
+        // of the SMs, the plan fails when they do not fit the device
+        cudnnStatus_t status = cudnnCreatePersistentRNNPlan(rnn_desc_, param_.batch_size_,
+                                                            dtype_with_fallback_,
+                                                            &persistent_plan_);
+        persistent_plan_created_ = (status == CUDNN_STATUS_SUCCESS);
+        if (persistent_plan_created_) {
+          status = cudnnSetPersistentRNNPlan(rnn_desc_, persistent_plan_);
+        }
+        if (status != CUDNN_STATUS_SUCCESS) {
+          LOG(INFO) << "cuDNN persistent RNN kernels are not available for this configuration ("
+                    << cudnnGetErrorString(status) << "), falling back to the standard ones.";
+          if (persistent_plan_created_) {
+            CUDNN_CALL(cudnnDestroyPersistentRNNPlan(persistent_plan_));
+            persistent_plan_created_ = false;
+          }
+          rnn_algo = CUDNN_RNN_ALGO_STANDARD;
+          CUDNN_CALL(cudnnSetRNNDescriptor_v6(s->dnn_handle_,
+                                              rnn_desc_,
+                                              param_.state_size,
+                                              param_.num_layers,
+                                              dropout_desc_,
+                                              input_mode_,
+                                              direction_,
+                                              mode_,
+                                              rnn_algo,
+                                              dtype_with_fallback_));
+        }
+      }
+      dgrad_sync_needed_ = (rnn_algo == CUDNN_RNN_ALGO_STANDARD) && param_.bidirectional;
       cudnnMathType_t math_type = CUDNN_DEFAULT_MATH;
       if (cudnn_tensor_core_ && rnn_algo == CUDNN_RNN_ALGO_STANDARD) {
         math_type = CUDNN_TENSOR_OP_MATH;
@@ -1402,6 +1621,7 @@ class RNNOp {
       reserve_space_ = Storage::Get()->Alloc(reserve_space_byte_, Context::GPU(s->dev_id));
       reserve_space_.profiler_scope = "cudnn_rnn:";
       reserve_space_.name = "reserve_space";
+      profiler::MemoryTimeline::Get()->UpdateStorageInfo(reserve_space_);
       profiler::GpuDeviceStorageProfiler::Get()->UpdateStorageInfo(reserve_space_);
       // Check that number of params are correct
       size_t cudnn_param_size;
@@ -1463,6 +1683,46 @@ class RNNOp {
     }
 #endif  // MXNET_USE_CUDNN == 1 && defined(__CUDACC__)
   }
+
+#if MXNET_USE_CUDNN == 1
+  /*!
+   * \brief whether to run the persistent kernels of cuDNN, which keep the recurrent weights
+   *        on chip across the time steps and are faster than the standard ones for small
+   *        batches; they do not support projection, state clipping or padded sequences
+   */
+  inline bool UsePersistentAlgo() const {
+    static const bool enabled = dmlc::GetEnv("MXNET_CUDNN_RNN_PERSISTENT", false);
+    static const int max_batch = dmlc::GetEnv("MXNET_CUDNN_RNN_PERSISTENT_MAX_BATCH", 32);
+    return enabled && cudnnGetVersion() >= 6000 &&
+           mshadow::DataType<DType>::kFlag != mshadow::kFloat64 &&
+           param_.batch_size_ <= max_batch &&
+           !param_.use_sequence_length &&
+           !param_.projection_size.has_value() &&
+           !param_.lstm_state_clip_min.has_value();
+  }
+
+  /*! \brief free what Init set up for one max sequence length and batch size */
+  inline void ReleaseCudnnPlan() {
+    if (!init_cudnn_) return;
+    for (size_t i = 0; i < x_desc_vec_.size(); ++i) {
+      CUDNN_CALL(cudnnDestroyTensorDescriptor(x_desc_vec_[i]));
+      CUDNN_CALL(cudnnDestroyTensorDescriptor(y_desc_vec_[i]));
+      CUDNN_CALL(cudnnDestroyTensorDescriptor(dx_desc_vec_[i]));
+      CUDNN_CALL(cudnnDestroyTensorDescriptor(dy_desc_vec_[i]));
+    }
+    x_desc_vec_.clear();
+    y_desc_vec_.clear();
+    dx_desc_vec_.clear();
+    dy_desc_vec_.clear();
+    if (persistent_plan_created_) {
+      CUDNN_CALL(cudnnDestroyPersistentRNNPlan(persistent_plan_));
+      persistent_plan_created_ = false;
+    }
+    Storage::Get()->Free(reserve_space_);
+    init_cudnn_ = false;
+  }
+#endif  // MXNET_USE_CUDNN == 1
+
   // naive private variables used in CPU Context
   bool init_space_, temp_init_space_;
   size_t reserve_cpu_space_size_, temp_cpu_space_size_;
@@ -1515,6 +1775,10 @@ class RNNOp {
   cudaEvent_t dgrad_sync_event_;
   bool dgrad_sync_event_created_ = false;
   bool dgrad_sync_needed_ = false;
+  cudnnPersistentRNNPlan_t persistent_plan_;
+  bool persistent_plan_created_ = false;
+  // max sequence length and batch size the descriptors and the reserve space were set up for
+  int plan_seq_length_ = 0, plan_batch_size_ = 0;
 #endif  // MXNET_USE_CUDNN
 };  //  class RNNOp
 
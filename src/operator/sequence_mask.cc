@@ -183,6 +183,9 @@ Example::
                  [[   1.,   1.,   1.],
                   [  16.,  17.,  18.]]]
 
+A masked softmax does not need SequenceMask: ``softmax(data, length, use_length=True)``
+skips the positions past the length in its reduction and writes 0 there, in a single pass.
+
 )code" ADD_FILELINE)
     .add_argument("data", "NDArray-or-Symbol",
                   "n-dimensional input array of the form [max_sequence_length,"
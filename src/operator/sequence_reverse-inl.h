@@ -99,6 +99,33 @@ struct ReverseKernel {
   }
 };
 
+/*!
+ * \brief Reverses the sequences in place, by swapping the periods of the first half of a
+ *  sequence with the ones of its second half. The padded periods stay where they are.
+ */
+struct ReverseInplaceKernel {
+  template <typename DType, typename IType>
+  MSHADOW_XINLINE static void Map(const index_t i, DType *const data,
+                                  const index_t half_seq_len,
+                                  const index_t max_seq_len,
+                                  const index_t batch_size,
+                                  const index_t other_dim,
+                                  const IType *const indices) {
+    const index_t batch = i / (half_seq_len * other_dim);
+    const index_t id = (i / other_dim) % half_seq_len;
+    const index_t j = i % other_dim;
+    const index_t num_seq =
+        indices ? static_cast<index_t>(indices[batch]) : max_seq_len;
+    if (id >= num_seq / 2) return;
+    const index_t offset = id * batch_size * other_dim + batch * other_dim + j;
+    const index_t mirror_offset =
+        (num_seq - 1 - id) * batch_size * other_dim + batch * other_dim + j;
+    const DType tmp = data[offset];
+    data[offset] = data[mirror_offset];
+    data[mirror_offset] = tmp;
+  }
+};
+
 template <typename xpu, typename DType, typename IType>
 class SequenceReverseOp : public Operator {
  public:
@@ -115,6 +142,14 @@ class SequenceReverseOp : public Operator {
     const index_t other_dim = data.size(2);
     const index_t tensor_numel = data.shape_.Size();
 
+    if (req == kWriteInplace) {
+      // a single pass over the reversed periods instead of a copy of every period
+      const index_t half_seq_len = max_seq_len / 2;
+      mxnet_op::Kernel<ReverseInplaceKernel, xpu>::Launch(
+          s, half_seq_len * batch_size * other_dim, out.dptr_, half_seq_len,
+          max_seq_len, batch_size, other_dim, indices);
+      return;
+    }
     MXNET_ASSIGN_REQ_SWITCH(req, req_type, {
       mxnet_op::Kernel<ReverseKernel<req_type>, xpu>::Launch(
           s, max_seq_len * batch_size * other_dim, out.dptr_, data.dptr_,
@@ -255,6 +290,19 @@ class SequenceReverseProp : public OperatorProperty {
     return true;
   }
 
+  std::vector<std::pair<int, void *> > BackwardInplaceOption(
+      const std::vector<int> &out_grad, const std::vector<int> &in_data,
+      const std::vector<int> &out_data,
+      const std::vector<void *> &in_grad) const override {
+    return {{out_grad[seq_reverse::kOut], in_grad[seq_reverse::kData]}};
+  }
+
+  std::vector<std::pair<int, void *> > ForwardInplaceOption(
+      const std::vector<int> &in_data,
+      const std::vector<void *> &out_data) const override {
+    return {{in_data[seq_reverse::kData], out_data[seq_reverse::kOut]}};
+  }
+
   OperatorProperty *Copy() const override {
     auto ptr = new SequenceReverseProp();
     ptr->param_ = param_;
@@ -0,0 +1,206 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file simd_functions-inl.h
+ * \brief vectorized float32 math functions, for any instruction set
+ *
+ *  The functions are written against a vector type V providing the few operations used,
+ *  and instantiated by the translation unit of each instruction set with its own V. This
+ *  header includes nothing else of mxnet: the translation units compiled for an instruction
+ *  set must not emit inline functions shared with the rest of the library.
+ *  The approximations are those of the Cephes library, within 2 ulp of the C library.
+ */
+#ifndef MXNET_OPERATOR_SIMD_FUNCTIONS_INL_H_
+#define MXNET_OPERATOR_SIMD_FUNCTIONS_INL_H_
+
+#include <cmath>
+#include <cstddef>
+
+namespace mxnet {
+namespace op {
+namespace simd_func {
+
+/*! \brief vectorized functions */
+enum UnaryFunc {
+  kNone = -1,
+  kExp,
+  kLog,
+  kSigmoid,
+  kTanh
+};
+
+namespace avx2 {
+/*!
+ * \brief compute a function with AVX2 on the calling thread
+ * \return false if the library is not built for AVX2
+ */
+bool Vectorize(UnaryFunc func, size_t n, const float *src, float *dst);
+}  // namespace avx2
+
+namespace avx512 {
+/*!
+ * \brief compute a function with AVX-512 on the calling thread
+ * \return false if the library is not built for AVX-512
+ */
+bool Vectorize(UnaryFunc func, size_t n, const float *src, float *dst);
+}  // namespace avx512
+
+/*! \brief scalar functions, those of the scalar kernels */
+static inline float Scalar(UnaryFunc func, float a) {
+  switch (func) {
+    case kExp:
+      return ::expf(a);
+    case kLog:
+      return ::logf(a);
+    case kSigmoid:
+      return 1.0f / (1.0f + ::expf(-a));
+    case kTanh:
+      return ::tanhf(a);
+    default:
+      return a;
+  }
+}
+
+/*! \brief e^x, for |x| <= 87 */
+template<typename V>
+inline typename V::F Exp(typename V::F x) {
+  using F = typename V::F;
+  const F n = V::Round(V::Mul(x, V::Set(1.44269504088896341f)));
+  // x - n * ln(2), ln(2) in two parts for the precision
+  F r = V::FMAdd(n, V::Set(-0.693359375f), x);
+  r = V::FMAdd(n, V::Set(2.12194440e-4f), r);
+  F y = V::Set(1.9875691500E-4f);
+  y = V::FMAdd(y, r, V::Set(1.3981999507E-3f));
+  y = V::FMAdd(y, r, V::Set(8.3334519073E-3f));
+  y = V::FMAdd(y, r, V::Set(4.1665795894E-2f));
+  y = V::FMAdd(y, r, V::Set(1.6666665459E-1f));
+  y = V::FMAdd(y, r, V::Set(5.0000001201E-1f));
+  y = V::Add(V::FMAdd(y, V::Mul(r, r), r), V::Set(1.0f));
+  return V::Mul(y, V::Pow2(n));
+}
+
+/*! \brief natural logarithm, for normal x */
+template<typename V>
+inline typename V::F Log(typename V::F x) {
+  using F = typename V::F;
+  // x = m * 2^e with m in [sqrt(0.5), sqrt(2))
+  F e, m;
+  V::Frexp(x, &m, &e);
+  const typename V::M small = V::Less(m, V::Set(0.707106781186547524f));
+  e = V::Sub(e, V::Select(small, V::Set(1.0f), V::Set(0.0f)));
+  m = V::Sub(V::Add(m, V::Select(small, m, V::Set(0.0f))), V::Set(1.0f));
+  const F z = V::Mul(m, m);
+  F y = V::Set(7.0376836292E-2f);
+  y = V::FMAdd(y, m, V::Set(-1.1514610310E-1f));
+  y = V::FMAdd(y, m, V::Set(1.1676998740E-1f));
+  y = V::FMAdd(y, m, V::Set(-1.2420140846E-1f));
+  y = V::FMAdd(y, m, V::Set(1.4249322787E-1f));
+  y = V::FMAdd(y, m, V::Set(-1.6668057665E-1f));
+  y = V::FMAdd(y, m, V::Set(2.0000714765E-1f));
+  y = V::FMAdd(y, m, V::Set(-2.4999993993E-1f));
+  y = V::FMAdd(y, m, V::Set(3.3333331174E-1f));
+  y = V::Mul(V::Mul(y, m), z);
+  y = V::FMAdd(e, V::Set(-2.12194440e-4f), y);
+  y = V::FMAdd(z, V::Set(-0.5f), y);
+  return V::FMAdd(e, V::Set(0.693359375f), V::Add(m, y));
+}
+
+/*! \brief 1 / (1 + e^-x), for |x| <= 87 */
+template<typename V>
+inline typename V::F Sigmoid(typename V::F x) {
+  const typename V::F one = V::Set(1.0f);
+  return V::Div(one, V::Add(one, Exp<V>(V::Sub(V::Set(0.0f), x))));
+}
+
+/*! \brief tanh, for |x| <= 9 */
+template<typename V>
+inline typename V::F Tanh(typename V::F x) {
+  using F = typename V::F;
+  const F a = V::Abs(x);
+  // 1 - 2 / (e^2|x| + 1) with the sign of x, loses the precision near 0
+  const F one = V::Set(1.0f);
+  F large = V::Sub(one, V::Div(V::Set(2.0f), V::Add(Exp<V>(V::Add(a, a)), one)));
+  large = V::CopySign(large, x);
+  const F z = V::Mul(x, x);
+  F y = V::Set(-5.70498872745E-3f);
+  y = V::FMAdd(y, z, V::Set(2.06390887954E-2f));
+  y = V::FMAdd(y, z, V::Set(-5.37397155531E-2f));
+  y = V::FMAdd(y, z, V::Set(1.33314422036E-1f));
+  y = V::FMAdd(y, z, V::Set(-3.33332819422E-1f));
+  y = V::FMAdd(V::Mul(y, z), x, x);
+  return V::Select(V::Less(a, V::Set(0.625f)), y, large);
+}
+
+/*!
+ * \brief compute a function over [begin, end), the vectors of elements out of the range
+ *  of the approximation by the scalar function
+ */
+template<typename V>
+inline void Compute(UnaryFunc func, const float *src, float *dst, size_t begin, size_t end) {
+  using F = typename V::F;
+  // range of the approximations, NaNs are out of every range
+  float lo, hi;
+  switch (func) {
+    case kExp:
+    case kSigmoid:
+      lo = -87.0f;
+      hi = 87.0f;
+      break;
+    case kLog:
+      lo = 1.17549435e-38f;
+      hi = 3.40282347e+38f;
+      break;
+    case kTanh:
+      lo = -9.0f;
+      hi = 9.0f;
+      break;
+    default:
+      return;
+  }
+  const F vlo = V::Set(lo), vhi = V::Set(hi);
+  size_t i = begin;
+  for (; i + V::kWidth <= end; i += V::kWidth) {
+    const F x = V::Load(src + i);
+    if (V::AnyOutside(x, vlo, vhi)) {
+      for (size_t j = i; j < i + V::kWidth; ++j) dst[j] = Scalar(func, src[j]);
+      continue;
+    }
+    switch (func) {
+      case kExp:
+        V::Store(dst + i, Exp<V>(x));
+        break;
+      case kLog:
+        V::Store(dst + i, Log<V>(x));
+        break;
+      case kSigmoid:
+        V::Store(dst + i, Sigmoid<V>(x));
+        break;
+      default:
+        V::Store(dst + i, Tanh<V>(x));
+        break;
+    }
+  }
+  for (; i < end; ++i) dst[i] = Scalar(func, src[i]);
+}
+
+}  // namespace simd_func
+}  // namespace op
+}  // namespace mxnet
+#endif  // MXNET_OPERATOR_SIMD_FUNCTIONS_INL_H_
@@ -0,0 +1,75 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file simd_functions.cc
+ * \brief runtime dispatch of the vectorized math functions
+ */
+#include <dmlc/omp.h>
+#include <dmlc/parameter.h>
+#include <algorithm>
+#include "./simd_functions.h"
+#include "../engine/openmp.h"
+
+namespace mxnet {
+namespace op {
+namespace simd_func {
+
+namespace {
+
+using VectorizeFunc = bool (*)(UnaryFunc, size_t, const float *, float *);
+
+/*! \brief best implementation supported by the CPU, nullptr if none */
+VectorizeFunc Implementation() {
+  if (!dmlc::GetEnv("MXNET_CPU_SIMD", true)) return nullptr;
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) return avx512::Vectorize;
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return avx2::Vectorize;
+#endif
+  return nullptr;
+}
+
+/*! \brief elements computed by a thread at least, multiple of the widest vector */
+constexpr size_t kGrainSize = 4096;
+
+}  // namespace
+
+bool Vectorize(UnaryFunc func, size_t n, const float *src, float *dst) {
+  static const VectorizeFunc impl = Implementation();
+  // the instantiation for the CPU may be missing from the build
+  if (impl == nullptr || !impl(func, 0, src, dst)) return false;
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  const size_t chunks = std::min(static_cast<size_t>(std::max(omp_threads, 1)),
+                                 (n + kGrainSize - 1) / kGrainSize);
+  if (chunks <= 1) return impl(func, n, src, dst);
+  // chunks of whole vectors, so that only the last one has a scalar tail
+  const size_t chunk = ((n + chunks - 1) / chunks + 63) / 64 * 64;
+  #pragma omp parallel for num_threads(chunks)
+  for (index_t i = 0; i < static_cast<index_t>(chunks); ++i) {
+    const size_t begin = std::min(n, static_cast<size_t>(i) * chunk);
+    const size_t end = std::min(n, begin + chunk);
+    impl(func, end - begin, src + begin, dst + begin);
+  }
+  return true;
+}
+
+}  // namespace simd_func
+}  // namespace op
+}  // namespace mxnet
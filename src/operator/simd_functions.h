@@ -0,0 +1,82 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file simd_functions.h
+ * \brief vectorized float32 math functions of the elementwise operators on CPU
+ *
+ *  The functions are implemented for AVX2 and AVX-512 in translation units of their own,
+ *  compiled for their instruction set, and the best one supported by the CPU is chosen at
+ *  runtime. The compiler does not vectorize the calls to the math library of the scalar
+ *  kernels. The elements out of the range of the polynomial approximations, infinities and
+ *  NaNs are computed by the scalar functions.
+ */
+#ifndef MXNET_OPERATOR_SIMD_FUNCTIONS_H_
+#define MXNET_OPERATOR_SIMD_FUNCTIONS_H_
+
+#include <mxnet/op_attr_types.h>
+#include <cstddef>
+#include <type_traits>
+#include "./mshadow_op.h"
+#include "./simd_functions-inl.h"
+
+namespace mxnet {
+namespace op {
+namespace simd_func {
+
+/*!
+ * \brief compute a function over an array in parallel, src and dst may be the same
+ * \return whether the CPU supports a vectorized implementation, nothing is computed otherwise
+ */
+bool Vectorize(UnaryFunc func, size_t n, const float *src, float *dst);
+
+/*! \brief vectorized function of a mshadow_op functor */
+template<typename OP>
+struct UnaryFuncOf {
+  static constexpr UnaryFunc value = kNone;
+};
+template<> struct UnaryFuncOf<mshadow_op::exp> {
+  static constexpr UnaryFunc value = kExp;
+};
+template<> struct UnaryFuncOf<mshadow_op::log> {
+  static constexpr UnaryFunc value = kLog;
+};
+template<> struct UnaryFuncOf<mshadow_op::sigmoid> {
+  static constexpr UnaryFunc value = kSigmoid;
+};
+template<> struct UnaryFuncOf<mshadow_op::tanh> {
+  static constexpr UnaryFunc value = kTanh;
+};
+
+/*!
+ * \brief compute dst = OP(src) with the vectorized function of OP, if any
+ * \return whether computed, the scalar kernel is to be launched otherwise
+ */
+template<typename OP, typename DType>
+inline bool Unary(OpReqType req, size_t n, const DType *src, DType *dst) {
+  return std::is_same<DType, float>::value && UnaryFuncOf<OP>::value != kNone &&
+         (req == kWriteTo || req == kWriteInplace) &&
+         Vectorize(UnaryFuncOf<OP>::value, n, reinterpret_cast<const float *>(src),
+                   reinterpret_cast<float *>(dst));
+}
+
+}  // namespace simd_func
+}  // namespace op
+}  // namespace mxnet
+#endif  // MXNET_OPERATOR_SIMD_FUNCTIONS_H_
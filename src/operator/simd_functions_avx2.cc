@@ -0,0 +1,97 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file simd_functions_avx2.cc
+ * \brief AVX2 instantiation of the vectorized math functions, compiled with AVX2 and FMA
+ */
+#include "./simd_functions-inl.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif  // __AVX2__
+
+namespace mxnet {
+namespace op {
+namespace simd_func {
+namespace avx2 {
+
+#if defined(__AVX2__)
+namespace {
+
+/*! \brief vector of 8 floats */
+struct V {
+  using F = __m256;
+  using M = __m256;
+  static constexpr size_t kWidth = 8;
+
+  static F Set(float a) { return _mm256_set1_ps(a); }
+  static F Load(const float *p) { return _mm256_loadu_ps(p); }
+  static void Store(float *p, F a) { _mm256_storeu_ps(p, a); }
+  static F Add(F a, F b) { return _mm256_add_ps(a, b); }
+  static F Sub(F a, F b) { return _mm256_sub_ps(a, b); }
+  static F Mul(F a, F b) { return _mm256_mul_ps(a, b); }
+  static F Div(F a, F b) { return _mm256_div_ps(a, b); }
+  static F FMAdd(F a, F b, F c) { return _mm256_fmadd_ps(a, b, c); }
+  static F Round(F a) { return _mm256_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+  static M Less(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+  static F Select(M m, F a, F b) { return _mm256_blendv_ps(b, a, m); }
+  static F Abs(F a) {
+    return _mm256_and_ps(a, _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff)));
+  }
+  static F CopySign(F a, F sign) {
+    return _mm256_or_ps(Abs(a), _mm256_and_ps(sign, _mm256_set1_ps(-0.0f)));
+  }
+  /*! \brief 2^n, for an integer n of a normal result */
+  static F Pow2(F n) {
+    const __m256i e = _mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127));
+    return _mm256_castsi256_ps(_mm256_slli_epi32(e, 23));
+  }
+  /*! \brief a = m * 2^e with m in [0.5, 1), for a positive normal a */
+  static void Frexp(F a, F *m, F *e) {
+    const __m256i bits = _mm256_castps_si256(a);
+    *e = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23),
+                                             _mm256_set1_epi32(126)));
+    *m = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007fffff)),
+                                             _mm256_set1_epi32(0x3f000000)));
+  }
+  /*! \brief whether an element is out of [lo, hi], or NaN */
+  static bool AnyOutside(F a, F lo, F hi) {
+    const F out = _mm256_or_ps(_mm256_cmp_ps(a, lo, _CMP_NGE_UQ),
+                               _mm256_cmp_ps(a, hi, _CMP_NLE_UQ));
+    return _mm256_movemask_ps(out) != 0;
+  }
+};
+
+}  // namespace
+
+bool Vectorize(UnaryFunc func, size_t n, const float *src, float *dst) {
+  Compute<V>(func, src, dst, 0, n);
+  return true;
+}
+#else
+bool Vectorize(UnaryFunc func, size_t n, const float *src, float *dst) {
+  return false;
+}
+#endif  // __AVX2__
+
+}  // namespace avx2
+}  // namespace simd_func
+}  // namespace op
+}  // namespace mxnet
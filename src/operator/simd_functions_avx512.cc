@@ -0,0 +1,101 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file simd_functions_avx512.cc
+ * \brief AVX-512 instantiation of the vectorized math functions, compiled with AVX-512F
+ */
+#include "./simd_functions-inl.h"
+
+#if defined(__AVX512F__)
+#include <immintrin.h>
+#endif  // __AVX512F__
+
+namespace mxnet {
+namespace op {
+namespace simd_func {
+namespace avx512 {
+
+#if defined(__AVX512F__)
+namespace {
+
+/*! \brief vector of 16 floats */
+struct V {
+  using F = __m512;
+  using M = __mmask16;
+  static constexpr size_t kWidth = 16;
+
+  static F Set(float a) { return _mm512_set1_ps(a); }
+  static F Load(const float *p) { return _mm512_loadu_ps(p); }
+  static void Store(float *p, F a) { _mm512_storeu_ps(p, a); }
+  static F Add(F a, F b) { return _mm512_add_ps(a, b); }
+  static F Sub(F a, F b) { return _mm512_sub_ps(a, b); }
+  static F Mul(F a, F b) { return _mm512_mul_ps(a, b); }
+  static F Div(F a, F b) { return _mm512_div_ps(a, b); }
+  static F FMAdd(F a, F b, F c) { return _mm512_fmadd_ps(a, b, c); }
+  static F Round(F a) {
+    return _mm512_roundscale_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+  }
+  static M Less(F a, F b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+  static F Select(M m, F a, F b) { return _mm512_mask_blend_ps(m, b, a); }
+  // the float bitwise operations are AVX-512DQ, the integer ones AVX-512F
+  static F Abs(F a) {
+    return _mm512_castsi512_ps(_mm512_and_epi32(_mm512_castps_si512(a),
+                                                _mm512_set1_epi32(0x7fffffff)));
+  }
+  static F CopySign(F a, F sign) {
+    const __m512i s = _mm512_and_epi32(_mm512_castps_si512(sign),
+                                       _mm512_set1_epi32(0x80000000));
+    return _mm512_castsi512_ps(_mm512_or_epi32(_mm512_castps_si512(Abs(a)), s));
+  }
+  /*! \brief 2^n, for an integer n of a normal result */
+  static F Pow2(F n) {
+    const __m512i e = _mm512_add_epi32(_mm512_cvtps_epi32(n), _mm512_set1_epi32(127));
+    return _mm512_castsi512_ps(_mm512_slli_epi32(e, 23));
+  }
+  /*! \brief a = m * 2^e with m in [0.5, 1), for a positive normal a */
+  static void Frexp(F a, F *m, F *e) {
+    const __m512i bits = _mm512_castps_si512(a);
+    *e = _mm512_cvtepi32_ps(_mm512_sub_epi32(_mm512_srli_epi32(bits, 23),
+                                             _mm512_set1_epi32(126)));
+    *m = _mm512_castsi512_ps(_mm512_or_epi32(_mm512_and_epi32(bits, _mm512_set1_epi32(0x007fffff)),
+                                             _mm512_set1_epi32(0x3f000000)));
+  }
+  /*! \brief whether an element is out of [lo, hi], or NaN */
+  static bool AnyOutside(F a, F lo, F hi) {
+    return (_mm512_cmp_ps_mask(a, lo, _CMP_NGE_UQ) | _mm512_cmp_ps_mask(a, hi, _CMP_NLE_UQ)) != 0;
+  }
+};
+
+}  // namespace
+
+bool Vectorize(UnaryFunc func, size_t n, const float *src, float *dst) {
+  Compute<V>(func, src, dst, 0, n);
+  return true;
+}
+#else
+bool Vectorize(UnaryFunc func, size_t n, const float *src, float *dst) {
+  return false;
+}
+#endif  // __AVX512F__
+
+}  // namespace avx512
+}  // namespace simd_func
+}  // namespace op
+}  // namespace mxnet
@@ -725,6 +725,21 @@ void TopSortEntries(const nnvm::Graph& g,
   }
 }
 
+std::vector<std::vector<nnvm::Node*>> FindSubgraphCandidates(nnvm::Graph* g,
+                                                             const SubgraphProperty& property) {
+  using namespace sg;
+  std::vector<BiDirectedNodePtr> simple_nodes;
+  CreateSimpleGraph(*g, &simple_nodes);
+  std::vector<std::vector<BiDirectedNode*>> subgraph_nodes;
+  std::vector<SubgraphSelectorV2Ptr> subgraph_selectors;
+  FindSubgraphs(g, property, simple_nodes, &subgraph_nodes, &subgraph_selectors);
+  std::vector<std::vector<nnvm::Node*>> ret(subgraph_nodes.size());
+  for (size_t i = 0; i < subgraph_nodes.size(); ++i) {
+    for (const BiDirectedNode* sn : subgraph_nodes[i]) ret[i].push_back(sn->node);
+  }
+  return ret;
+}
+
 nnvm::Graph BuildSubgraph(nnvm::Graph&& g) {
     static int verbose = dmlc::GetEnv("MXNET_SUBGRAPH_VERBOSE", 1);
   if (!g.HasAttr("subgraph_property")) {  // treat the whole graph as a subgraph
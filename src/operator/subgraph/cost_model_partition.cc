@@ -0,0 +1,453 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file cost_model_partition.cc
+ * \brief Partition a graph across several subgraph backends by an estimate of their cost
+ *
+ *  The pass is applied through optimize_for with the name CostModelPartition. The selectors
+ *  of every candidate backend first propose their subgraphs on the unchanged graph. Each
+ *  proposed region is priced for its backend and for the default executor, from the
+ *  operations and the memory traffic of its nodes, plus the copy of its inputs and outputs
+ *  when the backend runs on another device. Regions are then given, by decreasing savings,
+ *  to the backends that beat the default executor, one backend per node. Finally each
+ *  backend partitions the graph as optimize_for would, restricted to the nodes it was given.
+ */
+
+#include <mxnet/base.h>
+#include <nnvm/graph.h>
+#include <nnvm/pass.h>
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "./subgraph_property.h"
+
+namespace mxnet {
+namespace op {
+
+namespace {
+
+using OptionsMap = std::unordered_map<std::string, std::string>;
+using NodeSet = std::unordered_set<const nnvm::Node*>;
+
+/*!
+ * \brief Speed of a device or of a backend: throughput in GFLOP/s, memory bandwidth in
+ *        GB/s and fixed cost of running an operator, or a whole subgraph, in microseconds.
+ */
+struct DeviceSpeed {
+  double gflops;
+  double bandwidth;
+  double overhead;
+};
+
+/*! \brief Rough defaults, meant to be overridden by measured values through the options */
+DeviceSpeed DefaultSpeed(int dev_mask) {
+  if (dev_mask == gpu::kDevMask) return {10000.0, 500.0, 10.0};
+  return {100.0, 20.0, 5.0};
+}
+
+/*! \brief Read prefix + "gflops", "bandwidth" and "overhead" from the options */
+DeviceSpeed ParseSpeed(const OptionsMap& options, const std::string& prefix,
+                       const DeviceSpeed& defaults) {
+  DeviceSpeed ret = defaults;
+  const std::pair<const char*, double*> fields[] = {
+    {"gflops", &ret.gflops}, {"bandwidth", &ret.bandwidth}, {"overhead", &ret.overhead}};
+  for (const auto& field : fields) {
+    auto it = options.find(prefix + field.first);
+    if (it != options.end()) {
+      *field.second = std::stod(it->second);
+    }
+  }
+  CHECK_GT(ret.gflops, 0.0) << "CostModelPartition option " << prefix << "gflops must be positive";
+  CHECK_GT(ret.bandwidth, 0.0)
+      << "CostModelPartition option " << prefix << "bandwidth must be positive";
+  CHECK_GE(ret.overhead, 0.0)
+      << "CostModelPartition option " << prefix << "overhead must not be negative";
+  return ret;
+}
+
+/*!
+ * \brief Operations and bytes moved by the nodes of a graph, estimated from the shapes
+ *        and types inferred by optimize_for. Without them only the overheads are priced.
+ */
+class CostModel {
+ public:
+  explicit CostModel(const nnvm::Graph& g) : idx_(g.indexed_graph()) {
+    entry_bytes_.assign(idx_.num_node_entries(), 0.0);
+    flops_.assign(idx_.num_nodes(), 0.0);
+    if (g.HasAttr("shape") && g.HasAttr("dtype")) {
+      const auto& shapes = g.GetAttr<mxnet::ShapeVector>("shape");
+      const auto& dtypes = g.GetAttr<nnvm::DTypeVector>("dtype");
+      for (size_t eid = 0; eid < entry_bytes_.size(); ++eid) {
+        if (mxnet::shape_is_known(shapes[eid]) && dtypes[eid] != -1) {
+          entry_bytes_[eid] = static_cast<double>(shapes[eid].Size()) *
+                              mshadow::mshadow_sizeof(dtypes[eid]);
+        }
+      }
+      for (uint32_t nid = 0; nid < idx_.num_nodes(); ++nid) {
+        if (!idx_[nid].source->is_variable()) flops_[nid] = NodeFlops(nid, shapes);
+      }
+    }
+    consumers_.resize(idx_.num_node_entries());
+    for (uint32_t nid = 0; nid < idx_.num_nodes(); ++nid) {
+      for (const auto& e : idx_[nid].inputs) consumers_[idx_.entry_id(e)].push_back(nid);
+    }
+    for (const auto& e : idx_.outputs()) graph_outputs_.insert(idx_.entry_id(e));
+  }
+
+  /*! \brief latency of the nodes run one by one by the default executor */
+  double DefaultCost(const std::vector<nnvm::Node*>& region, const DeviceSpeed& speed) const {
+    double cost = 0.0;
+    for (const nnvm::Node* n : region) {
+      const uint32_t nid = idx_.node_id(n);
+      double bytes = 0.0;
+      for (const auto& e : idx_[nid].inputs) bytes += entry_bytes_[idx_.entry_id(e)];
+      for (uint32_t i = 0; i < n->num_outputs(); ++i) bytes += entry_bytes_[idx_.entry_id(nid, i)];
+      cost += speed.overhead + Time(flops_[nid], bytes, speed);
+    }
+    return cost;
+  }
+
+  /*!
+   * \brief latency of the region run as one subgraph, which only reads its inputs and
+   *        writes the outputs used outside of it, copied when it runs on another device
+   */
+  double SubgraphCost(const std::vector<nnvm::Node*>& region, const DeviceSpeed& speed,
+                      double transfer_bandwidth) const {
+    std::unordered_set<uint32_t> nids;
+    for (const nnvm::Node* n : region) nids.insert(idx_.node_id(n));
+    std::unordered_set<uint32_t> boundary;
+    double flops = 0.0;
+    for (uint32_t nid : nids) {
+      flops += flops_[nid];
+      for (const auto& e : idx_[nid].inputs) {
+        if (!nids.count(e.node_id)) boundary.insert(idx_.entry_id(e));
+      }
+      for (uint32_t i = 0; i < idx_[nid].source->num_outputs(); ++i) {
+        const uint32_t eid = idx_.entry_id(nid, i);
+        bool used_outside = graph_outputs_.count(eid) > 0;
+        for (uint32_t consumer : consumers_[eid]) used_outside |= !nids.count(consumer);
+        if (used_outside) boundary.insert(eid);
+      }
+    }
+    double bytes = 0.0;
+    for (uint32_t eid : boundary) bytes += entry_bytes_[eid];
+    double cost = speed.overhead + Time(flops, bytes, speed);
+    if (transfer_bandwidth > 0.0) cost += bytes / (transfer_bandwidth * 1e3);
+    return cost;
+  }
+
+ private:
+  /*! \brief microseconds of a kernel bound by the throughput or by the bandwidth */
+  static double Time(double flops, double bytes, const DeviceSpeed& speed) {
+    return std::max(flops / (speed.gflops * 1e3), bytes / (speed.bandwidth * 1e3));
+  }
+
+  double NodeFlops(uint32_t nid, const mxnet::ShapeVector& shapes) const {
+    const nnvm::Node* n = idx_[nid].source;
+    const auto& inputs = idx_[nid].inputs;
+    auto shape = [&](const nnvm::IndexedGraph::NodeEntry& e) -> const mxnet::TShape& {
+      return shapes[idx_.entry_id(e)];
+    };
+    const mxnet::TShape& out = shapes[idx_.entry_id(nid, 0)];
+    if (!mxnet::shape_is_known(out)) return 0.0;
+    const std::string& op = n->op()->name;
+    const double out_size = static_cast<double>(out.Size());
+    if (op == "FullyConnected" && inputs.size() > 1 && mxnet::shape_is_known(shape(inputs[1]))) {
+      return 2.0 * out_size * shape(inputs[1])[1];
+    }
+    if ((op == "Convolution" || op == "Deconvolution") && inputs.size() > 1 &&
+        mxnet::shape_is_known(shape(inputs[0])) && mxnet::shape_is_known(shape(inputs[1]))) {
+      // every output (input for the deconvolution) element takes a filter worth of MACs
+      const mxnet::TShape& w = shape(inputs[1]);
+      const double per_element = static_cast<double>(w.Size()) / w[0];
+      return 2.0 * per_element * (op == "Convolution" ? out_size : shape(inputs[0]).Size());
+    }
+    if ((op == "dot" || op == "batch_dot" || op == "_npi_matmul" || op == "linalg_gemm2") &&
+        inputs.size() > 1 && mxnet::shape_is_known(shape(inputs[0])) &&
+        mxnet::shape_is_known(shape(inputs[1])) && out.ndim() > 0) {
+      // lhs (B, M, K), rhs (B, K, N) and out (B, M, N) give B * M * N * K back
+      const double batch = out.ndim() > 2 ? out_size / (out[out.ndim() - 1] *
+                                                        out[out.ndim() - 2]) : 1.0;
+      return 2.0 * std::sqrt(static_cast<double>(shape(inputs[0]).Size()) *
+                             shape(inputs[1]).Size() * out_size / batch);
+    }
+    return out_size;
+  }
+
+  const nnvm::IndexedGraph& idx_;
+  std::vector<double> entry_bytes_;
+  std::vector<double> flops_;
+  std::vector<std::vector<uint32_t>> consumers_;
+  std::unordered_set<uint32_t> graph_outputs_;
+};
+
+/*! \brief Selector which never selects the nodes given to other backends */
+class RestrictedSelector : public SubgraphSelectorV2 {
+ public:
+  RestrictedSelector(SubgraphSelectorV2Ptr selector, const NodeSet* excluded)
+      : selector_(selector), excluded_(excluded) {}
+
+  bool Select(const BiDirectedNode& seed_node,
+              const std::shared_ptr<NodeAttr>& node_attr) override {
+    return !excluded_->count(seed_node.node) && selector_->Select(seed_node, node_attr);
+  }
+
+  bool SelectInput(const BiDirectedNode& cur_node, const BiDirectedNode& input_node,
+                   const std::shared_ptr<NodeAttr>& node_attr) override {
+    return !excluded_->count(input_node.node) &&
+           selector_->SelectInput(cur_node, input_node, node_attr);
+  }
+
+  bool SelectOutput(const BiDirectedNode& cur_node, const BiDirectedNode& output_node,
+                    const std::shared_ptr<NodeAttr>& node_attr) override {
+    return !excluded_->count(output_node.node) &&
+           selector_->SelectOutput(cur_node, output_node, node_attr);
+  }
+
+  std::vector<BiDirectedNode*> Filter(const std::vector<BiDirectedNode*>& candidates) override {
+    return selector_->Filter(candidates);
+  }
+
+  void Reset() override { selector_->Reset(); }
+
+  const SubgraphSelectorV2Ptr& selector() const { return selector_; }
+
+ private:
+  SubgraphSelectorV2Ptr selector_;
+  const NodeSet* excluded_;
+};
+
+/*!
+ * \brief Property of a backend restricted to some nodes. The property of the backend gets
+ *        its own selectors back, since it may rely on their type.
+ */
+class RestrictedProperty : public SubgraphProperty {
+ public:
+  RestrictedProperty(SubgraphPropertyPtr property, const NodeSet* excluded)
+      : SubgraphProperty(property->GetPropertyType()), property_(property), excluded_(excluded) {
+    if (property->HasAttr("property_name")) {
+      SetAttr("property_name", property->GetAttr<std::string>("property_name"));
+    }
+  }
+
+  SubgraphSelectorV2Ptr CreateSubgraphSelectorV2() const override {
+    return std::make_shared<RestrictedSelector>(property_->CreateSubgraphSelectorV2(), excluded_);
+  }
+
+  void PrePartition(const nnvm::Graph& g, const OptionsMap& options_map) override {
+    property_->PrePartition(g, options_map);
+  }
+
+  void PostPartition(const nnvm::Graph& g) override { property_->PostPartition(g); }
+
+  nnvm::ObjectPtr CreateSubgraphNode(const nnvm::Symbol& sym,
+                                     const SubgraphSelectorV2Ptr& subgraph_selector,
+                                     const int subgraph_id = 0) const override {
+    return property_->CreateSubgraphNode(sym, Unwrap(subgraph_selector), subgraph_id);
+  }
+
+  void AdjustSubgraphNode(const std::vector<nnvm::Node*>& subgraph_nodes,
+                          const SubgraphSelectorV2Ptr& subgraph_selector,
+                          const int subgraph_id = 0) const override {
+    property_->AdjustSubgraphNode(subgraph_nodes, Unwrap(subgraph_selector), subgraph_id);
+  }
+
+  void ConnectSubgraphOutputs(const nnvm::ObjectPtr subgraph_node,
+                              std::vector<nnvm::NodeEntry*>* output_entries) const override {
+    property_->ConnectSubgraphOutputs(subgraph_node, output_entries);
+  }
+
+  void ConnectSubgraphInputs(const nnvm::ObjectPtr subgraph_node,
+                             std::vector<nnvm::NodeEntry*>* input_entries,
+                             std::vector<nnvm::NodeEntry>* orig_input_entries) const override {
+    property_->ConnectSubgraphInputs(subgraph_node, input_entries, orig_input_entries);
+  }
+
+  void InitSubgraphInputs(std::vector<nnvm::NodeEntry*>* input_entries,
+                          std::vector<nnvm::NodeEntry>* orig_input_entries) const override {
+    property_->InitSubgraphInputs(input_entries, orig_input_entries);
+  }
+
+ private:
+  static const SubgraphSelectorV2Ptr& Unwrap(const SubgraphSelectorV2Ptr& selector) {
+    return static_cast<RestrictedSelector*>(selector.get())->selector();
+  }
+
+  SubgraphPropertyPtr property_;
+  const NodeSet* excluded_;
+};
+
+bool IsDisabled(const SubgraphPropertyPtr& property) {
+  return property->HasAttr("disable") && property->GetAttr<bool>("disable");
+}
+
+/*! \brief The backends of the "backends" option, or all the ones of the device */
+std::vector<std::string> CandidateBackends(const OptionsMap& options, int dev_mask) {
+  auto* registry = SubgraphBackendRegistry::Get();
+  std::vector<std::string> names;
+  auto it = options.find("backends");
+  if (it != options.end()) {
+    std::istringstream is(it->second);
+    std::string name;
+    while (std::getline(is, name, ',')) {
+      if (name.empty()) continue;
+      CHECK(registry->backend_map_.count(name))
+          << "CostModelPartition: unknown subgraph backend " << name;
+      names.push_back(name);
+    }
+  } else {
+    for (const auto& backend : registry->backend_map_) {
+      if (backend.second->HasAttr("context") &&
+          backend.second->GetAttr<Context>("context").dev_mask() == dev_mask) {
+        names.push_back(backend.first);
+      }
+    }
+    std::sort(names.begin(), names.end());
+  }
+  return names;
+}
+
+/*! \brief A subgraph proposed by a backend with the latency it saves */
+struct Candidate {
+  size_t backend;
+  std::vector<nnvm::Node*> nodes;
+  double savings;
+};
+
+}  // namespace
+
+nnvm::Graph CostModelPartition(nnvm::Graph&& g) {
+  static int verbose = dmlc::GetEnv("MXNET_SUBGRAPH_VERBOSE", 1);
+  const auto& options = g.GetAttr<OptionsMap>("options_map");
+  const int dev_mask = g.HasAttr("context") ?
+      g.GetAttr<std::vector<Context>>("context")[0].dev_mask() : cpu::kDevMask;
+  const DeviceSpeed default_speed = ParseSpeed(options, "", DefaultSpeed(dev_mask));
+  auto it = options.find("transfer_bandwidth");
+  const double transfer_bandwidth = it == options.end() ? 12.0 : std::stod(it->second);
+  CHECK_GT(transfer_bandwidth, 0.0) << "CostModelPartition option transfer_bandwidth "
+                                       "must be positive";
+
+  const std::vector<std::string> names = CandidateBackends(options, dev_mask);
+  std::vector<SubgraphBackendPtr> backends;
+  for (const auto& name : names) {
+    backends.push_back(SubgraphBackendRegistry::Get()->GetSubgraphBackend(name));
+  }
+
+  // the proposals of every backend on the unchanged graph
+  std::vector<Candidate> candidates;
+  {
+    const CostModel model(g);
+    for (size_t b = 0; b < backends.size(); ++b) {
+      const int backend_dev = backends[b]->HasAttr("context") ?
+          backends[b]->GetAttr<Context>("context").dev_mask() : dev_mask;
+      const DeviceSpeed speed = ParseSpeed(options, names[b] + "_",
+                                           backend_dev == dev_mask ? default_speed
+                                                                   : DefaultSpeed(backend_dev));
+      for (const auto& property : backends[b]->GetSubgraphProperties()) {
+        if (IsDisabled(property) || property->GetPropertyType() != SubgraphProperty::kCreate) {
+          continue;
+        }
+        property->PrePartition(g, options);
+        for (auto& nodes : FindSubgraphCandidates(&g, *property)) {
+          const double savings = model.DefaultCost(nodes, default_speed) -
+              model.SubgraphCost(nodes, speed, backend_dev == dev_mask ? 0.0
+                                                                        : transfer_bandwidth);
+          if (savings > 0.0) candidates.push_back({b, std::move(nodes), savings});
+        }
+      }
+    }
+  }
+  std::stable_sort(candidates.begin(), candidates.end(),
+                   [](const Candidate& a, const Candidate& b) { return a.savings > b.savings; });
+
+  // each node goes to the backend of the best region it belongs to; regions of one backend
+  // may overlap since its properties are applied one after the other
+  std::unordered_map<const nnvm::Node*, size_t> owner;
+  std::vector<NodeSet> owned(backends.size());
+  double total_savings = 0.0;
+  for (const auto& candidate : candidates) {
+    bool free = true;
+    for (const nnvm::Node* n : candidate.nodes) {
+      auto o = owner.find(n);
+      free &= o == owner.end() || o->second == candidate.backend;
+    }
+    if (!free) continue;
+    for (const nnvm::Node* n : candidate.nodes) {
+      owner[n] = candidate.backend;
+      owned[candidate.backend].insert(n);
+    }
+    total_savings += candidate.savings;
+  }
+  if (verbose > 1) {
+    LOG(INFO) << "CostModelPartition assigns " << owner.size() << " nodes, saving an "
+              << "estimated " << total_savings << " us";
+  }
+
+  // the nodes outside of the graph after partitioning stay alive, so that no node created
+  // meanwhile can take the address of one of them
+  std::vector<nnvm::ObjectPtr> original_nodes;
+  DFSVisit(g.outputs, [&](const nnvm::ObjectPtr& n) { original_nodes.push_back(n); });
+  for (size_t b = 0; b < backends.size(); ++b) {
+    if (owned[b].empty()) continue;
+    if (verbose > 1) {
+      LOG(INFO) << "CostModelPartition gives " << owned[b].size() << " nodes to " << names[b];
+    }
+    // the nodes present now and not given to the backend are excluded, while the subgraph
+    // nodes its own properties create stay available to its later properties
+    NodeSet excluded;
+    DFSVisit(g.outputs, [&](const nnvm::ObjectPtr& n) {
+      if (!owned[b].count(n.get())) excluded.insert(n.get());
+    });
+    for (const auto& property : backends[b]->GetSubgraphProperties()) {
+      if (IsDisabled(property)) continue;
+      SubgraphPropertyPtr restricted = std::make_shared<RestrictedProperty>(property, &excluded);
+      restricted->PrePartition(g, options);
+      g.attrs["subgraph_property"] = std::make_shared<nnvm::any>(restricted);
+      g = ApplyPass(std::move(g), "BuildSubgraph");
+      g.attrs.erase("subgraph_property");
+      restricted->PostPartition(g);
+    }
+  }
+
+  nnvm::Graph ret;
+  ret.outputs = g.outputs;
+  ret.attrs["new_args"] = std::make_shared<nnvm::any>(std::vector<NDArray*>());
+  ret.attrs["new_arg_names"] = std::make_shared<nnvm::any>(std::vector<std::string>());
+  ret.attrs["new_aux"] = std::make_shared<nnvm::any>(std::vector<NDArray*>());
+  ret.attrs["new_aux_names"] = std::make_shared<nnvm::any>(std::vector<std::string>());
+  return ret;
+}
+
+NNVM_REGISTER_PASS(CostModelPartition)
+.describe("Partition the graph across several subgraph backends, giving each region to "
+          "the backend of lowest estimated latency.")
+.set_body(CostModelPartition)
+.set_change_graph(true)
+.depend_graph_attr("options_map");
+
+}  // namespace op
+}  // namespace mxnet
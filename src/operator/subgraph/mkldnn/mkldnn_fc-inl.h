@@ -32,6 +32,7 @@ namespace op {
 
 static inline bool SupportMKLDNNFCEltwiseFusion(const std::string op_name) {
   if (op_name == "Activation" ||
+      op_name == "LeakyReLU" ||
       op_name == "square" ||
       op_name == "sqrt" ||
       op_name == "exp" ||
@@ -26,6 +26,7 @@
 
 #if MXNET_USE_MKLDNN == 1
 
+#include <cstring>
 #include <utility>
 #include <vector>
 #include <string>
@@ -112,7 +113,7 @@ void SgMKLDNNFCOp::Forward(const OpContext &ctx,
       channel_wise_runtime_ = true;
     }
 
-    total_num_inputs_ = base_num_inputs;
+    total_num_inputs_ = base_num_inputs + (mkldnn_param.with_sum ? 1 : 0);
     total_num_outputs_ = base_num_outputs;
     if (mkldnn_param.quantized) {
       total_num_inputs_ = channel_wise_runtime_ ? (base_num_inputs + 2) : (base_num_inputs * 3);
@@ -361,6 +362,21 @@ void SgMKLDNNFCOp::Forward(const OpContext &ctx,
   MSHADOW_TYPE_SWITCH(output.dtype(), DType, {
     cached_out_mem_->set_data_handle(reinterpret_cast<void *>(output.data().dptr<DType>()));
   });
+  // The sum post-op accumulates into the output, which holds the residual operand
+  // unless the inplace option between them could not be honored.
+  if (mkldnn_param.with_sum) {
+    NDArray residual = in_data[base_num_inputs];
+    if (residual.IsMKLDNNData()) residual = residual.Reorder2Default();
+    const TBlob &residual_blob = residual.data();
+    const TBlob &output_blob = output.data();
+    if (residual_blob.dptr_ != output_blob.dptr_) {
+      CHECK_EQ(residual_blob.Size(), output_blob.Size());
+      MSHADOW_TYPE_SWITCH(output.dtype(), DType, {
+        std::memcpy(output_blob.dptr<DType>(), residual_blob.dptr<DType>(),
+                    output_blob.Size() * sizeof(DType));
+      });
+    }
+  }
   MKLDNNStream::Get()->RegisterPrimArgs(fwd_->GetFwd(), args_);
   MKLDNNStream::Get()->Submit();
 
@@ -394,6 +410,8 @@ static void SgMKLDNNFCParamParser(nnvm::NodeAttrs *attrs) {
     os << ")";
     throw dmlc::ParamError(os.str());
   }
+  CHECK(!(full_param.mkldnn_param.quantized && full_param.mkldnn_param.with_sum))
+      << "Quantized " << attrs->op->name << " does not support the fused sum.";
   auto subgraph_sym = attrs->subgraphs[0];
   DFSVisit(subgraph_sym->outputs, [&](const nnvm::ObjectPtr &node) {
     if (node->is_variable()) return;
@@ -405,6 +423,10 @@ static void SgMKLDNNFCParamParser(nnvm::NodeAttrs *attrs) {
       if (op_name == "Activation") {
         const ActivationParam act_param = nnvm::get<ActivationParam>(node->attrs.parsed);
         full_param.eltwise_param.alg = GetMKLDNNActAlgo(act_param);
+      } else if (op_name == "LeakyReLU") {
+        const LeakyReLUParam act_param = nnvm::get<LeakyReLUParam>(node->attrs.parsed);
+        full_param.eltwise_param.alpha = act_param.slope;
+        full_param.eltwise_param.alg = GetMKLDNNActAlgo(act_param);
       } else if (op_name == "clip") {
         const ClipParam clip_param = nnvm::get<ClipParam>(node->attrs.parsed);
         full_param.eltwise_param.alg = mkldnn::algorithm::eltwise_bounded_relu;
@@ -607,6 +629,15 @@ nnvm::ObjectPtr SgMKLDNNFCQuantizedOp(const NodeAttrs& attrs) {
   return node;
 }
 
+static std::vector<std::pair<int, int>> SgMKLDNNFCInplaceOption(const NodeAttrs &attrs) {
+  auto const &full_param = nnvm::get<MKLDNNFCFullParam>(attrs.parsed);
+  if (full_param.mkldnn_param.with_sum) {
+    const int in_sum = full_param.default_param.no_bias ? 2 : 3;
+    return std::vector<std::pair<int, int>>{{in_sum, 0}};
+  }
+  return std::vector<std::pair<int, int>>();
+}
+
 static bool SgMKLDNNAvoidFCQuantizeInput(const NodeAttrs& attrs, const size_t index_to_check,
                                          const std::string quantize_granularity) {
   auto const &full_param = nnvm::get<MKLDNNFCFullParam>(attrs.parsed);
@@ -634,7 +665,7 @@ NNVM_REGISTER_OP(_sg_mkldnn_fully_connected)
       return num_inputs * 3;
     }
   } else {
-    return num_inputs;
+    return num_inputs + (full_param.mkldnn_param.with_sum ? 1 : 0);
   }
 })
 .set_num_outputs([](const NodeAttrs& attrs) {
@@ -659,9 +690,11 @@ NNVM_REGISTER_OP(_sg_mkldnn_fully_connected)
 })
 .set_attr<nnvm::FMutateInputs>("FMutateInputs",
                                DefaultSubgraphOpMutableInputs)
+.set_attr<nnvm::FInplaceOption>("FInplaceOption", SgMKLDNNFCInplaceOption)
 .set_attr<std::string>("key_var_num_args", "num_args")
 .set_attr<FQuantizable>("FQuantizable", [](const NodeAttrs& attrs) {
-    return QuantizeType::kMust;
+    auto const &full_param = nnvm::get<MKLDNNFCFullParam>(attrs.parsed);
+    return full_param.mkldnn_param.with_sum ? QuantizeType::kNone : QuantizeType::kMust;
 })
 .set_attr<FQuantizedOp>("FQuantizedOp", SgMKLDNNFCQuantizedOp)
 .set_attr<FNeedRequantize>("FNeedRequantize", [](const NodeAttrs& attrs) { return true; })
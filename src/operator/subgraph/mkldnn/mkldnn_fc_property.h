@@ -28,9 +28,13 @@
 #define MXNET_OPERATOR_SUBGRAPH_MKLDNN_MKLDNN_FC_PROPERTY_H_
 #if MXNET_USE_MKLDNN == 1
 
+#include <algorithm>
 #include <string>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 #include "../common.h"
+#include "../../leaky_relu-inl.h"
 #include "../../tensor/matrix_op-inl.h"
 #include "mkldnn_subgraph_base-inl.h"
 #include "mkldnn_fc-inl.h"
@@ -44,23 +48,49 @@ class SgMKLDNNFCSelector : public SubgraphSelector {
   enum SelectStatus {
     kFail = 0,
     kStart,
+    kSum,
     kSuccess,
   };
 
  private:
   bool disable_fc_eltwise_;
+  bool disable_fc_sum_;
   bool quantized_;
   SelectStatus status_;
   std::vector<const nnvm::Node *> matched_list_;
 
+  /*!
+   * \brief the status once the eltwise is matched. The residual sum is only fused in FP32,
+   *        the quantized FullyConnected has no output of the dtype of the operand.
+   */
+  SelectStatus AfterEltwise() const {
+    return (disable_fc_sum_ || quantized_) ? kSuccess : kSum;
+  }
+
+  /*! \brief whether new_node adds an operand from outside of the chain to the output of n */
+  bool IsResidualSum(const nnvm::Node &n, const nnvm::Node &new_node) const {
+    if (disable_fc_sum_ || quantized_ || new_node.op() != Op::Get("elemwise_add"))
+      return false;
+    const nnvm::Node *operand = new_node.inputs[0].node.get() == &n ?
+        new_node.inputs[1].node.get() : new_node.inputs[0].node.get();
+    return operand != &n &&
+           std::find(matched_list_.begin(), matched_list_.end(), operand) ==
+               matched_list_.end();
+  }
+
  public:
-  explicit SgMKLDNNFCSelector(const bool dis_fc_eltwise, bool quantized) :
+  SgMKLDNNFCSelector(const bool dis_fc_eltwise, const bool dis_fc_sum, bool quantized) :
       disable_fc_eltwise_(dis_fc_eltwise),
+      disable_fc_sum_(dis_fc_sum),
       quantized_(quantized) {}
 
   bool Select(const nnvm::Node &n, const std::shared_ptr<NodeAttr>& node_attr) override {
     if (n.op() == Op::Get("FullyConnected") && SupportMKLDNNAttr(node_attr)) {
-      status_ = disable_fc_eltwise_ ? kSuccess : kStart;
+      if (disable_fc_eltwise_) {
+        status_ = AfterEltwise();
+      } else {
+        status_ = kStart;
+      }
       matched_list_.clear();
       matched_list_.push_back(&n);
       return true;
@@ -92,13 +122,28 @@ class SgMKLDNNFCSelector : public SubgraphSelector {
 
     switch (status_) {
       case kStart:
+        if (IsResidualSum(n, new_node)) {
+          matched_list_.push_back(&new_node);
+          status_ = kSuccess;
+          return true;
+        }
         // Currently, For INT8 FC fusion, only supports relu/bounded_relu(clip)/abs.
         if (new_node.op() == Op::Get("Activation")) {
           const ActivationParam &param = nnvm::get<ActivationParam>(new_node.attrs.parsed);
           if ((quantized_ && SupportQuantizedMKLDNNAct(param)) ||
               (!quantized_ && SupportMKLDNNAct(param))) {
             matched_list_.push_back(&new_node);
-            status_ = kSuccess;
+            status_ = AfterEltwise();
+            return true;
+          }
+        }
+        if (!quantized_ && new_node.op() == Op::Get("LeakyReLU")) {
+          const LeakyReLUParam &param = nnvm::get<LeakyReLUParam>(new_node.attrs.parsed);
+          if (param.act_type == leakyrelu::kLeakyReLU ||
+              param.act_type == leakyrelu::kELU ||
+              param.act_type == leakyrelu::kGELU) {
+            matched_list_.push_back(&new_node);
+            status_ = AfterEltwise();
             return true;
           }
         }
@@ -106,24 +151,32 @@ class SgMKLDNNFCSelector : public SubgraphSelector {
             new_node.op() == Op::Get("sqrt") ||
             new_node.op() == Op::Get("exp"))) {
           matched_list_.push_back(&new_node);
-          status_ = kSuccess;
+          status_ = AfterEltwise();
           return true;
         }
         if (new_node.op() == Op::Get("abs")) {
           matched_list_.push_back(&new_node);
-          status_ = kSuccess;
+          status_ = AfterEltwise();
           return true;
         }
         if (new_node.op() == Op::Get("clip")) {
           const ClipParam &param = nnvm::get<ClipParam>(new_node.attrs.parsed);
           if (param.a_min == 0.f) {
             matched_list_.push_back(&new_node);
-            status_ = kSuccess;
+            status_ = AfterEltwise();
             return true;
           }
           status_ = kSuccess;
           return false;
         }
+        status_ = kSuccess;
+        return false;
+      case kSum:
+        if (IsResidualSum(n, new_node)) {
+          matched_list_.push_back(&new_node);
+          status_ = kSuccess;
+          return true;
+        }
       default:
         status_ = kSuccess;
         return false;
@@ -149,7 +202,7 @@ class SgMKLDNNFCSelector : public SubgraphSelector {
 
   void Reset() override {
     CHECK_GE(matched_list_.size(), 1);
-    auto new_selector = SgMKLDNNFCSelector(disable_fc_eltwise_, quantized_);
+    auto new_selector = SgMKLDNNFCSelector(disable_fc_eltwise_, disable_fc_sum_, quantized_);
     new_selector.Select(*matched_list_[0], nullptr);
     *this = new_selector;
   }
@@ -159,6 +212,7 @@ class SgMKLDNNFCProperty : public SubgraphProperty {
  public:
   SgMKLDNNFCProperty() {
     disable_fc_eltwise_ = dmlc::GetEnv("MXNET_DISABLE_MKLDNN_FUSE_FC_ELTWISE", false);
+    disable_fc_sum_ = dmlc::GetEnv("MXNET_DISABLE_MKLDNN_FUSE_FC_SUM", false);
   }
 
   static SubgraphPropertyPtr Create() {
@@ -189,6 +243,9 @@ class SgMKLDNNFCProperty : public SubgraphProperty {
       } else if (SupportMKLDNNFCEltwiseFusion(sub_name)) {
           node_name << "eltwise_";
           n->attrs.dict["with_eltwise"] = "True";
+      } else if (sub_name == "elemwise_add") {
+        node_name << "sum_";
+        n->attrs.dict["with_sum"] = "True";
       }
     });
     node_name << std::to_string(subgraph_id);
@@ -202,7 +259,8 @@ class SgMKLDNNFCProperty : public SubgraphProperty {
 
   SubgraphSelectorPtr CreateSubgraphSelector() const override {
     bool quantized = HasAttr("quantize") ? GetAttr<bool>("quantize") : false;
-    auto selector = std::make_shared<SgMKLDNNFCSelector>(disable_fc_eltwise_, quantized);
+    auto selector = std::make_shared<SgMKLDNNFCSelector>(disable_fc_eltwise_, disable_fc_sum_,
+                                                         quantized);
     return selector;
   }
 
@@ -216,8 +274,37 @@ class SgMKLDNNFCProperty : public SubgraphProperty {
     }
   }
 
+  void ConnectSubgraphInputs(
+      const nnvm::ObjectPtr n, std::vector<nnvm::NodeEntry *> *input_entries,
+      std::vector<nnvm::NodeEntry> *orig_input_entries) const override {
+    auto sym = n->attrs.subgraphs[0];
+    std::unordered_set<const nnvm::Node *> node_sets;
+    DFSVisit(sym->outputs, [&](const nnvm::ObjectPtr &node) {
+      if (node->is_variable()) return;
+      node_sets.insert(node.get());
+      if (node->op()->name == "elemwise_add") {
+        // The chain becomes the left operand of the sum and the residual operand
+        // the last input, which the fused op accumulates the output into.
+        const bool swap_operands = node_sets.count(node->inputs[1].node.get()) != 0;
+        const nnvm::NodeEntry *residual = &node->inputs[swap_operands ? 0 : 1];
+        for (size_t i = 0; i < input_entries->size(); ++i) {
+          if (input_entries->at(i) == residual) {
+            std::rotate(input_entries->begin() + i, input_entries->begin() + i + 1,
+                        input_entries->end());
+            std::rotate(orig_input_entries->begin() + i, orig_input_entries->begin() + i + 1,
+                        orig_input_entries->end());
+            break;
+          }
+        }
+        if (swap_operands) std::swap(node->inputs[0], node->inputs[1]);
+      }
+    });
+    n->inputs = *orig_input_entries;
+  }
+
  private:
   bool disable_fc_eltwise_;
+  bool disable_fc_sum_;
 };
 
 }  // namespace op
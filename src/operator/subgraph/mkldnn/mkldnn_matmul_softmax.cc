@@ -0,0 +1,485 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file mkldnn_matmul_softmax.cc
+ * \brief MKLDNN (quantized) attention scores: batch_dot, scaling, additive mask and softmax
+ *
+ *  The batch_dot is a oneDNN matmul whose output scale holds the scaling of the logits,
+ *  and with it the dequantization of int8 operands. The mask and the softmax are then
+ *  applied row by row while the logits are in cache. The quantized op writes uint8
+ *  probabilities, whose range is [0, 1] without calibration.
+ */
+
+#if MXNET_USE_MKLDNN == 1
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../common.h"
+#include "../../nn/mkldnn/mkldnn_base-inl.h"
+#include "../../nn/mkldnn/mkldnn_ops-inl.h"
+#include "../../quantization/quantization_utils.h"
+#include "../../tensor/dot-inl.h"
+
+namespace mxnet {
+namespace op {
+
+namespace mm_softmax {
+enum MatMulSoftmaxInputs {kLhs, kRhs, kMask};
+enum MatMulSoftmaxOutputs {kOut, kOutMin, kOutMax};
+}  // namespace mm_softmax
+
+struct MKLDNNMatMulSoftmaxParam : public dmlc::Parameter<MKLDNNMatMulSoftmaxParam> {
+  bool quantized;
+  bool with_mask;
+  double scale;
+  DMLC_DECLARE_PARAMETER(MKLDNNMatMulSoftmaxParam) {
+    DMLC_DECLARE_FIELD(quantized).set_default(false)
+    .describe("Whether the operands of batch_dot are quantized");
+    DMLC_DECLARE_FIELD(with_mask).set_default(false)
+    .describe("Whether a mask, the last input, is added to the logits");
+    DMLC_DECLARE_FIELD(scale).set_default(1.0)
+    .describe("Scale of the output of batch_dot, including the temperature of the softmax");
+  }
+};
+
+struct MKLDNNMatMulSoftmaxFullParam {
+  DotParam dot_param;
+  MKLDNNMatMulSoftmaxParam param;
+};
+
+DMLC_REGISTER_PARAMETER(MKLDNNMatMulSoftmaxParam);
+
+class SgMKLDNNMatMulSoftmaxOp {
+ public:
+  explicit SgMKLDNNMatMulSoftmaxOp(const nnvm::NodeAttrs &attrs)
+    : full_param_(nnvm::get<MKLDNNMatMulSoftmaxFullParam>(attrs.parsed)) {}
+
+  void Forward(const OpContext &ctx,
+               const std::vector<NDArray> &inputs,
+               const std::vector<OpReqType> &req,
+               const std::vector<NDArray> &outputs);
+
+ private:
+  void Initialize(const NDArray &lhs, const NDArray &rhs, const NDArray *mask,
+                  const NDArray &output, float scale);
+
+  bool initialized_{false};
+  MKLDNNMatMulSoftmaxFullParam full_param_;
+  std::shared_ptr<mkldnn::matmul::primitive_desc> pd_;
+  std::shared_ptr<mkldnn::matmul> fwd_;
+  mxnet::TShape lhs_shape_;
+  mxnet::TShape rhs_shape_;
+  mxnet::TShape mask_shape_;
+  int lhs_dtype_{-1};
+  int rhs_dtype_{-1};
+  float cached_scale_{0.0f};
+  // dequantize the operands when oneDNN has no matmul for them, that is uint8 weights
+  bool dequantize_operands_{false};
+  float lhs_scale_{1.0f};
+  float rhs_scale_{1.0f};
+  dim_t rows_{0};
+  dim_t cols_{0};
+  // offset of the mask for each row of the logits and stride of the mask along a row
+  std::vector<index_t> mask_row_offsets_;
+  index_t mask_col_stride_{0};
+};
+
+void SgMKLDNNMatMulSoftmaxOp::Initialize(const NDArray &lhs, const NDArray &rhs,
+                                         const NDArray *mask, const NDArray &output,
+                                         float scale) {
+  const DotParam &dot_param = full_param_.dot_param;
+  const mxnet::TShape &oshape = output.shape();
+  const int ndim = oshape.ndim();
+  CHECK_GE(ndim, 3) << "_sg_mkldnn_matmul_softmax supports operands of 3 dimensions or more";
+  const dim_t batch = oshape.ProdShape(0, ndim - 2);
+  const dim_t m = oshape[ndim - 2];
+  const dim_t n = oshape[ndim - 1];
+  // the batches of (B, M, K) x (B, K, N), a transposed operand is read through its strides
+  auto operand_md = [&](const NDArray &arr, bool transposed, mkldnn::memory::data_type dtype) {
+    const dim_t rows = arr.shape()[ndim - 2];
+    const dim_t cols = arr.shape()[ndim - 1];
+    if (transposed) {
+      return mkldnn::memory::desc({batch, cols, rows}, dtype, {rows * cols, 1, cols});
+    }
+    return mkldnn::memory::desc({batch, rows, cols}, dtype, {rows * cols, cols, 1});
+  };
+  dequantize_operands_ = full_param_.param.quantized && rhs.dtype() == mshadow::kUint8;
+  auto operand_type = [&](const NDArray &arr) {
+    return dequantize_operands_ ? mkldnn::memory::data_type::f32 : get_mkldnn_type(arr.dtype());
+  };
+  auto src_md = operand_md(lhs, dot_param.transpose_a, operand_type(lhs));
+  auto weights_md = operand_md(rhs, dot_param.transpose_b, operand_type(rhs));
+  auto dst_md = mkldnn::memory::desc({batch, m, n}, mkldnn::memory::data_type::f32,
+                                     {m * n, n, 1});
+  mkldnn::matmul::desc desc(src_md, weights_md, dst_md);
+  mkldnn::primitive_attr attr;
+  attr.set_output_scales(0, {scale});
+  pd_ = std::make_shared<mkldnn::matmul::primitive_desc>(desc, attr,
+                                                         CpuEngine::Get()->get_engine());
+  fwd_ = std::make_shared<mkldnn::matmul>(*pd_);
+  rows_ = batch * m;
+  cols_ = n;
+
+  mask_row_offsets_.clear();
+  mask_col_stride_ = 0;
+  if (mask) {
+    const mxnet::TShape &mshape = mask->shape();
+    CHECK_LE(mshape.ndim(), ndim) << "The mask of _sg_mkldnn_matmul_softmax has "
+                                  << mshape.ndim() << " dimensions for logits of " << ndim;
+    // the mask is broadcast to the logits, aligned on the last axis
+    std::vector<index_t> strides(ndim, 0);
+    index_t stride = 1;
+    for (int i = ndim - 1, j = mshape.ndim() - 1; j >= 0; --i, --j) {
+      CHECK(mshape[j] == oshape[i] || mshape[j] == 1)
+          << "The mask of shape " << mshape << " does not broadcast to the logits of shape "
+          << oshape;
+      strides[i] = mshape[j] == 1 ? 0 : stride;
+      stride *= mshape[j];
+    }
+    mask_col_stride_ = strides[ndim - 1];
+    mask_row_offsets_.resize(rows_);
+    for (index_t r = 0; r < static_cast<index_t>(rows_); ++r) {
+      index_t rest = r;
+      index_t offset = 0;
+      for (int i = ndim - 2; i >= 0; --i) {
+        offset += (rest % oshape[i]) * strides[i];
+        rest /= oshape[i];
+      }
+      mask_row_offsets_[r] = offset;
+    }
+    mask_shape_ = mshape;
+  }
+  lhs_shape_ = lhs.shape();
+  rhs_shape_ = rhs.shape();
+  lhs_dtype_ = lhs.dtype();
+  rhs_dtype_ = rhs.dtype();
+  cached_scale_ = scale;
+  initialized_ = true;
+}
+
+void SgMKLDNNMatMulSoftmaxOp::Forward(const OpContext &ctx,
+                                      const std::vector<NDArray> &inputs,
+                                      const std::vector<OpReqType> &req,
+                                      const std::vector<NDArray> &outputs) {
+  using namespace mm_softmax;
+  const MKLDNNMatMulSoftmaxParam &param = full_param_.param;
+  const size_t base_num_inputs = param.with_mask ? 3 : 2;
+  CHECK_EQ(inputs.size(), base_num_inputs + (param.quantized ? 4 : 0));
+  CHECK_EQ(outputs.size(), param.quantized ? 3U : 1U);
+  if (req[kOut] == kNullOp) return;
+  CHECK_NE(req[kOut], kAddTo) << "AddTo is not supported for the output";
+
+  // the strides of the operands describe the default layout
+  const NDArray lhs = inputs[kLhs].IsMKLDNNData() ? inputs[kLhs].Reorder2Default() : inputs[kLhs];
+  const NDArray rhs = inputs[kRhs].IsMKLDNNData() ? inputs[kRhs].Reorder2Default() : inputs[kRhs];
+  NDArray mask;
+  if (param.with_mask) {
+    mask = inputs[kMask].IsMKLDNNData() ? inputs[kMask].Reorder2Default() : inputs[kMask];
+    CHECK_EQ(mask.dtype(), mshadow::kFloat32) << "The mask must be float32";
+  }
+  const NDArray &output = outputs[kOut];
+
+  float scale = static_cast<float>(param.scale);
+  if (param.quantized) {
+    const float min_lhs = inputs[base_num_inputs].data().dptr<float>()[0];
+    const float max_lhs = inputs[base_num_inputs + 1].data().dptr<float>()[0];
+    const float min_rhs = inputs[base_num_inputs + 2].data().dptr<float>()[0];
+    const float max_rhs = inputs[base_num_inputs + 3].data().dptr<float>()[0];
+    lhs_scale_ = GetQuantizeScale(lhs.dtype(), min_lhs, max_lhs);
+    rhs_scale_ = GetQuantizeScale(rhs.dtype(), min_rhs, max_rhs);
+    // the matmul dequantizes its int8 output, except on operands dequantized beforehand
+    if (rhs.dtype() != mshadow::kUint8) scale /= lhs_scale_ * rhs_scale_;
+  }
+  if (!initialized_ || lhs_shape_ != lhs.shape() || rhs_shape_ != rhs.shape() ||
+      lhs_dtype_ != lhs.dtype() || rhs_dtype_ != rhs.dtype() || cached_scale_ != scale ||
+      (param.with_mask && mask_shape_ != mask.shape())) {
+    Initialize(lhs, rhs, param.with_mask ? &mask : nullptr, output, scale);
+  }
+
+  // The logits are computed in place in a float32 output, else in temp space which also
+  // holds the dequantized operands.
+  const size_t logits_size = param.quantized ? rows_ * cols_ : 0;
+  const size_t operands_size =
+      dequantize_operands_ ? lhs.shape().Size() + rhs.shape().Size() : 0;
+  float *workspace = nullptr;
+  if (logits_size + operands_size) {
+    workspace = ctx.requested[0].get_space_typed<cpu, 1, float>(
+        Shape1(logits_size + operands_size), ctx.get_stream<cpu>()).dptr_;
+  }
+  float *logits = param.quantized ? workspace : output.data().dptr<float>();
+
+  const int nthreads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  void *lhs_ptr = lhs.data().dptr_;
+  void *rhs_ptr = rhs.data().dptr_;
+  if (dequantize_operands_) {
+    float *lhs_float = workspace + logits_size;
+    float *rhs_float = lhs_float + lhs.shape().Size();
+    const bool lhs_int8 = lhs.dtype() == mshadow::kInt8;
+    const int8_t *lhs_s8 = lhs_int8 ? lhs.data().dptr<int8_t>() : nullptr;
+    const uint8_t *lhs_u8 = lhs_int8 ? nullptr : lhs.data().dptr<uint8_t>();
+    #pragma omp parallel for num_threads(nthreads)
+    for (index_t i = 0; i < static_cast<index_t>(lhs.shape().Size()); ++i)
+      lhs_float[i] = (lhs_int8 ? lhs_s8[i] : lhs_u8[i]) / lhs_scale_;
+    const uint8_t *rhs_u8 = rhs.data().dptr<uint8_t>();
+    #pragma omp parallel for num_threads(nthreads)
+    for (index_t i = 0; i < static_cast<index_t>(rhs.shape().Size()); ++i)
+      rhs_float[i] = rhs_u8[i] / rhs_scale_;
+    lhs_ptr = lhs_float;
+    rhs_ptr = rhs_float;
+  }
+
+  auto engine = CpuEngine::Get()->get_engine();
+  mkldnn::memory src_mem(pd_->src_desc(), engine, lhs_ptr);
+  mkldnn::memory weights_mem(pd_->weights_desc(), engine, rhs_ptr);
+  mkldnn::memory dst_mem(pd_->dst_desc(), engine, logits);
+  MKLDNNStream *stream = MKLDNNStream::Get();
+  stream->RegisterPrimArgs(*fwd_, {{MKLDNN_ARG_SRC, src_mem},
+                                   {MKLDNN_ARG_WEIGHTS, weights_mem},
+                                   {MKLDNN_ARG_DST, dst_mem}});
+  stream->Submit();
+
+  const float *mask_ptr = param.with_mask ? mask.data().dptr<float>() : nullptr;
+  uint8_t *quantized_out = param.quantized ? output.data().dptr<uint8_t>() : nullptr;
+  float *float_out = param.quantized ? nullptr : output.data().dptr<float>();
+  const index_t cols = cols_;
+  #pragma omp parallel for num_threads(nthreads)
+  for (index_t r = 0; r < static_cast<index_t>(rows_); ++r) {
+    float *x = logits + r * cols;
+    if (mask_ptr) {
+      const float *m = mask_ptr + mask_row_offsets_[r];
+      for (index_t j = 0; j < cols; ++j) x[j] += m[j * mask_col_stride_];
+    }
+    float max_x = x[0];
+    for (index_t j = 1; j < cols; ++j) max_x = std::max(max_x, x[j]);
+    float sum = 0.0f;
+    for (index_t j = 0; j < cols; ++j) {
+      x[j] = std::exp(x[j] - max_x);
+      sum += x[j];
+    }
+    const float inv_sum = 1.0f / sum;
+    if (quantized_out) {
+      uint8_t *y = quantized_out + r * cols;
+      for (index_t j = 0; j < cols; ++j)
+        y[j] = static_cast<uint8_t>(std::round(x[j] * inv_sum * MaxValue<uint8_t>()));
+    } else {
+      float *y = float_out + r * cols;
+      for (index_t j = 0; j < cols; ++j) y[j] = x[j] * inv_sum;
+    }
+  }
+
+  if (param.quantized) {
+    *outputs[kOutMin].data().dptr<float>() = 0.0f;
+    *outputs[kOutMax].data().dptr<float>() = 1.0f;
+  }
+}
+
+static void SgMKLDNNMatMulSoftmaxParamParser(nnvm::NodeAttrs *attrs) {
+  MKLDNNMatMulSoftmaxFullParam full_param;
+  try {
+    full_param.param.Init(attrs->dict);
+  } catch (const dmlc::ParamError &e) {
+    std::ostringstream os;
+    os << e.what();
+    os << ", in operator " << attrs->op->name << "("
+       << "name=\"" << attrs->name << "\"";
+    for (const auto &k : attrs->dict) {
+      os << ", " << k.first << "=\"" << k.second << "\"";
+    }
+    os << ")";
+    throw dmlc::ParamError(os.str());
+  }
+  auto subgraph_sym = attrs->subgraphs[0];
+  DFSVisit(subgraph_sym->outputs, [&](const nnvm::ObjectPtr &node) {
+    if (node->is_variable()) return;
+    if (node->op()->name == "batch_dot") {
+      full_param.dot_param = nnvm::get<DotParam>(node->attrs.parsed);
+    }
+  });
+  attrs->parsed = std::move(full_param);
+}
+
+static std::vector<std::string> SgMKLDNNMatMulSoftmaxListInputNames(const NodeAttrs &attrs) {
+  auto const &full_param = nnvm::get<MKLDNNMatMulSoftmaxFullParam>(attrs.parsed);
+  std::vector<std::string> input_names = DefaultSubgraphOpListInputs(attrs);
+  if (full_param.param.quantized) {
+    input_names.emplace_back("min_lhs");
+    input_names.emplace_back("max_lhs");
+    input_names.emplace_back("min_rhs");
+    input_names.emplace_back("max_rhs");
+  }
+  return input_names;
+}
+
+static std::vector<std::string> SgMKLDNNMatMulSoftmaxListOutputNames(const NodeAttrs &attrs) {
+  auto const &full_param = nnvm::get<MKLDNNMatMulSoftmaxFullParam>(attrs.parsed);
+  if (full_param.param.quantized) {
+    return std::vector<std::string>{"output", "min_output", "max_output"};
+  }
+  return std::vector<std::string>{"output"};
+}
+
+static bool SgMKLDNNMatMulSoftmaxInferShape(const nnvm::NodeAttrs &attrs,
+                                            mxnet::ShapeVector *in_shapes,
+                                            mxnet::ShapeVector *out_shapes) {
+  auto const &full_param = nnvm::get<MKLDNNMatMulSoftmaxFullParam>(attrs.parsed);
+  if (!full_param.param.quantized) {
+    return DefaultSubgraphOpShape(attrs, in_shapes, out_shapes);
+  }
+  const size_t base_num_inputs = full_param.param.with_mask ? 3 : 2;
+  mxnet::ShapeVector base_in_shapes(in_shapes->begin(), in_shapes->begin() + base_num_inputs);
+  mxnet::ShapeVector base_out_shapes{out_shapes->at(mm_softmax::kOut)};
+  bool ret = DefaultSubgraphOpShape(attrs, &base_in_shapes, &base_out_shapes);
+  for (size_t i = 0; i < in_shapes->size(); ++i) {
+    if (i < base_num_inputs)
+      in_shapes->at(i) = base_in_shapes[i];
+    else
+      SHAPE_ASSIGN_CHECK(*in_shapes, i, Shape1(1));
+  }
+  out_shapes->at(mm_softmax::kOut) = base_out_shapes[0];
+  SHAPE_ASSIGN_CHECK(*out_shapes, mm_softmax::kOutMin, Shape1(1));
+  SHAPE_ASSIGN_CHECK(*out_shapes, mm_softmax::kOutMax, Shape1(1));
+  return ret;
+}
+
+static bool SgMKLDNNMatMulSoftmaxInferType(const nnvm::NodeAttrs &attrs,
+                                           std::vector<int> *in_types,
+                                           std::vector<int> *out_types) {
+  auto const &full_param = nnvm::get<MKLDNNMatMulSoftmaxFullParam>(attrs.parsed);
+  if (!full_param.param.quantized) {
+    return DefaultSubgraphOpType(attrs, in_types, out_types);
+  }
+  for (int i : {mm_softmax::kLhs, mm_softmax::kRhs}) {
+    CHECK(in_types->at(i) == mshadow::kInt8 || in_types->at(i) == mshadow::kUint8)
+        << "Quantized _sg_mkldnn_matmul_softmax only supports int8/uint8 operands, while "
+        << in_types->at(i) << " is given.";
+  }
+  for (size_t i = 2; i < in_types->size(); ++i) {
+    TYPE_ASSIGN_CHECK(*in_types, i, mshadow::kFloat32);
+  }
+  TYPE_ASSIGN_CHECK(*out_types, mm_softmax::kOut, mshadow::kUint8);
+  TYPE_ASSIGN_CHECK(*out_types, mm_softmax::kOutMin, mshadow::kFloat32);
+  TYPE_ASSIGN_CHECK(*out_types, mm_softmax::kOutMax, mshadow::kFloat32);
+  return true;
+}
+
+static bool SgMKLDNNMatMulSoftmaxStorageType(const nnvm::NodeAttrs &attrs,
+                                             const int dev_mask,
+                                             DispatchMode *dispatch_mode,
+                                             std::vector<int> *in_attrs,
+                                             std::vector<int> *out_attrs) {
+  auto const &full_param = nnvm::get<MKLDNNMatMulSoftmaxFullParam>(attrs.parsed);
+  if (!full_param.param.quantized) {
+    return DefaultSubgraphOpStorageType(attrs, dev_mask, dispatch_mode, in_attrs, out_attrs);
+  }
+  const size_t base_num_inputs = full_param.param.with_mask ? 3 : 2;
+  std::vector<int> base_in_attrs(in_attrs->begin(), in_attrs->begin() + base_num_inputs);
+  std::vector<int> base_out_attrs{out_attrs->at(mm_softmax::kOut)};
+  bool ret = DefaultSubgraphOpStorageType(attrs, dev_mask, dispatch_mode,
+                                          &base_in_attrs, &base_out_attrs);
+  for (size_t i = 0; i < in_attrs->size(); ++i) {
+    if (i < base_num_inputs)
+      in_attrs->at(i) = base_in_attrs[i];
+    else
+      type_assign(&in_attrs->at(i), mxnet::kDefaultStorage);
+  }
+  out_attrs->at(mm_softmax::kOut) = base_out_attrs[0];
+  type_assign(&out_attrs->at(mm_softmax::kOutMin), mxnet::kDefaultStorage);
+  type_assign(&out_attrs->at(mm_softmax::kOutMax), mxnet::kDefaultStorage);
+  return ret;
+}
+
+static OpStatePtr CreateSgMKLDNNMatMulSoftmaxState(const nnvm::NodeAttrs &attrs,
+                                                   Context ctx,
+                                                   const mxnet::ShapeVector &in_shapes,
+                                                   const std::vector<int> &in_types) {
+  return OpStatePtr::Create<SgMKLDNNMatMulSoftmaxOp>(attrs);
+}
+
+static void SgMKLDNNMatMulSoftmaxForward(const OpStatePtr &state_pointer,
+                                         const OpContext &ctx,
+                                         const std::vector<NDArray> &inputs,
+                                         const std::vector<OpReqType> &req,
+                                         const std::vector<NDArray> &outputs) {
+  SgMKLDNNMatMulSoftmaxOp &op = state_pointer.get_state<SgMKLDNNMatMulSoftmaxOp>();
+  op.Forward(ctx, inputs, req, outputs);
+}
+
+nnvm::ObjectPtr SgMKLDNNMatMulSoftmaxQuantizedOp(const NodeAttrs& attrs) {
+  nnvm::ObjectPtr node = nnvm::Node::Create();
+  node->attrs.op = Op::Get("_sg_mkldnn_matmul_softmax");
+  node->attrs.name = "quantized_" + attrs.name;
+  node->attrs.dict = attrs.dict;
+  node->attrs.dict["quantized"] = "True";
+  node->attrs.subgraphs.reserve(attrs.subgraphs.size());
+  for (auto sub : attrs.subgraphs) {
+    node->attrs.subgraphs.push_back(sub);
+  }
+  node->op()->attr_parser(&(node->attrs));
+  return node;
+}
+
+NNVM_REGISTER_OP(_sg_mkldnn_matmul_softmax)
+.describe(R"code(_sg_mkldnn_matmul_softmax)code" ADD_FILELINE)
+.set_num_inputs([](const NodeAttrs& attrs) {
+  auto const &full_param = nnvm::get<MKLDNNMatMulSoftmaxFullParam>(attrs.parsed);
+  const uint32_t num_inputs = full_param.param.with_mask ? 3 : 2;
+  return full_param.param.quantized ? num_inputs + 4 : num_inputs;
+})
+.set_num_outputs([](const NodeAttrs& attrs) {
+  auto const &full_param = nnvm::get<MKLDNNMatMulSoftmaxFullParam>(attrs.parsed);
+  return full_param.param.quantized ? 3 : 1;
+})
+.set_attr_parser(SgMKLDNNMatMulSoftmaxParamParser)
+.set_attr<nnvm::FListInputNames>("FListInputNames", SgMKLDNNMatMulSoftmaxListInputNames)
+.set_attr<nnvm::FListOutputNames>("FListOutputNames", SgMKLDNNMatMulSoftmaxListOutputNames)
+.set_attr<mxnet::FInferShape>("FInferShape", SgMKLDNNMatMulSoftmaxInferShape)
+.set_attr<nnvm::FInferType>("FInferType", SgMKLDNNMatMulSoftmaxInferType)
+.set_attr<FInferStorageType>("FInferStorageType", SgMKLDNNMatMulSoftmaxStorageType)
+.set_attr<FCreateOpState>("FCreateOpState", CreateSgMKLDNNMatMulSoftmaxState)
+.set_attr<FStatefulComputeEx>("FStatefulComputeEx<cpu>", SgMKLDNNMatMulSoftmaxForward)
+.set_attr<bool>("TIsMKLDNN", true)
+.set_attr<nnvm::FGradient>("FGradient", MakeZeroGradNodes)
+.set_attr<FResourceRequest>("FResourceRequest", [](const NodeAttrs& n) {
+  return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
+})
+.set_attr<nnvm::FMutateInputs>("FMutateInputs", DefaultSubgraphOpMutableInputs)
+.set_attr<FQuantizable>("FQuantizable", [](const NodeAttrs& attrs) {
+    return QuantizeType::kMust;
+})
+.set_attr<FQuantizedOp>("FQuantizedOp", SgMKLDNNMatMulSoftmaxQuantizedOp)
+// the range of the probabilities is known, they need no requantization
+.set_attr<FNeedRequantize>("FNeedRequantize", [](const NodeAttrs& attrs) { return false; })
+// the mask stays float32
+.set_attr<FAvoidQuantizeInput>("FAvoidQuantizeInput",
+    [](const NodeAttrs& attrs, const size_t index_to_check,
+       const std::string quantize_granularity) {
+  auto const &full_param = nnvm::get<MKLDNNMatMulSoftmaxFullParam>(attrs.parsed);
+  return full_param.param.with_mask && index_to_check == mm_softmax::kMask;
+});
+
+}  // namespace op
+}  // namespace mxnet
+
+#endif  // if MXNET_USE_MKLDNN == 1
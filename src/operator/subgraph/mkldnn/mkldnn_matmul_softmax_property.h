@@ -0,0 +1,247 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file mkldnn_matmul_softmax_property.h
+ * \brief Partition graph property for the attention scores of transformer blocks, that is a
+ *        batch_dot followed by an optional scaling, an optional additive mask and a softmax
+ *        over the last axis
+ */
+
+#ifndef MXNET_OPERATOR_SUBGRAPH_MKLDNN_MKLDNN_MATMUL_SOFTMAX_PROPERTY_H_
+#define MXNET_OPERATOR_SUBGRAPH_MKLDNN_MKLDNN_MATMUL_SOFTMAX_PROPERTY_H_
+#if MXNET_USE_MKLDNN == 1
+
+#include <algorithm>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "../common.h"
+#include "../../nn/softmax-inl.h"
+#include "../../tensor/elemwise_binary_scalar_op.h"
+#include "mkldnn_subgraph_base-inl.h"
+
+namespace mxnet {
+namespace op {
+
+class SgMKLDNNMatMulSoftmaxSelector : public SubgraphSelector {
+ public:
+  /*! \brief pattern match status */
+  enum SelectStatus {
+    kFail = 0,
+    kStart,
+    kScaled,
+    kMasked,
+    kSuccess,
+  };
+
+ private:
+  SelectStatus status_;
+  std::vector<const nnvm::Node *> matched_list_;
+
+  static bool IsScale(const nnvm::Node &n) {
+    return n.op() == Op::Get("_mul_scalar") || n.op() == Op::Get("_div_scalar");
+  }
+
+  /*! \brief whether new_node adds an operand from outside of the chain to the output of n */
+  bool IsMask(const nnvm::Node &n, const nnvm::Node &new_node) const {
+    if (new_node.op() != Op::Get("elemwise_add") && new_node.op() != Op::Get("broadcast_add"))
+      return false;
+    const nnvm::Node *operand = new_node.inputs[0].node.get() == &n ?
+        new_node.inputs[1].node.get() : new_node.inputs[0].node.get();
+    return operand != &n &&
+           std::find(matched_list_.begin(), matched_list_.end(), operand) ==
+               matched_list_.end();
+  }
+
+  /*! \brief softmax over the last axis without length input and output dtype */
+  static bool IsSoftmax(const nnvm::Node &n) {
+    if (n.op() != Op::Get("softmax")) return false;
+    const SoftmaxParam &param = nnvm::get<SoftmaxParam>(n.attrs.parsed);
+    return param.axis == -1 && !param.dtype.has_value() &&
+           !(param.use_length.has_value() && param.use_length.value());
+  }
+
+ public:
+  bool Select(const nnvm::Node &n, const std::shared_ptr<NodeAttr>& node_attr) override {
+    if (n.op() != Op::Get("batch_dot")) return false;
+    // the fused op computes in float32, on operands of 3 dimensions or more
+    if (node_attr && (node_attr->dispatch_mode != DispatchMode::kFComputeEx ||
+                      node_attr->itype[0] != mshadow::kFloat32 ||
+                      node_attr->ishape[0].ndim() < 3))
+      return false;
+    status_ = kStart;
+    matched_list_.clear();
+    matched_list_.push_back(&n);
+    return true;
+  }
+
+  bool SelectInput(const nnvm::Node &n, const nnvm::Node &new_node) override {
+    return false;
+  }
+
+  bool SelectOutput(const nnvm::Node &n, const nnvm::Node &new_node) override {
+    if (status_ == kFail || new_node.is_variable()) return false;
+    // an intermediate output of the chain used outside of it makes the fusion invalid
+    if (matched_list_.back() != &n) {
+      status_ = kFail;
+      return false;
+    }
+    if (status_ == kSuccess) return false;
+
+    if (status_ == kStart && IsScale(new_node)) {
+      status_ = kScaled;
+    } else if ((status_ == kStart || status_ == kScaled) && IsMask(n, new_node)) {
+      status_ = kMasked;
+    } else if (IsSoftmax(new_node)) {
+      status_ = kSuccess;
+    } else {
+      status_ = kFail;
+      return false;
+    }
+    matched_list_.push_back(&new_node);
+    return true;
+  }
+
+  std::vector<nnvm::Node *> Filter(
+      const std::vector<nnvm::Node *> &candidates) override {
+    if (status_ != kSuccess || candidates.size() != matched_list_.size())
+      return std::vector<nnvm::Node *>(0);
+    for (auto i : matched_list_) {
+      if (std::find(candidates.begin(), candidates.end(), i) == candidates.end())
+        return std::vector<nnvm::Node *>(0);
+    }
+    return candidates;
+  }
+
+  void Reset() override {
+    CHECK_GE(matched_list_.size(), 1);
+    auto new_selector = SgMKLDNNMatMulSoftmaxSelector();
+    new_selector.Select(*matched_list_[0], nullptr);
+    *this = new_selector;
+  }
+};
+
+class SgMKLDNNMatMulSoftmaxProperty : public SubgraphProperty {
+ public:
+  static SubgraphPropertyPtr Create() {
+    static const std::string &name = "MKLDNN MatMul Softmax optimization pass";
+    auto property = std::make_shared<SgMKLDNNMatMulSoftmaxProperty>();
+    property->SetAttr<std::string>("property_name", name);
+    property->SetAttr<bool>("inference_only", true);
+    if (dmlc::GetEnv("MXNET_DISABLE_MKLDNN_MATMUL_SOFTMAX_OPT", 0)) {
+      property->SetAttr<bool>("disable", true);
+    }
+    return property;
+  }
+
+  nnvm::ObjectPtr CreateSubgraphNode(const nnvm::Symbol &sym,
+                                     const int subgraph_id = 0) const override {
+    nnvm::ObjectPtr n = nnvm::Node::Create();
+    // This op has single output, remove duplicated.
+    auto last_node = sym.outputs[0].node;
+    nnvm::Symbol new_sym;
+    new_sym.outputs.emplace_back(last_node);
+    std::ostringstream node_name;
+    node_name << "sg_mkldnn_matmul_";
+    // the scalings and the temperature of the softmax become one scale of the logits
+    double scale = 1.0;
+    DFSVisit(new_sym.outputs, [&](const nnvm::ObjectPtr &node) {
+      if (node->is_variable()) return;
+      auto &sub_name = node->op()->name;
+      if (sub_name == "_mul_scalar") {
+        scale *= nnvm::get<NumpyBinaryScalarParam>(node->attrs.parsed).scalar;
+        node_name << "scale_";
+      } else if (sub_name == "_div_scalar") {
+        scale /= nnvm::get<NumpyBinaryScalarParam>(node->attrs.parsed).scalar;
+        node_name << "scale_";
+      } else if (sub_name == "elemwise_add" || sub_name == "broadcast_add") {
+        n->attrs.dict["with_mask"] = "True";
+        node_name << "mask_";
+      } else if (sub_name == "softmax") {
+        const SoftmaxParam &param = nnvm::get<SoftmaxParam>(node->attrs.parsed);
+        if (param.temperature.has_value()) scale /= param.temperature.value();
+        node_name << "softmax_";
+      }
+    });
+    std::ostringstream scale_str;
+    scale_str.precision(17);
+    scale_str << scale;
+    n->attrs.dict["scale"] = scale_str.str();
+    node_name << std::to_string(subgraph_id);
+    n->attrs.name = node_name.str();
+    n->attrs.op = Op::Get("_sg_mkldnn_matmul_softmax");
+    CHECK(n->attrs.op);
+    n->attrs.subgraphs.emplace_back(std::make_shared<nnvm::Symbol>(new_sym));
+    n->op()->attr_parser(&(n->attrs));
+    return n;
+  }
+
+  SubgraphSelectorPtr CreateSubgraphSelector() const override {
+    return std::make_shared<SgMKLDNNMatMulSoftmaxSelector>();
+  }
+
+  void ConnectSubgraphOutputs(
+      const nnvm::ObjectPtr n,
+      std::vector<nnvm::NodeEntry *> *output_entries) const override {
+    // Connect all extern output entries to output[0]
+    for (size_t i = 0; i < output_entries->size(); ++i) {
+      auto entry_ptr = output_entries->at(i);
+      *entry_ptr = nnvm::NodeEntry{n, entry_ptr->index, 0};
+    }
+  }
+
+  void ConnectSubgraphInputs(
+      const nnvm::ObjectPtr n, std::vector<nnvm::NodeEntry *> *input_entries,
+      std::vector<nnvm::NodeEntry> *orig_input_entries) const override {
+    auto sym = n->attrs.subgraphs[0];
+    std::unordered_set<const nnvm::Node *> node_sets;
+    DFSVisit(sym->outputs, [&](const nnvm::ObjectPtr &node) {
+      if (node->is_variable()) return;
+      node_sets.insert(node.get());
+      auto &sub_name = node->op()->name;
+      if (sub_name == "elemwise_add" || sub_name == "broadcast_add") {
+        // The chain becomes the left operand of the add and the mask the last input,
+        // after the operands of batch_dot.
+        const bool swap_operands = node_sets.count(node->inputs[1].node.get()) != 0;
+        const nnvm::NodeEntry *mask = &node->inputs[swap_operands ? 0 : 1];
+        for (size_t i = 0; i < input_entries->size(); ++i) {
+          if (input_entries->at(i) == mask) {
+            std::rotate(input_entries->begin() + i, input_entries->begin() + i + 1,
+                        input_entries->end());
+            std::rotate(orig_input_entries->begin() + i, orig_input_entries->begin() + i + 1,
+                        orig_input_entries->end());
+            break;
+          }
+        }
+        if (swap_operands) std::swap(node->inputs[0], node->inputs[1]);
+      }
+    });
+    n->inputs = *orig_input_entries;
+  }
+};
+
+}  // namespace op
+}  // namespace mxnet
+
+#endif  // if MXNET_USE_MKLDNN == 1
+#endif  // MXNET_OPERATOR_SUBGRAPH_MKLDNN_MKLDNN_MATMUL_SOFTMAX_PROPERTY_H_
@@ -552,6 +552,14 @@ class SubgraphBackendRegistry {
 typedef dmlc::ThreadLocalStore<std::unordered_map<std::string, std::unordered_set<std::string>>>
     SubgraphPropertyOpNameSet;
 
+/*!
+ * \brief Find the subgraphs the selectors of a property would partition, without
+ *        changing the graph. Lets partitioners weigh the backends before applying them.
+ * \return the nodes of each subgraph, in topological order
+ */
+std::vector<std::vector<nnvm::Node*>> FindSubgraphCandidates(nnvm::Graph* g,
+                                                             const SubgraphProperty& property);
+
 #define DECLARE_PROPERTY_EX(NAME, SubgraphPropertyType, X) \
   static const DMLC_ATTRIBUTE_UNUSED auto __make_##SubgraphPropertyType##_##Name##_##X##__
 #define DECLARE_PROPERTY(NAME, SubgraphPropertyType, X) \
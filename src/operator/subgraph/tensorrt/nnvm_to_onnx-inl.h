@@ -59,6 +59,7 @@ void ConvertPlaceholder(
   const std::string& node_name,
   const std::unordered_map<std::string, TShape>& placeholder_shapes,
   const std::unordered_map<std::string, int>& placeholder_dtypes,
+  const std::vector<int>& dynamic_axes,
   GraphProto* graph_proto);
 
 void ConvertConstant(GraphProto* graph_proto,
@@ -68,7 +69,8 @@ void ConvertConstant(GraphProto* graph_proto,
 void ConvertOutput(GraphProto* graph_proto,
                    const std::unordered_map<std::string, uint32_t>::iterator& out_iter,
                    const std::string& node_name, const ShapeVector& shapes,
-                   const DTypeVector& dtypes, const nnvm::IndexedGraph &ig);
+                   const DTypeVector& dtypes, const nnvm::IndexedGraph &ig,
+                   bool dynamic_shapes = false);
 
 typedef void (*ConverterFunction)(NodeProto *node_proto,
                                   const NodeAttrs &attrs,
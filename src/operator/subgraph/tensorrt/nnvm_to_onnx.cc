@@ -44,6 +44,8 @@
 #include "../../nn/concat-inl.h"
 #include "../../tensor/matrix_op-inl.h"
 
+#include <algorithm>
+
 #if MXNET_USE_TENSORRT_ONNX_CHECKER
 #include <onnx/checker.h>
 #endif  // MXNET_USE_TENSORRT_ONNX_CHECKER
@@ -65,6 +67,9 @@ std::string ConvertNnvmGraphToOnnx(
   const auto& shapes = g.GetAttr<ShapeVector>("shape");
   const auto& dtype_inputs = g.GetAttr<DTypeVector>("dtype_inputs");
   const auto& shape_inputs = g.GetAttr<ShapeVector>("shape_inputs");
+  // axes of the placeholders whose size is only known at run time
+  const std::vector<int> dynamic_axes = g.HasAttr("dynamic_axes") ?
+      g.GetAttr<std::vector<int> >("dynamic_axes") : std::vector<int>();
 
   ModelProto model_proto;
 
@@ -122,7 +127,8 @@ std::string ConvertNnvmGraphToOnnx(
           current_input++;
           continue;
         }
-        ConvertPlaceholder(node_name, placeholder_shapes, placeholder_dtypes, graph_proto);
+        ConvertPlaceholder(node_name, placeholder_shapes, placeholder_dtypes, dynamic_axes,
+                           graph_proto);
       } else {
         // If it's not a placeholder, then by exclusion it's a constant.
         ConvertConstant(graph_proto, node_name, params_map);
@@ -156,7 +162,8 @@ std::string ConvertNnvmGraphToOnnx(
       auto out_iter = output_lookup.find(node_name);
       // We found an output
       if (out_iter != output_lookup.end()) {
-        ConvertOutput(graph_proto, out_iter, node_name, shapes, dtypes, ig);
+        ConvertOutput(graph_proto, out_iter, node_name, shapes, dtypes, ig,
+                      !dynamic_axes.empty());
       }  // output found
     }    // conversion function exists
   }      // loop over i from 0 to num_nodes
@@ -528,6 +535,7 @@ void ConvertPlaceholder(
     const std::string& node_name,
     const std::unordered_map<std::string, TShape>& placeholder_shapes,
     const std::unordered_map<std::string, int>& placeholder_dtypes,
+    const std::vector<int>& dynamic_axes,
     GraphProto* const graph_proto) {
   auto val_info_proto = graph_proto->add_input();
   auto type_proto = val_info_proto->mutable_type()->mutable_tensor_type();
@@ -537,9 +545,13 @@ void ConvertPlaceholder(
   auto entry_shape = placeholder_shapes.find(node_name)->second;
   auto entry_dtype = placeholder_dtypes.find(node_name)->second;
   type_proto->set_elem_type(ConvertDType(entry_dtype));
-  for (const auto& elem : entry_shape) {
+  for (int axis = 0; axis < entry_shape.ndim(); ++axis) {
     TensorShapeProto_Dimension* const tsp_dim = shape_proto->add_dim();
-    tsp_dim->set_dim_value(static_cast<int64>(elem));
+    if (std::find(dynamic_axes.begin(), dynamic_axes.end(), axis) != dynamic_axes.end()) {
+      tsp_dim->set_dim_param("dynamic_axis_" + std::to_string(axis));
+    } else {
+      tsp_dim->set_dim_value(static_cast<int64>(entry_shape[axis]));
+    }
   }
 }
 
@@ -598,7 +610,7 @@ void ConvertOutput(
     GraphProto* const graph_proto,
     const std::unordered_map<std::string, uint32_t>::iterator& out_iter,
     const std::string& node_name, const ShapeVector& shapes,
-    const DTypeVector& dtypes, const nnvm::IndexedGraph &ig) {
+    const DTypeVector& dtypes, const nnvm::IndexedGraph &ig, bool dynamic_shapes) {
   uint32_t out_idx = ig.entry_id(ig.outputs()[out_iter->second]);
   int dtype = dtypes[out_idx];
   auto graph_out = graph_proto->add_output();
@@ -609,9 +621,12 @@ void ConvertOutput(
   // Also support fp16.
   tensor_type->set_elem_type(ConvertDType(dtype));
 
+  // with dynamic inputs the output dims are left unknown, TensorRT infers them
   for (int64_t dim_shp : shapes[out_idx]) {
     TensorShapeProto_Dimension* const tsp_dim = tensor_shape_proto->add_dim();
-    tsp_dim->set_dim_value(static_cast<int64>(dim_shp));
+    if (!dynamic_shapes) {
+      tsp_dim->set_dim_value(static_cast<int64>(dim_shp));
+    }
   }
 }
 
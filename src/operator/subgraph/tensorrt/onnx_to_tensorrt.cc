@@ -31,6 +31,7 @@
 #include <onnx/onnx_pb.h>
 
 #include <NvInfer.h>
+#include <cuda_runtime_api.h>
 #include <google/protobuf/io/coded_stream.h>
 #include <google/protobuf/io/zero_copy_stream_impl.h>
 #include <google/protobuf/text_format.h>
@@ -38,6 +39,10 @@
 #include <dmlc/logging.h>
 #include <dmlc/parameter.h>
 
+#include <cstdio>
+#include <iomanip>
+#include <iterator>
+
 using std::cout;
 using std::cerr;
 using std::endl;
@@ -62,28 +67,94 @@ void PrintVersion() {
     << NV_TENSORRT_PATCH << endl;
 }
 
+/*!
+ * \brief Name of the cached engine: a FNV-1a hash of the model, whose graph name is
+ *        dropped since it numbers the subgraphs of the process, the GPU model, the
+ *        TensorRT version and the build settings.
+ */
+std::string EngineCacheKey(::ONNX_NAMESPACE::ModelProto* model, size_t max_workspace_size,
+                           bool fp16, const std::map<int, int>& dynamic_axes) {
+  model->mutable_graph()->clear_name();
+  std::string bytes;
+  model->SerializeToString(&bytes);
+  int device = 0;
+  cudaDeviceProp prop;
+  if (cudaGetDevice(&device) != cudaSuccess ||
+      cudaGetDeviceProperties(&prop, device) != cudaSuccess) {
+    throw dmlc::Error("Cannot query the GPU of the TensorRT engine");
+  }
+  std::ostringstream settings;
+  settings << prop.name << " sm_" << prop.major << prop.minor << " TensorRT "
+           << NV_TENSORRT_MAJOR << "." << NV_TENSORRT_MINOR << "." << NV_TENSORRT_PATCH
+           << " fp16 " << fp16 << " workspace " << max_workspace_size;
+  for (const auto& axis : dynamic_axes) {
+    settings << " axis " << axis.first << " max " << axis.second;
+  }
+  bytes += settings.str();
+  uint64_t hash = 14695981039346656037ULL;
+  for (unsigned char c : bytes) {
+    hash ^= c;
+    hash *= 1099511628211ULL;
+  }
+  std::ostringstream key;
+  key << std::hex << std::setw(16) << std::setfill('0') << hash;
+  return key.str();
+}
+
 std::tuple<unique_ptr<nvinfer1::ICudaEngine>,
            unique_ptr<nvonnxparser::IParser>,
-           std::unique_ptr<TRT_Logger> > onnxToTrtCtx(
+           std::unique_ptr<TRT_Logger>,
+           unique_ptr<nvinfer1::IRuntime> > onnxToTrtCtx(
         const std::string& onnx_model,
         int32_t max_batch_size,
         size_t max_workspace_size,
+        const std::map<int, int>& dynamic_axes,
+        const std::string& cache_dir,
         nvinfer1::ILogger::Severity verbosity,
         bool debug_builder) {
   GOOGLE_PROTOBUF_VERIFY_VERSION;
 
   auto trt_logger = std::unique_ptr<TRT_Logger>(new TRT_Logger(verbosity));
   auto trt_builder = InferObject(nvinfer1::createInferBuilder(*trt_logger));
-  const auto explicitBatch = 1U << static_cast<uint32_t>(
-                             nvinfer1::NetworkDefinitionCreationFlag::kEXPLICIT_BATCH);
-  auto trt_network = InferObject(trt_builder->createNetworkV2(explicitBatch));
-  auto trt_parser  = InferObject(nvonnxparser::createParser(*trt_network, *trt_logger));
+  bool use_fp16 = false;
+  if (dmlc::GetEnv("MXNET_TENSORRT_USE_FP16", true)) {
+    if (trt_builder->platformHasFastFp16()) {
+      use_fp16 = true;
+    } else {
+      LOG(WARNING) << "TensorRT can't use fp16 on this platform";
+    }
+  }
   ::ONNX_NAMESPACE::ModelProto parsed_model;
   // We check for a valid parse, but the main effect is the side effect
   // of populating parsed_model
   if (!parsed_model.ParseFromString(onnx_model)) {
     throw dmlc::Error("Could not parse ONNX from string");
   }
+
+  std::string cache_path;
+  if (!cache_dir.empty()) {
+    cache_path = cache_dir + "/" +
+        EngineCacheKey(&parsed_model, max_workspace_size, use_fp16, dynamic_axes) + ".trt";
+    std::ifstream cache_file(cache_path, std::ios::binary);
+    if (cache_file) {
+      const std::string serialized((std::istreambuf_iterator<char>(cache_file)),
+                                   std::istreambuf_iterator<char>());
+      auto trt_runtime = InferObject(nvinfer1::createInferRuntime(*trt_logger));
+      nvinfer1::ICudaEngine* engine =
+          trt_runtime->deserializeCudaEngine(serialized.data(), serialized.size(), nullptr);
+      if (engine != nullptr) {
+        return std::make_tuple(InferObject(engine), unique_ptr<nvonnxparser::IParser>(),
+                               std::move(trt_logger), std::move(trt_runtime));
+      }
+      LOG(WARNING) << "Cannot deserialize the cached TensorRT engine " << cache_path
+                   << ", building it again";
+    }
+  }
+
+  const auto explicitBatch = 1U << static_cast<uint32_t>(
+                             nvinfer1::NetworkDefinitionCreationFlag::kEXPLICIT_BATCH);
+  auto trt_network = InferObject(trt_builder->createNetworkV2(explicitBatch));
+  auto trt_parser  = InferObject(nvonnxparser::createParser(*trt_network, *trt_logger));
   if ( !trt_parser->parse(onnx_model.c_str(), onnx_model.size()) ) {
       size_t nerror = trt_parser->getNbErrors();
       for ( size_t i=0; i < nerror; ++i ) {
@@ -112,18 +183,52 @@ std::tuple<unique_ptr<nvinfer1::ICudaEngine>,
       }
       throw dmlc::Error("Cannot parse ONNX into TensorRT Engine");
   }
-  if (dmlc::GetEnv("MXNET_TENSORRT_USE_FP16", true)) {
-    if (trt_builder->platformHasFastFp16()) {
-      trt_builder->setFp16Mode(true);
-    } else {
-      LOG(WARNING) << "TensorRT can't use fp16 on this platform";
+  auto trt_config = InferObject(trt_builder->createBuilderConfig());
+  if (use_fp16) {
+    trt_config->setFlag(nvinfer1::BuilderFlag::kFP16);
+  }
+  trt_config->setMaxWorkspaceSize(max_workspace_size);
+  if (!dynamic_axes.empty()) {
+    // one profile serving every size of the dynamic axes, tuned for the largest
+    nvinfer1::IOptimizationProfile* profile = trt_builder->createOptimizationProfile();
+    for (int i = 0; i < trt_network->getNbInputs(); ++i) {
+      const nvinfer1::ITensor* input = trt_network->getInput(i);
+      nvinfer1::Dims min_dims = input->getDimensions();
+      nvinfer1::Dims max_dims = min_dims;
+      for (int d = 0; d < min_dims.nbDims; ++d) {
+        if (min_dims.d[d] != -1) continue;
+        auto it = dynamic_axes.find(d);
+        if (it == dynamic_axes.end()) {
+          throw dmlc::Error("Input " + std::string(input->getName()) + " has a dynamic axis " +
+                            std::to_string(d) + " without a maximum size");
+        }
+        min_dims.d[d] = 1;
+        max_dims.d[d] = it->second;
+      }
+      profile->setDimensions(input->getName(), nvinfer1::OptProfileSelector::kMIN, min_dims);
+      profile->setDimensions(input->getName(), nvinfer1::OptProfileSelector::kOPT, max_dims);
+      profile->setDimensions(input->getName(), nvinfer1::OptProfileSelector::kMAX, max_dims);
     }
+    trt_config->addOptimizationProfile(profile);
   }
   trt_builder->setMaxBatchSize(max_batch_size);
-  trt_builder->setMaxWorkspaceSize(max_workspace_size);
   trt_builder->setDebugSync(debug_builder);
-  auto trt_engine = InferObject(trt_builder->buildCudaEngine(*trt_network));
-  return std::make_tuple(std::move(trt_engine), std::move(trt_parser), std::move(trt_logger));
+  auto trt_engine = InferObject(trt_builder->buildEngineWithConfig(*trt_network, *trt_config));
+
+  if (!cache_path.empty()) {
+    // write to a temporary file first, so that concurrent processes never read a partial one
+    auto serialized = InferObject(trt_engine->serialize());
+    const std::string tmp_path = cache_path + ".tmp" + std::to_string(std::time(nullptr));
+    std::ofstream cache_file(tmp_path, std::ios::binary);
+    cache_file.write(static_cast<const char*>(serialized->data()), serialized->size());
+    cache_file.close();
+    if (!cache_file || std::rename(tmp_path.c_str(), cache_path.c_str()) != 0) {
+      LOG(WARNING) << "Cannot write the TensorRT engine cache " << cache_path;
+      std::remove(tmp_path.c_str());
+    }
+  }
+  return std::make_tuple(std::move(trt_engine), std::move(trt_parser), std::move(trt_logger),
+                         unique_ptr<nvinfer1::IRuntime>());
 }
 
 }  // namespace onnx_to_tensorrt
@@ -34,6 +34,7 @@
 #include <fstream>
 #include <memory>
 #include <iostream>
+#include <map>
 #include <sstream>
 #include <string>
 #include <ctime>
@@ -83,12 +84,24 @@ class TRT_Logger : public nvinfer1::ILogger {
   }
 };
 
+/*!
+ * \brief Build the TensorRT engine of an ONNX model, or load it from the cache
+ * \param dynamic_axes maximum size of each dynamic input axis; the engine then has one
+ *        optimization profile from 1 to that size
+ * \param cache_dir directory of the serialized engines, keyed by a hash of the model,
+ *        the GPU and the build settings; empty to always build
+ * \return the engine, the parser (null for a cached engine), the logger and the runtime
+ *          (null for a built engine), the last three having to outlive the engine
+ */
 std::tuple<unique_ptr<nvinfer1::ICudaEngine>,
            unique_ptr<nvonnxparser::IParser>,
-           std::unique_ptr<TRT_Logger> > onnxToTrtCtx(
+           std::unique_ptr<TRT_Logger>,
+           unique_ptr<nvinfer1::IRuntime> > onnxToTrtCtx(
         const std::string& onnx_model,
         int32_t max_batch_size = 32,
         size_t max_workspace_size = 1L << 30,
+        const std::map<int, int>& dynamic_axes = std::map<int, int>(),
+        const std::string& cache_dir = "",
         nvinfer1::ILogger::Severity verbosity = nvinfer1::ILogger::Severity::kWARNING,
         bool debug_builder = false);
 }  // namespace onnx_to_tensorrt
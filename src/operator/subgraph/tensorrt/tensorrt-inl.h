@@ -30,6 +30,8 @@
 
 #include <onnx-tensorrt/NvOnnxParser.h>
 
+#include <algorithm>
+#include <map>
 #include <utility>
 #include <string>
 #include <vector>
@@ -62,8 +64,10 @@ struct TRTEngineParam {
   TRTEngineParam(onnx_to_tensorrt::unique_ptr<nvinfer1::ICudaEngine> _trt_engine,
                  onnx_to_tensorrt::unique_ptr<nvonnxparser::IParser> _trt_parser,
                  std::unique_ptr<onnx_to_tensorrt::TRT_Logger> _trt_logger,
+                 onnx_to_tensorrt::unique_ptr<nvinfer1::IRuntime> _trt_runtime,
                  const std::unordered_map<std::string, uint32_t>& input_map,
                  const std::unordered_map<std::string, uint32_t>& output_map) {
+    trt_runtime = std::move(_trt_runtime);
     trt_engine = std::move(_trt_engine);
     trt_logger = std::move(_trt_logger);
     trt_parser = std::move(_trt_parser);
@@ -71,8 +75,13 @@ struct TRTEngineParam {
     bindings = std::make_shared<std::vector<void*> >();
     binding_order->reserve(trt_engine->getNbBindings());
     bindings->resize(trt_engine->getNbBindings());
+    dynamic_shapes = false;
     for (int b = 0; b < trt_engine->getNbBindings(); ++b) {
       const std::string& binding_name = trt_engine->getBindingName(b);
+      const nvinfer1::Dims dims = trt_engine->getBindingDimensions(b);
+      for (int d = 0; d < dims.nbDims; ++d) {
+        dynamic_shapes |= dims.d[d] == -1;
+      }
       if (trt_engine->bindingIsInput(b)) {
         binding_order->emplace_back(input_map.at(binding_name), true);
       } else {
@@ -82,12 +91,16 @@ struct TRTEngineParam {
     trt_executor = onnx_to_tensorrt::InferObject(trt_engine->createExecutionContext());
   }
 
+  /*! \brief runtime of an engine deserialized from the cache, it must outlive the engine */
+  onnx_to_tensorrt::unique_ptr<nvinfer1::IRuntime> trt_runtime;
   onnx_to_tensorrt::unique_ptr<nvinfer1::ICudaEngine> trt_engine;
   onnx_to_tensorrt::unique_ptr<nvinfer1::IExecutionContext> trt_executor;
   onnx_to_tensorrt::unique_ptr<nvonnxparser::IParser> trt_parser;
   std::unique_ptr<onnx_to_tensorrt::TRT_Logger> trt_logger;
   std::shared_ptr<std::vector<std::pair<uint32_t, bool> > > binding_order;
   std::shared_ptr<std::vector<void*> > bindings;
+  /*! \brief whether the input shapes have to be set before each run */
+  bool dynamic_shapes;
 };
 
 class TensorrtSelector : public SubgraphSelector {
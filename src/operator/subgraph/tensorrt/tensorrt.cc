@@ -310,11 +310,27 @@ OpStatePtr TRTCreateState(const nnvm::NodeAttrs& attrs, Context ctx,
   graph.attrs["shape_inputs"] = std::make_shared<nnvm::any>(std::move(shape_inputs));
   graph.attrs["dtype"]        = std::make_shared<nnvm::any>(std::move(dtypes));
   graph.attrs["shape"]        = std::make_shared<nnvm::any>(std::move(shapes));
+  // the batch axis, and the sequence axis (axis 1) with a maximum sequence length, are
+  // left dynamic up to their maximum size so that one engine serves every smaller size
+  std::map<int, int> dynamic_axes;
+  if (dmlc::GetEnv("MXNET_TENSORRT_DYNAMIC_SHAPES", false)) {
+    dynamic_axes[0] = max_batch_size;
+    const int max_seq_len = dmlc::GetEnv("MXNET_TENSORRT_MAX_SEQ_LEN", 0);
+    if (max_seq_len > 0 && in_shape[0].ndim() > 1) {
+      dynamic_axes[1] = std::max(max_seq_len, static_cast<int>(in_shape[0][1]));
+    }
+    std::vector<int> axes;
+    for (const auto& axis : dynamic_axes) axes.push_back(axis.first);
+    graph.attrs["dynamic_axes"] = std::make_shared<nnvm::any>(std::move(axes));
+  }
   auto onnx_graph = op::nnvm_to_onnx::ConvertNnvmGraphToOnnx(graph, &params_map);
-  auto trt_tuple = ::onnx_to_tensorrt::onnxToTrtCtx(onnx_graph, max_batch_size, 1 << 30);
+  auto trt_tuple = ::onnx_to_tensorrt::onnxToTrtCtx(
+      onnx_graph, max_batch_size, 1 << 30, dynamic_axes,
+      dmlc::GetEnv("MXNET_TENSORRT_ENGINE_CACHE_DIR", std::string()));
   return OpStatePtr::Create<TRTEngineParam>(std::move(std::get<0>(trt_tuple)),
                                             std::move(std::get<1>(trt_tuple)),
                                             std::move(std::get<2>(trt_tuple)),
+                                            std::move(std::get<3>(trt_tuple)),
                                             inputs_to_idx, outputs_to_idx);
 }
 
@@ -331,7 +347,8 @@ NNVM_REGISTER_OP(_TensorRT)
     .set_attr<FCreateOpState>("FCreateOpState", TRTCreateState)
     .set_attr<FInferStorageType>("FInferStorageType", TRTInferStorageType);
 
-MXNET_REGISTER_SUBGRAPH_BACKEND(TensorRT);
+MXNET_REGISTER_SUBGRAPH_BACKEND(TensorRT)
+.set_attr("context", Context::GPU());
 
 MXNET_REGISTER_SUBGRAPH_PROPERTY(TensorRT, TensorrtProperty);
 }  // namespace op
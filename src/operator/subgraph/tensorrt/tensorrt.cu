@@ -52,6 +52,16 @@ void TRTCompute(const OpStatePtr& state, const OpContext& ctx,
     auto& p = param.binding_order->at(i);
     if (p.second == true) {
       param.bindings->at(i) = inputs[p.first].dptr_;
+      if (param.dynamic_shapes) {
+        const TShape& shape = inputs[p.first].shape_;
+        nvinfer1::Dims dims;
+        dims.nbDims = shape.ndim();
+        for (int d = 0; d < shape.ndim(); ++d) {
+          dims.d[d] = static_cast<int>(shape[d]);
+        }
+        CHECK(param.trt_executor->setBindingDimensions(i, dims))
+          << "Input shape " << shape << " is out of the range of the TensorRT engine";
+      }
     } else {
       param.bindings->at(i) = outputs[p.first].dptr_;
     }
@@ -189,10 +189,11 @@ bool is_type_udf(const int &x) {
   return x == -1;
 }
 
-LoopState::LoopState(const nnvm::Symbol &g) {
+LoopState::LoopState(const nnvm::Symbol &g, bool static_alloc) {
   this->subgraph_sym = g;
   this->subgraph.outputs = g.outputs;
   this->iter_op = LoopState::MakeSharedOp(g);
+  if (static_alloc) this->static_op = LoopState::MakeSharedOp(g, true);
 }
 
 void LoopState::Forward(int iter_no,
@@ -219,7 +220,9 @@ void LoopState::Forward(int iter_no,
     outputs[i] = &out_bufs[i];
   CHECK(inputs.size() > 0) << "loop forward requires at least 1 input";
   Context default_ctx = cinputs[0].ctx();
-  OpStatePtr state = iter_op->Forward(nullptr, inputs, outputs, default_ctx);
+  // recorded iterations keep their own buffers, which the backward reads
+  CachedOpPtr op = is_recording || !static_op ? iter_op : static_op;
+  OpStatePtr state = op->Forward(nullptr, inputs, outputs, default_ctx);
   // If an input and an output share the array, the output array will be changed
   // by CachedOp. We need to copy data to the real output.
   for (size_t i = 0; i < out_bufs.size(); i++)
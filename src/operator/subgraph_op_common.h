@@ -135,11 +135,14 @@ class LoopState {
   // which will be used in the backward.
   std::vector<OpStatePtr> all_states;
   CachedOpPtr iter_op;
+  // With static_alloc, the iterations that are not recorded run through this op,
+  // whose memory is planned once and reused by all of them.
+  CachedOpPtr static_op;
   nnvm::Symbol subgraph_sym;
   nnvm::Graph subgraph;
 
  public:
-  explicit LoopState(const nnvm::Symbol &g);
+  explicit LoopState(const nnvm::Symbol &g, bool static_alloc = false);
 
   void Forward(int iter_no,
                const std::vector<NDArray> &inputs,
@@ -155,15 +158,26 @@ class LoopState {
     all_inputs.clear();
     all_states.clear();
   }
-  static CachedOpPtr MakeSharedOp(const nnvm::Symbol &sym) {
+  bool static_alloc() const {
+    return static_op != nullptr;
+  }
+  static CachedOpPtr MakeSharedOp(const nnvm::Symbol &sym, bool static_alloc = false) {
     // We turn on static_alloc for two reasons.
     // It avoids the overhead of unnecessary memory allocation.
     // only static_alloc supports nested call of CachedOp.
     std::vector<std::pair<std::string, std::string> > kwargs = {
       {"inline_limit", "0"},
       {"static_alloc", "1"},
-      {"is_dynamic", "1"}
+      {"is_dynamic", static_alloc ? "0" : "1"}
     };
+    if (static_alloc) {
+      // the whole body is pushed to the engine as a single bulk segment
+      nnvm::Graph g;
+      g.outputs = sym.outputs;
+      const std::string num_nodes = std::to_string(g.indexed_graph().num_nodes());
+      kwargs.emplace_back("forward_bulk_size", num_nodes);
+      kwargs.emplace_back("backward_bulk_size", num_nodes);
+    }
     return std::make_shared<CachedOp>(sym, kwargs);
   }
 };
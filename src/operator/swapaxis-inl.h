@@ -131,7 +131,14 @@ class SwapAxisOp : public Operator {
 
     if (shape_in.Size() == 0U) return;
 
-    if (axis1 == axis2) {
+    Shape<5> inter_shape;
+
+    Reshape2Five(&inter_shape, shape_in, axis1, axis2);
+
+    // the layout in memory is kept if at most one of the swapped axes and the axes
+    // between them is longer than 1
+    const int moved = (inter_shape[1] > 1) + (inter_shape[2] > 1) + (inter_shape[3] > 1);
+    if (axis1 == axis2 || moved <= 1) {
       if (out_req == kAddTo) {
         mxnet_op::Kernel<mxnet_op::op_with_req<mshadow_op::identity, kAddTo>, xpu>::Launch(
           s, data_out.Size(), data_out.dptr<DType>(), data_in.dptr<DType>());
@@ -141,10 +148,6 @@ class SwapAxisOp : public Operator {
       return;
     }
 
-    Shape<5> inter_shape;
-
-    Reshape2Five(&inter_shape, shape_in, axis1, axis2);
-
     Tensor<xpu, 5, DType> inter_data_in = data_in.get_with_shape<xpu, 5, DType>(inter_shape, s);
 
     Shape<5> inter_shape2 = inter_shape;
@@ -22,11 +22,125 @@
  * \brief Casts used by AMP (GPU operators)
  */
 
+#include <map>
+#include <utility>
+#include <vector>
 #include "./amp_cast.h"
 
 namespace mxnet {
 namespace op {
 
+namespace {
+// Chunked multi-tensor launches, as in
+// https://github.com/NVIDIA/apex/blob/master/csrc/multi_tensor_apply.cuh
+const int kMultiCastMaxTensors = 64;
+const int kMultiCastMaxBlocks = 320;
+const int kMultiCastChunkSize = 16384;
+
+/*! \brief tensors of a launch and the chunk of a tensor of each block, passed by value */
+template<typename SrcDType, typename DstDType>
+struct MultiCastKernelParam {
+  const SrcDType* inputs[kMultiCastMaxTensors];
+  DstDType* outputs[kMultiCastMaxTensors];
+  index_t sizes[kMultiCastMaxTensors];
+  unsigned char block_to_tensor[kMultiCastMaxBlocks];
+  int block_to_chunk[kMultiCastMaxBlocks];
+};
+
+template<typename SrcDType, typename DstDType>
+__global__ void MultiCastKernel(const MultiCastKernelParam<SrcDType, DstDType> param) {
+  const int tensor = param.block_to_tensor[blockIdx.x];
+  const index_t begin = static_cast<index_t>(param.block_to_chunk[blockIdx.x]) *
+                        kMultiCastChunkSize;
+  const index_t end = min(begin + kMultiCastChunkSize, param.sizes[tensor]);
+  const SrcDType* in = param.inputs[tensor];
+  DstDType* out = param.outputs[tensor];
+  for (index_t i = begin + threadIdx.x; i < end; i += blockDim.x) {
+    out[i] = static_cast<DstDType>(in[i]);
+  }
+}
+
+/*! \brief cast the tensors of the same input and output types, in as few launches as possible */
+template<typename SrcDType, typename DstDType>
+void MultiCast(mshadow::Stream<gpu>* s, const std::vector<TBlob>& inputs,
+               const std::vector<TBlob>& outputs, const std::vector<int>& tensors) {
+  cudaStream_t stream = mshadow::Stream<gpu>::GetStream(s);
+  const int nthreads = mshadow::cuda::kBaseThreadNum;
+  MultiCastKernelParam<SrcDType, DstDType> param;
+  int num_tensors = 0;
+  int num_blocks = 0;
+  for (const int t : tensors) {
+    const index_t size = inputs[t].Size();
+    param.inputs[num_tensors] = inputs[t].dptr<SrcDType>();
+    param.outputs[num_tensors] = outputs[t].dptr<DstDType>();
+    param.sizes[num_tensors] = size;
+    const index_t num_chunks = (size + kMultiCastChunkSize - 1) / kMultiCastChunkSize;
+    for (index_t c = 0; c < num_chunks; ++c) {
+      param.block_to_tensor[num_blocks] = num_tensors;
+      param.block_to_chunk[num_blocks] = c;
+      ++num_blocks;
+      const bool last_chunk = c == num_chunks - 1;
+      if (num_blocks == kMultiCastMaxBlocks ||
+          (last_chunk && num_tensors + 1 == kMultiCastMaxTensors)) {
+        MultiCastKernel<<<num_blocks, nthreads, 0, stream>>>(param);
+        num_blocks = 0;
+        if (last_chunk) {
+          num_tensors = -1;
+        } else {
+          // the rest of the tensor goes to the next launch
+          param.inputs[0] = param.inputs[num_tensors];
+          param.outputs[0] = param.outputs[num_tensors];
+          param.sizes[0] = param.sizes[num_tensors];
+          num_tensors = 0;
+        }
+      }
+    }
+    ++num_tensors;
+  }
+  if (num_blocks > 0) {
+    MultiCastKernel<<<num_blocks, nthreads, 0, stream>>>(param);
+  }
+  MSHADOW_CUDA_POST_KERNEL_CHECK(MultiCastKernel);
+}
+}  // namespace
+
+template<>
+void AMPMultiCastCompute<gpu>(const nnvm::NodeAttrs& attrs,
+                              const OpContext& ctx,
+                              const std::vector<TBlob>& inputs,
+                              const std::vector<OpReqType>& req,
+                              const std::vector<TBlob>& outputs) {
+  using namespace mshadow;
+  using namespace mshadow::expr;
+  Stream<gpu> *s = ctx.get_stream<gpu>();
+  // tensors written by the multi-tensor kernels, by input and output types
+  std::map<std::pair<int, int>, std::vector<int>> groups;
+  for (size_t i = 0; i < outputs.size(); ++i) {
+    if (req[i] == kNullOp || inputs[i].Size() == 0 ||
+        (outputs[i].type_flag_ == inputs[i].type_flag_ && req[i] == kWriteInplace)) {
+      continue;
+    }
+    if (req[i] != kAddTo) {
+      groups[std::make_pair(inputs[i].type_flag_, outputs[i].type_flag_)].push_back(i);
+      continue;
+    }
+    MSHADOW_TYPE_SWITCH(outputs[i].type_flag_, DstDType, {
+      Tensor<gpu, 1, DstDType> out = outputs[i].FlatTo1D<gpu, DstDType>(s);
+      MSHADOW_TYPE_SWITCH(inputs[i].type_flag_, SrcDType, {
+        Tensor<gpu, 1, SrcDType> data = inputs[i].FlatTo1D<gpu, SrcDType>(s);
+        Assign(out, req[i], tcast<DstDType>(data));
+      });
+    });
+  }
+  for (const auto& group : groups) {
+    MSHADOW_TYPE_SWITCH(group.first.first, SrcDType, {
+      MSHADOW_TYPE_SWITCH(group.first.second, DstDType, {
+        MultiCast<SrcDType, DstDType>(s, inputs, outputs, group.second);
+      });
+    });
+  }
+}
+
 NNVM_REGISTER_OP(amp_cast)
 .set_attr<FCompute>("FCompute<gpu>", AMPCastCompute<gpu>);
 NNVM_REGISTER_OP(_backward_amp_cast)
@@ -168,6 +168,14 @@ void AMPMultiCastCompute(const nnvm::NodeAttrs& attrs,
   }
 }
 
+/*! \brief GPU version, casting the tensors of the same types with multi-tensor kernels */
+template<>
+void AMPMultiCastCompute<gpu>(const nnvm::NodeAttrs& attrs,
+                              const OpContext& ctx,
+                              const std::vector<TBlob>& inputs,
+                              const std::vector<OpReqType>& req,
+                              const std::vector<TBlob>& outputs);
+
 }  // namespace op
 }  // namespace mxnet
 
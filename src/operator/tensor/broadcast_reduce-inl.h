@@ -27,6 +27,7 @@
 
 #include <mxnet/operator_util.h>
 #include <algorithm>
+#include <memory>
 #include <vector>
 #include <string>
 #include <utility>
@@ -301,23 +302,138 @@ inline int fastest_stride(const TShape &small, const TShape &big,
 
 }  // namespace
 
+/*! \brief minimum length of the innermost dimension of the broadcasts computed by rows */
+const index_t kBroadcastMinRow = 16;
+/*! \brief elements of a row computed by a task */
+const index_t kBroadcastSegment = 4096;
+
+template<int req, int ndim, typename DType, typename OP>
+void binary_broadcast_rows(const index_t rows, const index_t len, const Shape<ndim>& rows_shape,
+                           const Shape<ndim>& lstride, const Shape<ndim>& rstride,
+                           const bool lrow, const bool rrow,
+                           const DType *lhs, const DType *rhs, DType *out) {
+  const index_t segments = (len + kBroadcastSegment - 1) / kBroadcastSegment;
+  const int omp_threads = rows * len >= kBroadcastSegment ?
+      engine::OpenMP::Get()->GetRecommendedOMPThreadCount() : 1;
+  #pragma omp parallel for num_threads(omp_threads)
+  for (index_t t = 0; t < rows * segments; ++t) {
+    const index_t row = t / segments;
+    const index_t begin = (t - row * segments) * kBroadcastSegment;
+    const index_t end = std::min(len, begin + kBroadcastSegment);
+    const Shape<ndim> coord = mxnet_op::unravel(row, rows_shape);
+    const DType *l = lhs + mxnet_op::dot(coord, lstride);
+    const DType *r = rhs + mxnet_op::dot(coord, rstride);
+    DType *o = out + row * len;
+    if (lrow && rrow) {
+      for (index_t i = begin; i < end; ++i) KERNEL_ASSIGN(o[i], req, OP::Map(l[i], r[i]));
+    } else if (lrow) {
+      const DType rval = r[0];
+      for (index_t i = begin; i < end; ++i) KERNEL_ASSIGN(o[i], req, OP::Map(l[i], rval));
+    } else {
+      const DType lval = l[0];
+      for (index_t i = begin; i < end; ++i) KERNEL_ASSIGN(o[i], req, OP::Map(lval, r[i]));
+    }
+  }
+}
+
+/*!
+ * \brief broadcast computed by rows of the innermost dimension, in which each operand is
+ *  either contiguous or a scalar, e.g. (N, C, H, W) + (1, C, 1, 1) as N * C rows of H * W.
+ *  The rows are contiguous loops, vectorized by the compiler, only their start is unraveled.
+ * \return false if the innermost dimension is too short, nothing is computed then
+ */
+template<int ndim, typename DType, typename OP>
+bool BinaryBroadcastRows(const OpReqType req, const Shape<ndim>& lstride,
+                         const Shape<ndim>& rstride, const Shape<ndim>& oshape,
+                         const DType *lhs, const DType *rhs, DType *out) {
+  int k = ndim - 1;
+  while (k > 0 && oshape[k] == 1) --k;
+  const index_t len = oshape[k];
+  if (len < kBroadcastMinRow) return false;
+  Shape<ndim> rows_shape = oshape;
+  rows_shape[k] = 1;
+  // at least one operand is contiguous in the innermost dimension of the compacted shapes
+  const bool lrow = lstride[k] != 0, rrow = rstride[k] != 0;
+  MXNET_ASSIGN_REQ_SWITCH(req, Req, {
+    binary_broadcast_rows<Req, ndim, DType, OP>(rows_shape.Size(), len, rows_shape,
+                                                lstride, rstride, lrow, rrow, lhs, rhs, out);
+  });
+  return true;
+}
+
 template<int ndim, typename DType, typename OP>
 void BinaryBroadcastComputeImpl(Stream<cpu> *s, const OpReqType req,
                                 const TBlob& lhs, const TBlob& rhs, const TBlob& out) {
   mshadow::Shape<ndim> oshape = out.shape_.get<ndim>();
   mshadow::Shape<ndim> lstride = mxnet_op::calc_stride(lhs.shape_.get<ndim>());
   mshadow::Shape<ndim> rstride = mxnet_op::calc_stride(rhs.shape_.get<ndim>());
+  if (BinaryBroadcastRows<ndim, DType, OP>(req, lstride, rstride, oshape, lhs.dptr<DType>(),
+                                           rhs.dptr<DType>(), out.dptr<DType>())) {
+    return;
+  }
   mxnet_op::Kernel<mxnet_op::binary_broadcast_kernel<ndim, OP>, cpu>::
   template LaunchEx(s, out.shape_.Size(), req, lstride, rstride, oshape,
                     lhs.dptr<DType>(), rhs.dptr<DType>(), out.dptr<DType>());
 }
 
+/*! \brief reduced elements of a block, traversed for all the outputs while in cache */
+const size_t kReduceBlock = 1024;
+
+/*!
+ * \brief reduction to fewer outputs than threads: the threads reduce parts of the reduced
+ *  elements, and their partial results are merged
+ */
+template<typename Reducer, int ndim, typename AType, typename DType, typename OType, typename OP>
+void seq_reduce_compute_split(const size_t N, const size_t M, const bool addto,
+                              const DType *big, OType *small, const Shape<ndim> bshape,
+                              const Shape<ndim> sshape, const Shape<ndim> rshape,
+                              const Shape<ndim> rstride, const int num_parts) {
+  const size_t part = (M + num_parts - 1) / num_parts;
+  // values then residuals of the partial results, part p of output idx at p * N + idx
+  std::unique_ptr<AType[]> partials(new AType[2 * num_parts * N]);
+  AType *vals = partials.get(), *residuals = partials.get() + num_parts * N;
+  #pragma omp parallel for num_threads(num_parts)
+  for (int p = 0; p < num_parts; ++p) {
+    index_t offsets[kReduceBlock];
+    AType *val = vals + p * N, *residual = residuals + p * N;
+    for (size_t idx = 0; idx < N; ++idx) Reducer::SetInitValue(val[idx], residual[idx]);
+    const size_t end = std::min(M, (p + 1) * part);
+    for (size_t k0 = p * part; k0 < end; k0 += kReduceBlock) {
+      const size_t block = std::min(kReduceBlock, end - k0);
+      for (size_t k = 0; k < block; ++k) {
+        offsets[k] = mxnet_op::dot(mxnet_op::unravel(k0 + k, rshape), rstride);
+      }
+      for (size_t idx = 0; idx < N; ++idx) {
+        const DType *src = big + mxnet_op::ravel(mxnet_op::unravel(idx, sshape), bshape);
+        for (size_t k = 0; k < block; ++k) {
+          Reducer::Reduce(val[idx], AType(OP::Map(src[offsets[k]])), residual[idx]);
+        }
+      }
+    }
+  }
+  for (size_t idx = 0; idx < N; ++idx) {
+    for (int p = 1; p < num_parts; ++p) {
+      Reducer::Merge(vals[idx], residuals[idx], vals[p * N + idx], residuals[p * N + idx]);
+    }
+    Reducer::Finalize(vals[idx], residuals[idx]);
+    assign(&small[idx], addto, OType(vals[idx]));
+  }
+}
+
 template<typename Reducer, int ndim, typename AType, typename DType, typename OType, typename OP>
 void seq_reduce_compute(const size_t N, const size_t M, const bool addto,
                         const DType *big, OType *small, const Shape<ndim> bshape,
                         const Shape<ndim> sshape, const Shape<ndim> rshape,
                         const Shape<ndim> rstride) {
-  #pragma omp parallel for num_threads(engine::OpenMP::Get()->GetRecommendedOMPThreadCount())
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  if (N < static_cast<size_t>(omp_threads) && M >= 2 * kReduceBlock) {
+    // parts of at least a block each
+    const int num_parts = static_cast<int>(std::min<size_t>(omp_threads, M / kReduceBlock));
+    seq_reduce_compute_split<Reducer, ndim, AType, DType, OType, OP>(
+        N, M, addto, big, small, bshape, sshape, rshape, rstride, num_parts);
+    return;
+  }
+  #pragma omp parallel for num_threads(omp_threads)
   for (index_t idx = 0; idx < static_cast<index_t>(N); ++idx) {
     seq_reduce_assign<Reducer, ndim, AType, DType, OType, OP>(idx, M, addto, big, small,
         bshape, sshape, rshape, rstride);
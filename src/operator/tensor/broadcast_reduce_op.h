@@ -1829,6 +1829,7 @@ Defined in )code";
   .set_attr_parser(AxesParamParser<ReduceAxesParam>)            \
   .set_attr<mxnet::FInferShape>("FInferShape", ReduceAxesShape)  \
   .set_attr<nnvm::FInferType>("FInferType", ElemwiseType<1, 1>) \
+  .set_attr<FComputeCost>("FComputeCost", ReduceCost)           \
   .add_argument("data", "NDArray-or-Symbol", "The input")       \
   .add_arguments(ReduceAxesParam::__FIELDS__())
 
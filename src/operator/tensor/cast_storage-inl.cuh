@@ -36,32 +36,69 @@ namespace mxnet {
 namespace op {
 
 /*!
- * \brief GPU Kernel for filling the value array of the rsp tensor.
- * Parallelized by rsp tensor elements: 1 thread/element
+ * \brief GPU Kernel for filling both the row index array and the value array of the rsp
+ *        tensor from the prefix sum of the row flags, in a single pass over the dense rows.
+ * Parallelized by dense rows: 1 thread/row, for rows shorter than a warp
  */
-struct CastDnsRspValsKernel {
+struct CastDnsRspIdxAndValsThreadKernel {
   /*!
    * \brief
-   * \param tid         global thread id
-   * \param rsp_val     value array of rsp tensor to store data
-   * \param row_idx     indices of non-zero rows
-   * \param dns         dense matrix data
-   * \param nnr         number of non-zero rows
-   * \param row_length  number of elements per row
+   * \param tid          global thread id
+   * \param rsp_val      value array of rsp tensor to store data
+   * \param row_idx      row index array to store indices of non-zero rows
+   * \param row_flg_sum  inclusive prefix sum array over 0/1 marked row flag array
+   * \param dns          dense matrix data
+   * \param num_rows     number of rows of the dense matrix
+   * \param row_length   number of elements per row
    */
   template<typename DType, typename RType>
   __device__ __forceinline__ static void Map(int tid,
                                              DType* rsp_val,
-                                             const RType* row_idx,
+                                             RType* row_idx,
+                                             const nnvm::dim_t* row_flg_sum,
                                              const DType* dns,
-                                             const nnvm::dim_t nnr,
+                                             const nnvm::dim_t num_rows,
+                                             const nnvm::dim_t row_length) {
+    using nnvm::dim_t;
+    if (tid < num_rows) {
+      const dim_t prev = (tid == 0) ? 0 : row_flg_sum[tid-1];
+      if (row_flg_sum[tid] > prev) {
+        row_idx[prev] = static_cast<RType>(tid);
+        for (dim_t j = 0; j < row_length; ++j) {
+          rsp_val[prev * row_length + j] = dns[tid * row_length + j];
+        }
+      }
+    }
+  }
+};
+
+/*!
+ * \brief GPU Kernel for filling both the row index array and the value array of the rsp
+ *        tensor from the prefix sum of the row flags, in a single pass over the dense rows.
+ * Parallelized by dense rows: 1 warp/row
+ */
+struct CastDnsRspIdxAndValsWarpKernel {
+  template<typename DType, typename RType>
+  __device__ __forceinline__ static void Map(int tid,
+                                             DType* rsp_val,
+                                             RType* row_idx,
+                                             const nnvm::dim_t* row_flg_sum,
+                                             const DType* dns,
+                                             const nnvm::dim_t num_rows,
                                              const nnvm::dim_t row_length) {
     using nnvm::dim_t;
-    if (tid < nnr*row_length) {
-      const dim_t row_id = tid / row_length;
-      const dim_t row_el = tid % row_length;
-      const dim_t dns_idx = row_idx[row_id] * row_length + row_el;
-      rsp_val[tid] = dns[dns_idx];
+    const dim_t warp_id = tid / 32;      // global warp   id
+    const dim_t lane    = tid & (32-1);  // local  thread id within warp
+    if (warp_id < num_rows) {
+      const dim_t prev = (warp_id == 0) ? 0 : row_flg_sum[warp_id-1];
+      if (row_flg_sum[warp_id] > prev) {
+        if (lane == 0) {
+          row_idx[prev] = static_cast<RType>(warp_id);
+        }
+        for (dim_t j = lane; j < row_length; j+=32) {
+          rsp_val[prev * row_length + j] = dns[warp_id * row_length + j];
+        }
+      }
     }
   }
 };
@@ -107,10 +144,10 @@ void CastStorageDnsRspGPUImpl_(const OpContext& ctx,
   CHECK_GT(ctx.requested.size(), 0);
   // The resource is located at the end of requested resource array
   mshadow::Tensor<gpu, 1, char> workspace = ctx.requested[ctx.requested.size() - 1]
-    .get_space_typed<gpu, 1, char>(Shape1(num_rows * sizeof(RType) + temp_storage_bytes), s);
+    .get_space_typed<gpu, 1, char>(Shape1(num_rows * sizeof(dim_t) + temp_storage_bytes), s);
 
-  row_flg = reinterpret_cast<RType *>(workspace.dptr_);
-  d_temp_storage = workspace.dptr_ + num_rows * sizeof(RType);
+  row_flg = reinterpret_cast<dim_t *>(workspace.dptr_);
+  d_temp_storage = workspace.dptr_ + num_rows * sizeof(dim_t);
 
   // Mark non-zero rows as 'one' in row_flg
   // Different kernel versions are optimized for different matrix instances
@@ -166,22 +203,24 @@ void CastStorageDnsRspGPUImpl_(const OpContext& ctx,
                             cudaMemcpyDeviceToHost, mshadow::Stream<gpu>::GetStream(s)));
   CUDA_CALL(cudaStreamSynchronize(mshadow::Stream<gpu>::GetStream(s)));
 
-  // Allocate rsp tensor row index array and fill
+  // Allocate rsp tensor row index array and data array
   rsp->CheckAndAllocAuxData(rowsparse::kIdx, Shape1(nnr));
   if (0 == nnr) return;
-  RType *row_idx = rsp->aux_data(rowsparse::kIdx).dptr<RType>();
-  num_threads = num_rows;
-  Kernel<FillRspRowIdxKernel, gpu>::Launch(s, num_threads,
-                                           row_idx, row_flg, num_rows);
-
-  // Construct shape of rsp tensor data, allocate, and fill
   auto storage_shape = dns.shape_;
   storage_shape[0] = nnr;
   rsp->CheckAndAllocData(storage_shape);
-  num_threads = nnr * row_length;
-  Kernel<CastDnsRspValsKernel, gpu>::Launch(s, num_threads,
-                                            rsp->data().dptr<DType>(), row_idx, dns.dptr<DType>(),
-                                            nnr, row_length);
+
+  // Fill the row indices and the rows in a single pass over the dense rows
+  RType *row_idx = rsp->aux_data(rowsparse::kIdx).dptr<RType>();
+  if (row_length < threads_per_warp) {
+    num_threads = num_rows;
+    Kernel<CastDnsRspIdxAndValsThreadKernel, gpu>::Launch(s, num_threads,
+        rsp->data().dptr<DType>(), row_idx, row_flg, dns.dptr<DType>(), num_rows, row_length);
+  } else {
+    num_threads = num_rows * threads_per_warp;
+    Kernel<CastDnsRspIdxAndValsWarpKernel, gpu>::Launch(s, num_threads,
+        rsp->data().dptr<DType>(), row_idx, row_flg, dns.dptr<DType>(), num_rows, row_length);
+  }
 }
 
 
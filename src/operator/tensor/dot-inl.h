@@ -36,6 +36,10 @@
 #include "../elemwise_op_common.h"
 #include "./init_op.h"
 #include "../mxnet_op.h"
+#if MSHADOW_USE_MKL == 1
+#include <mkl_spblas.h>
+#include <climits>
+#endif  // MSHADOW_USE_MKL == 1
 #ifdef __CUDACC__
 #include "./dot-inl.cuh"
 #endif  // __CUDACC__
@@ -348,9 +352,15 @@ inline bool DotBackwardInferStorageType(const nnvm::NodeAttrs& attrs,
   return dispatched;
 }
 
+/*!
+ * \brief columns of the output computed at once by DotCsrDnsDnsByRowBlocks, so that the
+ * slices of the output row and of the rows of dns1 it accumulates stay in cache
+ */
+constexpr nnvm::dim_t kDotCsrDnsColBlock = 512;
+
 /*!
  * \brief CPU Kernel of dot(csr, dns1) = dns2
- * Parallelization by row blocks
+ * Parallelization by row blocks, the columns of a block computed by tiles
  */
 struct DotCsrDnsDnsByRowBlocks {
   /*!
@@ -371,20 +381,55 @@ struct DotCsrDnsDnsByRowBlocks {
     const dim_t seg_start = i * seg_len;
     if (seg_start >= num_rows) return;
     const dim_t seg_end = std::min(seg_start + seg_len, num_rows);
-    for (dim_t j = seg_start; j < seg_end; ++j) {
-      if (indptr_l[j] == indptr_l[j+1]) continue;
-      const dim_t offset_out = j * num_cols;
-      for (IType k = indptr_l[j]; k < indptr_l[j+1]; ++k) {
-        const DType val = data_l[k];
-        const dim_t offset_r = col_idx_l[k] * num_cols;
-        for (dim_t l = 0; l < num_cols; ++l) {
-          out[offset_out+l] += data_r[offset_r+l] * val;
+    for (dim_t tile = 0; tile < num_cols; tile += kDotCsrDnsColBlock) {
+      const dim_t tile_end = std::min(tile + kDotCsrDnsColBlock, num_cols);
+      for (dim_t j = seg_start; j < seg_end; ++j) {
+        if (indptr_l[j] == indptr_l[j+1]) continue;
+        DType* out_row = out + j * num_cols;
+        for (IType k = indptr_l[j]; k < indptr_l[j+1]; ++k) {
+          const DType val = data_l[k];
+          const DType* row_r = data_r + col_idx_l[k] * num_cols;
+          for (dim_t l = tile; l < tile_end; ++l) {
+            out_row[l] += row_r[l] * val;
+          }
         }
       }
     }
   }
 };
 
+/*!
+ * \brief CPU transpose of a csr matrix by a counting sort of its columns. The entries of a
+ * row of the transpose keep the order of the rows of the matrix.
+ * \param num_rows number of rows of the matrix
+ * \param num_cols number of columns of the matrix, rows of the transpose
+ */
+template<typename DType, typename IType, typename CType>
+inline void TransposeCsrCPU(const DType* data, const IType* indptr, const CType* col_idx,
+                            const nnvm::dim_t num_rows, const nnvm::dim_t num_cols,
+                            DType* data_t, IType* indptr_t, CType* col_idx_t) {
+  using nnvm::dim_t;
+  std::fill(indptr_t, indptr_t + num_cols + 1, IType(0));
+  for (IType k = indptr[0]; k < indptr[num_rows]; ++k) {
+    ++indptr_t[col_idx[k] + 1];
+  }
+  for (dim_t c = 0; c < num_cols; ++c) {
+    indptr_t[c + 1] += indptr_t[c];
+  }
+  // indptr_t[c] is the next position of column c, then the start of column c + 1
+  for (dim_t j = 0; j < num_rows; ++j) {
+    for (IType k = indptr[j]; k < indptr[j + 1]; ++k) {
+      const IType pos = indptr_t[col_idx[k]]++;
+      data_t[pos] = data[k];
+      col_idx_t[pos] = static_cast<CType>(j);
+    }
+  }
+  for (dim_t c = num_cols; c > 0; --c) {
+    indptr_t[c] = indptr_t[c - 1];
+  }
+  indptr_t[0] = 0;
+}
+
 /*!
  * \brief CPU Kernel of dot(csr.T(), dns1) = dns2
  * Parallelization by row blocks
@@ -757,6 +802,89 @@ struct DotDnsCsrTransDnsByRowBlocks {
   }
 };
 
+#if MSHADOW_USE_MKL == 1
+inline sparse_status_t MKLSparseCreateCsr(sparse_matrix_t* A, const MKL_INT rows,
+                                          const MKL_INT cols, MKL_INT* indptr,
+                                          MKL_INT* col_idx, float* data) {
+  return mkl_sparse_s_create_csr(A, SPARSE_INDEX_BASE_ZERO, rows, cols, indptr, indptr + 1,
+                                 col_idx, data);
+}
+
+inline sparse_status_t MKLSparseCreateCsr(sparse_matrix_t* A, const MKL_INT rows,
+                                          const MKL_INT cols, MKL_INT* indptr,
+                                          MKL_INT* col_idx, double* data) {
+  return mkl_sparse_d_create_csr(A, SPARSE_INDEX_BASE_ZERO, rows, cols, indptr, indptr + 1,
+                                 col_idx, data);
+}
+
+inline sparse_status_t MKLSparseMM(const sparse_operation_t op, const sparse_matrix_t A,
+                                   const float* B, const MKL_INT cols, const float beta,
+                                   float* C) {
+  matrix_descr descr;
+  descr.type = SPARSE_MATRIX_TYPE_GENERAL;
+  return mkl_sparse_s_mm(op, 1.0f, A, descr, SPARSE_LAYOUT_ROW_MAJOR, B, cols, cols, beta,
+                         C, cols);
+}
+
+inline sparse_status_t MKLSparseMM(const sparse_operation_t op, const sparse_matrix_t A,
+                                   const double* B, const MKL_INT cols, const double beta,
+                                   double* C) {
+  matrix_descr descr;
+  descr.type = SPARSE_MATRIX_TYPE_GENERAL;
+  return mkl_sparse_d_mm(op, 1.0, A, descr, SPARSE_LAYOUT_ROW_MAJOR, B, cols, cols, beta,
+                         C, cols);
+}
+
+/*!
+ * \brief dot(csr, dns1) = dns2 and dot(csr.T, dns1) = dns2 by the sparse BLAS of MKL.
+ * The indices are copied to MKL_INT.
+ * \return false if the sizes overflow MKL_INT
+ */
+template<typename DType, typename IType, typename CType>
+inline bool DotCsrDnsDnsMKL(const OpContext& ctx,
+                            const NDArray& lhs,
+                            const TBlob& rhs,
+                            const OpReqType req,
+                            const bool trans_lhs,
+                            const TBlob& ret) {
+  using nnvm::dim_t;
+  const size_t kMKLIntMax = (sizeof(MKL_INT) == sizeof(int)) ? INT_MAX : LLONG_MAX;
+  const dim_t num_rows = lhs.shape()[0];
+  const dim_t num_cols = lhs.shape()[1];
+  const dim_t nnz = lhs.aux_shape(csr::kIdx)[0];
+  if (static_cast<size_t>(std::max({num_rows + 1, num_cols, nnz, ret.shape_[1]})) >
+      kMKLIntMax) {
+    return false;
+  }
+  mshadow::Stream<cpu>* s = ctx.get_stream<cpu>();
+  mshadow::Tensor<cpu, 1, MKL_INT> idx = ctx.requested[0]
+      .get_space_typed<cpu, 1, MKL_INT>(mshadow::Shape1(num_rows + 1 + nnz), s);
+  MKL_INT* indptr = idx.dptr_;
+  MKL_INT* col_idx = idx.dptr_ + num_rows + 1;
+  const IType* indptr_l = lhs.aux_data(csr::kIndPtr).dptr<IType>();
+  const CType* col_idx_l = lhs.aux_data(csr::kIdx).dptr<CType>();
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  #pragma omp parallel for num_threads(omp_threads)
+  for (dim_t i = 0; i < num_rows + 1; ++i) {
+    indptr[i] = static_cast<MKL_INT>(indptr_l[i]);
+  }
+  #pragma omp parallel for num_threads(omp_threads)
+  for (dim_t i = 0; i < nnz; ++i) {
+    col_idx[i] = static_cast<MKL_INT>(col_idx_l[i]);
+  }
+  sparse_matrix_t A;
+  CHECK_EQ(MKLSparseCreateCsr(&A, num_rows, num_cols, indptr, col_idx,
+                              lhs.data().dptr<DType>()), SPARSE_STATUS_SUCCESS);
+  const sparse_status_t status =
+      MKLSparseMM(trans_lhs ? SPARSE_OPERATION_TRANSPOSE : SPARSE_OPERATION_NON_TRANSPOSE, A,
+                  rhs.dptr<DType>(), ret.shape_[1], DType(req == kAddTo ? 1 : 0),
+                  ret.dptr<DType>());
+  mkl_sparse_destroy(A);
+  CHECK_EQ(status, SPARSE_STATUS_SUCCESS) << "mkl_sparse_?_mm failed";
+  return true;
+}
+#endif  // MSHADOW_USE_MKL == 1
+
 /*!
  * \brief CPU Impl of dot(csr, dns1) = dns2 and dot(csr.T, dns1) = dns2
  */
@@ -786,6 +914,13 @@ inline void DotCsrDnsDnsImpl(const OpContext& ctx,
   MSHADOW_SGL_DBL_TYPE_SWITCH(data_l.type_flag_, DType, {  // data type
     MSHADOW_IDX_TYPE_SWITCH(indptr_l.type_flag_, IType, {  // indptr type
       MSHADOW_IDX_TYPE_SWITCH(col_idx_l.type_flag_, CType, {  // col idx type
+#if MSHADOW_USE_MKL == 1
+        static const bool use_mkl = dmlc::GetEnv("MXNET_MKL_SPARSE_DOT", true);
+        if (use_mkl && (req == kWriteTo || req == kAddTo) &&
+            DotCsrDnsDnsMKL<DType, IType, CType>(ctx, lhs, data_r, req, trans_lhs, data_out)) {
+          return;
+        }
+#endif  // MSHADOW_USE_MKL == 1
         dim_t num_threads;
         if (kWriteTo == req) {
           num_threads = data_out.Size();
@@ -793,6 +928,29 @@ inline void DotCsrDnsDnsImpl(const OpContext& ctx,
               s, num_threads, data_out.dptr<DType>());
         }
         num_threads = mxnet_op::get_num_threads<cpu>(data_out.shape_[0]);
+        // instead of every thread scanning all of csr for the rows of csr.T it computes,
+        // transpose csr once and compute by row blocks of csr.T
+        const DType* data_k = data_l.dptr<DType>();
+        const IType* indptr_k = indptr_l.dptr<IType>();
+        const CType* col_idx_k = col_idx_l.dptr<CType>();
+        const bool transpose = trans_lhs && num_threads > 1;
+        if (transpose) {
+          const dim_t nnz = col_idx_l.shape_.Size();
+          const size_t indptr_bytes = (data_out.shape_[0] + 1) * sizeof(IType);
+          const size_t col_idx_bytes = nnz * sizeof(CType);
+          mshadow::Tensor<cpu, 1, char> workspace = ctx.requested[0]
+              .get_space_typed<cpu, 1, char>(
+                  mshadow::Shape1(indptr_bytes + col_idx_bytes + nnz * sizeof(DType)), s);
+          IType* indptr_t = reinterpret_cast<IType*>(workspace.dptr_);
+          CType* col_idx_t = reinterpret_cast<CType*>(workspace.dptr_ + indptr_bytes);
+          DType* data_t = reinterpret_cast<DType*>(workspace.dptr_ + indptr_bytes +
+                                                   col_idx_bytes);
+          TransposeCsrCPU(data_k, indptr_k, col_idx_k, lhs.shape()[0], data_out.shape_[0],
+                          data_t, indptr_t, col_idx_t);
+          data_k = data_t;
+          indptr_k = indptr_t;
+          col_idx_k = col_idx_t;
+        }
         bool dynamic = false;
         const dim_t large_matrix_threshold = 1024 * 10;
         if (data_out.shape_[0] > large_matrix_threshold) {
@@ -802,23 +960,18 @@ inline void DotCsrDnsDnsImpl(const OpContext& ctx,
           num_threads = data_out.Size() / unit_work_per_thread;
         }
         dim_t seg_len = (data_out.shape_[0] + num_threads - 1) / num_threads;
-        if (trans_lhs) {
+        if (trans_lhs && !transpose) {
           mxnet_op::Kernel<DotCsrTransDnsDnsByRowBlocks, cpu>::Launch(s, num_threads,
-              data_out.dptr<DType>(), data_l.dptr<DType>(), indptr_l.dptr<IType>(),
-              col_idx_l.dptr<CType>(), data_r.dptr<DType>(), seg_len,
-              lhs.shape()[0], data_out.shape_[0], data_out.shape_[1]);
+              data_out.dptr<DType>(), data_k, indptr_k, col_idx_k, data_r.dptr<DType>(),
+              seg_len, lhs.shape()[0], data_out.shape_[0], data_out.shape_[1]);
+        } else if (dynamic) {
+          mxnet_op::Kernel<DotCsrDnsDnsByRowBlocks, cpu>::LaunchDynamic(s, num_threads,
+              data_out.dptr<DType>(), data_k, indptr_k, col_idx_k, data_r.dptr<DType>(),
+              seg_len, data_out.shape_[0], data_out.shape_[1]);
         } else {
-          if (dynamic) {
-            mxnet_op::Kernel<DotCsrDnsDnsByRowBlocks, cpu>::LaunchDynamic(s, num_threads,
-                data_out.dptr<DType>(), data_l.dptr<DType>(), indptr_l.dptr<IType>(),
-                col_idx_l.dptr<CType>(), data_r.dptr<DType>(), seg_len,
-                data_out.shape_[0], data_out.shape_[1]);
-          } else {
-            mxnet_op::Kernel<DotCsrDnsDnsByRowBlocks, cpu>::Launch(s, num_threads,
-                data_out.dptr<DType>(), data_l.dptr<DType>(), indptr_l.dptr<IType>(),
-                col_idx_l.dptr<CType>(), data_r.dptr<DType>(), seg_len,
-                data_out.shape_[0], data_out.shape_[1]);
-          }
+          mxnet_op::Kernel<DotCsrDnsDnsByRowBlocks, cpu>::Launch(s, num_threads,
+              data_out.dptr<DType>(), data_k, indptr_k, col_idx_k, data_r.dptr<DType>(),
+              seg_len, data_out.shape_[0], data_out.shape_[1]);
         }
       });
     });
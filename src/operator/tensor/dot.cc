@@ -23,6 +23,10 @@
  */
 
 #include "./dot-inl.h"
+#if MXNET_USE_MKLDNN == 1
+#include "../nn/mkldnn/mkldnn_base-inl.h"
+#include "../nn/mkldnn/mkldnn_ops-inl.h"
+#endif
 
 namespace mxnet {
 namespace op {
@@ -83,6 +87,14 @@ above patterns, ``dot`` will fallback and generate output with default storage.
     return std::vector<std::string>{"lhs", "rhs"};
   })
 .set_attr<mxnet::FInferShape>("FInferShape", DotShape)
+.set_attr<FComputeCost>("FComputeCost",
+  [](const NodeAttrs& attrs, const mxnet::ShapeVector& in_shapes,
+     const mxnet::ShapeVector& out_shapes) {
+    // a multiply and an add per output element and element of the contracted axis
+    const DotParam& param = nnvm::get<DotParam>(attrs.parsed);
+    const mxnet::TShape& lhs = in_shapes[0];
+    return 2. * out_shapes[0].Size() * (param.transpose_a ? lhs[0] : lhs[lhs.ndim() - 1]);
+  })
 .set_attr<nnvm::FInferType>("FInferType", ElemwiseType<2, 1>)
 .set_attr<FInferStorageType>("FInferStorageType", DotForwardInferStorageType)
 .set_attr<FResourceRequest>("FResourceRequest",
@@ -111,6 +123,32 @@ NNVM_REGISTER_OP(_backward_dot)
 .set_attr<FComputeEx>("FComputeEx<cpu>", DotBackwardEx<cpu>)
 .add_arguments(DotParam::__FIELDS__());
 
+#if MXNET_USE_MKLDNN == 1
+static void BatchDotComputeExCPU(const nnvm::NodeAttrs& attrs,
+                                 const OpContext& ctx,
+                                 const std::vector<NDArray>& inputs,
+                                 const std::vector<OpReqType>& req,
+                                 const std::vector<NDArray>& outputs) {
+  if (SupportMKLDNNBatchDot(inputs, outputs[0])) {
+    MKLDNN_OPCHECK_INIT(false, outputs.size(), inputs, outputs);
+    MKLDNNRun(MKLDNNBatchDotForward, attrs, ctx, inputs, req, outputs);
+    MKLDNN_OPCHECK_RUN(BatchDotForward_<cpu>, attrs, ctx, inputs, req, outputs);
+    return;
+  }
+  FallBackCompute(BatchDotForward_<cpu>, attrs, ctx, inputs, req, outputs);
+}
+
+inline static bool BatchDotStorageType(const nnvm::NodeAttrs& attrs,
+                                       const int dev_mask,
+                                       DispatchMode* dispatch_mode,
+                                       std::vector<int> *in_attrs,
+                                       std::vector<int> *out_attrs) {
+  CHECK_EQ(in_attrs->size(), 2U);
+  CHECK_EQ(out_attrs->size(), 1U);
+  return MKLDNNStorageType(attrs, dev_mask, true, dispatch_mode, in_attrs, out_attrs);
+}
+#endif
+
 NNVM_REGISTER_OP(batch_dot)
 .add_alias("_npx_batch_dot")
 .describe(R"doc(Batchwise dot product.
@@ -133,6 +171,14 @@ which is computed by::
     return std::vector<std::string>{"lhs", "rhs"};
   })
 .set_attr<mxnet::FInferShape>("FInferShape", BatchDotShape)
+.set_attr<FComputeCost>("FComputeCost",
+  [](const NodeAttrs& attrs, const mxnet::ShapeVector& in_shapes,
+     const mxnet::ShapeVector& out_shapes) {
+    const DotParam& param = nnvm::get<DotParam>(attrs.parsed);
+    const mxnet::TShape& lhs = in_shapes[0];
+    const int ndim = lhs.ndim();
+    return 2. * out_shapes[0].Size() * (param.transpose_a ? lhs[ndim - 2] : lhs[ndim - 1]);
+  })
 .set_attr<nnvm::FInferType>("FInferType", ElemwiseType<2, 1>)
 .set_attr<FResourceRequest>("FResourceRequest",
   [](const NodeAttrs& attrs) {
@@ -140,6 +186,11 @@ which is computed by::
   })
 .set_attr<THasDeterministicOutput>("THasDeterministicOutput", true)
 .set_attr<FCompute>("FCompute<cpu>", BatchDotForward_<cpu>)
+#if MXNET_USE_MKLDNN == 1
+.set_attr<bool>("TIsMKLDNN", true)
+.set_attr<FComputeEx>("FComputeEx<cpu>", BatchDotComputeExCPU)
+.set_attr<FInferStorageType>("FInferStorageType", BatchDotStorageType)
+#endif
 .set_attr<nnvm::FGradient>("FGradient",
     [](const nnvm::ObjectPtr& n,
        const std::vector<nnvm::NodeEntry>& ograds) {
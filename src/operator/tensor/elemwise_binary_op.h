@@ -794,6 +794,7 @@ template<typename xpu, typename OP>
     })                                                              \
   .set_attr<mxnet::FInferShape>("FInferShape", ElemwiseShape<2, 1>)  \
   .set_attr<nnvm::FInferType>("FInferType", ElemwiseType<2, 1>)     \
+  .set_attr<FComputeCost>("FComputeCost", ElemwiseCost)             \
   .set_attr<nnvm::FInplaceOption>("FInplaceOption",                 \
     [](const NodeAttrs& attrs){                                     \
       return std::vector<std::pair<int, int> >{{0, 0}, {1, 0}};     \
@@ -452,6 +452,7 @@ class BinaryScalarOp : public UnaryOp {
   .set_attr_parser(ParamParser<NumpyBinaryScalarParam>)                   \
   .set_attr<mxnet::FInferShape>("FInferShape", ElemwiseShape<1, 1>)       \
   .set_attr<nnvm::FInferType>("FInferType", NumpyBinaryScalarType)        \
+  .set_attr<FComputeCost>("FComputeCost", ElemwiseCost)                   \
   .set_attr<nnvm::FInplaceOption>("FInplaceOption",                       \
     [](const NodeAttrs& attrs){                                           \
       return std::vector<std::pair<int, int> >{{0, 0}};                   \
@@ -36,6 +36,7 @@
 #include "../mshadow_op.h"
 #include "../mxnet_op.h"
 #include "../elemwise_op_common.h"
+#include "../simd_functions.h"
 #include "../../common/utils.h"
 #include "../../ndarray/ndarray_function.h"
 
@@ -250,7 +251,9 @@ class UnaryOp : public OpBase {
                        const std::vector<TBlob>& outputs) {
     MSHADOW_TYPE_SWITCH(outputs[0].type_flag_, DType, {
       MXNET_ASSIGN_REQ_SWITCH(req[0], Req, {
-        if (inputs[0].Size() != 0) {
+        if (inputs[0].Size() != 0 &&
+            !simd_func::Unary<OP>(Req, inputs[0].Size(), inputs[0].dptr<DType>(),
+                                  outputs[0].dptr<DType>())) {
           mxnet_op::Kernel<mxnet_op::op_with_req<OP, Req>, cpu>::Launch(
             s, inputs[0].Size(), outputs[0].dptr<DType>(), inputs[0].dptr<DType>());
         }
@@ -853,6 +856,7 @@ void NumpyNanToNumOpBackward(const nnvm::NodeAttrs& attrs,
   .set_num_outputs(1)                                               \
   .set_attr<mxnet::FInferShape>("FInferShape", ElemwiseShape<1, 1>) \
   .set_attr<nnvm::FInferType>("FInferType", ElemwiseType<1, 1>)     \
+  .set_attr<FComputeCost>("FComputeCost", ElemwiseCost)             \
   .set_attr<nnvm::FInplaceOption>("FInplaceOption",                 \
     [](const NodeAttrs& attrs){                                     \
       return std::vector<std::pair<int, int> >{{0, 0}};             \
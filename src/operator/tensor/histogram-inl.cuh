@@ -0,0 +1,95 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file histogram-inl.cuh
+ * \brief Histogram privatized in the shared memory of the blocks, for histogram and bincount
+ */
+#ifndef MXNET_OPERATOR_TENSOR_HISTOGRAM_INL_CUH_
+#define MXNET_OPERATOR_TENSOR_HISTOGRAM_INL_CUH_
+
+#include <mxnet/base.h>
+#include <algorithm>
+#include "../mxnet_op.h"
+#include "../../common/cuda/utils.h"
+
+namespace mxnet {
+namespace op {
+
+/*! \brief number of threads of the blocks of the privatized histogram */
+constexpr int kHistogramThreads = 256;
+/*! \brief maximum size in bytes of the bins of a block of the privatized histogram */
+constexpr size_t kHistogramMaxSharedBytes = 48 * 1024;
+
+/*!
+ * \brief Each block counts a grid-strided part of the num elements into its own copy of
+ *  the num_bins bins in shared memory, then adds its copy to the global bins.
+ *  op.Bin(i) is the bin of element i, or -1 to skip it, and op.Weight(i) is its weight.
+ */
+template<typename CType, typename BinOp>
+__global__ void PrivatizedHistogramKernel(CType* bins, const index_t num,
+                                          const int num_bins, const BinOp op) {
+  extern __shared__ __align__(sizeof(CType)) unsigned char shared_memory[];
+  CType* shared_bins = reinterpret_cast<CType*>(shared_memory);
+  for (int b = threadIdx.x; b < num_bins; b += blockDim.x) {
+    shared_bins[b] = CType(0);
+  }
+  __syncthreads();
+  for (index_t i = blockIdx.x * blockDim.x + threadIdx.x; i < num;
+       i += static_cast<index_t>(blockDim.x) * gridDim.x) {
+    const int target = op.Bin(i);
+    if (target >= 0) {
+      atomicAdd(&shared_bins[target], op.Weight(i));
+    }
+  }
+  __syncthreads();
+  for (int b = threadIdx.x; b < num_bins; b += blockDim.x) {
+    if (shared_bins[b] != CType(0)) {
+      atomicAdd(&bins[b], shared_bins[b]);
+    }
+  }
+}
+
+/*!
+ * \brief Add the histogram of num elements to the num_bins bins with a histogram per block
+ *  in shared memory, which spares the contention of the global atomics on skewed data
+ *  and few bins.
+ * \return false when the bins do not fit in shared memory or are too many for the elements
+ *  of each block, and the caller then counts the elements with global atomics.
+ */
+template<typename CType, typename BinOp>
+bool PrivatizedHistogram(mshadow::Stream<gpu> *s, const int dev_id, CType* bins,
+                         const index_t num, const int num_bins, const BinOp& op) {
+  const size_t shared_bytes = num_bins * sizeof(CType);
+  if (num_bins <= 0 || shared_bytes > kHistogramMaxSharedBytes) return false;
+  const index_t max_blocks = 4 * common::cuda::MultiprocessorCount(dev_id);
+  const index_t num_blocks =
+    std::min(max_blocks, (num + kHistogramThreads - 1) / kHistogramThreads);
+  // the merge adds num_bins atomics per block
+  if (num_blocks == 0 || num < num_blocks * num_bins) return false;
+  PrivatizedHistogramKernel<<<num_blocks, kHistogramThreads, shared_bytes,
+                              mshadow::Stream<gpu>::GetStream(s)>>>(bins, num, num_bins, op);
+  MSHADOW_CUDA_POST_KERNEL_CHECK(PrivatizedHistogramKernel);
+  return true;
+}
+
+}  // namespace op
+}  // namespace mxnet
+
+#endif  // MXNET_OPERATOR_TENSOR_HISTOGRAM_INL_CUH_
@@ -33,6 +33,7 @@
 #include <nnvm/op.h>
 #include <nnvm/node.h>
 #include <nnvm/op_attr_types.h>
+#include <algorithm>
 #include <vector>
 #include <string>
 #include <unordered_map>
@@ -42,6 +43,7 @@
 #include "../mshadow_op.h"
 #include "../mxnet_op.h"
 #include "../operator_common.h"
+#include "../../engine/openmp.h"
 
 namespace mxnet {
 namespace op {
@@ -125,6 +127,49 @@ inline bool HistogramOpType(const nnvm::NodeAttrs& attrs,
   return !type_is_none(out_attrs->at(0)) && !type_is_none(out_attrs->at(1));
 }
 
+/*!
+ * \brief Add the histogram of num elements to the num_bins bins on CPU. The elements
+ *  are split into a chunk per thread, each chunk is counted into bins of its own, and
+ *  the bins of the chunks are summed. op.Bin(i) is the bin of element i, or -1 to skip
+ *  it, and op.Weight(i) is its weight.
+ */
+template<typename CType, typename BinOp>
+void ParallelHistogramCPU(CType* bins, const index_t num, const int num_bins, const BinOp& op) {
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  // thread-local bins only pay off with enough elements per bin
+  const index_t num_chunks = std::min<index_t>(omp_threads, num / std::max(num_bins, 1));
+  if (num_chunks < 2) {
+    for (index_t i = 0; i < num; ++i) {
+      const int target = op.Bin(i);
+      if (target >= 0) {
+        bins[target] += op.Weight(i);
+      }
+    }
+    return;
+  }
+  const index_t chunk = (num + num_chunks - 1) / num_chunks;
+  std::vector<CType> local_bins(num_chunks * num_bins, CType(0));
+  #pragma omp parallel for num_threads(num_chunks)
+  for (index_t c = 0; c < num_chunks; ++c) {
+    CType* local = local_bins.data() + c * num_bins;
+    const index_t end = std::min(num, (c + 1) * chunk);
+    for (index_t i = c * chunk; i < end; ++i) {
+      const int target = op.Bin(i);
+      if (target >= 0) {
+        local[target] += op.Weight(i);
+      }
+    }
+  }
+  #pragma omp parallel for num_threads(omp_threads)
+  for (int b = 0; b < num_bins; ++b) {
+    CType sum = bins[b];
+    for (index_t c = 0; c < num_chunks; ++c) {
+      sum += local_bins[c * num_bins + b];
+    }
+    bins[b] = sum;
+  }
+}
+
 template<typename xpu>
 void HistogramForwardImpl(const OpContext& ctx,
                           const TBlob& in_data,
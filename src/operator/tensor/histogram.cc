@@ -57,14 +57,17 @@ struct ComputeBinKernel {
   }
 };
 
+/*! \brief bins of the elements given by bin_indices, each element weighing 1 */
 template<typename CType>
-void ComputeHistogram(const int* bin_indices, CType* out_data, size_t input_size) {
-  for (size_t i = 0; i < input_size; ++i) {
-    int target = bin_indices[i];
-    if (target >= 0) {
-      out_data[target] += 1;
-    }
-  }
+struct HistogramIndexBin {
+  const int* bin_indices;
+  int Bin(index_t i) const { return bin_indices[i]; }
+  CType Weight(index_t i) const { return CType(1); }
+};
+
+template<typename CType>
+void ComputeHistogram(const int* bin_indices, CType* out_data, size_t input_size, int bin_cnt) {
+  ParallelHistogramCPU(out_data, input_size, bin_cnt, HistogramIndexBin<CType>{bin_indices});
 }
 
 template<>
@@ -89,7 +92,7 @@ void HistogramForwardImpl<cpu>(const OpContext& ctx,
   });
   MSHADOW_TYPE_SWITCH(out_data.type_flag_, CType, {
     Kernel<set_zero, cpu>::Launch(s, bin_cnt, out_data.dptr<CType>());
-    ComputeHistogram(bin_indices.dptr_, out_data.dptr<CType>(), in_data.Size());
+    ComputeHistogram(bin_indices.dptr_, out_data.dptr<CType>(), in_data.Size(), bin_cnt);
   });
 }
 
@@ -116,7 +119,7 @@ void HistogramForwardImpl<cpu>(const OpContext& ctx,
   });
   MSHADOW_TYPE_SWITCH(out_data.type_flag_, CType, {
     Kernel<set_zero, cpu>::Launch(s, bin_cnt, out_data.dptr<CType>());
-    ComputeHistogram(bin_indices.dptr_, out_data.dptr<CType>(), in_data.Size());
+    ComputeHistogram(bin_indices.dptr_, out_data.dptr<CType>(), in_data.Size(), bin_cnt);
   });
 }
 
@@ -23,14 +23,20 @@
 */
 #include "./histogram-inl.h"
 #include "./util/tensor_util-inl.cuh"
+#include "./histogram-inl.cuh"
 
 namespace mxnet {
 namespace op {
 
-struct HistogramFusedKernel {
-  template<typename DType, typename CType>
-  static MSHADOW_XINLINE void Map(int i, const DType* in_data, const DType* bin_bounds, CType* bins,
-                                  const int bin_cnt, const double min, const double max) {
+/*! \brief bins of the elements of in_data for bin_cnt bins of equal width over [min, max] */
+template<typename DType, typename CType>
+struct HistogramUniformBin {
+  const DType* in_data;
+  const DType* bin_bounds;
+  int bin_cnt;
+  double min;
+  double max;
+  MSHADOW_XINLINE int Bin(index_t i) const {
     DType data = in_data[i];
     int target = -1;
     if (data >= min && data <= max) {
@@ -39,14 +45,20 @@ struct HistogramFusedKernel {
       target -= (data < bin_bounds[target]) ? 1 : 0;
       target += ((data >= bin_bounds[target + 1]) && (target != bin_cnt - 1)) ? 1 : 0;
     }
-    if (target >= 0) {
-      atomicAdd(&bins[target], CType(1));
-    }
+    return target;
   }
+  MSHADOW_XINLINE CType Weight(index_t i) const {
+    return CType(1);
+  }
+};
 
-  template<typename DType, typename CType>
-  static MSHADOW_XINLINE void Map(int i, const DType* in_data, const DType* bin_bounds, CType* bins,
-                                  const int bin_cnt) {
+/*! \brief bins of the elements of in_data for the bin_cnt bins between the bin_bounds */
+template<typename DType, typename CType>
+struct HistogramBoundsBin {
+  const DType* in_data;
+  const DType* bin_bounds;
+  int bin_cnt;
+  MSHADOW_XINLINE int Bin(index_t i) const {
     DType data = in_data[i];
     int target = -1;
     if (data >= bin_bounds[0] && data <= bin_bounds[bin_cnt]) {
@@ -56,6 +68,17 @@ struct HistogramFusedKernel {
       }
       target = min(target - 1, bin_cnt - 1);
     }
+    return target;
+  }
+  MSHADOW_XINLINE CType Weight(index_t i) const {
+    return CType(1);
+  }
+};
+
+struct HistogramFusedKernel {
+  template<typename CType, typename BinOp>
+  static MSHADOW_XINLINE void Map(int i, CType* bins, const BinOp op) {
+    const int target = op.Bin(i);
     if (target >= 0) {
       atomicAdd(&bins[target], CType(1));
     }
@@ -74,10 +97,14 @@ void HistogramForwardImpl<gpu>(const OpContext& ctx,
   MSHADOW_TYPE_SWITCH(in_data.type_flag_, DType, {
     MSHADOW_IDX_TYPE_SWITCH(out_data.type_flag_, CType, {
       int bin_cnt = out_bins.Size() - 1;
+      const HistogramBoundsBin<DType, CType> op{in_data.dptr<DType>(), bin_bounds.dptr<DType>(),
+                                                bin_cnt};
       Kernel<set_zero, gpu>::Launch(s, bin_cnt, out_data.dptr<CType>());
-      Kernel<HistogramFusedKernel, gpu>::Launch(
-        s, in_data.Size(), in_data.dptr<DType>(), bin_bounds.dptr<DType>(),
-        out_data.dptr<CType>(), bin_cnt);
+      if (!PrivatizedHistogram(s, ctx.run_ctx.ctx.dev_id, out_data.dptr<CType>(),
+                               in_data.Size(), bin_cnt, op)) {
+        Kernel<HistogramFusedKernel, gpu>::Launch(
+          s, in_data.Size(), out_data.dptr<CType>(), op);
+      }
       Kernel<op_with_req<mshadow_op::identity, kWriteTo>, gpu>::Launch(
         s, bin_bounds.Size(), out_bins.dptr<DType>(), bin_bounds.dptr<DType>());
     });
@@ -97,12 +124,16 @@ void HistogramForwardImpl<gpu>(const OpContext& ctx,
   mshadow::Stream<gpu> *s = ctx.get_stream<gpu>();
   MSHADOW_TYPE_SWITCH(in_data.type_flag_, DType, {
     MSHADOW_IDX_TYPE_SWITCH(out_data.type_flag_, CType, {
+      const HistogramUniformBin<DType, CType> op{in_data.dptr<DType>(), out_bins.dptr<DType>(),
+                                                 bin_cnt, min, max};
       Kernel<set_zero, gpu>::Launch(s, bin_cnt, out_data.dptr<CType>());
       Kernel<FillBinBoundsKernel, gpu>::Launch(
         s, bin_cnt+1, out_bins.dptr<DType>(), bin_cnt, min, max);
-      Kernel<HistogramFusedKernel, gpu>::Launch(
-        s, in_data.Size(), in_data.dptr<DType>(), out_bins.dptr<DType>(), out_data.dptr<CType>(),
-        bin_cnt, min, max);
+      if (!PrivatizedHistogram(s, ctx.run_ctx.ctx.dev_id, out_data.dptr<CType>(),
+                               in_data.Size(), bin_cnt, op)) {
+        Kernel<HistogramFusedKernel, gpu>::Launch(
+          s, in_data.Size(), out_data.dptr<CType>(), op);
+      }
     });
   });
 }
@@ -440,6 +440,219 @@ inline void SparseEmbeddingOpBackwardRspImpl<cpu>(const bool deterministic,
   });
 }
 
+/*! \brief number of columns of a bag pooled at once */
+constexpr nnvm::dim_t kEmbeddingBagBlock = 64;
+
+template<int req, typename AType>
+struct EmbeddingBagForwardCPU {
+  /*!
+   * \brief pools the rows of bag b, a block of columns at a time so that the sums stay in
+   *        registers and every row of the weight is read once
+   * \param b           the bag
+   * \param out         output
+   * \param weight      the embedding weight matrix
+   * \param data        indices of the rows of the bags
+   * \param offsets     start offsets of the bags, followed by the end offset of the last one
+   * \param data_size   number of indices
+   * \param row_length  number of elements per row
+   * \param num_rows    number of rows of the weight, indices are clipped to them
+   * \param mean        whether the rows are averaged instead of summed
+   */
+  template<typename DType, typename IType, typename OType>
+  MSHADOW_XINLINE static void Map(index_t b, DType* out, const DType* weight,
+                                  const IType* data, const OType* offsets,
+                                  const nnvm::dim_t data_size, const nnvm::dim_t row_length,
+                                  const nnvm::dim_t num_rows, const bool mean) {
+    using nnvm::dim_t;
+    dim_t begin, end;
+    EmbeddingBagRange(offsets, b, data_size, &begin, &end);
+    const AType scale = (mean && end > begin) ? AType(1) / AType(end - begin) : AType(1);
+    for (dim_t col = 0; col < row_length; col += kEmbeddingBagBlock) {
+      const dim_t len = std::min(kEmbeddingBagBlock, row_length - col);
+      AType acc[kEmbeddingBagBlock];
+      for (dim_t j = 0; j < len; ++j) acc[j] = 0;
+      for (dim_t k = begin; k < end; ++k) {
+        dim_t row = static_cast<dim_t>(data[k]);
+        row = row < 0 ? 0 : (row >= num_rows ? num_rows - 1 : row);
+        const DType* w = weight + row * row_length + col;
+        for (dim_t j = 0; j < len; ++j) acc[j] += static_cast<AType>(w[j]);
+      }
+      DType* o = out + b * row_length + col;
+      for (dim_t j = 0; j < len; ++j) {
+        KERNEL_ASSIGN(o[j], req, static_cast<DType>(acc[j] * scale));
+      }
+    }
+  }
+};
+
+struct EmbeddingBagGradCPU {
+  /*!
+   * \brief Each thread i is responsible for row slices in [segment_start, segment_end)
+            of the result gradient, and adds to them the head gradient of the bags of
+            their indices
+   * \param tid             global thread id
+   * \param grad            the gradient to calculate
+   * \param prefix_sum      the inclusive prefix sum of row ids of a row_sparse gradient,
+   *                        nullptr if the gradient is dense
+   * \param ograd           head gradient of the bags
+   * \param data            indices of the rows of the bags
+   * \param offsets         start offsets of the bags, followed by the end offset of the last one
+   * \param num_bags        number of bags
+   * \param data_size       number of indices
+   * \param num_rows        number of rows of the weight, indices are clipped to them
+   * \param row_length      the length of the row slices of the gradient
+   * \param segment_length  the length of row segment to process for each thread
+   * \param nnr             total number of rows of result gradient
+   * \param mean            whether the bags were averaged instead of summed
+   */
+  template<typename DType, typename IType, typename OType>
+  MSHADOW_XINLINE static void Map(int tid, DType* grad, const nnvm::dim_t* prefix_sum,
+                                  const DType* ograd, const IType* data, const OType* offsets,
+                                  const nnvm::dim_t num_bags, const nnvm::dim_t data_size,
+                                  const nnvm::dim_t num_rows, const nnvm::dim_t row_length,
+                                  const nnvm::dim_t segment_length, const nnvm::dim_t nnr,
+                                  const bool mean) {
+    using nnvm::dim_t;
+    const dim_t segment_start = tid * segment_length;
+    const dim_t segment_end = std::min(nnr, segment_start + segment_length);
+    for (dim_t b = 0; b < num_bags; ++b) {
+      dim_t begin, end;
+      EmbeddingBagRange(offsets, b, data_size, &begin, &end);
+      if (begin == end) continue;
+      const DType scale = mean ? DType(1) / DType(end - begin) : DType(1);
+      const DType* og = ograd + b * row_length;
+      for (dim_t k = begin; k < end; ++k) {
+        dim_t row = static_cast<dim_t>(data[k]);
+        row = row < 0 ? 0 : (row >= num_rows ? num_rows - 1 : row);
+        const dim_t grad_row_id = prefix_sum != nullptr ? prefix_sum[row] - 1 : row;
+        if (grad_row_id < segment_start || grad_row_id >= segment_end) continue;
+        DType* g = grad + grad_row_id * row_length;
+        for (dim_t j = 0; j < row_length; ++j) g[j] += scale * og[j];
+      }
+    }
+  }
+};
+
+template<>
+void EmbeddingBagOpForwardImpl<cpu>(mshadow::Stream<cpu>* s,
+                                    const TBlob& data,
+                                    const TBlob& offsets,
+                                    const TBlob& weight,
+                                    const bool mean,
+                                    const OpReqType req,
+                                    const TBlob& output) {
+  using namespace mxnet_op;
+  using nnvm::dim_t;
+  const dim_t num_bags = output.shape_[0];
+  const dim_t data_size = static_cast<dim_t>(data.shape_.Size());
+  MXNET_REAL_ACC_TYPE_SWITCH(output.type_flag_, DType, AType, {
+    MSHADOW_TYPE_SWITCH(data.type_flag_, IType, {
+      MSHADOW_IDX_TYPE_SWITCH(offsets.type_flag_, OType, {
+        MXNET_ASSIGN_REQ_SWITCH(req, req_t, {
+          Kernel<EmbeddingBagForwardCPU<req_t, AType>, cpu>::Launch(
+            s, num_bags, output.dptr<DType>(), weight.dptr<DType>(), data.dptr<IType>(),
+            offsets.dptr<OType>(), data_size, weight.shape_[1], weight.shape_[0], mean);
+        });
+      });
+    });
+  });
+}
+
+template<>
+void EmbeddingBagOpBackwardDnsImpl<cpu>(const OpContext& ctx,
+                                        const TBlob& ograd,
+                                        const TBlob& data,
+                                        const TBlob& offsets,
+                                        const bool mean,
+                                        const OpReqType req,
+                                        const TBlob& output) {
+  using namespace mxnet_op;
+  using nnvm::dim_t;
+  if (req == kNullOp) return;
+  CHECK(req == kWriteTo || req == kAddTo) << "wrong req";
+  mshadow::Stream<cpu> *s = ctx.get_stream<cpu>();
+  const dim_t num_rows = output.shape_[0];
+  const dim_t row_length = output.shape_[1];
+  MSHADOW_REAL_TYPE_SWITCH(output.type_flag_, DType, {
+    MSHADOW_TYPE_SWITCH(data.type_flag_, IType, {
+      MSHADOW_IDX_TYPE_SWITCH(offsets.type_flag_, OType, {
+        if (req == kWriteTo) {
+          Fill<false>(s, output, kWriteTo, 0);
+        }
+        const int num_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+        const dim_t segment_len = (num_rows + num_threads - 1) / num_threads;
+        Kernel<EmbeddingBagGradCPU, cpu>::Launch(s, num_threads, output.dptr<DType>(),
+            static_cast<const dim_t*>(nullptr), ograd.dptr<DType>(), data.dptr<IType>(),
+            offsets.dptr<OType>(), ograd.shape_[0], static_cast<dim_t>(data.shape_.Size()),
+            num_rows, row_length, segment_len, num_rows, mean);
+      });
+    });
+  });
+}
+
+template<>
+void EmbeddingBagOpBackwardRspImpl<cpu>(const OpContext& ctx,
+                                        const TBlob& ograd,
+                                        const TBlob& data,
+                                        const TBlob& offsets,
+                                        const bool mean,
+                                        const OpReqType req,
+                                        const NDArray& output) {
+  using namespace mshadow;
+  using namespace mxnet_op;
+  using namespace rowsparse;
+  using nnvm::dim_t;
+  if (req == kNullOp) return;
+  CHECK_EQ(req, kWriteTo) << "EmbeddingBag layer doesn't support "
+                          << "weight gradient calculation with req != write";
+
+  // Request temporary storage for marking non-zero rows and prefix sum
+  Stream<cpu> *s = ctx.get_stream<cpu>();
+  const dim_t num_rows = output.shape()[0];
+  const dim_t row_length = output.shape()[1];
+  const dim_t data_size = static_cast<dim_t>(data.shape_.Size());
+  Tensor<cpu, 1, char> workspace =
+    ctx.requested[embedding_bag::kTempSpace].get_space_typed<cpu, 1, char>(
+      Shape1(num_rows * sizeof(dim_t)), s);
+  dim_t* prefix_sum = reinterpret_cast<dim_t*>(workspace.dptr_);
+
+  MSHADOW_TYPE_SWITCH(data.type_flag_, IType, {
+    MSHADOW_REAL_TYPE_SWITCH(ograd.type_flag_, DType, {
+      MSHADOW_IDX_TYPE_SWITCH(output.aux_type(kIdx), RType, {
+        MSHADOW_IDX_TYPE_SWITCH(offsets.type_flag_, OType, {
+          const IType* data_ptr = data.dptr<IType>();
+          bool is_valid = CheckIndexOutOfBound(data_ptr, data.shape_.Size(), IType(0),
+                                               static_cast<IType>(num_rows - 1));
+          CHECK(is_valid) << "EmbeddingBag input contains data out of bound";
+          // mark the rows of the indices, and their positions in the gradient
+          Fill<false>(s, TBlob(prefix_sum, Shape1(num_rows), cpu::kDevMask), kWriteTo, 0);
+          Kernel<MarkRowFlgKernel, cpu>::Launch(s, data_size, prefix_sum, data_ptr);
+          for (dim_t i = 1; i < num_rows; i++) {
+            prefix_sum[i] += prefix_sum[i - 1];
+          }
+          const dim_t nnr = prefix_sum[num_rows - 1];
+          if (nnr == 0) {
+            FillZerosRspImpl(s, output);
+            return;
+          }
+          output.CheckAndAlloc({Shape1(nnr)});
+          Kernel<FillRspRowIdxKernel, cpu>::Launch(s, num_rows,
+              output.aux_data(kIdx).dptr<RType>(), prefix_sum, num_rows);
+          DType* grad_data = output.data().dptr<DType>();
+          Fill<false>(s, TBlob(grad_data, Shape1(nnr * row_length), cpu::kDevMask),
+                      kWriteTo, 0);
+          // add the head gradients of the bags to the rows of their indices
+          const int num_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+          const dim_t segment_len = (nnr + num_threads - 1) / num_threads;
+          Kernel<EmbeddingBagGradCPU, cpu>::Launch(s, num_threads, grad_data, prefix_sum,
+              ograd.dptr<DType>(), data_ptr, offsets.dptr<OType>(), ograd.shape_[0],
+              data_size, num_rows, row_length, segment_len, nnr, mean);
+        });
+      });
+    });
+  });
+}
+
 /*
  * \brief check if any of the indices is out of bound
  * \param s the stream
@@ -541,6 +754,7 @@ GatherNDBackwardImpl(index_t N, index_t M, index_t K,
 }
 
 DMLC_REGISTER_PARAMETER(EmbeddingParam);
+DMLC_REGISTER_PARAMETER(EmbeddingBagParam);
 DMLC_REGISTER_PARAMETER(TakeParam);
 DMLC_REGISTER_PARAMETER(OneHotParam);
 DMLC_REGISTER_PARAMETER(ScatterNDParam);
@@ -637,6 +851,94 @@ NNVM_REGISTER_OP(_backward_Embedding)
 .set_attr<FCompute>("FCompute<cpu>", EmbeddingOpBackward<cpu>)
 .set_attr<FComputeEx>("FComputeEx<cpu>", EmbeddingOpBackwardEx<cpu>);
 
+NNVM_REGISTER_OP(EmbeddingBag)
+.add_alias("_npx_embedding_bag")
+.describe(R"code(Maps bags of integer indices to the sum or the mean of their embeddings.
+
+The indices of all the bags are concatenated in the one-dimensional input ``data``, and
+``offsets`` holds the position in ``data`` of the first index of each bag, followed by the
+number of indices, like the ``indptr`` of a CSR matrix. For ``B + 1`` offsets, the shape of the
+output is (B, output_dim), its row ``b`` pooling the rows of the weight matrix indexed by
+``data[offsets[b]:offsets[b+1]]``. Empty bags give zeros.
+
+This computes the same result as ``Embedding`` followed by a ``sum`` or ``mean`` over the bags,
+without the intermediate array of one embedding per index, and the backward adds the head
+gradient of each bag directly to the rows of its indices.
+
+If the input_dim is ip0 and output_dim is op0, then shape of the embedding weight matrix must be
+(ip0, op0). The offsets must be of type int64 and non-decreasing.
+
+When "sparse_grad" is False, if any index mentioned is too large, it is replaced by the index that
+addresses the last vector in an embedding matrix.
+When "sparse_grad" is True, an error will be raised if invalid indices are found.
+
+Examples::
+
+  input_dim = 4
+  output_dim = 2
+
+  y = [[ 0.,  1.],
+       [ 2.,  3.],
+       [ 4.,  5.],
+       [ 6.,  7.]]
+
+  // bags (w1, w3), (), (w0, w2, w2)
+  x = [ 1.,  3.,  0.,  2.,  2.]
+  offsets = [0, 2, 2, 5]
+
+  EmbeddingBag(x, offsets, y, 4, 2) = [[  8.,  10.],
+                                       [  0.,   0.],
+                                       [  8.,  11.]]
+
+  EmbeddingBag(x, offsets, y, 4, 2, mode='mean') = [[ 4.,  5.],
+                                                   [ 0.,  0.],
+                                                   [ 2.66666667,  3.66666667]]
+
+The storage type of weight must be default.
+
+.. Note::
+
+    If "sparse_grad" is set to True, the storage type of gradient w.r.t weights will be
+    "row_sparse". Only a subset of optimizers support sparse gradients, including SGD, AdaGrad
+    and Adam.
+
+)code" ADD_FILELINE)
+.set_num_inputs(3)
+.set_num_outputs(1)
+.set_attr_parser(ParamParser<EmbeddingBagParam>)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    return std::vector<std::string>{"data", "offsets", "weight"};
+  })
+.set_attr<mxnet::FInferShape>("FInferShape", EmbeddingBagOpShape)
+.set_attr<nnvm::FInferType>("FInferType", EmbeddingBagOpType)
+.set_attr<THasDeterministicOutput>("THasDeterministicOutput", true)
+.set_attr<FCompute>("FCompute<cpu>", EmbeddingBagOpForward<cpu>)
+.set_attr<nnvm::FGradient>("FGradient",
+  [](const nnvm::ObjectPtr& n, const std::vector<nnvm::NodeEntry>& ograds) {
+    return MakeNonlossGradNode("_backward_EmbeddingBag", n, ograds,
+                               {n->inputs[embedding_bag::kData],
+                                n->inputs[embedding_bag::kOffsets]}, n->attrs.dict);
+  })
+.add_argument("data", "NDArray-or-Symbol", "The indices of the bags, concatenated.")
+.add_argument("offsets", "NDArray-or-Symbol", "The offsets of the bags in data, followed by "
+              "the number of indices.")
+.add_argument("weight", "NDArray-or-Symbol", "The embedding weight matrix.")
+.add_arguments(EmbeddingBagParam::__FIELDS__());
+
+NNVM_REGISTER_OP(_backward_EmbeddingBag)
+.set_num_inputs(3)
+.set_num_outputs(3)
+.set_attr_parser(ParamParser<EmbeddingBagParam>)
+.set_attr<FResourceRequest>("FResourceRequest",
+  [](const NodeAttrs& attrs) {
+    return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
+  })
+.set_attr<FInferStorageType>("FInferStorageType", EmbeddingBagOpBackwardStorageType)
+.set_attr<nnvm::TIsBackward>("TIsBackward", true)
+.set_attr<FCompute>("FCompute<cpu>", EmbeddingBagOpBackward<cpu>)
+.set_attr<FComputeEx>("FComputeEx<cpu>", EmbeddingBagOpBackwardEx<cpu>);
+
 NNVM_REGISTER_OP(take)
 .add_alias("_npi_take")
 .describe(R"code(Takes elements from an input array along the given axis.
@@ -64,7 +64,8 @@ struct AddTakeGradRspGPUKernel {
  * \brief kernel for backward computation for take, executed with deterministic order
  * \param thread_id the thread id
  * \param out the output gradient data
- * \param lookup_table the table to lookup the position of an id in gradient array
+ * \param lookup_table the table to lookup the position of an id in gradient array, nullptr if
+ *        the sorted data are the positions already
  * \param sorted_data the sorted data input
  * \param original_idx the original indices of the sorted data input
  * \param ograd head gradient
@@ -98,7 +99,7 @@ struct AddTakeGradRspDeterministicKernel {
         acc[i] = 0;
       }
       const dim_t data = sorted_data[tid];
-      const dim_t row_id = lookup_table[data];
+      const dim_t row_id = lookup_table != nullptr ? lookup_table[data] : data;
       const dim_t out_offset = row_id * row_length + feature_start;
       do {
         const dim_t idx = original_idx[tid];
@@ -115,6 +116,88 @@ struct AddTakeGradRspDeterministicKernel {
   }
 };
 
+/*! \brief empty slot of the hash table of the embedding gradient rows */
+constexpr unsigned long long kEmbeddingHashEmpty = ~0ULL;
+
+/*! \brief first slot probed for a row id, in a table of 2^log2_slots slots */
+__device__ __forceinline__ nnvm::dim_t EmbeddingHashSlot(const unsigned long long key,
+                                                         const int log2_slots) {
+  return static_cast<nnvm::dim_t>((key * 0x9E3779B97F4A7C15ULL) >> (64 - log2_slots));
+}
+
+/*! \brief whether a slot of the hash table holds a row id */
+struct EmbeddingHashOccupied {
+  __device__ __forceinline__ bool operator()(const unsigned long long &key) const {
+    return key != kEmbeddingHashEmpty;
+  }
+};
+
+/*
+ * \brief kernel inserting the row ids of the data in the hash table, by linear probing
+ * \param i the index of the data
+ * \param keys the slots of the hash table
+ * \param slot_of the slot of the row id of each data
+ */
+struct EmbeddingHashInsertKernel {
+  template<typename IType>
+  __device__ __forceinline__ static void Map(int i, unsigned long long *keys,
+                                             nnvm::dim_t *slot_of, const IType *data,
+                                             const int log2_slots) {
+    const unsigned long long key = static_cast<unsigned long long>(data[i]);
+    const nnvm::dim_t mask = (nnvm::dim_t(1) << log2_slots) - 1;
+    nnvm::dim_t slot = EmbeddingHashSlot(key, log2_slots);
+    while (true) {
+      const unsigned long long prev = atomicCAS(keys + slot, kEmbeddingHashEmpty, key);
+      if (prev == kEmbeddingHashEmpty || prev == key) break;
+      slot = (slot + 1) & mask;
+    }
+    slot_of[i] = slot;
+  }
+};
+
+/*
+ * \brief kernel writing the sorted row ids of the gradient, and their position in the slots
+ * \param p the position of a row id in the gradient
+ * \param slot_pos the position in the gradient of the row id of each slot
+ */
+struct EmbeddingHashRankKernel {
+  template<typename RType>
+  __device__ __forceinline__ static void Map(int p, nnvm::dim_t *slot_pos, RType *row_idx,
+                                             const unsigned long long *keys,
+                                             const unsigned long long *sorted_keys,
+                                             const int log2_slots) {
+    const unsigned long long key = sorted_keys[p];
+    const nnvm::dim_t mask = (nnvm::dim_t(1) << log2_slots) - 1;
+    nnvm::dim_t slot = EmbeddingHashSlot(key, log2_slots);
+    while (keys[slot] != key) slot = (slot + 1) & mask;
+    slot_pos[slot] = p;
+    row_idx[p] = static_cast<RType>(key);
+  }
+};
+
+/*! \brief kernel writing the gradient row of each data, and the data index, to be sorted */
+struct EmbeddingHashRowKernel {
+  MSHADOW_XINLINE static void Map(int i, nnvm::dim_t *rows, nnvm::dim_t *original_idx,
+                                  const nnvm::dim_t *slot_pos, const nnvm::dim_t *slot_of) {
+    rows[i] = slot_pos[slot_of[i]];
+    original_idx[i] = i;
+  }
+};
+
+/*! \brief kernel adding the head gradient of each data to its row, in any order */
+struct EmbeddingHashAddGradKernel {
+  template<typename DType>
+  __device__ __forceinline__ static void Map(int tid, DType *out, const nnvm::dim_t *slot_pos,
+                                             const nnvm::dim_t *slot_of, const DType *ograd,
+                                             const nnvm::dim_t row_length) {
+    using nnvm::dim_t;
+    const dim_t data_i = tid / row_length;
+    const dim_t grad_i = tid % row_length;
+    const dim_t rsp_row = slot_pos[slot_of[data_i]];
+    atomicAdd(&out[rsp_row * row_length + grad_i], ograd[data_i * row_length + grad_i]);
+  }
+};
+
 template<bool clip = true>
 struct TakeZeroAxisGPU {
   // assume that idx have been flattened to a 1-D tensor (N,)
@@ -123,9 +206,10 @@ struct TakeZeroAxisGPU {
   // K is the number of rows of in_data
   // i is the index of out_data
   template<typename DType, typename IType>
-  MSHADOW_XINLINE static void Map(int i, DType* out_data, const DType* in_data,
+  MSHADOW_XINLINE static void Map(index_t i, DType* out_data, const DType* in_data,
                                   const IType* idx, const int64_t M, const int64_t K) {
-    int64_t j = static_cast<int64_t>(idx[i/M]);
+    const index_t row = mxnet_op::index_div(i, M);
+    int64_t j = static_cast<int64_t>(idx[row]);
     if (clip) {
       if (j <= 0) j = 0;
       else if (j >= K) j = K - 1;
@@ -133,7 +217,7 @@ struct TakeZeroAxisGPU {
       j = j % K;
       j += (j < 0) ? K : 0;
     }
-    out_data[i] = in_data[j * M + i % M];
+    out_data[i] = in_data[j * M + i - row * M];
   }
 };
 
@@ -356,6 +440,129 @@ inline void SparseEmbeddingOpBackwardDeterministicRspImpl(const OpContext& ctx,
 }
 
 
+/*
+ * \brief row_sparse gradient of an embedding, with the rows aggregated by a hash table of the
+ *  row ids of the data instead of a sort of the data or a table of all the rows, so that the
+ *  time and memory depend on the data only. In deterministic mode, the data are then sorted by
+ *  the positions of their rows in the gradient, ids of few bits, and added in order. Otherwise
+ *  they are added with atomics.
+ */
+template<typename IType, typename DType, typename RType>
+void SparseEmbeddingHashKernelLaunch(const OpContext& ctx,
+                                     const TBlob& ograd,
+                                     const TBlob& data,
+                                     const bool deterministic,
+                                     const NDArray& output) {
+  using namespace mshadow;
+  using namespace mxnet_op;
+  using namespace rowsparse;
+  using nnvm::dim_t;
+  Stream<gpu> *s = ctx.get_stream<gpu>();
+  cudaStream_t stream = Stream<gpu>::GetStream(s);
+  const dim_t num_rows = output.shape()[0];
+  const dim_t row_length = output.shape()[1];
+  const dim_t data_size = static_cast<dim_t>(data.shape_.Size());
+  // at least twice as many slots as data, so that the probes are short
+  const int log2_slots = common::ilog2ul(2 * data_size - 1);
+  const dim_t num_slots = dim_t(1) << log2_slots;
+  const int row_bits = common::ilog2ul(num_rows - 1);
+  // temp space of the cub calls
+  size_t select_bytes = 0, sort_keys_bytes = 0;
+  cub::DeviceSelect::If(nullptr, select_bytes, static_cast<unsigned long long*>(nullptr),
+                        static_cast<unsigned long long*>(nullptr), static_cast<dim_t*>(nullptr),
+                        static_cast<int>(num_slots), EmbeddingHashOccupied(), stream);
+  cub::DeviceRadixSort::SortKeys(nullptr, sort_keys_bytes,
+                                 static_cast<unsigned long long*>(nullptr),
+                                 static_cast<unsigned long long*>(nullptr),
+                                 static_cast<int>(data_size), 0, row_bits, stream);
+  const size_t sort_pairs_bytes = deterministic ?
+      SortByKeyWorkspaceSize<dim_t, dim_t, gpu>(data_size) : 0;
+  const size_t temp_bytes = std::max({select_bytes, sort_keys_bytes, sort_pairs_bytes,
+                                      sizeof(char)});
+  // layout: keys, slot_pos, slot_of, unique, sorted unique, unique count,
+  // rows and original_idx when deterministic, temp storage
+  const size_t slots_bytes = num_slots * sizeof(dim_t);
+  const size_t data_bytes = data_size * sizeof(dim_t);
+  const size_t total_bytes = 2 * slots_bytes + 3 * data_bytes + sizeof(dim_t) +
+                             (deterministic ? 2 * data_bytes : 0) + temp_bytes;
+  Tensor<gpu, 1, char> workspace = ctx.requested[0]
+      .get_space_typed<gpu, 1, char>(Shape1(total_bytes), s);
+  char *ptr = workspace.dptr_;
+  auto *keys = reinterpret_cast<unsigned long long*>(ptr);
+  ptr += slots_bytes;
+  dim_t *slot_pos = reinterpret_cast<dim_t*>(ptr);
+  ptr += slots_bytes;
+  dim_t *slot_of = reinterpret_cast<dim_t*>(ptr);
+  ptr += data_bytes;
+  auto *unique = reinterpret_cast<unsigned long long*>(ptr);
+  ptr += data_bytes;
+  auto *sorted_unique = reinterpret_cast<unsigned long long*>(ptr);
+  ptr += data_bytes;
+  dim_t *num_unique = reinterpret_cast<dim_t*>(ptr);
+  ptr += sizeof(dim_t);
+  dim_t *rows = nullptr, *original_idx = nullptr;
+  if (deterministic) {
+    rows = reinterpret_cast<dim_t*>(ptr);
+    ptr += data_bytes;
+    original_idx = reinterpret_cast<dim_t*>(ptr);
+    ptr += data_bytes;
+  }
+  char *temp_storage = ptr;
+
+  // check out-of-bound indices
+  {
+    IType min = 0;
+    IType max = static_cast<IType>(num_rows - 1);
+    bool is_valid = CheckIndexOutOfBound(s, data.dptr<IType>(), data_size, min, max,
+                                         temp_storage);
+    CHECK(is_valid) << "Embedding input contains data out of bound";
+  }
+
+  // aggregate the row ids in the hash table, and collect the distinct ones
+  CUDA_CALL(cudaMemsetAsync(keys, 0xFF, slots_bytes, stream));
+  Kernel<EmbeddingHashInsertKernel, gpu>::Launch(s, data_size, keys, slot_of,
+                                                  data.dptr<IType>(), log2_slots);
+  size_t bytes = temp_bytes;
+  cub::DeviceSelect::If(temp_storage, bytes, keys, unique, num_unique,
+                        static_cast<int>(num_slots), EmbeddingHashOccupied(), stream);
+  dim_t nnr = 0;
+  CUDA_CALL(cudaMemcpyAsync(&nnr, num_unique, sizeof(dim_t), cudaMemcpyDeviceToHost, stream));
+  CUDA_CALL(cudaStreamSynchronize(stream));
+
+  // sorted row ids of the gradient
+  CHECK_EQ(output.shape().ndim(), 2) << "Unexcepted ndim";
+  output.CheckAndAlloc({Shape1(nnr)});
+  RType* grad_row_idx = output.aux_data(kIdx).dptr<RType>();
+  bytes = temp_bytes;
+  cub::DeviceRadixSort::SortKeys(temp_storage, bytes, unique, sorted_unique,
+                                 static_cast<int>(nnr), 0, row_bits, stream);
+  Kernel<EmbeddingHashRankKernel, gpu>::Launch(s, nnr, slot_pos, grad_row_idx, keys,
+                                                sorted_unique, log2_slots);
+
+  // accumulate gradients
+  DType* grad_data = output.data().dptr<DType>();
+  Fill<false>(s, TBlob(grad_data, Shape1(nnr * row_length), gpu::kDevMask), kWriteTo, 0);
+  if (deterministic) {
+    Kernel<EmbeddingHashRowKernel, gpu>::Launch(s, data_size, rows, original_idx,
+                                                 slot_pos, slot_of);
+    // the radix sort is stable, the data of a row stay in order
+    Tensor<gpu, 1, dim_t> rows_tensor(rows, Shape1(data_size), s);
+    Tensor<gpu, 1, dim_t> original_idx_tensor(original_idx, Shape1(data_size), s);
+    Tensor<gpu, 1, char> temp_storage_tensor(temp_storage, Shape1(sort_pairs_bytes), s);
+    SortByKey(rows_tensor, original_idx_tensor, true, &temp_storage_tensor, 0,
+              common::ilog2ul(nnr - 1));
+    const int SZ = 4;
+    const nnvm::dim_t num_threads_per_row = (row_length + SZ - 1) / SZ;
+    Kernel<AddTakeGradRspDeterministicKernel<SZ>, gpu>::Launch(s, data_size * num_threads_per_row,
+                       grad_data, static_cast<const dim_t*>(nullptr), rows, data_size, original_idx,
+                       ograd.dptr<DType>(), row_length, num_threads_per_row);
+  } else {
+    Kernel<EmbeddingHashAddGradKernel, gpu>::Launch(s, data_size * row_length, grad_data,
+                                                     slot_pos, slot_of, ograd.dptr<DType>(),
+                                                     row_length);
+  }
+}
+
 template<>
 inline void SparseEmbeddingOpBackwardRspImpl<gpu>(const bool deterministic,
                                                   const OpContext& ctx,
@@ -363,6 +570,19 @@ inline void SparseEmbeddingOpBackwardRspImpl<gpu>(const bool deterministic,
                                                   const TBlob& data,
                                                   const OpReqType req,
                                                   const NDArray& output) {
+  // the other paths have a table of all the rows of the embedding, the hash one of the data
+  if (req == kWriteTo && data.shape_.Size() != 0 &&
+      static_cast<size_t>(output.shape()[0]) > data.shape_.Size()) {
+    MSHADOW_TYPE_SWITCH(data.type_flag_, IType, {
+      MSHADOW_TYPE_SWITCH(ograd.type_flag_, DType, {
+        MSHADOW_IDX_TYPE_SWITCH(output.aux_type(rowsparse::kIdx), RType, {
+          SparseEmbeddingHashKernelLaunch<IType, DType, RType>(ctx, ograd, data,
+                                                               deterministic, output);
+        });
+      });
+    });
+    return;
+  }
   if (deterministic) {
     SparseEmbeddingOpBackwardDeterministicRspImpl(ctx, ograd, data, req, output);
     return;
@@ -436,6 +656,220 @@ inline void SparseEmbeddingOpBackwardRspImpl<gpu>(const bool deterministic,
   });
 }
 
+template<int req, typename AType>
+struct EmbeddingBagForwardGPU {
+  /*!
+   * \brief pools a column of a bag, one thread per element of the output
+   * \param i           the element of the output
+   * \param out         output
+   * \param weight      the embedding weight matrix
+   * \param data        indices of the rows of the bags
+   * \param offsets     start offsets of the bags, followed by the end offset of the last one
+   * \param data_size   number of indices
+   * \param row_length  number of elements per row
+   * \param num_rows    number of rows of the weight, indices are clipped to them
+   * \param mean        whether the rows are averaged instead of summed
+   */
+  template<typename DType, typename IType, typename OType>
+  MSHADOW_XINLINE static void Map(index_t i, DType* out, const DType* weight,
+                                  const IType* data, const OType* offsets,
+                                  const nnvm::dim_t data_size, const nnvm::dim_t row_length,
+                                  const nnvm::dim_t num_rows, const bool mean) {
+    using nnvm::dim_t;
+    const dim_t b = i / row_length;
+    const dim_t col = i % row_length;
+    dim_t begin, end;
+    EmbeddingBagRange(offsets, b, data_size, &begin, &end);
+    AType sum = 0;
+    for (dim_t k = begin; k < end; ++k) {
+      dim_t row = static_cast<dim_t>(data[k]);
+      row = row < 0 ? 0 : (row >= num_rows ? num_rows - 1 : row);
+      sum += static_cast<AType>(weight[row * row_length + col]);
+    }
+    if (mean && end > begin) sum /= static_cast<AType>(end - begin);
+    KERNEL_ASSIGN(out[i], req, static_cast<DType>(sum));
+  }
+};
+
+struct EmbeddingBagGradGPU {
+  /*!
+   * \brief adds the head gradient of the bag of an index to the row of the index, one thread
+   *        per element of the row
+   * \param tid         global thread id
+   * \param grad        the gradient to calculate
+   * \param prefix_sum  the inclusive prefix sum of row ids of a row_sparse gradient,
+   *                    nullptr if the gradient is dense
+   * \param ograd       head gradient of the bags
+   * \param data        indices of the rows of the bags
+   * \param offsets     start offsets of the bags, followed by the end offset of the last one
+   * \param num_bags    number of bags
+   * \param data_size   number of indices
+   * \param num_rows    number of rows of the weight, indices are clipped to them
+   * \param row_length  the length of the rows of the gradient
+   * \param mean        whether the bags were averaged instead of summed
+   */
+  template<typename DType, typename IType, typename OType>
+  __device__ __forceinline__ static void Map(index_t tid, DType* grad,
+                                             const nnvm::dim_t* prefix_sum,
+                                             const DType* ograd, const IType* data,
+                                             const OType* offsets,
+                                             const nnvm::dim_t num_bags,
+                                             const nnvm::dim_t data_size,
+                                             const nnvm::dim_t num_rows,
+                                             const nnvm::dim_t row_length,
+                                             const bool mean) {
+    using nnvm::dim_t;
+    const dim_t k = tid / row_length;
+    const dim_t col = tid % row_length;
+    // the bag of index k is the last one starting at or before it
+    dim_t lo = 0, hi = num_bags - 1;
+    while (lo < hi) {
+      const dim_t mid = (lo + hi + 1) / 2;
+      if (static_cast<dim_t>(offsets[mid]) <= k) {
+        lo = mid;
+      } else {
+        hi = mid - 1;
+      }
+    }
+    dim_t begin, end;
+    EmbeddingBagRange(offsets, lo, data_size, &begin, &end);
+    if (k < begin || k >= end) return;
+    dim_t row = static_cast<dim_t>(data[k]);
+    row = row < 0 ? 0 : (row >= num_rows ? num_rows - 1 : row);
+    const dim_t grad_row_id = prefix_sum != nullptr ? prefix_sum[row] - 1 : row;
+    DType val = ograd[lo * row_length + col];
+    if (mean) val = val / static_cast<DType>(end - begin);
+    atomicAdd(&grad[grad_row_id * row_length + col], val);
+  }
+};
+
+template<>
+void EmbeddingBagOpForwardImpl<gpu>(mshadow::Stream<gpu>* s,
+                                    const TBlob& data,
+                                    const TBlob& offsets,
+                                    const TBlob& weight,
+                                    const bool mean,
+                                    const OpReqType req,
+                                    const TBlob& output) {
+  using namespace mxnet_op;
+  using nnvm::dim_t;
+  const dim_t data_size = static_cast<dim_t>(data.shape_.Size());
+  MXNET_REAL_ACC_TYPE_SWITCH(output.type_flag_, DType, AType, {
+    MSHADOW_TYPE_SWITCH(data.type_flag_, IType, {
+      MSHADOW_IDX_TYPE_SWITCH(offsets.type_flag_, OType, {
+        MXNET_ASSIGN_REQ_SWITCH(req, req_t, {
+          Kernel<EmbeddingBagForwardGPU<req_t, AType>, gpu>::Launch(
+            s, output.shape_.Size(), output.dptr<DType>(), weight.dptr<DType>(),
+            data.dptr<IType>(), offsets.dptr<OType>(), data_size, weight.shape_[1],
+            weight.shape_[0], mean);
+        });
+      });
+    });
+  });
+}
+
+template<>
+void EmbeddingBagOpBackwardDnsImpl<gpu>(const OpContext& ctx,
+                                        const TBlob& ograd,
+                                        const TBlob& data,
+                                        const TBlob& offsets,
+                                        const bool mean,
+                                        const OpReqType req,
+                                        const TBlob& output) {
+  using namespace mxnet_op;
+  using nnvm::dim_t;
+  if (req == kNullOp) return;
+  CHECK(req == kWriteTo || req == kAddTo) << "wrong req";
+  mshadow::Stream<gpu> *s = ctx.get_stream<gpu>();
+  const dim_t num_bags = ograd.shape_[0];
+  const dim_t data_size = static_cast<dim_t>(data.shape_.Size());
+  const dim_t row_length = output.shape_[1];
+  MSHADOW_REAL_TYPE_SWITCH(output.type_flag_, DType, {
+    MSHADOW_TYPE_SWITCH(data.type_flag_, IType, {
+      MSHADOW_IDX_TYPE_SWITCH(offsets.type_flag_, OType, {
+        if (req == kWriteTo) {
+          Fill<false>(s, output, kWriteTo, 0);
+        }
+        if (num_bags == 0) return;
+        Kernel<EmbeddingBagGradGPU, gpu>::Launch(s, data_size * row_length,
+            output.dptr<DType>(), static_cast<const dim_t*>(nullptr), ograd.dptr<DType>(),
+            data.dptr<IType>(), offsets.dptr<OType>(), num_bags, data_size,
+            output.shape_[0], row_length, mean);
+      });
+    });
+  });
+}
+
+template<>
+void EmbeddingBagOpBackwardRspImpl<gpu>(const OpContext& ctx,
+                                        const TBlob& ograd,
+                                        const TBlob& data,
+                                        const TBlob& offsets,
+                                        const bool mean,
+                                        const OpReqType req,
+                                        const NDArray& output) {
+  using namespace mshadow;
+  using namespace mxnet_op;
+  using namespace rowsparse;
+  using nnvm::dim_t;
+  if (req == kNullOp) return;
+  CHECK_EQ(req, kWriteTo) << "EmbeddingBag layer doesn't support "
+                          << "weight gradient calculation with req != write";
+  Stream<gpu> *s = ctx.get_stream<gpu>();
+  cudaStream_t stream = Stream<gpu>::GetStream(s);
+  const dim_t num_bags = ograd.shape_[0];
+  const dim_t num_rows = output.shape()[0];
+  const dim_t row_length = output.shape()[1];
+  const dim_t data_size = static_cast<dim_t>(data.shape_.Size());
+  if (num_bags == 0 || data_size == 0) {
+    FillZerosRspImpl(s, output);
+    return;
+  }
+
+  MSHADOW_TYPE_SWITCH(data.type_flag_, IType, {
+    MSHADOW_REAL_TYPE_SWITCH(ograd.type_flag_, DType, {
+      MSHADOW_IDX_TYPE_SWITCH(output.aux_type(kIdx), RType, {
+        MSHADOW_IDX_TYPE_SWITCH(offsets.type_flag_, OType, {
+          // Request temporary storage for marking non-zero rows and prefix sum
+          dim_t* prefix_sum = nullptr;
+          size_t temp_storage_bytes = 0;
+          cub::DeviceScan::InclusiveSum(nullptr, temp_storage_bytes, prefix_sum, prefix_sum,
+                                        num_rows, stream);
+          temp_storage_bytes = std::max(temp_storage_bytes, sizeof(char));
+          Tensor<gpu, 1, char> workspace = ctx.requested[embedding_bag::kTempSpace]
+              .get_space_typed<gpu, 1, char>(Shape1(num_rows * sizeof(dim_t) +
+                                                    temp_storage_bytes), s);
+          prefix_sum = reinterpret_cast<dim_t*>(workspace.dptr_);
+          char* temp_storage = workspace.dptr_ + num_rows * sizeof(dim_t);
+          const IType* data_ptr = data.dptr<IType>();
+          bool is_valid = CheckIndexOutOfBound(s, data_ptr, data_size, IType(0),
+                                               static_cast<IType>(num_rows - 1), temp_storage);
+          CHECK(is_valid) << "EmbeddingBag input contains data out of bound";
+          // mark the rows of the indices, and their positions in the gradient
+          Fill<false>(s, TBlob(prefix_sum, Shape1(num_rows), gpu::kDevMask), kWriteTo, 0);
+          Kernel<MarkRowFlgKernel, gpu>::Launch(s, data_size, prefix_sum, data_ptr);
+          cub::DeviceScan::InclusiveSum(temp_storage, temp_storage_bytes, prefix_sum,
+                                        prefix_sum, num_rows, stream);
+          dim_t nnr = 0;
+          CUDA_CALL(cudaMemcpyAsync(&nnr, &prefix_sum[num_rows - 1], sizeof(dim_t),
+                                    cudaMemcpyDeviceToHost, stream));
+          CUDA_CALL(cudaStreamSynchronize(stream));
+          output.CheckAndAlloc({Shape1(nnr)});
+          Kernel<FillRspRowIdxKernel, gpu>::Launch(s, num_rows,
+              output.aux_data(kIdx).dptr<RType>(), prefix_sum, num_rows);
+          DType* grad_data = output.data().dptr<DType>();
+          Fill<false>(s, TBlob(grad_data, Shape1(nnr * row_length), gpu::kDevMask),
+                      kWriteTo, 0);
+          // add the head gradients of the bags to the rows of their indices
+          Kernel<EmbeddingBagGradGPU, gpu>::Launch(s, data_size * row_length, grad_data,
+              prefix_sum, ograd.dptr<DType>(), data_ptr, offsets.dptr<OType>(), num_bags,
+              data_size, num_rows, row_length, mean);
+        });
+      });
+    });
+  });
+}
+
 /*
  * \brief check if any of the indices is out of bound
  * \param s the stream
@@ -877,6 +1311,13 @@ NNVM_REGISTER_OP(_backward_Embedding)
 .set_attr<FCompute>("FCompute<gpu>", EmbeddingOpBackward<gpu>)
 .set_attr<FComputeEx>("FComputeEx<gpu>", EmbeddingOpBackwardEx<gpu>);
 
+NNVM_REGISTER_OP(EmbeddingBag)
+.set_attr<FCompute>("FCompute<gpu>", EmbeddingBagOpForward<gpu>);
+
+NNVM_REGISTER_OP(_backward_EmbeddingBag)
+.set_attr<FCompute>("FCompute<gpu>", EmbeddingBagOpBackward<gpu>)
+.set_attr<FComputeEx>("FComputeEx<gpu>", EmbeddingBagOpBackwardEx<gpu>);
+
 NNVM_REGISTER_OP(take)
 .set_attr<FCompute>("FCompute<gpu>", TakeOpForward<gpu>);
 
@@ -227,11 +227,11 @@ struct TakeNonzeroAxis {
                                   const int in_ndims, const int out_ndims, const int idx_ndims,
                                   const int axis_dim, const int axis) {
     // i is the global flattened index in the output
-    const int64_t out_head_index = i / out_prev_stride;
-    const int64_t out_rest_index = i % out_prev_stride;
-    const int64_t out_mid_index = out_rest_index / in_stride;
+    const int64_t out_head_index = mxnet_op::index_div(i, out_prev_stride);
+    const int64_t out_rest_index = i - out_head_index * out_prev_stride;
+    const int64_t out_mid_index = mxnet_op::index_div(out_rest_index, in_stride);
     const int64_t out_tail_index = (axis == in_ndims - 1) ?
-                                   0 : (out_rest_index % in_stride);
+                                   0 : (out_rest_index - out_mid_index * in_stride);
     int64_t idx_index = static_cast<int64_t>(idx[out_mid_index]);
     if (clip) {
       idx_index = (idx_index < 0) ? 0 : idx_index;
@@ -507,13 +507,228 @@ void EmbeddingOpBackwardEx(const nnvm::NodeAttrs& attrs,
           << "Embedding layer doesn't support calculate data gradient";
   if (data.storage_type() == kDefaultStorage && ograd.storage_type() == kDefaultStorage &&
       weight_grad.storage_type() == kRowSparseStorage) {
-    SparseEmbeddingOpBackwardRspImpl<xpu>(true, ctx, ograd.data(), data.data(),
+    const bool deterministic = dmlc::GetEnv("MXNET_EMBEDDING_DETERMINISTIC_SPARSE_GRAD", true);
+    SparseEmbeddingOpBackwardRspImpl<xpu>(deterministic, ctx, ograd.data(), data.data(),
                                           req[embedding::kWeight], weight_grad);
   } else {
     LogUnimplementedOp(attrs, ctx, inputs, req, outputs);
   }
 }
 
+namespace embedding_bag {
+enum EmbeddingBagOpInputs {kData, kOffsets, kWeight};
+enum EmbeddingBagOpOutputs {kOut};
+enum EmbeddingBagOpResource {kTempSpace};
+enum EmbeddingBagOpMode {kSum, kMean};
+}  // namespace embedding_bag
+
+struct EmbeddingBagParam: public dmlc::Parameter<EmbeddingBagParam> {
+  index_t input_dim;
+  index_t output_dim;
+  int dtype;
+  int mode;
+  bool sparse_grad;
+  DMLC_DECLARE_PARAMETER(EmbeddingBagParam) {
+    DMLC_DECLARE_FIELD(input_dim).set_lower_bound(1)
+    .describe("Vocabulary size of the input indices.");
+    DMLC_DECLARE_FIELD(output_dim).set_lower_bound(1)
+    .describe("Dimension of the embedding vectors.");
+    DMLC_DECLARE_FIELD(dtype).set_default(mshadow::kFloat32)
+    MXNET_ADD_ALL_TYPES
+    .describe("Data type of weight.");
+    DMLC_DECLARE_FIELD(mode)
+    .add_enum("sum", embedding_bag::kSum)
+    .add_enum("mean", embedding_bag::kMean)
+    .set_default(embedding_bag::kSum)
+    .describe("How the embeddings of a bag are pooled.");
+    DMLC_DECLARE_FIELD(sparse_grad).set_default(false)
+    .describe("Compute row sparse gradient in the backward calculation. If set to True, "
+              "the grad's storage type is row_sparse.");
+  }
+};
+
+inline bool EmbeddingBagOpShape(const nnvm::NodeAttrs& attrs,
+                                mxnet::ShapeVector *in_attrs,
+                                mxnet::ShapeVector *out_attrs) {
+  using namespace mshadow;
+  CHECK_EQ(in_attrs->size(), 3U);
+  CHECK_EQ(out_attrs->size(), 1U);
+  const EmbeddingBagParam& param = nnvm::get<EmbeddingBagParam>(attrs.parsed);
+  SHAPE_ASSIGN_CHECK(*in_attrs, embedding_bag::kWeight, Shape2(param.input_dim,
+                                                               param.output_dim));
+  const mxnet::TShape &dshape = (*in_attrs)[embedding_bag::kData];
+  const mxnet::TShape &oshape = (*in_attrs)[embedding_bag::kOffsets];
+  if (ndim_is_known(dshape)) {
+    CHECK_EQ(dshape.ndim(), 1) << "EmbeddingBag expects one-dimensional indices";
+  }
+  if (!ndim_is_known(oshape)) return false;
+  CHECK_EQ(oshape.ndim(), 1) << "EmbeddingBag expects one-dimensional offsets";
+  if (!dim_size_is_known(oshape, 0)) return false;
+  CHECK_GE(oshape[0], 1) << "EmbeddingBag expects the offsets of the bags and of the end";
+  SHAPE_ASSIGN_CHECK(*out_attrs, 0, Shape2(oshape[0] - 1, param.output_dim));
+  return shape_is_known(dshape);
+}
+
+inline bool EmbeddingBagOpType(const nnvm::NodeAttrs& attrs,
+                               std::vector<int> *in_type,
+                               std::vector<int> *out_type) {
+  const EmbeddingBagParam& param = nnvm::get<EmbeddingBagParam>(attrs.parsed);
+  CHECK_EQ(in_type->size(), 3U);
+  CHECK_EQ(out_type->size(), 1U);
+  CHECK_NE((*in_type)[embedding_bag::kData], -1) << "First input must have specified type";
+  TYPE_ASSIGN_CHECK(*in_type, embedding_bag::kOffsets, mshadow::kInt64);
+  int dtype = param.dtype;
+  if ((*in_type)[embedding_bag::kWeight] != -1) {
+    dtype = (*in_type)[embedding_bag::kWeight];
+  } else if ((*out_type)[0] != -1) {
+    dtype = (*out_type)[0];
+  }
+  TYPE_ASSIGN_CHECK(*in_type, embedding_bag::kWeight, dtype);
+  TYPE_ASSIGN_CHECK(*out_type, 0, dtype);
+  return true;
+}
+
+// storage type inference function for _backward_EmbeddingBag
+inline bool EmbeddingBagOpBackwardStorageType(const nnvm::NodeAttrs& attrs,
+                                              const int dev_mask,
+                                              DispatchMode* dispatch_mode,
+                                              std::vector<int>* in_attrs,
+                                              std::vector<int>* out_attrs) {
+  CHECK_EQ(in_attrs->size(), 3U);
+  CHECK_EQ(out_attrs->size(), 3U);
+  const bool sparse_grad = nnvm::get<EmbeddingBagParam>(attrs.parsed).sparse_grad;
+  const NDArrayStorageType target_stype = sparse_grad ? kRowSparseStorage : kDefaultStorage;
+  const auto target_mode = sparse_grad ? DispatchMode::kFComputeEx : DispatchMode::kFCompute;
+  int& weight_grad_stype = out_attrs->at(embedding_bag::kWeight);
+  bool dispatched = false;
+  if (!dispatched && common::ContainsOnlyStorage(*in_attrs, kDefaultStorage)) {
+    // dns, dns, dns -> dns, dns, dns/rsp
+    if (type_assign(&out_attrs->at(embedding_bag::kData), kDefaultStorage) &&
+        type_assign(&out_attrs->at(embedding_bag::kOffsets), kDefaultStorage) &&
+        type_assign(&weight_grad_stype, target_stype)) {
+      dispatched = dispatch_mode_assign(dispatch_mode, target_mode);
+    }
+  }
+  if (weight_grad_stype != target_stype) {
+    LOG(FATAL) << "Cannot use sparse_grad = " << sparse_grad
+               << ", while stype of gradients w.r.t embedding weight is "
+               << common::stype_string(weight_grad_stype);
+  }
+  return dispatched;
+}
+
+/*!
+ * \brief the indices [begin, end) of bag b, clipped to the indices
+ * \param offsets start offsets of the bags, followed by the end offset of the last one
+ * \param b the bag
+ * \param data_size number of indices
+ */
+template<typename OType>
+MSHADOW_XINLINE void EmbeddingBagRange(const OType* offsets, const nnvm::dim_t b,
+                                       const nnvm::dim_t data_size,
+                                       nnvm::dim_t* begin, nnvm::dim_t* end) {
+  nnvm::dim_t lo = static_cast<nnvm::dim_t>(offsets[b]);
+  nnvm::dim_t hi = static_cast<nnvm::dim_t>(offsets[b + 1]);
+  lo = lo < 0 ? 0 : (lo > data_size ? data_size : lo);
+  hi = hi < lo ? lo : (hi > data_size ? data_size : hi);
+  *begin = lo;
+  *end = hi;
+}
+
+// EmbeddingBag forward implementation, pooling the rows of the bags
+template<typename xpu>
+void EmbeddingBagOpForwardImpl(mshadow::Stream<xpu>* s,
+                               const TBlob& data,
+                               const TBlob& offsets,
+                               const TBlob& weight,
+                               const bool mean,
+                               const OpReqType req,
+                               const TBlob& output);
+
+template<typename xpu>
+void EmbeddingBagOpForward(const nnvm::NodeAttrs& attrs,
+                           const OpContext& ctx,
+                           const std::vector<TBlob>& inputs,
+                           const std::vector<OpReqType>& req,
+                           const std::vector<TBlob>& outputs) {
+  CHECK_EQ(inputs.size(), 3U);
+  CHECK_EQ(outputs.size(), 1U);
+  if (req[embedding_bag::kOut] == kNullOp) return;
+  const EmbeddingBagParam& param = nnvm::get<EmbeddingBagParam>(attrs.parsed);
+  mshadow::Stream<xpu> *s = ctx.get_stream<xpu>();
+  EmbeddingBagOpForwardImpl<xpu>(s, inputs[embedding_bag::kData],
+                                 inputs[embedding_bag::kOffsets],
+                                 inputs[embedding_bag::kWeight],
+                                 param.mode == embedding_bag::kMean,
+                                 req[embedding_bag::kOut], outputs[embedding_bag::kOut]);
+}
+
+// EmbeddingBag backward implementation with dense weight gradient
+template<typename xpu>
+void EmbeddingBagOpBackwardDnsImpl(const OpContext& ctx,
+                                   const TBlob& ograd,
+                                   const TBlob& data,
+                                   const TBlob& offsets,
+                                   const bool mean,
+                                   const OpReqType req,
+                                   const TBlob& output);
+
+// EmbeddingBag backward implementation with row_sparse weight gradient
+template<typename xpu>
+void EmbeddingBagOpBackwardRspImpl(const OpContext& ctx,
+                                   const TBlob& ograd,
+                                   const TBlob& data,
+                                   const TBlob& offsets,
+                                   const bool mean,
+                                   const OpReqType req,
+                                   const NDArray& output);
+
+template<typename xpu>
+void EmbeddingBagOpBackward(const nnvm::NodeAttrs& attrs,
+                            const OpContext& ctx,
+                            const std::vector<TBlob>& inputs,
+                            const std::vector<OpReqType>& req,
+                            const std::vector<TBlob>& outputs) {
+  CHECK_EQ(inputs.size(), 3U);
+  CHECK_EQ(outputs.size(), 3U);
+  CHECK_EQ(req[embedding_bag::kData], kNullOp)
+          << "EmbeddingBag layer doesn't support calculate data gradient";
+  CHECK_EQ(req[embedding_bag::kOffsets], kNullOp)
+          << "EmbeddingBag layer doesn't support calculate offsets gradient";
+  CHECK_EQ(outputs[embedding_bag::kWeight].type_flag_, inputs[0].type_flag_);
+  const EmbeddingBagParam& param = nnvm::get<EmbeddingBagParam>(attrs.parsed);
+  EmbeddingBagOpBackwardDnsImpl<xpu>(ctx, inputs[0], inputs[1], inputs[2],
+                                     param.mode == embedding_bag::kMean,
+                                     req[embedding_bag::kWeight],
+                                     outputs[embedding_bag::kWeight]);
+}
+
+template<typename xpu>
+void EmbeddingBagOpBackwardEx(const nnvm::NodeAttrs& attrs,
+                              const OpContext& ctx,
+                              const std::vector<NDArray>& inputs,
+                              const std::vector<OpReqType>& req,
+                              const std::vector<NDArray>& outputs) {
+  CHECK_EQ(inputs.size(), 3U);
+  CHECK_EQ(outputs.size(), 3U);
+  const NDArray& weight_grad = outputs[embedding_bag::kWeight];
+  const NDArray& ograd = inputs[0];
+  CHECK_EQ(weight_grad.dtype(), ograd.dtype());
+  CHECK_EQ(req[embedding_bag::kData], kNullOp)
+          << "EmbeddingBag layer doesn't support calculate data gradient";
+  CHECK_EQ(req[embedding_bag::kOffsets], kNullOp)
+          << "EmbeddingBag layer doesn't support calculate offsets gradient";
+  if (common::ContainsOnlyStorage(inputs, kDefaultStorage) &&
+      weight_grad.storage_type() == kRowSparseStorage) {
+    const EmbeddingBagParam& param = nnvm::get<EmbeddingBagParam>(attrs.parsed);
+    EmbeddingBagOpBackwardRspImpl<xpu>(ctx, ograd.data(), inputs[1].data(), inputs[2].data(),
+                                       param.mode == embedding_bag::kMean,
+                                       req[embedding_bag::kWeight], weight_grad);
+  } else {
+    LogUnimplementedOp(attrs, ctx, inputs, req, outputs);
+  }
+}
+
 namespace take_ {  // to avoid name conflict
 enum TakeOpInputs {kArr, kIdx};
 enum TakeOpOutputs {kOut};
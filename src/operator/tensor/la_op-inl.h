@@ -443,13 +443,10 @@ struct syevd {
     if (A.dptr_ != U.dptr_) Copy(U, A, s);
     // From here on, we work on U only
     // Reserve workspace (size determined by query)
-    int lwork(linalg_syevd_workspace_query(U[0], L[0], s));
+    int lwork(linalg_batch_syevd_workspace_query(U, L, s));
     Tensor<xpu, 1, DType> work = ctx.requested[0]
       .get_space_typed<xpu, 1, DType>(Shape1(lwork), s);
-    // Loop over items in batch
-    for (index_t i = 0; i < U.size(0); ++i) {
-      linalg_syevd(U[i], L[i], work, s);
-    }
+    linalg_batch_syevd(U, L, work, s);
     // Set signs of eigenvectors in a deterministic way
     using namespace mxnet_op;
     Kernel<SyevdEigenVecSigns, xpu>::Launch
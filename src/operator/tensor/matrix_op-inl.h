@@ -320,6 +320,51 @@ inline bool IsIdentityTranspose(const TShape& axes) {
   return true;
 }
 
+/*!
+ * \brief Drops the axes of length 1 and merges the runs of axes kept next to each other
+ *  by the transpose. Transposing by axes is transposing the input reshaped to *shape by
+ *  the returned axes, which are the identity if the transpose keeps the memory layout.
+ */
+inline mxnet::TShape CollapseTransposeAxes(const mxnet::TShape& src_shape,
+                                           const mxnet::TShape& axes,
+                                           mxnet::TShape* shape) {
+  const int ndim = axes.ndim();
+  // position of each axis of length > 1 among those of the input
+  std::vector<int> rank(ndim, -1);
+  int nkept = 0;
+  for (int i = 0; i < ndim; ++i) {
+    if (src_shape[i] != 1) rank[i] = nkept++;
+  }
+  // runs of consecutive input axes in the output order, (first rank, length)
+  std::vector<std::pair<int, dim_t>> runs;
+  int last = -2;
+  for (int i = 0; i < ndim; ++i) {
+    const int r = rank[axes[i]];
+    if (r < 0) continue;
+    if (r == last + 1) {
+      runs.back().second *= src_shape[axes[i]];
+    } else {
+      runs.emplace_back(r, src_shape[axes[i]]);
+    }
+    last = r;
+  }
+  if (runs.empty()) {
+    *shape = mxnet::TShape(1, 1);
+    return mxnet::TShape(1, 0);
+  }
+  std::vector<int> order(runs.size());
+  for (size_t i = 0; i < runs.size(); ++i) order[i] = i;
+  std::sort(order.begin(), order.end(),
+            [&runs](int a, int b) { return runs[a].first < runs[b].first; });
+  mxnet::TShape ret(runs.size(), -1);
+  *shape = mxnet::TShape(runs.size(), -1);
+  for (size_t i = 0; i < order.size(); ++i) {
+    (*shape)[i] = runs[order[i]].second;
+    ret[order[i]] = i;
+  }
+  return ret;
+}
+
 template<typename xpu, bool is_addto = false>
 bool TransposeCommonImpl(RunContext ctx,
                    const TBlob& src,
@@ -331,6 +376,18 @@ bool TransposeCommonImpl(RunContext ctx,
   CHECK_EQ(src.type_flag_, ret.type_flag_);
   // zero-size tensor, no need to compute
   if (src.shape_.Size() == 0U) return true;
+  // Transpose with the fewest dimensions, so that transposes only moving axes of
+  // length 1 are copies, and more of them are 2D or within the supported dimensions
+  mxnet::TShape collapsed_shape;
+  const mxnet::TShape collapsed = CollapseTransposeAxes(src.shape_, axes, &collapsed_shape);
+  if (collapsed.ndim() < axes.ndim()) {
+    mxnet::TShape collapsed_ret_shape(collapsed.ndim(), -1);
+    for (int i = 0; i < collapsed.ndim(); ++i) {
+      collapsed_ret_shape[i] = collapsed_shape[collapsed[i]];
+    }
+    return TransposeCommonImpl<xpu, is_addto>(ctx, src.reshape(collapsed_shape),
+                                              ret.reshape(collapsed_ret_shape), collapsed);
+  }
   Stream<xpu> *s = ctx.get_stream<xpu>();
 #ifdef __CUDACC__
   // This transpose can be used only if there exist n and m such that:
@@ -349,8 +406,8 @@ bool TransposeCommonImpl(RunContext ctx,
       Tensor<xpu, 1, DType> in = src.get_with_shape<xpu, 1, DType>(mshadow::Shape1(src.Size()), s);
       Tensor<xpu, 1, DType> out = ret.get_with_shape<xpu, 1, DType>(mshadow::Shape1(ret.Size()), s);
       if (!is_addto) {
-        // Use memcpy to accelerate the speed
-        Copy(out, in, s);
+        // Use memcpy to accelerate the speed, nothing to do in place
+        if (out.dptr_ != in.dptr_) Copy(out, in, s);
       } else {
         mxnet_op::Kernel<mxnet_op::op_with_req<mshadow_op::identity, kAddTo>, xpu>::Launch(
             s, ret.Size(), out.dptr_, in.dptr_);
@@ -427,9 +484,8 @@ void TransposeImpl(RunContext ctx,
                    const TBlob& src,
                    const TBlob& ret,
                    const mxnet::TShape& axes) {
-  CHECK_LE(axes.ndim(), 6) << "TransposeImpl supports at most 6 dimensions";
   CHECK((TransposeCommonImpl<xpu, is_addto>(ctx, src, ret, axes))) <<
-    "Failed to execute TransposeImpl Operator";
+    "TransposeImpl supports at most 6 dimensions after merging the axes kept together";
 }
 
 template <bool is_addto>
@@ -3093,6 +3149,8 @@ inline void SplitOpForwardImpl(const nnvm::NodeAttrs& attrs,
   using namespace mshadow;
   using namespace mshadow::expr;
   using namespace mxnet_op;
+  // the outputs planned in place in the input, see DetectConcatAlias
+  if (std::all_of(req.begin(), req.end(), [](OpReqType r) { return r == kNullOp; })) return;
   const SplitParam& param = nnvm::get<SplitParam>(attrs.parsed);
   Stream<xpu> *s = ctx.get_stream<xpu>();
   const TBlob& input_data = inputs[split_enum::kData];
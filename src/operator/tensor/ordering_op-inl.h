@@ -29,6 +29,7 @@
 #include <dmlc/optional.h>
 #include <mshadow/tensor.h>
 #include <algorithm>
+#include <functional>
 #include <vector>
 #include <string>
 #include <type_traits>
@@ -222,50 +223,163 @@ struct fill_ind {
   }
 };
 
-template<typename DType>
-MSHADOW_FORCE_INLINE void TopKSort(const Tensor<cpu, 1, DType>& dat,
-                                   const Tensor<cpu, 1, index_t>& ind,
-                                   const Tensor<cpu, 1, char>& work,
-                                   index_t K, index_t N, bool is_ascend,
-                                   Stream<cpu> *s) {
+/*! \brief elements of a row selected by a task of the parallel top-k and sorts */
+const index_t kTopKMinChunk = 1 << 16;
+/*! \brief elements filtered against the current k-th value at once */
+const index_t kTopKSelectBlock = 256;
+
+/*!
+ * \brief indices of the K first elements of vals[begin, end) in the order of comp, unsorted
+ *
+ *  The elements are compared, in blocks, with the K-th element of those selected so far, and
+ *  the few that are not after it are buffered. The buffer is cut back to its K first elements
+ *  whenever it is full, so that most elements cost one comparison on contiguous values.
+ */
+template<typename DType, typename Compare>
+std::vector<index_t> TopKSelect(const DType *vals, index_t begin, index_t end, index_t K,
+                                Compare comp) {
+  std::vector<index_t> selected;
+  if (K <= 0) return selected;
+  auto by_value = [vals, comp](index_t i1, index_t i2) { return comp(vals[i1], vals[i2]); };
+  const size_t capacity = std::max<size_t>(2 * K, 4 * kTopKSelectBlock);
+  selected.reserve(capacity + kTopKSelectBlock);
+  bool has_threshold = false;
+  DType threshold = DType(0);
+  index_t candidates[kTopKSelectBlock];
+  for (index_t j0 = begin; j0 < end; j0 += kTopKSelectBlock) {
+    const index_t j1 = std::min(end, j0 + kTopKSelectBlock);
+    if (!has_threshold) {
+      for (index_t j = j0; j < j1; ++j) selected.push_back(j);
+    } else {
+      // most blocks have no candidate, and this test vectorizes
+      int passed = 0;
+      for (index_t j = j0; j < j1; ++j) passed += !comp(threshold, vals[j]);
+      if (passed == 0) continue;
+      index_t n = 0;
+      for (index_t j = j0; j < j1; ++j) {
+        candidates[n] = j;
+        n += !comp(threshold, vals[j]);
+      }
+      selected.insert(selected.end(), candidates, candidates + n);
+    }
+    if (selected.size() >= capacity) {
+      std::nth_element(selected.begin(), selected.begin() + (K - 1), selected.end(), by_value);
+      selected.resize(K);
+      threshold = vals[selected[K - 1]];
+      has_threshold = true;
+    }
+  }
+  if (selected.size() > static_cast<size_t>(K)) {
+    std::nth_element(selected.begin(), selected.begin() + (K - 1), selected.end(), by_value);
+    selected.resize(K);
+  }
+  return selected;
+}
+
+/*!
+ * \brief sort the indices of one row by their values with nthreads threads, sorting chunks
+ *  in parallel then merging them pairwise
+ */
+template<typename DType, typename Compare>
+void TopKParallelSort(const DType *vals, index_t *indices, index_t N, Compare comp,
+                      int nthreads) {
+  auto by_value = [vals, comp](index_t i1, index_t i2) { return comp(vals[i1], vals[i2]); };
+  const index_t chunk = (N + nthreads - 1) / nthreads;
+  #pragma omp parallel for num_threads(nthreads)
+  for (int p = 0; p < nthreads; ++p) {
+    const index_t lo = std::min(N, p * chunk), hi = std::min(N, lo + chunk);
+    std::sort(indices + lo, indices + hi, by_value);
+  }
+  std::vector<index_t> buffer(N);
+  index_t *src = indices, *dst = buffer.data();
+  for (index_t width = chunk; width < N; width *= 2) {
+    const index_t pairs = (N + 2 * width - 1) / (2 * width);
+    #pragma omp parallel for num_threads(nthreads)
+    for (index_t p = 0; p < pairs; ++p) {
+      const index_t lo = p * 2 * width;
+      const index_t mid = std::min(N, lo + width), hi = std::min(N, lo + 2 * width);
+      std::merge(src + lo, src + mid, src + mid, src + hi, dst + lo, by_value);
+    }
+    std::swap(src, dst);
+  }
+  if (src != indices) std::copy(src, src + N, indices);
+}
+
+/*!
+ * \brief sort the M rows of N elements of vals, up to their K-th element
+ * \param indices indices in vals of the elements of the rows, i * N + j initially
+ */
+template<typename DType, typename Compare>
+void TopKSortRows(const DType *vals, DType *sorted_vals, index_t *indices,
+                  index_t K, index_t N, index_t M, Compare comp) {
+  if (K == 0) return;
   // Use full sort when K is relatively large.
   const bool full_sort(K*8 > N);
-  // Batch size.
-  const index_t M(work.size(0)/(sizeof(DType)*N));
+  auto by_value = [vals, comp](index_t i1, index_t i2) { return comp(vals[i1], vals[i2]); };
   const int omp_threads(engine::OpenMP::Get()->GetRecommendedOMPThreadCount());
-  #pragma omp parallel for num_threads(omp_threads)
-  for (index_t i = 0; i < M; ++i) {
-    // Tensor `work` stores the flattened source data, while `dat` stores the sorted result.
-    DType *vals = reinterpret_cast<DType*>(work.dptr_);
-    DType *sorted_vals = dat.dptr_+i*N;
-    index_t *indices = ind.dptr_+i*N;
-    if (is_ascend) {
+  // chunks of long rows for the threads left idle by the parallelism over the rows
+  const int row_threads = M >= omp_threads ? 1 :
+      static_cast<int>(std::min<index_t>(omp_threads / M, N / kTopKMinChunk));
+  if (row_threads <= 1) {
+    #pragma omp parallel for num_threads(omp_threads)
+    for (index_t i = 0; i < M; ++i) {
+      index_t *row = indices + i * N;
       if (full_sort) {
-        std::sort(indices, indices+N,
-                  [&](const index_t& i1, const index_t& i2){
-          return vals[i1] < vals[i2]; });
+        std::sort(row, row + N, by_value);
       } else {
-        std::partial_sort(indices, indices+K, indices+N,
-                          [&](const index_t& i1, const index_t& i2){
-          return vals[i1] < vals[i2]; });
+        const std::vector<index_t> selected = TopKSelect(vals, i * N, (i + 1) * N, K, comp);
+        std::copy(selected.begin(), selected.end(), row);
+        std::sort(row, row + K, by_value);
       }
+      for (index_t j = 0; j < K; ++j) {
+        sorted_vals[i * N + j] = vals[row[j]];
+      }
+    }
+    return;
+  }
+  for (index_t i = 0; i < M; ++i) {
+    index_t *row = indices + i * N;
+    if (full_sort) {
+      TopKParallelSort(vals, row, N, comp, row_threads);
     } else {
-      if (full_sort) {
-        std::sort(indices, indices+N,
-                  [&](const index_t& i1, const index_t& i2){
-          return vals[i1] > vals[i2]; });
-      } else {
-        std::partial_sort(indices, indices+K, indices+N,
-                          [&](const index_t& i1, const index_t& i2){
-          return vals[i1] > vals[i2]; });
+      // K first elements of every chunk, then of those
+      const index_t chunk = (N + row_threads - 1) / row_threads;
+      std::vector<std::vector<index_t>> parts(row_threads);
+      #pragma omp parallel for num_threads(row_threads)
+      for (int p = 0; p < row_threads; ++p) {
+        const index_t lo = std::min(N, p * chunk), hi = std::min(N, lo + chunk);
+        parts[p] = TopKSelect(vals, i * N + lo, i * N + hi, K, comp);
       }
+      std::vector<index_t> selected;
+      selected.reserve(row_threads * K);
+      for (const auto &part : parts) selected.insert(selected.end(), part.begin(), part.end());
+      std::nth_element(selected.begin(), selected.begin() + (K - 1), selected.end(), by_value);
+      std::sort(selected.begin(), selected.begin() + K, by_value);
+      std::copy(selected.begin(), selected.begin() + K, row);
     }
     for (index_t j = 0; j < K; ++j) {
-      sorted_vals[j] = vals[indices[j]];
+      sorted_vals[i * N + j] = vals[row[j]];
     }
   }
 }
 
+template<typename DType>
+MSHADOW_FORCE_INLINE void TopKSort(const Tensor<cpu, 1, DType>& dat,
+                                   const Tensor<cpu, 1, index_t>& ind,
+                                   const Tensor<cpu, 1, char>& work,
+                                   index_t K, index_t N, bool is_ascend,
+                                   Stream<cpu> *s) {
+  // Batch size.
+  const index_t M(work.size(0)/(sizeof(DType)*N));
+  // Tensor `work` stores the flattened source data, while `dat` stores the sorted result.
+  const DType *vals = reinterpret_cast<DType*>(work.dptr_);
+  if (is_ascend) {
+    TopKSortRows(vals, dat.dptr_, ind.dptr_, K, N, M, std::less<DType>());
+  } else {
+    TopKSortRows(vals, dat.dptr_, ind.dptr_, K, N, M, std::greater<DType>());
+  }
+}
+
 #ifdef __CUDACC__
 
 template<typename DType>
@@ -364,20 +478,9 @@ MSHADOW_FORCE_INLINE void TopKSort(const Tensor<gpu, 1, DType>& dat,
   // Batch size.
   const index_t M(dat.size(0)/N);
   if (full_sort) {
-    // Divide workspace into two parts. The first one is needed to store batch ids.
-    size_t alignment = std::max(sizeof(DType), sizeof(index_t));
-    size_t id_size = PadBytes(sizeof(index_t) * ind.size(0), alignment);
-    Tensor<gpu, 1, index_t> batch_id(reinterpret_cast<index_t*>(work.dptr_),
-                                     Shape1(ind.size(0)), s);
-    Tensor<gpu, 1, char> sort_work(work.dptr_+id_size, Shape1(work.size(0)-id_size), s);
-    mxnet::op::SortByKey(dat, ind, is_ascend, &sort_work);
-    if (M > 1) {
-      // Back to back sorting. Note that mxnet::op::SortByKey is a stable sort.
-      batch_id = ind / N;
-      mxnet::op::SortByKey(batch_id, dat, true, &sort_work);
-      batch_id = ind / N;
-      mxnet::op::SortByKey(batch_id, ind, true, &sort_work);
-    }
+    // Each batch is a segment sorted on its own.
+    Tensor<gpu, 1, char> sort_work(work.dptr_, Shape1(work.size(0)), s);
+    mxnet::op::SegmentedSortByKey(dat, ind, N, is_ascend, &sort_work);
   } else {
     const int nthreads(mshadow::cuda::kBaseThreadNum);
     PartialSortSmallK<<<M, nthreads, nthreads*K*(sizeof(index_t)+sizeof(DType)),
@@ -436,14 +539,8 @@ void TopKImpl(const RunContext &ctx,
     << mxnet::common::MaxIntegerValue<index_t>() << " elements";
   Tensor<xpu, 3, DType> dat = src.FlatTo3D<xpu, DType>(axis, axis, s);
   // Temp space needed by the full sorts.
-  size_t temp_size = std::max(
-      mxnet::op::SortByKeyWorkspaceSize<index_t, DType, xpu>(src.Size()),
-      mxnet::op::SortByKeyWorkspaceSize<DType, index_t, xpu>(src.Size()));
-
-  temp_size = std::max(temp_size,
-      mxnet::op::SortByKeyWorkspaceSize<index_t, index_t, xpu>(src.Size()));
-  // Additional temp space for gpu full sorts for batch ids.
-  temp_size += PadBytes(sizeof(index_t) * src.Size(), alignment);
+  size_t temp_size =
+      mxnet::op::SegmentedSortByKeyWorkspaceSize<DType, index_t, xpu>(src.Size(), element_num);
   // Temp space for cpu sorts.
   temp_size = std::max(temp_size, sizeof(DType) * src.Size());
 
@@ -596,14 +693,8 @@ size_t TopKWorkspaceSize(const TBlob& src,
                  &target_shape, &batch_size, &element_num, &axis, &k, &do_transpose, &is_ascend);
 
   // Temp space needed by the full sorts.
-  temp_size = std::max(
-      mxnet::op::SortByKeyWorkspaceSize<index_t, DType, xpu>(src.Size()),
-      mxnet::op::SortByKeyWorkspaceSize<DType, index_t, xpu>(src.Size()));
-
-  temp_size = std::max(temp_size,
-      mxnet::op::SortByKeyWorkspaceSize<index_t, index_t, xpu>(src.Size()));
-  // Additional temp space for gpu full sorts for batch ids.
-  temp_size += PadBytes(sizeof(index_t) * src.Size(), alignment);
+  temp_size =
+      mxnet::op::SegmentedSortByKeyWorkspaceSize<DType, index_t, xpu>(src.Size(), element_num);
   // Temp space for cpu sorts.
   temp_size = std::max(temp_size, sizeof(DType) * src.Size());
   *temp_size_ptr = temp_size;
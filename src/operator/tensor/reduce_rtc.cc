@@ -297,6 +297,10 @@ void RTCReduceImpl(Stream<gpu> *s, const TBlob& small, const bool addto,
   const auto &function_code = (lhs == nullptr)
                             ? reduce_function_code
                             : reduce_function_use_input_code;
+  if (config.Mnext > 1) {
+    // compiled in the background while the first kernel is compiled here
+    compile_function_async(code, "reduce_lines_kernel", reduce_lines_kernel_code, dev_id);
+  }
   auto reduce_kernel_func = get_function(code + function_code,
                                          "reduce_kernel",
                                          reduce_kernel_code,
@@ -24,15 +24,22 @@
  */
 #ifndef MXNET_OPERATOR_TENSOR_SORT_OP_INL_CUH_
 #define MXNET_OPERATOR_TENSOR_SORT_OP_INL_CUH_
+#include <limits>
 #include <type_traits>
 #include <thrust/device_ptr.h>
+#include <thrust/gather.h>
 #include <thrust/sort.h>
 #if defined(_MSC_VER) && __CUDACC_VER_MAJOR__ == 8 && __CUDACC_VER_BUILD__ != 44
 // Many CUDA 8 compilers other than V8.0.44 crash on Windows
 #pragma warning("Potential crash on CUDA compiler detected. Switching sorting from CUB to Thrust")
 #define SORT_WITH_THRUST
 #else
+#include <cub/block/block_load.cuh>
+#include <cub/block/block_radix_sort.cuh>
 #include <cub/device/device_radix_sort.cuh>
+#include <cub/device/device_segmented_radix_sort.cuh>
+#include <cub/iterator/counting_input_iterator.cuh>
+#include <cub/iterator/transform_input_iterator.cuh>
 #undef SORT_WITH_THRUST
 #endif
 #if CUDA_VERSION >= 7000
@@ -353,6 +360,202 @@ inline void SortByKey(mshadow::Tensor<gpu, 1, KDType> keys, mshadow::Tensor<gpu,
   SortByKeyImpl(keys, values, is_ascend, workspace, begin_bit, end_bit, sorted_keys, sorted_values);
 }
 
+#ifndef SORT_WITH_THRUST
+namespace cuda {
+/*! \brief type sorted by cub for a type of mshadow */
+template<typename DType>
+struct CubSortType {
+  using type = DType;
+};
+
+template<>
+struct CubSortType<mshadow::half::half_t> {
+  using type = __half;
+};
+
+/*! \brief offset of a segment of segment_length keys */
+struct SegmentOffset {
+  int segment_length;
+  __host__ __device__ __forceinline__ int operator()(const int segment) const {
+    return segment * segment_length;
+  }
+};
+
+using SegmentOffsetIterator =
+    cub::TransformInputIterator<int, SegmentOffset, cub::CountingInputIterator<int>>;
+
+/*! \brief longest segment sorted by BlockSegmentedSortKernel */
+const index_t kBlockSortMaxLength = 4096;
+
+/*!
+ * \brief Sort a segment in the shared memory of a block, one block per segment of at most
+ *  kThreads * kItems keys.
+ */
+template<int kThreads, int kItems, typename KDType, typename VDType>
+__global__ void __launch_bounds__(kThreads)
+BlockSegmentedSortKernel(KDType* keys, VDType* values, const int segment_length,
+                         const bool is_ascend) {
+  using BlockLoadKeys = cub::BlockLoad<KDType, kThreads, kItems, cub::BLOCK_LOAD_TRANSPOSE>;
+  using BlockLoadValues = cub::BlockLoad<VDType, kThreads, kItems, cub::BLOCK_LOAD_TRANSPOSE>;
+  using BlockSort = cub::BlockRadixSort<KDType, kThreads, kItems, VDType>;
+  using UnsignedBits = typename cub::Traits<KDType>::UnsignedBits;
+  __shared__ union {
+    typename BlockLoadKeys::TempStorage load_keys;
+    typename BlockLoadValues::TempStorage load_values;
+    typename BlockSort::TempStorage sort;
+  } temp_storage;
+  KDType* segment_keys = keys + static_cast<size_t>(blockIdx.x) * segment_length;
+  VDType* segment_values = values + static_cast<size_t>(blockIdx.x) * segment_length;
+  // the sort is stable, so the padding comes after the keys of the segment equal to it
+  const UnsignedBits pad_bits = is_ascend ? cub::Traits<KDType>::MAX_KEY :
+                                            cub::Traits<KDType>::LOWEST_KEY;
+  const KDType pad = reinterpret_cast<const KDType&>(pad_bits);
+  KDType thread_keys[kItems];
+  VDType thread_values[kItems];
+  BlockLoadKeys(temp_storage.load_keys).Load(segment_keys, thread_keys, segment_length, pad);
+  __syncthreads();
+  BlockLoadValues(temp_storage.load_values).Load(segment_values, thread_values, segment_length);
+  __syncthreads();
+  if (is_ascend) {
+    BlockSort(temp_storage.sort).SortBlockedToStriped(thread_keys, thread_values);
+  } else {
+    BlockSort(temp_storage.sort).SortDescendingBlockedToStriped(thread_keys, thread_values);
+  }
+  cub::StoreDirectStriped<kThreads>(threadIdx.x, segment_keys, thread_keys, segment_length);
+  cub::StoreDirectStriped<kThreads>(threadIdx.x, segment_values, thread_values, segment_length);
+}
+
+template<int kThreads, int kItems, typename KDType, typename VDType>
+inline void BlockSegmentedSort(KDType* keys, VDType* values, const int num_segments,
+                               const int segment_length, const bool is_ascend,
+                               cudaStream_t stream) {
+  BlockSegmentedSortKernel<kThreads, kItems><<<num_segments, kThreads, 0, stream>>>(
+      keys, values, segment_length, is_ascend);
+}
+}  // namespace cuda
+#endif  // SORT_WITH_THRUST
+
+template <typename KDType, typename VDType, typename xpu>
+inline typename std::enable_if<std::is_same<xpu, gpu>::value, size_t>::type
+SegmentedSortByKeyWorkspaceSize(const size_t num_keys, const size_t segment_length) {
+  if (num_keys == segment_length) {
+    return SortByKeyWorkspaceSize<KDType, VDType, xpu>(num_keys);
+  }
+#ifdef SORT_WITH_THRUST
+  // [segment ids, sorted indices, values] of the back to back sorts
+  const size_t alignment = std::max(std::max(sizeof(KDType), sizeof(VDType)), sizeof(index_t));
+  return 2 * PadBytes(sizeof(index_t) * num_keys, alignment) +
+         PadBytes(sizeof(VDType) * num_keys, alignment);
+#else
+  if (segment_length <= static_cast<size_t>(cuda::kBlockSortMaxLength)) return 0;
+  using CubKey = typename cuda::CubSortType<KDType>::type;
+  using CubValue = typename cuda::CubSortType<VDType>::type;
+  size_t keys_bytes, values_bytes;
+  WorkspaceSize4KeysAndValues<KDType, VDType>(num_keys, &keys_bytes, &values_bytes);
+  size_t sortpairs_bytes = 0;
+  const cuda::SegmentOffsetIterator offsets(cub::CountingInputIterator<int>(0),
+      cuda::SegmentOffset{static_cast<int>(segment_length)});
+  cub::DeviceSegmentedRadixSort::SortPairs<CubKey, CubValue>(nullptr, sortpairs_bytes,
+      nullptr, nullptr, nullptr, nullptr, static_cast<int>(num_keys),
+      static_cast<int>(num_keys / segment_length), offsets, offsets + 1);
+  return keys_bytes + values_bytes + sortpairs_bytes;
+#endif
+}
+
+template<typename KDType, typename VDType>
+inline void SegmentedSortByKey(mshadow::Tensor<gpu, 1, KDType> keys,
+                               mshadow::Tensor<gpu, 1, VDType> values,
+                               const index_t segment_length, bool is_ascend,
+                               mshadow::Tensor<gpu, 1, char>* workspace) {
+  CHECK_EQ(keys.CheckContiguous(), true);
+  CHECK_EQ(values.CheckContiguous(), true);
+  CHECK_EQ(keys.size(0), values.size(0));
+  CHECK_EQ(keys.size(0) % segment_length, 0);
+  const index_t num_keys = keys.size(0);
+  if (num_keys == segment_length) {
+    SortByKey(keys, values, is_ascend, workspace);
+    return;
+  }
+  CHECK(workspace != nullptr) << "SegmentedSortByKey requires a workspace";
+  CHECK_GE(workspace->size(0), (SegmentedSortByKeyWorkspaceSize<KDType, VDType, gpu>(
+      num_keys, segment_length)))
+    << "Workspace given to SegmentedSortByKey is too small";
+#ifdef SORT_WITH_THRUST
+  // Back to back sorting of the indices of the keys. Note that SortByKey is a stable sort.
+  using namespace mshadow::expr;
+  const size_t alignment = std::max(std::max(sizeof(KDType), sizeof(VDType)), sizeof(index_t));
+  const size_t index_bytes = PadBytes(sizeof(index_t) * num_keys, alignment);
+  mshadow::Tensor<gpu, 1, index_t> segment_id(reinterpret_cast<index_t*>(workspace->dptr_),
+                                              mshadow::Shape1(num_keys), keys.stream_);
+  mshadow::Tensor<gpu, 1, index_t> sorted_index(
+      reinterpret_cast<index_t*>(workspace->dptr_ + index_bytes), mshadow::Shape1(num_keys),
+      keys.stream_);
+  mshadow::Tensor<gpu, 1, VDType> values_copy(
+      reinterpret_cast<VDType*>(workspace->dptr_ + 2 * index_bytes), mshadow::Shape1(num_keys),
+      keys.stream_);
+  sorted_index = range<index_t>(0, num_keys);
+  SortByKey(keys, sorted_index, is_ascend);
+  segment_id = sorted_index / ScalarExp<index_t>(segment_length);
+  SortByKey(segment_id, keys, true);
+  segment_id = sorted_index / ScalarExp<index_t>(segment_length);
+  SortByKey(segment_id, sorted_index, true);
+  mshadow::Copy(values_copy, values, values.stream_);
+  const auto index_iter = thrust::device_pointer_cast(sorted_index.dptr_);
+  thrust::gather(thrust::cuda::par.on(mshadow::Stream<gpu>::GetStream(keys.stream_)),
+                 index_iter, index_iter + num_keys, thrust::device_pointer_cast(values_copy.dptr_),
+                 thrust::device_pointer_cast(values.dptr_));
+#else
+  CHECK_LE(num_keys, std::numeric_limits<int>::max())
+    << "SegmentedSortByKey sorts at most " << std::numeric_limits<int>::max() << " keys";
+  cudaStream_t stream = mshadow::Stream<gpu>::GetStream(keys.stream_);
+  using CubKey = typename cuda::CubSortType<KDType>::type;
+  using CubValue = typename cuda::CubSortType<VDType>::type;
+  CubKey* keys_ptr = reinterpret_cast<CubKey*>(keys.dptr_);
+  CubValue* values_ptr = reinterpret_cast<CubValue*>(values.dptr_);
+  const int num_segments = num_keys / segment_length;
+  const int length = segment_length;
+  if (segment_length <= 512) {
+    cuda::BlockSegmentedSort<128, 4>(keys_ptr, values_ptr, num_segments, length, is_ascend,
+                                     stream);
+  } else if (segment_length <= 1024) {
+    cuda::BlockSegmentedSort<128, 8>(keys_ptr, values_ptr, num_segments, length, is_ascend,
+                                     stream);
+  } else if (segment_length <= 2048) {
+    cuda::BlockSegmentedSort<256, 8>(keys_ptr, values_ptr, num_segments, length, is_ascend,
+                                     stream);
+  } else if (segment_length <= cuda::kBlockSortMaxLength) {
+    cuda::BlockSegmentedSort<256, 16>(keys_ptr, values_ptr, num_segments, length, is_ascend,
+                                      stream);
+  } else {
+    // workspace = [keys_out, values_out, temporary_storage]
+    size_t keys_bytes, values_bytes;
+    WorkspaceSize4KeysAndValues<KDType, VDType>(num_keys, &keys_bytes, &values_bytes);
+    CubKey* keys_out_ptr = reinterpret_cast<CubKey*>(workspace->dptr_);
+    CubValue* values_out_ptr = reinterpret_cast<CubValue*>(workspace->dptr_ + keys_bytes);
+    void* temp_storage = workspace->dptr_ + keys_bytes + values_bytes;
+    size_t sortpairs_bytes = workspace->size(0) - keys_bytes - values_bytes;
+    const cuda::SegmentOffsetIterator offsets(cub::CountingInputIterator<int>(0),
+                                              cuda::SegmentOffset{length});
+    if (is_ascend) {
+      cub::DeviceSegmentedRadixSort::SortPairs(temp_storage, sortpairs_bytes,
+          keys_ptr, keys_out_ptr, values_ptr, values_out_ptr, num_keys, num_segments,
+          offsets, offsets + 1, 0, sizeof(KDType) * 8, stream);
+    } else {
+      cub::DeviceSegmentedRadixSort::SortPairsDescending(temp_storage, sortpairs_bytes,
+          keys_ptr, keys_out_ptr, values_ptr, values_out_ptr, num_keys, num_segments,
+          offsets, offsets + 1, 0, sizeof(KDType) * 8, stream);
+    }
+    // Copy result back to [keys, values]
+    mshadow::Copy(keys, mshadow::Tensor<gpu, 1, KDType>(
+        reinterpret_cast<KDType*>(keys_out_ptr), keys.shape_, keys.stream_), keys.stream_);
+    mshadow::Copy(values, mshadow::Tensor<gpu, 1, VDType>(
+        reinterpret_cast<VDType*>(values_out_ptr), values.shape_, values.stream_),
+        values.stream_);
+  }
+  MSHADOW_CUDA_POST_KERNEL_CHECK(SegmentedSortByKey);
+#endif  // SORT_WITH_THRUST
+}
+
 }  // namespace op
 }  // namespace mxnet
 
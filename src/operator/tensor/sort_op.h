@@ -148,6 +148,50 @@ SortByKeyWorkspaceSize(const size_t num_keys,
                        const bool keys_in_place = true,
                        const bool values_in_place = true);
 
+/*!
+ * \brief CPU/GPU: Sort the key-value pairs of consecutive segments of the same length, each
+ *  segment on its own. (Stable sort is performed!)
+ * \param keys the keys to sort, the segments laid end to end
+ * \param values the values that sorts w.r.t the key
+ * \param segment_length number of keys of a segment
+ * \param is_ascend whether to sort key in ascending order
+ * \param workspace temporary storage of SegmentedSortByKeyWorkspaceSize bytes
+ */
+template<typename KDType, typename VDType>
+inline void SegmentedSortByKey(mshadow::Tensor<cpu, 1, KDType> keys,
+                               mshadow::Tensor<cpu, 1, VDType> values,
+                               const index_t segment_length, bool is_ascend = true,
+                               mshadow::Tensor<cpu, 1, char>* workspace = nullptr) {
+  CHECK_EQ(keys.size(0), values.size(0));
+  CHECK_EQ(keys.size(0) % segment_length, 0);
+  for (index_t begin = 0; begin < keys.size(0); begin += segment_length) {
+    SortByKey(keys.Slice(begin, begin + segment_length),
+              values.Slice(begin, begin + segment_length), is_ascend);
+  }
+}
+
+/*!
+ * \brief CPU/GPU: Return the amount of temporary storage in bytes required for
+ *  SegmentedSortByKey
+ * \param num_keys number of keys to sort
+ * \param segment_length number of keys of a segment
+ */
+template <typename KDType, typename VDType, typename xpu>
+inline typename std::enable_if<std::is_same<xpu, cpu>::value, size_t>::type
+SegmentedSortByKeyWorkspaceSize(const size_t num_keys, const size_t segment_length) {
+  return 0;
+}
+
+template<typename KDType, typename VDType>
+inline void SegmentedSortByKey(mshadow::Tensor<gpu, 1, KDType> keys,
+                               mshadow::Tensor<gpu, 1, VDType> values,
+                               const index_t segment_length, bool is_ascend = true,
+                               mshadow::Tensor<gpu, 1, char>* workspace = nullptr);
+
+template <typename KDType, typename VDType, typename xpu>
+inline typename std::enable_if<std::is_same<xpu, gpu>::value, size_t>::type
+SegmentedSortByKeyWorkspaceSize(const size_t num_keys, const size_t segment_length);
+
 }  // namespace op
 }  // namespace mxnet
 #ifdef __CUDACC__
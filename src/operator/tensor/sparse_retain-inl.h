@@ -213,6 +213,40 @@ struct SparseRetainRspRowBlockKernel {
   }
 };
 
+/*!
+ * \brief Single pass retain for GPU, parallelized by the elements of the output rows.
+ * Each thread searches the input rsp for the row of its element and writes either the
+ * retained value or zero, so that the output does not need to be zeroed beforehand.
+ * The threads of a row search the same index, which keeps the search coalesced.
+ */
+struct SparseRetainRspElemKernel {
+  template<typename DType, typename RType, typename IType>
+  MSHADOW_XINLINE static void Map(int i, DType* out_data, RType* out_idx,
+                                  const DType* in_data, const RType* in_idx,
+                                  const IType* idx, const nnvm::dim_t nnr,
+                                  const nnvm::dim_t row_length) {
+    using nnvm::dim_t;
+    const dim_t irow = i / row_length;
+    const dim_t icol = i % row_length;
+    const RType row = static_cast<RType>(idx[irow]);
+    dim_t left = 0, right = nnr - 1, j = -1;
+    while (left <= right) {
+      const dim_t m = left + (right - left) / 2;
+      const RType in_idx_m = in_idx[m];
+      if (in_idx_m == row) {
+        j = m;
+        break;
+      } else if (in_idx_m < row) {
+        left = m + 1;
+      } else {
+        right = m - 1;
+      }
+    }
+    if (icol == 0) out_idx[irow] = row;
+    out_data[i] = j >= 0 ? in_data[j * row_length + icol] : DType(0);
+  }
+};
+
 /*!
  * Copy input indices to output indices.
  * Only used when input rsp is dense.
@@ -287,9 +321,10 @@ void SparseRetainOpForwardRspImpl(mshadow::Stream<xpu> *s,
 
   using namespace mxnet_op;
   MSHADOW_TYPE_SWITCH(output_data.type_flag_, DType, {  // output data type
-    Kernel<set_zero, xpu>::Launch(s, output_data.Size(), output_data.dptr<DType>());
     MSHADOW_IDX_TYPE_SWITCH(output_idx.type_flag_, RType, {  // row index data type
       MSHADOW_TYPE_SWITCH(idx_data.type_flag_, IType, {  // index array data type
+        // every output row is written when the input rsp is dense, and the gpu kernel
+        // writes the zeros of the missing rows itself
         if (input_idx.Size() == static_cast<size_t>(input_nd.shape()[0])) {  // input rsp is dense
           using namespace mshadow;
           // copy indices
@@ -312,10 +347,15 @@ void SparseRetainOpForwardRspImpl(mshadow::Stream<xpu> *s,
               output_data.dptr<DType>(), input_data.dptr<DType>(),
               idx_data.dptr<IType>(), row_length);
           }
-        } else {  // input rsp is not dense
+        } else if (std::is_same<xpu, cpu>::value) {  // input rsp is not dense
+          Kernel<set_zero, xpu>::Launch(s, output_data.Size(), output_data.dptr<DType>());
           Kernel<SparseRetainRspThreadKernel, xpu>::Launch(s, idx_data.Size(),
               output_data.dptr<DType>(), output_idx.dptr<RType>(), input_data.dptr<DType>(),
               input_idx.dptr<RType>(), idx_data.dptr<IType>(), input_data.shape_[0], row_length);
+        } else {
+          Kernel<SparseRetainRspElemKernel, xpu>::Launch(s, output_data.Size(),
+              output_data.dptr<DType>(), output_idx.dptr<RType>(), input_data.dptr<DType>(),
+              input_idx.dptr<RType>(), idx_data.dptr<IType>(), input_data.shape_[0], row_length);
         }
       });
     });
@@ -27,6 +27,7 @@
 #include <tvm/runtime/packed_func.h>
 #include <tvm/runtime/registry.h>
 #include <tvm/runtime/c_runtime_api.h>
+#include <sstream>
 #include <string>
 #include <vector>
 #include "op_module.h"
@@ -52,43 +53,41 @@ void TVMOpModule::Import(const TVMOpModule& module) {
   module_ptr_->Import(*(module.module_ptr_));
 }
 
+const char *DTypeName(int type_flag) {
+  switch (type_flag) {
+    case mshadow::kFloat32:
+      return "float32";
+    case mshadow::kFloat64:
+      return "float64";
+    case mshadow::kFloat16:
+      return "float16";
+    case mshadow::kUint8:
+      return "uint8";
+    case mshadow::kInt32:
+      return "int32";
+    case mshadow::kInt8:
+      return "int8";
+    case mshadow::kInt64:
+      return "int64";
+    case mshadow::kBool:
+      return "bool";
+    default:
+      LOG(FATAL) << "Unknown dtype " << type_flag;
+  }
+  return nullptr;
+}
+
 PackedFunc GetFunction(const std::shared_ptr<Module> &module,
                        const std::string &op_name,
                        const std::vector<mxnet::TBlob> &args) {
   std::ostringstream func_name;
   func_name << op_name;
   for (const auto &arg : args) {
-    switch (arg.type_flag_) {
-      case mshadow::kFloat32:
-        func_name << "float32";
-        break;
-      case mshadow::kFloat64:
-        func_name << "float64";
-        break;
-      case mshadow::kFloat16:
-        func_name << "float16";
-        break;
-      case mshadow::kUint8:
-        func_name << "uint8";
-        break;
-      case mshadow::kInt32:
-        func_name << "int32";
-        break;
-      case mshadow::kInt8:
-        func_name << "int8";
-        break;
-      case mshadow::kInt64:
-        func_name << "int64";
-        break;
-      case mshadow::kBool:
-        func_name << "bool";
-        break;
-      default:
-        LOG(FATAL) << "Unknown dtype " << arg.type_flag_;
-    }
-    func_name << "_" << arg.shape_.ndim();
+    func_name << DTypeName(arg.type_flag_) << "_" << arg.shape_.ndim();
   }
-  return module->GetFunction(func_name.str(), false);
+  PackedFunc func = module->GetFunction(func_name.str(), false);
+  CHECK(func != nullptr) << "TVM kernel " << func_name.str() << " is not in the library";
+  return func;
 }
 
 void TVMOpModule::Call(const std::string &func_name,
@@ -145,13 +144,37 @@ void TVMOpModule::CallEx(const std::string &func_name,
 #endif
 }
 
+int TVMOpConfig::get_tuned_index(const std::vector<mxnet::TBlob>& args) const {
+  // the entity name tune.py gives the workload, e.g. tuned_float32_64x32_float32_64
+  std::ostringstream key;
+  key << "tuned";
+  for (const auto &arg : args) {
+    key << "_" << DTypeName(arg.type_flag_) << "_";
+    for (int i = 0; i < arg.shape_.ndim(); ++i) {
+      key << (i == 0 ? "" : "x") << arg.shape_[i];
+    }
+  }
+  auto it = entity_map_.find(key.str());
+  return it == entity_map_.end() ? -1 : it->second.get_val();
+}
+
 const TVMOpConfig& GetOpConfig(const std::string& name) {
-  const TVMOpConfig* ret = ::dmlc::Registry<TVMOpConfig>::Get()->Find(name);
+  const TVMOpConfig* ret = FindOpConfig(name);
   CHECK(ret != nullptr)
     << "op " << name << "does not exist.";
   return *ret;
 }
 
+const TVMOpConfig* FindOpConfig(const std::string& name) {
+  return ::dmlc::Registry<TVMOpConfig>::Get()->Find(name);
+}
+
+std::string TunedSchedule(const std::string& name, const std::vector<mxnet::TBlob>& args) {
+  const TVMOpConfig* config = FindOpConfig(name);
+  const int index = config == nullptr ? -1 : config->get_tuned_index(args);
+  return index < 0 ? "fallback" : "index_" + std::to_string(index);
+}
+
 }  // namespace runtime
 }  // namespace tvm
 
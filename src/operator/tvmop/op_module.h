@@ -139,6 +139,13 @@ class TVMOpConfig {
     return weight_map_.at(name);
   }
 
+  /*!
+   * \brief the index of the schedule found fastest on the shapes and dtypes of the tensors
+   *        of a call by contrib/tvmop/tune.py, -1 when the tuning log of the build has no
+   *        record of them
+   */
+  int get_tuned_index(const std::vector<mxnet::TBlob>& args) const;
+
  private:
   std::map<std::string, OtherOptionEntity> entity_map_;
   std::map<std::string, OtherOptionSpace> space_map_;
@@ -148,6 +155,15 @@ class TVMOpConfig {
 
 const TVMOpConfig& GetOpConfig(const std::string& name);
 
+/*! \brief the config of a dispatchable op, nullptr when the config file was not loaded */
+const TVMOpConfig* FindOpConfig(const std::string& name);
+
+/*!
+ * \brief the schedule suffix of a dispatchable op without a shape heuristic: the tuned
+ *        schedule of the tensors of the call when there is one, else the fallback schedule
+ */
+std::string TunedSchedule(const std::string& name, const std::vector<mxnet::TBlob>& args);
+
 }  // namespace runtime
 }  // namespace tvm
 
@@ -25,11 +25,14 @@
 #include <dmlc/base.h>
 #include <dmlc/logging.h>
 #include <mxnet/base.h>
+#include <algorithm>
 #include <fstream>
+#include <functional>
 #include <thread>
 #include <iomanip>
 #include <queue>
 #include <utility>
+#include <vector>
 #include "./profiler.h"
 
 namespace mxnet {
@@ -86,13 +89,125 @@ inline std::priority_queue<pi>
   return heap;
 }
 
+inline bool HasScheduling(const AggregateStats::StatData& data) {
+  return data.type_ == AggregateStats::StatData::kDuration && data.exec_time_.count_ != 0;
+}
+
+inline bool HasSamples(const AggregateStats::StatData& data) {
+  return data.type_ == AggregateStats::StatData::kDuration && data.samples_ != 0;
+}
+
+inline bool HasCost(const AggregateStats::StatData& data) {
+  return data.type_ == AggregateStats::StatData::kDuration && data.cost_count_ != 0 &&
+      data.total_aggregate_ != 0;
+}
+
+/*! \brief average estimated GFLOP of a run over the average duration of a run */
+inline double GflopsPerSecond(const AggregateStats::StatData& data) {
+  return data.flops_ / data.cost_count_ * 1e-3 * data.total_count_ / data.total_aggregate_;
+}
+
+/*! \brief average bytes of a run over the average duration of a run, in GB/s */
+inline double GigabytesPerSecond(const AggregateStats::StatData& data) {
+  return data.bytes_ / data.cost_count_ * 1e-3 * data.total_count_ / data.total_aggregate_;
+}
+
+inline bool HasCounters(const AggregateStats::StatData& data) {
+  return data.type_ == AggregateStats::StatData::kDuration && data.counted_ != 0 &&
+      data.total_aggregate_ != 0;
+}
+
+/*! \brief instructions per cycle of the counted runs */
+inline double InstructionsPerCycle(const AggregateStats::StatData& data) {
+  const uint64_t cycles = data.counters_[perf::kCycles];
+  return cycles ? static_cast<double>(data.counters_[perf::kInstructions]) / cycles : 0;
+}
+
+/*! \brief average of a counter over a run, per output element, -1 if the elements are unknown */
+inline double PerElement(const AggregateStats::StatData& data, perf::Counter counter) {
+  if (data.elements_ == 0) return -1;
+  return static_cast<double>(data.counters_[counter]) / data.counted_ /
+      (data.elements_ / data.elements_count_);
+}
+
+/*!
+ * \brief bytes of the lines missing the last level cache in a run over the average
+ *  duration of a run, in GB/s, which is about the memory traffic of the operator
+ */
+inline double MissGigabytesPerSecond(const AggregateStats::StatData& data) {
+  return static_cast<double>(data.counters_[perf::kCacheMisses]) * perf::kCacheLineBytes /
+      data.counted_ * 1e-3 * data.total_count_ / data.total_aggregate_;
+}
+
+/*! \brief samples per second over the total duration of an entry */
+inline double SamplesPerSecond(const AggregateStats::StatData& data) {
+  return data.total_aggregate_ == 0 ? 0 :
+      static_cast<double>(data.samples_) * 1e6 / data.total_aggregate_;
+}
+
+/*!
+ * \brief Print a scheduling histogram in json format, with the non-empty buckets keyed
+ *  by their upper bound in ms
+ */
+inline void DumpHistogramJson(std::ostream& os, const char* key,
+                              const AggregateStats::Histogram& hist, bool last) {
+  using Histogram = AggregateStats::Histogram;
+  os << "                \"" << key << "\": {" << std::endl
+     << "                    \"Avg\": " << std::setprecision(4)
+     << MicroToMilli(static_cast<double>(hist.total_) / hist.count_) << "," << std::endl
+     << "                    \"P50\": " << std::setprecision(4)
+     << MicroToMilli(hist.Percentile(0.5)) << "," << std::endl
+     << "                    \"P99\": " << std::setprecision(4)
+     << MicroToMilli(hist.Percentile(0.99)) << "," << std::endl
+     << "                    \"Max\": " << std::setprecision(4)
+     << MicroToMilli(hist.max_) << "," << std::endl
+     << "                    \"Histogram\": {";
+  bool first = true;
+  for (int i = 0; i < Histogram::kNumBuckets; ++i) {
+    if (hist.buckets_[i] == 0) continue;
+    os << (first ? "" : ",") << std::endl << "                        \"";
+    if (Histogram::UpperBound(i) != 0) {
+      os << std::setprecision(4) << MicroToMilli(Histogram::UpperBound(i));
+    } else {
+      os << "inf";
+    }
+    os << "\": " << hist.buckets_[i];
+    first = false;
+  }
+  os << std::endl << "                    }" << std::endl
+     << "                }" << (last ? "" : ",") << std::endl;
+}
+
 void AggregateStats::OnProfileStat(const ProfileStat& stat) {
   std::unique_lock<std::mutex> lk(m_);
   if (stat.enable_aggregate_) {
     stat.SaveAggregate(&stats_[stat.categories_.c_str()][stat.name_.c_str()]);
+    if (stat.request_id_ != 0) {
+      StatData& data = requests_[Profiler::Get()->RequestName(stat.request_id_)];
+      stat.SaveAggregate(&data);
+      if (data.type_ == StatData::kDuration) {
+        data.first_start_ = std::min(data.first_start_, stat.items_[0].timestamp_);
+        data.last_end_ = std::max(data.last_end_, stat.items_[1].timestamp_);
+      }
+    }
   }
 }
 
+void AggregateStats::OnOperatorCost(const std::string& name, double flops, double bytes) {
+  std::unique_lock<std::mutex> lk(m_);
+  StatData& data = stats_["operator"][name];
+  data.flops_ += flops;
+  data.bytes_ += bytes;
+  ++data.cost_count_;
+}
+
+void AggregateStats::OnOperatorElements(const std::string& name, double elements) {
+  std::unique_lock<std::mutex> lk(m_);
+  StatData& data = stats_["operator"][name];
+  data.elements_ += elements;
+  ++data.elements_count_;
+}
+
 void AggregateStats::DumpTable(std::ostream& os, int sort_by, int ascending) {
   std::ios state(nullptr);
   state.copyfmt(os);
@@ -163,10 +278,237 @@ void AggregateStats::DumpTable(std::ostream& os, int sort_by, int ascending) {
     }
     os << std::endl;
   }
+  DumpSchedulingTable(os, sort_by, ascending);
+  DumpThroughputTable(os, sort_by, ascending);
+  DumpEfficiencyTable(os, sort_by, ascending);
+  DumpCounterTable(os, sort_by, ascending);
+  DumpRequestTable(os);
   os << std::flush;
   os.copyfmt(state);
 }
 
+void AggregateStats::DumpSchedulingTable(std::ostream& os, int sort_by, int ascending) {
+  for (const auto& stat : stats_) {
+    const std::unordered_map<std::string, StatData>& mm = stat.second;
+    std::unordered_map<std::string, StatData> scheduled;
+    for (const auto& iter : mm) {
+      if (HasScheduling(iter.second)) scheduled.insert(iter);
+    }
+    if (scheduled.empty()) continue;
+    os << stat.first << " Scheduling" << std::endl << "=================" << std::endl;
+    os << std::setw(25) << std::left  << "Name"
+       << std::setw(16) << std::right << "Total Count"
+       << " " << std::setw(16) << std::right << "Avg Dep (ms)"
+       << " " << std::setw(16) << std::right << "Avg Queue (ms)"
+       << " " << std::setw(16) << std::right << "P99 Queue (ms)"
+       << " " << std::setw(16) << std::right << "P50 Exec (ms)"
+       << " " << std::setw(16) << std::right << "P99 Exec (ms)"
+       << std::endl;
+    os << std::setw(25) << std::left  << "----"
+       << std::setw(16) << std::right << "-----------";
+    for (int i = 0; i < 5; ++i) {
+      os << " " << std::setw(16) << std::right << "-------------";
+    }
+    os << std::endl;
+    auto heap = BuildHeap(scheduled, sort_by, ascending);
+    while (!heap.empty()) {
+      const std::string& name = heap.top().second;
+      const StatData &data = scheduled.at(name);
+      os << std::setw(25) << std::left << name
+         << std::setw(16) << std::right << data.exec_time_.count_
+         << std::fixed << std::setprecision(4) << std::right
+         << " " << std::setw(16) << MicroToMilli(
+             static_cast<double>(data.dependency_wait_.total_) / data.dependency_wait_.count_)
+         << " " << std::setw(16) << MicroToMilli(
+             static_cast<double>(data.queue_delay_.total_) / data.queue_delay_.count_)
+         << " " << std::setw(16) << MicroToMilli(data.queue_delay_.Percentile(0.99))
+         << " " << std::setw(16) << MicroToMilli(data.exec_time_.Percentile(0.5))
+         << " " << std::setw(16) << MicroToMilli(data.exec_time_.Percentile(0.99))
+         << std::endl;
+      heap.pop();
+    }
+    os << std::endl;
+  }
+}
+
+void AggregateStats::DumpThroughputTable(std::ostream& os, int sort_by, int ascending) {
+  for (const auto& stat : stats_) {
+    const std::unordered_map<std::string, StatData>& mm = stat.second;
+    std::unordered_map<std::string, StatData> counted;
+    for (const auto& iter : mm) {
+      if (HasSamples(iter.second)) counted.insert(iter);
+    }
+    if (counted.empty()) continue;
+    os << stat.first << " Throughput" << std::endl << "=================" << std::endl
+       << "\tThe time of a stage run by several threads is summed over the threads."
+       << std::endl;
+    os << std::setw(25) << std::left  << "Name"
+       << std::setw(16) << std::right << "Total Count"
+       << " " << std::setw(16) << std::right << "Samples"
+       << " " << std::setw(16) << std::right << "Time (ms)"
+       << " " << std::setw(16) << std::right << "Samples/s"
+       << std::endl;
+    os << std::setw(25) << std::left  << "----"
+       << std::setw(16) << std::right << "-----------";
+    for (int i = 0; i < 3; ++i) {
+      os << " " << std::setw(16) << std::right << "-------------";
+    }
+    os << std::endl;
+    auto heap = BuildHeap(counted, sort_by, ascending);
+    while (!heap.empty()) {
+      const std::string& name = heap.top().second;
+      const StatData &data = counted.at(name);
+      os << std::setw(25) << std::left << name
+         << std::setw(16) << std::right << data.total_count_
+         << " " << std::setw(16) << data.samples_
+         << std::fixed << std::setprecision(4) << std::right
+         << " " << std::setw(16) << MicroToMilli(data.total_aggregate_)
+         << " " << std::setw(16) << std::setprecision(1) << SamplesPerSecond(data)
+         << std::endl;
+      heap.pop();
+    }
+    os << std::endl;
+  }
+}
+
+void AggregateStats::DumpEfficiencyTable(std::ostream& os, int sort_by, int ascending) {
+  for (const auto& stat : stats_) {
+    const std::unordered_map<std::string, StatData>& mm = stat.second;
+    std::unordered_map<std::string, StatData> costed;
+    for (const auto& iter : mm) {
+      if (HasCost(iter.second)) costed.insert(iter);
+    }
+    if (costed.empty()) continue;
+    os << stat.first << " Efficiency" << std::endl << "=================" << std::endl
+       << "\tFrom the FLOPs and the bytes of the inputs and outputs estimated by FComputeCost."
+       << std::endl;
+    os << std::setw(25) << std::left  << "Name"
+       << std::setw(16) << std::right << "Total Count"
+       << " " << std::setw(16) << std::right << "Avg GFLOP"
+       << " " << std::setw(16) << std::right << "Avg MB"
+       << " " << std::setw(16) << std::right << "GFLOP/s"
+       << " " << std::setw(16) << std::right << "GB/s"
+       << std::endl;
+    os << std::setw(25) << std::left  << "----"
+       << std::setw(16) << std::right << "-----------";
+    for (int i = 0; i < 4; ++i) {
+      os << " " << std::setw(16) << std::right << "-------------";
+    }
+    os << std::endl;
+    auto heap = BuildHeap(costed, sort_by, ascending);
+    while (!heap.empty()) {
+      const std::string& name = heap.top().second;
+      const StatData &data = costed.at(name);
+      os << std::setw(25) << std::left << name
+         << std::setw(16) << std::right << data.total_count_
+         << std::fixed << std::setprecision(4) << std::right
+         << " " << std::setw(16) << data.flops_ / data.cost_count_ * 1e-9
+         << " " << std::setw(16) << data.bytes_ / data.cost_count_ * 1e-6
+         << " " << std::setw(16) << GflopsPerSecond(data)
+         << " " << std::setw(16) << GigabytesPerSecond(data)
+         << std::endl;
+      heap.pop();
+    }
+    os << std::endl;
+  }
+}
+
+void AggregateStats::DumpCounterTable(std::ostream& os, int sort_by, int ascending) {
+  for (const auto& stat : stats_) {
+    const std::unordered_map<std::string, StatData>& mm = stat.second;
+    std::unordered_map<std::string, StatData> counted;
+    for (const auto& iter : mm) {
+      if (HasCounters(iter.second)) counted.insert(iter);
+    }
+    if (counted.empty()) continue;
+    os << stat.first << " Counters" << std::endl << "=================" << std::endl
+       << "\tFrom the perf_event counters of the CPU runs, of the last level cache for the"
+       << " misses. Low IPC and many misses per element mark memory bound operators."
+       << std::endl;
+    os << std::setw(25) << std::left  << "Name"
+       << std::setw(16) << std::right << "Counted"
+       << " " << std::setw(16) << std::right << "IPC"
+       << " " << std::setw(16) << std::right << "Cycles/Elem"
+       << " " << std::setw(16) << std::right << "Misses/Elem"
+       << " " << std::setw(16) << std::right << "Miss Rate"
+       << " " << std::setw(16) << std::right << "Miss GB/s"
+       << std::endl;
+    os << std::setw(25) << std::left  << "----"
+       << std::setw(16) << std::right << "-----------";
+    for (int i = 0; i < 5; ++i) {
+      os << " " << std::setw(16) << std::right << "-------------";
+    }
+    os << std::endl;
+    auto heap = BuildHeap(counted, sort_by, ascending);
+    while (!heap.empty()) {
+      const std::string& name = heap.top().second;
+      const StatData &data = counted.at(name);
+      const uint64_t references = data.counters_[perf::kCacheReferences];
+      os << std::setw(25) << std::left << name
+         << std::setw(16) << std::right << data.counted_
+         << std::fixed << std::setprecision(4) << std::right
+         << " " << std::setw(16) << InstructionsPerCycle(data);
+      for (const perf::Counter counter : {perf::kCycles, perf::kCacheMisses}) {
+        const double per_element = PerElement(data, counter);
+        os << " " << std::setw(16);
+        if (per_element < 0) {
+          os << "-";
+        } else {
+          os << per_element;
+        }
+      }
+      os << " " << std::setw(16) << (references ? static_cast<double>(
+             data.counters_[perf::kCacheMisses]) / references : 0.0)
+         << " " << std::setw(16) << MissGigabytesPerSecond(data)
+         << std::endl;
+      heap.pop();
+    }
+    os << std::endl;
+  }
+}
+
+void AggregateStats::DumpRequestTable(std::ostream& os) {
+  /*! \brief number of requests listed */
+  static constexpr size_t kRequestRows = 20;
+  std::vector<std::pair<uint64_t, std::string>> requests;
+  for (const auto& iter : requests_) {
+    if (iter.second.type_ == StatData::kDuration) {
+      requests.emplace_back(iter.second.total_aggregate_, iter.first);
+    }
+  }
+  if (requests.empty()) return;
+  std::sort(requests.begin(), requests.end(), std::greater<std::pair<uint64_t, std::string>>());
+  const size_t n = requests.size();
+  os << "Requests" << std::endl << "=================" << std::endl
+     << "\t" << n << " requests, operator time P50 "
+     << MicroToMilli(requests[n / 2].first) << " ms, P99 "
+     << MicroToMilli(requests[n / 100].first) << " ms, Max "
+     << MicroToMilli(requests[0].first) << " ms" << std::endl;
+  os << std::setw(25) << std::left  << "Name"
+     << std::setw(16) << std::right << "Operator Count"
+     << " " << std::setw(16) << std::right << "Operator (ms)"
+     << " " << std::setw(16) << std::right << "Span (ms)"
+     << " " << std::setw(16) << std::right << "Max Op (ms)"
+     << std::endl;
+  os << std::setw(25) << std::left  << "----"
+     << std::setw(16) << std::right << "--------------";
+  for (int i = 0; i < 3; ++i) {
+    os << " " << std::setw(16) << std::right << "-------------";
+  }
+  os << std::endl;
+  for (size_t i = 0; i < std::min(n, kRequestRows); ++i) {
+    const StatData& data = requests_.at(requests[i].second);
+    os << std::setw(25) << std::left << requests[i].second
+       << std::setw(16) << std::right << data.total_count_
+       << std::fixed << std::setprecision(4) << std::right
+       << " " << std::setw(16) << MicroToMilli(data.total_aggregate_)
+       << " " << std::setw(16) << MicroToMilli(data.last_end_ - data.first_start_)
+       << " " << std::setw(16) << MicroToMilli(data.max_aggregate_)
+       << std::endl;
+  }
+  os << std::endl;
+}
+
 void AggregateStats::DumpJson(std::ostream& os, int sort_by, int ascending) {
   std::ios state(nullptr);
   state.copyfmt(os);
@@ -196,6 +538,29 @@ void AggregateStats::DumpJson(std::ostream& os, int sort_by, int ascending) {
             << "                \"Count\": "
             << data.total_count_
             << "," << std::endl;
+        if (HasSamples(data)) {
+          *ss << "                \"Samples\": " << data.samples_ << "," << std::endl
+              << "                \"Samples/s\": " << std::setprecision(6)
+              << SamplesPerSecond(data) << "," << std::endl;
+        }
+        if (HasCost(data)) {
+          *ss << "                \"GFLOP/s\": " << std::setprecision(6)
+              << GflopsPerSecond(data) << "," << std::endl
+              << "                \"GB/s\": " << std::setprecision(6)
+              << GigabytesPerSecond(data) << "," << std::endl;
+        }
+        if (HasCounters(data)) {
+          *ss << "                \"IPC\": " << std::setprecision(4)
+              << InstructionsPerCycle(data) << "," << std::endl;
+          if (data.elements_ != 0) {
+            *ss << "                \"Cycles/Element\": " << std::setprecision(6)
+                << PerElement(data, perf::kCycles) << "," << std::endl
+                << "                \"Misses/Element\": " << std::setprecision(6)
+                << PerElement(data, perf::kCacheMisses) << "," << std::endl;
+          }
+          *ss << "                \"Miss GB/s\": " << std::setprecision(6)
+              << MissGigabytesPerSecond(data) << "," << std::endl;
+        }
         if (!is_memory)
           *ss << "                \"Total\": "
               << std::setprecision(4)
@@ -218,8 +583,14 @@ void AggregateStats::DumpJson(std::ostream& os, int sort_by, int ascending) {
             << (data.type_ == AggregateStats::StatData::kCounter ?
                  ByteToKilobyte((data.max_aggregate_ - data.min_aggregate_) / 2) :
                  MicroToMilli(static_cast<double>(data.total_aggregate_) /  data.total_count_))
-            << std::endl
-            << "            }" << std::endl;
+            << (HasScheduling(data) ? "," : "")
+            << std::endl;
+        if (HasScheduling(data)) {
+          DumpHistogramJson(*ss, "Dependency Wait", data.dependency_wait_, false);
+          DumpHistogramJson(*ss, "Queue Delay", data.queue_delay_, false);
+          DumpHistogramJson(*ss, "Execution", data.exec_time_, true);
+        }
+        *ss << "            }" << std::endl;
       }
       heap.pop();
     }
@@ -232,6 +603,26 @@ void AggregateStats::DumpJson(std::ostream& os, int sort_by, int ascending) {
      << "    ," << std::endl
      << "    \"Memory\": {" << std::endl
      << memory_ss.str()
+     << "    }" << std::endl
+     << "," << std::endl
+     << "    \"Requests\": {" << std::endl;
+  bool first_request = true;
+  for (const auto& iter : requests_) {
+    const StatData& data = iter.second;
+    if (data.type_ != StatData::kDuration) continue;
+    os << (first_request ? "" : ",\n")
+       << "        \"" << iter.first << "\": {" << std::endl
+       << "            \"Count\": " << data.total_count_ << "," << std::endl
+       << "            \"Operator Time\": " << std::setprecision(4)
+       << MicroToMilli(data.total_aggregate_) << "," << std::endl
+       << "            \"Span\": " << std::setprecision(4)
+       << MicroToMilli(data.last_end_ - data.first_start_) << "," << std::endl
+       << "            \"Max\": " << std::setprecision(4)
+       << MicroToMilli(data.max_aggregate_) << std::endl
+       << "        }";
+    first_request = false;
+  }
+  os << std::endl
      << "    }" << std::endl
      << "," << std::endl
      << "    \"Unit\": {" << std::endl
@@ -246,6 +637,7 @@ void AggregateStats::DumpJson(std::ostream& os, int sort_by, int ascending) {
 void AggregateStats::clear() {
   std::unique_lock<std::mutex> lk(m_);
   stats_.clear();
+  requests_.clear();
 }
 
 }  // namespace profiler
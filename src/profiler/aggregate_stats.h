@@ -20,11 +20,13 @@
 #ifndef MXNET_PROFILER_AGGREGATE_STATS_H_
 #define MXNET_PROFILER_AGGREGATE_STATS_H_
 
+#include <array>
 #include <string>
 #include <map>
 #include <cstdint>
 #include <ostream>
 #include <mutex>
+#include "./perf_counters.h"
 #include "./profiler.h"
 
 namespace mxnet {
@@ -34,6 +36,52 @@ struct ProfileStat;
 
 class AggregateStats {
  public:
+  /*!
+   * \brief Log2 histogram of durations in microseconds.
+   *  Bucket 0 holds durations under 1 us, bucket k durations in [2^(k-1), 2^k) us
+   *  and the last bucket everything longer.
+   */
+  struct Histogram {
+    static constexpr int kNumBuckets = 24;
+
+    size_t    count_ = 0;
+    uint64_t  total_ = 0;
+    uint64_t  max_ = 0;
+    std::array<uint64_t, kNumBuckets> buckets_{};
+
+    /*! \brief record one duration */
+    void Add(uint64_t duration) {
+      int bucket = 0;
+      while (bucket < kNumBuckets - 1 && (duration >> bucket) != 0) ++bucket;
+      ++buckets_[bucket];
+      ++count_;
+      total_ += duration;
+      if (duration > max_) max_ = duration;
+    }
+    /*! \return exclusive upper bound of a bucket in microseconds, 0 for the last one */
+    static uint64_t UpperBound(int bucket) {
+      return bucket < kNumBuckets - 1 ? (1ULL << bucket) : 0;
+    }
+    /*!
+     * \brief Estimate a percentile as the upper bound of the bucket it falls in.
+     * \param q the percentile, in [0, 1].
+     * \return the estimate in microseconds, never above the maximum seen.
+     */
+    uint64_t Percentile(double q) const {
+      if (count_ == 0) return 0;
+      const double rank = q * static_cast<double>(count_);
+      size_t seen = 0;
+      for (int i = 0; i < kNumBuckets; ++i) {
+        seen += buckets_[i];
+        if (buckets_[i] != 0 && static_cast<double>(seen) >= rank) {
+          const uint64_t bound = UpperBound(i);
+          return bound != 0 && bound < max_ ? bound : max_;
+        }
+      }
+      return max_;
+    }
+  };
+
   struct StatData {
     /*!
      * \brief Types that the console printer knows how to format
@@ -49,6 +97,36 @@ class AggregateStats {
     uint64_t  total_aggregate_ = 0;
     uint64_t  max_aggregate_ = 0;
     uint64_t  min_aggregate_ = INT_MAX;
+    /*!
+     * \brief Engine scheduling of operators, only filled for operators run by a
+     *  threaded engine: time from push until the dependencies are satisfied, time
+     *  spent in the worker queue and execution time.
+     */
+    Histogram dependency_wait_;
+    Histogram queue_delay_;
+    Histogram exec_time_;
+    /*! \brief Number of samples processed, only filled for stages of the data pipeline */
+    size_t    samples_ = 0;
+    /*!
+     * \brief Estimated floating point operations and bytes read and written, and the
+     *  number of runs they were estimated for, only filled for operators registering
+     *  FComputeCost
+     */
+    double    flops_ = 0;
+    double    bytes_ = 0;
+    size_t    cost_count_ = 0;
+    /*!
+     * \brief Hardware counters summed over the runs counted, and the number of these runs,
+     *  only filled for CPU operators with MXNET_PROFILER_PERF_EVENTS
+     */
+    std::array<uint64_t, perf::kNumCounters> counters_{};
+    size_t    counted_ = 0;
+    /*! \brief Elements of the outputs, and the number of runs they were recorded for */
+    double    elements_ = 0;
+    size_t    elements_count_ = 0;
+    /*! \brief Start of the first and end of the last operator, only filled for requests */
+    uint64_t  first_start_ = UINT64_MAX;
+    uint64_t  last_end_ = 0;
   };
 
   /*!
@@ -56,6 +134,19 @@ class AggregateStats {
    * \param stat SIngle profile statistics to add to the accumulates statistics
    */
   void OnProfileStat(const ProfileStat& stat);
+  /*!
+   * \brief Record the estimated cost of a run of an operator
+   * \param name Name of the operator
+   * \param flops Floating point operations of the run
+   * \param bytes Bytes of the inputs and outputs of the run
+   */
+  void OnOperatorCost(const std::string& name, double flops, double bytes);
+  /*!
+   * \brief Record the number of output elements of a run of an operator, for its counters
+   * \param name Name of the operator
+   * \param elements Elements of the outputs of the run
+   */
+  void OnOperatorElements(const std::string& name, double elements);
   /*!
    * \brief Print profliing statistics to console in a tabular format
    * \param sort_by by which stat to sort the entries, can be "avg", "min", "max", or "count"
@@ -78,10 +169,37 @@ class AggregateStats {
   };
 
  private:
+  /*!
+   * \brief Print the engine scheduling statistics of the entries that have them,
+   *  one table per category. The caller must hold m_.
+   */
+  void DumpSchedulingTable(std::ostream& os, int sort_by, int ascending);
+  /*!
+   * \brief Print the throughput of the entries that count samples, i.e. the stages of the
+   *  data pipeline. The caller must hold m_.
+   */
+  void DumpThroughputTable(std::ostream& os, int sort_by, int ascending);
+  /*!
+   * \brief Print the achieved GFLOP/s and GB/s of the operators with an estimated cost.
+   *  The caller must hold m_.
+   */
+  void DumpEfficiencyTable(std::ostream& os, int sort_by, int ascending);
+  /*!
+   * \brief Print the hardware counters of the operators counted with perf_event. The caller
+   *  must hold m_.
+   */
+  void DumpCounterTable(std::ostream& os, int sort_by, int ascending);
+  /*!
+   * \brief Print the distribution of the operator time of the requests, and the requests
+   *  with the most operator time. The caller must hold m_.
+   */
+  void DumpRequestTable(std::ostream& os);
   /*! \brief Should rarely collide, so most locks should occur only in user-space (futex) */
   std::mutex m_;
   /* !\brief Stat type -> State name -> Stats */
   std::map<std::string, std::unordered_map<std::string, StatData>> stats_;
+  /* !\brief Request name -> Stats of its operators */
+  std::unordered_map<std::string, StatData> requests_;
 };
 
 }  // namespace profiler
@@ -0,0 +1,367 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file cupti_activity.cc
+ * \brief device timing of the GPU operators from the CUPTI activity records
+ */
+#include "./cupti_activity.h"
+
+#if MXNET_USE_CUPTI
+
+#include <cuda_runtime.h>
+#include <cupti.h>
+#include <dmlc/logging.h>
+#include <dmlc/parameter.h>
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "./profiler.h"
+
+namespace mxnet {
+namespace profiler {
+namespace cupti {
+
+/*!
+ * \brief Device activity (kernel or copy) of an operator, recorded by CUPTI
+ */
+struct DeviceActivityStat : public ProfileOperator::OprExecStat {
+  /*!
+   * \brief Constructor
+   * \param name Name of the operator
+   * \param category "gpu kernel" or "gpu memcpy"
+   * \param dev_id GPU of the activity
+   * \param start_time Device start time, in profiler time
+   * \param stop_time Device end time, in profiler time
+   * \param stream CUDA stream of the activity
+   */
+  DeviceActivityStat(const char *name, const char *category, uint32_t dev_id,
+                     uint64_t start_time, uint64_t stop_time, uint32_t stream)
+    : OprExecStat(name, Context::kGPU, dev_id, start_time, stop_time, nullptr)
+      , stream_(stream) {
+    categories_.set(category);
+    // the activities of the streams overlap, they are async events per stream
+    items_[kStart].event_type_ = kAsyncNestableStart;
+    items_[kStop].event_type_ = kAsyncNestableEnd;
+  }
+
+  void EmitExtra(std::ostream *os, size_t idx) override {
+    ProfileStat::EmitExtra(os, idx);
+    *os << "        \"id\": " << stream_ << ",\n";
+    if (idx == kStart) {
+      *os << "        \"args\": { \"stream\": " << stream_;
+      if (kernel_.c_str()[0] != '\0') {
+        *os << ", \"kernel\": \"" << kernel_.c_str() << "\", \"occupancy\": " << occupancy_;
+      } else {
+        *os << ", \"bytes\": " << bytes_;
+      }
+      *os << " },\n";
+    }
+  }
+
+  /*! \brief CUDA stream */
+  uint32_t stream_;
+  /*! \brief Kernel name, empty for a copy */
+  profile_stat_string kernel_;
+  /*! \brief Theoretical occupancy of the kernel */
+  float occupancy_{0};
+  /*! \brief Bytes of the copy */
+  uint64_t bytes_{0};
+};
+
+}  // namespace cupti
+
+/*!
+ * \brief The device activities go to the queue of their GPU, as the operators
+ */
+template<>
+inline void Profiler::AddProfileStat<cupti::DeviceActivityStat>(
+  std::unique_ptr<cupti::DeviceActivityStat> *stat) {
+  std::unique_ptr<ProfileOperator::OprExecStat> opr_stat(stat->release());
+  AddProfileStat(&opr_stat);
+}
+
+namespace cupti {
+
+#define CUPTI_CALL(func)                                              \
+  {                                                                   \
+    CUptiResult e = (func);                                           \
+    if (e != CUPTI_SUCCESS) {                                         \
+      const char *errstr;                                             \
+      cuptiGetResultString(e, &errstr);                               \
+      LOG(WARNING) << "CUPTI: " #func " failed with " << errstr;      \
+    }                                                                 \
+  }
+
+/*! \brief Limits of a GPU for the occupancy of its kernels */
+struct DeviceLimits {
+  int warp_size;
+  int max_threads_per_sm;
+  int max_blocks_per_sm;
+  int regs_per_sm;
+  size_t smem_per_sm;
+};
+
+/*! \brief A kernel or a copy waiting for the operator of its launch */
+struct Activity {
+  bool kernel;
+  uint32_t correlation;
+  uint32_t dev_id;
+  uint32_t stream;
+  uint64_t start, end;
+  std::string kernel_name;
+  float occupancy;
+  uint64_t bytes;
+  /*! \brief Number of flushes the activity waited for its operator */
+  int age;
+};
+
+class ActivityCollector {
+ public:
+  static ActivityCollector *Get() {
+    static ActivityCollector inst;
+    return &inst;
+  }
+
+  void Start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_ || !dmlc::GetEnv("MXNET_PROFILER_CUPTI", false)) return;
+    CUPTI_CALL(cuptiActivityRegisterCallbacks(BufferRequested, BufferCompleted));
+    CUPTI_CALL(cuptiActivityEnable(CUPTI_ACTIVITY_KIND_CONCURRENT_KERNEL));
+    CUPTI_CALL(cuptiActivityEnable(CUPTI_ACTIVITY_KIND_MEMCPY));
+    CUPTI_CALL(cuptiActivityEnable(CUPTI_ACTIVITY_KIND_EXTERNAL_CORRELATION));
+    uint64_t now = 0;
+    CUPTI_CALL(cuptiGetTimestamp(&now));
+    clock_offset_ = static_cast<int64_t>(ProfileStat::NowInMicrosec() * 1000) -
+                    static_cast<int64_t>(now);
+    running_ = true;
+  }
+
+  void Stop() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!running_) return;
+      running_ = false;
+      CUPTI_CALL(cuptiActivityDisable(CUPTI_ACTIVITY_KIND_CONCURRENT_KERNEL));
+      CUPTI_CALL(cuptiActivityDisable(CUPTI_ACTIVITY_KIND_MEMCPY));
+      CUPTI_CALL(cuptiActivityDisable(CUPTI_ACTIVITY_KIND_EXTERNAL_CORRELATION));
+    }
+    CUPTI_CALL(cuptiActivityFlushAll(0));
+  }
+
+  void Flush() {
+    if (!running_) return;
+    // the completed buffers are handed to BufferCompleted on this thread
+    CUPTI_CALL(cuptiActivityFlushAll(0));
+    std::lock_guard<std::mutex> lock(mutex_);
+    Resolve(true);
+  }
+
+  bool PushOperator(const char *name, uint32_t dev_id) {
+    if (!running_) return false;
+    uint64_t id;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = name_ids_.find(name);
+      if (it == name_ids_.end()) {
+        it = name_ids_.emplace(name, names_.size()).first;
+        names_.emplace_back(name);
+      }
+      id = it->second;
+      if (limits_.size() <= dev_id) limits_.resize(dev_id + 1);
+      if (limits_[dev_id].warp_size == 0) {
+        // queried here, CUDA must not be called from the CUPTI callbacks
+        cudaDeviceProp prop;
+        if (cudaGetDeviceProperties(&prop, dev_id) == cudaSuccess) {
+          limits_[dev_id].warp_size = prop.warpSize;
+          limits_[dev_id].max_threads_per_sm = prop.maxThreadsPerMultiProcessor;
+#if CUDA_VERSION >= 11000
+          limits_[dev_id].max_blocks_per_sm = prop.maxBlocksPerMultiProcessor;
+#else
+          limits_[dev_id].max_blocks_per_sm = 32;
+#endif
+          limits_[dev_id].regs_per_sm = prop.regsPerMultiprocessor;
+          limits_[dev_id].smem_per_sm = prop.sharedMemPerMultiprocessor;
+        }
+      }
+    }
+    // an operator completing on another thread left its id on this one
+    PopOperator();
+    CUPTI_CALL(cuptiActivityPushExternalCorrelationId(CUPTI_EXTERNAL_CORRELATION_KIND_CUSTOM0,
+                                                      id));
+    pushed_ = true;
+    return true;
+  }
+
+  void PopOperator() {
+    if (!pushed_) return;
+    uint64_t id;
+    CUPTI_CALL(cuptiActivityPopExternalCorrelationId(CUPTI_EXTERNAL_CORRELATION_KIND_CUSTOM0,
+                                                     &id));
+    pushed_ = false;
+  }
+
+ private:
+  /*! \brief Size of the activity buffers */
+  static constexpr size_t kBufferSize = 8UL << 20UL;
+  /*! \brief Number of flushes an activity waits for its operator before it is dropped */
+  static constexpr int kMaxAge = 2;
+
+  static void CUPTIAPI BufferRequested(uint8_t **buffer, size_t *size,
+                                       size_t *max_num_records) {
+    // new[] is aligned enough for the records
+    *buffer = new uint8_t[kBufferSize];
+    *size = kBufferSize;
+    *max_num_records = 0;
+  }
+
+  static void CUPTIAPI BufferCompleted(CUcontext ctx, uint32_t stream_id, uint8_t *buffer,
+                                       size_t size, size_t valid_size) {
+    Get()->Parse(buffer, valid_size);
+    delete[] buffer;
+  }
+
+  /*! \brief Theoretical occupancy of a kernel, ignoring the allocation granularities */
+  float Occupancy(uint32_t dev_id, int threads, int regs, size_t smem) const {
+    if (dev_id >= limits_.size() || limits_[dev_id].warp_size == 0 || threads <= 0) {
+      return 0;
+    }
+    const DeviceLimits &d = limits_[dev_id];
+    const int block_threads = (threads + d.warp_size - 1) / d.warp_size * d.warp_size;
+    int blocks = std::min(d.max_threads_per_sm / block_threads, d.max_blocks_per_sm);
+    if (regs > 0) {
+      blocks = std::min(blocks, d.regs_per_sm / (regs * block_threads));
+    }
+    if (smem > 0) {
+      blocks = std::min(blocks, static_cast<int>(d.smem_per_sm / smem));
+    }
+    return static_cast<float>(blocks * block_threads) / d.max_threads_per_sm;
+  }
+
+  void Parse(uint8_t *buffer, size_t valid_size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    CUpti_Activity *record = nullptr;
+    while (cuptiActivityGetNextRecord(buffer, valid_size, &record) == CUPTI_SUCCESS) {
+      switch (record->kind) {
+        case CUPTI_ACTIVITY_KIND_EXTERNAL_CORRELATION: {
+          auto *r = reinterpret_cast<CUpti_ActivityExternalCorrelation *>(record);
+          if (r->externalKind == CUPTI_EXTERNAL_CORRELATION_KIND_CUSTOM0) {
+            operators_[r->correlationId] = r->externalId;
+          }
+          break;
+        }
+        case CUPTI_ACTIVITY_KIND_CONCURRENT_KERNEL: {
+          auto *r = reinterpret_cast<CUpti_ActivityKernel4 *>(record);
+          const int threads = r->blockX * r->blockY * r->blockZ;
+          pending_.push_back({true, r->correlationId, r->deviceId, r->streamId, r->start, r->end,
+                              r->name ? r->name : "", Occupancy(r->deviceId, threads, r->registersPerThread,
+                                                 r->staticSharedMemory + r->dynamicSharedMemory),
+                              0, 0});
+          break;
+        }
+        case CUPTI_ACTIVITY_KIND_MEMCPY: {
+          auto *r = reinterpret_cast<CUpti_ActivityMemcpy *>(record);
+          pending_.push_back({false, r->correlationId, r->deviceId, r->streamId, r->start,
+                              r->end, std::string(), 0, r->bytes, 0});
+          break;
+        }
+        default:
+          break;
+      }
+    }
+    Resolve(false);
+  }
+
+  /*!
+   * \brief add the activities whose operator is known to the profiler
+   * \param flush whether the activities left wait one more flush
+   */
+  void Resolve(bool flush) {
+    Profiler *profiler = Profiler::Get();
+    size_t kept = 0;
+    for (Activity &activity : pending_) {
+      auto it = operators_.find(activity.correlation);
+      if (it == operators_.end()) {
+        // the kernels launched outside of the operators never get one
+        if (!flush || ++activity.age <= kMaxAge) {
+          pending_[kept++] = std::move(activity);
+        }
+        continue;
+      }
+      const uint64_t start = (activity.start + clock_offset_) / 1000;
+      const uint64_t end = std::max(start, (activity.end + clock_offset_) / 1000);
+      profiler->AddNewProfileStat<DeviceActivityStat>([&activity](DeviceActivityStat *stat) {
+        stat->kernel_.set(activity.kernel_name.c_str());
+        stat->occupancy_ = activity.occupancy;
+        stat->bytes_ = activity.bytes;
+      }, names_[it->second].c_str(), activity.kernel ? "gpu kernel" : "gpu memcpy",
+         activity.dev_id, start, end, activity.stream);
+      // a launch has one activity
+      operators_.erase(it);
+    }
+    pending_.resize(kept);
+  }
+
+  /*! \brief Whether the calling thread has an operator id pushed */
+  static thread_local bool pushed_;
+  std::mutex mutex_;
+  volatile bool running_ = false;
+  /*! \brief Profiler time minus CUPTI time, in ns */
+  int64_t clock_offset_ = 0;
+  /*! \brief Operator names, their index being the external correlation id */
+  std::vector<std::string> names_;
+  std::unordered_map<std::string, uint64_t> name_ids_;
+  /*! \brief Operator of the launches, by CUPTI correlation id */
+  std::unordered_map<uint32_t, uint64_t> operators_;
+  /*! \brief Activities waiting for the operator of their launch */
+  std::vector<Activity> pending_;
+  /*! \brief Limits of the GPUs, by device id */
+  std::vector<DeviceLimits> limits_;
+};
+
+thread_local bool ActivityCollector::pushed_ = false;
+
+void Start() {
+  ActivityCollector::Get()->Start();
+}
+
+void Stop() {
+  ActivityCollector::Get()->Stop();
+}
+
+void Flush() {
+  ActivityCollector::Get()->Flush();
+}
+
+bool PushOperator(const char *name, uint32_t dev_id) {
+  return ActivityCollector::Get()->PushOperator(name, dev_id);
+}
+
+void PopOperator() {
+  ActivityCollector::Get()->PopOperator();
+}
+
+}  // namespace cupti
+}  // namespace profiler
+}  // namespace mxnet
+
+#endif  // MXNET_USE_CUPTI
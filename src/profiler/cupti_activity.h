@@ -0,0 +1,74 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file cupti_activity.h
+ * \brief device timing of the GPU operators from the CUPTI activity records
+ *
+ *  The kernels and copies launched while a GPU operator runs are tagged with the operator
+ *  through a CUPTI external correlation id. Their activity records, with the device start
+ *  and end times, become statistics of the operator on its GPU, in the "gpu kernel" and
+ *  "gpu memcpy" categories, so the trace shows when the device ran the operator and the
+ *  aggregate stats its device time.
+ */
+#ifndef MXNET_PROFILER_CUPTI_ACTIVITY_H_
+#define MXNET_PROFILER_CUPTI_ACTIVITY_H_
+
+#if MXNET_USE_CUPTI
+
+#include <cstdint>
+
+namespace mxnet {
+namespace profiler {
+namespace cupti {
+
+/*!
+ * \brief start recording the kernels and copies, if MXNET_PROFILER_CUPTI is set
+ * \note does nothing if already recording
+ */
+void Start();
+
+/*! \brief stop recording, the completed records are added to the profiler */
+void Stop();
+
+/*! \brief add the completed records to the profiler, before a dump */
+void Flush();
+
+/*!
+ * \brief tag the kernels and copies launched by the calling thread with an operator,
+ *  until PopOperator
+ * \param name name of the operator
+ * \param dev_id GPU of the operator
+ * \return whether recording, in which case PopOperator must be called
+ */
+bool PushOperator(const char *name, uint32_t dev_id);
+
+/*!
+ * \brief stop tagging the kernels and copies of the calling thread
+ * \note must be called on the thread of PushOperator, an operator left pushed is popped
+ *  by the next PushOperator of its thread
+ */
+void PopOperator();
+
+}  // namespace cupti
+}  // namespace profiler
+}  // namespace mxnet
+
+#endif  // MXNET_USE_CUPTI
+#endif  // MXNET_PROFILER_CUPTI_ACTIVITY_H_
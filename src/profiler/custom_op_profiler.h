@@ -51,10 +51,12 @@ class CustomOpProfiler {
    * \brief Called before the callback of custom operators to start a profile task for python 
    * code execution time
    * \param op_type The registed name of the custom operator
+   * \param native Whether the callback is native code run inline on an engine worker
    */
-  void OnCustomBegin(const std::string& op_type) {
+  void OnCustomBegin(const std::string& op_type, bool native = false) {
     const Tid tid = std::this_thread::get_id();
-    const std::string task_name = MakePythonCodeName(op_type);
+    const std::string task_name = native ? MakeNativeCodeName(op_type) :
+                                           MakePythonCodeName(op_type);
     std::lock_guard<std::mutex> lock(mutex_);
     tid_to_op_type_[tid] = op_type;
     tasks_[tid] = std::make_unique<ProfileTask>(task_name.c_str(), &custom_op_domain);
@@ -108,6 +110,12 @@ class CustomOpProfiler {
   inline std::string MakePythonCodeName(const std::string& op_type) {
     return op_type + "::pure_python";
   }
+  /* !\brief make the display name for the callback of a custom operator registered
+   * with native code through MXCustomOpRegisterNative
+   */
+  inline std::string MakeNativeCodeName(const std::string& op_type) {
+    return op_type + "::native";
+  }
   /*! \brief class mutex */
   std::mutex mutex_;
   /* !\brief display names for sub-operators in custom ops */
@@ -0,0 +1,173 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file data_profiler.h
+ * \brief Profiling of the stages and queues of the data pipeline
+ */
+#ifndef MXNET_PROFILER_DATA_PROFILER_H_
+#define MXNET_PROFILER_DATA_PROFILER_H_
+
+#include <atomic>
+#include "./profiler.h"
+
+namespace mxnet {
+namespace profiler {
+
+/*! \brief category of the data pipeline statistics */
+constexpr const char *kDataPipelineCategory = "Data Pipeline";
+
+/*! \return the domain of the data pipeline counters */
+inline ProfileDomain *DataPipelineDomain() {
+  static ProfileDomain domain(kDataPipelineCategory);
+  return &domain;
+}
+
+/*! \return whether the data pipeline is profiled, i.e. whether the profiler runs */
+inline bool IsProfilingDataPipeline() {
+  return Profiler::Get()->GetState() == Profiler::kRunning;
+}
+
+/*!
+ * \brief Stage of the data pipeline, e.g. decoding images or batchifying samples.
+ *  Each duration records the number of samples processed in it, so that the aggregate
+ *  statistics report the throughput of the stage.
+ */
+class ProfileDataStage : public ProfileDuration {
+ public:
+  /*!
+   * \brief Constructor
+   * \param name Name of the stage
+   */
+  explicit ProfileDataStage(const char *name)
+    : name_(name) {}
+
+  /*! \brief Start timing the stage in the calling thread */
+  void start() override {
+    start_time_ = ProfileStat::NowInMicrosec();
+  }
+
+  /*! \brief Stop timing the stage in the calling thread */
+  void stop() override {
+    stop(0);
+  }
+
+  /*!
+   * \brief Stop timing the stage in the calling thread
+   * \param samples Number of samples processed since start()
+   */
+  void stop(size_t samples) {
+    Record(start_time_, ProfileStat::NowInMicrosec(), samples);
+  }
+
+  /*!
+   * \brief Record a duration of the stage, can be called by several threads at once.
+   *  A thread processing many samples one at a time may record its busy time
+   *  from start_time, instead of one duration per sample.
+   * \param start_time Start of the duration in microseconds
+   * \param stop_time Stop of the duration in microseconds
+   * \param samples Number of samples processed in the duration
+   */
+  void Record(uint64_t start_time, uint64_t stop_time, size_t samples) {
+    Profiler::Get()->AddNewProfileStat<ProfileDataStageStat>([](ProfileDataStageStat *stat) {
+      stat->categories_.set(kDataPipelineCategory);
+    }, name_.c_str(), start_time, stop_time, samples);
+  }
+
+  ProfileObjectType type() const override { return kEvent; }
+
+ protected:
+  /*!
+   * \brief Data stage statistic object
+   */
+  struct ProfileDataStageStat : public DurationStat {
+    /*! \brief number of samples processed */
+    size_t samples_;
+    ProfileDataStageStat(const char *name, uint64_t start_time, uint64_t stop_time,
+                         size_t samples)
+      : DurationStat(ProfileStat::kDurationBegin, ProfileStat::kDurationEnd)
+        , samples_(samples) {
+      name_.set(name);
+      items_[kStart].timestamp_ = start_time;
+      items_[kStop].timestamp_ = stop_time;
+    }
+
+    void EmitExtra(std::ostream *os, size_t idx) override {
+      DurationStat::EmitExtra(os, idx);
+      if (idx == kStart) {
+        *os << "        \"args\": { \"samples\": " << samples_ << " },\n";
+      }
+    }
+
+    void SaveAggregate(AggregateStats::StatData *data) const override {
+      DurationStat::SaveAggregate(data);
+      if (data) {
+        data->samples_ += samples_;
+      }
+    }
+  };
+
+ private:
+  /*! \brief Stage name */
+  const profile_stat_string name_;
+  /*! \brief Start time of the stage in the calling thread */
+  uint64_t start_time_ = 0;
+};
+
+/*!
+ * \brief Occupancy of a queue of the data pipeline, e.g. the batches prefetched ahead of
+ *  the consumer.
+ */
+class ProfileDataQueue {
+ public:
+  /*!
+   * \brief Constructor
+   * \param name Name of the queue
+   */
+  explicit ProfileDataQueue(const char *name)
+    : counter_(name, DataPipelineDomain()) {}
+
+  /*! \brief an item entered the queue */
+  void Push() {
+    const uint64_t size = ++size_;
+    if (IsProfilingDataPipeline()) counter_ = size;
+  }
+
+  /*! \brief an item left the queue */
+  void Pop() {
+    const uint64_t size = size_ > 0 ? --size_ : 0;
+    if (IsProfilingDataPipeline()) counter_ = size;
+  }
+
+  /*! \brief the queue was emptied */
+  void Clear() {
+    size_ = 0;
+    if (IsProfilingDataPipeline()) counter_ = 0;
+  }
+
+ private:
+  /*! \brief counter exported to the profiler */
+  ProfileCounter counter_;
+  /*! \brief current number of items, tracked even when not profiling */
+  std::atomic<uint64_t> size_{0};
+};
+
+}  // namespace profiler
+}  // namespace mxnet
+#endif  // MXNET_PROFILER_DATA_PROFILER_H_
@@ -0,0 +1,164 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file perf_counters.cc
+ * \brief hardware performance counters of the CPU operators from perf_event
+ */
+#include "./perf_counters.h"
+
+#include <dmlc/logging.h>
+#include <dmlc/parameter.h>
+#include <atomic>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+namespace mxnet {
+namespace profiler {
+namespace perf {
+
+namespace {
+
+std::atomic<bool> running{false};
+/*! \brief whether a thread failed to open its counters, warned about once */
+std::atomic<bool> warned{false};
+
+#if defined(__linux__)
+/*! \brief event of each counter */
+constexpr uint64_t kEvents[kNumCounters] = {
+  PERF_COUNT_HW_CPU_CYCLES,
+  PERF_COUNT_HW_INSTRUCTIONS,
+  PERF_COUNT_HW_CACHE_REFERENCES,
+  PERF_COUNT_HW_CACHE_MISSES
+};
+
+/*!
+ * \brief group of the counters of a thread, the cycles counter leading it, so that the
+ *  kernel schedules them together and they count the same instructions
+ */
+class ThreadCounters {
+ public:
+  ThreadCounters() {
+    fds_.fill(-1);
+  }
+
+  ~ThreadCounters() {
+    Close();
+  }
+
+  bool Read(Counters *counters) {
+    if (!opened_) Open();
+    if (fds_[0] < 0) return false;
+    struct {
+      uint64_t nr;
+      uint64_t time_enabled;
+      uint64_t time_running;
+      uint64_t values[kNumCounters];
+    } data;
+    if (read(fds_[0], &data, sizeof(data)) != static_cast<ssize_t>(sizeof(data)) ||
+        data.time_running == 0) {
+      return false;
+    }
+    const double scale = static_cast<double>(data.time_enabled) / data.time_running;
+    for (int i = 0; i < kNumCounters; ++i) {
+      counters->values[i] = static_cast<uint64_t>(data.values[i] * scale);
+    }
+    return true;
+  }
+
+ private:
+  void Open() {
+    opened_ = true;
+    for (int i = 0; i < kNumCounters; ++i) {
+      perf_event_attr attr;
+      memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = kEvents[i];
+      // user space only, allowed by the default perf_event_paranoid of 2
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                         PERF_FORMAT_TOTAL_TIME_RUNNING;
+      fds_[i] = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1,
+                                         i == 0 ? -1 : fds_[0], 0));
+      if (fds_[i] < 0) {
+        if (!warned.exchange(true)) {
+          LOG(WARNING) << "Cannot open the perf_event counters, the operators are not "
+                       << "counted: " << strerror(errno) << ". Counting may need a lower "
+                       << "/proc/sys/kernel/perf_event_paranoid or CAP_PERFMON";
+        }
+        Close();
+        return;
+      }
+    }
+  }
+
+  void Close() {
+    for (int &fd : fds_) {
+      if (fd >= 0) close(fd);
+      fd = -1;
+    }
+  }
+
+  std::array<int, kNumCounters> fds_;
+  bool opened_ = false;
+};
+#endif  // defined(__linux__)
+
+}  // namespace
+
+void Start() {
+  if (!dmlc::GetEnv("MXNET_PROFILER_PERF_EVENTS", false)) return;
+#if defined(__linux__)
+  running = true;
+#else
+  if (!warned.exchange(true)) {
+    LOG(WARNING) << "MXNET_PROFILER_PERF_EVENTS is only supported on Linux";
+  }
+#endif
+}
+
+void Stop() {
+  running = false;
+}
+
+bool Running() {
+  return running.load(std::memory_order_relaxed);
+}
+
+bool Read(Counters *counters) {
+  if (!Running()) return false;
+#if defined(__linux__)
+  static thread_local ThreadCounters thread_counters;
+  return thread_counters.Read(counters);
+#else
+  return false;
+#endif
+}
+
+}  // namespace perf
+}  // namespace profiler
+}  // namespace mxnet
@@ -0,0 +1,80 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file perf_counters.h
+ * \brief hardware performance counters of the CPU operators from perf_event
+ *
+ *  Every engine worker opens a group of perf_event counters of its own thread: the cycles,
+ *  the instructions, and the references to and misses of the last level cache. The counters
+ *  read when a CPU operator starts and stops give the events of its run, which the aggregate
+ *  stats turn into instructions per cycle and misses per output element, telling memory
+ *  bound operators from compute bound ones.
+ */
+#ifndef MXNET_PROFILER_PERF_COUNTERS_H_
+#define MXNET_PROFILER_PERF_COUNTERS_H_
+
+#include <array>
+#include <cstdint>
+
+namespace mxnet {
+namespace profiler {
+namespace perf {
+
+/*! \brief counters of the group of a thread */
+enum Counter {
+  kCycles,
+  kInstructions,
+  kCacheReferences,
+  kCacheMisses,
+  kNumCounters
+};
+
+/*! \brief bytes of a line of the last level cache, for the traffic of its misses */
+constexpr uint64_t kCacheLineBytes = 64;
+
+/*! \brief values of the counters, or of their increments */
+struct Counters {
+  std::array<uint64_t, kNumCounters> values{};
+};
+
+/*!
+ * \brief start counting, if MXNET_PROFILER_PERF_EVENTS is set
+ * \note the counters of a thread are opened by its first Read
+ */
+void Start();
+
+/*! \brief stop counting */
+void Stop();
+
+/*! \return whether counting */
+bool Running();
+
+/*!
+ * \brief read the counters of the calling thread
+ * \param counters filled with the counters, scaled when the kernel multiplexes them
+ * \return whether counting, false if perf_event is not available to the thread
+ */
+bool Read(Counters *counters);
+
+}  // namespace perf
+}  // namespace profiler
+}  // namespace mxnet
+
+#endif  // MXNET_PROFILER_PERF_COUNTERS_H_
@@ -0,0 +1,251 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file perfetto_trace.h
+ * \brief streaming writer of profile statistics in the Perfetto protobuf trace format
+ *
+ *  A Perfetto trace is a sequence of TracePacket messages, each one a `packet` field of the
+ *  Trace message, so packets are appended to the file as they come and the file is a valid
+ *  trace after every flush. The few messages used are encoded by hand, the field numbers are
+ *  those of protos/perfetto/trace/ in the Perfetto repository.
+ *  Processes (devices and categories) and their threads are named tracks, their events are
+ *  track events on them.
+ */
+#ifndef MXNET_PROFILER_PERFETTO_TRACE_H_
+#define MXNET_PROFILER_PERFETTO_TRACE_H_
+
+#include <dmlc/logging.h>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include "./profiler.h"
+
+namespace mxnet {
+namespace profiler {
+
+/*! \brief writer of a Perfetto trace, appending the statistics to the file */
+class PerfettoTraceWriter {
+ public:
+  /*!
+   * \brief constructor
+   * \param filename path of the trace, truncated
+   */
+  explicit PerfettoTraceWriter(const std::string &filename)
+      : file_(filename, std::ios::trunc | std::ios::out | std::ios::binary) {
+    CHECK(file_.is_open()) << "Failed to open " << filename << ": " << strerror(errno);
+  }
+
+  ~PerfettoTraceWriter() {
+    Flush();
+  }
+
+  /*!
+   * \brief name a process, its track is written with its first event
+   * \param pid process id of the statistics
+   * \param name name of the process
+   */
+  void SetProcessName(size_t pid, const std::string &name) {
+    process_names_[pid] = name;
+  }
+
+  /*! \brief append the events of a statistic */
+  void AddStat(const ProfileStat &stat) {
+    for (const ProfileStat::SubEvent &ev : stat.items_) {
+      if (!ev.enabled_) continue;
+      uint64_t type;
+      uint64_t track;
+      switch (ev.event_type_) {
+        case ProfileStat::kDurationBegin:
+        case ProfileStat::kAsyncNestableStart:
+          type = kSliceBegin;
+          track = ThreadTrack(stat.process_id_, stat.thread_id_);
+          break;
+        case ProfileStat::kDurationEnd:
+        case ProfileStat::kAsyncNestableEnd:
+          type = kSliceEnd;
+          track = ThreadTrack(stat.process_id_, stat.thread_id_);
+          break;
+        case ProfileStat::kInstant:
+        case ProfileStat::kAsyncNestableInstant:
+          type = kInstant;
+          track = ThreadTrack(stat.process_id_, stat.thread_id_);
+          break;
+        case ProfileStat::kCounter:
+          type = kCounter;
+          track = CounterTrack(stat.process_id_, stat.name_.c_str());
+          break;
+        default:
+          // no equivalent track event
+          continue;
+      }
+      std::string event;
+      PutVarint(&event, kTrackEventType, type);
+      PutVarint(&event, kTrackEventTrackUuid, track);
+      if (type == kCounter) {
+        PutVarint(&event, kTrackEventCounterValue, stat.CounterValue());
+      } else {
+        PutString(&event, kTrackEventCategories, stat.categories_.c_str());
+        if (type != kSliceEnd) {
+          PutString(&event, kTrackEventName, stat.name_.c_str());
+        }
+        if (type == kSliceBegin && stat.request_id_ != 0) {
+          std::string annotation;
+          PutString(&annotation, kAnnotationName, "request");
+          PutString(&annotation, kAnnotationString,
+                    Profiler::Get()->RequestName(stat.request_id_));
+          PutString(&event, kTrackEventAnnotations, annotation);
+        }
+      }
+      std::string packet;
+      PutVarint(&packet, kPacketTimestamp, ev.timestamp_ * 1000);
+      PutVarint(&packet, kPacketSequenceId, kSequenceId);
+      PutString(&packet, kPacketTrackEvent, event);
+      AddPacket(packet);
+    }
+  }
+
+  /*! \brief write the packets added so far */
+  void Flush() {
+    if (buffer_.empty()) return;
+    file_.write(buffer_.data(), buffer_.size());
+    file_.flush();
+    buffer_.clear();
+  }
+
+ private:
+  /*! \brief field numbers and values of the messages written */
+  enum : uint32_t {
+    kTracePacket = 1,
+    kPacketTimestamp = 8,
+    kPacketSequenceId = 10,
+    kPacketTrackEvent = 11,
+    kPacketTrackDescriptor = 60,
+    kTrackUuid = 1,
+    kTrackName = 2,
+    kTrackParentUuid = 5,
+    kTrackCounter = 8,
+    kTrackEventAnnotations = 4,
+    kTrackEventType = 9,
+    kTrackEventTrackUuid = 11,
+    kTrackEventCategories = 22,
+    kTrackEventName = 23,
+    kTrackEventCounterValue = 30,
+    kAnnotationString = 6,
+    kAnnotationName = 10,
+    kSliceBegin = 1,
+    kSliceEnd = 2,
+    kInstant = 3,
+    kCounter = 4,
+    kSequenceId = 1
+  };
+  /*! \brief size of the packets buffered before they are written */
+  static constexpr size_t kBufferSize = 1UL << 20UL;
+
+  static void PutRawVarint(std::string *out, uint64_t value) {
+    while (value >= 0x80) {
+      out->push_back(static_cast<char>((value & 0x7f) | 0x80));
+      value >>= 7;
+    }
+    out->push_back(static_cast<char>(value));
+  }
+
+  static void PutVarint(std::string *out, uint32_t field, uint64_t value) {
+    PutRawVarint(out, field << 3);
+    PutRawVarint(out, value);
+  }
+
+  static void PutString(std::string *out, uint32_t field, const std::string &value) {
+    PutRawVarint(out, (field << 3) | 2);
+    PutRawVarint(out, value.size());
+    out->append(value);
+  }
+
+  void AddPacket(const std::string &packet) {
+    PutString(&buffer_, kTracePacket, packet);
+    if (buffer_.size() >= kBufferSize) Flush();
+  }
+
+  /*! \brief write the descriptor of a new track */
+  uint64_t AddTrack(const std::string &name, uint64_t parent, bool counter) {
+    const uint64_t uuid = next_uuid_++;
+    std::string track;
+    PutVarint(&track, kTrackUuid, uuid);
+    PutString(&track, kTrackName, name);
+    if (parent != 0) {
+      PutVarint(&track, kTrackParentUuid, parent);
+    }
+    if (counter) {
+      PutString(&track, kTrackCounter, "");
+    }
+    std::string packet;
+    PutString(&packet, kPacketTrackDescriptor, track);
+    AddPacket(packet);
+    return uuid;
+  }
+
+  uint64_t ProcessTrack(size_t pid) {
+    auto it = process_tracks_.find(pid);
+    if (it != process_tracks_.end()) return it->second;
+    auto name = process_names_.find(pid);
+    const uint64_t uuid = AddTrack(name != process_names_.end() ? name->second
+                                                                 : std::to_string(pid), 0, false);
+    process_tracks_.emplace(pid, uuid);
+    return uuid;
+  }
+
+  uint64_t ThreadTrack(size_t pid, std::thread::id thread_id) {
+    const size_t tid = std::hash<std::thread::id>{}(thread_id);
+    auto key = std::make_tuple(pid, tid, std::string());
+    auto it = tracks_.find(key);
+    if (it != tracks_.end()) return it->second;
+    const uint64_t uuid = AddTrack("thread " + std::to_string(tid), ProcessTrack(pid), false);
+    tracks_.emplace(key, uuid);
+    return uuid;
+  }
+
+  uint64_t CounterTrack(size_t pid, const std::string &name) {
+    auto key = std::make_tuple(pid, size_t(0), name);
+    auto it = tracks_.find(key);
+    if (it != tracks_.end()) return it->second;
+    const uint64_t uuid = AddTrack(name, ProcessTrack(pid), true);
+    tracks_.emplace(key, uuid);
+    return uuid;
+  }
+
+  std::ofstream file_;
+  /*! \brief packets not written yet */
+  std::string buffer_;
+  /*! \brief names of the processes */
+  std::unordered_map<size_t, std::string> process_names_;
+  /*! \brief uuids of the tracks written, of the processes and of their threads and counters */
+  std::unordered_map<size_t, uint64_t> process_tracks_;
+  std::map<std::tuple<size_t, size_t, std::string>, uint64_t> tracks_;
+  uint64_t next_uuid_ = 1;
+};
+
+}  // namespace profiler
+}  // namespace mxnet
+#endif  // MXNET_PROFILER_PERFETTO_TRACE_H_
@@ -28,7 +28,9 @@
 #include <mxnet/base.h>
 #include <fstream>
 #include <thread>
+#include <unordered_set>
 #include "./profiler.h"
+#include "./perfetto_trace.h"
 
 #if MXNET_USE_CUDA
 #include "../common/cuda/utils.h"
@@ -43,6 +45,11 @@ namespace profiler {
 
 ProfileDomain ProfileOperator::domain_("operator");
 
+static inline bool EndsWith(const std::string& s, const std::string& suffix) {
+  return s.size() >= suffix.size() &&
+      s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
 Profiler::Profiler()
   : state_(kNotRunning)
     , enable_output_(false)
@@ -119,7 +126,11 @@ void Profiler::SetState(ProfilerState state) {
   if (state == kRunning) {
     this->enable_output_ = true;
     set_paused(false);
+    CUPTI_ONLY_CODE(cupti::Start());
+    perf::Start();
   } else {
+    CUPTI_ONLY_CODE(cupti::Stop());
+    perf::Stop();
     set_paused(true);
   }
 }
@@ -133,6 +144,9 @@ void Profiler::SetConfig(int mode,
   std::lock_guard<std::recursive_mutex> lock{this->m_};
   this->mode_ = mode;
   this->filename_ = output_filename;
+  this->perfetto_trace_ = EndsWith(output_filename, ".pftrace") ||
+      EndsWith(output_filename, ".perfetto-trace");
+  trace_writer_.reset();
   // Remove the output file to start
   if (!this->filename_.empty()) {
     ::unlink(this->filename_.c_str());
@@ -148,6 +162,62 @@ void Profiler::SetConfig(int mode,
   }
 }
 
+void Profiler::SetSampling(size_t ring_size, int sample_period, bool sample_iterations) {
+  CHECK_GT(sample_period, 0) << "sample_period must be positive";
+  std::lock_guard<std::recursive_mutex> lock{this->m_};
+  this->sample_period_ = sample_period;
+  this->sample_iterations_ = sample_iterations;
+  this->iteration_ = 0;
+  this->sampled_iteration_ = true;
+  ProfileStatRing *ring = ring_.load();
+  if ((ring ? ring->capacity() : 0) == ring_size) {
+    return;
+  }
+  if (ring_size > 0) {
+    rings_.emplace_back(new ProfileStatRing(ring_size));
+    ring_.store(rings_.back().get());
+  } else {
+    ring_.store(nullptr);
+  }
+  if (ring) {
+    // the records of the previous ring are dropped, its slots stay for late writers
+    std::vector<ProfileStat *> stats;
+    ring->Drain(&stats);
+    for (ProfileStat *stat : stats) {
+      delete stat;
+    }
+  }
+}
+
+uint32_t Profiler::SetRequest(const std::string& name) {
+  if (name.empty()) {
+    CurrentRequestId() = 0;
+    return 0;
+  }
+  std::lock_guard<std::mutex> lock{request_mutex_};
+  if (next_request_id_ == 0) {
+    ++next_request_id_;
+  }
+  const uint32_t request_id = next_request_id_++;
+  if (request_names_.size() < kMaxRequestNames) {
+    request_names_.resize(kMaxRequestNames);
+  }
+  request_names_[request_id % kMaxRequestNames] = name;
+  CurrentRequestId() = request_id;
+  return request_id;
+}
+
+std::string Profiler::RequestName(uint32_t request_id) {
+  std::lock_guard<std::mutex> lock{request_mutex_};
+  if (request_id == 0) {
+    return std::string();
+  }
+  if (static_cast<uint32_t>(next_request_id_ - request_id) <= kMaxRequestNames) {
+    return request_names_[request_id % kMaxRequestNames];
+  }
+  return "#" + std::to_string(request_id);
+}
+
 /*
  * Docs for tracing format:
  * https://docs.google.com/document/d/1CvAClvFfyA5R-PhYUmn5OOQtYMH4h6I0nSsKchNAySU/preview
@@ -168,6 +238,17 @@ void Profiler::DumpProfile(bool perform_cleanup) {
   if (!IsEnableOutput()) {
     return;
   }
+  // the kernels and copies completed so far join the operators
+  CUPTI_ONLY_CODE(cupti::Flush());
+  ProfileStatRing *ring = ring_.load();
+  if (ring) {
+    DumpRing(ring, perform_cleanup);
+    return;
+  }
+  if (perfetto_trace_) {
+    DumpPerfetto(perform_cleanup);
+    return;
+  }
   if (perform_cleanup) {
     SetContinuousProfileDump(false, 1.0f);
   }
@@ -253,6 +334,123 @@ void Profiler::DumpProfile(bool perform_cleanup) {
                                                     // Otherwise, profiling stops.
 }
 
+void Profiler::DumpPerfetto(bool perform_cleanup) {
+  if (perform_cleanup) {
+    SetContinuousProfileDump(false, 1.0f);
+  }
+  ++profile_dump_count_;
+  const bool last_pass = perform_cleanup || !continuous_dump_;
+  if (!trace_writer_) {
+    trace_writer_.reset(new PerfettoTraceWriter(filename_));
+    for (uint32_t pid = 0; pid < DeviceCount(); ++pid) {
+      trace_writer_->SetProcessName(pid, profile_stat[pid].dev_name_);
+    }
+  }
+  std::shared_ptr<AggregateStats> ptr_aggregate_stats = aggregate_stats_.get()
+                                                        ? aggregate_stats_ : nullptr;
+  for (uint32_t i = 0; i < DeviceCount(); ++i) {
+    ProfileStat *_opr_stat;
+    while (profile_stat[i].opr_exec_stats_->try_dequeue(_opr_stat)) {
+      std::unique_ptr<ProfileStat> opr_stat(_opr_stat);  // manage lifecycle
+      opr_stat->process_id_ = i;
+      trace_writer_->AddStat(*opr_stat);
+      ++num_records_emitted_;
+      if (ptr_aggregate_stats) {
+        ptr_aggregate_stats->OnProfileStat(*opr_stat);
+      }
+    }
+  }
+  ProfileStat *_profile_stat;
+  while (general_stats_.opr_exec_stats_->try_dequeue(_profile_stat)) {
+    std::unique_ptr<ProfileStat> profile_stat(_profile_stat);  // manage lifecycle
+    CHECK_NE(profile_stat->categories_.c_str()[0], '\0') << "Category must be set";
+    auto iter = category_to_pid_.find(profile_stat->categories_.c_str());
+    if (iter == category_to_pid_.end()) {
+      static std::hash<std::string> hash_fn;
+      iter = category_to_pid_.emplace(profile_stat->categories_.c_str(),
+                                      hash_fn(profile_stat->categories_.c_str())).first;
+    }
+    profile_stat->process_id_ = iter->second;
+    trace_writer_->SetProcessName(iter->second, iter->first);
+    trace_writer_->AddStat(*profile_stat);
+    ++num_records_emitted_;
+    if (ptr_aggregate_stats) {
+      ptr_aggregate_stats->OnProfileStat(*profile_stat);
+    }
+  }
+  // the trace is valid after every dump, the next continuous dump appends to it
+  trace_writer_->Flush();
+  if (last_pass) {
+    trace_writer_.reset();
+  }
+  enable_output_ = continuous_dump_ && !last_pass;
+}
+
+void Profiler::DumpRing(ProfileStatRing *ring, bool perform_cleanup) {
+  if (perform_cleanup) {
+    SetContinuousProfileDump(false, 1.0f);
+  }
+  std::vector<ProfileStat *> stats;
+  ring->Drain(&stats);
+  // every dump is a whole trace of the last records, the live process keeps recording
+  const size_t dev_num = DeviceCount();
+  std::unique_ptr<PerfettoTraceWriter> writer;
+  std::ofstream file;
+  if (perfetto_trace_) {
+    writer.reset(new PerfettoTraceWriter(filename_));
+    for (uint32_t pid = 0; pid < dev_num; ++pid) {
+      writer->SetProcessName(pid, profile_stat[pid].dev_name_);
+    }
+  } else {
+    file.open(filename_, std::ios::trunc|std::ios::out);
+    file << "{" << std::endl;
+    file << "    \"traceEvents\": [" << std::endl;
+    for (uint32_t pid = 0; pid < dev_num; ++pid) {
+      if (pid) {
+        file << ",\n";
+      }
+      this->EmitPid(&file, profile_stat[pid].dev_name_, pid);
+    }
+  }
+  std::shared_ptr<AggregateStats> ptr_aggregate_stats = aggregate_stats_.get()
+                                                        ? aggregate_stats_ : nullptr;
+  std::unordered_set<size_t> category_pids;
+  for (ProfileStat *_stat : stats) {
+    std::unique_ptr<ProfileStat> stat(_stat);  // manage lifecycle
+    // the operators have their device as process id already
+    if (!dynamic_cast<ProfileOperator::OprExecStat *>(_stat)) {
+      CHECK_NE(stat->categories_.c_str()[0], '\0') << "Category must be set";
+      static std::hash<std::string> hash_fn;
+      stat->process_id_ = hash_fn(stat->categories_.c_str());
+      if (category_pids.insert(stat->process_id_).second) {
+        if (writer) {
+          writer->SetProcessName(stat->process_id_, stat->categories_.c_str());
+        } else {
+          file << ",\n";
+          EmitPid(&file, stat->categories_.c_str(), stat->process_id_);
+        }
+      }
+    }
+    if (writer) {
+      writer->AddStat(*stat);
+    } else {
+      file << ",\n";
+      stat->EmitEvents(&file);
+    }
+    ++num_records_emitted_;
+    if (ptr_aggregate_stats) {
+      ptr_aggregate_stats->OnProfileStat(*stat);
+    }
+  }
+  if (!writer) {
+    file << "\n" << std::endl;
+    file << "    ]," << std::endl;
+    file << R"(    "displayTimeUnit": "ms")" << std::endl;
+    file << "}" << std::endl;
+  }
+  enable_output_ = !perform_cleanup;
+}
+
 static constexpr char TIMER_THREAD_NAME[] = "DumpProfileTimer";
 
 void Profiler::SetContinuousProfileDump(bool continuous_dump, float delay_in_seconds) {
@@ -29,6 +29,7 @@
 #include <dmlc/thread_group.h>
 #include <vector>
 #include <string>
+#include <atomic>
 #include <cstdint>
 #include <mutex>
 #include <memory>
@@ -36,6 +37,8 @@
 #include "./vtune.h"
 #include "./aggregate_stats.h"
 #include "./nvtx.h"
+#include "./cupti_activity.h"
+#include "./perf_counters.h"
 #include "../common/utils.h"
 
 
@@ -71,6 +74,26 @@ struct static_string {
 
 using profile_stat_string = static_string<128>;
 
+/*!
+ * \brief Id of the request the calling thread works for, 0 for none
+ * \note set by Profiler::SetRequest, and by the engine workers to the request which
+ *  pushed the operator they run
+ */
+inline uint32_t& CurrentRequestId() {
+  static thread_local uint32_t request_id = 0;
+  return request_id;
+}
+
+/*!
+ * \brief Name of the operator the calling thread runs, empty for none
+ * \note set while memory is profiled, for the memory timeline to find the operators
+ *  allocating
+ */
+inline profile_stat_string& CurrentOperatorName() {
+  static thread_local profile_stat_string name;
+  return name;
+}
+
 /*!
  * \brief Base profile statistic structure
  */
@@ -122,6 +145,9 @@ struct ProfileStat {
   /*! \brief whether to add this stat to AggregateStats */
   bool enable_aggregate_ = true;
 
+  /*! \brief id of the request of the statistic, 0 for none */
+  uint32_t request_id_ = 0;
+
   /* !\brief Process id */
   size_t process_id_ = common::current_process_id();
 
@@ -183,6 +209,14 @@ struct ProfileStat {
     }
   }
 
+  /*!
+   * \brief Value of a counter statistic, for the writers of binary traces
+   * \return The counter value
+   */
+  virtual uint64_t CounterValue() const {
+    return 0;
+  }
+
  protected:
   /*!
    * \brief Override to emit extra items within the json event data block. Append with a comma ",".
@@ -236,6 +270,63 @@ struct DeviceStats {
   std::shared_ptr<TQueue> opr_exec_stats_ = std::make_shared<TQueue>();
 };
 
+/*!
+ * \brief Lock free ring keeping the last statistics added, the older ones are dropped
+ */
+class ProfileStatRing {
+ public:
+  /*!
+   * \brief Constructor
+   * \param capacity Number of statistics kept
+   */
+  explicit ProfileStatRing(size_t capacity)
+    : capacity_(capacity), slots_(new std::atomic<ProfileStat *>[capacity]) {
+    CHECK_GT(capacity, 0U);
+    for (size_t i = 0; i < capacity_; ++i) {
+      slots_[i].store(nullptr, std::memory_order_relaxed);
+    }
+  }
+  ~ProfileStatRing() {
+    std::vector<ProfileStat *> stats;
+    Drain(&stats);
+    for (ProfileStat *stat : stats) {
+      delete stat;
+    }
+  }
+  /*! \return Number of statistics kept */
+  size_t capacity() const { return capacity_; }
+  /*!
+   * \brief Add a statistic in place of the oldest one
+   * \param stat The statistic, owned by the ring
+   */
+  void Push(ProfileStat *stat) {
+    const size_t i = next_.fetch_add(1, std::memory_order_relaxed) % capacity_;
+    delete slots_[i].exchange(stat, std::memory_order_acq_rel);
+  }
+  /*!
+   * \brief Take the statistics out of the ring, oldest first
+   * \param stats The statistics, owned by the caller
+   */
+  void Drain(std::vector<ProfileStat *> *stats) {
+    const size_t next = next_.load(std::memory_order_relaxed);
+    for (size_t k = 0; k < capacity_; ++k) {
+      ProfileStat *stat = slots_[(next + k) % capacity_].exchange(nullptr,
+                                                               std::memory_order_acq_rel);
+      if (stat) {
+        stats->push_back(stat);
+      }
+    }
+  }
+
+ private:
+  const size_t capacity_;
+  std::unique_ptr<std::atomic<ProfileStat *>[]> slots_;
+  /*! \brief Number of statistics added */
+  std::atomic<size_t> next_{0};
+};
+
+class PerfettoTraceWriter;
+
 /*!
  *  _____              __  _  _
  * |  __ \            / _|(_)| |
@@ -278,6 +369,50 @@ class Profiler {
                  bool continuous_dump,
                  float dump_period,
                  bool aggregate_stats);
+  /*!
+   * \brief set sampling configuration, for a profiler left on in production
+   * \param ring_size if nonzero, only the last ring_size statistics are kept and every
+   *        dump writes them as a whole trace, otherwise all of them are queued
+   * \param sample_period 1 in sample_period operators is recorded
+   * \param sample_iterations if true, rather all the operators of 1 in sample_period
+   *        iterations are recorded, the iterations being delimited by NextIteration()
+   */
+  void SetSampling(size_t ring_size, int sample_period, bool sample_iterations);
+
+  /*!
+   * \brief whether the operator about to be pushed is to be recorded
+   * \note called for every operator, the count is kept per thread
+   */
+  inline bool SampleOperator() const {
+    if (sample_period_ <= 1) {
+      return true;
+    }
+    if (sample_iterations_) {
+      return sampled_iteration_;
+    }
+    static thread_local uint32_t count = 0;
+    return count++ % static_cast<uint32_t>(sample_period_) == 0;
+  }
+
+  /*!
+   * \brief start a request on the calling thread, the operators it pushes are attributed
+   *  to it in the trace and the aggregate stats
+   * \param name name of the request, empty to end the current one
+   * \return id of the request, 0 if ended
+   */
+  uint32_t SetRequest(const std::string& name);
+
+  /*!
+   * \brief name of a request
+   * \note only the names of the last kMaxRequestNames requests are kept, the older
+   *  requests are named by their id
+   */
+  std::string RequestName(uint32_t request_id);
+
+  /*! \brief mark the start of the next iteration, for sample_iterations */
+  inline void NextIteration() {
+    sampled_iteration_ = ++iteration_ % static_cast<uint64_t>(sample_period_) == 0;
+  }
 
   /*! \return mode of profiler */
   inline int GetMode() const {
@@ -298,6 +433,11 @@ class Profiler {
    */
   void DumpProfile(bool perform_cleanup = true);
 
+  /*! \return filename of the profile */
+  inline const std::string& GetFilename() const {
+    return filename_;
+  }
+
   /*! \return the profiler init time, time unit is microsecond (10^-6) s */
   uint64_t MSHADOW_CINLINE GetInitTime() const {
     return init_time_;
@@ -426,12 +566,31 @@ class Profiler {
    */
   template<typename StatType>
   inline void AddProfileStat(std::unique_ptr<StatType> *stat) {
+    ProfileStatRing *ring = ring_.load(std::memory_order_acquire);
+    if (ring) {
+      ring->Push(stat->release());
+      return;
+    }
     general_stats_.opr_exec_stats_->enqueue(stat->release());
   }
 
   /*! \brief generate device information following chrome profile file format */
   void EmitPid(std::ostream *os, const std::string& name, size_t pid);
 
+  /*!
+   * \brief write the statistics of the ring as a whole trace
+   * \param ring The ring
+   * \param perform_cleanup Whether output stops after this dump
+   */
+  void DumpRing(ProfileStatRing *ring, bool perform_cleanup);
+
+  /*!
+   * \brief dump the profile file as a Perfetto protobuf trace, appended to by the
+   *  continuous dumps
+   * \param perform_cleanup Close off the trace (ie last pass)
+   */
+  void DumpPerfetto(bool perform_cleanup);
+
   /*!
    * \brief Set continuous asynchronous profile dump
    * \param continuous_dump Whether to continuously dump profile information
@@ -449,6 +608,13 @@ class Profiler {
   int mode_ = kSymbolic | kAPI | kMemory;
   /*! \brief filename to output profile file */
   std::string filename_ = "profile.json";
+  /*!
+   * \brief Whether the profile is written as a Perfetto protobuf trace, for a filename
+   *  ending with .pftrace or .perfetto-trace, rather than as chrome tracing json
+   */
+  bool perfetto_trace_ = false;
+  /*! \brief Writer of the Perfetto trace open across the continuous dumps */
+  std::unique_ptr<PerfettoTraceWriter> trace_writer_;
   /*! \brief profile statistics consist of multiple device statistics */
   std::unique_ptr<DeviceStats[]> profile_stat;
   /*! \brief Stats not associated directly with a device */
@@ -469,6 +635,23 @@ class Profiler {
   volatile uint64_t profile_dump_count_;
   /*! \brief Whether profiling is paused */
   volatile bool paused_ = false;
+  /*! \brief Ring the statistics are added to instead of the queues, if any */
+  std::atomic<ProfileStatRing *> ring_{nullptr};
+  /*! \brief Rings created, the previous ones kept for the threads still adding to them */
+  std::vector<std::unique_ptr<ProfileStatRing>> rings_;
+  /*! \brief 1 in sample_period_ operators or iterations is recorded */
+  volatile int sample_period_ = 1;
+  /*! \brief Whether whole iterations are sampled */
+  volatile bool sample_iterations_ = false;
+  /*! \brief Number of iterations, and whether the current one is recorded */
+  uint64_t iteration_ = 0;
+  volatile bool sampled_iteration_ = true;
+  /*! \brief Number of request names kept */
+  static constexpr size_t kMaxRequestNames = 1 << 16;
+  /*! \brief Names of the last requests by id modulo kMaxRequestNames, and the next id */
+  std::mutex request_mutex_;
+  std::vector<std::string> request_names_;
+  uint32_t next_request_id_ = 1;
   /*! \brief Maintain in-memory aggregate stats for print output.
    *  \warning This has a negative performance impact */
   std::shared_ptr<AggregateStats> aggregate_stats_ = nullptr;
@@ -490,6 +673,12 @@ class Profiler {
 #define NVTX_ONLY_CODE(...) /* */        /* This is undefined at the bottom of this file */
 #endif
 
+#if MXNET_USE_CUPTI
+#define CUPTI_ONLY_CODE(...) __VA_ARGS__  /* This is undefined at the bottom of this file */
+#else
+#define CUPTI_ONLY_CODE(...) /* */        /* This is undefined at the bottom of this file */
+#endif
+
 /**
  *  _____              __  _  _  _                ____  _     _            _
  * |  __ \            / _|(_)| |(_)              / __ \| |   (_)          | |
@@ -646,6 +835,10 @@ struct ProfileCounter : public ProfileObject {
       *os << "        \"args\": { \"" << name_.c_str() << "\": " << value_ << " },\n";
     }
 
+    uint64_t CounterValue() const override {
+      return value_;
+    }
+
     /*!
      * \brief Save aggregate data for this stat
      * \param data Stat data
@@ -1184,6 +1377,16 @@ struct ProfileOperator : public ProfileEvent {
     if (profiling_) {
       ProfileEvent::start();
       as_task_.start();
+      thread_ = std::this_thread::get_id();
+      tag_operator_ = Profiler::Get()->IsProfiling(Profiler::kMemory);
+      if (tag_operator_) {
+        prev_operator_ = CurrentOperatorName();
+        CurrentOperatorName() = name_;
+      }
+      CUPTI_ONLY_CODE(cupti_pushed_ = dev_type == Context::kGPU &&
+                                      cupti::PushOperator(name_.c_str(), dev_id));
+      // last, not to count the profiler
+      counted_ = dev_type != Context::kGPU && perf::Read(&counters_);
     }
   }
   /*!
@@ -1191,10 +1394,36 @@ struct ProfileOperator : public ProfileEvent {
    */
   void stop() override {
     if (profiling_) {
+      // the counters of an asynchronous operator completing on another thread are not its own
+      perf::Counters counters;
+      counted_ = counted_ && thread_ == std::this_thread::get_id() && perf::Read(&counters);
+      if (counted_) {
+        for (int i = 0; i < perf::kNumCounters; ++i) {
+          counters_.values[i] = counters.values[i] - counters_.values[i];
+        }
+      }
+      // the kernels of an asynchronous operator completing on another thread are
+      // tagged until the next operator of the launching thread
+      CUPTI_ONLY_CODE(if (cupti_pushed_ && thread_ == std::this_thread::get_id()) {
+        cupti::PopOperator();
+      });
+      if (tag_operator_ && thread_ == std::this_thread::get_id()) {
+        CurrentOperatorName() = prev_operator_;
+      }
       as_task_.stop();
       ProfileEvent::stop();
     }
   }
+  /*!
+   * \brief Record when the engine scheduled the operator, for the aggregate stats
+   * \param push_time Time when the operator was pushed to the engine
+   * \param enqueue_time Time when its dependencies were satisfied and it was
+   *        handed to a worker queue
+   */
+  void setSchedulingTimes(uint64_t push_time, uint64_t enqueue_time) {
+    push_time_ = push_time;
+    enqueue_time_ = enqueue_time;
+  }
 
   /*!
    * \brief Operation execution statistics
@@ -1226,10 +1455,52 @@ struct ProfileOperator : public ProfileEvent {
       items_[kStart].timestamp_ = start_time;
       items_[kStop].timestamp_ = stop_time;
     }
+    /*!
+     * \brief Save aggregate data for this stat, including the engine scheduling
+     *  delays when they were recorded
+     * \param data Stat data
+     */
+    void SaveAggregate(AggregateStats::StatData *data) const override {
+      DurationStat::SaveAggregate(data);
+      if (data && counted_) {
+        for (int i = 0; i < perf::kNumCounters; ++i) {
+          data->counters_[i] += counters_.values[i];
+        }
+        ++data->counted_;
+      }
+      const uint64_t start_time = items_[kStart].timestamp_;
+      if (data && push_time_ != 0 && push_time_ <= enqueue_time_ &&
+          enqueue_time_ <= start_time) {
+        data->dependency_wait_.Add(enqueue_time_ - push_time_);
+        data->queue_delay_.Add(start_time - enqueue_time_);
+        data->exec_time_.Add(items_[kStop].timestamp_ - start_time);
+      }
+    }
     /*! \brief device type: CPU: 1, GPU: 2, CPUPinned: 3 */
     mxnet::Context::DeviceType dev_type_;
     /*! \brief device id */
     uint32_t dev_id_;
+    /*! \brief time when the operator was pushed to the engine, 0 if unknown */
+    uint64_t push_time_{0};
+    /*! \brief time when the operator was handed to a worker queue */
+    uint64_t enqueue_time_{0};
+    /*! \brief whether the hardware counters counted the run, and their increments */
+    bool counted_{false};
+    perf::Counters counters_;
+
+   protected:
+    /*!
+     * \brief Emit the request of the operator, if any
+     * \param os Output stream to write data to
+     * \param idx Sub-even index (index into items_) to write
+     */
+    void EmitExtra(std::ostream *os, size_t idx) override {
+      DurationStat::EmitExtra(os, idx);
+      if (request_id_ != 0 && idx == kStart) {
+        *os << "        \"args\": { \"request\": \""
+            << Profiler::Get()->RequestName(request_id_) << "\" },\n";
+      }
+    }
   };
 
  private:
@@ -1238,7 +1509,13 @@ struct ProfileOperator : public ProfileEvent {
    */
   void SendStat() override {
     Profiler::Get()->AddNewProfileStat<OprExecStat>(
-      [](OprExecStat *stat) {}, name_.c_str(), dev_type_, dev_id_,
+      [this](OprExecStat *stat) {
+        stat->push_time_ = push_time_;
+        stat->enqueue_time_ = enqueue_time_;
+        stat->request_id_ = request_id_;
+        stat->counted_ = counted_;
+        stat->counters_ = counters_;
+      }, name_.c_str(), dev_type_, dev_id_,
       start_time_, ProfileStat::NowInMicrosec(),
       attributes_.get());
   }
@@ -1270,6 +1547,22 @@ struct ProfileOperator : public ProfileEvent {
   std::unique_ptr<Attributes> attributes_;
   /*! \brief Whether to profile or not */
   const bool profiling_;
+  /*! \brief Time when the operator was pushed to the engine, 0 if unknown */
+  uint64_t push_time_{0};
+  /*! \brief Time when the operator was handed to a worker queue */
+  uint64_t enqueue_time_{0};
+  /*! \brief Request the operator works for, 0 for none */
+  const uint32_t request_id_ = CurrentRequestId();
+  /*! \brief Thread which started the operator */
+  std::thread::id thread_;
+  /*! \brief Whether its kernels are tagged with CUPTI */
+  CUPTI_ONLY_CODE(bool cupti_pushed_ = false);
+  /*! \brief Whether the hardware counters count it, their values at start then increments */
+  bool counted_ = false;
+  perf::Counters counters_;
+  /*! \brief Whether its allocations are tagged, and the operator of the thread before */
+  bool tag_operator_ = false;
+  profile_stat_string prev_operator_;
 };
 
 /*
@@ -1308,6 +1601,12 @@ inline void Profiler::AddProfileStat<ProfileOperator::OprExecStat>(
   std::unique_ptr<ProfileOperator::OprExecStat> *opr_stat) {
   const size_t idx = DeviceIndex((*opr_stat)->dev_type_, (*opr_stat)->dev_id_);
   CHECK_LT(idx, DeviceCount());
+  ProfileStatRing *ring = ring_.load(std::memory_order_acquire);
+  if (ring) {
+    (*opr_stat)->process_id_ = idx;
+    ring->Push((*opr_stat).release());
+    return;
+  }
   DeviceStats& dev_stat = profile_stat[idx];
   dev_stat.opr_exec_stats_->enqueue((*opr_stat).release());
 }
@@ -21,9 +21,14 @@
 #if MXNET_USE_NVML
 #include <nvml.h>
 #endif  // MXNET_USE_NVML
+#include <algorithm>
 #include <fstream>
+#include <iterator>
 #include <map>
+#include <string>
+#include <tuple>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 #include "./profiler.h"
 #include "../common/utils.h"
@@ -32,6 +37,121 @@
 namespace mxnet {
 namespace profiler {
 
+MemoryTimeline* MemoryTimeline::Get() {
+  static MemoryTimeline timeline;
+  return &timeline;
+}
+
+void MemoryTimeline::OnAlloc(const Storage::Handle &handle) {
+  Profiler *prof = Profiler::Get();
+  Allocation alloc{handle.profiler_scope + handle.name,
+                   CurrentOperatorName().c_str(),
+                   prof->RequestName(CurrentRequestId()),
+                   handle.size,
+                   prof->DeviceIndex(handle.ctx.dev_type, handle.ctx.dev_id),
+                   ProfileStat::NowInMicrosec(), 0, 0, 0};
+  std::lock_guard<std::mutex> lk(mutex_);
+  alloc.alloc_seq = ++seq_;
+  live_[handle.dptr] = allocations_.size();
+  allocations_.emplace_back(std::move(alloc));
+}
+
+void MemoryTimeline::OnFree(const Storage::Handle &handle) {
+  const uint64_t now = ProfileStat::NowInMicrosec();
+  std::lock_guard<std::mutex> lk(mutex_);
+  auto it = live_.find(handle.dptr);
+  // allocated before memory was profiled
+  if (it == live_.end()) return;
+  Allocation &alloc = allocations_[it->second];
+  alloc.free_time = now;
+  alloc.free_seq = ++seq_;
+  live_.erase(it);
+}
+
+void MemoryTimeline::UpdateStorageInfo(const Storage::Handle &handle) {
+  if (handle.size == 0 || !Profiler::Get()->IsProfiling(Profiler::kMemory)) return;
+  std::lock_guard<std::mutex> lk(mutex_);
+  auto it = live_.find(handle.dptr);
+  if (it != live_.end()) {
+    allocations_[it->second].name = handle.profiler_scope + handle.name;
+  }
+}
+
+void MemoryTimeline::DumpProfile(const std::string &profile_filename) const {
+  std::lock_guard<std::mutex> lk(mutex_);
+  if (allocations_.empty()) return;
+  const size_t dot = profile_filename.find_last_of('.');
+  const size_t slash = profile_filename.find_last_of("/\\");
+  const std::string stem = dot != std::string::npos &&
+      (slash == std::string::npos || dot > slash) ? profile_filename.substr(0, dot)
+                                                  : profile_filename;
+  std::ofstream fout(stem + "_memory.json");
+  if (!fout.is_open()) {
+    LOG(WARNING) << "Failed to write the memory timeline to " << stem << "_memory.json";
+    return;
+  }
+  // (order, change of the live bytes, time) of the allocations and frees of each device
+  std::map<size_t, std::vector<std::tuple<uint64_t, int64_t, uint64_t>>> events;
+  for (const Allocation &alloc : allocations_) {
+    auto &dev_events = events[alloc.dev];
+    dev_events.emplace_back(alloc.alloc_seq, static_cast<int64_t>(alloc.size), alloc.alloc_time);
+    if (alloc.free_seq != 0) {
+      dev_events.emplace_back(alloc.free_seq, -static_cast<int64_t>(alloc.size),
+                              alloc.free_time);
+    }
+  }
+  Profiler *prof = Profiler::Get();
+  fout << "{" << std::endl << "    \"Devices\": {" << std::endl;
+  for (auto it = events.begin(); it != events.end(); ++it) {
+    auto &dev_events = it->second;
+    std::sort(dev_events.begin(), dev_events.end());
+    int64_t live = 0, peak = 0;
+    uint64_t peak_seq = 0, peak_time = 0;
+    bool first = true;
+    fout << "        \"" << prof->DeviceName(it->first) << "\": {" << std::endl
+         << "            \"Timeline\": [";
+    for (size_t i = 0; i < dev_events.size(); ++i) {
+      live += std::get<1>(dev_events[i]);
+      if (live > peak) {
+        peak = live;
+        peak_seq = std::get<0>(dev_events[i]);
+        peak_time = std::get<2>(dev_events[i]);
+      }
+      // one point per instant
+      const uint64_t time = std::get<2>(dev_events[i]);
+      if (i + 1 == dev_events.size() || std::get<2>(dev_events[i + 1]) != time) {
+        fout << (first ? "" : ", ") << "[" << time << ", " << live << "]";
+        first = false;
+      }
+    }
+    fout << "]," << std::endl
+         << "            \"Peak Bytes\": " << peak << "," << std::endl
+         << "            \"Peak Time\": " << peak_time << "," << std::endl
+         << "            \"Holders\": [";
+    // the allocations live at the peak, largest first
+    std::vector<const Allocation *> holders;
+    for (const Allocation &alloc : allocations_) {
+      if (alloc.dev == it->first && alloc.alloc_seq <= peak_seq &&
+          (alloc.free_seq == 0 || alloc.free_seq > peak_seq)) {
+        holders.push_back(&alloc);
+      }
+    }
+    std::stable_sort(holders.begin(), holders.end(),
+                     [](const Allocation *a, const Allocation *b) { return a->size > b->size; });
+    for (size_t i = 0; i < holders.size(); ++i) {
+      fout << (i != 0 ? "," : "") << std::endl
+           << "                {\"Name\": \"" << holders[i]->name << "\", "
+           << "\"Operator\": \"" << holders[i]->opr << "\", "
+           << "\"Request\": \"" << holders[i]->request << "\", "
+           << "\"Bytes\": " << holders[i]->size << ", "
+           << "\"Allocated\": " << holders[i]->alloc_time << "}";
+    }
+    fout << std::endl << "            ]" << std::endl
+         << "        }" << (std::next(it) != events.end() ? "," : "") << std::endl;
+  }
+  fout << "    }" << std::endl << "}" << std::endl;
+}
+
 #if MXNET_USE_CUDA
 
 GpuDeviceStorageProfiler* GpuDeviceStorageProfiler::Get() {
@@ -56,6 +176,7 @@ void GpuDeviceStorageProfiler::DumpProfile() const {
     int dev_id;
     size_t actual_size;
     bool reuse;
+    std::string request;
   };
   // order the GPU memory allocation entries by their attribute name
   std::multimap<std::string, AllocEntryDumpFmt> gpu_mem_ordered_alloc_entries;
@@ -69,18 +190,20 @@ void GpuDeviceStorageProfiler::DumpProfile() const {
           alloc_entry.second.requested_size,
           alloc_entry.second.dev_id,
           alloc_entry.second.actual_size,
-          alloc_entry.second.reuse});
+          alloc_entry.second.reuse,
+          alloc_entry.second.request});
     gpu_dev_id_total_alloc_map[alloc_entry.second.dev_id] = 0;
   }
   fout << "\"Attribute Name\",\"Requested Size\","
-          "\"Device\",\"Actual Size\",\"Reuse?\"" << std::endl;
+          "\"Device\",\"Actual Size\",\"Reuse?\",\"Request\"" << std::endl;
   for (const std::pair<const std::string, AllocEntryDumpFmt>& alloc_entry :
        gpu_mem_ordered_alloc_entries) {
     fout << "\"" << alloc_entry.first << "\","
          << "\"" << alloc_entry.second.requested_size << "\","
          << "\"" << alloc_entry.second.dev_id << "\","
          << "\"" << alloc_entry.second.actual_size << "\","
-         << "\"" << alloc_entry.second.reuse << "\"" << std::endl;
+         << "\"" << alloc_entry.second.reuse << "\","
+         << "\"" << alloc_entry.second.request << "\"" << std::endl;
     gpu_dev_id_total_alloc_map[alloc_entry.second.dev_id] +=
         alloc_entry.second.actual_size;
   }
@@ -111,7 +234,7 @@ void GpuDeviceStorageProfiler::DumpProfile() const {
              << "\"" << infos[i].usedGpuMemory - dev_id_total_alloc_pair.second << "\","
              << "\"" << dev_id_total_alloc_pair.first << "\","
              << "\"" << infos[i].usedGpuMemory - dev_id_total_alloc_pair.second << "\","
-             << "\"0\"" << std::endl;
+             << "\"0\",\"\"" << std::endl;
         break;
       }
     }
@@ -27,11 +27,60 @@
 #include <thread>
 #include <unordered_map>
 #include <chrono>
+#include <mutex>
 #include "./profiler.h"
 
 namespace mxnet {
 namespace profiler {
 
+/*!
+ * \brief Timeline of the bytes handed out by the storage of every device, and report of
+ *  the allocations live at the peak of each device
+ *
+ *  Every allocation made while memory is profiled is recorded with its profiler scope,
+ *  name, operator and request. The report replays the allocations and frees of a device
+ *  in time order to find its peak, and lists the allocations live at that instant.
+ */
+class MemoryTimeline {
+ public:
+  /*! \brief get the global instance */
+  static MemoryTimeline* Get();
+  /*! \brief record an allocation */
+  void OnAlloc(const Storage::Handle &handle);
+  /*! \brief record the free of an allocation */
+  void OnFree(const Storage::Handle &handle);
+  /*! \brief update the profiler scope and name of a live allocation */
+  void UpdateStorageInfo(const Storage::Handle &handle);
+  /*!
+   * \brief write the report, next to the profile: `profile.json` is reported in
+   *  `profile_memory.json`
+   * \param profile_filename filename of the profile
+   */
+  void DumpProfile(const std::string &profile_filename) const;
+
+ private:
+  /*! \brief allocation */
+  struct Allocation {
+    std::string name;      // profiler scope and name of the storage handle
+    std::string opr;       // operator allocating, empty if none
+    std::string request;   // request of the allocating thread, empty if none
+    size_t size;           // requested size
+    size_t dev;            // device index in the profiler
+    uint64_t alloc_time;   // time of the allocation, in microseconds
+    uint64_t free_time;    // time of the free
+    uint64_t alloc_seq;    // order of the allocation among the allocations and frees
+    uint64_t free_seq;     // order of the free, 0 if live
+  };
+  /*! \brief protects the members below */
+  mutable std::mutex mutex_;
+  /*! \brief allocations in allocation order */
+  std::vector<Allocation> allocations_;
+  /*! \brief index in allocations_ of the live allocations */
+  std::unordered_map<void*, size_t> live_;
+  /*! \brief number of allocations and frees recorded */
+  uint64_t seq_ = 0;
+};
+
 /*!
  * \brief Storage allocation/deallocation profiling via ProfileCounters
  */
@@ -62,6 +111,7 @@ class DeviceStorageProfiler {
         }
         CHECK_LT(idx, mem_counters_.size()) << "Invalid device index: " << idx;
         *mem_counters_[idx] += handle.size;
+        MemoryTimeline::Get()->OnAlloc(handle);
       }
     }
   }
@@ -88,6 +138,7 @@ class DeviceStorageProfiler {
         } else {
             *mem_counters_[idx] = 0;
         }
+        MemoryTimeline::Get()->OnFree(handle);
       }
     }
   }
@@ -149,14 +200,16 @@ class GpuDeviceStorageProfiler {
             handle.name,
             handle.size,
             handle.ctx.dev_id,
-            actual_size, reuse};
+            actual_size, reuse,
+            prof->RequestName(CurrentRequestId())};
 #else
         gpu_mem_alloc_entries_[handle.dptr] = {
             handle.profiler_scope,
             handle.name,
             handle.size,
             handle.ctx.dev_id,
-            actual_size, reuse};
+            actual_size, reuse,
+            prof->RequestName(CurrentRequestId())};
 #endif
       }
     }
@@ -211,6 +264,7 @@ class GpuDeviceStorageProfiler {
     int dev_id;                  // device ID of the storage handle
     size_t actual_size;          // actual allocation size
     bool reuse;                  // whether the allocation is a reuse
+    std::string request;         // request of the allocating thread, empty for none
   };
   std::unordered_map<void*, AllocEntry> gpu_mem_alloc_entries_;
 };
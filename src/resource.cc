@@ -36,6 +36,7 @@
 #include "./common/utils.h"
 #include "./common/cuda/utils.h"
 #include "./profiler/storage_profiler.h"
+#include "./storage/storage_manager.h"
 
 namespace mxnet {
 namespace resource {
@@ -48,6 +49,10 @@ struct SpaceAllocator {
   Storage::Handle handle;
   // internal CPU handle
   Storage::Handle host_handle;
+  // scope of the space in the storage profiler
+  std::string profiler_scope = "resource:";
+  // memory pressure signals seen at the last request
+  uint64_t pressure = 0;
 
   SpaceAllocator() {
     handle.dptr = nullptr;
@@ -67,12 +72,17 @@ struct SpaceAllocator {
   }
 
   inline void* GetSpace(size_t size, const std::string &name) {
-    if (handle.size >= size) return handle.dptr;
+    // once a device ran short of memory, the next request shrinks the space to its size
+    const uint64_t pressure_count = storage::MemoryPressureCount();
+    const bool shrink = pressure_count != pressure && handle.size > size;
+    pressure = pressure_count;
+    if (handle.size >= size && !shrink) return handle.dptr;
 
     Storage::Get()->DirectFree(handle);
     handle = Storage::Get()->Alloc(size, ctx);
-    handle.profiler_scope = "resource:";
+    handle.profiler_scope = profiler_scope;
     handle.name = name;
+    profiler::MemoryTimeline::Get()->UpdateStorageInfo(handle);
 #if MXNET_USE_CUDA
     profiler::GpuDeviceStorageProfiler::Get()->UpdateStorageInfo(handle);
 #endif  // MXNET_USE_CUDA
@@ -176,6 +186,28 @@ class ResourceManagerImpl : public ResourceManager {
     return ret;
   }
 
+  Resource NewTempSpaceArena(Context ctx, const std::string &profiler_scope) override {
+    auto space = new SpaceAllocator();
+    space->ctx = ctx;
+    space->profiler_scope = profiler_scope;
+    Resource ret;
+    ret.req = ResourceRequest(ResourceRequest::kTempSpace);
+    ret.var = Engine::Get()->NewVariable();
+    ret.id = -1;
+    ret.ptr_ = space;
+    return ret;
+  }
+
+  void ReleaseTempSpaceArena(const Resource &arena) override {
+    CHECK_EQ(arena.req.type, ResourceRequest::kTempSpace);
+    auto space = static_cast<SpaceAllocator*>(arena.ptr_);
+    Engine::Get()->DeleteVariable(
+        [space](RunContext rctx) {
+          MSHADOW_CATCH_ERROR(space->ReleaseAll());
+          delete space;
+        }, space->ctx, arena.var);
+  }
+
   void SeedRandom(uint32_t seed) override {
     global_seed_ = seed;
     cpu_rand_->SeedWithDeviceID(global_seed_);
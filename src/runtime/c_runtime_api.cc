@@ -27,10 +27,13 @@
 #include <dmlc/thread_local.h>
 #include <mxnet/runtime/packed_func.h>
 #include <mxnet/runtime/registry.h>
+#include <mxnet/runtime/container.h>
+#include <mxnet/runtime/ndarray_handle.h>
 #include <sstream>
 #include <array>
 #include <algorithm>
 #include <string>
+#include <vector>
 #include <cstdlib>
 #include <cctype>
 
@@ -42,6 +45,9 @@ struct MXNetRuntimeEntry {
   std::string ret_str;
   MXNetByteArray ret_bytes;
   std::string last_error;
+  // the strings returned by MXNetFuncCallBatch
+  std::vector<std::string> batch_str;
+  std::vector<MXNetByteArray> batch_bytes;
 };
 
 
@@ -83,6 +89,96 @@ int MXNetFuncCall(MXNetFunctionHandle func,
   API_END();
 }
 
+int MXNetFuncCallBatch(int num_calls,
+                       MXNetFunctionHandle* funcs,
+                       int* num_args,
+                       MXNetValue* arg_values,
+                       int* type_codes,
+                       MXNetValue* ret_vals,
+                       int* ret_type_codes) {
+  API_BEGIN();
+  std::vector<size_t> offsets(num_calls + 1, 0);
+  for (int i = 0; i < num_calls; ++i) {
+    CHECK_GE(num_args[i], 0);
+    offsets[i + 1] = offsets[i] + num_args[i];
+  }
+  // the references are replaced in a copy of the arguments
+  std::vector<MXNetValue> values(arg_values, arg_values + offsets[num_calls]);
+  std::vector<int> codes(type_codes, type_codes + offsets[num_calls]);
+  std::vector<MXNetRetValue> rets(num_calls);
+  try {
+    for (int i = 0; i < num_calls; ++i) {
+      for (size_t k = offsets[i]; k < offsets[i + 1]; ++k) {
+        if (codes[k] != kBatchResult) continue;
+        const int64_t call = values[k].v_int64 >> 32;
+        const int64_t element = values[k].v_int64 & 0xffffffff;
+        CHECK(call >= 0 && call < i) << "argument " << k - offsets[i] << " of call " << i
+                                     << " refers to call " << call
+                                     << ", which is not an earlier call of the batch";
+        MXNetRetValue& ret = rets[call];
+        if (ret.type_code() == kPyArg) {
+          CHECK_EQ(element, 0) << "call " << call << " returns one of its arguments";
+          const size_t arg = offsets[call] + ret.value().v_int64;
+          values[k] = values[arg];
+          codes[k] = codes[arg];
+        } else if (ret.type_code() == kObjectHandle) {
+          ObjectRef value = ret;
+          if (element > 0) {
+            const ADT adt = Downcast<ADT>(value);
+            CHECK_LE(static_cast<size_t>(element), adt.size())
+                << "call " << call << " returns " << adt.size() << " elements, element "
+                << element - 1 << " is referred to";
+            value = adt[element - 1];
+          }
+          if (const auto* array = value.as<mxnet::NDArrayHandleObj>()) {
+            values[k].v_handle = array->value;
+            codes[k] = kNDArrayHandle;
+          } else {
+            // kept alive by the result of the call until the batch ends
+            values[k].v_handle = const_cast<Object*>(value.get());
+            codes[k] = kObjectHandle;
+          }
+        } else {
+          CHECK(element == 0 && ret.type_code() != kStr && ret.type_code() != kBytes)
+              << "the result of call " << call << " cannot be an argument";
+          values[k] = ret.value();
+          codes[k] = ret.type_code();
+        }
+      }
+      (*static_cast<const PackedFunc*>(funcs[i])).CallPacked(
+          MXNetArgs(values.data() + offsets[i], codes.data() + offsets[i], num_args[i]),
+          &rets[i]);
+    }
+  } catch (...) {
+    // the arrays created by the earlier calls are owned by nobody yet
+    for (MXNetRetValue& ret : rets) {
+      if (ret.type_code() == kNDArrayHandle) {
+        delete static_cast<mxnet::NDArray*>(ret.value().v_handle);
+      }
+    }
+    throw;
+  }
+  MXNetRuntimeEntry* e = MXNetAPIRuntimeStore::Get();
+  e->batch_str.assign(num_calls, std::string());
+  e->batch_bytes.resize(num_calls);
+  for (int i = 0; i < num_calls; ++i) {
+    if (rets[i].type_code() == kStr || rets[i].type_code() == kBytes) {
+      e->batch_str[i] = *rets[i].ptr<std::string>();
+      if (rets[i].type_code() == kBytes) {
+        e->batch_bytes[i].data = e->batch_str[i].c_str();
+        e->batch_bytes[i].size = e->batch_str[i].length();
+        ret_vals[i].v_handle = &(e->batch_bytes[i]);
+      } else {
+        ret_vals[i].v_str = e->batch_str[i].c_str();
+      }
+      ret_type_codes[i] = rets[i].type_code();
+    } else {
+      rets[i].MoveToCHost(&ret_vals[i], &ret_type_codes[i]);
+    }
+  }
+  API_END();
+}
+
 #ifndef _LIBCPP_SGX_NO_IOSTREAMS
 //--------------------------------------------------------
 // Error handling mechanism
@@ -26,6 +26,7 @@
 #define MXNET_STORAGE_CPU_DEVICE_STORAGE_H_
 
 #include "mxnet/base.h"
+#include "./cpu_hugepage_storage.h"
 
 namespace mxnet {
 namespace storage {
@@ -60,11 +61,15 @@ class CPUDeviceStorage {
 };  // class CPUDeviceStorage
 
 inline void CPUDeviceStorage::Alloc(Storage::Handle* handle) {
+  CPUHugePageStorage *huge_pages = CPUHugePageStorage::Get();
+  if (huge_pages->Accepts(handle->size) && huge_pages->Alloc(&handle->dptr, handle->size))
+    return;
   bool success = mxnet::common::AlignedMemAlloc(&(handle->dptr), handle->size, alignment_);
   if (!success) LOG(FATAL) << "Failed to allocate CPU Memory";
 }
 
 inline void CPUDeviceStorage::Free(Storage::Handle handle) {
+  if (CPUHugePageStorage::Get()->Free(handle.dptr)) return;
   mxnet::common::AlignedMemFree(handle.dptr);
 }
 
@@ -0,0 +1,171 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file cpu_hugepage_storage.h
+ * \brief CPU storage backed by 2MB huge pages.
+ *
+ *  Allocations of at least MXNET_CPU_HUGE_PAGE_THRESHOLD bytes (disabled by default)
+ *  are mapped with mmap on 2MB boundaries. With MXNET_CPU_HUGE_PAGE_EXPLICIT=1 the
+ *  pages come from the hugetlbfs reserve (MAP_HUGETLB, see /proc/sys/vm/nr_hugepages),
+ *  falling back to transparent huge pages when the reserve is exhausted. Otherwise the
+ *  mapping is only advised with MADV_HUGEPAGE, which needs transparent huge pages to be
+ *  set to "always" or "madvise". Large embedding tables and activations then need far
+ *  fewer TLB entries.
+ */
+#ifndef MXNET_STORAGE_CPU_HUGEPAGE_STORAGE_H_
+#define MXNET_STORAGE_CPU_HUGEPAGE_STORAGE_H_
+
+#include <dmlc/logging.h>
+#include <dmlc/parameter.h>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace mxnet {
+namespace storage {
+
+/*!
+ * \brief Allocator of CPU memory mapped on huge page boundaries.
+ *  Used by the CPU storage and the CPU memory pools for large allocations.
+ */
+class CPUHugePageStorage {
+ public:
+  /*! \brief size of the huge pages */
+  static constexpr size_t kHugePageSize = 2 * 1024 * 1024;
+
+  /*!
+   * \brief Constructor.
+   * \param threshold allocations of at least this size use huge pages, 0 to disable.
+   * \param explicit_pages whether to try the hugetlbfs reserve first.
+   */
+  CPUHugePageStorage(size_t threshold, bool explicit_pages)
+      : threshold_(threshold), explicit_(explicit_pages) {
+#if !defined(__linux__)
+    if (threshold_ != 0) {
+      LOG(WARNING) << "Huge page allocations are only supported on Linux, ignoring them";
+      threshold_ = 0;
+    }
+#endif
+  }
+  /*! \return the allocator configured by the environment */
+  static CPUHugePageStorage* Get() {
+    static CPUHugePageStorage inst(
+        dmlc::GetEnv("MXNET_CPU_HUGE_PAGE_THRESHOLD", static_cast<size_t>(0)),
+        dmlc::GetEnv("MXNET_CPU_HUGE_PAGE_EXPLICIT", false));
+    return &inst;
+  }
+  /*! \return whether an allocation of size bytes should be backed by huge pages */
+  inline bool Accepts(size_t size) const {
+    return threshold_ != 0 && size >= threshold_;
+  }
+  /*!
+   * \brief Map size bytes, rounded up to a multiple of kHugePageSize.
+   * \return whether the allocation succeeded.
+   */
+  bool Alloc(void** ptr, size_t size) {
+#if defined(__linux__)
+    size = RoundUp(size);
+    void* mem = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    if (explicit_) {
+      mem = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    }
+#endif  // MAP_HUGETLB
+    if (mem == MAP_FAILED) mem = MapAligned(size);
+    if (mem == nullptr) return false;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      sizes_[mem] = size;
+    }
+    *ptr = mem;
+    return true;
+#else
+    return false;
+#endif  // __linux__
+  }
+  /*!
+   * \brief Unmap memory allocated by Alloc.
+   * \return false if ptr was not allocated by Alloc, in which case nothing is done.
+   */
+  bool Free(void* ptr) {
+#if defined(__linux__)
+    if (threshold_ == 0) return false;
+    size_t size = 0;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = sizes_.find(ptr);
+      if (it == sizes_.end()) return false;
+      size = it->second;
+      sizes_.erase(it);
+    }
+    CHECK_EQ(munmap(ptr, size), 0) << "Failed to unmap huge page memory";
+    return true;
+#else
+    return false;
+#endif  // __linux__
+  }
+
+ private:
+  static inline size_t RoundUp(size_t size) {
+    return (size + kHugePageSize - 1) / kHugePageSize * kHugePageSize;
+  }
+
+#if defined(__linux__)
+  /*!
+   * \brief Map size bytes starting on a huge page boundary and advise huge pages,
+   *  by over-mapping and trimming the unaligned head and tail.
+   * \return the mapping, nullptr on failure.
+   */
+  static void* MapAligned(size_t size) {
+    const size_t mapped = size + kHugePageSize;
+    void* mem = mmap(nullptr, mapped, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) return nullptr;
+    const uintptr_t begin = reinterpret_cast<uintptr_t>(mem);
+    const uintptr_t aligned = (begin + kHugePageSize - 1) / kHugePageSize * kHugePageSize;
+    if (aligned != begin) munmap(mem, aligned - begin);
+    const size_t tail = mapped - (aligned - begin) - size;
+    if (tail != 0) munmap(reinterpret_cast<void*>(aligned + size), tail);
+#ifdef MADV_HUGEPAGE
+    // only a hint, the kernel may not have transparent huge pages enabled
+    madvise(reinterpret_cast<void*>(aligned), size, MADV_HUGEPAGE);
+#endif
+    return reinterpret_cast<void*>(aligned);
+  }
+#endif  // __linux__
+
+  /*! \brief allocations of at least this size use huge pages, 0 to disable */
+  size_t threshold_;
+  /*! \brief whether to try the hugetlbfs reserve first */
+  bool explicit_;
+  std::mutex mutex_;
+  /*! \brief size of the mappings, by address */
+  std::unordered_map<void*, size_t> sizes_;
+};  // class CPUHugePageStorage
+
+}  // namespace storage
+}  // namespace mxnet
+
+#endif  // MXNET_STORAGE_CPU_HUGEPAGE_STORAGE_H_
@@ -31,21 +31,43 @@
 #include <process.h>
 #endif  // _WIN32
 
+#include <algorithm>
+#include <list>
+#include <map>
+#include <memory>
 #include <string>
 #include <limits>
+#include <utility>
+#include <vector>
 #include "./storage_manager.h"
 
 namespace mxnet {
 namespace storage {
 /*!
  * \brief Storage manager for cpu shared memory
+ *
+ *  By default every allocation is a shared memory file of its own. On Linux,
+ *  MXNET_CPU_SHARED_MEM_POOL_TYPE=Pooled makes the manager carve the allocations
+ *  out of large shared segments instead, so that creating a shared array usually
+ *  takes no system call. A chunk is then identified across processes by the file
+ *  descriptor of its segment plus its offset in the segment (shared_offset). The
+ *  receiving process maps each segment once and keeps it mapped while it holds
+ *  chunks of it. A chunk is reused by the process that created it once the
+ *  reference count in its header drops to 0, whichever process releases it last.
  */
 class CPUSharedStorageManager final : public StorageManager {
  public:
   /*!
    * \brief Default constructor.
    */
-  CPUSharedStorageManager() : rand_gen_(std::random_device()()) {}
+  CPUSharedStorageManager() : rand_gen_(std::random_device()()) {
+#ifdef __linux__
+    pooled_ = dmlc::GetEnv("MXNET_CPU_SHARED_MEM_POOL_TYPE", std::string("Unpooled")) == "Pooled";
+    segment_size_ = dmlc::GetEnv("MXNET_CPU_SHARED_MEM_POOL_SEGMENT_SIZE",
+                                 static_cast<size_t>(64 << 20));
+    owner_pid_ = getpid();
+#endif  // __linux__
+  }
   /*!
    * \brief Default destructor.
    */
@@ -56,6 +78,12 @@ class CPUSharedStorageManager final : public StorageManager {
 #ifdef _WIN32
     CheckAndRealFree();
 #endif
+#ifdef __linux__
+    for (const auto& segment : segments_) {
+      munmap(segment->base, segment->size);
+      close(segment->fd);
+    }
+#endif  // __linux__
   }
 
   void Alloc(Storage::Handle* handle) override;
@@ -97,6 +125,61 @@ class CPUSharedStorageManager final : public StorageManager {
   void CheckAndRealFree();
 #endif
 
+#ifdef __linux__
+  /*! \brief shared segment, either sub-allocated by this process or mapped from another one */
+  struct Segment {
+    int fd;
+    char* base;
+    size_t size;
+    /*! \brief whether this process carves chunks out of the segment */
+    bool owned;
+    /*! \brief bytes already carved, for owned segments */
+    size_t used;
+    /*! \brief number of chunks of the segment held by this process, for mapped segments */
+    int live;
+    /*! \brief device and inode of the segment, for segments in mapped_segments_ */
+    std::pair<dev_t, ino_t> key;
+  };
+  /*! \brief chunk of a segment */
+  struct Chunk {
+    Segment* segment;
+    size_t offset;
+    size_t size;
+  };
+  /*! \brief chunks size granularity */
+  static constexpr size_t kChunkAlign = 4096;
+
+  void AllocPooled(Storage::Handle* handle);
+  void FreePooled(const Storage::Handle& handle);
+  /*! \brief create a new owned segment of at least size bytes */
+  Segment* NewSegment(size_t size);
+  /*!
+   * \brief Map the segment of a chunk created by another process, or by this one
+   *  and sent back, which then gets a separate mapping.
+   */
+  Segment* AttachSegment(int fd);
+  /*! \brief move the chunks no process references anymore to the free lists */
+  void Recycle();
+  /*!
+   * \brief After a fork the segments of the parent are still mapped, but the child
+   *  must not carve chunks out of them. They are unmapped once the child released
+   *  the chunks it inherited.
+   */
+  void ForgetParentSegments();
+
+  bool pooled_{false};
+  size_t segment_size_{0};
+  pid_t owner_pid_{-1};
+  std::list<std::unique_ptr<Segment>> segments_;
+  std::map<std::pair<dev_t, ino_t>, Segment*> mapped_segments_;
+  /*! \brief chunks in use in this process, by data pointer */
+  std::unordered_map<void*, Chunk> chunks_;
+  /*! \brief owned chunks released by this process, possibly still used by others */
+  std::vector<Chunk> released_;
+  /*! \brief owned chunks ready for reuse, by size */
+  std::unordered_map<size_t, std::vector<Chunk>> free_chunks_;
+#endif  // __linux__
+
   std::string SharedHandleToString(int shared_pid, int shared_id) {
     std::stringstream name;
     name << "/mx_" << std::hex << shared_pid << "_" << std::hex << shared_id;
@@ -107,6 +190,15 @@ class CPUSharedStorageManager final : public StorageManager {
 
 void CPUSharedStorageManager::Alloc(Storage::Handle* handle) {
   std::lock_guard<std::recursive_mutex> lock(mutex_);
+#ifdef __linux__
+  // chunks of pooled segments are recognized even if this process does not pool itself
+  if (handle->shared_offset >= 0 ||
+      (pooled_ && handle->shared_id == -1 && handle->shared_pid == -1)) {
+    AllocPooled(handle);
+    pool_[handle->dptr] = *handle;
+    return;
+  }
+#endif  // __linux__
   std::uniform_int_distribution<> dis(0, std::numeric_limits<int>::max());
   int fid = -1;
   std::string filename;
@@ -200,6 +292,12 @@ void CPUSharedStorageManager::Alloc(Storage::Handle* handle) {
 }
 
 void CPUSharedStorageManager::FreeImpl(const Storage::Handle& handle) {
+#ifdef __linux__
+  if (handle.shared_offset >= 0) {
+    FreePooled(handle);
+    return;
+  }
+#endif  // __linux__
   int count = DecrementRefCount(handle);
   CHECK_GE(count, 0);
 #ifdef _WIN32
@@ -227,6 +325,151 @@ void CPUSharedStorageManager::FreeImpl(const Storage::Handle& handle) {
 #endif  // _WIN32
 }
 
+#ifdef __linux__
+inline void CPUSharedStorageManager::AllocPooled(Storage::Handle* handle) {
+  Chunk chunk;
+  if (handle->shared_offset < 0) {
+    // new chunk, carved out of a segment of this process
+    if (getpid() != owner_pid_) ForgetParentSegments();
+    Recycle();
+    const size_t size = (handle->size + alignment_ + kChunkAlign - 1) / kChunkAlign * kChunkAlign;
+    auto& reusable = free_chunks_[size];
+    if (!reusable.empty()) {
+      chunk = reusable.back();
+      reusable.pop_back();
+    } else {
+      Segment* segment = segments_.empty() ? nullptr : segments_.back().get();
+      if (segment == nullptr || !segment->owned || segment->used + size > segment->size) {
+        segment = NewSegment(size);
+      }
+      chunk = Chunk{segment, segment->used, size};
+      segment->used += size;
+    }
+    new (chunk.segment->base + chunk.offset) std::atomic<int>(1);
+    handle->shared_pid = getpid();
+    handle->shared_offset = static_cast<int64_t>(chunk.offset);
+  } else {
+    // chunk created by another process, the handle carries a descriptor of its segment
+    Segment* segment = AttachSegment(handle->shared_id);
+    CHECK_LE(static_cast<size_t>(handle->shared_offset) + alignment_ + handle->size,
+             segment->size) << "Invalid offset in shared memory segment";
+    ++segment->live;
+    chunk = Chunk{segment, static_cast<size_t>(handle->shared_offset), 0};
+  }
+  handle->shared_id = chunk.segment->fd;
+  handle->dptr = chunk.segment->base + chunk.offset + alignment_;
+  chunks_[handle->dptr] = chunk;
+}
+
+inline void CPUSharedStorageManager::FreePooled(const Storage::Handle& handle) {
+  auto it = chunks_.find(handle.dptr);
+  CHECK(it != chunks_.end()) << "Freeing shared memory not allocated by this process";
+  const Chunk chunk = it->second;
+  chunks_.erase(it);
+  const int count = DecrementRefCount(handle);
+  CHECK_GE(count, 0);
+  Segment* segment = chunk.segment;
+  if (segment->owned) {
+    if (count == 0) {
+      free_chunks_[chunk.size].push_back(chunk);
+    } else {
+      released_.push_back(chunk);
+    }
+  } else if (--segment->live == 0) {
+    CHECK_EQ(munmap(segment->base, segment->size), 0)
+        << "Failed to unmap shared memory. munmap failed with error " << strerror(errno);
+    CHECK_EQ(close(segment->fd), 0)
+        << "Failed to close shared memory. close failed with error " << strerror(errno);
+    mapped_segments_.erase(segment->key);
+    segments_.remove_if([segment](const std::unique_ptr<Segment>& s) {
+      return s.get() == segment;
+    });
+  }
+}
+
+inline CPUSharedStorageManager::Segment* CPUSharedStorageManager::NewSegment(size_t size) {
+  size = std::max(size, segment_size_);
+  std::uniform_int_distribution<> dis(0, std::numeric_limits<int>::max());
+  std::string filename;
+  int fid = -1;
+  for (int i = 0; i < 10; ++i) {
+    filename = SharedHandleToString(getpid(), dis(rand_gen_));
+    fid = shm_open(filename.c_str(), O_EXCL|O_CREAT|O_RDWR, 0666);
+    if (fid != -1) break;
+  }
+  if (fid == -1) {
+    LOG(FATAL) << "Failed to open shared memory. shm_open failed with error "
+               << strerror(errno);
+  }
+  CHECK_EQ(ftruncate(fid, size), 0);
+  void* ptr = mmap(nullptr, size, PROT_READ|PROT_WRITE, MAP_SHARED, fid, 0);
+  CHECK_NE(ptr, MAP_FAILED)
+      << "Failed to map shared memory. mmap failed with error " << strerror(errno);
+  CHECK_EQ(shm_unlink(filename.c_str()), 0)
+      << "Failed to unlink shared memory. shm_unlink failed with error " << strerror(errno);
+  segments_.emplace_back(new Segment{fid, static_cast<char*>(ptr), size, true, 0, 0, {}});
+  return segments_.back().get();
+}
+
+inline CPUSharedStorageManager::Segment* CPUSharedStorageManager::AttachSegment(int fd) {
+  CHECK_NE(fd, -1) << "Invalid file descriptor from shared array.";
+  struct stat st;
+  CHECK_EQ(fstat(fd, &st), 0) << "Failed to stat shared memory. fstat failed with error "
+                              << strerror(errno);
+  const std::pair<dev_t, ino_t> key(st.st_dev, st.st_ino);
+  auto it = mapped_segments_.find(key);
+  if (it != mapped_segments_.end()) {
+    // already mapped, the descriptor we were handed is not needed
+    if (fd != it->second->fd) close(fd);
+    return it->second;
+  }
+  const size_t size = static_cast<size_t>(st.st_size);
+  void* ptr = mmap(nullptr, size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+  CHECK_NE(ptr, MAP_FAILED)
+      << "Failed to map shared memory. mmap failed with error " << strerror(errno);
+  segments_.emplace_back(new Segment{fd, static_cast<char*>(ptr), size, false, 0, 0, key});
+  mapped_segments_[key] = segments_.back().get();
+  return segments_.back().get();
+}
+
+inline void CPUSharedStorageManager::Recycle() {
+  auto unused = std::partition(released_.begin(), released_.end(), [](const Chunk& chunk) {
+    return reinterpret_cast<std::atomic<int>*>(chunk.segment->base + chunk.offset)->load() != 0;
+  });
+  for (auto it = unused; it != released_.end(); ++it) {
+    free_chunks_[it->size].push_back(*it);
+  }
+  released_.erase(unused, released_.end());
+}
+
+inline void CPUSharedStorageManager::ForgetParentSegments() {
+  owner_pid_ = getpid();
+  released_.clear();
+  free_chunks_.clear();
+  for (auto& segment : segments_) {
+    if (!segment->owned) continue;
+    // kept out of mapped_segments_, chunks received later get a mapping of their own
+    segment->owned = false;
+    segment->live = 0;
+    for (const auto& kv : chunks_) {
+      if (kv.second.segment == segment.get()) ++segment->live;
+    }
+  }
+  // segments the child holds no chunk of are of no use to it
+  for (auto it = segments_.begin(); it != segments_.end();) {
+    Segment* segment = it->get();
+    if (segment->live == 0) {
+      munmap(segment->base, segment->size);
+      close(segment->fd);
+      mapped_segments_.erase(segment->key);
+      it = segments_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+#endif  // __linux__
+
 #ifdef _WIN32
 inline void CPUSharedStorageManager::CheckAndRealFree() {
   std::lock_guard<std::recursive_mutex> lock(mutex_);
@@ -0,0 +1,135 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file gpu_async_storage_manager.h
+ * \brief GPU storage manager based on stream-ordered allocation.
+ */
+#ifndef MXNET_STORAGE_GPU_ASYNC_STORAGE_MANAGER_H_
+#define MXNET_STORAGE_GPU_ASYNC_STORAGE_MANAGER_H_
+
+#if MXNET_USE_CUDA
+#include <cuda_runtime.h>
+#include <dmlc/parameter.h>
+#include <cstdint>
+#include <limits>
+#include "./storage_manager.h"
+#include "../common/cuda/utils.h"
+#include "../profiler/storage_profiler.h"
+
+// cudaMallocFromPoolAsync and cudaMemPoolCreate appeared in CUDA 11.2
+#define MXNET_CUDA_MALLOC_ASYNC_SUPPORTED (CUDART_VERSION >= 11020)
+
+namespace mxnet {
+namespace storage {
+
+#if MXNET_CUDA_MALLOC_ASYNC_SUPPORTED
+/*!
+ * \brief Storage manager allocating GPU memory with cudaMallocFromPoolAsync.
+ *
+ *  Unlike cudaFree, which synchronizes the whole device, frees are only ordered on
+ *  an allocation stream owned by the manager and the memory goes back to a CUDA
+ *  memory pool that the driver recycles for the following allocations. The engine
+ *  frees memory only after the operators using it completed and synchronized their
+ *  streams, so nothing needs to be ordered against the compute streams. The
+ *  allocation stream carries no kernel, hence waiting for it after an allocation,
+ *  so that the memory can be used on any stream, does not wait for any compute.
+ *
+ *  The pool keeps up to MXNET_GPU_MEM_POOL_RELEASE_THRESHOLD bytes of freed memory
+ *  cached, everything by default. Selected with MXNET_GPU_MEM_POOL_TYPE=Async.
+ */
+class GPUAsyncStorageManager final : public StorageManager {
+ public:
+  explicit GPUAsyncStorageManager(const Context &ctx) : dev_id_(ctx.real_dev_id()) {
+    mxnet::common::cuda::DeviceStore device_store(dev_id_, true);
+    int supported = 0;
+    CUDA_CALL(cudaDeviceGetAttribute(&supported, cudaDevAttrMemoryPoolsSupported, dev_id_));
+    CHECK(supported) << "GPU " << dev_id_ << " does not support stream-ordered allocation, "
+                     << "MXNET_GPU_MEM_POOL_TYPE=Async cannot be used";
+    cudaMemPoolProps props = {};
+    props.allocType = cudaMemAllocationTypePinned;
+    props.location.type = cudaMemLocationTypeDevice;
+    props.location.id = dev_id_;
+    CUDA_CALL(cudaMemPoolCreate(&pool_, &props));
+    uint64_t threshold = dmlc::GetEnv("MXNET_GPU_MEM_POOL_RELEASE_THRESHOLD",
+                                      std::numeric_limits<uint64_t>::max());
+    CUDA_CALL(cudaMemPoolSetAttribute(pool_, cudaMemPoolAttrReleaseThreshold, &threshold));
+    CUDA_CALL(cudaStreamCreateWithFlags(&stream_, cudaStreamNonBlocking));
+  }
+  ~GPUAsyncStorageManager() override {
+    // errors are ignored, the driver may be shutting down
+    cudaStreamSynchronize(stream_);
+    cudaStreamDestroy(stream_);
+    cudaMemPoolDestroy(pool_);
+  }
+
+  void Alloc(Storage::Handle* handle) override {
+    mxnet::common::cuda::DeviceStore device_store(dev_id_, true);
+    cudaError_t e = cudaMallocFromPoolAsync(&handle->dptr, handle->size, pool_, stream_);
+    if (e != cudaSuccess) {
+      // give the cached memory back to the device and retry
+      cudaGetLastError();
+      TrimPool();
+      e = cudaMallocFromPoolAsync(&handle->dptr, handle->size, pool_, stream_);
+    }
+    if (e != cudaSuccess) {
+      LOG(FATAL) << "Memory allocation failed " << cudaGetErrorString(e);
+    }
+    // make the memory usable on the other streams
+    CUDA_CALL(cudaStreamSynchronize(stream_));
+    profiler::GpuDeviceStorageProfiler::Get()->OnAlloc(*handle, handle->size, false);
+  }
+
+  void Free(Storage::Handle handle) override {
+    mxnet::common::cuda::DeviceStore device_store(dev_id_, true);
+    CUDA_CALL(cudaFreeAsync(handle.dptr, stream_));
+    profiler::GpuDeviceStorageProfiler::Get()->OnFree(handle);
+  }
+
+  void DirectFree(Storage::Handle handle) override {
+    // The pool decides when memory goes back to the device
+    Free(handle);
+  }
+
+  void ReleaseAll() override {
+    mxnet::common::cuda::DeviceStore device_store(dev_id_, true);
+    TrimPool();
+  }
+
+ private:
+  /*! \brief wait for the pending frees and release the unused memory of the pool */
+  void TrimPool() {
+    CUDA_CALL(cudaStreamSynchronize(stream_));
+    CUDA_CALL(cudaMemPoolTrimTo(pool_, 0));
+  }
+
+  /*! \brief device of the pool */
+  int dev_id_;
+  /*! \brief memory pool the allocations come from */
+  cudaMemPool_t pool_{nullptr};
+  /*! \brief stream the allocations and frees are ordered on */
+  cudaStream_t stream_{nullptr};
+};  // class GPUAsyncStorageManager
+#endif  // MXNET_CUDA_MALLOC_ASYNC_SUPPORTED
+
+}  // namespace storage
+}  // namespace mxnet
+
+#endif  // MXNET_USE_CUDA
+#endif  // MXNET_STORAGE_GPU_ASYNC_STORAGE_MANAGER_H_
@@ -0,0 +1,150 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file gpu_managed_storage_manager.h
+ * \brief GPU storage manager oversubscribing the device with CUDA managed memory.
+ */
+#ifndef MXNET_STORAGE_GPU_MANAGED_STORAGE_MANAGER_H_
+#define MXNET_STORAGE_GPU_MANAGED_STORAGE_MANAGER_H_
+
+#if MXNET_USE_CUDA
+#include <cuda_runtime.h>
+#include <dmlc/parameter.h>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include "./storage_manager.h"
+#include "../common/cuda/utils.h"
+#include "../profiler/storage_profiler.h"
+
+namespace mxnet {
+namespace storage {
+
+/*!
+ * \brief Storage manager allocating the large arrays with cudaMallocManaged, and the others
+ *  with the GPU memory pool.
+ *
+ *  Managed memory may exceed the memory of the device: the driver migrates its pages on
+ *  demand and evicts them to the host, so that a model slightly too large for the GPU runs
+ *  slower instead of failing. An allocation is managed if it is at least
+ *  MXNET_GPU_MEM_MANAGED_MIN_SIZE bytes, or if the pool fails to allocate it. Its preferred
+ *  location is the GPU, and the operators prefetch it to the GPU on their stream before
+ *  running, except from MXNET_GPU_MEM_MANAGED_HOST_SIZE bytes, where the pages stay on the
+ *  host and the GPU reads them over the bus, which suits large arrays rarely used as a
+ *  whole, like frozen embeddings. Selected with MXNET_GPU_MEM_MANAGED=1.
+ */
+class GPUManagedStorageManager final : public StorageManager {
+ public:
+  GPUManagedStorageManager(const Context &ctx, StorageManager *pool)
+      : dev_id_(ctx.real_dev_id()), pool_(pool) {
+    int supported = 0;
+    CUDA_CALL(cudaDeviceGetAttribute(&supported, cudaDevAttrConcurrentManagedAccess, dev_id_));
+    CHECK(supported) << "GPU " << dev_id_ << " cannot oversubscribe its memory with managed "
+                     << "memory, MXNET_GPU_MEM_MANAGED=1 cannot be used";
+    min_size_ = dmlc::GetEnv("MXNET_GPU_MEM_MANAGED_MIN_SIZE",
+                             std::numeric_limits<size_t>::max());
+    host_size_ = dmlc::GetEnv("MXNET_GPU_MEM_MANAGED_HOST_SIZE",
+                              std::numeric_limits<size_t>::max());
+  }
+
+  void Alloc(Storage::Handle* handle) override {
+    if (handle->size < min_size_) {
+      try {
+        pool_->Alloc(handle);
+        return;
+      } catch (const dmlc::Error &e) {
+        // out of device memory even after the pool released its cache
+        cudaGetLastError();
+        LOG(WARNING) << "GPU " << dev_id_ << " out of memory for " << handle->size
+                     << " bytes, allocating managed memory: " << e.what();
+      }
+    }
+    mxnet::common::cuda::DeviceStore device_store(dev_id_, true);
+    const cudaError_t e = cudaMallocManaged(&handle->dptr, handle->size, cudaMemAttachGlobal);
+    if (e != cudaSuccess) {
+      cudaGetLastError();
+      LOG(FATAL) << "Managed memory allocation failed " << cudaGetErrorString(e);
+    }
+    const bool on_host = handle->size >= host_size_;
+    CUDA_CALL(cudaMemAdvise(handle->dptr, handle->size, cudaMemAdviseSetPreferredLocation,
+                            on_host ? cudaCpuDeviceId : dev_id_));
+    // mapped in the page tables of the GPU, which reads the pages on the host without a fault
+    CUDA_CALL(cudaMemAdvise(handle->dptr, handle->size, cudaMemAdviseSetAccessedBy, dev_id_));
+    handle->managed = true;
+    handle->managed_prefetch = !on_host;
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      managed_bytes_ += handle->size;
+    }
+    profiler::GpuDeviceStorageProfiler::Get()->OnAlloc(*handle, handle->size, false);
+  }
+
+  void Free(Storage::Handle handle) override {
+    if (!handle.managed) {
+      pool_->Free(handle);
+      return;
+    }
+    DirectFree(handle);
+  }
+
+  void DirectFree(Storage::Handle handle) override {
+    if (!handle.managed) {
+      pool_->DirectFree(handle);
+      return;
+    }
+    mxnet::common::cuda::DeviceStore device_store(dev_id_, true);
+    CUDA_CALL(cudaFree(handle.dptr));
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      managed_bytes_ -= handle.size;
+    }
+    profiler::GpuDeviceStorageProfiler::Get()->OnFree(handle);
+  }
+
+  void ReleaseAll() override {
+    pool_->ReleaseAll();
+  }
+
+  bool GetStats(Storage::Stats* stats) override {
+    const bool has_stats = pool_->GetStats(stats);
+    std::lock_guard<std::mutex> lock(mu_);
+    stats->bytes_in_use += managed_bytes_;
+    return has_stats;
+  }
+
+ private:
+  /*! \brief device of the manager */
+  int dev_id_;
+  /*! \brief memory pool of the allocations not managed */
+  std::unique_ptr<StorageManager> pool_;
+  /*! \brief size from which the allocations are managed */
+  size_t min_size_;
+  /*! \brief size from which managed memory prefers the host */
+  size_t host_size_;
+  /*! \brief bytes of managed memory not freed yet */
+  size_t managed_bytes_{0};
+  std::mutex mu_;
+};  // class GPUManagedStorageManager
+
+}  // namespace storage
+}  // namespace mxnet
+
+#endif  // MXNET_USE_CUDA
+#endif  // MXNET_STORAGE_GPU_MANAGED_STORAGE_MANAGER_H_
@@ -0,0 +1,162 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file gpu_shared_storage_manager.h
+ * \brief GPU memory shared between processes with CUDA IPC.
+ */
+#ifndef MXNET_STORAGE_GPU_SHARED_STORAGE_MANAGER_H_
+#define MXNET_STORAGE_GPU_SHARED_STORAGE_MANAGER_H_
+
+#if MXNET_USE_CUDA
+#include <cuda.h>
+#include <cuda_runtime.h>
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "./storage_manager.h"
+#include "../common/cuda/utils.h"
+
+namespace mxnet {
+namespace storage {
+
+/*!
+ * \brief Storage manager of the GPU memory of other processes, opened with
+ *  cudaIpcOpenMemHandle.
+ *
+ *  A process exports the allocation an array is in with cudaIpcGetMemHandle. The handle plus
+ *  the offset of the array in the allocation (shared_offset) identify the array in every
+ *  process of the machine. The process importing arrays opens each allocation once, and
+ *  keeps it open while it holds arrays in it, counting them. The exporting process keeps the
+ *  memory: its arrays must outlive the arrays imported from them. An allocation exported
+ *  and imported by the same process is not opened, since CUDA forbids it.
+ */
+class GPUSharedStorageManager final : public StorageManager {
+ public:
+  explicit GPUSharedStorageManager(const Context &ctx) : dev_id_(ctx.real_dev_id()) {
+    static_assert(sizeof(cudaIpcMemHandle_t) == MXNET_GPU_IPC_HANDLE_SIZE,
+                  "Unexpected size of cudaIpcMemHandle_t");
+  }
+
+  ~GPUSharedStorageManager() {
+    for (const auto& kv : opened_) {
+      if (kv.second.opened) cudaIpcCloseMemHandle(kv.second.base);
+    }
+  }
+
+  /*!
+   * \brief Fill ipc_handle and shared_offset of a handle of GPU memory of this process.
+   */
+  void Export(Storage::Handle* handle) {
+    CHECK(!handle->managed) << "CUDA managed memory cannot be shared with CUDA IPC";
+    mxnet::common::cuda::DeviceStore device_store(dev_id_, true);
+    CUdeviceptr base;
+    size_t size;
+    CUDA_DRIVER_CALL(cuMemGetAddressRange(&base, &size,
+                                          reinterpret_cast<CUdeviceptr>(handle->dptr)));
+    cudaIpcMemHandle_t ipc_handle;
+    const cudaError_t e = cudaIpcGetMemHandle(&ipc_handle, reinterpret_cast<void*>(base));
+    if (e != cudaSuccess) {
+      cudaGetLastError();
+      LOG(FATAL) << "Cannot share the GPU memory with CUDA IPC, it must come from cudaMalloc "
+                 << "(not MXNET_GPU_MEM_POOL_TYPE=Async): " << cudaGetErrorString(e);
+    }
+    handle->ipc_handle.assign(reinterpret_cast<const char*>(&ipc_handle), sizeof(ipc_handle));
+    handle->shared_offset = static_cast<char*>(handle->dptr) -
+                            reinterpret_cast<char*>(base);
+    std::lock_guard<std::mutex> lock(mutex_);
+    exported_[handle->ipc_handle] = reinterpret_cast<void*>(base);
+  }
+
+  /*!
+   * \brief Open the memory identified by ipc_handle and shared_offset.
+   */
+  void Alloc(Storage::Handle* handle) override {
+    CHECK_EQ(handle->ipc_handle.size(), sizeof(cudaIpcMemHandle_t));
+    CHECK_GE(handle->shared_offset, 0);
+    std::lock_guard<std::mutex> lock(mutex_);
+    Allocation& allocation = opened_[handle->ipc_handle];
+    if (allocation.count == 0) {
+      auto it = exported_.find(handle->ipc_handle);
+      if (it != exported_.end()) {
+        allocation.base = it->second;
+        allocation.opened = false;
+      } else {
+        mxnet::common::cuda::DeviceStore device_store(dev_id_, true);
+        cudaIpcMemHandle_t ipc_handle;
+        std::copy(handle->ipc_handle.begin(), handle->ipc_handle.end(),
+                  reinterpret_cast<char*>(&ipc_handle));
+        const cudaError_t e = cudaIpcOpenMemHandle(&allocation.base, ipc_handle,
+                                                   cudaIpcMemLazyEnablePeerAccess);
+        if (e != cudaSuccess) {
+          cudaGetLastError();
+          opened_.erase(handle->ipc_handle);
+          LOG(FATAL) << "Cannot open the GPU memory of another process on GPU " << dev_id_
+                     << ": " << cudaGetErrorString(e);
+        }
+        allocation.opened = true;
+      }
+    }
+    ++allocation.count;
+    handle->dptr = static_cast<char*>(allocation.base) + handle->shared_offset;
+  }
+
+  /*!
+   * \brief Close the memory of the handle once no array of this process is in it.
+   */
+  void Free(Storage::Handle handle) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = opened_.find(handle.ipc_handle);
+    CHECK(it != opened_.end()) << "GPU memory of another process freed twice";
+    if (--it->second.count > 0) return;
+    if (it->second.opened) {
+      mxnet::common::cuda::DeviceStore device_store(dev_id_, true);
+      CUDA_CALL(cudaIpcCloseMemHandle(it->second.base));
+    }
+    opened_.erase(it);
+  }
+
+  void DirectFree(Storage::Handle handle) override {
+    Free(handle);
+  }
+
+ private:
+  /*! \brief allocation of another process, opened by this one */
+  struct Allocation {
+    void* base{nullptr};
+    /*! \brief number of arrays of this process in the allocation */
+    int count{0};
+    /*! \brief whether cudaIpcOpenMemHandle opened it, false if exported by this process */
+    bool opened{false};
+  };
+  /*! \brief device of the manager */
+  int dev_id_;
+  /*! \brief opened allocations, by cudaIpcMemHandle_t bytes */
+  std::unordered_map<std::string, Allocation> opened_;
+  /*! \brief base of the allocations exported by this process, by cudaIpcMemHandle_t bytes */
+  std::unordered_map<std::string, void*> exported_;
+  std::mutex mutex_;
+};  // class GPUSharedStorageManager
+
+}  // namespace storage
+}  // namespace mxnet
+
+#endif  // MXNET_USE_CUDA
+#endif  // MXNET_STORAGE_GPU_SHARED_STORAGE_MANAGER_H_
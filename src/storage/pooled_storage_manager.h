@@ -28,8 +28,13 @@
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <set>
 #include <tuple>
+#include <unordered_map>
+#include <utility>
 #include "./storage_manager.h"
 #include "../profiler/storage_profiler.h"
 
@@ -48,9 +53,11 @@ typedef enum {
 const std::string env_var_name(const char* dev_type, env_var_type type);
 
 #if MXNET_USE_CUDA
+// the device is restored when an allocation failure unwinds the stack too
 #define SET_DEVICE(device_store, contextHelper, ctx, flag) \
-      const auto *device_store = flag? contextHelper.get()->SetCurrentDevice(ctx) : nullptr;
-#define UNSET_DEVICE(device_store)    delete device_store
+      std::unique_ptr<const CudaDeviceStore> device_store( \
+          flag? contextHelper.get()->SetCurrentDevice(ctx) : nullptr);
+#define UNSET_DEVICE(device_store)    device_store.reset()
 
 #define SET_GPU_PROFILER(prof, contextHelper)                          \
       auto prof = contextHelper->contextGPU()?                         \
@@ -66,6 +73,59 @@ const std::string env_var_name(const char* dev_type, env_var_type type);
 #define GPU_PROFILER_ON_FREE(prof, ...)
 #endif
 
+/*!
+ * \brief Create the helper doing the actual allocations of a pool for a context.
+ * \param ctx context of the pool
+ * \param num_gpu_device number of GPUs, CPU_PINNED memory is plain CPU memory without GPUs
+ * \param dev_type set to the device type whose storage mutex protects the pool
+ * \param helper set to the helper
+ * \return the name of the device used in the environment variables configuring the pool
+ */
+inline const char *CreateContextHelper(const Context &ctx, int num_gpu_device,
+                                       Context::DeviceType *dev_type,
+                                       std::unique_ptr<ContextHelper> *helper) {
+  const char *dev_name = nullptr;
+  switch (*dev_type = ctx.dev_type) {
+#if MXNET_USE_CUDA
+    case Context::kGPU:       *helper = std::make_unique<ContextHelperGPU>();
+                              dev_name = "GPU";
+                              break;
+    case Context::kCPUPinned: dev_name = "CPU_PINNED";
+                              if (num_gpu_device > 1) {
+                                *helper = std::make_unique<ContextHelperPinned>();
+                                *dev_type = Context::kGPU;
+                                break;
+                              }
+#else
+    case Context::kCPUPinned: dev_name = "CPU_PINNED";
+#endif
+                              *dev_type = Context::kCPU;
+    case Context::kCPU:       *helper = std::make_unique<ContextHelperCPU>();
+                              dev_name = "CPU";
+    default:                  break;
+  }
+  return dev_name;
+}
+
+/*! \brief Reset the error state left by a failed allocation, so that it can be retried */
+inline void ClearAllocationError(Context::DeviceType dev_type) {
+#if MXNET_USE_CUDA
+  if (dev_type == Context::kGPU) cudaGetLastError();
+#endif
+}
+
+/*!
+ * \brief Amount of memory a pool must leave free, set in percent of the total memory
+ *  through MXNET_<dev_type>_MEM_POOL_RESERVE.
+ */
+inline size_t ReservedMemory(const char *dev_type, const ContextHelper *helper) {
+  if (!dev_type) return 0;
+  const auto env_var = env_var_name(dev_type, pool_reserve);
+  const size_t reserve = dmlc::GetEnv(env_var.c_str(), 5);
+  const size_t total = std::get<1>(helper->getMemoryInfo());
+  return total * reserve / 100;
+}
+
 /*!
  * \brief Storage manager with a memory pool for GPU/CPU/CPUPunned memory chunks
  * memory chunks which reused based on rounded size match.
@@ -79,38 +139,11 @@ class PooledStorageManager : public StorageManager,
              public BucketingStrategy, public StoringMethod {
  public:
   explicit PooledStorageManager(const Context &ctx, int num_gpu_device) {
-    const char *dev_type = nullptr;
-    switch (dev_type_ = ctx.dev_type) {
-#if MXNET_USE_CUDA
-      case Context::kGPU:       contextHelper_ = std::make_unique<ContextHelperGPU>();
-                                dev_type = "GPU";
-                                break;
-      case Context::kCPUPinned: dev_type = "CPU_PINNED";
-                                if (num_gpu_device > 1) {
-                                  contextHelper_ = std::make_unique<ContextHelperPinned>();
-                                  dev_type_ = Context::kGPU;
-                                  break;
-                                }
-#else
-      case Context::kCPUPinned: dev_type = "CPU_PINNED";
-#endif
-                                dev_type_ = Context::kCPU;
-      case Context::kCPU:       contextHelper_ = std::make_unique<ContextHelperCPU>();
-                                dev_type = "CPU";
-      default:                  break;
-    }
-
+    const char *dev_type = CreateContextHelper(ctx, num_gpu_device, &dev_type_, &contextHelper_);
     BucketingStrategy::InitRoundHelper(dev_type);
     StoringMethod::InitContainer(this);
     contextHelper_->set_initilal_context(ctx);
-
-    // percentage of reserved memory
-    if (dev_type) {
-      const auto env_var = env_var_name(dev_type, pool_reserve);
-      const size_t reserve = dmlc::GetEnv(env_var.c_str(), 5);
-      const size_t total = std::get<1>(contextHelper_->getMemoryInfo());
-      memory_allocation_limit_ = total * reserve / 100;
-    }
+    memory_allocation_limit_ = ReservedMemory(dev_type, contextHelper_.get());
   }
   /*!
    * \brief Default destructor.
@@ -123,7 +156,9 @@ class PooledStorageManager : public StorageManager,
   void Free(Storage::Handle handle) override {
     // Insert returned memory in cache
     std::lock_guard<std::mutex> lock(Storage::Get()->GetMutex(dev_type_));
-    StoringMethod::InsertInCache(BucketingStrategy::get_bucket(handle.size), handle.dptr);
+    const auto bucket_id = BucketingStrategy::get_bucket(handle.size);
+    StoringMethod::InsertInCache(bucket_id, handle.dptr);
+    in_use_ -= BucketingStrategy::RoundAllocSizeForBucket(bucket_id);
   }
 
   void DirectFree(Storage::Handle handle) override {
@@ -134,6 +169,7 @@ class PooledStorageManager : public StorageManager,
     GPU_PROFILER_ON_FREE(profilerGPU, handle.dptr);
     UNSET_DEVICE(device_store);
     used_memory_ -= BucketingStrategy::RoundAllocSize(handle.size);
+    in_use_ -= BucketingStrategy::RoundAllocSize(handle.size);
   }
 
   void ReleaseAll() override {
@@ -141,6 +177,18 @@ class PooledStorageManager : public StorageManager,
     ReleaseAllNoLock();
   }
 
+  bool GetStats(Storage::Stats* stats) override {
+    std::lock_guard<std::mutex> lock(Storage::Get()->GetMutex(dev_type_));
+    stats->bytes_in_use = in_use_;
+    stats->bytes_cached = used_memory_ - in_use_;
+    stats->peak_bytes_in_use = peak_in_use_;
+    stats->num_allocs = num_allocs_;
+    stats->num_pool_hits = num_pool_hits_;
+    StoringMethod::GetFreeChunks(this, &stats->free_chunks);
+    stats->largest_free_chunk = stats->free_chunks.empty() ? 0 : stats->free_chunks.back().first;
+    return true;
+  }
+
  private:
   void ReleaseAllNoLock(bool set_device = true) {
     SET_DEVICE(device_store, contextHelper_, contextHelper_->initilal_context(), set_device);
@@ -157,6 +205,13 @@ class PooledStorageManager : public StorageManager,
   Context::DeviceType dev_type_;
   // used memory
   size_t used_memory_ = 0;
+  // memory of the chunks handed out, the rest of used_memory_ is cached
+  size_t in_use_ = 0;
+  // highest value of in_use_
+  size_t peak_in_use_ = 0;
+  // number of allocations, and of those reusing a cached chunk
+  uint64_t num_allocs_ = 0;
+  uint64_t num_pool_hits_ = 0;
   // minimum amount of memory, which will never be allocated
   size_t memory_allocation_limit_ = 0;
   // Pointer to the Helper, supporting some context-specific operations in GPU/CPU/CPUPinned context
@@ -167,16 +222,24 @@ template<typename BucketingStrategy, typename StoringMethod>
 void PooledStorageManager<BucketingStrategy, StoringMethod>::Alloc(Storage::Handle* handle) {
   std::lock_guard<std::mutex> lock(Storage::Get()->GetMutex(dev_type_));
   const auto bucket_id = BucketingStrategy::get_bucket(handle->size);
-  size_t roundSize = 0;
+  const size_t roundSize = BucketingStrategy::RoundAllocSizeForBucket(bucket_id);
   auto reuse_pool = StoringMethod::GetMemStorage(bucket_id);
   if (!reuse_pool) {
     SET_DEVICE(device_store, contextHelper_, handle->ctx, true);
-    roundSize = BucketingStrategy::RoundAllocSizeForBucket(bucket_id);
-    if (!MemoryIsAvalable(roundSize))
+    if (!MemoryIsAvalable(roundSize)) {
+      NotifyMemoryPressure();
       ReleaseAllNoLock(false);
+    }
 
     void *ret = nullptr;
     auto e = contextHelper_->Malloc(&ret, roundSize);
+    if (e) {
+      // the cached chunks may be what prevents the allocation, drop them and retry
+      ClearAllocationError(dev_type_);
+      NotifyMemoryPressure();
+      ReleaseAllNoLock(false);
+      e = contextHelper_->Malloc(&ret, roundSize);
+    }
     if (e) {
       const std::string err(
 #if MXNET_USE_CUDA
@@ -196,13 +259,14 @@ void PooledStorageManager<BucketingStrategy, StoringMethod>::Alloc(Storage::Hand
     // Reusing memory
     handle->dptr = reuse_pool->back();
     reuse_pool->pop_back();
+    ++num_pool_hits_;
   }
+  ++num_allocs_;
+  in_use_ += roundSize;
+  peak_in_use_ = std::max(peak_in_use_, in_use_);
 #if MXNET_USE_CUDA
   SET_GPU_PROFILER(profilerGPU, contextHelper_);
   if (profilerGPU) {
-    if (reuse_pool)  // roundSize was not calculated
-      roundSize = BucketingStrategy::RoundAllocSizeForBucket(bucket_id);
-
     // record the allocation event in the memory profiler
     profilerGPU->OnAlloc(*handle, roundSize, reuse_pool);
   }
@@ -383,6 +447,15 @@ class UnorderedMapContainer {
     return released_memory;
   }
 
+  void GetFreeChunks(const RoundHelper * /*rndHelper*/,
+                     std::vector<std::pair<size_t, size_t>> *free_chunks) const {
+    free_chunks->clear();
+    for (auto&& i : memory_pool_) {
+      if (i.second.size()) free_chunks->emplace_back(i.first, i.second.size());
+    }
+    std::sort(free_chunks->begin(), free_chunks->end());
+  }
+
  private:
   std::unordered_map<size_t, std::vector<void *>> memory_pool_;
 };  // class UnorderedMapContainer
@@ -427,11 +500,293 @@ class VectorContainer {
     return released_memory;
   }
 
+  void GetFreeChunks(const RoundHelper *rndHelper,
+                     std::vector<std::pair<size_t, size_t>> *free_chunks) const {
+    free_chunks->clear();
+    for (size_t i = first_bucket_; i < memory_pool_.size(); i++) {
+      if (memory_pool_[i].size()) free_chunks->emplace_back(rndHelper->get_size(i),
+                                                            memory_pool_[i].size());
+    }
+  }
+
  private:
   std::vector<std::vector<void*>> memory_pool_;
   size_t first_bucket_;
 };  // class VectorContainer
 
+/*!
+ * \brief Storage manager with a best-fit memory pool of splittable blocks.
+ *
+ *  Memory is obtained from the device in segments, which are split into blocks.
+ *  An allocation takes the smallest free block that is large enough and splits off
+ *  the remainder as a new free block. Freed blocks are merged with their free
+ *  neighbours of the same segment, so that memory freed by allocations of one size
+ *  can serve allocations of another size. This avoids the fragmentation of the
+ *  exact-size pools with variable shape workloads such as dynamic sequence lengths.
+ *
+ *  As in caching allocators, allocations under kSmallSize are served from segments
+ *  of kSmallSegmentSize bytes kept apart from the larger ones, so that short-lived
+ *  small blocks do not split the large segments. Large segments are rounded to
+ *  MXNET_<dev_type>_MEM_LARGE_ALLOC_ROUND_SIZE. Segments that are entirely free are
+ *  returned to the device by ReleaseAll, which also happens automatically when an
+ *  allocation fails or would eat into the reserved memory.
+ *  Selected with MXNET_<dev_type>_MEM_POOL_TYPE=BestFit.
+ */
+class BestFitStorageManager : public StorageManager {
+ public:
+  /*! \brief granularity of the block sizes */
+  static constexpr size_t kRoundSize = 512;
+  /*! \brief allocations of this size or more are served from the large segments */
+  static constexpr size_t kSmallSize = 1 << 20;
+  /*! \brief size of the segments serving the small allocations */
+  static constexpr size_t kSmallSegmentSize = 2 << 20;
+
+  BestFitStorageManager(const Context &ctx, int num_gpu_device) {
+    const char *dev_type = CreateContextHelper(ctx, num_gpu_device, &dev_type_, &contextHelper_);
+    contextHelper_->set_initilal_context(ctx);
+    memory_allocation_limit_ = ReservedMemory(dev_type, contextHelper_.get());
+    if (dev_type) {
+      const auto env_var = env_var_name(dev_type, large_alloc_size);
+      large_segment_round_ = dmlc::GetEnv(env_var.c_str(), large_segment_round_);
+      if (large_segment_round_ == 0)
+        LOG(FATAL) << env_var << " cannot be set to 0";
+    }
+  }
+  ~BestFitStorageManager() override {
+    ReleaseAll();
+  }
+
+  void Alloc(Storage::Handle* handle) override;
+  void Free(Storage::Handle handle) override {
+    std::lock_guard<std::mutex> lock(Storage::Get()->GetMutex(dev_type_));
+    FreeNoLock(handle);
+  }
+  void DirectFree(Storage::Handle handle) override {
+    std::lock_guard<std::mutex> lock(Storage::Get()->GetMutex(dev_type_));
+    Block *block = FreeNoLock(handle);
+    // only whole segments can be handed back to the device
+    if (block->prev == nullptr && block->next == nullptr) {
+      SET_DEVICE(device_store, contextHelper_, handle.ctx, true);
+      FreePool(block->small)->erase(block);
+      ReleaseSegment(block);
+      UNSET_DEVICE(device_store);
+    }
+  }
+  void ReleaseAll() override {
+    std::lock_guard<std::mutex> lock(Storage::Get()->GetMutex(dev_type_));
+    ReleaseAllNoLock(true);
+  }
+  bool GetStats(Storage::Stats* stats) override;
+
+ private:
+  /*! \brief contiguous part of a segment, either allocated or free */
+  struct Block {
+    char *ptr;
+    size_t size;
+    /*! \brief whether the block belongs to a small segment */
+    bool small;
+    bool allocated{false};
+    /*! \brief neighbouring blocks in the same segment */
+    Block *prev{nullptr};
+    Block *next{nullptr};
+    Block(char *p, size_t s, bool is_small) : ptr(p), size(s), small(is_small) {}
+  };
+  /*! \brief order of the free blocks: best fit first, then by address */
+  struct BlockLess {
+    bool operator()(const Block *a, const Block *b) const {
+      return a->size != b->size ? a->size < b->size : a->ptr < b->ptr;
+    }
+  };
+  typedef std::set<Block*, BlockLess> FreeBlocks;
+
+  inline FreeBlocks *FreePool(bool small) { return small ? &small_free_ : &large_free_; }
+
+  inline static size_t RoundToMultiple(size_t x, size_t multiple) {
+    return ((x + multiple - 1) / multiple) * multiple;
+  }
+
+  bool MemoryIsAvalable(size_t size) const {
+    const auto free = contextHelper_->freeMemorySize();
+    return free > size && memory_allocation_limit_ <= free - size;
+  }
+
+  /*! \brief allocate a new segment holding at least size bytes, as a single free block */
+  Block *NewSegment(size_t size, bool small);
+  /*! \brief return the memory of a segment made of a single free block to the device */
+  void ReleaseSegment(Block *block) {
+    SET_GPU_PROFILER(profilerGPU, contextHelper_);
+    contextHelper_->Free(block->ptr);
+    GPU_PROFILER_ON_FREE(profilerGPU, block->ptr);
+    used_memory_ -= block->size;
+    delete block;
+  }
+  /*! \brief Mark a block as free and merge it with its free neighbours
+   *  \return the resulting free block, already in its free pool */
+  Block *FreeNoLock(const Storage::Handle &handle);
+  /*! \brief release all the segments that are entirely free */
+  void ReleaseAllNoLock(bool set_device);
+
+  // device type of used context
+  Context::DeviceType dev_type_;
+  // memory obtained from the device
+  size_t used_memory_ = 0;
+  // memory of the allocated blocks, the rest of used_memory_ is in free blocks
+  size_t in_use_ = 0;
+  // highest value of in_use_
+  size_t peak_in_use_ = 0;
+  // number of allocations, and of those served by a free block
+  uint64_t num_allocs_ = 0;
+  uint64_t num_pool_hits_ = 0;
+  // minimum amount of memory, which will never be allocated
+  size_t memory_allocation_limit_ = 0;
+  // size large segments are rounded to
+  size_t large_segment_round_ = 2 << 20;
+  // free blocks of the small and of the large segments
+  FreeBlocks small_free_;
+  FreeBlocks large_free_;
+  // allocated blocks by address
+  std::unordered_map<void*, Block*> allocated_;
+  // Pointer to the Helper, supporting some context-specific operations in GPU/CPU/CPUPinned context
+  std::unique_ptr<ContextHelper> contextHelper_;
+};  // class BestFitStorageManager
+
+inline void BestFitStorageManager::Alloc(Storage::Handle* handle) {
+  std::lock_guard<std::mutex> lock(Storage::Get()->GetMutex(dev_type_));
+  const size_t size = RoundToMultiple(handle->size, kRoundSize);
+  const bool small = size < kSmallSize;
+  FreeBlocks *pool = FreePool(small);
+  Block key(nullptr, size, small);
+  auto it = pool->lower_bound(&key);
+  const bool reuse = it != pool->end();
+  Block *block = nullptr;
+  if (reuse) {
+    block = *it;
+    pool->erase(it);
+  } else {
+    block = NewSegment(size, small);
+  }
+  // split off the remainder, unless it is too small to be useful
+  const size_t remaining = block->size - size;
+  if (small ? remaining >= kRoundSize : remaining > kSmallSize) {
+    Block *rest = new Block(block->ptr + size, remaining, small);
+    rest->prev = block;
+    rest->next = block->next;
+    if (block->next) block->next->prev = rest;
+    block->next = rest;
+    block->size = size;
+    pool->insert(rest);
+  }
+  block->allocated = true;
+  allocated_[block->ptr] = block;
+  handle->dptr = block->ptr;
+  ++num_allocs_;
+  if (reuse) ++num_pool_hits_;
+  in_use_ += block->size;
+  peak_in_use_ = std::max(peak_in_use_, in_use_);
+#if MXNET_USE_CUDA
+  SET_GPU_PROFILER(profilerGPU, contextHelper_);
+  // record the allocation event in the memory profiler
+  if (profilerGPU) profilerGPU->OnAlloc(*handle, block->size, reuse);
+#endif
+}
+
+inline BestFitStorageManager::Block *BestFitStorageManager::NewSegment(size_t size, bool small) {
+  const size_t segment_size = small ? kSmallSegmentSize
+                                    : RoundToMultiple(size, large_segment_round_);
+  SET_DEVICE(device_store, contextHelper_, contextHelper_->initilal_context(), true);
+  if (!MemoryIsAvalable(segment_size)) {
+    NotifyMemoryPressure();
+    ReleaseAllNoLock(false);
+  }
+
+  void *ret = nullptr;
+  auto e = contextHelper_->Malloc(&ret, segment_size);
+  if (e) {
+    // free segments cached in the pool may be what prevents the allocation
+    ClearAllocationError(dev_type_);
+    NotifyMemoryPressure();
+    ReleaseAllNoLock(false);
+    e = contextHelper_->Malloc(&ret, segment_size);
+  }
+  if (e) {
+    const std::string err(
+#if MXNET_USE_CUDA
+    dev_type_ == Context::kGPU?
+       cudaGetErrorString(static_cast<cudaError_t>(e)) :
+#endif
+       std::strerror(errno));
+
+    LOG(FATAL) << "Memory allocation failed " << err;
+  }
+  UNSET_DEVICE(device_store);
+  used_memory_ += segment_size;
+  return new Block(static_cast<char*>(ret), segment_size, small);
+}
+
+inline BestFitStorageManager::Block *BestFitStorageManager::FreeNoLock(
+    const Storage::Handle &handle) {
+  auto it = allocated_.find(handle.dptr);
+  CHECK(it != allocated_.end()) << "Freeing memory not allocated by this pool";
+  Block *block = it->second;
+  allocated_.erase(it);
+  block->allocated = false;
+  in_use_ -= block->size;
+  SET_GPU_PROFILER(profilerGPU, contextHelper_);
+  GPU_PROFILER_ON_FREE(profilerGPU, block->ptr);
+  FreeBlocks *pool = FreePool(block->small);
+  Block *prev = block->prev;
+  if (prev && !prev->allocated) {
+    pool->erase(prev);
+    prev->size += block->size;
+    prev->next = block->next;
+    if (block->next) block->next->prev = prev;
+    delete block;
+    block = prev;
+  }
+  Block *next = block->next;
+  if (next && !next->allocated) {
+    pool->erase(next);
+    block->size += next->size;
+    block->next = next->next;
+    if (next->next) next->next->prev = block;
+    delete next;
+  }
+  pool->insert(block);
+  return block;
+}
+
+inline void BestFitStorageManager::ReleaseAllNoLock(bool set_device) {
+  SET_DEVICE(device_store, contextHelper_, contextHelper_->initilal_context(), set_device);
+  for (FreeBlocks *pool : {&small_free_, &large_free_}) {
+    for (auto it = pool->begin(); it != pool->end();) {
+      Block *block = *it;
+      if (block->prev == nullptr && block->next == nullptr) {
+        it = pool->erase(it);
+        ReleaseSegment(block);
+      } else {
+        ++it;
+      }
+    }
+  }
+  UNSET_DEVICE(device_store);
+}
+
+inline bool BestFitStorageManager::GetStats(Storage::Stats* stats) {
+  std::lock_guard<std::mutex> lock(Storage::Get()->GetMutex(dev_type_));
+  stats->bytes_in_use = in_use_;
+  stats->bytes_cached = used_memory_ - in_use_;
+  stats->peak_bytes_in_use = peak_in_use_;
+  stats->num_allocs = num_allocs_;
+  stats->num_pool_hits = num_pool_hits_;
+  std::map<size_t, size_t> free_chunks;
+  for (const FreeBlocks *pool : {&small_free_, &large_free_}) {
+    for (const Block *block : *pool) ++free_chunks[block->size];
+  }
+  stats->free_chunks.assign(free_chunks.begin(), free_chunks.end());
+  stats->largest_free_chunk = free_chunks.empty() ? 0 : free_chunks.rbegin()->first;
+  return true;
+}
+
 // For backward compatibility, define previously used classes via new components.
 // Just in case, if someone uses these classes in other places, besides
 // the storage.cc, where the corresponding changes have already been made.
@@ -0,0 +1,218 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file slab_storage_manager.h
+ * \brief CPU storage manager serving small allocations from size-class slabs.
+ */
+#ifndef MXNET_STORAGE_SLAB_STORAGE_MANAGER_H_
+#define MXNET_STORAGE_SLAB_STORAGE_MANAGER_H_
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "./storage_manager.h"
+#include "./pooled_storage_manager.h"
+
+namespace mxnet {
+namespace storage {
+
+/*!
+ * \brief Storage manager for CPU memory with a slab allocator for small chunks.
+ *
+ *  Allocations smaller than kMaxSmallSize are rounded up to a power of 2 size class
+ *  and carved out of slabs of kSlabSize bytes. Every thread keeps a cache of free
+ *  chunks per size class, so that allocating and freeing small chunks usually takes
+ *  no lock at all. The caches exchange chunks in batches with a central free list
+ *  per size class, which has its own mutex. Larger allocations are served by the
+ *  Naive pool.
+ *
+ *  Slabs are only returned to the system when the manager and all the threads that
+ *  used it are gone, ReleaseAll only releases the memory cached by the Naive pool.
+ *  Selected with MXNET_CPU_MEM_POOL_TYPE=Slab.
+ */
+class SlabStorageManager final : public StorageManager {
+ public:
+  /*! \brief allocations of at least this size bypass the slabs */
+  static constexpr size_t kMaxSmallSize = 64 * 1024;
+  /*! \brief size of the slabs the small chunks are carved from */
+  static constexpr size_t kSlabSize = 1024 * 1024;
+
+  SlabStorageManager(const Context &ctx, int num_gpu_device)
+      : central_(std::make_shared<Central>(ctx)), large_pool_(ctx, num_gpu_device) {}
+
+  void Alloc(Storage::Handle* handle) override {
+    if (handle->size >= kMaxSmallSize) {
+      large_pool_.Alloc(handle);
+      return;
+    }
+    const int sc = SizeClass(handle->size);
+    std::vector<void*>* cache = LocalCache()->free_chunks(sc);
+    if (cache->empty()) {
+      central_->Fetch(sc, TransferBatch(sc), cache);
+    }
+    handle->dptr = cache->back();
+    cache->pop_back();
+  }
+
+  void Free(Storage::Handle handle) override {
+    if (handle.size >= kMaxSmallSize) {
+      large_pool_.Free(handle);
+      return;
+    }
+    const int sc = SizeClass(handle.size);
+    std::vector<void*>* cache = LocalCache()->free_chunks(sc);
+    cache->push_back(handle.dptr);
+    if (cache->size() >= 2 * TransferBatch(sc)) {
+      central_->Return(sc, TransferBatch(sc), cache);
+    }
+  }
+
+  void DirectFree(Storage::Handle handle) override {
+    // small chunks belong to a slab and cannot be handed back individually
+    if (handle.size >= kMaxSmallSize) {
+      large_pool_.DirectFree(handle);
+    } else {
+      Free(handle);
+    }
+  }
+
+  void ReleaseAll() override { large_pool_.ReleaseAll(); }
+
+ private:
+  /*! \brief log2 of the smallest size class */
+  static constexpr int kMinShift = 6;
+  /*! \brief number of size classes, the largest one holds kMaxSmallSize bytes */
+  static constexpr int kNumClasses = 11;
+  static_assert((1ul << (kMinShift + kNumClasses - 1)) == kMaxSmallSize,
+                "the largest size class must hold kMaxSmallSize bytes");
+  /*! \brief bytes of free chunks moved at once between a thread cache and the central list */
+  static constexpr size_t kTransferBytes = 128 * 1024;
+
+  /*! \return size class of an allocation smaller than kMaxSmallSize */
+  static inline int SizeClass(size_t size) {
+    int sc = 0;
+    while ((1ul << (kMinShift + sc)) < size) ++sc;
+    return sc;
+  }
+  /*! \return size in bytes of the chunks of a size class */
+  static inline size_t ChunkSize(int sc) { return 1ul << (kMinShift + sc); }
+  /*! \return number of chunks moved at once between a thread cache and the central list */
+  static inline size_t TransferBatch(int sc) {
+    return std::max<size_t>(kTransferBytes / ChunkSize(sc), 4);
+  }
+
+  /*! \brief central free lists and slabs, shared with the caches of the threads */
+  class Central {
+   public:
+    explicit Central(const Context &ctx) { helper_.set_initilal_context(ctx); }
+    ~Central() {
+      for (void *slab : slabs_) helper_.Free(slab);
+    }
+    /*! \brief move up to n free chunks of a size class to out, carving a slab if needed */
+    void Fetch(int sc, size_t n, std::vector<void*>* out) {
+      SizeClassList& list = lists_[sc];
+      std::lock_guard<std::mutex> lock(list.mutex);
+      if (list.free_chunks.empty()) Carve(sc, &list.free_chunks);
+      n = std::min(n, list.free_chunks.size());
+      out->insert(out->end(), list.free_chunks.end() - n, list.free_chunks.end());
+      list.free_chunks.resize(list.free_chunks.size() - n);
+    }
+    /*! \brief move the last n chunks of in back to the central list of a size class */
+    void Return(int sc, size_t n, std::vector<void*>* in) {
+      n = std::min(n, in->size());
+      SizeClassList& list = lists_[sc];
+      {
+        std::lock_guard<std::mutex> lock(list.mutex);
+        list.free_chunks.insert(list.free_chunks.end(), in->end() - n, in->end());
+      }
+      in->resize(in->size() - n);
+    }
+
+   private:
+    struct SizeClassList {
+      std::mutex mutex;
+      std::vector<void*> free_chunks;
+    };
+    /*! \brief allocate a slab and split it into chunks of a size class */
+    void Carve(int sc, std::vector<void*>* out) {
+      void *slab = nullptr;
+      if (helper_.Malloc(&slab, kSlabSize) != 0) {
+        LOG(FATAL) << "Memory allocation failed " << std::strerror(errno);
+      }
+      {
+        std::lock_guard<std::mutex> lock(slabs_mutex_);
+        slabs_.push_back(slab);
+      }
+      const size_t chunk = ChunkSize(sc);
+      char *base = static_cast<char*>(slab);
+      // reversed, so that chunks get handed out in address order
+      for (size_t offset = kSlabSize; offset >= chunk; offset -= chunk) {
+        out->push_back(base + offset - chunk);
+      }
+    }
+
+    ContextHelperCPU helper_;
+    std::array<SizeClassList, kNumClasses> lists_;
+    std::mutex slabs_mutex_;
+    std::vector<void*> slabs_;
+  };
+
+  /*! \brief free chunks cached by one thread for one manager */
+  class ThreadCache {
+   public:
+    explicit ThreadCache(std::shared_ptr<Central> central) : central_(std::move(central)) {}
+    ThreadCache(ThreadCache&&) = default;
+    ~ThreadCache() {
+      if (central_ == nullptr) return;
+      for (int sc = 0; sc < kNumClasses; ++sc) {
+        central_->Return(sc, free_chunks_[sc].size(), &free_chunks_[sc]);
+      }
+    }
+    const Central* central() const { return central_.get(); }
+    std::vector<void*>* free_chunks(int sc) { return &free_chunks_[sc]; }
+
+   private:
+    std::shared_ptr<Central> central_;
+    std::array<std::vector<void*>, kNumClasses> free_chunks_;
+  };
+
+  /*! \return cache of the calling thread for this manager */
+  ThreadCache* LocalCache() {
+    static thread_local std::vector<ThreadCache> caches;
+    for (auto& cache : caches) {
+      if (cache.central() == central_.get()) return &cache;
+    }
+    caches.emplace_back(central_);
+    return &caches.back();
+  }
+
+  std::shared_ptr<Central> central_;
+  /*! \brief pool serving the allocations of at least kMaxSmallSize bytes */
+  PooledStorageManager<RoundMultiple, UnorderedMapContainer> large_pool_;
+};  // class SlabStorageManager
+
+}  // namespace storage
+}  // namespace mxnet
+
+#endif  // MXNET_STORAGE_SLAB_STORAGE_MANAGER_H_
@@ -21,28 +21,51 @@
  * Copyright (c) 2015 by Contributors
  */
 #include <mxnet/storage.h>
+#include <atomic>
 #include "./storage_manager.h"
 #include "./naive_storage_manager.h"
 #include "./pooled_storage_manager.h"
+#include "./slab_storage_manager.h"
 #include "./cpu_shared_storage_manager.h"
 #include "./cpu_device_storage.h"
 #include "./gpu_device_storage.h"
+#include "./gpu_async_storage_manager.h"
+#include "./gpu_managed_storage_manager.h"
+#include "./gpu_shared_storage_manager.h"
 #include "./pinned_memory_storage.h"
 #include "../common/lazy_alloc_array.h"
+#include "../common/numa.h"
 #include "../profiler/storage_profiler.h"
 
 namespace mxnet {
 namespace storage {
 
+namespace {
+std::atomic<uint64_t> memory_pressure_count(0);
+}  // namespace
+
+void NotifyMemoryPressure() {
+  memory_pressure_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t MemoryPressureCount() {
+  return memory_pressure_count.load(std::memory_order_relaxed);
+}
+
 // consider change storage as a pure abstract class
 class StorageImpl : public Storage {
  public:
   void Alloc(Handle* handle) override;
   void Free(Handle handle) override;
   void DirectFree(Handle handle) override;
-  void ReleaseAll(Context ctx) override   { storage_manager(ctx)->ReleaseAll(); }
+  void ReleaseAll(Context ctx) override {
+    NotifyMemoryPressure();
+    storage_manager(ctx)->ReleaseAll();
+  }
+  bool GetStats(Context ctx, Stats* stats) override;
 
   void SharedIncrementRefCount(Handle handle) override;
+  void GetGPUSharedHandle(Handle* handle) override;
   StorageImpl() = default;
   ~StorageImpl() override = default;
 
@@ -50,16 +73,33 @@ class StorageImpl : public Storage {
   std::shared_ptr<StorageManager> storage_manager(const Context &ctx) {
     auto &&device = storage_managers_.at(ctx.dev_type);
     std::shared_ptr<StorageManager> manager = device.Get(
-      ctx.real_dev_id(), []() {
+      manager_id(ctx), []() {
       LOG(FATAL) << "Cannot Free space to a device you have not allocated";
       return nullptr;
       });
     return manager;
   }
 
+  /*! \brief index of the storage manager serving a context */
+  static int manager_id(const Context &ctx) {
+    return common::NumaTopology::Get()->ManagerIndexOf(ctx);
+  }
+
+#if MXNET_USE_CUDA
+  std::shared_ptr<GPUSharedStorageManager> gpu_shared_manager(const Context &ctx) {
+    return gpu_shared_managers_.Get(ctx.real_dev_id(), [ctx]() {
+      return new GPUSharedStorageManager(ctx);
+    });
+  }
+#endif
+
   static constexpr size_t kMaxNumberOfDevices = Context::kMaxDevType + 1;
   // internal storage managers
   std::array<common::LazyAllocArray<StorageManager>, kMaxNumberOfDevices> storage_managers_;
+#if MXNET_USE_CUDA
+  // managers of the GPU memory opened from other processes
+  common::LazyAllocArray<GPUSharedStorageManager> gpu_shared_managers_;
+#endif
   profiler::DeviceStorageProfiler profiler_;
 };  // struct Storage::Impl
 
@@ -76,6 +116,22 @@ StorageManager *CreateStorageManager(const Context &ctx, const char *context,
     ptr = new PooledStorageManager<RoundPower2, VectorContainer>(ctx, num_gpu_device);
   } else if (*pStrategy == "Naive") {
     ptr = new PooledStorageManager<RoundMultiple, UnorderedMapContainer>(ctx, num_gpu_device);
+  } else if (*pStrategy == "BestFit") {
+    ptr = new BestFitStorageManager(ctx, num_gpu_device);
+  } else if (*pStrategy == "Async") {
+#if MXNET_USE_CUDA && MXNET_CUDA_MALLOC_ASYNC_SUPPORTED
+    if (ctx.dev_type == Context::kGPU)
+      ptr = new GPUAsyncStorageManager(ctx);
+    else
+#endif
+      LOG(FATAL) << "Memory pool strategy Async is only supported by "
+                 << env_var_name("GPU", pool_type) << " with CUDA 11.2 or later";
+  } else if (*pStrategy == "Slab") {
+    if (ctx.dev_type == Context::kCPU)
+      ptr = new SlabStorageManager(ctx, num_gpu_device);
+    else
+      LOG(FATAL) << "Memory pool strategy Slab is only supported by "
+                 << env_var_name("CPU", pool_type);
   } else if (*pStrategy == "Unpooled") {
     if (ctx.dev_type == Context::kCPU || num_gpu_device == 0)
       ptr = new NaiveStorageManager<CPUDeviceStorage>();
@@ -95,11 +151,21 @@ void StorageImpl::Alloc(Storage::Handle *handle) {
     handle->dptr = nullptr;
     return;
   }
+  if (!handle->ipc_handle.empty()) {
+#if MXNET_USE_CUDA
+    CHECK_EQ(handle->ctx.dev_type, Context::kGPU);
+    gpu_shared_manager(handle->ctx)->Alloc(handle);
+    profiler_.OnAlloc(*handle);
+    return;
+#else
+    LOG(FATAL) << "Compile with USE_CUDA=1 to share GPU memory between processes";
+#endif
+  }
 
   // space already recycled, ignore request
   auto &&device = storage_managers_.at(handle->ctx.dev_type);
   std::shared_ptr<StorageManager> manager = device.Get(
-    handle->ctx.real_dev_id(), [handle]() {
+    manager_id(handle->ctx), [handle]() {
     const auto dev_type = handle->ctx.dev_type;
     int num_gpu_device = 0;
 #if MXNET_USE_CUDA
@@ -194,6 +260,13 @@ void StorageImpl::Alloc(Storage::Handle *handle) {
       }
     }
 
+#if MXNET_USE_CUDA
+    if (dev_type == Context::kGPU && dmlc::GetEnv("MXNET_GPU_MEM_MANAGED", false)) {
+      ptr = new GPUManagedStorageManager(handle->ctx, ptr);
+      storage_manager_type += " with managed memory";
+    }
+#endif
+
     if (context)
       LOG(INFO) << "Using " << storage_manager_type << " StorageManager for " << context;
 
@@ -208,6 +281,13 @@ void StorageImpl::Free(Storage::Handle handle) {
   // Do nothing if dtpr is nullptr because the handle may have already
   // been freed or have not been allocated memory yet.
   if (handle.dptr == nullptr) return;
+#if MXNET_USE_CUDA
+  if (!handle.ipc_handle.empty()) {
+    gpu_shared_manager(handle.ctx)->Free(handle);
+    profiler_.OnFree(handle);
+    return;
+  }
+#endif
 
   storage_manager(handle.ctx)->Free(handle);
   profiler_.OnFree(handle);
@@ -217,11 +297,28 @@ void StorageImpl::DirectFree(Storage::Handle handle) {
   // Do nothing if dtpr is nullptr because the handle may have already
   // been freed or have not been allocated memory yet.
   if (handle.dptr == nullptr) return;
+#if MXNET_USE_CUDA
+  if (!handle.ipc_handle.empty()) {
+    gpu_shared_manager(handle.ctx)->DirectFree(handle);
+    profiler_.OnFree(handle);
+    return;
+  }
+#endif
 
   storage_manager(handle.ctx)->DirectFree(handle);
   profiler_.OnFree(handle);
 }
 
+bool StorageImpl::GetStats(Context ctx, Storage::Stats* stats) {
+  *stats = Storage::Stats();
+  auto &&device = storage_managers_.at(ctx.dev_type);
+  // nothing allocated on the device yet, do not create its manager
+  std::shared_ptr<StorageManager> manager = device.Get(manager_id(ctx), []() {
+    return nullptr;
+  });
+  return manager == nullptr || manager->GetStats(stats);
+}
+
 void StorageImpl::SharedIncrementRefCount(Storage::Handle handle) {
   CHECK_EQ(handle.ctx.dev_type, Context::kCPUShared);
   auto&& device = storage_managers_.at(Context::kCPUShared);
@@ -236,6 +333,18 @@ void StorageImpl::SharedIncrementRefCount(Storage::Handle handle) {
 #endif  // !defined(ANDROID) && !defined(__ANDROID__)
 }
 
+void StorageImpl::GetGPUSharedHandle(Storage::Handle* handle) {
+  CHECK_EQ(handle->ctx.dev_type, Context::kGPU) << "Only GPU memory is shared with CUDA IPC";
+  // memory opened from another process keeps its handle
+  if (!handle->ipc_handle.empty()) return;
+  CHECK(handle->dptr != nullptr) << "Cannot share GPU memory not allocated yet";
+#if MXNET_USE_CUDA
+  gpu_shared_manager(handle->ctx)->Export(handle);
+#else
+  LOG(FATAL) << "Compile with USE_CUDA=1 to share GPU memory between processes";
+#endif
+}
+
 const std::string env_var_name(const char* dev_type, env_var_type type) {
   static const std::array<std::string, 5> name = {
                         "MEM_POOL_TYPE",
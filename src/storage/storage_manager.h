@@ -32,6 +32,16 @@
 namespace mxnet {
 namespace storage {
 
+/*!
+ * \brief Signal that a device ran short of memory, so that the memory held outside of the
+ *        pools, like the temporary spaces of the resource manager, shrinks on its next use.
+ */
+void NotifyMemoryPressure();
+/*!
+ * \brief Number of memory pressure signals so far.
+ */
+uint64_t MemoryPressureCount();
+
 /*!
  * \brief Storage manager interface.
  */
@@ -60,6 +70,11 @@ class StorageManager {
   * For non-pool memory managers this has no effect.
   */
   virtual void ReleaseAll() {}
+  /*!
+   * \brief Get the memory usage of the manager.
+   * \return false if the manager does not keep statistics.
+   */
+  virtual bool GetStats(Storage::Stats* /*stats*/) { return false; }
   /*!
    * \brief Destructor.
    */
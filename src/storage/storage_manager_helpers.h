@@ -43,6 +43,8 @@ typedef  mxnet::common::cuda::DeviceStore CudaDeviceStore;
 
 #include <tuple>
 #include "../common/utils.h"
+#include "../common/numa.h"
+#include "./cpu_hugepage_storage.h"
 
 namespace mxnet {
 namespace storage {
@@ -111,12 +113,28 @@ class ContextHelperCPU : public ContextHelper {
   }
 
   int Malloc(void **ppNtr, size_t size) const override {
+    const common::NumaTopology *numa = common::NumaTopology::Get();
+    const int numa_node = numa->NodeOf(initilal_context());
+    CPUHugePageStorage *huge_pages = CPUHugePageStorage::Get();
+    if (huge_pages->Accepts(size) && huge_pages->Alloc(ppNtr, size)) {
+      // not touched yet, the pages can still be placed on the node
+      numa->BindMemory(*ppNtr, size, numa_node);
+      return 0;
+    }
+    if (numa_node >= 0 && size >= numa->page_size()) {
+      // page aligned chunks, so that their pages can be placed on the node before first touch
+      if (!mxnet::common::AlignedMemAlloc(ppNtr, size, numa->page_size()))
+        return -1;
+      numa->BindMemory(*ppNtr, size, numa_node);
+      return 0;
+    }
     bool success = mxnet::common::AlignedMemAlloc(ppNtr, size, alignment_);
     return success ? 0 : -1;
   }
 
   void Free(void *dptr) const override {
-    mxnet::common::AlignedMemFree(dptr);
+    if (!CPUHugePageStorage::Get()->Free(dptr))
+      mxnet::common::AlignedMemFree(dptr);
   }
 
  private:
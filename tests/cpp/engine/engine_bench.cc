@@ -0,0 +1,206 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file engine_bench.cc
+ * \brief overhead of the engines on synthetic graphs of empty operators
+ *
+ *  Every engine runs the same workloads: the latency of a push, the throughput of a chain
+ *  of operators writing one var, of a wide fan-out of readers, of diamonds, of threads
+ *  contending on one var, and the latency from the completion of an operator to the wake
+ *  up of WaitForVar. The operators do nothing, so the timings are those of the engine.
+ *  The sizes are those of a quick run, or ten times larger with --perf.
+*/
+#include <dmlc/logging.h>
+#include <gtest/gtest.h>
+#include <mxnet/engine.h>
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/engine/engine_impl.h"
+#include "../include/test_util.h"
+
+using namespace mxnet;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double Seconds(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+void EmptyOpr(RunContext, Engine::CallbackOnComplete cb) {
+  cb();
+}
+
+/*! \brief mean time of a push of an operator without dependencies, in microseconds */
+double PushLatency(Engine *engine, int num_ops) {
+  std::vector<Engine::VarHandle> vars(num_ops);
+  for (auto &var : vars) var = engine->NewVariable();
+  double t = 0;
+  for (int i = 0; i < num_ops; ++i) {
+    const auto start = Clock::now();
+    engine->PushAsync(EmptyOpr, Context::CPU(), {}, {vars[i]});
+    t += Seconds(start);
+  }
+  engine->WaitForAll();
+  for (auto var : vars) engine->DeleteVariable([](RunContext) {}, Context::CPU(), var);
+  engine->WaitForAll();
+  return t / num_ops * 1e6;
+}
+
+/*! \brief operators per second of a chain of operators writing the same var */
+double Chain(Engine *engine, int num_ops) {
+  auto var = engine->NewVariable();
+  const auto start = Clock::now();
+  for (int i = 0; i < num_ops; ++i) {
+    engine->PushAsync(EmptyOpr, Context::CPU(), {}, {var});
+  }
+  engine->WaitForVar(var);
+  const double t = Seconds(start);
+  engine->DeleteVariable([](RunContext) {}, Context::CPU(), var);
+  engine->WaitForAll();
+  return num_ops / t;
+}
+
+/*!
+ * \brief operators per second of a var written then read by `width` operators, each
+ *  writing its own var
+ */
+double FanOut(Engine *engine, int num_ops, int width) {
+  auto src = engine->NewVariable();
+  std::vector<Engine::VarHandle> dst(width);
+  for (auto &var : dst) var = engine->NewVariable();
+  const auto start = Clock::now();
+  for (int i = 0; i < num_ops / (width + 1); ++i) {
+    engine->PushAsync(EmptyOpr, Context::CPU(), {}, {src});
+    for (int j = 0; j < width; ++j) {
+      engine->PushAsync(EmptyOpr, Context::CPU(), {src}, {dst[j]});
+    }
+  }
+  engine->WaitForAll();
+  const double t = Seconds(start);
+  engine->DeleteVariable([](RunContext) {}, Context::CPU(), src);
+  for (auto var : dst) engine->DeleteVariable([](RunContext) {}, Context::CPU(), var);
+  engine->WaitForAll();
+  return num_ops / (width + 1) * (width + 1) / t;
+}
+
+/*! \brief operators per second of diamonds, a -> (b, c) -> d, chained through d */
+double Diamond(Engine *engine, int num_ops) {
+  auto a = engine->NewVariable();
+  auto b = engine->NewVariable();
+  auto c = engine->NewVariable();
+  auto d = engine->NewVariable();
+  const auto start = Clock::now();
+  for (int i = 0; i < num_ops / 4; ++i) {
+    engine->PushAsync(EmptyOpr, Context::CPU(), {d}, {a});
+    engine->PushAsync(EmptyOpr, Context::CPU(), {a}, {b});
+    engine->PushAsync(EmptyOpr, Context::CPU(), {a}, {c});
+    engine->PushAsync(EmptyOpr, Context::CPU(), {b, c}, {d});
+  }
+  engine->WaitForVar(d);
+  const double t = Seconds(start);
+  for (auto var : {a, b, c, d}) engine->DeleteVariable([](RunContext) {}, Context::CPU(), var);
+  engine->WaitForAll();
+  return num_ops / 4 * 4 / t;
+}
+
+/*! \brief operators per second of threads pushing operators writing the same var */
+double Contention(Engine *engine, int num_ops, int num_pushers) {
+  auto var = engine->NewVariable();
+  const auto start = Clock::now();
+  std::vector<std::thread> pushers;
+  for (int p = 0; p < num_pushers; ++p) {
+    pushers.emplace_back([engine, var, num_ops, num_pushers]() {
+      for (int i = 0; i < num_ops / num_pushers; ++i) {
+        engine->PushAsync(EmptyOpr, Context::CPU(), {}, {var});
+      }
+    });
+  }
+  for (auto &p : pushers) p.join();
+  engine->WaitForVar(var);
+  const double t = Seconds(start);
+  engine->DeleteVariable([](RunContext) {}, Context::CPU(), var);
+  engine->WaitForAll();
+  return num_ops / num_pushers * num_pushers / t;
+}
+
+/*!
+ * \brief median time from the completion of an operator to the return of WaitForVar on
+ *  its var, in microseconds
+ */
+double WakeupLatency(Engine *engine, int num_waits) {
+  auto var = engine->NewVariable();
+  std::vector<double> latencies;
+  latencies.reserve(num_waits);
+  for (int i = 0; i < num_waits; ++i) {
+    Clock::time_point completed;
+    engine->PushAsync([&completed](RunContext, Engine::CallbackOnComplete cb) {
+      // let the waiting thread block first
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+      completed = Clock::now();
+      cb();
+    }, Context::CPU(), {}, {var});
+    engine->WaitForVar(var);
+    latencies.push_back(Seconds(completed) * 1e6);
+  }
+  engine->DeleteVariable([](RunContext) {}, Context::CPU(), var);
+  engine->WaitForAll();
+  std::sort(latencies.begin(), latencies.end());
+  return latencies[latencies.size() / 2];
+}
+
+}  // namespace
+
+TEST(EngineBench, Overhead) {
+  const int scale = test::performance_run ? 10 : 1;
+  const int num_ops = 10000 * scale;
+  std::vector<Engine*> engine = {mxnet::engine::CreateNaiveEngine(),
+                                 mxnet::engine::CreateThreadedEnginePooled(),
+                                 mxnet::engine::CreateThreadedEnginePerDevice()};
+  std::string type_names[3] = {"NaiveEngine", "ThreadedEnginePooled", "ThreadedEnginePerDevice"};
+  std::ostringstream os;
+  os << std::endl << std::left << std::setw(26) << "Engine"
+     << std::right << std::setw(14) << "Push (us)" << std::setw(14) << "Chain (op/s)"
+     << std::setw(14) << "Fan-out (op/s)" << std::setw(14) << "Diamond (op/s)"
+     << std::setw(16) << "Contended (op/s)" << std::setw(14) << "Wake up (us)" << std::endl;
+  for (size_t k = 0; k < engine.size(); ++k) {
+    os << std::left << std::setw(26) << type_names[k] << std::right << std::fixed
+       << std::setprecision(3) << std::setw(14) << PushLatency(engine[k], num_ops)
+       << std::setprecision(0) << std::setw(14) << Chain(engine[k], num_ops)
+       << std::setw(14) << FanOut(engine[k], num_ops, 64)
+       << std::setw(14) << Diamond(engine[k], num_ops) << std::setw(16);
+    // the naive engine runs the operators in the pushing threads
+    if (k == 0) {
+      os << "-";
+    } else {
+      os << Contention(engine[k], num_ops, 4);
+    }
+    os << std::setprecision(3) << std::setw(14) << WakeupLatency(engine[k], 100 * scale)
+       << std::endl;
+  }
+  LOG(INFO) << os.str();
+}
@@ -0,0 +1,81 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file thread_budget_test.cc
+ * \brief partitioning of the cores of a thread budget between the thread pools
+ */
+#include <gtest/gtest.h>
+#include <dmlc/logging.h>
+#include <cstdlib>
+
+#include "../../src/engine/openmp.h"
+#include "../../src/engine/thread_budget.h"
+
+TEST(ThreadBudget, Disabled) {
+  mxnet::engine::ThreadBudget budget(0, false);
+  EXPECT_FALSE(budget.enabled());
+  // all the threads asked for, and at least one
+  EXPECT_EQ(budget.Acquire("disabled", 3)->threads(), 3);
+  EXPECT_EQ(budget.Acquire("disabled", 0)->threads(), 1);
+}
+
+TEST(ThreadBudget, Acquire) {
+  using mxnet::engine::OpenMP;
+  using mxnet::engine::ThreadBudget;
+  OpenMP *openmp = OpenMP::Get();
+  const int thread_max = openmp->thread_max();
+  {
+    ThreadBudget budget(4, false);
+    EXPECT_TRUE(budget.enabled());
+    const int cores = budget.cores();
+    EXPECT_LE(cores, 4);
+    // the OMP regions of the engine do not exceed the budget
+    EXPECT_LE(openmp->thread_max(), cores);
+    // OMP_NUM_THREADS overrides the recommendation of the engine
+    const bool capped = openmp->enabled() && std::getenv("OMP_NUM_THREADS") == nullptr;
+    const int recommended = openmp->GetRecommendedOMPThreadCount();
+    if (cores == 4) {
+      auto a = budget.Acquire("a", 2);
+      EXPECT_EQ(a->threads(), 2);
+      if (capped) EXPECT_LE(openmp->GetRecommendedOMPThreadCount(), 2);
+      // one core is always left to the engine
+      auto b = budget.Acquire("b", 8);
+      EXPECT_EQ(b->threads(), 1);
+      auto c = budget.Acquire("c", 2);
+      EXPECT_EQ(c->threads(), 1);
+      if (capped) EXPECT_EQ(openmp->GetRecommendedOMPThreadCount(), 1);
+      // released cores are leased again
+      b.reset();
+      auto d = budget.Acquire("d", 2);
+      EXPECT_EQ(d->threads(), 1);
+      a.reset();
+      auto e = budget.Acquire("e", 3);
+      EXPECT_EQ(e->threads(), 2);
+      c.reset();
+      d.reset();
+      e.reset();
+    } else {
+      LOG(INFO) << "Only " << cores << " cores, lease partitioning is not checked";
+    }
+    // without leases the engine gets its threads back
+    EXPECT_EQ(openmp->GetRecommendedOMPThreadCount(), recommended);
+  }
+  openmp->set_thread_max(thread_max);
+}
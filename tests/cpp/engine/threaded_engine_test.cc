@@ -32,12 +32,15 @@
 #include <dmlc/timer.h>
 #include <ctime>
 #include <cstdio>
+#include <cstdlib>
 #include <thread>
 #include <chrono>
 #include <vector>
 #include <random>
 
 #include "../src/engine/engine_impl.h"
+#include "../src/engine/priority_task_queue.h"
+#include "../src/engine/work_stealing_queue.h"
 #include "../include/test_util.h"
 
 /**
@@ -128,12 +131,14 @@ double EvaluateWorkloads(const std::vector<Workload>& workloads,
 }
 
 TEST(Engine, start_stop) {
-  const int num_engine = 3;
+  const int num_engine = 4;
   std::vector<mxnet::Engine*> engine(num_engine);
   engine[0] = mxnet::engine::CreateNaiveEngine();
   engine[1] = mxnet::engine::CreateThreadedEnginePooled();
   engine[2] = mxnet::engine::CreateThreadedEnginePerDevice();
-  std::string type_names[3] = {"NaiveEngine", "ThreadedEnginePooled", "ThreadedEnginePerDevice"};
+  engine[3] = mxnet::engine::CreateThreadedEngineWorkStealing();
+  std::string type_names[4] = {"NaiveEngine", "ThreadedEnginePooled", "ThreadedEnginePerDevice",
+                               "ThreadedEngineWorkStealing"};
 
   for (int i = 0; i < num_engine; ++i) {
     LOG(INFO) << "Stopping: " << type_names[i];
@@ -147,7 +152,7 @@ TEST(Engine, start_stop) {
 TEST(Engine, RandSumExpr) {
   std::vector<Workload> workloads;
   int num_repeat = 5;
-  const int num_engine = 4;
+  const int num_engine = 5;
 
   std::vector<double> t(num_engine, 0.0);
   std::vector<mxnet::Engine*> engine(num_engine);
@@ -156,6 +161,7 @@ TEST(Engine, RandSumExpr) {
   engine[1] = mxnet::engine::CreateNaiveEngine();
   engine[2] = mxnet::engine::CreateThreadedEnginePooled();
   engine[3] = mxnet::engine::CreateThreadedEnginePerDevice();
+  engine[4] = mxnet::engine::CreateThreadedEngineWorkStealing();
 
   for (int repeat = 0; repeat < num_repeat; ++repeat) {
     srand(time(nullptr) + repeat);
@@ -178,6 +184,176 @@ TEST(Engine, RandSumExpr) {
   LOG(INFO) << "NaiveEngine\t\t"  << t[1] << " sec";
   LOG(INFO) << "ThreadedEnginePooled\t" << t[2] << " sec";
   LOG(INFO) << "ThreadedEnginePerDevice\t" << t[3] << " sec";
+  LOG(INFO) << "ThreadedEngineWorkStealing\t" << t[4] << " sec";
+}
+
+/*!
+ * \brief The workloads of RandSumExpr with workers and waiters spinning, then yielding,
+ *  before they block. The engines read the wait policy when they are created.
+ */
+TEST(Engine, SpinWait) {
+  setenv("MXNET_ENGINE_SPIN_WAIT_US", "50", 1);
+  setenv("MXNET_ENGINE_YIELD_WAIT_US", "50", 1);
+  std::vector<mxnet::Engine*> engine = {mxnet::engine::CreateThreadedEnginePooled(),
+                                        mxnet::engine::CreateThreadedEnginePerDevice()};
+  unsetenv("MXNET_ENGINE_SPIN_WAIT_US");
+  unsetenv("MXNET_ENGINE_YIELD_WAIT_US");
+  std::string type_names[2] = {"ThreadedEnginePooled", "ThreadedEnginePerDevice"};
+
+  std::vector<Workload> workloads;
+  const int num_var = 100;
+  for (int repeat = 0; repeat < 3; ++repeat) {
+    // sleeping ops leave the workers idle long enough to exhaust the polling budget
+    GenerateWorkload(2000, num_var, 2, 20, 0, repeat * 100 + 1, &workloads);
+    std::vector<double> expected(num_var, 1.0);
+    EvaluateWorkloads(workloads, nullptr, &expected);
+    for (size_t k = 0; k < engine.size(); ++k) {
+      std::vector<double> data(num_var, 1.0);
+      const double t = EvaluateWorkloads(workloads, engine[k], &data);
+      for (int j = 0; j < num_var; ++j) EXPECT_EQ(expected[j], data[j]);
+      LOG(INFO) << type_names[k] << "\t" << t << " sec";
+    }
+  }
+
+  // a single var waited on after each push
+  for (size_t k = 0; k < engine.size(); ++k) {
+    auto var = engine[k]->NewVariable();
+    int count = 0;
+    for (int i = 0; i < 100; ++i) {
+      engine[k]->PushSync([&count](RunContext) { ++count; }, Context::CPU(), {}, {var});
+      engine[k]->WaitForVar(var);
+      EXPECT_EQ(count, i + 1);
+    }
+    engine[k]->DeleteVariable([](RunContext) {}, Context::CPU(), var);
+    engine[k]->WaitForAll();
+  }
+}
+
+/*!
+ * \brief Push throughput on a var shared by many readers, e.g. a parameter read by
+ *  every op of a step. Most pushes only touch the read counter of the var.
+ */
+TEST(Engine, ReadHeavyVarThroughput) {
+  const int num_ops = 100000;
+  const int write_every = 1000;
+  const int num_pushers = 4;
+  std::vector<mxnet::Engine*> engine = {mxnet::engine::CreateThreadedEnginePooled(),
+                                        mxnet::engine::CreateThreadedEnginePerDevice()};
+  std::string type_names[2] = {"ThreadedEnginePooled", "ThreadedEnginePerDevice"};
+  for (size_t k = 0; k < engine.size(); ++k) {
+    auto param = engine[k]->NewVariable();
+    std::atomic<int> num_reads{0};
+    double t = dmlc::GetTime();
+    std::vector<std::thread> pushers;
+    for (int p = 0; p < num_pushers; ++p) {
+      pushers.emplace_back([&, p]() {
+        auto out = engine[k]->NewVariable();
+        for (int i = 0; i < num_ops / num_pushers; ++i) {
+          if (p == 0 && i % write_every == 0) {
+            engine[k]->PushSync([](RunContext) {}, Context::CPU(), {}, {param});
+          }
+          engine[k]->PushSync([&num_reads](RunContext) { ++num_reads; },
+                              Context::CPU(), {param}, {out});
+        }
+        engine[k]->DeleteVariable([](RunContext) {}, Context::CPU(), out);
+      });
+    }
+    for (auto& p : pushers) p.join();
+    engine[k]->WaitForAll();
+    t = dmlc::GetTime() - t;
+    EXPECT_EQ(num_reads.load(), num_ops / num_pushers * num_pushers);
+    EXPECT_EQ(param->version(), static_cast<size_t>(
+        (num_ops / num_pushers + write_every - 1) / write_every));
+    LOG(INFO) << type_names[k] << "\t" << num_ops / t << " ops/sec";
+    engine[k]->DeleteVariable([](RunContext) {}, Context::CPU(), param);
+    engine[k]->WaitForAll();
+  }
+}
+
+TEST(Engine, PushBatch) {
+  std::vector<mxnet::Engine*> engine = {mxnet::engine::CreateNaiveEngine(),
+                                        mxnet::engine::CreateThreadedEnginePooled(),
+                                        mxnet::engine::CreateThreadedEnginePerDevice()};
+  const int num_oprs = 100;
+  for (auto e : engine) {
+    auto var = e->NewVariable();
+    auto other = e->NewVariable();
+    std::vector<int> order;
+    std::atomic<int> num_reads{0};
+    std::vector<mxnet::Engine::OprHandle> oprs;
+    for (int i = 0; i < num_oprs; ++i) {
+      if (i % 10 == 0) {
+        oprs.push_back(e->NewOperator(
+            [&num_reads](RunContext, Engine::CallbackOnComplete cb) { ++num_reads; cb(); },
+            {var}, {other}));
+      } else {
+        oprs.push_back(e->NewOperator(
+            [&order, i](RunContext, Engine::CallbackOnComplete cb) { order.push_back(i); cb(); },
+            {}, {var}));
+      }
+    }
+    e->PushBatch(oprs, Context::CPU());
+    e->PushBatch(oprs, Context::CPU());
+    e->WaitForAll();
+    ASSERT_EQ(order.size(), 2U * (num_oprs - num_oprs / 10));
+    for (size_t i = 1; i < order.size(); ++i) {
+      EXPECT_TRUE(order[i] > order[i - 1] || order[i] == 1);
+    }
+    EXPECT_EQ(num_reads.load(), 2 * num_oprs / 10);
+    for (auto op : oprs) e->DeleteOperator(op);
+    e->DeleteVariable([](RunContext) {}, Context::CPU(), var);
+    e->DeleteVariable([](RunContext) {}, Context::CPU(), other);
+    e->WaitForAll();
+  }
+}
+
+TEST(Engine, PriorityTaskQueue) {
+  mxnet::engine::PriorityTaskQueue<int> queue;
+  queue.Push(1, 0);
+  queue.Push(2, 5);
+  queue.Push(3, 0);
+  queue.PushFront(4, 0);
+  queue.Push(5, 5);
+  EXPECT_EQ(queue.Size(), 5U);
+  // highest priority first, push order within a priority, PushFront ahead of its priority
+  const int expected[] = {2, 5, 4, 1, 3};
+  for (int e : expected) {
+    int v;
+    ASSERT_TRUE(queue.Pop(&v));
+    EXPECT_EQ(v, e);
+  }
+  queue.SignalForKill();
+  int v;
+  EXPECT_FALSE(queue.Pop(&v));
+}
+
+TEST(Engine, WorkStealingQueue) {
+  mxnet::engine::WorkStealingQueue<int> queue(2);
+  int v;
+  // the first pop registers this thread as the owner of the first deque
+  queue.Push(0);
+  ASSERT_TRUE(queue.Pop(&v));
+  EXPECT_EQ(v, 0);
+  queue.Push(1);
+  queue.Push(2);
+  queue.Push(3);
+  queue.PushFront(4);
+  EXPECT_EQ(queue.Size(), 4U);
+  // a thief steals the oldest element
+  std::thread thief([&queue]() {
+    int stolen;
+    ASSERT_TRUE(queue.Pop(&stolen));
+    EXPECT_EQ(stolen, 1);
+  });
+  thief.join();
+  // the owner pops the newest first, and PushFront ahead of all
+  const int expected[] = {4, 3, 2};
+  for (int e : expected) {
+    ASSERT_TRUE(queue.Pop(&v));
+    EXPECT_EQ(v, e);
+  }
+  queue.SignalForKill();
+  EXPECT_FALSE(queue.Pop(&v));
 }
 
 void Foo(mxnet::RunContext, int i) { printf("The fox says %d\n", i); }
@@ -436,6 +612,51 @@ TEST(Engine, basics) {
   LOG(INFO) << "All pass";
 }
 
+/*!
+ * \brief Tags used once, whose operations complete with or without a waiter, and tags
+ *  waited for by several threads.
+ */
+TEST(Engine, WaitForTag) {
+  std::vector<mxnet::Engine*> engine = {mxnet::engine::CreateThreadedEnginePooled(),
+                                        mxnet::engine::CreateThreadedEnginePerDevice()};
+  for (auto* e : engine) {
+    auto var = e->NewVariable();
+    std::atomic<int> count{0};
+    for (int tag = 1; tag <= 1000; ++tag) {
+      e->set_wait_tag(tag);
+      e->PushSync([&count](RunContext) { ++count; }, Context::CPU(), {}, {var});
+      e->set_wait_tag(0);
+      if (tag % 2 == 0) {
+        e->WaitForTag(tag);
+        EXPECT_EQ(count.load(), tag);
+      }
+    }
+    e->WaitForAll();
+    // the completed or unknown tags do not block
+    e->WaitForTag(999);
+    e->WaitForTag(5000);
+
+    e->set_wait_tag(7);
+    for (int i = 0; i < 10; ++i) {
+      e->PushSync([&count](RunContext) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        ++count;
+      }, Context::CPU(), {}, {var});
+    }
+    e->set_wait_tag(0);
+    std::vector<std::thread> waiters;
+    for (int i = 0; i < 4; ++i) {
+      waiters.emplace_back([e, &count]() {
+        e->WaitForTag(7);
+        EXPECT_EQ(count.load(), 1010);
+      });
+    }
+    for (auto& w : waiters) w.join();
+    e->DeleteVariable([](RunContext) {}, Context::CPU(), var);
+    e->WaitForAll();
+  }
+}
+
 TEST(Engine, VarVersion) {
   const size_t num_engines = 3;
   std::vector<mxnet::Engine*> engines(num_engines);
@@ -49,6 +49,12 @@ extern bool quick_test;
 extern bool performance_run;
 extern bool csv;
 extern bool thread_safety_force_cpu;
+/*! \brief file the kernel benchmark results are written to, in the opperf json format */
+extern std::string bench_json;
+/*! \brief kernel benchmark results the results are checked against, if any */
+extern std::string bench_baseline;
+/*! \brief slowdown over the baseline failing the kernel benchmark, 0.1 for 10% */
+extern double bench_tolerance;
 
 template<typename DType>
 inline size_t shapeMemorySize(const mxnet::TShape& shape) {
@@ -0,0 +1,182 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file custom_op_native_test.cc
+ * \brief custom operators registered with native callbacks through MXCustomOpRegisterNative
+ */
+#include <gtest/gtest.h>
+#include <mxnet/base.h>
+#include <mxnet/c_api.h>
+#include <nnvm/op.h>
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace {
+
+/*! \brief number of elements of the arrays passed to the operator */
+constexpr int kSize = 6;
+/*! \brief number of forward callbacks run */
+std::atomic<int> forward_calls(0);
+
+template<typename Func>
+int (*AsCallback(Func func))(void) {
+  return reinterpret_cast<int (*)(void)>(func);
+}
+
+int DeleteState(void* state) {
+  return 1;
+}
+
+/*! \brief out = 2 * data, reading and writing the buffers directly since the callback runs
+ *  inline on the engine worker and must not wait on the engine */
+int Forward(int size, void** ptrs, int* tags, const int* reqs, const int is_train,
+            void* state) {
+  float* in = nullptr;
+  float* out = nullptr;
+  for (int i = 0; i < size; ++i) {
+    void* data = nullptr;
+    if (MXNDArrayGetData(ptrs[i], &data) != 0) return 0;
+    if (tags[i] == 0) in = static_cast<float*>(data);
+    if (tags[i] == 1) out = static_cast<float*>(data);
+  }
+  if (in == nullptr || out == nullptr) return 0;
+  for (int j = 0; j < kSize; ++j) out[j] = 2 * in[j];
+  // the callback owns the handles it is given
+  for (int i = 0; i < size; ++i) MXNDArrayFree(ptrs[i]);
+  ++forward_calls;
+  return 1;
+}
+
+int Backward(int size, void** ptrs, int* tags, const int* reqs, const int is_train,
+             void* state) {
+  return 0;
+}
+
+int ListArguments(char*** args, void* state) {
+  static const char* names[] = {"data", nullptr};
+  *args = const_cast<char**>(names);
+  return 1;
+}
+
+int ListOutputs(char*** args, void* state) {
+  static const char* names[] = {"output", nullptr};
+  *args = const_cast<char**>(names);
+  return 1;
+}
+
+int ListAuxiliaryStates(char*** args, void* state) {
+  static const char* names[] = {nullptr};
+  *args = const_cast<char**>(names);
+  return 1;
+}
+
+int InferShape(int num_input, int* ndims, int** shapes, void* state) {
+  // the output has the shape of the data
+  ndims[1] = ndims[0];
+  shapes[1] = shapes[0];
+  return 1;
+}
+
+int DeclareBackwardDependency(const int* out_grad, const int* in_data, const int* out_data,
+                              int* num_deps, int** rdeps, void* state) {
+  static thread_local int deps[1];
+  deps[0] = out_grad[0];
+  *num_deps = 1;
+  *rdeps = deps;
+  return 1;
+}
+
+int CreateOperator(const char* ctx, int num_inputs, unsigned** shapes, const int* ndims,
+                   const int* dtypes, MXCallbackList* ret, void* state) {
+  static int (*callbacks[])(void) = {
+    AsCallback(DeleteState), AsCallback(Forward), AsCallback(Backward)
+  };
+  static void* contexts[] = {nullptr, nullptr, nullptr};
+  ret->num_callbacks = 3;
+  ret->callbacks = callbacks;
+  ret->contexts = contexts;
+  return 1;
+}
+
+int CreateProp(const char* op_type, const int num_kwargs, const char** keys,
+               const char** values, MXCallbackList* ret) {
+  // the optional type and storage type callbacks are left out
+  static int (*callbacks[])(void) = {
+    AsCallback(DeleteState), AsCallback(ListArguments), AsCallback(ListOutputs),
+    AsCallback(ListAuxiliaryStates), AsCallback(InferShape),
+    AsCallback(DeclareBackwardDependency), AsCallback(CreateOperator)
+  };
+  static void* contexts[] = {nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr};
+  ret->num_callbacks = kCustomOpPropCreateOperator + 1;
+  ret->callbacks = callbacks;
+  ret->contexts = contexts;
+  return 1;
+}
+
+}  // namespace
+
+TEST(CustomOp, RegisterNative) {
+  const char* op_type = "native_times_two";
+  ASSERT_EQ(MXCustomOpRegisterNative(op_type, CreateProp), 0);
+
+  const char* profiler_keys[] = {"profile_all", "aggregate_stats", "filename"};
+  const char* profiler_vals[] = {"true", "true", "custom_op_native_profile.json"};
+  ASSERT_EQ(MXSetProfilerConfig(3, profiler_keys, profiler_vals), 0);
+  ASSERT_EQ(MXSetProfilerState(1), 0);
+
+  const uint32_t shape[] = {2, 3};
+  const std::vector<float> data = {1, 2, 3, 4, 5, 6};
+  ASSERT_EQ(data.size(), static_cast<size_t>(kSize));
+  NDArrayHandle input = nullptr;
+  ASSERT_EQ(MXNDArrayCreate(shape, 2, mxnet::Context::kCPU, 0, 0, mshadow::kFloat32, &input), 0);
+  ASSERT_EQ(MXNDArraySyncCopyFromCPU(input, data.data(), data.size()), 0);
+
+  AtomicSymbolCreator custom = const_cast<nnvm::Op*>(nnvm::Op::Get("Custom"));
+  const char* keys[] = {"op_type"};
+  const char* vals[] = {op_type};
+  const int calls = forward_calls;
+  for (int iter = 0; iter < 3; ++iter) {
+    int num_outputs = 0;
+    NDArrayHandle* outputs = nullptr;
+    const int* out_stypes = nullptr;
+    ASSERT_EQ(MXImperativeInvoke(custom, 1, &input, &num_outputs, &outputs,
+                                 1, keys, vals, &out_stypes), 0);
+    ASSERT_EQ(num_outputs, 1);
+    NDArrayHandle output = outputs[0];
+    std::vector<float> result(data.size());
+    ASSERT_EQ(MXNDArraySyncCopyToCPU(output, result.data(), result.size()), 0);
+    for (size_t i = 0; i < data.size(); ++i) {
+      EXPECT_EQ(result[i], 2 * data[i]);
+    }
+    MXNDArrayFree(output);
+  }
+  EXPECT_EQ(forward_calls - calls, 3);
+
+  ASSERT_EQ(MXNDArrayWaitAll(), 0);
+  ASSERT_EQ(MXSetProfilerState(0), 0);
+  const char* stats = nullptr;
+  ASSERT_EQ(MXAggregateProfileStatsPrint(&stats, 1, 0, 0, 0), 0);
+  const std::string table(stats);
+  // the callbacks are reported apart from the custom ops run through the python pool
+  EXPECT_NE(table.find(std::string(op_type) + "::native"), std::string::npos);
+  EXPECT_EQ(table.find(std::string(op_type) + "::pure_python"), std::string::npos);
+  MXNDArrayFree(input);
+}
@@ -0,0 +1,252 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ *  \file kernel_bench.cc
+ *  \brief Benchmark of the FCompute kernels of operators over grids of shapes and types
+ *
+ *  The kernels are called directly on prebuilt blobs, so that the timings are those of the
+ *  kernels alone, without the engine, the C API and Python. The results are written with
+ *  --bench-json <file> in the json format of benchmark/opperf, and with
+ *  --bench-baseline <file> the median time of every kernel is checked against the results
+ *  of a previous run, failing when slower by more than --bench-tolerance (0.1 for 10%).
+ *  The whole grid is run with --perf, a small part of it otherwise.
+ */
+
+#include <gtest/gtest.h>
+#include <dmlc/json.h>
+#include <mxnet/tensor_blob.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../include/test_core_op.h"
+
+using namespace mxnet;
+
+using kwargs_t = test::op::kwargs_t;
+
+namespace {
+
+/*! \brief inputs of a benchmark, as the "inputs" of the opperf results */
+struct BenchInputs {
+  std::vector<std::vector<int64_t>> shapes;
+  std::string dtype;
+  std::string context;
+
+  bool operator==(const BenchInputs &o) const {
+    return shapes == o.shapes && dtype == o.dtype && context == o.context;
+  }
+
+  void Save(dmlc::JSONWriter *writer) const {
+    writer->BeginObject();
+    writer->WriteObjectKeyValue("shapes", shapes);
+    writer->WriteObjectKeyValue("dtype", dtype);
+    writer->WriteObjectKeyValue("context", context);
+    writer->EndObject();
+  }
+
+  void Load(dmlc::JSONReader *reader) {
+    dmlc::JSONObjectReadHelper helper;
+    helper.DeclareField("shapes", &shapes);
+    helper.DeclareField("dtype", &dtype);
+    helper.DeclareField("context", &context);
+    helper.ReadAllFields(reader);
+  }
+};
+
+/*! \brief timings of a kernel in milliseconds, keyed as in the opperf results */
+struct BenchResult {
+  std::string op;
+  double avg = 0, p50 = 0, p90 = 0, p99 = 0;
+  BenchInputs inputs;
+
+  void Save(dmlc::JSONWriter *writer) const {
+    writer->BeginObject();
+    writer->WriteObjectKeyValue("avg_time_" + op, avg);
+    writer->WriteObjectKeyValue("p50_time_" + op, p50);
+    writer->WriteObjectKeyValue("p90_time_" + op, p90);
+    writer->WriteObjectKeyValue("p99_time_" + op, p99);
+    writer->WriteObjectKeyValue("inputs", inputs);
+    writer->EndObject();
+  }
+
+  void Load(dmlc::JSONReader *reader) {
+    std::string key;
+    reader->BeginObject();
+    while (reader->NextObjectItem(&key)) {
+      if (key == "inputs") {
+        reader->Read(&inputs);
+      } else if (key.compare(0, 9, "avg_time_") == 0) {
+        reader->Read(&avg);
+      } else if (key.compare(0, 9, "p50_time_") == 0) {
+        reader->Read(&p50);
+      } else if (key.compare(0, 9, "p90_time_") == 0) {
+        reader->Read(&p90);
+      } else if (key.compare(0, 9, "p99_time_") == 0) {
+        reader->Read(&p99);
+      } else {
+        // other statistics of the opperf results
+        double number;
+        reader->Read(&number);
+      }
+    }
+  }
+};
+
+/*! \brief results of the benchmark by operator */
+using BenchResults = std::map<std::string, std::vector<BenchResult>>;
+
+/*! \brief benchmarked operator, with the shapes of its inputs */
+struct BenchCase {
+  const char *op;
+  kwargs_t kwargs;
+  std::vector<mxnet::ShapeVector> shapes;
+};
+
+template<typename DType>
+const char *DTypeName();
+template<> const char *DTypeName<float>() { return "float32"; }
+template<> const char *DTypeName<double>() { return "float64"; }
+template<> const char *DTypeName<mshadow::half::half_t>() { return "float16"; }
+
+double Percentile(const std::vector<double> &sorted, double p) {
+  const size_t i = std::min(sorted.size() - 1, static_cast<size_t>(p * sorted.size()));
+  return sorted[i];
+}
+
+/*!
+ * \brief time the forward kernel of an operator
+ * \param runs number of timed runs, after as many untimed ones
+ */
+template<typename DType>
+BenchResult RunKernel(const bool isGPU, const BenchCase &bench,
+                      const mxnet::ShapeVector &shapes, const size_t runs) {
+  test::op::CoreOpExecutor<DType> op(isGPU, shapes);
+  op.set_verbose(false);
+  op.Init(op.ArgsWithOpName(bench.kwargs, bench.op, COREOP_BWD_OP_NAME_VALUE_NONE));
+  auto sync = [&op, isGPU]() {
+#if MXNET_USE_CUDA
+    if (isGPU) op.ctx().run_ctx.template get_stream<gpu>()->Wait();
+#endif  // MXNET_USE_CUDA
+  };
+  for (size_t i = 0; i < runs; ++i) op.Execute();
+  sync();
+  std::vector<double> times;
+  times.reserve(runs);
+  for (size_t i = 0; i < runs; ++i) {
+    const auto start = std::chrono::steady_clock::now();
+    op.Execute();
+    sync();
+    times.push_back(std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count());
+  }
+  std::sort(times.begin(), times.end());
+  BenchResult result;
+  result.op = bench.op;
+  for (double t : times) result.avg += t / times.size();
+  result.p50 = Percentile(times, 0.5);
+  result.p90 = Percentile(times, 0.9);
+  result.p99 = Percentile(times, 0.99);
+  for (const mxnet::TShape &shape : shapes) {
+    result.inputs.shapes.emplace_back(shape.begin(), shape.end());
+  }
+  result.inputs.dtype = DTypeName<DType>();
+  result.inputs.context = isGPU ? "gpu" : "cpu";
+  return result;
+}
+
+std::vector<BenchCase> BenchCases() {
+  if (!test::performance_run) {
+    return {
+      {"elemwise_add", {}, {{{1024}}}},
+      {"dot", {}, {{{64, 64}, {64, 64}}}},
+    };
+  }
+  return {
+    {"elemwise_add", {}, {{{64}}, {{1024}}, {{1024, 1024}}, {{32, 3, 224, 224}}}},
+    {"Activation", {{"act_type", "relu"}}, {{{64}}, {{1024, 1024}}, {{32, 3, 224, 224}}}},
+    {"softmax", {}, {{{64, 16}}, {{1024, 1024}}}},
+    {"sum", {}, {{{64}}, {{1024, 1024}}}},
+    {"dot", {}, {{{16, 16}, {16, 16}}, {{256, 256}, {256, 256}}, {{1024, 1024}, {1024, 1024}}}},
+  };
+}
+
+template<typename DType>
+void RunBenchmark(const bool isGPU, BenchResults *results) {
+  const size_t runs = test::performance_run ? 100 : 10;
+  for (const BenchCase &bench : BenchCases()) {
+    for (const mxnet::ShapeVector &shapes : bench.shapes) {
+      (*results)[bench.op].push_back(RunKernel<DType>(isGPU, bench, shapes, runs));
+    }
+  }
+}
+
+/*! \brief write the results, and check them against the baseline */
+void ReportBenchmark(const BenchResults &results) {
+  if (!test::bench_json.empty()) {
+    std::ofstream fout(test::bench_json);
+    ASSERT_TRUE(fout.is_open()) << "Failed to open " << test::bench_json;
+    dmlc::JSONWriter writer(&fout);
+    writer.Write(results);
+  }
+  if (test::bench_baseline.empty()) return;
+  std::ifstream fin(test::bench_baseline);
+  ASSERT_TRUE(fin.is_open()) << "Failed to open " << test::bench_baseline;
+  BenchResults baseline;
+  dmlc::JSONReader reader(&fin);
+  reader.Read(&baseline);
+  for (const auto &op : results) {
+    auto base = baseline.find(op.first);
+    if (base == baseline.end()) continue;
+    for (const BenchResult &result : op.second) {
+      for (const BenchResult &base_result : base->second) {
+        if (!(base_result.inputs == result.inputs)) continue;
+        std::ostringstream shapes;
+        for (const std::vector<int64_t> &shape : result.inputs.shapes) {
+          shapes << mxnet::TShape(shape.begin(), shape.end());
+        }
+        EXPECT_LE(result.p50, base_result.p50 * (1 + test::bench_tolerance))
+          << op.first << " regressed on " << result.inputs.context << " "
+          << result.inputs.dtype << " inputs " << shapes.str();
+      }
+    }
+  }
+}
+
+}  // namespace
+
+/*!
+ * \brief Kernel benchmark, on the GPU too if there is one
+ */
+TEST(KERNEL_BENCH, Timing) {
+  BenchResults results;
+  RunBenchmark<float>(false, &results);
+  RunBenchmark<double>(false, &results);
+#if MXNET_USE_CUDA == 1
+  if (test::unitTestsWithCuda) {
+    RunBenchmark<float>(true, &results);
+    RunBenchmark<mshadow::half::half_t>(true, &results);
+  }
+#endif  // MXNET_USE_CUDA == 1
+  ReportBenchmark(results);
+}
@@ -26,7 +26,16 @@
 #include <mxnet/storage.h>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <set>
+#include <thread>
+#include <vector>
 #include "test_util.h"
+#include "../../src/common/numa.h"
+#include "../../src/storage/cpu_hugepage_storage.h"
+#include "../../src/storage/gpu_async_storage_manager.h"
+#include "../../src/storage/pooled_storage_manager.h"
+#include "../../src/storage/slab_storage_manager.h"
 
 TEST(Storage, Basic_CPU) {
   constexpr size_t kSize = 1024;
@@ -69,6 +78,192 @@ TEST(Storage, CPU_MemAlign) {
   }
 }
 
+TEST(Storage, CPU_HugePage) {
+  using mxnet::storage::CPUHugePageStorage;
+  constexpr size_t kThreshold = 1024 * 1024;
+  CPUHugePageStorage huge_pages(kThreshold, false);
+  EXPECT_FALSE(huge_pages.Accepts(kThreshold - 1));
+#if defined(__linux__)
+  ASSERT_TRUE(huge_pages.Accepts(kThreshold));
+  // sizes that are not a multiple of the page size
+  for (size_t size : {kThreshold, 3 * kThreshold + 100}) {
+    void *ptr = nullptr;
+    ASSERT_TRUE(huge_pages.Alloc(&ptr, size));
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(ptr) % CPUHugePageStorage::kHugePageSize, 0);
+    std::memset(ptr, 1, size);
+    EXPECT_TRUE(huge_pages.Free(ptr));
+  }
+  // memory that does not come from the allocator is left alone
+  int local = 0;
+  EXPECT_FALSE(huge_pages.Free(&local));
+#endif
+}
+
+TEST(Storage, CPU_Slab) {
+  using mxnet::storage::SlabStorageManager;
+  mxnet::Context context_cpu = mxnet::Context::CPU(0);
+  SlabStorageManager manager(context_cpu, 0);
+  const std::vector<size_t> sizes = {1, 64, 65, 1000, 4096, 65535, 65536, 1 << 20};
+  std::vector<mxnet::Storage::Handle> handles;
+  std::set<void*> ptrs;
+  for (int k = 0; k < 100; ++k) {
+    for (size_t size : sizes) {
+      mxnet::Storage::Handle handle;
+      handle.ctx = context_cpu;
+      handle.size = size;
+      manager.Alloc(&handle);
+      ASSERT_NE(handle.dptr, nullptr);
+      EXPECT_EQ(reinterpret_cast<intptr_t>(handle.dptr) % 16, 0);
+      // chunks in use never overlap
+      EXPECT_TRUE(ptrs.insert(handle.dptr).second);
+      memset(handle.dptr, k, size);
+      handles.push_back(handle);
+    }
+  }
+  // a freed small chunk is reused by the next allocation of its size class
+  void *last = handles.front().dptr;
+  manager.Free(handles.front());
+  mxnet::Storage::Handle handle;
+  handle.ctx = context_cpu;
+  handle.size = 32;
+  manager.Alloc(&handle);
+  EXPECT_EQ(handle.dptr, last);
+  handles.front() = handle;
+
+  // chunks can be freed from other threads than the ones that allocated them
+  std::vector<std::thread> threads;
+  const size_t num_threads = 4;
+  for (size_t t = 0; t < num_threads; ++t) {
+    threads.emplace_back([&manager, &handles, t, num_threads]() {
+      for (size_t i = t; i < handles.size(); i += num_threads) {
+        manager.Free(handles[i]);
+      }
+      for (int k = 0; k < 1000; ++k) {
+        mxnet::Storage::Handle h;
+        h.size = 128;
+        manager.Alloc(&h);
+        manager.Free(h);
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  manager.ReleaseAll();
+}
+
+TEST(Storage, CPU_BestFit) {
+  mxnet::Context context_cpu = mxnet::Context::CPU(0);
+  mxnet::storage::BestFitStorageManager manager(context_cpu, 0);
+  auto alloc = [&](size_t size) {
+    mxnet::Storage::Handle handle;
+    handle.ctx = context_cpu;
+    handle.size = size;
+    manager.Alloc(&handle);
+    EXPECT_NE(handle.dptr, nullptr);
+    return handle;
+  };
+  // a freed block is split to serve smaller requests
+  auto big = alloc(3 << 20);
+  manager.Free(big);
+  auto first = alloc(1 << 20);
+  auto second = alloc(1 << 20);
+  EXPECT_EQ(first.dptr, big.dptr);
+  EXPECT_EQ(second.dptr, static_cast<char*>(big.dptr) + (1 << 20));
+  // and the pieces are merged again once freed
+  manager.Free(first);
+  manager.Free(second);
+  auto merged = alloc(3 << 20);
+  EXPECT_EQ(merged.dptr, big.dptr);
+  manager.Free(merged);
+
+  // small requests come from their own segments
+  auto small = alloc(1000);
+  auto small2 = alloc(1000);
+  EXPECT_EQ(static_cast<char*>(small2.dptr) - static_cast<char*>(small.dptr), 1024);
+  manager.Free(small);
+  manager.Free(small2);
+  manager.ReleaseAll();
+}
+
+TEST(Storage, CPU_Stats) {
+  mxnet::Context context_cpu = mxnet::Context::CPU(0);
+  mxnet::storage::PooledStorageManager<mxnet::storage::RoundMultiple,
+                                       mxnet::storage::UnorderedMapContainer>
+      naive(context_cpu, 0);
+  mxnet::storage::BestFitStorageManager best_fit(context_cpu, 0);
+  for (mxnet::storage::StorageManager *manager :
+       std::vector<mxnet::storage::StorageManager*>{&naive, &best_fit}) {
+    auto alloc = [&](size_t size) {
+      mxnet::Storage::Handle handle;
+      handle.ctx = context_cpu;
+      handle.size = size;
+      manager->Alloc(&handle);
+      return handle;
+    };
+    mxnet::Storage::Stats stats;
+    auto a = alloc(4 << 20);
+    auto b = alloc(8 << 20);
+    ASSERT_TRUE(manager->GetStats(&stats));
+    EXPECT_EQ(stats.bytes_in_use, 12u << 20);
+    EXPECT_EQ(stats.bytes_cached, 0u);
+    EXPECT_EQ(stats.num_allocs, 2u);
+    EXPECT_EQ(stats.num_pool_hits, 0u);
+    manager->Free(a);
+    manager->Free(b);
+    ASSERT_TRUE(manager->GetStats(&stats));
+    EXPECT_EQ(stats.bytes_in_use, 0u);
+    EXPECT_EQ(stats.bytes_cached, 12u << 20);
+    EXPECT_EQ(stats.peak_bytes_in_use, 12u << 20);
+    EXPECT_EQ(stats.largest_free_chunk, 8u << 20);
+    ASSERT_EQ(stats.free_chunks.size(), 2u);
+    EXPECT_EQ(stats.free_chunks[0], std::make_pair(size_t{4} << 20, size_t{1}));
+    EXPECT_NEAR(stats.fragmentation(), 1.0 / 3, 1e-9);
+    manager->Free(alloc(4 << 20));
+    ASSERT_TRUE(manager->GetStats(&stats));
+    EXPECT_EQ(stats.num_allocs, 3u);
+    EXPECT_EQ(stats.num_pool_hits, 1u);
+    manager->ReleaseAll();
+    ASSERT_TRUE(manager->GetStats(&stats));
+    EXPECT_EQ(stats.bytes_cached, 0u);
+    EXPECT_EQ(stats.fragmentation(), 0.0);
+  }
+}
+
+TEST(Storage, CPU_NumaTopology) {
+  using mxnet::common::NumaTopology;
+  EXPECT_EQ(NumaTopology::ParseCPUList("0-3,8-11"),
+            std::vector<int>({0, 1, 2, 3, 8, 9, 10, 11}));
+  EXPECT_EQ(NumaTopology::ParseCPUList("0,2-3"), std::vector<int>({0, 2, 3}));
+  EXPECT_EQ(NumaTopology::ParseCPUList("5"), std::vector<int>({5}));
+  EXPECT_TRUE(NumaTopology::ParseCPUList("").empty());
+
+  unsetenv("MXNET_CPU_NUMA_BIND");
+  const NumaTopology unbound({NumaTopology::ParseCPUList("0-3"),
+                              NumaTopology::ParseCPUList("4-7")});
+  EXPECT_FALSE(unbound.enabled());
+  EXPECT_EQ(unbound.ManagerIndexOf(mxnet::Context::CPU(1)), 0);
+
+  setenv("MXNET_CPU_NUMA_BIND", "1", 1);
+  // a single node never binds, whatever the environment says
+  const NumaTopology single({NumaTopology::ParseCPUList("0-7")});
+  EXPECT_FALSE(single.enabled());
+  EXPECT_EQ(single.NodeOf(mxnet::Context::CPU(1)), -1);
+  EXPECT_EQ(single.ManagerIndexOf(mxnet::Context::CPU(1)), 0);
+  // cpu(i) is served by the manager of node i % num_nodes
+  const NumaTopology numa({NumaTopology::ParseCPUList("0-3,8-11"),
+                           NumaTopology::ParseCPUList("4-7,12-15")});
+  EXPECT_TRUE(numa.enabled());
+  EXPECT_EQ(numa.num_nodes(), 2);
+  EXPECT_EQ(numa.cpus(1), std::vector<int>({4, 5, 6, 7, 12, 13, 14, 15}));
+  for (int dev_id = 0; dev_id < 4; ++dev_id) {
+    EXPECT_EQ(numa.NodeOf(mxnet::Context::CPU(dev_id)), dev_id % 2);
+    EXPECT_EQ(numa.ManagerIndexOf(mxnet::Context::CPU(dev_id)), dev_id % 2);
+  }
+  // other device types keep one manager per device
+  EXPECT_EQ(numa.NodeOf(mxnet::Context::CPUPinned(1)), -1);
+  EXPECT_EQ(numa.ManagerIndexOf(mxnet::Context::CPUPinned(1)), 1);
+  EXPECT_EQ(numa.ManagerIndexOf(mxnet::Context::GPU(3)), 3);
+  unsetenv("MXNET_CPU_NUMA_BIND");
+}
 
 #if MXNET_USE_CUDA
 TEST(Storage_GPU, Basic_GPU) {
@@ -128,5 +323,30 @@ TEST(Storage_GPU, Basic_GPU) {
     storage->Free(handle);
   }
 }
+
+#if MXNET_CUDA_MALLOC_ASYNC_SUPPORTED
+TEST(Storage_GPU, Async_GPU) {
+  if (mxnet::test::unitTestsWithCuda) {
+    int supported = 0;
+    cudaDeviceGetAttribute(&supported, cudaDevAttrMemoryPoolsSupported, 0);
+    if (!supported) return;
+    mxnet::Context context_gpu = mxnet::Context::GPU(0);
+    mxnet::storage::GPUAsyncStorageManager manager(context_gpu);
+    mxnet::Storage::Handle handle;
+    handle.ctx = context_gpu;
+    handle.size = 1 << 20;
+    manager.Alloc(&handle);
+    EXPECT_NE(handle.dptr, nullptr);
+    CUDA_CALL(cudaMemset(handle.dptr, 0, handle.size));
+    manager.Free(handle);
+    // freed memory is handed out again without synchronizing the device
+    manager.Alloc(&handle);
+    EXPECT_NE(handle.dptr, nullptr);
+    CUDA_CALL(cudaMemset(handle.dptr, 0, handle.size));
+    manager.Free(handle);
+    manager.ReleaseAll();
+  }
+}
+#endif  // MXNET_CUDA_MALLOC_ASYNC_SUPPORTED
 #endif  // MXNET_USE_CUDA
 
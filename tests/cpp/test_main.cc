@@ -48,6 +48,9 @@ bool quick_test = false;
 bool performance_run = false;
 bool csv = false;
 bool thread_safety_force_cpu = false;
+std::string bench_json;
+std::string bench_baseline;
+double bench_tolerance = 0.1;
 }  // namespace test
 }  // namespace mxnet
 
@@ -105,6 +108,12 @@ int main(int argc, char ** argv) {
       mxnet::test::csv = true;
     } else if (!strcmp(arg, "--quick") || !strcmp(arg, "-q")) {
       mxnet::test::quick_test = true;
+    } else if (!strcmp(arg, "--bench-json") && x + 1 < argc) {
+      mxnet::test::bench_json = argv[++x];
+    } else if (!strcmp(arg, "--bench-baseline") && x + 1 < argc) {
+      mxnet::test::bench_baseline = argv[++x];
+    } else if (!strcmp(arg, "--bench-tolerance") && x + 1 < argc) {
+      mxnet::test::bench_tolerance = atof(argv[++x]);
     } else if (!strcmp(arg, "--thread-safety-with-cpu")) {
       mxnet::test::thread_safety_force_cpu = true;
     } else if (!strcmp(arg, "--backtrace")) {
@@ -0,0 +1,77 @@
+#!/usr/bin/env python
+
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+import sys
+sys.path.insert(0, "../../python/")
+import mxnet as mx
+import numpy as np
+
+def check_diff_to_scalar(A, x, rank=None):
+    """ assert A == x"""
+    assert(np.sum(np.abs((A - x).asnumpy())) == 0), (rank, A.asnumpy(), x)
+
+# setup
+rate = 2
+num_gpus = 2
+shape = (2, 3)
+big_shape = (1200, 1200)        # bigger than MXNET_KVSTORE_BIGARRAY_BOUND
+
+kv = mx.kv.create('dist_allreduce')
+my_rank = kv.rank
+nworker = kv.num_workers
+
+def test_init():
+    # every worker starts from the values of rank 0
+    kv.init('1', mx.nd.ones(shape) * (my_rank + 1))
+    kv.init('2', mx.nd.ones(big_shape) * (my_rank + 1))
+    for key, s in [('1', shape), ('2', big_shape)]:
+        val = mx.nd.zeros(s)
+        kv.pull(key, out=val)
+        check_diff_to_scalar(val, 1, my_rank)
+
+def test_pushpull():
+    kv.init('3', mx.nd.zeros(shape))
+    kv.init('4', mx.nd.zeros(big_shape))
+    num = (nworker + 1) * nworker * num_gpus / 2
+    for key, s in [('3', shape), ('4', big_shape)]:
+        for ctx in [mx.gpu, lambda j: mx.cpu()]:
+            arr = [mx.nd.ones(s, ctx=ctx(j)) * (my_rank + 1) for j in range(num_gpus)]
+            vals = [mx.nd.zeros(s, ctx=ctx(j)) for j in range(num_gpus)]
+            kv.pushpull(key, arr, out=vals)
+            for v in vals:
+                check_diff_to_scalar(v, num, my_rank)
+
+def test_push_pull_updater():
+    kv.set_optimizer(mx.optimizer.create('test', rescale_grad=rate))
+    kv.init('5', mx.nd.ones(shape))
+    kv.init('6', mx.nd.ones(big_shape))
+    for i in range(3):
+        num = (nworker + 1) * nworker * rate * num_gpus / 2 * (i + 1) + 1
+        for key, s in [('5', shape), ('6', big_shape)]:
+            arr = [mx.nd.ones(s, ctx=mx.gpu(j)) * (my_rank + 1) for j in range(num_gpus)]
+            kv.push(key, arr)
+            val = mx.nd.zeros(s)
+            kv.pull(key, out=val)
+            check_diff_to_scalar(val, num, my_rank)
+
+if __name__ == "__main__":
+    test_init()
+    test_pushpull()
+    test_push_pull_updater()
+    print('worker ' + str(my_rank) + ' is done')
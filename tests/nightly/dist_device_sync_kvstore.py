@@ -34,6 +34,7 @@ init_test_keys = [str(i) for i in range(200,300)]
 init_test_keys_big = [str(i) for i in range(300,400)]
 init_test_keys_device = [str(i) for i in range(400,500)]
 init_test_keys_device_big = [str(i) for i in range(500,600)]
+compr_keys_shapes = [('1000', (2, 3)), ('1300', (1200, 1200))]
 
 rate = 2
 shape = (2, 3)
@@ -124,8 +125,29 @@ def test_gluon_trainer_type():
     my_rank = kv.rank
     print('worker ' + str(my_rank) + ' passed test_gluon_trainer_type')
 
+def test_sync_intra_node_compression(nrepeat=3):
+    # float16 holds the small integers pushed exactly, on the way to the merging GPU
+    # and on the way to the servers
+    kv.set_gradient_compression({'type': 'fp16', 'intra_node': True})
+    for k, s in compr_keys_shapes:
+        kv.init(k, mx.nd.zeros(s))
+    my_rank = kv.rank
+    nworker = kv.num_workers
+    num_gpus = 2
+    expected = (nworker + 1) * nworker * num_gpus / 2
+    for i in range(nrepeat):
+        for k, s in compr_keys_shapes:
+            arr = [mx.nd.ones(s, ctx=mx.gpu(j)) * (my_rank + 1) for j in range(num_gpus)]
+            kv.push(k, arr)
+            val = mx.nd.zeros(s)
+            kv.pull(k, out=val)
+            check_diff_to_scalar(val, expected, my_rank)
+    print('worker ' + str(my_rank) + ' passed test_sync_intra_node_compression')
+
 if __name__ == "__main__":
     test_sync_init()
     # TODO(szha): disabled due to repeated failures. tracked in #18098
     # test_sync_push_pull()
     test_gluon_trainer_type()
+    # last, the kvstore keeps the gradient compression
+    test_sync_intra_node_compression()
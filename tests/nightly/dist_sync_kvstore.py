@@ -18,6 +18,7 @@
 # under the License.
 
 # pylint: skip-file
+import os
 import sys
 sys.path.insert(0, "../../python/")
 import argparse
@@ -434,6 +435,115 @@ def test_gluon_trainer_sparse_step():
     check_trainer_sparse_step()
     print('worker ' + str(my_rank) + ' passed test_gluon_trainer_sparse_step')
 
+def test_fused_pushpull(nrepeat):
+    # the small values of a pushpull are sent in fused buckets, the big one alone
+    shapes = [(3,), (2, 3), (4, 5), (1,), (7, 2), big_shape]
+    dtypes = ['float32', 'float32', 'float16', 'float32', 'float16', 'float32']
+    fused_keys = [str(i) for i in range(700, 700 + len(shapes))]
+    kv.init(fused_keys, [mx.nd.zeros(s, dtype=t) for s, t in zip(shapes, dtypes)])
+    for i in range(nrepeat):
+        scale = (my_rank + 1) * (i + 1)
+        vals = [mx.nd.ones(s, dtype=t) * scale for s, t in zip(shapes, dtypes)]
+        outs = [mx.nd.zeros(s, dtype=t) for s, t in zip(shapes, dtypes)]
+        kv.pushpull(fused_keys, vals, out=outs)
+        expected = (nworker + 1) * nworker / 2 * (i + 1)
+        for out in outs:
+            check_diff(out, expected)
+    print('worker ' + str(my_rank) + ' passed test_fused_pushpull')
+
+def test_gluon_trainer_fused_step():
+    ctx = mx.cpu(0)
+    params = [mx.gluon.Parameter('x%d' % i, shape=(i + 1, 2)) for i in range(4)]
+    for p in params:
+        p.initialize(ctx=ctx, init='ones')
+    trainer = mx.gluon.Trainer(params, 'sgd', {'learning_rate': 1.0}, kvstore=kv,
+                               update_on_kvstore=False)
+    with mx.autograd.record():
+        y = sum(((my_rank + 1) * p.data(ctx)).sum() for p in params)
+    y.backward()
+    trainer.step(1)
+    expected = 1 - (1 + nworker) * nworker / 2
+    for p in params:
+        assert_almost_equal(p.data(ctx).asnumpy(), np.full(p.shape, expected))
+    print('worker ' + str(my_rank) + ' passed test_gluon_trainer_fused_step')
+
+def test_gluon_trainer_local_sgd():
+    ctx = mx.cpu(0)
+    x = mx.gluon.Parameter('x', shape=(2, 3))
+    x.initialize(ctx=ctx, init='ones')
+    trainer = mx.gluon.Trainer([x], 'sgd', {'learning_rate': 1.0}, kvstore=kv,
+                               local_sgd_period=2)
+    for i in range(4):
+        with mx.autograd.record():
+            y = ((my_rank + 1) * x.data(ctx)).sum()
+        y.backward()
+        trainer.step(1)
+        if i % 2 == 0:
+            # the worker only applies its own gradient
+            expected = 1 - (i // 2) * (nworker + 1) - (my_rank + 1)
+        else:
+            # then the parameters are averaged over the workers
+            expected = 1 - (i // 2 + 1) * (nworker + 1)
+        assert_almost_equal(x.data(ctx).asnumpy(), np.full((2, 3), expected))
+    print('worker ' + str(my_rank) + ' passed test_gluon_trainer_local_sgd')
+
+def test_row_cache(nrepeat):
+    # the rows pulled again within MXNET_KVSTORE_ROW_CACHE_STALENESS pushes are cached
+    staleness = int(os.environ.get('MXNET_KVSTORE_ROW_CACHE_STALENESS', 0))
+    k = '900'
+    s = (8, 3)
+    kv.init(k, mx.nd.ones(s).tostype('row_sparse'))
+    kv.set_optimizer(mx.optimizer.create('test', rescale_grad=rate))
+    # only the differences of versions matter
+    version = 0
+    cached = {}
+    for i in range(nrepeat):
+        kv.push(k, mx.nd.ones(s).tostype('row_sparse'))
+        version += 1
+        fresh = 1 + nworker * rate * (i + 1)
+        # the first half of the rows every step, the second half every other step
+        row_ids_np = np.arange(s[0] // 2) if i % 2 == 0 else np.arange(s[0])
+        expected = np.zeros(s)
+        for row in row_ids_np:
+            if row not in cached or version - cached[row][0] > staleness:
+                cached[row] = (version, fresh)
+            expected[row] = cached[row][1]
+        # a second pull before the next push is served from the cache
+        for _ in range(2):
+            val = mx.nd.sparse.zeros('row_sparse', s)
+            kv.row_sparse_pull(k, out=val, row_ids=mx.nd.array(row_ids_np))
+            assert_almost_equal(val.asnumpy(), expected)
+    print('worker ' + str(my_rank) + ' passed test_row_cache')
+
+def test_lazy_update(nrepeat):
+    # the servers update the rows of the row_sparse gradients as the python optimizers do
+    s = (8, 3)
+    optimizers = [('adam', {'lazy_update': True, 'wd': 0.1, 'clip_gradient': 3.0}),
+                  ('adagrad', {'epsilon': 1e-5}),
+                  ('ftrl', {'lamda1': 0.05, 'wd': 0.1})]
+    for i, (name, kwargs) in enumerate(optimizers):
+        k = str(950 + i)
+        kv.init(k, mx.nd.ones(s).tostype('row_sparse'))
+        kv.set_optimizer(mx.optimizer.create(name, learning_rate=0.1, rescale_grad=rate, **kwargs))
+        updater = mx.optimizer.get_updater(
+            mx.optimizer.create(name, learning_rate=0.1, rescale_grad=rate, **kwargs))
+        expected = mx.nd.ones(s).tostype('row_sparse')
+        all_rows = mx.nd.arange(0, s[0])
+        for j in range(nrepeat):
+            # a different half of the rows every step
+            row_ids = mx.nd.array(np.arange(s[0] // 2) + (j % 2) * (s[0] // 2))
+            grad = mx.nd.sparse.row_sparse_array(
+                (mx.nd.ones((s[0] // 2, s[1])) * (my_rank + 1) * (j + 1), row_ids), shape=s)
+            kv.push(k, grad)
+            merged = mx.nd.sparse.row_sparse_array(
+                (mx.nd.ones((s[0] // 2, s[1])) * nworker * (nworker + 1) / 2 * (j + 1), row_ids),
+                shape=s)
+            updater(int(k), merged, expected)
+            val = mx.nd.sparse.zeros('row_sparse', s)
+            kv.row_sparse_pull(k, out=val, row_ids=all_rows)
+            assert_almost_equal(val.asnumpy(), expected.asnumpy(), rtol=1e-5, atol=1e-6)
+    print('worker ' + str(my_rank) + ' passed test_lazy_update')
+
 if __name__ == "__main__":
     parser = argparse.ArgumentParser(description='test distributed kvstore in dist_sync mode')
     parser.add_argument('--nrepeat', type=int, default=7)
@@ -447,6 +557,15 @@ if __name__ == "__main__":
         test_gluon_trainer_step()
     elif opt.type == 'gluon_sparse_step_cpu':
         test_gluon_trainer_sparse_step()
+    elif opt.type == 'fused_cpu':
+        test_fused_pushpull(opt.nrepeat)
+        test_gluon_trainer_fused_step()
+    elif opt.type == 'local_sgd_cpu':
+        test_gluon_trainer_local_sgd()
+    elif opt.type == 'row_cache_cpu':
+        test_row_cache(opt.nrepeat)
+    elif opt.type == 'lazy_update_cpu':
+        test_lazy_update(opt.nrepeat)
     elif opt.type == 'invalid_cpu':
         test_invalid_operations()
     elif opt.type == 'init_gpu':
@@ -28,6 +28,7 @@ test_kvstore() {
         "-n 4 --launcher local python3 dist_device_sync_kvstore_custom.py"
         "--p3 -n 4 --launcher local python3 dist_device_sync_kvstore_custom.py"
         "-n 4 --launcher local python3 dist_sync_kvstore.py --type=init_gpu"
+        "-n 2 --launcher local python3 dist_allreduce_kvstore.py"
     )
 
     for arg in "${test_args[@]}"; do
@@ -76,6 +76,32 @@ def compute_expected_2bit_quantization(arr, curr_residual, threshold):
         i+=32
     return np.array(compr), np.array(new_residual).reshape(arr.shape), np.array(decompr).reshape(arr.shape)
 
+def compute_expected_1bit_quantization(arr, curr_residual, threshold):
+    a = arr.asnumpy() + curr_residual
+    decompr = np.where(a >= 0, threshold, -threshold).astype(np.float32)
+    return a - decompr, decompr
+
+def compute_expected_topk_sparsification(arr, curr_residual, block_size):
+    a = (arr.asnumpy() + curr_residual).flatten()
+    pad = (-a.size) % block_size
+    blocks = np.concatenate([a, np.zeros(pad, dtype=a.dtype)]).reshape(-1, block_size)
+    picks = np.argmax(np.abs(blocks), axis=1)
+    decompr = np.zeros_like(blocks)
+    rows = np.arange(blocks.shape[0])
+    decompr[rows, picks] = blocks[rows, picks].astype(np.float16).astype(np.float32)
+    decompr = decompr.flatten()[:a.size]
+    return (a - decompr).reshape(arr.shape), decompr.reshape(arr.shape)
+
+def compute_expected_16bit_quantization(arr, curr_residual, bfloat):
+    a = (arr.asnumpy() + curr_residual).astype(np.float32)
+    if bfloat:
+        bits = a.view(np.uint32).astype(np.uint64)
+        bits = ((bits + 0x7fff + ((bits >> 16) & 1)) >> 16) << 16
+        decompr = bits.astype(np.uint32).view(np.float32)
+    else:
+        decompr = a.astype(np.float16).astype(np.float32)
+    return a - decompr, decompr
+
 ## individual key interface
 def test_kvstore(kv_type, stype):
     print(kv_type)
@@ -211,6 +237,51 @@ def test_compress_kvstore(kv_type, compression='2bit', threshold=0.5):
     check_neg(kv, -1*threshold, rate, curval)
     check_compr_random(kv, threshold)
 
+def test_compress_kvstore_types(kv_type):
+    rate = 2
+    threshold = 0.25
+    block_size = 8
+    for compression in ['1bit', 'topk', 'randk', 'fp16', 'bf16']:
+        print(kv_type + ' with ' + compression + ' compression')
+        kv = mx.kv.create(kv_type)
+        kv.set_gradient_compression({'type': compression, 'threshold': threshold,
+                                     'block_size': block_size})
+        kv.set_optimizer(mx.optimizer.create('test', rescale_grad=rate))
+        for k, s in zip(keys, shapes):
+            kv.init(k, mx.nd.zeros(s))
+        for k, s in zip(keys, shapes):
+            curr_residual = [np.zeros(s, dtype=np.float32) for g in range(nworker)]
+            for r in range(3):
+                orig_val = [mx.nd.zeros(s, mx.gpu(g)) for g in range(nworker)]
+                kv.pull(k, out=orig_val)
+                grads = [mx.nd.random_uniform(-0.6, 0.6, shape=s, ctx=mx.gpu(g))
+                         for g in range(nworker)]
+                grads_cpy = copy.deepcopy(grads)
+                kv.push(k, grads)
+                val = [mx.nd.zeros(s, mx.gpu(g)) for g in range(nworker)]
+                kv.pull(k, out=val)
+                diff = (val[0] - orig_val[0]).asnumpy()
+                if compression == 'randk':
+                    # one value of each block is sent per device
+                    flat = diff.flatten()
+                    flat = np.concatenate([flat, np.zeros((-flat.size) % block_size)])
+                    nonzeros = np.count_nonzero(flat.reshape(-1, block_size), axis=1)
+                    assert np.all(nonzeros <= nworker)
+                    continue
+                expected = np.zeros(s)
+                for g in range(nworker):
+                    if compression == '1bit':
+                        curr_residual[g], decompr = compute_expected_1bit_quantization(
+                            grads_cpy[g], curr_residual[g], threshold)
+                    elif compression in ['fp16', 'bf16']:
+                        curr_residual[g], decompr = compute_expected_16bit_quantization(
+                            grads_cpy[g], curr_residual[g], compression == 'bf16')
+                    else:
+                        curr_residual[g], decompr = compute_expected_topk_sparsification(
+                            grads_cpy[g], curr_residual[g], block_size)
+                    expected += decompr * rate
+                assert_almost_equal(diff, expected, rtol=1e-4, atol=1e-5)
+
 ## group keys interface
 def test_group_kvstore(kv_type, stype):
     print(kv_type)
@@ -253,6 +324,7 @@ if __name__ == "__main__":
 
     ## compression for local kvstore happens only when reduce is on device
     test_compress_kvstore('local_allreduce_device')
+    test_compress_kvstore_types('local_allreduce_device')
     for stype in stypes:
         test_group_kvstore('local_update_cpu', stype)
         test_group_kvstore('local_allreduce_cpu', stype)
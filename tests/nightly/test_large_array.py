@@ -1755,3 +1755,36 @@ def test_sparse_dot():
     assert out.asnumpy()[0][0] == 2
     assert out.shape == (2, 2)
 
+
+
+@pytest.mark.timeout(0)
+@pytest.mark.skipif(mx.context.num_gpus() == 0, reason="requires a GPU")
+@pytest.mark.skipif(not mx.runtime.Features().is_enabled('INT64_TENSOR_SIZE'),
+                    reason="requires USE_INT64_TENSOR_SIZE")
+@pytest.mark.parametrize('size', [2**31 - 2**25, 2**31 - 64, 2**31 + 64, 2**32 + 64])
+def test_gpu_index_math(size):
+    # GPU kernels run a 32-bit loop while the size plus the grid stride fits in int, and
+    # index_div divides in 32 bits below 2^32, the sizes are on both sides of these bounds
+    ctx = mx.gpu(0)
+    cols = 64
+    rows = size // cols
+    # every row holds its index modulo 100, so that any index error shows in the values
+    row_ids = (nd.arange(rows, ctx=ctx, dtype='int32') % 100).astype('int8')
+    cols_ids = nd.arange(cols, ctx=ctx, dtype='int8').reshape((1, cols))
+    a = nd.broadcast_add(nd.zeros((rows, cols), ctx=ctx, dtype='int8'),
+                         row_ids.reshape((rows, 1)))
+    out = nd.broadcast_add(a, cols_ids)
+    assert out.shape == (rows, cols)
+    for r in [0, rows // 2, rows - 1]:
+        assert (out[r].asnumpy() == (r % 100) + np.arange(cols)).all()
+    del out
+
+    # take rows on both sides of the bounds, and single elements of the flattened array
+    indices = [0, 2**31 // cols - 1, 2**31 // cols, rows // 2, rows - 1]
+    taken = nd.take(a, nd.array(indices, ctx=ctx, dtype='int64'), axis=0)
+    for i, r in enumerate(indices):
+        assert (taken[i].asnumpy() == r % 100).all()
+    flat_indices = [0, 2**31 - 1, 2**31, size // 2, rows * cols - 1]
+    flat_indices = [i for i in flat_indices if i < rows * cols]
+    taken = nd.take(a.reshape((-1,)), nd.array(flat_indices, ctx=ctx, dtype='int64'))
+    assert (taken.asnumpy() == np.array([(i // cols) % 100 for i in flat_indices])).all()
@@ -276,6 +276,44 @@ def test_fusion_compiler_cache():
     if num_gpus > 1:
         check_fused_symbol(a+b, ctx=mx.gpu(1), a=arr1, b=arr2)
 
+@with_seed()
+def test_fusion_reductions():
+    a = mx.sym.Variable('a')
+    # softmax over the last axis, written with primitives
+    e = mx.sym.exp(mx.sym.broadcast_sub(a, mx.sym.max(a, axis=-1, keepdims=True)))
+    softmax = mx.sym.broadcast_div(e, mx.sym.sum(e, axis=-1, keepdims=True))
+    # layer normalization, with dependent reductions
+    centered = mx.sym.broadcast_sub(a, mx.sym.mean(a, axis=-1, keepdims=True))
+    var = mx.sym.mean(mx.sym.square(centered), axis=-1, keepdims=True)
+    layernorm = mx.sym.broadcast_div(centered, mx.sym.sqrt(var + 1e-5))
+    # reduction dropping the reduced axis
+    norm = mx.sym.sqrt(mx.sym.sum(mx.sym.square(a), axis=-1))
+    for shape in [(7, 5, 300), (3, 1500), (4, 1)]:
+        arr = mx.random.uniform(shape=shape)
+        for sym in [softmax, layernorm, norm, mx.sym.Group([softmax, norm])]:
+            check_fused_symbol(sym, a=arr)
+
+def test_fusion_persistent_cache():
+    # The kernels compiled by a first process are loaded from MXNET_RTC_CACHE_DIR by a second one
+    import subprocess
+    import tempfile
+    script = """
+import mxnet as mx
+a = mx.sym.Variable('a')
+b = mx.sym.Variable('b')
+sym = mx.sym.identity(mx.sym.identity((a + b) * 2))
+exe = sym._simple_bind(ctx=mx.gpu(0), a=(4, 5), b=(4, 5))
+out = exe.forward(a=mx.nd.ones((4, 5)), b=mx.nd.ones((4, 5)))[0]
+assert (out.asnumpy() == 4).all()
+"""
+    with tempfile.TemporaryDirectory() as cache_dir:
+        env = dict(os.environ, MXNET_USE_FUSION='1', MXNET_RTC_CACHE_DIR=cache_dir)
+        subprocess.check_call([sys.executable, '-c', script], env=env)
+        cached = sorted(os.listdir(cache_dir))
+        assert len(cached) > 0 and all(f.endswith('.ptx') for f in cached)
+        subprocess.check_call([sys.executable, '-c', script], env=env)
+        assert sorted(os.listdir(cache_dir)) == cached
+
 @with_seed()
 @use_np
 def test_fusion_boolean_inputs():
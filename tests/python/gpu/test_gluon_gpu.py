@@ -30,7 +30,7 @@ import pytest
 
 curr_path = os.path.dirname(os.path.abspath(os.path.expanduser(__file__)))
 sys.path.insert(0, os.path.join(curr_path, '../unittest'))
-from common import setup_module, with_seed, teardown_module, assert_raises_cudnn_not_satisfied, run_in_spawned_process
+from common import setup_module, with_seed, teardown_module, assert_raises_cudnn_not_satisfied, run_in_spawned_process, random_seed
 from test_gluon import *
 from test_loss import *
 from test_numpy_loss import *
@@ -647,3 +647,81 @@ def test_gemms_true_fp16():
     assert_almost_equal(ref_results.asnumpy(), results_trueFP16.asnumpy(),
                         atol=atol, rtol=rtol)
 
+
+@with_seed()
+@pytest.mark.parametrize('prefetch_distance', [0, 2])
+def test_offload_activations(prefetch_distance):
+    ctx = mx.gpu(0)
+    def build():
+        net = nn.HybridSequential()
+        net.add(nn.Dense(256, activation='relu'),
+                nn.Dense(256, activation='tanh'),
+                nn.Dense(10))
+        net.initialize(mx.init.Xavier(), ctx=ctx)
+        return net
+    ref_net = build()
+    net = build()
+    for p, ref_p in zip(net.collect_params().values(), ref_net.collect_params().values()):
+        p.set_data(ref_p.data())
+    ref_net.hybridize()
+    # small threshold, so that all the activations are offloaded
+    net.hybridize(offload_activations=True, offload_min_size=1,
+                  offload_prefetch_distance=prefetch_distance)
+
+    x = mx.nd.random.uniform(shape=(64, 512), ctx=ctx)
+    for _ in range(2):
+        for n in (ref_net, net):
+            with autograd.record():
+                y = n(x)
+            y.backward()
+        assert_almost_equal(net(x), ref_net(x))
+        for p, ref_p in zip(net.collect_params().values(), ref_net.collect_params().values()):
+            assert_almost_equal(p.grad(), ref_p.grad(), rtol=1e-5, atol=1e-6)
+
+
+@with_seed()
+@pytest.mark.parametrize('try_nopython', [False, True])
+def test_data_loader_copy_to_gpu(try_nopython):
+    data = np.random.uniform(size=(50, 3, 4)).astype(np.float32)
+    dataset = mx.gluon.data.SimpleDataset(data)
+    loader = mx.gluon.data.DataLoader(dataset, 8, num_workers=2, pin_memory=True,
+                                      pin_device_id=0, copy_to_gpu=True,
+                                      try_nopython=try_nopython)
+    for _ in range(2):
+        batches = list(loader)
+        assert len(batches) == 7
+        for batch in batches:
+            assert batch.context == mx.gpu(0)
+        assert_almost_equal(np.concatenate([b.asnumpy() for b in batches]), data)
+
+
+def _cuda_graphs_func(_, seed, results):
+    # the parameters and the inputs only depend on the seed shared by the processes
+    with random_seed(seed):
+        net = mx.gluon.nn.HybridSequential()
+        net.add(mx.gluon.nn.Dense(64, activation='relu'),
+                mx.gluon.nn.Dense(32, activation='tanh'),
+                mx.gluon.nn.Dense(8))
+        net.initialize(ctx=mx.gpu(0))
+        net.hybridize(static_alloc=True, static_shape=True)
+        inputs = [mx.nd.random.uniform(-1, 1, shape=(4, 16), ctx=mx.gpu(0)) for _ in range(3)]
+    # segments are run, then captured, then replayed, so each input is run several times
+    outputs = []
+    for _ in range(3):
+        for x in inputs:
+            outputs.append(net(x).asnumpy().tolist())
+    results.extend(outputs)
+
+@with_seed()
+def test_cuda_graphs():
+    results = {}
+    seed = np.random.randint(0, 1024 * 1024 * 1024)
+    for enabled in ['0', '1']:
+        results[enabled] = mp.Manager().list()
+        # CUDA graphs are enabled once per process
+        if not run_in_spawned_process(_cuda_graphs_func, {'MXNET_ENABLE_CUDA_GRAPHS': enabled},
+                                      seed, results[enabled]):
+            return
+    assert len(results['0']) == len(results['1']) == 9
+    for ref, out in zip(results['0'], results['1']):
+        assert_almost_equal(np.array(out), np.array(ref), rtol=1e-5, atol=1e-6)
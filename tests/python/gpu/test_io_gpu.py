@@ -0,0 +1,67 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+import os
+import mxnet as mx
+import numpy as np
+import pytest
+from mxnet.runtime import Features
+
+cv2 = pytest.importorskip('cv2')
+
+pytestmark = pytest.mark.skipif(not Features().is_enabled('NVJPEG'),
+                                reason='MXNet is built without nvJPEG')
+
+
+def _write_rec(path, num_images, img_fmt):
+    rng = np.random.RandomState(1234)
+    record = mx.recordio.MXRecordIO(path, 'w')
+    for i in range(num_images):
+        # smooth images keep the JPEG decoders of the CPU and the GPU close
+        img = cv2.resize(rng.randint(0, 256, (5, 6, 3)).astype(np.uint8), (48, 40))
+        header = mx.recordio.IRHeader(0, float(i), i, 0)
+        record.write(mx.recordio.pack_img(header, img, quality=95, img_fmt=img_fmt))
+    record.close()
+
+
+def _read_all(**kwargs):
+    it = mx.io.ImageRecordIter(data_shape=(3, 32, 32), batch_size=4, shuffle=False,
+                               preprocess_threads=2, **kwargs)
+    data, label = [], []
+    for batch in it:
+        assert batch.pad == 0
+        data.append(batch.data[0].asnumpy())
+        label.append(batch.label[0].asnumpy())
+    return np.concatenate(data), np.concatenate(label)
+
+
+@pytest.mark.parametrize('img_fmt,atol', [('.jpg', 3), ('.png', 0)])
+@pytest.mark.parametrize('dtype', ['float32', 'uint8'])
+def test_image_record_iter_gpu_decode(tmpdir, img_fmt, atol, dtype):
+    path = os.path.join(str(tmpdir), 'data.rec')
+    _write_rec(path, 8, img_fmt)
+    kwargs = dict(path_imgrec=path, dtype=dtype, mirror=True)
+    if dtype == 'float32':
+        kwargs.update(mean_r=123.68, mean_g=116.28, mean_b=103.53,
+                      std_r=58.395, std_g=57.12, std_b=57.375)
+        atol = atol / 57.
+    expected_data, expected_label = _read_all(**kwargs)
+    data, label = _read_all(gpu_decode=True, device_id=0, **kwargs)
+    assert data.dtype == expected_data.dtype
+    np.testing.assert_allclose(label, expected_label)
+    np.testing.assert_allclose(data.astype(np.float32), expected_data.astype(np.float32),
+                               rtol=0, atol=atol + 1e-5)
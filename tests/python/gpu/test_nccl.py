@@ -19,6 +19,7 @@ import mxnet as mx
 import numpy as np
 import os
 import pytest
+from mxnet.test_utils import environment
 
 shapes = [(10), (100), (1000), (10000), (100000), (2,2), (2,3,4,5,6,7,8)]
 keys = [1,2,3,4,5,6,7]
@@ -49,5 +50,24 @@ def test_nccl_pushpull():
 
     print ("Passed")
 
+@pytest.mark.skip(reason="Test requires NCCL library installed and enabled during build")
+def test_nccl_pushpull_channels():
+    # consecutive pushes and pulls use the channels in turn
+    n_gpus = max(gpus)
+    with environment('MXNET_KVSTORE_NCCL_CHANNELS', '3'):
+        kv_nccl = mx.kv.create('nccl')
+    channel_keys = [str(100 + key) for key in keys]
+    for shape, key in zip(shapes, channel_keys):
+        kv_nccl.init(key, mx.nd.zeros(shape, mx.gpu(0)))
+    for i in range(3):
+        for shape, key in zip(shapes, channel_keys):
+            kv_nccl.push(key, [mx.nd.ones(shape, mx.gpu(x)) * (i + 1) for x in range(n_gpus)])
+        for shape, key in zip(shapes, channel_keys):
+            res = [mx.nd.zeros(shape, mx.gpu(x)) for x in range(n_gpus)]
+            kv_nccl.pull(key, res)
+            for x in range(n_gpus):
+                assert(np.sum(np.abs((res[x] - n_gpus * (i + 1)).asnumpy())) == 0)
+
 if __name__ == '__main__':
     test_nccl_pushpull()
+    test_nccl_pushpull_channels()
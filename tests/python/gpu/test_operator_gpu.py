@@ -24,6 +24,7 @@ import mxnet as mx
 import numpy as np
 import pytest
 import itertools
+import json
 import scipy.sparse as sps
 import mxnet.ndarray.sparse as mxsps
 from mxnet.test_utils import check_consistency, set_default_context, assert_almost_equal, assert_allclose
@@ -223,6 +224,38 @@ def test_multi_sum_sq():
             tol2 = 1e-6 if low_tol else 1e-7
             check_multi_sum_sq(dtype, shapes, ctx, tol1, tol2)
 
+@with_seed()
+def test_multi_clip_global_norm():
+    def check(dtype, shapes, max_norm, ctx):
+        values_arr = [np.random.rand(*shape).astype(dtype) * 10. for shape in shapes]
+        mx_vals = _make_ndarrays(values_arr, ctx=ctx)
+        norm = mx.nd.empty((1,), ctx=ctx)
+        finite = mx.nd.empty((1,), ctx=ctx)
+        mx.nd.multi_clip_global_norm(*mx_vals, num_arrays=len(shapes), max_norm=max_norm,
+                                     out=mx_vals + [norm, finite])
+        ref_norm = np.sqrt(sum((v.astype('float64') ** 2).sum() for v in values_arr))
+        ref_scale = min(1.0, max_norm / (ref_norm + 1e-8))
+        tol = 1e-2 if dtype == 'float16' else 1e-5
+        assert_almost_equal(norm.asnumpy(), np.array([ref_norm]), rtol=tol, atol=tol)
+        assert finite.asscalar() == 1
+        for v, ref in zip(mx_vals, values_arr):
+            assert_almost_equal(v.asnumpy(), ref * ref_scale, rtol=tol, atol=tol)
+
+    for ctx in [mx.cpu(), mx.gpu(0)]:
+        for dtype in ['float16', 'float32', 'float64']:
+            # more arrays than fit in one launch of the kernels
+            shapes = [np.random.randint(1, 5000, size=1) for _ in range(130)]
+            check(dtype, shapes, 1.0, ctx)
+            check(dtype, shapes, 1e9, ctx)
+
+        x = mx.nd.array([1.0, float('nan'), 2.0], ctx=ctx)
+        y = mx.nd.ones((4,), ctx=ctx)
+        norm = mx.nd.empty((1,), ctx=ctx)
+        finite = mx.nd.empty((1,), ctx=ctx)
+        mx.nd.multi_clip_global_norm(x, y, num_arrays=2, max_norm=1.0, out=[x, y, norm, finite])
+        assert finite.asscalar() == 0
+        assert_almost_equal(y.asnumpy(), np.ones((4,)))
+
 def check_fast_lars(w_dtype, g_dtype, shapes, ctx, tol1, tol2):
     weights_arr = [np.random.rand(*shape).astype(w_dtype) * 10. for shape in shapes]
     grads_arr = [np.random.rand(*shape).astype(g_dtype) for shape in shapes]
@@ -527,6 +560,33 @@ def test_convolution_with_type():
     check_consistency(sym, ctx_list, grad_req={'conv_data': 'write', 'conv_weight': 'write', 'conv_bias': 'null'}, rtol=tol, atol=tol)
 
 
+@with_seed()
+@assert_raises_cudnn_not_satisfied(min_version='7.2.1')
+@pytest.mark.serial
+def test_convert_layout():
+    data = mx.sym.Variable('data')
+    body = mx.sym.Convolution(data, num_filter=8, kernel=(3,3), pad=(1,1), name='conv0')
+    body = mx.sym.BatchNorm(body, name='bn0')
+    body = mx.sym.Activation(body, act_type='relu')
+    res = mx.sym.Convolution(body, num_filter=8, kernel=(3,3), pad=(1,1), name='conv1')
+    body = mx.sym.Pooling(body + res, kernel=(2,2), stride=(2,2), pool_type='max')
+    body = mx.sym.Concat(body, body * 2, dim=1)
+    body = mx.sym.Pooling(body, global_pool=True, kernel=(1,1), pool_type='avg')
+    sym = mx.sym.FullyConnected(mx.sym.Flatten(body), num_hidden=4, name='fc')
+
+    converted = sym.optimize_for('ConvertLayout', layout='NHWC')
+    nodes = json.loads(converted.tojson())['nodes']
+    # data, both conv weights and the Flatten input
+    assert len([n for n in nodes if n['op'] == 'transpose']) == 4
+    assert all(n['attrs']['layout'] == 'NHWC' for n in nodes
+               if n['op'] in ('Convolution', 'Pooling'))
+
+    ctx_list = [{'ctx': mx.gpu(0), 'data': (2, 4, 16, 16), 'type_dict': {'data': np.float32}},
+                {'ctx': mx.gpu(0), 'data': (2, 4, 16, 16), 'type_dict': {'data': np.float16}}]
+    tol = {np.dtype(np.float16): 1e-1, np.dtype(np.float32): 1e-3}
+    check_consistency([sym, sym, converted, converted], ctx_list * 2, rtol=tol, atol=tol)
+
+
 # Apply N symbols against each of M contexts, checking that all NxM combinations match.
 def check_consistency_NxM(sym_list, ctx_list):
     # e.g. if sym_list=[sym1, sym2] and ctx_list=[ctx1, ctx2, ctx3], then resulting lists are:
@@ -603,6 +663,33 @@ def test_convolution_options():
     check_consistency_NxM([sym, sym_no_cudnn], ctx_list)
 
 
+def test_cudnn_algo_persistent_cache():
+    # The algorithms tuned by a first process are read from MXNET_CUDNN_ALGO_CACHE by a second one
+    import subprocess
+    import tempfile
+    script = """
+import mxnet as mx
+for sym in [mx.sym.Convolution(num_filter=4, kernel=(3, 3), pad=(1, 1), name='conv'),
+            mx.sym.Deconvolution(num_filter=4, kernel=(3, 3), pad=(1, 1), name='deconv')]:
+    exe = sym._simple_bind(ctx=mx.gpu(0), data=(2, 3, 8, 8))
+    exe.forward(is_train=True)
+    exe.backward(exe.outputs[0])
+    mx.nd.waitall()
+"""
+    with tempfile.TemporaryDirectory() as cache_dir:
+        cache_file = os.path.join(cache_dir, 'cudnn_algos.txt')
+        env = dict(os.environ, MXNET_CUDNN_AUTOTUNE_DEFAULT='1', MXNET_CUDNN_ALGO_CACHE=cache_file)
+        subprocess.check_call([sys.executable, '-c', script], env=env)
+        with open(cache_file) as f:
+            cached = f.read()
+        lines = cached.splitlines()
+        assert len(lines) == 2
+        assert lines[0].startswith('Convolution;') and lines[1].startswith('Deconvolution;')
+        subprocess.check_call([sys.executable, '-c', script], env=env)
+        with open(cache_file) as f:
+            assert f.read() == cached
+
+
 @with_seed()
 @pytest.mark.serial
 def test_conv_deconv_guards():
@@ -664,6 +751,36 @@ def test_convolution_multiple_streams():
             print('Finished engine {} with {} streams.'.format(engine, num_streams), file=sys.stderr)
 
 
+def _independent_ops_with_event_sync(seed):
+    with random_seed(seed):
+        # many small independent chains, mixed with host reads and frees of temporaries
+        xs = [mx.nd.random.uniform(shape=(64, 64), ctx=mx.gpu(0)) for _ in range(16)]
+        ys = [mx.nd.dot(x, x) + i for i, x in enumerate(xs)]
+        zs = [mx.nd.relu(y - y.mean()) for y in ys]
+        total = mx.nd.add_n(*zs)
+        for i, (x, z) in enumerate(zip(xs, zs)):
+            x_np = x.asnumpy()
+            y_np = np.dot(x_np, x_np) + i
+            assert_almost_equal(z, np.maximum(y_np - y_np.mean(), 0), rtol=1e-4, atol=1e-4)
+        assert_almost_equal(total, sum(z.asnumpy() for z in zs), rtol=1e-4, atol=1e-4)
+        # in-place updates read by the following ops
+        w = mx.nd.ones((256,), ctx=mx.gpu(0))
+        for _ in range(50):
+            w += w * 0.01
+        mx.nd.waitall()
+        assert_almost_equal(w, np.full((256,), 1.01 ** 50), rtol=1e-4, atol=1e-4)
+
+
+@with_seed()
+@pytest.mark.serial
+def test_engine_gpu_event_sync():
+    for num_streams in ['1', '4']:
+        for engine in ['ThreadedEngine', 'ThreadedEnginePerDevice']:
+            run_in_spawned_process(_independent_ops_with_event_sync,
+                {'MXNET_ENGINE_GPU_EVENT_SYNC' : '1', 'MXNET_ENGINE_GPU_WORKER_STREAMS' : num_streams,
+                 'MXNET_ENGINE_TYPE' : engine})
+
+
 # This test is designed to expose an issue with cudnn v7.1.4 algo find() when invoked with large c.
 # Algos returned by find() can fail to run with grad_req='add' (wgrad kernel beta parameter == 1.0f).
 @with_seed()
@@ -1485,6 +1602,35 @@ def test_embedding_with_type():
     test_embedding_helper(data_types, weight_types, 0, 5)
 
 
+@with_seed()
+def test_sparse_embedding_large_vocabulary():
+    # more rows than data, the row_sparse gradient is aggregated by hashing the data
+    in_dim, out_dim, batch = 1000000, 8, 5000
+    np_data = np.random.zipf(1.5, size=batch) % in_dim
+    np_ograd = np.random.uniform(-1, 1, size=(batch, out_dim)).astype(np.float32)
+    expected = np.zeros((in_dim, out_dim), dtype=np.float32)
+    np.add.at(expected, np_data, np_ograd)
+    data = mx.nd.array(np_data, ctx=mx.gpu(0))
+    weight = mx.nd.zeros((in_dim, out_dim), ctx=mx.gpu(0))
+    weight.attach_grad(stype='row_sparse')
+    ograd = mx.nd.array(np_ograd, ctx=mx.gpu(0))
+    for deterministic in ['1', '0']:
+        with environment('MXNET_EMBEDDING_DETERMINISTIC_SPARSE_GRAD', deterministic):
+            grads = []
+            for _ in range(2):
+                with autograd.record():
+                    out = mx.nd.Embedding(data, weight, input_dim=in_dim, output_dim=out_dim,
+                                          sparse_grad=True)
+                out.backward(ograd)
+                assert weight.grad.stype == 'row_sparse'
+                assert_almost_equal(weight.grad.indices, np.unique(np_data))
+                assert_almost_equal(weight.grad.data, expected[np.unique(np_data)],
+                                    rtol=1e-5, atol=1e-5)
+                grads.append(weight.grad.data.asnumpy())
+            if deterministic == '1':
+                assert (grads[0] == grads[1]).all()
+
+
 @with_seed()
 def test_take_with_type():
     sym = mx.sym.take(name='take')
@@ -2319,3 +2465,92 @@ def test_fp16_spmm():
     out = mxsps.dot(inp, weight)
     out_np = mx.nd.dot(inp, weight)
     assert_almost_equal(out.asnumpy(), out_np, rtol=1e-3, atol=1e-5)
+
+@with_seed()
+def test_copy_to_gpu_staged():
+    # sizes around the staging threshold and the 4MB staging buffers
+    for size in [1000, 16 * 1024 + 1, 1024 * 1024, 1024 * 1024 + 7, 3 * 1024 * 1024 + 5]:
+        data = np.random.uniform(size=(size,)).astype(np.float32)
+        for ctx in [mx.cpu(), mx.cpu_pinned(0)]:
+            src = mx.nd.array(data, ctx=ctx)
+            assert_almost_equal(src.copyto(mx.gpu(0)).asnumpy(), data)
+        assert_almost_equal(mx.nd.array(data, ctx=mx.gpu(0)).asnumpy(), data)
+
+def _fill_gpu_shared_mem(seed, ipc_handle, shared_offset, dev_id, shape, dtype):
+    from mxnet.ndarray.ndarray import _new_from_gpu_shared_mem
+    arr = mx.nd.NDArray(_new_from_gpu_shared_mem(ipc_handle, shared_offset, dev_id, shape,
+                                                 dtype))
+    arr[:] = 2
+    mx.nd.waitall()
+
+def test_gpu_shared_mem():
+    from mxnet.ndarray.ndarray import _new_from_gpu_shared_mem
+    src = mx.nd.arange(24, ctx=mx.gpu(0)).reshape((4, 6))
+    # an array imported by the process exporting it
+    part = src[1:3]
+    shared = mx.nd.NDArray(_new_from_gpu_shared_mem(*part._to_gpu_shared_mem()))
+    assert shared.shape == part.shape and shared.context == mx.gpu(0)
+    assert_almost_equal(shared.asnumpy(), part.asnumpy())
+    shared[:] = -1
+    expected = np.arange(24).reshape((4, 6))
+    expected[1:3] = -1
+    assert_almost_equal(src.asnumpy(), expected)
+    # an array written by another process
+    if run_in_spawned_process(_fill_gpu_shared_mem, {}, *src[3:]._to_gpu_shared_mem()):
+        expected[3:] = 2
+        assert_almost_equal(src.asnumpy(), expected)
+
+@with_seed()
+@pytest.mark.parametrize('dtype', ['float32', 'float16'])
+@pytest.mark.parametrize('act_type', ['relu', 'gelu'])
+def test_fully_connected_act(dtype, act_type):
+    data = mx.nd.random.uniform(-1, 1, shape=(6, 32), dtype=dtype, ctx=mx.gpu(0))
+    weight = mx.nd.random.uniform(-1, 1, shape=(16, 32), dtype=dtype, ctx=mx.gpu(0))
+    bias = mx.nd.random.uniform(-1, 1, shape=(16,), dtype=dtype, ctx=mx.gpu(0))
+    out_grad = mx.nd.random.uniform(-1, 1, shape=(6, 16), dtype=dtype, ctx=mx.gpu(0))
+    rtol, atol = (1e-2, 1e-2) if dtype == 'float16' else (1e-4, 1e-5)
+    results = []
+    for fused in [False, True]:
+        args = [x.copy() for x in [data, weight, bias]]
+        for x in args:
+            x.attach_grad()
+        with autograd.record():
+            if fused:
+                out = mx.nd.contrib.FullyConnectedAct(*args, num_hidden=16, act_type=act_type)
+            else:
+                out = mx.nd.FullyConnected(*args, num_hidden=16)
+                out = mx.nd.relu(out) if act_type == 'relu' else \
+                    mx.nd.LeakyReLU(out, act_type='gelu')
+        out.backward(out_grad)
+        results.append([out] + [x.grad for x in args])
+    for ref, res in zip(*results):
+        assert_almost_equal(res, ref, rtol=rtol, atol=atol)
+
+@with_seed()
+@pytest.mark.parametrize('dtype', ['float16', 'float32', 'float64'])
+@pytest.mark.parametrize('blank_label', ['first', 'last'])
+def test_ctc_loss_dtypes(dtype, blank_label):
+    seq_len, batch_size, alphabet_size = 40, 6, 12
+    # label lengths spread over more than one thread block size of the recursion
+    label_lengths = np.array([1, 3, 17, 0, 9, 15], dtype=np.int32)
+    data_lengths = np.array([40, 35, 40, 12, 30, 38], dtype=np.int32)
+    low = 1 if blank_label == 'first' else 0
+    high = alphabet_size if blank_label == 'first' else alphabet_size - 1
+    label = np.random.randint(low, high, size=(batch_size, label_lengths.max()))
+    data = np.random.uniform(-2, 2, size=(seq_len, batch_size, alphabet_size))
+    out_grad = np.random.uniform(0.5, 1.5, size=(batch_size,))
+    rtol, atol = (5e-2, 5e-2) if dtype == 'float16' else (1e-4, 1e-4)
+    results = []
+    for ctx, data_type in [(mx.cpu(0), 'float32'), (mx.gpu(0), dtype)]:
+        x = mx.nd.array(data, ctx=ctx, dtype=data_type)
+        x.attach_grad()
+        with autograd.record():
+            loss = mx.nd.ctc_loss(x, mx.nd.array(label, ctx=ctx),
+                                  mx.nd.array(data_lengths, ctx=ctx),
+                                  mx.nd.array(label_lengths, ctx=ctx),
+                                  use_data_lengths=True, use_label_lengths=True,
+                                  blank_label=blank_label)
+        loss.backward(mx.nd.array(out_grad, ctx=ctx, dtype=data_type))
+        results.append([loss.astype('float32'), x.grad.astype('float32')])
+    for ref, res in zip(*results):
+        assert_almost_equal(res, ref, rtol=rtol, atol=atol)
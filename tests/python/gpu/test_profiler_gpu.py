@@ -65,14 +65,14 @@ def test_gpu_memory_profiler_symbolic():
              'Requested Size' : str(4 * c.size)}]
 
     # Sample gpu_memory_profile.csv:
-    # "Attribute Name","Requested Size","Device","Actual Size","Reuse?"
-    # "<unk>:_zeros","67108864","0","67108864","0"
-    # "<unk>:_zeros","67108864","0","67108864","0"
-    # "tensordot:dot","67108864","0","67108864","1"
-    # "tensordot:dot","67108864","0","67108864","1"
-    # "tensordot:in_arg:A","67108864","0","67108864","0"
-    # "tensordot:in_arg:B","67108864","0","67108864","0"
-    # "nvml_amend","1074790400","0","1074790400","0"
+    # "Attribute Name","Requested Size","Device","Actual Size","Reuse?","Request"
+    # "<unk>:_zeros","67108864","0","67108864","0",""
+    # "<unk>:_zeros","67108864","0","67108864","0",""
+    # "tensordot:dot","67108864","0","67108864","1",""
+    # "tensordot:dot","67108864","0","67108864","1",""
+    # "tensordot:in_arg:A","67108864","0","67108864","0",""
+    # "tensordot:in_arg:B","67108864","0","67108864","0",""
+    # "nvml_amend","1074790400","0","1074790400","0",""
 
     with open('gpu_memory_profile-pid_%d.csv' % (os.getpid()), mode='r') as csv_file:
         csv_reader = csv.DictReader(csv_file)
@@ -145,3 +145,27 @@ def test_gpu_memory_profiler_gluon():
             if row['Attribute Name'] == "<unk>:unknown" or \
                row['Attribute Name'] == "<unk>:":
                 assert False, "Unknown allocation entry has been encountered"
+
+
+@pytest.mark.skipif(not mx.runtime.Features().is_enabled('CUPTI'),
+                    reason='built without CUPTI')
+def test_cupti_kernel_timing():
+    os.environ['MXNET_PROFILER_CUPTI'] = '1'
+    try:
+        enable_profiler('test_cupti_kernel_timing.json', run=True, aggregate_stats=True)
+        a = mx.nd.ones((1024, 1024), ctx=mx.gpu(0))
+        for _ in range(5):
+            b = mx.nd.dot(a, a)
+        mx.nd.waitall()
+        profiler.set_state('stop')
+        profiler.dump(True)
+        target_dict = json.loads(profiler.dumps(format='json'))
+        kernels = target_dict['Time']['gpu kernel']
+        assert kernels['dot']['Count'] >= 5
+        assert kernels['dot']['Total'] > 0
+        with open('test_cupti_kernel_timing.json') as f:
+            events = json.load(f)['traceEvents']
+        kernel_events = [e for e in events if e.get('cat') == 'gpu kernel' and e['ph'] == 'b']
+        assert all(0 < e['args']['occupancy'] <= 1 for e in kernel_events)
+    finally:
+        del os.environ['MXNET_PROFILER_CUPTI']
@@ -0,0 +1,181 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+import sys
+import os
+import mxnet as mx
+import numpy as np
+import pytest
+from mxnet.test_utils import assert_almost_equal, assert_allclose
+
+curr_path = os.path.dirname(os.path.abspath(os.path.expanduser(__file__)))
+sys.path.insert(0, os.path.join(curr_path, '../unittest'))
+from common import setup_module, teardown_module, with_seed
+
+ctx = mx.gpu(0)
+
+
+def quantize(x, min_range=None, max_range=None):
+    if min_range is None:
+        r = float(mx.nd.abs(x).max().asscalar())
+        min_range = mx.nd.array([-r], ctx=ctx)
+        max_range = mx.nd.array([r], ctx=ctx)
+    return mx.nd.contrib.quantize(x, min_range, max_range, out_type='int8')
+
+
+def dequantize(q, min_range, max_range):
+    return mx.nd.contrib.dequantize(q, min_range, max_range, out_type='float32')
+
+
+def check_quantized(outputs, ref):
+    # the reference is quantized into the output range of the op
+    out, min_out, max_out = outputs
+    q_ref = quantize(ref, min_out, max_out)[0]
+    assert out.dtype == np.int8
+    assert_allclose(out.asnumpy().astype(np.int32), q_ref.asnumpy().astype(np.int32), atol=1)
+
+
+@with_seed()
+@pytest.mark.parametrize('calibrated', [False, True])
+def test_quantized_elemwise_add(calibrated):
+    a = quantize(mx.nd.random.uniform(-1, 1, shape=(4, 33), ctx=ctx))
+    b = quantize(mx.nd.random.uniform(-3, 3, shape=(4, 33), ctx=ctx))
+    ref = dequantize(*a) + dequantize(*b)
+    kwargs = {}
+    if calibrated:
+        r = float(mx.nd.abs(ref).max().asscalar())
+        kwargs = {'min_calib_range': -r, 'max_calib_range': r}
+    outputs = mx.nd.contrib.quantized_elemwise_add(a[0], b[0], a[1], a[2], b[1], b[2], **kwargs)
+    if calibrated:
+        check_quantized(outputs, ref)
+    else:
+        assert outputs[0].dtype == np.int32
+        assert_almost_equal(dequantize(*outputs), ref, rtol=1e-5, atol=1e-5)
+
+
+@with_seed()
+def test_quantized_act():
+    data = quantize(mx.nd.random.uniform(-1, 1, shape=(4, 33), ctx=ctx))
+    outputs = mx.nd.contrib.quantized_act(*data, act_type='relu')
+    assert_almost_equal(outputs[1], data[1])
+    assert_almost_equal(outputs[2], data[2])
+    check_quantized(outputs, mx.nd.relu(dequantize(*data)))
+
+
+@with_seed()
+@pytest.mark.parametrize('dim', [0, 1, 2])
+def test_quantized_concat(dim):
+    shapes = [(2, 3, 4), (2, 3, 4), (2, 3, 4)]
+    inputs = [quantize(mx.nd.random.uniform(-s, s, shape=shape, ctx=ctx))
+              for s, shape in zip([1, 2, 0.5], shapes)]
+    ranges = [r for q in inputs for r in q[1:]]
+    outputs = mx.nd.contrib.quantized_concat(*([q[0] for q in inputs] + ranges),
+                                              num_args=len(inputs), dim=dim)
+    # the output range covers the input ranges
+    assert_almost_equal(outputs[1], mx.nd.concat(*[q[1] for q in inputs], dim=0).min())
+    assert_almost_equal(outputs[2], mx.nd.concat(*[q[2] for q in inputs], dim=0).max())
+    check_quantized(outputs, mx.nd.concat(*[dequantize(*q) for q in inputs], dim=dim))
+
+
+@with_seed()
+@pytest.mark.parametrize('fix_gamma', [False, True])
+def test_quantized_batch_norm(fix_gamma):
+    data = quantize(mx.nd.random.uniform(-1, 1, shape=(2, 3, 5, 5), ctx=ctx))
+    gamma = mx.nd.random.uniform(0.5, 1.5, shape=(3,), ctx=ctx)
+    beta = mx.nd.random.uniform(-1, 1, shape=(3,), ctx=ctx)
+    mean = mx.nd.random.uniform(-0.5, 0.5, shape=(3,), ctx=ctx)
+    var = mx.nd.random.uniform(0.5, 1.5, shape=(3,), ctx=ctx)
+    ref = mx.nd.BatchNorm(dequantize(*data), gamma, beta, mean, var, eps=1e-3,
+                          fix_gamma=fix_gamma, use_global_stats=True)
+    r = float(mx.nd.abs(ref).max().asscalar())
+    outputs = mx.nd.contrib.quantized_batch_norm(data[0], gamma, beta, mean, var, data[1],
+                                                 data[2], eps=1e-3, fix_gamma=fix_gamma,
+                                                 min_calib_range=-r, max_calib_range=r)
+    check_quantized(outputs, ref)
+
+
+@with_seed()
+def test_quantized_embedding():
+    weight = quantize(mx.nd.random.uniform(-1, 1, shape=(10, 7), ctx=ctx))
+    data = mx.nd.array(np.random.randint(0, 10, size=(3, 4)), ctx=ctx)
+    outputs = mx.nd.contrib.quantized_embedding(data, *weight, input_dim=10, output_dim=7)
+    assert_almost_equal(outputs[1], weight[1])
+    assert_almost_equal(outputs[2], weight[2])
+    ref = mx.nd.Embedding(data, dequantize(*weight), input_dim=10, output_dim=7)
+    check_quantized(outputs, ref)
+
+
+@with_seed()
+def test_fuse_requantize():
+    names = ['lhs', 'rhs', 'lhs_min', 'lhs_max', 'rhs_min', 'rhs_max']
+    add = mx.sym.contrib.quantized_elemwise_add(*[mx.sym.var(name) for name in names])
+    sym = mx.sym.contrib.requantize(add[0], add[1], add[2],
+                                    min_calib_range=-2.5, max_calib_range=2.5)
+    a = quantize(mx.nd.random.uniform(-1, 1, shape=(4, 33), ctx=ctx))
+    b = quantize(mx.nd.random.uniform(-2, 2, shape=(4, 33), ctx=ctx))
+    args = dict(zip(names, [a[0], b[0], a[1], a[2], b[1], b[2]]))
+
+    fused = sym.optimize_for('FuseRequantize', args, {})
+    assert '_contrib_requantize' not in fused.tojson()
+    assert '_contrib_quantized_elemwise_add' in fused.tojson()
+    assert sorted(fused.list_arguments()) == sorted(sym.list_arguments())
+
+    results = []
+    for s in [sym, fused]:
+        exe = s._bind(ctx, args={k: v.copy() for k, v in args.items()})
+        results.append([out.asnumpy() for out in exe.forward()])
+    for ref, out in zip(*results):
+        assert ref.dtype == out.dtype
+        assert_allclose(out.astype(np.float32), ref.astype(np.float32), atol=1)
+
+
+def quantize_channel_wise(w):
+    # one range per output channel, the first axis of the weights
+    q, min_range, max_range = mx.nd.contrib.quantize_v2(w, out_type='int8',
+                                                        channel_wise_quantize=True)
+    scale = (max_range / 127).reshape((-1,) + (1,) * (w.ndim - 1))
+    return q, min_range, max_range, q.astype('float32') * scale
+
+
+@with_seed()
+@pytest.mark.parametrize('op', ['fully_connected', 'conv'])
+def test_quantized_channel_wise_weights(op):
+    if op == 'fully_connected':
+        data = mx.nd.random.uniform(-1, 1, shape=(4, 16), ctx=ctx)
+        weight = mx.nd.random.uniform(-1, 1, shape=(8, 16), ctx=ctx)
+        kwargs = {'num_hidden': 8, 'no_bias': True}
+        float_op, quantized_op = mx.nd.FullyConnected, mx.nd.contrib.quantized_fully_connected
+    else:
+        data = mx.nd.random.uniform(-1, 1, shape=(2, 4, 6, 6), ctx=ctx)
+        weight = mx.nd.random.uniform(-1, 1, shape=(8, 4, 3, 3), ctx=ctx)
+        kwargs = {'kernel': (3, 3), 'num_filter': 8, 'no_bias': True}
+        float_op, quantized_op = mx.nd.Convolution, mx.nd.contrib.quantized_conv
+    # channels of very different ranges, which a single range would quantize poorly
+    scales = mx.nd.array([0.01, 0.1, 1, 10, 0.5, 2, 5, 0.05], ctx=ctx)
+    weight = weight * scales.reshape((8,) + (1,) * (weight.ndim - 1))
+    q_data, min_data, max_data = quantize(data)
+    q_weight, min_weight, max_weight, weight_deq = quantize_channel_wise(weight)
+    assert min_weight.shape == (8,)
+
+    outputs = quantized_op(q_data, q_weight, min_data, max_data, min_weight, max_weight,
+                           **kwargs)
+    assert outputs[0].dtype == np.int32
+    out = dequantize(*outputs).asnumpy()
+    ref = float_op(dequantize(q_data, min_data, max_data), weight_deq, **kwargs).asnumpy()
+    # the channels are rescaled to the level of the largest weight range, and rounded to it
+    level = max_data.asscalar() / 127 * max_weight.max().asscalar() / 127
+    assert_allclose(out, ref, rtol=1e-5, atol=level)
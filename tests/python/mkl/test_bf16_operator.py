@@ -160,6 +160,36 @@ def test_bf16_fc():
     fc_bf16 = mx.sym.FullyConnected(data_sym_bf16, **fc_params)
     check_operator_accuracy(fc_fp32, fc_bf16, data_shape=(3, 3, 16, 16), bf16_use_fp32_params=False)
 
+@with_seed()
+@pytest.mark.parametrize('transpose_a', [False, True])
+@pytest.mark.parametrize('transpose_b', [False, True])
+def test_bf16_batch_dot(transpose_a, transpose_b):
+    lhs_shape = (4, 3, 16, 8)
+    rhs_shape = (4, 3, 8, 12)
+    if transpose_a:
+        lhs_shape = lhs_shape[:2] + (lhs_shape[3], lhs_shape[2])
+    if transpose_b:
+        rhs_shape = rhs_shape[:2] + (rhs_shape[3], rhs_shape[2])
+    lhs = mx.nd.random.uniform(low=0.0, high=1.0, shape=lhs_shape)
+    rhs = mx.nd.random.uniform(low=0.0, high=1.0, shape=rhs_shape)
+    out_fp32 = mx.nd.batch_dot(lhs, rhs, transpose_a=transpose_a, transpose_b=transpose_b)
+    out_bf16 = mx.nd.batch_dot(mx.nd.amp_cast(lhs, dtype=bfloat16), mx.nd.amp_cast(rhs, dtype=bfloat16),
+                               transpose_a=transpose_a, transpose_b=transpose_b)
+    assert out_bf16.dtype == bfloat16
+    assert_almost_equal_with_err(mx.nd.amp_cast(out_bf16, dtype="float32"), out_fp32,
+                                 rtol=1e-1, atol=1e-1, etol=0)
+
+    # batch_dot is cast to bfloat16 by AMP
+    lhs_sym = mx.sym.var('lhs')
+    rhs_sym = mx.sym.var('rhs')
+    sym = mx.sym.batch_dot(lhs_sym, rhs_sym, transpose_a=transpose_a, transpose_b=transpose_b)
+    sym_bf16 = amp.convert_symbol(sym, target_dtype="bfloat16")
+    exe = sym_bf16._bind(mx.cpu(), args={'lhs': lhs, 'rhs': rhs})
+    out = exe.forward()[0]
+    assert out.dtype == bfloat16
+    assert_almost_equal_with_err(mx.nd.amp_cast(out, dtype="float32"), out_fp32,
+                                 rtol=1e-1, atol=1e-1, etol=0)
+
 @with_seed()
 def test_bf16_pooling():
     pool_params = {"kernel": (3, 3), "stride": (1, 1), "pad": (0, 0), "name": "pool"}
@@ -358,6 +358,55 @@ def test_softmax():
         check_softmax_training(stype)
 
 
+@with_seed()
+def test_layer_norm():
+    def np_layer_norm(data, gamma, beta, axis, eps):
+        mean = data.mean(axis=axis, keepdims=True)
+        std = np.sqrt(data.var(axis=axis, keepdims=True) + eps)
+        shape = [1] * data.ndim
+        shape[axis] = data.shape[axis]
+        return (data - mean) / std * gamma.reshape(shape) + beta.reshape(shape), mean, std
+
+    # the last axis runs through MKL-DNN, the other falls back
+    for shape, axis in [((4, 32), -1), ((2, 5, 768), -1), ((2, 3, 4, 8), -1), ((2, 5, 6), 1)]:
+        data = np.random.normal(0, 1, size=shape).astype('float32')
+        gamma = np.random.normal(0, 1, size=(shape[axis],)).astype('float32')
+        beta = np.random.normal(0, 1, size=(shape[axis],)).astype('float32')
+        out, mean, std = mx.nd.LayerNorm(mx.nd.array(data), mx.nd.array(gamma),
+                                         mx.nd.array(beta), axis=axis, eps=1e-5,
+                                         output_mean_var=True)
+        np_out, np_mean, np_std = np_layer_norm(data, gamma, beta, axis, 1e-5)
+        assert_almost_equal(out, np_out, rtol=1e-4, atol=1e-4)
+        assert_almost_equal(mean, np_mean, rtol=1e-4, atol=1e-4)
+        assert_almost_equal(std, np_std, rtol=1e-4, atol=1e-4)
+
+
+@with_seed()
+def test_group_norm():
+    def np_group_norm(data, gamma, beta, num_groups, eps):
+        new_shape = (data.shape[0], num_groups, -1)
+        grouped = data.reshape(new_shape)
+        mean = grouped.mean(axis=-1, keepdims=True)
+        std = np.sqrt(grouped.var(axis=-1, keepdims=True) + eps)
+        out = ((grouped - mean) / std).reshape(data.shape)
+        param_shape = [1] * data.ndim
+        param_shape[1] = data.shape[1]
+        out = out * gamma.reshape(param_shape) + beta.reshape(param_shape)
+        return out, mean.reshape(data.shape[0], num_groups), std.reshape(data.shape[0], num_groups)
+
+    for shape, num_groups in [((2, 4, 5), 2), ((3, 8, 6, 6), 4), ((2, 6, 3, 4, 5), 3)]:
+        data = np.random.normal(0, 1, size=shape).astype('float32')
+        gamma = np.random.normal(0, 1, size=(shape[1],)).astype('float32')
+        beta = np.random.normal(0, 1, size=(shape[1],)).astype('float32')
+        out, mean, std = mx.nd.GroupNorm(mx.nd.array(data), mx.nd.array(gamma),
+                                         mx.nd.array(beta), num_groups=num_groups, eps=1e-5,
+                                         output_mean_var=True)
+        np_out, np_mean, np_std = np_group_norm(data, gamma, beta, num_groups, 1e-5)
+        assert_almost_equal(out, np_out, rtol=1e-4, atol=1e-4)
+        assert_almost_equal(mean, np_mean, rtol=1e-4, atol=1e-4)
+        assert_almost_equal(std, np_std, rtol=1e-4, atol=1e-4)
+
+
 @with_seed()
 def test_pooling():
     def check_pooling_training(stype):
@@ -669,3 +718,43 @@ def test_elemwise_add():
     for stype in stypes:
         check_elemwise_add_training(stype)
 
+
+
+def test_primitive_cache_eviction():
+    # Variable input shapes overflow the primitive caches limited to a few entries, whose
+    # evicted primitives are then created again
+    import subprocess
+    script = """
+import numpy as np
+import mxnet as mx
+net = mx.gluon.nn.HybridSequential()
+net.add(mx.gluon.nn.Conv2D(channels=4, kernel_size=3, activation='relu'))
+net.add(mx.gluon.nn.MaxPool2D())
+net.initialize(ctx=mx.cpu())
+outs = {}
+for it in range(2):
+    for size in range(8, 20):
+        x = mx.nd.ones((1, 3, size, size))
+        out = net(x).asnumpy()
+        if it == 0:
+            outs[size] = out
+        else:
+            assert np.array_equal(outs[size], out)
+"""
+    for env in [{'MXNET_MKLDNN_CACHE_NUM': '3'}, {'MXNET_MKLDNN_CACHE_TOTAL': '5'}]:
+        subprocess.check_call([sys.executable, '-c', script], env=dict(os.environ, **env))
+
+
+def test_prepack_weights():
+    net = mx.gluon.nn.HybridSequential()
+    net.add(mx.gluon.nn.Conv2D(channels=8, kernel_size=3, activation='relu'))
+    net.add(mx.gluon.nn.Dense(4))
+    net.initialize(ctx=mx.cpu())
+    x = mx.nd.random.uniform(shape=(2, 3, 10, 10))
+    expected = net(x).asnumpy()
+    weight = net[0].weight.data().asnumpy()
+    net.hybridize(static_alloc=True, prepack_weights=True)
+    for _ in range(3):
+        assert_almost_equal(net(x), expected, rtol=1e-4, atol=1e-5)
+    # the packed weights still read back in the default layout
+    assert_almost_equal(net[0].weight.data(), weight)
@@ -38,3 +38,66 @@ def test_float64_fallback():
     ex = sym._bind(mx.cpu(), args, args_grad=None, grad_req='write')
     ex.forward()
     ex.outputs[0].wait_to_read()
+
+@pytest.mark.parametrize('act_type', ['leaky', 'elu', 'gelu'])
+def test_fc_leakyrelu_fusion(act_type):
+    import json
+    data = mx.sym.Variable('data')
+    fc = mx.sym.FullyConnected(data, num_hidden=16, name='fc')
+    sym = mx.sym.LeakyReLU(fc, act_type=act_type, slope=0.3)
+    part_sym = sym.optimize_for('MKLDNN')
+    ops = [node['op'] for node in json.loads(part_sym.tojson())['nodes']]
+    assert '_sg_mkldnn_fully_connected' in ops
+    assert 'LeakyReLU' not in ops
+
+    args = {'data': mx.nd.random.uniform(-1, 1, shape=(4, 10)),
+            'fc_weight': mx.nd.random.uniform(-1, 1, shape=(16, 10)),
+            'fc_bias': mx.nd.random.uniform(-1, 1, shape=(16,))}
+    ref = sym._bind(mx.cpu(), args).forward()[0]
+    out = part_sym._bind(mx.cpu(), args).forward()[0]
+    mx.test_utils.assert_almost_equal(out, ref, rtol=1e-5, atol=1e-5)
+
+@pytest.mark.parametrize('with_act', [False, True])
+def test_fc_sum_fusion(with_act):
+    import json
+    data = mx.sym.Variable('data')
+    residual = mx.sym.Variable('residual')
+    fc = mx.sym.FullyConnected(data, num_hidden=16, name='fc')
+    if with_act:
+        fc = mx.sym.LeakyReLU(fc, act_type='gelu')
+    sym = mx.sym.elemwise_add(residual, fc)
+    part_sym = sym.optimize_for('MKLDNN')
+    ops = [node['op'] for node in json.loads(part_sym.tojson())['nodes']]
+    assert '_sg_mkldnn_fully_connected' in ops
+    assert 'elemwise_add' not in ops
+
+    args = {'data': mx.nd.random.uniform(-1, 1, shape=(4, 10)),
+            'residual': mx.nd.random.uniform(-1, 1, shape=(4, 16)),
+            'fc_weight': mx.nd.random.uniform(-1, 1, shape=(16, 10)),
+            'fc_bias': mx.nd.random.uniform(-1, 1, shape=(16,))}
+    ref = sym._bind(mx.cpu(), args).forward()[0]
+    out = part_sym._bind(mx.cpu(), args).forward()[0]
+    mx.test_utils.assert_almost_equal(out, ref, rtol=1e-5, atol=1e-5)
+
+@pytest.mark.parametrize('mask_shape', [None, (4, 6, 6), (1, 1, 6)])
+def test_matmul_softmax_fusion(mask_shape):
+    import json
+    query = mx.sym.Variable('query')
+    key = mx.sym.Variable('key')
+    scores = mx.sym.batch_dot(query, key, transpose_b=True)
+    scores = scores / 8.0
+    if mask_shape is not None:
+        scores = mx.sym.broadcast_add(scores, mx.sym.Variable('mask'))
+    sym = mx.sym.softmax(scores, axis=-1)
+    part_sym = sym.optimize_for('MKLDNN')
+    ops = [node['op'] for node in json.loads(part_sym.tojson())['nodes']]
+    assert '_sg_mkldnn_matmul_softmax' in ops
+    assert 'softmax' not in ops and 'batch_dot' not in ops
+
+    args = {'query': mx.nd.random.uniform(-1, 1, shape=(4, 6, 8)),
+            'key': mx.nd.random.uniform(-1, 1, shape=(4, 6, 8))}
+    if mask_shape is not None:
+        args['mask'] = mx.nd.random.uniform(-10, 0, shape=mask_shape)
+    ref = sym._bind(mx.cpu(), args).forward()[0]
+    out = part_sym._bind(mx.cpu(), args).forward()[0]
+    mx.test_utils.assert_almost_equal(out, ref, rtol=1e-5, atol=1e-5)
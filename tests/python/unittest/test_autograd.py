@@ -22,6 +22,7 @@ from mxnet.autograd import *
 from mxnet.test_utils import *
 
 from common import setup_module, with_seed, teardown_module, xfail_when_nonstandard_decimal_separator
+from common import run_in_spawned_process, random_seed
 from mxnet.test_utils import environment
 
 import pytest
@@ -537,3 +538,48 @@ def test_gradient():
     dx.backward()
     assert abs(x.grad.asscalar() - 2.71828175) < 1e-7
 
+
+
+def _check_wide_fan_out_gradient(seed, fan_out):
+    with random_seed(seed):
+        x = mx.nd.random.uniform(shape=(3, 4))
+        x.attach_grad()
+        with mx.autograd.record():
+            ys = [mx.nd.sin(x) * i for i in range(fan_out)]
+            z = mx.nd.add_n(*ys)
+        z.backward()
+        expected = np.cos(x.asnumpy()) * sum(range(fan_out))
+        assert_almost_equal(x.grad, expected, rtol=1e-4, atol=1e-4)
+
+        data = mx.sym.var('data')
+        heads = [mx.sym.exp(data) * i for i in range(fan_out)]
+        sym = mx.sym.add_n(*heads)
+        exe = sym._bind(mx.cpu(), args={'data': x}, args_grad={'data': mx.nd.zeros_like(x)})
+        exe.forward(is_train=True)
+        exe.backward(mx.nd.ones_like(x))
+        expected = np.exp(x.asnumpy()) * sum(range(fan_out))
+        assert_almost_equal(exe.grad_dict['data'], expected, rtol=1e-4, atol=1e-4)
+
+
+@pytest.mark.parametrize('arity', ['2', '4'])
+@pytest.mark.parametrize('fan_out', [3, 9, 40])
+def test_gradient_tree_sum(arity, fan_out):
+    run_in_spawned_process(_check_wide_fan_out_gradient,
+                           {'MXNET_EXEC_GRAD_SUM_TREE_ARITY': arity,
+                            'MXNET_EXEC_INPLACE_GRAD_SUM_CAP': '2'}, fan_out)
+
+
+@with_seed()
+def test_backward_graph_reuse():
+    # the iterations of a same structure reuse the backward graph of the first one, the ones
+    # of other attributes or shapes do not
+    for shape, axis in [((3, 4), 0), ((3, 4), 0), ((3, 4), 1), ((2, 5), 1), ((3, 4), 0)]:
+        x = mx.nd.random.uniform(shape=shape)
+        w = mx.nd.random.uniform(shape=shape)
+        x.attach_grad()
+        with mx.autograd.record():
+            y = mx.nd.sum(mx.nd.sin(x) * w, axis=axis)
+        dy = mx.nd.random.uniform(shape=y.shape)
+        y.backward(dy)
+        dy = np.expand_dims(dy.asnumpy(), axis)
+        assert_almost_equal(x.grad, np.cos(x.asnumpy()) * w.asnumpy() * dy, rtol=1e-4, atol=1e-5)
@@ -1978,3 +1978,38 @@ def test_foreach_with_unkown_dim():
     _, output_shape, _ = outs.infer_shape_partial()
     assert_allclose((0, 3, 32, 32), output_shape[0])
 
+
+@with_seed()
+def test_loop_static_alloc():
+    data = mx.nd.random.uniform(shape=(7, 3, 4))
+    init = mx.nd.random.uniform(shape=(3, 4))
+    weight = mx.nd.random.uniform(shape=(4, 4))
+
+    def step(x, states):
+        h = mx.sym.tanh(mx.sym.dot(states[0], mx.sym.var('w')) + x)
+        return h * 2, [h]
+
+    def loop_cond(i, h):
+        return i < 5
+
+    def loop_func(i, h):
+        h = mx.sym.sigmoid(mx.sym.dot(h, mx.sym.var('w')))
+        return h + 1, (i + 1, h)
+
+    results = []
+    for static_alloc in [False, True]:
+        outs, states = mx.sym.contrib.foreach(step, mx.sym.var('x'), [mx.sym.var('h')],
+                                              static_alloc=static_alloc)
+        sym = mx.sym.Group([outs] + states)
+        exe = sym._bind(default_context(), {'x': data, 'h': init, 'w': weight})
+        foreach_outs = [o.asnumpy() for o in exe.forward(is_train=False)]
+        outs, states = mx.sym.contrib.while_loop(
+            loop_cond, loop_func, [mx.sym.var('i'), mx.sym.var('h')], max_iterations=8,
+            static_alloc=static_alloc)
+        sym = mx.sym.Group([outs] + list(states))
+        exe = sym._bind(default_context(), {'i': mx.nd.zeros((1,)), 'h': init, 'w': weight})
+        while_outs = [o.asnumpy() for o in exe.forward(is_train=False)]
+        results.append(foreach_outs + while_outs)
+    for a, b in zip(*results):
+        assert_almost_equal(a[:5] if a.shape[0] == 8 else a, b[:5] if b.shape[0] == 8 else b,
+                            rtol=1e-5, atol=1e-6)
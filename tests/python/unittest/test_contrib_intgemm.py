@@ -217,3 +217,45 @@ def test_contrib_intgemm_multiply(data_rows, inner, weight_cols, api):
                                              out_type='float32',
                                              num_hidden=weight_cols)
     assert_almost_equal(direct, cooked, rtol=0.01, atol=0.01)
+
+@with_seed()
+@pytest.mark.parametrize('no_bias', [True, False])
+def test_contrib_intgemm_dynamic_quantize_pass(no_bias):
+    if "intgemm_fully_connected" not in dir(mx.nd.contrib):
+        return
+    data = mx.sym.var('data')
+    hidden = mx.sym.FullyConnected(data, num_hidden=64, no_bias=no_bias, name='fc1')
+    sym = mx.sym.FullyConnected(mx.sym.relu(hidden), num_hidden=8, no_bias=no_bias, name='fc2')
+    shapes = dict(zip(sym.list_arguments(), sym.infer_shape(data=(4, 128))[0]))
+    args = {name: mx.nd.random.uniform(-1, 1, shape=shape) for name, shape in shapes.items()}
+    ref = sym._bind(mx.cpu(), args=args).forward()[0]
+
+    quantized = sym.optimize_for('IntgemmDynamicQuantize', args, {}, exclude='fc2')
+    assert quantized.tojson().count('_contrib_intgemm_fully_connected') == 1
+    assert 'fc1_weight' not in quantized.list_arguments()
+    assert 'fc1_weight_intgemm' in args and 'fc1_weight_intgemm_scaling' in args
+    out = quantized._bind(mx.cpu(), args=args).forward()[0]
+    assert_almost_equal(out, ref, rtol=0.1, atol=0.1)
+
+@with_seed()
+def test_contrib_intgemm_subgraph_backend():
+    if "intgemm_fully_connected" not in dir(mx.nd.contrib):
+        return
+    data = mx.sym.var('data')
+    hidden = mx.sym.FullyConnected(data, num_hidden=64, name='fc1')
+    # 10 hidden units do not fit the intgemm tiles, so fc2 stays in float
+    sym = mx.sym.FullyConnected(mx.sym.relu(hidden), num_hidden=10, name='fc2')
+    shapes = dict(zip(sym.list_arguments(), sym.infer_shape(data=(4, 128))[0]))
+    args = {name: mx.nd.random.uniform(-1, 1, shape=shape) for name, shape in shapes.items()}
+    ref = sym._bind(mx.cpu(), args=args).forward()[0]
+
+    partitioned = sym.optimize_for('INTGEMM', args, {})
+    assert partitioned.tojson().count('"_sg_intgemm_fully_connected"') == 1
+    assert sorted(partitioned.list_arguments()) == sorted(sym.list_arguments())
+    exe = partitioned._bind(mx.cpu(), args=args)
+    out = exe.forward()[0]
+    assert_almost_equal(out, ref, rtol=0.1, atol=0.1)
+    # the weight is quantized again once it changes
+    args['fc1_weight'][:] = -args['fc1_weight']
+    ref = sym._bind(mx.cpu(), args=args).forward()[0]
+    assert_almost_equal(exe.forward()[0], ref, rtol=0.1, atol=0.1)
@@ -26,6 +26,7 @@ from mxnet.test_utils import *
 from common import with_seed, assert_raises_cudnn_not_satisfied, \
     xfail_when_nonstandard_decimal_separator
 import unittest
+import pytest
 
 def test_box_nms_op():
     def test_box_nms_forward(data, expected, thresh=0.5, valid=0, topk=-1, coord=2, score=1, cid=0, bid=-1,
@@ -201,6 +202,42 @@ def test_box_nms_op():
     test_box_nms_forward(np.array(boxes9), np.array(expected9), force=force, thresh=thresh, bid=background_id)
     test_box_nms_backward(np.array(boxes9), grad9, expected_in_grad9, force=force, thresh=thresh, bid=background_id)
 
+@with_seed()
+def test_box_nms_many_boxes():
+    def iou(a, b):
+        w = max(0, min(a[2], b[2]) - max(a[0], b[0]))
+        h = max(0, min(a[3], b[3]) - max(a[1], b[1]))
+        inter = w * h
+        return inter / ((a[2] - a[0]) * (a[3] - a[1]) + (b[2] - b[0]) * (b[3] - b[1]) - inter)
+
+    def reference_nms(boxes, thresh, topk, force):
+        order = np.argsort(-boxes[:, 1])[:topk]
+        kept = []
+        for i in order:
+            if all(iou(boxes[i, 2:], boxes[j, 2:]) <= thresh
+                   for j in kept if force or boxes[j, 0] == boxes[i, 0]):
+                kept.append(i)
+        out = np.full(boxes.shape, -1, dtype=boxes.dtype)
+        out[:len(kept)] = boxes[kept]
+        return out
+
+    num_batch, num_elem, thresh = 2, 700, 0.3
+    corners = np.random.uniform(0, 1, size=(num_batch, num_elem, 2))
+    sizes = np.random.uniform(0.02, 0.2, size=(num_batch, num_elem, 2))
+    ids = np.random.randint(0, 3, size=(num_batch, num_elem, 1))
+    scores = np.random.permutation(num_batch * num_elem).reshape(num_batch, num_elem, 1)
+    scores = (scores + 1.0) / (num_batch * num_elem)
+    data = np.concatenate([ids, scores, corners, corners + sizes], axis=2).astype('float32')
+    for force in [True, False]:
+        for topk in [-1, 600]:
+            out = mx.contrib.nd.box_nms(mx.nd.array(data), overlap_thresh=thresh, topk=topk,
+                                        coord_start=2, score_index=1, id_index=0,
+                                        force_suppress=force)
+            k = num_elem if topk < 0 else topk
+            expected = np.stack([reference_nms(b, thresh, k, force) for b in data])
+            assert_almost_equal(out.asnumpy(), expected, rtol=1e-5, atol=1e-5)
+
+
 def test_box_iou_op():
     def numpy_box_iou(a, b, fmt='corner'):
         def area(left, top, right, bottom):
@@ -446,3 +483,149 @@ def test_modulated_deformable_convolution():
                         else:
                             rtol, atol = 0.05, 1e-3
 
+
+def _fp8_round(x, fp8_type):
+    mantissa_bits, min_exponent, max_value = (3, -6, 448.) if fp8_type == 'e4m3' \
+        else (2, -14, 57344.)
+    a = np.abs(x)
+    exponent = np.maximum(np.floor(np.log2(np.where(a > 0, a, 1))), min_exponent)
+    step = np.exp2(exponent - mantissa_bits)
+    return np.sign(x) * np.minimum(np.rint(a / step) * step, max_value)
+
+def _fp8_cast(x, amax, fp8_type):
+    scale = (448. if fp8_type == 'e4m3' else 57344.) / amax
+    return _fp8_round(x * scale, fp8_type) / scale
+
+@with_seed()
+def test_fp8_fully_connected():
+    data = mx.nd.random.uniform(-2, 2, shape=(4, 3, 5))
+    weight = mx.nd.random.uniform(-1, 1, shape=(6, 15))
+    bias = mx.nd.random.uniform(-1, 1, shape=(6,))
+    ograd = mx.nd.random.uniform(-1, 1, shape=(4, 6))
+    amax = [np.abs(a.asnumpy()).max() for a in [data, weight, ograd]]
+    # the scales of this step come from the amax of the previous one
+    history = mx.nd.zeros((3, 4))
+    history[:, 0] = mx.nd.array(amax)
+    for a in [data, weight, bias]:
+        a.attach_grad()
+    with mx.autograd.record():
+        out = mx.nd.contrib.fp8_fully_connected(data, weight, bias, history, num_hidden=6,
+                                                amax_history_len=4)
+    out.backward(ograd)
+
+    d = _fp8_cast(data.asnumpy().reshape(4, 15), amax[0], 'e4m3')
+    w = _fp8_cast(weight.asnumpy(), amax[1], 'e4m3')
+    g = _fp8_cast(ograd.asnumpy(), amax[2], 'e5m2')
+    assert_almost_equal(out, d.dot(w.T) + bias.asnumpy(), rtol=1e-5, atol=1e-5)
+    assert_almost_equal(data.grad, g.dot(w).reshape(4, 3, 5), rtol=1e-5, atol=1e-5)
+    assert_almost_equal(weight.grad, g.T.dot(d), rtol=1e-5, atol=1e-5)
+    assert_almost_equal(bias.grad, ograd.asnumpy().sum(axis=0), rtol=1e-5, atol=1e-5)
+    # the amax of the step is recorded in front of the history
+    assert_almost_equal(history[:, 0], np.array(amax), rtol=1e-6, atol=1e-6)
+    assert_almost_equal(history[:, 1], np.array(amax), rtol=1e-6, atol=1e-6)
+    assert_almost_equal(history[:, 2:], np.zeros((3, 2)))
+
+    # without history the scales are 1, and inference leaves the history untouched
+    history = mx.nd.zeros((3, 4))
+    out = mx.nd.contrib.fp8_fully_connected(data, weight, history, num_hidden=6, no_bias=True,
+                                            fp8_format='e4m3', amax_history_len=4)
+    d = _fp8_round(data.asnumpy().reshape(4, 15), 'e4m3')
+    w = _fp8_round(weight.asnumpy(), 'e4m3')
+    assert_almost_equal(out, d.dot(w.T), rtol=1e-5, atol=1e-5)
+    assert_almost_equal(history, np.zeros((3, 4)))
+
+@with_seed()
+@pytest.mark.parametrize('transpose_a', [True, False])
+@pytest.mark.parametrize('transpose_b', [True, False])
+def test_fp8_batch_dot(transpose_a, transpose_b):
+    lhs_shape = (2, 5, 3) if transpose_a else (2, 3, 5)
+    rhs_shape = (2, 4, 5) if transpose_b else (2, 5, 4)
+    lhs = mx.nd.random.uniform(-1, 1, shape=lhs_shape)
+    rhs = mx.nd.random.uniform(-3, 3, shape=rhs_shape)
+    ograd = mx.nd.random.uniform(-1, 1, shape=(2, 3, 4))
+    amax = [np.abs(a.asnumpy()).max() for a in [lhs, rhs, ograd]]
+    history = mx.nd.array(np.array(amax)[:, None] * np.array([[0.5, 1., 0.25]]))
+    lhs.attach_grad()
+    rhs.attach_grad()
+    with mx.autograd.record():
+        out = mx.nd.contrib.fp8_batch_dot(lhs, rhs, history, transpose_a=transpose_a,
+                                          transpose_b=transpose_b, amax_history_len=3)
+    out.backward(ograd)
+
+    # the default amax_compute_algo takes the maximum over the history
+    a = _fp8_cast(lhs.asnumpy(), amax[0], 'e4m3')
+    b = _fp8_cast(rhs.asnumpy(), amax[1], 'e4m3')
+    g = _fp8_cast(ograd.asnumpy(), amax[2], 'e5m2')
+    a_t = a.transpose(0, 2, 1) if transpose_a else a
+    b_t = b.transpose(0, 2, 1) if transpose_b else b
+    assert_almost_equal(out, np.matmul(a_t, b_t), rtol=1e-5, atol=1e-5)
+    lhs_grad = np.matmul(g, b_t.transpose(0, 2, 1))
+    rhs_grad = np.matmul(a_t.transpose(0, 2, 1), g)
+    assert_almost_equal(lhs.grad, lhs_grad.transpose(0, 2, 1) if transpose_a else lhs_grad,
+                        rtol=1e-5, atol=1e-5)
+    assert_almost_equal(rhs.grad, rhs_grad.transpose(0, 2, 1) if transpose_b else rhs_grad,
+                        rtol=1e-5, atol=1e-5)
+    assert_almost_equal(history[:, 0], np.array(amax), rtol=1e-6, atol=1e-6)
+    assert_almost_equal(history[:, 1:], np.array(amax)[:, None] * np.array([[0.5, 1.]]),
+                        rtol=1e-6, atol=1e-6)
+
+
+def test_calibrate_percentile():
+    # unit bins centered on -4..4, the zero bin is the middle one
+    hist = mx.nd.array([1, 0, 0, 10, 78, 10, 0, 0, 1])
+    hist_edges = mx.nd.array(np.linspace(-4.5, 4.5, 10))
+    for percentile, threshold in [(50, 0.5), (78, 0.5), (98, 1.5), (99, 4.5), (100, 4.5)]:
+        out = mx.nd.contrib.calibrate_percentile(hist, hist_edges, percentile=percentile)
+        assert_almost_equal(out, np.array([threshold]))
+
+
+@with_seed()
+def test_calibrate_mse():
+    def mse(hist, hist_edges, threshold, num_quantized_bins):
+        half = num_quantized_bins // 2
+        x = np.abs(0.5 * (hist_edges[:-1] + hist_edges[1:]))
+        q = np.minimum(np.floor(x * half / threshold + 0.5), half) * threshold / half
+        return (hist * (x - q) ** 2).sum() / hist.sum()
+
+    # all the mass at +-1 is exactly representable with the threshold 1.5 and one level
+    hist = np.array([0, 0, 0, 50, 0, 50, 0, 0, 0], dtype=np.float32)
+    hist_edges = np.linspace(-4.5, 4.5, 10).astype(np.float32)
+    threshold, error = mx.nd.contrib.calibrate_mse(mx.nd.array(hist), mx.nd.array(hist_edges),
+                                                   num_quantized_bins=3)
+    assert_almost_equal(threshold, np.array([1.5]))
+    assert_almost_equal(error, np.array([0.25]))
+
+    # a Gaussian with outliers, the threshold is the candidate of minimal error
+    num_bins, num_quantized_bins = 101, 15
+    data = np.concatenate([np.random.normal(size=10000), [-40, 45]])
+    hist, hist_edges = np.histogram(data, bins=num_bins, range=(-50, 50))
+    hist = hist.astype(np.float32)
+    hist_edges = hist_edges.astype(np.float32)
+    threshold, error = mx.nd.contrib.calibrate_mse(mx.nd.array(hist), mx.nd.array(hist_edges),
+                                                   num_quantized_bins=num_quantized_bins)
+    zero_bin = num_bins // 2
+    half = num_quantized_bins // 2
+    candidates = hist_edges[zero_bin + half + 1:]
+    errors = [mse(hist, hist_edges, t, num_quantized_bins) for t in candidates]
+    assert_almost_equal(threshold, np.array([candidates[np.argmin(errors)]]))
+    assert_almost_equal(error, np.array([min(errors)]), rtol=1e-4, atol=1e-6)
+    # the outliers are clipped
+    assert threshold.asscalar() < 40
+
+
+@with_seed()
+def test_quantize_v2_channel_wise():
+    data = np.random.uniform(-1, 1, size=(4, 3, 2, 2)).astype(np.float32)
+    data *= np.array([0.1, 1, 10, 0], dtype=np.float32).reshape((4, 1, 1, 1))
+    q, min_range, max_range = mx.nd.contrib.quantize_v2(mx.nd.array(data), out_type='int8',
+                                                        channel_wise_quantize=True)
+    real_range = np.abs(data).reshape((4, -1)).max(axis=1)
+    assert min_range.shape == (4,) and max_range.shape == (4,)
+    assert_almost_equal(min_range, -real_range)
+    assert_almost_equal(max_range, real_range)
+    scale = np.where(real_range > 0, 127 / np.maximum(real_range, 1e-30), 0).reshape((4, 1, 1, 1))
+    expected = np.sign(data) * np.minimum(np.abs(data) * scale + 0.5, 127)
+    assert q.dtype == np.int8
+    assert_allclose(q.asnumpy(), expected.astype(np.int8), atol=1)
+    # the pruned slice stays zero
+    assert (q.asnumpy()[3] == 0).all()
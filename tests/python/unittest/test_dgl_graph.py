@@ -182,6 +182,32 @@ def test_non_uniform_sample():
     assert (len(out) == 4)
     check_non_uniform(out, num_hops=1, max_num_vertices=5)
 
+def test_uniform_sample_large():
+    num_nodes, num_neighbor, max_num_vertices = 2000, 3, 1500
+    csr = sp.sparse.random(num_nodes, num_nodes, density=0.01, format='csr')
+    csr.sort_indices()
+    csr.data = np.arange(csr.nnz, dtype=np.int64)
+    a = mx.nd.sparse.csr_matrix((csr.data, csr.indices.astype(np.int64),
+                                 csr.indptr.astype(np.int64)), shape=csr.shape)
+    seed = mx.nd.array(np.random.choice(num_nodes, 300, replace=False), dtype=np.int64)
+    out = mx.nd.contrib.dgl_csr_neighbor_uniform_sample(a, seed, num_args=2, num_hops=2,
+                                                        num_neighbor=num_neighbor,
+                                                        max_num_vertices=max_num_vertices)
+    check_uniform(out, num_hops=2, max_num_vertices=max_num_vertices)
+    sample_id = out[0].asnumpy()
+    sub_csr = out[1]
+    indptr = sub_csr.indptr.asnumpy()
+    indices = sub_csr.indices.asnumpy()
+    data = sub_csr.data.asnumpy()
+    # every sampled edge is an edge of its vertex in the graph
+    for i in range(sample_id[-1]):
+        row = slice(indptr[i], indptr[i + 1])
+        assert indptr[i + 1] - indptr[i] <= num_neighbor
+        assert len(np.unique(data[row])) == indptr[i + 1] - indptr[i]
+        for col, eid in zip(indices[row], data[row]):
+            assert csr.indptr[sample_id[i]] <= eid < csr.indptr[sample_id[i] + 1]
+            assert csr.indices[eid] == col
+
 def test_edge_id():
     shape = rand_shape_2d()
     data = rand_ndarray(shape, stype='csr', density=0.4)
@@ -32,7 +32,43 @@ def test_bulk():
             x += 1
     assert (x.asnumpy() == 104).all()
 
+def test_priority():
+    assert mx.engine.set_priority(0) == 0
+    with mx.engine.priority(5):
+        with mx.engine.priority(10):
+            x = mx.nd.ones((10,))
+            x += 1
+        assert mx.engine.set_priority(5) == 5
+        x *= 2
+    assert mx.engine.set_priority(0) == 0
+    assert (x.asnumpy() == 4).all()
+
 @pytest.mark.skip(reason="OMP platform dependent")
+def test_wait_tag():
+    assert mx.engine.set_wait_tag(0) == 0
+    data = mx.nd.ones((256, 256))
+    with mx.engine.wait_tag(3):
+        out = data
+        for _ in range(10):
+            out = mx.nd.dot(out, data) / 256
+        assert mx.engine.set_wait_tag(3) == 3
+    assert mx.engine.set_wait_tag(0) == 0
+    mx.engine.wait_for_tag(3)
+    # a tag without operators
+    mx.engine.wait_for_tag(4)
+    assert out.asnumpy().sum() == 256 * 256
+
+
+def test_wait_for_context():
+    data = mx.nd.ones((256, 256), ctx=mx.cpu(1))
+    out = data
+    for _ in range(10):
+        out = mx.nd.dot(out, data) / 256
+    mx.engine.wait_for_context(mx.cpu(1))
+    mx.engine.wait_for_context(mx.cpu(2))
+    assert out.asnumpy().sum() == 256 * 256
+
+
 def test_engine_openmp_after_fork():
     """
     Test that the number of max threads in the child is 1. After forking we should not use a bigger
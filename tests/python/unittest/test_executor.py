@@ -164,3 +164,52 @@ def test_cached_op_init():
     check_init(False, False)
     check_init(True, False)
     check_init(True, True)
+
+
+@with_seed()
+def test_fusion_cpu():
+    a = mx.sym.Variable('a')
+    b = mx.sym.Variable('b')
+    syms = [mx.sym.relu(a * b + 2) / (mx.sym.exp(-a) + 1),
+            mx.sym.add_n(a, b, mx.sym.square(a)) - mx.sym.Activation(b, act_type='tanh'),
+            mx.sym.Group([mx.sym.sqrt(mx.sym.abs(a)) * 3, mx.sym.sigmoid(a + b).reshape((-1,))])]
+    shape = (3, 5, 700)
+    for sym in syms:
+        sym = mx.sym.Group([mx.sym.identity(mx.sym.identity(s)) for s in sym])
+        for dtype in ['float16', 'float32', 'float64']:
+            data = {'a': mx.nd.random.uniform(-1, 1, shape=shape, dtype=dtype),
+                    'b': mx.nd.random.uniform(-1, 1, shape=shape, dtype=dtype)}
+            results = []
+            for fusion in ['0', '1']:
+                with environment('MXNET_USE_FUSION', fusion):
+                    exe = sym._simple_bind(ctx=mx.cpu(), grad_req='write',
+                                           type_dict={'a': dtype, 'b': dtype}, a=shape, b=shape)
+                outputs = exe.forward(is_train=True, **data)
+                exe.backward(out_grads=[mx.nd.ones_like(out) for out in outputs])
+                results.append([out.asnumpy() for out in outputs] +
+                               [grad.asnumpy() for grad in exe.grad_arrays])
+            rtol = 1e-2 if dtype == 'float16' else 1e-5
+            for orig, fused in zip(*results):
+                assert_almost_equal(orig, fused, rtol=rtol, atol=rtol)
+
+
+@with_seed()
+def test_fusion_cpu_cast():
+    # a cast inside a fused region must round or truncate as the unfused op does
+    a = mx.sym.Variable('a')
+    b = mx.sym.Variable('b')
+    syms = [mx.sym.Cast(a * 3, dtype='int32') * 2 + 1,
+            mx.sym.Cast(mx.sym.Cast(a + b, dtype='int32'), dtype='float32') * b,
+            mx.sym.amp_cast(mx.sym.amp_cast(a * b, dtype='float16'), dtype='float32') * 3]
+    shape = (3, 5, 700)
+    data = {'a': mx.nd.random.uniform(-5, 5, shape=shape),
+            'b': mx.nd.random.uniform(-5, 5, shape=shape)}
+    for sym in syms:
+        sym = mx.sym.identity(sym)
+        results = []
+        for fusion in ['0', '1']:
+            with environment('MXNET_USE_FUSION', fusion):
+                exe = sym._simple_bind(ctx=mx.cpu(), grad_req='null', a=shape, b=shape)
+            results.append(exe.forward(is_train=False, **data)[0].asnumpy())
+        assert results[0].dtype == results[1].dtype
+        assert_almost_equal(results[0], results[1], rtol=1e-6, atol=1e-6)
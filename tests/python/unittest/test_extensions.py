@@ -25,6 +25,7 @@ from mxnet import nd
 from mxnet.gluon import nn
 from mxnet.base import MXNetError
 from mxnet.test_utils import download, is_cd_run, assert_almost_equal, default_context
+from common import run_in_spawned_process
 import pytest
 
 base_path = os.path.join(os.path.dirname(__file__), "../../..")
@@ -96,6 +97,57 @@ def test_custom_op():
     assert_almost_equal(in_grad_base[0].asnumpy(), in_grad1[0].asnumpy(), rtol=1e-3, atol=1e-3)
     assert_almost_equal(in_grad_base[0].asnumpy(), in_grad2[0].asnumpy(), rtol=1e-3, atol=1e-3)
 
+    # the backward transposes A and B into its declared temp space
+    out_grad = mx.nd.random.uniform(-1, 1, shape=(dim_n, dim_m), ctx=mx.cpu())
+    exe1.forward(is_train=True)
+    exe1.backward([out_grad])
+    exe2.forward(is_train=True)
+    exe2.backward([out_grad])
+    a, b, dc = mat1.asnumpy(), mat2.asnumpy(), out_grad.asnumpy()
+    for in_grad in [in_grad1, in_grad2]:
+        assert_almost_equal(in_grad[0].asnumpy(), np.dot(dc, b.T), rtol=1e-3, atol=1e-3)
+        assert_almost_equal(in_grad[1].asnumpy(), np.dot(a.T, dc), rtol=1e-3, atol=1e-3)
+
+    # alloc_cpu would alias the declared temp space, so it raises
+    e = mx.sym.my_gemm(s, t, alloc_cpu='true')
+    in_grad3 = [mx.nd.empty((dim_n,dim_k),ctx=mx.cpu()),mx.nd.empty((dim_k,dim_m),ctx=mx.cpu())]
+    exe3 = e._bind(ctx=mx.cpu(),args={'s':mat1,'t':mat2},args_grad=in_grad3)
+    exe3.forward(is_train=True)
+    with pytest.raises(MXNetError):
+        exe3.backward([out_grad])
+        in_grad3[0].asnumpy()
+
+@pytest.mark.skipif(check_platform(), reason="not all machine types supported")
+@pytest.mark.skipif(is_cd_run(), reason="continuous delivery run - ignoring test")
+def test_custom_op_relu():
+    # the relu library is only built with CUDA, its operators also run on CPU
+    lib = 'libcustomop_gpu_lib.so' if os.name == 'posix' else 'libcustomop_gpu_lib.dll'
+    fname = None
+    for path in [lib, os.path.join(base_path, 'build/'+lib), 'windows_package\\lib\\'+lib]:
+        if os.path.exists(path):
+            fname = os.path.abspath(path)
+    if fname is None:
+        pytest.skip("library %s not found " % lib)
+    mx.library.load(fname)
+
+    data = mx.nd.random.uniform(-1, 1, shape=(3, 4), ctx=mx.cpu())
+
+    # my_relu may write its output over its input
+    x = mx.sym.Variable('x')
+    sym = mx.sym.my_relu(mx.sym.my_relu(x * 2) - 1)
+    block = nn.SymbolBlock(sym, [x])
+    block.hybridize(static_alloc=True, static_shape=True)
+    for _ in range(2):
+        out = block(data)
+        assert_almost_equal(out.asnumpy(), np.maximum(np.maximum(data.asnumpy() * 2, 0) - 1, 0),
+                            rtol=1e-5, atol=1e-5)
+
+    # my_state_relu reuses its state between the calls of the same shapes
+    for shape in [(3, 4), (3, 4), (2, 5)]:
+        data = mx.nd.random.uniform(-1, 1, shape=shape, ctx=mx.cpu())
+        out = mx.nd.my_state_relu(data)
+        assert_almost_equal(out.asnumpy(), np.maximum(data.asnumpy(), 0), rtol=1e-5, atol=1e-5)
+
 @pytest.mark.skipif(check_platform(), reason="not all machine types supported")
 @pytest.mark.skipif(is_cd_run(), reason="continuous delivery run - ignoring test")
 def test_subgraph():
@@ -179,3 +231,49 @@ def test_subgraph():
     out5 = sym_block3(a_data, b_data)
     # check that result matches one executed by MXNet
     assert_almost_equal(out[0].asnumpy(), out5[0].asnumpy(), rtol=1e-3, atol=1e-3)
+
+
+def _check_plan_memory_pass(seed, fname, registered):
+    mx.library.load(fname)
+    # elementwise ops planned inplace over their input, the pass moves them apart
+    a = mx.sym.var('a')
+    b = mx.sym.var('b')
+    sym = mx.sym.log(mx.sym.exp(a + b))
+    sym_block = nn.SymbolBlock(sym, [a, b])
+    sym_block.initialize()
+    sym_block.hybridize(static_alloc=True)
+    a_data = mx.nd.ones((3, 2))
+    b_data = mx.nd.ones((3, 2))
+    if registered:
+        for _ in range(2):
+            out = sym_block(a_data, b_data)
+            assert_almost_equal(out.asnumpy(), np.full((3, 2), 2.0), rtol=1e-3, atol=1e-3)
+    else:
+        with pytest.raises(MXNetError):
+            sym_block(a_data, b_data).wait_to_read()
+
+@pytest.mark.skipif(check_platform(), reason="not all machine types supported")
+@pytest.mark.skipif(is_cd_run(), reason="continuous delivery run - ignoring test")
+def test_plan_memory_pass():
+    # possible places to find library file
+    if (os.name=='posix'):
+        lib = 'libpass_lib.so'
+        if os.path.exists(lib):
+            fname = lib
+        elif os.path.exists(os.path.join(base_path, 'build/'+lib)):
+            fname = os.path.join(base_path, 'build/'+lib)
+        else:
+            raise MXNetError("library %s not found " % lib)
+    elif (os.name=='nt'):
+        lib = 'libpass_lib.dll'
+        if os.path.exists('windows_package\\lib\\'+lib):
+            fname = 'windows_package\\lib\\'+lib
+        else:
+            raise MXNetError("library %s not found " % lib)
+
+    fname = os.path.abspath(fname)
+    # the passes are read once per process
+    run_in_spawned_process(_check_plan_memory_pass,
+                           {'MXNET_PLAN_MEMORY_PASSES': 'noInplace'}, fname, True)
+    run_in_spawned_process(_check_plan_memory_pass,
+                           {'MXNET_PLAN_MEMORY_PASSES': 'noSuchPass'}, fname, False)
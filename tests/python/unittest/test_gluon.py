@@ -1640,6 +1640,336 @@ def test_hybrid_static_memory(static_alloc, static_shape):
         assert_almost_equal(grads1[key].asnumpy(), grads2[key].asnumpy(), rtol=1e-3, atol=1e-4)
 
 
+@with_seed()
+def test_hybrid_static_temp_arena():
+    x = mx.nd.random.uniform(shape=(2, 3, 16, 16))
+    x.attach_grad()
+
+    def run(arena):
+        net = nn.HybridSequential()
+        net.add(nn.Conv2D(8, 3), nn.BatchNorm(), nn.Conv2D(4, 3))
+        net.initialize(mx.init.One())
+        with environment('MXNET_CACHEDOP_TEMP_ARENA', arena):
+            net.hybridize(static_alloc=True, static_shape=True)
+            with mx.autograd.record():
+                y = net(x)
+            y.backward()
+            mx.nd.waitall()
+        return y.asnumpy(), x.grad.asnumpy()
+
+    y1, grad1 = run('0')
+    y2, grad2 = run('1')
+    assert_almost_equal(y1, y2, rtol=1e-5, atol=1e-5)
+    assert_almost_equal(grad1, grad2, rtol=1e-5, atol=1e-5)
+
+
+def test_hybrid_static_sparse_grad():
+    def run(static):
+        net = nn.HybridSequential()
+        net.add(nn.Embedding(20, 8, sparse_grad=True), nn.Dense(4, flatten=False))
+        net.initialize(mx.init.One())
+        if static:
+            net.hybridize(static_alloc=True, static_shape=True)
+        grads = []
+        # the inference passes in between make the static graph plan its memory again
+        for batch in [[1, 3, 5], [2, 3, 19], [0, 3, 5]]:
+            x = mx.nd.array(batch)
+            net(x)
+            with mx.autograd.record():
+                y = net(x)
+            y.backward()
+            weight = net[0].weight.grad()
+            assert weight.stype == 'row_sparse'
+            grads.append(weight.asnumpy())
+        return grads
+
+    for grad1, grad2 in zip(run(False), run(True)):
+        assert_almost_equal(grad1, grad2)
+
+
+@with_seed()
+@use_np
+def test_auto_hybridize():
+    class Net(gluon.HybridBlock):
+        def __init__(self):
+            super().__init__()
+            self.dense = nn.Dense(4)
+
+        def forward(self, x):
+            return mx.np.tanh(self.dense(x)) * 2
+
+    class Branching(gluon.HybridBlock):
+        def forward(self, x):
+            return x * 2 if x.asnumpy().sum() > 0 else x * 3
+
+    class Inplace(gluon.HybridBlock):
+        def forward(self, x):
+            y = x + 1
+            y += 1
+            return y
+
+    threshold = mx.gluon.block._AUTO_HYBRIDIZE
+    mx.gluon.block._AUTO_HYBRIDIZE = 3
+    try:
+        net = Net()
+        net.initialize()
+        x = mx.np.random.uniform(size=(2, 5))
+        expected = net(x).asnumpy()
+        for _ in range(2):
+            assert not net._active
+            assert_almost_equal(net(x), expected)
+        assert net._active and net.dense._active
+        assert_almost_equal(net(x), expected)
+        assert net._cached_op is not None
+
+        # the same inputs trace other graphs, so that the block stays eager
+        branching = Branching()
+        ones = mx.np.ones((3,))
+        for i in range(6):
+            sign = 1 if i % 2 else -1
+            assert_almost_equal(branching(ones * sign), ones.asnumpy() * sign * (2 if sign > 0 else 3))
+        assert not branching._active
+
+        inplace = Inplace()
+        with warnings.catch_warnings(record=True):
+            for i in range(4):
+                assert_almost_equal(inplace(ones), ones.asnumpy() + 2)
+        assert not inplace._active
+
+        # a block hybridized or kept eager by the user is left as it is
+        net = Net()
+        net.initialize()
+        net.hybridize(False)
+        for _ in range(4):
+            net(x)
+        assert not net._active
+    finally:
+        mx.gluon.block._AUTO_HYBRIDIZE = threshold
+
+
+@with_seed()
+def test_hybrid_static_parallel_branches():
+    class Towers(gluon.HybridBlock):
+        def __init__(self, **kwargs):
+            super(Towers, self).__init__(**kwargs)
+            self.towers = nn.HybridSequential()
+            for _ in range(3):
+                tower = nn.HybridSequential()
+                tower.add(nn.Dense(16, activation='relu'), nn.Dense(8))
+                self.towers.add(tower)
+
+        def hybrid_forward(self, F, x):
+            return F.concat(*[tower(x) for tower in self.towers], dim=1)
+
+    x = mx.nd.random.uniform(shape=(4, 10))
+    net = Towers()
+    net.initialize()
+
+    def test(net, x):
+        with mx.autograd.record():
+            y = net(x)
+            y.backward()
+        grads = {k: v.grad() for k, v in net.collect_params().items()}
+        return y, grads
+
+    y1, grads1 = test(net, x)
+    for split_branches in ['0', '1']:
+        with environment('MXNET_EXEC_BULK_EXEC_SPLIT_BRANCHES', split_branches):
+            net.hybridize(static_alloc=True, static_shape=True)
+            y2, grads2 = test(net, x)
+            assert_almost_equal(y1, y2, rtol=1e-4, atol=1e-5)
+            for key in grads1:
+                assert_almost_equal(grads1[key], grads2[key], rtol=1e-4, atol=1e-5)
+
+
+@with_seed()
+@pytest.mark.parametrize('static_alloc', [False, True])
+def test_hybrid_memory_aware_order(static_alloc):
+    class Branches(gluon.HybridBlock):
+        def __init__(self, **kwargs):
+            super(Branches, self).__init__(**kwargs)
+            self.wide = nn.Dense(64, activation='relu')
+            self.narrow = nn.Dense(4)
+            self.out = nn.Dense(4)
+
+        def hybrid_forward(self, F, x):
+            return self.out(self.wide(x)) + self.narrow(x)
+
+    x = mx.nd.random.uniform(shape=(8, 16))
+    net = Branches()
+    net.initialize()
+
+    def test(net, x):
+        x.attach_grad()
+        with mx.autograd.record():
+            y = net(x)
+        y.backward()
+        grads = {k: v.grad().copy() for k, v in net.collect_params().items()
+                 if v.grad_req != 'null'}
+        return y, x.grad.copy(), grads
+
+    net.hybridize(static_alloc=static_alloc)
+    y1, dx1, grads1 = test(net, x)
+    with environment('MXNET_EXEC_MEMORY_AWARE_ORDER', '1'):
+        net.hybridize(static_alloc=static_alloc)
+        y2, dx2, grads2 = test(net, x)
+        # the order is chosen again when the gradient requests change
+        net.narrow.weight.grad_req = 'null'
+        y3, dx3, grads3 = test(net, x)
+    assert_almost_equal(y1, y2)
+    assert_almost_equal(dx1, dx2)
+    assert_almost_equal(dx1, dx3)
+    assert len(grads3) == len(grads1) - 1
+    for key in grads1:
+        assert_almost_equal(grads1[key], grads2[key])
+    for key in grads3:
+        assert_almost_equal(grads1[key], grads3[key])
+
+
+@with_seed()
+@pytest.mark.parametrize('static_shape_bucket', [0, 8])
+def test_hybrid_static_cache(static_shape_bucket):
+    def build():
+        net = nn.HybridSequential()
+        net.add(nn.Dense(16, activation='relu', flatten=False, in_units=8),
+                nn.Dense(4, flatten=False, in_units=16))
+        net.initialize()
+        return net
+    net = build()
+    ref_net = build()
+    for p, ref_p in zip(net.collect_params().values(), ref_net.collect_params().values()):
+        ref_p.set_data(p.data())
+    net.hybridize(static_alloc=True, static_shape=True, static_cache_size=2,
+                  static_shape_bucket=static_shape_bucket)
+    ref_net.hybridize()
+
+    # more sequence lengths than cached plans, revisited out of order
+    for seq_len in [5, 12, 5, 7, 12, 3, 5]:
+        x = mx.nd.random.uniform(shape=(2, seq_len, 8))
+        x.attach_grad()
+        ref_x = x.copy()
+        ref_x.attach_grad()
+        with mx.autograd.record():
+            y = net(x)
+        y.backward()
+        with mx.autograd.record():
+            ref_y = ref_net(ref_x)
+        ref_y.backward()
+        assert y.shape == (2, seq_len, 4)
+        assert_almost_equal(y, ref_y)
+        assert_almost_equal(x.grad, ref_x.grad)
+
+
+@with_seed()
+@pytest.mark.parametrize('static_alloc', [False, True])
+def test_hybrid_memory_arena(static_alloc):
+    def build():
+        net = nn.HybridSequential()
+        net.add(nn.Dense(32, activation='relu', in_units=8),
+                nn.Dense(32, activation='tanh', in_units=32),
+                nn.Dense(4, in_units=32))
+        net.initialize()
+        return net
+    net = build()
+    ref_net = build()
+    for p, ref_p in zip(net.collect_params().values(), ref_net.collect_params().values()):
+        ref_p.set_data(p.data())
+    net.hybridize(static_alloc=static_alloc, memory_arena=True)
+    ref_net.hybridize(static_alloc=static_alloc)
+
+    for batch_size in [3, 3, 6]:
+        x = mx.nd.random.uniform(shape=(batch_size, 8))
+        assert_almost_equal(net(x), ref_net(x))
+        x.attach_grad()
+        ref_x = x.copy()
+        ref_x.attach_grad()
+        with mx.autograd.record():
+            y = net(x)
+        y.backward()
+        with mx.autograd.record():
+            ref_y = ref_net(ref_x)
+        ref_y.backward()
+        assert_almost_equal(y, ref_y)
+        assert_almost_equal(x.grad, ref_x.grad)
+
+
+@with_seed()
+@pytest.mark.parametrize('static_alloc', [False, True])
+@pytest.mark.parametrize('memory_arena', [False, True])
+def test_hybrid_alias_concat(static_alloc, memory_arena):
+    class Net(gluon.HybridBlock):
+        def __init__(self):
+            super(Net, self).__init__()
+            self.fc1 = nn.Dense(16, in_units=8)
+            self.fc2 = nn.Dense(16, in_units=8)
+            self.fc3 = nn.Dense(4, in_units=16)
+
+        def hybrid_forward(self, F, x):
+            a = F.relu(self.fc1(x))
+            b = self.fc2(x)
+            # contiguous along the batch axis, and along the channels of a batch of one
+            h = F.concat(F.concat(a, b, dim=0), F.concat(b, a, dim=1).reshape((-1, 16)), dim=0)
+            s = F.split(F.tanh(h), num_outputs=2, axis=0)
+            return self.fc3(s[0] * s[1])
+
+    net = Net()
+    ref_net = Net()
+    for n in (net, ref_net):
+        n.initialize()
+    for p, ref_p in zip(net.collect_params().values(), ref_net.collect_params().values()):
+        ref_p.set_data(p.data())
+    net.hybridize(static_alloc=static_alloc, memory_arena=memory_arena, alias_concat=True)
+    ref_net.hybridize(static_alloc=static_alloc)
+
+    for batch_size in [1, 1, 3]:
+        x = mx.nd.random.uniform(shape=(batch_size, 8))
+        assert_almost_equal(net(x), ref_net(x))
+        for n in (net, ref_net):
+            with mx.autograd.record():
+                y = n(x)
+            y.backward()
+        for p, ref_p in zip(net.collect_params().values(), ref_net.collect_params().values()):
+            assert_almost_equal(p.grad(), ref_p.grad())
+
+
+@with_seed()
+@pytest.mark.parametrize('static_alloc', [False, True])
+def test_hybrid_backward_mirror(static_alloc):
+    class Net(gluon.HybridBlock):
+        def __init__(self):
+            super(Net, self).__init__()
+            self.fc1 = nn.Dense(64)
+            self.fc2 = nn.Dense(8)
+
+        def hybrid_forward(self, F, x):
+            h = F.tanh(self.fc1(x))
+            h = F.sigmoid(h) * h + F.exp(-h)
+            return self.fc2(F.relu(h))
+
+    x = mx.nd.random.uniform(shape=(16, 32))
+    ref_net = Net()
+    ref_net.initialize()
+    ref_net(x)
+    net = Net()
+    net.initialize()
+    net(x)
+    for p, ref_p in zip(net.collect_params().values(), ref_net.collect_params().values()):
+        p.set_data(ref_p.data())
+    ref_net.hybridize(static_alloc=static_alloc)
+    net.hybridize(static_alloc=static_alloc, backward_mirror=True)
+
+    # the second batch has another shape than the one the mirroring was planned for
+    for shape in [(16, 32), (4, 32)]:
+        x = mx.nd.random.uniform(shape=shape)
+        for n in (ref_net, net):
+            with mx.autograd.record():
+                y = n(x)
+            y.backward()
+        assert_almost_equal(net(x), ref_net(x))
+        for p, ref_p in zip(net.collect_params().values(), ref_net.collect_params().values()):
+            assert_almost_equal(p.grad(), ref_p.grad(), rtol=1e-5, atol=1e-6)
+
+
 @with_seed()
 @pytest.mark.parametrize('static_alloc', [False, True])
 @pytest.mark.parametrize('static_shape', [False, True])
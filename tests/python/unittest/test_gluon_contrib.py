@@ -27,6 +27,7 @@ from mxnet.gluon.contrib.nn import (
 from mxnet.test_utils import almost_equal, default_context, assert_almost_equal, assert_allclose
 from common import setup_module, with_seed, teardown_module
 import numpy as np
+import pytest
 
 
 def check_rnn_cell(cell, in_shape=(10, 50), out_shape=(10, 100), begin_state=None):
@@ -424,3 +425,115 @@ def test_ModulatedDeformableConvolution():
     with mx.autograd.record():
         y = net(x)
 
+
+
+def test_one_f_one_b_schedule():
+    from mxnet.gluon.contrib.pipeline import one_f_one_b_schedule
+    assert one_f_one_b_schedule(2, 4) == [('F', 0), ('F', 1), ('B', 0), ('F', 2),
+                                          ('B', 1), ('F', 3), ('B', 2), ('B', 3)]
+    assert one_f_one_b_schedule(4, 2) == [('F', 0), ('F', 1), ('B', 0), ('B', 1)]
+
+
+@with_seed()
+def test_pipeline_parallel():
+    from mxnet.gluon.contrib.pipeline import PipelineParallel, split_sequential
+    net = nn.HybridSequential()
+    net.add(nn.Dense(16, activation='relu', in_units=8),
+            nn.Dense(16, activation='relu', in_units=16),
+            nn.Dense(4, in_units=16))
+    net.initialize()
+    loss = gluon.loss.L2Loss()
+    x = mx.nd.random.uniform(shape=(10, 8))
+    y = mx.nd.random.uniform(shape=(10, 4))
+    with mx.autograd.record():
+        l = loss(net(x), y)
+    l.backward()
+    expected = {k: v.grad().copy() for k, v in net.collect_params().items()}
+    expected_out = net(x)
+
+    stages = split_sequential(net, 2)
+    assert len(stages) == 2
+    pipe = PipelineParallel(stages, [mx.cpu(0), mx.cpu(1)], num_micro_batches=3)
+    for _ in range(2):
+        losses = pipe.forward_backward(x, y, loss)
+        assert len(losses) == 3
+        assert all(out.ctx == mx.cpu(1) for out in losses)
+        assert len(pipe.collect_params()) == len(expected)
+        for k, v in net.collect_params().items():
+            assert_almost_equal(v.list_grad()[0], expected[k], rtol=1e-4, atol=1e-5)
+    out = mx.nd.concat(*pipe.forward(x), dim=0)
+    assert_almost_equal(out, expected_out, rtol=1e-4, atol=1e-5)
+
+
+@with_seed()
+def test_tensor_parallel_dense():
+    from mxnet.gluon.contrib.nn import ColumnParallelDense, RowParallelDense
+    ctxs = [mx.cpu(0), mx.cpu(1)]
+    col = ColumnParallelDense(8, ctxs, in_units=6, gather_output=False, activation='relu')
+    row = RowParallelDense(5, ctxs, in_units=8)
+    col.initialize(init='xavier')
+    row.initialize(init='xavier')
+    row.bias.set_data(mx.nd.random.uniform(shape=(5,)))
+    for i, ctx in enumerate(ctxs):
+        assert col._shards[i].weight.list_ctx() == [ctx]
+        assert row._shards[i].weight.list_ctx() == [ctx]
+    assert row.bias.list_ctx() == [ctxs[0]]
+
+    x = mx.nd.random.uniform(shape=(4, 6))
+    x.attach_grad()
+    with mx.autograd.record():
+        out = row(col(x))
+    out.backward()
+    assert out.ctx == ctxs[0]
+
+    w1 = mx.nd.concat(*[s.weight.data(c).copyto(ctxs[0]) for s, c in zip(col._shards, ctxs)], dim=0)
+    b1 = mx.nd.concat(*[s.bias.data(c).copyto(ctxs[0]) for s, c in zip(col._shards, ctxs)], dim=0)
+    w2 = mx.nd.concat(*[s.weight.data(c).copyto(ctxs[0]) for s, c in zip(row._shards, ctxs)], dim=1)
+    y = mx.nd.relu(mx.nd.FullyConnected(x, w1, b1, num_hidden=8))
+    expected = mx.nd.FullyConnected(y, w2, row.bias.data(ctxs[0]), num_hidden=5)
+    assert_almost_equal(out, expected, rtol=1e-5, atol=1e-6)
+    expected_grad = mx.nd.dot(mx.nd.dot(mx.nd.ones((4, 5)), w2) * (y > 0), w1)
+    assert_almost_equal(x.grad, expected_grad, rtol=1e-5, atol=1e-6)
+
+    gathered = ColumnParallelDense(8, ctxs, in_units=6)
+    gathered.initialize()
+    assert gathered(x).shape == (4, 8)
+
+
+@with_seed()
+def test_parallel_multi_head_attention():
+    from mxnet.gluon.contrib.nn import ParallelMultiHeadAttention
+    ctxs = [mx.cpu(0), mx.cpu(1)]
+    units, heads, length = 8, 4, 3
+    att = ParallelMultiHeadAttention(units, heads, ctxs, in_units=6)
+    att.initialize(init='xavier')
+    x = mx.nd.random.uniform(shape=(2, length, 6))
+    mask = mx.nd.ones((2, length, length))
+    mask[:, :, -1] = 0
+    out = att(x, mask)
+    assert out.shape == (2, length, units)
+
+    # single-device reference with the same weights
+    head_units = units // heads
+    outs = []
+    for shard, ctx in zip(att._shards, ctxs):
+        qkv = shard(x.copyto(ctx)).copyto(ctxs[0])
+        q, k, v = mx.nd.split(qkv, num_outputs=3, axis=-1)
+        for h in range(heads // len(ctxs)):
+            sl = slice(h * head_units, (h + 1) * head_units)
+            s = mx.nd.batch_dot(q[:, :, sl], k[:, :, sl], transpose_b=True) / np.sqrt(head_units)
+            s = s + (1 - mask) * -1e18
+            outs.append(mx.nd.batch_dot(mx.nd.softmax(s, axis=-1), v[:, :, sl]))
+    concat = mx.nd.concat(*outs, dim=-1)
+    assert_almost_equal(out, att.proj(concat), rtol=1e-5, atol=1e-6)
+
+
+def test_sync_batchnorm_backend_args():
+    from mxnet.gluon.contrib.nn import SyncBatchNorm
+    with pytest.raises(ValueError):
+        SyncBatchNorm(in_channels=4, num_devices=2, backend='nccl')
+    with pytest.raises(ValueError):
+        SyncBatchNorm(in_channels=4, num_devices=2, backend='mpi')
+    layer = SyncBatchNorm(in_channels=4, num_devices=2, backend='nccl', nccl_id='00' * 128,
+                          rank_offset=2)
+    assert layer._kwargs['num_ranks'] == 2 and layer._kwargs['rank_offset'] == 2
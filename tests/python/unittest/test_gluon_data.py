@@ -30,6 +30,7 @@ import mxnet.ndarray as nd
 from mxnet import context
 from mxnet.gluon.data.dataset import Dataset
 from mxnet.gluon.data.dataset import ArrayDataset
+from mxnet.test_utils import assert_almost_equal
 import pytest
 
 @with_seed()
@@ -89,6 +90,135 @@ def test_recordimage_dataset_handle(prepare_record):
         assert x.shape[0] == 1 and x.shape[3] == 3
         assert y.asscalar() == i
 
+@pytest.mark.parametrize('use_mmap', [False, True])
+def test_record_file_dataset_handle(tmpdir, use_mmap):
+    idx_file, rec_file = str(tmpdir.join('data.idx')), str(tmpdir.join('data.rec'))
+    magic = (0xced7230a).to_bytes(4, 'little')
+    # the middle records contain the magic number and are split by the writer
+    payloads = [b'first', b'ab' + magic + b'cde', magic + b'x' + magic, b'last record']
+    record = mx.recordio.MXIndexedRecordIO(idx_file, rec_file, 'w')
+    for i, payload in enumerate(payloads):
+        record.write_idx(i, payload)
+    record.close()
+    dataset = gluon.data.RecordFileDataset(rec_file, use_mmap=use_mmap).__mx_handle__()
+    assert len(dataset) == len(payloads)
+    for i, payload in enumerate(payloads):
+        item = dataset[i]
+        if isinstance(item, mx.nd.NDArray):
+            item = item.asnumpy()
+        assert item.astype(np.uint8).tobytes() == payload
+
+def _write_columnar(path, num_rows=50, row_group_size=16):
+    x = np.random.uniform(size=(num_rows, 2, 3)).astype(np.float32)
+    y = np.arange(num_rows, dtype=np.int64)
+    s = mx.nd.sparse.csr_matrix(np.eye(num_rows, 7, dtype=np.float32) * 2)
+    gluon.data.ColumnarDataset.write(path, [('x', x), ('y', y), ('s', s)],
+                                     row_group_size=row_group_size)
+    return x, y, s.asnumpy()
+
+def test_columnar_dataset(tmpdir):
+    path = str(tmpdir.join('data.col'))
+    x, y, s = _write_columnar(path)
+    dataset = gluon.data.ColumnarDataset(path)
+    assert len(dataset) == 50
+    for i in [0, 15, 16, 49]:
+        xi, yi, si = dataset[i]
+        assert_almost_equal(xi.asnumpy(), x[i])
+        assert yi == y[i]
+        assert si.stype == 'csr' and si.shape == (1, 7)
+        assert_almost_equal(si.asnumpy(), s[i:i + 1])
+    projected = gluon.data.ColumnarDataset(path, columns=['y', 'x'])
+    yi, xi = projected[20]
+    assert yi == 20
+    assert_almost_equal(xi.asnumpy(), x[20])
+
+def test_columnar_dataset_threaded_loader(tmpdir):
+    path = str(tmpdir.join('data.col'))
+    x, y, _ = _write_columnar(path)
+    dataset = gluon.data.ColumnarDataset(path, columns=['x', 'y'])
+    loader = gluon.data.DataLoader(dataset, 8, num_workers=2, try_nopython=True)
+    for epoch in range(2):
+        xs, ys = [], []
+        for xb, yb in loader:
+            xs.append(xb.asnumpy())
+            ys.append(yb.asnumpy())
+        assert_almost_equal(np.concatenate(xs), x)
+        assert_almost_equal(np.concatenate(ys), y)
+
+def test_columnar_dataset_from_parquet(tmpdir):
+    pa = pytest.importorskip('pyarrow')
+    pq = pytest.importorskip('pyarrow.parquet')
+    parquet_path, path = str(tmpdir.join('data.parquet')), str(tmpdir.join('data.col'))
+    a = np.arange(40, dtype=np.float32)
+    b = np.arange(40, dtype=np.int32) * 3
+    pq.write_table(pa.table({'a': a, 'b': b}), parquet_path, row_group_size=16)
+    dataset = gluon.data.ColumnarDataset.from_parquet(parquet_path, path, columns=['b', 'a'])
+    assert len(dataset) == 40
+    for i in [0, 17, 39]:
+        bi, ai = dataset[i]
+        assert bi == b[i] and ai == a[i]
+
+@pytest.mark.parametrize('use_mmap', [False, True])
+def test_recordimage_dataset_threaded_loader(prepare_record, use_mmap):
+    # the loader samples batches ahead and lets the dataset read their records early
+    dataset = gluon.data.vision.ImageRecordDataset(prepare_record, use_mmap=use_mmap)
+    loader = gluon.data.DataLoader(dataset, 1, num_workers=2, try_nopython=True)
+    for epoch in range(2):
+        labels = []
+        for x, y in loader:
+            assert x.shape[0] == y.shape[0] and x.shape[3] == 3
+            labels.extend(y.asnumpy().tolist())
+        assert labels == list(range(len(dataset)))
+
+@pytest.mark.parametrize('cache', [dict(decoded_cache_size=64),
+                                   dict(decoded_cache_file_size=64),
+                                   dict(decoded_cache_size=1, decoded_cache_file_size=1)])
+def test_recordimage_dataset_decoded_cache(prepare_record, tmpdir, cache):
+    expected = [x.asnumpy() for x, _ in gluon.data.vision.ImageRecordDataset(prepare_record)]
+    dataset = gluon.data.vision.ImageRecordDataset(
+        prepare_record, decoded_cache_file=os.path.join(str(tmpdir), 'cache.bin'), **cache)
+    loader = gluon.data.DataLoader(dataset, 1, num_workers=2, try_nopython=True)
+    for epoch in range(2):
+        for i, (x, y) in enumerate(loader):
+            assert int(y.asscalar()) == i
+            assert_almost_equal(x[0].asnumpy(), expected[i])
+
+@pytest.mark.parametrize('flag', [0, 1])
+def test_image_dataset_handles_rgb(prepare_record, flag):
+    # the backend datasets decode 1 and 3 channel images to the layout of image.imdecode
+    root = os.path.join(os.path.dirname(prepare_record), 'test_images')
+    imlist = os.listdir(root)
+    record = mx.recordio.MXIndexedRecordIO(os.path.splitext(prepare_record)[0] + '.idx',
+                                           prepare_record, 'r')
+    expected = []
+    for i in range(len(imlist)):
+        _, buf = mx.recordio.unpack(record.read_idx(i))
+        expected.append(mx.image.imdecode(buf, flag=flag).asnumpy())
+    record.close()
+    rec_handle = gluon.data.vision.ImageRecordDataset(prepare_record, flag=flag).__mx_handle__()
+    list_handle = gluon.data.vision.ImageListDataset(
+        root=root, imglist=[(0, path) for path in imlist], flag=flag).__mx_handle__()
+    channels = 3 if flag else 1
+    for i in range(len(imlist)):
+        rec_img = rec_handle[i][0].asnumpy()
+        list_img = list_handle[i][0].asnumpy()
+        assert rec_img.shape[2] == channels and rec_img.dtype == np.uint8
+        assert np.all(rec_img == expected[i])
+        assert np.all(list_img == expected[i])
+
+@pytest.mark.parametrize('num_workers,batch_size', [(2, 5), (3, 5), (4, 3), (8, 3)])
+def test_threaded_loader_chunks(num_workers, batch_size):
+    # the workers read contiguous chunks of a batch, which may be fewer than the workers
+    data = np.arange(23 * 2, dtype=np.float32).reshape(23, 2)
+    dataset = gluon.data.SimpleDataset(data)
+    loader = gluon.data.DataLoader(dataset, batch_size, num_workers=num_workers,
+                                   try_nopython=True)
+    for _ in range(2):
+        batches = [batch.asnumpy() for batch in loader]
+        assert [len(b) for b in batches[:-1]] == [batch_size] * (len(batches) - 1)
+        assert len(batches[-1]) == 23 - batch_size * (len(batches) - 1)
+        assert np.all(np.concatenate(batches) == data)
+
 def _dataset_transform_fn(x, y):
     """Named transform function since lambda function cannot be pickled."""
     return x, y
@@ -136,6 +266,24 @@ def test_sampler():
     rand_batch_keep = gluon.data.BatchSampler(rand_sampler, 3, 'keep')
     assert sorted(sum(list(rand_batch_keep), [])) == list(range(10))
 
+@with_seed()
+def test_bucket_sampler():
+    lengths = [1, 5, 2, 6, 1]
+    sampler = gluon.data.BucketSampler(lengths, max_tokens=6, num_buckets=2, shuffle=False)
+    assert list(sampler) == [[0, 4], [2], [1], [3]]
+    assert len(sampler) == 4
+    lengths = np.random.randint(1, 50, size=(1000,))
+    sampler = gluon.data.BucketSampler(lengths, max_tokens=200, batch_size=16)
+    for _ in range(2):
+        batches = list(sampler)
+        assert sorted(sum(batches, [])) == list(range(1000))
+        for batch in batches:
+            assert len(batch) <= 16
+            assert len(batch) == 1 or len(batch) * lengths[batch].max() <= 200
+    dataset = gluon.data.SimpleDataset(np.arange(1000, dtype=np.float32))
+    loader = gluon.data.DataLoader(dataset, batch_sampler=sampler, try_nopython=True)
+    assert sorted(np.concatenate([x.asnumpy() for x in loader]).tolist()) == list(range(1000))
+
 @with_seed()
 def test_datasets(tmpdir):
     p = tmpdir.mkdir("test_datasets")
@@ -364,6 +512,28 @@ def test_multi_worker_dataloader_release_pool():
         del the_iter
         del D
 
+@pytest.mark.skipif(platform.system() != 'Linux', reason='pooled shared memory is Linux only')
+def test_multi_worker_pooled_shared_mem():
+    # the storage manager reads the pool type once, hence the separate process
+    import subprocess
+    import sys
+    script = """
+import mxnet as mx
+class D(mx.gluon.data.Dataset):
+    def __len__(self):
+        return 200
+    def __getitem__(self, key):
+        return mx.nd.full((key % 7 + 1, 10), key)
+loader = mx.gluon.data.DataLoader(D(), batch_size=1, num_workers=3)
+for epoch in range(2):
+    for i, batch in enumerate(loader):
+        assert batch.shape == (1, i % 7 + 1, 10)
+        assert (batch.asnumpy() == i).all()
+"""
+    env = dict(os.environ, MXNET_CPU_SHARED_MEM_POOL_TYPE='Pooled',
+               MXNET_CPU_SHARED_MEM_POOL_SEGMENT_SIZE=str(1 << 16))
+    subprocess.check_call([sys.executable, '-c', script], env=env)
+
 @with_seed()
 def test_dataloader_context():
     X = np.random.uniform(size=(10, 20))
@@ -568,6 +738,17 @@ def test_mx_data_loader_nopython():
     for _ in dl1:
         pass
 
+@pytest.mark.parametrize('prefetch', [1, 3])
+def test_mx_data_loader_nopython_prefetch(prefetch):
+    data = np.arange(60, dtype=np.float32).reshape(20, 3)
+    dataset = gluon.data.SimpleDataset(data)
+    loader = gluon.data.DataLoader(dataset, 4, num_workers=2, prefetch=prefetch,
+                                   try_nopython=True)
+    for _ in range(2):
+        batches = [batch.asnumpy() for batch in loader]
+        assert len(batches) == 5
+        assert np.all(np.concatenate(batches) == data)
+
 def test_batchify_stack():
     a = np.array([[1, 2, 3, 4], [5, 6, 7, 8]])
     b = np.array([[5, 6, 7, 8], [1, 2, 3, 4]])
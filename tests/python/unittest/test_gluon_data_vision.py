@@ -131,6 +131,36 @@ def test_resize():
         _test_resize_with_diff_type(dtype)
 
 
+@with_seed()
+def test_batch_resize_normalize():
+    def bilinear(img, out_h, out_w):
+        in_h, in_w = img.shape[:2]
+        ys = np.maximum((np.arange(out_h) + 0.5) * in_h / out_h - 0.5, 0)
+        xs = np.maximum((np.arange(out_w) + 0.5) * in_w / out_w - 0.5, 0)
+        y0, x0 = ys.astype(int), xs.astype(int)
+        y1, x1 = np.minimum(y0 + 1, in_h - 1), np.minimum(x0 + 1, in_w - 1)
+        ly, lx = (ys - y0)[:, None, None], (xs - x0)[None, :, None]
+        img = img.astype(np.float64)
+        top = img[y0][:, x0] * (1 - lx) + img[y0][:, x1] * lx
+        bottom = img[y1][:, x0] * (1 - lx) + img[y1][:, x1] * lx
+        return top * (1 - ly) + bottom * ly
+
+    mean, std = (0.485, 0.456, 0.406), (0.229, 0.224, 0.225)
+    images = [np.random.randint(0, 256, (h, w, 3)).astype('uint8')
+              for h, w in [(30, 20), (7, 41), (16, 16), (1, 5)]]
+    data = nd.array(np.concatenate([img.reshape(-1) for img in images]), dtype='uint8')
+    offsets = nd.array(np.cumsum([0] + [img.size for img in images[:-1]]), dtype='int64')
+    shapes = nd.array([img.shape[:2] for img in images], dtype='int64')
+    for dtype, tol in [('float32', 1e-4), ('float16', 1e-2)]:
+        out = nd.image.batch_resize_normalize(data, offsets, shapes, size=(12, 10),
+                                              mean=mean, std=std, dtype=dtype)
+        assert out.shape == (len(images), 3, 10, 12)
+        assert out.dtype == np.dtype(dtype)
+        for img, res in zip(images, out.asnumpy()):
+            expected = (bilinear(img, 10, 12) / 255 - np.array(mean)) / np.array(std)
+            assert_almost_equal(res, expected.transpose(2, 0, 1), rtol=tol, atol=tol)
+
+
 @with_seed()
 def test_crop_resize():
     def _test_crop_resize_with_diff_type(dtype):
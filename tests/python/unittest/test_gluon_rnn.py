@@ -912,3 +912,53 @@ def test_bidirectional_unroll_valid_length():
 
     _check_bidirectional_unroll_valid_length(1)
     _check_bidirectional_unroll_valid_length(3)
+
+
+@with_seed()
+@pytest.mark.parametrize('layer_type', ['lstm', 'gru', 'rnn_tanh'])
+@pytest.mark.parametrize('bidirectional', [False, True])
+def test_rnn_layer_sequence_length(layer_type, bidirectional):
+    layers = {'lstm': gluon.rnn.LSTM, 'gru': gluon.rnn.GRU,
+              'rnn_tanh': partial(gluon.rnn.RNN, activation='tanh')}
+    hidden_size, input_size, num_layers = 8, 5, 2
+    num_timesteps, batch_size = 7, 6
+    net = layers[layer_type](hidden_size, num_layers, bidirectional=bidirectional,
+                             input_size=input_size, use_sequence_length=True)
+    ref_net = layers[layer_type](hidden_size, num_layers, bidirectional=bidirectional,
+                                 input_size=input_size)
+    net.initialize()
+    ref_net.share_parameters(net.collect_params())
+
+    data = mx.nd.random.uniform(shape=(num_timesteps, batch_size, input_size))
+    sequence_length = mx.nd.array([7, 3, 1, 7, 3, 5], dtype='int32')
+    lengths = sequence_length.asnumpy().astype('int32')
+    states = net.begin_state(batch_size)
+    for s in states:
+        s[:] = mx.nd.random.uniform(shape=s.shape)
+    data.attach_grad()
+    with mx.autograd.record():
+        out, out_states = net(data, states, sequence_length=sequence_length)
+        loss = (out * out).sum()
+    loss.backward()
+    grads = {k: p.grad().copy() for k, p in net.collect_params().items()}
+    dx = data.grad.asnumpy()
+
+    # the reference runs each sequence on its own, accumulating the gradients
+    for p in ref_net.collect_params().values():
+        p.grad_req = 'add'
+        p.zero_grad()
+    for b, length in enumerate(lengths):
+        data_b = data[:length, b:b+1].copy()
+        data_b.attach_grad()
+        with mx.autograd.record():
+            out_b, states_b = ref_net(data_b, [s[:, b:b+1] for s in states])
+            loss_b = (out_b * out_b).sum()
+        loss_b.backward()
+        assert_almost_equal(out[:length, b:b+1], out_b, rtol=1e-4, atol=1e-5)
+        assert_allclose(out[length:, b].asnumpy(), 0)
+        for s, s_b in zip(out_states, states_b):
+            assert_almost_equal(s[:, b:b+1], s_b, rtol=1e-4, atol=1e-5)
+        assert_almost_equal(dx[:length, b:b+1], data_b.grad, rtol=1e-4, atol=1e-5)
+        assert_allclose(dx[length:, b], 0)
+    for k, p in ref_net.collect_params().items():
+        assert_almost_equal(grads[k], p.grad(), rtol=1e-4, atol=1e-4)
@@ -399,3 +399,72 @@ def test_trainer_share_parameters():
 
     assert((shared_params[0] == shared_params[1]).all())
 
+
+@with_seed()
+def test_trainer_overlap_backward():
+    def run(overlap, extra_backward):
+        ctxs = [mx.cpu(0), mx.cpu(1)]
+        x = gluon.Parameter('x', shape=(10,))
+        x.initialize(ctx=ctxs, init='ones')
+        z = gluon.Parameter('z', shape=(10,), grad_req='add')
+        z.initialize(ctx=ctxs, init='ones')
+        trainer = gluon.Trainer([x, z], 'sgd', {'learning_rate': 1.0}, kvstore='device',
+                                update_on_kvstore=False, overlap_backward=overlap)
+        for _ in range(2):
+            with mx.autograd.record():
+                ys = [(i + 1) * w * u for i, (w, u) in
+                      enumerate(zip(x.list_data(), z.list_data()))]
+            mx.autograd.backward(ys)
+            if extra_backward:
+                # a backward not writing the gradient of x does not reduce it again
+                other = mx.nd.ones((10,))
+                other.attach_grad()
+                with mx.autograd.record():
+                    y = other * 2
+                y.backward()
+            trainer.step(1)
+            z.zero_grad()
+        return x.data(mx.cpu(1)).asnumpy(), z.data(mx.cpu(1)).asnumpy()
+
+    expected = run(False, False)
+    for extra_backward in [False, True]:
+        result = run(True, extra_backward)
+        assert_almost_equal(result[0], expected[0])
+        assert_almost_equal(result[1], expected[1])
+
+
+@with_seed()
+def test_trainer_shard_optimizer_states():
+    def run(shard):
+        ctxs = [mx.cpu(0), mx.cpu(1)]
+        params = []
+        for i, shape in enumerate([(10, 4), (6,), (3, 3)]):
+            p = gluon.Parameter('p%d' % i, shape=shape)
+            p.initialize(ctx=ctxs, init='ones')
+            params.append(p)
+        trainer = gluon.Trainer(params, 'adam', {'learning_rate': 0.1}, kvstore='device',
+                                shard_optimizer_states=shard)
+        for _ in range(3):
+            with mx.autograd.record():
+                ys = [((i + 1) * w * w).sum() for p in params
+                      for i, w in enumerate(p.list_data())]
+            mx.autograd.backward(ys)
+            trainer.step(1)
+        return trainer, params
+
+    _, expected = run(False)
+    trainer, params = run(True)
+    for p, e in zip(params, expected):
+        for arr in p.list_data():
+            assert_almost_equal(arr, e.data(mx.cpu(0)), rtol=1e-5, atol=1e-6)
+    # each Parameter has optimizer states on its owner only
+    owners = trainer._shard_owners()
+    assert owners[0] != owners[1] and owners[1] == owners[2]
+    for dev, updater in enumerate(trainer._updaters):
+        assert sorted(updater.states.keys()) == [i for i, o in enumerate(owners) if o == dev]
+
+    trainer.save_states('test_trainer_shard_optimizer_states.states')
+    trainer.load_states('test_trainer_shard_optimizer_states.states')
+    for dev, updater in enumerate(trainer._updaters):
+        assert sorted(updater.states.keys()) == [i for i, o in enumerate(owners) if o == dev]
+    os.remove('test_trainer_shard_optimizer_states.states')
@@ -409,6 +409,106 @@ def test_LibSVMIter(tmpdir):
     assertRaises(MXNetError, check_libSVMIter_exception)
 
 
+def test_LibSVMIter_fast_parse(tmpdir):
+    data_path = os.path.join(str(tmpdir), 'data.t')
+    label_path = os.path.join(str(tmpdir), 'label.t')
+    num_rows, num_cols = 1000, 50
+    rng = np.random.RandomState(0)
+    with open(data_path, 'w') as fdata, open(label_path, 'w') as flabel:
+        for i in range(num_rows):
+            cols = np.sort(rng.choice(num_cols, rng.randint(0, 8), replace=False))
+            feats = ' '.join('%d:%g' % (c, rng.uniform(-10, 10)) for c in cols)
+            fdata.write('%d %s\n' % (i, feats))
+            flabel.write('%d %d:%g\n' % (i, i % num_cols, rng.uniform()))
+
+    for label_libsvm, label_shape in [('NULL', (1,)), (label_path, (num_cols,))]:
+        def make_iter(fast_parse):
+            return mx.io.LibSVMIter(data_libsvm=data_path, data_shape=(num_cols,),
+                                    label_libsvm=label_libsvm, label_shape=label_shape,
+                                    batch_size=33, fast_parse=fast_parse, parse_threads=3)
+        default_iter, fast_iter = make_iter(False), make_iter(True)
+        for epoch in range(2):
+            num_batches = 0
+            for expected, batch in zip(default_iter, fast_iter):
+                batch.data[0].check_format(True)
+                assert batch.pad == expected.pad
+                assert_almost_equal(batch.data[0].asnumpy(), expected.data[0].asnumpy())
+                assert_almost_equal(batch.label[0].asnumpy(), expected.label[0].asnumpy())
+                assert_almost_equal(batch.index, expected.index)
+                num_batches += 1
+            # the second epoch starts after the rows padding the last batch of the first one
+            assert num_batches == (num_rows // 33 + 1 if epoch == 0 else (num_rows - 23) // 33 + 1)
+            default_iter.reset()
+            fast_iter.reset()
+
+
+def test_CSVIter_fast_parse(tmpdir):
+    data_path = os.path.join(str(tmpdir), 'data.csv')
+    label_path = os.path.join(str(tmpdir), 'label.csv')
+    num_rows = 250
+    data = np.arange(num_rows * 6).reshape((num_rows, 6)) - 100
+    np.savetxt(data_path, data, delimiter=',', fmt='%d')
+    np.savetxt(label_path, data[:, 0], fmt='%d')
+    for dtype in ['int32', 'int64', 'float32']:
+        for round_batch in [True, False]:
+            data_iter = mx.io.CSVIter(data_csv=data_path, data_shape=(2, 3),
+                                      label_csv=label_path, batch_size=40, dtype=dtype,
+                                      round_batch=round_batch, fast_parse=True, parse_threads=2)
+            begin = 0
+            for batch in data_iter:
+                rows = np.arange(begin, begin + 40) % num_rows
+                num_valid = 40 - batch.pad if not round_batch else 40
+                assert batch.data[0].dtype == np.dtype(dtype)
+                assert_almost_equal(batch.data[0].asnumpy()[:num_valid],
+                                    data[rows].reshape((40, 2, 3))[:num_valid])
+                assert_almost_equal(batch.label[0].asnumpy()[:num_valid].flatten(),
+                                    data[rows, 0][:num_valid])
+                begin += 40
+            assert begin == 280
+
+
+def test_ColumnarIter(tmpdir):
+    path = os.path.join(str(tmpdir), 'data.col')
+    num_rows = 70
+    a = np.random.uniform(size=(num_rows, 3)).astype(np.float32)
+    b = np.random.uniform(size=(num_rows,)).astype(np.float32)
+    y = np.arange(num_rows, dtype=np.float32)
+    s = np.random.uniform(size=(num_rows, 9)).astype(np.float32)
+    s[s < 0.7] = 0
+    mx.gluon.data.ColumnarDataset.write(
+        path, [('a', a), ('b', b), ('y', y), ('s', mx.nd.array(s).tostype('csr'))],
+        row_group_size=16)
+
+    # the dense data columns are concatenated
+    dense = np.concatenate([a, b[:, None]], axis=1)
+    for round_batch in [True, False]:
+        data_iter = mx.io.ColumnarIter(file=path, data_columns='a,b', label_columns='y',
+                                       batch_size=20, round_batch=round_batch)
+        begin = 0
+        for batch in data_iter:
+            rows = np.arange(begin, begin + 20) % num_rows
+            num_valid = 20 if round_batch else 20 - batch.pad
+            assert batch.data[0].shape == (20, 4)
+            assert_almost_equal(batch.data[0].asnumpy()[:num_valid], dense[rows][:num_valid])
+            assert_almost_equal(batch.label[0].asnumpy()[:num_valid], y[rows][:num_valid])
+            begin += 20
+        assert begin == 80
+
+    # a csr data column, with the parts of two workers
+    labels = []
+    for part_index in range(2):
+        data_iter = mx.io.ColumnarIter(file=path, data_columns='s', label_columns='y',
+                                       batch_size=5, num_parts=2, part_index=part_index)
+        for batch in data_iter:
+            data = batch.data[0]
+            assert data.stype == 'csr'
+            data.check_format(True)
+            rows = batch.label[0].asnumpy().astype(np.int64)
+            assert_almost_equal(data.asnumpy(), s[rows])
+            labels.extend(rows.tolist())
+    assert labels == list(range(num_rows))
+
+
 def test_DataBatch():
     from mxnet.io import DataBatch
     import re
@@ -572,3 +672,96 @@ def test_ImageRecordIter_seed_augmentation(cifar10):
         seed_aug=seed_aug)
 
     assert_dataiter_items_equals(dataiter1, dataiter2)
+
+def _write_smooth_rec(path, num_images, size):
+    cv2 = pytest.importorskip('cv2')
+    rng = np.random.RandomState(1)
+    record = mx.recordio.MXRecordIO(path, 'w')
+    for i in range(num_images):
+        # smooth images, so that different resampling paths barely change them
+        img = cv2.resize(rng.randint(0, 256, (6, 8, 3)).astype(np.uint8), size)
+        header = mx.recordio.IRHeader(0, float(i), i, 0)
+        record.write(mx.recordio.pack_img(header, img, quality=95))
+    record.close()
+
+def test_ImageRecordIter_scaled_decode(tmpdir):
+    path = os.path.join(str(tmpdir), 'large.rec')
+    _write_smooth_rec(path, 4, (512, 384))
+
+    def read(scaled_decode):
+        it = mx.io.ImageRecordIter(path_imgrec=path, data_shape=(3, 56, 56), resize=64,
+                                   batch_size=4, shuffle=False, dtype='uint8',
+                                   scaled_decode=scaled_decode)
+        return next(iter(it)).data[0].asnumpy().astype(np.float32)
+
+    full, scaled = read(False), read(True)
+    assert full.shape == scaled.shape == (4, 3, 56, 56)
+    assert np.abs(full - scaled).mean() < 4
+
+@pytest.mark.parametrize('dtype', ['float32', 'uint8', 'int8'])
+@pytest.mark.parametrize('augment', [dict(resize=40),
+                                     dict(random_resized_crop=True, min_random_area=0.5),
+                                     dict(max_crop_size=36, min_crop_size=36)])
+def test_ImageRecordIter_fused_augment(tmpdir, dtype, augment):
+    path = os.path.join(str(tmpdir), 'data.rec')
+    _write_smooth_rec(path, 8, (64, 48))
+
+    def read(fused_augment):
+        it = mx.io.ImageRecordIter(path_imgrec=path, data_shape=(3, 32, 32), batch_size=8,
+                                   shuffle=False, dtype=dtype, mirror=True, seed_aug=7,
+                                   mean_r=123.68, mean_g=116.28, mean_b=103.53,
+                                   std_r=58.395, std_g=57.12, std_b=57.375,
+                                   fused_augment=fused_augment, **augment)
+        batch = next(iter(it))
+        return batch.data[0].asnumpy().astype(np.float32), batch.label[0].asnumpy()
+
+    (data, label), (expected_data, expected_label) = read(True), read(False)
+    assert data.shape == expected_data.shape == (8, 3, 32, 32)
+    np.testing.assert_allclose(label, expected_label)
+    scale = 1. / 57 if dtype == 'float32' else 1.
+    assert np.abs(data - expected_data).mean() < 2 * scale
+
+def test_ImageRecordIter_shuffle_buffer(tmpdir):
+    path = os.path.join(str(tmpdir), 'data.rec')
+    _write_smooth_rec(path, 64, (16, 16))
+
+    def read(num_parts=1, part_index=0, seed=0, epochs=1):
+        it = mx.io.ImageRecordIter(path_imgrec=path, data_shape=(3, 16, 16), batch_size=8,
+                                   shuffle=True, shuffle_buffer_size=16,
+                                   shuffle_buffer_streams=3, seed=seed, round_batch=False,
+                                   num_parts=num_parts, part_index=part_index)
+        orders = []
+        for _ in range(epochs):
+            it.reset()
+            orders.append([int(l) for batch in it
+                           for l in batch.label[0].asnumpy()[:8 - batch.pad]])
+        return orders
+
+    first, second = read(epochs=2)
+    assert sorted(first) == sorted(second) == list(range(64))
+    assert first != list(range(64)) and first != second
+    assert read(epochs=2) == [first, second]
+    assert read(seed=1)[0] != first
+    parts = [read(num_parts=2, part_index=i)[0] for i in range(2)]
+    assert sorted(parts[0] + parts[1]) == list(range(64))
+
+@pytest.mark.parametrize('cache', [dict(decoded_cache_size=16),
+                                   dict(decoded_cache_file_size=16)])
+def test_ImageRecordIter_decoded_cache(tmpdir, cache):
+    path = os.path.join(str(tmpdir), 'data.rec')
+    _write_smooth_rec(path, 16, (40, 32))
+
+    def read(**kwargs):
+        it = mx.io.ImageRecordIter(path_imgrec=path, data_shape=(3, 24, 24), batch_size=8,
+                                   rand_crop=True, rand_mirror=True, seed_aug=3, **kwargs)
+        epochs = []
+        for _ in range(2):
+            it.reset()
+            epochs.append([batch.data[0].asnumpy() for batch in it])
+        return epochs
+
+    expected = read()
+    cached = read(decoded_cache_file=os.path.join(str(tmpdir), 'cache.bin'), **cache)
+    for expected_batches, batches in zip(expected, cached):
+        for expected_batch, batch in zip(expected_batches, batches):
+            np.testing.assert_array_equal(batch, expected_batch)
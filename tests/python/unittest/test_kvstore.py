@@ -95,6 +95,22 @@ def test_row_sparse_pull():
     check_row_sparse_pull(kv, 1)
     check_row_sparse_pull(kv, 4)
 
+@with_seed()
+def test_row_sparse_pull_reuses_retained_rows():
+    kv = init_kv_with_str('row_sparse')
+    init = mx.nd.random.uniform(shape=shape)
+    kv.init('e', init.tostype('row_sparse'))
+    num_rows = shape[0]
+    # the output is on another context, the retained rows are staged on the context of
+    # the stored value and the staging array is reused by the pulls
+    for num_ids in [num_rows, 1, num_rows // 2, num_rows]:
+        out = mx.nd.zeros(shape, ctx=mx.cpu(1)).tostype('row_sparse')
+        row_id = np.sort(np.random.choice(num_rows, size=num_ids, replace=False))
+        kv.row_sparse_pull('e', out=out, row_ids=mx.nd.array(row_id))
+        expected = np.zeros(shape)
+        expected[row_id] = init.asnumpy()[row_id]
+        assert_almost_equal(out.asnumpy(), expected)
+
 @with_seed()
 def test_init():
     """test init"""
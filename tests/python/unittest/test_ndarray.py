@@ -20,6 +20,8 @@ import numpy as np
 from distutils.version import LooseVersion
 from itertools import permutations, combinations_with_replacement
 import os
+import ctypes
+import threading
 import pickle as pkl
 import random
 import functools
@@ -429,6 +431,153 @@ def test_ndarray_legacy_load():
         assert same(data[i].asnumpy(), legacy_data[i].asnumpy())
 
 
+@with_seed()
+def test_ndarray_save_load_mapped():
+    with TemporaryDirectory(prefix='test_ndarray_save_load_mapped_') as tmpdir:
+        fname = os.path.join(tmpdir, 'mapped.params')
+        dmap = {'w%d' % i: random_ndarray(np.random.randint(1, 5)) for i in range(6)}
+        dmap['half'] = mx.nd.ones((3, 7), dtype='float16')
+        mx.nd.save(fname, dmap, mapped=True)
+        # the data of each array starts on a page
+        assert os.path.getsize(fname) % 4096 == 0
+        dmap2 = mx.nd.load(fname)
+        assert sorted(dmap2.keys()) == sorted(dmap.keys())
+        for k, x in dmap.items():
+            assert dmap2[k].dtype == x.dtype
+            assert same(dmap2[k].asnumpy(), x.asnumpy())
+
+        # only the arrays asked for are loaded
+        subset = mx.nd.load(fname, keys=['w3', 'half'])
+        assert sorted(subset.keys()) == ['half', 'w3']
+        assert same(subset['w3'].asnumpy(), dmap['w3'].asnumpy())
+        assertRaises(mx.base.MXNetError, mx.nd.load, fname, keys=['missing'])
+
+        # writing to a loaded array leaves the file unchanged
+        subset['w3'][:] = 0
+        assert same(mx.nd.load(fname, keys=['w3'])['w3'].asnumpy(), dmap['w3'].asnumpy())
+
+        # the buffer loader reads the mapped format
+        with open(fname, 'rb') as f:
+            buffered = mx.nd.load_frombuffer(f.read())
+        for k, x in dmap.items():
+            assert same(buffered[k].asnumpy(), x.asnumpy())
+
+        data = [dmap['w0'], dmap['w1']]
+        mx.nd.save(fname, data, mapped=True)
+        data2 = mx.nd.load(fname)
+        assert len(data2) == 2
+        for x, y in zip(data, data2):
+            assert same(x.asnumpy(), y.asnumpy())
+        # keys needs names in the file, also with the default format
+        assertRaises(mx.base.MXNetError, mx.nd.load, fname, keys=['w0'])
+        mx.nd.save(fname, dmap)
+        assert same(mx.nd.load(fname, keys=['w2'])['w2'].asnumpy(), dmap['w2'].asnumpy())
+        assertRaises(mx.base.MXNetError, mx.nd.save, fname,
+                      [mx.nd.zeros((2, 2)).tostype('csr')], mapped=True)
+
+
+@with_seed()
+def test_ndarray_save_load_sharded():
+    with TemporaryDirectory(prefix='test_ndarray_save_load_sharded_') as tmpdir:
+        prefix = os.path.join(tmpdir, 'ckpt')
+        dmap = {'w%d' % i: random_ndarray(np.random.randint(1, 5)) for i in range(7)}
+        dmap['sparse'] = mx.nd.sparse.row_sparse_array(
+            (np.ones((2, 3)), [1, 4]), shape=(6, 3))
+        expected = {k: v.asnumpy() for k, v in dmap.items()}
+        mx.nd.save_sharded(prefix, dmap, num_shards=3)
+        # the checkpoint holds the values the arrays had when it was saved
+        for i in range(7):
+            dmap['w%d' % i] *= 2
+        mx.nd.wait_for_checkpoint()
+        for shard in range(3):
+            assert os.path.isfile('%s-%05d-of-00003.params' % (prefix, shard))
+        assert not any(name.endswith('.tmp') for name in os.listdir(tmpdir))
+        loaded = mx.nd.load_sharded(prefix)
+        assert sorted(loaded.keys()) == sorted(dmap.keys())
+        assert loaded['sparse'].stype == 'row_sparse'
+        for k, x in expected.items():
+            assert same(loaded[k].asnumpy(), x)
+        assert_almost_equal(mx.nd.load_sharded(prefix, num_shards=3)['w0'], expected['w0'])
+
+        # more shards than arrays leaves some of them empty
+        mx.nd.save_sharded(prefix, {'w0': dmap['w0']}, num_shards=2)
+        mx.nd.wait_for_checkpoint()
+        assert same(mx.nd.load_sharded(prefix, 2)['w0'].asnumpy(), dmap['w0'].asnumpy())
+        assertRaises(TypeError, mx.nd.save_sharded, prefix, [dmap['w0']])
+        assertRaises(mx.base.MXNetError, mx.nd.load_sharded, prefix, 4)
+
+
+@with_seed()
+def test_ndarray_copy_to_cpu_async():
+    from mxnet.base import _LIB, check_call
+    x = mx.nd.random.uniform(shape=(64, 32))
+    y = x * 2 + 1
+    out = np.empty(y.shape, dtype=np.float32)
+    event = ctypes.c_void_p()
+    check_call(_LIB.MXNDArrayCopyToCPUAsync(y.handle, out.ctypes.data_as(ctypes.c_void_p),
+                                            ctypes.c_size_t(out.size), ctypes.byref(event)))
+    check_call(_LIB.MXNDArrayCopyEventWait(event))
+    done = ctypes.c_int()
+    check_call(_LIB.MXNDArrayCopyEventPoll(event, ctypes.byref(done)))
+    assert done.value == 1
+    check_call(_LIB.MXNDArrayCopyEventFree(event))
+    assert_almost_equal(out, x.asnumpy() * 2 + 1)
+
+    # the callback runs on an engine thread once the copy is done
+    statuses = []
+    finished = threading.Event()
+    @ctypes.CFUNCTYPE(None, ctypes.c_int, ctypes.c_void_p)
+    def callback(status, arg):
+        statuses.append(status)
+        finished.set()
+    out2 = np.empty(y.shape, dtype=np.float32)
+    check_call(_LIB.MXNDArrayCopyToCPUAsyncCallback(
+        y.handle, out2.ctypes.data_as(ctypes.c_void_p), ctypes.c_size_t(out2.size),
+        callback, None))
+    assert finished.wait(60)
+    assert statuses == [0]
+    assert_almost_equal(out2, out)
+
+    # a mismatching size fails at once
+    assert _LIB.MXNDArrayCopyToCPUAsync(y.handle, out.ctypes.data_as(ctypes.c_void_p),
+                                        ctypes.c_size_t(3), ctypes.byref(event)) == -1
+
+
+@with_seed()
+def test_imperative_infer_cache():
+    # repeated calls reuse the inferred shapes, calls with other shapes or attributes do not
+    for shape in [(2, 3), (4, 5), (2, 3)]:
+        x = mx.nd.random.uniform(shape=shape)
+        for axis in [0, 1, 0]:
+            y = mx.nd.sum(x, axis=axis)
+            assert y.shape == (shape[1 - axis],)
+            assert_almost_equal(y, x.asnumpy().sum(axis=axis), rtol=1e-5, atol=1e-5)
+        z = mx.nd.cast(x, dtype='float16')
+        assert z.dtype == np.float16
+        z = mx.nd.cast(x, dtype='int32')
+        assert z.dtype == np.int32
+    x = mx.nd.ones((2, 3))
+    out = mx.nd.empty((3,))
+    mx.nd.sum(x, axis=0, out=out)
+    assert_almost_equal(out, np.full((3,), 2))
+    # an output of another shape is still rejected after the cache hit
+    mx.nd.sum(x, axis=0)
+    assertRaises(mx.base.MXNetError, mx.nd.sum, x, axis=0, out=mx.nd.empty((2,)))
+
+    # the numpy FFI leaves the attribute dict empty outside autograd.record()
+    @mx.util.use_np
+    def check_np():
+        for shape in [(2, 3), (4, 5), (2, 3)]:
+            z = mx.np.zeros(shape)
+            assert z.shape == shape
+            x = mx.np.random.uniform(size=shape)
+            for axis in [0, 1, 0]:
+                y = mx.np.sum(x, axis=axis)
+                assert y.shape == (shape[1 - axis],)
+                assert_almost_equal(y, x.asnumpy().sum(axis=axis), rtol=1e-5, atol=1e-5)
+    check_np()
+
+
 @with_seed()
 def test_buffer_load():
     nrepeat = 10
@@ -674,6 +823,24 @@ def test_reduce():
                       mx.nd.argmin, False, check_dtype=False)
 
 
+@with_seed()
+def test_reduce_to_few_outputs():
+    # reductions of many elements to fewer outputs than threads, split over the threads
+    for shape, axis in [((1000003,), None), ((3, 40001), 1), ((5000, 3), 0),
+                        ((64, 2, 1000), (0, 2)), ((7, 3000, 2), (0, 1))]:
+        dat = np.random.uniform(-1, 1, size=shape).astype(np.float32)
+        arr = mx.nd.array(dat)
+        assert_almost_equal(mx.nd.sum(arr, axis=axis), np.sum(dat.astype(np.float64), axis=axis),
+                            rtol=1e-4, atol=1e-3)
+        assert_almost_equal(mx.nd.mean(arr, axis=axis), np.mean(dat.astype(np.float64), axis=axis),
+                            rtol=1e-4, atol=1e-6)
+        assert_almost_equal(mx.nd.max(arr, axis=axis), np.max(dat, axis=axis))
+        assert_almost_equal(mx.nd.min(arr, axis=axis), np.min(dat, axis=axis))
+        assert_almost_equal(mx.nd.norm(arr, axis=axis),
+                            np.sqrt(np.sum(np.square(dat.astype(np.float64)), axis=axis)),
+                            rtol=1e-4, atol=1e-4)
+
+
 @with_seed()
 @pytest.mark.serial
 def test_broadcast():
@@ -1830,6 +1997,55 @@ def test_dlpack():
             assert_almost_equal(a_np, d)
             assert_almost_equal(a_np, e)
 
+@with_seed()
+def test_dlpack_protocol():
+    ctx = mx.context.current_context()
+    a = mx.nd.random.uniform(shape=(4, 5), ctx=ctx) * 2
+    device_type = 2 if ctx.device_type == 'gpu' else 1
+    assert a.__dlpack_device__() == (device_type, ctx.device_id)
+    # from_dlpack takes arrays with __dlpack__, the pending writes are waited for
+    b = mx.nd.from_dlpack(a)
+    assert_almost_equal(b, a)
+    c = mx.npx.from_dlpack(mx.np.array(a.asnumpy(), ctx=ctx) + 1)
+    assert isinstance(c, mx.np.ndarray)
+    assert_almost_equal(c, a.asnumpy() + 1)
+    # the capsule is a view of the array
+    d = mx.nd.from_dlpack(a.__dlpack__(stream=1 if ctx.device_type == 'gpu' else None))
+    a += 1
+    assert_almost_equal(d, a)
+    if ctx.device_type == 'gpu':
+        assert_almost_equal(mx.nd.from_dlpack(a.__dlpack__(stream=2)), a)
+        assertRaises(ValueError, a.__dlpack__, stream=0)
+    else:
+        assertRaises(ValueError, a.__dlpack__, stream=1)
+
+
+def test_ndarray_from_buffer():
+    from mxnet.base import _LIB, check_call, NDArrayHandle
+    buf = np.arange(12, dtype=np.float32).reshape(3, 4)
+    released = []
+    deleter_type = ctypes.CFUNCTYPE(None, ctypes.c_void_p)
+    deleter = deleter_type(lambda param: released.append(param))
+    var = ctypes.c_void_p()
+    check_call(_LIB.MXEngineNewVar(ctypes.byref(var)))
+    handle = NDArrayHandle()
+    shape = (ctypes.c_int64 * 2)(3, 4)
+    check_call(_LIB.MXNDArrayCreateFromBuffer(
+        buf.ctypes.data_as(ctypes.c_void_p), shape, 2, 0, 1, 0, var, deleter,
+        ctypes.c_void_p(7), ctypes.byref(handle)))
+    a = mx.nd.NDArray(handle)
+    assert_array_equal(a.asnumpy(), buf)
+    # the array is a view of the buffer, both ways
+    a[:] = a * 2
+    mx.nd.waitall()
+    assert_array_equal(buf, np.arange(12, dtype=np.float32).reshape(3, 4) * 2)
+    buf[0, 0] = -1
+    assert a.asnumpy()[0, 0] == -1
+    del a
+    mx.nd.waitall()
+    assert released == [7]
+    check_call(_LIB.MXEngineDeleteVar(var))
+
 @with_seed()
 def test_ndarray_is_inf():
     random_dimensions = np.random.randint(2, 5)
@@ -2076,3 +2292,24 @@ def test_load_saved_gpu_array_when_no_gpus_are_present():
     # but there are no GPUs
     array.__setstate__(ndarray_state)
 
+
+
+@pytest.mark.skipif(os.environ.get('MXNET_CPU_MEM_POOL_TYPE', 'Naive') not in ('Naive', 'Round', 'BestFit'),
+                    reason='the CPU memory pool keeps no statistics')
+def test_memory_stats():
+    ctx = mx.cpu()
+    a = mx.nd.ones((1024, 1024), ctx=ctx)
+    a.wait_to_read()
+    stats = ctx.memory_stats()
+    assert stats['bytes_in_use'] >= a.size * 4
+    assert stats['peak_bytes_in_use'] >= stats['bytes_in_use']
+    assert stats['num_allocs'] >= stats['num_pool_hits']
+    del a
+    mx.nd.waitall()
+    stats = ctx.memory_stats()
+    assert stats['bytes_cached'] >= 1024 * 1024 * 4
+    assert stats['largest_free_chunk'] >= 1024 * 1024 * 4
+    assert sum(size * count for size, count in stats['free_chunks']) == stats['bytes_cached']
+    assert 0 <= stats['fragmentation'] < 1
+    ctx.empty_cache()
+    assert ctx.memory_stats()['bytes_cached'] == 0
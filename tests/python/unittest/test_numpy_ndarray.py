@@ -1421,3 +1421,30 @@ def test_mixed_array_types_share_memory():
     mx_pinned_array = mx_array.as_in_ctx(mx.cpu_pinned(0))
     assert not _np.may_share_memory(np_array, mx_pinned_array)
     assert not _np.shares_memory(np_array, mx_pinned_array)
+
+@use_np
+def test_ffi_call_batch():
+    from mxnet.ndarray.numpy import _api_internal
+    from mxnet._ffi.function import call_batch, BatchResult
+    x = np.array([[1, 2], [3, 4]], dtype='float32')
+    out = np.empty((2, 2))
+    y, z, w, parts, first = call_batch([
+        (_api_internal.add, (x, x, None)),
+        (_api_internal.multiply, (BatchResult(0), x, None)),
+        (_api_internal.add, (BatchResult(1), 1.0, out)),
+        (_api_internal.split, (BatchResult(2), 2, 0)),
+        (_api_internal.add, (BatchResult(3, 1), 0.0, None))])
+    expected = (x.asnumpy() * 2) * x.asnumpy() + 1
+    assert_almost_equal(y, x.asnumpy() * 2)
+    assert_almost_equal(z, x.asnumpy() * x.asnumpy() * 2)
+    assert w is out
+    assert_almost_equal(out, expected)
+    assert len(parts) == 2
+    assert_almost_equal(parts[0], expected[:1])
+    assert_almost_equal(first, expected[1:])
+    # a call fails as a single call would, and so does a reference to a later call
+    with pytest.raises(mx.base.MXNetError):
+        call_batch([(_api_internal.add, (x, x, None)),
+                    (_api_internal.add, (x, np.ones((3,)), None))])
+    with pytest.raises(ValueError):
+        call_batch([(_api_internal.add, (BatchResult(0), x, None))])
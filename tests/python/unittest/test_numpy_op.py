@@ -420,7 +420,9 @@ def test_np_outer(a_shape, b_shape, dtype, hybridize):
     ((2, 1, 3, 4, 5), (5, 2)),
     ((1, 3, 5, 4), (1, 4, 3)),
     ((3, 5, 4), (2, 1, 4, 3)),
-    ((3, 4), (1, 5, 4, 3))
+    ((3, 4), (1, 5, 4, 3)),
+    ((2, 4, 3, 5), (2, 1, 5, 3)),
+    ((2, 1, 3, 4), (1, 3, 4, 2))
 ])
 @pytest.mark.parametrize('grad_req_a', ['write', 'add', 'null'])
 @pytest.mark.parametrize('grad_req_b', ['write', 'add', 'null'])
@@ -2510,6 +2512,34 @@ def test_np_transpose_error():
     pytest.raises(MXNetError, lambda: dat.transpose((0, 1, 3)))
 
 
+@use_np
+def test_np_transpose_view():
+    # permutations moving axes of length 1 only share the memory with the input
+    for shape, func in [((2, 1, 3), lambda a: np.transpose(a, (1, 0, 2))),
+                        ((1, 4, 1), lambda a: a.T),
+                        ((2, 1, 3), lambda a: np.swapaxes(a, 0, 1)),
+                        ((3, 1, 1, 4), lambda a: np.moveaxis(a, [1, 2], [-1, 0]))]:
+        x = np.random.uniform(size=shape)
+        x.attach_grad()
+        with mx.autograd.record():
+            y = func(x)
+            loss = (y * np.arange(y.size).reshape(y.shape)).sum()
+        loss.backward()
+        assert_almost_equal(x.grad.asnumpy().ravel(), _np.arange(x.size), use_broadcast=False)
+        y[()] = 7
+        assert (x.asnumpy() == 7).all()
+    # permutations reordering axes longer than 1 are copies
+    x = np.ones((2, 1, 3))
+    y = np.transpose(x, (2, 1, 0))
+    y[()] = 7
+    assert (x.asnumpy() == 1).all()
+    # more than 6 axes once the axes kept together and those of length 1 are merged away
+    x = np.random.uniform(size=(2, 3, 1, 2, 2, 1, 3, 2))
+    axes = (4, 5, 6, 7, 0, 1, 3, 2)
+    assert_almost_equal(np.transpose(x, axes).asnumpy(), _np.transpose(x.asnumpy(), axes),
+                        use_broadcast=False)
+
+
 @with_seed()
 @use_np
 def test_np_meshgrid():
@@ -5323,6 +5353,19 @@ def test_np_cumsum():
                     assert mx_out.shape == np_out.shape
                     assert_almost_equal(mx_out.asnumpy(), np_out, rtol=1e-3, atol=1e-5)
 
+    # long axes with few lanes take the blocked parallel scan on cpu
+    for shape, axis in [((50000,), None), ((1, 30000), 1), ((2, 20000, 3), 1)]:
+        x = np.array(_np.random.randint(-5, 5, size=shape), dtype=_np.float64)
+        x.attach_grad()
+        with mx.autograd.record():
+            mx_out = np.cumsum(x, axis=axis)
+        mx_out.backward()
+        np_out = _np.cumsum(x.asnumpy(), axis=axis)
+        assert_almost_equal(mx_out.asnumpy(), np_out)
+        assert_almost_equal(np.cumsum(x.astype(_np.int64), axis=axis).asnumpy(), np_out)
+        np_backward = np_cumsum_backward(_np.ones(np_out.shape), axis=axis).reshape(shape)
+        assert_almost_equal(x.grad.asnumpy(), np_backward)
+
 
 @with_seed()
 @use_np
@@ -6223,7 +6266,12 @@ def test_np_linalg_solve():
         (0, 1, 1),
         (0, 5, 3, 3),
         (5, 0, 0, 0),
-        (2, 2, 5, 5)
+        (2, 2, 5, 5),
+        # batches of small and moderately sized matrices
+        (64, 3, 3),
+        (8, 8, 4, 4),
+        (16, 12, 12),
+        (2, 40, 40)
     ]
     nrhs = (-1, 0, 1, 2, 3)
     dtypes = ['float32', 'float64']
@@ -7727,6 +7775,32 @@ def test_np_nonzero():
                 assert_almost_equal(mx_out.asnumpy(), np_out, rtol, atol)
 
 
+@with_seed()
+@use_np
+def test_npx_nonzero_padded():
+    class TestNonzeroPadded(HybridBlock):
+        def __init__(self):
+            super(TestNonzeroPadded, self).__init__()
+
+        def hybrid_forward(self, F, x):
+            return F.npx.nonzero_padded(x)
+
+    for hybridize in [True, False]:
+        for shape in [(), (1, 2, 3), (1, 0), (4, 5)]:
+            for dtype in ['int32', 'float32', 'bool']:
+                test_nonzero = TestNonzeroPadded()
+                if hybridize:
+                    test_nonzero.hybridize()
+                x = np.array(_np.random.randint(0, 2, size=shape), dtype=dtype)
+                out, valid_length = test_nonzero(x)
+                np_out = _np.transpose(_np.nonzero(x.asnumpy().reshape(shape or (1,))))
+                n = np_out.shape[0]
+                assert out.shape == (x.size, max(len(shape), 1))
+                assert valid_length.asnumpy()[0] == n
+                assert_almost_equal(out.asnumpy()[:n], np_out)
+                assert (out.asnumpy()[n:] == -1).all()
+
+
 @with_seed()
 @use_np
 def test_np_unique():
@@ -8262,6 +8336,22 @@ def test_np_einsum():
         ('...ij, ...jc -> ...ic', [(2, 1, 5, 4), (2, 1, 4, 2)], lambda *args: (
                                                             _np.tile(args[1].sum(axis=3)[:, :, None, :], [1, 1, 5, 1]),
                                                              _np.tile(args[0].sum(axis=2)[:, :, : ,None], [1, 1, 1, 2]))),
+        # batched gemm, with the operands and the output stored transposed or permuted
+        ('bij, bjk -> bik', [(2, 3, 4), (2, 4, 5)], lambda *args: (
+                                                            _np.tile(args[1].sum(axis=2)[:, None, :], [1, 3, 1]),
+                                                            _np.tile(args[0].sum(axis=1)[:, :, None], [1, 1, 5]))),
+        ('bij, bkj -> bki', [(2, 3, 4), (2, 5, 4)], lambda *args: (
+                                                            _np.tile(args[1].sum(axis=1)[:, None, :], [1, 3, 1]),
+                                                            _np.tile(args[0].sum(axis=1)[:, None, :], [1, 5, 1]))),
+        ('ibj, jbk -> bki', [(3, 2, 4), (4, 2, 5)], lambda *args: (
+                                                            _np.tile(args[1].sum(axis=2).T[None, :, :], [3, 1, 1]),
+                                                            _np.tile(args[0].sum(axis=0).T[:, :, None], [1, 1, 5]))),
+        ('bij, bjk, bkl -> bil', [(2, 3, 4), (2, 4, 5), (2, 5, 2)], lambda *args: (
+                                                            _np.tile(_np.matmul(args[1], args[2]).sum(axis=2)[:, None, :],
+                                                                     [1, 3, 1]),
+                                                            args[0].sum(axis=1)[:, :, None] * args[2].sum(axis=2)[:, None, :],
+                                                            _np.tile(_np.matmul(args[0], args[1]).sum(axis=1)[:, :, None],
+                                                                     [1, 1, 2]))),
         # issue #16576
         # commented due to long running time
         # ('abiz,abjz->abij', [(64, 8, 128, 512), (64, 8, 128, 512)], lambda *args: (_np.matmul(_np.ones((64, 8, 128, 128)), args[1]),
@@ -8865,6 +8955,14 @@ def test_np_percentile():
         np_out = _np.percentile(a.asnumpy(), np_q, axis=axis, interpolation=interpolation, keepdims=keepdims)
         assert_almost_equal(mx_out.asnumpy(), np_out, atol=atol, rtol=rtol)
 
+    # several percentiles of long lanes with repeated values
+    a = np.random.randint(0, 50, size=(3, 5000)).astype(np.float64)
+    q = np.array([0, 50, 90, 99, 99.9, 100, 37.5], dtype=np.float64)
+    for interpolation, axis in itertools.product(interpolation_options, [None, 1]):
+        mx_out = np.percentile(a, q, axis=axis, interpolation=interpolation)
+        np_out = _np.percentile(a.asnumpy(), q.asnumpy(), axis=axis, interpolation=interpolation)
+        assert_almost_equal(mx_out.asnumpy(), np_out)
+
 
 @with_seed()
 @use_np
@@ -9863,6 +9961,13 @@ def test_np_bincount():
         np_out = _np.bincount(data.asnumpy(), weights_np, minlength)
         assert_almost_equal(mx_out.asnumpy(), np_out, rtol=rtol, atol=atol)
 
+    # many elements into few bins, skewed to the first bin
+    data = _np.concatenate([_np.zeros(60000), _np.random.randint(0, 20, size=40000)]).astype(_np.int64)
+    weights = _np.random.uniform(0, 1, size=data.shape)
+    assert_almost_equal(np.bincount(np.array(data)).asnumpy(), _np.bincount(data))
+    assert_almost_equal(np.bincount(np.array(data), np.array(weights, dtype=_np.float64)).asnumpy(),
+                        _np.bincount(data, weights))
+
 
 @with_seed()
 @use_np
@@ -31,6 +31,7 @@ from mxnet.operator import *
 from mxnet.base import py_str, MXNetError, _as_list
 from common import setup_module, with_seed, teardown_module, assert_raises_cudnn_not_satisfied, assert_raises_cuda_not_satisfied, assertRaises
 from common import xfail_when_nonstandard_decimal_separator, with_environment
+from common import run_in_spawned_process
 import pytest
 import os
 
@@ -696,6 +697,22 @@ def test_sigmoid():
     check_symbolic_forward(y, [xa], [ya])
     check_symbolic_backward(y, [xa], [np.ones(shape)], [ya * (1 - ya)])
 
+@with_seed()
+def test_vectorized_unary_float32():
+    # large enough to be split over the threads, with a tail shorter than a vector
+    n = 100003
+    special = np.array([0, -0.0, 1e-40, -1e-40, 87, -87, 88, -88, 9, -9, 0.625, -0.625,
+                        np.inf, -np.inf, np.nan], dtype=np.float32)
+    xa = np.random.uniform(-100, 100, size=n).astype(np.float32)
+    xa[::7] = np.random.uniform(-1, 1, size=len(xa[::7]))
+    xa[1000:1000 + len(special)] = special
+    with np.errstate(all='ignore'):
+        for op, fnp in [(mx.nd.exp, np.exp), (mx.nd.log, np.log), (mx.nd.tanh, np.tanh),
+                        (mx.nd.sigmoid, lambda a: 1 / (1 + np.exp(-a)))]:
+            x = np.abs(xa) if op is mx.nd.log else xa
+            assert_almost_equal(op(mx.nd.array(x, dtype=np.float32)), fnp(x.astype(np.float64)).astype(np.float32),
+                                rtol=1e-5, atol=1e-30, equal_nan=True)
+
 @with_seed()
 def test_shape_array():
     for i in range(1,6):
@@ -884,6 +901,44 @@ def test_embedding():
     assert_almost_equal(grad_map["embed_weight"], np.dot(np_onehot.T, np_grad), rtol=rtol, atol=atol)
 
 
+@with_seed()
+@pytest.mark.parametrize('mode', ['sum', 'mean'])
+@pytest.mark.parametrize('sparse_grad', [False, True])
+def test_embedding_bag(mode, sparse_grad):
+    in_dim = 20
+    out_dim = 70
+    bag_sizes = [3, 0, 7, 1, 12, 0, 5]
+    np_offsets = np.concatenate([[0], np.cumsum(bag_sizes)]).astype(np.int64)
+    np_data = np.random.randint(low=0, high=in_dim, size=np_offsets[-1])
+    np_weight = np.random.uniform(-1, 1, (in_dim, out_dim))
+    # bag b pools the rows of its indices
+    np_pool = np.zeros((len(bag_sizes), in_dim))
+    for b, size in enumerate(bag_sizes):
+        for i in np_data[np_offsets[b]:np_offsets[b + 1]]:
+            np_pool[b, i] += 1.0 / size if mode == 'mean' else 1.0
+    data = mx.nd.array(np_data)
+    offsets = mx.nd.array(np_offsets, dtype=np.int64)
+    weight = mx.nd.array(np_weight)
+    weight.attach_grad(stype='row_sparse' if sparse_grad else 'default')
+    with mx.autograd.record():
+        out = mx.nd.EmbeddingBag(data, offsets, weight, input_dim=in_dim, output_dim=out_dim,
+                                 mode=mode, sparse_grad=sparse_grad)
+    assert_almost_equal(out, np.dot(np_pool, np_weight), rtol=1e-5, atol=1e-5)
+    np_grad = np.random.uniform(-1, 1, out.shape)
+    out.backward(mx.nd.array(np_grad))
+    assert weight.grad.stype == ('row_sparse' if sparse_grad else 'default')
+    assert_almost_equal(weight.grad.tostype('default'), np.dot(np_pool.T, np_grad),
+                        rtol=1e-5, atol=1e-5)
+    # same as Embedding followed by the pooling of the bags
+    embed = mx.nd.Embedding(data, weight, input_dim=in_dim, output_dim=out_dim)
+    for b, size in enumerate(bag_sizes):
+        if size == 0:
+            continue
+        bag = embed[int(np_offsets[b]):int(np_offsets[b + 1])]
+        expected = bag.sum(axis=0) if mode == 'sum' else bag.mean(axis=0)
+        assert_almost_equal(out[b], expected, rtol=1e-5, atol=1e-5)
+
+
 # check ops handle duplicate input correctly.
 @with_seed()
 def test_binary_op_duplicate_input():
@@ -1790,6 +1845,44 @@ def test_depthwise_convolution():
                                 assert_allclose(arr1, arr2, rtol=1e-3, atol=1e-3)
 
 
+@with_seed()
+def test_convolution_depthwise_and_winograd():
+    def np_convolution(data, weight, bias, stride, pad, dilate, num_group):
+        n, c, h, w = data.shape
+        k, cg, kh, kw = weight.shape
+        padded = np.pad(data, ((0, 0), (0, 0), (pad, pad), (pad, pad)), mode='constant')
+        oh = (h + 2 * pad - dilate * (kh - 1) - 1) // stride + 1
+        ow = (w + 2 * pad - dilate * (kw - 1) - 1) // stride + 1
+        out = np.zeros((n, k, oh, ow)) + bias.reshape(1, k, 1, 1)
+        kg = k // num_group
+        for g in range(num_group):
+            for i in range(kh):
+                for j in range(kw):
+                    window = padded[:, g * cg:(g + 1) * cg,
+                                    i * dilate:i * dilate + stride * (oh - 1) + 1:stride,
+                                    j * dilate:j * dilate + stride * (ow - 1) + 1:stride]
+                    out[:, g * kg:(g + 1) * kg] += np.einsum('ncxy,kc->nkxy', window,
+                                                             weight[g * kg:(g + 1) * kg, :, i, j])
+        return out
+
+    # depthwise with channel multipliers, then the shapes of Winograd F(4x4, 3x3) and F(2x2, 3x3)
+    configs = [((2, 8, 9, 11), 8, (3, 3), 1, 1, 1, 8),
+               ((2, 8, 10, 11), 16, (3, 3), 2, 1, 1, 8),
+               ((1, 4, 13, 12), 8, (5, 5), 2, 3, 2, 4),
+               ((2, 16, 13, 15), 12, (3, 3), 1, 1, 1, 1),
+               ((2, 16, 12, 12), 12, (3, 3), 1, 0, 1, 1),
+               ((3, 8, 5, 6), 9, (3, 3), 1, 1, 1, 1)]
+    for shape, num_filter, kernel, stride, pad, dilate, num_group in configs:
+        data = np.random.uniform(-1, 1, shape).astype('float32')
+        weight = np.random.uniform(-1, 1, (num_filter, shape[1] // num_group) + kernel).astype('float32')
+        bias = np.random.uniform(-1, 1, (num_filter,)).astype('float32')
+        out = mx.nd.Convolution(mx.nd.array(data), mx.nd.array(weight), mx.nd.array(bias),
+                                num_filter=num_filter, kernel=kernel, stride=(stride, stride),
+                                pad=(pad, pad), dilate=(dilate, dilate), num_group=num_group)
+        expected = np_convolution(data, weight, bias, stride, pad, dilate, num_group)
+        assert_almost_equal(out, expected, rtol=1e-4, atol=1e-4)
+
+
 @with_seed()
 def test_convolution_independent_gradients():
     # NOTE(zixuanweeei): Flaky test tracked by https://github.com/apache/incubator-mxnet/issues/15603.
@@ -1906,7 +1999,9 @@ def gen_broadcast_data(idx):
         [[1, 1, 65, 2, 22], [1, 1, 65, 1, 1]],
         [[1, 24, 103, 17, 18], [1, 24, 1, 1, 1]],
         [[1, 1, 1, 1, 2], [1, 24, 194, 50, 1]],
-        [[1, 1, 107, 84, 9], [1, 1, 1, 1, 1]]])
+        [[1, 1, 107, 84, 9], [1, 1, 1, 1, 1]],
+        [[4, 16, 1, 28, 28], [1, 16, 1, 1, 1]],
+        [[1, 1, 1, 1, 96], [1, 1, 1, 300, 96]]])
     if idx < binary_op_data_shape.shape[0]:
         l_shape = binary_op_data_shape[idx][0]
         r_shape = binary_op_data_shape[idx][1]
@@ -3580,6 +3675,35 @@ def test_layer_norm(enforce_safe_acc, dtype, forward_check_eps, backward_check_e
                                               finite_grad_check=finite_grad_check)
 
 
+@with_seed()
+@pytest.mark.parametrize('dtype', ['float16', 'float32', 'float64'])
+@pytest.mark.parametrize('shape', [(3, 7), (4, 5, 768), (2, 3, 1030)])
+def test_residual_layer_norm(dtype, shape):
+    data, residual = [mx.nd.random.uniform(-1, 1, shape=shape, dtype=dtype) for _ in range(2)]
+    bias, gamma, beta = [mx.nd.random.uniform(-1, 1, shape=shape[-1:], dtype=dtype)
+                         for _ in range(3)]
+    ograd = mx.nd.random.uniform(-1, 1, shape=shape, dtype=dtype)
+
+    def reference(data, gamma, beta, residual, bias):
+        return mx.nd.LayerNorm(data + residual + bias, gamma, beta, eps=1e-3)
+
+    def fused(data, gamma, beta, residual, bias):
+        return mx.nd.contrib.residual_layer_norm(data, gamma, beta, residual, bias, eps=1e-3)
+
+    rtol, atol = (1e-2, 1e-2) if dtype == 'float16' else (1e-3, 1e-4)
+    results = []
+    for f in [reference, fused]:
+        args = [x.copy() for x in [data, gamma, beta, residual, bias]]
+        for x in args:
+            x.attach_grad()
+        with mx.autograd.record():
+            out = f(*args)
+        out.backward(ograd)
+        results.append([out] + [x.grad for x in args])
+    for expected, actual in zip(*results):
+        assert_almost_equal(expected, actual, rtol=rtol, atol=atol)
+
+
 # Numpy Implementation of Sequence Ops
 def sequence_last_numpy(array, lengths, axis):
     # create new array of dims [batch, seqlen, ...]
@@ -3743,6 +3867,25 @@ def test_sequence_reverse():
     check_sequence_reverse(mx.cpu())
 
 
+def test_sequence_reverse_inplace():
+    # the output of the intermediate sum is reversed in place
+    data = mx.sym.Variable('data')
+    seq_len = mx.sym.Variable('seq_len')
+    sym = mx.sym.SequenceReverse(data + 1, seq_len, use_sequence_length=True)
+    x = np.random.uniform(size=(5, 3, 2))
+    lengths = np.array([5, 2, 3])
+    expected = x + 1
+    for b, l in enumerate(lengths):
+        expected[:l, b] = expected[:l, b][::-1]
+    dy = np.random.uniform(size=x.shape)
+    expected_grad = dy.copy()
+    for b, l in enumerate(lengths):
+        expected_grad[:l, b] = expected_grad[:l, b][::-1]
+    check_symbolic_forward(sym, {'data': x, 'seq_len': lengths}, [expected])
+    check_symbolic_backward(sym, {'data': x, 'seq_len': lengths}, [dy], {'data': expected_grad},
+                            grad_req={'data': 'write', 'seq_len': 'null'})
+
+
 def mathematical_core_binary(name,
                              forward_mxnet_call,
                              forward_numpy_call,
@@ -4160,6 +4303,49 @@ def test_order():
                     is_ascend=True)])
 
 
+@with_seed()
+def test_order_long_rows():
+    # rows long enough to be selected and sorted by several threads each
+    for shape in [(1, 1000003), (3, 200000)]:
+        # distinct values, so that the indices are those of numpy
+        a_npy = np.random.permutation(np.prod(shape)).reshape(shape).astype(np.float32)
+        a = mx.nd.array(a_npy)
+        for k in [1, 100, 20000]:
+            for is_ascend in [False, True]:
+                order = np.argsort(a_npy, axis=1)
+                expected = order[:, :k] if is_ascend else order[:, ::-1][:, :k]
+                assert_almost_equal(mx.nd.topk(a, axis=1, k=k, ret_typ="indices",
+                                               is_ascend=is_ascend, dtype=np.int64), expected)
+                assert_almost_equal(mx.nd.topk(a, axis=1, k=k, ret_typ="value", is_ascend=is_ascend),
+                                    np.take_along_axis(a_npy, expected, axis=1))
+        assert_almost_equal(mx.nd.sort(a, axis=1), np.sort(a_npy, axis=1))
+        assert_almost_equal(mx.nd.argsort(a, axis=1, dtype=np.int64), np.argsort(a_npy, axis=1))
+
+
+@with_seed()
+def test_order_batched_rows():
+    # many rows, sorted in shared memory up to 4096 values each and by segments beyond
+    for num_rows, row_len in [(500, 7), (300, 300), (100, 1000), (50, 2000), (20, 4096),
+                              (10, 5000)]:
+        for dtype in [np.float32, np.float64, np.int32]:
+            # distinct values in a row, so that the indices are those of numpy
+            a_npy = np.stack([np.random.permutation(row_len) - row_len // 2
+                              for _ in range(num_rows)]).astype(dtype)
+            a = mx.nd.array(a_npy, dtype=dtype)
+            order = np.argsort(a_npy, axis=1)
+            assert_almost_equal(mx.nd.sort(a, axis=1), np.sort(a_npy, axis=1))
+            assert_almost_equal(mx.nd.sort(a, axis=1, is_ascend=False),
+                                np.sort(a_npy, axis=1)[:, ::-1])
+            assert_almost_equal(mx.nd.argsort(a, axis=1, dtype=np.int64), order)
+            assert_almost_equal(mx.nd.argsort(a, axis=1, is_ascend=False, dtype=np.int64),
+                                order[:, ::-1])
+            k = min(row_len, 10)
+            assert_almost_equal(mx.nd.topk(a, axis=1, k=k, ret_typ="indices", dtype=np.int64),
+                                order[:, ::-1][:, :k])
+            # rows along the first axis
+            assert_almost_equal(mx.nd.argsort(a.T, axis=0, dtype=np.int64), order.T)
+
+
 @with_seed()
 def test_blockgrad():
     a = mx.sym.Variable('a')
@@ -4467,6 +4653,25 @@ def test_amp_multicast():
     check_amp_multicast(input_np, expected_output)
 
 
+@with_seed()
+def test_amp_multicast_many_tensors():
+    # more tensors and chunks than a single multi-tensor launch takes on gpu
+    ctx = default_context()
+    sizes = [1, 7, 16384, 16385, 100000] * 30 + [320 * 16384 + 5]
+    arrays_np = [np.random.uniform(-10, 10, size=(size,)).astype(np.float16) for size in sizes]
+    arrays16 = [mx.nd.array(a, dtype=np.float16, ctx=ctx) for a in arrays_np]
+    arrays32 = [mx.nd.empty((size,), dtype=np.float32, ctx=ctx) for size in sizes]
+    mx.nd.amp_multicast(*arrays16, num_outputs=len(sizes), out=arrays32)
+    for a_np, a32 in zip(arrays_np, arrays32):
+        assert_almost_equal(a32, a_np.astype(np.float32), rtol=0, atol=0)
+    for a32 in arrays32:
+        a32 *= 2
+    mx.nd.amp_multicast(*arrays32, num_outputs=len(sizes), cast_narrow=True, out=arrays16)
+    for a_np, a16 in zip(arrays_np, arrays16):
+        assert a16.dtype == np.float16
+        assert_almost_equal(a16, a_np * 2, rtol=0, atol=0)
+
+
 @with_seed()
 def test_all_finite():
     data = mx.sym.Variable("data", dtype=np.float32)
@@ -5044,6 +5249,36 @@ def test_softmax_with_length():
                                 rtol=1e-2, atol=2e-3 if dtype == np.float16 else 1e-3, dtype="asnumpy")
 
 
+@with_seed()
+@pytest.mark.parametrize('dtype', [np.float16, np.float32, np.float64])
+@pytest.mark.parametrize('shape,axis', [((3, 5, 37), -1), ((2, 4, 64), -1), ((2, 4, 2048), -1),
+                                        ((3, 9, 4), 1)])
+def test_masked_softmax(dtype, shape, axis):
+    temperature = 2.0
+    np_data = np.random.uniform(-2, 2, shape).astype(dtype)
+    np_mask = np.random.uniform(0, 1, shape) < 0.7
+    # a row without any element to normalize
+    row = [0] * len(shape)
+    row[axis] = slice(None)
+    np_mask[tuple(row)] = False
+    np_ograd = np.random.uniform(-1, 1, shape).astype(dtype)
+    scaled = np.where(np_mask, np_data.astype(np.float64) / temperature, -np.inf)
+    scores = np.exp(scaled - np.max(scaled, axis=axis, keepdims=True).clip(-1e30)) * np_mask
+    total = np.sum(scores, axis=axis, keepdims=True)
+    np_out = scores / np.where(total > 0, total, 1)
+    np_grad = np_out * (np_ograd - np.sum(np_ograd * np_out, axis=axis, keepdims=True)) / temperature
+
+    data = mx.nd.array(np_data, dtype=dtype)
+    mask = mx.nd.array(np_mask, dtype=np.bool_)
+    data.attach_grad()
+    with mx.autograd.record():
+        out = mx.nd.masked_softmax(data, mask, axis=axis, temperature=temperature)
+    out.backward(mx.nd.array(np_ograd, dtype=dtype))
+    rtol, atol = (1e-2, 1e-3) if dtype == np.float16 else (1e-4, 1e-6)
+    assert_almost_equal(out.asnumpy(), np_out, rtol=rtol, atol=atol)
+    assert_almost_equal(data.grad.asnumpy(), np_grad, rtol=rtol, atol=atol)
+
+
 @with_seed()
 def test_pick():
     def test_pick_helper(index_type=np.int32):
@@ -5350,6 +5585,29 @@ def test_boolean_mask():
     assert same(c.asnumpy(), a_np[ci.asnumpy().astype('bool')])
 
 
+@with_seed()
+def test_boolean_mask_padded():
+    shape = (50, 4, 3)
+    a = mx.nd.random.uniform(-1, 1, shape=shape)
+    a.attach_grad()
+    for mask in [mx.nd.random.randint(0, 2, shape=shape[0:1]),
+                 mx.nd.zeros(shape[0:1]), mx.nd.ones(shape[0:1])]:
+        with mx.autograd.record():
+            out, valid_length = mx.nd.contrib.boolean_mask_padded(a, mask, fill_value=-2)
+            loss = (out * out).sum()
+        loss.backward()
+        m = mask.asnumpy().astype('bool')
+        a_np = a.asnumpy()
+        n = int(m.sum())
+        assert out.shape == shape
+        assert valid_length.dtype == np.int32
+        assert valid_length.asnumpy()[0] == n
+        assert same(out.asnumpy()[:n], a_np[m])
+        assert (out.asnumpy()[n:] == -2).all()
+        expected_grad = 2 * a_np * m.reshape((-1, 1, 1))
+        assert_allclose(a.grad.asnumpy(), expected_grad, rtol=1e-5, atol=1e-6)
+
+
 @with_seed()
 def test_div_sqrt_dim():
     data_tmp = np.random.normal(0, 1, (5, 10, 8))
@@ -5827,6 +6085,32 @@ def test_deformable_convolution():
                                                    grad_nodes=grad_nodes, ctx=mx.gpu(0), numeric_eps=1.0/64)
 
 
+@with_seed()
+def test_deformable_convolution_im2col_step():
+    # chunks of several images, and a last chunk with the remaining ones, match one image at a time
+    num_batch, num_channel, num_group, num_deformable_group = 5, 4, 2, 2
+    data = mx.nd.random.uniform(shape=(num_batch, num_channel, 6, 6))
+    offset = mx.nd.random.uniform(0.1, 0.9, shape=(num_batch, num_deformable_group * 2 * 3 * 3, 6, 6))
+    weight = mx.nd.random.normal(0, 0.1, shape=(6, num_channel // num_group, 3, 3))
+    bias = mx.nd.random.normal(shape=(6,))
+    ograd = mx.nd.random.uniform(shape=(num_batch, 6, 6, 6))
+    results = []
+    for im2col_step in [1, 2, 64]:
+        args = [arr.copy() for arr in [data, offset, weight, bias]]
+        for arr in args:
+            arr.attach_grad()
+        with mx.autograd.record():
+            out = mx.nd.contrib.DeformableConvolution(*args, kernel=(3, 3), pad=(1, 1), num_filter=6,
+                                                      num_group=num_group,
+                                                      num_deformable_group=num_deformable_group,
+                                                      im2col_step=im2col_step)
+        out.backward(ograd)
+        results.append([out] + [arr.grad for arr in args])
+    for result in results[1:]:
+        for expected, actual in zip(results[0], result):
+            assert_almost_equal(expected, actual, rtol=1e-4, atol=1e-5)
+
+
 def _validate_sample_location(input_rois, input_offset, spatial_scale, pooled_w, pooled_h, sample_per_part, part_size, output_dim, num_classes, trans_std, feat_h, feat_w):
     num_rois = input_rois.shape[0]
     output_offset = input_offset.copy()
@@ -6572,6 +6856,26 @@ def test_laop_6():
     check_fw(test_logabsdet, [a], [r2])
     check_grad(test_logabsdet, [a])
 
+# Tests for potrf and syevd on batches of small and moderately sized matrices
+@with_seed()
+def test_laop_7():
+    for dtype in [np.float32, np.float64]:
+        rtol, atol = (1e-3, 1e-4) if dtype == np.float32 else (1e-7, 1e-9)
+        for n, batch in itertools.product([1, 2, 3, 4, 5, 12, 40], [1, 33]):
+            m = np.random.uniform(-1.0, 1.0, (batch, n, n))
+            a = np.matmul(m, np.swapaxes(m, 1, 2)) + n * np.eye(n)
+            for lower in [True, False]:
+                l = mx.nd.linalg.potrf(mx.nd.array(a, dtype=dtype), lower=lower).asnumpy()
+                expected = np.linalg.cholesky(a)
+                if not lower:
+                    expected = np.swapaxes(expected, 1, 2)
+                assert_almost_equal(l, expected, rtol=rtol, atol=atol)
+            u, lam = mx.nd.linalg.syevd(mx.nd.array(a, dtype=dtype))
+            u, lam = u.asnumpy(), lam.asnumpy()
+            assert_almost_equal(lam, np.linalg.eigvalsh(a), rtol=rtol, atol=atol * n)
+            assert_almost_equal(np.matmul(np.swapaxes(u, 1, 2) * lam[:, None, :], u), a,
+                                rtol=rtol, atol=atol * n)
+
 @with_seed()
 def test_stack():
     for _ in range(100):
@@ -6761,6 +7065,33 @@ def test_dropout():
         # check_dropout_axes(0.25, nshape, axes = (1, 2, 3), cudnn_off=False)
 
 
+@with_seed()
+def test_bias_dropout_add():
+    shape = (4, 7, 33)
+    data = mx.nd.random.uniform(1, 2, shape=shape)
+    bias = mx.nd.random.uniform(1, 2, shape=(shape[-1],))
+    residual = mx.nd.random.uniform(-1, 1, shape=shape)
+    for arr in [data, bias, residual]:
+        arr.attach_grad()
+    biased = (data + bias).asnumpy()
+    for p in [0.0, 0.4]:
+        with mx.autograd.record():
+            out = mx.nd.contrib.bias_dropout_add(data, bias, residual, p=p)
+        out.backward(mx.nd.ones(shape))
+        dropped = out.asnumpy() - residual.asnumpy()
+        keep = dropped != 0
+        assert_almost_equal(dropped[keep], biased[keep] / (1 - p), rtol=1e-5, atol=1e-5)
+        assert_almost_equal(data.grad, keep / (1 - p), rtol=1e-5, atol=1e-5)
+        assert_almost_equal(bias.grad, (keep / (1 - p)).sum(axis=(0, 1)), rtol=1e-4, atol=1e-4)
+        assert_almost_equal(residual.grad, np.ones(shape))
+        if p == 0:
+            assert keep.all()
+        else:
+            assert abs(keep.mean() - (1 - p)) < 0.05
+    # inference without dropout
+    out = mx.nd.contrib.bias_dropout_add(data, bias, residual, p=0.4)
+    assert_almost_equal(out, biased + residual.asnumpy(), rtol=1e-5, atol=1e-5)
+
 @pytest.mark.skip(reason="test fails intermittently. temporarily disabled till it gets fixed. tracked at https://github.com/apache/incubator-mxnet/issues/11290")
 @with_seed()
 def test_scatter_gather_nd():
@@ -8019,10 +8350,28 @@ def test_op_roi_align():
                                grad_nodes={'data': 'add', 'rois': 'null'},
                                numeric_eps=1e-4, rtol=1e-1, atol=1e-4, ctx=ctx)
 
+    def test_roi_align_ignored_roi():
+        ctx = default_context()
+        data = mx.nd.random.uniform(shape=(2, 3, 8, 8), ctx=ctx)
+        rois = mx.nd.array([[0, 1, 1, 6, 6], [-1, 1, 1, 6, 6], [1, 0, 2, 7, 5]], ctx=ctx)
+        output = mx.nd.ones((3, 3, 2, 2), ctx=ctx)
+        data.attach_grad()
+        with mx.autograd.record():
+            mx.nd.contrib.ROIAlign(data, rois, pooled_size=(2, 2), spatial_scale=1, out=output)
+        # the whole output of a ROI of negative batch index is 0, and it has no gradient
+        assert_almost_equal(output[1], np.zeros((3, 2, 2)))
+        output.backward(mx.nd.ones_like(output))
+        expected_grad = data.grad.copy()
+        with mx.autograd.record():
+            output = mx.nd.contrib.ROIAlign(data, rois[::2], pooled_size=(2, 2), spatial_scale=1)
+        output.backward(mx.nd.ones_like(output))
+        assert_almost_equal(data.grad, expected_grad)
+
     test_roi_align_value()
     test_roi_align_value(sampling_ratio=2)
     test_roi_align_value(position_sensitive=True)
     test_roi_align_autograd()
+    test_roi_align_ignored_roi()
 
 @with_seed()
 def test_op_rroi_align():
@@ -9179,6 +9528,63 @@ def test_multihead_attention_encdec():
     for dtype in dtypes:
         check_multihead_attention_encdec(dtype=dtype)
 
+def check_interleaved_selfatt(dtype, causal, use_length):
+    seq_len, batch_size, num_heads, head_dim = 37, 3, 2, 8
+    qkv = mx.nd.random.uniform(-1, 1, shape=(seq_len, batch_size, num_heads * head_dim * 3),
+                               dtype=dtype)
+    valid_length = mx.nd.array([seq_len, 20, 0], dtype='int32')
+    ograd = mx.nd.random.uniform(-1, 1, shape=(seq_len, batch_size, num_heads * head_dim),
+                                 dtype=dtype)
+    mask = np.ones((batch_size * num_heads, seq_len, seq_len), dtype=bool)
+    if causal:
+        mask &= np.tril(np.ones((seq_len, seq_len), dtype=bool))
+    if use_length:
+        lengths = np.repeat(valid_length.asnumpy(), num_heads)
+        mask &= np.arange(seq_len)[None, None, :] < lengths[:, None, None]
+    mask = mx.nd.array(mask, dtype=dtype)
+
+    def reference(x):
+        att = mx.nd.contrib.interleaved_matmul_selfatt_qk(x, heads=num_heads)
+        att = mx.nd.softmax(att * mask - 1e4 * (1 - mask), axis=-1) * mask
+        return mx.nd.contrib.interleaved_matmul_selfatt_valatt(x, att, heads=num_heads)
+
+    def fused(x, dropout=0.):
+        args = [x, valid_length] if use_length else [x]
+        return mx.nd.contrib.interleaved_selfatt(*args, heads=num_heads, causal=causal,
+                                                 use_length=use_length, dropout=dropout)
+
+    rtol, atol = (1e-2, 1e-2) if dtype == 'float16' else (1e-4, 1e-5)
+    results = []
+    for f in [reference, fused]:
+        x = qkv.copy()
+        x.attach_grad()
+        with mx.autograd.record():
+            out = f(x)
+        out.backward(ograd)
+        results.append((out.asnumpy(), x.grad.asnumpy()))
+    assert_almost_equal(results[0][0], results[1][0], rtol=rtol, atol=atol)
+    assert_almost_equal(results[0][1], results[1][1], rtol=rtol, atol=atol)
+
+    # dropout only applies in training
+    assert_almost_equal(fused(qkv, dropout=0.5).asnumpy(), results[1][0], rtol=rtol, atol=atol)
+    with mx.autograd.train_mode():
+        assert_almost_equal(fused(qkv, dropout=0.).asnumpy(), results[1][0],
+                            rtol=rtol, atol=atol)
+        dropped = fused(qkv, dropout=0.5).asnumpy()
+    assert not np.allclose(dropped, results[1][0])
+
+@with_seed()
+@pytest.mark.serial
+def test_interleaved_selfatt():
+    dtypes = ['float32']
+    if default_context().device_type == 'gpu':
+        dtypes += ['float16']
+
+    for dtype in dtypes:
+        for causal in [False, True]:
+            for use_length in [False, True]:
+                check_interleaved_selfatt(dtype, causal, use_length)
+
 @with_seed()
 @pytest.mark.serial
 def test_im2col_col2im():
@@ -9418,3 +9824,37 @@ def test_broadcast_ops_on_misaligned_input_oneside(dtype, lead_dim, both_ways):
     mx.nd.waitall()
     assert_almost_equal(f, expected)
 
+
+def _check_online_operator_tuning(seed):
+    # unary ops launch tuned kernels, sized over a few size buckets
+    for size in [1 << 12, 1 << 16, (1 << 16) + 7]:
+        x = np.random.uniform(0.5, 2, size=(size,)).astype(np.float32)
+        # the first launches time the thread counts, the later ones use the fastest
+        for _ in range(20):
+            assert_almost_equal(mx.nd.exp(mx.nd.array(x)), np.exp(x), rtol=1e-5, atol=1e-6)
+            assert_almost_equal(mx.nd.sqrt(mx.nd.array(x)), np.sqrt(x), rtol=1e-5, atol=1e-6)
+
+
+def _read_online_tuning_cache(path):
+    with open(path) as f:
+        entries = dict(line.split() for line in f if line.strip())
+    return {key: int(threads) for key, threads in entries.items()}
+
+
+def test_online_operator_tuning(tmpdir):
+    cache = str(tmpdir.join('online_tuning.txt'))
+    env = {'MXNET_ONLINE_OPERATOR_TUNING': '1',
+           'MXNET_ONLINE_TUNING_SAMPLES': '2',
+           'MXNET_ONLINE_TUNING_CACHE': cache,
+           'OMP_NUM_THREADS': '4'}
+    # tuning is enabled once per process, the decisions are written at exit
+    run_in_spawned_process(_check_online_operator_tuning, env)
+    decisions = _read_online_tuning_cache(cache)
+    assert len(decisions) > 0
+    assert all(1 <= threads <= 4 for threads in decisions.values())
+    # a later run starts from the cached decisions, which it leaves as they are
+    with open(cache, 'w') as f:
+        for key in decisions:
+            f.write('{} 1\n'.format(key))
+    run_in_spawned_process(_check_online_operator_tuning, env)
+    assert _read_online_tuning_cache(cache) == {key: 1 for key in decisions}
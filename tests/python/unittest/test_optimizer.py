@@ -476,6 +476,77 @@ def test_adam():
                               rtol=1e-4, atol=2e-5)
 
 
+@with_seed()
+def test_multi_tensor_update_chunks():
+    # more tensors than one launch of the multi-tensor kernels takes
+    shapes = [(3, 4), (7,), (2, 3, 2)] * 17
+    for opt, kwarg in [(mx.optimizer.Adam, {'wd': 0.03}),
+                       (mx.optimizer.RMSProp, {'clip_weights': 0.5}),
+                       (mx.optimizer.NAG, {'momentum': 0.9})]:
+        for dtype, mp in [(np.float32, False), (np.float16, True)]:
+            compare_optimizer(opt(use_fused_step=False, multi_precision=mp, **kwarg),
+                              opt(use_fused_step=True, multi_precision=mp,
+                                  aggregate_num=np.inf, **kwarg),
+                              shapes, dtype, rtol=1e-4, atol=2e-5)
+
+
+@with_seed()
+def test_adam_low_precision_states():
+    shapes = [(3, 4, 5), (10, 4), (700,)]
+    for state_dtype in ['bfloat16', 'int8']:
+        for dtype, mp in [(np.float32, False), (np.float16, True)]:
+            opt1 = mx.optimizer.Adam(multi_precision=mp, wd=0.03)
+            opt2 = mx.optimizer.Adam(multi_precision=mp, wd=0.03, state_dtype=state_dtype,
+                                     state_block_size=64)
+            weights1 = [mx.random.uniform(shape=shape, dtype=dtype) for shape in shapes]
+            weights2 = [w.copy() for w in weights1]
+            states1 = [opt1.create_state_multi_precision(i, w) for i, w in enumerate(weights1)]
+            states2 = [opt2.create_state_multi_precision(i, w) for i, w in enumerate(weights2)]
+            indices = list(range(len(shapes)))
+            for _ in range(5):
+                grads = [mx.random.normal(shape=shape, dtype=dtype) for shape in shapes]
+                opt1.update_multi_precision(indices, weights1, [g.copy() for g in grads], states1)
+                opt2.update_multi_precision(indices, weights2, grads, states2)
+            # each step moves the weights by about the learning rate of 1e-3
+            for w1, w2 in zip(weights1, weights2):
+                assert_almost_equal(w1, w2, rtol=0, atol=1e-3)
+
+
+@with_seed()
+def test_preloaded_multi_adam():
+    shapes = [(3, 4), (7,), (2, 3, 2)] * 17
+    lrs = [0.01 * (i + 1) for i in range(len(shapes))]
+    wds = [0.001 * i for i in range(len(shapes))]
+    kwargs = {'beta1': 0.8, 'beta2': 0.99, 'epsilon': 1e-6, 'clip_gradient': 0.5}
+    for dtype, mp in [(np.float32, False), (np.float16, True)]:
+        inputs = []
+        for shape in shapes:
+            weight = mx.nd.random.uniform(shape=shape).astype(dtype)
+            grad = mx.nd.random.normal(shape=shape).astype(dtype)
+            mean = mx.nd.random.uniform(shape=shape)
+            var = mx.nd.random.uniform(shape=shape)
+            inputs.append([weight, grad, mean, var] + ([weight.astype('float32')] if mp else []))
+        expected = [[a.copy() for a in arrays] for arrays in inputs]
+        update = mx.nd.multi_mp_adam_update if mp else mx.nd.multi_adam_update
+        preloaded = (mx.nd.preloaded_multi_mp_adam_update if mp else
+                     mx.nd.preloaded_multi_adam_update)
+        update(*[a for arrays in expected for a in arrays], out=[e[0] for e in expected],
+               num_weights=len(shapes), lrs=lrs, wds=wds, rescale_grad=0.25, **kwargs)
+        hyper = [mx.nd.array(lrs), mx.nd.array(wds), mx.nd.array([0.25])]
+        flat = [a for arrays in inputs for a in arrays] + hyper
+        preloaded(*flat, out=[i[0] for i in inputs], num_weights=len(shapes), **kwargs)
+        for arrays, expected_arrays in zip(inputs, expected):
+            for a, e in zip(arrays, expected_arrays):
+                assert_almost_equal(a, e, rtol=1e-3, atol=1e-5)
+        # a scale of 0 or inf skips the step, as a loss scaler does on overflow
+        for scale in [0, np.inf]:
+            hyper[2][:] = scale
+            preloaded(*flat, out=[i[0] for i in inputs], num_weights=len(shapes), **kwargs)
+            for arrays, expected_arrays in zip(inputs, expected):
+                for a, e in zip(arrays, expected_arrays):
+                    assert_almost_equal(a, e, rtol=1e-3, atol=1e-5)
+
+
 @xfail_when_nonstandard_decimal_separator
 @with_seed()
 def test_sparse_adam():
@@ -26,7 +26,7 @@ from collections import OrderedDict
 import mxnet as mx
 from mxnet import profiler
 from mxnet.gluon import nn
-from mxnet.test_utils import is_cd_run
+from mxnet.test_utils import is_cd_run, environment
 from common import run_in_spawned_process
 import pytest
 
@@ -306,6 +306,224 @@ def test_aggregate_duplication():
     profiler.set_state('stop')
 
 
+@pytest.mark.skipif(os.environ.get('MXNET_ENGINE_TYPE') == 'NaiveEngine',
+                    reason='the naive engine does not schedule operators')
+def test_aggregate_scheduling_stats():
+    file_name = 'test_aggregate_scheduling_stats.json'
+    enable_profiler(profile_filename=file_name, run=True, continuous_dump=True, \
+                    aggregate_stats=True)
+    profiler.dumps(reset=True)
+    inp = mx.nd.zeros(shape=(100, 100))
+    for _ in range(10):
+        inp = inp + 1
+    mx.nd.waitall()
+    profiler.dump(False)
+    target_dict = json.loads(profiler.dumps(format='json'))
+    stat = target_dict['Time']['operator']['_plus_scalar']
+    for key in ['Dependency Wait', 'Queue Delay', 'Execution']:
+        assert key in stat
+        assert sum(stat[key]['Histogram'].values()) == stat['Count']
+        assert stat[key]['P50'] <= stat[key]['P99'] <= stat[key]['Max']
+    assert 'operator Scheduling' in profiler.dumps(format='table')
+    profiler.set_state('stop')
+
+
+def test_data_pipeline_stats():
+    file_name = 'test_data_pipeline_stats.json'
+    enable_profiler(profile_filename=file_name, run=True, continuous_dump=True, \
+                    aggregate_stats=True)
+    profiler.dumps(reset=True)
+    dataset = mx.gluon.data.SimpleDataset(np.arange(60, dtype=np.float32).reshape(20, 3))
+    loader = mx.gluon.data.DataLoader(dataset, 4, num_workers=2, try_nopython=True)
+    for _ in loader:
+        pass
+    profiler.dump(False)
+    target_dict = json.loads(profiler.dumps(format='json'))
+    stats = target_dict['Time']['Data Pipeline']
+    # the loader may have started the next epoch in the background
+    for stage in ['ThreadedDataLoader::GetItems', 'ThreadedDataLoader::Batchify',
+                  'PrefetcherIter::Load']:
+        assert stats[stage]['Samples'] >= 20
+        assert 'Samples/s' in stats[stage]
+    assert stats['PrefetcherIter::Wait']['Samples'] == 20
+    assert 'PrefetcherIter::Queue' in stats
+    assert 'Data Pipeline Throughput' in profiler.dumps(format='table')
+    profiler.set_state('stop')
+
+
+def test_aggregate_operator_efficiency():
+    file_name = 'test_aggregate_operator_efficiency.json'
+    enable_profiler(profile_filename=file_name, run=True, continuous_dump=True, \
+                    aggregate_stats=True)
+    profiler.dumps(reset=True)
+    lhs = mx.nd.ones(shape=(64, 128))
+    rhs = mx.nd.ones(shape=(128, 32))
+    for _ in range(5):
+        out = mx.nd.dot(lhs, rhs)
+    mx.nd.waitall()
+    profiler.dump(False)
+    target_dict = json.loads(profiler.dumps(format='json'))
+    stat = target_dict['Time']['operator']['dot']
+    assert stat['Count'] == 5
+    assert stat['GFLOP/s'] > 0
+    assert stat['GB/s'] > 0
+    assert 'operator Efficiency' in profiler.dumps(format='table')
+    profiler.set_state('stop')
+
+
+def test_aggregate_operator_counters():
+    file_name = 'test_aggregate_operator_counters.json'
+    with environment('MXNET_PROFILER_PERF_EVENTS', '1'):
+        enable_profiler(profile_filename=file_name, run=True, continuous_dump=True, \
+                        aggregate_stats=True)
+    profiler.dumps(reset=True)
+    data = mx.nd.ones(shape=(256, 1024))
+    for _ in range(5):
+        out = mx.nd.exp(data)
+    mx.nd.waitall()
+    profiler.dump(False)
+    target_dict = json.loads(profiler.dumps(format='json'))
+    table = profiler.dumps(format='table')
+    profiler.set_state('stop')
+    stat = target_dict['Time']['operator']['exp']
+    assert stat['Count'] == 5
+    if 'IPC' not in stat:
+        pytest.skip('perf_event counters not available')
+    assert stat['IPC'] > 0
+    assert stat['Cycles/Element'] > 0
+    assert stat['Misses/Element'] >= 0
+    assert 'operator Counters' in table
+
+
+def test_memory_timeline():
+    file_name = 'test_memory_timeline.json'
+    enable_profiler(profile_filename=file_name, run=True, continuous_dump=True)
+    with profiler.scope('timeline'):
+        A = mx.sym.Variable('A')
+        B = mx.sym.Variable('B')
+        C = mx.symbol.dot(A, B, name='dot')
+    executor = C._simple_bind(mx.cpu(), 'write', A=(256, 256), B=(256, 256))
+    executor.forward()
+    mx.nd.waitall()
+    profiler.dump(False)
+    with open('test_memory_timeline_memory.json') as f:
+        report = json.load(f)
+    device = report['Devices']['cpu/0']
+    assert device['Peak Bytes'] >= 3 * 256 * 256 * 4
+    assert max(point[1] for point in device['Timeline']) == device['Peak Bytes']
+    holders = device['Holders']
+    assert sum(h['Bytes'] for h in holders) == device['Peak Bytes']
+    assert any(h['Name'].startswith('timeline:') for h in holders)
+    profiler.set_state('stop')
+
+
+def test_aggregate_requests():
+    import threading
+    file_name = 'test_aggregate_requests.json'
+    enable_profiler(profile_filename=file_name, run=True, continuous_dump=True, \
+                    aggregate_stats=True)
+    profiler.dumps(reset=True)
+
+    def serve(request_id):
+        with profiler.request(request_id):
+            a = mx.nd.ones(shape=(32, 32))
+            for _ in range(3):
+                a = a + 1
+            a.wait_to_read()
+
+    threads = [threading.Thread(target=serve, args=(r,)) for r in ('req-a', 'req-b')]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    mx.nd.waitall()
+    profiler.dump(False)
+    target_dict = json.loads(profiler.dumps(format='json'))
+    for request_id in ('req-a', 'req-b'):
+        assert target_dict['Requests'][request_id]['Count'] > 0
+    assert 'Requests' in profiler.dumps(format='table')
+    profiler.set_state('stop')
+
+
+def test_profile_perfetto_trace():
+    file_name = 'test_profile_perfetto_trace.pftrace'
+
+    def read_packets():
+        # a trace is a sequence of length delimited `packet` fields
+        with open(file_name, 'rb') as f:
+            data = f.read()
+        packets, pos = [], 0
+        while pos < len(data):
+            assert data[pos] == 0x0a
+            pos, size, shift = pos + 1, 0, 0
+            while True:
+                byte = data[pos]
+                size |= (byte & 0x7f) << shift
+                pos, shift = pos + 1, shift + 7
+                if byte < 0x80:
+                    break
+            packets.append(data[pos:pos + size])
+            pos += size
+        assert pos == len(data)
+        return packets
+
+    enable_profiler(profile_filename=file_name, run=True, continuous_dump=True)
+    inp = mx.nd.zeros(shape=(10, 10))
+    for _ in range(5):
+        inp = inp + 1
+    mx.nd.waitall()
+    profiler.dump(False)
+    first = read_packets()
+    assert any(b'_plus_scalar' in packet for packet in first)
+    for _ in range(5):
+        inp = inp * 2
+    mx.nd.waitall()
+    profiler.dump(False)
+    second = read_packets()
+    # the second dump appended to the first one
+    assert second[:len(first)] == first
+    assert any(b'_mul_scalar' in packet for packet in second[len(first):])
+    profiler.set_state('stop')
+
+
+def test_profile_ring_sampling():
+    file_name = 'test_profile_ring_sampling.json'
+
+    def count_ops():
+        profiler.dump(False)
+        with open(file_name) as f:
+            events = json.load(f)['traceEvents']
+        return len([e for e in events if e['name'] == '_plus_scalar' and e['ph'] == 'B'])
+
+    profiler.set_config(profile_imperative=True, profile_api=False, profile_memory=False,
+                        filename=file_name, continuous_dump=False,
+                        ring_size=16, sample_period=2)
+    profiler.set_state('run')
+    inp = mx.nd.zeros(shape=(10, 10))
+    for _ in range(100):
+        inp = inp + 1
+    mx.nd.waitall()
+    # a sampled operator is recorded as an operator and as a task
+    assert 0 < count_ops() <= 8
+    for _ in range(10):
+        inp = inp + 1
+    mx.nd.waitall()
+    # the previous records were dumped already
+    assert 0 < count_ops() <= 5
+
+    profiler.set_config(profile_imperative=True, profile_api=False, profile_memory=False,
+                        filename=file_name, continuous_dump=False,
+                        ring_size=64, sample_period=3, sample_iterations=True)
+    for _ in range(6):
+        inp = inp + 1
+        inp = inp + 1
+        mx.nd.waitall()
+        profiler.next_iteration()
+    assert count_ops() == 4
+    profiler.set_state('stop')
+    profiler.set_config(filename=file_name, continuous_dump=False)
+
+
 def test_custom_operator_profiling(seed=None, file_name=None):
     class Sigmoid(mx.operator.CustomOp):
         def forward(self, is_train, req, in_data, out_data, aux):
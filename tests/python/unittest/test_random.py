@@ -600,6 +600,21 @@ def test_sample_multinomial(dtype, x):
             real_dx[int(y[i][j])] += 5.0 / rprob[j]
         assert_almost_equal(real_dx, dx[i, :], rtol=1e-4, atol=1e-5)
 
+@with_seed()
+def test_sample_multinomial_many_categories():
+    # repeated draws from the alias tables of distributions with zeros
+    num_categories = 1000
+    samples = 200000
+    x = np.random.uniform(0, 1, size=(2, num_categories))
+    x[:, ::7] = 0
+    x /= x.sum(axis=1, keepdims=True)
+    y = mx.nd.random.multinomial(mx.nd.array(x), shape=samples).asnumpy().astype('int32')
+    for i in range(x.shape[0]):
+        freq = np.bincount(y[i], minlength=num_categories) / np.float32(samples)
+        assert np.all(freq[::7] == 0)
+        assert_almost_equal(freq, x[i], rtol=0, atol=5e-4)
+
+
 # Test the generators with the chi-square testing
 @with_seed()
 @pytest.mark.serial
@@ -645,6 +660,21 @@ def test_uniform_generator():
                      for _ in range(10)])
             verify_generator(generator=generator_mx_same_seed, buckets=buckets, probs=probs)
 
+@with_seed()
+def test_dropout_mask_seed():
+    # each parallel state is a philox subsequence, so masks follow the seed alone
+    shape = (300, 500)
+    x = mx.nd.ones(shape, ctx=mx.cpu())
+    masks = []
+    for _ in range(2):
+        mx.random.seed(128)
+        with mx.autograd.train_mode():
+            masks.append((mx.nd.Dropout(x, p=0.3) != 0).asnumpy())
+    assert same(masks[0], masks[1])
+    assert abs(masks[0].mean() - 0.7) < 0.01
+    with mx.autograd.train_mode():
+        assert not same(masks[1], (mx.nd.Dropout(x, p=0.3) != 0).asnumpy())
+
 @with_seed()
 @pytest.mark.serial
 def test_gamma_generator():
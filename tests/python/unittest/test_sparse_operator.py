@@ -1363,6 +1363,9 @@ def test_sparse_dot():
         test_dot_csr(lhs_shape, (lhs_shape[0], 1), 'default', True,  lhs_d, rhs_d)  # (vector kernel)
         test_dot_csr(lhs_shape, (lhs_shape[1], rnd.randint(5, 10)), 'default', False, lhs_d, rhs_d)  # test gpu SpMM
         test_dot_csr(lhs_shape, (lhs_shape[0], rnd.randint(5, 10)), 'default', True, lhs_d, rhs_d)  # (scalar kernel)
+        # wider than the column tiles of the cpu kernel
+        test_dot_csr(lhs_shape, (lhs_shape[1], rnd.randint(600, 1100)), 'default', False, lhs_d, rhs_d)
+        test_dot_csr(lhs_shape, (lhs_shape[0], rnd.randint(600, 1100)), 'default', True, lhs_d, rhs_d)
         test_dot_dns_csr(lhs_shape, (lhs_shape[1], rnd.randint(50, 200)), lhs_d, lhs_d)
         test_dot_dns_csr(lhs_shape, (rnd.randint(50, 200), lhs_shape[1]), lhs_d, lhs_d, trans_rhs=True)
         for rhs_d in density:
@@ -17,6 +17,7 @@
 
 import os
 import ctypes
+import json
 import mxnet as mx
 from mxnet.base import SymbolHandle, check_call, _LIB, mx_uint, c_str_array, c_str, mx_real_t
 from mxnet.symbol import Symbol
@@ -476,3 +477,212 @@ def test_subgraph_backend_gluon_ext2(tmpdir):
     for i in range(len(outputs1)):
         assert_almost_equal((outputs1[i] - outputs2[i]).abs().sum().asnumpy(), np.zeros(shape=(1,)))
 
+
+def test_fold_constants():
+    data = mx.sym.var('data')
+    weight = mx.sym.var('weight')
+    bias = mx.sym.var('bias')
+    sym = mx.sym.broadcast_add(mx.sym.dot(data, mx.sym.transpose(weight) * 2), bias)
+    args = {'data': mx.nd.random.uniform(shape=(4, 8)),
+            'weight': mx.nd.random.uniform(shape=(16, 8)),
+            'bias': mx.nd.random.uniform(shape=(16,))}
+    ref = sym._bind(mx.cpu(), args=args).forward()[0]
+
+    # data is excluded explicitly, so only the transposed and scaled weight is folded
+    folded = sym.optimize_for('FoldConstants', args, {}, data='data')
+    assert len(folded.get_internals().list_outputs()) < len(sym.get_internals().list_outputs())
+    assert 'weight' not in folded.list_arguments()
+    assert 'bias' in folded.list_arguments()
+    out = folded._bind(mx.cpu(), args=args).forward()[0]
+    assert_almost_equal(out, ref)
+
+
+
+@pytest.mark.parametrize('num_bits,group_size,tol', [(8, 128, 0.05), (8, 16, 0.05), (4, 16, 0.5)])
+def test_weight_only_quantize(num_bits, group_size, tol):
+    data = mx.sym.var('data')
+    rhs = mx.sym.var('rhs')
+    fc = mx.sym.FullyConnected(data, num_hidden=16, name='fc')
+    out = mx.sym.batch_dot(mx.sym.reshape(fc, shape=(2, 4, 16)), rhs, name='bdot')
+    shapes = dict(zip(out.list_arguments(), out.infer_shape(data=(8, 64), rhs=(2, 16, 6))[0]))
+    args = {name: mx.nd.random.uniform(-1, 1, shape=shape) for name, shape in shapes.items()}
+    ref = out._bind(mx.cpu(), args=args).forward()[0]
+
+    quantized = out.optimize_for('WeightOnlyQuantize', args, {},
+                                 num_bits=num_bits, group_size=group_size)
+    assert '_contrib_weight_only_fully_connected' in quantized.tojson()
+    assert '_contrib_weight_only_batch_dot' in quantized.tojson()
+    assert 'fc_weight' not in quantized.list_arguments()
+    assert args['fc_weight_quantized'].dtype == np.int8
+    assert args['fc_weight_quantized'].shape == (16, 64 * num_bits // 8)
+    assert args['rhs_scale'].shape == (2, 6, (16 + group_size - 1) // group_size)
+    result = quantized._bind(mx.cpu(), args=args).forward()[0]
+    assert_almost_equal(result, ref, rtol=tol, atol=tol)
+
+@pytest.mark.parametrize('mode', ['sum', 'mean'])
+def test_weight_only_quantize_rowwise(mode):
+    ids = mx.sym.var('ids')
+    offsets = mx.sym.var('offsets', dtype=np.int64)
+    feats = mx.sym.var('feats', stype='csr')
+    embed = mx.sym.Embedding(ids, input_dim=30, output_dim=8, name='embed')
+    bag = mx.sym.EmbeddingBag(ids, offsets, input_dim=30, output_dim=8, mode=mode, name='bag')
+    proj = mx.sym.dot(feats, mx.sym.var('proj_weight'), name='proj')
+    out = mx.sym.Group([embed, bag, proj])
+    args = {'ids': mx.nd.array(np.random.randint(0, 30, size=(12,))),
+            'offsets': mx.nd.array([0, 3, 3, 10, 12], dtype=np.int64),
+            'feats': mx.nd.random.uniform(0, 1, shape=(5, 40)).tostype('csr'),
+            'embed_weight': mx.nd.random.uniform(-1, 1, shape=(30, 8)),
+            'bag_weight': mx.nd.random.uniform(-1, 1, shape=(30, 8)),
+            'proj_weight': mx.nd.random.uniform(-1, 1, shape=(40, 6))}
+    refs = out._bind(mx.cpu(), args=args).forward()
+
+    quantized = out.optimize_for('WeightOnlyQuantize', args, {})
+    for op in ['embedding', 'embedding_bag', 'dot']:
+        assert '_contrib_rowwise_quantized_%s"' % op in quantized.tojson()
+    for name in ['embed_weight', 'bag_weight', 'proj_weight']:
+        assert name not in quantized.list_arguments()
+        assert args[name + '_quantized'].dtype == np.int8
+        assert args[name + '_scale'].shape == args[name].shape[:1]
+    results = quantized._bind(mx.cpu(), args=args).forward()
+    for result, ref in zip(results, refs):
+        assert_almost_equal(result, ref, rtol=0.05, atol=0.05)
+
+    # a row_sparse table gives zeros for the rows it does not hold
+    rows = np.array([1, 4, 7])
+    table = args['embed_weight_quantized'].asnumpy()
+    sparse = mx.nd.sparse.row_sparse_array((table[rows], rows), shape=table.shape,
+                                           dtype=np.int8)
+    lookup = mx.nd.contrib.rowwise_quantized_embedding(
+        mx.nd.array([4, 2, 7]), sparse, args['embed_weight_scale'], input_dim=30, output_dim=8)
+    expected = table[[4, 2, 7]] * args['embed_weight_scale'].asnumpy()[[4, 2, 7], None]
+    expected[1] = 0
+    assert_almost_equal(lookup, expected, rtol=1e-5, atol=1e-5)
+
+def test_fp8_pass():
+    data = mx.sym.var('data')
+    fc = mx.sym.FullyConnected(data, num_hidden=8, name='fc')
+    proj = mx.sym.FullyConnected(fc, num_hidden=4, name='proj')
+    out = mx.sym.batch_dot(mx.sym.reshape(proj, (2, 2, 4)), mx.sym.var('rhs'), name='bdot')
+    args = {'data': mx.nd.random.uniform(-1, 1, shape=(4, 6)),
+            'fc_weight': mx.nd.random.uniform(-1, 1, shape=(8, 6)),
+            'fc_bias': mx.nd.random.uniform(-1, 1, shape=(8,)),
+            'proj_weight': mx.nd.random.uniform(-1, 1, shape=(4, 8)),
+            'proj_bias': mx.nd.random.uniform(-1, 1, shape=(4,)),
+            'rhs': mx.nd.random.uniform(-1, 1, shape=(2, 4, 3))}
+    ref = out._bind(mx.cpu(), args=args).forward()[0]
+
+    aux = {}
+    converted = out.optimize_for('FP8', args, aux, exclude='proj', amax_history_len=4)
+    json = converted.tojson()
+    assert json.count('_contrib_fp8_fully_connected') == 1
+    assert '_contrib_fp8_batch_dot' in json
+    assert converted.list_auxiliary_states() == ['fc_amax_history', 'bdot_amax_history']
+    for name in converted.list_auxiliary_states():
+        assert_almost_equal(aux[name], np.zeros((3, 4)))
+    result = converted._bind(mx.cpu(), args=args, aux_states=aux).forward()[0]
+    assert_almost_equal(result, ref, rtol=0.15, atol=0.3)
+
+@pytest.mark.parametrize('no_bias', [True, False])
+def test_fuse_conv_bn_relu(no_bias):
+    data = mx.sym.var('data')
+    conv = mx.sym.Convolution(data, kernel=(3, 3), pad=(1, 1), num_filter=8,
+                              no_bias=no_bias, name='conv')
+    bn = mx.sym.BatchNorm(conv, fix_gamma=False, name='bn')
+    sym = mx.sym.Activation(bn, act_type='relu')
+    shapes = dict(zip(sym.list_arguments(), sym.infer_shape(data=(2, 4, 6, 6))[0]))
+    args = {name: mx.nd.random.uniform(-1, 1, shape=shape) for name, shape in shapes.items()}
+    aux_shapes = sym.infer_shape(data=(2, 4, 6, 6))[2]
+    aux_names = sym.list_auxiliary_states()
+    out_grad = mx.nd.random.uniform(-1, 1, shape=(2, 8, 6, 6))
+
+    fused = sym.optimize_for('FuseConvBNReLU', args, {})
+    assert '_contrib_ConvBatchNormWithReLU' in fused.tojson()
+    assert 'BatchNorm"' not in fused.tojson()
+    assert sorted(fused.list_arguments()) == sorted(sym.list_arguments())
+    assert sorted(fused.list_auxiliary_states()) == sorted(aux_names)
+
+    results = []
+    for s in [sym, fused]:
+        aux = {name: mx.nd.zeros(shape) if 'mean' in name else mx.nd.ones(shape)
+               for name, shape in zip(aux_names, aux_shapes)}
+        grads = {name: mx.nd.zeros(arr.shape) for name, arr in args.items()}
+        exe = s._bind(mx.cpu(), args={k: v.copy() for k, v in args.items()},
+                      args_grad=grads, aux_states=aux)
+        out = exe.forward(is_train=True)[0]
+        exe.backward([out_grad])
+        results.append((out.asnumpy(), {k: v.asnumpy() for k, v in grads.items()},
+                        {k: v.asnumpy() for k, v in aux.items()}))
+    (ref_out, ref_grads, ref_aux), (out, grads, aux) = results
+    assert_almost_equal(out, ref_out, rtol=1e-4, atol=1e-5)
+    for name in ref_grads:
+        assert_almost_equal(grads[name], ref_grads[name], rtol=1e-4, atol=1e-5)
+    for name in ref_aux:
+        assert_almost_equal(aux[name], ref_aux[name], rtol=1e-4, atol=1e-5)
+
+@pytest.mark.parametrize('no_bias', [False, True])
+@pytest.mark.parametrize('act', ['relu', 'Activation', 'gelu'])
+def test_fuse_fc_activation(act, no_bias):
+    data = mx.sym.var('data')
+    fc = mx.sym.FullyConnected(data, num_hidden=8, no_bias=no_bias, flatten=False, name='fc')
+    if act == 'relu':
+        sym = mx.sym.relu(fc)
+    elif act == 'Activation':
+        sym = mx.sym.Activation(fc, act_type='relu')
+    else:
+        sym = mx.sym.LeakyReLU(fc, act_type='gelu')
+    shapes = dict(zip(sym.list_arguments(), sym.infer_shape(data=(3, 4, 5))[0]))
+    args = {name: mx.nd.random.uniform(-1, 1, shape=shape) for name, shape in shapes.items()}
+    out_grad = mx.nd.random.uniform(-1, 1, shape=(3, 4, 8))
+
+    fused = sym.optimize_for('FuseFCActivation', args, {})
+    assert '_contrib_FullyConnectedAct' in fused.tojson()
+    assert 'FullyConnected"' not in fused.tojson()
+    assert sorted(fused.list_arguments()) == sorted(sym.list_arguments())
+    assert len(fused.list_outputs()) == 1
+
+    results = []
+    for s in [sym, fused]:
+        grads = {name: mx.nd.zeros(arr.shape) for name, arr in args.items()}
+        exe = s._bind(mx.cpu(), args={k: v.copy() for k, v in args.items()}, args_grad=grads)
+        out = exe.forward(is_train=True)[0]
+        exe.backward([out_grad])
+        results.append((out.asnumpy(), {k: v.asnumpy() for k, v in grads.items()}))
+    (ref_out, ref_grads), (out, grads) = results
+    assert_almost_equal(out, ref_out, rtol=1e-5, atol=1e-6)
+    for name in ref_grads:
+        assert_almost_equal(grads[name], ref_grads[name], rtol=1e-5, atol=1e-6)
+
+def test_fuse_fc_activation_shared_output():
+    data = mx.sym.var('data')
+    fc = mx.sym.FullyConnected(data, num_hidden=8, name='fc')
+    sym = mx.sym.Group([mx.sym.relu(fc), fc])
+    args = {'data': mx.nd.ones((2, 5)), 'fc_weight': mx.nd.ones((8, 5)),
+            'fc_bias': mx.nd.ones((8,))}
+    fused = sym.optimize_for('FuseFCActivation', args, {})
+    assert '_contrib_FullyConnectedAct' not in fused.tojson()
+
+@pytest.mark.parametrize('v2_overhead,num_outside', [
+    # the default_v2 subgraph of the four ops saves more than the default one of exp and cos
+    (5, 0),
+    # a costly default_v2 leaves the default backend its subgraph, sin and the sum stay out
+    (1e6, 2)])
+def test_cost_model_partition(v2_overhead, num_outside):
+    sym, _, _ = network_structure_2()
+    args = {'data': mx.nd.random.uniform(shape=(2, 3, 10, 10))}
+    ref = sym._bind(mx.cpu(), args=args).forward()[0]
+    plus = ['_Plus', 'elemwise_add', '_plus']
+    op_names = {'default': ['exp', 'cos'], 'default_v2': ['exp', 'sin', 'cos'] + plus}
+    for backend, names in op_names.items():
+        check_call(_LIB.MXSetSubgraphPropertyOpNamesV2(c_str(backend), mx_uint(len(names)),
+                                                       c_str_array(names)))
+    try:
+        part = sym.optimize_for('CostModelPartition', args, {}, backends='default,default_v2',
+                                default_v2_overhead=v2_overhead)
+    finally:
+        for backend in op_names:
+            check_call(_LIB.MXRemoveSubgraphPropertyOpNamesV2(c_str(backend)))
+    ops = [n['op'] for n in json.loads(part.tojson())['nodes'] if n['op'] != 'null']
+    assert ops.count('_CachedOp') == 1
+    assert len(ops) == 1 + num_outside
+    out = part._bind(mx.cpu(), args=args).forward()[0]
+    assert_almost_equal(out, ref)
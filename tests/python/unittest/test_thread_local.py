@@ -230,3 +230,72 @@ def test_np_global_shape():
         assert_almost_equal(data[1].asnumpy(), np.ones(shape=(0, 1, 2)))
     finally:
         set_np_shape(0)
+
+def test_batching_executor():
+    import ctypes
+    from mxnet.base import _LIB, check_call, mx_uint, NDArrayHandle
+    from mxnet.ndarray._internal import CachedOp
+    data = mx.sym.var('data')
+    weight = mx.sym.var('weight')
+    sym = mx.sym.FullyConnected(data, weight, no_bias=True, num_hidden=4)
+    op = CachedOp(sym, [('static_alloc', 'true'), ('static_shape', 'true')],
+                  thread_safe=True)
+    ctx = mx.cpu()
+    handle = ctypes.c_void_p()
+    batch_inputs = (mx_uint * 1)(0)
+    check_call(_LIB.MXBatchingExecutorCreate(
+        op.handle, 1, batch_inputs, mx_uint(8), mx_uint(20000),
+        ctypes.c_int(ctx.device_typeid), ctypes.c_int(ctx.device_id),
+        ctypes.byref(handle)))
+
+    w = mx.nd.random.uniform(shape=(4, 3))
+    inputs = [mx.nd.random.uniform(shape=(i % 3 + 1, 3)) for i in range(12)]
+    results = [None] * len(inputs)
+    def infer(i):
+        args = (NDArrayHandle * 2)(inputs[i].handle, w.handle)
+        num_outputs = ctypes.c_int()
+        outputs = ctypes.POINTER(NDArrayHandle)()
+        check_call(_LIB.MXBatchingExecutorInfer(
+            handle, 2, args, ctypes.byref(num_outputs), ctypes.byref(outputs)))
+        assert num_outputs.value == 1
+        results[i] = mx.nd.NDArray(NDArrayHandle(outputs[0]))
+    threads = [threading.Thread(target=infer, args=(i,)) for i in range(len(inputs))]
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+    check_call(_LIB.MXBatchingExecutorFree(handle))
+
+    for x, out in zip(inputs, results):
+        assert out.shape == (x.shape[0], 4)
+        assert_almost_equal(out, mx.nd.dot(x, w, transpose_b=True), rtol=1e-5, atol=1e-5)
+
+def test_threadsafe_cached_op():
+    from mxnet.ndarray._internal import CachedOp
+    data = mx.sym.var('data')
+    weight = mx.sym.var('weight')
+    sym = mx.sym.relu(mx.sym.FullyConnected(data, weight, no_bias=True, num_hidden=4))
+    op = CachedOp(sym, [('static_alloc', 'true'), ('static_shape', 'true'),
+                        ('data_indices', [0]), ('param_indices', [1])],
+                  thread_safe=True)
+    w = mx.nd.random.uniform(-1, 1, shape=(4, 3))
+    inputs = [mx.nd.random.uniform(-1, 1, shape=(2, 3)) for _ in range(8)]
+    results = [[] for _ in inputs]
+    def infer(i):
+        # every thread runs several requests on its own state
+        for _ in range(3):
+            out = op(inputs[i], w, default_ctx=mx.cpu())
+            results[i].append(out.asnumpy())
+    # the states of the threads of a round are freed when they exit
+    for _ in range(2):
+        threads = [threading.Thread(target=infer, args=(i,)) for i in range(len(inputs))]
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+
+    for x, outs in zip(inputs, results):
+        expected = mx.nd.relu(mx.nd.dot(x, w, transpose_b=True)).asnumpy()
+        assert len(outs) == 6
+        for out in outs:
+            assert_almost_equal(out, expected, rtol=1e-5, atol=1e-5)
@@ -67,3 +67,27 @@ def test_tvm_broadcast_add():
             assert same(a.grad.asnumpy(), expected_grad_a)
             assert same(b.grad.asnumpy(), expected_grad_b)
 
+
+
+@with_seed()
+def test_tvm_sum():
+    if _features.is_enabled("TVM_OP"):
+        from mxnet.test_utils import assert_almost_equal
+        configs = [
+            [[1024, 1024], (1,)],
+            [[64, 32, 16], (0, 2)],
+            [[4, 3, 2, 5, 6], (1, 3)],
+            [[4, 3, 2, 5, 6], None],
+            [[7, 9], (0,)],
+        ]
+        for dtype in ['float32', 'float64']:
+            for shape, axis in configs:
+                a = mx.np.random.uniform(-1, 1, size=shape, dtype=dtype)
+                a.attach_grad()
+                with mx.autograd.record():
+                    b = mx.np.sum(a, axis=axis)
+                assert b.dtype == a.dtype
+                assert_almost_equal(b.asnumpy(), _np.sum(a.asnumpy(), axis=axis),
+                                    rtol=1e-4, atol=1e-3)
+                b.backward()
+                assert same(a.grad.asnumpy(), _np.ones(shape, dtype=dtype))
@@ -0,0 +1,145 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+"""Sweep the message sizes and the numbers of keys of push and pull over kvstore types.
+
+For every kvstore, size and number of keys, the keys of this size are pushed from all the
+gpus and pulled back to them, then the latency of a round, the algorithm bandwidth (bytes of
+the keys / latency) and the bus bandwidth (algorithm bandwidth * 2 (n - 1) / n, with n the
+number of gpus of all the workers) are reported.
+"""
+import os, sys
+curr_path = os.path.abspath(os.path.dirname(__file__))
+sys.path.insert(0, os.path.join(curr_path, "../../python"))
+import mxnet as mx
+import logging
+import argparse
+import time
+import numpy as np
+from collections import namedtuple
+
+logger = logging.getLogger()
+logger.setLevel(logging.INFO)
+
+# kvstore types reduced by the trees of the gpus
+TREE_TYPES = {'device_tree': 'device', 'dist_sync_device_tree': 'dist_sync_device'}
+
+Results = namedtuple('Results', ['kv_store', 'size', 'num_keys', 'latency', 'algbw', 'busbw',
+                                 'error'])
+
+def parse_args():
+    parser = argparse.ArgumentParser(description="sweep the message sizes of kv-store types")
+    parser.add_argument('--kv-stores', type=str, default='local,device,device_tree,nccl',
+                        help='the kvstore types, separated by commas. device_tree is device '
+                        'with MXNET_KVSTORE_USETREE=1, and a +<gc type> suffix, as in '
+                        'dist_sync+2bit, sets the gradient compression. A process can only '
+                        'create one dist kvstore')
+    parser.add_argument('--gpus', type=str, default='0,1',
+                        help='the gpus to be used, e.g "0,1,2,3"')
+    parser.add_argument('--min-bytes', type=int, default=4096,
+                        help='the smallest message size in bytes')
+    parser.add_argument('--max-bytes', type=int, default=64 << 20,
+                        help='the biggest message size in bytes')
+    parser.add_argument('--step-factor', type=int, default=4,
+                        help='the ratio between consecutive message sizes')
+    parser.add_argument('--num-keys', type=str, default='1,16',
+                        help='the numbers of keys pushed and pulled together, e.g. "1,16"')
+    parser.add_argument('--num-iters', type=int, default=10,
+                        help='number of rounds averaged per measurement')
+    parser.add_argument('--gc-threshold', type=float, default=0.5,
+                        help='threshold of the gradient compression')
+    parser.add_argument('--output', type=str, default=None,
+                        help='csv file where the results are written')
+    args = parser.parse_args()
+    logging.info(args)
+    return args
+
+def create_kv(kv_store, gc_threshold):
+    name, _, gc_type = kv_store.partition('+')
+    if name in TREE_TYPES:
+        os.environ['MXNET_KVSTORE_USETREE'] = '1'
+        kv = mx.kv.create(TREE_TYPES[name])
+        del os.environ['MXNET_KVSTORE_USETREE']
+    else:
+        kv = mx.kv.create(name)
+    if gc_type:
+        kv.set_gradient_compression({'type': gc_type, 'threshold': gc_threshold})
+    return kv
+
+def sweep_kv(kv, kv_store, devs, sizes, num_keys, num_iters):
+    """Yield the results of a kvstore"""
+    num_ranks = len(devs) * kv.num_workers
+    key = 0
+    for n in num_keys:
+        for size in sizes:
+            shape = (max(size // 4, 1),)
+            keys = list(range(key, key + n))
+            key += n
+            kv.init(keys, [mx.nd.zeros(shape) for _ in keys])
+            grads = [[mx.nd.ones(shape, d) for d in devs] for _ in keys]
+            outs = [[mx.nd.zeros(shape, d) for d in devs] for _ in keys]
+            toc = 0
+            # the first round is a warmup
+            for i in range(num_iters + 1):
+                tic = time.time()
+                kv.push(keys, grads)
+                kv.pull(keys, outs)
+                for out in outs:
+                    for o in out:
+                        o.wait_to_read()
+                if i > 0:
+                    toc += time.time() - tic
+            latency = toc / num_iters
+            # the values are the sums of the ones of every gpu of every worker, unless
+            # compressed
+            err = float(np.max(np.abs(outs[0][0].asnumpy() - num_ranks)))
+            algbw = shape[0] * 4 * n / latency / 1e9
+            r = Results(kv_store=kv_store, size=shape[0] * 4, num_keys=n, latency=latency,
+                        algbw=algbw, busbw=algbw * 2 * (num_ranks - 1) / num_ranks, error=err)
+            logging.info('%s, %d bytes x %d keys, %f sec, algbw %f GB/sec, busbw %f GB/sec, '
+                         'error %f' % (r.kv_store, r.size, r.num_keys, r.latency, r.algbw,
+                                       r.busbw, r.error))
+            yield r
+
+def run(kv_stores, gpus, min_bytes, max_bytes, step_factor, num_keys, num_iters,
+        gc_threshold, output=None, **kwargs):
+    devs = [mx.gpu(int(i)) for i in gpus.split(',')]
+    sizes = []
+    size = min_bytes
+    while size <= max_bytes:
+        sizes.append(size)
+        size *= step_factor
+    num_keys = [int(n) for n in num_keys.split(',')]
+    kv_stores = kv_stores.split(',')
+    assert sum('dist' in k for k in kv_stores) <= 1, 'only one dist kvstore per process'
+    logging.info('MXNET_KVSTORE_BIGARRAY_BOUND = %s, MXNET_KVSTORE_TREE_ARRAY_BOUND = %s' % (
+        os.environ.get('MXNET_KVSTORE_BIGARRAY_BOUND', 'default'),
+        os.environ.get('MXNET_KVSTORE_TREE_ARRAY_BOUND', 'default')))
+    res = []
+    for kv_store in kv_stores:
+        kv = create_kv(kv_store, gc_threshold)
+        res += list(sweep_kv(kv, kv_store, devs, sizes, num_keys, num_iters))
+    if output is not None:
+        with open(output, 'w') as f:
+            f.write(','.join(Results._fields) + '\n')
+            for r in res:
+                f.write(','.join(str(v) for v in r) + '\n')
+    return res
+
+if __name__ == "__main__":
+    args = parse_args()
+    run(**vars(args))
@@ -19,6 +19,7 @@
 test measure.py
 """
 from measure import run
+import sweep
 import subprocess
 import logging
 
@@ -34,6 +35,13 @@ def test_measure(**kwargs):
     assert len(res) == 1
     assert res[0].error < 1e-4
 
+def test_sweep(**kwargs):
+    logging.info(kwargs)
+    res = sweep.run(min_bytes=4096, max_bytes=1 << 20, step_factor=16, num_keys='1,4',
+                    num_iters=2, gc_threshold=0.5, **kwargs)
+    assert len(res) == 3 * 2 * len(kwargs['kv_stores'].split(','))
+    assert all(r.error < 1e-4 for r in res)
+
 if __name__ == '__main__':
     gpus = get_gpus()
     assert gpus is not ''
@@ -42,3 +50,4 @@ if __name__ == '__main__':
     test_measure(gpus=gpus, network='inception-bn', optimizer=None, kv_store='local')
     test_measure(gpus=gpus, network='resnet', optimizer=None, kv_store='local')
     test_measure(gpus=gpus, network='resnet', optimizer='sgd', kv_store='local')
+    test_sweep(gpus=gpus, kv_stores='local,device,device_tree')
@@ -27,9 +27,12 @@
  *  Image List Format: unique-image-index label[s] path-to-image
  * \sa dmlc/recordio.h
  */
+#include <atomic>
 #include <cctype>
 #include <cstring>
+#include <memory>
 #include <string>
+#include <thread>
 #include <vector>
 #include <iomanip>
 #include <sstream>
@@ -76,7 +79,9 @@ int main(int argc, char *argv[]) {
            "\tquality=QUALITY[default=95] JPEG quality for encoding (1-100, default: 95) or PNG compression for encoding (1-9, default: 3).\n"\
            "\tencoding=ENCODING[default='.jpg'] Encoding type. Can be '.jpg' or '.png'\n"\
            "\tinter_method=INTER_METHOD[default=1] NN(0) BILINEAR(1) CUBIC(2) AREA(3) LANCZOS4(4) AUTO(9) RAND(10).\n"\
-           "\tunchanged=UNCHANGED[default=0] Keep the original image encoding, size and color. If set to 1, it will ignore the others parameters.\n");
+           "\tunchanged=UNCHANGED[default=0] Keep the original image encoding, size and color. If set to 1, it will ignore the others parameters.\n"\
+           "\tnum_thread=NUM_THREAD[default=1] number of threads reading, resizing and encoding the images. The records keep the order of the list.\n"\
+           "\tnum_shard=NUM_SHARD[default=1] write the records round-robin to NUM_SHARD files <output>_000.rec ... with their index files <output>_000.idx ...\n");
     return 0;
   }
   int label_width = 1;
@@ -89,6 +94,8 @@ int main(int argc, char *argv[]) {
   int color_mode = CV_LOAD_IMAGE_COLOR;
   int unchanged = 0;
   int inter_method = CV_INTER_LINEAR;
+  int num_thread = 1;
+  int num_shard = 1;
   std::string encoding(".jpg");
   for (int i = 4; i < argc; ++i) {
     char key[128], val[128];
@@ -112,6 +119,8 @@ int main(int argc, char *argv[]) {
       if (!strcmp(key, "encoding")) encoding = std::string(val);
       if (!strcmp(key, "unchanged")) unchanged = atoi(val);
       if (!strcmp(key, "inter_method")) inter_method = atoi(val);
+      if (!strcmp(key, "num_thread")) num_thread = atoi(val);
+      if (!strcmp(key, "num_shard")) num_shard = atoi(val);
     }
   }
   // Check parameters ranges
@@ -124,6 +133,9 @@ int main(int argc, char *argv[]) {
   if (label_width <= 1 && pack_label) {
     LOG(FATAL) << "pack_label can only be used when label_width > 1";
   }
+  if (num_thread < 1 || num_shard < 1) {
+    LOG(FATAL) << "num_thread and num_shard must be positive.";
+  }
   if (new_size > 0) {
     LOG(INFO) << "New Image Size: Short Edge " << new_size;
   } else {
@@ -168,10 +180,10 @@ int main(int argc, char *argv[]) {
             return 0;
       }
   }
-  std::random_device rd;
-  std::mt19937 prnd(rd());
   using namespace dmlc;
   const static size_t kBufferSize = 1 << 20UL;
+  // number of images read from the list for each round of the encoding threads
+  const size_t batch_size = 64 * num_thread;
   std::string root = argv[2];
   mxnet::io::ImageRecordIO rec;
   size_t imcnt = 0;
@@ -184,13 +196,28 @@ int main(int argc, char *argv[]) {
   } else {
     os << argv[3] << ".part" << std::setw(3) << std::setfill('0') << partid;
   }
-  LOG(INFO) << "Write to output: " << os.str();
-  dmlc::Stream *fo = dmlc::Stream::Create(os.str().c_str(), "w");
-  LOG(INFO) << "Output: " << os.str();
-  dmlc::RecordIOWriter writer(fo);
-  std::string fname, path, blob;
-  std::vector<unsigned char> decode_buf;
-  std::vector<unsigned char> encode_buf;
+  std::vector<std::unique_ptr<dmlc::Stream>> fo, fidx;
+  std::vector<std::unique_ptr<dmlc::RecordIOWriter>> writers;
+  std::vector<std::unique_ptr<dmlc::ostream>> idx_os;
+  if (num_shard == 1) {
+    LOG(INFO) << "Write to output: " << os.str();
+    fo.emplace_back(dmlc::Stream::Create(os.str().c_str(), "w"));
+    writers.emplace_back(new dmlc::RecordIOWriter(fo.back().get()));
+  } else {
+    std::string base = os.str();
+    if (base.size() > 4 && base.compare(base.size() - 4, 4, ".rec") == 0) {
+      base.resize(base.size() - 4);
+    }
+    for (int i = 0; i < num_shard; ++i) {
+      std::ostringstream shard;
+      shard << base << "_" << std::setw(3) << std::setfill('0') << i;
+      LOG(INFO) << "Write to output: " << shard.str() << ".rec";
+      fo.emplace_back(dmlc::Stream::Create((shard.str() + ".rec").c_str(), "w"));
+      writers.emplace_back(new dmlc::RecordIOWriter(fo.back().get()));
+      fidx.emplace_back(dmlc::Stream::Create((shard.str() + ".idx").c_str(), "w"));
+      idx_os.emplace_back(new dmlc::ostream(fidx.back().get()));
+    }
+  }
   std::vector<int> encode_params;
   if (encoding == std::string(".png")) {
       encode_params.push_back(CV_IMWRITE_PNG_COMPRESSION);
@@ -201,39 +228,25 @@ int main(int argc, char *argv[]) {
       encode_params.push_back(quality);
       LOG(INFO) << "JPEG encoding quality: " << quality;
   }
+  if (num_thread > 1) {
+    LOG(INFO) << "Encoding with " << num_thread << " threads";
+  }
   dmlc::InputSplit::Blob line;
   std::vector<float> label_buf(label_width, 0.f);
 
-  while (flist->NextRecord(&line)) {
-    std::string sline(static_cast<char*>(line.dptr), line.size);
-    std::istringstream is(sline);
-    if (!(is >> rec.header.image_id[0] >> rec.header.label)) continue;
-    label_buf[0] = rec.header.label;
-    for (int k = 1; k < label_width; ++k) {
-      CHECK(is >> label_buf[k])
-          << "Invalid ImageList, did you provide the correct label_width?";
-    }
-    if (pack_label) rec.header.flag = label_width;
-    rec.SaveHeader(&blob);
-    if (pack_label) {
-      size_t bsize = blob.size();
-      blob.resize(bsize + label_buf.size()*sizeof(float));
-      memcpy(BeginPtr(blob) + bsize,
-             BeginPtr(label_buf), label_buf.size()*sizeof(float));
-    }
-    CHECK(std::getline(is, fname));
-    // eliminate invalid chars in the end
-    while (fname.length() != 0 &&
-           (isspace(*fname.rbegin()) || !isprint(*fname.rbegin()))) {
-      fname.resize(fname.length() - 1);
-    }
-    // eliminate invalid chars in beginning.
-    const char *p = fname.c_str();
-    while (isspace(*p)) ++p;
-    path = root + p;
+  /*! \brief an image of the list, its record holds the header until it is encoded */
+  struct ImageTask {
+    uint64_t image_id;
+    std::string path;
+    std::string blob;
+  };
+  // read, resize and encode the image of task, appending it to the record
+  auto encode_image = [&](ImageTask* task, std::mt19937* prnd) {
+    const std::string& path = task->path;
+    std::string& blob = task->blob;
+    std::vector<unsigned char> decode_buf;
     // use "r" is equal to rb in dmlc::Stream
     dmlc::Stream *fi = dmlc::Stream::Create(path.c_str(), "r");
-    decode_buf.clear();
     size_t imsize = 0;
     while (true) {
       decode_buf.resize(imsize + kBufferSize);
@@ -244,7 +257,6 @@ int main(int argc, char *argv[]) {
     }
     delete fi;
 
-
     if (unchanged != 1) {
       cv::Mat img = cv::imdecode(decode_buf, color_mode);
       CHECK(img.data != nullptr) << "OpenCV decode fail:" << path;
@@ -262,21 +274,21 @@ int main(int argc, char *argv[]) {
         int interpolation_method = 1;
         if (img.rows > img.cols) {
             if (img.cols != new_size) {
-                interpolation_method = GetInterMethod(inter_method, img.cols, img.rows, new_size, img.rows * new_size / img.cols, prnd);
+                interpolation_method = GetInterMethod(inter_method, img.cols, img.rows, new_size, img.rows * new_size / img.cols, *prnd);
                 cv::resize(img, res, cv::Size(new_size, img.rows * new_size / img.cols), 0, 0, interpolation_method);
             } else {
                 res = img.clone();
             }
         } else {
             if (img.rows != new_size) {
-                interpolation_method = GetInterMethod(inter_method, img.cols, img.rows, new_size * img.cols / img.rows, new_size, prnd);
+                interpolation_method = GetInterMethod(inter_method, img.cols, img.rows, new_size * img.cols / img.rows, new_size, *prnd);
                 cv::resize(img, res, cv::Size(new_size * img.cols / img.rows, new_size), 0, 0, interpolation_method);
             } else {
                 res = img.clone();
             }
         }
       }
-      encode_buf.clear();
+      std::vector<unsigned char> encode_buf;
       CHECK(cv::imencode(encoding, res, encode_buf, encode_params));
 
       // write buffer
@@ -290,15 +302,88 @@ int main(int argc, char *argv[]) {
       memcpy(BeginPtr(blob) + bsize,
              BeginPtr(decode_buf), decode_buf.size());
     }
-    writer.WriteRecord(BeginPtr(blob), blob.size());
-    // write header
-    ++imcnt;
-    if (imcnt % 1000 == 0) {
-      LOG(INFO) << imcnt << " images processed, " << GetTime() - tstart << " sec elapsed";
+  };
+
+  std::random_device rd;
+  std::vector<std::mt19937> prnds;
+  for (int i = 0; i < num_thread; ++i) {
+    prnds.emplace_back(rd());
+  }
+  std::vector<ImageTask> batch;
+  bool has_next = true;
+  while (has_next) {
+    // parse a batch of the list
+    batch.clear();
+    while (batch.size() < batch_size && (has_next = flist->NextRecord(&line))) {
+      std::string sline(static_cast<char*>(line.dptr), line.size);
+      std::istringstream is(sline);
+      if (!(is >> rec.header.image_id[0] >> rec.header.label)) continue;
+      label_buf[0] = rec.header.label;
+      for (int k = 1; k < label_width; ++k) {
+        CHECK(is >> label_buf[k])
+            << "Invalid ImageList, did you provide the correct label_width?";
+      }
+      if (pack_label) rec.header.flag = label_width;
+      ImageTask task;
+      task.image_id = rec.header.image_id[0];
+      rec.SaveHeader(&task.blob);
+      if (pack_label) {
+        size_t bsize = task.blob.size();
+        task.blob.resize(bsize + label_buf.size()*sizeof(float));
+        memcpy(BeginPtr(task.blob) + bsize,
+               BeginPtr(label_buf), label_buf.size()*sizeof(float));
+      }
+      std::string fname;
+      CHECK(std::getline(is, fname));
+      // eliminate invalid chars in the end
+      while (fname.length() != 0 &&
+             (isspace(*fname.rbegin()) || !isprint(*fname.rbegin()))) {
+        fname.resize(fname.length() - 1);
+      }
+      // eliminate invalid chars in beginning.
+      const char *p = fname.c_str();
+      while (isspace(*p)) ++p;
+      task.path = root + p;
+      batch.push_back(std::move(task));
+    }
+    // encode the batch, the threads taking the next image in turn
+    if (num_thread == 1 || batch.size() < 2) {
+      for (ImageTask& task : batch) {
+        encode_image(&task, &prnds[0]);
+      }
+    } else {
+      std::atomic<size_t> next(0);
+      std::vector<std::thread> workers;
+      for (int i = 0; i < num_thread; ++i) {
+        workers.emplace_back([&, i]() {
+          for (size_t j = next++; j < batch.size(); j = next++) {
+            encode_image(&batch[j], &prnds[i]);
+          }
+        });
+      }
+      for (std::thread& worker : workers) {
+        worker.join();
+      }
+    }
+    // write the records in the order of the list
+    for (ImageTask& task : batch) {
+      const size_t shard = imcnt % num_shard;
+      if (num_shard > 1) {
+        *idx_os[shard] << task.image_id << '\t' << writers[shard]->Tell() << '\n';
+      }
+      writers[shard]->WriteRecord(BeginPtr(task.blob), task.blob.size());
+      ++imcnt;
+      if (imcnt % 1000 == 0) {
+        LOG(INFO) << imcnt << " images processed, " << GetTime() - tstart << " sec elapsed";
+      }
     }
   }
   LOG(INFO) << "Total: " << imcnt << " images processed, " << GetTime() - tstart << " sec elapsed";
-  delete fo;
+  // flush the writers and the index streams before closing their files
+  writers.clear();
+  idx_os.clear();
+  fo.clear();
+  fidx.clear();
   delete flist;
   return 0;
 }